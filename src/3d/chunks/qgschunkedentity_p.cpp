@@ -16,6 +16,7 @@
 #include "qgschunkedentity_p.h"
 
 #include <QElapsedTimer>
+#include <QThread>
 #include <QVector4D>
 #include <Qt3DRender/QObjectPicker>
 #include <Qt3DRender/QPickTriangleEvent>
@@ -25,10 +26,15 @@
 #include "qgschunklist_p.h"
 #include "qgschunkloader_p.h"
 #include "qgschunknode_p.h"
+#include "qgssettings.h"
 #include "qgstessellatedpolygongeometry.h"
 
 #include "qgseventtracing.h"
 
+#include <algorithm>
+#include <limits>
+#include <vector>
+
 ///@cond PRIVATE
 
 static float screenSpaceError( float epsilon, float distance, float screenSize, float fov )
@@ -80,6 +86,10 @@ QgsChunkedEntity::QgsChunkedEntity( const QgsAABB &rootBbox, float rootError, fl
   mRootNode = new QgsChunkNode( 0, 0, 0, rootBbox, rootError );
   mChunkLoaderQueue = new QgsChunkList;
   mReplacementQueue = new QgsChunkList;
+
+  // the loaders do most of their work in the global thread pool
+  const QgsSettings settings;
+  setMaximumConcurrentJobs( settings.value( QStringLiteral( "3D/maxConcurrentChunkJobs" ), std::max( 4, QThread::idealThreadCount() ) ).toInt() );
 }
 
 
@@ -138,9 +148,13 @@ void QgsChunkedEntity::update( const SceneState &state )
   mActiveNodes.clear();
   mFrustumCulled = 0;
   mCurrentTime = QTime::currentTime();
+  mRequestedNodes.clear();
 
   update( mRootNode, state );
 
+  // load first the chunks with the largest error in the new view, forget the others
+  prioritizeJobs();
+
   int enabled = 0, disabled = 0, unloaded = 0;
 
   Q_FOREACH ( QgsChunkNode *node, mActiveNodes )
@@ -248,7 +262,7 @@ void QgsChunkedEntity::update( QgsChunkNode *node, const SceneState &state )
 
   // make sure all nodes leading to children are always loaded
   // so that zooming out does not create issues
-  requestResidency( node );
+  requestResidency( node, state );
 
   if ( !node->entity() )
   {
@@ -282,14 +296,19 @@ void QgsChunkedEntity::update( QgsChunkNode *node, const SceneState &state )
     {
       QgsChunkNode *const *children = node->children();
       for ( int i = 0; i < 4; ++i )
-        requestResidency( children[i] );
+        requestResidency( children[i], state );
     }
   }
 }
 
 
-void QgsChunkedEntity::requestResidency( QgsChunkNode *node )
+void QgsChunkedEntity::requestResidency( QgsChunkNode *node, const SceneState &state )
 {
+  LoadPriority priority;
+  priority.screenSpaceError = screenSpaceError( node, state );
+  priority.distance = node->bbox().distanceFromPoint( state.cameraPos );
+  mRequestedNodes.insert( node, priority );
+
   if ( node->state() == QgsChunkNode::Loaded || node->state() == QgsChunkNode::QueuedForUpdate || node->state() == QgsChunkNode::Updating )
   {
     Q_ASSERT( node->replacementQueueEntry() );
@@ -299,14 +318,9 @@ void QgsChunkedEntity::requestResidency( QgsChunkNode *node )
   }
   else if ( node->state() == QgsChunkNode::QueuedForLoad )
   {
-    // move to the front of loading queue
+    // the position in the loading queue is given by the priority, see prioritizeJobs()
     Q_ASSERT( node->loaderQueueEntry() );
     Q_ASSERT( !node->loader() );
-    if ( node->loaderQueueEntry()->prev || node->loaderQueueEntry()->next )
-    {
-      mChunkLoaderQueue->takeEntry( node->loaderQueueEntry() );
-      mChunkLoaderQueue->insertFirst( node->loaderQueueEntry() );
-    }
   }
   else if ( node->state() == QgsChunkNode::Loading )
   {
@@ -327,6 +341,48 @@ void QgsChunkedEntity::requestResidency( QgsChunkNode *node )
 }
 
 
+void QgsChunkedEntity::prioritizeJobs()
+{
+  // the loading of chunks that are not needed in the current view is canceled
+  const QList<QgsChunkQueueJob *> activeJobs = mActiveJobs;
+  for ( QgsChunkQueueJob *job : activeJobs )
+  {
+    if ( qobject_cast<QgsChunkLoader *>( job ) && !mRequestedNodes.contains( job->chunk() ) )
+      cancelActiveJob( job );
+  }
+
+  std::vector<QgsChunkListEntry *> entries;
+  entries.reserve( mChunkLoaderQueue->count() );
+  while ( !mChunkLoaderQueue->isEmpty() )
+  {
+    QgsChunkListEntry *entry = mChunkLoaderQueue->takeFirst();
+    QgsChunkNode *node = entry->chunk;
+    if ( node->state() == QgsChunkNode::QueuedForLoad && !mRequestedNodes.contains( node ) )
+    {
+      // back to skeleton, the chunk will be requested again when it gets into the view
+      node->cancelQueuedForLoad();  // also deletes the entry
+      continue;
+    }
+    entries.push_back( entry );
+  }
+
+  // the updates of chunks that are not in the current view keep their place after the requested chunks
+  LoadPriority notRequested;
+  notRequested.screenSpaceError = -1;
+  notRequested.distance = std::numeric_limits<float>::max();
+  std::stable_sort( entries.begin(), entries.end(), [this, &notRequested]( const QgsChunkListEntry * entry1, const QgsChunkListEntry * entry2 )
+  {
+    const LoadPriority priority1 = mRequestedNodes.value( entry1->chunk, notRequested );
+    const LoadPriority priority2 = mRequestedNodes.value( entry2->chunk, notRequested );
+    if ( priority1.screenSpaceError != priority2.screenSpaceError )
+      return priority1.screenSpaceError > priority2.screenSpaceError;
+    return priority1.distance < priority2.distance;
+  } );
+
+  for ( QgsChunkListEntry *entry : entries )
+    mChunkLoaderQueue->insertLast( entry );
+}
+
 void QgsChunkedEntity::onActiveJobFinished()
 {
   int oldJobsCount = pendingJobsCount();
@@ -394,7 +450,7 @@ void QgsChunkedEntity::onActiveJobFinished()
 
 void QgsChunkedEntity::startJobs()
 {
-  while ( mActiveJobs.count() < 4 )
+  while ( mActiveJobs.count() < mMaxConcurrentJobs )
   {
     if ( mChunkLoaderQueue->isEmpty() )
       return;
@@ -472,6 +528,12 @@ void QgsChunkedEntity::cancelActiveJobs()
 }
 
 
+void QgsChunkedEntity::setMaximumConcurrentJobs( int count )
+{
+  mMaxConcurrentJobs = std::max( 1, count );
+  startJobs();
+}
+
 void QgsChunkedEntity::setPickingEnabled( bool enabled )
 {
   if ( mPickingEnabled == enabled )
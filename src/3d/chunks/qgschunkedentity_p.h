@@ -41,6 +41,7 @@ class QgsChunkQueueJobFactory;
 
 #include <QVector3D>
 #include <QMatrix4x4>
+#include <QHash>
 
 #include <QTime>
 
@@ -99,6 +100,11 @@ class QgsChunkedEntity : public Qt3DCore::QEntity
     //! Returns whether object picking is currently enabled
     bool hasPickingEnabled() const { return mPickingEnabled; }
 
+    //! Sets the maximum number of jobs loading or updating chunks at once
+    void setMaximumConcurrentJobs( int count );
+    //! Returns the maximum number of jobs loading or updating chunks at once
+    int maximumConcurrentJobs() const { return mMaxConcurrentJobs; }
+
   protected:
     //! Cancels the background job that is currently in progress
     void cancelActiveJob( QgsChunkQueueJob *job );
@@ -110,7 +116,13 @@ class QgsChunkedEntity : public Qt3DCore::QEntity
     void update( QgsChunkNode *node, const SceneState &state );
 
     //! make sure that the chunk will be loaded soon (if not loaded yet) and not unloaded anytime soon (if loaded already)
-    void requestResidency( QgsChunkNode *node );
+    void requestResidency( QgsChunkNode *node, const SceneState &state );
+
+    /**
+     * Sorts the loader queue by the priority of the chunks requested in the current update, drops the
+     * requests of chunks which are not needed anymore and cancels their loading if it has started already
+     */
+    void prioritizeJobs();
 
     void startJobs();
     QgsChunkQueueJob *startJob( QgsChunkNode *node );
@@ -172,6 +184,19 @@ class QgsChunkedEntity : public Qt3DCore::QEntity
     //! jobs that are currently being processed (asynchronously in worker threads)
     QList<QgsChunkQueueJob *> mActiveJobs;
 
+    //! maximum number of jobs that are processed at once
+    int mMaxConcurrentJobs = 4;
+
+    //! Priority of a chunk requested in the current update: higher screen space error first, then closer to the camera
+    struct LoadPriority
+    {
+      float screenSpaceError = 0;
+      float distance = 0;
+    };
+
+    //! chunks requested during the current update, with their priority
+    QHash<QgsChunkNode *, LoadPriority> mRequestedNodes;
+
     //! If picking is enabled, QObjectPicker objects will be assigned to chunks and pickedObject() signals fired on mouse click
     bool mPickingEnabled = false;
 
@@ -23,6 +23,7 @@ Qgs3DMapExportSettings::Qgs3DMapExportSettings()
   mSceneFolderPath = settings.value( QStringLiteral( "UI/last3DSceneExportDir" ), QDir::homePath() ).toString();
   mTerrainResolution = settings.value( QStringLiteral( "UI/last3DSceneExportTerrainResolution" ), 128 ).toInt();
   mTerrainTextureResolution = settings.value( QStringLiteral( "UI/last3DSceneExportTerrainTextureResolution" ), 512 ).toInt();
+  mTerrainLevelOfDetail = settings.value( QStringLiteral( "UI/last3DSceneExportTerrainLevelOfDetail" ), 0 ).toInt();
   mScale = settings.value( QStringLiteral( "UI/last3DSceneExportModelScale" ), 1.0f ).toFloat();
   mSmoothEdges = settings.value( QStringLiteral( "UI/last3DSceneExportSmoothEdges" ), false ).toBool();
   mExportNormals = settings.value( QStringLiteral( "UI/last3DSceneExportExportNormals" ), true ).toBool();
@@ -36,6 +37,7 @@ Qgs3DMapExportSettings::~Qgs3DMapExportSettings()
   settings.setValue( QStringLiteral( "UI/last3DSceneExportDir" ), mSceneFolderPath );
   settings.setValue( QStringLiteral( "UI/last3DSceneExportTerrainResolution" ), mTerrainResolution );
   settings.setValue( QStringLiteral( "UI/last3DSceneExportTerrainTextureResolution" ), mTerrainTextureResolution );
+  settings.setValue( QStringLiteral( "UI/last3DSceneExportTerrainLevelOfDetail" ), mTerrainLevelOfDetail );
   settings.setValue( QStringLiteral( "UI/last3DSceneExportModelScale" ), mScale );
   settings.setValue( QStringLiteral( "UI/last3DSceneExportSmoothEdges" ), mSmoothEdges );
   settings.setValue( QStringLiteral( "UI/last3DSceneExportExportNormals" ), mExportNormals );
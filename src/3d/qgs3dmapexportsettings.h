@@ -51,6 +51,8 @@ class _3D_EXPORT Qgs3DMapExportSettings
     bool exportTextures() const { return mExportTextures; }
     //! Returns the terrain texture resolution
     int terrainTextureResolution() const { return mTerrainTextureResolution; }
+    //! Returns the level of detail of the exported terrain tiles, 0 exports the terrain as a single tile
+    int terrainLevelOfDetail() const { return mTerrainLevelOfDetail; }
     //! Returns the scale of the exported model
     float scale() const { return mScale; }
 
@@ -68,6 +70,8 @@ class _3D_EXPORT Qgs3DMapExportSettings
     void setExportTextures( bool exportTextures ) { mExportTextures = exportTextures; }
     //! Sets the terrain texture resolution
     void setTerrainTextureResolution( int resolution ) { mTerrainTextureResolution = resolution; }
+    //! Sets the level of detail of the exported terrain tiles, each level splits the tiles of the previous one in four
+    void setTerrainLevelOfDetail( int level ) { mTerrainLevelOfDetail = level; }
     //! Sets the scale of exported model
     void setScale( float scale ) { mScale = scale; }
 
@@ -79,6 +83,7 @@ class _3D_EXPORT Qgs3DMapExportSettings
     bool mExportNormals = true;
     bool mExportTextures = false;
     int mTerrainTextureResolution = 512;
+    int mTerrainLevelOfDetail = 0;
     float mScale = 1.0f;
 };
 
@@ -895,6 +895,7 @@ void Qgs3DMapScene::exportScene( const Qgs3DMapExportSettings &exportSettings )
   exporter.setExportNormals( exportSettings.exportNormals() );
   exporter.setExportTextures( exportSettings.exportTextures() );
   exporter.setTerrainTextureResolution( exportSettings.terrainTextureResolution() );
+  exporter.setTerrainLevelOfDetail( exportSettings.terrainLevelOfDetail() );
   exporter.setScale( exportSettings.scale() );
 
   for ( auto it = mLayerEntities.constBegin(); it != mLayerEntities.constEnd(); ++it )
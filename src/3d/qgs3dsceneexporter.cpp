@@ -78,6 +78,7 @@
 #include "qgsimagetexture.h"
 
 #include <numeric>
+#include <memory>
 
 template<typename T>
 QVector<T> getAttributeData( Qt3DRender::QAttribute *attribute, QByteArray data )
@@ -262,20 +263,55 @@ void Qgs3DSceneExporter::parseTerrain( QgsTerrainEntity *terrain, const  QString
   textureGenerator->waitForFinished();
   QSize oldResolution = textureGenerator->textureSize();
   textureGenerator->setTextureSize( QSize( mTerrainTextureResolution, mTerrainTextureResolution ) );
+
+  // the tiles of the chosen level of detail, each of them is loaded, converted and then deleted
+  // so that only the exported vertex data is kept in memory. They are split from a copy of the
+  // root node, the nodes of the scene are only populated by its chunked entity
+  std::unique_ptr<QgsChunkNode> exportRootNode = qgis::make_unique<QgsChunkNode>( node->tileX(), node->tileY(), node->tileZ(), node->bbox(), node->error() );
+  QVector<QgsChunkNode *> nodes;
+  nodes << exportRootNode.get();
+  for ( int level = 0; level < mTerrainLevelOfDetail; ++level )
+  {
+    QVector<QgsChunkNode *> childNodes;
+    childNodes.reserve( nodes.size() * 4 );
+    for ( QgsChunkNode *parentNode : qgis::as_const( nodes ) )
+    {
+      parentNode->ensureAllChildrenExist();
+      for ( int i = 0; i < 4; ++i )
+        childNodes << parentNode->children()[i];
+    }
+    nodes = childNodes;
+  }
+
   switch ( generator->type() )
   {
     case QgsTerrainGenerator::Dem:
-      terrainTile = getDemTerrainEntity( terrain, node );
-      parseDemTile( terrainTile, layerName + QStringLiteral( "_" ) );
+    {
+      // Just create new tiles (we don't need to export exact level of details as in the scene)
+      std::unique_ptr<QgsDemTerrainGenerator> demGenerator( dynamic_cast<QgsDemTerrainGenerator *>( generator->clone() ) );
+      demGenerator->setResolution( mTerrainResolution );
+      for ( QgsChunkNode *tileNode : qgis::as_const( nodes ) )
+      {
+        terrainTile = getDemTerrainEntity( terrain, demGenerator.get(), tileNode );
+        parseDemTile( terrainTile, layerName + QStringLiteral( "_" ) );
+        delete terrainTile;
+      }
       break;
+    }
     case QgsTerrainGenerator::Flat:
-      terrainTile = getFlatTerrainEntity( terrain, node );
-      parseFlatTile( terrainTile, layerName + QStringLiteral( "_" ) );
+      for ( QgsChunkNode *tileNode : qgis::as_const( nodes ) )
+      {
+        terrainTile = getFlatTerrainEntity( terrain, tileNode );
+        parseFlatTile( terrainTile, layerName + QStringLiteral( "_" ) );
+        delete terrainTile;
+      }
       break;
     // TODO: implement other terrain types
     case QgsTerrainGenerator::Mesh:
+      // each tile would hold the whole mesh
       terrainTile = getMeshTerrainEntity( terrain, node );
       parseMeshTile( terrainTile, layerName + QStringLiteral( "_" ) );
+      delete terrainTile;
       break;
     case QgsTerrainGenerator::Online:
       break;
@@ -286,34 +322,30 @@ void Qgs3DSceneExporter::parseTerrain( QgsTerrainEntity *terrain, const  QString
 QgsTerrainTileEntity *Qgs3DSceneExporter::getFlatTerrainEntity( QgsTerrainEntity *terrain, QgsChunkNode *node )
 {
   QgsFlatTerrainGenerator *generator = dynamic_cast<QgsFlatTerrainGenerator *>( terrain->map3D().terrainGenerator() );
-  FlatTerrainChunkLoader *flatTerrainLoader = qobject_cast<FlatTerrainChunkLoader *>( generator->createChunkLoader( node ) );
+  std::unique_ptr<FlatTerrainChunkLoader> flatTerrainLoader( qobject_cast<FlatTerrainChunkLoader *>( generator->createChunkLoader( node ) ) );
   if ( mExportTextures )
     terrain->textureGenerator()->waitForFinished();
-  // the entity we created will be deallocated once the scene exporter is deallocated
+  // the entity is deleted by the caller once exported
   Qt3DCore::QEntity *entity = flatTerrainLoader->createEntity( this );
   QgsTerrainTileEntity *tileEntity = qobject_cast<QgsTerrainTileEntity *>( entity );
   return tileEntity;
 }
 
-QgsTerrainTileEntity *Qgs3DSceneExporter::getDemTerrainEntity( QgsTerrainEntity *terrain, QgsChunkNode *node )
+QgsTerrainTileEntity *Qgs3DSceneExporter::getDemTerrainEntity( QgsTerrainEntity *terrain, QgsDemTerrainGenerator *generator, QgsChunkNode *node )
 {
-  // Just create a new tile (we don't need to export exact level of details as in the scene)
-  // create the entity synchronously and then it will be deleted once our scene exporter instance is deallocated
-  QgsDemTerrainGenerator *generator = dynamic_cast<QgsDemTerrainGenerator *>( terrain->map3D().terrainGenerator()->clone() );
-  generator->setResolution( mTerrainResolution );
-  QgsDemTerrainTileLoader *loader = qobject_cast<QgsDemTerrainTileLoader *>( generator->createChunkLoader( node ) );
+  // create the entity synchronously, it is deleted by the caller once exported
+  std::unique_ptr<QgsDemTerrainTileLoader> loader( qobject_cast<QgsDemTerrainTileLoader *>( generator->createChunkLoader( node ) ) );
   generator->heightMapGenerator()->waitForFinished();
   if ( mExportTextures )
     terrain->textureGenerator()->waitForFinished();
   QgsTerrainTileEntity *tileEntity = qobject_cast<QgsTerrainTileEntity *>( loader->createEntity( this ) );
-  delete generator;
   return tileEntity;
 }
 
 QgsTerrainTileEntity *Qgs3DSceneExporter::getMeshTerrainEntity( QgsTerrainEntity *terrain, QgsChunkNode *node )
 {
   QgsMeshTerrainGenerator *generator = dynamic_cast<QgsMeshTerrainGenerator *>( terrain->map3D().terrainGenerator() );;
-  QgsMeshTerrainTileLoader *loader = qobject_cast<QgsMeshTerrainTileLoader *>( generator->createChunkLoader( node ) );
+  std::unique_ptr<QgsMeshTerrainTileLoader> loader( qobject_cast<QgsMeshTerrainTileLoader *>( generator->createChunkLoader( node ) ) );
   // TODO: export textures
   QgsTerrainTileEntity *tileEntity = qobject_cast<QgsTerrainTileEntity *>( loader->createEntity( this ) );
   return tileEntity;
@@ -695,7 +727,10 @@ void Qgs3DSceneExporter::save( const QString &sceneName, const QString &sceneFol
     if ( material != QString() )
       out << "usemtl " << material << "\n";
     obj->saveTo( out, scale / mScale, QVector3D( centerX, centerY, centerZ ) );
+    // release the vertex data of each object once written
+    delete obj;
   }
+  mObjects.clear();
 }
 
 QString Qgs3DSceneExporter::getObjectName( const QString &name )
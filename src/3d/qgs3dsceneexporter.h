@@ -71,10 +71,19 @@ class _3D_EXPORT Qgs3DSceneExporter : public Qt3DCore::QEntity
      */
     bool parseVectorLayerEntity( Qt3DCore::QEntity *entity, QgsVectorLayer *layer );
 
-    //! Creates terrain export objects from the terrain entity
+    /**
+     * Creates terrain export objects from the terrain entity.
+     *
+     * The DEM and flat terrains are exported with the tiles of the terrainLevelOfDetail() level, which
+     * are loaded, converted and released one after the other.
+     */
     void parseTerrain( QgsTerrainEntity *terrain, const  QString &layer );
 
-    //! Saves the scene to a .obj file
+    /**
+     * Saves the scene to a .obj file
+     *
+     * The export objects are released as soon as they are written.
+     */
     void save( const QString &sceneName, const QString &sceneFolderPath );
 
     //! Sets whether the triangles will look smooth
@@ -101,6 +110,20 @@ class _3D_EXPORT Qgs3DSceneExporter : public Qt3DCore::QEntity
     void setTerrainTextureResolution( int resolution ) { mTerrainTextureResolution = resolution; }
     //! Returns the terrain resolution
     int terrainTextureResolution() const { return mTerrainTextureResolution; }
+
+    /**
+     * Sets the level of detail of the exported terrain tiles: 0 exports the terrain as a single tile,
+     * each following level splits the tiles of the previous level in four.
+     * \since QGIS 3.16
+     */
+    void setTerrainLevelOfDetail( int level ) { mTerrainLevelOfDetail = level; }
+
+    /**
+     * Returns the level of detail of the exported terrain tiles
+     * \since QGIS 3.16
+     */
+    int terrainLevelOfDetail() const { return mTerrainLevelOfDetail; }
+
     //! Sets the scale of the exported 3D model
     void setScale( float scale ) { mScale = scale; }
     //! Returns the scale of the exported 3D model
@@ -123,7 +146,7 @@ class _3D_EXPORT Qgs3DSceneExporter : public Qt3DCore::QEntity
     //! Returns a tile entity that contains the geometry to be exported and necessary scaling parameters
     QgsTerrainTileEntity *getFlatTerrainEntity( QgsTerrainEntity *terrain, QgsChunkNode *node );
     //! Returns a tile entity that contains the geometry to be exported and necessary scaling parameters
-    QgsTerrainTileEntity *getDemTerrainEntity( QgsTerrainEntity *terrain, QgsChunkNode *node );
+    QgsTerrainTileEntity *getDemTerrainEntity( QgsTerrainEntity *terrain, QgsDemTerrainGenerator *generator, QgsChunkNode *node );
     //! Returns a tile entity that contains the geometry to be exported and necessary scaling parameters
     QgsTerrainTileEntity *getMeshTerrainEntity( QgsTerrainEntity *terrain, QgsChunkNode *node );
 
@@ -144,6 +167,7 @@ class _3D_EXPORT Qgs3DSceneExporter : public Qt3DCore::QEntity
     bool mExportNormals = true;
     bool mExportTextures = false;
     int mTerrainTextureResolution = 512;
+    int mTerrainLevelOfDetail = 0;
     float mScale = 1.0f;
 
     friend QgsPolygon3DSymbol;
@@ -39,6 +39,9 @@
 
 #include <Qt3DExtras/QPhongMaterial>
 
+#include <QtConcurrentRun>
+#include <QThread>
+
 QImage Qgs3DUtils::captureSceneImage( QgsAbstract3DEngine &engine, Qgs3DMapScene *scene )
 {
   QImage resImage;
@@ -131,6 +134,21 @@ bool Qgs3DUtils::exportAnimation( const Qgs3DAnimationSettings &animationSetting
     return false;
   }
 
+  // the frames are encoded and written in worker threads while the next frames are rendered,
+  // with a bounded number of frames waiting so that they do not pile up in memory
+  QList<QFuture<bool>> pendingFrames;
+  const int maxPendingFrames = std::max( 2, QThread::idealThreadCount() );
+  QStringList failedPaths;
+  auto waitForFrame = [&pendingFrames, &failedPaths]( const QString & path )
+  {
+    QFuture<bool> frame = pendingFrames.takeFirst();
+    if ( !frame.result() )
+      failedPaths << path;
+  };
+  QStringList pendingPaths;
+
+  // the scene and its loaded chunks are kept for all the frames
+  bool firstFrame = true;
   while ( time <= duration )
   {
 
@@ -139,6 +157,8 @@ bool Qgs3DUtils::exportAnimation( const Qgs3DAnimationSettings &animationSetting
       if ( feedback->isCanceled() )
       {
         error = QObject::tr( "Export canceled" );
+        while ( !pendingFrames.isEmpty() )
+          waitForFrame( pendingPaths.takeFirst() );
         return false;
       }
       feedback->setProgress( frameNo / static_cast<double>( totalFrames ) * 100 );
@@ -156,14 +176,28 @@ bool Qgs3DUtils::exportAnimation( const Qgs3DAnimationSettings &animationSetting
     // It would initially return empty rendered image.
     // Capturing the initial image and throwing it away fixes that.
     // Hopefully we will find a better fix in the future.
-    Qgs3DUtils::captureSceneImage( engine, scene );
-    QImage img = Qgs3DUtils::captureSceneImage( engine, scene );
+    if ( firstFrame )
+      Qgs3DUtils::captureSceneImage( engine, scene );
+    firstFrame = false;
+    const QImage img = Qgs3DUtils::captureSceneImage( engine, scene );
 
-    img.save( path );
+    if ( pendingFrames.size() >= maxPendingFrames )
+      waitForFrame( pendingPaths.takeFirst() );
+    pendingFrames << QtConcurrent::run( [img, path] { return img.save( path ); } );
+    pendingPaths << path;
 
     time += 1.0f / static_cast<float>( framesPerSecond );
   }
 
+  while ( !pendingFrames.isEmpty() )
+    waitForFrame( pendingPaths.takeFirst() );
+
+  if ( !failedPaths.isEmpty() )
+  {
+    error = QObject::tr( "Unable to write the frame %1" ).arg( failedPaths.first() );
+    return false;
+  }
+
   return true;
 }
 
@@ -52,6 +52,7 @@ namespace Qgs3DSymbolImpl
       context.expressionContext().setFeature( f );
       handler->processFeature( f, context );
     }
+    handler->finishProcessing( context );
 
     Qt3DCore::QEntity *entity = new Qt3DCore::QEntity;
     handler->finalize( entity, context );
@@ -30,6 +30,7 @@
 #include <Qt3DCore/QEntity>
 
 class QgsFeature;
+class QgsTessellationCache;
 
 
 #include "qgsexpressioncontext.h"
@@ -74,10 +75,26 @@ class Qgs3DRenderContext
      */
     const QgsExpressionContext &expressionContext() const { return mExpressionContext; } SIP_SKIP
 
+    /**
+     * Sets the cache of tessellated polygons shared by the chunks of the layer, or NULLPTR if the
+     * polygons should not be cached. Ownership is not transferred.
+     * \see tessellationCache()
+     */
+    void setTessellationCache( QgsTessellationCache *cache ) { mTessellationCache = cache; }
+
+    /**
+     * Returns the cache of tessellated polygons shared by the chunks of the layer, or NULLPTR if the
+     * polygons should not be cached.
+     * \see setTessellationCache()
+     */
+    QgsTessellationCache *tessellationCache() const { return mTessellationCache; }
+
   private:
     const Qgs3DMapSettings &mMap;
     //! Expression context
     QgsExpressionContext mExpressionContext;
+    //! Cache of tessellated polygons, not owned
+    QgsTessellationCache *mTessellationCache = nullptr;
 
 };
 
@@ -103,6 +120,12 @@ class QgsFeature3DHandler
      */
     virtual void processFeature( QgsFeature &feature, const Qgs3DRenderContext &context ) = 0;
 
+    /**
+     * Called once all the features have been passed to processFeature(), from the same thread,
+     * to complete the work left for batches of features. The default implementation does nothing.
+     */
+    virtual void finishProcessing( const Qgs3DRenderContext &context ) { Q_UNUSED( context ) }
+
     /**
      * When feature iteration has finished, finalize() is called to turn the extracted data
      * to a 3D entity object(s) attached to the given parent.
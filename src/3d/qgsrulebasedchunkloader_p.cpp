@@ -48,6 +48,7 @@ QgsRuleBasedChunkLoader::QgsRuleBasedChunkLoader( const QgsRuleBasedChunkLoaderF
   QgsExpressionContext exprContext( Qgs3DUtils::globalProjectLayerExpressionContext( layer ) );
   exprContext.setFields( layer->fields() );
   mContext.setExpressionContext( exprContext );
+  mContext.setTessellationCache( mFactory->mTessellationCache.get() );
 
   // factory is shared among multiple loaders which may be run at the same time
   // so we need a local copy of our rule tree that does not intefere with others
@@ -86,6 +87,11 @@ QgsRuleBasedChunkLoader::QgsRuleBasedChunkLoader( const QgsRuleBasedChunkLoaderF
       mContext.expressionContext().setFeature( f );
       mRootRule->registerFeature( f, mContext, mHandlers );
     }
+    if ( !mCanceled )
+    {
+      for ( QgsFeature3DHandler *handler : qgis::as_const( mHandlers ) )
+        handler->finishProcessing( mContext );
+    }
   } );
 
   // emit finished() as soon as the handler is populated with features
@@ -152,6 +158,7 @@ QgsRuleBasedChunkLoaderFactory::QgsRuleBasedChunkLoaderFactory( const Qgs3DMapSe
   , mLayer( vl )
   , mRootRule( rootRule->clone() )
   , mLeafLevel( leafLevel )
+  , mTessellationCache( new QgsTessellationCache )
 {
 }
 
@@ -31,6 +31,7 @@
 #include "qgsfeature3dhandler_p.h"
 #include "qgschunkedentity_p.h"
 #include "qgsrulebased3drenderer.h"
+#include "qgstessellationcache_p.h"
 
 #define SIP_NO_FILE
 
@@ -62,6 +63,8 @@ class QgsRuleBasedChunkLoaderFactory : public QgsChunkLoaderFactory
     QgsVectorLayer *mLayer;
     std::unique_ptr<QgsRuleBased3DRenderer::Rule> mRootRule;
     int mLeafLevel;
+    //! Tessellated polygons reused when the chunks are loaded again
+    std::unique_ptr<QgsTessellationCache> mTessellationCache;
 };
 
 
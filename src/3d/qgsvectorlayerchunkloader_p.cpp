@@ -62,6 +62,7 @@ QgsVectorLayerChunkLoader::QgsVectorLayerChunkLoader( const QgsVectorLayerChunkL
   QgsExpressionContext exprContext( Qgs3DUtils::globalProjectLayerExpressionContext( layer ) );
   exprContext.setFields( layer->fields() );
   mContext.setExpressionContext( exprContext );
+  mContext.setTessellationCache( mFactory->mTessellationCache.get() );
 
   QSet<QString> attributeNames;
   if ( !mHandler->prepare( mContext, attributeNames ) )
@@ -96,6 +97,8 @@ QgsVectorLayerChunkLoader::QgsVectorLayerChunkLoader( const QgsVectorLayerChunkL
       mContext.expressionContext().setFeature( f );
       mHandler->processFeature( f, mContext );
     }
+    if ( !mCanceled )
+      mHandler->finishProcessing( mContext );
   } );
 
   // emit finished() as soon as the handler is populated with features
@@ -139,6 +142,7 @@ QgsVectorLayerChunkLoaderFactory::QgsVectorLayerChunkLoaderFactory( const Qgs3DM
   , mLayer( vl )
   , mSymbol( symbol->clone() )
   , mLeafLevel( leafLevel )
+  , mTessellationCache( new QgsTessellationCache )
 {
 }
 
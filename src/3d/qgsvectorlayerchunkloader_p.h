@@ -30,6 +30,7 @@
 #include "qgschunkloader_p.h"
 #include "qgsfeature3dhandler_p.h"
 #include "qgschunkedentity_p.h"
+#include "qgstessellationcache_p.h"
 
 #define SIP_NO_FILE
 
@@ -63,6 +64,8 @@ class QgsVectorLayerChunkLoaderFactory : public QgsChunkLoaderFactory
     QgsVectorLayer *mLayer;
     std::unique_ptr<QgsAbstract3DSymbol> mSymbol;
     int mLeafLevel;
+    //! Tessellated polygons reused when the chunks are loaded again
+    std::unique_ptr<QgsTessellationCache> mTessellationCache;
 };
 
 
@@ -429,26 +429,29 @@ void QgsModelPoint3DSymbolHandler::makeEntity( Qt3DCore::QEntity *parent, const
 void QgsModelPoint3DSymbolHandler::addSceneEntities( const Qgs3DMapSettings &map, const QVector<QVector3D> &positions, const QgsPoint3DSymbol *symbol, Qt3DCore::QEntity *parent )
 {
   Q_UNUSED( map )
+  if ( positions.empty() )
+    return;
+
+  const QString source = QgsApplication::instance()->sourceCache()->localFilePath( symbol->shapeProperties()[QStringLiteral( "model" )].toString() );
+  // if the source is remote, the Qgs3DMapScene will take care of refreshing this 3D symbol when the source is fetched
+  if ( source.isEmpty() )
+    return;
+
+  const QUrl url = QUrl::fromLocalFile( source );
   for ( const QVector3D &position : positions )
   {
-    const QString source = QgsApplication::instance()->sourceCache()->localFilePath( symbol->shapeProperties()[QStringLiteral( "model" )].toString() );
-    // if the source is remote, the Qgs3DMapScene will take care of refreshing this 3D symbol when the source is fetched
-    if ( !source.isEmpty() )
-    {
-      // build the entity
-      Qt3DCore::QEntity *entity = new Qt3DCore::QEntity;
+    // build the entity
+    Qt3DCore::QEntity *entity = new Qt3DCore::QEntity;
 
-      QUrl url = QUrl::fromLocalFile( source );
-      Qt3DRender::QSceneLoader *modelLoader = new Qt3DRender::QSceneLoader;
-      modelLoader->setSource( url );
+    Qt3DRender::QSceneLoader *modelLoader = new Qt3DRender::QSceneLoader;
+    modelLoader->setSource( url );
 
-      entity->addComponent( modelLoader );
-      entity->addComponent( transform( position, symbol ) );
-      entity->setParent( parent );
+    entity->addComponent( modelLoader );
+    entity->addComponent( transform( position, symbol ) );
+    entity->setParent( parent );
 
 // cppcheck wrongly believes entity will leak
 // cppcheck-suppress memleak
-    }
   }
 }
 
@@ -457,33 +460,33 @@ void QgsModelPoint3DSymbolHandler::addMeshEntities( const Qgs3DMapSettings &map,
   if ( positions.empty() )
     return;
 
+  const QString source = QgsApplication::instance()->sourceCache()->localFilePath( symbol->shapeProperties()[QStringLiteral( "model" )].toString() );
+  if ( source.isEmpty() )
+    return;
+
   // build the default material
   QgsMaterialContext materialContext;
   materialContext.setIsSelected( are_selected );
   materialContext.setSelectionColor( map.selectionColor() );
   Qt3DRender::QMaterial *mat = symbol->material()->toMaterial( QgsMaterialSettingsRenderingTechnique::Triangles, materialContext );
 
+  // the mesh is shared by all the entities, so that the model is loaded and uploaded to the GPU only once
+  Qt3DRender::QMesh *mesh = new Qt3DRender::QMesh;
+  mesh->setSource( QUrl::fromLocalFile( source ) );
+
   // get nodes
   for ( const QVector3D &position : positions )
   {
-    const QString source = QgsApplication::instance()->sourceCache()->localFilePath( symbol->shapeProperties()[QStringLiteral( "model" )].toString() );
-    if ( !source.isEmpty() )
-    {
-      // build the entity
-      Qt3DCore::QEntity *entity = new Qt3DCore::QEntity;
-
-      QUrl url = QUrl::fromLocalFile( source );
-      Qt3DRender::QMesh *mesh = new Qt3DRender::QMesh;
-      mesh->setSource( url );
+    // build the entity
+    Qt3DCore::QEntity *entity = new Qt3DCore::QEntity;
 
-      entity->addComponent( mesh );
-      entity->addComponent( mat );
-      entity->addComponent( transform( position, symbol ) );
-      entity->setParent( parent );
+    entity->addComponent( mesh );
+    entity->addComponent( mat );
+    entity->addComponent( transform( position, symbol ) );
+    entity->setParent( parent );
 
 // cppcheck wrongly believes entity will leak
 // cppcheck-suppress memleak
-    }
   }
 }
 
@@ -20,8 +20,11 @@
 #include "qgs3dmapsettings.h"
 #include "qgs3dutils.h"
 #include "qgstessellator.h"
+#include "qgstessellationcache_p.h"
 #include "qgsphongtexturedmaterialsettings.h"
 
+#include <QDataStream>
+
 #include <Qt3DCore/QTransform>
 #include <Qt3DRender/QMaterial>
 #include <Qt3DExtras/QPhongMaterial>
@@ -56,19 +59,30 @@ class QgsPolygon3DSymbolHandler : public QgsFeature3DHandler
 
     bool prepare( const Qgs3DRenderContext &context, QSet<QString> &attributeNames ) override;
     void processFeature( QgsFeature &feature, const Qgs3DRenderContext &context ) override;
+    void finishProcessing( const Qgs3DRenderContext &context ) override;
     void finalize( Qt3DCore::QEntity *parent, const Qgs3DRenderContext &context ) override;
 
   private:
 
+    //! Number of polygons tessellated together in parallel
+    static const int TESSELLATION_BATCH_SIZE = 1000;
+
     //! temporary data we will pass to the tessellator
     struct PolygonData
     {
       std::unique_ptr<QgsTessellator> tessellator;
       QVector<QgsFeatureId> triangleIndexFids;
       QVector<uint> triangleIndexStartingIndices;
+
+      //! polygons waiting for the next batch of tessellation, with their feature ids and extrusion heights
+      std::vector<std::unique_ptr<QgsPolygon>> pendingPolygons;
+      QVector<QgsFeatureId> pendingFids;
+      QVector<float> pendingExtrusionHeights;
     };
 
     void processPolygon( QgsPolygon *polyClone, QgsFeatureId fid, float height, float extrusionHeight, const Qgs3DRenderContext &context, PolygonData &out );
+    //! Tessellates the pending polygons of \a out, or takes their tessellation from the cache of the context
+    void tessellatePendingPolygons( const Qgs3DRenderContext &context, PolygonData &out );
     void makeEntity( Qt3DCore::QEntity *parent, const Qgs3DRenderContext &context, PolygonData &out, bool selected );
     Qt3DRender::QMaterial *material( const QgsPolygon3DSymbol *symbol, bool isSelected, const Qgs3DRenderContext &context ) const;
 
@@ -76,6 +90,8 @@ class QgsPolygon3DSymbolHandler : public QgsFeature3DHandler
     std::unique_ptr< QgsPolygon3DSymbol > mSymbol;
     // inputs - generic
     QgsFeatureIds mSelectedIds;
+    //! identifies the settings of the tessellators in the keys of the tessellation cache
+    QByteArray mTessellatorSettings;
 
     // outputs
     PolygonData outNormal;  //!< Features that are not selected
@@ -102,6 +118,11 @@ bool QgsPolygon3DSymbolHandler::prepare( const Qgs3DRenderContext &context, QSet
                                  mSymbol->renderedFacade(),
                                  texturedMaterialSettings ? texturedMaterialSettings->textureRotation() : 0 ) );
 
+  QDataStream settingsStream( &mTessellatorSettings, QIODevice::WriteOnly );
+  settingsStream << context.map().origin().x() << context.map().origin().y() << mSymbol->invertNormals() << mSymbol->addBackFaces()
+                 << ( texturedMaterialSettings && texturedMaterialSettings->requiresTextureCoordinates() ) << mSymbol->renderedFacade()
+                 << ( texturedMaterialSettings ? texturedMaterialSettings->textureRotation() : 0 );
+
   QSet<QString> attrs = mSymbol->dataDefinedProperties().referencedFields( context.expressionContext() );
   attributeNames.unite( attrs );
   return true;
@@ -133,12 +154,67 @@ void QgsPolygon3DSymbolHandler::processPolygon( QgsPolygon *polyClone, QgsFeatur
 
   Qgs3DUtils::clampAltitudes( polyClone, mSymbol->altitudeClamping(), mSymbol->altitudeBinding(), height, context.map() );
 
-  Q_ASSERT( out.tessellator->dataVerticesCount() % 3 == 0 );
-  uint startingTriangleIndex = static_cast<uint>( out.tessellator->dataVerticesCount() / 3 );
-  out.triangleIndexStartingIndices.append( startingTriangleIndex );
-  out.triangleIndexFids.append( fid );
-  out.tessellator->addPolygon( *polyClone, extrusionHeight );
-  delete polyClone;
+  out.pendingPolygons.emplace_back( polyClone );
+  out.pendingFids.append( fid );
+  out.pendingExtrusionHeights.append( extrusionHeight );
+  if ( static_cast<int>( out.pendingPolygons.size() ) >= TESSELLATION_BATCH_SIZE )
+    tessellatePendingPolygons( context, out );
+}
+
+void QgsPolygon3DSymbolHandler::tessellatePendingPolygons( const Qgs3DRenderContext &context, PolygonData &out )
+{
+  if ( out.pendingPolygons.empty() )
+    return;
+
+  QgsTessellationCache *cache = context.tessellationCache();
+
+  QVector<const QgsPolygon *> polygons;
+  QVector<float> extrusionHeights;
+  QVector<QgsFeatureId> fids;
+  QVector<QByteArray> keys;
+  for ( int i = 0; i < static_cast<int>( out.pendingPolygons.size() ); ++i )
+  {
+    const QgsPolygon *polygon = out.pendingPolygons.at( i ).get();
+    const QgsFeatureId fid = out.pendingFids.at( i );
+    const float extrusionHeight = out.pendingExtrusionHeights.at( i );
+    if ( cache )
+    {
+      // the polygons already tessellated for another chunk are added as they were
+      const QByteArray key = QgsTessellationCache::key( fid, *polygon, extrusionHeight, mTessellatorSettings );
+      QVector<float> data;
+      if ( cache->data( key, data ) )
+      {
+        Q_ASSERT( out.tessellator->dataVerticesCount() % 3 == 0 );
+        out.triangleIndexStartingIndices.append( static_cast<uint>( out.tessellator->dataVerticesCount() / 3 ) );
+        out.triangleIndexFids.append( fid );
+        out.tessellator->addData( data );
+        continue;
+      }
+      keys << key;
+    }
+    polygons << polygon;
+    extrusionHeights << extrusionHeight;
+    fids << fid;
+  }
+
+  const QVector<int> firstVertices = out.tessellator->addPolygons( polygons, extrusionHeights );
+  const QVector<float> data = cache ? out.tessellator->data() : QVector<float>();
+  const int floatsPerVertex = out.tessellator->stride() / sizeof( float );
+  for ( int i = 0; i < firstVertices.size(); ++i )
+  {
+    Q_ASSERT( firstVertices.at( i ) % 3 == 0 );
+    out.triangleIndexStartingIndices.append( static_cast<uint>( firstVertices.at( i ) / 3 ) );
+    out.triangleIndexFids.append( fids.at( i ) );
+    if ( cache )
+    {
+      const int endVertex = i + 1 < firstVertices.size() ? firstVertices.at( i + 1 ) : out.tessellator->dataVerticesCount();
+      cache->insert( keys.at( i ), data.mid( firstVertices.at( i ) * floatsPerVertex, ( endVertex - firstVertices.at( i ) ) * floatsPerVertex ) );
+    }
+  }
+
+  out.pendingPolygons.clear();
+  out.pendingFids.clear();
+  out.pendingExtrusionHeights.clear();
 }
 
 void QgsPolygon3DSymbolHandler::processFeature( QgsFeature &f, const Qgs3DRenderContext &context )
@@ -196,9 +272,18 @@ void QgsPolygon3DSymbolHandler::processFeature( QgsFeature &f, const Qgs3DRender
     qDebug() << "not a polygon";
 }
 
+void QgsPolygon3DSymbolHandler::finishProcessing( const Qgs3DRenderContext &context )
+{
+  tessellatePendingPolygons( context, outNormal );
+  tessellatePendingPolygons( context, outSelected );
+}
+
 
 void QgsPolygon3DSymbolHandler::finalize( Qt3DCore::QEntity *parent, const Qgs3DRenderContext &context )
 {
+  // in case the last batch was not tessellated in the background
+  finishProcessing( context );
+
   // create entity for selected and not selected
   makeEntity( parent, context, outNormal, false );
   makeEntity( parent, context, outSelected, true );
@@ -0,0 +1,57 @@
+/***************************************************************************
+  qgstessellationcache_p.cpp
+  --------------------------------------
+  Date                 : October 2020
+  Copyright            : (C) 2020 by the QGIS project
+  Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstessellationcache_p.h"
+
+#include "qgspolygon.h"
+
+#include <QCryptographicHash>
+#include <QMutexLocker>
+
+/// @cond PRIVATE
+
+QgsTessellationCache::QgsTessellationCache( int maximumBytes )
+  : mCache( maximumBytes )
+{
+}
+
+QByteArray QgsTessellationCache::key( QgsFeatureId fid, const QgsPolygon &polygon, float extrusionHeight, const QByteArray &tessellatorSettings )
+{
+  QCryptographicHash hash( QCryptographicHash::Md5 );
+  hash.addData( reinterpret_cast<const char *>( &fid ), sizeof( fid ) );
+  hash.addData( reinterpret_cast<const char *>( &extrusionHeight ), sizeof( extrusionHeight ) );
+  hash.addData( tessellatorSettings );
+  hash.addData( polygon.asWkb() );
+  return hash.result();
+}
+
+bool QgsTessellationCache::data( const QByteArray &key, QVector<float> &data ) const
+{
+  QMutexLocker locker( &mMutex );
+  const QVector<float> *cachedData = mCache.object( key );
+  if ( !cachedData )
+    return false;
+
+  data = *cachedData;
+  return true;
+}
+
+void QgsTessellationCache::insert( const QByteArray &key, const QVector<float> &data )
+{
+  QMutexLocker locker( &mMutex );
+  mCache.insert( key, new QVector<float>( data ), data.size() * static_cast<int>( sizeof( float ) ) );
+}
+
+/// @endcond
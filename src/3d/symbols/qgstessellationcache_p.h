@@ -0,0 +1,80 @@
+/***************************************************************************
+  qgstessellationcache_p.h
+  --------------------------------------
+  Date                 : October 2020
+  Copyright            : (C) 2020 by the QGIS project
+  Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSTESSELLATIONCACHE_P_H
+#define QGSTESSELLATIONCACHE_P_H
+
+/// @cond PRIVATE
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QGIS API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+
+#include "qgsfeatureid.h"
+
+#include <QByteArray>
+#include <QCache>
+#include <QMutex>
+#include <QVector>
+
+#define SIP_NO_FILE
+
+class QgsPolygon;
+
+/**
+ * \ingroup 3d
+ * Thread safe cache of the vertex data of tessellated polygons, shared by the chunks of a layer.
+ *
+ * The polygons are identified by the feature id and a hash of everything the tessellation depends on,
+ * i.e. the geometry with its final Z values, the extrusion height and the settings of the tessellator,
+ * so that a cached tessellation is never used for a polygon which has changed.
+ *
+ * \since QGIS 3.16
+ */
+class QgsTessellationCache
+{
+  public:
+
+    //! Constructs a cache holding up to \a maximumBytes of vertex data
+    explicit QgsTessellationCache( int maximumBytes = DEFAULT_MAXIMUM_BYTES );
+
+    /**
+     * Returns the key of the tessellation of the \a polygon of the feature \a fid, extruded by
+     * \a extrusionHeight with a tessellator identified by \a tessellatorSettings
+     */
+    static QByteArray key( QgsFeatureId fid, const QgsPolygon &polygon, float extrusionHeight, const QByteArray &tessellatorSettings );
+
+    //! Sets \a data to the cached vertex data of the tessellation with \a key, returns FALSE if it is not cached
+    bool data( const QByteArray &key, QVector<float> &data ) const;
+
+    //! Stores the vertex \a data of the tessellation with \a key
+    void insert( const QByteArray &key, const QVector<float> &data );
+
+    //! Default maximum size of the cached vertex data
+    static const int DEFAULT_MAXIMUM_BYTES = 128 * 1024 * 1024;
+
+  private:
+    mutable QMutex mMutex;
+    QCache<QByteArray, QVector<float>> mCache;
+};
+
+/// @endcond
+
+#endif // QGSTESSELLATIONCACHE_P_H
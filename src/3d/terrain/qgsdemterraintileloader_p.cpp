@@ -145,8 +145,11 @@ void QgsDemTerrainTileLoader::onHeightMapReady( int jobId, const QByteArray &hei
 #include <qgsrasterlayer.h>
 #include <qgsrasterprojector.h>
 #include <QtConcurrent/QtConcurrentRun>
+#include <QFileInfo>
 #include <QFutureWatcher>
+#include "qgssettings.h"
 #include "qgsterraindownloader.h"
+#include "qgsterrainheightmapcache.h"
 
 QgsDemHeightMapGenerator::QgsDemHeightMapGenerator( QgsRasterLayer *dtm, const QgsTilingScheme &tilingScheme, int resolution, const QgsCoordinateTransformContext &transformContext )
   : mDtm( dtm )
@@ -156,6 +159,19 @@ QgsDemHeightMapGenerator::QgsDemHeightMapGenerator( QgsRasterLayer *dtm, const Q
   , mLastJobId( 0 )
   , mDownloader( dtm ? nullptr : new QgsTerrainDownloader( transformContext ) )
 {
+  const QgsSettings settings;
+  if ( settings.value( QStringLiteral( "3D/cacheTerrainHeightMaps" ), true ).toBool() )
+  {
+    mCacheDirectory = cacheDirectory( mDtm, mDownloader.get() );
+
+    // the other sources are removed first when the cache is too large
+    const qint64 maxSize = settings.value( QStringLiteral( "3D/heightMapCacheSize" ), 512 ).toLongLong() * 1024 * 1024;
+    const QString keepDirectory = mCacheDirectory;
+    QtConcurrent::run( [maxSize, keepDirectory]
+    {
+      QgsTerrainHeightMapCache::trim( maxSize, keepDirectory );
+    } );
+  }
 }
 
 QgsDemHeightMapGenerator::~QgsDemHeightMapGenerator()
@@ -208,6 +224,39 @@ static QByteArray _readOnlineDtm( QgsTerrainDownloader *downloader, const QgsRec
   return downloader->getHeightMap( extent, res, destCrs );
 }
 
+QString QgsDemHeightMapGenerator::cacheDirectory( QgsRasterLayer *dtm, const QgsTerrainDownloader *downloader )
+{
+  QString source;
+  QString version;
+  int maxAgeDays = 0;
+  if ( dtm )
+  {
+    source = QStringLiteral( "%1:%2" ).arg( dtm->providerType(), dtm->source() );
+    const QFileInfo fileInfo( dtm->source() );
+    if ( fileInfo.exists() )
+      version = QStringLiteral( "%1:%2" ).arg( fileInfo.lastModified().toMSecsSinceEpoch() ).arg( fileInfo.size() );
+    else
+      maxAgeDays = QgsSettings().value( QStringLiteral( "3D/remoteHeightMapMaxAge" ), 7 ).toInt();
+  }
+  else if ( downloader )
+  {
+    const QgsTerrainDownloader::DataSource dataSource = downloader->dataSource();
+    source = dataSource.uri;
+    version = QStringLiteral( "%1:%2" ).arg( dataSource.zMin ).arg( dataSource.zMax );
+    maxAgeDays = QgsSettings().value( QStringLiteral( "3D/remoteHeightMapMaxAge" ), 7 ).toInt();
+  }
+  else
+    return QString();
+
+  return QgsTerrainHeightMapCache::sourceDirectory( source, version, maxAgeDays );
+}
+
+QString QgsDemHeightMapGenerator::cacheFilePath( const QgsRectangle &extent, int resolution ) const
+{
+  const QString tile = QStringLiteral( "%1:%2:%3" ).arg( mTilingScheme.crs().toWkt(), extent.toString( 17 ) ).arg( resolution );
+  return QgsTerrainHeightMapCache::heightMapPath( mCacheDirectory, tile );
+}
+
 int QgsDemHeightMapGenerator::render( int x, int y, int z )
 {
   QgsChunkNodeId tileId( x, y, z );
@@ -228,10 +277,22 @@ int QgsDemHeightMapGenerator::render( int x, int y, int z )
   jd.extent = extent;
   jd.timer.start();
   // make a clone of the data provider so it is safe to use in worker thread
-  if ( mDtm )
-    jd.future = QtConcurrent::run( _readDtmData, mClonedProvider, extent, mResolution, mTilingScheme.crs() );
-  else
-    jd.future = QtConcurrent::run( _readOnlineDtm, mDownloader.get(), extent, mResolution, mTilingScheme.crs() );
+  QgsRasterDataProvider *provider = mDtm ? mClonedProvider : nullptr;
+  QgsTerrainDownloader *downloader = mDtm ? nullptr : mDownloader.get();
+  const int resolution = mResolution;
+  const QgsCoordinateReferenceSystem crs = mTilingScheme.crs();
+  const QString cachePath = cacheFilePath( extent, mResolution );
+  jd.future = QtConcurrent::run( [provider, downloader, extent, resolution, crs, cachePath]
+  {
+    // the heightmaps read already are stored in the user profile, so that the terrain is not read again from the source
+    QByteArray data = QgsTerrainHeightMapCache::readHeightMap( cachePath, resolution );
+    if ( !data.isNull() )
+      return data;
+
+    data = provider ? _readDtmData( provider, extent, resolution, crs ) : _readOnlineDtm( downloader, extent, resolution, crs );
+    QgsTerrainHeightMapCache::writeHeightMap( cachePath, resolution, data );
+    return data;
+  } );
 
   QFutureWatcher<QByteArray> *fw = new QFutureWatcher<QByteArray>( nullptr );
   fw->setFuture( jd.future );
@@ -276,12 +337,15 @@ float QgsDemHeightMapGenerator::heightAt( double x, double y )
   // TODO: this is quite a primitive implementation: better to use heightmaps currently in use
   int res = 1024;
   QgsRectangle rect = mDtm->extent();
+  if ( mDtmCoarseData.isEmpty() )
+    mDtmCoarseData = QgsTerrainHeightMapCache::readHeightMap( cacheFilePath( rect, res ), res );
   if ( mDtmCoarseData.isEmpty() )
   {
     std::unique_ptr< QgsRasterBlock > block( mDtm->dataProvider()->block( 1, rect, res, res ) );
     block->convert( Qgis::Float32 );
     mDtmCoarseData = block->data();
     mDtmCoarseData.detach();  // make a deep copy
+    QgsTerrainHeightMapCache::writeHeightMap( cacheFilePath( rect, res ), res, mDtmCoarseData );
   }
 
   int cellX = ( int )( ( x - rect.xMinimum() ) / rect.width() * res + .5f );
@@ -100,6 +100,13 @@ class QgsDemHeightMapGenerator : public QObject
     //! returns height at given position (in terrain's CRS)
     float heightAt( double x, double y );
 
+    /**
+     * Returns the directory of QgsTerrainHeightMapCache storing the heightmaps read from \a dtm, or from the
+     * \a downloader if \a dtm is NULLPTR. The heightmaps of an older version of a local file are removed,
+     * the ones of a remote source once they are older than the "3D/remoteHeightMapMaxAge" setting, in days.
+     */
+    static QString cacheDirectory( QgsRasterLayer *dtm, const QgsTerrainDownloader *downloader );
+
   signals:
     //! emitted when a previously requested heightmap is ready
     void heightMapReady( int jobId, const QByteArray &heightMap );
@@ -108,6 +115,9 @@ class QgsDemHeightMapGenerator : public QObject
     void onFutureFinished();
 
   private:
+    //! Returns the path of the file storing the heightmap of \a extent, or an empty string if heightmaps are not cached
+    QString cacheFilePath( const QgsRectangle &extent, int resolution ) const;
+
     //! raster used to build terrain
     QgsRasterLayer *mDtm = nullptr;
 
@@ -122,6 +132,9 @@ class QgsDemHeightMapGenerator : public QObject
 
     std::unique_ptr<QgsTerrainDownloader> mDownloader;
 
+    //! directory storing the heightmaps read already, empty if heightmaps are not cached
+    QString mCacheDirectory;
+
     struct JobData
     {
       int jobId;
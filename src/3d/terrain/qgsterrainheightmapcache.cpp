@@ -0,0 +1,234 @@
+/***************************************************************************
+  qgsterrainheightmapcache.cpp
+  --------------------------------------
+  Date                 : October 2020
+  Copyright            : (C) 2020 by the QGIS project
+  Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsterrainheightmapcache.h"
+
+#include "qgis.h"
+#include "qgsapplication.h"
+#include "qgslogger.h"
+#include "qgssettings.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QTextStream>
+
+#include <algorithm>
+
+//! Identifies the files of cached heightmaps
+static const quint32 HEIGHTMAP_FILE_MAGIC = 0x514d4850;  // "QHMP"
+//! Version of the format of the files of cached heightmaps
+static const quint32 HEIGHTMAP_FILE_VERSION = 1;
+//! Name of the file storing the version of the source in a source directory
+static const QLatin1String VERSION_FILE_NAME( "version.txt" );
+
+QString QgsTerrainHeightMapCache::cacheDirectory()
+{
+  const QString directory = QgsSettings().value( QStringLiteral( "3D/heightMapCacheDirectory" ) ).toString();
+  if ( !directory.isEmpty() )
+    return directory;
+  return QgsApplication::qgisSettingsDirPath() + QStringLiteral( "3d_heightmaps" );
+}
+
+QString QgsTerrainHeightMapCache::sourceDirectoryName( const QString &source )
+{
+  return QString::fromLatin1( QCryptographicHash::hash( source.toUtf8(), QCryptographicHash::Md5 ).toHex() );
+}
+
+QString QgsTerrainHeightMapCache::sourceDirectory( const QString &source, const QString &version, int maxAgeDays )
+{
+  QDir directory( QDir( cacheDirectory() ).filePath( sourceDirectoryName( source ) ) );
+  const QString versionPath = directory.filePath( VERSION_FILE_NAME );
+
+  // the heightmaps read from another version of the source, or too old, are not valid anymore
+  qint64 created = -1;
+  QFile versionFile( versionPath );
+  if ( versionFile.open( QIODevice::ReadOnly | QIODevice::Text ) )
+  {
+    QTextStream stream( &versionFile );
+    const QString storedVersion = stream.readLine();
+    bool ok = false;
+    created = stream.readLine().toLongLong( &ok );
+    versionFile.close();
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if ( !ok || storedVersion != version || ( maxAgeDays > 0 && now - created > static_cast<qint64>( maxAgeDays ) * 24 * 3600 * 1000 ) )
+    {
+      directory.removeRecursively();
+      created = -1;
+    }
+  }
+  else if ( directory.exists() )
+  {
+    // heightmaps of an unknown version
+    directory.removeRecursively();
+  }
+
+  if ( !QDir().mkpath( directory.absolutePath() ) )
+    return QString();
+
+  // the version file is written again each time, its modification time tells when the directory was last used
+  if ( created < 0 )
+    created = QDateTime::currentMSecsSinceEpoch();
+  QSaveFile file( versionPath );
+  if ( file.open( QIODevice::WriteOnly | QIODevice::Text ) )
+  {
+    QTextStream stream( &file );
+    stream << version << '\n' << created << '\n';
+    stream.flush();
+    if ( !file.commit() )
+      QgsDebugMsg( QStringLiteral( "Version of the heightmaps could not be stored in %1" ).arg( versionPath ) );
+  }
+  return directory.absolutePath();
+}
+
+QString QgsTerrainHeightMapCache::heightMapPath( const QString &sourceDirectory, const QString &key )
+{
+  if ( sourceDirectory.isEmpty() )
+    return QString();
+
+  const QByteArray keyHash = QCryptographicHash::hash( key.toUtf8(), QCryptographicHash::Md5 );
+  return QDir( sourceDirectory ).filePath( QStringLiteral( "%1.heightmap" ).arg( QString::fromLatin1( keyHash.toHex() ) ) );
+}
+
+QByteArray QgsTerrainHeightMapCache::readHeightMap( const QString &path, int resolution )
+{
+  if ( path.isEmpty() )
+    return QByteArray();
+
+  QFile file( path );
+  if ( !file.open( QIODevice::ReadOnly ) )
+    return QByteArray();
+
+  const qint64 dataSize = static_cast<qint64>( resolution ) * resolution * sizeof( float );
+  const qint64 headerSize = 3 * sizeof( quint32 );
+  if ( file.size() != headerSize + dataSize )
+    return QByteArray();
+
+  uchar *fileData = file.map( 0, file.size() );
+  if ( !fileData )
+    return QByteArray();
+
+  const quint32 *header = reinterpret_cast<const quint32 *>( fileData );
+  QByteArray data;
+  if ( header[0] == HEIGHTMAP_FILE_MAGIC && header[1] == HEIGHTMAP_FILE_VERSION && header[2] == static_cast<quint32>( resolution ) )
+    data = QByteArray( reinterpret_cast<const char *>( fileData + headerSize ), static_cast<int>( dataSize ) );
+  file.unmap( fileData );
+  return data;
+}
+
+bool QgsTerrainHeightMapCache::writeHeightMap( const QString &path, int resolution, const QByteArray &data )
+{
+  if ( path.isEmpty() || data.size() != resolution * resolution * static_cast<int>( sizeof( float ) ) )
+    return false;
+
+  // the source directory may have been removed by trim() or invalidate() in the meantime
+  QSaveFile file( path );
+  if ( !QDir().mkpath( QFileInfo( path ).absolutePath() ) || !file.open( QIODevice::WriteOnly ) )
+    return false;
+
+  const quint32 header[3] = { HEIGHTMAP_FILE_MAGIC, HEIGHTMAP_FILE_VERSION, static_cast<quint32>( resolution ) };
+  if ( file.write( reinterpret_cast<const char *>( header ), sizeof( header ) ) != sizeof( header ) || file.write( data ) != data.size() )
+  {
+    file.cancelWriting();
+    return false;
+  }
+  if ( !file.commit() )
+  {
+    QgsDebugMsg( QStringLiteral( "Heightmap could not be stored in %1" ).arg( path ) );
+    return false;
+  }
+  return true;
+}
+
+void QgsTerrainHeightMapCache::invalidate( const QString &source )
+{
+  QDir( QDir( cacheDirectory() ).filePath( sourceDirectoryName( source ) ) ).removeRecursively();
+}
+
+qint64 QgsTerrainHeightMapCache::size()
+{
+  qint64 total = 0;
+  const QFileInfoList directories = QDir( cacheDirectory() ).entryInfoList( QDir::Dirs | QDir::NoDotAndDotDot );
+  for ( const QFileInfo &directory : directories )
+  {
+    const QFileInfoList files = QDir( directory.absoluteFilePath() ).entryInfoList( QDir::Files );
+    for ( const QFileInfo &file : files )
+      total += file.size();
+  }
+  return total;
+}
+
+void QgsTerrainHeightMapCache::trim( qint64 maxSize, const QString &keepDirectory )
+{
+  struct SourceDirectory
+  {
+    QString path;
+    qint64 size = 0;
+    QDateTime lastUsed;
+  };
+
+  QList<SourceDirectory> sourceDirectories;
+  qint64 total = 0;
+  const QFileInfoList directories = QDir( cacheDirectory() ).entryInfoList( QDir::Dirs | QDir::NoDotAndDotDot );
+  for ( const QFileInfo &directory : directories )
+  {
+    SourceDirectory sourceDirectory;
+    sourceDirectory.path = directory.absoluteFilePath();
+    const QFileInfoList files = QDir( sourceDirectory.path ).entryInfoList( QDir::Files );
+    for ( const QFileInfo &file : files )
+      sourceDirectory.size += file.size();
+    const QFileInfo versionFile( QDir( sourceDirectory.path ).filePath( VERSION_FILE_NAME ) );
+    sourceDirectory.lastUsed = versionFile.exists() ? versionFile.lastModified() : directory.lastModified();
+    total += sourceDirectory.size;
+    sourceDirectories << sourceDirectory;
+  }
+
+  if ( total <= maxSize )
+    return;
+
+  // the least recently used first
+  std::sort( sourceDirectories.begin(), sourceDirectories.end(), []( const SourceDirectory & a, const SourceDirectory & b )
+  {
+    return a.lastUsed < b.lastUsed;
+  } );
+
+  const QString keepPath = keepDirectory.isEmpty() ? QString() : QDir( keepDirectory ).absolutePath();
+  for ( const SourceDirectory &sourceDirectory : qgis::as_const( sourceDirectories ) )
+  {
+    if ( total <= maxSize )
+      return;
+    if ( sourceDirectory.path == keepPath )
+      continue;
+    if ( QDir( sourceDirectory.path ).removeRecursively() )
+      total -= sourceDirectory.size;
+  }
+
+  if ( total <= maxSize || keepPath.isEmpty() )
+    return;
+
+  // the directory in use is too large on its own, its oldest heightmaps are removed
+  const QFileInfoList heightMaps = QDir( keepPath ).entryInfoList( QStringList() << QStringLiteral( "*.heightmap" ), QDir::Files, QDir::Time | QDir::Reversed );
+  for ( const QFileInfo &heightMap : heightMaps )
+  {
+    if ( total <= maxSize )
+      return;
+    if ( QFile::remove( heightMap.absoluteFilePath() ) )
+      total -= heightMap.size();
+  }
+}
@@ -0,0 +1,99 @@
+/***************************************************************************
+  qgsterrainheightmapcache.h
+  --------------------------------------
+  Date                 : October 2020
+  Copyright            : (C) 2020 by the QGIS project
+  Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSTERRAINHEIGHTMAPCACHE_H
+#define QGSTERRAINHEIGHTMAPCACHE_H
+
+#include "qgis_3d.h"
+
+#include <QByteArray>
+#include <QString>
+
+#define SIP_NO_FILE
+
+/**
+ * \ingroup 3d
+ * An on-disk cache of the heightmaps of the terrain tiles, in the user profile.
+ *
+ * The heightmaps of a source are stored in their own directory, together with the version
+ * of the source they were read from. The heightmaps of an older version of the source are
+ * removed when its directory is opened, so that no heightmaps are left behind when a DEM
+ * file is modified. The version of a remote source cannot be known, its heightmaps are
+ * removed once they are older than a maximum age, or on request with invalidate().
+ *
+ * The directories which were not used recently are removed first when the size of the
+ * cache is trimmed.
+ *
+ * \note Not available in Python bindings
+ *
+ * \since QGIS 3.16
+ */
+class _3D_EXPORT QgsTerrainHeightMapCache
+{
+  public:
+
+    /**
+     * Returns the directory of the cache: the "3D/heightMapCacheDirectory" setting when it is set,
+     * or the "3d_heightmaps" directory of the user profile.
+     */
+    static QString cacheDirectory();
+
+    /**
+     * Returns the directory storing the heightmaps of \a source, creates it if needed and marks
+     * it as used. The stored heightmaps are removed first if they were read from a \a version
+     * of the source other than the current one, or if they are older than \a maxAgeDays days
+     * (when \a maxAgeDays is positive).
+     * Returns an empty string if the directory cannot be created.
+     */
+    static QString sourceDirectory( const QString &source, const QString &version, int maxAgeDays = 0 );
+
+    //! Returns the path of the file storing the heightmap identified by \a key in \a sourceDirectory
+    static QString heightMapPath( const QString &sourceDirectory, const QString &key );
+
+    /**
+     * Returns the heightmap of \a resolution x \a resolution floats stored in the file at \a path,
+     * or a null array if there is no such stored heightmap. The file is memory mapped while it is read.
+     */
+    static QByteArray readHeightMap( const QString &path, int resolution );
+
+    /**
+     * Stores the heightmap \a data of \a resolution x \a resolution floats in the file at \a path.
+     * Returns FALSE if the data is not a heightmap of this resolution or if it could not be written.
+     */
+    static bool writeHeightMap( const QString &path, int resolution, const QByteArray &data );
+
+    /**
+     * Removes the heightmaps stored for \a source, e.g. when the data of a remote source has
+     * changed. They are read again from the source the next time they are needed.
+     */
+    static void invalidate( const QString &source );
+
+    //! Returns the size in bytes of the files of the cache
+    static qint64 size();
+
+    /**
+     * Removes the least recently used source directories until the size of the cache is not
+     * larger than \a maxSize bytes. The \a keepDirectory source directory is removed last:
+     * only its oldest heightmaps are removed, if it is larger than \a maxSize on its own.
+     */
+    static void trim( qint64 maxSize, const QString &keepDirectory = QString() );
+
+  private:
+
+    //! Returns the name of the directory of \a source
+    static QString sourceDirectoryName( const QString &source );
+};
+
+#endif // QGSTERRAINHEIGHTMAPCACHE_H
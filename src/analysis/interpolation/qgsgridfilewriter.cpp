@@ -19,8 +19,15 @@
 #include "qgsinterpolator.h"
 #include "qgsvectorlayer.h"
 #include "qgsfeedback.h"
+#include "qgsgdalutils.h"
+#include "cpl_string.h"
+
 #include <QFile>
 #include <QFileInfo>
+#include <QThread>
+#include <QtConcurrentMap>
+
+#include <algorithm>
 
 QgsGridFileWriter::QgsGridFileWriter( QgsInterpolator *i, const QString &outputPath, const QgsRectangle &extent, int nCols, int nRows )
   : mInterpolator( i )
@@ -34,56 +41,152 @@ QgsGridFileWriter::QgsGridFileWriter( QgsInterpolator *i, const QString &outputP
 
 int QgsGridFileWriter::writeFile( QgsFeedback *feedback )
 {
+  const QString suffix = QFileInfo( mOutputFilePath ).suffix().toLower();
+  const bool writeGeoTiff = suffix == QLatin1String( "tif" ) || suffix == QLatin1String( "tiff" );
+
   QFile outputFile( mOutputFilePath );
+  gdal::dataset_unique_ptr outputDataset;
+  QTextStream outStream;
+  if ( writeGeoTiff )
+  {
+    if ( !mInterpolator )
+    {
+      return 2;
+    }
 
-  if ( !outputFile.open( QFile::WriteOnly | QIODevice::Truncate ) )
+    // the rows are streamed to a GeoTIFF through GDAL, instead of written as text
+    GDALDriverH driver = GDALGetDriverByName( "GTiff" );
+    char **options = CSLSetNameValue( nullptr, "COMPRESS", "LZW" );
+    options = CSLSetNameValue( options, "BIGTIFF", "IF_SAFER" );
+    outputDataset.reset( driver ? GDALCreate( driver, mOutputFilePath.toUtf8().constData(), mNumColumns, mNumRows, 1, GDT_Float32, options ) : nullptr );
+    CSLDestroy( options );
+    if ( !outputDataset )
+    {
+      return 1;
+    }
+
+    double geoTransform[6] = { mInterpolationExtent.xMinimum(), mCellSizeX, 0, mInterpolationExtent.yMaximum(), 0, -mCellSizeY };
+    GDALSetGeoTransform( outputDataset.get(), geoTransform );
+    const QgsFeatureSource *source = mInterpolator->layerData().at( 0 ).source;
+    GDALSetProjection( outputDataset.get(), source->sourceCrs().toWkt( QgsCoordinateReferenceSystem::WKT_PREFERRED_GDAL ).toLocal8Bit().constData() );
+    GDALSetRasterNoDataValue( GDALGetRasterBand( outputDataset.get(), 1 ), -9999 );
+  }
+  else
   {
-    return 1;
+    if ( !outputFile.open( QFile::WriteOnly | QIODevice::Truncate ) )
+    {
+      return 1;
+    }
+
+    if ( !mInterpolator )
+    {
+      outputFile.remove();
+      return 2;
+    }
+
+    outStream.setDevice( &outputFile );
+    outStream.setRealNumberPrecision( 8 );
+    writeHeader( outStream );
   }
 
-  if ( !mInterpolator )
+  auto removeOutput = [&]
   {
-    outputFile.remove();
-    return 2;
-  }
+    if ( writeGeoTiff )
+    {
+      outputDataset.reset();
+      QFile::remove( mOutputFilePath );
+    }
+    else
+    {
+      outputFile.remove();
+    }
+  };
 
-  QTextStream outStream( &outputFile );
-  outStream.setRealNumberPrecision( 8 );
-  writeHeader( outStream );
+  // interpolate a row, the values are in the center of the cells
+  auto interpolateRow = [this, feedback]( int row, double * values )
+  {
+    const double currentYValue = mInterpolationExtent.yMaximum() - mCellSizeY / 2.0 - row * mCellSizeY;
+    double currentXValue = mInterpolationExtent.xMinimum() + mCellSizeX / 2.0;
+    double interpolatedValue;
+    for ( int j = 0; j < mNumColumns; ++j )
+    {
+      values[ j ] = mInterpolator->interpolatePoint( currentXValue, currentYValue, interpolatedValue, feedback ) == 0 ? interpolatedValue : -9999;
+      currentXValue += mCellSizeX;
+    }
+  };
 
-  double currentYValue = mInterpolationExtent.yMaximum() - mCellSizeY / 2.0; //calculate value in the center of the cell
-  double currentXValue;
-  double interpolatedValue;
+  // interpolators supporting it interpolate a block of rows in parallel, once a first point has cached their data
+  const bool parallel = mInterpolator->supportsParallelInterpolation() && mNumRows > 1;
+  const int blockRows = parallel ? std::min( mNumRows, std::max( 1, QThread::idealThreadCount() ) * 4 ) : 1;
+  if ( parallel && mNumColumns > 0 )
+  {
+    double interpolatedValue;
+    mInterpolator->interpolatePoint( mInterpolationExtent.xMinimum() + mCellSizeX / 2.0, mInterpolationExtent.yMaximum() - mCellSizeY / 2.0, interpolatedValue, feedback );
+  }
 
-  for ( int i = 0; i < mNumRows; ++i )
+  QVector< double > values( blockRows * mNumColumns );
+  QVector< float > tiffValues( writeGeoTiff ? mNumColumns : 0 );
+  for ( int blockStart = 0; blockStart < mNumRows; blockStart += blockRows )
   {
-    currentXValue = mInterpolationExtent.xMinimum() + mCellSizeX / 2.0; //calculate value in the center of the cell
-    for ( int j = 0; j < mNumColumns; ++j )
+    const int blockEnd = std::min( blockStart + blockRows, mNumRows );
+    if ( parallel )
     {
-      if ( mInterpolator->interpolatePoint( currentXValue, currentYValue, interpolatedValue, feedback ) == 0 )
+      QVector< int > rows;
+      for ( int i = blockStart; i < blockEnd; ++i )
+        rows << i;
+      double *blockValues = values.data();
+      QtConcurrent::blockingMap( rows, [&]( int row )
       {
-        outStream << interpolatedValue << ' ';
+        interpolateRow( row, blockValues + static_cast< std::size_t >( row - blockStart ) * mNumColumns );
+      } );
+    }
+    else
+    {
+      interpolateRow( blockStart, values.data() );
+    }
+
+    for ( int i = blockStart; i < blockEnd; ++i )
+    {
+      const double *rowValues = values.constData() + static_cast< std::size_t >( i - blockStart ) * mNumColumns;
+      if ( writeGeoTiff )
+      {
+        std::copy( rowValues, rowValues + mNumColumns, tiffValues.begin() );
+        if ( GDALRasterIO( GDALGetRasterBand( outputDataset.get(), 1 ), GF_Write, 0, i, mNumColumns, 1, tiffValues.data(), mNumColumns, 1, GDT_Float32, 0, 0 ) != CE_None )
+        {
+          removeOutput();
+          return 1;
+        }
       }
       else
       {
-        outStream << "-9999 ";
+        for ( int j = 0; j < mNumColumns; ++j )
+        {
+          if ( rowValues[ j ] == -9999 )
+            outStream << "-9999 ";
+          else
+            outStream << rowValues[ j ] << ' ';
+        }
+        outStream << endl;
       }
-      currentXValue += mCellSizeX;
-    }
-    outStream << endl;
-    currentYValue -= mCellSizeY;
 
-    if ( feedback )
-    {
-      if ( feedback->isCanceled() )
+      if ( feedback )
       {
-        outputFile.remove();
-        return 3;
+        if ( feedback->isCanceled() )
+        {
+          removeOutput();
+          return 3;
+        }
+        feedback->setProgress( 100.0 * i / static_cast< double >( mNumRows ) );
       }
-      feedback->setProgress( 100.0 * i / static_cast< double >( mNumRows ) );
     }
   }
 
+  if ( writeGeoTiff )
+  {
+    // the GeoTIFF embeds its CRS
+    return 0;
+  }
+
   // create prj file
   QgsInterpolator::LayerData ld;
   ld = mInterpolator->layerData().at( 0 );
@@ -26,11 +26,10 @@
 class QgsInterpolator;
 class QgsFeedback;
 
-//todo: extend such that writing to other file types is possible
-
 /**
  * \ingroup analysis
- * A class that does interpolation to a grid and writes the results to an ascii grid.
+ * A class that does interpolation to a grid and writes the results to an ascii grid,
+ * or to a GeoTIFF if the output file has a .tif or .tiff extension.
 */
 class ANALYSIS_EXPORT QgsGridFileWriter
 {
@@ -48,6 +47,9 @@ class ANALYSIS_EXPORT QgsGridFileWriter
     /**
      * Writes the grid file.
      *
+     * If the interpolator supports it, blocks of rows are interpolated in parallel. The rows are written as
+     * they are interpolated, so that the whole grid is never held in memory.
+     *
      * An optional \a feedback object can be set for progress reports and cancellation support
      *
      * \returns 0 in case of success
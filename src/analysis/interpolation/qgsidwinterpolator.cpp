@@ -17,8 +17,11 @@
 
 #include "qgsidwinterpolator.h"
 #include "qgis.h"
+#include <algorithm>
 #include <cmath>
 #include <limits>
+#include <utility>
+#include <vector>
 
 QgsIDWInterpolator::QgsIDWInterpolator( const QList<LayerData> &layerData )
   : QgsInterpolator( layerData )
@@ -31,6 +34,13 @@ int QgsIDWInterpolator::interpolatePoint( double x, double y, double &result, Qg
     cacheBaseData( feedback );
   }
 
+  if ( mMaxPoints > 0 || mSearchRadius > 0 )
+  {
+    if ( !mIndexIsBuilt )
+      buildIndex();
+    return interpolatePointFromIndex( x, y, result );
+  }
+
   double sumCounter = 0;
   double sumDenominator = 0;
 
@@ -55,3 +65,148 @@ int QgsIDWInterpolator::interpolatePoint( double x, double y, double &result, Qg
   result = sumCounter / sumDenominator;
   return 0;
 }
+
+void QgsIDWInterpolator::buildIndex()
+{
+  mIndexIsBuilt = true;
+  mIndexCellStarts.clear();
+  mIndexPoints.clear();
+  mIndexColumns = 0;
+  mIndexRows = 0;
+  if ( mCachedBaseData.isEmpty() )
+    return;
+
+  double xMax = std::numeric_limits< double >::lowest();
+  double yMax = std::numeric_limits< double >::lowest();
+  mIndexXMin = std::numeric_limits< double >::max();
+  mIndexYMin = std::numeric_limits< double >::max();
+  for ( const QgsInterpolatorVertexData &vertex : qgis::as_const( mCachedBaseData ) )
+  {
+    mIndexXMin = std::min( mIndexXMin, vertex.x );
+    mIndexYMin = std::min( mIndexYMin, vertex.y );
+    xMax = std::max( xMax, vertex.x );
+    yMax = std::max( yMax, vertex.y );
+  }
+
+  // about two points per cell, with at most 2048 cells on each side
+  const double width = std::max( xMax - mIndexXMin, 1e-12 );
+  const double height = std::max( yMax - mIndexYMin, 1e-12 );
+  mIndexCellSize = std::sqrt( width * height / std::max( 1, mCachedBaseData.size() / 2 ) );
+  mIndexCellSize = std::max( { mIndexCellSize, width / 2048, height / 2048 } );
+  mIndexColumns = std::max( 1, static_cast< int >( std::ceil( width / mIndexCellSize ) ) );
+  mIndexRows = std::max( 1, static_cast< int >( std::ceil( height / mIndexCellSize ) ) );
+
+  auto cellForPoint = [this]( const QgsInterpolatorVertexData & vertex )->int
+  {
+    const int column = std::min( static_cast< int >( ( vertex.x - mIndexXMin ) / mIndexCellSize ), mIndexColumns - 1 );
+    const int row = std::min( static_cast< int >( ( vertex.y - mIndexYMin ) / mIndexCellSize ), mIndexRows - 1 );
+    return row * mIndexColumns + column;
+  };
+
+  mIndexCellStarts.fill( 0, mIndexColumns * mIndexRows + 1 );
+  for ( const QgsInterpolatorVertexData &vertex : qgis::as_const( mCachedBaseData ) )
+    mIndexCellStarts[ cellForPoint( vertex ) + 1 ]++;
+  for ( int cell = 0; cell < mIndexColumns * mIndexRows; ++cell )
+    mIndexCellStarts[ cell + 1 ] += mIndexCellStarts[ cell ];
+
+  mIndexPoints.resize( mCachedBaseData.size() );
+  QVector< int > next = mIndexCellStarts;
+  for ( int i = 0; i < mCachedBaseData.size(); ++i )
+    mIndexPoints[ next[ cellForPoint( mCachedBaseData.at( i ) ) ]++ ] = i;
+}
+
+int QgsIDWInterpolator::interpolatePointFromIndex( double x, double y, double &result ) const
+{
+  if ( mIndexPoints.isEmpty() )
+    return 1;
+
+  // the grid cells are visited by rings of growing size around the cell of the location, keeping the
+  // nearest points (as squared distance, point index) in a max heap when their count is limited
+  const double maxDistanceSquared = mSearchRadius > 0 ? mSearchRadius * mSearchRadius : std::numeric_limits< double >::infinity();
+  std::vector< std::pair< double, int > > nearest;
+  const int column = static_cast< int >( std::floor( ( x - mIndexXMin ) / mIndexCellSize ) );
+  const int row = static_cast< int >( std::floor( ( y - mIndexYMin ) / mIndexCellSize ) );
+  const int maxRing = std::max( { std::abs( column ), std::abs( column - mIndexColumns + 1 ), std::abs( row ), std::abs( row - mIndexRows + 1 ) } );
+
+  auto visitCell = [&]( int cellColumn, int cellRow )
+  {
+    if ( cellColumn < 0 || cellColumn >= mIndexColumns || cellRow < 0 || cellRow >= mIndexRows )
+      return;
+
+    const int cell = cellRow * mIndexColumns + cellColumn;
+    for ( int i = mIndexCellStarts.at( cell ); i < mIndexCellStarts.at( cell + 1 ); ++i )
+    {
+      const int index = mIndexPoints.at( i );
+      const QgsInterpolatorVertexData &vertex = mCachedBaseData.at( index );
+      const double distanceSquared = ( vertex.x - x ) * ( vertex.x - x ) + ( vertex.y - y ) * ( vertex.y - y );
+      if ( distanceSquared > maxDistanceSquared )
+        continue;
+
+      if ( mMaxPoints <= 0 || static_cast< int >( nearest.size() ) < mMaxPoints )
+      {
+        nearest.emplace_back( distanceSquared, index );
+        if ( mMaxPoints > 0 )
+          std::push_heap( nearest.begin(), nearest.end() );
+      }
+      else if ( distanceSquared < nearest.front().first )
+      {
+        std::pop_heap( nearest.begin(), nearest.end() );
+        nearest.back() = std::make_pair( distanceSquared, index );
+        std::push_heap( nearest.begin(), nearest.end() );
+      }
+    }
+  };
+
+  for ( int ring = 0; ring <= maxRing; ++ring )
+  {
+    if ( ring == 0 )
+    {
+      visitCell( column, row );
+    }
+    else
+    {
+      for ( int c = column - ring; c <= column + ring; ++c )
+      {
+        visitCell( c, row - ring );
+        visitCell( c, row + ring );
+      }
+      for ( int r = row - ring + 1; r <= row + ring - 1; ++r )
+      {
+        visitCell( column - ring, r );
+        visitCell( column + ring, r );
+      }
+    }
+
+    // the points of the next ring are at least this far from the location
+    const double nextRingDistance = ring * mIndexCellSize;
+    const double nextRingDistanceSquared = nextRingDistance * nextRingDistance;
+    if ( nextRingDistanceSquared > maxDistanceSquared )
+      break;
+    if ( mMaxPoints > 0 && static_cast< int >( nearest.size() ) == mMaxPoints && nextRingDistanceSquared >= nearest.front().first )
+      break;
+  }
+
+  double sumCounter = 0;
+  double sumDenominator = 0;
+  for ( const std::pair< double, int > &point : nearest )
+  {
+    const QgsInterpolatorVertexData &vertex = mCachedBaseData.at( point.second );
+    double distance = std::sqrt( point.first );
+    if ( qgsDoubleNear( distance, 0.0 ) )
+    {
+      result = vertex.z;
+      return 0;
+    }
+    double currentWeight = 1 / ( std::pow( distance, mDistanceCoefficient ) );
+    sumCounter += ( currentWeight * vertex.z );
+    sumDenominator += currentWeight;
+  }
+
+  if ( sumDenominator == 0.0 )
+  {
+    return 1;
+  }
+
+  result = sumCounter / sumDenominator;
+  return 0;
+}
@@ -21,6 +21,8 @@
 #include "qgsinterpolator.h"
 #include "qgis_analysis.h"
 
+#include <algorithm>
+
 /**
  * \ingroup analysis
  * \class QgsIDWInterpolator
@@ -60,11 +62,70 @@ class ANALYSIS_EXPORT QgsIDWInterpolator: public QgsInterpolator
     */
     double distanceCoefficient() const { return mDistanceCoefficient; }
 
+    /**
+     * Sets the maximum number of the nearest points used to interpolate each location. A value of 0 (the default)
+     * uses all the points.
+     *
+     * Limiting the number of points, or the search radius, lets the interpolator find the points through a spatial
+     * index instead of weighting all of them for each location, which is much faster for large point sets.
+     *
+     * \see maxPoints()
+     * \see setSearchRadius()
+     * \since QGIS 3.16
+     */
+    void setMaxPoints( int points ) { mMaxPoints = std::max( 0, points ); }
+
+    /**
+     * Returns the maximum number of the nearest points used to interpolate each location, or 0 if all the points are used.
+     *
+     * \see setMaxPoints()
+     * \since QGIS 3.16
+     */
+    int maxPoints() const { return mMaxPoints; }
+
+    /**
+     * Sets the search \a radius, in map units, of the points used to interpolate each location. A value of 0 (the default)
+     * means no limit. Locations without any point within the radius are not interpolated.
+     *
+     * \see searchRadius()
+     * \see setMaxPoints()
+     * \since QGIS 3.16
+     */
+    void setSearchRadius( double radius ) { mSearchRadius = std::max( 0.0, radius ); }
+
+    /**
+     * Returns the search radius, in map units, of the points used to interpolate each location, or 0 if it is not limited.
+     *
+     * \see setSearchRadius()
+     * \since QGIS 3.16
+     */
+    double searchRadius() const { return mSearchRadius; }
+
+    bool supportsParallelInterpolation() const override { return true; }
+
   private:
 
     QgsIDWInterpolator() = delete;
 
+    //! Sorts the cached points into the cells of a regular grid
+    void buildIndex();
+
+    //! Returns the weighted value of the nearest points within the search radius, through the index
+    int interpolatePointFromIndex( double x, double y, double &result ) const;
+
     double mDistanceCoefficient = 2.0;
+    int mMaxPoints = 0;
+    double mSearchRadius = 0;
+
+    // grid index of the cached points, the points of cell c are mIndexPoints[ mIndexCellStarts[ c ] ] to mIndexPoints[ mIndexCellStarts[ c + 1 ] - 1 ]
+    bool mIndexIsBuilt = false;
+    double mIndexXMin = 0;
+    double mIndexYMin = 0;
+    double mIndexCellSize = 1;
+    int mIndexColumns = 0;
+    int mIndexRows = 0;
+    QVector< int > mIndexCellStarts;
+    QVector< int > mIndexPoints;
 };
 
 #endif
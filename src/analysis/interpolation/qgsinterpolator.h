@@ -126,6 +126,16 @@ class ANALYSIS_EXPORT QgsInterpolator
      */
     virtual int interpolatePoint( double x, double y, double &result SIP_OUT, QgsFeedback *feedback = nullptr ) = 0;
 
+    /**
+     * Returns TRUE if interpolatePoint() can be called from several threads at once, once a first call
+     * has cached the base data.
+     *
+     * The default implementation returns FALSE.
+     *
+     * \since QGIS 3.16
+     */
+    virtual bool supportsParallelInterpolation() const { return false; }
+
     //! \note not available in Python bindings
     QList<LayerData> layerData() const { return mLayerData; } SIP_SKIP
 
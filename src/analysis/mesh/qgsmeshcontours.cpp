@@ -30,10 +30,16 @@
 #include "qgsfeedback.h"
 #include "qgsproject.h"
 
+#include <algorithm>
 #include <limits>
 
 #include <QSet>
 #include <QPair>
+#include <QThread>
+#include <QtConcurrent>
+
+// minimum number of triangles of the ranges processed in parallel
+static const int TRIANGLES_PER_RANGE = 10000;
 
 QgsMeshContours::QgsMeshContours( QgsMeshLayer *layer )
   : mMeshLayer( layer )
@@ -54,43 +60,54 @@ QgsMeshContours::QgsMeshContours( QgsMeshLayer *layer )
 
 QgsMeshContours::~QgsMeshContours() = default;
 
-QgsGeometry QgsMeshContours::exportPolygons(
-  const QgsMeshDatasetIndex &index,
-  double min_value,
-  double max_value,
-  QgsMeshRendererScalarSettings::DataResamplingMethod method,
-  QgsFeedback *feedback
-)
-{
-  // Check if the layer/mesh is valid
-  if ( !mTriangularMesh )
-    return QgsGeometry();
+///@cond PRIVATE
 
-  if ( min_value > max_value )
-  {
-    double tmp = max_value;
-    max_value = min_value;
-    min_value = tmp;
-  }
-
-  QVector<QgsGeometry> multiPolygon;
+// part of a contour line crossing a triangle, for the level at index level of the sorted levels
+struct QgsMeshContourSegment
+{
+  int level = 0;
+  // mesh vertices of the ends of a mesh edge lying on the contour line, or -1
+  int exactEdgeStart = -1;
+  int exactEdgeEnd = -1;
+  QgsPoint start;
+  QgsPoint end;
+};
+
+// the triangles are processed in parallel by ranges, whose results are merged in the order of the triangles
+static QVector< QPair< int, int > > triangleRanges( int triangleCount )
+{
+  const int rangeCount = std::max( 1, std::min( triangleCount / TRIANGLES_PER_RANGE + 1, QThread::idealThreadCount() * 4 ) );
+  const int rangeSize = triangleCount / rangeCount + 1;
+  QVector< QPair< int, int > > ranges;
+  for ( int first = 0; first < triangleCount; first += rangeSize )
+    ranges << qMakePair( first, std::min( first + rangeSize, triangleCount ) );
+  return ranges;
+}
 
-  // STEP 1: Get Data
-  populateCache( index, method );
-  const QVector<QgsMeshVertex> vertices = mTriangularMesh->vertices();
-  const QVector<int> &trianglesToNativeFaces = mTriangularMesh->trianglesToNativeFaces();
+// polygons made of the parts of the triangles in [range.first, range.second) with values between min_value and max_value
+static QVector<QgsGeometry> trianglePolygons( const QPair< int, int > &range,
+    const QgsTriangularMesh &mesh,
+    const QVector<double> &datasetValues,
+    const QgsMeshDataBlock &activeFaceFlagValues,
+    double min_value,
+    double max_value,
+    QgsFeedback *feedback )
+{
+  QVector<QgsGeometry> polygons;
+  const QVector<QgsMeshVertex> &vertices = mesh.vertices();
+  const QVector<QgsMeshFace> &triangles = mesh.triangles();
+  const QVector<int> &trianglesToNativeFaces = mesh.trianglesToNativeFaces();
 
-  // STEP 2: For each triangle get the contour line
-  for ( int i = 0; i < mTriangularMesh->triangles().size(); ++i )
+  for ( int t = range.first; t < range.second; ++t )
   {
-    if ( feedback && feedback->isCanceled() )
+    if ( feedback && ( t - range.first ) % 1000 == 0 && feedback->isCanceled() )
       break;
 
-    int nativeIndex = trianglesToNativeFaces.at( i );
-    if ( !mScalarActiveFaceFlagValues.active( nativeIndex ) )
+    int nativeIndex = trianglesToNativeFaces.at( t );
+    if ( !activeFaceFlagValues.active( nativeIndex ) )
       continue;
 
-    const QgsMeshFace &triangle = mTriangularMesh->triangles().at( i );
+    const QgsMeshFace &triangle = triangles.at( t );
     const int indices[3] =
     {
       triangle.at( 0 ),
@@ -98,7 +115,7 @@ QgsGeometry QgsMeshContours::exportPolygons(
       triangle.at( 2 )
     };
 
-    const QVector<QgsMeshVertex> coords =
+    const QgsMeshVertex coords[3] =
     {
       vertices.at( indices[0] ),
       vertices.at( indices[1] ),
@@ -107,9 +124,9 @@ QgsGeometry QgsMeshContours::exportPolygons(
 
     const double values[3] =
     {
-      mDatasetValues.at( indices[0] ),
-      mDatasetValues.at( indices[1] ),
-      mDatasetValues.at( indices[2] )
+      datasetValues.at( indices[0] ),
+      datasetValues.at( indices[1] ),
+      datasetValues.at( indices[2] )
     };
 
     // any value is NaN
@@ -131,12 +148,10 @@ QgsGeometry QgsMeshContours::exportPolygons(
     // all values are inside the range == take whole triangle
     if ( valueInRange[0] && valueInRange[1] && valueInRange[2] )
     {
-      QVector<QgsMeshVertex> ring = coords;
-      ring.push_back( coords[0] );
-      std::unique_ptr< QgsLineString > ext = qgis::make_unique< QgsLineString> ( coords );
+      std::unique_ptr< QgsLineString > ext = qgis::make_unique< QgsLineString> ( QVector<QgsPoint>( { coords[0], coords[1], coords[2] } ) );
       std::unique_ptr< QgsPolygon > poly = qgis::make_unique< QgsPolygon >();
       poly->setExteriorRing( ext.release() );
-      multiPolygon.push_back( QgsGeometry( std::move( poly ) ) );
+      polygons.push_back( QgsGeometry( std::move( poly ) ) );
       continue;
     }
 
@@ -236,50 +251,35 @@ QgsGeometry QgsMeshContours::exportPolygons(
       std::unique_ptr< QgsLineString > ext = qgis::make_unique< QgsLineString> ( ring );
       std::unique_ptr< QgsPolygon > poly = qgis::make_unique< QgsPolygon >();
       poly->setExteriorRing( ext.release() );
-      multiPolygon.push_back( QgsGeometry( std::move( poly ) ) );
+      polygons.push_back( QgsGeometry( std::move( poly ) ) );
     }
   }
-
-  // STEP 3: dissolve the individual polygons from triangles if possible
-  if ( multiPolygon.isEmpty() )
-  {
-    return QgsGeometry();
-  }
-  else
-  {
-    QgsGeometry res = QgsGeometry::unaryUnion( multiPolygon );
-    return res;
-  }
+  return polygons;
 }
 
-QgsGeometry QgsMeshContours::exportLines( const QgsMeshDatasetIndex &index,
-    double value,
-    QgsMeshRendererScalarSettings::DataResamplingMethod method,
+// segments of the contour lines of all the sorted levels crossing the triangles in [range.first, range.second)
+static QVector<QgsMeshContourSegment> triangleContourSegments( const QPair< int, int > &range,
+    const QgsTriangularMesh &mesh,
+    const QVector<double> &datasetValues,
+    const QgsMeshDataBlock &activeFaceFlagValues,
+    const QVector<double> &levels,
     QgsFeedback *feedback )
 {
-  // Check if the layer/mesh is valid
-  if ( !mTriangularMesh )
-    return QgsGeometry();
-
-  std::unique_ptr<QgsMultiLineString> multiLineString( new QgsMultiLineString() );
-  QSet<QPair<int, int>> exactEdges;
+  QVector<QgsMeshContourSegment> segments;
+  const QVector<QgsMeshVertex> &vertices = mesh.vertices();
+  const QVector<QgsMeshFace> &triangles = mesh.triangles();
+  const QVector<int> &trianglesToNativeFaces = mesh.trianglesToNativeFaces();
 
-  // STEP 1: Get Data
-  populateCache( index, method );
-  QVector<QgsMeshVertex> vertices = mTriangularMesh->vertices();
-  const QVector<int> &trianglesToNativeFaces = mTriangularMesh->trianglesToNativeFaces();
-
-  // STEP 2: For each triangle get the contour line
-  for ( int i = 0; i < mTriangularMesh->triangles().size(); ++i )
+  for ( int t = range.first; t < range.second; ++t )
   {
-    if ( feedback && feedback->isCanceled() )
+    if ( feedback && ( t - range.first ) % 1000 == 0 && feedback->isCanceled() )
       break;
 
-    int nativeIndex = trianglesToNativeFaces.at( i );
-    if ( !mScalarActiveFaceFlagValues.active( nativeIndex ) )
+    int nativeIndex = trianglesToNativeFaces.at( t );
+    if ( !activeFaceFlagValues.active( nativeIndex ) )
       continue;
 
-    const QgsMeshFace &triangle = mTriangularMesh->triangles().at( i );
+    const QgsMeshFace &triangle = triangles.at( t );
 
     const int indices[3] =
     {
@@ -288,7 +288,7 @@ QgsGeometry QgsMeshContours::exportLines( const QgsMeshDatasetIndex &index,
       triangle.at( 2 )
     };
 
-    const QVector<QgsMeshVertex> coords =
+    const QgsMeshVertex coords[3] =
     {
       vertices.at( indices[0] ),
       vertices.at( indices[1] ),
@@ -297,89 +297,215 @@ QgsGeometry QgsMeshContours::exportLines( const QgsMeshDatasetIndex &index,
 
     const double values[3] =
     {
-      mDatasetValues.at( indices[0] ),
-      mDatasetValues.at( indices[1] ),
-      mDatasetValues.at( indices[2] )
+      datasetValues.at( indices[0] ),
+      datasetValues.at( indices[1] ),
+      datasetValues.at( indices[2] )
     };
 
     // any value is NaN
     if ( std::isnan( values[0] ) || std::isnan( values[1] ) || std::isnan( values[2] ) )
       continue;
 
-    // value is outside the range
-    if ( ( ( value > values[0] ) && ( value > values[1] ) && ( value > values[2] ) )  ||
-         ( ( value < values[0] ) && ( value < values[1] ) && ( value < values[2] ) ) )
-      continue;
-
     // all values are the same
     if ( qgsDoubleNear( values[0], values[1] ) && qgsDoubleNear( values[1], values[2] ) )
       continue;
 
-    // go through all edges
-    QgsPoint tmp;
-
-    for ( int i = 0; i < 3; ++i )
+    // levels between the lowest and the highest values of the triangle
+    const double minValue = std::min( { values[0], values[1], values[2] } );
+    const double maxValue = std::max( { values[0], values[1], values[2] } );
+    const auto levelsEnd = std::upper_bound( levels.constBegin(), levels.constEnd(), maxValue );
+    for ( auto levelIt = std::lower_bound( levels.constBegin(), levels.constEnd(), minValue ); levelIt < levelsEnd; ++levelIt )
     {
-      const int j = ( i + 1 ) % 3;
-      // value is outside the range
-      if ( ( ( value > values[i] ) && ( value > values[j] ) ) ||
-           ( ( value < values[i] ) && ( value < values[j] ) ) )
-        continue;
+      const double value = *levelIt;
+      const int level = static_cast< int >( levelIt - levels.constBegin() );
+
+      // go through all edges
+      QgsPoint tmp;
 
-      // the whole edge is result and we are done
-      if ( qgsDoubleNear( values[i], values[j] ) && qgsDoubleNear( values[i], values[j] ) )
+      for ( int i = 0; i < 3; ++i )
       {
-        if ( exactEdges.contains( { indices[i], indices[j] } ) || exactEdges.contains( { indices[j], indices[i] } ) )
+        const int j = ( i + 1 ) % 3;
+        // value is outside the range
+        if ( ( ( value > values[i] ) && ( value > values[j] ) ) ||
+             ( ( value < values[i] ) && ( value < values[j] ) ) )
+          continue;
+
+        // the whole edge is result and we are done
+        if ( qgsDoubleNear( values[i], values[j] ) )
         {
+          QgsMeshContourSegment segment;
+          segment.level = level;
+          segment.exactEdgeStart = indices[i];
+          segment.exactEdgeEnd = indices[j];
+          segment.start = coords[i];
+          segment.end = coords[j];
+          segments << segment;
           break;
         }
+
+        // only one point matches, we are not interested in this
+        if ( qgsDoubleNear( values[i], value ) || qgsDoubleNear( values[j], value ) )
+        {
+          continue;
+        }
+
+        // ok part of the result contour line is one point on this edge
+        const double fraction = ( value - values[i] ) / ( values[j] - values[i] );
+        const QgsPoint xy = QgsGeometryUtils::interpolatePointOnLine( coords[i], coords[j], fraction );
+
+        if ( std::isnan( tmp.x() ) )
+        {
+          // ok we have found start point of the contour line
+          tmp = xy;
+        }
         else
         {
-          exactEdges.insert( { indices[i], indices[j] } );
-          std::unique_ptr<QgsLineString> line( new QgsLineString( coords[i], coords[j] ) );
-          multiLineString->addGeometry( line.release() );
+          // we have found the end point of the contour line, we are done
+          QgsMeshContourSegment segment;
+          segment.level = level;
+          segment.start = tmp;
+          segment.end = xy;
+          segments << segment;
           break;
         }
       }
+    }
+  }
+  return segments;
+}
 
-      // only one point matches, we are not interested in this
-      if ( qgsDoubleNear( values[i], value ) || qgsDoubleNear( values[j], value ) )
-      {
-        continue;
-      }
+///@endcond
 
-      // ok part of the result contour line is one point on this edge
-      const double fraction = ( value - values[i] ) / ( values[j] - values[i] );
-      const QgsPoint xy = QgsGeometryUtils::interpolatePointOnLine( coords[i], coords[j], fraction );
+QgsGeometry QgsMeshContours::exportPolygons(
+  const QgsMeshDatasetIndex &index,
+  double min_value,
+  double max_value,
+  QgsMeshRendererScalarSettings::DataResamplingMethod method,
+  QgsFeedback *feedback
+)
+{
+  // Check if the layer/mesh is valid
+  if ( !mTriangularMesh )
+    return QgsGeometry();
 
-      if ( std::isnan( tmp.x() ) )
-      {
-        // ok we have found start point of the contour line
-        tmp = xy;
-      }
-      else
-      {
-        // we have found the end point of the contour line, we are done
-        std::unique_ptr<QgsLineString> line( new QgsLineString( tmp, xy ) );
-        multiLineString->addGeometry( line.release() );
-        break;
-      }
-    }
+  if ( min_value > max_value )
+  {
+    double tmp = max_value;
+    max_value = min_value;
+    min_value = tmp;
   }
 
-  // STEP 3: merge the contour segments to linestrings
-  if ( multiLineString->isEmpty() )
+  // STEP 1: Get Data
+  populateCache( index, method );
+
+  // STEP 2: For each triangle get the contour polygon, and dissolve the polygons of each range of triangles
+  const QVector< QPair< int, int > > ranges = triangleRanges( mTriangularMesh->triangles().size() );
+  const QgsTriangularMesh &mesh = *mTriangularMesh;
+  const QVector<double> &datasetValues = mDatasetValues;
+  const QgsMeshDataBlock &activeFaceFlagValues = mScalarActiveFaceFlagValues;
+  const QVector< QVector<QgsGeometry> > rangePolygons = QtConcurrent::blockingMapped< QVector< QVector<QgsGeometry> > >( ranges, [&]( const QPair< int, int > &range )
+  {
+    const QVector<QgsGeometry> polygons = trianglePolygons( range, mesh, datasetValues, activeFaceFlagValues, min_value, max_value, feedback );
+    if ( polygons.size() < 2 || ranges.size() == 1 )
+      return polygons;
+    return QVector<QgsGeometry>() << QgsGeometry::unaryUnion( polygons );
+  } );
+
+  // STEP 3: dissolve the polygons of the ranges if possible
+  QVector<QgsGeometry> multiPolygon;
+  for ( const QVector<QgsGeometry> &polygons : rangePolygons )
+  {
+    for ( const QgsGeometry &polygon : polygons )
+    {
+      if ( !polygon.isNull() )
+        multiPolygon << polygon;
+    }
+  }
+  if ( multiPolygon.isEmpty() )
   {
     return QgsGeometry();
   }
   else
   {
-    const QgsGeometry in( multiLineString.release() );
-    const QgsGeometry res = in.mergeLines();
+    QgsGeometry res = QgsGeometry::unaryUnion( multiPolygon );
     return res;
   }
 }
 
+QgsGeometry QgsMeshContours::exportLines( const QgsMeshDatasetIndex &index,
+    double value,
+    QgsMeshRendererScalarSettings::DataResamplingMethod method,
+    QgsFeedback *feedback )
+{
+  return exportLines( index, QVector<double>() << value, method, feedback ).value( 0 );
+}
+
+QVector<QgsGeometry> QgsMeshContours::exportLines( const QgsMeshDatasetIndex &index,
+    const QVector<double> &values,
+    QgsMeshRendererScalarSettings::DataResamplingMethod method,
+    QgsFeedback *feedback )
+{
+  QVector<QgsGeometry> result( values.size() );
+
+  // Check if the layer/mesh is valid
+  if ( !mTriangularMesh )
+    return result;
+
+  // STEP 1: Get Data
+  populateCache( index, method );
+
+  QVector<double> levels = values;
+  levels.erase( std::remove_if( levels.begin(), levels.end(), []( double level ) { return std::isnan( level ); } ), levels.end() );
+  std::sort( levels.begin(), levels.end() );
+  levels.erase( std::unique( levels.begin(), levels.end() ), levels.end() );
+
+  // STEP 2: For each triangle get the contour lines of all the levels in a single pass
+  const QVector< QPair< int, int > > ranges = triangleRanges( mTriangularMesh->triangles().size() );
+  const QgsTriangularMesh &mesh = *mTriangularMesh;
+  const QVector<double> &datasetValues = mDatasetValues;
+  const QgsMeshDataBlock &activeFaceFlagValues = mScalarActiveFaceFlagValues;
+  const QVector< QVector<QgsMeshContourSegment> > rangeSegments = QtConcurrent::blockingMapped< QVector< QVector<QgsMeshContourSegment> > >( ranges, [&]( const QPair< int, int > &range )
+  {
+    return triangleContourSegments( range, mesh, datasetValues, activeFaceFlagValues, levels, feedback );
+  } );
+
+  std::vector< std::unique_ptr<QgsMultiLineString> > levelLines;
+  std::vector< QSet<QPair<int, int>> > exactEdges( levels.size() );
+  for ( int level = 0; level < levels.size(); ++level )
+    levelLines.emplace_back( new QgsMultiLineString() );
+
+  for ( const QVector<QgsMeshContourSegment> &segments : rangeSegments )
+  {
+    for ( const QgsMeshContourSegment &segment : segments )
+    {
+      if ( segment.exactEdgeStart >= 0 )
+      {
+        // edges shared by two triangles are only added once
+        QSet<QPair<int, int>> &levelExactEdges = exactEdges[ segment.level ];
+        if ( levelExactEdges.contains( { segment.exactEdgeStart, segment.exactEdgeEnd } ) || levelExactEdges.contains( { segment.exactEdgeEnd, segment.exactEdgeStart } ) )
+          continue;
+        levelExactEdges.insert( { segment.exactEdgeStart, segment.exactEdgeEnd } );
+      }
+      levelLines[ segment.level ]->addGeometry( new QgsLineString( segment.start, segment.end ) );
+    }
+  }
+
+  // STEP 3: merge the contour segments to linestrings
+  for ( int i = 0; i < values.size(); ++i )
+  {
+    if ( std::isnan( values.at( i ) ) )
+      continue;
+
+    const int level = static_cast< int >( std::lower_bound( levels.constBegin(), levels.constEnd(), values.at( i ) ) - levels.constBegin() );
+    if ( levelLines[ level ]->isEmpty() )
+      continue;
+
+    const QgsGeometry in( levelLines[ level ]->clone() );
+    result[ i ] = in.mergeLines();
+  }
+  return result;
+}
+
 void QgsMeshContours::populateCache( const QgsMeshDatasetIndex &index, QgsMeshRendererScalarSettings::DataResamplingMethod method )
 {
   if ( mCachedIndex != index )
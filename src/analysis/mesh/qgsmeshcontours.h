@@ -72,6 +72,20 @@ class ANALYSIS_EXPORT QgsMeshContours
                              QgsMeshRendererScalarSettings::DataResamplingMethod method,
                              QgsFeedback *feedback = nullptr );
 
+    /**
+     * Exports the contour lines of several values for particular dataset, in a single pass over the mesh
+     * \param index dataset index
+     * \param values values of the contour lines
+     * \param method for datasets defined on faces, the method will be used to convert data to vertices
+     * \param feedback optional feedback object for progress and cancellation support
+     * \returns MultiLineString geometries containing contour lines, in the order of \a values
+     * \since QGIS 3.16
+     */
+    QVector<QgsGeometry> exportLines( const QgsMeshDatasetIndex &index,
+                                      const QVector<double> &values,
+                                      QgsMeshRendererScalarSettings::DataResamplingMethod method,
+                                      QgsFeedback *feedback = nullptr );
+
     /**
      * Exports multi polygons representing the areas with values in range for particular dataset
      * \param index dataset index
@@ -13,36 +13,119 @@
 *                                                                          *
 ***************************************************************************/
 
+#include <algorithm>
 #include <limits>
+#include <functional>
+#include <queue>
+#include <vector>
 
-#include <QMap>
+#include <QThread>
 #include <QVector>
-#include <QPair>
+#include <QtConcurrentMap>
 
+#include "qgsfeedback.h"
 #include "qgsgraph.h"
 #include "qgsgraphanalyzer.h"
 
-void QgsGraphAnalyzer::dijkstra( const QgsGraph *source, int startPointIdx, int criterionNum, QVector<int> *resultTree, QVector<double> *resultCost )
+///@cond PRIVATE
+
+/**
+ * Compressed sparse row adjacency of a graph for one criterion: the edges leaving (or, for a reversed
+ * adjacency, entering) vertex v are at indices offsets[v] to offsets[v + 1] - 1 of the other arrays.
+ *
+ * The edge costs are converted from their QVariant once, instead of each time an edge is scanned.
+ */
+struct QgsGraphAdjacency
 {
-  if ( startPointIdx < 0 || startPointIdx >= source->vertexCount() )
+  QgsGraphAdjacency( const QgsGraph *graph, int criterionNum, bool reversed )
   {
-    // invalid start point
-    return;
+    const int vertexCount = graph->vertexCount();
+    const int edgeCount = graph->edgeCount();
+    offsets.fill( 0, vertexCount + 1 );
+    for ( int i = 0; i < edgeCount; ++i )
+    {
+      const QgsGraphEdge &edge = graph->edge( i );
+      offsets[( reversed ? edge.toVertex() : edge.fromVertex() ) + 1 ]++;
+    }
+    for ( int v = 0; v < vertexCount; ++v )
+      offsets[ v + 1 ] += offsets[ v ];
+
+    edgeIds.resize( edgeCount );
+    vertices.resize( edgeCount );
+    costs.resize( edgeCount );
+    QVector< int > next = offsets;
+    for ( int i = 0; i < edgeCount; ++i )
+    {
+      const QgsGraphEdge &edge = graph->edge( i );
+      const int index = next[ reversed ? edge.toVertex() : edge.fromVertex() ]++;
+      edgeIds[ index ] = i;
+      vertices[ index ] = reversed ? edge.fromVertex() : edge.toVertex();
+      costs[ index ] = edge.cost( criterionNum ).toDouble();
+    }
   }
 
-  QVector< double > *result = nullptr;
-  if ( resultCost )
+  QVector< int > offsets;
+  //! Edge indices in the graph
+  QVector< int > edgeIds;
+  //! Vertex at the other end of each edge
+  QVector< int > vertices;
+  QVector< double > costs;
+};
+
+//! Binary heap of ( cost, vertex ) pairs, with the lowest cost on top
+typedef std::priority_queue< std::pair< double, int >, std::vector< std::pair< double, int > >, std::greater< std::pair< double, int > > > QgsGraphVertexQueue;
+
+///@endcond
+
+///@cond PRIVATE
+
+/**
+ * Runs a Dijkstra search from \a rootVertexIdx over the \a adjacency, filling the cost of each vertex in \a result,
+ * and if \a resultTree is not NULLPTR the index of the last edge of the path to each vertex.
+ */
+static void dijkstraSearch( const QgsGraphAdjacency &adjacency, int rootVertexIdx, QVector<int> *resultTree, QVector<double> &result )
+{
+  // vertices are not removed from the queue when their cost decreases, outdated entries are skipped instead
+  QgsGraphVertexQueue queue;
+  queue.push( std::make_pair( 0.0, rootVertexIdx ) );
+
+  while ( !queue.empty() )
   {
-    result = resultCost;
+    const double curCost = queue.top().first;
+    const int curVertex = queue.top().second;
+    queue.pop();
+    if ( curCost > result[ curVertex ] )
+      continue;
+
+    for ( int i = adjacency.offsets[ curVertex ]; i < adjacency.offsets[ curVertex + 1 ]; ++i )
+    {
+      const int toVertex = adjacency.vertices[ i ];
+      double cost = adjacency.costs[ i ] + curCost;
+
+      if ( cost < result[ toVertex ] )
+      {
+        result[ toVertex ] = cost;
+        if ( resultTree )
+        {
+          ( *resultTree )[ toVertex ] = adjacency.edgeIds[ i ];
+        }
+        queue.push( std::make_pair( cost, toVertex ) );
+      }
+    }
   }
-  else
+}
+
+static void dijkstraFromRoot( const QgsGraph *source, int rootVertexIdx, int criterionNum, bool reversed, QVector<int> *resultTree, QVector<double> *resultCost )
+{
+  if ( rootVertexIdx < 0 || rootVertexIdx >= source->vertexCount() )
   {
-    result = new QVector<double>();
+    // invalid start point
+    return;
   }
 
-  result->clear();
-  result->insert( result->begin(), source->vertexCount(), std::numeric_limits<double>::infinity() );
-  ( *result )[ startPointIdx ] = 0.0;
+  QVector< double > result;
+  result.fill( std::numeric_limits<double>::infinity(), source->vertexCount() );
+  result[ rootVertexIdx ] = 0.0;
 
   if ( resultTree )
   {
@@ -50,42 +133,175 @@ void QgsGraphAnalyzer::dijkstra( const QgsGraph *source, int startPointIdx, int
     resultTree->insert( resultTree->begin(), source->vertexCount(), -1 );
   }
 
-  // QMultiMap< cost, vertexIdx > not_begin
-  // I use it and don't create any struct or class
-  QMultiMap< double, int > not_begin;
-  QMultiMap< double, int >::iterator it;
+  dijkstraSearch( QgsGraphAdjacency( source, criterionNum, reversed ), rootVertexIdx, resultTree, result );
 
-  not_begin.insert( 0.0, startPointIdx );
+  if ( resultCost )
+    *resultCost = result;
+}
 
-  while ( !not_begin.empty() )
+///@endcond
+
+void QgsGraphAnalyzer::dijkstra( const QgsGraph *source, int startPointIdx, int criterionNum, QVector<int> *resultTree, QVector<double> *resultCost )
+{
+  dijkstraFromRoot( source, startPointIdx, criterionNum, false, resultTree, resultCost );
+}
+
+void QgsGraphAnalyzer::dijkstraToVertex( const QgsGraph *source, int endVertexIdx, int criterionNum, QVector<int> *resultTree, QVector<double> *resultCost )
+{
+  dijkstraFromRoot( source, endVertexIdx, criterionNum, true, resultTree, resultCost );
+}
+
+void QgsGraphAnalyzer::dijkstra( const QgsGraph *source, const QVector<int> &startVertexIndices, int criterionNum, const std::function< void( int, const QVector<int> &, const QVector<double> & ) > &visitor, QgsFeedback *feedback )
+{
+  if ( startVertexIndices.isEmpty() )
+    return;
+
+  // the adjacency is shared by all the searches, which run on blocks of consecutive start vertices
+  // so that each block reuses the same tree and cost buffers
+  const QgsGraphAdjacency adjacency( source, criterionNum, false );
+  const int vertexCount = source->vertexCount();
+  const int blockCount = std::min( startVertexIndices.size(), std::max( 1, QThread::idealThreadCount() ) * 4 );
+  QVector< int > blocks;
+  blocks.reserve( blockCount );
+  for ( int block = 0; block < blockCount; ++block )
+    blocks << block;
+
+  QtConcurrent::blockingMap( blocks, [&]( int block )
   {
-    it = not_begin.begin();
-    double curCost = it.key();
-    int curVertex = it.value();
-    not_begin.erase( it );
-
-    // edge index list
-    const QgsGraphEdgeIds &outgoingEdges = source->vertex( curVertex ).outgoingEdges();
-    for ( int edgeId : outgoingEdges )
+    QVector< int > tree;
+    QVector< double > costs;
+    const int first = static_cast< int >( static_cast< qint64 >( startVertexIndices.size() ) * block / blockCount );
+    const int last = static_cast< int >( static_cast< qint64 >( startVertexIndices.size() ) * ( block + 1 ) / blockCount );
+    for ( int i = first; i < last; ++i )
     {
-      const QgsGraphEdge &arc = source->edge( edgeId );
-      double cost = arc.cost( criterionNum ).toDouble() + curCost;
+      if ( feedback && feedback->isCanceled() )
+        return;
+
+      const int startVertexIdx = startVertexIndices.at( i );
+      if ( startVertexIdx < 0 || startVertexIdx >= vertexCount )
+        continue;
+
+      tree.fill( -1, vertexCount );
+      costs.fill( std::numeric_limits<double>::infinity(), vertexCount );
+      costs[ startVertexIdx ] = 0.0;
+      dijkstraSearch( adjacency, startVertexIdx, &tree, costs );
+      visitor( i, tree, costs );
+    }
+  } );
+}
+
+QVector< QVector< double > > QgsGraphAnalyzer::costMatrix( const QgsGraph *source, const QVector<int> &startVertexIndices, const QVector<int> &endVertexIndices, int criterionNum, QgsFeedback *feedback )
+{
+  QVector< QVector< double > > matrix( startVertexIndices.size(), QVector< double >( endVertexIndices.size(), std::numeric_limits<double>::infinity() ) );
+  // each search only writes its own row of the matrix
+  dijkstra( source, startVertexIndices, criterionNum, [&matrix, &endVertexIndices]( int i, const QVector<int> &, const QVector<double> &costs )
+  {
+    QVector< double > &row = matrix[ i ];
+    for ( int j = 0; j < endVertexIndices.size(); ++j )
+    {
+      const int endVertexIdx = endVertexIndices.at( j );
+      if ( endVertexIdx >= 0 && endVertexIdx < costs.size() )
+        row[ j ] = costs.at( endVertexIdx );
+    }
+  }, feedback );
+  return matrix;
+}
+
+bool QgsGraphAnalyzer::shortestPath( const QgsGraph *source, int startVertexIdx, int endVertexIdx, int criterionNum, QVector<int> *resultPath, double *resultCost )
+{
+  if ( resultPath )
+    resultPath->clear();
+
+  const int vertexCount = source->vertexCount();
+  if ( startVertexIdx < 0 || startVertexIdx >= vertexCount || endVertexIdx < 0 || endVertexIdx >= vertexCount )
+    return false;
+
+  if ( startVertexIdx == endVertexIdx )
+  {
+    if ( resultCost )
+      *resultCost = 0;
+    return true;
+  }
+
+  // index 0 is the forward search from the start vertex, index 1 the backward search from the end vertex
+  const QgsGraphAdjacency adjacency[2] = { QgsGraphAdjacency( source, criterionNum, false ), QgsGraphAdjacency( source, criterionNum, true ) };
+  QVector< double > costs[2];
+  QVector< int > trees[2];
+  QgsGraphVertexQueue queues[2];
+  const int roots[2] = { startVertexIdx, endVertexIdx };
+  for ( int side = 0; side < 2; ++side )
+  {
+    costs[ side ].fill( std::numeric_limits<double>::infinity(), vertexCount );
+    trees[ side ].fill( -1, vertexCount );
+    costs[ side ][ roots[ side ] ] = 0.0;
+    queues[ side ].push( std::make_pair( 0.0, roots[ side ] ) );
+  }
 
-      if ( cost < ( *result )[ arc.toVertex()] )
+  // best path found so far, through meetingEdge, going from meetingVertex[0] to meetingVertex[1]
+  double bestCost = std::numeric_limits<double>::infinity();
+  int meetingEdge = -1;
+  int meetingVertex[2] = { -1, -1 };
+
+  while ( !queues[0].empty() && !queues[1].empty() )
+  {
+    // no path through the unsettled vertices can be shorter than the best path found
+    if ( queues[0].top().first + queues[1].top().first >= bestCost )
+      break;
+
+    const int side = queues[0].top().first <= queues[1].top().first ? 0 : 1;
+    const double curCost = queues[ side ].top().first;
+    const int curVertex = queues[ side ].top().second;
+    queues[ side ].pop();
+    if ( curCost > costs[ side ][ curVertex ] )
+      continue;
+
+    const QgsGraphAdjacency &sideAdjacency = adjacency[ side ];
+    for ( int i = sideAdjacency.offsets[ curVertex ]; i < sideAdjacency.offsets[ curVertex + 1 ]; ++i )
+    {
+      const int toVertex = sideAdjacency.vertices[ i ];
+      const double cost = sideAdjacency.costs[ i ] + curCost;
+
+      if ( cost < costs[ side ][ toVertex ] )
       {
-        ( *result )[ arc.toVertex()] = cost;
-        if ( resultTree )
-        {
-          ( *resultTree )[ arc.toVertex()] = edgeId;
-        }
-        not_begin.insert( cost, arc.toVertex() );
+        costs[ side ][ toVertex ] = cost;
+        trees[ side ][ toVertex ] = sideAdjacency.edgeIds[ i ];
+        queues[ side ].push( std::make_pair( cost, toVertex ) );
+      }
+
+      const double pathCost = cost + costs[ 1 - side ][ toVertex ];
+      if ( pathCost < bestCost )
+      {
+        bestCost = pathCost;
+        meetingEdge = sideAdjacency.edgeIds[ i ];
+        meetingVertex[ side ] = curVertex;
+        meetingVertex[ 1 - side ] = toVertex;
       }
     }
   }
-  if ( !resultCost )
+
+  if ( meetingEdge == -1 )
+    return false;
+
+  if ( resultCost )
+    *resultCost = bestCost;
+
+  if ( resultPath )
   {
-    delete result;
+    for ( int vertex = meetingVertex[0]; vertex != startVertexIdx; )
+    {
+      const int edge = trees[0][ vertex ];
+      resultPath->prepend( edge );
+      vertex = source->edge( edge ).fromVertex();
+    }
+    resultPath->append( meetingEdge );
+    for ( int vertex = meetingVertex[1]; vertex != endVertexIdx; )
+    {
+      const int edge = trees[1][ vertex ];
+      resultPath->append( edge );
+      vertex = source->edge( edge ).toVertex();
+    }
   }
+  return true;
 }
 
 QgsGraph *QgsGraphAnalyzer::shortestTree( const QgsGraph *source, int startVertexIdx, int criterionNum )
@@ -17,10 +17,12 @@
 #define QGSGRAPHANALYZER_H
 
 #include <QVector>
+#include <functional>
 
 #include "qgis_sip.h"
 #include "qgis_analysis.h"
 
+class QgsFeedback;
 class QgsGraph;
 
 /**
@@ -75,6 +77,53 @@ class ANALYSIS_EXPORT QgsGraphAnalyzer
     % End
 #endif
 
+    /**
+     * Solve the shortest path problems from many start vertices, using Dijkstra algorithm.
+     *
+     * The searches run in parallel on the global thread pool and share a single read-only copy of the
+     * graph costs. The \a visitor is called once the search from each start vertex is complete, with
+     * the index of the start vertex in \a startVertexIndices and the shortest path tree and costs,
+     * as returned by dijkstra(). The \a visitor is called from several threads at once, and the tree
+     * and costs are only valid during the call.
+     *
+     * The optional \a feedback object can be used to cancel the remaining searches.
+     *
+     * \note not available in Python bindings
+     * \since QGIS 3.16
+     */
+    static void dijkstra( const QgsGraph *source, const QVector<int> &startVertexIndices, int criterionNum, const std::function< void( int, const QVector<int> &, const QVector<double> & ) > &visitor, QgsFeedback *feedback = nullptr ) SIP_SKIP;
+
+    /**
+     * Returns the matrix of the costs of the shortest paths from each of the \a startVertexIndices
+     * to each of the \a endVertexIndices, where matrix[ i ][ j ] is the cost from the start vertex at
+     * index i to the end vertex at index j, or infinity if it is not reachable.
+     *
+     * The searches run in parallel on the global thread pool. The optional \a feedback object can be used to cancel
+     * the computation, the remaining costs are then left to infinity.
+     *
+     * \note not available in Python bindings
+     * \since QGIS 3.16
+     */
+    static QVector< QVector< double > > costMatrix( const QgsGraph *source, const QVector<int> &startVertexIndices, const QVector<int> &endVertexIndices, int criterionNum, QgsFeedback *feedback = nullptr ) SIP_SKIP;
+
+    /**
+     * Solve the shortest path problem from all the vertices to a single end vertex, using Dijkstra algorithm
+     * over the reversed edges.
+     *
+     * This answers the routes from many start vertices to the same end vertex with a single search.
+     *
+     * \param source source graph
+     * \param endVertexIdx index of the end vertex
+     * \param criterionNum index of the optimization strategy
+     * \param resultTree array that represents the shortest path tree to the end vertex. resultTree[ vertexIndex ] == outgoingArcIndex
+     * if the end vertex is reachable from the vertex, otherwise resultTree[ vertexIndex ] == -1. The endVertexIdx will also have a value of -1.
+     * \param resultCost array of the costs of the paths to the end vertex
+     *
+     * \note not available in Python bindings
+     * \since QGIS 3.16
+     */
+    static void dijkstraToVertex( const QgsGraph *source, int endVertexIdx, int criterionNum, QVector<int> *resultTree = nullptr, QVector<double> *resultCost = nullptr ) SIP_SKIP;
+
     /**
      * Returns shortest path tree with root-node in startVertexIdx
      * \param source source graph
@@ -82,6 +131,25 @@ class ANALYSIS_EXPORT QgsGraphAnalyzer
      * \param criterionNum index of the optimization strategy
      */
     static QgsGraph *shortestTree( const QgsGraph *source, int startVertexIdx, int criterionNum );
+
+    /**
+     * Solve the shortest path problem between two vertices, using a bidirectional Dijkstra search.
+     *
+     * This is much faster than dijkstra() when only the route between two vertices is needed, as the
+     * search stops once the forward search from the start vertex meets the backward search from the end vertex.
+     *
+     * \param source source graph
+     * \param startVertexIdx index of the start vertex
+     * \param endVertexIdx index of the end vertex
+     * \param criterionNum index of the optimization strategy
+     * \param resultPath will be set to the indices of the edges of the path, from the start vertex to the end vertex
+     * \param resultCost will be set to the cost of the path
+     * \returns TRUE if the end vertex is reachable from the start vertex
+     *
+     * \note not available in Python bindings
+     * \since QGIS 3.16
+     */
+    static bool shortestPath( const QgsGraph *source, int startVertexIdx, int endVertexIdx, int criterionNum, QVector<int> *resultPath = nullptr, double *resultCost = nullptr ) SIP_SKIP;
 };
 
 #endif // QGSGRAPHANALYZER_H
@@ -29,29 +29,24 @@
 #include "qgsdistancearea.h"
 #include "qgswkbtypes.h"
 
+#include "qgsspatialindexpackedrtree.h"
+
+#include <QHash>
 #include <QString>
 #include <QtAlgorithms>
+#include <QtConcurrentMap>
 
-#include <spatialindex/SpatialIndex.h>
-
-using namespace SpatialIndex;
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
 
 struct TiePointInfo
 {
-  TiePointInfo() = default;
-  TiePointInfo( int additionalPointId, QgsFeatureId featureId, const QgsPointXY &start, const QgsPointXY &end )
-    : additionalPointId( additionalPointId )
-    , mNetworkFeatureId( featureId )
-    , mFirstPoint( start )
-    , mLastPoint( end )
-  {}
-
-  int additionalPointId = -1;
   QgsPointXY mTiedPoint;
   double mLength = std::numeric_limits<double>::max();
-  QgsFeatureId mNetworkFeatureId = -1;
-  QgsPointXY mFirstPoint;
-  QgsPointXY mLastPoint;
+  //! Index of the network segment the point is tied to
+  int mSegment = -1;
 };
 
 QgsVectorLayerDirector::QgsVectorLayerDirector( QgsFeatureSource *source,
@@ -113,58 +108,76 @@ QgsVectorLayerDirector::Direction QgsVectorLayerDirector::directionForFeature( c
 }
 
 ///@cond PRIVATE
-class QgsNetworkVisitor : public SpatialIndex::IVisitor
+
+/**
+ * Hash grid of the graph vertices, with cells the size of the topology tolerance, used to
+ * find an existing vertex within the tolerance of a point.
+ */
+class QgsNetworkVertexGrid
 {
   public:
-    explicit QgsNetworkVisitor( QVector< int > &pointIndexes )
-      : mPoints( pointIndexes ) {}
-
-    void visitNode( const INode &n ) override
-    { Q_UNUSED( n ) }
+    QgsNetworkVertexGrid( const QVector< QgsPointXY > &vertices, double tolerance )
+      : mVertices( vertices )
+      , mTolerance( tolerance )
+    {}
 
-    void visitData( const IData &d ) override
+    //! Returns the index of a vertex within the tolerance of \a point, or -1 if there is none
+    int find( const QgsPointXY &point ) const
     {
-      mPoints.append( d.getIdentifier() );
+      const qint64 cellX = cell( point.x() );
+      const qint64 cellY = cell( point.y() );
+      for ( qint64 x = cellX - 1; x <= cellX + 1; ++x )
+      {
+        for ( qint64 y = cellY - 1; y <= cellY + 1; ++y )
+        {
+          const auto it = mCells.constFind( qMakePair( x, y ) );
+          if ( it == mCells.constEnd() )
+            continue;
+
+          for ( int index : it.value() )
+          {
+            const QgsPointXY &vertex = mVertices.at( index );
+            if ( std::fabs( vertex.x() - point.x() ) <= mTolerance && std::fabs( vertex.y() - point.y() ) <= mTolerance )
+              return index;
+          }
+        }
+      }
+      return -1;
     }
 
-    void visitData( std::vector<const IData *> &v ) override
-    { Q_UNUSED( v ) }
+    //! Adds the vertex at \a index of the vertices
+    void insert( int index )
+    {
+      const QgsPointXY &vertex = mVertices.at( index );
+      mCells[ qMakePair( cell( vertex.x() ), cell( vertex.y() ) ) ].append( index );
+    }
 
   private:
-    QVector< int > &mPoints;
-};
+    qint64 cell( double coordinate ) const
+    {
+      return static_cast< qint64 >( std::floor( coordinate / mTolerance ) );
+    }
 
-///@endcond
+    const QVector< QgsPointXY > &mVertices;
+    double mTolerance = 0;
+    QHash< QPair< qint64, qint64 >, QVector< int > > mCells;
+};
 
-std::unique_ptr< SpatialIndex::ISpatialIndex > createVertexSpatialIndex( SpatialIndex::IStorageManager &storageManager )
+//! A segment of a network line, between two graph vertices
+struct QgsNetworkSegment
 {
-  // R-Tree parameters
-  double fillFactor = 0.7;
-  unsigned long indexCapacity = 10;
-  unsigned long leafCapacity = 10;
-  unsigned long dimension = 2;
-  RTree::RTreeVariant variant = RTree::RV_RSTAR;
-
-  // create R-tree
-  SpatialIndex::id_type indexId;
-  std::unique_ptr< SpatialIndex::ISpatialIndex > iRTree( RTree::createNewRTree( storageManager, fillFactor, indexCapacity,
-      leafCapacity, dimension, variant, indexId ) );
-  return iRTree;
-}
+  int fromVertex;
+  int toVertex;
+};
 
-int findClosestVertex( const QgsPointXY &point, SpatialIndex::ISpatialIndex *index, double tolerance )
+//! A network feature, with the graph vertices of each of its lines
+struct QgsNetworkFeature
 {
-  QVector< int > matching;
-  QgsNetworkVisitor visitor( matching );
-
-  double pt1[2] = { point.x() - tolerance, point.y() - tolerance },
-                  pt2[2] = { point.x() + tolerance, point.y() + tolerance };
-  SpatialIndex::Region searchRegion( pt1, pt2, 2 );
-
-  index->intersectsWithQuery( searchRegion, visitor );
+  QgsFeature feature;
+  QVector< QVector< int > > lines;
+};
 
-  return matching.empty() ? -1 : matching.at( 0 );
-}
+///@endcond
 
 void QgsVectorLayerDirector::makeGraph( QgsGraphBuilderInterface *builder, const QVector< QgsPointXY > &additionalPoints,
                                         QVector< QgsPointXY > &snappedPoints, QgsFeedback *feedback ) const
@@ -187,23 +200,28 @@ void QgsVectorLayerDirector::makeGraph( QgsGraphBuilderInterface *builder, const
   // graph's vertices = all vertices in graph, with vertices within builder's tolerance collapsed together
   QVector< QgsPointXY > graphVertices;
 
-  // spatial index for graph vertices
-  std::unique_ptr< SpatialIndex::IStorageManager > iStorage( StorageManager::createNewMemoryStorageManager() );
-  std::unique_ptr< SpatialIndex::ISpatialIndex > iRTree = createVertexSpatialIndex( *iStorage );
-
   double tolerance = std::max( builder->topologyTolerance(), 1e-10 );
-  auto findPointWithinTolerance = [&iRTree, tolerance]( const QgsPointXY & point )->int
-  {
-    return findClosestVertex( point, iRTree.get(), tolerance );
-  };
-  auto addPointToIndex = [&iRTree]( const QgsPointXY & point, int index )
+  QgsNetworkVertexGrid vertexGrid( graphVertices, tolerance );
+  auto addVertex = [&graphVertices, &vertexGrid]( const QgsPointXY & point )->int
   {
-    double coords[] = {point.x(), point.y()};
-    iRTree->insertData( 0, nullptr, SpatialIndex::Point( coords, 2 ), index );
+    int index = vertexGrid.find( point );
+    if ( index == -1 )
+    {
+      // no vertex already exists within tolerance - add to points, and grid
+      index = graphVertices.count();
+      graphVertices.push_back( point );
+      vertexGrid.insert( index );
+    }
+    return index;
   };
 
-  // first iteration - get all nodes from network, and snap additional points to network
-  QgsFeatureIterator fit = mSource->getFeatures( QgsFeatureRequest().setNoAttributes() );
+  // single pass over the network - collapse the line vertices into graph vertices, keeping the features
+  // and their segments for the tie points and the graph construction
+  QVector< QgsNetworkFeature > networkFeatures;
+  QVector< QgsNetworkSegment > segments;
+  QVector< QgsFeatureId > segmentIds;
+  QVector< QgsRectangle > segmentBounds;
+  QgsFeatureIterator fit = mSource->getFeatures( QgsFeatureRequest().setSubsetOfAttributes( requiredAttributes() ) );
   QgsFeature feature;
   while ( fit.nextFeature( feature ) )
   {
@@ -216,99 +234,114 @@ void QgsVectorLayerDirector::makeGraph( QgsGraphBuilderInterface *builder, const
     else if ( QgsWkbTypes::flatType( feature.geometry().wkbType() ) == QgsWkbTypes::LineString )
       mpl.push_back( feature.geometry().asPolyline() );
 
+    QgsNetworkFeature networkFeature;
+    networkFeature.lines.reserve( mpl.size() );
     for ( const QgsPolylineXY &line : qgis::as_const( mpl ) )
     {
-      QgsPointXY pt1, pt2;
-      bool isFirstPoint = true;
+      QVector< int > lineVertices;
+      lineVertices.reserve( line.size() );
       for ( const QgsPointXY &point : line )
       {
-        pt2 = ct.transform( point );
-
-        int pt2Idx = findPointWithinTolerance( pt2 ) ;
-        if ( pt2Idx == -1 )
-        {
-          // no vertex already exists within tolerance - add to points, and index
-          addPointToIndex( pt2, graphVertices.count() );
-          graphVertices.push_back( pt2 );
-        }
-        else
+        const int vertex = addVertex( ct.transform( point ) );
+        if ( !lineVertices.isEmpty() )
         {
-          // vertex already exists within tolerance - use that
-          pt2 = graphVertices.at( pt2Idx );
+          const QgsPointXY &pt1 = graphVertices.at( lineVertices.last() );
+          const QgsPointXY &pt2 = graphVertices.at( vertex );
+          segments.push_back( { lineVertices.last(), vertex } );
+          segmentIds.push_back( segments.size() - 1 );
+          segmentBounds.push_back( QgsRectangle( pt1, pt2 ) );
         }
+        lineVertices.push_back( vertex );
+      }
+      networkFeature.lines.push_back( lineVertices );
+    }
 
-        if ( !isFirstPoint )
-        {
-          // check if this line segment is a candidate for being closest to each additional point
-          int i = 0;
-          for ( const QgsPointXY &additionalPoint : additionalPoints )
-          {
+    feature.clearGeometry();
+    networkFeature.feature = feature;
+    networkFeatures.push_back( networkFeature );
 
-            QgsPointXY snappedPoint;
-            double thisSegmentClosestDist = std::numeric_limits<double>::max();
-            if ( pt1 == pt2 )
-            {
-              thisSegmentClosestDist = additionalPoint.sqrDist( pt1 );
-              snappedPoint = pt1;
-            }
-            else
-            {
-              thisSegmentClosestDist = additionalPoint.sqrDistToSegment( pt1.x(), pt1.y(),
-                                       pt2.x(), pt2.y(), snappedPoint, 0 );
-            }
+    if ( feedback )
+      feedback->setProgress( 100.0 * static_cast< double >( ++step ) / featureCount );
+  }
 
-            if ( thisSegmentClosestDist < additionalTiePoints[ i ].mLength )
-            {
-              // found a closer segment for this additional point
-              TiePointInfo info( i, feature.id(), pt1, pt2 );
-              info.mLength = thisSegmentClosestDist;
-              info.mTiedPoint = snappedPoint;
+  // snap the additional points to their closest segment, in parallel, through an index of the segments
+  if ( !segments.isEmpty() && !additionalPoints.isEmpty() )
+  {
+    const QgsSpatialIndexPackedRTree segmentIndex( segmentIds, segmentBounds );
+    QVector< int > pointIndices( additionalPoints.size() );
+    std::iota( pointIndices.begin(), pointIndices.end(), 0 );
+    // each point only writes its own tie point, through raw pointers to avoid detaching the vectors from several threads
+    TiePointInfo *tiePoints = additionalTiePoints.data();
+    QgsPointXY *snapped = snappedPoints.data();
+    QtConcurrent::blockingMap( pointIndices, [&]( int i )
+    {
+      const QgsPointXY &additionalPoint = additionalPoints.at( i );
+      // the nearest segments by bounding box are checked until none of the others can be closer
+      for ( int neighbors = 16; ; neighbors *= 4 )
+      {
+        const QList< QgsFeatureId > candidates = segmentIndex.nearestNeighbor( additionalPoint, neighbors );
+        for ( QgsFeatureId candidate : candidates )
+        {
+          const int segment = static_cast< int >( candidate );
+          const QgsPointXY &pt1 = graphVertices.at( segments.at( segment ).fromVertex );
+          const QgsPointXY &pt2 = graphVertices.at( segments.at( segment ).toVertex );
+          QgsPointXY snappedPoint;
+          double thisSegmentClosestDist = std::numeric_limits<double>::max();
+          if ( pt1 == pt2 )
+          {
+            thisSegmentClosestDist = additionalPoint.sqrDist( pt1 );
+            snappedPoint = pt1;
+          }
+          else
+          {
+            thisSegmentClosestDist = additionalPoint.sqrDistToSegment( pt1.x(), pt1.y(),
+                                     pt2.x(), pt2.y(), snappedPoint, 0 );
+          }
 
-              additionalTiePoints[ i ] = info;
-              snappedPoints[ i ] = info.mTiedPoint;
-            }
-            i++;
+          // on equal distances, the first segment of the network wins
+          TiePointInfo &info = tiePoints[ i ];
+          if ( thisSegmentClosestDist < info.mLength || ( thisSegmentClosestDist == info.mLength && segment < info.mSegment ) )
+          {
+            // found a closer segment for this additional point
+            info.mLength = thisSegmentClosestDist;
+            info.mTiedPoint = snappedPoint;
+            info.mSegment = segment;
+            snapped[ i ] = snappedPoint;
           }
         }
-        pt1 = pt2;
-        isFirstPoint = false;
+
+        if ( candidates.size() < neighbors )
+          break;
+
+        const QgsRectangle &lastBounds = segmentBounds.at( static_cast< int >( candidates.last() ) );
+        const double dx = std::max( { lastBounds.xMinimum() - additionalPoint.x(), 0.0, additionalPoint.x() - lastBounds.xMaximum() } );
+        const double dy = std::max( { lastBounds.yMinimum() - additionalPoint.y(), 0.0, additionalPoint.y() - lastBounds.yMaximum() } );
+        if ( tiePoints[ i ].mLength < dx * dx + dy * dy )
+          break;
       }
-    }
-    if ( feedback )
-      feedback->setProgress( 100.0 * static_cast< double >( ++step ) / featureCount );
+    } );
   }
 
-  // build a hash of feature ids to tie points which depend on this feature
-  QHash< QgsFeatureId, QList< int > > tiePointNetworkFeatures;
-  int i = 0;
-  for ( TiePointInfo &info : additionalTiePoints )
+  // build a hash of segments to tie points which depend on this segment
+  QHash< int, QList< int > > tiePointSegments;
+  for ( int i = 0; i < additionalTiePoints.size(); ++i )
   {
-    tiePointNetworkFeatures[ info.mNetworkFeatureId ] << i;
-    i++;
+    if ( additionalTiePoints.at( i ).mSegment != -1 )
+      tiePointSegments[ additionalTiePoints.at( i ).mSegment ] << i;
   }
 
   // add tied point to graph
+  QVector< int > tiePointVertices( snappedPoints.size() );
   for ( int i = 0; i < snappedPoints.size(); ++i )
   {
-    // check index to see if vertex exists within tolerance of tie point
-    const QgsPointXY point = snappedPoints.at( i );
-    int ptIdx = findPointWithinTolerance( point );
-    if ( ptIdx == -1 )
-    {
-      // no vertex already within tolerance, add to index and network vertices
-      addPointToIndex( point, graphVertices.count() );
-      graphVertices.push_back( point );
-    }
-    else
-    {
-      // otherwise snap tie point to vertex
-      snappedPoints[ i ] = graphVertices.at( ptIdx );
-    }
+    // snap tie point to a vertex within tolerance if there is one, otherwise add it to the network vertices
+    tiePointVertices[ i ] = addVertex( snappedPoints.at( i ) );
+    snappedPoints[ i ] = graphVertices.at( tiePointVertices.at( i ) );
   }
   // also need to update tie points - they need to be matched for snapped points
   for ( int i = 0; i < additionalTiePoints.count(); ++i )
   {
-    additionalTiePoints[ i ].mTiedPoint = snappedPoints.at( additionalTiePoints.at( i ).additionalPointId );
+    additionalTiePoints[ i ].mTiedPoint = snappedPoints.at( i );
   }
 
 
@@ -324,90 +357,71 @@ void QgsVectorLayerDirector::makeGraph( QgsGraphBuilderInterface *builder, const
     }
   }
 
-  fit = mSource->getFeatures( QgsFeatureRequest().setSubsetOfAttributes( requiredAttributes() ) );
-  while ( fit.nextFeature( feature ) )
+  int segment = 0;
+  for ( const QgsNetworkFeature &networkFeature : qgis::as_const( networkFeatures ) )
   {
     if ( feedback && feedback->isCanceled() )
       return;
 
-    Direction direction = directionForFeature( feature );
+    Direction direction = directionForFeature( networkFeature.feature );
 
     // begin features segments and add arc to the Graph;
-    QgsMultiPolylineXY mpl;
-    if ( QgsWkbTypes::flatType( feature.geometry().wkbType() ) == QgsWkbTypes::MultiLineString )
-      mpl = feature.geometry().asMultiPolyline();
-    else if ( QgsWkbTypes::flatType( feature.geometry().wkbType() ) == QgsWkbTypes::LineString )
-      mpl.push_back( feature.geometry().asPolyline() );
-
-    for ( const QgsPolylineXY &line : qgis::as_const( mpl ) )
+    for ( const QVector< int > &line : networkFeature.lines )
     {
-      QgsPointXY pt1, pt2;
-
-      bool isFirstPoint = true;
-      for ( const QgsPointXY &point : line )
+      for ( int lineVertex = 1; lineVertex < line.size(); ++lineVertex, ++segment )
       {
-        pt2 = ct.transform( point );
-        int pPt2idx = findPointWithinTolerance( pt2 );
-        Q_ASSERT_X( pPt2idx >= 0, "QgsVectorLayerDirectory::makeGraph", "encountered a vertex which was not present in graph" );
-        pt2 = graphVertices.at( pPt2idx );
+        const int segmentPt1idx = line.at( lineVertex - 1 );
+        const int segmentPt2idx = line.at( lineVertex );
+        const QgsPointXY &pt1 = graphVertices.at( segmentPt1idx );
+        const QgsPointXY &pt2 = graphVertices.at( segmentPt2idx );
+
+        // vertices along the segment, by their squared distance to its start
+        QMap< double, int > pointsOnArc;
+        pointsOnArc[ 0.0 ] = segmentPt1idx;
+        pointsOnArc[ pt1.sqrDist( pt2 )] = segmentPt2idx;
+
+        const QList< int > tiePointsForCurrentSegment = tiePointSegments.value( segment );
+        for ( int tiePointIdx : tiePointsForCurrentSegment )
+        {
+          const TiePointInfo &t = additionalTiePoints.at( tiePointIdx );
+          pointsOnArc[ pt1.sqrDist( t.mTiedPoint )] = tiePointVertices.at( tiePointIdx );
+        }
 
-        if ( !isFirstPoint )
+        QgsPointXY arcPt1;
+        QgsPointXY arcPt2;
+        int pt1idx = -1;
+        int pt2idx = -1;
+        bool isFirstPoint = true;
+        for ( auto arcPointIt = pointsOnArc.constBegin(); arcPointIt != pointsOnArc.constEnd(); ++arcPointIt )
         {
-          QMap< double, QgsPointXY > pointsOnArc;
-          pointsOnArc[ 0.0 ] = pt1;
-          pointsOnArc[ pt1.sqrDist( pt2 )] = pt2;
+          pt2idx = arcPointIt.value();
+          arcPt2 = graphVertices.at( pt2idx );
 
-          const QList< int > tiePointsForCurrentFeature = tiePointNetworkFeatures.value( feature.id() );
-          for ( int tiePointIdx : tiePointsForCurrentFeature )
+          if ( !isFirstPoint && arcPt1 != arcPt2 )
           {
-            const TiePointInfo &t = additionalTiePoints.at( tiePointIdx );
-            if ( t.mFirstPoint == pt1 && t.mLastPoint == pt2 )
+            double distance = builder->distanceArea()->measureLine( arcPt1, arcPt2 );
+            QVector< QVariant > prop;
+            prop.reserve( mStrategies.size() );
+            for ( QgsNetworkStrategy *strategy : mStrategies )
             {
-              pointsOnArc[ pt1.sqrDist( t.mTiedPoint )] = t.mTiedPoint;
+              prop.push_back( strategy->cost( distance, networkFeature.feature ) );
             }
-          }
 
-          QgsPointXY arcPt1;
-          QgsPointXY arcPt2;
-          int pt1idx = -1;
-          int pt2idx = -1;
-          bool isFirstPoint = true;
-          for ( auto arcPointIt = pointsOnArc.constBegin(); arcPointIt != pointsOnArc.constEnd(); ++arcPointIt )
-          {
-            arcPt2 = arcPointIt.value();
-
-            pt2idx = findPointWithinTolerance( arcPt2 );
-            Q_ASSERT_X( pt2idx >= 0, "QgsVectorLayerDirectory::makeGraph", "encountered a vertex which was not present in graph" );
-            arcPt2 = graphVertices.at( pt2idx );
-
-            if ( !isFirstPoint && arcPt1 != arcPt2 )
+            if ( direction == Direction::DirectionForward ||
+                 direction == Direction::DirectionBoth )
+            {
+              builder->addEdge( pt1idx, arcPt1, pt2idx, arcPt2, prop );
+            }
+            if ( direction == Direction::DirectionBackward ||
+                 direction == Direction::DirectionBoth )
             {
-              double distance = builder->distanceArea()->measureLine( arcPt1, arcPt2 );
-              QVector< QVariant > prop;
-              prop.reserve( mStrategies.size() );
-              for ( QgsNetworkStrategy *strategy : mStrategies )
-              {
-                prop.push_back( strategy->cost( distance, feature ) );
-              }
-
-              if ( direction == Direction::DirectionForward ||
-                   direction == Direction::DirectionBoth )
-              {
-                builder->addEdge( pt1idx, arcPt1, pt2idx, arcPt2, prop );
-              }
-              if ( direction == Direction::DirectionBackward ||
-                   direction == Direction::DirectionBoth )
-              {
-                builder->addEdge( pt2idx, arcPt2, pt1idx, arcPt1, prop );
-              }
+              builder->addEdge( pt2idx, arcPt2, pt1idx, arcPt1, prop );
             }
-            pt1idx = pt2idx;
-            arcPt1 = arcPt2;
-            isFirstPoint = false;
           }
+          pt1idx = pt2idx;
+          arcPt1 = arcPt2;
+          isFirstPoint = false;
         }
-        pt1 = pt2;
-        isFirstPoint = false;
       }
     }
     if ( feedback )
@@ -17,6 +17,10 @@
 
 #include "qgsalgorithmdbscanclustering.h"
 #include "qgsspatialindexkdbush.h"
+
+#include <QtConcurrent>
+
+#include <algorithm>
 #include <unordered_set>
 
 ///@cond PRIVATE
@@ -193,65 +197,130 @@ void QgsDbscanClusteringAlgorithm::dbscan( const std::size_t minSize,
 {
   const double step = featureCount > 0 ? 90.0 / featureCount : 1;
 
+  // points of the features, in the order of the features
+  struct ScanPoint
+  {
+    QgsFeatureId id;
+    QgsPointXY point;
+    bool isPoint;
+  };
+  std::vector< ScanPoint > points;
+  points.reserve( index.size() );
+
+  QgsFeature feat;
+  while ( features.nextFeature( feat ) )
+  {
+    if ( feedback->isCanceled() )
+    {
+      return;
+    }
+
+    if ( !feat.hasGeometry() )
+    {
+      points.push_back( { feat.id(), QgsPointXY(), false } );
+    }
+    else if ( QgsWkbTypes::flatType( feat.geometry().wkbType() ) == QgsWkbTypes::Point )
+    {
+      points.push_back( { feat.id(), QgsPointXY( *qgsgeometry_cast< const QgsPoint * >( feat.geometry().constGet() ) ), true } );
+    }
+    else
+    {
+      // not a point geometry
+      feedback->reportError( QObject::tr( "Feature %1 is a %2 feature, not a point." ).arg( feat.id() ).arg( QgsWkbTypes::displayString( feat.geometry().wkbType() ) ) );
+      points.push_back( { feat.id(), QgsPointXY(), false } );
+    }
+  }
+
+  // the core points, with at least minSize points in their neighbourhood, are found in parallel
+  // so that the scan below only queries the neighbourhood of the points it expands
+  std::unordered_set< QgsFeatureId > corePoints;
+  if ( minSize > 1 )
+  {
+    std::vector< char > isCore( points.size(), false );
+    const std::size_t chunkSize = 1000;
+    std::vector< std::size_t > chunks;
+    for ( std::size_t first = 0; first < points.size(); first += chunkSize )
+      chunks.push_back( first );
+    QtConcurrent::blockingMap( chunks, [&]( std::size_t first )
+    {
+      const std::size_t last = std::min( first + chunkSize, points.size() );
+      for ( std::size_t p = first; p < last && !feedback->isCanceled(); ++p )
+      {
+        if ( !points[p].isPoint )
+          continue;
+
+        std::size_t neighbours = 0;
+        index.within( points[p].point, eps, [&neighbours]( const QgsSpatialIndexKDBushData & )
+        {
+          neighbours++;
+        } );
+        isCore[p] = neighbours >= minSize;
+      }
+    } );
+    if ( feedback->isCanceled() )
+      return;
+
+    for ( std::size_t p = 0; p < points.size(); ++p )
+    {
+      if ( isCore[p] )
+        corePoints.insert( points[p].id );
+    }
+  }
+  const auto isCorePoint = [minSize, &corePoints]( QgsFeatureId id )
+  {
+    return minSize <= 1 || corePoints.find( id ) != corePoints.end();
+  };
+
   std::unordered_set< QgsFeatureId > visited;
   visited.reserve( index.size() );
 
-  QgsFeature feat;
   int i = 0;
   int clusterCount = 0;
 
-  while ( features.nextFeature( feat ) )
+  for ( const ScanPoint &scanPoint : points )
   {
     if ( feedback->isCanceled() )
     {
       break;
     }
 
-    if ( !feat.hasGeometry() )
+    if ( !scanPoint.isPoint )
     {
       feedback->setProgress( ++i * step );
       continue;
     }
 
-    if ( visited.find( feat.id() ) != visited.end() )
+    if ( visited.find( scanPoint.id ) != visited.end() )
     {
       // already visited!
       continue;
     }
 
-    QgsPointXY point;
-    if ( QgsWkbTypes::flatType( feat.geometry().wkbType() ) == QgsWkbTypes::Point )
-      point = QgsPointXY( *qgsgeometry_cast< const QgsPoint * >( feat.geometry().constGet() ) );
-    else
-    {
-      // not a point geometry
-      feedback->reportError( QObject::tr( "Feature %1 is a %2 feature, not a point." ).arg( feat.id() ).arg( QgsWkbTypes::displayString( feat.geometry().wkbType() ) ) );
-      feedback->setProgress( ++i * step );
-      continue;
-    }
+    const QgsPointXY &point = scanPoint.point;
 
     std::unordered_set< QgsSpatialIndexKDBushData, KDBushDataHashById, KDBushDataEqualById> within;
 
     if ( minSize > 1 )
     {
+      if ( !isCorePoint( scanPoint.id ) )
+        continue;
+
       index.within( point, eps, [ &within]( const QgsSpatialIndexKDBushData & data )
       {
         within.insert( data );
       } );
-      if ( within.size() < minSize )
-        continue;
 
-      visited.insert( feat.id() );
+      visited.insert( scanPoint.id );
     }
     else
     {
       // optimised case for minSize == 1, we can skip the initial check
-      within.insert( QgsSpatialIndexKDBushData( feat.id(), point.x(), point.y() ) );
+      within.insert( QgsSpatialIndexKDBushData( scanPoint.id, point.x(), point.y() ) );
     }
 
     // start new cluster
     clusterCount++;
-    idToCluster[ feat.id() ] = clusterCount;
+    idToCluster[ scanPoint.id ] = clusterCount;
     feedback->setProgress( ++i * step );
 
     while ( !within.empty() )
@@ -273,16 +342,18 @@ void QgsDbscanClusteringAlgorithm::dbscan( const std::size_t minSize,
       visited.insert( j.id );
       feedback->setProgress( ++i * step );
 
-      // check from this point
-      QgsPointXY point2 = j.point();
-
-      std::unordered_set< QgsSpatialIndexKDBushData, KDBushDataHashById, KDBushDataEqualById > within2;
-      index.within( point2, eps, [&within2]( const QgsSpatialIndexKDBushData & data )
-      {
-        within2.insert( data );
-      } );
-      if ( within2.size() >= minSize )
+      // check from this point, only the neighbourhood of core points is expanded
+      const bool isCore = isCorePoint( j.id );
+      if ( isCore )
       {
+        QgsPointXY point2 = j.point();
+
+        std::unordered_set< QgsSpatialIndexKDBushData, KDBushDataHashById, KDBushDataEqualById > within2;
+        index.within( point2, eps, [&within2]( const QgsSpatialIndexKDBushData & data )
+        {
+          within2.insert( data );
+        } );
+
         // expand neighbourhood
         std::copy_if( within2.begin(),
                       within2.end(),
@@ -292,7 +363,7 @@ void QgsDbscanClusteringAlgorithm::dbscan( const std::size_t minSize,
           return visited.find( needle.id ) == visited.end();
         } );
       }
-      if ( !borderPointsAreNoise || within2.size() >= minSize )
+      if ( !borderPointsAreNoise || isCore )
       {
         idToCluster[ j.id ] = clusterCount;
       }
@@ -16,6 +16,14 @@
  ***************************************************************************/
 
 #include "qgsalgorithmdissolve.h"
+#include "qgsprocessingfeedback.h"
+
+#include <QMutex>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+#include <memory>
 
 ///@cond PRIVATE
 
@@ -23,8 +31,184 @@
 // QgsCollectorAlgorithm
 //
 
+quint32 QgsCollectorAlgorithm::hilbertIndex( quint32 x, quint32 y )
+{
+  quint32 index = 0;
+  for ( quint32 s = 1 << 15; s > 0; s >>= 1 )
+  {
+    const quint32 rx = ( x & s ) > 0 ? 1 : 0;
+    const quint32 ry = ( y & s ) > 0 ? 1 : 0;
+    index += s * s * ( ( 3 * rx ) ^ ry );
+    // rotate the quadrant so that the curve is continuous
+    if ( ry == 0 )
+    {
+      if ( rx == 1 )
+      {
+        x = 0xFFFF - x;
+        y = 0xFFFF - y;
+      }
+      std::swap( x, y );
+    }
+  }
+  return index;
+}
+
+void QgsCollectorAlgorithm::sortSpatially( QVector< QgsGeometry > &geometries )
+{
+  QVector< QgsPointXY > centers;
+  centers.reserve( geometries.size() );
+  QgsRectangle extent;
+  extent.setMinimal();
+  for ( const QgsGeometry &geometry : qgis::as_const( geometries ) )
+  {
+    const QgsRectangle box = geometry.boundingBox();
+    centers << box.center();
+    extent.combineExtentWith( box );
+  }
+
+  const double xScale = extent.width() > 0 ? 0xFFFF / extent.width() : 0;
+  const double yScale = extent.height() > 0 ? 0xFFFF / extent.height() : 0;
+  std::vector< std::pair< quint32, int > > keys;
+  keys.reserve( geometries.size() );
+  for ( int i = 0; i < centers.size(); ++i )
+  {
+    const quint32 x = static_cast< quint32 >( qBound( 0.0, ( centers.at( i ).x() - extent.xMinimum() ) * xScale, 65535.0 ) );
+    const quint32 y = static_cast< quint32 >( qBound( 0.0, ( centers.at( i ).y() - extent.yMinimum() ) * yScale, 65535.0 ) );
+    keys.emplace_back( hilbertIndex( x, y ), i );
+  }
+  std::sort( keys.begin(), keys.end() );
+
+  QVector< QgsGeometry > sorted;
+  sorted.reserve( geometries.size() );
+  for ( const std::pair< quint32, int > &key : keys )
+    sorted << geometries.at( key.second );
+  geometries = sorted;
+}
+
+QVector< QgsGeometry > QgsCollectorAlgorithm::cascadedCollect( const QVector< QVector< QgsGeometry > > &groups, const Collector &collector, int maxQueueLength, QgsProcessingFeedback *feedback )
+{
+  QVector< QgsGeometry > results( groups.size() );
+  if ( maxQueueLength <= 0 )
+  {
+    for ( int i = 0; i < groups.size() && !feedback->isCanceled(); ++i )
+      results[ i ] = collector( groups.at( i ), feedback );
+    return results;
+  }
+
+  // each thread collects with its own feedback, taken from the free workers
+  struct Job
+  {
+    int group;
+    QVector< QgsGeometry > parts;
+    QgsGeometry result;
+  };
+
+  const int threadCount = std::max( 1, QThreadPool::globalInstance()->maxThreadCount() );
+  // the calling thread also runs jobs
+  std::vector< std::unique_ptr< QgsProcessingRecordingFeedback > > workers;
+  QList< QgsProcessingRecordingFeedback * > freeWorkers;
+  for ( int i = 0; i <= threadCount; ++i )
+  {
+    workers.emplace_back( qgis::make_unique< QgsProcessingRecordingFeedback >() );
+    QObject::connect( feedback, &QgsFeedback::canceled, workers.back().get(), &QgsFeedback::cancel, Qt::DirectConnection );
+    freeWorkers << workers.back().get();
+  }
+
+  QMutex mutex;
+  QString error;
+  auto runJob = [&]( Job & job )
+  {
+    QgsProcessingRecordingFeedback *worker = nullptr;
+    {
+      QMutexLocker locker( &mutex );
+      worker = freeWorkers.takeLast();
+    }
+
+    if ( !feedback->isCanceled() )
+    {
+      try
+      {
+        job.result = collector( job.parts, worker );
+      }
+      catch ( QgsException &e )
+      {
+        // rethrown from the calling thread, once the jobs being run are done
+        QMutexLocker locker( &mutex );
+        if ( error.isEmpty() )
+          error = e.what();
+      }
+    }
+    job.parts.clear();
+
+    QMutexLocker locker( &mutex );
+    freeWorkers << worker;
+  };
+
+  // groups longer than the queue are split in blocks of neighboring geometries, which are cheaper to
+  // union than arbitrary ones, and whose unions are then merged pairwise with their neighbors
+  std::vector< Job > jobs;
+  for ( int i = 0; i < groups.size(); ++i )
+  {
+    const QVector< QgsGeometry > &group = groups.at( i );
+    if ( group.size() <= maxQueueLength )
+    {
+      jobs.push_back( { i, group, QgsGeometry() } );
+      continue;
+    }
+
+    QVector< QgsGeometry > sorted = group;
+    sortSpatially( sorted );
+    const int blockCount = ( sorted.size() + maxQueueLength - 1 ) / maxQueueLength;
+    for ( int block = 0; block < blockCount; ++block )
+    {
+      const int begin = static_cast< int >( static_cast< qint64 >( sorted.size() ) * block / blockCount );
+      const int end = static_cast< int >( static_cast< qint64 >( sorted.size() ) * ( block + 1 ) / blockCount );
+      jobs.push_back( { i, sorted.mid( begin, end - begin ), QgsGeometry() } );
+    }
+  }
+
+  while ( !jobs.empty() )
+  {
+    QtConcurrent::blockingMap( jobs, runJob );
+
+    for ( const std::unique_ptr< QgsProcessingRecordingFeedback > &worker : workers )
+      worker->replay( feedback );
+
+    if ( !error.isEmpty() )
+      throw QgsProcessingException( error );
+
+    // the jobs of a group are consecutive, and in the order of the spatial sort
+    std::vector< Job > merges;
+    std::size_t begin = 0;
+    while ( begin < jobs.size() )
+    {
+      std::size_t end = begin + 1;
+      while ( end < jobs.size() && jobs[ end ].group == jobs[ begin ].group )
+        ++end;
+
+      if ( end - begin == 1 || feedback->isCanceled() )
+      {
+        results[ jobs[ begin ].group ] = jobs[ begin ].result;
+      }
+      else
+      {
+        for ( std::size_t i = begin; i < end; i += 2 )
+        {
+          Job merge { jobs[ i ].group, QVector< QgsGeometry >() << jobs[ i ].result, QgsGeometry() };
+          if ( i + 1 < end )
+            merge.parts << jobs[ i + 1 ].result;
+          merges.push_back( merge );
+        }
+      }
+      begin = end;
+    }
+    jobs.swap( merges );
+  }
+  return results;
+}
+
 QVariantMap QgsCollectorAlgorithm::processCollection( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback,
-    const std::function<QgsGeometry( const QVector< QgsGeometry >& )> &collector, int maxQueueLength, QgsProcessingFeatureSource::Flags sourceFlags )
+    const Collector &collector, int maxQueueLength, QgsProcessingFeatureSource::Flags sourceFlags )
 {
   std::unique_ptr< QgsProcessingFeatureSource > source( parameterAsSource( parameters, QStringLiteral( "INPUT" ), context ) );
   if ( !source )
@@ -50,8 +234,11 @@ QVariantMap QgsCollectorAlgorithm::processCollection( const QVariantMap &paramet
   {
     // dissolve all - not using fields
     bool firstFeature = true;
-    // we dissolve geometries in blocks using unaryUnion
+    // we dissolve geometries in batches of a block per thread, whose unions are then merged like
+    // the digits of a binary counter, so that only a few partial results are kept
+    const int batchLength = maxQueueLength * std::max( 1, QThreadPool::globalInstance()->maxThreadCount() );
     QVector< QgsGeometry > geomQueue;
+    QVector< QgsGeometry > partialResults;
     QgsFeature outputFeature;
 
     while ( it.nextFeature( f ) )
@@ -70,12 +257,21 @@ QVariantMap QgsCollectorAlgorithm::processCollection( const QVariantMap &paramet
       if ( f.hasGeometry() && !f.geometry().isNull() )
       {
         geomQueue.append( f.geometry() );
-        if ( maxQueueLength > 0 && geomQueue.length() > maxQueueLength )
+        if ( maxQueueLength > 0 && geomQueue.length() > batchLength )
         {
           // queue too long, combine it
-          QgsGeometry tempOutputGeometry = collector( geomQueue );
+          QgsGeometry partialResult = cascadedCollect( QVector< QVector< QgsGeometry > >() << geomQueue, collector, maxQueueLength, feedback ).value( 0 );
           geomQueue.clear();
-          geomQueue << tempOutputGeometry;
+          int level = 0;
+          for ( ; level < partialResults.size() && !partialResults.at( level ).isNull(); ++level )
+          {
+            partialResult = collector( QVector< QgsGeometry >() << partialResults.at( level ) << partialResult, feedback );
+            partialResults[ level ] = QgsGeometry();
+          }
+          if ( level == partialResults.size() )
+            partialResults << partialResult;
+          else
+            partialResults[ level ] = partialResult;
         }
       }
 
@@ -83,7 +279,12 @@ QVariantMap QgsCollectorAlgorithm::processCollection( const QVariantMap &paramet
       current++;
     }
 
-    outputFeature.setGeometry( collector( geomQueue ) );
+    for ( const QgsGeometry &partialResult : qgis::as_const( partialResults ) )
+    {
+      if ( !partialResult.isNull() )
+        geomQueue << partialResult;
+    }
+    outputFeature.setGeometry( cascadedCollect( QVector< QVector< QgsGeometry > >() << geomQueue, collector, maxQueueLength, feedback ).value( 0 ) );
     sink->addFeature( outputFeature, QgsFeatureSink::FastInsert );
   }
   else
@@ -126,9 +327,24 @@ QVariantMap QgsCollectorAlgorithm::processCollection( const QVariantMap &paramet
       }
     }
 
-    int numberFeatures = attributeHash.count();
+    // all the groups are collected at once, in parallel
+    QVector< QVector< QgsGeometry > > groups;
+    QHash< QVariant, int > groupIndexes;
     QHash< QVariant, QgsAttributes >::const_iterator attrIt = attributeHash.constBegin();
     for ( ; attrIt != attributeHash.constEnd(); ++attrIt )
+    {
+      if ( geometryHash.contains( attrIt.key() ) )
+      {
+        groupIndexes.insert( attrIt.key(), groups.size() );
+        groups << geometryHash.take( attrIt.key() );
+      }
+    }
+    const QVector< QgsGeometry > collected = feedback->isCanceled() ? QVector< QgsGeometry >() : cascadedCollect( groups, collector, maxQueueLength, feedback );
+    groups.clear();
+
+    int numberFeatures = attributeHash.count();
+    attrIt = attributeHash.constBegin();
+    for ( ; attrIt != attributeHash.constEnd(); ++attrIt )
     {
       if ( feedback->isCanceled() )
       {
@@ -136,9 +352,9 @@ QVariantMap QgsCollectorAlgorithm::processCollection( const QVariantMap &paramet
       }
 
       QgsFeature outputFeature;
-      if ( geometryHash.contains( attrIt.key() ) )
+      if ( groupIndexes.contains( attrIt.key() ) )
       {
-        QgsGeometry geom = collector( geometryHash.value( attrIt.key() ) );
+        QgsGeometry geom = collected.at( groupIndexes.value( attrIt.key() ) );
         if ( !geom.isMultipart() )
         {
           geom.convertToMultiType();
@@ -214,7 +430,7 @@ QgsDissolveAlgorithm *QgsDissolveAlgorithm::createInstance() const
 
 QVariantMap QgsDissolveAlgorithm::processAlgorithm( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback )
 {
-  return processCollection( parameters, context, feedback, [ & ]( const QVector< QgsGeometry > &parts )->QgsGeometry
+  return processCollection( parameters, context, feedback, []( const QVector< QgsGeometry > &parts, QgsProcessingFeedback * collectFeedback )->QgsGeometry
   {
     QgsGeometry result( QgsGeometry::unaryUnion( parts ) );
     if ( QgsWkbTypes::geometryType( result.wkbType() ) == QgsWkbTypes::LineGeometry )
@@ -223,23 +439,23 @@ QVariantMap QgsDissolveAlgorithm::processAlgorithm( const QVariantMap &parameter
     // See: https://github.com/qgis/QGIS/issues/28411 - Dissolve tool failing to produce outputs
     if ( ! result.lastError().isEmpty() && parts.count() >  2 )
     {
-      if ( feedback->isCanceled() )
+      if ( collectFeedback->isCanceled() )
         return result;
 
-      feedback->pushDebugInfo( QObject::tr( "GEOS exception: taking the slower route ..." ) );
+      collectFeedback->pushDebugInfo( QObject::tr( "GEOS exception: taking the slower route ..." ) );
       result = QgsGeometry();
       for ( const auto &p : parts )
       {
         result = QgsGeometry::unaryUnion( QVector< QgsGeometry >() << result << p );
         if ( QgsWkbTypes::geometryType( result.wkbType() ) == QgsWkbTypes::LineGeometry )
           result = result.mergeLines();
-        if ( feedback->isCanceled() )
+        if ( collectFeedback->isCanceled() )
           return result;
       }
     }
     if ( ! result.lastError().isEmpty() )
     {
-      feedback->reportError( result.lastError(), true );
+      collectFeedback->reportError( result.lastError(), true );
       if ( result.isEmpty() )
         throw QgsProcessingException( QObject::tr( "The algorithm returned no output." ) );
     }
@@ -278,7 +494,7 @@ QString QgsCollectAlgorithm::groupId() const
 
 QVariantMap QgsCollectAlgorithm::processAlgorithm( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback )
 {
-  return processCollection( parameters, context, feedback, []( const QVector< QgsGeometry > &parts )->QgsGeometry
+  return processCollection( parameters, context, feedback, []( const QVector< QgsGeometry > &parts, QgsProcessingFeedback * )->QgsGeometry
   {
     return QgsGeometry::collectGeometry( parts );
   }, 0, QgsProcessingFeatureSource::FlagSkipGeometryValidityChecks );
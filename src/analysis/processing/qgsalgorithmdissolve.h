@@ -33,8 +33,37 @@ class QgsCollectorAlgorithm : public QgsProcessingAlgorithm
 {
   protected:
 
+    /**
+     * Combines geometries into a single one, reporting to the feedback it is given. The collector
+     * is called from several threads at once, each with its own feedback.
+     */
+    typedef std::function<QgsGeometry( const QVector<QgsGeometry> &, QgsProcessingFeedback * )> Collector;
+
+    /**
+     * Combines the features of the INPUT source with \a collector, all of them or by the values of the FIELD fields.
+     *
+     * If \a maxQueueLength is positive, the geometries are combined by spatially sorted blocks of up to
+     * \a maxQueueLength geometries, the partial results being then combined pairwise, in parallel across the
+     * groups and the blocks. When all the features are combined, the geometries are queued in batches of
+     * a block per thread, to bound the memory used.
+     */
     QVariantMap processCollection( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback,
-                                   const std::function<QgsGeometry( const QVector<QgsGeometry>& )> &collector, int maxQueueLength = 0, QgsProcessingFeatureSource::Flags sourceFlags = nullptr );
+                                   const Collector &collector, int maxQueueLength = 0, QgsProcessingFeatureSource::Flags sourceFlags = nullptr );
+
+  private:
+
+    /**
+     * Combines each of the \a groups of geometries into a single geometry with \a collector, by spatially
+     * sorted blocks of up to \a maxQueueLength geometries if positive, then pairwise, running the
+     * blocks and pairs of all the groups in parallel.
+     */
+    static QVector< QgsGeometry > cascadedCollect( const QVector< QVector< QgsGeometry > > &groups, const Collector &collector, int maxQueueLength, QgsProcessingFeedback *feedback );
+
+    //! Sorts \a geometries by the Hilbert curve index of the center of their bounding box
+    static void sortSpatially( QVector< QgsGeometry > &geometries );
+
+    //! Returns the index along a Hilbert curve filling a 65536 by 65536 grid of the cell \a x, \a y
+    static quint32 hilbertIndex( quint32 x, quint32 y );
 };
 
 /**
@@ -22,6 +22,14 @@
 #include "qgsapplication.h"
 #include "qgsfeature.h"
 #include "qgsfeaturesource.h"
+#include "qgsspatialindexcache.h"
+#include "qgsspatialindexpackedrtree.h"
+
+#include <QMutex>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
+#include <unordered_map>
 
 ///@cond PRIVATE
 
@@ -126,6 +134,17 @@ QVariantMap QgsJoinByLocationAlgorithm::processAlgorithm( const QVariantMap &par
   if ( !mJoinSource )
     throw QgsProcessingException( invalidSourceError( parameters, QStringLiteral( "JOIN" ) ) );
 
+  // without a native index, the location queries on the join layer scan all its features,
+  // unless an index was stored for the layer by the "Create spatial index" algorithm
+  mJoinCachedIndex.reset();
+  if ( mJoinSource->hasSpatialIndex() != QgsFeatureSource::SpatialIndexPresent && mJoinSource->sourceCrs() == mBaseSource->sourceCrs() )
+  {
+    QgsVectorLayer *joinLayer = parameterAsVectorLayer( parameters, QStringLiteral( "JOIN" ), context );
+    QgsSpatialIndexPackedRTree index( QVector< QgsFeatureId >(), QVector< QgsRectangle >() );
+    if ( joinLayer && QgsSpatialIndexCache::loadIndex( joinLayer, index ) )
+      mJoinCachedIndex = qgis::make_unique< QgsSpatialIndexPackedRTree >( index );
+  }
+
   mJoinMethod = static_cast< JoinMethod >( parameterAsEnum( parameters, QStringLiteral( "METHOD" ), context ) );
 
   const QStringList joinedFieldNames = parameterAsFields( parameters, QStringLiteral( "JOIN_FIELDS" ), context );
@@ -192,19 +211,19 @@ QVariantMap QgsJoinByLocationAlgorithm::processAlgorithm( const QVariantMap &par
       }
       else
       {
-        // default -- iterate over the join source and match back to the base source. We do this on the assumption that the most common
-        // use case is joining a points layer to a polygon layer (taking polygon attributes and adding them to the points), so by iterating
-        // over the polygons we can take advantage of prepared geometries for the spatial relationship test.
-
-        // TODO - consider using more heuristics to determine whether it's always best to iterate over the join
-        // source.
-        processAlgorithmByIteratingOverJoinedSource( context, feedback );
+        // default -- index the join source in memory and stream the base source. We do this on the assumption that the most common
+        // use case is joining a points layer to a polygon layer (taking polygon attributes and adding them to the points), so by caching
+        // prepared geometries of the polygons we can take advantage of them for the spatial relationship test of many points.
+        processAlgorithmInBulk( context, feedback );
       }
       break;
     }
 
     case JoinToLargestOverlap:
-      processAlgorithmByIteratingOverInputSource( context, feedback );
+      if ( mJoinSource->featureCount() > 0 && mBaseSource->featureCount() > 0 && mJoinSource->featureCount() <= mBaseSource->featureCount() )
+        processAlgorithmInBulk( context, feedback );
+      else
+        processAlgorithmByIteratingOverInputSource( context, feedback );
       break;
   }
 
@@ -310,65 +329,247 @@ bool QgsJoinByLocationAlgorithm::featureFilter( const QgsFeature &feature, QgsGe
   return ok;
 }
 
-void QgsJoinByLocationAlgorithm::processAlgorithmByIteratingOverJoinedSource( QgsProcessingContext &context, QgsProcessingFeedback *feedback )
+void QgsJoinByLocationAlgorithm::processAlgorithmInBulk( QgsProcessingContext &context, QgsProcessingFeedback *feedback )
 {
-  if ( mBaseSource->hasSpatialIndex() == QgsFeatureSource::SpatialIndexNotPresent )
-    feedback->reportError( QObject::tr( "No spatial index exists for input layer, performance will be severely degraded" ) );
-
+  // the join features are read once and bulk loaded in a packed R-tree
+  QHash< QgsFeatureId, QgsFeature > joinFeatures;
+  QVector< QgsFeatureId > joinIds;
+  QVector< QgsRectangle > joinBoxes;
   QgsFeatureIterator joinIter = mJoinSource->getFeatures( QgsFeatureRequest().setDestinationCrs( mBaseSource->sourceCrs(), context.transformContext() ).setSubsetOfAttributes( mJoinedFieldIndices ) );
-  QgsFeature f;
-
-  // Create output vector layer with additional attributes
-  const double step = mJoinSource->featureCount() > 0 ? 100.0 / mJoinSource->featureCount() : 1;
-  long i = 0;
-  while ( joinIter.nextFeature( f ) )
+  QgsFeature joinFeature;
+  while ( joinIter.nextFeature( joinFeature ) )
   {
     if ( feedback->isCanceled() )
-      break;
+      return;
 
-    processFeatureFromJoinSource( f, feedback );
+    if ( joinFeature.hasGeometry() )
+    {
+      joinFeatures.insert( joinFeature.id(), joinFeature );
+      joinIds << joinFeature.id();
+      joinBoxes << joinFeature.geometry().boundingBox();
+    }
+  }
+  const QgsSpatialIndexPackedRTree index( joinIds, joinBoxes );
+  joinIds.clear();
+  joinBoxes.clear();
 
-    i++;
-    feedback->setProgress( i * step );
+  // prepared geometries are not safe to share between threads, so each thread caches its own ones
+  struct Worker
+  {
+    std::unordered_map< QgsFeatureId, std::unique_ptr< QgsGeometryEngine > > engines;
+  };
+
+  struct Item
+  {
+    QgsFeature feature;
+    QList< QgsFeatureId > candidates;
+    QList< QgsFeatureId > matches;
+  };
+
+  struct Chunk
+  {
+    std::size_t begin;
+    std::size_t end;
+  };
+
+  const int threadCount = std::max( 1, QThreadPool::globalInstance()->maxThreadCount() );
+  // the calling thread also matches chunks
+  std::vector< std::unique_ptr< Worker > > workers;
+  QList< Worker * > freeWorkers;
+  for ( int i = 0; i <= threadCount; ++i )
+  {
+    workers.emplace_back( qgis::make_unique< Worker >() );
+    freeWorkers << workers.back().get();
   }
 
-  if ( !mDiscardNonMatching || mUnjoinedFeatures )
+  QMutex mutex;
+  std::vector< Item > items;
+
+  auto matchChunk = [&]( const Chunk & chunk )
   {
-    QgsFeatureIds unjoinedIds = mBaseSource->allFeatureIds();
-    unjoinedIds.subtract( mAddedIds );
+    Worker *worker = nullptr;
+    {
+      QMutexLocker locker( &mutex );
+      worker = freeWorkers.takeLast();
+    }
+
+    for ( std::size_t i = chunk.begin; i < chunk.end && !feedback->isCanceled(); ++i )
+    {
+      Item &item = items[ i ];
+      double largestOverlap = std::numeric_limits< double >::lowest();
+      for ( QgsFeatureId id : qgis::as_const( item.candidates ) )
+      {
+        const auto joinFeature = joinFeatures.constFind( id );
+        if ( joinFeature == joinFeatures.constEnd() )
+          continue;
+
+        auto engineIt = worker->engines.find( id );
+        if ( engineIt == worker->engines.end() )
+        {
+          if ( worker->engines.size() >= BULK_ENGINE_CACHE_SIZE )
+            worker->engines.clear();
 
-    QgsFeature f2;
-    QgsFeatureRequest remainings = QgsFeatureRequest().setFilterFids( unjoinedIds );
-    QgsFeatureIterator remainIter = mBaseSource->getFeatures( remainings );
+          std::unique_ptr< QgsGeometryEngine > engine( QgsGeometry::createGeometryEngine( joinFeature->geometry().constGet() ) );
+          engine->prepareGeometry();
+          engineIt = worker->engines.emplace( id, std::move( engine ) ).first;
+        }
+        QgsGeometryEngine *engine = engineIt->second.get();
 
-    QgsAttributes emptyAttributes;
-    emptyAttributes.reserve( mJoinedFieldIndices.count() );
-    for ( int i = 0; i < mJoinedFieldIndices.count(); ++i )
-      emptyAttributes << QVariant();
+        if ( !featureFilter( item.feature, engine, false ) )
+          continue;
+
+        switch ( mJoinMethod )
+        {
+          case OneToMany:
+          case JoinToFirst:
+            item.matches << id;
+            break;
+
+          case JoinToLargestOverlap:
+          {
+            // calculate area of overlap
+            std::unique_ptr< QgsAbstractGeometry > intersection( engine->intersection( item.feature.geometry().constGet() ) );
+            double overlap = 0;
+            switch ( intersection ? QgsWkbTypes::geometryType( intersection->wkbType() ) : QgsWkbTypes::UnknownGeometry )
+            {
+              case QgsWkbTypes::LineGeometry:
+                overlap = intersection->length();
+                break;
+
+              case QgsWkbTypes::PolygonGeometry:
+                overlap = intersection->area();
+                break;
+
+              case QgsWkbTypes::UnknownGeometry:
+              case QgsWkbTypes::PointGeometry:
+              case QgsWkbTypes::NullGeometry:
+                break;
+            }
 
-    while ( remainIter.nextFeature( f2 ) )
+            if ( overlap > largestOverlap )
+            {
+              largestOverlap = overlap;
+              item.matches = QList< QgsFeatureId >() << id;
+            }
+            break;
+          }
+        }
+
+        if ( mJoinMethod == JoinToFirst )
+          break;
+      }
+    }
+
+    QMutexLocker locker( &mutex );
+    freeWorkers << worker;
+  };
+
+  QgsAttributes emptyAttributes;
+  emptyAttributes.reserve( mJoinedFieldIndices.count() );
+  for ( int i = 0; i < mJoinedFieldIndices.count(); ++i )
+    emptyAttributes << QVariant();
+
+  const std::size_t chunkSize = BULK_FEATURES_PER_THREAD / 4;
+  const std::size_t batchSize = static_cast< std::size_t >( BULK_FEATURES_PER_THREAD ) * threadCount;
+  const double step = mBaseSource->featureCount() > 0 ? 100.0 / mBaseSource->featureCount() : 1;
+  long current = 0;
+  QgsFeatureIterator it = mBaseSource->getFeatures();
+  QgsFeature f;
+  std::vector< Chunk > chunks;
+  bool finished = false;
+  while ( !finished && !feedback->isCanceled() )
+  {
+    // the base features are read and the index is queried from the calling thread
+    items.clear();
+    while ( items.size() < batchSize )
     {
-      if ( feedback->isCanceled() )
+      if ( !it.nextFeature( f ) )
+      {
+        finished = true;
         break;
+      }
+
+      Item item { f, QList< QgsFeatureId >(), QList< QgsFeatureId >() };
+      items.push_back( item );
+    }
 
-      if ( mJoinedFeatures && !mDiscardNonMatching )
+    // the index is queried for the whole batch, in parallel
+    QVector< QgsRectangle > boxes;
+    std::vector< Item * > queried;
+    for ( Item &item : items )
+    {
+      if ( item.feature.hasGeometry() )
       {
-        QgsAttributes attributes = f2.attributes();
-        attributes.append( emptyAttributes );
-        QgsFeature outputFeature( f2 );
-        outputFeature.setAttributes( attributes );
-        mJoinedFeatures->addFeature( outputFeature, QgsFeatureSink::FastInsert );
+        boxes << item.feature.geometry().boundingBox();
+        queried.push_back( &item );
       }
+    }
+    const QVector< QList< QgsFeatureId > > candidates = index.intersects( boxes );
+    for ( std::size_t i = 0; i < queried.size(); ++i )
+    {
+      queried[ i ]->candidates = candidates.at( static_cast< int >( i ) );
+      std::sort( queried[ i ]->candidates.begin(), queried[ i ]->candidates.end() );
+    }
+
+    chunks.clear();
+    for ( std::size_t begin = 0; begin < items.size(); begin += chunkSize )
+      chunks.push_back( { begin, std::min( begin + chunkSize, items.size() ) } );
+    QtConcurrent::blockingMap( chunks, matchChunk );
 
-      if ( mUnjoinedFeatures )
-        mUnjoinedFeatures->addFeature( f2, QgsFeatureSink::FastInsert );
+    if ( feedback->isCanceled() )
+      break;
+
+    for ( const Item &item : items )
+    {
+      if ( item.matches.isEmpty() )
+      {
+        // didn't find a match...
+        if ( mJoinedFeatures && !mDiscardNonMatching )
+        {
+          QgsAttributes attributes = item.feature.attributes();
+          attributes.append( emptyAttributes );
+          QgsFeature outputFeature( item.feature );
+          outputFeature.setAttributes( attributes );
+          mJoinedFeatures->addFeature( outputFeature, QgsFeatureSink::FastInsert );
+        }
+
+        if ( mUnjoinedFeatures )
+        {
+          QgsFeature unjoinedFeature( item.feature );
+          mUnjoinedFeatures->addFeature( unjoinedFeature, QgsFeatureSink::FastInsert );
+        }
+        continue;
+      }
+
+      if ( mJoinedFeatures )
+      {
+        for ( QgsFeatureId id : item.matches )
+        {
+          const QgsFeature joinFeature = joinFeatures.value( id );
+          QgsAttributes joinAttributes = item.feature.attributes();
+          joinAttributes.reserve( joinAttributes.size() + mJoinedFieldIndices.size() );
+          for ( int ix : qgis::as_const( mJoinedFieldIndices ) )
+          {
+            joinAttributes.append( joinFeature.attribute( ix ) );
+          }
+
+          QgsFeature outputFeature( item.feature );
+          outputFeature.setAttributes( joinAttributes );
+          mJoinedFeatures->addFeature( outputFeature, QgsFeatureSink::FastInsert );
+        }
+      }
+      // one-to-many joins count each pair of joined features
+      mJoinedCount += mJoinMethod == OneToMany ? item.matches.count() : 1;
     }
+
+    current += static_cast< long >( items.size() );
+    feedback->setProgress( current * step );
   }
 }
 
 void QgsJoinByLocationAlgorithm::processAlgorithmByIteratingOverInputSource( QgsProcessingContext &context, QgsProcessingFeedback *feedback )
 {
-  if ( mJoinSource->hasSpatialIndex() == QgsFeatureSource::SpatialIndexNotPresent )
+  if ( mJoinSource->hasSpatialIndex() == QgsFeatureSource::SpatialIndexNotPresent && !mJoinCachedIndex )
     feedback->reportError( QObject::tr( "No spatial index exists for join layer, performance will be severely degraded" ) );
 
   QgsFeatureIterator it = mBaseSource->getFeatures();
@@ -414,69 +615,6 @@ void QgsJoinByLocationAlgorithm::sortPredicates( QList<int> &predicates )
   } );
 }
 
-bool QgsJoinByLocationAlgorithm::processFeatureFromJoinSource( QgsFeature &joinFeature, QgsProcessingFeedback *feedback )
-{
-  if ( !joinFeature.hasGeometry() )
-    return false;
-
-  const QgsGeometry featGeom = joinFeature.geometry();
-  std::unique_ptr< QgsGeometryEngine > engine;
-  QgsFeatureRequest req = QgsFeatureRequest().setFilterRect( featGeom.boundingBox() );
-  QgsFeatureIterator it = mBaseSource->getFeatures( req );
-  QList<QgsFeature> filtered;
-  QgsFeature baseFeature;
-  bool ok = false;
-  QgsAttributes joinAttributes;
-
-  while ( it.nextFeature( baseFeature ) )
-  {
-    if ( feedback->isCanceled() )
-      break;
-
-    switch ( mJoinMethod )
-    {
-      case JoinToFirst:
-        if ( mAddedIds.contains( baseFeature.id() ) )
-        {
-          //  already added this feature, and user has opted to only output first match
-          continue;
-        }
-        break;
-
-      case OneToMany:
-        break;
-
-      case JoinToLargestOverlap:
-        Q_ASSERT_X( false, "QgsJoinByLocationAlgorithm::processFeatureFromJoinSource", "processFeatureFromJoinSource should not be used with join to largest overlap method" );
-    }
-
-    if ( !engine )
-    {
-      engine.reset( QgsGeometry::createGeometryEngine( featGeom.constGet() ) );
-      engine->prepareGeometry();
-      for ( int ix : qgis::as_const( mJoinedFieldIndices ) )
-      {
-        joinAttributes.append( joinFeature.attribute( ix ) );
-      }
-    }
-    if ( featureFilter( baseFeature, engine.get(), false ) )
-    {
-      if ( mJoinedFeatures )
-      {
-        QgsFeature outputFeature( baseFeature );
-        outputFeature.setAttributes( baseFeature.attributes() + joinAttributes );
-        mJoinedFeatures->addFeature( outputFeature, QgsFeatureSink::FastInsert );
-      }
-      if ( !ok )
-        ok = true;
-
-      mAddedIds.insert( baseFeature.id() );
-      mJoinedCount++;
-    }
-  }
-  return ok;
-}
-
 bool QgsJoinByLocationAlgorithm::processFeatureFromInputSource( QgsFeature &baseFeature, QgsProcessingContext &context, QgsProcessingFeedback *feedback )
 {
   if ( !baseFeature.hasGeometry() )
@@ -504,7 +642,11 @@ bool QgsJoinByLocationAlgorithm::processFeatureFromInputSource( QgsFeature &base
 
   const QgsGeometry featGeom = baseFeature.geometry();
   std::unique_ptr< QgsGeometryEngine > engine;
-  QgsFeatureRequest req = QgsFeatureRequest().setDestinationCrs( mBaseSource->sourceCrs(), context.transformContext() ).setFilterRect( featGeom.boundingBox() ).setSubsetOfAttributes( mJoinedFieldIndices );
+  QgsFeatureRequest req = QgsFeatureRequest().setDestinationCrs( mBaseSource->sourceCrs(), context.transformContext() ).setSubsetOfAttributes( mJoinedFieldIndices );
+  if ( mJoinCachedIndex )
+    req.setFilterFids( qgis::listToSet( mJoinCachedIndex->intersects( featGeom.boundingBox() ) ) );
+  else
+    req.setFilterRect( featGeom.boundingBox() );
 
   QgsFeatureIterator it = mJoinSource->getFeatures( req );
   QList<QgsFeature> filtered;
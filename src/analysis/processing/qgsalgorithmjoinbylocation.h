@@ -23,7 +23,7 @@
 #include "qgis.h"
 #include "qgsprocessingalgorithm.h"
 #include "qgsfeature.h"
-
+#include "qgsspatialindexpackedrtree.h"
 
 ///@cond PRIVATE
 
@@ -50,13 +50,17 @@ class QgsJoinByLocationAlgorithm : public QgsProcessingAlgorithm
 
   protected:
     QVariantMap processAlgorithm( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback ) override;
-    bool processFeatureFromJoinSource( QgsFeature &joinFeature, QgsProcessingFeedback *feedback );
     bool processFeatureFromInputSource( QgsFeature &inputFeature, QgsProcessingContext &context, QgsProcessingFeedback *feedback );
     bool featureFilter( const QgsFeature &feature, QgsGeometryEngine *engine, bool comparingToJoinedFeature ) const;
 
   private:
 
-    void processAlgorithmByIteratingOverJoinedSource( QgsProcessingContext &context, QgsProcessingFeedback *feedback );
+    /**
+     * Joins the features of the base source in bulk: the join features are held in memory in a packed STR tree,
+     * and the base features are matched by batches in parallel, each thread caching the prepared geometries
+     * of the join features.
+     */
+    void processAlgorithmInBulk( QgsProcessingContext &context, QgsProcessingFeedback *feedback );
     void processAlgorithmByIteratingOverInputSource( QgsProcessingContext &context, QgsProcessingFeedback *feedback );
 
     enum JoinMethod
@@ -68,14 +72,21 @@ class QgsJoinByLocationAlgorithm : public QgsProcessingAlgorithm
     long mJoinedCount = 0;
     std::unique_ptr< QgsProcessingFeatureSource > mBaseSource;
     std::unique_ptr< QgsProcessingFeatureSource > mJoinSource;
+    //! Cached spatial index of the join layer, when its provider has no native index
+    std::unique_ptr< QgsSpatialIndexPackedRTree > mJoinCachedIndex;
     QgsAttributeList mJoinedFieldIndices;
     bool mDiscardNonMatching = false;
     std::unique_ptr< QgsFeatureSink > mJoinedFeatures;
-    QgsFeatureIds mAddedIds;
     std::unique_ptr< QgsFeatureSink > mUnjoinedFeatures;
     JoinMethod mJoinMethod = OneToMany;
     QList<int> mPredicates;
 
+    //! Number of base features matched in parallel by each thread, between two progress reports
+    static const int BULK_FEATURES_PER_THREAD = 1024;
+
+    //! Maximum number of prepared join geometries cached by each thread
+    static const int BULK_ENGINE_CACHE_SIZE = 10000;
+
     static void sortPredicates( QList<int > &predicates );
 };
 
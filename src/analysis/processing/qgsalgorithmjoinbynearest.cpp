@@ -19,8 +19,13 @@
 #include "qgsprocessingoutputs.h"
 #include "qgslinestring.h"
 
+#include <QtConcurrent>
+
 ///@cond PRIVATE
 
+// number of input features searched in parallel at once
+static const int CHUNK_SIZE = 1000;
+
 QString QgsJoinByNearestAlgorithm::name() const
 {
   return QStringLiteral( "joinbynearest" );
@@ -215,8 +220,6 @@ QVariantMap QgsJoinByNearestAlgorithm::processAlgorithm( const QVariantMap &para
     return true;
   }, QgsSpatialIndex::FlagStoreFeatureGeometries );
 
-  QgsFeature f;
-
   // create extra null attributes for non-matched records (the +2 is for the "n" and "distance", and start/end x/y fields)
   QgsAttributes nullMatch;
   nullMatch.reserve( fields2Indices.size() + 6 );
@@ -226,59 +229,55 @@ QVariantMap QgsJoinByNearestAlgorithm::processAlgorithm( const QVariantMap &para
   long long joinedCount = 0;
   long long unjoinedCount = 0;
 
-  // Create output vector layer with additional attributes
-  step = input->featureCount() > 0 ? 50.0 / input->featureCount() : 1;
-  QgsFeatureIterator features = input->getFeatures();
-  i = 0;
-  while ( features.nextFeature( f ) )
+  // the nearest features of a chunk of input features are searched in parallel, and the output
+  // features are then written in the order of the input features
+  struct NearestMatches
   {
-    i++;
-    if ( feedback->isCanceled() )
-    {
-      break;
-    }
-
-    feedback->setProgress( 50 + i * step );
+    int nearestCount = 0;
+    QgsFeatureList joinedFeatures;
+  };
 
+  const int neighborsToFind = neighbors + ( sameSourceAndTarget ? 1 : 0 );
+  const auto findNearest = [&]( const QgsFeature & f ) -> NearestMatches
+  {
+    NearestMatches matches;
     if ( !f.hasGeometry() )
+      return matches;
+
+    // note - if using same source as target, we have to get one extra neighbor, since the first match will be the input feature
+    const QList< QgsFeatureId > nearest = index.nearestNeighbor( f.geometry(), neighborsToFind, std::isnan( maxDistance ) ? 0 : maxDistance );
+    matches.nearestCount = nearest.count();
+
+    const QgsPoint *point = QgsWkbTypes::flatType( f.geometry().wkbType() ) == QgsWkbTypes::Point ? qgsgeometry_cast< const QgsPoint * >( f.geometry().constGet() ) : nullptr;
+    int j = 0;
+    for ( QgsFeatureId id : nearest )
     {
-      unjoinedCount++;
-      if ( sinkNonMatching1 )
-      {
-        sinkNonMatching1->addFeature( f, QgsFeatureSink::FastInsert );
-      }
-      if ( sink && !discardNonMatching )
-      {
-        QgsAttributes attr = f.attributes();
-        attr.append( nullMatch );
-        f.setAttributes( attr );
-        sink->addFeature( f, QgsFeatureSink::FastInsert );
-      }
-    }
-    else
-    {
-      // note - if using same source as target, we have to get one extra neighbor, since the first match will be the input feature
-      const QList< QgsFeatureId > nearest = index.nearestNeighbor( f.geometry(), neighbors + ( sameSourceAndTarget ? 1 : 0 ), std::isnan( maxDistance ) ? 0 : maxDistance );
+      if ( sameSourceAndTarget && id == f.id() )
+        continue; // don't match to same feature if using a single input table
+      j++;
 
-      if ( nearest.count() > neighbors + ( sameSourceAndTarget ? 1 : 0 ) )
-      {
-        feedback->pushInfo( QObject::tr( "Multiple matching features found at same distance from search feature, found %1 features instead of %2" ).arg( nearest.count() - ( sameSourceAndTarget ? 1 : 0 ) ).arg( neighbors ) );
-      }
       QgsFeature out;
-      out.setGeometry( f.geometry() );
-      int j = 0;
-      for ( QgsFeatureId id : nearest )
+      if ( sink )
       {
-        if ( sameSourceAndTarget && id == f.id() )
-          continue; // don't match to same feature if using a single input table
-        j++;
-        if ( sink )
-        {
-          QgsAttributes attr = f.attributes();
-          attr.append( input2AttributeCache.value( id ) );
-          attr.append( j );
+        out.setGeometry( f.geometry() );
+        QgsAttributes attr = f.attributes();
+        attr.append( input2AttributeCache.value( id ) );
+        attr.append( j );
 
-          const QgsGeometry closestLine = f.geometry().shortestLine( index.geometry( id ) );
+        const QgsGeometry nearestGeometry = index.geometry( id );
+        const QgsPoint *nearestPoint = point && QgsWkbTypes::flatType( nearestGeometry.wkbType() ) == QgsWkbTypes::Point ? qgsgeometry_cast< const QgsPoint * >( nearestGeometry.constGet() ) : nullptr;
+        if ( nearestPoint && !point->isEmpty() && !nearestPoint->isEmpty() )
+        {
+          // the shortest line between two points joins them
+          attr.append( point->distance( nearestPoint->x(), nearestPoint->y() ) );
+          attr.append( point->x() );
+          attr.append( point->y() );
+          attr.append( nearestPoint->x() );
+          attr.append( nearestPoint->y() );
+        }
+        else
+        {
+          const QgsGeometry closestLine = f.geometry().shortestLine( nearestGeometry );
           if ( const QgsLineString *line = qgsgeometry_cast< const QgsLineString *>( closestLine.constGet() ) )
           {
             attr.append( line->length() );
@@ -295,12 +294,54 @@ QVariantMap QgsJoinByNearestAlgorithm::processAlgorithm( const QVariantMap &para
             attr.append( QVariant() ); //end x
             attr.append( QVariant() ); //end y
           }
-          out.setAttributes( attr );
-          sink->addFeature( out, QgsFeatureSink::FastInsert );
         }
+        out.setAttributes( attr );
       }
-      if ( j > 0 )
+      matches.joinedFeatures << out;
+    }
+    return matches;
+  };
+
+  QgsFeatureList chunk;
+  const auto processChunk = [&]
+  {
+    const QVector< NearestMatches > chunkMatches = QtConcurrent::blockingMapped< QVector< NearestMatches > >( chunk, findNearest );
+    for ( int k = 0; k < chunk.size(); ++k )
+    {
+      QgsFeature &f = chunk[ k ];
+      const NearestMatches &matches = chunkMatches.at( k );
+
+      if ( !f.hasGeometry() )
+      {
+        unjoinedCount++;
+        if ( sinkNonMatching1 )
+        {
+          sinkNonMatching1->addFeature( f, QgsFeatureSink::FastInsert );
+        }
+        if ( sink && !discardNonMatching )
+        {
+          QgsAttributes attr = f.attributes();
+          attr.append( nullMatch );
+          f.setAttributes( attr );
+          sink->addFeature( f, QgsFeatureSink::FastInsert );
+        }
+        continue;
+      }
+
+      if ( matches.nearestCount > neighborsToFind )
+      {
+        feedback->pushInfo( QObject::tr( "Multiple matching features found at same distance from search feature, found %1 features instead of %2" ).arg( matches.nearestCount - ( sameSourceAndTarget ? 1 : 0 ) ).arg( neighbors ) );
+      }
+
+      if ( !matches.joinedFeatures.isEmpty() )
+      {
         joinedCount++;
+        if ( sink )
+        {
+          QgsFeatureList joinedFeatures = matches.joinedFeatures;
+          sink->addFeatures( joinedFeatures, QgsFeatureSink::FastInsert );
+        }
+      }
       else
       {
         if ( sinkNonMatching1 )
@@ -317,7 +358,30 @@ QVariantMap QgsJoinByNearestAlgorithm::processAlgorithm( const QVariantMap &para
         unjoinedCount++;
       }
     }
+    chunk.clear();
+  };
+
+  // Create output vector layer with additional attributes
+  step = input->featureCount() > 0 ? 50.0 / input->featureCount() : 1;
+  QgsFeatureIterator features = input->getFeatures();
+  QgsFeature f;
+  i = 0;
+  while ( features.nextFeature( f ) )
+  {
+    i++;
+    if ( feedback->isCanceled() )
+    {
+      break;
+    }
+
+    feedback->setProgress( 50 + i * step );
+
+    chunk << f;
+    if ( chunk.size() >= CHUNK_SIZE )
+      processChunk();
   }
+  if ( !feedback->isCanceled() )
+    processChunk();
 
   QVariantMap outputs;
   outputs.insert( QStringLiteral( "JOINED_COUNT" ), joinedCount );
@@ -16,6 +16,11 @@
  ***************************************************************************/
 
 #include "qgsalgorithmkmeansclustering.h"
+
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <atomic>
 #include <unordered_map>
 
 ///@cond PRIVATE
@@ -331,33 +336,62 @@ void QgsKMeansClusteringAlgorithm::calculateKMeans( std::vector<QgsKMeansCluster
 void QgsKMeansClusteringAlgorithm::findNearest( std::vector<QgsKMeansClusteringAlgorithm::Feature> &points, const std::vector<QgsPointXY> &centers, const int k, bool &changed )
 {
   changed = false;
-  std::size_t n = points.size();
-  for ( std::size_t i = 0; i < n; i++ )
+  const std::size_t n = points.size();
+
+  // the points are assigned to their nearest cluster in parallel, by chunks
+  const std::size_t chunkSize = 10000;
+  std::vector< std::size_t > chunks;
+  for ( std::size_t first = 0; first < n; first += chunkSize )
+    chunks.push_back( first );
+
+  // plain arrays of the center coordinates, which the compiler can vectorize the distance loop over
+  std::vector< double > centerX( k );
+  std::vector< double > centerY( k );
+  for ( int cluster = 0; cluster < k; cluster++ )
   {
-    Feature &point = points[i];
-
-    // Initialize with distance to first cluster
-    double currentDistance = point.point.sqrDist( centers[0] );
-    int currentCluster = 0;
+    centerX[ cluster ] = centers[ cluster ].x();
+    centerY[ cluster ] = centers[ cluster ].y();
+  }
 
-    // Check all other cluster centers and find the nearest
-    for ( int cluster = 1; cluster < k; cluster++ )
+  std::atomic< bool > anyChanged( false );
+  QtConcurrent::blockingMap( chunks, [&]( std::size_t first )
+  {
+    bool chunkChanged = false;
+    const std::size_t last = std::min( first + chunkSize, n );
+    for ( std::size_t i = first; i < last; i++ )
     {
-      const double distance = point.point.sqrDist( centers[cluster] );
-      if ( distance < currentDistance )
+      Feature &point = points[i];
+      const double x = point.point.x();
+      const double y = point.point.y();
+
+      // Initialize with distance to first cluster
+      double currentDistance = ( x - centerX[0] ) * ( x - centerX[0] ) + ( y - centerY[0] ) * ( y - centerY[0] );
+      int currentCluster = 0;
+
+      // Check all other cluster centers and find the nearest
+      for ( int cluster = 1; cluster < k; cluster++ )
       {
-        currentDistance = distance;
-        currentCluster = cluster;
+        const double dx = x - centerX[ cluster ];
+        const double dy = y - centerY[ cluster ];
+        const double distance = dx * dx + dy * dy;
+        if ( distance < currentDistance )
+        {
+          currentDistance = distance;
+          currentCluster = cluster;
+        }
       }
-    }
 
-    // Store the nearest cluster this object is in
-    if ( point.cluster != currentCluster )
-    {
-      changed = true;
-      point.cluster = currentCluster;
+      // Store the nearest cluster this object is in
+      if ( point.cluster != currentCluster )
+      {
+        chunkChanged = true;
+        point.cluster = currentCluster;
+      }
     }
-  }
+    if ( chunkChanged )
+      anyChanged = true;
+  } );
+  changed = anyChanged;
 }
 
 // ported from https://github.com/postgis/postgis/blob/svn-trunk/liblwgeom/lwkmeans.c
@@ -23,6 +23,11 @@
 
 ///@cond PRIVATE
 
+QgsProcessingAlgorithm::Flags QgsPointsInPolygonAlgorithm::flags() const
+{
+  return QgsProcessingFeatureBasedAlgorithm::flags() | FlagSupportsParallelFeatureProcessing;
+}
+
 void QgsPointsInPolygonAlgorithm::initParameters( const QVariantMap & )
 {
   addParameter( new QgsProcessingParameterFeatureSource( QStringLiteral( "POINTS" ),
@@ -108,8 +113,7 @@ QgsProcessing::SourceType QgsPointsInPolygonAlgorithm::outputLayerType() const
 
 QgsCoordinateReferenceSystem QgsPointsInPolygonAlgorithm::outputCrs( const QgsCoordinateReferenceSystem &inputCrs ) const
 {
-  mCrs = inputCrs;
-  return mCrs;
+  return inputCrs;
 }
 
 QString QgsPointsInPolygonAlgorithm::inputParameterName() const
@@ -132,13 +136,16 @@ bool QgsPointsInPolygonAlgorithm::prepareAlgorithm( const QVariantMap &parameter
   mFieldName = parameterAsString( parameters, QStringLiteral( "FIELD" ), context );
   mWeightFieldName = parameterAsString( parameters, QStringLiteral( "WEIGHT" ), context );
   mClassFieldName = parameterAsString( parameters, QStringLiteral( "CLASSFIELD" ), context );
-  mPointSource.reset( parameterAsSource( parameters, QStringLiteral( "POINTS" ), context ) );
-  if ( !mPointSource )
+  std::unique_ptr< QgsProcessingFeatureSource > pointSource( parameterAsSource( parameters, QStringLiteral( "POINTS" ), context ) );
+  if ( !pointSource )
     throw QgsProcessingException( invalidSourceError( parameters, QStringLiteral( "POINTS" ) ) );
+  std::unique_ptr< QgsProcessingFeatureSource > polygonSource( parameterAsSource( parameters, inputParameterName(), context ) );
+  if ( !polygonSource )
+    throw QgsProcessingException( invalidSourceError( parameters, inputParameterName() ) );
 
   if ( !mWeightFieldName.isEmpty() )
   {
-    mWeightFieldIndex = mPointSource->fields().lookupField( mWeightFieldName );
+    mWeightFieldIndex = pointSource->fields().lookupField( mWeightFieldName );
     if ( mWeightFieldIndex == -1 )
       throw QgsProcessingException( QObject::tr( "Could not find field %1" ).arg( mWeightFieldName ) );
     mPointAttributes.append( mWeightFieldIndex );
@@ -146,19 +153,43 @@ bool QgsPointsInPolygonAlgorithm::prepareAlgorithm( const QVariantMap &parameter
 
   if ( !mClassFieldName.isEmpty() )
   {
-    mClassFieldIndex = mPointSource->fields().lookupField( mClassFieldName );
+    mClassFieldIndex = pointSource->fields().lookupField( mClassFieldName );
     if ( mClassFieldIndex == -1 )
       throw QgsProcessingException( QObject::tr( "Could not find field %1" ).arg( mClassFieldIndex ) );
     mPointAttributes.append( mClassFieldIndex );
   }
 
-  if ( mPointSource->hasSpatialIndex() == QgsFeatureSource::SpatialIndexNotPresent )
-    feedback->reportError( QObject::tr( "No spatial index exists for points layer, performance will be severely degraded" ) );
+  // the points are read once, instead of once per polygon, with the weight or class of each one
+  const QgsFeatureRequest request = QgsFeatureRequest().setDestinationCrs( polygonSource->sourceCrs(), context.transformContext() );
+  const int valueFieldIndex = mWeightFieldIndex >= 0 ? mWeightFieldIndex : mClassFieldIndex;
+  QgsFeatureIterator it = pointSource->getFeatures( QgsFeatureRequest( request ).setSubsetOfAttributes( mPointAttributes ) );
+  QgsFeature pointFeature;
+  while ( it.nextFeature( pointFeature ) )
+  {
+    if ( feedback->isCanceled() )
+      return false;
+
+    if ( !pointFeature.hasGeometry() )
+      continue;
+
+    if ( valueFieldIndex >= 0 )
+      mPointValues.insert( pointFeature.id(), pointFeature.attribute( valueFieldIndex ) );
+
+    if ( QgsWkbTypes::flatType( pointFeature.geometry().wkbType() ) != QgsWkbTypes::Point )
+    {
+      mMultiPoints.insert( pointFeature.id(), pointFeature.geometry() );
+      mMultiPointIndex.addFeature( pointFeature );
+    }
+  }
+
+  // the single points, all of them in most layers, are bulk loaded in a KDBush index
+  it = pointSource->getFeatures( QgsFeatureRequest( request ).setNoAttributes() );
+  mPointIndex = qgis::make_unique< QgsSpatialIndexKDBush >( it, feedback );
 
-  return true;
+  return !feedback->isCanceled();
 }
 
-QgsFeatureList QgsPointsInPolygonAlgorithm::processFeature( const QgsFeature &feature, QgsProcessingContext &context, QgsProcessingFeedback *feedback )
+QgsFeatureList QgsPointsInPolygonAlgorithm::processFeature( const QgsFeature &feature, QgsProcessingContext &, QgsProcessingFeedback *feedback )
 {
   QgsFeature outputFeature = feature;
   if ( !feature.hasGeometry() )
@@ -180,38 +211,51 @@ QgsFeatureList QgsPointsInPolygonAlgorithm::processFeature( const QgsFeature &fe
     double count = 0;
     QSet< QVariant> classes;
 
-    QgsFeatureRequest req = QgsFeatureRequest().setFilterRect( polyGeom.boundingBox() ).setDestinationCrs( mCrs, context.transformContext() );
-    req.setSubsetOfAttributes( mPointAttributes );
-    QgsFeatureIterator it = mPointSource->getFeatures( req );
+    // weighted and class counts are accumulated in the same pass
+    auto countPoint = [&]( QgsFeatureId id )
+    {
+      if ( mWeightFieldIndex >= 0 )
+      {
+        const QVariant weight = mPointValues.value( id );
+        bool ok = false;
+        double pointWeight = weight.toDouble( &ok );
+        // Ignore fields with non-numeric values
+        if ( ok )
+          count += pointWeight;
+        else
+          feedback->reportError( QObject::tr( "Weight field value “%1” is not a numeric value" ).arg( weight.toString() ) );
+      }
+      else if ( mClassFieldIndex >= 0 )
+      {
+        classes.insert( mPointValues.value( id ) );
+      }
+      else
+      {
+        count++;
+      }
+    };
 
-    bool ok = false;
-    QgsFeature pointFeature;
-    while ( it.nextFeature( pointFeature ) )
+    const QgsRectangle bounds = polyGeom.boundingBox();
+    mPointIndex->intersects( bounds, [&]( const QgsSpatialIndexKDBushData & data )
     {
       if ( feedback->isCanceled() )
-        break;
+        return;
+
+      const QgsPoint point( data.coords.first, data.coords.second );
+      if ( engine->contains( &point ) )
+        countPoint( data.id );
+    } );
 
-      if ( engine->contains( pointFeature.geometry().constGet() ) )
+    if ( !mMultiPoints.isEmpty() )
+    {
+      const QList< QgsFeatureId > ids = mMultiPointIndex.intersects( bounds );
+      for ( QgsFeatureId id : ids )
       {
-        if ( mWeightFieldIndex >= 0 )
-        {
-          const QVariant weight = pointFeature.attribute( mWeightFieldIndex );
-          double pointWeight = weight.toDouble( &ok );
-          // Ignore fields with non-numeric values
-          if ( ok )
-            count += pointWeight;
-          else
-            feedback->reportError( QObject::tr( "Weight field value “%1” is not a numeric value" ).arg( weight.toString() ) );
-        }
-        else if ( mClassFieldIndex >= 0 )
-        {
-          const QVariant pointClass = pointFeature.attribute( mClassFieldIndex );
-          classes.insert( pointClass );
-        }
-        else
-        {
-          count++;
-        }
+        if ( feedback->isCanceled() )
+          break;
+
+        if ( engine->contains( mMultiPoints.value( id ).constGet() ) )
+          countPoint( id );
       }
     }
 
@@ -22,6 +22,8 @@
 
 #include "qgis.h"
 #include "qgsprocessingalgorithm.h"
+#include "qgsspatialindex.h"
+#include "qgsspatialindexkdbush.h"
 
 ///@cond PRIVATE
 
@@ -34,6 +36,7 @@ class QgsPointsInPolygonAlgorithm : public QgsProcessingFeatureBasedAlgorithm
   public:
 
     QgsPointsInPolygonAlgorithm() = default;
+    Flags flags() const override;
     void initParameters( const QVariantMap &configuration = QVariantMap() ) override;
     QString name() const override;
     QString displayName() const override;
@@ -67,9 +70,15 @@ class QgsPointsInPolygonAlgorithm : public QgsProcessingFeatureBasedAlgorithm
     int mClassFieldIndex = -1;
     mutable int mDestFieldIndex = -1;
     mutable QgsFields mFields;
-    mutable QgsCoordinateReferenceSystem mCrs;
     QgsAttributeList mPointAttributes;
-    std::unique_ptr< QgsProcessingFeatureSource > mPointSource;
+
+    //! Index of the single points, read once in the crs of the polygons
+    std::unique_ptr< QgsSpatialIndexKDBush > mPointIndex;
+    //! Index of the multipoints, which are only counted when all their points are in a polygon
+    QgsSpatialIndex mMultiPointIndex;
+    QHash< QgsFeatureId, QgsGeometry > mMultiPoints;
+    //! Weight or class of the points
+    QHash< QgsFeatureId, QVariant > mPointValues;
 
 };
 
@@ -32,6 +32,8 @@
 
 #include <QtConcurrent>
 
+#include <algorithm>
+
 ///@cond PRIVATE
 
 QString QgsRasterizeAlgorithm::name() const
@@ -172,7 +174,18 @@ QVariantMap QgsRasterizeAlgorithm::processAlgorithm( const QVariantMap &paramete
     throw QgsProcessingException( QObject::tr( "Error creating GDAL driver" ) );
   }
 
-  gdal::dataset_unique_ptr hOutputDataset( GDALCreate( hOutputFileDriver, outputLayerFileName.toLocal8Bit().constData(), width, height, nBands, GDALDataType::GDT_Byte, nullptr ) );
+  // GeoTIFF blocks matching the tiles, so that each tile is written to its own blocks
+  // and no block is shared by tiles written by different threads
+  QStringList createOptions;
+  if ( driverName == QLatin1String( "GTiff" ) && tileSize % 16 == 0 )
+  {
+    createOptions << QStringLiteral( "TILED=YES" )
+                  << QStringLiteral( "BLOCKXSIZE=%1" ).arg( tileSize )
+                  << QStringLiteral( "BLOCKYSIZE=%1" ).arg( tileSize );
+  }
+  char **papszOptions = QgsGdalUtils::papszFromStringList( createOptions );
+  gdal::dataset_unique_ptr hOutputDataset( GDALCreate( hOutputFileDriver, outputLayerFileName.toLocal8Bit().constData(), width, height, nBands, GDALDataType::GDT_Byte, papszOptions ) );
+  CSLDestroy( papszOptions );
   if ( !hOutputDataset )
   {
     throw QgsProcessingException( QObject::tr( "Error creating GDAL output layer" ) );
@@ -226,18 +239,12 @@ QVariantMap QgsRasterizeAlgorithm::processAlgorithm( const QVariantMap &paramete
   const int numTiles { xTileCount * yTileCount };
   const QString fileExtension { QFileInfo( outputLayerFileName ).suffix() };
 
-  // Custom deleter for CPL allocation
-  struct CPLDelete
-  {
-    void operator()( uint8_t *ptr ) const
-    {
-      CPLFree( ptr );
-    }
-  };
-
   QAtomicInt rendered = 0;
   QMutex rasterWriteLocker;
 
+  // bands of the output in the bytes of the ARGB32 pixels, which are stored as BGRA
+  int bandMap[4] = { 3, 2, 1, 4 };
+
   const auto renderJob = [ & ]( const int x, const int y, QgsMapSettings mapSettings )
   {
     QImage image { tileSize, tileSize, QImage::Format::Format_ARGB32 };
@@ -255,35 +262,22 @@ QVariantMap QgsRasterizeAlgorithm::processAlgorithm( const QVariantMap &paramete
                              extent.xMinimum() + ( x + 1 ) * extentRatio,
                              extent.yMaximum() - y * extentRatio
                            ) );
+    // renders in this worker thread, instead of waiting for another task of the pool
     QgsMapRendererCustomPainterJob job( mapSettings, &painter );
-    job.start();
-    job.waitForFinished();
-
-    gdal::dataset_unique_ptr hIntermediateDataset( QgsGdalUtils::imageToMemoryDataset( image ) );
-    if ( !hIntermediateDataset )
-    {
-      throw QgsProcessingException( QStringLiteral( "Error reading tiles from the temporary image" ) );
-    }
+    job.renderSynchronously();
+    painter.end();
 
     const int xOffset { x * tileSize };
     const int yOffset { y * tileSize };
 
-    std::unique_ptr<uint8_t, CPLDelete> buffer( static_cast< uint8_t * >( CPLMalloc( sizeof( uint8_t ) * static_cast<size_t>( tileSize * tileSize * nBands ) ) ) );
-    CPLErr err = GDALDatasetRasterIO( hIntermediateDataset.get(),
-                                      GF_Read, 0, 0, tileSize, tileSize,
-                                      buffer.get(),
-                                      tileSize, tileSize, GDT_Byte, nBands, nullptr, 0, 0, 0 );
-    if ( err != CE_None )
-    {
-      throw QgsProcessingException( QStringLiteral( "Error reading intermediate raster" ) );
-    }
-
+    CPLErr err = CE_None;
     {
       QMutexLocker locker( &rasterWriteLocker );
       err = GDALDatasetRasterIO( hOutputDataset.get(),
                                  GF_Write, xOffset, yOffset, tileSize, tileSize,
-                                 buffer.get(),
-                                 tileSize, tileSize, GDT_Byte, nBands, nullptr, 0, 0, 0 );
+                                 image.bits(),
+                                 tileSize, tileSize, GDT_Byte, nBands, bandMap,
+                                 sizeof( QRgb ), image.bytesPerLine(), 1 );
       rendered++;
       feedback->setProgress( static_cast<double>( rendered ) / numTiles * 100.0 );
     }
@@ -295,7 +289,10 @@ QVariantMap QgsRasterizeAlgorithm::processAlgorithm( const QVariantMap &paramete
 
   feedback->setProgress( 0 );
 
+  // at most a few tiles per thread are queued, which bounds the memory used by the rendered images
+  const int maxQueuedTiles { std::max( 1, QThreadPool::globalInstance()->maxThreadCount() ) * 2 };
   std::vector<QFuture<void>> futures;
+  futures.reserve( numTiles );
 
   for ( int x = 0; x < xTileCount; ++x )
   {
@@ -303,7 +300,11 @@ QVariantMap QgsRasterizeAlgorithm::processAlgorithm( const QVariantMap &paramete
     {
       if ( feedback->isCanceled() )
       {
-        return {};
+        break;
+      }
+      if ( static_cast< int >( futures.size() ) >= maxQueuedTiles )
+      {
+        futures[ futures.size() - maxQueuedTiles ].waitForFinished();
       }
       futures.push_back( QtConcurrent::run( renderJob, x, y, mapSettings ) );
     }
@@ -314,6 +315,11 @@ QVariantMap QgsRasterizeAlgorithm::processAlgorithm( const QVariantMap &paramete
     f.waitForFinished();
   }
 
+  if ( feedback->isCanceled() )
+  {
+    return {};
+  }
+
   return { { QStringLiteral( "OUTPUT" ), outputLayerFileName } };
 }
 
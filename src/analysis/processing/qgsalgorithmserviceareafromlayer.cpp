@@ -20,8 +20,88 @@
 #include "qgsgeometryutils.h"
 #include "qgsgraphanalyzer.h"
 
+#include <QThread>
+
 ///@cond PRIVATE
 
+QgsServiceAreaFromLayerAlgorithm::ServiceArea QgsServiceAreaFromLayerAlgorithm::serviceArea( const QgsGraph *graph, int idxStart, const QVector< int > &tree, const QVector< double > &costs, double travelCost, bool includeBounds )
+{
+  ServiceArea area;
+  QSet< int > vertices;
+
+  for ( int j = 0; j < costs.size(); j++ )
+  {
+    const int inboundEdgeIndex = tree.at( j );
+
+    if ( inboundEdgeIndex == -1 && j != idxStart )
+    {
+      // unreachable vertex
+      continue;
+    }
+
+    const double startVertexCost = costs.at( j );
+    if ( startVertexCost > travelCost )
+    {
+      // vertex is too expensive, discard
+      continue;
+    }
+
+    vertices.insert( j );
+    const QgsPointXY startPoint = graph->vertex( j ).point();
+
+    // find all edges coming from this vertex
+    const QList< int > outgoingEdges = graph->vertex( j ).outgoingEdges() ;
+    for ( int edgeId : outgoingEdges )
+    {
+      const QgsGraphEdge &edge = graph->edge( edgeId );
+      const double endVertexCost = startVertexCost + edge.cost( 0 ).toDouble();
+      const QgsPointXY endPoint = graph->vertex( edge.toVertex() ).point();
+      if ( endVertexCost <= travelCost )
+      {
+        // end vertex is cheap enough to include
+        vertices.insert( edge.toVertex() );
+        area.lines.push_back( QgsPolylineXY() << startPoint << endPoint );
+      }
+      else
+      {
+        // travelCost sits somewhere on this edge, interpolate position
+        QgsPointXY interpolatedEndPoint = QgsGeometryUtils::interpolatePointOnLineByValue( startPoint.x(), startPoint.y(), startVertexCost,
+                                          endPoint.x(), endPoint.y(), endVertexCost, travelCost );
+
+        area.points.push_back( interpolatedEndPoint );
+        area.lines.push_back( QgsPolylineXY() << startPoint << interpolatedEndPoint );
+      }
+    } // edges
+  } // costs
+
+  // convert to list and sort to maintain same order of points between algorithm runs
+  QList< int > verticesList = qgis::setToList( vertices );
+  area.points.reserve( verticesList.size() );
+  std::sort( verticesList.begin(), verticesList.end() );
+  for ( int v : verticesList )
+  {
+    area.points.push_back( graph->vertex( v ).point() );
+  }
+
+  if ( includeBounds )
+  {
+    for ( int v = 0; v < costs.size(); v++ )
+    {
+      if ( costs.at( v ) > travelCost && tree.at( v ) != -1 )
+      {
+        const QgsGraphEdge &edge = graph->edge( tree.at( v ) );
+        if ( costs.at( edge.fromVertex() ) <= travelCost )
+        {
+          area.upperBoundary.push_back( graph->vertex( edge.toVertex() ).point() );
+          area.lowerBoundary.push_back( graph->vertex( edge.fromVertex() ).point() );
+        }
+      }
+    } // costs
+  }
+
+  return area;
+}
+
 QString QgsServiceAreaFromLayerAlgorithm::name() const
 {
   return QStringLiteral( "serviceareafromlayer" );
@@ -123,152 +203,77 @@ QVariantMap QgsServiceAreaFromLayerAlgorithm::processAlgorithm( const QVariantMa
   std::unique_ptr< QgsFeatureSink > linesSink( parameterAsSink( parameters, QStringLiteral( "OUTPUT_LINES" ), context, linesSinkId, fields,
       QgsWkbTypes::MultiLineString, mNetwork->sourceCrs() ) );
 
-  int idxStart;
-  QString origPoint;
-  QVector< int > tree;
-  QVector< double > costs;
-
-  int inboundEdgeIndex;
-  double startVertexCost, endVertexCost;
-  QgsPointXY startPoint, endPoint;
-  QgsGraphEdge edge;
-
   QgsFeature feat;
   QgsAttributes attributes;
 
-  int step =  snappedPoints.size() > 0 ? 100.0 / snappedPoints.size() : 1;
-  for ( int i = 0; i < snappedPoints.size(); i++ )
+  // the service areas of a block of start points are computed in parallel, then written in order
+  const int blockSize = std::max( 1, QThread::idealThreadCount() ) * 16;
+  const bool computeBounds = pointsSink && includeBounds;
+  double step = snappedPoints.size() > 0 ? 100.0 / snappedPoints.size() : 1;
+  for ( int blockStart = 0; blockStart < snappedPoints.size(); blockStart += blockSize )
   {
     if ( feedback->isCanceled() )
     {
       break;
     }
 
-    idxStart = graph->findVertex( snappedPoints.at( i ) );
-    origPoint = points.at( i ).toString();
+    const int blockEnd = std::min( blockStart + blockSize, snappedPoints.size() );
+    QVector< int > startVertices;
+    startVertices.reserve( blockEnd - blockStart );
+    for ( int i = blockStart; i < blockEnd; i++ )
+      startVertices << graph->findVertex( snappedPoints.at( i ) );
 
-    QgsGraphAnalyzer::dijkstra( graph, idxStart, 0, &tree, &costs );
-
-    QgsMultiPointXY areaPoints;
-    QgsMultiPolylineXY lines;
-    QSet< int > vertices;
-
-    for ( int j = 0; j < costs.size(); j++ )
+    QVector< ServiceArea > areas( startVertices.size() );
+    QgsGraphAnalyzer::dijkstra( graph, startVertices, 0, [&]( int index, const QVector< int > &tree, const QVector< double > &costs )
     {
-      inboundEdgeIndex = tree.at( j );
-
-      if ( inboundEdgeIndex == -1 && j != idxStart )
-      {
-        // unreachable vertex
-        continue;
-      }
-
-      startVertexCost = costs.at( j );
-      if ( startVertexCost > travelCost )
-      {
-        // vertex is too expensive, discard
-        continue;
-      }
-
-      vertices.insert( j );
-      startPoint = graph->vertex( j ).point();
-
-      // find all edges coming from this vertex
-      const QList< int > outgoingEdges = graph->vertex( j ).outgoingEdges() ;
-      for ( int edgeId : outgoingEdges )
-      {
-        edge = graph->edge( edgeId );
-        endVertexCost = startVertexCost + edge.cost( 0 ).toDouble();
-        endPoint = graph->vertex( edge.toVertex() ).point();
-        if ( endVertexCost <= travelCost )
-        {
-          // end vertex is cheap enough to include
-          vertices.insert( edge.toVertex() );
-          lines.push_back( QgsPolylineXY() << startPoint << endPoint );
-        }
-        else
-        {
-          // travelCost sits somewhere on this edge, interpolate position
-          QgsPointXY interpolatedEndPoint = QgsGeometryUtils::interpolatePointOnLineByValue( startPoint.x(), startPoint.y(), startVertexCost,
-                                            endPoint.x(), endPoint.y(), endVertexCost, travelCost );
-
-          areaPoints.push_back( interpolatedEndPoint );
-          lines.push_back( QgsPolylineXY() << startPoint << interpolatedEndPoint );
-        }
-      } // edges
-    } // costs
+      areas[ index ] = serviceArea( graph, startVertices.at( index ), tree, costs, travelCost, computeBounds );
+    }, feedback );
 
-    // convert to list and sort to maintain same order of points between algorithm runs
-    QList< int > verticesList = qgis::setToList( vertices );
-    areaPoints.reserve( verticesList.size() );
-    std::sort( verticesList.begin(), verticesList.end() );
-    for ( int v : verticesList )
+    for ( int i = blockStart; i < blockEnd && !feedback->isCanceled(); i++ )
     {
-      areaPoints.push_back( graph->vertex( v ).point() );
-    }
+      const ServiceArea &area = areas.at( i - blockStart );
+      const QString origPoint = points.at( i ).toString();
 
-    if ( pointsSink )
-    {
-      QgsGeometry geomPoints = QgsGeometry::fromMultiPointXY( areaPoints );
-      feat.setGeometry( geomPoints );
-      attributes = sourceAttributes.value( i + 1 );
-      attributes << QStringLiteral( "within" ) << origPoint;
-      feat.setAttributes( attributes );
-      pointsSink->addFeature( feat, QgsFeatureSink::FastInsert );
-
-      if ( includeBounds )
+      if ( pointsSink )
       {
-        QgsMultiPointXY upperBoundary, lowerBoundary;
-        QVector< int > nodes;
-        nodes.reserve( costs.size() );
-
-        int vertexId;
-        for ( int v = 0; v < costs.size(); v++ )
-        {
-          if ( costs.at( v ) > travelCost && tree.at( v ) != -1 )
-          {
-            vertexId = graph->edge( tree.at( v ) ).fromVertex();
-            if ( costs.at( vertexId ) <= travelCost )
-            {
-              nodes.push_back( v );
-            }
-          }
-        } // costs
-
-        for ( int n : qgis::as_const( nodes ) )
-        {
-          upperBoundary.push_back( graph->vertex( graph->edge( tree.at( n ) ).toVertex() ).point() );
-          lowerBoundary.push_back( graph->vertex( graph->edge( tree.at( n ) ).fromVertex() ).point() );
-        } // nodes
-
-        QgsGeometry geomUpper = QgsGeometry::fromMultiPointXY( upperBoundary );
-        QgsGeometry geomLower = QgsGeometry::fromMultiPointXY( lowerBoundary );
-
-        feat.setGeometry( geomUpper );
+        QgsGeometry geomPoints = QgsGeometry::fromMultiPointXY( area.points );
+        feat.setGeometry( geomPoints );
         attributes = sourceAttributes.value( i + 1 );
-        attributes << QStringLiteral( "upper" ) << origPoint;
+        attributes << QStringLiteral( "within" ) << origPoint;
         feat.setAttributes( attributes );
         pointsSink->addFeature( feat, QgsFeatureSink::FastInsert );
 
-        feat.setGeometry( geomLower );
+        if ( includeBounds )
+        {
+          QgsGeometry geomUpper = QgsGeometry::fromMultiPointXY( area.upperBoundary );
+          QgsGeometry geomLower = QgsGeometry::fromMultiPointXY( area.lowerBoundary );
+
+          feat.setGeometry( geomUpper );
+          attributes = sourceAttributes.value( i + 1 );
+          attributes << QStringLiteral( "upper" ) << origPoint;
+          feat.setAttributes( attributes );
+          pointsSink->addFeature( feat, QgsFeatureSink::FastInsert );
+
+          feat.setGeometry( geomLower );
+          attributes = sourceAttributes.value( i + 1 );
+          attributes << QStringLiteral( "lower" ) << origPoint;
+          feat.setAttributes( attributes );
+          pointsSink->addFeature( feat, QgsFeatureSink::FastInsert );
+        } // includeBounds
+      }
+
+      if ( linesSink )
+      {
+        QgsGeometry geomLines = QgsGeometry::fromMultiPolylineXY( area.lines );
+        feat.setGeometry( geomLines );
         attributes = sourceAttributes.value( i + 1 );
-        attributes << QStringLiteral( "lower" ) << origPoint;
+        attributes << QStringLiteral( "lines" ) << origPoint;
         feat.setAttributes( attributes );
-        pointsSink->addFeature( feat, QgsFeatureSink::FastInsert );
-      } // includeBounds
-    }
+        linesSink->addFeature( feat, QgsFeatureSink::FastInsert );
+      }
 
-    if ( linesSink )
-    {
-      QgsGeometry geomLines = QgsGeometry::fromMultiPolylineXY( lines );
-      feat.setGeometry( geomLines );
-      attributes = sourceAttributes.value( i + 1 );
-      attributes << QStringLiteral( "lines" ) << origPoint;
-      feat.setAttributes( attributes );
-      linesSink->addFeature( feat, QgsFeatureSink::FastInsert );
+      feedback->setProgress( i * step );
     }
-
-    feedback->setProgress( i * step );
   } // snappedPoints
 
   QVariantMap outputs;
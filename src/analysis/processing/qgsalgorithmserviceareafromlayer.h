@@ -22,6 +22,7 @@
 
 #include "qgis.h"
 #include "qgsalgorithmnetworkanalysisbase.h"
+#include "qgsgeometry.h"
 
 ///@cond PRIVATE
 
@@ -46,6 +47,23 @@ class QgsServiceAreaFromLayerAlgorithm : public QgsNetworkAnalysisAlgorithmBase
     QVariantMap processAlgorithm( const QVariantMap &parameters,
                                   QgsProcessingContext &context, QgsProcessingFeedback *feedback ) override;
 
+  private:
+
+    //! Geometries of the service area of a start point
+    struct ServiceArea
+    {
+      QgsMultiPointXY points;
+      QgsMultiPolylineXY lines;
+      QgsMultiPointXY upperBoundary;
+      QgsMultiPointXY lowerBoundary;
+    };
+
+    /**
+     * Returns the service area of the start vertex \a idxStart within \a travelCost, from its shortest path \a tree and \a costs.
+     * Only reads the \a graph, so that the service areas of several start points can be computed in parallel.
+     */
+    static ServiceArea serviceArea( const QgsGraph *graph, int idxStart, const QVector< int > &tree, const QVector< double > &costs, double travelCost, bool includeBounds );
+
 };
 
 ///@endcond PRIVATE
@@ -0,0 +1,145 @@
+/***************************************************************************
+                         qgsalgorithmshortestpathcostmatrix.cpp
+                         ---------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsalgorithmshortestpathcostmatrix.h"
+
+#include "qgsgraphanalyzer.h"
+
+#include <QThread>
+
+#include <limits>
+
+///@cond PRIVATE
+
+QString QgsShortestPathCostMatrixAlgorithm::name() const
+{
+  return QStringLiteral( "shortestpathcostmatrix" );
+}
+
+QString QgsShortestPathCostMatrixAlgorithm::displayName() const
+{
+  return QObject::tr( "Shortest path cost matrix (layer to layer)" );
+}
+
+QStringList QgsShortestPathCostMatrixAlgorithm::tags() const
+{
+  return QObject::tr( "network,path,shortest,fastest,origin,destination,od,matrix,cost,accessibility" ).split( ',' );
+}
+
+QString QgsShortestPathCostMatrixAlgorithm::shortHelpString() const
+{
+  return QObject::tr( "This algorithm computes the cost of the optimal (shortest or fastest) route from each of the start points "
+                      "defined by a vector layer to each of the end points defined by another vector layer.\n\n"
+                      "The output table has one row per pair of start and end points, identified by their order in their layer, "
+                      "starting at 1. The cost is NULL when there is no route between the points." );
+}
+
+QgsShortestPathCostMatrixAlgorithm *QgsShortestPathCostMatrixAlgorithm::createInstance() const
+{
+  return new QgsShortestPathCostMatrixAlgorithm();
+}
+
+void QgsShortestPathCostMatrixAlgorithm::initAlgorithm( const QVariantMap & )
+{
+  addCommonParams();
+  addParameter( new QgsProcessingParameterFeatureSource( QStringLiteral( "START_POINTS" ), QObject::tr( "Vector layer with start points" ), QList< int >() << QgsProcessing::TypeVectorPoint ) );
+  addParameter( new QgsProcessingParameterFeatureSource( QStringLiteral( "END_POINTS" ), QObject::tr( "Vector layer with end points" ), QList< int >() << QgsProcessing::TypeVectorPoint ) );
+
+  addParameter( new QgsProcessingParameterFeatureSink( QStringLiteral( "OUTPUT" ), QObject::tr( "Cost matrix" ), QgsProcessing::TypeVector ) );
+}
+
+QVariantMap QgsShortestPathCostMatrixAlgorithm::processAlgorithm( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback )
+{
+  loadCommonParams( parameters, context, feedback );
+
+  std::unique_ptr< QgsFeatureSource > startPoints( parameterAsSource( parameters, QStringLiteral( "START_POINTS" ), context ) );
+  if ( !startPoints )
+    throw QgsProcessingException( invalidSourceError( parameters, QStringLiteral( "START_POINTS" ) ) );
+
+  std::unique_ptr< QgsFeatureSource > endPoints( parameterAsSource( parameters, QStringLiteral( "END_POINTS" ), context ) );
+  if ( !endPoints )
+    throw QgsProcessingException( invalidSourceError( parameters, QStringLiteral( "END_POINTS" ) ) );
+
+  QgsFields fields;
+  fields.append( QgsField( QStringLiteral( "start_id" ), QVariant::Int ) );
+  fields.append( QgsField( QStringLiteral( "end_id" ), QVariant::Int ) );
+  fields.append( QgsField( QStringLiteral( "start" ), QVariant::String ) );
+  fields.append( QgsField( QStringLiteral( "end" ), QVariant::String ) );
+  fields.append( QgsField( QStringLiteral( "cost" ), QVariant::Double ) );
+
+  QString dest;
+  std::unique_ptr< QgsFeatureSink > sink( parameterAsSink( parameters, QStringLiteral( "OUTPUT" ), context, dest, fields, QgsWkbTypes::NoGeometry, QgsCoordinateReferenceSystem() ) );
+  if ( !sink )
+    throw QgsProcessingException( invalidSinkError( parameters, QStringLiteral( "OUTPUT" ) ) );
+
+  QVector< QgsPointXY > points;
+  QHash< int, QgsAttributes > sourceAttributes;
+  loadPoints( startPoints.get(), points, sourceAttributes, context, feedback );
+  const int startCount = points.size();
+  loadPoints( endPoints.get(), points, sourceAttributes, context, feedback );
+  const int endCount = points.size() - startCount;
+
+  feedback->pushInfo( QObject::tr( "Building graph…" ) );
+  QVector< QgsPointXY > snappedPoints;
+  mDirector->makeGraph( mBuilder.get(), points, snappedPoints, feedback );
+
+  feedback->pushInfo( QObject::tr( "Calculating shortest path costs…" ) );
+  QgsGraph *graph = mBuilder->graph();
+
+  QVector< int > endVertices;
+  endVertices.reserve( endCount );
+  for ( int j = 0; j < endCount; j++ )
+    endVertices << graph->findVertex( snappedPoints.at( startCount + j ) );
+
+  // the costs from a block of start points are computed in parallel, then written in order
+  const int blockSize = std::max( 1, QThread::idealThreadCount() ) * 16;
+  const double step = startCount > 0 ? 100.0 / startCount : 1;
+  QgsFeature feat;
+  feat.setFields( fields );
+  for ( int blockStart = 0; blockStart < startCount && !feedback->isCanceled(); blockStart += blockSize )
+  {
+    const int blockEnd = std::min( blockStart + blockSize, startCount );
+    QVector< int > startVertices;
+    startVertices.reserve( blockEnd - blockStart );
+    for ( int i = blockStart; i < blockEnd; i++ )
+      startVertices << graph->findVertex( snappedPoints.at( i ) );
+
+    const QVector< QVector< double > > costs = QgsGraphAnalyzer::costMatrix( graph, startVertices, endVertices, 0, feedback );
+    if ( feedback->isCanceled() )
+      break;
+
+    for ( int i = blockStart; i < blockEnd; i++ )
+    {
+      const QVector< double > &row = costs.at( i - blockStart );
+      const QString start = points.at( i ).toString();
+      for ( int j = 0; j < endCount; j++ )
+      {
+        const double cost = row.at( j );
+        feat.setAttributes( QgsAttributes() << i + 1 << j + 1 << start << points.at( startCount + j ).toString()
+                            << ( cost < std::numeric_limits< double >::infinity() ? QVariant( cost / mMultiplier ) : QVariant() ) );
+        sink->addFeature( feat, QgsFeatureSink::FastInsert );
+      }
+      feedback->setProgress( i * step );
+    }
+  }
+
+  QVariantMap outputs;
+  outputs.insert( QStringLiteral( "OUTPUT" ), dest );
+  return outputs;
+}
+
+///@endcond
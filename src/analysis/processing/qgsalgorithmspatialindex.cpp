@@ -16,6 +16,8 @@
  ***************************************************************************/
 
 #include "qgsalgorithmspatialindex.h"
+#include "qgsspatialindexcache.h"
+#include "qgsspatialindexpackedrtree.h"
 #include "qgsvectorlayer.h"
 #include "qgsvectordataprovider.h"
 
@@ -57,7 +59,11 @@ QString QgsSpatialIndexAlgorithm::shortHelpString() const
   return QObject::tr( "Creates an index to speed up access to the features "
                       "in a layer based on their spatial location. Support "
                       "for spatial index creation is dependent on the layer's "
-                      "data provider." );
+                      "data provider.\n\n"
+                      "For files whose format does not support spatial indexes, "
+                      "like GeoJSON or CSV files, the index is stored in the QGIS "
+                      "cache directory and used by the algorithms which query the "
+                      "layer by location, until the file is modified." );
 }
 
 QgsSpatialIndexAlgorithm *QgsSpatialIndexAlgorithm::createInstance() const
@@ -88,6 +94,15 @@ QVariantMap QgsSpatialIndexAlgorithm::processAlgorithm( const QVariantMap &param
       feedback->pushInfo( QObject::tr( "Could not create spatial index" ) );
     }
   }
+  else if ( QgsSpatialIndexCache::isCacheable( layer ) )
+  {
+    const QgsSpatialIndexPackedRTree index( *provider, feedback );
+    if ( feedback->isCanceled() )
+      return QVariantMap();
+
+    if ( !QgsSpatialIndexCache::storeIndex( layer, index ) )
+      feedback->pushInfo( QObject::tr( "Could not store spatial index in %1" ).arg( QgsSpatialIndexCache::cacheDirectory() ) );
+  }
   else
   {
     feedback->pushInfo( QObject::tr( "Layer's data provider does not support spatial indexes" ) );
@@ -18,8 +18,181 @@
 #include "qgsgeometryengine.h"
 #include "qgsprocessingalgorithm.h"
 
+#include <QMutex>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
 ///@cond PRIVATE
 
+//! Number of input features overlaid in parallel by each thread, between two progress reports
+static const int OVERLAY_FEATURES_PER_THREAD = 256;
+
+//! A feature of the input layer, with the overlay features whose bounding box intersects it, and the output features
+struct QgsOverlayItem
+{
+  QgsFeature feature;
+  QList<QgsFeatureId> candidates;
+  QgsFeatureList outputs;
+};
+
+//! Computes the output features of an input feature from the overlay features, called from several threads at once
+typedef std::function< void( QgsOverlayItem &, const QHash<QgsFeatureId, QgsFeature> & ) > QgsOverlayFunction;
+
+/**
+ * Overlays in parallel the features of \a fitA with the features of \a sourceB, found from \a indexB and read with \a requestB.
+ *
+ * The input features are read by batches, whose overlay features are read at once. Each batch is partitioned in cells
+ * of a grid over its extent, from the center of the bounding box of the features, and the cells are overlaid concurrently,
+ * so that each thread works on neighboring features. A feature belongs to a single cell, so nothing is output twice
+ * for the features across cell boundaries. The output features are added to \a sink in the order of the input features.
+ */
+static void overlayFeatures( QgsFeatureIterator &fitA, const QgsSpatialIndex &indexB, const QgsFeatureSource &sourceB, QgsFeatureRequest requestB,
+                             QgsFeatureSink &sink, QgsProcessingFeedback *feedback, int &count, int totalCount, const QgsOverlayFunction &overlay )
+{
+  struct Cell
+  {
+    std::size_t begin;
+    std::size_t end;
+  };
+
+  const int threadCount = std::max( 1, QThreadPool::globalInstance()->maxThreadCount() );
+  const std::size_t cellSize = OVERLAY_FEATURES_PER_THREAD / 4;
+  const std::size_t batchSize = static_cast< std::size_t >( OVERLAY_FEATURES_PER_THREAD ) * threadCount;
+
+  QMutex mutex;
+  QString error;
+  QAtomicInt failed( 0 );
+  std::vector< QgsOverlayItem > items;
+  QHash<QgsFeatureId, QgsFeature> featuresB;
+
+  auto overlayCell = [&]( const Cell & cell )
+  {
+    for ( std::size_t i = cell.begin; i < cell.end && !feedback->isCanceled() && !failed.loadAcquire(); ++i )
+    {
+      try
+      {
+        overlay( items[ i ], featuresB );
+      }
+      catch ( QgsException &e )
+      {
+        // rethrown from the calling thread, once the cells being overlaid are done
+        QMutexLocker locker( &mutex );
+        if ( error.isEmpty() )
+          error = e.what();
+        failed.storeRelease( 1 );
+        break;
+      }
+    }
+  };
+
+  QgsFeature featA;
+  std::vector< std::pair< quint64, std::size_t > > keys;
+  std::vector< QgsOverlayItem > sorted;
+  std::vector< Cell > cells;
+  bool finished = false;
+  while ( !finished && !feedback->isCanceled() )
+  {
+    // the features are read from the calling thread, the iterators not being thread safe
+    items.clear();
+    QgsFeatureIds idsB;
+    QgsRectangle extent;
+    extent.setMinimal();
+    while ( items.size() < batchSize )
+    {
+      if ( !fitA.nextFeature( featA ) )
+      {
+        finished = true;
+        break;
+      }
+
+      QgsOverlayItem item { featA, QList<QgsFeatureId>(), QgsFeatureList() };
+      if ( featA.hasGeometry() )
+      {
+        const QgsRectangle box = featA.geometry().boundingBox();
+        item.candidates = indexB.intersects( box );
+        std::sort( item.candidates.begin(), item.candidates.end() );
+        for ( QgsFeatureId id : qgis::as_const( item.candidates ) )
+          idsB.insert( id );
+        extent.combineExtentWith( box );
+      }
+      items.push_back( item );
+    }
+    if ( items.empty() )
+      break;
+
+    featuresB.clear();
+    if ( !idsB.isEmpty() )
+    {
+      QgsFeatureRequest request( requestB );
+      request.setFilterFids( idsB );
+      QgsFeature featB;
+      QgsFeatureIterator fitB = sourceB.getFeatures( request );
+      while ( fitB.nextFeature( featB ) )
+      {
+        if ( feedback->isCanceled() )
+          break;
+        featuresB.insert( featB.id(), featB );
+      }
+    }
+
+    // sort the features by grid cell, row by row, keeping their position to restore the input order
+    const int gridSize = std::max( 1, static_cast< int >( std::ceil( std::sqrt( static_cast< double >( items.size() ) / cellSize ) ) ) );
+    const double cellWidth = extent.width() > 0 ? extent.width() / gridSize : 1;
+    const double cellHeight = extent.height() > 0 ? extent.height() / gridSize : 1;
+    keys.clear();
+    for ( std::size_t i = 0; i < items.size(); ++i )
+    {
+      quint64 key = 0;
+      if ( items[ i ].feature.hasGeometry() )
+      {
+        const QgsPointXY center = items[ i ].feature.geometry().boundingBox().center();
+        const quint64 column = static_cast< quint64 >( qBound( 0, static_cast< int >( ( center.x() - extent.xMinimum() ) / cellWidth ), gridSize - 1 ) );
+        const quint64 row = static_cast< quint64 >( qBound( 0, static_cast< int >( ( center.y() - extent.yMinimum() ) / cellHeight ), gridSize - 1 ) );
+        key = row * gridSize + column;
+      }
+      keys.emplace_back( key, i );
+    }
+    std::sort( keys.begin(), keys.end() );
+
+    sorted.clear();
+    sorted.reserve( items.size() );
+    for ( const std::pair< quint64, std::size_t > &key : keys )
+      sorted.push_back( std::move( items[ key.second ] ) );
+    items.swap( sorted );
+
+    // runs of consecutive features are overlaid together whatever their cell, to balance the load among the threads
+    cells.clear();
+    for ( std::size_t begin = 0; begin < items.size(); begin += cellSize )
+      cells.push_back( { begin, std::min( begin + cellSize, items.size() ) } );
+    QtConcurrent::blockingMap( cells, overlayCell );
+
+    if ( !error.isEmpty() )
+      throw QgsProcessingException( error );
+
+    // restores the input order
+    sorted.resize( items.size() );
+    for ( std::size_t i = 0; i < keys.size(); ++i )
+      sorted[ keys[ i ].second ] = std::move( items[ i ] );
+    items.swap( sorted );
+
+    for ( const QgsOverlayItem &item : items )
+    {
+      if ( feedback->isCanceled() )
+        break;
+
+      for ( QgsFeature outFeat : item.outputs )
+        sink.addFeature( outFeat, QgsFeatureSink::FastInsert );
+    }
+
+    count += static_cast< int >( items.size() );
+    feedback->setProgress( count / ( double ) std::max( 1, totalCount ) * 100. );
+  }
+}
+
 bool QgsOverlayUtils::sanitizeIntersectionResult( QgsGeometry &geom, QgsWkbTypes::GeometryType geometryType )
 {
   if ( geom.isNull() )
@@ -82,104 +255,87 @@ void QgsOverlayUtils::difference( const QgsFeatureSource &sourceA, const QgsFeat
     requestB.setDestinationCrs( sourceA.sourceCrs(), context.transformContext() );
   QgsSpatialIndex indexB( sourceB.getFeatures( requestB ), feedback );
 
-  int fieldsCountA = sourceA.fields().count();
-  int fieldsCountB = sourceB.fields().count();
-  QgsAttributes attrs;
-  attrs.resize( outputAttrs == OutputA ? fieldsCountA : ( fieldsCountA + fieldsCountB ) );
+  const int fieldsCountA = sourceA.fields().count();
+  const int fieldsCountB = sourceB.fields().count();
+  const int attrCount = outputAttrs == OutputA ? fieldsCountA : ( fieldsCountA + fieldsCountB );
 
-  if ( totalCount == 0 )
-    totalCount = 1;  // avoid division by zero
-
-  QgsFeature featA;
   QgsFeatureRequest requestA;
   requestA.setInvalidGeometryCheck( context.invalidGeometryCheck() );
   if ( outputAttrs == OutputBA )
     requestA.setDestinationCrs( sourceB.sourceCrs(), context.transformContext() );
   QgsFeatureIterator fitA = sourceA.getFeatures( requestA );
-  while ( fitA.nextFeature( featA ) )
-  {
-    if ( feedback->isCanceled() )
-      break;
 
-    if ( featA.hasGeometry() )
+  overlayFeatures( fitA, indexB, sourceB, requestB, sink, feedback, count, totalCount, [ = ]( QgsOverlayItem & item, const QHash<QgsFeatureId, QgsFeature> &featuresB )
+  {
+    const QgsFeature &featA = item.feature;
+    if ( !featA.hasGeometry() )
     {
-      QgsGeometry geom( featA.geometry() );
-      QgsFeatureIds intersects = qgis::listToSet( indexB.intersects( geom.boundingBox() ) );
+      // TODO: should we write out features that do not have geometry?
+      item.outputs << featA;
+      return;
+    }
 
-      QgsFeatureRequest request;
-      request.setFilterFids( intersects );
-      request.setNoAttributes();
-      if ( outputAttrs != OutputBA )
-        request.setDestinationCrs( sourceA.sourceCrs(), context.transformContext() );
+    QgsGeometry geom( featA.geometry() );
 
-      std::unique_ptr< QgsGeometryEngine > engine;
-      if ( !intersects.isEmpty() )
-      {
-        // use prepared geometries for faster intersection tests
-        engine.reset( QgsGeometry::createGeometryEngine( geom.constGet() ) );
-        engine->prepareGeometry();
-      }
+    std::unique_ptr< QgsGeometryEngine > engine;
+    if ( !item.candidates.isEmpty() )
+    {
+      // use prepared geometries for faster intersection tests
+      engine.reset( QgsGeometry::createGeometryEngine( geom.constGet() ) );
+      engine->prepareGeometry();
+    }
 
-      QVector<QgsGeometry> geometriesB;
-      QgsFeature featB;
-      QgsFeatureIterator fitB = sourceB.getFeatures( request );
-      while ( fitB.nextFeature( featB ) )
-      {
-        if ( feedback->isCanceled() )
-          break;
+    QVector<QgsGeometry> geometriesB;
+    for ( QgsFeatureId id : qgis::as_const( item.candidates ) )
+    {
+      if ( feedback->isCanceled() )
+        break;
 
-        if ( engine->intersects( featB.geometry().constGet() ) )
-          geometriesB << featB.geometry();
-      }
+      const auto featB = featuresB.constFind( id );
+      if ( featB != featuresB.constEnd() && engine->intersects( featB->geometry().constGet() ) )
+        geometriesB << featB->geometry();
+    }
 
-      if ( !geometriesB.isEmpty() )
+    if ( !geometriesB.isEmpty() )
+    {
+      QgsGeometry geomB = QgsGeometry::unaryUnion( geometriesB );
+      if ( !geomB.lastError().isEmpty() )
       {
-        QgsGeometry geomB = QgsGeometry::unaryUnion( geometriesB );
-        if ( !geomB.lastError().isEmpty() )
-        {
-          // This may happen if input geometries from a layer do not line up well (for example polygons
-          // that are nearly touching each other, but there is a very tiny overlap or gap at one of the edges).
-          // It is possible to get rid of this issue in two steps:
-          // 1. snap geometries with a small tolerance (e.g. 1cm) using QgsGeometrySnapperSingleSource
-          // 2. fix geometries (removes polygons collapsed to lines etc.) using MakeValid
-          throw QgsProcessingException( QStringLiteral( "%1\n\n%2" ).arg( QObject::tr( "GEOS geoprocessing error: unary union failed." ), geomB.lastError() ) );
-        }
-        geom = geom.difference( geomB );
+        // This may happen if input geometries from a layer do not line up well (for example polygons
+        // that are nearly touching each other, but there is a very tiny overlap or gap at one of the edges).
+        // It is possible to get rid of this issue in two steps:
+        // 1. snap geometries with a small tolerance (e.g. 1cm) using QgsGeometrySnapperSingleSource
+        // 2. fix geometries (removes polygons collapsed to lines etc.) using MakeValid
+        throw QgsProcessingException( QStringLiteral( "%1\n\n%2" ).arg( QObject::tr( "GEOS geoprocessing error: unary union failed." ), geomB.lastError() ) );
       }
+      geom = geom.difference( geomB );
+    }
 
-      if ( !sanitizeDifferenceResult( geom ) )
-        continue;
-
-      const QgsAttributes attrsA( featA.attributes() );
-      switch ( outputAttrs )
-      {
-        case OutputA:
-          attrs = attrsA;
-          break;
-        case OutputAB:
-          for ( int i = 0; i < fieldsCountA; ++i )
-            attrs[i] = attrsA[i];
-          break;
-        case OutputBA:
-          for ( int i = 0; i < fieldsCountA; ++i )
-            attrs[i + fieldsCountB] = attrsA[i];
-          break;
-      }
+    if ( !sanitizeDifferenceResult( geom ) )
+      return;
 
-      QgsFeature outFeat;
-      outFeat.setGeometry( geom );
-      outFeat.setAttributes( attrs );
-      sink.addFeature( outFeat, QgsFeatureSink::FastInsert );
-    }
-    else
+    QgsAttributes attrs( attrCount );
+    const QgsAttributes attrsA( featA.attributes() );
+    switch ( outputAttrs )
     {
-      // TODO: should we write out features that do not have geometry?
-      sink.addFeature( featA, QgsFeatureSink::FastInsert );
+      case OutputA:
+        attrs = attrsA;
+        break;
+      case OutputAB:
+        for ( int i = 0; i < fieldsCountA; ++i )
+          attrs[i] = attrsA[i];
+        break;
+      case OutputBA:
+        for ( int i = 0; i < fieldsCountA; ++i )
+          attrs[i + fieldsCountB] = attrsA[i];
+        break;
     }
 
-    ++count;
-    feedback->setProgress( count / ( double ) totalCount * 100. );
-  }
+    QgsFeature outFeat;
+    outFeat.setGeometry( geom );
+    outFeat.setAttributes( attrs );
+    item.outputs << outFeat;
+  } );
 }
 
 
@@ -192,51 +348,41 @@ void QgsOverlayUtils::intersection( const QgsFeatureSource &sourceA, const QgsFe
   request.setNoAttributes();
   request.setDestinationCrs( sourceA.sourceCrs(), context.transformContext() );
 
-  QgsFeature outFeat;
   QgsSpatialIndex indexB( sourceB.getFeatures( request ), feedback );
 
-  if ( totalCount == 0 )
-    totalCount = 1;  // avoid division by zero
+  QgsFeatureRequest requestB;
+  requestB.setDestinationCrs( sourceA.sourceCrs(), context.transformContext() );
+  requestB.setSubsetOfAttributes( fieldIndicesB );
 
-  QgsFeature featA;
   QgsFeatureIterator fitA = sourceA.getFeatures( QgsFeatureRequest().setSubsetOfAttributes( fieldIndicesA ) );
-  while ( fitA.nextFeature( featA ) )
-  {
-    if ( feedback->isCanceled() )
-      break;
 
-    if ( !featA.hasGeometry() )
-      continue;
+  overlayFeatures( fitA, indexB, sourceB, requestB, sink, feedback, count, totalCount, [ = ]( QgsOverlayItem & item, const QHash<QgsFeatureId, QgsFeature> &featuresB )
+  {
+    const QgsFeature &featA = item.feature;
+    if ( !featA.hasGeometry() || item.candidates.isEmpty() )
+      return;
 
     QgsGeometry geom( featA.geometry() );
-    QgsFeatureIds intersects = qgis::listToSet( indexB.intersects( geom.boundingBox() ) );
 
-    QgsFeatureRequest request;
-    request.setFilterFids( intersects );
-    request.setDestinationCrs( sourceA.sourceCrs(), context.transformContext() );
-    request.setSubsetOfAttributes( fieldIndicesB );
-
-    std::unique_ptr< QgsGeometryEngine > engine;
-    if ( !intersects.isEmpty() )
-    {
-      // use prepared geometries for faster intersection tests
-      engine.reset( QgsGeometry::createGeometryEngine( geom.constGet() ) );
-      engine->prepareGeometry();
-    }
+    // use prepared geometries for faster intersection tests
+    std::unique_ptr< QgsGeometryEngine > engine( QgsGeometry::createGeometryEngine( geom.constGet() ) );
+    engine->prepareGeometry();
 
     QgsAttributes outAttributes( attrCount );
     const QgsAttributes attrsA( featA.attributes() );
     for ( int i = 0; i < fieldIndicesA.count(); ++i )
       outAttributes[i] = attrsA[fieldIndicesA[i]];
 
-    QgsFeature featB;
-    QgsFeatureIterator fitB = sourceB.getFeatures( request );
-    while ( fitB.nextFeature( featB ) )
+    for ( QgsFeatureId id : qgis::as_const( item.candidates ) )
     {
       if ( feedback->isCanceled() )
         break;
 
-      QgsGeometry tmpGeom( featB.geometry() );
+      const auto featB = featuresB.constFind( id );
+      if ( featB == featuresB.constEnd() )
+        continue;
+
+      QgsGeometry tmpGeom( featB->geometry() );
       if ( !engine->intersects( tmpGeom.constGet() ) )
         continue;
 
@@ -244,18 +390,16 @@ void QgsOverlayUtils::intersection( const QgsFeatureSource &sourceA, const QgsFe
       if ( !sanitizeIntersectionResult( intGeom, geometryType ) )
         continue;
 
-      const QgsAttributes attrsB( featB.attributes() );
+      const QgsAttributes attrsB( featB->attributes() );
       for ( int i = 0; i < fieldIndicesB.count(); ++i )
         outAttributes[fieldIndicesA.count() + i] = attrsB[fieldIndicesB[i]];
 
+      QgsFeature outFeat;
       outFeat.setGeometry( intGeom );
       outFeat.setAttributes( outAttributes );
-      sink.addFeature( outFeat, QgsFeatureSink::FastInsert );
+      item.outputs << outFeat;
     }
-
-    ++count;
-    feedback->setProgress( count / ( double ) totalCount * 100. );
-  }
+  } );
 }
 
 void QgsOverlayUtils::resolveOverlaps( const QgsFeatureSource &source, QgsFeatureSink &sink, QgsProcessingFeedback *feedback )
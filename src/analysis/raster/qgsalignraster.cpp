@@ -20,8 +20,17 @@
 #include <cpl_conv.h>
 #include <limits>
 
+#include <QMutex>
+#include <QMutexLocker>
 #include <QPair>
 #include <QString>
+#include <QThread>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+#include <vector>
 
 #include "qgscoordinatereferencesystem.h"
 #include "qgsrectangle.h"
@@ -71,6 +80,41 @@ static int CPL_STDCALL _progress( double dfComplete, const char *pszMessage, voi
     return true;
 }
 
+///@cond PRIVATE
+
+//! Progress of the rasters aligned concurrently by QgsAlignRaster::run()
+struct QgsAlignRasterProgress
+{
+  QMutex mutex;
+  //! Woken whenever the progress of a raster changes
+  QWaitCondition changed;
+  bool canceled = false;
+};
+
+//! A raster aligned by QgsAlignRaster::run(), with its progress
+struct QgsAlignRasterWarp
+{
+  const QgsAlignRaster::Item *raster;
+  QgsAlignRasterProgress *state;
+  double progress;
+  bool success;
+  QString errorMessage;
+};
+
+static int CPL_STDCALL _concurrentProgress( double dfComplete, const char *pszMessage, void *pProgressArg )
+{
+  Q_UNUSED( pszMessage )
+
+  // called from the warping threads, the progress handler is called from the thread running the alignment
+  QgsAlignRasterWarp *warp = static_cast< QgsAlignRasterWarp * >( pProgressArg );
+  QMutexLocker locker( &warp->state->mutex );
+  warp->progress = dfComplete;
+  warp->state->changed.wakeAll();
+  return !warp->state->canceled;
+}
+
+///@endcond
+
 
 static CPLErr rescalePreWarpChunkProcessor( void *pKern, void *pArg )
 {
@@ -363,11 +407,72 @@ bool QgsAlignRaster::run()
 
   //dump();
 
-  const auto constMRasters = mRasters;
-  for ( const Item &r : constMRasters )
+  if ( mRasters.isEmpty() )
+    return true;
+
+  // the rasters are aligned concurrently, each from its own datasets, and share the threads left for warping
+  const int concurrentRasters = std::max( 1, std::min( mRasters.size(), QThreadPool::globalInstance()->maxThreadCount() ) );
+  const int threadCount = std::max( 1, QThread::idealThreadCount() / concurrentRasters );
+
+  QgsAlignRasterProgress state;
+  std::vector< QgsAlignRasterWarp > warps;
+  warps.reserve( mRasters.size() );
+  for ( const Item &raster : qgis::as_const( mRasters ) )
+    warps.push_back( { &raster, &state, 0.0, false, QString() } );
+
+  auto warp = [this, threadCount]( QgsAlignRasterWarp & w )
+  {
+    w.success = warpRaster( *w.raster, _concurrentProgress, &w, threadCount, w.errorMessage );
+    QMutexLocker locker( &w.state->mutex );
+    w.progress = 1;
+    // the other rasters are not aligned if one fails
+    w.state->canceled = w.state->canceled || !w.success;
+    w.state->changed.wakeAll();
+  };
+  QFuture< void > future = QtConcurrent::map( warps, warp );
+
+  bool canceled = false;
+  QMutexLocker locker( &state.mutex );
+  while ( !future.isFinished() )
+  {
+    // the worker which finishes last may not wake us after isFinished() was checked
+    state.changed.wait( &state.mutex, 100 );
+    if ( !mProgressHandler )
+      continue;
+
+    double complete = 0;
+    for ( const QgsAlignRasterWarp &w : warps )
+      complete += w.progress;
+    locker.unlock();
+    const bool proceed = mProgressHandler->progress( complete / warps.size() );
+    locker.relock();
+    if ( !proceed )
+    {
+      canceled = true;
+      state.canceled = true;
+    }
+  }
+  locker.unlock();
+  future.waitForFinished();
+
+  // the alignment may have finished before any progress was reported
+  if ( mProgressHandler && !canceled )
+    mProgressHandler->progress( 1 );
+
+  if ( canceled )
+  {
+    mErrorMessage = QObject::tr( "Alignment was canceled" );
+    return false;
+  }
+
+  // the first error, in the order of the rasters, is reported
+  for ( const QgsAlignRasterWarp &w : warps )
   {
-    if ( !createAndWarp( r ) )
+    if ( !w.success )
+    {
+      mErrorMessage = w.errorMessage;
       return false;
+    }
   }
   return true;
 }
@@ -419,11 +524,16 @@ int QgsAlignRaster::suggestedReferenceLayer() const
 
 
 bool QgsAlignRaster::createAndWarp( const Item &raster )
+{
+  return warpRaster( raster, _progress, this, 1, mErrorMessage );
+}
+
+bool QgsAlignRaster::warpRaster( const Item &raster, GDALProgressFunc progress, void *progressArg, int threadCount, QString &errorMessage ) const
 {
   GDALDriverH hDriver = GDALGetDriverByName( "GTiff" );
   if ( !hDriver )
   {
-    mErrorMessage = QStringLiteral( "GDALGetDriverByName(GTiff) failed." );
+    errorMessage = QStringLiteral( "GDALGetDriverByName(GTiff) failed." );
     return false;
   }
 
@@ -431,7 +541,7 @@ bool QgsAlignRaster::createAndWarp( const Item &raster )
   gdal::dataset_unique_ptr hSrcDS( GDALOpen( raster.inputFilename.toLocal8Bit().constData(), GA_ReadOnly ) );
   if ( !hSrcDS )
   {
-    mErrorMessage = QObject::tr( "Unable to open input file: %1" ).arg( raster.inputFilename );
+    errorMessage = QObject::tr( "Unable to open input file: %1" ).arg( raster.inputFilename );
     return false;
   }
 
@@ -445,7 +555,7 @@ bool QgsAlignRaster::createAndWarp( const Item &raster )
                                    bandCount, eDT, nullptr ) );
   if ( !hDstDS )
   {
-    mErrorMessage = QObject::tr( "Unable to create output file: %1" ).arg( raster.outputFilename );
+    errorMessage = QObject::tr( "Unable to create output file: %1" ).arg( raster.outputFilename );
     return false;
   }
 
@@ -477,8 +587,11 @@ bool QgsAlignRaster::createAndWarp( const Item &raster )
   psWarpOptions->eResampleAlg = static_cast< GDALResampleAlg >( raster.resampleMethod );
 
   // our progress function
-  psWarpOptions->pfnProgress = _progress;
-  psWarpOptions->pProgressArg = this;
+  psWarpOptions->pfnProgress = progress;
+  psWarpOptions->pProgressArg = progressArg;
+
+  if ( threadCount > 1 )
+    psWarpOptions->papszWarpOptions = CSLSetNameValue( psWarpOptions->papszWarpOptions, "NUM_THREADS", QByteArray::number( threadCount ).constData() );
 
   // Establish reprojection transformer.
   psWarpOptions->pTransformerArg =
@@ -500,12 +613,24 @@ bool QgsAlignRaster::createAndWarp( const Item &raster )
     psWarpOptions->eWorkingDataType = GDT_Float32;
   }
 
-  // Initialize and execute the warp operation.
+  // Initialize and execute the warp operation, the chunks are read and written while the
+  // previous ones are warped if running multi-threaded
   GDALWarpOperation oOperation;
   oOperation.Initialize( psWarpOptions.get() );
-  oOperation.ChunkAndWarpImage( 0, 0, mXSize, mYSize );
+  CPLErr eErr = CE_None;
+  if ( threadCount > 1 )
+    eErr = oOperation.ChunkAndWarpMulti( 0, 0, mXSize, mYSize );
+  else
+    eErr = oOperation.ChunkAndWarpImage( 0, 0, mXSize, mYSize );
 
   GDALDestroyGenImgProjTransformer( psWarpOptions->pTransformerArg );
+
+  // also when the progress function returned FALSE
+  if ( eErr != CE_None )
+  {
+    errorMessage = QObject::tr( "Unable to warp input file: %1" ).arg( raster.inputFilename );
+    return false;
+  }
   return true;
 }
 
@@ -250,6 +250,11 @@ class ANALYSIS_EXPORT QgsAlignRaster
 
     /**
      * Run the alignment process
+     *
+     * The rasters are aligned concurrently, each of them warped with several threads. The
+     * progress handler is called from the thread calling run(), with the overall progress
+     * of the alignment, and cancels it when returning FALSE.
+     *
      * \returns TRUE on success, sets error on error (see errorMessage())
      */
     bool run();
@@ -310,6 +315,16 @@ class ANALYSIS_EXPORT QgsAlignRaster
     //! Computed raster grid height
     int mYSize;
 
+  private:
+
+    /**
+     * Creates the output of \a raster and warps it, reporting progress to \a progress with \a progressArg.
+     * If \a threadCount is greater than 1, the warping computation uses that many threads and overlaps
+     * with the reading and writing of the chunks. Sets \a errorMessage and returns FALSE on error or
+     * cancellation.
+     */
+    bool warpRaster( const Item &raster, GDALProgressFunc progress, void *progressArg, int threadCount, QString &errorMessage ) const SIP_SKIP;
+
 };
 
 
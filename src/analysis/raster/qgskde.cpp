@@ -18,6 +18,11 @@
 #include "qgsfeatureiterator.h"
 #include "qgsgeometry.h"
 
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+
 #define NO_DATA -9999
 
 QgsKernelDensityEstimation::QgsKernelDensityEstimation( const QgsKernelDensityEstimation::Parameters &parameters, const QString &outputFile, const QString &outputFormat )
@@ -89,6 +94,12 @@ QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::prepare()
   if ( !createEmptyLayer( driver, mBounds, rows, cols ) )
     return FileCreationError;
 
+  mRows = rows;
+  mColumns = cols;
+  mKernels.clear();
+  mTileKernels.clear();
+  mTileKernels.resize( static_cast< std::size_t >( ( rows + TILE_SIZE - 1 ) / TILE_SIZE ) * ( ( cols + TILE_SIZE - 1 ) / TILE_SIZE ) );
+
   // open the raster in GA_Update mode
   mDatasetH.reset( GDALOpen( mOutputFile.toUtf8().constData(), GA_Update ) );
   if ( !mDatasetH )
@@ -157,59 +168,131 @@ QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::addFeature( const
     }
 
     // calculate the pixel position
-    unsigned int xPosition = ( ( ( *pointIt ).x() - mBounds.xMinimum() ) / mPixelSize ) - buffer;
-    unsigned int yPosition = ( ( ( *pointIt ).y() - mBounds.yMinimum() ) / mPixelSize ) - buffer;
-    unsigned int yPositionIO = ( ( mBounds.yMaximum() - ( *pointIt ).y() ) / mPixelSize ) - buffer;
+    const double xPosition = std::trunc( ( ( *pointIt ).x() - mBounds.xMinimum() ) / mPixelSize - buffer );
+    const double yPosition = std::trunc( ( ( *pointIt ).y() - mBounds.yMinimum() ) / mPixelSize - buffer );
+    const double yPositionIO = std::trunc( ( mBounds.yMaximum() - ( *pointIt ).y() ) / mPixelSize - buffer );
 
-
-    // get the data
-    float *dataBuffer = ( float * ) CPLMalloc( sizeof( float ) * blockSize * blockSize );
-    if ( GDALRasterIO( mRasterBandH, GF_Read, xPosition, yPositionIO, blockSize, blockSize,
-                       dataBuffer, blockSize, blockSize, GDT_Float32, 0, 0 ) != CE_None )
+    // the block of cells of the kernel must be within the raster
+    if ( xPosition < 0 || yPositionIO < 0 || xPosition + blockSize > mColumns || yPositionIO + blockSize > mRows )
     {
       result = RasterIoError;
+      continue;
     }
 
-    for ( int xp = 0; xp < blockSize; xp++ )
+    // the kernel is recorded for each tile it covers, and computed by finalise()
+    Kernel kernel;
+    kernel.x = ( *pointIt ).x();
+    kernel.y = ( *pointIt ).y();
+    kernel.radius = radius;
+    kernel.weight = weight;
+    kernel.column = static_cast< int >( xPosition );
+    kernel.row = static_cast< int >( yPositionIO );
+    kernel.rowFromBottom = static_cast< int >( yPosition );
+    kernel.size = blockSize;
+    const int index = static_cast< int >( mKernels.size() );
+    mKernels.push_back( kernel );
+
+    const int tileColumns = ( mColumns + TILE_SIZE - 1 ) / TILE_SIZE;
+    for ( int tileRow = kernel.row / TILE_SIZE; tileRow <= ( kernel.row + blockSize - 1 ) / TILE_SIZE; ++tileRow )
     {
-      for ( int yp = 0; yp < blockSize; yp++ )
-      {
-        double pixelCentroidX = ( xPosition + xp + 0.5 ) * mPixelSize + mBounds.xMinimum();
-        double pixelCentroidY = ( yPosition + yp + 0.5 ) * mPixelSize + mBounds.yMinimum();
+      for ( int tileColumn = kernel.column / TILE_SIZE; tileColumn <= ( kernel.column + blockSize - 1 ) / TILE_SIZE; ++tileColumn )
+        mTileKernels[ static_cast< std::size_t >( tileRow ) * tileColumns + tileColumn ].push_back( index );
+    }
+  }
 
-        double distance = std::sqrt( std::pow( pixelCentroidX - ( *pointIt ).x(), 2.0 ) + std::pow( pixelCentroidY - ( *pointIt ).y(), 2.0 ) );
+  return result;
+}
 
-        // is pixel outside search bandwidth of feature?
-        if ( distance > radius )
+QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::finalise()
+{
+  struct Tile
+  {
+    int index;
+    int left;
+    int top;
+    int width;
+    int height;
+    std::vector< float > values;
+  };
+
+  // the kernels are added in the order of the features to each cell, as they were added to the raster
+  auto computeTile = [this]( Tile & tile )
+  {
+    tile.values.assign( static_cast< std::size_t >( tile.width ) * tile.height, NO_DATA );
+    for ( int index : mTileKernels[ tile.index ] )
+    {
+      const Kernel &kernel = mKernels[ index ];
+      const int firstRow = std::max( kernel.row, tile.top );
+      const int lastRow = std::min( kernel.row + kernel.size, tile.top + tile.height );
+      const int firstColumn = std::max( kernel.column, tile.left );
+      const int lastColumn = std::min( kernel.column + kernel.size, tile.left + tile.width );
+      for ( int row = firstRow; row < lastRow; ++row )
+      {
+        // the rows of the block are evaluated from the bottom row of the kernel
+        const double pixelCentroidY = ( kernel.rowFromBottom + ( row - kernel.row ) + 0.5 ) * mPixelSize + mBounds.yMinimum();
+        float *line = tile.values.data() + static_cast< std::size_t >( row - tile.top ) * tile.width - tile.left;
+        for ( int column = firstColumn; column < lastColumn; ++column )
         {
-          continue;
+          const double pixelCentroidX = ( column + 0.5 ) * mPixelSize + mBounds.xMinimum();
+          const double distance = std::sqrt( std::pow( pixelCentroidX - kernel.x, 2.0 ) + std::pow( pixelCentroidY - kernel.y, 2.0 ) );
+
+          // is pixel outside search bandwidth of feature?
+          if ( distance > kernel.radius )
+          {
+            continue;
+          }
+
+          const double pixelValue = kernel.weight * calculateKernelValue( distance, kernel.radius, mShape, mOutputValues );
+          if ( line[ column ] == NO_DATA )
+          {
+            line[ column ] = 0;
+          }
+          line[ column ] += pixelValue;
         }
+      }
+    }
+  };
 
-        double pixelValue = weight * calculateKernelValue( distance, radius, mShape, mOutputValues );
-        int pos = xp + blockSize * yp;
-        if ( dataBuffer[ pos ] == NO_DATA )
+  // the tiles are computed in parallel, a batch at a time, and written in order
+  Result result = Success;
+  if ( mRasterBandH )
+  {
+    const int tileColumns = ( mColumns + TILE_SIZE - 1 ) / TILE_SIZE;
+    const int tileCount = static_cast< int >( mTileKernels.size() );
+    const int batchSize = std::max( 1, QThreadPool::globalInstance()->maxThreadCount() );
+    std::vector< Tile > batch;
+    for ( int next = 0; next < tileCount; )
+    {
+      batch.clear();
+      for ( int i = 0; i < batchSize && next < tileCount; ++i, ++next )
+      {
+        Tile tile;
+        tile.index = next;
+        tile.left = ( next % tileColumns ) * TILE_SIZE;
+        tile.top = ( next / tileColumns ) * TILE_SIZE;
+        tile.width = std::min( TILE_SIZE, mColumns - tile.left );
+        tile.height = std::min( TILE_SIZE, mRows - tile.top );
+        batch.push_back( tile );
+      }
+
+      QtConcurrent::blockingMap( batch, computeTile );
+
+      for ( Tile &tile : batch )
+      {
+        if ( GDALRasterIO( mRasterBandH, GF_Write, tile.left, tile.top, tile.width, tile.height,
+                           tile.values.data(), tile.width, tile.height, GDT_Float32, 0, 0 ) != CE_None )
         {
-          dataBuffer[ pos ] = 0;
+          result = RasterIoError;
         }
-        dataBuffer[ pos ] += pixelValue;
       }
     }
-    if ( GDALRasterIO( mRasterBandH, GF_Write, xPosition, yPositionIO, blockSize, blockSize,
-                       dataBuffer, blockSize, blockSize, GDT_Float32, 0, 0 ) != CE_None )
-    {
-      result = RasterIoError;
-    }
-    CPLFree( dataBuffer );
   }
 
-  return result;
-}
-
-QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::finalise()
-{
+  mKernels.clear();
+  mTileKernels.clear();
   mDatasetH.reset();
   mRasterBandH = nullptr;
-  return Success;
+  return result;
 }
 
 int QgsKernelDensityEstimation::radiusSizeInPixels( double radius ) const
@@ -243,21 +326,7 @@ bool QgsKernelDensityEstimation::createEmptyLayer( GDALDriverH driver, const Qgs
   if ( GDALSetRasterNoDataValue( poBand, NO_DATA ) != CE_None )
     return false;
 
-  float *line = static_cast< float * >( CPLMalloc( sizeof( float ) * columns ) );
-  for ( int i = 0; i < columns; i++ )
-  {
-    line[i] = NO_DATA;
-  }
-  // Write the empty raster
-  for ( int i = 0; i < rows ; i++ )
-  {
-    if ( GDALRasterIO( poBand, GF_Write, 0, i, columns, 1, line, columns, 1, GDT_Float32, 0, 0 ) != CE_None )
-    {
-      return false;
-    }
-  }
-
-  CPLFree( line );
+  // the whole raster is written by finalise(), the empty cells with the no data value
   return true;
 }
 
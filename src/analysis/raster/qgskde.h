@@ -20,6 +20,8 @@
 #include "qgsogrutils.h"
 #include <QString>
 
+#include <vector>
+
 // GDAL includes
 #include <gdal.h>
 #include <cpl_string.h>
@@ -129,6 +131,9 @@ class ANALYSIS_EXPORT QgsKernelDensityEstimation
 
     /**
      * Finalises the output file. Must be called after adding all features via addFeature().
+     *
+     * The surface is computed here, by tiles computed in parallel and written to the output file
+     * as soon as they are. addFeature() only records the kernels of the features.
      * \see prepare()
      * \see addFeature()
      */
@@ -171,7 +176,33 @@ class ANALYSIS_EXPORT QgsKernelDensityEstimation
     gdal::dataset_unique_ptr mDatasetH;
     GDALRasterBandH mRasterBandH;
 
-    //! Creates a new raster layer and initializes it to the no data value
+    //! A kernel added to the surface, with the block of cells it covers
+    struct Kernel
+    {
+      double x;
+      double y;
+      double radius;
+      double weight;
+      //! Column of the first cell of the block
+      int column;
+      //! Row (from the top) of the first cell of the block
+      int row;
+      //! Row (from the bottom) from which the centroids of the cells of the block are computed
+      int rowFromBottom;
+      //! Number of cells of each side of the block
+      int size;
+    };
+
+    //! Number of cells of each side of the tiles of the surface computed by finalise()
+    static const int TILE_SIZE = 512;
+
+    int mRows = 0;
+    int mColumns = 0;
+    std::vector< Kernel > mKernels;
+    //! Indexes in mKernels of the kernels covering each tile, by row of tiles
+    std::vector< std::vector< int > > mTileKernels;
+
+    //! Creates a new raster layer, whose no data value is set but whose cells are written by finalise()
     bool createEmptyLayer( GDALDriverH driver, const QgsRectangle &bounds, int rows, int columns ) const;
     int radiusSizeInPixels( double radius ) const;
 
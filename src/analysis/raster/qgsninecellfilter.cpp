@@ -30,7 +30,25 @@
 #include <QFile>
 #include <QDebug>
 #include <QFileInfo>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+#include <algorithm>
 #include <iterator>
+#include <vector>
+
+///@cond PRIVATE
+
+//! Rows of the output of a nine cell filter, with the input rows around them
+struct QgsNineCellFilterTile
+{
+  int firstRow;
+  int rowCount;
+  //! Input rows, from the row above the first row to the row below the last one, with a nodata column on each side
+  std::vector<float> input;
+  std::vector<float> result;
+};
+
+///@endcond
 
 
 
@@ -401,16 +419,37 @@ int QgsNineCellFilter::processRasterCPU( QgsFeedback *feedback )
     return 6;
   }
 
-  //keep only three scanlines in memory at a time, make room for initial and final nodata
-  std::size_t bufferSize( sizeof( float ) * ( xSize + 2 ) );
-  float *scanLine1 = ( float * ) CPLMalloc( bufferSize );
-  float *scanLine2 = ( float * ) CPLMalloc( bufferSize );
-  float *scanLine3 = ( float * ) CPLMalloc( bufferSize );
+  // Tiles of rows are read with a halo of one row above and below, and a column of
+  // nodata on each side, computed in parallel, a batch at a time, and written in order.
+  // Values outside the layer extent (if the 3x3 window is on the border) are sent to
+  // the processing method as (input) nodata values.
+  const int tileRows = qBound( 1, TILE_PIXELS / xSize, ySize );
+  const int batchSize = std::max( 1, QThreadPool::globalInstance()->maxThreadCount() );
+  const std::size_t lineSize = static_cast< std::size_t >( xSize ) + 2;
 
-  float *resultLine = ( float * ) CPLMalloc( sizeof( float ) * xSize );
+  auto processTile = [this, xSize, lineSize]( QgsNineCellFilterTile & tile )
+  {
+    tile.result.resize( static_cast< std::size_t >( xSize ) * tile.rowCount );
+    for ( int row = 0; row < tile.rowCount; ++row )
+    {
+      float *scanLine1 = tile.input.data() + row * lineSize;
+      float *scanLine2 = scanLine1 + lineSize;
+      float *scanLine3 = scanLine2 + lineSize;
+      float *resultLine = tile.result.data() + static_cast< std::size_t >( row ) * xSize;
+      for ( int xIndex = 0; xIndex < xSize ; ++xIndex )
+      {
+        // cells(x, y) x11, x21, x31, x12, x22, x32, x13, x23, x33
+        resultLine[ xIndex ] = processNineCellWindow( &scanLine1[ xIndex ], &scanLine1[ xIndex + 1 ], &scanLine1[ xIndex + 2 ],
+                               &scanLine2[ xIndex ], &scanLine2[ xIndex + 1 ], &scanLine2[ xIndex + 2 ],
+                               &scanLine3[ xIndex ], &scanLine3[ xIndex + 1 ], &scanLine3[ xIndex + 2 ] );
+      }
+    }
+    // the input is released as soon as possible
+    std::vector< float >().swap( tile.input );
+  };
 
-  //values outside the layer extent (if the 3x3 window is on the border) are sent to the processing method as (input) nodata values
-  for ( int yIndex = 0; yIndex < ySize; ++yIndex )
+  std::vector< QgsNineCellFilterTile > batch;
+  for ( int firstRow = 0; firstRow < ySize; )
   {
     if ( feedback && feedback->isCanceled() )
     {
@@ -419,74 +458,42 @@ int QgsNineCellFilter::processRasterCPU( QgsFeedback *feedback )
 
     if ( feedback )
     {
-      feedback->setProgress( 100.0 * static_cast< double >( yIndex ) / ySize );
+      feedback->setProgress( 100.0 * static_cast< double >( firstRow ) / ySize );
     }
 
-    if ( yIndex == 0 )
+    // the dataset handle is not thread-safe, the tiles are read from the calling thread
+    batch.clear();
+    for ( int i = 0; i < batchSize && firstRow < ySize; ++i, firstRow += tileRows )
     {
-      //fill scanline 1 with (input) nodata for the values above the first row and feed scanline2 with the first row
-      for ( int a = 0; a < xSize + 2 ; ++a )
-      {
-        scanLine1[a] = mInputNodataValue;
-      }
-      // Read scanline2
-      if ( GDALRasterIO( rasterBand, GF_Read, 0, 0, xSize, 1, &scanLine2[1], xSize, 1, GDT_Float32, 0, 0 ) != CE_None )
+      QgsNineCellFilterTile tile;
+      tile.firstRow = firstRow;
+      tile.rowCount = std::min( tileRows, ySize - firstRow );
+      tile.input.assign( lineSize * ( tile.rowCount + 2 ), mInputNodataValue );
+
+      // the halo rows above the first row and below the last row stay nodata
+      const int readFirstRow = std::max( 0, firstRow - 1 );
+      const int readLastRow = std::min( ySize - 1, firstRow + tile.rowCount );
+      const int readRowCount = readLastRow - readFirstRow + 1;
+      float *readStart = tile.input.data() + ( readFirstRow - firstRow + 1 ) * lineSize + 1;
+      if ( GDALRasterIO( rasterBand, GF_Read, 0, readFirstRow, xSize, readRowCount, readStart, xSize, readRowCount, GDT_Float32,
+                         0, static_cast< GSpacing >( lineSize * sizeof( float ) ) ) != CE_None )
       {
         QgsDebugMsg( QStringLiteral( "Raster IO Error" ) );
       }
-    }
-    else
-    {
-      //normally fetch only scanLine3 and release scanline 1 if we move forward one row
-      CPLFree( scanLine1 );
-      scanLine1 = scanLine2;
-      scanLine2 = scanLine3;
-      scanLine3 = ( float * ) CPLMalloc( bufferSize );
+      batch.push_back( std::move( tile ) );
     }
 
-    // Read scanline 3
-    if ( yIndex == ySize - 1 ) //fill the row below the bottom with nodata values
-    {
-      for ( int a = 0; a < xSize + 2; ++a )
-      {
-        scanLine3[a] = mInputNodataValue;
-      }
-    }
-    else
+    QtConcurrent::blockingMap( batch, processTile );
+
+    for ( QgsNineCellFilterTile &tile : batch )
     {
-      if ( GDALRasterIO( rasterBand, GF_Read, 0, yIndex + 1, xSize, 1, &scanLine3[1], xSize, 1, GDT_Float32, 0, 0 ) != CE_None )
+      if ( GDALRasterIO( outputRasterBand, GF_Write, 0, tile.firstRow, xSize, tile.rowCount, tile.result.data(), xSize, tile.rowCount, GDT_Float32, 0, 0 ) != CE_None )
       {
         QgsDebugMsg( QStringLiteral( "Raster IO Error" ) );
       }
     }
-    // Set first and last extra columns to nodata
-    scanLine1[0] = scanLine1[xSize + 1] = mInputNodataValue;
-    scanLine2[0] = scanLine2[xSize + 1] = mInputNodataValue;
-    scanLine3[0] = scanLine3[xSize + 1] = mInputNodataValue;
-
-
-
-    // j is the x axis index, skip 0 and last cell that have been filled with nodata
-    for ( int xIndex = 0; xIndex < xSize ; ++xIndex )
-    {
-      // cells(x, y) x11, x21, x31, x12, x22, x32, x13, x23, x33
-      resultLine[ xIndex ] = processNineCellWindow( &scanLine1[ xIndex ], &scanLine1[ xIndex + 1 ], &scanLine1[ xIndex + 2 ],
-                             &scanLine2[ xIndex ], &scanLine2[ xIndex + 1 ], &scanLine2[ xIndex + 2 ],
-                             &scanLine3[ xIndex ], &scanLine3[ xIndex + 1 ], &scanLine3[ xIndex + 2 ] );
-
-    }
-
-    if ( GDALRasterIO( outputRasterBand, GF_Write, 0, yIndex, xSize, 1, resultLine, xSize, 1, GDT_Float32, 0, 0 ) != CE_None )
-    {
-      QgsDebugMsg( QStringLiteral( "Raster IO Error" ) );
-    }
   }
 
-  CPLFree( resultLine );
-  CPLFree( scanLine1 );
-  CPLFree( scanLine2 );
-  CPLFree( scanLine3 );
-
   if ( feedback && feedback->isCanceled() )
   {
     //delete the dataset without closing (because it is faster)
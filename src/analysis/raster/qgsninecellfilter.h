@@ -65,6 +65,9 @@ class ANALYSIS_EXPORT QgsNineCellFilter
      *
      * First index of the input cell is the row, second index is the column
      *
+     * The rows of the raster are processed in parallel threads, so this method must not
+     * modify the filter.
+     *
      * \param x11 surrounding cell top left
      * \param x21 surrounding cell central left
      * \param x31 surrounding cell bottom left
@@ -106,6 +109,9 @@ class ANALYSIS_EXPORT QgsNineCellFilter
      */
     int processRasterCPU( QgsFeedback *feedback = nullptr );
 
+    //! Maximum number of cells of the tiles of rows computed in parallel by processRasterCPU()
+    static const int TILE_PIXELS = 1 << 20;
+
 #ifdef HAVE_OPENCL
 
     /**
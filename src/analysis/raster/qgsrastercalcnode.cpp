@@ -16,6 +16,8 @@
 #include "qgsrasterblock.h"
 #include "qgsrastermatrix.h"
 
+#include <algorithm>
+
 QgsRasterCalcNode::QgsRasterCalcNode( double number )
   : mNumber( number )
 {
@@ -50,6 +52,25 @@ QgsRasterCalcNode::~QgsRasterCalcNode()
   delete mRight;
 }
 
+///@cond PRIVATE
+
+//! Converts the typed values of a raster block to double, and its no data to the result no data value
+struct QgsRasterCalcNodeConversion
+{
+  template <typename T>
+  void operator()( const T *values, qgssize count )
+  {
+    for ( qgssize i = 0; i < count; ++i )
+      data[i] = noData[i] ? nodataValue : static_cast< double >( values[i] );
+  }
+
+  double *data;
+  const char *noData;
+  double nodataValue;
+};
+
+///@endcond
+
 bool QgsRasterCalcNode::calculate( QMap<QString, QgsRasterBlock * > &rasterData, QgsRasterMatrix &result, int row ) const
 {
   //if type is raster ref: return a copy of the corresponding matrix
@@ -66,22 +87,16 @@ bool QgsRasterCalcNode::calculate( QMap<QString, QgsRasterBlock * > &rasterData,
 
     int nRows = ( row >= 0 ? 1 : ( *it )->height() );
     int startRow = ( row >= 0 ? row : 0 );
-    int endRow = startRow + nRows;
     int nCols = ( *it )->width();
     int nEntries = nCols * nRows;
     double *data = new double[nEntries];
 
     //convert input raster values to double, also convert input no data to result no data
-
-    int outRow = 0;
-    bool isNoData = false;
-    for ( int dataRow = startRow; dataRow < endRow ; ++dataRow, ++outRow )
+    const QByteArray noData = ( *it )->noDataMask( startRow, nRows );
+    QgsRasterCalcNodeConversion conversion = { data, noData.constData(), result.nodataValue() };
+    if ( noData.size() != nEntries || !( *it )->apply( conversion, startRow, nRows ) )
     {
-      for ( int dataCol = 0; dataCol < nCols; ++dataCol )
-      {
-        const double value = ( *it )->valueAndNoData( dataRow, dataCol, isNoData );
-        data[ dataCol + nCols * outRow] = isNoData ? result.nodataValue() : value;
-      }
+      std::fill( data, data + nEntries, result.nodataValue() );
     }
     result.setData( nCols, nRows, data, result.nodataValue() );
     return true;
@@ -100,88 +115,9 @@ bool QgsRasterCalcNode::calculate( QMap<QString, QgsRasterBlock * > &rasterData,
       return false;
     }
 
-    switch ( mOperator )
+    if ( !applyOperator( leftMatrix, rightMatrix ) )
     {
-      case opPLUS:
-        leftMatrix.add( rightMatrix );
-        break;
-      case opMINUS:
-        leftMatrix.subtract( rightMatrix );
-        break;
-      case opMUL:
-        leftMatrix.multiply( rightMatrix );
-        break;
-      case opDIV:
-        leftMatrix.divide( rightMatrix );
-        break;
-      case opPOW:
-        leftMatrix.power( rightMatrix );
-        break;
-      case opEQ:
-        leftMatrix.equal( rightMatrix );
-        break;
-      case opNE:
-        leftMatrix.notEqual( rightMatrix );
-        break;
-      case opGT:
-        leftMatrix.greaterThan( rightMatrix );
-        break;
-      case opLT:
-        leftMatrix.lesserThan( rightMatrix );
-        break;
-      case opGE:
-        leftMatrix.greaterEqual( rightMatrix );
-        break;
-      case opLE:
-        leftMatrix.lesserEqual( rightMatrix );
-        break;
-      case opAND:
-        leftMatrix.logicalAnd( rightMatrix );
-        break;
-      case opOR:
-        leftMatrix.logicalOr( rightMatrix );
-        break;
-      case opMIN:
-        leftMatrix.min( rightMatrix );
-        break;
-      case opMAX:
-        leftMatrix.max( rightMatrix );
-        break;
-      case opSQRT:
-        leftMatrix.squareRoot();
-        break;
-      case opSIN:
-        leftMatrix.sinus();
-        break;
-      case opCOS:
-        leftMatrix.cosinus();
-        break;
-      case opTAN:
-        leftMatrix.tangens();
-        break;
-      case opASIN:
-        leftMatrix.asinus();
-        break;
-      case opACOS:
-        leftMatrix.acosinus();
-        break;
-      case opATAN:
-        leftMatrix.atangens();
-        break;
-      case opSIGN:
-        leftMatrix.changeSign();
-        break;
-      case opLOG:
-        leftMatrix.log();
-        break;
-      case opLOG10:
-        leftMatrix.log10();
-        break;
-      case opABS:
-        leftMatrix.absoluteValue();
-        break;
-      default:
-        return false;
+      return false;
     }
     int newNColumns = leftMatrix.nColumns();
     int newNRows = leftMatrix.nRows();
@@ -211,6 +147,153 @@ bool QgsRasterCalcNode::calculate( QMap<QString, QgsRasterBlock * > &rasterData,
   return false;
 }
 
+bool QgsRasterCalcNode::applyOperator( QgsRasterMatrix &left, const QgsRasterMatrix &right ) const
+{
+  switch ( mOperator )
+  {
+    case opPLUS:
+      left.add( right );
+      break;
+    case opMINUS:
+      left.subtract( right );
+      break;
+    case opMUL:
+      left.multiply( right );
+      break;
+    case opDIV:
+      left.divide( right );
+      break;
+    case opPOW:
+      left.power( right );
+      break;
+    case opEQ:
+      left.equal( right );
+      break;
+    case opNE:
+      left.notEqual( right );
+      break;
+    case opGT:
+      left.greaterThan( right );
+      break;
+    case opLT:
+      left.lesserThan( right );
+      break;
+    case opGE:
+      left.greaterEqual( right );
+      break;
+    case opLE:
+      left.lesserEqual( right );
+      break;
+    case opAND:
+      left.logicalAnd( right );
+      break;
+    case opOR:
+      left.logicalOr( right );
+      break;
+    case opMIN:
+      left.min( right );
+      break;
+    case opMAX:
+      left.max( right );
+      break;
+    case opSQRT:
+      left.squareRoot();
+      break;
+    case opSIN:
+      left.sinus();
+      break;
+    case opCOS:
+      left.cosinus();
+      break;
+    case opTAN:
+      left.tangens();
+      break;
+    case opASIN:
+      left.asinus();
+      break;
+    case opACOS:
+      left.acosinus();
+      break;
+    case opATAN:
+      left.atangens();
+      break;
+    case opSIGN:
+      left.changeSign();
+      break;
+    case opLOG:
+      left.log();
+      break;
+    case opLOG10:
+      left.log10();
+      break;
+    case opABS:
+      left.absoluteValue();
+      break;
+    default:
+      return false;
+  }
+  return true;
+}
+
+bool QgsRasterCalcNode::calculateRow( const QMap<QString, QgsRasterBlock * > &rasterData, int row, QgsRasterMatrix &result, std::vector< std::unique_ptr< QgsRasterMatrix > > &buffers, int depth ) const
+{
+  const int nCols = result.nColumns();
+  switch ( mType )
+  {
+    case tRasterRef:
+    {
+      const QgsRasterBlock *block = rasterData.value( mRasterName );
+      if ( !block )
+      {
+        QgsDebugMsg( QStringLiteral( "Error: could not find raster data for \"%1\"" ).arg( mRasterName ) );
+        return false;
+      }
+
+      //convert input raster values to double, also convert input no data to result no data
+      const QByteArray noData = block->noDataMask( row, 1 );
+      QgsRasterCalcNodeConversion conversion = { result.data(), noData.constData(), result.nodataValue() };
+      if ( block->width() != nCols || noData.size() != nCols || !block->apply( conversion, row, 1 ) )
+      {
+        std::fill( result.data(), result.data() + nCols, result.nodataValue() );
+      }
+      return true;
+    }
+
+    case tNumber:
+      std::fill( result.data(), result.data() + nCols, mNumber );
+      return true;
+
+    case tOperator:
+    {
+      if ( !mLeft || !mLeft->calculateRow( rasterData, row, result, buffers, depth ) )
+      {
+        return false;
+      }
+      if ( !mRight )
+      {
+        return applyOperator( result, result );
+      }
+
+      if ( static_cast< int >( buffers.size() ) <= depth )
+        buffers.resize( depth + 1 );
+      if ( !buffers[depth] || buffers[depth]->nColumns() != nCols )
+        buffers[depth].reset( new QgsRasterMatrix( nCols, 1, new double[nCols], result.nodataValue() ) );
+
+      QgsRasterMatrix &right = *buffers[depth];
+      right.setNodataValue( result.nodataValue() );
+      if ( !mRight->calculateRow( rasterData, row, right, buffers, depth + 1 ) )
+      {
+        return false;
+      }
+      return applyOperator( result, right );
+    }
+
+    case tMatrix:
+      break;
+  }
+  return false;
+}
+
 QString QgsRasterCalcNode::toString( bool cStyle ) const
 {
   QString result;
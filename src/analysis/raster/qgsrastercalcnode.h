@@ -25,6 +25,9 @@
 #include <QString>
 #include "qgis_analysis.h"
 
+#include <memory>
+#include <vector>
+
 class QgsRasterBlock;
 class QgsRasterMatrix;
 
@@ -109,6 +112,21 @@ class ANALYSIS_EXPORT QgsRasterCalcNode
      */
     bool calculate( QMap<QString, QgsRasterBlock * > &rasterData, QgsRasterMatrix &result, int row = -1 ) const SIP_SKIP;
 
+#ifndef SIP_RUN
+
+    /**
+     * Calculates the \a row of the blocks of \a rasterData into \a result, a single row matrix of
+     * the width of the blocks. Unlike calculate(), no matrix is allocated for the nodes: the
+     * result is calculated in place in \a result, and the right operands in the matrices of
+     * \a buffers, a stack of row matrices grown as needed and meant to be reused for all the
+     * rows. Expressions with matrix nodes are not supported.
+     * The node tree is not modified, rows can be calculated in parallel with distinct buffers.
+     * \note not available in Python bindings
+     * \since QGIS 3.16
+     */
+    bool calculateRow( const QMap<QString, QgsRasterBlock * > &rasterData, int row, QgsRasterMatrix &result, std::vector< std::unique_ptr< QgsRasterMatrix > > &buffers, int depth = 0 ) const;
+#endif
+
     /**
      * Returns a string representation of the expression
      * \param cStyle if TRUE operators will follow C syntax
@@ -129,6 +147,9 @@ class ANALYSIS_EXPORT QgsRasterCalcNode
     QgsRasterCalcNode( const QgsRasterCalcNode &rh );
 #endif
 
+    //! Applies the operator of the node to \a left, with \a right as second operand for the binary operators
+    bool applyOperator( QgsRasterMatrix &left, const QgsRasterMatrix &right ) const;
+
     Type mType = tNumber;
     QgsRasterCalcNode *mLeft = nullptr;
     QgsRasterCalcNode *mRight = nullptr;
@@ -27,6 +27,8 @@
 #include "qgsproject.h"
 
 #include <QFile>
+#include <QThreadPool>
+#include <QtConcurrentMap>
 
 #include <cpl_string.h>
 #include <gdalwarper.h>
@@ -36,6 +38,20 @@
 #include "qgsgdalutils.h"
 #endif
 
+///@cond PRIVATE
+
+//! Rows of the output of a raster calculation, calculated from their own clones of the input providers
+struct QgsRasterCalculatorTile
+{
+  int firstRow;
+  int rowCount;
+  std::map<QString, std::unique_ptr<QgsRasterDataProvider>> providers;
+  std::vector<float> values;
+  bool calculated;
+};
+
+///@endcond
+
 QgsRasterCalculator::QgsRasterCalculator( const QString &formulaString, const QString &outputFile, const QString &outputFormat, const QgsRectangle &outputExtent, int nOutputColumns, int nOutputRows, const QVector<QgsRasterCalculatorEntry> &rasterEntries, const QgsCoordinateTransformContext &transformContext )
   : mFormulaString( formulaString )
   , mOutputFile( outputFile )
@@ -160,93 +176,126 @@ QgsRasterCalculator::Result QgsRasterCalculator::processCalculation( QgsFeedback
   GDALSetRasterNoDataValue( outputRasterBand, outputNodataValue );
 
 
-  // Take the fast route (process one line at a time) if we can
+  // Take the fast route (process tiles of rows in parallel) if we can
   if ( ! requiresMatrix )
   {
-    // Map of raster names -> blocks
-    std::map<QString, std::unique_ptr<QgsRasterBlock>> inputBlocks;
-    std::map<QString, QgsRasterCalculatorEntry> uniqueRasterEntries;
+    // Map of raster names -> entries
+    QMap<QString, QgsRasterCalculatorEntry> uniqueRasterEntries;
     const QList<const QgsRasterCalcNode *> rasterRefNodes = calcNode->findNodes( QgsRasterCalcNode::Type::tRasterRef );
     for ( const QgsRasterCalcNode *r : rasterRefNodes )
     {
       QString layerRef( r->toString().remove( 0, 1 ) );
       layerRef.chop( 1 );
-      if ( ! inputBlocks.count( layerRef ) )
+      if ( ! uniqueRasterEntries.contains( layerRef ) )
       {
         for ( const QgsRasterCalculatorEntry &ref : qgis::as_const( mRasterEntries ) )
         {
           if ( ref.ref == layerRef )
           {
             uniqueRasterEntries[layerRef] = ref;
-            inputBlocks[layerRef ] = qgis::make_unique<QgsRasterBlock>();
           }
         }
       }
     }
 
-    //read / write line by line
-    QMap<QString, QgsRasterBlock * > _rasterData;
-    // Cast to float
-    std::vector<float> castedResult( static_cast<size_t>( mNumOutputColumns ), 0 );
-    auto rowHeight = mOutputRectangle.height() / mNumOutputRows;
-    for ( size_t row = 0; row < static_cast<size_t>( mNumOutputRows ); ++row )
-    {
-      if ( feedback )
-      {
-        feedback->setProgress( 100.0 * static_cast< double >( row ) / mNumOutputRows );
-      }
-
-      if ( feedback && feedback->isCanceled() )
-      {
-        break;
-      }
+    // Tiles of rows are read and calculated in parallel, a batch at a time, and written in order.
+    // Each row is calculated in a single pass over the expression, with row buffers reused
+    // for the intermediate results.
+    const int tileRows = qBound( 1, TILE_PIXELS / std::max( 1, mNumOutputColumns ), mNumOutputRows );
+    const int batchSize = std::max( 1, QThreadPool::globalInstance()->maxThreadCount() );
+    const double rowHeight = mOutputRectangle.height() / mNumOutputRows;
+    const QgsRasterCalcNode *node = calcNode.get();
 
-      // Calculates the rect for a single row read
+    auto calculateTile = [ &, node ]( QgsRasterCalculatorTile & tile )
+    {
       QgsRectangle rect( mOutputRectangle );
-      rect.setYMaximum( rect.yMaximum() - rowHeight * row );
-      rect.setYMinimum( rect.yMaximum() - rowHeight );
+      rect.setYMaximum( mOutputRectangle.yMaximum() - rowHeight * tile.firstRow );
+      rect.setYMinimum( rect.yMaximum() - rowHeight * tile.rowCount );
 
-      // Read rows into input blocks
-      for ( auto &layerRef : inputBlocks )
+      // Read the tile of the input blocks
+      std::map<QString, std::unique_ptr<QgsRasterBlock>> inputBlocks;
+      QMap<QString, QgsRasterBlock * > rasterData;
+      for ( auto it = tile.providers.begin(); it != tile.providers.end(); ++it )
       {
-        QgsRasterCalculatorEntry ref = uniqueRasterEntries[layerRef.first];
+        const QgsRasterCalculatorEntry ref = uniqueRasterEntries.value( it->first );
+        std::unique_ptr<QgsRasterBlock> block;
         if ( ref.raster->crs() != mOutputCrs )
         {
           QgsRasterProjector proj;
           proj.setCrs( ref.raster->crs(), mOutputCrs, mTransformContext );
-          proj.setInput( ref.raster->dataProvider() );
+          proj.setInput( it->second.get() );
           proj.setPrecision( QgsRasterProjector::Exact );
-          layerRef.second.reset( proj.block( ref.bandNumber, rect, mNumOutputColumns, 1 ) );
+          block.reset( proj.block( ref.bandNumber, rect, mNumOutputColumns, tile.rowCount ) );
         }
         else
         {
-          layerRef.second.reset( ref.raster->dataProvider()->block( ref.bandNumber, rect, mNumOutputColumns, 1 ) );
+          block.reset( it->second->block( ref.bandNumber, rect, mNumOutputColumns, tile.rowCount ) );
         }
+        rasterData.insert( it->first, block.get() );
+        inputBlocks[it->first] = std::move( block );
       }
 
       // 1 row X mNumOutputColumns matrix
-      QgsRasterMatrix resultMatrix( mNumOutputColumns, 1, nullptr, outputNodataValue );
+      QgsRasterMatrix resultMatrix( mNumOutputColumns, 1, new double[ static_cast<size_t>( mNumOutputColumns ) ], outputNodataValue );
+      std::vector< std::unique_ptr< QgsRasterMatrix > > buffers;
+      tile.values.resize( static_cast<size_t>( mNumOutputColumns ) * tile.rowCount );
+      tile.calculated = true;
+      for ( int row = 0; row < tile.rowCount; ++row )
+      {
+        if ( !node->calculateRow( rasterData, row, resultMatrix, buffers ) )
+        {
+          tile.calculated = false;
+          return;
+        }
+        // Cast to float
+        std::copy( resultMatrix.data(), resultMatrix.data() + mNumOutputColumns, tile.values.begin() + static_cast<size_t>( row ) * mNumOutputColumns );
+      }
+      // the providers are released as soon as possible
+      tile.providers.clear();
+    };
 
-      _rasterData.clear();
-      for ( const auto &layerRef : inputBlocks )
+    std::vector< QgsRasterCalculatorTile > batch;
+    for ( int firstRow = 0; firstRow < mNumOutputRows; )
+    {
+      if ( feedback )
+      {
+        feedback->setProgress( 100.0 * static_cast< double >( firstRow ) / mNumOutputRows );
+      }
+
+      if ( feedback && feedback->isCanceled() )
       {
-        _rasterData.insert( layerRef.first, layerRef.second.get() );
+        break;
       }
 
-      if ( calcNode->calculate( _rasterData, resultMatrix, 0 ) )
+      // the providers are not thread-safe, each tile reads from its own clones
+      batch.clear();
+      for ( int i = 0; i < batchSize && firstRow < mNumOutputRows; ++i, firstRow += tileRows )
       {
-        std::copy( resultMatrix.data(), resultMatrix.data() + mNumOutputColumns, castedResult.begin() );
-        if ( GDALRasterIO( outputRasterBand, GF_Write, 0, row, mNumOutputColumns, 1, castedResult.data(), mNumOutputColumns, 1, GDT_Float32, 0, 0 ) != CE_None )
+        QgsRasterCalculatorTile tile;
+        tile.firstRow = firstRow;
+        tile.rowCount = std::min( tileRows, mNumOutputRows - firstRow );
+        tile.calculated = false;
+        for ( auto it = uniqueRasterEntries.constBegin(); it != uniqueRasterEntries.constEnd(); ++it )
+          tile.providers[it.key()].reset( it.value().raster->dataProvider()->clone() );
+        batch.push_back( std::move( tile ) );
+      }
+
+      QtConcurrent::blockingMap( batch, calculateTile );
+
+      for ( const QgsRasterCalculatorTile &tile : batch )
+      {
+        if ( !tile.calculated )
+        {
+          //delete the dataset without closing (because it is faster)
+          gdal::fast_delete_and_close( outputDataset, outputDriver, mOutputFile );
+          return CalculationError;
+        }
+
+        if ( GDALRasterIO( outputRasterBand, GF_Write, 0, tile.firstRow, mNumOutputColumns, tile.rowCount, const_cast< float * >( tile.values.data() ), mNumOutputColumns, tile.rowCount, GDT_Float32, 0, 0 ) != CE_None )
         {
           QgsDebugMsg( QStringLiteral( "RasterIO error!" ) );
         }
       }
-      else
-      {
-        //delete the dataset without closing (because it is faster)
-        gdal::fast_delete_and_close( outputDataset, outputDriver, mOutputFile );
-        return CalculationError;
-      }
     }
 
     if ( feedback )
@@ -199,6 +199,9 @@ class ANALYSIS_EXPORT QgsRasterCalculator
     //! Execute calculations on GPU
     Result processCalculationGPU( std::unique_ptr< QgsRasterCalcNode > calcNode, QgsFeedback *feedback = nullptr );
 
+    //! Number of pixels of the tiles of rows calculated in parallel
+    static const int TILE_PIXELS = 1 << 20;
+
     QString mFormulaString;
     QString mOutputFile;
     QString mOutputFormat;
@@ -36,6 +36,24 @@ QgsFeaturePool::QgsFeaturePool( QgsVectorLayer *layer )
 
 }
 
+// approximate size of a feature in memory, used as its cost in the cache
+static int featureCost( const QgsFeature &feature )
+{
+  int cost = sizeof( QgsFeature );
+  if ( const QgsAbstractGeometry *geometry = feature.geometry().constGet() )
+    cost += geometry->nCoordinates() * ( 2 + geometry->is3D() + geometry->isMeasure() ) * sizeof( double );
+  const QgsAttributes attributes = feature.attributes();
+  for ( const QVariant &attribute : attributes )
+  {
+    cost += sizeof( QVariant );
+    if ( attribute.type() == QVariant::String )
+      cost += attribute.toString().size() * sizeof( QChar );
+    else if ( attribute.type() == QVariant::ByteArray )
+      cost += attribute.toByteArray().size();
+  }
+  return cost;
+}
+
 bool QgsFeaturePool::getFeature( QgsFeatureId id, QgsFeature &feature )
 {
   // Why is there a write lock acquired here? Weird, we only want to read a feature from the cache, right?
@@ -52,22 +70,50 @@ bool QgsFeaturePool::getFeature( QgsFeatureId id, QgsFeature &feature )
   {
     //feature was cached
     feature = *cachedFeature;
+    return true;
   }
-  else
+
+  // Feature not in cache, retrieve from layer. Only a read lock is held during the fetch,
+  // so that the other checks can still query the spatial index.
+  // TODO: avoid always querying all attributes (attribute values are needed when merging by attribute)
+  locker.changeMode( QgsReadWriteLocker::Read );
+  if ( !mFeatureSource->getFeatures( QgsFeatureRequest( id ) ).nextFeature( feature ) )
   {
-    // Feature not in cache, retrieve from layer
-    // TODO: avoid always querying all attributes (attribute values are needed when merging by attribute)
-    if ( !mFeatureSource->getFeatures( QgsFeatureRequest( id ) ).nextFeature( feature ) )
-    {
-      return false;
-    }
-    locker.changeMode( QgsReadWriteLocker::Write );
-    mFeatureCache.insert( id, new QgsFeature( feature ) );
-    mIndex.addFeature( feature );
+    return false;
   }
+  locker.changeMode( QgsReadWriteLocker::Write );
+  // the feature may have been fetched by another thread while the lock was released
+  if ( !mFeatureCache.contains( id ) )
+    cacheFeature( feature );
   return true;
 }
 
+void QgsFeaturePool::prefetchFeatures( const QgsFeatureIds &ids )
+{
+  QgsReadWriteLocker locker( mCacheLock, QgsReadWriteLocker::Read );
+  QgsFeatureIds missingIds;
+  for ( QgsFeatureId id : ids )
+  {
+    if ( !mFeatureCache.contains( id ) )
+      missingIds << id;
+  }
+  if ( missingIds.isEmpty() )
+    return;
+
+  QgsFeatureList features;
+  QgsFeatureIterator it = mFeatureSource->getFeatures( QgsFeatureRequest( missingIds ) );
+  QgsFeature feature;
+  while ( it.nextFeature( feature ) )
+    features << feature;
+
+  locker.changeMode( QgsReadWriteLocker::Write );
+  for ( const QgsFeature &fetchedFeature : qgis::as_const( features ) )
+  {
+    if ( !mFeatureCache.contains( fetchedFeature.id() ) )
+      cacheFeature( fetchedFeature );
+  }
+}
+
 QgsFeatureIds QgsFeaturePool::getFeatures( const QgsFeatureRequest &request, QgsFeedback *feedback )
 {
   QgsReadWriteLocker( mCacheLock, QgsReadWriteLocker::Write );
@@ -121,7 +167,12 @@ void QgsFeaturePool::insertFeature( const QgsFeature &feature, bool skipLock )
   QgsReadWriteLocker locker( mCacheLock, QgsReadWriteLocker::Unlocked );
   if ( !skipLock )
     locker.changeMode( QgsReadWriteLocker::Write );
-  mFeatureCache.insert( feature.id(), new QgsFeature( feature ) );
+  cacheFeature( feature );
+}
+
+void QgsFeaturePool::cacheFeature( const QgsFeature &feature )
+{
+  mFeatureCache.insert( feature.id(), new QgsFeature( feature ), featureCost( feature ) );
   QgsFeature indexFeature( feature );
   mIndex.addFeature( indexFeature );
 }
@@ -64,6 +64,16 @@ class ANALYSIS_EXPORT QgsFeaturePool : public QgsFeatureSink SIP_ABSTRACT
      */
     QgsFeatureIds getFeatures( const QgsFeatureRequest &request, QgsFeedback *feedback = nullptr ) SIP_SKIP;
 
+    /**
+     * Fetches the features with the specified \a ids which are not cached yet with a single
+     * request to the underlying feature source, and inserts them in the cache.
+     * This is used to avoid fetching the features of a neighbourhood one by one with getFeature().
+     *
+     * \note not available in Python bindings
+     * \since QGIS 3.16
+     */
+    void prefetchFeatures( const QgsFeatureIds &ids ) SIP_SKIP;
+
     /**
      * Updates a feature in this pool.
      * Implementations will update the feature on the layer or on the data provider.
@@ -176,7 +186,11 @@ class ANALYSIS_EXPORT QgsFeaturePool : public QgsFeatureSink SIP_ABSTRACT
     {}
 #endif
 
-    static const int CACHE_SIZE = 1000;
+    //! Inserts \a feature in the cache and the spatial index, the cache lock must be locked for write
+    void cacheFeature( const QgsFeature &feature );
+
+    //! Maximum size of the cached features, in bytes
+    static const int CACHE_SIZE = 64 * 1024 * 1024;
     QCache<QgsFeatureId, QgsFeature> mFeatureCache;
     QPointer<QgsVectorLayer> mLayer;
     mutable QReadWriteLock mCacheLock;
@@ -28,6 +28,8 @@
 #include "qgsfeedback.h"
 
 #include <qmath.h>
+#include <QThreadPool>
+#include <QtConcurrentMap>
 
 QgsGeometryCheckerUtils::LayerFeature::LayerFeature( const QgsFeaturePool *pool,
     const QgsFeature &feature,
@@ -89,6 +91,9 @@ bool QgsGeometryCheckerUtils::LayerFeature::operator!=( const LayerFeature &othe
 
 /////////////////////////////////////////////////////////////////////////////
 
+// number of features fetched at once by the iterator of LayerFeatures
+static const int PREFETCH_SIZE = 500;
+
 QgsGeometryCheckerUtils::LayerFeatures::iterator::iterator( const QStringList::const_iterator &layerIt, const LayerFeatures *parent )
   : mLayerIt( layerIt )
   , mFeatureIt( QgsFeatureIds::const_iterator() )
@@ -101,6 +106,7 @@ QgsGeometryCheckerUtils::LayerFeatures::iterator::iterator( const QgsGeometryChe
 {
   mLayerIt = rh.mLayerIt;
   mFeatureIt = rh.mFeatureIt;
+  mPrefetchedCount = rh.mPrefetchedCount;
   mParent = rh.mParent;
   mCurrentFeature = qgis::make_unique<LayerFeature>( *rh.mCurrentFeature.get() );
 }
@@ -171,6 +177,7 @@ bool QgsGeometryCheckerUtils::LayerFeatures::iterator::nextLayer( bool begin )
     if ( mParent->mGeometryTypes.contains( mParent->mFeaturePools[*mLayerIt]->geometryType() ) )
     {
       mFeatureIt = mParent->mFeatureIds[*mLayerIt].constBegin();
+      mPrefetchedCount = 0;
       return true;
     }
     ++mLayerIt;
@@ -194,6 +201,16 @@ bool QgsGeometryCheckerUtils::LayerFeatures::iterator::nextFeature( bool begin )
     }
     if ( mParent->mFeedback )
       mParent->mFeedback->setProgress( mParent->mFeedback->progress() + 1.0 );
+    if ( mPrefetchedCount == 0 )
+    {
+      // fetch the next features with a single request rather than one by one
+      QgsFeatureIds prefetchIds;
+      for ( auto it = mFeatureIt; it != featureIds.end() && prefetchIds.size() < PREFETCH_SIZE; ++it )
+        prefetchIds << *it;
+      featurePool->prefetchFeatures( prefetchIds );
+      mPrefetchedCount = prefetchIds.size();
+    }
+    mPrefetchedCount--;
     QgsFeature feature;
     if ( featurePool->getFeature( *mFeatureIt, feature ) && !feature.geometry().isNull() )
     {
@@ -265,6 +282,37 @@ std::unique_ptr<QgsGeometryEngine> QgsGeometryCheckerUtils::createGeomEngine( co
   return qgis::make_unique<QgsGeos>( geometry, tolerance );
 }
 
+//! Number of consecutive indexes processed by each task of runInParallel()
+static const int INDEXES_PER_TASK = 64;
+
+void QgsGeometryCheckerUtils::runInParallel( int count, const std::function<void ( int )> &function, QgsFeedback *feedback )
+{
+  if ( QThreadPool::globalInstance()->maxThreadCount() <= 1 || count <= INDEXES_PER_TASK )
+  {
+    for ( int i = 0; i < count && !( feedback && feedback->isCanceled() ); ++i )
+      function( i );
+    return;
+  }
+
+  // small tasks even out the load, the cost of checking a feature varies a lot
+  QVector< int > firstIndexes;
+  firstIndexes.reserve( count / INDEXES_PER_TASK + 1 );
+  for ( int first = 0; first < count; first += INDEXES_PER_TASK )
+    firstIndexes << first;
+
+  QtConcurrent::blockingMap( firstIndexes, [count, &function, feedback]( int first )
+  {
+    const int last = std::min( count, first + INDEXES_PER_TASK );
+    for ( int i = first; i < last && !( feedback && feedback->isCanceled() ); ++i )
+      function( i );
+  } );
+}
+
+int QgsGeometryCheckerUtils::parallelBatchSize()
+{
+  return 4 * INDEXES_PER_TASK * std::max( 1, QThreadPool::globalInstance()->maxThreadCount() );
+}
+
 QgsAbstractGeometry *QgsGeometryCheckerUtils::getGeomPart( QgsAbstractGeometry *geom, int partIdx )
 {
   if ( dynamic_cast<QgsGeometryCollection *>( geom ) )
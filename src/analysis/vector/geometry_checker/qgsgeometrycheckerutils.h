@@ -23,6 +23,7 @@
 #include "geometry/qgspoint.h"
 #include "qgsgeometrycheckcontext.h"
 #include <qmath.h>
+#include <functional>
 
 class QgsGeometryEngine;
 class QgsFeaturePool;
@@ -178,6 +179,7 @@ class ANALYSIS_EXPORT QgsGeometryCheckerUtils
             bool nextFeature( bool begin );
             QList<QString>::const_iterator mLayerIt;
             QgsFeatureIds::const_iterator mFeatureIt;
+            int mPrefetchedCount = 0;
             const LayerFeatures *mParent = nullptr;
             std::unique_ptr<QgsGeometryCheckerUtils::LayerFeature> mCurrentFeature;
 
@@ -214,6 +216,26 @@ class ANALYSIS_EXPORT QgsGeometryCheckerUtils
 
     static std::unique_ptr<QgsGeometryEngine> createGeomEngine( const QgsAbstractGeometry *geometry, double tolerance );
 
+    /**
+     * Calls \a function for each index from 0 to \a count - 1, in chunks spread over the global
+     * thread pool, and returns once all the calls have finished. The remaining calls are skipped
+     * once \a feedback is canceled.
+     *
+     * The \a function must be safe to call from several threads at once.
+     *
+     * \see parallelBatchSize()
+     * \since QGIS 3.16
+     */
+    static void runInParallel( int count, const std::function< void( int index ) > &function, QgsFeedback *feedback = nullptr );
+
+    /**
+     * Returns the number of features a check should fetch before processing them with runInParallel(),
+     * enough to keep all the threads of the global thread pool busy.
+     *
+     * \since QGIS 3.16
+     */
+    static int parallelBatchSize();
+
     static QgsAbstractGeometry *getGeomPart( QgsAbstractGeometry *geom, int partIdx );
     static const QgsAbstractGeometry *getGeomPart( const QgsAbstractGeometry *geom, int partIdx );
 
@@ -34,6 +34,29 @@ void QgsGeometryOverlapCheck::collectErrors( const QMap<QString, QgsFeaturePool
   QMap<QString, QgsFeatureIds> featureIds = ids.isEmpty() ? allLayerFeatureIds( featurePools ) : ids.toMap();
   const QgsGeometryCheckerUtils::LayerFeatures layerFeaturesA( featurePools, featureIds, compatibleGeometryTypes(), feedback, mContext, true );
   QList<QString> layerIds = featureIds.keys();
+
+  // the features are fetched in batches on this thread, then each of them is compared in parallel
+  // with the features looked up in the spatial index of the pools, and the errors are kept in order
+  const int batchSize = QgsGeometryCheckerUtils::parallelBatchSize();
+  QList<QgsGeometryCheckerUtils::LayerFeature> batch;
+  QList<QList<QString>> batchLayerIds;
+  auto processBatch = [this, &featurePools, &batch, &batchLayerIds, &errors, &messages, feedback]()
+  {
+    std::vector< QList<QgsGeometryCheckError *> > batchErrors( batch.size() );
+    std::vector< QStringList > batchMessages( batch.size() );
+    QgsGeometryCheckerUtils::runInParallel( batch.size(), [this, &featurePools, &batch, &batchLayerIds, &batchErrors, &batchMessages, feedback]( int i )
+    {
+      collectFeatureErrors( featurePools, batch.at( i ), batchLayerIds.at( i ), batchErrors[i], batchMessages[i], feedback );
+    }, feedback );
+    for ( int i = 0; i < batch.size(); ++i )
+    {
+      errors.append( batchErrors[i] );
+      messages.append( batchMessages[i] );
+    }
+    batch.clear();
+    batchLayerIds.clear();
+  };
+
   for ( const QgsGeometryCheckerUtils::LayerFeature &layerFeatureA : layerFeaturesA )
   {
     if ( feedback && feedback->isCanceled() )
@@ -42,51 +65,60 @@ void QgsGeometryOverlapCheck::collectErrors( const QMap<QString, QgsFeaturePool
     // Ensure each pair of layers only gets compared once: remove the current layer from the layerIds, but add it to the layerList for layerFeaturesB
     layerIds.removeOne( layerFeatureA.layer()->id() );
 
-    const QgsGeometry geomA = layerFeatureA.geometry();
-    QgsRectangle bboxA = geomA.boundingBox();
-    std::unique_ptr< QgsGeometryEngine > geomEngineA = QgsGeometryCheckerUtils::createGeomEngine( geomA.constGet(), mContext->tolerance );
-    geomEngineA->prepareGeometry();
-    if ( !geomEngineA->isValid() )
+    batch.append( layerFeatureA );
+    batchLayerIds.append( QList<QString>() << layerFeatureA.layer()->id() << layerIds );
+    if ( batch.size() >= batchSize )
+      processBatch();
+  }
+  processBatch();
+}
+
+void QgsGeometryOverlapCheck::collectFeatureErrors( const QMap<QString, QgsFeaturePool *> &featurePools, const QgsGeometryCheckerUtils::LayerFeature &layerFeatureA, const QList<QString> &layerIdsB, QList<QgsGeometryCheckError *> &errors, QStringList &messages, QgsFeedback *feedback ) const
+{
+  const QgsGeometry geomA = layerFeatureA.geometry();
+  QgsRectangle bboxA = geomA.boundingBox();
+  std::unique_ptr< QgsGeometryEngine > geomEngineA = QgsGeometryCheckerUtils::createGeomEngine( geomA.constGet(), mContext->tolerance );
+  geomEngineA->prepareGeometry();
+  if ( !geomEngineA->isValid() )
+  {
+    messages.append( tr( "Overlap check failed for (%1): the geometry is invalid" ).arg( layerFeatureA.id() ) );
+    return;
+  }
+
+  const QgsGeometryCheckerUtils::LayerFeatures layerFeaturesB( featurePools, layerIdsB, bboxA, compatibleGeometryTypes(), mContext );
+  for ( const QgsGeometryCheckerUtils::LayerFeature &layerFeatureB : layerFeaturesB )
+  {
+    if ( feedback && feedback->isCanceled() )
+      break;
+
+    // > : only report overlaps within same layer once
+    if ( layerFeatureA.layerId() == layerFeatureB.layerId() && layerFeatureB.feature().id() >= layerFeatureA.feature().id() )
     {
-      messages.append( tr( "Overlap check failed for (%1): the geometry is invalid" ).arg( layerFeatureA.id() ) );
       continue;
     }
 
-    const QgsGeometryCheckerUtils::LayerFeatures layerFeaturesB( featurePools, QList<QString>() << layerFeatureA.layer()->id() << layerIds, bboxA, compatibleGeometryTypes(), mContext );
-    for ( const QgsGeometryCheckerUtils::LayerFeature &layerFeatureB : layerFeaturesB )
+    QString errMsg;
+    const QgsGeometry geometryB = layerFeatureB.geometry();
+    const QgsAbstractGeometry *geomB = geometryB.constGet();
+    if ( geomEngineA->overlaps( geomB, &errMsg ) )
     {
-      if ( feedback && feedback->isCanceled() )
-        break;
-
-      // > : only report overlaps within same layer once
-      if ( layerFeatureA.layerId() == layerFeatureB.layerId() && layerFeatureB.feature().id() >= layerFeatureA.feature().id() )
+      std::unique_ptr<QgsAbstractGeometry> interGeom( geomEngineA->intersection( geomB ) );
+      if ( interGeom && !interGeom->isEmpty() )
       {
-        continue;
-      }
-
-      QString errMsg;
-      const QgsGeometry geometryB = layerFeatureB.geometry();
-      const QgsAbstractGeometry *geomB = geometryB.constGet();
-      if ( geomEngineA->overlaps( geomB, &errMsg ) )
-      {
-        std::unique_ptr<QgsAbstractGeometry> interGeom( geomEngineA->intersection( geomB ) );
-        if ( interGeom && !interGeom->isEmpty() )
+        QgsGeometryCheckerUtils::filter1DTypes( interGeom.get() );
+        for ( int iPart = 0, nParts = interGeom->partCount(); iPart < nParts; ++iPart )
         {
-          QgsGeometryCheckerUtils::filter1DTypes( interGeom.get() );
-          for ( int iPart = 0, nParts = interGeom->partCount(); iPart < nParts; ++iPart )
+          QgsAbstractGeometry *interPart = QgsGeometryCheckerUtils::getGeomPart( interGeom.get(), iPart );
+          double area = interPart->area();
+          if ( area > mContext->reducedTolerance && ( area < mOverlapThresholdMapUnits || mOverlapThresholdMapUnits == 0.0 ) )
           {
-            QgsAbstractGeometry *interPart = QgsGeometryCheckerUtils::getGeomPart( interGeom.get(), iPart );
-            double area = interPart->area();
-            if ( area > mContext->reducedTolerance && ( area < mOverlapThresholdMapUnits || mOverlapThresholdMapUnits == 0.0 ) )
-            {
-              errors.append( new QgsGeometryOverlapCheckError( this, layerFeatureA, QgsGeometry( interPart->clone() ), interPart->centroid(), area, layerFeatureB ) );
-            }
+            errors.append( new QgsGeometryOverlapCheckError( this, layerFeatureA, QgsGeometry( interPart->clone() ), interPart->centroid(), area, layerFeatureB ) );
           }
         }
-        else if ( !errMsg.isEmpty() )
-        {
-          messages.append( tr( "Overlap check between features %1 and %2 %3" ).arg( layerFeatureA.id(), layerFeatureB.id(), errMsg ) );
-        }
+      }
+      else if ( !errMsg.isEmpty() )
+      {
+        messages.append( tr( "Overlap check between features %1 and %2 %3" ).arg( layerFeatureA.id(), layerFeatureB.id(), errMsg ) );
       }
     }
   }
@@ -132,6 +132,13 @@ class ANALYSIS_EXPORT QgsGeometryOverlapCheck : public QgsGeometryCheck
 ///@endcond private
 
   private:
+
+    /**
+     * Collects the errors of the overlaps of \a layerFeatureA with the features of the layers \a layerIdsB.
+     * May be called from several threads at once.
+     */
+    void collectFeatureErrors( const QMap<QString, QgsFeaturePool *> &featurePools, const QgsGeometryCheckerUtils::LayerFeature &layerFeatureA, const QList<QString> &layerIdsB, QList<QgsGeometryCheckError *> &errors, QStringList &messages, QgsFeedback *feedback ) const;
+
     const double mOverlapThresholdMapUnits;
 
 };
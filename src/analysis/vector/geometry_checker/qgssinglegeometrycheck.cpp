@@ -17,6 +17,8 @@ email                : matthias@opengis.ch
 #include "qgsgeometrycheckcontext.h"
 #include "qgspoint.h"
 
+#include <vector>
+
 
 
 void QgsSingleGeometryCheck::collectErrors( const QMap<QString, QgsFeaturePool *> &featurePools,
@@ -26,12 +28,33 @@ void QgsSingleGeometryCheck::collectErrors( const QMap<QString, QgsFeaturePool *
   Q_UNUSED( messages )
   QMap<QString, QgsFeatureIds> featureIds = ids.isEmpty() ? allLayerFeatureIds( featurePools ) : ids.toMap();
   QgsGeometryCheckerUtils::LayerFeatures layerFeatures( featurePools, featureIds, compatibleGeometryTypes(), feedback, mContext );
+
+  // the feature pools serialize the reads, so the features are fetched in batches on this
+  // thread, then their geometries are processed in parallel and the errors kept in order
+  const int batchSize = QgsGeometryCheckerUtils::parallelBatchSize();
+  QList<QgsGeometryCheckerUtils::LayerFeature> batch;
+  auto processBatch = [this, &batch, &errors, feedback]()
+  {
+    std::vector< QList<QgsSingleGeometryCheckError *> > batchErrors( batch.size() );
+    QgsGeometryCheckerUtils::runInParallel( batch.size(), [this, &batch, &batchErrors]( int i )
+    {
+      batchErrors[i] = processGeometry( batch.at( i ).geometry() );
+    }, feedback );
+    for ( int i = 0; i < batch.size(); ++i )
+    {
+      for ( QgsSingleGeometryCheckError *error : qgis::as_const( batchErrors[i] ) )
+        errors.append( convertToGeometryCheckError( error, batch.at( i ) ) );
+    }
+    batch.clear();
+  };
+
   for ( const QgsGeometryCheckerUtils::LayerFeature &layerFeature : layerFeatures )
   {
-    const auto singleErrors = processGeometry( layerFeature.geometry() );
-    for ( const auto error : singleErrors )
-      errors.append( convertToGeometryCheckError( error, layerFeature ) );
+    batch.append( layerFeature );
+    if ( batch.size() >= batchSize )
+      processBatch();
   }
+  processBatch();
 }
 
 QgsGeometryCheckErrorSingle *QgsSingleGeometryCheck::convertToGeometryCheckError( QgsSingleGeometryCheckError *singleGeometryCheckError, const QgsGeometryCheckerUtils::LayerFeature &layerFeature ) const
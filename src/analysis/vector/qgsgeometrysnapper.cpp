@@ -15,6 +15,7 @@
  ***************************************************************************/
 
 #include <QtConcurrentMap>
+#include <algorithm>
 #include "qgsfeatureiterator.h"
 #include "qgsgeometry.h"
 #include "qgsvectorlayer.h"
@@ -459,9 +460,32 @@ QgsSnapIndex::SnapItem *QgsSnapIndex::getSnapItem( const QgsPoint &pos, double t
 
 QgsGeometrySnapper::QgsGeometrySnapper( QgsFeatureSource *referenceSource )
   : mReferenceSource( referenceSource )
+  , mIndex( QVector< QgsFeatureId >(), QVector< QgsRectangle >() )
 {
-  // Build spatial index
-  mIndex = QgsSpatialIndex( *mReferenceSource );
+  // Read the reference geometries and build a static spatial index of them, which the snapping
+  // threads can then query at the same time without locking
+  QVector< QgsFeatureId > ids;
+  QVector< QgsRectangle > boundingBoxes;
+  const long count = mReferenceSource->featureCount();
+  if ( count > 0 )
+  {
+    ids.reserve( static_cast< int >( count ) );
+    boundingBoxes.reserve( static_cast< int >( count ) );
+    mReferenceGeometries.reserve( static_cast< int >( count ) );
+  }
+
+  QgsFeature refFeature;
+  QgsFeatureIterator refFeatureIt = mReferenceSource->getFeatures( QgsFeatureRequest().setNoAttributes() );
+  while ( refFeatureIt.nextFeature( refFeature ) )
+  {
+    if ( !refFeature.hasGeometry() )
+      continue;
+
+    ids << refFeature.id();
+    boundingBoxes << refFeature.geometry().boundingBox();
+    mReferenceGeometries.insert( refFeature.id(), refFeature.geometry() );
+  }
+  mIndex = QgsSpatialIndexPackedRTree( ids, boundingBoxes );
 }
 
 QgsFeatureList QgsGeometrySnapper::snapFeatures( const QgsFeatureList &features, double snapTolerance, SnapMode mode )
@@ -481,23 +505,16 @@ void QgsGeometrySnapper::processFeature( QgsFeature &feature, double snapToleran
 QgsGeometry QgsGeometrySnapper::snapGeometry( const QgsGeometry &geometry, double snapTolerance, SnapMode mode ) const
 {
   // Get potential reference features and construct snap index
-  QList<QgsGeometry> refGeometries;
-  mIndexMutex.lock();
   QgsRectangle searchBounds = geometry.boundingBox();
   searchBounds.grow( snapTolerance );
-  QgsFeatureIds refFeatureIds = qgis::listToSet( mIndex.intersects( searchBounds ) );
-  mIndexMutex.unlock();
-
-  QgsFeatureRequest refFeatureRequest = QgsFeatureRequest().setFilterFids( refFeatureIds ).setNoAttributes();
-  mReferenceLayerMutex.lock();
-  QgsFeature refFeature;
-  QgsFeatureIterator refFeatureIt = mReferenceSource->getFeatures( refFeatureRequest );
+  QList< QgsFeatureId > refFeatureIds = mIndex.intersects( searchBounds );
+  // in the order of the ids, so that the result does not depend on the index layout
+  std::sort( refFeatureIds.begin(), refFeatureIds.end() );
 
-  while ( refFeatureIt.nextFeature( refFeature ) )
-  {
-    refGeometries.append( refFeature.geometry() );
-  }
-  mReferenceLayerMutex.unlock();
+  QList<QgsGeometry> refGeometries;
+  refGeometries.reserve( refFeatureIds.size() );
+  for ( QgsFeatureId id : qgis::as_const( refFeatureIds ) )
+    refGeometries.append( mReferenceGeometries.value( id ) );
 
   return snapGeometry( geometry, snapTolerance, refGeometries, mode );
 }
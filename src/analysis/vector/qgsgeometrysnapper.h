@@ -17,10 +17,11 @@
 #ifndef QGS_GEOMETRY_SNAPPER_H
 #define QGS_GEOMETRY_SNAPPER_H
 
-#include <QMutex>
 #include <QFuture>
+#include <QHash>
 #include <QStringList>
 #include "qgsspatialindex.h"
+#include "qgsspatialindexpackedrtree.h"
 #include "qgsabstractgeometry.h"
 #include "qgspoint.h"
 #include "qgsgeometry.h"
@@ -58,6 +59,9 @@ class ANALYSIS_EXPORT QgsGeometrySnapper : public QObject
      * Constructor for QgsGeometrySnapper. A reference feature source which contains geometries to snap to must be
      * set. It is assumed that all geometries snapped using this object will have the
      * same CRS as the reference source (ie, no reprojection is performed).
+     *
+     * The geometries of the reference source are read once and kept in memory, so that snapping does not
+     * need to access the source again.
      */
     QgsGeometrySnapper( QgsFeatureSource *referenceSource );
 
@@ -104,9 +108,9 @@ class ANALYSIS_EXPORT QgsGeometrySnapper : public QObject
     QgsFeatureSource *mReferenceSource = nullptr;
     QgsFeatureList mInputFeatures;
 
-    QgsSpatialIndex mIndex;
-    mutable QMutex mIndexMutex;
-    mutable QMutex mReferenceLayerMutex;
+    //! Static index of the reference geometries, read without locking by the snapping threads
+    QgsSpatialIndexPackedRTree mIndex;
+    QHash< QgsFeatureId, QgsGeometry > mReferenceGeometries;
 
     void processFeature( QgsFeature &feature, double snapTolerance, SnapMode mode );
 
@@ -28,7 +28,161 @@
 #include "qgslogger.h"
 #include "qgsproject.h"
 
+#include "qgscurvepolygon.h"
+#include "qgsgeometryengine.h"
+#include "qgslinestring.h"
+#include "qgsrasterblock.h"
+
 #include <QFile>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <vector>
+
+///@cond PRIVATE
+
+//! An edge of a ring of a zone
+struct QgsZonalStatisticsEdge
+{
+  double x1;
+  double y1;
+  double x2;
+  double y2;
+};
+
+/**
+ * Calls \a addCell with the column and row of the cells from \a left, \a top to \a right, \a bottom (excluded)
+ * of the raster whose center is in \a geometry, by a scanline sweep of the edges of its rings. The cells whose
+ * center is on, or very close to, the boundary of the geometry are tested with the geometry engine, so that the
+ * cells are those of QgsRasterAnalysisUtils::statisticsFromMiddlePointTest().
+ */
+static void sweepZone( const QgsGeometry &geometry, int left, int top, int right, int bottom, const QgsRectangle &rasterBBox,
+                       double cellSizeX, double cellSizeY, const std::function<void( int, int )> &addCell )
+{
+  if ( left >= right || top >= bottom )
+    return;
+
+  // the edges of the rings crossing the centers of the rows
+  const double firstCenterY = rasterBBox.yMaximum() - ( top + 0.5 ) * cellSizeY;
+  const double lastCenterY = rasterBBox.yMaximum() - ( bottom - 0.5 ) * cellSizeY;
+  std::vector< QgsZonalStatisticsEdge > edges;
+  std::vector< double > vertexY;
+  const auto addEdge = [&]( double x1, double y1, double x2, double y2 )
+  {
+    if ( std::max( y1, y2 ) < lastCenterY || std::min( y1, y2 ) > firstCenterY )
+      return;
+    edges.push_back( { x1, y1, x2, y2 } );
+    vertexY.push_back( y1 );
+    vertexY.push_back( y2 );
+  };
+  for ( auto part = geometry.const_parts_begin(); part != geometry.const_parts_end(); ++part )
+  {
+    const QgsCurvePolygon *polygon = qgsgeometry_cast< const QgsCurvePolygon * >( *part );
+    if ( !polygon )
+      continue;
+
+    for ( int ring = 0; ring <= polygon->numInteriorRings(); ++ring )
+    {
+      const QgsCurve *curve = ring == 0 ? polygon->exteriorRing() : polygon->interiorRing( ring - 1 );
+      if ( !curve )
+        continue;
+
+      std::unique_ptr< QgsLineString > segmentized;
+      const QgsLineString *line = qgsgeometry_cast< const QgsLineString * >( curve );
+      if ( !line )
+      {
+        segmentized.reset( curve->curveToLine() );
+        line = segmentized.get();
+      }
+      const int pointCount = line->numPoints();
+      if ( pointCount < 3 )
+        continue;
+
+      const double *x = line->xData();
+      const double *y = line->yData();
+      for ( int i = 0; i < pointCount - 1; ++i )
+        addEdge( x[i], y[i], x[i + 1], y[i + 1] );
+      if ( x[0] != x[pointCount - 1] || y[0] != y[pointCount - 1] )
+        addEdge( x[pointCount - 1], y[pointCount - 1], x[0], y[0] );
+    }
+  }
+  if ( edges.empty() )
+    return;
+  std::sort( vertexY.begin(), vertexY.end() );
+
+  std::unique_ptr< QgsGeometryEngine > engine;
+  const auto contains = [&]( double x, double y )
+  {
+    if ( !engine )
+    {
+      engine.reset( QgsGeometry::createGeometryEngine( geometry.constGet() ) );
+      engine->prepareGeometry();
+    }
+    QgsPoint cellCenter( x, y );
+    return engine->contains( &cellCenter );
+  };
+
+  // the distance to an edge under which the interpolation of the crossings is not accurate enough
+  const double toleranceX = cellSizeX * 1e-6;
+  const double toleranceY = cellSizeY * 1e-6;
+  std::vector< double > crossings;
+  for ( int row = top; row < bottom; ++row )
+  {
+    const double y = rasterBBox.yMaximum() - ( row + 0.5 ) * cellSizeY;
+
+    // rows through vertices, or horizontal edges, are tested with the engine
+    const auto vertex = std::lower_bound( vertexY.begin(), vertexY.end(), y - toleranceY );
+    if ( vertex != vertexY.end() && *vertex <= y + toleranceY )
+    {
+      for ( int column = left; column < right; ++column )
+      {
+        if ( contains( rasterBBox.xMinimum() + ( column + 0.5 ) * cellSizeX, y ) )
+          addCell( column, row );
+      }
+      continue;
+    }
+
+    crossings.clear();
+    for ( const QgsZonalStatisticsEdge &edge : edges )
+    {
+      if ( ( edge.y1 < y ) != ( edge.y2 < y ) )
+        crossings.push_back( edge.x1 + ( y - edge.y1 ) * ( edge.x2 - edge.x1 ) / ( edge.y2 - edge.y1 ) );
+    }
+    std::sort( crossings.begin(), crossings.end() );
+
+    // the centers between pairs of crossings are inside the rings, by the even-odd rule
+    int lastColumn = left - 1;
+    for ( std::size_t i = 0; i + 1 < crossings.size(); i += 2 )
+    {
+      const double spanLeft = crossings[i];
+      const double spanRight = crossings[i + 1];
+      const double firstColumn = std::floor( ( spanLeft - toleranceX - rasterBBox.xMinimum() ) / cellSizeX - 0.5 );
+      const double endColumn = std::ceil( ( spanRight + toleranceX - rasterBBox.xMinimum() ) / cellSizeX - 0.5 );
+      const int first = std::max( lastColumn + 1, static_cast< int >( qBound< double >( left, firstColumn, right ) ) );
+      const int last = static_cast< int >( std::min< double >( right - 1, endColumn ) );
+      for ( int column = first; column <= last; ++column )
+      {
+        const double x = rasterBBox.xMinimum() + ( column + 0.5 ) * cellSizeX;
+        if ( x - spanLeft > toleranceX && spanRight - x > toleranceX )
+          addCell( column, row );
+        else if ( x > spanLeft - toleranceX && x < spanRight + toleranceX )
+        {
+          if ( contains( x, y ) )
+            addCell( column, row );
+        }
+        else
+          continue;
+        lastColumn = column;
+      }
+    }
+  }
+}
+
+///@endcond
 
 QgsZonalStatistics::QgsZonalStatistics( QgsVectorLayer *polygonLayer, QgsRasterLayer *rasterLayer, const QString &attributePrefix, int rasterBand, QgsZonalStatistics::Statistics stats )
   : QgsZonalStatistics( polygonLayer,
@@ -207,7 +361,7 @@ int QgsZonalStatistics::calculateStatistics( QgsFeedback *feedback )
   //progress dialog
   long featureCount = vectorProvider->featureCount();
 
-  //iterate over each polygon
+  //read all the polygons, with the cells of the raster they cover
   QgsFeatureRequest request;
   request.setNoAttributes();
   request.setDestinationCrs( mRasterCrs, QgsProject::instance()->transformContext() );
@@ -220,10 +374,19 @@ int QgsZonalStatistics::calculateStatistics( QgsFeedback *feedback )
   bool statsStoreValueCount = ( mStatistics & QgsZonalStatistics::Minority ) ||
                               ( mStatistics & QgsZonalStatistics::Majority );
 
-  FeatureStats featureStats( statsStoreValues, statsStoreValueCount );
+  struct Zone
+  {
+    QgsFeatureId id;
+    QgsGeometry geometry;
+    int nCellsX;
+    int nCellsY;
+    QgsRectangle rasterBlockExtent;
+    //! First column and row of the cells of the zone
+    int left;
+    int top;
+  };
+  std::vector< Zone > zones;
   int featureCounter = 0;
-
-  QgsChangedAttributesMap changeMap;
   while ( fi.nextFeature( f ) )
   {
     if ( feedback && feedback->isCanceled() )
@@ -231,14 +394,14 @@ int QgsZonalStatistics::calculateStatistics( QgsFeedback *feedback )
       break;
     }
 
-    if ( feedback )
+    if ( feedback && featureCount > 0 && featureCounter % 1000 == 0 )
     {
-      feedback->setProgress( 100.0 * static_cast< double >( featureCounter ) / featureCount );
+      feedback->setProgress( 10.0 * static_cast< double >( featureCounter ) / featureCount );
     }
 
+    ++featureCounter;
     if ( !f.hasGeometry() )
     {
-      ++featureCounter;
       continue;
     }
     QgsGeometry featureGeometry = f.geometry();
@@ -246,24 +409,152 @@ int QgsZonalStatistics::calculateStatistics( QgsFeedback *feedback )
     QgsRectangle featureRect = featureGeometry.boundingBox().intersect( rasterBBox );
     if ( featureRect.isEmpty() )
     {
-      ++featureCounter;
       continue;
     }
 
-    int nCellsX, nCellsY;
-    QgsRectangle rasterBlockExtent;
-    QgsRasterAnalysisUtils::cellInfoForBBox( rasterBBox, featureRect, mCellSizeX, mCellSizeY, nCellsX, nCellsY, nCellsXProvider, nCellsYProvider, rasterBlockExtent );
+    Zone zone;
+    zone.id = f.id();
+    zone.geometry = featureGeometry;
+    QgsRasterAnalysisUtils::cellInfoForBBox( rasterBBox, featureRect, mCellSizeX, mCellSizeY, zone.nCellsX, zone.nCellsY, nCellsXProvider, nCellsYProvider, zone.rasterBlockExtent );
+    zone.left = static_cast< int >( std::round( ( zone.rasterBlockExtent.xMinimum() - rasterBBox.xMinimum() ) / mCellSizeX ) );
+    zone.top = static_cast< int >( std::round( ( rasterBBox.yMaximum() - zone.rasterBlockExtent.yMaximum() ) / mCellSizeY ) );
+    zones.push_back( zone );
+  }
 
-    featureStats.reset();
-    QgsRasterAnalysisUtils::statisticsFromMiddlePointTest( mRasterInterface, mRasterBand, featureGeometry, nCellsX, nCellsY, mCellSizeX, mCellSizeY,
-    rasterBlockExtent, [ &featureStats ]( double value ) { featureStats.addValue( value ); } );
+  // The raster is read by tiles, each of them once for all the zones it intersects, and the
+  // tiles are processed in parallel, a batch at a time, each from its own clone of the raster
+  // interface. The cells of the zones in a tile are found by a scanline sweep of their rings.
+  const int tileColumns = ( nCellsXProvider + TILE_SIZE - 1 ) / TILE_SIZE;
+  const int tileRows = ( nCellsYProvider + TILE_SIZE - 1 ) / TILE_SIZE;
+  QHash< int, QVector< int > > tileZones;
+  QVector< int > tileOrder;
+  for ( int i = 0; i < static_cast< int >( zones.size() ); ++i )
+  {
+    const Zone &zone = zones.at( i );
+    if ( zone.nCellsX <= 0 || zone.nCellsY <= 0 )
+      continue;
+
+    for ( int tileRow = zone.top / TILE_SIZE; tileRow <= std::min( tileRows - 1, ( zone.top + zone.nCellsY - 1 ) / TILE_SIZE ); ++tileRow )
+    {
+      for ( int tileColumn = zone.left / TILE_SIZE; tileColumn <= std::min( tileColumns - 1, ( zone.left + zone.nCellsX - 1 ) / TILE_SIZE ); ++tileColumn )
+      {
+        QVector< int > &indexes = tileZones[ tileRow * tileColumns + tileColumn ];
+        if ( indexes.isEmpty() )
+          tileOrder << tileRow * tileColumns + tileColumn;
+        indexes << i;
+      }
+    }
+  }
+  std::sort( tileOrder.begin(), tileOrder.end() );
+
+  struct Tile
+  {
+    int left;
+    int top;
+    int width;
+    int height;
+    QVector< int > zones;
+    std::unique_ptr< QgsRasterInterface > rasterInterface;
+    std::vector< std::pair< int, FeatureStats > > stats;
+  };
+
+  auto processTile = [&]( Tile & tile )
+  {
+    const QgsRectangle tileExtent( rasterBBox.xMinimum() + tile.left * mCellSizeX,
+                                   rasterBBox.yMaximum() - ( tile.top + tile.height ) * mCellSizeY,
+                                   rasterBBox.xMinimum() + ( tile.left + tile.width ) * mCellSizeX,
+                                   rasterBBox.yMaximum() - tile.top * mCellSizeY );
+    QgsRasterInterface *rasterInterface = tile.rasterInterface ? tile.rasterInterface.get() : mRasterInterface;
+    std::unique_ptr< QgsRasterBlock > block( rasterInterface->block( mRasterBand, tileExtent, tile.width, tile.height ) );
+    if ( block )
+    {
+      bool isNoData = false;
+      for ( int index : qgis::as_const( tile.zones ) )
+      {
+        const Zone &zone = zones.at( index );
+        FeatureStats stats( statsStoreValues, statsStoreValueCount );
+        sweepZone( zone.geometry, std::max( zone.left, tile.left ), std::max( zone.top, tile.top ),
+                   std::min( zone.left + zone.nCellsX, tile.left + tile.width ), std::min( zone.top + zone.nCellsY, tile.top + tile.height ),
+                   rasterBBox, mCellSizeX, mCellSizeY, [&]( int column, int row )
+        {
+          const double pixelValue = block->valueAndNoData( row - tile.top, column - tile.left, isNoData );
+          if ( QgsRasterAnalysisUtils::validPixel( pixelValue ) && !isNoData )
+            stats.addValue( pixelValue );
+        } );
+        tile.stats.emplace_back( index, stats );
+      }
+    }
+    // the clone is released as soon as possible
+    tile.rasterInterface.reset();
+  };
+
+  std::vector< FeatureStats > zoneStats( zones.size(), FeatureStats( statsStoreValues, statsStoreValueCount ) );
+  const int batchSize = std::max( 1, QThreadPool::globalInstance()->maxThreadCount() );
+  std::vector< Tile > batch;
+  for ( int next = 0; next < tileOrder.size(); )
+  {
+    if ( feedback && feedback->isCanceled() )
+    {
+      break;
+    }
+
+    if ( feedback )
+    {
+      feedback->setProgress( 10.0 + 80.0 * static_cast< double >( next ) / tileOrder.size() );
+    }
+
+    batch.clear();
+    for ( int i = 0; i < batchSize && next < tileOrder.size(); ++i, ++next )
+    {
+      Tile tile;
+      tile.left = ( tileOrder.at( next ) % tileColumns ) * TILE_SIZE;
+      tile.top = ( tileOrder.at( next ) / tileColumns ) * TILE_SIZE;
+      tile.width = std::min( TILE_SIZE, nCellsXProvider - tile.left );
+      tile.height = std::min( TILE_SIZE, nCellsYProvider - tile.top );
+      tile.zones = tileZones.take( tileOrder.at( next ) );
+      // the raster interfaces are not thread-safe, the tiles are read from clones unless cloning is not supported
+      tile.rasterInterface.reset( mRasterInterface->clone() );
+      batch.push_back( std::move( tile ) );
+      if ( !batch.back().rasterInterface )
+      {
+        ++next;
+        break;
+      }
+    }
 
+    if ( batch.size() == 1 )
+      processTile( batch.front() );
+    else
+      QtConcurrent::blockingMap( batch, processTile );
+
+    for ( const Tile &tile : batch )
+    {
+      for ( const std::pair< int, FeatureStats > &stats : tile.stats )
+        zoneStats[ stats.first ].merge( stats.second );
+    }
+  }
+
+  QgsChangedAttributesMap changeMap;
+  for ( int i = 0; i < static_cast< int >( zones.size() ); ++i )
+  {
+    if ( feedback && feedback->isCanceled() )
+    {
+      break;
+    }
+
+    if ( feedback && i % 1000 == 0 )
+    {
+      feedback->setProgress( 90.0 + 10.0 * static_cast< double >( i ) / zones.size() );
+    }
+
+    const Zone &zone = zones.at( i );
+    FeatureStats &featureStats = zoneStats[ i ];
     if ( featureStats.count <= 1 )
     {
       //the cell resolution is probably larger than the polygon area. We switch to precise pixel - polygon intersection in this case
       featureStats.reset();
-      QgsRasterAnalysisUtils::statisticsFromPreciseIntersection( mRasterInterface, mRasterBand, featureGeometry, nCellsX, nCellsY, mCellSizeX, mCellSizeY,
-      rasterBlockExtent, [ &featureStats ]( double value, double weight ) { featureStats.addValue( value, weight ); } );
+      QgsRasterAnalysisUtils::statisticsFromPreciseIntersection( mRasterInterface, mRasterBand, zone.geometry, zone.nCellsX, zone.nCellsY, mCellSizeX, mCellSizeY,
+      zone.rasterBlockExtent, [ &featureStats ]( double value, double weight ) { featureStats.addValue( value, weight ); } );
     }
 
     //write the statistics value to the vector data provider
@@ -335,8 +626,15 @@ int QgsZonalStatistics::calculateStatistics( QgsFeedback *feedback )
         changeAttributeMap.insert( varietyIndex, QVariant( featureStats.valueCount.count() ) );
     }
 
-    changeMap.insert( f.id(), changeAttributeMap );
-    ++featureCounter;
+    changeMap.insert( zone.id, changeAttributeMap );
+    // the values of the zone are not needed anymore
+    featureStats.reset();
+  }
+
+  // statistics of a part of the zones only would be wrong
+  if ( feedback && feedback->isCanceled() )
+  {
+    changeMap.clear();
   }
 
   vectorProvider->changeAttributeValues( changeMap );
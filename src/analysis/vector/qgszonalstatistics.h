@@ -173,6 +173,18 @@ class ANALYSIS_EXPORT QgsZonalStatistics
           if ( mStoreValues )
             values.append( value );
         }
+
+        //! Adds the values of \a other, the statistics of another part of the zone
+        void merge( const FeatureStats &other )
+        {
+          sum += other.sum;
+          count += other.count;
+          min = std::min( min, other.min );
+          max = std::max( max, other.max );
+          for ( auto it = other.valueCount.constBegin(); it != other.valueCount.constEnd(); ++it )
+            valueCount.insert( it.key(), valueCount.value( it.key(), 0 ) + it.value() );
+          values.append( other.values );
+        }
         double sum = 0.0;
         double count = 0.0;
         double max = std::numeric_limits<double>::lowest();
@@ -187,6 +199,9 @@ class ANALYSIS_EXPORT QgsZonalStatistics
 
     QString getUniqueFieldName( const QString &fieldName, const QList<QgsField> &newFields );
 
+    //! Number of cells of each side of the tiles of the raster read, each once, for all the zones
+    static const int TILE_SIZE = 512;
+
     QgsRasterInterface *mRasterInterface = nullptr;
     QgsCoordinateReferenceSystem mRasterCrs;
 
@@ -41,6 +41,7 @@ QgsMap3DExportWidget::QgsMap3DExportWidget( Qgs3DMapScene *scene, Qgs3DMapExport
   connect( ui->selectFolderWidget, &QgsFileWidget::fileChanged, [ = ]( const QString & ) { settingsChanged(); } );
   connect( ui->smoothEdgesCheckBox, &QCheckBox::stateChanged, [ = ]( int ) { settingsChanged(); } );
   connect( ui->terrainResolutionSpinBox, qgis::overload<int>::of( &QSpinBox::valueChanged ), [ = ]( int ) { settingsChanged(); } );
+  connect( ui->terrainLevelOfDetailSpinBox, qgis::overload<int>::of( &QSpinBox::valueChanged ), [ = ]( int ) { settingsChanged(); } );
   connect( ui->exportNormalsCheckBox, &QCheckBox::stateChanged, [ = ]( int ) { settingsChanged(); } );
   connect( ui->exportTexturesCheckBox, &QCheckBox::stateChanged, [ = ]( int ) { settingsChanged(); } );
   connect( ui->terrainTextureResolutionSpinBox, qgis::overload<int>::of( &QSpinBox::valueChanged ), [ = ]( int ) { settingsChanged(); } );
@@ -61,6 +62,7 @@ void QgsMap3DExportWidget::loadSettings()
   ui->selectFolderWidget->setFilePath( mExportSettings->sceneFolderPath() );
   ui->terrainResolutionSpinBox->setValue( mExportSettings->terrrainResolution() );
   ui->terrainTextureResolutionSpinBox->setValue( mExportSettings->terrainTextureResolution() );
+  ui->terrainLevelOfDetailSpinBox->setValue( mExportSettings->terrainLevelOfDetail() );
   ui->smoothEdgesCheckBox->setChecked( mExportSettings->smoothEdges() );
   ui->exportNormalsCheckBox->setChecked( mExportSettings->exportNormals() );
   ui->exportTexturesCheckBox->setChecked( mExportSettings->exportTextures() );
@@ -76,6 +78,7 @@ void QgsMap3DExportWidget::settingsChanged()
   mExportSettings->setExportNormals( ui->exportNormalsCheckBox->isChecked() );
   mExportSettings->setExportTextures( ui->exportTexturesCheckBox->isChecked() );
   mExportSettings->setTerrainTextureResolution( ui->terrainTextureResolutionSpinBox->value() );
+  mExportSettings->setTerrainLevelOfDetail( ui->terrainLevelOfDetailSpinBox->value() );
   mExportSettings->setScale( ui->scaleSpinBox->value() );
 }
 
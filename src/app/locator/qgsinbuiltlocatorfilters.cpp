@@ -15,6 +15,7 @@
  *                                                                         *
  ***************************************************************************/
 
+#include <QCheckBox>
 #include <QClipboard>
 #include <QMap>
 #include <QSpinBox>
@@ -22,11 +23,14 @@
 #include <QToolButton>
 #include <QUrl>
 
+#include <algorithm>
+
 #include "qgsapplication.h"
 #include "qgscoordinatereferencesystem.h"
 #include "qgscoordinatetransform.h"
 #include "qgscoordinateutils.h"
 #include "qgsinbuiltlocatorfilters.h"
+#include "qgslocatorfeaturesindex.h"
 #include "qgsproject.h"
 #include "qgslayertree.h"
 #include "qgsfeedback.h"
@@ -404,6 +408,8 @@ void QgsAllLayersFeaturesLocatorFilter::prepare( const QString &string, const Qg
   QgsSettings settings;
   mMaxTotalResults = settings.value( "locator_filters/all_layers_features/limit_global", 15, QgsSettings::App ).toInt();
   mMaxResultsPerLayer = settings.value( "locator_filters/all_layers_features/limit_per_layer", 8, QgsSettings::App ).toInt();
+  const bool useIndex = settings.value( "locator_filters/all_layers_features/use_index", false, QgsSettings::App ).toBool()
+                        && QgsLocatorFeaturesIndex::supportsSearch( string );
 
   mPreparedLayers.clear();
   const QMap<QString, QgsMapLayer *> layers = QgsProject::instance()->mapLayers();
@@ -441,6 +447,8 @@ void QgsAllLayersFeaturesLocatorFilter::prepare( const QString &string, const Qg
     preparedLayer->featureSource.reset( new QgsVectorLayerFeatureSource( layer ) );
     preparedLayer->request = req;
     preparedLayer->exactMatchRequest = exactMatchRequest;
+    if ( useIndex )
+      preparedLayer->index = QgsLocatorFeaturesIndexRegistry::instance()->index( layer );
     preparedLayer->layerIcon = QgsMapLayerModel::iconForLayer( layer );
 
     mPreparedLayers.append( preparedLayer );
@@ -460,6 +468,36 @@ void QgsAllLayersFeaturesLocatorFilter::fetchResults( const QString &string, con
 
     QgsFeatureIds foundFeatureIds;
 
+    if ( preparedLayer->index )
+    {
+      // the features are searched in the index of the display strings, exact matches first
+      const QVector< QgsLocatorFeaturesIndex::Match > exactMatches = preparedLayer->index->search( string, true, std::min( 10, mMaxResultsPerLayer ), QgsFeatureIds(), feedback );
+      for ( const QgsLocatorFeaturesIndex::Match &match : exactMatches )
+        foundFeatureIds << match.id;
+      const QVector< QgsLocatorFeaturesIndex::Match > partialMatches = preparedLayer->index->search( string, false, std::min( 6, mMaxResultsPerLayer - exactMatches.size() ), foundFeatureIds, feedback );
+      if ( feedback->isCanceled() )
+        return;
+
+      for ( const QgsLocatorFeaturesIndex::Match &match : exactMatches + partialMatches )
+      {
+        QgsLocatorResult result;
+        result.group = preparedLayer->layerName;
+        result.displayString = match.displayString;
+        result.userData = QVariantList() << match.id << preparedLayer->layerId;
+        result.icon = preparedLayer->layerIcon;
+        result.score = static_cast< double >( string.length() ) / result.displayString.size();
+        result.actions << QgsLocatorResult::ResultAction( OpenForm, tr( "Open form…" ) );
+        emit resultFetched( result );
+
+        foundInTotal++;
+        if ( foundInTotal >= mMaxTotalResults )
+          break;
+      }
+      if ( foundInTotal >= mMaxTotalResults )
+        break;
+      continue;
+    }
+
     QgsFeatureIterator exactMatchIt = preparedLayer->featureSource->getFeatures( preparedLayer->exactMatchRequest );
     while ( exactMatchIt.nextFeature( f ) )
     {
@@ -578,6 +616,9 @@ void QgsAllLayersFeaturesLocatorFilter::openConfigWidget( QWidget *parent )
   parLayerLimitSpinBox->setMinimum( 1 );
   parLayerLimitSpinBox->setMaximum( 200 );
   formLayout->addRow( tr( "&Maximum number of results per layer:" ), parLayerLimitSpinBox );
+  QCheckBox *useIndexCheckBox = new QCheckBox( tr( "Index the features of the layers in the background" ), dlg.get() );
+  useIndexCheckBox->setChecked( settings.value( QStringLiteral( "%1/use_index" ).arg( key ), false, QgsSettings::App ).toBool() );
+  formLayout->addRow( useIndexCheckBox );
   QDialogButtonBox *buttonbBox = new QDialogButtonBox( QDialogButtonBox::Ok | QDialogButtonBox::Cancel, dlg.get() );
   formLayout->addRow( buttonbBox );
   dlg->setLayout( formLayout );
@@ -585,6 +626,7 @@ void QgsAllLayersFeaturesLocatorFilter::openConfigWidget( QWidget *parent )
   {
     settings.setValue( QStringLiteral( "%1/limit_global" ).arg( key ), globalLimitSpinBox->value(), QgsSettings::App );
     settings.setValue( QStringLiteral( "%1/limit_per_layer" ).arg( key ), parLayerLimitSpinBox->value(), QgsSettings::App );
+    settings.setValue( QStringLiteral( "%1/use_index" ).arg( key ), useIndexCheckBox->isChecked(), QgsSettings::App );
     dlg->accept();
   } );
   connect( buttonbBox, &QDialogButtonBox::rejected, dlg.get(), &QDialog::reject );
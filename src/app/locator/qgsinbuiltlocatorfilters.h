@@ -26,6 +26,7 @@
 
 
 class QAction;
+class QgsLocatorFeaturesIndex;
 
 class APP_EXPORT QgsLayerTreeLocatorFilter : public QgsLocatorFilter
 {
@@ -138,6 +139,7 @@ class APP_EXPORT QgsAllLayersFeaturesLocatorFilter : public QgsLocatorFilter
         std::unique_ptr<QgsVectorLayerFeatureSource> featureSource;
         QgsFeatureRequest request;
         QgsFeatureRequest exactMatchRequest;
+        std::shared_ptr< const QgsLocatorFeaturesIndex > index;
         QString layerName;
         QString layerId;
         QIcon layerIcon;
@@ -0,0 +1,232 @@
+/***************************************************************************
+                         qgslocatorfeaturesindex.cpp
+                         ---------------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgslocatorfeaturesindex.h"
+#include "qgsapplication.h"
+#include "qgsexpressioncontextutils.h"
+#include "qgsfeedback.h"
+#include "qgsproject.h"
+#include "qgsvectorlayer.h"
+#include "qgsvectorlayerfeatureiterator.h"
+
+#include <QRegularExpression>
+
+#include <algorithm>
+#include <iterator>
+
+//
+// QgsLocatorFeaturesIndex
+//
+
+void QgsLocatorFeaturesIndex::addFeature( QgsFeatureId id, const QString &displayString )
+{
+  const int entry = count();
+  mIds.push_back( id );
+  mDisplayStrings << displayString;
+  const QVector< quint64 > entryTrigrams = trigrams( displayString.toLower() );
+  for ( quint64 trigram : entryTrigrams )
+    mTrigrams[ trigram ].push_back( entry );
+}
+
+bool QgsLocatorFeaturesIndex::supportsSearch( const QString &string )
+{
+  return !string.contains( '%' ) && !string.contains( '_' ) && !string.contains( '\\' );
+}
+
+QVector< QgsLocatorFeaturesIndex::Match > QgsLocatorFeaturesIndex::search( const QString &string, bool exactMatch, int limit, const QSet< QgsFeatureId > &excluded, QgsFeedback *feedback ) const
+{
+  QVector< Match > matches;
+
+  // spaces are replaced by % in the ILIKE search of the locator
+  const QStringList parts = string.split( ' ' );
+  QStringList patternParts;
+  std::vector< const std::vector< int > * > postings;
+  for ( const QString &part : parts )
+  {
+    patternParts << QRegularExpression::escape( part );
+    const QVector< quint64 > partTrigrams = trigrams( part.toLower() );
+    for ( quint64 trigram : partTrigrams )
+    {
+      auto it = mTrigrams.constFind( trigram );
+      if ( it == mTrigrams.constEnd() )
+        return matches;
+      postings.push_back( &it.value() );
+    }
+  }
+  const QString pattern = patternParts.join( QStringLiteral( ".*" ) );
+  const QRegularExpression regex( exactMatch ? QStringLiteral( "^%1$" ).arg( pattern ) : pattern,
+                                  QRegularExpression::CaseInsensitiveOption | QRegularExpression::DotMatchesEverythingOption );
+
+  // entries holding all the trigrams of the search, starting from the rarest one
+  std::vector< int > candidates;
+  const bool useCandidates = !postings.empty();
+  if ( useCandidates )
+  {
+    std::sort( postings.begin(), postings.end(), []( const std::vector< int > *postings1, const std::vector< int > *postings2 )
+    {
+      return postings1->size() < postings2->size();
+    } );
+    candidates = *postings.front();
+    std::vector< int > intersection;
+    for ( std::size_t i = 1; i < postings.size() && !candidates.empty(); ++i )
+    {
+      intersection.clear();
+      std::set_intersection( candidates.begin(), candidates.end(), postings[i]->begin(), postings[i]->end(), std::back_inserter( intersection ) );
+      candidates.swap( intersection );
+    }
+  }
+
+  const int candidateCount = useCandidates ? static_cast< int >( candidates.size() ) : count();
+  for ( int i = 0; i < candidateCount && matches.size() < limit; ++i )
+  {
+    if ( feedback && i % 1000 == 0 && feedback->isCanceled() )
+      break;
+
+    const int entry = useCandidates ? candidates[i] : i;
+    if ( excluded.contains( mIds[entry] ) )
+      continue;
+
+    const QString &displayString = mDisplayStrings.at( entry );
+    if ( regex.match( displayString ).hasMatch() )
+      matches << Match{ mIds[entry], displayString };
+  }
+  return matches;
+}
+
+QVector< quint64 > QgsLocatorFeaturesIndex::trigrams( const QString &lowered )
+{
+  QVector< quint64 > result;
+  if ( lowered.size() < 3 )
+    return result;
+
+  result.reserve( lowered.size() - 2 );
+  for ( int i = 0; i + 2 < lowered.size(); ++i )
+  {
+    result << ( ( static_cast< quint64 >( lowered.at( i ).unicode() ) << 32 )
+                | ( static_cast< quint64 >( lowered.at( i + 1 ).unicode() ) << 16 )
+                | static_cast< quint64 >( lowered.at( i + 2 ).unicode() ) );
+  }
+  std::sort( result.begin(), result.end() );
+  result.erase( std::unique( result.begin(), result.end() ), result.end() );
+  return result;
+}
+
+//
+// QgsLocatorFeaturesIndexTask
+//
+
+QgsLocatorFeaturesIndexTask::QgsLocatorFeaturesIndexTask( QgsVectorLayer *layer )
+  : QgsTask( tr( "Indexing features of %1" ).arg( layer->name() ), QgsTask::CanCancel )
+  , mSource( new QgsVectorLayerFeatureSource( layer ) )
+  , mFields( layer->fields() )
+  , mFeatureCount( layer->featureCount() )
+  , mExpression( layer->displayExpression() )
+{
+  mContext.appendScopes( QgsExpressionContextUtils::globalProjectLayerScopes( layer ) );
+}
+
+QgsLocatorFeaturesIndexTask::~QgsLocatorFeaturesIndexTask() = default;
+
+bool QgsLocatorFeaturesIndexTask::run()
+{
+  mIndex = std::make_shared< QgsLocatorFeaturesIndex >();
+  mExpression.prepare( &mContext );
+
+  QgsFeatureRequest request;
+  request.setSubsetOfAttributes( qgis::setToList( mExpression.referencedAttributeIndexes( mFields ) ) );
+  if ( !mExpression.needsGeometry() )
+    request.setFlags( QgsFeatureRequest::NoGeometry );
+
+  QgsFeatureIterator it = mSource->getFeatures( request );
+  QgsFeature feature;
+  long indexed = 0;
+  while ( it.nextFeature( feature ) )
+  {
+    if ( isCanceled() )
+      return false;
+
+    mContext.setFeature( feature );
+    mIndex->addFeature( feature.id(), mExpression.evaluate( &mContext ).toString() );
+    if ( mFeatureCount > 0 && ++indexed % 1000 == 0 )
+      setProgress( 100.0 * indexed / mFeatureCount );
+  }
+  return true;
+}
+
+//
+// QgsLocatorFeaturesIndexRegistry
+//
+
+QgsLocatorFeaturesIndexRegistry::QgsLocatorFeaturesIndexRegistry( QObject *parent )
+  : QObject( parent )
+{
+}
+
+QgsLocatorFeaturesIndexRegistry *QgsLocatorFeaturesIndexRegistry::instance()
+{
+  static QgsLocatorFeaturesIndexRegistry *sInstance = new QgsLocatorFeaturesIndexRegistry( QgsProject::instance() );
+  return sInstance;
+}
+
+std::shared_ptr< const QgsLocatorFeaturesIndex > QgsLocatorFeaturesIndexRegistry::index( QgsVectorLayer *layer )
+{
+  const QString layerId = layer->id();
+  if ( !mConnectedLayers.contains( layerId ) )
+  {
+    mConnectedLayers.insert( layerId );
+    auto invalidateLayer = [this, layerId] { invalidate( layerId ); };
+    connect( layer, &QgsMapLayer::dataChanged, this, invalidateLayer );
+    connect( layer, &QgsVectorLayer::layerModified, this, invalidateLayer );
+    connect( layer, &QgsVectorLayer::afterRollBack, this, invalidateLayer );
+    connect( layer, &QgsVectorLayer::subsetStringChanged, this, invalidateLayer );
+    connect( layer, &QgsVectorLayer::displayExpressionChanged, this, invalidateLayer );
+    connect( layer, &QgsMapLayer::willBeDeleted, this, [this, layerId]
+    {
+      invalidate( layerId );
+      mConnectedLayers.remove( layerId );
+    } );
+  }
+
+  LayerIndex &layerIndex = mIndexes[ layerId ];
+  if ( layerIndex.index )
+    return layerIndex.index;
+
+  if ( !layerIndex.task )
+  {
+    QgsLocatorFeaturesIndexTask *task = new QgsLocatorFeaturesIndexTask( layer );
+    layerIndex.task = task;
+    connect( task, &QgsTask::taskCompleted, this, [this, layerId, task]
+    {
+      auto it = mIndexes.find( layerId );
+      if ( it != mIndexes.end() && it->task == task )
+        it->index = task->index();
+    } );
+    QgsApplication::taskManager()->addTask( task );
+  }
+  return nullptr;
+}
+
+void QgsLocatorFeaturesIndexRegistry::invalidate( const QString &layerId )
+{
+  auto it = mIndexes.find( layerId );
+  if ( it == mIndexes.end() )
+    return;
+
+  if ( it->task )
+    it->task->cancel();
+  mIndexes.erase( it );
+}
@@ -0,0 +1,145 @@
+/***************************************************************************
+                         qgslocatorfeaturesindex.h
+                         -------------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSLOCATORFEATURESINDEX_H
+#define QGSLOCATORFEATURESINDEX_H
+
+#include "qgis_app.h"
+#include "qgsexpression.h"
+#include "qgsexpressioncontext.h"
+#include "qgsfeatureid.h"
+#include "qgsfields.h"
+#include "qgstaskmanager.h"
+
+#include <QHash>
+#include <QPointer>
+#include <QSet>
+#include <QVector>
+
+#include <memory>
+#include <vector>
+
+class QgsFeedback;
+class QgsVectorLayer;
+class QgsVectorLayerFeatureSource;
+
+/**
+ * Index of the display strings of the features of a layer, with the trigrams of the
+ * lowered strings, used by the locator to search features without querying the provider.
+ */
+class APP_EXPORT QgsLocatorFeaturesIndex
+{
+  public:
+
+    struct Match
+    {
+      QgsFeatureId id;
+      QString displayString;
+    };
+
+    //! Adds the feature with \a id, displayed as \a displayString
+    void addFeature( QgsFeatureId id, const QString &displayString );
+
+    //! Returns the number of indexed features
+    int count() const { return static_cast< int >( mIds.size() ); }
+
+    /**
+     * Returns TRUE if the index can answer a search for \a string, which must not contain
+     * the wildcards of the ILIKE operator.
+     */
+    static bool supportsSearch( const QString &string );
+
+    /**
+     * Returns at most \a limit features matching \a string like the ILIKE search of the locator,
+     * where spaces match any characters. With \a exactMatch the display string must match the
+     * whole \a string, otherwise it must contain it. Features in \a excluded are skipped.
+     */
+    QVector< Match > search( const QString &string, bool exactMatch, int limit, const QSet< QgsFeatureId > &excluded = QSet< QgsFeatureId >(), QgsFeedback *feedback = nullptr ) const;
+
+  private:
+
+    static QVector< quint64 > trigrams( const QString &lowered );
+
+    std::vector< QgsFeatureId > mIds;
+    QStringList mDisplayStrings;
+    QHash< quint64, std::vector< int > > mTrigrams;
+};
+
+/**
+ * Task building the locator index of the features of a layer from a snapshot of its features.
+ */
+class APP_EXPORT QgsLocatorFeaturesIndexTask : public QgsTask
+{
+    Q_OBJECT
+
+  public:
+
+    QgsLocatorFeaturesIndexTask( QgsVectorLayer *layer );
+    ~QgsLocatorFeaturesIndexTask() override;
+
+    bool run() override;
+
+    //! Returns the built index, once the task is completed
+    std::shared_ptr< QgsLocatorFeaturesIndex > index() const { return mIndex; }
+
+  private:
+
+    std::unique_ptr< QgsVectorLayerFeatureSource > mSource;
+    QgsFields mFields;
+    long mFeatureCount = 0;
+    QgsExpression mExpression;
+    QgsExpressionContext mContext;
+    std::shared_ptr< QgsLocatorFeaturesIndex > mIndex;
+};
+
+/**
+ * Keeps the locator indexes of the layers of the project, built in background tasks and
+ * discarded when the features or the display expression of a layer change.
+ */
+class APP_EXPORT QgsLocatorFeaturesIndexRegistry : public QObject
+{
+    Q_OBJECT
+
+  public:
+
+    //! Returns the registry, to be used in the main thread
+    static QgsLocatorFeaturesIndexRegistry *instance();
+
+    /**
+     * Returns the index of \a layer, or nullptr if it is not built yet. The build of the index
+     * is then started in a background task.
+     */
+    std::shared_ptr< const QgsLocatorFeaturesIndex > index( QgsVectorLayer *layer );
+
+    //! Discards the index of the layer with \a layerId
+    void invalidate( const QString &layerId );
+
+  private:
+
+    explicit QgsLocatorFeaturesIndexRegistry( QObject *parent );
+
+    struct LayerIndex
+    {
+      std::shared_ptr< const QgsLocatorFeaturesIndex > index;
+      QPointer< QgsLocatorFeaturesIndexTask > task;
+    };
+
+    QHash< QString, LayerIndex > mIndexes;
+    QSet< QString > mConnectedLayers;
+};
+
+#endif // QGSLOCATORFEATURESINDEX_H
@@ -361,9 +361,7 @@ void QgsMeshLayerProperties::apply()
   simplifySettings.setEnabled( mSimplifyMeshGroupBox->isChecked() );
   simplifySettings.setReductionFactor( mSimplifyReductionFactorSpinBox->value() );
   simplifySettings.setMeshResolution( mSimplifyMeshResolutionSpinBox->value() );
-  bool needMeshUpdating = ( ( simplifySettings.isEnabled() != mMeshLayer->meshSimplificationSettings().isEnabled() ) ||
-                            ( simplifySettings.reductionFactor() != mMeshLayer->meshSimplificationSettings().reductionFactor() ) );
-
+  // the simplified meshes are built again if needed
   mMeshLayer->setMeshSimplificationSettings( simplifySettings );
 
   QgsDebugMsgLevel( QStringLiteral( "processing temporal tab" ), 4 );
@@ -382,9 +380,6 @@ void QgsMeshLayerProperties::apply()
   mMeshLayer->setTemporalMatchingMethod( static_cast<QgsMeshDataProviderTemporalCapabilities::MatchingTemporalDatasetMethod>(
       mComboBoxTemporalDatasetMatchingMethod->currentData().toInt() ) );
 
-  if ( needMeshUpdating )
-    mMeshLayer->reload();
-
   if ( needEmitRendererChanged )
     emit mMeshLayer->rendererChanged();
 
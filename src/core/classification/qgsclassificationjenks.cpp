@@ -17,6 +17,15 @@
 #include "qgsclassificationjenks.h"
 #include "qgsapplication.h"
 
+#include <QThread>
+#include <QtConcurrentMap>
+
+// maximum number of entries of the matrix of the optimal class starts
+static const qint64 MAXIMUM_MATRIX_SIZE = 64 * 1024 * 1024;
+
+// number of values from which the rows of the dynamic program are computed in parallel
+static const int PARALLEL_MINIMUM_SIZE = 100000;
+
 QgsClassificationJenks::QgsClassificationJenks()
   : QgsClassificationMethod()
 {
@@ -72,94 +81,138 @@ QList<double> QgsClassificationJenks::calculateBreaks( double &minimum, double &
     return values;
   }
 
-  QVector<double> sample;
+  // the values are sorted and used all, unless the matrix of the optimal class starts
+  // of each number of classes gets too large: then evenly spaced order statistics of the
+  // sorted values are taken, so that the breaks are stable between runs
+  QVector<double> sorted = values.toVector();
+  std::sort( sorted.begin(), sorted.end() );
 
-  // if we have lots of values, we need to take a random sample
-  if ( values.size() > mMaximumSize )
+  QVector<double> sample;
+  const qint64 maximumSize = MAXIMUM_MATRIX_SIZE / ( nclasses - 1 );
+  if ( sorted.size() > maximumSize )
   {
-    // for now, sample at least maximumSize values or a 10% sample, whichever
-    // is larger. This will produce a more representative sample for very large
-    // layers, but could end up being computationally intensive...
-
-    sample.resize( std::max( mMaximumSize, values.size() / 10 ) );
+    sample.resize( static_cast< int >( maximumSize ) );
+    for ( int i = 0; i < sample.size(); i++ )
+      sample[ i ] = sorted.at( static_cast< int >( static_cast< qint64 >( i ) * ( sorted.size() - 1 ) / ( sample.size() - 1 ) ) );
 
     QgsDebugMsgLevel( QStringLiteral( "natural breaks (jenks) sample size: %1" ).arg( sample.size() ), 2 );
     QgsDebugMsgLevel( QStringLiteral( "values:%1" ).arg( values.size() ), 2 );
-
-    sample[ 0 ] = minimum;
-    sample[ 1 ] = maximum;
-    for ( int i = 2; i < sample.size(); i++ )
-    {
-      // pick a random integer from 0 to n
-      double r = qrand();
-      int j = std::floor( r / RAND_MAX * ( values.size() - 1 ) );
-      sample[ i ] = values[ j ];
-    }
   }
   else
   {
-    sample = values.toVector();
+    sample = sorted;
+  }
+  sorted.clear();
+
+  const int n = sample.size();
+
+  // Fisher's dynamic program: cost[j][l] is the minimal sum of squared deviations of the first l
+  // values in j classes, reached with the last class starting at split[j][l]. The optimal split is
+  // non decreasing with l, so each row is computed by divide and conquer in O(n log n) instead of O(n2).
+  // Sums are taken on the values centered on the mean to limit the loss of precision.
+  double mean = 0;
+  for ( double value : qgis::as_const( sample ) )
+    mean += value;
+  mean /= n;
+
+  std::vector<double> sums( n + 1, 0.0 );
+  std::vector<double> squareSums( n + 1, 0.0 );
+  for ( int i = 0; i < n; i++ )
+  {
+    const double value = sample.at( i ) - mean;
+    sums[ i + 1 ] = sums[ i ] + value;
+    squareSums[ i + 1 ] = squareSums[ i ] + value * value;
   }
 
-  int n = sample.size();
+  // sum of squared deviations of the values from index begin (included) to end (excluded)
+  auto deviation = [&sums, &squareSums]( int begin, int end ) -> double
+  {
+    const double sum = sums[ end ] - sums[ begin ];
+    return std::max( 0.0, squareSums[ end ] - squareSums[ begin ] - sum * sum / ( end - begin ) );
+  };
 
-  // sort the sample values
-  std::sort( sample.begin(), sample.end() );
+  std::vector<double> previousCost( n + 1 );
+  std::vector<double> cost( n + 1, std::numeric_limits<double>::max() );
+  for ( int l = 1; l <= n; l++ )
+    previousCost[ l ] = deviation( 0, l );
 
-  QVector< QVector<int> > matrixOne( n + 1 );
-  QVector< QVector<double> > matrixTwo( n + 1 );
+  std::vector< std::vector<int> > splits( nclasses + 1 );
 
-  for ( int i = 0; i <= n; i++ )
+  struct Range
   {
-    matrixOne[i].resize( nclasses + 1 );
-    matrixTwo[i].resize( nclasses + 1 );
-  }
+    int first;
+    int last;
+    int splitFirst;
+    int splitLast;
+  };
 
-  for ( int i = 1; i <= nclasses; i++ )
+  for ( int j = 2; j <= nclasses; j++ )
   {
-    matrixOne[0][i] = 1;
-    matrixOne[1][i] = 1;
-    matrixTwo[0][i] = 0.0;
-    for ( int j = 2; j <= n; j++ )
+    std::vector<int> &split = splits[ j ];
+    split.assign( n + 1, 0 );
+
+    // computes cost[l] and split[l] for the middle l of a range knowing that the split
+    // is between splitFirst and splitLast, and returns the ranges on both sides of it.
+    // On ties the earliest split is kept, as in the original algorithm
+    auto solveMiddle = [&]( const Range & range, std::vector<Range> &remaining ) -> void
     {
-      matrixTwo[j][i] = std::numeric_limits<double>::max();
-    }
-  }
+      if ( range.first > range.last )
+        return;
 
-  for ( int l = 2; l <= n; l++ )
-  {
-    double s1 = 0.0;
-    double s2 = 0.0;
-    int w = 0;
+      const int l = range.first + ( range.last - range.first ) / 2;
+      double best = std::numeric_limits<double>::max();
+      int bestSplit = std::max( range.splitFirst, j - 1 );
+      for ( int m = std::max( range.splitFirst, j - 1 ); m <= std::min( range.splitLast, l - 1 ); m++ )
+      {
+        const double candidate = previousCost[ m ] + deviation( m, l );
+        if ( candidate < best )
+        {
+          best = candidate;
+          bestSplit = m;
+        }
+      }
+      cost[ l ] = best;
+      split[ l ] = bestSplit;
 
-    double v = 0.0;
+      remaining.push_back( { range.first, l - 1, range.splitFirst, bestSplit } );
+      remaining.push_back( { l + 1, range.last, bestSplit, range.splitLast } );
+    };
 
-    for ( int m = 1; m <= l; m++ )
+    auto solve = [&]( const Range & range ) -> void
     {
-      int i3 = l - m + 1;
-
-      double val = sample[ i3 - 1 ];
-
-      s2 += val * val;
-      s1 += val;
-      w++;
+      std::vector<Range> stack;
+      stack.push_back( range );
+      while ( !stack.empty() )
+      {
+        const Range current = stack.back();
+        stack.pop_back();
+        solveMiddle( current, stack );
+      }
+    };
 
-      v = s2 - ( s1 * s1 ) / static_cast< double >( w );
-      int i4 = i3 - 1;
-      if ( i4 != 0 )
+    const Range row { j, n, j - 1, n - 1 };
+    const int threads = std::max( 1, QThread::idealThreadCount() );
+    if ( threads > 1 && n - j > PARALLEL_MINIMUM_SIZE )
+    {
+      // the first levels of the divide and conquer are computed serially, then the
+      // remaining independent ranges in parallel
+      std::vector<Range> ranges;
+      ranges.push_back( row );
+      while ( !ranges.empty() && static_cast< int >( ranges.size() ) < 4 * threads )
       {
-        for ( int j = 2; j <= nclasses; j++ )
-        {
-          if ( matrixTwo[l][j] >= v + matrixTwo[i4][j - 1] )
-          {
-            matrixOne[l][j] = i4;
-            matrixTwo[l][j] = v + matrixTwo[i4][j - 1];
-          }
-        }
+        std::vector<Range> next;
+        for ( const Range &range : ranges )
+          solveMiddle( range, next );
+        ranges.swap( next );
       }
+      QtConcurrent::blockingMap( ranges, solve );
     }
-    matrixOne[l][1] = 1;
-    matrixTwo[l][1] = v;
+    else
+    {
+      solve( row );
+    }
+
+    std::swap( previousCost, cost );
   }
 
   QVector<double> breaks( nclasses );
@@ -167,9 +220,9 @@ QList<double> QgsClassificationJenks::calculateBreaks( double &minimum, double &
 
   for ( int j = nclasses, k = n; j >= 2; j-- )
   {
-    int id = matrixOne[k][j] - 1;
+    const int id = splits[ j ][ k ] - 1;
     breaks[j - 2] = sample[id];
-    k = matrixOne[k][j] - 1;
+    k = splits[ j ][ k ];
   }
 
   return breaks.toList();
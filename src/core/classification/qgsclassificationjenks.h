@@ -38,8 +38,6 @@ class CORE_EXPORT QgsClassificationJenks : public QgsClassificationMethod
   private:
     QList<double> calculateBreaks( double &minimum, double &maximum,
                                    const QList<double> &values, int nclasses ) override;
-
-    int mMaximumSize = 3000;
 };
 
 #endif // QGSCLASSIFICATIONJENKS_H
@@ -14,10 +14,13 @@
  ***************************************************************************/
 #include "qgsdiagram.h"
 #include "qgsdiagramrenderer.h"
+#include "qgsexpressionnodeimpl.h"
+#include "qgsfeature.h"
+#include "qgsrendercontext.h"
 
 #include <QPainter>
 
-QgsDiagram::QgsDiagram( const QgsDiagram & ): mExpressions{}
+QgsDiagram::QgsDiagram( const QgsDiagram & ): mExpressions{}, mFieldNames{}
 {
   // do not copy the cached expression map - the expressions need to be created and prepared with getExpression(...) call
 }
@@ -32,6 +35,7 @@ void QgsDiagram::clearCache()
     delete i.value();
   }
   mExpressions.clear();
+  mFieldNames.clear();
 }
 
 QgsExpression *QgsDiagram::getExpression( const QString &expression, const QgsExpressionContext &context )
@@ -45,6 +49,36 @@ QgsExpression *QgsDiagram::getExpression( const QString &expression, const QgsEx
   return mExpressions[expression];
 }
 
+QVariant QgsDiagram::attributeValue( const QString &expression, const QgsFeature &feature, const QgsRenderContext &c, std::unique_ptr< QgsExpressionContext > &expressionContext )
+{
+  auto fieldIt = mFieldNames.constFind( expression );
+  if ( fieldIt == mFieldNames.constEnd() )
+  {
+    const QgsExpression parsedExpression( expression );
+    QString fieldName;
+    if ( parsedExpression.rootNode() && parsedExpression.rootNode()->nodeType() == QgsExpressionNode::ntColumnRef )
+      fieldName = static_cast< const QgsExpressionNodeColumnRef * >( parsedExpression.rootNode() )->name();
+    fieldIt = mFieldNames.insert( expression, fieldName );
+  }
+
+  if ( !fieldIt.value().isEmpty() )
+  {
+    const int fieldIndex = feature.fields().lookupField( fieldIt.value() );
+    if ( fieldIndex >= 0 )
+      return feature.attribute( fieldIndex );
+  }
+
+  if ( !expressionContext )
+  {
+    expressionContext = qgis::make_unique< QgsExpressionContext >( c.expressionContext() );
+    expressionContext->setFeature( feature );
+    if ( !feature.fields().isEmpty() )
+      expressionContext->setFields( feature.fields() );
+  }
+  QgsExpression *preparedExpression = getExpression( expression, *expressionContext );
+  return preparedExpression->evaluate( expressionContext.get() );
+}
+
 void QgsDiagram::setPenWidth( QPen &pen, const QgsDiagramSettings &s, const QgsRenderContext &c )
 {
   pen.setWidthF( c.convertToPainterUnits( s.penWidth, s.lineSizeUnit, s.lineSizeScale ) );
@@ -19,8 +19,11 @@
 #include "qgis.h"
 #include <QPen>
 #include <QBrush>
+#include <QHash>
 #include "qgsexpression.h" //for QMap with QgsExpression
 
+#include <memory>
+
 class QPainter;
 class QPointF;
 class QgsDiagramSettings;
@@ -148,8 +151,23 @@ class CORE_EXPORT QgsDiagram SIP_NODEFAULTCTORS
      */
     QSizeF sizeForValue( double value, const QgsDiagramSettings &s, const QgsDiagramInterpolationSettings &is ) const;
 
+    /**
+     * Returns the value of the attribute \a expression for \a feature.
+     *
+     * An expression which is a plain field reference is read directly from the attributes of the feature.
+     * Other expressions are evaluated with a copy of the expression context of \a c. The copy is
+     * created in \a expressionContext by the first evaluated expression and reused by the next ones.
+     *
+     * \note not available in Python bindings
+     * \since QGIS 3.16
+     */
+    QVariant attributeValue( const QString &expression, const QgsFeature &feature, const QgsRenderContext &c, std::unique_ptr< QgsExpressionContext > &expressionContext ) SIP_SKIP;
+
   private:
     QMap<QString, QgsExpression *> mExpressions;
+
+    //! Field names of the expressions which are a plain field reference, or an empty string for the other expressions
+    QHash<QString, QString> mFieldNames;
     QgsDiagram &operator= ( const QgsDiagram & ) = delete;
 };
 
@@ -45,15 +45,11 @@ QSizeF QgsHistogramDiagram::diagramSize( const QgsFeature &feature, const QgsRen
 
   double maxValue = 0;
 
-  QgsExpressionContext expressionContext = c.expressionContext();
-  expressionContext.setFeature( feature );
-  if ( !feature.fields().isEmpty() )
-    expressionContext.setFields( feature.fields() );
+  std::unique_ptr< QgsExpressionContext > expressionContext;
 
   for ( const QString &cat : qgis::as_const( s.categoryAttributes ) )
   {
-    QgsExpression *expression = getExpression( cat, expressionContext );
-    maxValue = std::max( expression->evaluate( &expressionContext ).toDouble(), maxValue );
+    maxValue = std::max( attributeValue( cat, feature, c, expressionContext ).toDouble(), maxValue );
   }
 
   // Scale, if extension is smaller than the specified minimum
@@ -174,16 +170,12 @@ void QgsHistogramDiagram::renderDiagram( const QgsFeature &feature, QgsRenderCon
   QList<double> values;
   double maxValue = 0;
 
-  QgsExpressionContext expressionContext = c.expressionContext();
-  expressionContext.setFeature( feature );
-  if ( !feature.fields().isEmpty() )
-    expressionContext.setFields( feature.fields() );
+  std::unique_ptr< QgsExpressionContext > expressionContext;
 
   values.reserve( s.categoryAttributes.size() );
   for ( const QString &cat : qgis::as_const( s.categoryAttributes ) )
   {
-    QgsExpression *expression = getExpression( cat, expressionContext );
-    double currentVal = expression->evaluate( &expressionContext ).toDouble();
+    double currentVal = attributeValue( cat, feature, c, expressionContext ).toDouble();
     values.push_back( currentVal );
     maxValue = std::max( currentVal, maxValue );
   }
@@ -38,13 +38,9 @@ QSizeF QgsPieDiagram::diagramSize( const QgsFeature &feature, const QgsRenderCon
   QVariant attrVal;
   if ( is.classificationAttributeIsExpression )
   {
-    QgsExpressionContext expressionContext = c.expressionContext();
-    if ( !feature.fields().isEmpty() )
-      expressionContext.setFields( feature.fields() );
-    expressionContext.setFeature( feature );
+    std::unique_ptr< QgsExpressionContext > expressionContext;
 
-    QgsExpression *expression = getExpression( is.classificationAttributeExpression, expressionContext );
-    attrVal = expression->evaluate( &expressionContext );
+    attrVal = attributeValue( is.classificationAttributeExpression, feature, c, expressionContext );
   }
   else
   {
@@ -93,16 +89,12 @@ void QgsPieDiagram::renderDiagram( const QgsFeature &feature, QgsRenderContext &
   double valSum = 0;
   int valCount = 0;
 
-  QgsExpressionContext expressionContext = c.expressionContext();
-  expressionContext.setFeature( feature );
-  if ( !feature.fields().isEmpty() )
-    expressionContext.setFields( feature.fields() );
+  std::unique_ptr< QgsExpressionContext > expressionContext;
 
   QList<QString>::const_iterator catIt = s.categoryAttributes.constBegin();
   for ( ; catIt != s.categoryAttributes.constEnd(); ++catIt )
   {
-    QgsExpression *expression = getExpression( *catIt, expressionContext );
-    currentVal = expression->evaluate( &expressionContext ).toDouble();
+    currentVal = attributeValue( *catIt, feature, c, expressionContext ).toDouble();
     values.push_back( currentVal );
     valSum += currentVal;
     if ( currentVal ) valCount++;
@@ -40,13 +40,9 @@ QSizeF QgsStackedBarDiagram::diagramSize( const QgsFeature &feature, const QgsRe
   QVariant attrVal;
   if ( is.classificationAttributeIsExpression )
   {
-    QgsExpressionContext expressionContext = c.expressionContext();
-    if ( !feature.fields().isEmpty() )
-      expressionContext.setFields( feature.fields() );
-    expressionContext.setFeature( feature );
+    std::unique_ptr< QgsExpressionContext > expressionContext;
 
-    QgsExpression *expression = getExpression( is.classificationAttributeExpression, expressionContext );
-    attrVal = expression->evaluate( &expressionContext );
+    attrVal = attributeValue( is.classificationAttributeExpression, feature, c, expressionContext );
   }
   else
   {
@@ -163,10 +159,7 @@ void QgsStackedBarDiagram::renderDiagram( const QgsFeature &feature, QgsRenderCo
   QList< QPair<double, QColor> > values;
   QList< QPair<double, QColor> > negativeValues;
 
-  QgsExpressionContext expressionContext = c.expressionContext();
-  expressionContext.setFeature( feature );
-  if ( !feature.fields().isEmpty() )
-    expressionContext.setFields( feature.fields() );
+  std::unique_ptr< QgsExpressionContext > expressionContext;
 
   values.reserve( s.categoryAttributes.size() );
   double total = 0;
@@ -175,8 +168,7 @@ void QgsStackedBarDiagram::renderDiagram( const QgsFeature &feature, QgsRenderCo
   QList< QColor >::const_iterator colIt = s.categoryColors.constBegin();
   for ( const QString &cat : qgis::as_const( s.categoryAttributes ) )
   {
-    QgsExpression *expression = getExpression( cat, expressionContext );
-    double currentVal = expression->evaluate( &expressionContext ).toDouble();
+    double currentVal = attributeValue( cat, feature, c, expressionContext ).toDouble();
     total += fabs( currentVal );
     if ( currentVal >= 0 )
     {
@@ -34,16 +34,12 @@ QgsTextDiagram *QgsTextDiagram::clone() const
 
 QSizeF QgsTextDiagram::diagramSize( const QgsFeature &feature, const QgsRenderContext &c, const QgsDiagramSettings &s, const QgsDiagramInterpolationSettings &is )
 {
-  QgsExpressionContext expressionContext = c.expressionContext();
-  expressionContext.setFeature( feature );
-  if ( !feature.fields().isEmpty() )
-    expressionContext.setFields( feature.fields() );
+  std::unique_ptr< QgsExpressionContext > expressionContext;
 
   QVariant attrVal;
   if ( is.classificationAttributeIsExpression )
   {
-    QgsExpression *expression = getExpression( is.classificationAttributeExpression, expressionContext );
-    attrVal = expression->evaluate( &expressionContext );
+    attrVal = attributeValue( is.classificationAttributeExpression, feature, c, expressionContext );
   }
   else
   {
@@ -197,15 +193,11 @@ void QgsTextDiagram::renderDiagram( const QgsFeature &feature, QgsRenderContext
   QFontMetricsF fontMetrics( sFont );
   p->setFont( sFont );
 
-  QgsExpressionContext expressionContext = c.expressionContext();
-  expressionContext.setFeature( feature );
-  if ( !feature.fields().isEmpty() )
-    expressionContext.setFields( feature.fields() );
+  std::unique_ptr< QgsExpressionContext > expressionContext;
 
   for ( int i = 0; i < textPositions.size(); ++i )
   {
-    QgsExpression *expression = getExpression( s.categoryAttributes.at( i ), expressionContext );
-    QString val = expression->evaluate( &expressionContext ).toString();
+    QString val = attributeValue( s.categoryAttributes.at( i ), feature, c, expressionContext ).toString();
 
     //find out dimensions
     double textWidth = fontMetrics.width( val );
@@ -59,6 +59,24 @@
 #include "pal/labelposition.h"
 
 #include <QIODevice>
+#include <QtConcurrentRun>
+
+///@cond PRIVATE
+
+/**
+ * Returns a key identifying the block written for the marker symbol layer \a ml of \a symbol,
+ * identical marker symbol layers share the same block.
+ */
+static QString markerBlockKey( const QgsMarkerSymbolLayer *ml, const QgsSymbol *symbol )
+{
+  QString key = ml->layerType() + QLatin1Char( '|' ) + QString::number( symbol->opacity() ) + QLatin1Char( '|' ) + QString::number( static_cast< int >( symbol->renderHints() ) );
+  const QgsStringMap properties = ml->properties();
+  for ( auto it = properties.constBegin(); it != properties.constEnd(); ++it )
+    key += QLatin1Char( '|' ) + it.key() + QLatin1Char( '=' ) + it.value();
+  return key;
+}
+
+///@endcond
 
 QgsDxfExport::QgsDxfExport() = default;
 
@@ -352,6 +370,8 @@ void QgsDxfExport::writeTables()
   }
 
   int i = 0;
+  // identical marker symbol layers share their block, see writeBlocks()
+  QSet< QString > markerBlockKeys;
   for ( const auto &symbolLayer : qgis::as_const( slList ) )
   {
     QgsMarkerSymbolLayer *ml = dynamic_cast< QgsMarkerSymbolLayer *>( symbolLayer.first );
@@ -361,6 +381,11 @@ void QgsDxfExport::writeTables()
     if ( hasDataDefinedProperties( ml, symbolLayer.second ) )
       continue;
 
+    const QString blockKey = markerBlockKey( ml, symbolLayer.second );
+    if ( markerBlockKeys.contains( blockKey ) )
+      continue;
+    markerBlockKeys << blockKey;
+
     QString name = QStringLiteral( "symbolLayer%1" ).arg( i++ );
     writeGroup( 0, QStringLiteral( "BLOCK_RECORD" ) );
     mBlockHandles.insert( name, writeHandle() );
@@ -576,6 +601,8 @@ void QgsDxfExport::writeBlocks()
     slList = symbolLayers( ct );
   }
 
+  // the blocks of identical marker symbol layers, in the order of the block records of writeTables()
+  QHash< QString, QString > markerBlocks;
   for ( const auto &symbolLayer : qgis::as_const( slList ) )
   {
     QgsMarkerSymbolLayer *ml = dynamic_cast< QgsMarkerSymbolLayer *>( symbolLayer.first );
@@ -591,7 +618,16 @@ void QgsDxfExport::writeBlocks()
       continue;
     }
 
+    const QString blockKey = markerBlockKey( ml, symbolLayer.second );
+    auto existingBlock = markerBlocks.constFind( blockKey );
+    if ( existingBlock != markerBlocks.constEnd() )
+    {
+      mPointSymbolBlocks.insert( ml, existingBlock.value() );
+      continue;
+    }
+
     QString block( QStringLiteral( "symbolLayer%1" ).arg( mBlockCounter++ ) );
+    markerBlocks.insert( blockKey, block );
     mBlockHandle = QStringLiteral( "%1" ).arg( mBlockHandles[ block ], 0, 16 );
 
     writeGroup( 0, QStringLiteral( "BLOCK" ) );
@@ -652,10 +688,15 @@ void QgsDxfExport::writeEntities()
     QgsFeatureRequest request = QgsFeatureRequest().setSubsetOfAttributes( job->attributes, job->fields ).setExpressionContext( job->renderContext.expressionContext() );
     request.setFilterRect( ct.transform( mExtent ) );
 
-    QgsFeatureIterator featureIt = job->featureSource.getFeatures( request );
+    // the features are read in a background thread while they are converted
+    DxfFeatureQueue featureQueue;
+    QFuture< void > featureReader = QtConcurrent::run( [&featureQueue, job, request]
+    {
+      featureQueue.fetch( job->featureSource.getFeatures( request ) );
+    } );
 
     QgsFeature fet;
-    while ( featureIt.nextFeature( fet ) )
+    while ( featureQueue.nextFeature( fet ) )
     {
       mRenderContext.expressionContext().setFeature( fet );
       QString lName( dxfLayerName( job->splitLayerAttribute.isNull() ? job->layerTitle : fet.attribute( job->splitLayerAttribute ).toString() ) );
@@ -731,6 +772,7 @@ void QgsDxfExport::writeEntities()
         }
       }
     }
+    featureReader.waitForFinished();
   }
 
   QImage image( 10, 10, QImage::Format_ARGB32_Premultiplied );
@@ -802,12 +844,17 @@ void QgsDxfExport::writeEntitiesSymbolLevels( DxfLayerJob *job )
   QgsCoordinateTransform ct( mMapSettings.destinationCrs(), job->crs, mMapSettings.transformContext() );
   req.setFilterRect( ct.transform( mExtent ) );
 
-  QgsFeatureIterator fit = job->featureSource.getFeatures( req );
+  // the features are read in a background thread while their symbols are evaluated
+  DxfFeatureQueue featureQueue;
+  QFuture< void > featureReader = QtConcurrent::run( [&featureQueue, job, req]
+  {
+    featureQueue.fetch( job->featureSource.getFeatures( req ) );
+  } );
 
   // fetch features
   QgsFeature fet;
   QgsSymbol *featureSymbol = nullptr;
-  while ( fit.nextFeature( fet ) )
+  while ( featureQueue.nextFeature( fet ) )
   {
     ctx.expressionContext().setFeature( fet );
     featureSymbol = job->renderer->symbolForFeature( fet, ctx );
@@ -823,6 +870,7 @@ void QgsDxfExport::writeEntitiesSymbolLevels( DxfLayerJob *job )
     }
     it.value().append( fet );
   }
+  featureReader.waitForFinished();
 
   // find out order
   QgsSymbolLevelOrder levels;
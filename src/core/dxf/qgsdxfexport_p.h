@@ -24,6 +24,10 @@
 #include "qgsvectorlayerlabeling.h"
 #include "qgslabelsink.h"
 
+#include <QMutex>
+#include <QQueue>
+#include <QWaitCondition>
+
 /**
  * Holds information about each layer in a DXF job.
  * This can be used for multithreading.
@@ -109,6 +113,79 @@ struct DxfLayerJob
     DxfLayerJob &operator=( const DxfLayerJob & ) = delete;
 };
 
+/**
+ * Passes the features of a layer read in a background thread to the DXF export, in
+ * chunks, so that reading the features overlaps with their conversion.
+ * At most MAX_CHUNKS chunks are waiting to be converted.
+ */
+class DxfFeatureQueue
+{
+  public:
+
+    //! Number of features in a chunk
+    static const int CHUNK_SIZE = 1000;
+
+    //! Maximum number of chunks read ahead
+    static const int MAX_CHUNKS = 4;
+
+    //! Reads all the features of \a iterator, to be called from the background thread
+    void fetch( QgsFeatureIterator iterator )
+    {
+      QgsFeatureList chunk;
+      chunk.reserve( CHUNK_SIZE );
+      QgsFeature feature;
+      while ( iterator.nextFeature( feature ) )
+      {
+        chunk << feature;
+        if ( chunk.size() == CHUNK_SIZE )
+        {
+          QMutexLocker locker( &mMutex );
+          while ( mChunks.size() >= MAX_CHUNKS )
+            mChunkTaken.wait( &mMutex );
+          mChunks.enqueue( chunk );
+          mChunkAdded.wakeAll();
+          chunk.clear();
+          chunk.reserve( CHUNK_SIZE );
+        }
+      }
+
+      QMutexLocker locker( &mMutex );
+      if ( !chunk.isEmpty() )
+        mChunks.enqueue( chunk );
+      mFinished = true;
+      mChunkAdded.wakeAll();
+    }
+
+    //! Takes the next \a feature, returns FALSE once all features were taken
+    bool nextFeature( QgsFeature &feature )
+    {
+      if ( mCurrentIndex >= mCurrentChunk.size() )
+      {
+        QMutexLocker locker( &mMutex );
+        while ( mChunks.isEmpty() && !mFinished )
+          mChunkAdded.wait( &mMutex );
+        if ( mChunks.isEmpty() )
+          return false;
+        mCurrentChunk = mChunks.dequeue();
+        mCurrentIndex = 0;
+        mChunkTaken.wakeAll();
+      }
+      feature = mCurrentChunk.at( mCurrentIndex++ );
+      return true;
+    }
+
+  private:
+    QMutex mMutex;
+    QWaitCondition mChunkAdded;
+    QWaitCondition mChunkTaken;
+    QQueue< QgsFeatureList > mChunks;
+    bool mFinished = false;
+
+    //! Chunk being converted, only used by the export thread
+    QgsFeatureList mCurrentChunk;
+    int mCurrentIndex = 0;
+};
+
 // dxf color palette
 static const int sDxfColors[][3] =
 {
@@ -23,6 +23,8 @@
 #include <QColor>
 #include <QPainter>
 
+#include <vector>
+
 //determined via trial-and-error. Could possibly be optimised, or varied
 //depending on the image size.
 #define BLOCK_THREADS 16
@@ -381,7 +383,7 @@ void QgsImageOperation::distanceTransform( QImage &image, const DistanceTransfor
   ConvertToArrayPixelOperation convertToArray( image.width(), array, properties.shadeExterior );
   runPixelOperation( image, convertToArray );
 
-  //calculate distance transform (single threaded only)
+  //calculate distance transform
   distanceTransform2d( array, image.width(), image.height() );
 
   double spread;
@@ -478,45 +480,51 @@ double QgsImageOperation::maxValueInDistanceTransformArray( const double *array,
 /* distance transform of 2d function using squared distance */
 void QgsImageOperation::distanceTransform2d( double *im, int width, int height )
 {
-  int maxDimension = std::max( width, height );
-
-  double *f = new double[ maxDimension ];
-  int *v = new int[ maxDimension ];
-  double *z = new double[ maxDimension + 1 ];
-  double *d = new double[ maxDimension ];
+  // the columns, then the rows, are transformed independently: large images are split
+  // in blocks of lines processed in threads, each with its own buffers
+  const int blockCount = width * height < 100000 ? 1 : BLOCK_THREADS;
 
-  // transform along columns
-  for ( int x = 0; x < width; x++ )
+  auto transformLines = [im, width, height, blockCount]( bool columns )
   {
-    for ( int y = 0; y < height; y++ )
-    {
-      f[y] = im[ x + y * width ];
-    }
-    distanceTransform1d( f, height, v, z, d );
-    for ( int y = 0; y < height; y++ )
-    {
-      im[ x + y * width ] = d[y];
-    }
-  }
+    const int lineCount = columns ? width : height;
+    const int lineLength = columns ? height : width;
+    const int stride = columns ? width : 1;
+    const int lineStride = columns ? 1 : width;
 
-  // transform along rows
-  for ( int y = 0; y < height; y++ )
-  {
-    for ( int x = 0; x < width; x++ )
-    {
-      f[x] = im[  x + y * width ];
-    }
-    distanceTransform1d( f, width, v, z, d );
-    for ( int x = 0; x < width; x++ )
+    QVector< int > blocks;
+    for ( int block = 0; block < blockCount; ++block )
+      blocks << block;
+
+    auto transformBlock = [ = ]( int block )
     {
-      im[  x + y * width ] = d[x];
-    }
-  }
+      std::vector< double > f( lineLength );
+      std::vector< int > v( lineLength );
+      std::vector< double > z( lineLength + 1 );
+      std::vector< double > d( lineLength );
+
+      const int begin = static_cast< int >( static_cast< qint64 >( lineCount ) * block / blockCount );
+      const int end = static_cast< int >( static_cast< qint64 >( lineCount ) * ( block + 1 ) / blockCount );
+      for ( int line = begin; line < end; ++line )
+      {
+        double *start = im + static_cast< qgssize >( line ) * lineStride;
+        for ( int i = 0; i < lineLength; ++i )
+          f[i] = start[ static_cast< qgssize >( i ) * stride ];
+        distanceTransform1d( f.data(), lineLength, v.data(), z.data(), d.data() );
+        for ( int i = 0; i < lineLength; ++i )
+          start[ static_cast< qgssize >( i ) * stride ] = d[i];
+      }
+    };
+
+    if ( blockCount == 1 )
+      transformBlock( 0 );
+    else
+      QtConcurrent::blockingMap( blocks, transformBlock );
+  };
 
-  delete [] d;
-  delete [] f;
-  delete [] v;
-  delete [] z;
+  // transform along columns
+  transformLines( true );
+  // transform along rows
+  transformLines( false );
 }
 
 void QgsImageOperation::ShadeFromArrayOperation::operator()( QRgb &rgb, const int x, const int y )
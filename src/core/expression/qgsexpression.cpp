@@ -25,6 +25,9 @@
 #include "qgsexpressioncontextutils.h"
 #include "qgsexpression_p.h"
 
+#include <QCache>
+#include <QMutex>
+
 // from parser
 extern QgsExpressionNode *parseExpression( const QString &str, QString &parserErrorMsg, QList<QgsExpression::ParserError> &parserErrors );
 
@@ -32,6 +35,50 @@ Q_GLOBAL_STATIC( HelpTextHash, sFunctionHelpTexts )
 Q_GLOBAL_STATIC( QgsStringMap, sVariableHelpTexts )
 Q_GLOBAL_STATIC( QgsStringMap, sGroups )
 
+///@cond PRIVATE
+
+/*
+ * Parsed expression trees, keyed by expression string and shared by all the expressions created
+ * from the same string (e.g. the same data defined property in every render job).
+ * Nodes in the cache are never prepared nor evaluated, each expression works on its own clone.
+ * The trees reference functions by index, so the cache is cleared whenever functions are
+ * registered or unregistered.
+ */
+typedef QCache< QString, QgsExpressionNode > ParsedExpressionCache;
+Q_GLOBAL_STATIC_WITH_ARGS( ParsedExpressionCache, sParsedExpressionCache, ( 1000 ) )
+Q_GLOBAL_STATIC( QMutex, sParsedExpressionCacheMutex )
+static int sParsedExpressionCacheGeneration = 0;
+
+static QgsExpressionNode *parseExpressionCached( const QString &str, QString &parserErrorMsg, QList<QgsExpression::ParserError> &parserErrors )
+{
+  int generation = 0;
+  {
+    QMutexLocker locker( sParsedExpressionCacheMutex() );
+    if ( const QgsExpressionNode *node = sParsedExpressionCache()->object( str ) )
+      return node->clone();
+    generation = sParsedExpressionCacheGeneration;
+  }
+
+  QgsExpressionNode *node = ::parseExpression( str, parserErrorMsg, parserErrors );
+  if ( node )
+  {
+    QMutexLocker locker( sParsedExpressionCacheMutex() );
+    // functions may have been (un)registered while parsing
+    if ( generation == sParsedExpressionCacheGeneration )
+      sParsedExpressionCache()->insert( str, node->clone() );
+  }
+  return node;
+}
+
+///@endcond
+
+void QgsExpression::clearParsedExpressionCache()
+{
+  QMutexLocker locker( sParsedExpressionCacheMutex() );
+  sParsedExpressionCache()->clear();
+  sParsedExpressionCacheGeneration++;
+}
+
 HelpTextHash &functionHelpTexts()
 {
   return *sFunctionHelpTexts();
@@ -48,10 +95,11 @@ bool QgsExpression::checkExpression( const QString &text, const QgsExpressionCon
 void QgsExpression::setExpression( const QString &expression )
 {
   detach();
-  d->mRootNode = ::parseExpression( expression, d->mParserErrorString, d->mParserErrors );
+  d->mRootNode = parseExpressionCached( expression, d->mParserErrorString, d->mParserErrors );
   d->mEvalErrorString = QString();
   d->mExp = expression;
   d->mIsPrepared = false;
+  d->mProgram.reset();
 }
 
 QString QgsExpression::expression() const
@@ -146,7 +194,7 @@ int QgsExpression::functionCount()
 QgsExpression::QgsExpression( const QString &expr )
   : d( new QgsExpressionPrivate )
 {
-  d->mRootNode = ::parseExpression( expr, d->mParserErrorString, d->mParserErrors );
+  d->mRootNode = parseExpressionCached( expr, d->mParserErrorString, d->mParserErrors );
   d->mExp = expr;
   Q_ASSERT( !d->mParserErrorString.isNull() || d->mRootNode );
 }
@@ -324,12 +372,13 @@ bool QgsExpression::prepare( const QgsExpressionContext *context )
 {
   detach();
   d->mEvalErrorString = QString();
+  d->mProgram.reset();
   if ( !d->mRootNode )
   {
     //re-parse expression. Creation of QgsExpressionContexts may have added extra
     //known functions since this expression was created, so we have another try
     //at re-parsing it now that the context must have been created
-    d->mRootNode = ::parseExpression( d->mExp, d->mParserErrorString, d->mParserErrors );
+    d->mRootNode = parseExpressionCached( d->mExp, d->mParserErrorString, d->mParserErrors );
   }
 
   if ( !d->mRootNode )
@@ -340,7 +389,11 @@ bool QgsExpression::prepare( const QgsExpressionContext *context )
 
   initGeomCalculator( context );
   d->mIsPrepared = true;
-  return d->mRootNode->prepare( this, context );
+  if ( !d->mRootNode->prepare( this, context ) )
+    return false;
+
+  d->mProgram = QgsExpressionProgram::compile( d->mRootNode, context );
+  return true;
 }
 
 QVariant QgsExpression::evaluate()
@@ -368,6 +421,8 @@ QVariant QgsExpression::evaluate( const QgsExpressionContext *context )
   {
     prepare( context );
   }
+  if ( d->mProgram )
+    return d->mProgram->evaluate( this, context );
   return d->mRootNode->eval( this, context );
 }
 
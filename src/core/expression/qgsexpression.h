@@ -501,6 +501,18 @@ class CORE_EXPORT QgsExpression
      */
     static void cleanRegisteredFunctions();
 
+    /**
+     * Clears the process wide cache of parsed expressions.
+     *
+     * Expressions created from the same string share their parsed form, which is cloned
+     * instead of parsing the string again. The cache is cleared automatically whenever
+     * functions are registered or unregistered, fields are only resolved by prepare()
+     * and are not part of the cached state.
+     *
+     * \since QGIS 3.16
+     */
+    static void clearParsedExpressionCache();
+
     //! tells whether the identifier is a name of existing function
     static bool isFunctionName( const QString &name );
 
@@ -24,6 +24,7 @@
 #include "qgsdistancearea.h"
 #include "qgsunittypes.h"
 #include "qgsexpressionnode.h"
+#include "qgsexpressionprogram_p.h"
 
 ///@cond
 
@@ -81,6 +82,9 @@ class QgsExpressionPrivate
     //! Whether prepare() has been called before evaluate()
     bool mIsPrepared = false;
 
+    //! Compiled form of the prepared tree, if any. Not shared with copies, which need to be prepared again.
+    std::unique_ptr<QgsExpressionProgram> mProgram;
+
     QgsExpressionPrivate &operator= ( const QgsExpressionPrivate & ) = delete;
 };
 
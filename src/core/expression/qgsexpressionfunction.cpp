@@ -4900,10 +4900,39 @@ static QVariant fcnGetFeatureById( const QVariantList &values, const QgsExpressi
   return result;
 }
 
+//! Number of queries of get_feature() on a layer and attribute after which all the features are indexed
+static const int GET_FEATURE_INDEX_MIN_LOOKUPS = 10;
+//! Maximum number of features indexed for get_feature()
+static const int GET_FEATURE_INDEX_MAX_FEATURES = 100000;
+
 static QVariant fcnGetFeature( const QVariantList &values, const QgsExpressionContext *context, QgsExpression *parent, const QgsExpressionNodeFunction * )
 {
   //arguments: 1. layer id / name, 2. key attribute, 3. eq value
 
+  QString attribute = QgsExpressionUtils::getStringValue( values.at( 1 ), parent );
+  const QVariant &attVal = values.at( 2 );
+
+  // the cached values are checked before creating the feature source, which is costly
+  // outside of the main thread
+  const bool useCache = context && values.at( 0 ).type() == QVariant::String;
+  const QString cacheValueKey = QStringLiteral( "getfeature:%1:%2:%3" ).arg( values.at( 0 ).toString(), attribute, attVal.toString() );
+  const QString cacheIndexKey = QStringLiteral( "getfeature_index:%1:%2" ).arg( values.at( 0 ).toString(), attribute );
+  if ( useCache )
+  {
+    if ( context->hasCachedValue( cacheValueKey ) )
+      return context->cachedValue( cacheValueKey );
+
+    // features with NULL values are not indexed, they are never equal to the value
+    const QVariant index = context->cachedValue( cacheIndexKey );
+    if ( index.type() == QVariant::Map )
+    {
+      const QVariantMap features = index.toMap();
+      auto it = features.constFind( attVal.toString() );
+      if ( it != features.constEnd() )
+        return *it;
+    }
+  }
+
   std::unique_ptr<QgsVectorLayerFeatureSource> featureSource = QgsExpressionUtils::getFeatureSource( values.at( 0 ), parent );
 
   //no layer found
@@ -4912,19 +4941,53 @@ static QVariant fcnGetFeature( const QVariantList &values, const QgsExpressionCo
     return QVariant();
   }
 
-  QString attribute = QgsExpressionUtils::getStringValue( values.at( 1 ), parent );
   int attributeId = featureSource->fields().lookupField( attribute );
   if ( attributeId == -1 )
   {
     return QVariant();
   }
 
-  const QVariant &attVal = values.at( 2 );
+  const QString sourceCacheValueKey = QStringLiteral( "getfeature:%1:%2:%3" ).arg( featureSource->id(), QString::number( attributeId ), attVal.toString() );
+  if ( context && !useCache && context->hasCachedValue( sourceCacheValueKey ) )
+  {
+    return context->cachedValue( sourceCacheValueKey );
+  }
 
-  const QString cacheValueKey = QStringLiteral( "getfeature:%1:%2:%3" ).arg( featureSource->id(), QString::number( attributeId ), attVal.toString() );
-  if ( context && context->hasCachedValue( cacheValueKey ) )
+  // after a few lookups, the features of small layers are indexed by the value of the
+  // attribute, for the remaining lookups of the evaluation
+  if ( useCache && !context->hasCachedValue( cacheIndexKey ) )
   {
-    return context->cachedValue( cacheValueKey );
+    const QString cacheLookupsKey = QStringLiteral( "getfeature_lookups:%1:%2" ).arg( values.at( 0 ).toString(), attribute );
+    const int lookups = context->cachedValue( cacheLookupsKey ).toInt() + 1;
+    context->setCachedValue( cacheLookupsKey, lookups );
+    if ( lookups >= GET_FEATURE_INDEX_MIN_LOOKUPS )
+    {
+      QgsFeatureRequest indexRequest;
+      indexRequest.setLimit( GET_FEATURE_INDEX_MAX_FEATURES + 1 );
+      indexRequest.setTimeout( 10000 );
+      indexRequest.setRequestMayBeNested( true );
+      if ( !parent->needsGeometry() )
+      {
+        indexRequest.setFlags( QgsFeatureRequest::NoGeometry );
+      }
+      QgsFeatureIterator indexIt = featureSource->getFeatures( indexRequest );
+
+      QVariantMap features;
+      QgsFeature fet;
+      int featureCount = 0;
+      while ( indexIt.nextFeature( fet ) && ++featureCount <= GET_FEATURE_INDEX_MAX_FEATURES )
+      {
+        const QVariant value = fet.attribute( attributeId );
+        if ( !value.isNull() && !features.contains( value.toString() ) )
+          features.insert( value.toString(), QVariant::fromValue( fet ) );
+      }
+
+      // a null value marks the layers too large to be indexed
+      context->setCachedValue( cacheIndexKey, featureCount <= GET_FEATURE_INDEX_MAX_FEATURES ? QVariant( features ) : QVariant() );
+      auto it = features.constFind( attVal.toString() );
+      if ( featureCount <= GET_FEATURE_INDEX_MAX_FEATURES && it != features.constEnd() )
+        return *it;
+    }
   }
 
   QgsFeatureRequest req;
@@ -4947,7 +5010,7 @@ static QVariant fcnGetFeature( const QVariantList &values, const QgsExpressionCo
   }
 
   if ( context )
-    context->setCachedValue( cacheValueKey, res );
+    context->setCachedValue( useCache ? cacheValueKey : sourceCacheValueKey, res );
   return res;
 }
 
@@ -6618,6 +6681,7 @@ bool QgsExpression::registerFunction( QgsExpressionFunction *function, bool tran
   sFunctions()->append( function );
   if ( transferOwnership )
     sOwnedFunctions()->append( function );
+  clearParsedExpressionCache();
   return true;
 }
 
@@ -6632,6 +6696,7 @@ bool QgsExpression::unregisterFunction( const QString &name )
   if ( fnIdx != -1 )
   {
     sFunctions()->removeAt( fnIdx );
+    clearParsedExpressionCache();
     return true;
   }
   return false;
@@ -6641,6 +6706,7 @@ void QgsExpression::cleanRegisteredFunctions()
 {
   qDeleteAll( *sOwnedFunctions() );
   sOwnedFunctions()->clear();
+  clearParsedExpressionCache();
 }
 
 const QStringList &QgsExpression::BuiltinFunctions()
@@ -0,0 +1,578 @@
+/***************************************************************************
+                         qgsexpressionprogram.cpp
+                         ------------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsexpressionprogram_p.h"
+#include "qgsexpression.h"
+#include "qgsexpressioncontext.h"
+#include "qgsexpressionutils.h"
+#include "qgsfeature.h"
+
+#include <QVarLengthArray>
+#include <cmath>
+
+///@cond PRIVATE
+
+QgsExpressionProgram::Value QgsExpressionProgram::Value::fromVariant( const QVariant &variant )
+{
+  Value value;
+  value.v = variant;
+  value.boxed = true;
+  if ( variant.isNull() )
+    return value;
+
+  switch ( variant.type() )
+  {
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+      value.kind = Integer;
+      value.i = variant.toLongLong();
+      value.d = variant.toDouble();
+      break;
+
+    case QVariant::Double:
+      value.kind = Double;
+      value.d = variant.toDouble();
+      break;
+
+    default:
+      break;
+  }
+  return value;
+}
+
+QgsExpressionProgram::Value QgsExpressionProgram::Value::fromInteger( qlonglong integer )
+{
+  Value value;
+  value.kind = Integer;
+  value.i = integer;
+  value.d = static_cast< double >( integer );
+  return value;
+}
+
+QgsExpressionProgram::Value QgsExpressionProgram::Value::fromDouble( double number )
+{
+  Value value;
+  value.kind = Double;
+  value.d = number;
+  return value;
+}
+
+QVariant QgsExpressionProgram::Value::toVariant() const
+{
+  if ( boxed )
+    return v;
+
+  switch ( kind )
+  {
+    case Integer:
+      return QVariant( i );
+    case Double:
+      return QVariant( d );
+    case Other:
+      break;
+  }
+  return v;
+}
+
+static const QgsExpressionProgram::Value &tvlValue( QgsExpressionUtils::TVL tvl );
+
+std::unique_ptr<QgsExpressionProgram> QgsExpressionProgram::compile( QgsExpressionNode *root, const QgsExpressionContext *context )
+{
+  if ( !root )
+    return nullptr;
+
+  std::unique_ptr< QgsExpressionProgram > program( new QgsExpressionProgram() );
+  if ( !program->compileNode( root, context ) || program->mNativeOperations == 0 )
+    return nullptr;
+
+  program->mInstructions.squeeze();
+  program->mConstants.squeeze();
+  return program;
+}
+
+void QgsExpressionProgram::addInstruction( Instruction::Code code, int argument, QgsExpressionNode *node )
+{
+  mInstructions.append( Instruction{ code, argument, node } );
+}
+
+bool QgsExpressionProgram::isNativeBinaryOperator( QgsExpressionNodeBinaryOperator::BinaryOperator op )
+{
+  switch ( op )
+  {
+    case QgsExpressionNodeBinaryOperator::boOr:
+    case QgsExpressionNodeBinaryOperator::boAnd:
+    case QgsExpressionNodeBinaryOperator::boEQ:
+    case QgsExpressionNodeBinaryOperator::boNE:
+    case QgsExpressionNodeBinaryOperator::boLE:
+    case QgsExpressionNodeBinaryOperator::boGE:
+    case QgsExpressionNodeBinaryOperator::boLT:
+    case QgsExpressionNodeBinaryOperator::boGT:
+    case QgsExpressionNodeBinaryOperator::boIs:
+    case QgsExpressionNodeBinaryOperator::boIsNot:
+    case QgsExpressionNodeBinaryOperator::boPlus:
+    case QgsExpressionNodeBinaryOperator::boMinus:
+    case QgsExpressionNodeBinaryOperator::boMul:
+    case QgsExpressionNodeBinaryOperator::boDiv:
+    case QgsExpressionNodeBinaryOperator::boIntDiv:
+    case QgsExpressionNodeBinaryOperator::boMod:
+    case QgsExpressionNodeBinaryOperator::boPow:
+      return true;
+
+    case QgsExpressionNodeBinaryOperator::boRegexp:
+    case QgsExpressionNodeBinaryOperator::boLike:
+    case QgsExpressionNodeBinaryOperator::boNotLike:
+    case QgsExpressionNodeBinaryOperator::boILike:
+    case QgsExpressionNodeBinaryOperator::boNotILike:
+    case QgsExpressionNodeBinaryOperator::boConcat:
+      break;
+  }
+  return false;
+}
+
+bool QgsExpressionProgram::compileNode( QgsExpressionNode *node, const QgsExpressionContext *context )
+{
+  if ( node->hasCachedStaticValue() )
+  {
+    mConstants.append( Value::fromVariant( node->cachedStaticValue() ) );
+    addInstruction( Instruction::Constant, mConstants.size() - 1 );
+    return true;
+  }
+
+  switch ( node->nodeType() )
+  {
+    case QgsExpressionNode::ntLiteral:
+    {
+      mConstants.append( Value::fromVariant( static_cast< QgsExpressionNodeLiteral * >( node )->value() ) );
+      addInstruction( Instruction::Constant, mConstants.size() - 1 );
+      return true;
+    }
+
+    case QgsExpressionNode::ntColumnRef:
+    {
+      // resolve the index the same way QgsExpressionNodeColumnRef::prepareNode() does
+      const QString name = static_cast< QgsExpressionNodeColumnRef * >( node )->name();
+      int index = -1;
+      if ( context && context->hasVariable( QgsExpressionContext::EXPR_FIELDS ) )
+      {
+        const QgsFields fields = qvariant_cast<QgsFields>( context->variable( QgsExpressionContext::EXPR_FIELDS ) );
+        index = fields.lookupField( name );
+        if ( index == -1 && context->hasFeature() )
+          index = context->feature().fieldNameIndex( name );
+      }
+
+      if ( index >= 0 )
+        addInstruction( Instruction::Field, index, node );
+      else
+        addInstruction( Instruction::Node, 0, node );
+      return true;
+    }
+
+    case QgsExpressionNode::ntBinaryOperator:
+    {
+      QgsExpressionNodeBinaryOperator *binary = static_cast< QgsExpressionNodeBinaryOperator * >( node );
+      const QgsExpressionNodeBinaryOperator::BinaryOperator op = binary->op();
+      if ( !isNativeBinaryOperator( op ) )
+        break;
+
+      if ( !compileNode( binary->opLeft(), context ) )
+        return false;
+
+      int jump = -1;
+      if ( op == QgsExpressionNodeBinaryOperator::boAnd || op == QgsExpressionNodeBinaryOperator::boOr )
+      {
+        jump = mInstructions.size();
+        addInstruction( op == QgsExpressionNodeBinaryOperator::boAnd ? Instruction::AndJump : Instruction::OrJump );
+      }
+
+      if ( !compileNode( binary->opRight(), context ) )
+        return false;
+
+      addInstruction( Instruction::Binary, op, node );
+      if ( jump >= 0 )
+        mInstructions[ jump ].argument = mInstructions.size();
+      mNativeOperations++;
+      return true;
+    }
+
+    case QgsExpressionNode::ntUnaryOperator:
+    {
+      QgsExpressionNodeUnaryOperator *unary = static_cast< QgsExpressionNodeUnaryOperator * >( node );
+      if ( !compileNode( unary->operand(), context ) )
+        return false;
+
+      addInstruction( Instruction::Unary, unary->op(), node );
+      mNativeOperations++;
+      return true;
+    }
+
+    case QgsExpressionNode::ntInOperator:
+    case QgsExpressionNode::ntFunction:
+    case QgsExpressionNode::ntCondition:
+    case QgsExpressionNode::ntIndexOperator:
+      break;
+  }
+
+  // evaluated through the tree
+  addInstruction( Instruction::Node, 0, node );
+  return true;
+}
+
+static bool numericTvl( const QgsExpressionProgram::Value &value, QgsExpressionUtils::TVL &tvl );
+
+bool QgsExpressionProgram::evaluateBinary( QgsExpressionNodeBinaryOperator::BinaryOperator op, const Value &left, const Value &right, Value &result )
+{
+  switch ( op )
+  {
+    case QgsExpressionNodeBinaryOperator::boAnd:
+    case QgsExpressionNodeBinaryOperator::boOr:
+    {
+      QgsExpressionUtils::TVL tvlL;
+      QgsExpressionUtils::TVL tvlR;
+      if ( !numericTvl( left, tvlL ) || !numericTvl( right, tvlR ) )
+        return false;
+      result = tvlValue( op == QgsExpressionNodeBinaryOperator::boAnd ? QgsExpressionUtils::AND[tvlL][tvlR] : QgsExpressionUtils::OR[tvlL][tvlR] );
+      return true;
+    }
+
+    case QgsExpressionNodeBinaryOperator::boEQ:
+    case QgsExpressionNodeBinaryOperator::boNE:
+    case QgsExpressionNodeBinaryOperator::boLE:
+    case QgsExpressionNodeBinaryOperator::boGE:
+    case QgsExpressionNodeBinaryOperator::boLT:
+    case QgsExpressionNodeBinaryOperator::boGT:
+    {
+      if ( left.isNull() || right.isNull() )
+      {
+        result = tvlValue( QgsExpressionUtils::Unknown );
+        return true;
+      }
+      if ( !left.isNumeric() || !right.isNumeric() )
+        return false;
+
+      const double diff = left.d - right.d;
+      bool res = false;
+      switch ( op )
+      {
+        case QgsExpressionNodeBinaryOperator::boEQ:
+          res = qgsDoubleNear( diff, 0.0 );
+          break;
+        case QgsExpressionNodeBinaryOperator::boNE:
+          res = !qgsDoubleNear( diff, 0.0 );
+          break;
+        case QgsExpressionNodeBinaryOperator::boLT:
+          res = diff < 0;
+          break;
+        case QgsExpressionNodeBinaryOperator::boGT:
+          res = diff > 0;
+          break;
+        case QgsExpressionNodeBinaryOperator::boLE:
+          res = diff <= 0;
+          break;
+        default:
+          res = diff >= 0;
+          break;
+      }
+      result = tvlValue( res ? QgsExpressionUtils::True : QgsExpressionUtils::False );
+      return true;
+    }
+
+    case QgsExpressionNodeBinaryOperator::boIs:
+    case QgsExpressionNodeBinaryOperator::boIsNot:
+    {
+      bool equal = false;
+      if ( left.isNull() || right.isNull() )
+        equal = left.isNull() && right.isNull();
+      else if ( left.isNumeric() && right.isNumeric() )
+        equal = qgsDoubleNear( left.d, right.d );
+      else
+        return false;
+
+      result = tvlValue( equal == ( op == QgsExpressionNodeBinaryOperator::boIs ) ? QgsExpressionUtils::True : QgsExpressionUtils::False );
+      return true;
+    }
+
+    case QgsExpressionNodeBinaryOperator::boPlus:
+    case QgsExpressionNodeBinaryOperator::boMinus:
+    case QgsExpressionNodeBinaryOperator::boMul:
+    case QgsExpressionNodeBinaryOperator::boDiv:
+    case QgsExpressionNodeBinaryOperator::boMod:
+    {
+      // string concatenation with + also applies to NULL strings
+      if ( op == QgsExpressionNodeBinaryOperator::boPlus && left.kind == Value::Other && right.kind == Value::Other
+           && left.v.type() == QVariant::String && right.v.type() == QVariant::String )
+        return false;
+
+      if ( left.isNull() || right.isNull() )
+      {
+        result = Value::fromVariant( QVariant() );
+        return true;
+      }
+      if ( !left.isNumeric() || !right.isNumeric() )
+        return false;
+
+      if ( op != QgsExpressionNodeBinaryOperator::boDiv && left.kind == Value::Integer && right.kind == Value::Integer )
+      {
+        switch ( op )
+        {
+          case QgsExpressionNodeBinaryOperator::boPlus:
+            result = Value::fromInteger( left.i + right.i );
+            break;
+          case QgsExpressionNodeBinaryOperator::boMinus:
+            result = Value::fromInteger( left.i - right.i );
+            break;
+          case QgsExpressionNodeBinaryOperator::boMul:
+            result = Value::fromInteger( left.i * right.i );
+            break;
+          default:
+            if ( right.i == 0 )
+              result = Value::fromVariant( QVariant() );
+            else
+              result = Value::fromInteger( left.i % right.i );
+            break;
+        }
+        return true;
+      }
+
+      switch ( op )
+      {
+        case QgsExpressionNodeBinaryOperator::boPlus:
+          result = Value::fromDouble( left.d + right.d );
+          break;
+        case QgsExpressionNodeBinaryOperator::boMinus:
+          result = Value::fromDouble( left.d - right.d );
+          break;
+        case QgsExpressionNodeBinaryOperator::boMul:
+          result = Value::fromDouble( left.d * right.d );
+          break;
+        case QgsExpressionNodeBinaryOperator::boDiv:
+          // silently handle division by zero and return NULL
+          result = right.d == 0. ? Value::fromVariant( QVariant() ) : Value::fromDouble( left.d / right.d );
+          break;
+        default:
+          result = right.d == 0. ? Value::fromVariant( QVariant() ) : Value::fromDouble( std::fmod( left.d, right.d ) );
+          break;
+      }
+      return true;
+    }
+
+    case QgsExpressionNodeBinaryOperator::boIntDiv:
+    {
+      // NULL operands are converted to 0 by the tree, leave that to it
+      if ( !left.isNumeric() || !right.isNumeric() )
+        return false;
+      result = right.d == 0. ? Value::fromVariant( QVariant() ) : Value::fromInteger( qlonglong( std::floor( left.d / right.d ) ) );
+      return true;
+    }
+
+    case QgsExpressionNodeBinaryOperator::boPow:
+    {
+      if ( left.isNull() || right.isNull() )
+      {
+        result = Value::fromVariant( QVariant() );
+        return true;
+      }
+      if ( !left.isNumeric() || !right.isNumeric() )
+        return false;
+      result = Value::fromDouble( std::pow( left.d, right.d ) );
+      return true;
+    }
+
+    case QgsExpressionNodeBinaryOperator::boRegexp:
+    case QgsExpressionNodeBinaryOperator::boLike:
+    case QgsExpressionNodeBinaryOperator::boNotLike:
+    case QgsExpressionNodeBinaryOperator::boILike:
+    case QgsExpressionNodeBinaryOperator::boNotILike:
+    case QgsExpressionNodeBinaryOperator::boConcat:
+      break;
+  }
+  return false;
+}
+
+bool QgsExpressionProgram::evaluateUnary( QgsExpressionNodeUnaryOperator::UnaryOperator op, const Value &value, Value &result )
+{
+  switch ( op )
+  {
+    case QgsExpressionNodeUnaryOperator::uoNot:
+    {
+      QgsExpressionUtils::TVL tvl;
+      if ( !numericTvl( value, tvl ) )
+        return false;
+      result = tvlValue( QgsExpressionUtils::NOT[tvl] );
+      return true;
+    }
+
+    case QgsExpressionNodeUnaryOperator::uoMinus:
+      if ( value.kind == Value::Integer )
+        result = Value::fromInteger( -value.i );
+      else if ( value.kind == Value::Double )
+        result = Value::fromDouble( -value.d );
+      else
+        return false;
+      return true;
+  }
+  return false;
+}
+
+QVariant QgsExpressionProgram::evaluate( QgsExpression *parent, const QgsExpressionContext *context ) const
+{
+  QVarLengthArray< Value, 16 > stack;
+  QgsFeature feature;
+  bool hasFeature = false;
+
+  const int count = mInstructions.size();
+  for ( int pc = 0; pc < count; ++pc )
+  {
+    const Instruction &instruction = mInstructions.at( pc );
+    switch ( instruction.code )
+    {
+      case Instruction::Constant:
+        stack.append( mConstants.at( instruction.argument ) );
+        break;
+
+      case Instruction::Field:
+        if ( !hasFeature && context )
+        {
+          feature = context->feature();
+          hasFeature = true;
+        }
+        if ( feature.isValid() )
+        {
+          stack.append( Value::fromVariant( feature.attribute( instruction.argument ) ) );
+          break;
+        }
+        // let the node report the missing feature
+        FALLTHROUGH
+
+      case Instruction::Node:
+      {
+        const QVariant value = instruction.node->eval( parent, context );
+        if ( parent->hasEvalError() )
+          return QVariant();
+        stack.append( Value::fromVariant( value ) );
+        break;
+      }
+
+      case Instruction::AndJump:
+      case Instruction::OrJump:
+      {
+        const Value &top = stack.last();
+        QgsExpressionUtils::TVL tvl;
+        if ( !numericTvl( top, tvl ) )
+        {
+          tvl = QgsExpressionUtils::getTVLValue( top.v, parent );
+          if ( parent->hasEvalError() )
+            return QVariant();
+        }
+
+        // shortcut -- no need to evaluate right-hand side
+        if ( instruction.code == Instruction::AndJump && tvl == QgsExpressionUtils::False )
+        {
+          stack.last() = tvlValue( QgsExpressionUtils::False );
+          pc = instruction.argument - 1;
+        }
+        else if ( instruction.code == Instruction::OrJump && tvl == QgsExpressionUtils::True )
+        {
+          stack.last() = tvlValue( QgsExpressionUtils::True );
+          pc = instruction.argument - 1;
+        }
+        break;
+      }
+
+      case Instruction::Binary:
+      {
+        const QgsExpressionNodeBinaryOperator::BinaryOperator op = static_cast< QgsExpressionNodeBinaryOperator::BinaryOperator >( instruction.argument );
+        const Value right = stack.last();
+        stack.removeLast();
+        Value &left = stack.last();
+
+        Value result;
+        if ( !evaluateBinary( op, left, right, result ) )
+        {
+          // operand types which are not handled natively, use the regular operator node
+          QgsExpressionNodeBinaryOperator node( op, new QgsExpressionNodeLiteral( left.toVariant() ), new QgsExpressionNodeLiteral( right.toVariant() ) );
+          const QVariant value = node.eval( parent, context );
+          if ( parent->hasEvalError() )
+            return QVariant();
+          result = Value::fromVariant( value );
+        }
+        left = result;
+        break;
+      }
+
+      case Instruction::Unary:
+      {
+        const QgsExpressionNodeUnaryOperator::UnaryOperator op = static_cast< QgsExpressionNodeUnaryOperator::UnaryOperator >( instruction.argument );
+        Value &operand = stack.last();
+
+        Value result;
+        if ( !evaluateUnary( op, operand, result ) )
+        {
+          QgsExpressionNodeUnaryOperator node( op, new QgsExpressionNodeLiteral( operand.toVariant() ) );
+          const QVariant value = node.eval( parent, context );
+          if ( parent->hasEvalError() )
+            return QVariant();
+          result = Value::fromVariant( value );
+        }
+        operand = result;
+        break;
+      }
+    }
+  }
+
+  Q_ASSERT( stack.size() == 1 );
+  return stack.last().toVariant();
+}
+
+/**
+ * Returns the value matching \a tvl, identical to the TVL_True, TVL_False and TVL_Unknown
+ * variants returned by the expression nodes.
+ */
+static const QgsExpressionProgram::Value &tvlValue( QgsExpressionUtils::TVL tvl )
+{
+  static const QgsExpressionProgram::Value sFalse = QgsExpressionProgram::Value::fromVariant( TVL_False );
+  static const QgsExpressionProgram::Value sTrue = QgsExpressionProgram::Value::fromVariant( TVL_True );
+  static const QgsExpressionProgram::Value sUnknown = QgsExpressionProgram::Value::fromVariant( TVL_Unknown );
+  switch ( tvl )
+  {
+    case QgsExpressionUtils::False:
+      return sFalse;
+    case QgsExpressionUtils::True:
+      return sTrue;
+    case QgsExpressionUtils::Unknown:
+      break;
+  }
+  return sUnknown;
+}
+
+/**
+ * Converts NULL and numeric values to a TVL, the same way QgsExpressionUtils::getTVLValue() does.
+ * Returns FALSE for other values.
+ */
+static bool numericTvl( const QgsExpressionProgram::Value &value, QgsExpressionUtils::TVL &tvl )
+{
+  if ( value.isNull() )
+    tvl = QgsExpressionUtils::Unknown;
+  else if ( value.kind == QgsExpressionProgram::Value::Integer )
+    tvl = value.i != 0 ? QgsExpressionUtils::True : QgsExpressionUtils::False;
+  else if ( value.kind == QgsExpressionProgram::Value::Double )
+    tvl = !qgsDoubleNear( value.d, 0.0 ) ? QgsExpressionUtils::True : QgsExpressionUtils::False;
+  else
+    return false;
+  return true;
+}
+
+///@endcond
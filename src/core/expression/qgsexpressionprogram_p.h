@@ -0,0 +1,138 @@
+/***************************************************************************
+                         qgsexpressionprogram_p.h
+                         ------------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSEXPRESSIONPROGRAM_P_H
+#define QGSEXPRESSIONPROGRAM_P_H
+
+#define SIP_NO_FILE
+
+#include <QVariant>
+#include <QVector>
+#include <memory>
+
+#include "qgsexpressionnodeimpl.h"
+
+class QgsExpression;
+class QgsExpressionContext;
+
+///@cond PRIVATE
+
+/**
+ * A flat, postfix form of a prepared expression tree.
+ *
+ * The program is built by QgsExpression::prepare() from the prepared node tree and
+ * evaluates arithmetic, comparison and logical operators over unboxed numeric values
+ * with a small value stack instead of recursing through the nodes and boxing every
+ * intermediate result in a QVariant. Static subtrees are folded to constants and
+ * field references are read straight from the attribute index resolved during
+ * preparation.
+ *
+ * Any node which is not handled natively (functions, conditions, IN, LIKE...) is
+ * evaluated through the node tree, and operands of unexpected types are passed on to
+ * the regular operator nodes, so results are identical to evaluating the tree.
+ *
+ * A program references the nodes of the tree it was compiled from and must not
+ * outlive it. Evaluation does not modify the program.
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.16
+ */
+class QgsExpressionProgram
+{
+  public:
+
+    /**
+     * Compiles a program for the prepared tree starting at \a root.
+     *
+     * Returns NULLPTR if the expression would not benefit from a compiled program,
+     * e.g. because it does not contain any natively handled operators.
+     */
+    static std::unique_ptr< QgsExpressionProgram > compile( QgsExpressionNode *root, const QgsExpressionContext *context );
+
+    /**
+     * Evaluates the program for the given \a context. Evaluation errors are reported to
+     * \a parent, exactly as the node tree would.
+     */
+    QVariant evaluate( QgsExpression *parent, const QgsExpressionContext *context ) const;
+
+    //! Returns the number of instructions in the program
+    int size() const { return mInstructions.size(); }
+
+    /**
+     * A value on the evaluation stack. Numeric values are kept unboxed.
+     */
+    struct Value
+    {
+      enum Kind
+      {
+        Integer,
+        Double,
+        Other,
+      };
+
+      Kind kind = Other;
+      qlonglong i = 0;
+      double d = 0;
+
+      //! Boxed value, always set for Other values and optional for the numeric kinds
+      QVariant v;
+      bool boxed = false;
+
+      static Value fromVariant( const QVariant &variant );
+      static Value fromInteger( qlonglong value );
+      static Value fromDouble( double value );
+
+      bool isNull() const { return kind == Other && v.isNull(); }
+      bool isNumeric() const { return kind != Other; }
+      QVariant toVariant() const;
+    };
+
+  private:
+
+    struct Instruction
+    {
+      enum Code
+      {
+        Constant, //!< Pushes constant number argument
+        Field, //!< Pushes the feature's attribute at index argument
+        Node, //!< Evaluates node through the tree and pushes its value
+        Binary, //!< Pops two values and pushes the result of binary operator argument
+        Unary, //!< Pops a value and pushes the result of unary operator argument
+        AndJump, //!< Replaces a FALSE top value by FALSE and jumps to instruction argument
+        OrJump, //!< Replaces a TRUE top value by TRUE and jumps to instruction argument
+      };
+
+      Code code;
+      int argument;
+      QgsExpressionNode *node;
+    };
+
+    QgsExpressionProgram() = default;
+
+    bool compileNode( QgsExpressionNode *node, const QgsExpressionContext *context );
+    void addInstruction( Instruction::Code code, int argument = 0, QgsExpressionNode *node = nullptr );
+
+    static bool isNativeBinaryOperator( QgsExpressionNodeBinaryOperator::BinaryOperator op );
+    static bool evaluateBinary( QgsExpressionNodeBinaryOperator::BinaryOperator op, const Value &left, const Value &right, Value &result );
+    static bool evaluateUnary( QgsExpressionNodeUnaryOperator::UnaryOperator op, const Value &value, Value &result );
+
+    QVector< Instruction > mInstructions;
+    QVector< Value > mConstants;
+    int mNativeOperations = 0;
+};
+
+///@endcond
+
+#endif // QGSEXPRESSIONPROGRAM_P_H
@@ -22,6 +22,7 @@
 #include "qgsfeature.h"
 #include "qgsexpression.h"
 #include "qgscolorramp.h"
+#include "qgshotpathinstrumentation.h"
 #include "qgsvectorlayerfeatureiterator.h"
 #include "qgsrasterlayer.h"
 #include "qgsproject.h"
@@ -185,6 +186,8 @@ class QgsExpressionUtils
 // implicit conversion to string
     static QString getStringValue( const QVariant &value, QgsExpression * )
     {
+      if ( value.type() != QVariant::String )
+        QgsHotPathInstrumentation::count( QgsHotPathInstrumentation::VariantConversion );
       return value.toString();
     }
 
@@ -207,6 +210,8 @@ class QgsExpressionUtils
 
     static double getDoubleValue( const QVariant &value, QgsExpression *parent )
     {
+      if ( value.type() != QVariant::Double )
+        QgsHotPathInstrumentation::count( QgsHotPathInstrumentation::VariantConversion );
       bool ok;
       double x = value.toDouble( &ok );
       if ( !ok || std::isnan( x ) || !std::isfinite( x ) )
@@ -219,6 +224,8 @@ class QgsExpressionUtils
 
     static qlonglong getIntValue( const QVariant &value, QgsExpression *parent )
     {
+      if ( value.type() != QVariant::Int && value.type() != QVariant::LongLong )
+        QgsHotPathInstrumentation::count( QgsHotPathInstrumentation::VariantConversion );
       bool ok;
       qlonglong x = value.toLongLong( &ok );
       if ( ok )
@@ -31,14 +31,21 @@ QString QgsValueMapFieldFormatter::id() const
 
 QString QgsValueMapFieldFormatter::representValue( QgsVectorLayer *layer, int fieldIndex, const QVariantMap &config, const QVariant &cache, const QVariant &value ) const
 {
-  Q_UNUSED( cache )
-
   QString valueInternalText;
   if ( value.isNull() )
     valueInternalText = NULL_VALUE;
   else
     valueInternalText = value.toString();
 
+  if ( cache.type() == QVariant::Hash )
+  {
+    const QVariantHash descriptions = cache.toHash();
+    auto it = descriptions.constFind( valueInternalText );
+    if ( it != descriptions.constEnd() )
+      return it.value().toString();
+    return QStringLiteral( "(%1)" ).arg( layer->fields().at( fieldIndex ).displayString( value ) );
+  }
+
   const QVariant v = config.value( QStringLiteral( "map" ) );
   const QVariantList list = v.toList();
   if ( !list.empty() )
@@ -68,6 +75,42 @@ QVariant QgsValueMapFieldFormatter::sortValue( QgsVectorLayer *layer, int fieldI
   return representValue( layer, fieldIndex, config, cache, value );
 }
 
+QVariant QgsValueMapFieldFormatter::createCache( QgsVectorLayer *layer, int fieldIndex, const QVariantMap &config ) const
+{
+  Q_UNUSED( layer )
+  Q_UNUSED( fieldIndex )
+
+  // the first description of each value, like representValue() without cache
+  QVariantHash descriptions;
+  const QVariant v = config.value( QStringLiteral( "map" ) );
+  const QVariantList list = v.toList();
+  if ( !list.empty() )
+  {
+    for ( const QVariant &item : list )
+    {
+      const QVariantMap map = item.toMap();
+      for ( auto it = map.constBegin(); it != map.constEnd(); ++it )
+      {
+        const QString valueText = it.value().toString();
+        if ( !descriptions.contains( valueText ) )
+          descriptions.insert( valueText, it.key() );
+      }
+    }
+  }
+  else
+  {
+    // old style config
+    const QVariantMap map = v.toMap();
+    for ( auto it = map.constBegin(); it != map.constEnd(); ++it )
+    {
+      const QString valueText = it.value().toString();
+      if ( !descriptions.contains( valueText ) )
+        descriptions.insert( valueText, it.key() );
+    }
+  }
+  return descriptions;
+}
+
 QVariantList QgsValueMapFieldFormatter::availableValues( const QVariantMap &config, int countLimit, const QgsFieldFormatterContext &context ) const
 {
   Q_UNUSED( context )
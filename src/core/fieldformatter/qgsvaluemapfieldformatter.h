@@ -57,6 +57,13 @@ class CORE_EXPORT QgsValueMapFieldFormatter : public QgsFieldFormatter
 
     QVariant sortValue( QgsVectorLayer *layer, int fieldIndex, const QVariantMap &config, const QVariant &cache, const QVariant &value ) const override;
 
+    /**
+     * Returns the descriptions of the map by value, as a QVariantHash, so that
+     * representValue() looks them up instead of iterating the map.
+     * \since QGIS 3.16
+     */
+    QVariant createCache( QgsVectorLayer *layer, int fieldIndex, const QVariantMap &config ) const override;
+
     QVariantList availableValues( const QVariantMap &config, int countLimit, const QgsFieldFormatterContext &context ) const override;
 };
 
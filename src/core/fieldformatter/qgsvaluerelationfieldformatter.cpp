@@ -28,6 +28,7 @@
 #include <nlohmann/json.hpp>
 using namespace nlohmann;
 
+#include <QMutex>
 #include <QSettings>
 
 bool orderByKeyLessThan( const QgsValueRelationFieldFormatter::ValueRelationItem &p1, const QgsValueRelationFieldFormatter::ValueRelationItem &p2 )
@@ -50,17 +51,178 @@ QString QgsValueRelationFieldFormatter::id() const
   return QStringLiteral( "ValueRelation" );
 }
 
+//
+// value relation caches shared by the fields with the same configuration, by referenced
+// layer. They are discarded when the referenced layer changes
+//
+struct SharedValueRelationIndexes
+{
+  QMutex mutex;
+  QHash< QString, QgsValueRelationFieldFormatter::ValueRelationIndex > indexes;
+  QHash< QString, QSet< QString > > keysByLayer;
+  //! Incremented when the indexes of a layer are discarded, to drop the indexes built meanwhile
+  QHash< QString, int > layerGenerations;
+  QSet< QString > connectedLayers;
+};
+Q_GLOBAL_STATIC( SharedValueRelationIndexes, sSharedIndexes )
+
+static void invalidateSharedIndexes( const QString &layerId )
+{
+  QMutexLocker locker( &sSharedIndexes()->mutex );
+  const QSet< QString > keys = sSharedIndexes()->keysByLayer.take( layerId );
+  for ( const QString &key : keys )
+    sSharedIndexes()->indexes.remove( key );
+  sSharedIndexes()->layerGenerations[ layerId ]++;
+}
+
+static QgsValueRelationFieldFormatter::ValueRelationIndex indexItems( const QgsValueRelationFieldFormatter::ValueRelationCache &items )
+{
+  QgsValueRelationFieldFormatter::ValueRelationIndex index;
+  index.items = items;
+  index.itemByKey.reserve( items.size() );
+  for ( int i = 0; i < items.size(); ++i )
+  {
+    const QString key = items.at( i ).key.toString();
+    if ( !index.itemByKey.contains( key ) )
+      index.itemByKey.insert( key, i );
+  }
+  return index;
+}
+
+static QgsValueRelationFieldFormatter::ValueRelationCache buildCache( const QgsVectorLayer *layer, const QVariantMap &config, const QgsFeature &formFeature, const QgsFeature &parentFormFeature )
+{
+  QgsValueRelationFieldFormatter::ValueRelationCache cache;
+
+  QgsFields fields = layer->fields();
+  int ki = fields.indexOf( config.value( QStringLiteral( "Key" ) ).toString() );
+  int vi = fields.indexOf( config.value( QStringLiteral( "Value" ) ).toString() );
+
+  QgsFeatureRequest request;
+
+  request.setFlags( QgsFeatureRequest::NoGeometry );
+  QgsAttributeIds subsetOfAttributes { ki, vi };
+
+  const QString descriptionExpressionString = config.value( "Description" ).toString();
+  QgsExpression descriptionExpression( descriptionExpressionString );
+  QgsExpressionContext context( QgsExpressionContextUtils::globalProjectLayerScopes( layer ) );
+  descriptionExpression.prepare( &context );
+  subsetOfAttributes += descriptionExpression.referencedAttributeIndexes( layer->fields() );
+  request.setSubsetOfAttributes( qgis::setToList( subsetOfAttributes ) );
+
+  const QString filterExpression = config.value( QStringLiteral( "FilterExpression" ) ).toString();
+
+  // Skip the filter and build a full cache if the form scope is required and the feature
+  // is not valid or the attributes required for the filter have no valid value
+  // Note: parent form scope is not checked for usability because it's supposed to
+  //       be used into a coalesce that retrieve the current value of the parent
+  //       from the parent layer when used outside of an embedded form
+  if ( ! filterExpression.isEmpty() && ( !( QgsValueRelationFieldFormatter::expressionRequiresFormScope( filterExpression ) )
+                                         || QgsValueRelationFieldFormatter::expressionIsUsable( filterExpression, formFeature ) ) )
+  {
+    QgsExpressionContext filterContext = context;
+    if ( formFeature.isValid( ) && QgsValueRelationFieldFormatter::expressionRequiresFormScope( filterExpression ) )
+      filterContext.appendScope( QgsExpressionContextUtils::formScope( formFeature ) );
+    if ( parentFormFeature.isValid() && QgsValueRelationFieldFormatter::expressionRequiresParentFormScope( filterExpression ) )
+      filterContext.appendScope( QgsExpressionContextUtils::parentFormScope( parentFormFeature ) );
+    request.setExpressionContext( filterContext );
+    request.setFilterExpression( filterExpression );
+  }
+
+  QgsFeatureIterator fit = layer->getFeatures( request );
+
+  QgsFeature f;
+  while ( fit.nextFeature( f ) )
+  {
+    QString description;
+    if ( descriptionExpression.isValid() )
+    {
+      context.setFeature( f );
+      description = descriptionExpression.evaluate( &context ).toString();
+    }
+    cache.append( QgsValueRelationFieldFormatter::ValueRelationItem( f.attribute( ki ), f.attribute( vi ).toString(), description ) );
+  }
+
+  if ( config.value( QStringLiteral( "OrderByValue" ) ).toBool() )
+  {
+    std::sort( cache.begin(), cache.end(), orderByValueLessThan );
+  }
+  else
+  {
+    std::sort( cache.begin(), cache.end(), orderByKeyLessThan );
+  }
+
+  return cache;
+}
+
+static QgsValueRelationFieldFormatter::ValueRelationIndex sharedIndex( QgsVectorLayer *layer, const QVariantMap &config )
+{
+  const QString layerId = layer->id();
+  const QString key = QStringList
+  {
+    layerId,
+    config.value( QStringLiteral( "Key" ) ).toString(),
+    config.value( QStringLiteral( "Value" ) ).toString(),
+    config.value( QStringLiteral( "Description" ) ).toString(),
+    config.value( QStringLiteral( "FilterExpression" ) ).toString(),
+    config.value( QStringLiteral( "OrderByValue" ) ).toBool() ? QStringLiteral( "1" ) : QStringLiteral( "0" )
+  }.join( QChar( 0x1f ) );
+
+  SharedValueRelationIndexes *shared = sSharedIndexes();
+  int generation = 0;
+  {
+    QMutexLocker locker( &shared->mutex );
+    auto it = shared->indexes.constFind( key );
+    if ( it != shared->indexes.constEnd() )
+      return it.value();
+
+    if ( !shared->connectedLayers.contains( layerId ) )
+    {
+      shared->connectedLayers.insert( layerId );
+      auto invalidate = [layerId] { invalidateSharedIndexes( layerId ); };
+      QObject::connect( layer, &QgsMapLayer::dataChanged, layer, invalidate );
+      QObject::connect( layer, &QgsMapLayer::dataSourceChanged, layer, invalidate );
+      QObject::connect( layer, &QgsVectorLayer::layerModified, layer, invalidate );
+      QObject::connect( layer, &QgsVectorLayer::afterRollBack, layer, invalidate );
+      QObject::connect( layer, &QgsVectorLayer::subsetStringChanged, layer, invalidate );
+      QObject::connect( layer, &QgsVectorLayer::updatedFields, layer, invalidate );
+      QObject::connect( layer, &QgsMapLayer::willBeDeleted, layer, [layerId]
+      {
+        invalidateSharedIndexes( layerId );
+        QMutexLocker locker( &sSharedIndexes()->mutex );
+        sSharedIndexes()->connectedLayers.remove( layerId );
+        sSharedIndexes()->layerGenerations.remove( layerId );
+      } );
+    }
+    generation = shared->layerGenerations.value( layerId );
+  }
+
+  // the layer is read without holding the lock
+  const QgsValueRelationFieldFormatter::ValueRelationIndex index = indexItems( buildCache( layer, config, QgsFeature(), QgsFeature() ) );
+
+  QMutexLocker locker( &shared->mutex );
+  if ( shared->connectedLayers.contains( layerId ) && shared->layerGenerations.value( layerId ) == generation )
+  {
+    shared->indexes.insert( key, index );
+    shared->keysByLayer[ layerId ].insert( key );
+  }
+  return index;
+}
+
 QString QgsValueRelationFieldFormatter::representValue( QgsVectorLayer *layer, int fieldIndex, const QVariantMap &config, const QVariant &cache, const QVariant &value ) const
 {
-  ValueRelationCache vrCache;
+  ValueRelationIndex index;
 
-  if ( cache.isValid() )
+  if ( cache.userType() == qMetaTypeId< QgsValueRelationFieldFormatter::ValueRelationIndex >() )
   {
-    vrCache = cache.value<QgsValueRelationFieldFormatter::ValueRelationCache>();
+    index = cache.value<QgsValueRelationFieldFormatter::ValueRelationIndex>();
+  }
+  else if ( cache.isValid() )
+  {
+    index.items = cache.value<QgsValueRelationFieldFormatter::ValueRelationCache>();
   }
   else
   {
-    vrCache = QgsValueRelationFieldFormatter::createCache( config );
+    index = createCache( layer, fieldIndex, config ).value<QgsValueRelationFieldFormatter::ValueRelationIndex>();
   }
 
   if ( config.value( QStringLiteral( "AllowMulti" ) ).toBool() )
@@ -77,11 +239,12 @@ QString QgsValueRelationFieldFormatter::representValue( QgsVectorLayer *layer, i
       keyList = valueToStringList( value );
     }
 
+    const QSet< QString > keys = qgis::listToSet( keyList );
     QStringList valueList;
 
-    for ( const QgsValueRelationFieldFormatter::ValueRelationItem &item : qgis::as_const( vrCache ) )
+    for ( const QgsValueRelationFieldFormatter::ValueRelationItem &item : qgis::as_const( index.items ) )
     {
-      if ( keyList.contains( item.key.toString() ) )
+      if ( keys.contains( item.key.toString() ) )
       {
         valueList << item.value;
       }
@@ -96,11 +259,20 @@ QString QgsValueRelationFieldFormatter::representValue( QgsVectorLayer *layer, i
       return QgsApplication::nullRepresentation();
     }
 
-    for ( const QgsValueRelationFieldFormatter::ValueRelationItem &item : qgis::as_const( vrCache ) )
+    if ( !index.itemByKey.isEmpty() )
     {
-      if ( item.key == value )
+      auto it = index.itemByKey.constFind( value.toString() );
+      if ( it != index.itemByKey.constEnd() )
+        return index.items.at( it.value() ).value;
+    }
+    else
+    {
+      for ( const QgsValueRelationFieldFormatter::ValueRelationItem &item : qgis::as_const( index.items ) )
       {
-        return item.value;
+        if ( item.key == value )
+        {
+          return item.value;
+        }
       }
     }
   }
@@ -117,8 +289,11 @@ QVariant QgsValueRelationFieldFormatter::createCache( QgsVectorLayer *layer, int
 {
   Q_UNUSED( layer )
   Q_UNUSED( fieldIndex )
-  return QVariant::fromValue<ValueRelationCache>( createCache( config ) );
 
+  ValueRelationIndex index;
+  if ( QgsVectorLayer *referencedLayer = resolveLayer( config, QgsProject::instance() ) )
+    index = sharedIndex( referencedLayer, config );
+  return QVariant::fromValue<ValueRelationIndex>( index );
 }
 
 QgsValueRelationFieldFormatter::ValueRelationCache QgsValueRelationFieldFormatter::createCache(
@@ -126,72 +301,21 @@ QgsValueRelationFieldFormatter::ValueRelationCache QgsValueRelationFieldFormatte
   const QgsFeature &formFeature,
   const QgsFeature &parentFormFeature )
 {
-  ValueRelationCache cache;
-
-  const QgsVectorLayer *layer = resolveLayer( config, QgsProject::instance() );
+  QgsVectorLayer *layer = resolveLayer( config, QgsProject::instance() );
 
   if ( !layer )
-    return cache;
-
-  QgsFields fields = layer->fields();
-  int ki = fields.indexOf( config.value( QStringLiteral( "Key" ) ).toString() );
-  int vi = fields.indexOf( config.value( QStringLiteral( "Value" ) ).toString() );
-
-  QgsFeatureRequest request;
-
-  request.setFlags( QgsFeatureRequest::NoGeometry );
-  QgsAttributeIds subsetOfAttributes { ki, vi };
-
-  const QString descriptionExpressionString = config.value( "Description" ).toString();
-  QgsExpression descriptionExpression( descriptionExpressionString );
-  QgsExpressionContext context( QgsExpressionContextUtils::globalProjectLayerScopes( layer ) );
-  descriptionExpression.prepare( &context );
-  subsetOfAttributes += descriptionExpression.referencedAttributeIndexes( layer->fields() );
-  request.setSubsetOfAttributes( qgis::setToList( subsetOfAttributes ) );
+    return ValueRelationCache();
 
+  // caches filtered with the form features are not shared
   const QString filterExpression = config.value( QStringLiteral( "FilterExpression" ) ).toString();
-
-  // Skip the filter and build a full cache if the form scope is required and the feature
-  // is not valid or the attributes required for the filter have no valid value
-  // Note: parent form scope is not checked for usability because it's supposed to
-  //       be used into a coalesce that retrieve the current value of the parent
-  //       from the parent layer when used outside of an embedded form
-  if ( ! filterExpression.isEmpty() && ( !( expressionRequiresFormScope( filterExpression ) )
-                                         || expressionIsUsable( filterExpression, formFeature ) ) )
+  if ( !filterExpression.isEmpty()
+       && ( ( formFeature.isValid() && expressionRequiresFormScope( filterExpression ) )
+            || ( parentFormFeature.isValid() && expressionRequiresParentFormScope( filterExpression ) ) ) )
   {
-    QgsExpressionContext filterContext = context;
-    if ( formFeature.isValid( ) && QgsValueRelationFieldFormatter::expressionRequiresFormScope( filterExpression ) )
-      filterContext.appendScope( QgsExpressionContextUtils::formScope( formFeature ) );
-    if ( parentFormFeature.isValid() && QgsValueRelationFieldFormatter::expressionRequiresParentFormScope( filterExpression ) )
-      filterContext.appendScope( QgsExpressionContextUtils::parentFormScope( parentFormFeature ) );
-    request.setExpressionContext( filterContext );
-    request.setFilterExpression( filterExpression );
+    return buildCache( layer, config, formFeature, parentFormFeature );
   }
 
-  QgsFeatureIterator fit = layer->getFeatures( request );
-
-  QgsFeature f;
-  while ( fit.nextFeature( f ) )
-  {
-    QString description;
-    if ( descriptionExpression.isValid() )
-    {
-      context.setFeature( f );
-      description = descriptionExpression.evaluate( &context ).toString();
-    }
-    cache.append( ValueRelationItem( f.attribute( ki ), f.attribute( vi ).toString(), description ) );
-  }
-
-  if ( config.value( QStringLiteral( "OrderByValue" ) ).toBool() )
-  {
-    std::sort( cache.begin(), cache.end(), orderByValueLessThan );
-  }
-  else
-  {
-    std::sort( cache.begin(), cache.end(), orderByKeyLessThan );
-  }
-
-  return cache;
+  return sharedIndex( layer, config ).items;
 }
 
 
@@ -21,6 +21,7 @@
 #include "qgsexpression.h"
 #include "qgsexpressioncontext.h"
 
+#include <QHash>
 #include <QVector>
 #include <QVariant>
 
@@ -55,6 +56,21 @@ class CORE_EXPORT QgsValueRelationFieldFormatter : public QgsFieldFormatter
 
     typedef QVector < QgsValueRelationFieldFormatter::ValueRelationItem > ValueRelationCache;
 
+#ifndef SIP_RUN
+
+    /**
+     * Items of a value relation with the position of the first item of each key, by key
+     * as a string. It is the cache created by createCache( QgsVectorLayer *, int, const QVariantMap & ).
+     * \note not available in Python bindings
+     * \since QGIS 3.16
+     */
+    struct ValueRelationIndex
+    {
+      ValueRelationCache items;
+      QHash< QString, int > itemByKey;
+    };
+#endif
+
     /**
      * Constructor for QgsValueRelationFieldFormatter.
      */
@@ -77,6 +93,10 @@ class CORE_EXPORT QgsValueRelationFieldFormatter : public QgsFieldFormatter
      * Create a cache for a value relation field.
      * This can be used to keep the value map in the local memory
      * if doing multiple lookups in a loop.
+     *
+     * The caches which do not depend on \a formFeature or \a parentFormFeature are
+     * shared by all the fields with the same configuration, until the referenced
+     * layer changes (since QGIS 3.16).
      * \param config The widget configuration
      * \param formFeature The feature currently being edited with current attribute values
      * \param parentFormFeature For embedded forms only, the feature currently being edited in the parent form with current attribute values
@@ -164,5 +184,8 @@ class CORE_EXPORT QgsValueRelationFieldFormatter : public QgsFieldFormatter
 };
 
 Q_DECLARE_METATYPE( QgsValueRelationFieldFormatter::ValueRelationCache )
+#ifndef SIP_RUN
+Q_DECLARE_METATYPE( QgsValueRelationFieldFormatter::ValueRelationIndex )
+#endif
 
 #endif // QGSVALUERELATIONFIELDKIT_H
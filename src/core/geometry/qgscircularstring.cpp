@@ -278,28 +278,7 @@ bool QgsCircularString::fromWkb( QgsConstWkbPtr &wkbPtr )
   clearCache();
   mWkbType = type;
 
-  //type
-  bool hasZ = is3D();
-  bool hasM = isMeasure();
-  int nVertices = 0;
-  wkbPtr >> nVertices;
-  mX.resize( nVertices );
-  mY.resize( nVertices );
-  hasZ ? mZ.resize( nVertices ) : mZ.clear();
-  hasM ? mM.resize( nVertices ) : mM.clear();
-  for ( int i = 0; i < nVertices; ++i )
-  {
-    wkbPtr >> mX[i];
-    wkbPtr >> mY[i];
-    if ( hasZ )
-    {
-      wkbPtr >> mZ[i];
-    }
-    if ( hasM )
-    {
-      wkbPtr >> mM[i];
-    }
-  }
+  wkbPtr.readPointSequence( mX, mY, mZ, mM, is3D(), isMeasure() );
 
   return true;
 }
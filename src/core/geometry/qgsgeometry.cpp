@@ -18,6 +18,7 @@ email                : morb at ozemail dot com dot au
 #include <cstdio>
 #include <cmath>
 #include <nlohmann/json.hpp>
+#include <QMutex>
 
 #include "qgis.h"
 #include "qgsgeometry.h"
@@ -53,8 +54,81 @@ struct QgsGeometryPrivate
   QgsGeometryPrivate(): ref( 1 ) {}
   QAtomicInt ref;
   std::unique_ptr< QgsAbstractGeometry > geometry;
+
+  // prepared GEOS engine of the geometry, created once the geometry is used by GEOS a second time
+  QMutex geosMutex;
+  std::unique_ptr< QgsGeos > geos;
+  int geosUses = 0;
+  // TRUE once a non const pointer to the geometry was returned, through which it may be modified at any time
+  bool geosCacheDisabled = false;
+
+  void clearGeosCache()
+  {
+    QMutexLocker locker( &geosMutex );
+    geos.reset();
+    geosUses = 0;
+  }
 };
 
+///@cond PRIVATE
+
+/**
+ * Gives access to a GEOS engine for the geometry of a QgsGeometryPrivate, which is its cached
+ * prepared engine when possible. As GEOS prepared geometries are not safe for concurrent use, when
+ * the geometry is shared by several threads, the cached engine is used by one at a time, and the
+ * others create their own engine meanwhile.
+ */
+class QgsGeometryGeosEngine
+{
+  public:
+    explicit QgsGeometryGeosEngine( QgsGeometryPrivate *d )
+      : mD( d )
+    {
+      if ( !d->geosCacheDisabled && d->geosMutex.tryLock() )
+      {
+        if ( !d->geos && ++d->geosUses >= 2 )
+        {
+          d->geos = qgis::make_unique< QgsGeos >( d->geometry.get() );
+          d->geos->prepareGeometry();
+        }
+        if ( d->geos )
+        {
+          mEngine = d->geos.get();
+          mLocked = true;
+        }
+        else
+        {
+          d->geosMutex.unlock();
+        }
+      }
+
+      if ( !mEngine )
+      {
+        mOwnedEngine = qgis::make_unique< QgsGeos >( d->geometry.get() );
+        mEngine = mOwnedEngine.get();
+      }
+    }
+
+    ~QgsGeometryGeosEngine()
+    {
+      if ( mLocked )
+        mD->geosMutex.unlock();
+    }
+
+    const QgsGeos *operator->() const { return mEngine; }
+
+  private:
+    QgsGeometryPrivate *mD = nullptr;
+    std::unique_ptr< QgsGeos > mOwnedEngine;
+    const QgsGeos *mEngine = nullptr;
+    bool mLocked = false;
+
+    QgsGeometryGeosEngine( const QgsGeometryGeosEngine &other ) = delete;
+    QgsGeometryGeosEngine &operator=( const QgsGeometryGeosEngine &other ) = delete;
+};
+
+///@endcond
+
 QgsGeometry::QgsGeometry()
   : d( new QgsGeometryPrivate() )
 {
@@ -106,7 +180,11 @@ QgsGeometry &QgsGeometry::operator=( QgsGeometry const &other )
 void QgsGeometry::detach()
 {
   if ( d->ref <= 1 )
+  {
+    // the geometry is about to be modified in place
+    d->clearGeosCache();
     return;
+  }
 
   std::unique_ptr< QgsAbstractGeometry > cGeom;
   if ( d->geometry )
@@ -122,6 +200,8 @@ void QgsGeometry::reset( std::unique_ptr<QgsAbstractGeometry> newGeometry )
     ( void )d->ref.deref();
     d = new QgsGeometryPrivate();
   }
+  d->clearGeosCache();
+  d->geosCacheDisabled = false;
   d->geometry = std::move( newGeometry );
 }
 
@@ -133,6 +213,8 @@ const QgsAbstractGeometry *QgsGeometry::constGet() const
 QgsAbstractGeometry *QgsGeometry::get()
 {
   detach();
+  // the geometry may be modified through the returned pointer, unknown to the cached GEOS engine
+  d->geosCacheDisabled = true;
   return d->geometry.get();
 }
 
@@ -609,18 +691,18 @@ double QgsGeometry::sqrDistToVertexAt( QgsPointXY &point, int atVertex ) const
 
 QgsGeometry QgsGeometry::nearestPoint( const QgsGeometry &other ) const
 {
-  QgsGeos geos( d->geometry.get() );
+  QgsGeometryGeosEngine geos( d );
   mLastError.clear();
-  QgsGeometry result = geos.closestPoint( other );
+  QgsGeometry result = geos->closestPoint( other );
   result.mLastError = mLastError;
   return result;
 }
 
 QgsGeometry QgsGeometry::shortestLine( const QgsGeometry &other ) const
 {
-  QgsGeos geos( d->geometry.get() );
+  QgsGeometryGeosEngine geos( d );
   mLastError.clear();
-  QgsGeometry result = geos.shortestLine( other, &mLastError );
+  QgsGeometry result = geos->shortestLine( other, &mLastError );
   result.mLastError = mLastError;
   return result;
 }
@@ -967,10 +1049,10 @@ QgsGeometry QgsGeometry::makeDifference( const QgsGeometry &other ) const
     return QgsGeometry();
   }
 
-  QgsGeos geos( d->geometry.get() );
+  QgsGeometryGeosEngine geos( d );
 
   mLastError.clear();
-  std::unique_ptr< QgsAbstractGeometry > diffGeom( geos.intersection( other.constGet(), &mLastError ) );
+  std::unique_ptr< QgsAbstractGeometry > diffGeom( geos->intersection( other.constGet(), &mLastError ) );
   if ( !diffGeom )
   {
     QgsGeometry result;
@@ -1137,9 +1219,9 @@ bool QgsGeometry::intersects( const QgsGeometry &geometry ) const
     return false;
   }
 
-  QgsGeos geos( d->geometry.get() );
+  QgsGeometryGeosEngine geos( d );
   mLastError.clear();
-  return geos.intersects( geometry.d->geometry.get(), &mLastError );
+  return geos->intersects( geometry.d->geometry.get(), &mLastError );
 }
 
 bool QgsGeometry::boundingBoxIntersects( const QgsRectangle &rectangle ) const
@@ -1177,9 +1259,9 @@ bool QgsGeometry::contains( const QgsPointXY *p ) const
   }
 
   QgsPoint pt( p->x(), p->y() );
-  QgsGeos geos( d->geometry.get() );
+  QgsGeometryGeosEngine geos( d );
   mLastError.clear();
-  return geos.contains( &pt, &mLastError );
+  return geos->contains( &pt, &mLastError );
 }
 
 bool QgsGeometry::contains( const QgsGeometry &geometry ) const
@@ -1189,9 +1271,9 @@ bool QgsGeometry::contains( const QgsGeometry &geometry ) const
     return false;
   }
 
-  QgsGeos geos( d->geometry.get() );
+  QgsGeometryGeosEngine geos( d );
   mLastError.clear();
-  return geos.contains( geometry.d->geometry.get(), &mLastError );
+  return geos->contains( geometry.d->geometry.get(), &mLastError );
 }
 
 bool QgsGeometry::disjoint( const QgsGeometry &geometry ) const
@@ -1201,9 +1283,9 @@ bool QgsGeometry::disjoint( const QgsGeometry &geometry ) const
     return false;
   }
 
-  QgsGeos geos( d->geometry.get() );
+  QgsGeometryGeosEngine geos( d );
   mLastError.clear();
-  return geos.disjoint( geometry.d->geometry.get(), &mLastError );
+  return geos->disjoint( geometry.d->geometry.get(), &mLastError );
 }
 
 bool QgsGeometry::equals( const QgsGeometry &geometry ) const
@@ -1232,9 +1314,9 @@ bool QgsGeometry::touches( const QgsGeometry &geometry ) const
     return false;
   }
 
-  QgsGeos geos( d->geometry.get() );
+  QgsGeometryGeosEngine geos( d );
   mLastError.clear();
-  return geos.touches( geometry.d->geometry.get(), &mLastError );
+  return geos->touches( geometry.d->geometry.get(), &mLastError );
 }
 
 bool QgsGeometry::overlaps( const QgsGeometry &geometry ) const
@@ -1244,9 +1326,9 @@ bool QgsGeometry::overlaps( const QgsGeometry &geometry ) const
     return false;
   }
 
-  QgsGeos geos( d->geometry.get() );
+  QgsGeometryGeosEngine geos( d );
   mLastError.clear();
-  return geos.overlaps( geometry.d->geometry.get(), &mLastError );
+  return geos->overlaps( geometry.d->geometry.get(), &mLastError );
 }
 
 bool QgsGeometry::within( const QgsGeometry &geometry ) const
@@ -1256,9 +1338,9 @@ bool QgsGeometry::within( const QgsGeometry &geometry ) const
     return false;
   }
 
-  QgsGeos geos( d->geometry.get() );
+  QgsGeometryGeosEngine geos( d );
   mLastError.clear();
-  return geos.within( geometry.d->geometry.get(), &mLastError );
+  return geos->within( geometry.d->geometry.get(), &mLastError );
 }
 
 bool QgsGeometry::crosses( const QgsGeometry &geometry ) const
@@ -1268,9 +1350,9 @@ bool QgsGeometry::crosses( const QgsGeometry &geometry ) const
     return false;
   }
 
-  QgsGeos geos( d->geometry.get() );
+  QgsGeometryGeosEngine geos( d );
   mLastError.clear();
-  return geos.crosses( geometry.d->geometry.get(), &mLastError );
+  return geos->crosses( geometry.d->geometry.get(), &mLastError );
 }
 
 QString QgsGeometry::asWkt( int precision ) const
@@ -1957,13 +2039,13 @@ QgsGeometry QgsGeometry::offsetCurve( double distance, int segments, JoinStyle j
   }
   else
   {
-    QgsGeos geos( d->geometry.get() );
+    QgsGeometryGeosEngine geos( d );
     mLastError.clear();
 
     // GEOS can flip the curve orientation in some circumstances. So record previous orientation and correct if required
     const QgsCurve::Orientation prevOrientation = qgsgeometry_cast< const QgsCurve * >( d->geometry.get() )->orientation();
 
-    std::unique_ptr< QgsAbstractGeometry > offsetGeom( geos.offsetCurve( distance, segments, joinStyle, miterLimit, &mLastError ) );
+    std::unique_ptr< QgsAbstractGeometry > offsetGeom( geos->offsetCurve( distance, segments, joinStyle, miterLimit, &mLastError ) );
     if ( !offsetGeom )
     {
       QgsGeometry result;
@@ -2015,9 +2097,9 @@ QgsGeometry QgsGeometry::singleSidedBuffer( double distance, int segments, Buffe
   }
   else
   {
-    QgsGeos geos( d->geometry.get() );
+    QgsGeometryGeosEngine geos( d );
     mLastError.clear();
-    std::unique_ptr< QgsAbstractGeometry > bufferGeom = geos.singleSidedBuffer( distance, segments, side,
+    std::unique_ptr< QgsAbstractGeometry > bufferGeom = geos->singleSidedBuffer( distance, segments, side,
         joinStyle, miterLimit, &mLastError );
     if ( !bufferGeom )
     {
@@ -2090,9 +2172,9 @@ QgsGeometry QgsGeometry::simplify( double tolerance ) const
     return QgsGeometry();
   }
 
-  QgsGeos geos( d->geometry.get() );
+  QgsGeometryGeosEngine geos( d );
   mLastError.clear();
-  std::unique_ptr< QgsAbstractGeometry > simplifiedGeom( geos.simplify( tolerance, &mLastError ) );
+  std::unique_ptr< QgsAbstractGeometry > simplifiedGeom( geos->simplify( tolerance, &mLastError ) );
   if ( !simplifiedGeom )
   {
     QgsGeometry result;
@@ -2139,10 +2221,10 @@ QgsGeometry QgsGeometry::centroid() const
     return c;
   }
 
-  QgsGeos geos( d->geometry.get() );
+  QgsGeometryGeosEngine geos( d );
 
   mLastError.clear();
-  QgsGeometry result( geos.centroid( &mLastError ) );
+  QgsGeometry result( geos->centroid( &mLastError ) );
   result.mLastError = mLastError;
   return result;
 }
@@ -2154,10 +2236,10 @@ QgsGeometry QgsGeometry::pointOnSurface() const
     return QgsGeometry();
   }
 
-  QgsGeos geos( d->geometry.get() );
+  QgsGeometryGeosEngine geos( d );
 
   mLastError.clear();
-  QgsGeometry result( geos.pointOnSurface( &mLastError ) );
+  QgsGeometry result( geos->pointOnSurface( &mLastError ) );
   result.mLastError = mLastError;
   return result;
 }
@@ -2175,9 +2257,9 @@ QgsGeometry QgsGeometry::convexHull() const
   {
     return QgsGeometry();
   }
-  QgsGeos geos( d->geometry.get() );
+  QgsGeometryGeosEngine geos( d );
   mLastError.clear();
-  std::unique_ptr< QgsAbstractGeometry > cHull( geos.convexHull( &mLastError ) );
+  std::unique_ptr< QgsAbstractGeometry > cHull( geos->convexHull( &mLastError ) );
   if ( !cHull )
   {
     QgsGeometry geom;
@@ -2194,9 +2276,9 @@ QgsGeometry QgsGeometry::voronoiDiagram( const QgsGeometry &extent, double toler
     return QgsGeometry();
   }
 
-  QgsGeos geos( d->geometry.get() );
+  QgsGeometryGeosEngine geos( d );
   mLastError.clear();
-  QgsGeometry result = geos.voronoiDiagram( extent.constGet(), tolerance, edgesOnly, &mLastError );
+  QgsGeometry result = geos->voronoiDiagram( extent.constGet(), tolerance, edgesOnly, &mLastError );
   result.mLastError = mLastError;
   return result;
 }
@@ -2208,9 +2290,9 @@ QgsGeometry QgsGeometry::delaunayTriangulation( double tolerance, bool edgesOnly
     return QgsGeometry();
   }
 
-  QgsGeos geos( d->geometry.get() );
+  QgsGeometryGeosEngine geos( d );
   mLastError.clear();
-  QgsGeometry result = geos.delaunayTriangulation( tolerance, edgesOnly );
+  QgsGeometry result = geos->delaunayTriangulation( tolerance, edgesOnly );
   result.mLastError = mLastError;
   return result;
 }
@@ -2306,9 +2388,9 @@ double QgsGeometry::lineLocatePoint( const QgsGeometry &point ) const
     segmentized = QgsGeometry( static_cast< QgsCurve * >( d->geometry.get() )->segmentize() );
   }
 
-  QgsGeos geos( d->geometry.get() );
+  QgsGeometryGeosEngine geos( d );
   mLastError.clear();
-  return geos.lineLocatePoint( *( static_cast< QgsPoint * >( point.d->geometry.get() ) ), &mLastError );
+  return geos->lineLocatePoint( *( static_cast< QgsPoint * >( point.d->geometry.get() ) ), &mLastError );
 }
 
 double QgsGeometry::interpolateAngle( double distance ) const
@@ -2372,10 +2454,10 @@ QgsGeometry QgsGeometry::intersection( const QgsGeometry &geometry ) const
     return QgsGeometry();
   }
 
-  QgsGeos geos( d->geometry.get() );
+  QgsGeometryGeosEngine geos( d );
 
   mLastError.clear();
-  std::unique_ptr< QgsAbstractGeometry > resultGeom( geos.intersection( geometry.d->geometry.get(), &mLastError ) );
+  std::unique_ptr< QgsAbstractGeometry > resultGeom( geos->intersection( geometry.d->geometry.get(), &mLastError ) );
 
   if ( !resultGeom )
   {
@@ -2394,9 +2476,9 @@ QgsGeometry QgsGeometry::combine( const QgsGeometry &geometry ) const
     return QgsGeometry();
   }
 
-  QgsGeos geos( d->geometry.get() );
+  QgsGeometryGeosEngine geos( d );
   mLastError.clear();
-  std::unique_ptr< QgsAbstractGeometry > resultGeom( geos.combine( geometry.d->geometry.get(), &mLastError ) );
+  std::unique_ptr< QgsAbstractGeometry > resultGeom( geos->combine( geometry.d->geometry.get(), &mLastError ) );
   if ( !resultGeom )
   {
     QgsGeometry geom;
@@ -2419,9 +2501,9 @@ QgsGeometry QgsGeometry::mergeLines() const
     return QgsGeometry( *this );
   }
 
-  QgsGeos geos( d->geometry.get() );
+  QgsGeometryGeosEngine geos( d );
   mLastError.clear();
-  QgsGeometry result = geos.mergeLines( &mLastError );
+  QgsGeometry result = geos->mergeLines( &mLastError );
   result.mLastError = mLastError;
   return result;
 }
@@ -2433,10 +2515,10 @@ QgsGeometry QgsGeometry::difference( const QgsGeometry &geometry ) const
     return QgsGeometry();
   }
 
-  QgsGeos geos( d->geometry.get() );
+  QgsGeometryGeosEngine geos( d );
 
   mLastError.clear();
-  std::unique_ptr< QgsAbstractGeometry > resultGeom( geos.difference( geometry.d->geometry.get(), &mLastError ) );
+  std::unique_ptr< QgsAbstractGeometry > resultGeom( geos->difference( geometry.d->geometry.get(), &mLastError ) );
   if ( !resultGeom )
   {
     QgsGeometry geom;
@@ -2453,10 +2535,10 @@ QgsGeometry QgsGeometry::symDifference( const QgsGeometry &geometry ) const
     return QgsGeometry();
   }
 
-  QgsGeos geos( d->geometry.get() );
+  QgsGeometryGeosEngine geos( d );
 
   mLastError.clear();
-  std::unique_ptr< QgsAbstractGeometry > resultGeom( geos.symDifference( geometry.d->geometry.get(), &mLastError ) );
+  std::unique_ptr< QgsAbstractGeometry > resultGeom( geos->symDifference( geometry.d->geometry.get(), &mLastError ) );
   if ( !resultGeom )
   {
     QgsGeometry geom;
@@ -2706,9 +2788,9 @@ bool QgsGeometry::isSimple() const
   if ( !d->geometry )
     return false;
 
-  QgsGeos geos( d->geometry.get() );
+  QgsGeometryGeosEngine geos( d );
   mLastError.clear();
-  return geos.isSimple( &mLastError );
+  return geos->isSimple( &mLastError );
 }
 
 bool QgsGeometry::isGeosEqual( const QgsGeometry &g ) const
@@ -2737,9 +2819,9 @@ bool QgsGeometry::isGeosEqual( const QgsGeometry &g ) const
   if ( d->geometry->boundingBox() != g.d->geometry->boundingBox() )
     return false;
 
-  QgsGeos geos( d->geometry.get() );
+  QgsGeometryGeosEngine geos( d );
   mLastError.clear();
-  return geos.isEqual( g.d->geometry.get(), &mLastError );
+  return geos->isEqual( g.d->geometry.get(), &mLastError );
 }
 
 QgsGeometry QgsGeometry::unaryUnion( const QVector<QgsGeometry> &geometries )
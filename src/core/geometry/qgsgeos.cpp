@@ -27,6 +27,7 @@ email                : marco.hugentobler at sourcepole dot com
 #include "qgsgeometryeditutils.h"
 #include <limits>
 #include <cstdio>
+#include <QThreadStorage>
 
 #define DEFAULT_QUADRANT_SEGMENTS 8
 
@@ -116,7 +117,15 @@ class GEOSInit
     GEOSInit &operator=( const GEOSInit &rh ) = delete;
 };
 
-Q_GLOBAL_STATIC( GEOSInit, geosinit )
+// GEOS context handles must not be used by several threads at once, each thread gets its own
+static QThreadStorage< GEOSInit * > sGeosInit;
+
+static GEOSInit *geosinit()
+{
+  if ( !sGeosInit.hasLocalData() )
+    sGeosInit.setLocalData( new GEOSInit() );
+  return sGeosInit.localData();
+}
 
 void geos::GeosDeleter::operator()( GEOSGeometry *geom )
 {
@@ -356,6 +356,12 @@ class CORE_EXPORT QgsGeos: public QgsGeometryEngine
     static geos::unique_ptr asGeos( const QgsAbstractGeometry *geometry, double precision = 0 );
     static QgsPoint coordSeqPoint( const GEOSCoordSequence *cs, int i, bool hasZ, bool hasM );
 
+    /**
+     * Returns the GEOS context handle of the current thread.
+     *
+     * Each thread has its own context, created on first use, so that GEOS may be
+     * used from several threads at once. A handle must not be passed to another thread.
+     */
     static GEOSContextHandle_t getGEOSHandler();
 
 
@@ -395,27 +395,38 @@ bool QgsLineString::fromWkb( QgsConstWkbPtr &wkbPtr )
   return true;
 }
 
-QgsRectangle QgsLineString::calculateBoundingBox() const
-{
-  double xmin = std::numeric_limits<double>::max();
-  double ymin = std::numeric_limits<double>::max();
-  double xmax = -std::numeric_limits<double>::max();
-  double ymax = -std::numeric_limits<double>::max();
-
-  for ( double x : mX )
-  {
-    if ( x < xmin )
-      xmin = x;
-    if ( x > xmax )
-      xmax = x;
+/**
+ * Computes the minimum and maximum of \a count \a values, in four independent lanes
+ * which the compiler can keep in vector registers.
+ */
+static void minMax( const double *values, int count, double &minimum, double &maximum )
+{
+  double minima[4] = { std::numeric_limits<double>::max(), std::numeric_limits<double>::max(), std::numeric_limits<double>::max(), std::numeric_limits<double>::max() };
+  double maxima[4] = { -std::numeric_limits<double>::max(), -std::numeric_limits<double>::max(), -std::numeric_limits<double>::max(), -std::numeric_limits<double>::max() };
+  int i = 0;
+  for ( ; i + 4 <= count; i += 4 )
+  {
+    for ( int lane = 0; lane < 4; ++lane )
+    {
+      const double value = values[i + lane];
+      minima[lane] = value < minima[lane] ? value : minima[lane];
+      maxima[lane] = value > maxima[lane] ? value : maxima[lane];
+    }
   }
-  for ( double y : mY )
+  for ( ; i < count; ++i )
   {
-    if ( y < ymin )
-      ymin = y;
-    if ( y > ymax )
-      ymax = y;
+    minima[0] = values[i] < minima[0] ? values[i] : minima[0];
+    maxima[0] = values[i] > maxima[0] ? values[i] : maxima[0];
   }
+  minimum = std::min( std::min( minima[0], minima[1] ), std::min( minima[2], minima[3] ) );
+  maximum = std::max( std::max( maxima[0], maxima[1] ), std::max( maxima[2], maxima[3] ) );
+}
+
+QgsRectangle QgsLineString::calculateBoundingBox() const
+{
+  double xmin, xmax, ymin, ymax;
+  minMax( mX.constData(), mX.size(), xmin, xmax );
+  minMax( mY.constData(), mY.size(), ymin, ymax );
   return QgsRectangle( xmin, ymin, xmax, ymax );
 }
 
@@ -592,16 +603,29 @@ QString QgsLineString::asKml( int precision ) const
 
 double QgsLineString::length() const
 {
-  double length = 0;
-  int size = mX.size();
-  double dx, dy;
-  for ( int i = 1; i < size; ++i )
+  const int size = mX.size();
+  const double *x = mX.constData();
+  const double *y = mY.constData();
+
+  // two independent sums, so that pairs of segments can be computed together
+  double lengths[2] = { 0, 0 };
+  int i = 1;
+  for ( ; i + 1 < size; i += 2 )
   {
-    dx = mX.at( i ) - mX.at( i - 1 );
-    dy = mY.at( i ) - mY.at( i - 1 );
-    length += std::sqrt( dx * dx + dy * dy );
+    for ( int lane = 0; lane < 2; ++lane )
+    {
+      const double dx = x[i + lane] - x[i + lane - 1];
+      const double dy = y[i + lane] - y[i + lane - 1];
+      lengths[lane] += std::sqrt( dx * dx + dy * dy );
+    }
   }
-  return length;
+  if ( i < size )
+  {
+    const double dx = x[i] - x[i - 1];
+    const double dy = y[i] - y[i - 1];
+    lengths[0] += std::sqrt( dx * dx + dy * dy );
+  }
+  return lengths[0] + lengths[1];
 }
 
 double QgsLineString::length3D() const
@@ -1424,8 +1448,9 @@ QgsPoint QgsLineString::centroid() const
   {
     double currentX = mX.at( i );
     double currentY = mY.at( i );
-    double segmentLength = std::sqrt( std::pow( currentX - prevX, 2.0 ) +
-                                      std::pow( currentY - prevY, 2.0 ) );
+    const double dx = currentX - prevX;
+    const double dy = currentY - prevY;
+    double segmentLength = std::sqrt( dx * dx + dy * dy );
     if ( qgsDoubleNear( segmentLength, 0.0 ) )
       continue;
 
@@ -1451,41 +1476,27 @@ QgsPoint QgsLineString::centroid() const
 
 void QgsLineString::sumUpArea( double &sum ) const
 {
-  int maxIndex = numPoints() - 1;
+  const int maxIndex = numPoints() - 1;
+  const double *x = mX.constData();
+  const double *y = mY.constData();
 
-  for ( int i = 0; i < maxIndex; ++i )
+  // shoelace formula, with two independent sums so that pairs of segments can be computed together
+  double sums[2] = { 0, 0 };
+  int i = 0;
+  for ( ; i + 1 < maxIndex; i += 2 )
   {
-    sum += 0.5 * ( mX.at( i ) * mY.at( i + 1 ) - mY.at( i ) * mX.at( i + 1 ) );
+    for ( int lane = 0; lane < 2; ++lane )
+      sums[lane] += x[i + lane] * y[i + lane + 1] - y[i + lane] * x[i + lane + 1];
   }
+  if ( i < maxIndex )
+    sums[0] += x[i] * y[i + 1] - y[i] * x[i + 1];
+
+  sum += 0.5 * ( sums[0] + sums[1] );
 }
 
 void QgsLineString::importVerticesFromWkb( const QgsConstWkbPtr &wkb )
 {
-  bool hasZ = is3D();
-  bool hasM = isMeasure();
-  int nVertices = 0;
-  wkb >> nVertices;
-  mX.resize( nVertices );
-  mY.resize( nVertices );
-  hasZ ? mZ.resize( nVertices ) : mZ.clear();
-  hasM ? mM.resize( nVertices ) : mM.clear();
-  double *x = mX.data();
-  double *y = mY.data();
-  double *m = hasM ? mM.data() : nullptr;
-  double *z = hasZ ? mZ.data() : nullptr;
-  for ( int i = 0; i < nVertices; ++i )
-  {
-    wkb >> *x++;
-    wkb >> *y++;
-    if ( hasZ )
-    {
-      wkb >> *z++;
-    }
-    if ( hasM )
-    {
-      wkb >> *m++;
-    }
-  }
+  wkb.readPointSequence( mX, mY, mZ, mM, is3D(), isMeasure() );
   clearCache(); //set bounding box invalid
 }
 
@@ -0,0 +1,284 @@
+/***************************************************************************
+    qgswkbgeometryview.cpp
+    ---------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgswkbgeometryview.h"
+#include "qgsapplication.h"
+#include "qgsgeometry.h"
+#include "qgslinestring.h"
+#include "qgswkbptr.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+QgsWkbGeometryView::QgsWkbGeometryView( const QByteArray &wkb )
+  : mOwner( wkb )
+  , mData( reinterpret_cast< const unsigned char * >( mOwner.constData() ) )
+  , mSize( mOwner.size() )
+{
+  mValid = index();
+}
+
+QgsWkbGeometryView::QgsWkbGeometryView( const unsigned char *wkb, int size )
+  : mData( wkb )
+  , mSize( size )
+{
+  mValid = index();
+}
+
+bool QgsWkbGeometryView::index()
+{
+  mPartRings.append( 0 );
+  if ( indexParts() )
+    return true;
+
+  mWkbType = QgsWkbTypes::Unknown;
+  mNativeIsoWkb = false;
+  mRings.clear();
+  mPartRings.resize( 1 );
+  return false;
+}
+
+bool QgsWkbGeometryView::indexParts()
+{
+  if ( !mData || mSize <= 0 )
+    return false;
+
+  try
+  {
+    QgsConstWkbPtr wkbPtr( mData, mSize );
+
+    // reads a part header, returning its type and byte order
+    auto readHeader = [this, &wkbPtr]( bool & endianSwap ) -> QgsWkbTypes::Type
+    {
+      if ( wkbPtr.remaining() < 1 )
+        return QgsWkbTypes::Unknown;
+      endianSwap = *static_cast< const unsigned char * >( wkbPtr ) != QgsApplication::endian();
+      const QgsWkbTypes::Type type = wkbPtr.readHeader();
+      // the 25D types set the high bit of the type code
+      mNativeIsoWkb &= !endianSwap && !( static_cast< unsigned int >( type ) & 0x80000000 );
+      return type;
+    };
+
+    auto addRing = [this, &wkbPtr]( int pointCount, QgsWkbTypes::Type type, bool endianSwap ) -> bool
+    {
+      const int dimension = QgsWkbTypes::coordDimensions( type );
+      if ( pointCount < 0 || pointCount > wkbPtr.remaining() / ( dimension * static_cast< int >( sizeof( double ) ) ) )
+        return false;
+      Ring ring;
+      ring.data = wkbPtr;
+      ring.pointCount = pointCount;
+      ring.dimension = dimension;
+      ring.hasZ = QgsWkbTypes::hasZ( type );
+      ring.hasM = QgsWkbTypes::hasM( type );
+      ring.endianSwap = endianSwap;
+      wkbPtr += pointCount * dimension * static_cast< int >( sizeof( double ) );
+      mRings.append( ring );
+      return true;
+    };
+
+    auto indexPart = [&wkbPtr, &addRing]( QgsWkbTypes::Type type, bool endianSwap ) -> bool
+    {
+      switch ( QgsWkbTypes::flatType( type ) )
+      {
+        case QgsWkbTypes::Point:
+          return addRing( 1, type, endianSwap );
+
+        case QgsWkbTypes::LineString:
+        {
+          int pointCount = 0;
+          wkbPtr >> pointCount;
+          return addRing( pointCount, type, endianSwap );
+        }
+
+        case QgsWkbTypes::Polygon:
+        case QgsWkbTypes::Triangle:
+        {
+          int ringCount = 0;
+          wkbPtr >> ringCount;
+          if ( ringCount < 0 )
+            return false;
+          for ( int i = 0; i < ringCount; ++i )
+          {
+            int pointCount = 0;
+            wkbPtr >> pointCount;
+            if ( !addRing( pointCount, type, endianSwap ) )
+              return false;
+          }
+          return true;
+        }
+
+        default:
+          return false;
+      }
+    };
+
+    bool endianSwap = false;
+    mWkbType = readHeader( endianSwap );
+    const QgsWkbTypes::Type flatType = QgsWkbTypes::flatType( mWkbType );
+    switch ( flatType )
+    {
+      case QgsWkbTypes::Point:
+      case QgsWkbTypes::LineString:
+      case QgsWkbTypes::Polygon:
+      case QgsWkbTypes::Triangle:
+        if ( !indexPart( mWkbType, endianSwap ) )
+          return false;
+        mPartRings.append( mRings.size() );
+        break;
+
+      case QgsWkbTypes::MultiPoint:
+      case QgsWkbTypes::MultiLineString:
+      case QgsWkbTypes::MultiPolygon:
+      {
+        int partCount = 0;
+        wkbPtr >> partCount;
+        if ( partCount < 0 )
+          return false;
+        for ( int i = 0; i < partCount; ++i )
+        {
+          bool partEndianSwap = false;
+          const QgsWkbTypes::Type partType = readHeader( partEndianSwap );
+          if ( QgsWkbTypes::flatType( partType ) != QgsWkbTypes::singleType( flatType ) )
+            return false;
+          if ( !indexPart( partType, partEndianSwap ) )
+            return false;
+          mPartRings.append( mRings.size() );
+        }
+        break;
+      }
+
+      default:
+        return false;
+    }
+
+    mNativeIsoWkb &= wkbPtr.remaining() == 0;
+    return true;
+  }
+  catch ( QgsWkbException & )
+  {
+    return false;
+  }
+}
+
+double QgsWkbGeometryView::value( const Ring &ring, int vertex, int offset )
+{
+  double v;
+  std::memcpy( &v, ring.data + ( static_cast< std::size_t >( vertex ) * ring.dimension + offset ) * sizeof( double ), sizeof( double ) );
+  if ( ring.endianSwap )
+  {
+    char *bytes = reinterpret_cast< char * >( &v );
+    std::reverse( bytes, bytes + sizeof( double ) );
+  }
+  return v;
+}
+
+int QgsWkbGeometryView::nCoordinates() const
+{
+  int count = 0;
+  for ( const Ring &ring : mRings )
+    count += ring.pointCount;
+  return count;
+}
+
+QgsRectangle QgsWkbGeometryView::boundingBox() const
+{
+  double xMin = std::numeric_limits< double >::max();
+  double yMin = std::numeric_limits< double >::max();
+  double xMax = -std::numeric_limits< double >::max();
+  double yMax = -std::numeric_limits< double >::max();
+  bool empty = true;
+
+  for ( const Ring &ring : mRings )
+  {
+    for ( int i = 0; i < ring.pointCount; ++i )
+    {
+      const double px = value( ring, i, 0 );
+      const double py = value( ring, i, 1 );
+      xMin = std::min( xMin, px );
+      xMax = std::max( xMax, px );
+      yMin = std::min( yMin, py );
+      yMax = std::max( yMax, py );
+      empty = false;
+    }
+  }
+
+  if ( empty )
+    return QgsRectangle();
+  return QgsRectangle( xMin, yMin, xMax, yMax );
+}
+
+QgsRectangle QgsWkbGeometryView::boundingBox( int part, int ring ) const
+{
+  const Ring &r = mRings.at( mPartRings.at( part ) + ring );
+  if ( r.pointCount == 0 )
+    return QgsRectangle();
+
+  double xMin = value( r, 0, 0 );
+  double yMin = value( r, 0, 1 );
+  double xMax = xMin;
+  double yMax = yMin;
+  for ( int i = 1; i < r.pointCount; ++i )
+  {
+    const double px = value( r, i, 0 );
+    const double py = value( r, i, 1 );
+    xMin = std::min( xMin, px );
+    xMax = std::max( xMax, px );
+    yMin = std::min( yMin, py );
+    yMax = std::max( yMax, py );
+  }
+  return QgsRectangle( xMin, yMin, xMax, yMax );
+}
+
+QPolygonF QgsWkbGeometryView::asQPolygonF( int part, int ring ) const
+{
+  const Ring &r = mRings.at( mPartRings.at( part ) + ring );
+  QPolygonF points( r.pointCount );
+  QPointF *dest = points.data();
+  for ( int i = 0; i < r.pointCount; ++i, ++dest )
+  {
+    dest->setX( value( r, i, 0 ) );
+    dest->setY( value( r, i, 1 ) );
+  }
+  return points;
+}
+
+std::unique_ptr<QgsLineString> QgsWkbGeometryView::lineString( int part, int ring ) const
+{
+  const Ring &r = mRings.at( mPartRings.at( part ) + ring );
+  QVector< double > x( r.pointCount );
+  QVector< double > y( r.pointCount );
+  QVector< double > z( r.hasZ ? r.pointCount : 0 );
+  QVector< double > m( r.hasM ? r.pointCount : 0 );
+  const int mOffset = r.hasZ ? 3 : 2;
+  for ( int i = 0; i < r.pointCount; ++i )
+  {
+    x[i] = value( r, i, 0 );
+    y[i] = value( r, i, 1 );
+    if ( r.hasZ )
+      z[i] = value( r, i, 2 );
+    if ( r.hasM )
+      m[i] = value( r, i, mOffset );
+  }
+  return qgis::make_unique< QgsLineString >( x, y, z, m );
+}
+
+QgsGeometry QgsWkbGeometryView::toGeometry() const
+{
+  QgsGeometry geometry;
+  if ( mData && mSize > 0 )
+    geometry.fromWkb( mOwner.isNull() ? QByteArray( reinterpret_cast< const char * >( mData ), mSize ) : mOwner );
+  return geometry;
+}
@@ -0,0 +1,142 @@
+/***************************************************************************
+    qgswkbgeometryview.h
+    ---------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef QGSWKBGEOMETRYVIEW_H
+#define QGSWKBGEOMETRYVIEW_H
+
+#include "qgis_core.h"
+#include "qgis_sip.h"
+#include "qgswkbtypes.h"
+#include "qgsrectangle.h"
+
+#include <QByteArray>
+#include <QPolygonF>
+#include <QVarLengthArray>
+#include <memory>
+
+#define SIP_NO_FILE
+
+class QgsGeometry;
+class QgsLineString;
+
+/**
+ * \ingroup core
+ * \class QgsWkbGeometryView
+ *
+ * A lightweight, read-only view of a linear geometry stored as WKB.
+ *
+ * The view indexes the parts and rings of the WKB once, without copying any coordinate,
+ * and reads vertices straight from the buffer on demand. It allows bounding box checks,
+ * conversion to QPolygonF for rendering and map to pixel simplification
+ * (see QgsMapToPixelSimplifier::simplify()) without materializing the QgsAbstractGeometry
+ * tree and its separate x/y/z/m vectors.
+ *
+ * Points, line strings, polygons, triangles and their multi variants are supported, with
+ * any byte order and with or without z and m values. Other types (curves, collections)
+ * result in an invalid view, for which toGeometry() must be used instead.
+ *
+ * When constructed from a QByteArray the view keeps a shallow copy of it, otherwise the
+ * buffer must stay valid for the lifetime of the view.
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.16
+ */
+class CORE_EXPORT QgsWkbGeometryView
+{
+  public:
+
+    //! Constructor for a view of the \a wkb buffer
+    explicit QgsWkbGeometryView( const QByteArray &wkb );
+
+    //! Constructor for a view of the \a size bytes at \a wkb, the buffer is not copied
+    QgsWkbGeometryView( const unsigned char *wkb, int size );
+
+    /**
+     * Returns TRUE if the WKB could be indexed, i.e. if it is well formed and of a supported
+     * geometry type.
+     */
+    bool isValid() const { return mValid; }
+
+    //! Returns the WKB type of the viewed geometry
+    QgsWkbTypes::Type wkbType() const { return mWkbType; }
+
+    /**
+     * Returns TRUE if all the headers of the WKB use the byte order of the host and ISO type codes,
+     * without trailing data, i.e. if the WKB is the one QgsAbstractGeometry::asWkb() exports for
+     * this geometry. Such buffers can be passed on without decoding them.
+     */
+    bool isNativeIsoWkb() const { return mValid && mNativeIsoWkb; }
+
+    //! Returns the number of parts, 1 for single geometries
+    int partCount() const { return mPartRings.size() - 1; }
+
+    //! Returns the number of rings of \a part, 1 for points and line strings
+    int ringCount( int part ) const { return mPartRings.at( part + 1 ) - mPartRings.at( part ); }
+
+    //! Returns the number of vertices in \a ring of \a part
+    int pointCount( int part, int ring ) const { return mRings.at( mPartRings.at( part ) + ring ).pointCount; }
+
+    //! Returns the total number of vertices
+    int nCoordinates() const;
+
+    //! Returns the x coordinate of \a vertex in \a ring of \a part
+    double x( int part, int ring, int vertex ) const { return value( mRings.at( mPartRings.at( part ) + ring ), vertex, 0 ); }
+
+    //! Returns the y coordinate of \a vertex in \a ring of \a part
+    double y( int part, int ring, int vertex ) const { return value( mRings.at( mPartRings.at( part ) + ring ), vertex, 1 ); }
+
+    //! Returns the bounding box of the geometry, computed from the buffer
+    QgsRectangle boundingBox() const;
+
+    //! Returns the bounding box of \a ring of \a part
+    QgsRectangle boundingBox( int part, int ring ) const;
+
+    //! Returns the x/y vertices of \a ring of \a part
+    QPolygonF asQPolygonF( int part, int ring ) const;
+
+    //! Builds a line string with all the vertices (including z and m values) of \a ring of \a part
+    std::unique_ptr< QgsLineString > lineString( int part, int ring ) const;
+
+    //! Builds the full geometry from the WKB
+    QgsGeometry toGeometry() const;
+
+  private:
+
+    struct Ring
+    {
+      const unsigned char *data = nullptr;
+      int pointCount = 0;
+      int dimension = 2;
+      bool hasZ = false;
+      bool hasM = false;
+      bool endianSwap = false;
+    };
+
+    bool index();
+    bool indexParts();
+    static double value( const Ring &ring, int vertex, int offset );
+
+    QByteArray mOwner;
+    const unsigned char *mData = nullptr;
+    int mSize = 0;
+    bool mValid = false;
+    bool mNativeIsoWkb = true;
+    QgsWkbTypes::Type mWkbType = QgsWkbTypes::Unknown;
+    QVarLengthArray< Ring, 1 > mRings;
+
+    //! Index of the first ring of each part, followed by the total ring count
+    QVarLengthArray< int, 2 > mPartRings;
+};
+
+#endif // QGSWKBGEOMETRYVIEW_H
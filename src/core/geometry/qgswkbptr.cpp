@@ -82,20 +82,92 @@ const QgsConstWkbPtr &QgsConstWkbPtr::operator>>( QPointF &point ) const
 
 const QgsConstWkbPtr &QgsConstWkbPtr::operator>>( QPolygonF &points ) const
 {
-  int skipZM = ( QgsWkbTypes::coordDimensions( mWkbType ) - 2 ) * sizeof( double );
-  Q_ASSERT( skipZM >= 0 );
+  const int dimensions = QgsWkbTypes::coordDimensions( mWkbType );
+  Q_ASSERT( dimensions >= 2 );
 
   unsigned int nPoints;
   read( nPoints );
 
+  const qint64 size = static_cast< qint64 >( nPoints ) * dimensions * static_cast< qint64 >( sizeof( double ) );
+  if ( size > mEnd - mP )
+    throw QgsWkbException( QStringLiteral( "wkb access out of bounds" ) );
+
   points.resize( nPoints );
   QPointF *ptr = points.data();
+  const int stride = dimensions * sizeof( double );
+  for ( unsigned int i = 0; i < nPoints; ++i, ++ptr, mP += stride )
+  {
+    memcpy( &ptr->rx(), mP, sizeof( double ) );
+    memcpy( &ptr->ry(), mP + sizeof( double ), sizeof( double ) );
+  }
 
-  for ( unsigned int i = 0; i < nPoints; ++i, ++ptr )
+  if ( mEndianSwap )
   {
-    read( ptr->rx() );
-    read( ptr->ry() );
-    mP += skipZM;
+    ptr = points.data();
+    for ( unsigned int i = 0; i < nPoints; ++i, ++ptr )
+    {
+      endian_swap( ptr->rx() );
+      endian_swap( ptr->ry() );
+    }
   }
   return *this;
 }
+
+void QgsConstWkbPtr::readPointSequence( QVector<double> &x, QVector<double> &y, QVector<double> &z, QVector<double> &m, bool hasZ, bool hasM ) const
+{
+  int nPoints = 0;
+  read( nPoints );
+
+  const int dimensions = 2 + ( hasZ ? 1 : 0 ) + ( hasM ? 1 : 0 );
+  const qint64 size = static_cast< qint64 >( nPoints ) * dimensions * static_cast< qint64 >( sizeof( double ) );
+  if ( nPoints < 0 || size > mEnd - mP )
+    throw QgsWkbException( QStringLiteral( "wkb access out of bounds" ) );
+
+  x.resize( nPoints );
+  y.resize( nPoints );
+  hasZ ? z.resize( nPoints ) : z.clear();
+  hasM ? m.resize( nPoints ) : m.clear();
+  double *px = x.data();
+  double *py = y.data();
+  double *pz = hasZ ? z.data() : nullptr;
+  double *pm = hasM ? m.data() : nullptr;
+
+  // fixed stride copies, without a bound check per value
+  const unsigned char *p = mP;
+  if ( dimensions == 2 )
+  {
+    for ( int i = 0; i < nPoints; ++i, p += 2 * sizeof( double ) )
+    {
+      memcpy( px + i, p, sizeof( double ) );
+      memcpy( py + i, p + sizeof( double ), sizeof( double ) );
+    }
+  }
+  else
+  {
+    const int stride = dimensions * sizeof( double );
+    const int mOffset = ( hasZ ? 3 : 2 ) * sizeof( double );
+    for ( int i = 0; i < nPoints; ++i, p += stride )
+    {
+      memcpy( px + i, p, sizeof( double ) );
+      memcpy( py + i, p + sizeof( double ), sizeof( double ) );
+      if ( pz )
+        memcpy( pz + i, p + 2 * sizeof( double ), sizeof( double ) );
+      if ( pm )
+        memcpy( pm + i, p + mOffset, sizeof( double ) );
+    }
+  }
+  mP += size;
+
+  if ( mEndianSwap )
+  {
+    for ( int i = 0; i < nPoints; ++i )
+    {
+      endian_swap( px[i] );
+      endian_swap( py[i] );
+      if ( pz )
+        endian_swap( pz[i] );
+      if ( pm )
+        endian_swap( pm[i] );
+    }
+  }
+}
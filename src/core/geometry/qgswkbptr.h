@@ -173,6 +173,20 @@ class CORE_EXPORT QgsConstWkbPtr
     //! Read a point array
     const QgsConstWkbPtr &operator>>( QPolygonF &points ) const; SIP_SKIP
 
+    /**
+     * Reads a point count followed by the coordinates of these points into the \a x, \a y, \a z and \a m
+     * vectors, which are resized to the point count. The \a z and \a m vectors are cleared when \a hasZ
+     * or \a hasM is FALSE.
+     *
+     * The bounds are checked once for the whole sequence, which is then copied in a single pass,
+     * before any vector is resized.
+     *
+     * \throws QgsWkbException if the WKB is too short for the point count
+     * \note not available in Python bindings
+     * \since QGIS 3.16
+     */
+    void readPointSequence( QVector<double> &x, QVector<double> &y, QVector<double> &z, QVector<double> &m, bool hasZ, bool hasM ) const SIP_SKIP;
+
     inline void operator+=( int n ) { verifyBound( n ); mP += n; } SIP_SKIP
     inline void operator-=( int n ) { mP -= n; } SIP_SKIP
 
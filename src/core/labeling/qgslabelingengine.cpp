@@ -16,6 +16,7 @@
 
 #include "qgslabelingengine.h"
 
+#include "qgslabelplacements.h"
 #include "qgslogger.h"
 
 #include "feature.h"
@@ -276,6 +277,9 @@ void QgsLabelingEngine::registerLabels( QgsRenderContext &context )
   mPal->setShowPartialLabels( settings.testFlag( QgsLabelingEngineSettings::UsePartialCandidates ) );
   mPal->setPlacementVersion( settings.placementVersion() );
 
+  if ( mPreviousPlacements && mPreviousPlacements->isCompatibleWith( mMapSettings ) )
+    mPal->setPreviousPlacements( mPreviousPlacements.get() );
+
   // for each provider: get labels and register them in PAL
   for ( QgsAbstractLabelProvider *provider : qgis::as_const( mProviders ) )
   {
@@ -392,6 +396,12 @@ void QgsLabelingEngine::solve( QgsRenderContext &context )
   // find the solution
   mLabels = mPal->solveProblem( mProblem.get(), settings.testFlag( QgsLabelingEngineSettings::UseAllLabels ), settings.testFlag( QgsLabelingEngineSettings::DrawUnplacedLabels ) ? &mUnlabeled : nullptr );
 
+  // placements reused by the next render of the map
+  std::shared_ptr< QgsLabelPlacements > placements = std::make_shared< QgsLabelPlacements >( mMapSettings );
+  for ( const pal::LabelPosition *label : qgis::as_const( mLabels ) )
+    placements->addLabel( label );
+  mPlacements = placements;
+
   // sort labels
   std::sort( mLabels.begin(), mLabels.end(), QgsLabelSorter( mMapSettings ) );
 
@@ -25,7 +25,10 @@
 #include "qgslabelingenginesettings.h"
 #include "qgslabeling.h"
 
+#include <memory>
+
 class QgsLabelingEngine;
+class QgsLabelPlacements;
 
 namespace pal
 {
@@ -265,6 +268,25 @@ class CORE_EXPORT QgsLabelingEngine
     //! For internal use by the providers
     QgsLabelingResults *results() const { return mResults.get(); }
 
+    /**
+     * Sets the label \a placements of the previous render of the map. They are reused
+     * if the map has the same scale, rotation and resolution: the features which remain
+     * fully visible keep their label position.
+     *
+     * \see placements()
+     * \since QGIS 3.16
+     */
+    void setPreviousPlacements( std::shared_ptr< const QgsLabelPlacements > placements ) { mPreviousPlacements = std::move( placements ); }
+
+    /**
+     * Returns the placements of the labels solved by the engine, or NULLPTR if the
+     * labeling was not solved.
+     *
+     * \see setPreviousPlacements()
+     * \since QGIS 3.16
+     */
+    std::shared_ptr< const QgsLabelPlacements > placements() const { return mPlacements; }
+
   protected:
     void processProvider( QgsAbstractLabelProvider *provider, QgsRenderContext &context, pal::Pal &p );
 
@@ -322,6 +344,9 @@ class CORE_EXPORT QgsLabelingEngine
     QList<pal::LabelPosition *> mUnlabeled;
     QList<pal::LabelPosition *> mLabels;
 
+    std::shared_ptr< const QgsLabelPlacements > mPreviousPlacements;
+    std::shared_ptr< const QgsLabelPlacements > mPlacements;
+
 };
 
 /**
@@ -0,0 +1,82 @@
+/***************************************************************************
+                              qgslabelplacements.cpp
+                              ----------------------
+  begin                : October 2020
+  copyright            : (C) 2020 by the QGIS project
+  email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgslabelplacements.h"
+#include "qgslabelfeature.h"
+#include "qgslabelingengine.h"
+#include "qgsmapsettings.h"
+#include "feature.h"
+#include "labelposition.h"
+
+QgsLabelPlacements::QgsLabelPlacements( const QgsMapSettings &settings )
+  : mMapUnitsPerPixel( settings.mapUnitsPerPixel() )
+  , mRotation( settings.rotation() )
+  , mOutputDpi( settings.outputDpi() )
+{
+}
+
+bool QgsLabelPlacements::isCompatibleWith( const QgsMapSettings &settings ) const
+{
+  return qgsDoubleNear( mMapUnitsPerPixel, settings.mapUnitsPerPixel(), mMapUnitsPerPixel * 1e-9 )
+         && qgsDoubleNear( mRotation, settings.rotation() )
+         && qgsDoubleNear( mOutputDpi, settings.outputDpi() );
+}
+
+void QgsLabelPlacements::addLabel( const pal::LabelPosition *label )
+{
+  pal::FeaturePart *part = label->getFeaturePart();
+  if ( !part || !part->feature() || !part->feature()->provider() )
+    return;
+
+  Placement placement;
+  placement.x = label->getX();
+  placement.y = label->getY();
+  placement.alpha = label->getAlpha();
+  placement.width = label->getWidth();
+  placement.height = label->getHeight();
+  mPlacements[ providerKey( part ) ].insert( part->featureId(), placement );
+}
+
+bool QgsLabelPlacements::contains( pal::FeaturePart *part, const pal::LabelPosition *candidate ) const
+{
+  if ( !part->feature() || !part->feature()->provider() )
+    return false;
+
+  const auto provider = mPlacements.constFind( providerKey( part ) );
+  if ( provider == mPlacements.constEnd() )
+    return false;
+
+  // candidates are generated from the same geometries at the same scale, only rounding
+  // errors are tolerated (1/100 pixel)
+  const double tolerance = mMapUnitsPerPixel / 100;
+  for ( auto it = provider->constFind( part->featureId() ); it != provider->constEnd() && it.key() == part->featureId(); ++it )
+  {
+    if ( qgsDoubleNear( it->x, candidate->getX(), tolerance )
+         && qgsDoubleNear( it->y, candidate->getY(), tolerance )
+         && qgsDoubleNear( it->alpha, candidate->getAlpha(), 1e-6 )
+         && qgsDoubleNear( it->width, candidate->getWidth(), tolerance )
+         && qgsDoubleNear( it->height, candidate->getHeight(), tolerance ) )
+      return true;
+  }
+  return false;
+}
+
+QString QgsLabelPlacements::providerKey( pal::FeaturePart *part )
+{
+  const QgsAbstractLabelProvider *provider = part->feature()->provider();
+  return provider->layerId() + '\n' + provider->providerId();
+}
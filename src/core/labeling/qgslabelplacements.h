@@ -0,0 +1,98 @@
+/***************************************************************************
+                              qgslabelplacements.h
+                              --------------------
+  begin                : October 2020
+  copyright            : (C) 2020 by the QGIS project
+  email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSLABELPLACEMENTS_H
+#define QGSLABELPLACEMENTS_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+#include "qgsfeatureid.h"
+
+#include <QHash>
+#include <QMultiHash>
+#include <QString>
+
+class QgsMapSettings;
+
+namespace pal
+{
+  class FeaturePart;
+  class LabelPosition;
+}
+
+/**
+ * \ingroup core
+ * \class QgsLabelPlacements
+ * \brief Positions of the labels placed by a labeling engine, by label provider and feature.
+ *
+ * The placements solved by a render are stored in the QgsMapRendererCache of the map,
+ * and given to the labeling engine of the next render. If the map has the same scale,
+ * rotation and resolution (e.g. after a pan), the features which remain fully visible
+ * keep their label at the same position, only the other features are placed again.
+ * Labels do not jump around and the problem left to the solver is much smaller.
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.16
+ */
+class CORE_EXPORT QgsLabelPlacements
+{
+  public:
+
+    //! Creates empty placements for a map with the given \a settings
+    explicit QgsLabelPlacements( const QgsMapSettings &settings );
+
+    /**
+     * Returns TRUE if the placements can be reused by the labeling of a map with the
+     * given \a settings: same scale, rotation and resolution.
+     */
+    bool isCompatibleWith( const QgsMapSettings &settings ) const;
+
+    //! Returns TRUE if there are no placements
+    bool isEmpty() const { return mPlacements.isEmpty(); }
+
+    //! Adds the position of \a label, a solved label of the labeling problem
+    void addLabel( const pal::LabelPosition *label );
+
+    /**
+     * Returns TRUE if \a candidate, a candidate position of the label of \a part, is at
+     * the position of a label of the same feature in the placements.
+     */
+    bool contains( pal::FeaturePart *part, const pal::LabelPosition *candidate ) const;
+
+  private:
+
+    struct Placement
+    {
+      double x = 0;
+      double y = 0;
+      double alpha = 0;
+      double width = 0;
+      double height = 0;
+    };
+
+    static QString providerKey( pal::FeaturePart *part );
+
+    double mMapUnitsPerPixel = 0;
+    double mRotation = 0;
+    double mOutputDpi = 0;
+
+    //! Placements by provider key and feature id
+    QHash< QString, QMultiHash< QgsFeatureId, Placement > > mPlacements;
+};
+
+#endif // QGSLABELPLACEMENTS_H
@@ -632,6 +632,11 @@ void QgsLayerTreeModel::setLegendFilterByMap( const QgsMapSettings *settings )
 
 void QgsLayerTreeModel::setLegendFilter( const QgsMapSettings *settings, bool useExtent, const QgsGeometry &polygon, bool useExpressions )
 {
+  // the previous filter, to only refresh the legends of the layers whose filter changes
+  std::unique_ptr< QgsMapSettings > previousMapSettings = std::move( mLegendFilterMapSettings );
+  std::unique_ptr< QgsMapHitTest > previousHitTest = std::move( mLegendFilterHitTest );
+  const bool previousUsesExtent = mLegendFilterUsesExtent;
+
   if ( settings && settings->hasValidSettings() )
   {
     mLegendFilterMapSettings.reset( new QgsMapSettings( *settings ) );
@@ -665,11 +670,8 @@ void QgsLayerTreeModel::setLegendFilter( const QgsMapSettings *settings, bool us
   }
   else
   {
-    if ( !mLegendFilterMapSettings )
+    if ( !previousMapSettings )
       return; // no change
-
-    mLegendFilterMapSettings.reset();
-    mLegendFilterHitTest.reset();
   }
 
   // temporarily disable autocollapse so that legend nodes stay visible
@@ -680,7 +682,16 @@ void QgsLayerTreeModel::setLegendFilter( const QgsMapSettings *settings, bool us
   // by just updating active legend nodes, without refreshing original legend nodes
   const auto layers = mRootNode->findLayers();
   for ( QgsLayerTreeLayer *nodeLayer : layers )
+  {
+    // the filtered nodes of a vector layer only depend on the symbols visible in the hit test
+    QgsVectorLayer *vl = qobject_cast< QgsVectorLayer * >( nodeLayer->layer() );
+    if ( vl && previousHitTest && mLegendFilterHitTest && previousUsesExtent == mLegendFilterUsesExtent
+         && previousMapSettings->layers().contains( vl ) == mLegendFilterMapSettings->layers().contains( vl )
+         && previousHitTest->hasSameResults( *mLegendFilterHitTest, vl ) )
+      continue;
+
     refreshLayerLegend( nodeLayer );
+  }
 
   setAutoCollapseLegendNodes( bkAutoCollapse );
 }
@@ -35,6 +35,75 @@
 #include "qgsexpression.h"
 #include "qgstextrenderer.h"
 
+#include <QCache>
+#include <QMutex>
+
+
+///@cond PRIVATE
+
+/**
+ * Symbol previews and minimum icon sizes shared by the symbol legend nodes, which are recreated
+ * each time the legend of a layer is refreshed. They are keyed by the properties of the symbol,
+ * the size of the preview and the scale of the render context.
+ */
+class QgsSymbolLegendNodePreviewCache
+{
+  public:
+
+    QgsSymbolLegendNodePreviewCache()
+      : mPreviews( 20 * 1024 * 1024 )
+      , mMinimumSizes( 10000 )
+    {}
+
+    QPixmap preview( QgsSymbol *symbol, QSize size, QgsRenderContext *context )
+    {
+      const QString key = cacheKey( symbol, size, context );
+      {
+        QMutexLocker locker( &mMutex );
+        if ( const QImage *image = mPreviews.object( key ) )
+          return QPixmap::fromImage( *image );
+      }
+      const QPixmap pixmap = QgsSymbolLayerUtils::symbolPreviewPixmap( symbol, size, 0, context );
+      QMutexLocker locker( &mMutex );
+      mPreviews.insert( key, new QImage( pixmap.toImage() ), pixmap.width() * pixmap.height() * 4 );
+      return pixmap;
+    }
+
+    QSize minimumSize( QgsSymbol *symbol, QSize previewSize, QSize minimumSize, QgsRenderContext *context )
+    {
+      const QString key = cacheKey( symbol, previewSize, context ) + QStringLiteral( "|%1x%2" ).arg( minimumSize.width() ).arg( minimumSize.height() );
+      {
+        QMutexLocker locker( &mMutex );
+        if ( const QSize *size = mMinimumSizes.object( key ) )
+          return *size;
+      }
+      const QSize size = QgsImageOperation::nonTransparentImageRect(
+                           QgsSymbolLayerUtils::symbolPreviewPixmap( symbol, previewSize, 0, context ).toImage(),
+                           minimumSize, true ).size();
+      QMutexLocker locker( &mMutex );
+      mMinimumSizes.insert( key, new QSize( size ) );
+      return size;
+    }
+
+  private:
+
+    static QString cacheKey( QgsSymbol *symbol, QSize size, QgsRenderContext *context )
+    {
+      QString key = QgsSymbolLayerUtils::symbolProperties( symbol ) + QStringLiteral( "|%1x%2" ).arg( size.width() ).arg( size.height() );
+      if ( context )
+        key += QStringLiteral( "|%1|%2|%3" ).arg( context->scaleFactor() ).arg( context->mapToPixel().mapUnitsPerPixel() ).arg( context->rendererScale() );
+      return key;
+    }
+
+    QMutex mMutex;
+    // images rather than pixmaps, which must not outlive the application
+    QCache< QString, QImage > mPreviews;
+    QCache< QString, QSize > mMinimumSizes;
+};
+
+Q_GLOBAL_STATIC( QgsSymbolLegendNodePreviewCache, sPreviewCache )
+
+///@endcond
 
 QgsLayerTreeModelLegendNode::QgsLayerTreeModelLegendNode( QgsLayerTreeLayer *nodeL, QObject *parent )
   : QObject( parent )
@@ -270,19 +339,11 @@ QSize QgsSymbolLegendNode::minimumIconSize( QgsRenderContext *context ) const
   QSize minSz( iconSize, iconSize );
   if ( mItem.symbol() && mItem.symbol()->type() == QgsSymbol::Marker )
   {
-    minSz = QgsImageOperation::nonTransparentImageRect(
-              QgsSymbolLayerUtils::symbolPreviewPixmap( mItem.symbol(), QSize( largeIconSize, largeIconSize ), 0,
-                  context ).toImage(),
-              minSz,
-              true ).size();
+    minSz = sPreviewCache()->minimumSize( mItem.symbol(), QSize( largeIconSize, largeIconSize ), minSz, context );
   }
   else if ( mItem.symbol() && mItem.symbol()->type() == QgsSymbol::Line )
   {
-    minSz = QgsImageOperation::nonTransparentImageRect(
-              QgsSymbolLayerUtils::symbolPreviewPixmap( mItem.symbol(), QSize( minSz.width(), largeIconSize ), 0,
-                  context ).toImage(),
-              minSz,
-              true ).size();
+    minSz = sPreviewCache()->minimumSize( mItem.symbol(), QSize( minSz.width(), largeIconSize ), minSz, context );
   }
 
   if ( !mTextOnSymbolLabel.isEmpty() && context )
@@ -443,7 +504,7 @@ QVariant QgsSymbolLegendNode::data( int role ) const
       if ( mItem.symbol() )
       {
         std::unique_ptr<QgsRenderContext> context( createTemporaryRenderContext() );
-        pix = QgsSymbolLayerUtils::symbolPreviewPixmap( mItem.symbol(), mIconSize, 0, context.get() );
+        pix = sPreviewCache()->preview( mItem.symbol(), mIconSize, context.get() );
 
         if ( !mTextOnSymbolLabel.isEmpty() && context )
         {
@@ -28,11 +28,16 @@
 #include "qgslayoutgeopdfexporter.h"
 #include "qgslinestring.h"
 #include <QImageWriter>
+#include <QThread>
+#include <QtConcurrentRun>
 #include <QSize>
 #include <QSvgGenerator>
 
 #include "gdal.h"
 #include "cpl_conv.h"
+#include "cpl_string.h"
+
+#include <algorithm>
 
 ///@cond PRIVATE
 class LayoutContextPreviewSettingRestorer
@@ -296,6 +301,8 @@ QImage QgsLayoutExporter::renderRegionToImage( const QRectF &region, QSize image
     image.setDotsPerMeterY( static_cast< int>( std::round( resolution / 25.4 * 1000 ) ) );
     image.fill( Qt::transparent );
     QPainter imagePainter( &image );
+    // the maps are drawn at the logical resolution of the image
+    prerenderMaps( region, image.logicalDpiX() );
     renderRegion( &imagePainter, region );
     if ( !imagePainter.isActive() )
       return QImage();
@@ -304,6 +311,28 @@ QImage QgsLayoutExporter::renderRegionToImage( const QRectF &region, QSize image
   return image;
 }
 
+void QgsLayoutExporter::prerenderMaps( const QRectF &region, double dpi ) const
+{
+  if ( !( mLayout->renderContext().flags() & QgsLayoutRenderContext::FlagRenderMapsInParallel ) )
+    return;
+
+  QList< QgsLayoutItemMap * > maps;
+  mLayout->layoutItems( maps );
+  maps.erase( std::remove_if( maps.begin(), maps.end(), [&region]( QgsLayoutItemMap * map )
+  {
+    return !map->sceneBoundingRect().intersects( region );
+  } ), maps.end() );
+
+  QList< QgsLayoutItemMap * > startedMaps;
+  for ( QgsLayoutItemMap *map : qgis::as_const( maps ) )
+  {
+    if ( map->startPrerender( dpi ) )
+      startedMaps << map;
+  }
+  for ( QgsLayoutItemMap *map : qgis::as_const( startedMaps ) )
+    map->waitForPrerender();
+}
+
 ///@cond PRIVATE
 class LayoutContextSettingsRestorer
 {
@@ -406,6 +435,56 @@ QgsLayoutExporter::ExportResult QgsLayoutExporter::exportToImage( const QString
       continue;
     }
 
+    pageDetails.page = page;
+    const bool shouldGeoreference = ( page == worldFilePageNo );
+    const QgsProject *project = settings.exportMetadata ? mLayout->project() : nullptr;
+
+    // very large TIFF images are rendered and written in bands, not to allocate the whole image at once
+    if ( pageDetails.extension.compare( QLatin1String( "tif" ), Qt::CaseInsensitive ) == 0
+         || pageDetails.extension.compare( QLatin1String( "tiff" ), Qt::CaseInsensitive ) == 0 )
+    {
+      QRectF region;
+      QSize imageSize;
+      double resolution = 0;
+      if ( !imageRegion( settings, page, region, imageSize, resolution ) )
+        continue; // should skip this page, e.g. null size
+
+      int bandHeight = settings.tiffBandHeight;
+      if ( bandHeight <= 0 && static_cast< qint64 >( imageSize.width() ) * imageSize.height() > 100000000 )
+        bandHeight = std::max( 1, 25000000 / std::max( 1, imageSize.width() ) );
+
+      if ( bandHeight > 0 && bandHeight < imageSize.height() )
+      {
+        QString outputFilePath = generateFileName( pageDetails );
+        ExportResult result = renderRegionToTiffInBands( region, imageSize, resolution, bandHeight, outputFilePath, project ? &project->metadata() : nullptr );
+        if ( result != Success )
+        {
+          mErrorFileName = outputFilePath;
+          return result;
+        }
+
+        if ( shouldGeoreference )
+        {
+          georeferenceOutputPrivate( outputFilePath, nullptr, settings.cropToContents ? region : QRectF(), settings.dpi, shouldGeoreference );
+          if ( settings.generateWorldFile )
+          {
+            double a, b, c, d, e, f;
+            if ( settings.cropToContents )
+              computeWorldFileParameters( region, a, b, c, d, e, f, settings.dpi );
+            else
+              computeWorldFileParameters( a, b, c, d, e, f, settings.dpi );
+
+            QFileInfo fi( outputFilePath );
+            QString outputSuffix = fi.suffix();
+            QString worldFileName = fi.absolutePath() + '/' + fi.completeBaseName() + '.'
+                                    + outputSuffix.at( 0 ) + outputSuffix.at( fi.suffix().size() - 1 ) + 'w';
+            writeWorldFile( worldFileName, a, b, c, d, e, f );
+          }
+        }
+        continue;
+      }
+    }
+
     bool skip = false;
     QRectF bounds;
     QImage image = createImage( settings, page, bounds, skip );
@@ -413,7 +492,6 @@ QgsLayoutExporter::ExportResult QgsLayoutExporter::exportToImage( const QString
     if ( skip )
       continue; // should skip this page, e.g. null size
 
-    pageDetails.page = page;
     QString outputFilePath = generateFileName( pageDetails );
 
     if ( image.isNull() )
@@ -422,17 +500,60 @@ QgsLayoutExporter::ExportResult QgsLayoutExporter::exportToImage( const QString
       return MemoryError;
     }
 
-    if ( !saveImage( image, outputFilePath, pageDetails.extension, settings.exportMetadata ? mLayout->project() : nullptr ) )
+    if ( mWriteImagesInBackground )
     {
-      mErrorFileName = outputFilePath;
-      return FileError;
+      // encoding large images is slow, it runs in a background thread while the next pages are rendered.
+      // The georeference depends on the current state of the reference map, so it is computed right away
+      if ( !waitForBackgroundImageWrites( std::max( 1, QThread::idealThreadCount() ) ) )
+        return FileError;
+
+      QVector< double > geoTransform;
+      QString crsWkt;
+      QgsLayoutItemMap *referenceMap = mLayout->referenceMap();
+      if ( shouldGeoreference && referenceMap )
+      {
+        std::unique_ptr<double[]> t = computeGeoTransform( referenceMap, bounds, settings.dpi );
+        geoTransform = QVector< double >( 6 );
+        std::copy( t.get(), t.get() + 6, geoTransform.begin() );
+        crsWkt = referenceMap->crs().toWkt( QgsCoordinateReferenceSystem::WKT_PREFERRED_GDAL );
+      }
+
+      const QgsProjectMetadata metadata = project ? project->metadata() : QgsProjectMetadata();
+      const bool includeMetadata = project;
+      const QString extension = pageDetails.extension;
+      mBackgroundImageWrites << qMakePair( outputFilePath, QtConcurrent::run( [image, outputFilePath, extension, metadata, includeMetadata, geoTransform, crsWkt]() -> bool
+      {
+        if ( !saveImage( image, outputFilePath, extension, includeMetadata ? &metadata : nullptr ) )
+          return false;
+
+        if ( !geoTransform.isEmpty() )
+        {
+          gdal::dataset_unique_ptr outputDS( GDALOpen( outputFilePath.toLocal8Bit().constData(), GA_Update ) );
+          if ( outputDS )
+          {
+            double t[6];
+            std::copy( geoTransform.constBegin(), geoTransform.constEnd(), t );
+            GDALSetGeoTransform( outputDS.get(), t );
+            GDALSetProjection( outputDS.get(), crsWkt.toLocal8Bit().constData() );
+          }
+        }
+        return true;
+      } ) );
+    }
+    else
+    {
+      if ( !saveImage( image, outputFilePath, pageDetails.extension, project ? &project->metadata() : nullptr ) )
+      {
+        mErrorFileName = outputFilePath;
+        return FileError;
+      }
+
+      if ( shouldGeoreference )
+        georeferenceOutputPrivate( outputFilePath, nullptr, bounds, settings.dpi, shouldGeoreference );
     }
 
-    const bool shouldGeoreference = ( page == worldFilePageNo );
     if ( shouldGeoreference )
     {
-      georeferenceOutputPrivate( outputFilePath, nullptr, bounds, settings.dpi, shouldGeoreference );
-
       if ( settings.generateWorldFile )
       {
         // should generate world file for this page
@@ -466,6 +587,9 @@ QgsLayoutExporter::ExportResult QgsLayoutExporter::exportToImage( QgsAbstractLay
   int total = iterator->count();
   double step = total > 0 ? 100.0 / total : 100.0;
   int i = 0;
+  // the images of a page are written in background threads while the next features are rendered
+  QgsLayoutExporter exporter( iterator->layout() );
+  exporter.mWriteImagesInBackground = true;
   while ( iterator->next() )
   {
     if ( feedback )
@@ -478,23 +602,31 @@ QgsLayoutExporter::ExportResult QgsLayoutExporter::exportToImage( QgsAbstractLay
     }
     if ( feedback && feedback->isCanceled() )
     {
+      exporter.waitForBackgroundImageWrites();
       iterator->endRender();
       return Canceled;
     }
 
-    QgsLayoutExporter exporter( iterator->layout() );
     QString filePath = iterator->filePath( baseFilePath, extension );
     ExportResult result = exporter.exportToImage( filePath, settings );
     if ( result != Success )
     {
+      exporter.waitForBackgroundImageWrites();
       if ( result == FileError )
-        error = QObject::tr( "Cannot write to %1. This file may be open in another application or may be an invalid path." ).arg( QDir::toNativeSeparators( filePath ) );
+        error = QObject::tr( "Cannot write to %1. This file may be open in another application or may be an invalid path." ).arg( QDir::toNativeSeparators( exporter.errorFile() ) );
       iterator->endRender();
       return result;
     }
     i++;
   }
 
+  if ( !exporter.waitForBackgroundImageWrites() )
+  {
+    error = QObject::tr( "Cannot write to %1. This file may be open in another application or may be an invalid path." ).arg( QDir::toNativeSeparators( exporter.errorFile() ) );
+    iterator->endRender();
+    return FileError;
+  }
+
   if ( feedback )
   {
     feedback->setProgress( 100 );
@@ -1944,6 +2076,121 @@ QImage QgsLayoutExporter::createImage( const QgsLayoutExporter::ImageExportSetti
   }
 }
 
+bool QgsLayoutExporter::imageRegion( const QgsLayoutExporter::ImageExportSettings &settings, int page, QRectF &region, QSize &imageSize, double &resolution ) const
+{
+  imageSize = QSize();
+  if ( settings.cropToContents )
+  {
+    if ( mLayout->pageCollection()->pageCount() == 1 )
+      region = mLayout->layoutBounds( true );
+    else
+      region = mLayout->pageItemBounds( page, true );
+    if ( region.width() <= 0 || region.height() <= 0 )
+      return false;
+
+    double pixelToLayoutUnits = mLayout->convertToLayoutUnits( QgsLayoutMeasurement( 1, QgsUnitTypes::LayoutPixels ) );
+    region = region.adjusted( -settings.cropMargins.left() * pixelToLayoutUnits,
+                              -settings.cropMargins.top() * pixelToLayoutUnits,
+                              settings.cropMargins.right() * pixelToLayoutUnits,
+                              settings.cropMargins.bottom() * pixelToLayoutUnits );
+  }
+  else
+  {
+    QgsLayoutItemPage *pageItem = mLayout->pageCollection()->page( page );
+    if ( !pageItem )
+      return false;
+
+    region = QRectF( pageItem->pos().x(), pageItem->pos().y(), pageItem->rect().width(), pageItem->rect().height() );
+    imageSize = settings.imageSize;
+    if ( imageSize.isValid() && ( !qgsDoubleNear( static_cast< double >( imageSize.width() ) / imageSize.height(),
+                                  region.width() / region.height(), 0.008 ) ) )
+    {
+      // same as renderPageToImage(), ignore an image size with the wrong aspect ratio
+      imageSize = QSize();
+    }
+  }
+
+  // same as renderRegionToImage()
+  const double oneInchInLayoutUnits = mLayout->convertToLayoutUnits( QgsLayoutMeasurement( 1, QgsUnitTypes::LayoutInches ) );
+  resolution = settings.dpi > 0 ? settings.dpi : mLayout->renderContext().dpi();
+  if ( imageSize.isValid() )
+  {
+    resolution = ( imageSize.width() / region.width()
+                   + imageSize.height() / region.height() ) / 2.0 * oneInchInLayoutUnits;
+  }
+  else
+  {
+    imageSize = QSize( static_cast< int >( resolution * region.width() / oneInchInLayoutUnits ),
+                       static_cast< int >( resolution * region.height() / oneInchInLayoutUnits ) );
+  }
+  return !imageSize.isEmpty();
+}
+
+QgsLayoutExporter::ExportResult QgsLayoutExporter::renderRegionToTiffInBands( const QRectF &region, QSize imageSize, double resolution, int bandHeight,
+    const QString &filePath, const QgsProjectMetadata *metadata ) const
+{
+  GDALDriverH driver = GDALGetDriverByName( "GTiff" );
+  if ( !driver )
+    return FileError;
+
+  // same options as saveImage(), with non premultiplied alpha as in QImage::Format_ARGB32
+  char **options = nullptr;
+  options = CSLSetNameValue( options, "COMPRESS", "LZW" );
+  options = CSLSetNameValue( options, "PHOTOMETRIC", "RGB" );
+  options = CSLSetNameValue( options, "ALPHA", "UNASSOCIATED" );
+  options = CSLSetNameValue( options, "BIGTIFF", "IF_SAFER" );
+  gdal::dataset_unique_ptr outputDS( GDALCreate( driver, filePath.toLocal8Bit().constData(), imageSize.width(), imageSize.height(), 4, GDT_Byte, options ) );
+  CSLDestroy( options );
+  if ( !outputDS )
+    return FileError;
+
+  GDALSetMetadataItem( outputDS.get(), "TIFFTAG_XRESOLUTION", QString::number( resolution ).toLocal8Bit().constData(), nullptr );
+  GDALSetMetadataItem( outputDS.get(), "TIFFTAG_YRESOLUTION", QString::number( resolution ).toLocal8Bit().constData(), nullptr );
+  GDALSetMetadataItem( outputDS.get(), "TIFFTAG_RESOLUTIONUNIT", "2", nullptr ); // inches
+  if ( metadata )
+  {
+    GDALSetMetadataItem( outputDS.get(), "TIFFTAG_ARTIST", metadata->author().toUtf8().constData(), nullptr );
+    GDALSetMetadataItem( outputDS.get(), "TIFFTAG_SOFTWARE", QStringLiteral( "QGIS %1" ).arg( Qgis::version() ).toUtf8().constData(), nullptr );
+    GDALSetMetadataItem( outputDS.get(), "TIFFTAG_DOCUMENTNAME", metadata->title().toUtf8().constData(), nullptr );
+    GDALSetMetadataItem( outputDS.get(), "TIFFTAG_IMAGEDESCRIPTION", metadata->abstract().toUtf8().constData(), nullptr );
+    if ( metadata->creationDateTime().isValid() )
+      GDALSetMetadataItem( outputDS.get(), "TIFFTAG_DATETIME", metadata->creationDateTime().toString( QStringLiteral( "yyyy:MM:dd HH:mm:ss" ) ).toLocal8Bit().constData(), nullptr );
+  }
+
+  // QImage::Format_ARGB32 pixels are 32 bit 0xAARRGGBB values
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+  int bandMap[4] = { 3, 2, 1, 4 };
+#else
+  int bandMap[4] = { 4, 1, 2, 3 };
+#endif
+
+  const double dotsPerMeter = std::round( resolution / 25.4 * 1000 );
+  for ( int y = 0; y < imageSize.height(); y += bandHeight )
+  {
+    const int rows = std::min( bandHeight, imageSize.height() - y );
+    QImage band( QSize( imageSize.width(), rows ), QImage::Format_ARGB32 );
+    if ( band.isNull() )
+      return MemoryError;
+
+    band.setDotsPerMeterX( static_cast< int >( dotsPerMeter ) );
+    band.setDotsPerMeterY( static_cast< int >( dotsPerMeter ) );
+    band.fill( Qt::transparent );
+    const QRectF bandRegion( region.left(), region.top() + region.height() * y / imageSize.height(),
+                             region.width(), region.height() * rows / imageSize.height() );
+    {
+      QPainter bandPainter( &band );
+      renderRegion( &bandPainter, bandRegion );
+      if ( !bandPainter.isActive() )
+        return MemoryError;
+    }
+
+    if ( GDALDatasetRasterIO( outputDS.get(), GF_Write, 0, y, imageSize.width(), rows, band.bits(), imageSize.width(), rows,
+                              GDT_Byte, 4, bandMap, 4, band.bytesPerLine(), 1 ) != CE_None )
+      return FileError;
+  }
+  return Success;
+}
+
 int QgsLayoutExporter::firstPageToBeExported( QgsLayout *layout )
 {
   const int pageCount = layout->pageCollection()->pageCount();
@@ -1971,24 +2218,39 @@ QString QgsLayoutExporter::generateFileName( const PageExportDetails &details )
   }
 }
 
-bool QgsLayoutExporter::saveImage( const QImage &image, const QString &imageFilename, const QString &imageFormat, QgsProject *projectForMetadata )
+bool QgsLayoutExporter::waitForBackgroundImageWrites( int maxPending )
+{
+  bool ok = true;
+  while ( mBackgroundImageWrites.size() > maxPending )
+  {
+    const QPair< QString, QFuture< bool > > write = mBackgroundImageWrites.takeFirst();
+    if ( !write.second.result() && ok )
+    {
+      mErrorFileName = write.first;
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+bool QgsLayoutExporter::saveImage( const QImage &image, const QString &imageFilename, const QString &imageFormat, const QgsProjectMetadata *metadata )
 {
   QImageWriter w( imageFilename, imageFormat.toLocal8Bit().constData() );
   if ( imageFormat.compare( QLatin1String( "tiff" ), Qt::CaseInsensitive ) == 0 || imageFormat.compare( QLatin1String( "tif" ), Qt::CaseInsensitive ) == 0 )
   {
     w.setCompression( 1 ); //use LZW compression
   }
-  if ( projectForMetadata )
+  if ( metadata )
   {
-    w.setText( QStringLiteral( "Author" ), projectForMetadata->metadata().author() );
+    w.setText( QStringLiteral( "Author" ), metadata->author() );
     const QString creator = QStringLiteral( "QGIS %1" ).arg( Qgis::version() );
     w.setText( QStringLiteral( "Creator" ), creator );
     w.setText( QStringLiteral( "Producer" ), creator );
-    w.setText( QStringLiteral( "Subject" ), projectForMetadata->metadata().abstract() );
-    w.setText( QStringLiteral( "Created" ), projectForMetadata->metadata().creationDateTime().toString( Qt::ISODate ) );
-    w.setText( QStringLiteral( "Title" ), projectForMetadata->metadata().title() );
+    w.setText( QStringLiteral( "Subject" ), metadata->abstract() );
+    w.setText( QStringLiteral( "Created" ), metadata->creationDateTime().toString( Qt::ISODate ) );
+    w.setText( QStringLiteral( "Title" ), metadata->title() );
 
-    const QgsAbstractMetadataBase::KeywordMap keywords = projectForMetadata->metadata().keywords();
+    const QgsAbstractMetadataBase::KeywordMap keywords = metadata->keywords();
     QStringList allKeywords;
     for ( auto it = keywords.constBegin(); it != keywords.constEnd(); ++it )
     {
@@ -22,6 +22,8 @@
 #include "qgslayoutreportcontext.h"
 #include "qgslayoutitem.h"
 #include <QPointer>
+#include <QFuture>
+#include <QPair>
 #include <QSize>
 #include <QRectF>
 #include <functional>
@@ -34,6 +36,7 @@ class QPainter;
 class QgsLayoutItemMap;
 class QgsAbstractLayoutIterator;
 class QgsFeedback;
+class QgsProjectMetadata;
 
 /**
  * \ingroup core
@@ -217,6 +220,18 @@ class CORE_EXPORT QgsLayoutExporter
        */
       QVector<qreal> predefinedMapScales;
 
+      /**
+       * Height in pixels of the horizontal bands in which TIFF images are rendered and written one after
+       * the other, so that the memory used by very large exports is bounded by the band size.
+       *
+       * If 0, the bands are only used for TIFF images larger than 100 megapixels, with bands of about
+       * 25 megapixels. The layout items crossing several bands are rendered again for each of them, so
+       * the bands should not be too small.
+       *
+       * \since QGIS 3.16
+       */
+      int tiffBandHeight = 0;
+
     };
 
     /**
@@ -640,8 +655,40 @@ class CORE_EXPORT QgsLayoutExporter
 
     mutable QString mErrorFileName;
 
+    //! TRUE if the exported images which do not need georeferencing are written in background threads
+    bool mWriteImagesInBackground = false;
+
+    //! Output file paths and results of the images being written in background threads, in export order
+    QList< QPair< QString, QFuture< bool > > > mBackgroundImageWrites;
+
+    /**
+     * Waits until at most \a maxPending images are still being written in background threads.
+     * Returns FALSE and sets the error file name if any of the finished writes failed.
+     */
+    bool waitForBackgroundImageWrites( int maxPending = 0 );
+
     QImage createImage( const ImageExportSettings &settings, int page, QRectF &bounds, bool &skipPage ) const;
 
+    /**
+     * Renders the layers of the maps in the layout \a region ahead of its export to an image at \a dpi,
+     * all at the same time, if the FlagRenderMapsInParallel flag is set. See QgsLayoutItemMap::startPrerender().
+     */
+    void prerenderMaps( const QRectF &region, double dpi ) const;
+
+    /**
+     * Computes the layout \a region, the \a imageSize in pixels and the \a resolution of the image
+     * exported for a \a page with the specified \a settings, as createImage() renders it.
+     * Returns FALSE if the page should be skipped.
+     */
+    bool imageRegion( const ImageExportSettings &settings, int page, QRectF &region, QSize &imageSize, double &resolution ) const;
+
+    /**
+     * Renders the layout \a region to a TIFF file at \a filePath, \a imageSize and \a resolution, in
+     * horizontal bands of \a bandHeight pixels written one after the other.
+     */
+    ExportResult renderRegionToTiffInBands( const QRectF &region, QSize imageSize, double resolution, int bandHeight,
+                                            const QString &filePath, const QgsProjectMetadata *metadata ) const;
+
     /**
      * Returns the page number of the first page to be exported from the layout, skipping any pages
      * which have been excluded from export.
@@ -651,7 +698,7 @@ class CORE_EXPORT QgsLayoutExporter
     /**
      * Saves an image to a file, possibly using format specific options (e.g. LZW compression for tiff)
     */
-    static bool saveImage( const QImage &image, const QString &imageFilename, const QString &imageFormat, QgsProject *projectForMetadata );
+    static bool saveImage( const QImage &image, const QString &imageFilename, const QString &imageFormat, const QgsProjectMetadata *metadata );
 
     /**
      * Computes a GDAL style geotransform for georeferencing a layout.
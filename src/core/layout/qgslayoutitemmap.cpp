@@ -34,9 +34,25 @@
 #include "qgsexpressioncontextutils.h"
 #include "qgsstyleentityvisitor.h"
 #include "qgsannotationlayer.h"
+#include "qgsmaprenderercache.h"
+#include "qgsmaprendererparalleljob.h"
+#include "qgspallabeling.h"
+#include "qgsrasterlayer.h"
+#include "qgsvectorlayerutils.h"
+#include "qgsrulebasedrenderer.h"
+#include "qgscategorizedsymbolrenderer.h"
+#include "qgsgraduatedsymbolrenderer.h"
+#include "qgsheatmaprenderer.h"
+#include "qgsgeometrygeneratorsymbollayer.h"
+#include "qgsrulebasedlabeling.h"
+#include "qgsvectorlayerlabeling.h"
+#include "qgsdiagramrenderer.h"
+#include "qgscallout.h"
+#include "qgsstyle.h"
 
 #include <QPainter>
 #include <QStyleOptionGraphicsItem>
+#include <QDataStream>
 
 QgsLayoutItemMap::QgsLayoutItemMap( QgsLayout *layout )
   : QgsLayoutItem( layout )
@@ -82,6 +98,8 @@ QgsLayoutItemMap::~QgsLayoutItemMap()
     mPainterJob->cancel(); // blocks
     mPainter->end();
   }
+  if ( mPrerenderJob )
+    mPrerenderJob->cancel(); // blocks
 }
 
 int QgsLayoutItemMap::type() const
@@ -1327,19 +1345,348 @@ void QgsLayoutItemMap::drawMap( QPainter *painter, const QgsRectangle &extent, Q
   }
 
   // render
-  QgsMapSettings ms( mapSettings( extent, size, dpi, true ) );
-  if ( shouldDrawPart( OverviewMapExtent ) )
-  {
-    ms.setLayers( mOverviewStack->modifyMapLayerList( ms.layers() ) );
-  }
+  QgsMapSettings ms( drawMapSettings( extent, size, dpi ) );
+
+  // the layer images rendered ahead of the export are only used once
+  std::unique_ptr< QgsMapRendererCache > prerenderCache = std::move( mPrerenderCache );
 
   QgsMapRendererCustomPainterJob job( ms, painter );
+  job.setCache( prerenderCache ? prerenderCache.get() : atlasRenderCache( ms, painter ) );
   // Render the map in this thread. This is done because of problems
   // with printing to printer on Windows (printing to PDF is fine though).
   // Raster images were not displayed - see #10599
   job.renderSynchronously();
 
   mRenderingErrors = job.errors();
+  if ( prerenderCache )
+    mRenderingErrors = mPrerenderErrors + mRenderingErrors;
+  mPrerenderErrors.clear();
+}
+
+QgsMapSettings QgsLayoutItemMap::drawMapSettings( const QgsRectangle &extent, QSizeF size, double dpi )
+{
+  QgsMapSettings ms( mapSettings( extent, size, dpi, true ) );
+  if ( shouldDrawPart( OverviewMapExtent ) )
+  {
+    ms.setLayers( mOverviewStack->modifyMapLayerList( ms.layers() ) );
+  }
+  return ms;
+}
+
+bool QgsLayoutItemMap::startPrerender( double dpi )
+{
+  mPrerenderCache.reset();
+  mPrerenderErrors.clear();
+  if ( mPrerenderJob )
+    mPrerenderJob->cancel();
+  mPrerenderJob.reset();
+
+  // only the maps which paint() draws with drawMap() on the export painter, and not the ones
+  // already reusing their layer images between the atlas pages
+  if ( !mLayout || !mUpdatesEnabled || mDrawing || !isVisible() || !shouldDrawItem() || mCurrentExportPart != NotLayered
+       || mLayout->renderContext().isPreviewRender()
+       || ( containsAdvancedEffects() && !( mLayout->renderContext().flags() & QgsLayoutRenderContext::FlagForceVectorOutput ) )
+       || ( mLayout->reportContext().layer() && mLayout->reportContext().feature().isValid() ) )
+    return false;
+
+  const QgsRectangle cExtent = extent();
+  QSizeF size( cExtent.width() * mapUnitsToLayoutUnits(), cExtent.height() * mapUnitsToLayoutUnits() );
+  if ( qgsDoubleNear( size.width(), 0.0 ) || qgsDoubleNear( size.height(), 0.0 ) )
+    return false;
+
+  // same size as in paint()
+  const double dotsPerMM = dpi / 25.4;
+  size *= dotsPerMM;
+  const QgsMapSettings ms = drawMapSettings( cExtent, size, dpi );
+
+  // the cache does not handle the second pass of the selective masking
+  const QList< QgsMapLayer * > layers = ms.layers();
+  for ( QgsMapLayer *layer : layers )
+  {
+    QgsVectorLayer *vl = qobject_cast< QgsVectorLayer * >( layer );
+    if ( vl && ( !QgsVectorLayerUtils::labelMasks( vl ).isEmpty() || !QgsVectorLayerUtils::symbolLayerMasks( vl ).isEmpty() ) )
+      return false;
+  }
+
+  mPrerenderCache = qgis::make_unique< QgsMapRendererCache >();
+  mPrerenderJob = qgis::make_unique< QgsMapRendererParallelJob >( ms );
+  mPrerenderJob->setCache( mPrerenderCache.get() );
+  mPrerenderJob->start();
+  return true;
+}
+
+void QgsLayoutItemMap::waitForPrerender()
+{
+  if ( !mPrerenderJob )
+    return;
+
+  mPrerenderJob->waitForFinished();
+  mPrerenderErrors = mPrerenderJob->errors();
+  const QgsMapSettings ms = mPrerenderJob->mapSettings();
+  mPrerenderJob.reset();
+
+  // without the label image, drawMap() would skip the labels of the cached layers, as it does not render them again
+  bool hasLabels = false;
+  const QList< QgsMapLayer * > layers = ms.layers();
+  for ( QgsMapLayer *layer : layers )
+    hasLabels |= QgsPalLabeling::staticWillUseLayer( layer );
+
+  if ( hasLabels && ms.testFlag( QgsMapSettings::DrawLabeling ) && !mPrerenderCache->hasCacheImage( QgsMapRendererJob::LABEL_CACHE_ID ) )
+  {
+    mPrerenderCache.reset();
+    mPrerenderErrors.clear();
+  }
+}
+
+///@cond PRIVATE
+
+//! Returns TRUE if \a expression may refer to the atlas variables
+static bool expressionDependsOnAtlas( const QString &expression )
+{
+  if ( expression.isEmpty() )
+    return false;
+
+  QgsExpression exp( expression );
+  if ( exp.hasParserError() )
+    return true;
+
+  // the name of a variable is unknown when var() is called with a non literal argument, and eval() can refer to any variable
+  const QSet<QString> variables = exp.referencedVariables();
+  for ( const QString &variable : variables )
+  {
+    if ( variable.isEmpty() || variable.startsWith( QLatin1String( "atlas_" ) ) )
+      return true;
+  }
+  return exp.referencedFunctions().contains( QStringLiteral( "eval" ) );
+}
+
+//! Returns TRUE if an active expression based property of \a properties may refer to the atlas variables
+static bool propertiesDependOnAtlas( const QgsPropertyCollection &properties )
+{
+  const QSet<int> keys = properties.propertyKeys();
+  for ( int key : keys )
+  {
+    const QgsProperty property = properties.property( key );
+    if ( property.isActive() && property.propertyType() == QgsProperty::ExpressionBasedProperty
+         && expressionDependsOnAtlas( property.expressionString() ) )
+      return true;
+  }
+  return false;
+}
+
+//! Returns TRUE if a symbol layer of \a symbol, or of its sub symbols, may refer to the atlas variables
+static bool symbolDependsOnAtlas( QgsSymbol *symbol )
+{
+  if ( !symbol )
+    return false;
+
+  const QgsSymbolLayerList symbolLayers = symbol->symbolLayers();
+  for ( QgsSymbolLayer *symbolLayer : symbolLayers )
+  {
+    if ( propertiesDependOnAtlas( symbolLayer->dataDefinedProperties() ) )
+      return true;
+    if ( const QgsGeometryGeneratorSymbolLayer *generator = dynamic_cast< const QgsGeometryGeneratorSymbolLayer * >( symbolLayer ) )
+    {
+      if ( expressionDependsOnAtlas( generator->geometryExpression() ) )
+        return true;
+    }
+    if ( symbolDependsOnAtlas( symbolLayer->subSymbol() ) )
+      return true;
+  }
+  return false;
+}
+
+/**
+ * Visits the symbols of a renderer, including the symbols which are not returned by
+ * QgsFeatureRenderer::symbols() such as the cluster symbols
+ */
+class AtlasDependentSymbolVisitor : public QgsStyleEntityVisitorInterface
+{
+  public:
+    bool visit( const QgsStyleEntityVisitorInterface::StyleLeaf &entity ) override
+    {
+      if ( entity.entity && entity.entity->type() == QgsStyle::SymbolEntity )
+        dependsOnAtlas |= symbolDependsOnAtlas( static_cast< const QgsStyleSymbolEntity * >( entity.entity )->symbol() );
+      // stop the visit once an atlas dependent symbol is found
+      return !dependsOnAtlas;
+    }
+
+    bool dependsOnAtlas = false;
+};
+
+//! Returns TRUE if \a renderer, or one of its embedded renderers, may refer to the atlas variables
+static bool rendererDependsOnAtlas( const QgsFeatureRenderer *renderer )
+{
+  if ( !renderer )
+    return false;
+
+  AtlasDependentSymbolVisitor visitor;
+  renderer->accept( &visitor );
+  if ( visitor.dependsOnAtlas )
+    return true;
+
+  if ( renderer->orderByEnabled() )
+  {
+    const QgsFeatureRequest::OrderBy orderBy = renderer->orderBy();
+    for ( const QgsFeatureRequest::OrderByClause &clause : orderBy )
+    {
+      if ( expressionDependsOnAtlas( clause.expression().expression() ) )
+        return true;
+    }
+  }
+
+  if ( const QgsRuleBasedRenderer *ruleBased = dynamic_cast< const QgsRuleBasedRenderer * >( renderer ) )
+  {
+    const QgsRuleBasedRenderer::RuleList rules = ruleBased->rootRule()->descendants();
+    for ( const QgsRuleBasedRenderer::Rule *rule : rules )
+    {
+      if ( expressionDependsOnAtlas( rule->filterExpression() ) )
+        return true;
+    }
+  }
+  else if ( const QgsCategorizedSymbolRenderer *categorized = dynamic_cast< const QgsCategorizedSymbolRenderer * >( renderer ) )
+  {
+    if ( expressionDependsOnAtlas( categorized->classAttribute() ) )
+      return true;
+  }
+  else if ( const QgsGraduatedSymbolRenderer *graduated = dynamic_cast< const QgsGraduatedSymbolRenderer * >( renderer ) )
+  {
+    if ( expressionDependsOnAtlas( graduated->classAttribute() ) )
+      return true;
+  }
+  else if ( const QgsHeatmapRenderer *heatmap = dynamic_cast< const QgsHeatmapRenderer * >( renderer ) )
+  {
+    if ( expressionDependsOnAtlas( heatmap->weightExpression() ) )
+      return true;
+  }
+
+  return rendererDependsOnAtlas( renderer->embeddedRenderer() );
+}
+
+//! Returns TRUE if the labels of \a labeling may refer to the atlas variables
+static bool labelingDependsOnAtlas( const QgsAbstractVectorLayerLabeling *labeling )
+{
+  if ( !labeling )
+    return false;
+
+  if ( const QgsRuleBasedLabeling *ruleBased = dynamic_cast< const QgsRuleBasedLabeling * >( labeling ) )
+  {
+    const QgsRuleBasedLabeling::RuleList rules = ruleBased->rootRule()->descendants();
+    for ( const QgsRuleBasedLabeling::Rule *rule : rules )
+    {
+      if ( expressionDependsOnAtlas( rule->filterExpression() ) )
+        return true;
+    }
+  }
+
+  const QStringList providers = labeling->subProviders();
+  for ( const QString &provider : providers )
+  {
+    const QgsPalLayerSettings settings = labeling->settings( provider );
+    if ( ( settings.isExpression && expressionDependsOnAtlas( settings.fieldName ) )
+         || ( settings.geometryGeneratorEnabled && expressionDependsOnAtlas( settings.geometryGenerator ) )
+         || propertiesDependOnAtlas( settings.dataDefinedProperties() )
+         || propertiesDependOnAtlas( settings.format().dataDefinedProperties() )
+         || ( settings.callout() && propertiesDependOnAtlas( settings.callout()->dataDefinedProperties() ) ) )
+      return true;
+  }
+  return false;
+}
+
+//! Returns TRUE if the renderer, the labels or the diagrams of \a layer may refer to the atlas variables
+static bool layerDependsOnAtlas( const QgsVectorLayer *layer )
+{
+  if ( rendererDependsOnAtlas( layer->renderer() ) )
+    return true;
+
+  if ( layer->labelsEnabled() && labelingDependsOnAtlas( layer->labeling() ) )
+    return true;
+
+  if ( const QgsDiagramRenderer *diagrams = layer->diagramRenderer() )
+  {
+    if ( layer->diagramLayerSettings() && propertiesDependOnAtlas( layer->diagramLayerSettings()->dataDefinedProperties() ) )
+      return true;
+    const QList<QString> attributes = diagrams->diagramAttributes();
+    for ( const QString &attribute : attributes )
+    {
+      if ( expressionDependsOnAtlas( attribute ) )
+        return true;
+    }
+  }
+  return false;
+}
+
+///@endcond
+
+QgsMapRendererCache *QgsLayoutItemMap::atlasRenderCache( const QgsMapSettings &settings, QPainter *painter )
+{
+  QgsVectorLayer *coverageLayer = mLayout ? mLayout->reportContext().layer() : nullptr;
+  // the layers are cached as images, which is only transparent for raster outputs. The clipping
+  // regions usually follow the atlas feature
+  if ( !coverageLayer || !mLayout->reportContext().feature().isValid() || !mLayout->project()
+       || !painter->device() || painter->device()->devType() != QInternal::Image || !settings.clippingRegions().isEmpty() )
+  {
+    mAtlasRenderCache.reset();
+    mAtlasRenderCacheSignature.clear();
+    return nullptr;
+  }
+
+  // the cache only checks the extent and the scale, the other settings changing the rendered images
+  // invalidate the whole cache
+  QByteArray signature;
+  QDataStream stream( &signature, QIODevice::WriteOnly );
+  stream << settings.destinationCrs().toWkt() << settings.outputSize() << settings.outputDpi() << settings.rotation()
+         << static_cast< int >( settings.flags() ) << settings.layerStyleOverrides() << settings.backgroundColor()
+         << settings.selectionColor() << static_cast< int >( settings.textRenderFormat() )
+         << settings.isTemporal() << settings.temporalRange().begin() << settings.temporalRange().end();
+  const QList< QgsMapLayer * > layers = settings.layers();
+  for ( QgsMapLayer *layer : layers )
+    stream << layer->id();
+
+  if ( !mAtlasRenderCache )
+    mAtlasRenderCache = qgis::make_unique< QgsMapRendererCache >();
+  if ( signature != mAtlasRenderCacheSignature )
+  {
+    mAtlasRenderCache->clear();
+    mAtlasRenderCacheSignature = signature;
+  }
+
+  // only the project layers which cannot depend on the atlas feature are reused: the raster layers, and the vector
+  // layers other than the coverage layer whose expressions do not refer to the atlas variables. The overview layers
+  // are not in the project, and the style overrides are only applied to the layers while they are rendered
+  const QMap< QString, QString > styleOverrides = settings.layerStyleOverrides();
+  for ( QgsMapLayer *layer : layers )
+  {
+    bool isStatic = false;
+    if ( layer != coverageLayer && mLayout->project()->mapLayer( layer->id() ) == layer && !styleOverrides.contains( layer->id() ) )
+    {
+      if ( qobject_cast< QgsRasterLayer * >( layer ) )
+      {
+        isStatic = true;
+      }
+      else if ( QgsVectorLayer *vl = qobject_cast< QgsVectorLayer * >( layer ) )
+      {
+        auto it = mAtlasStaticLayers.constFind( vl->id() );
+        if ( it == mAtlasStaticLayers.constEnd() )
+        {
+          it = mAtlasStaticLayers.insert( vl->id(), !layerDependsOnAtlas( vl ) );
+          connect( vl, &QgsMapLayer::styleChanged, this, &QgsLayoutItemMap::invalidateAtlasStaticLayer, Qt::UniqueConnection );
+          connect( vl, &QgsMapLayer::rendererChanged, this, &QgsLayoutItemMap::invalidateAtlasStaticLayer, Qt::UniqueConnection );
+          connect( vl, &QgsMapLayer::repaintRequested, this, &QgsLayoutItemMap::invalidateAtlasStaticLayer, Qt::UniqueConnection );
+        }
+        isStatic = it.value();
+      }
+    }
+
+    if ( !isStatic )
+    {
+      mAtlasRenderCache->clearCacheImage( layer->id() );
+      if ( QgsPalLabeling::staticWillUseLayer( layer ) )
+        mAtlasRenderCache->clearCacheImage( QgsMapRendererJob::LABEL_CACHE_ID );
+    }
+  }
+
+  return mAtlasRenderCache.get();
 }
 
 void QgsLayoutItemMap::recreateCachedImageInBackground()
@@ -1919,6 +2266,12 @@ void QgsLayoutItemMap::layersAboutToBeRemoved( const QList<QgsMapLayer *> &layer
   }
 }
 
+void QgsLayoutItemMap::invalidateAtlasStaticLayer()
+{
+  if ( QgsMapLayer *layer = qobject_cast< QgsMapLayer * >( sender() ) )
+    mAtlasStaticLayers.remove( layer->id() );
+}
+
 void QgsLayoutItemMap::painterJobFinished()
 {
   mPainter->end();
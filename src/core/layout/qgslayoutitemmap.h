@@ -29,6 +29,8 @@
 
 class QgsAnnotation;
 class QgsRenderedFeatureHandlerInterface;
+class QgsMapRendererCache;
+class QgsMapRendererParallelJob;
 
 /**
  * \ingroup core
@@ -789,6 +791,30 @@ class CORE_EXPORT QgsLayoutItemMap : public QgsLayoutItem, public QgsTemporalRan
      */
     QgsMapRendererJob::Errors renderingErrors() const { return mRenderingErrors; }
 
+    /**
+     * Starts rendering the layers of the map for a raster export at \a dpi, with the current render
+     * context of the layout, into a cache which the next export of the map uses instead of rendering
+     * the layers again. This lets the maps of a layout render at the same time before the export.
+     *
+     * Returns FALSE if the map cannot be rendered ahead of its export, e.g. because it uses advanced
+     * effects. The map is then rendered as usual during the export.
+     *
+     * \see waitForPrerender()
+     * \note not available in Python bindings
+     * \since QGIS 3.16
+     */
+    bool startPrerender( double dpi ) SIP_SKIP;
+
+    /**
+     * Waits for the render started by startPrerender(). The rendered images are dropped if the
+     * labels could not be cached, the map is then rendered as usual during the export.
+     *
+     * \see startPrerender()
+     * \note not available in Python bindings
+     * \since QGIS 3.16
+     */
+    void waitForPrerender() SIP_SKIP;
+
     bool accept( QgsStyleEntityVisitorInterface *visitor ) const override;
 
     /**
@@ -917,6 +943,9 @@ class CORE_EXPORT QgsLayoutItemMap : public QgsLayoutItem, public QgsTemporalRan
     //! Create cache image
     void recreateCachedImageInBackground();
 
+    //! Forgets whether the sender layer depends on the atlas, after a change of its style
+    void invalidateAtlasStaticLayer();
+
     void updateAtlasFeature();
   private:
 
@@ -1023,6 +1052,9 @@ class CORE_EXPORT QgsLayoutItemMap : public QgsLayoutItem, public QgsTemporalRan
      */
     void drawMap( QPainter *painter, const QgsRectangle &extent, QSizeF size, double dpi );
 
+    //! Returns the settings drawMap() renders the map with
+    QgsMapSettings drawMapSettings( const QgsRectangle &extent, QSizeF size, double dpi );
+
     //! Establishes signal/slot connection for update in case of layer change
     void connectUpdateSlot();
 
@@ -1070,6 +1102,27 @@ class CORE_EXPORT QgsLayoutItemMap : public QgsLayoutItem, public QgsTemporalRan
 
     std::unique_ptr< QgsMapRendererStagedRenderJob > mStagedRendererJob;
 
+    //! Cache of the layer images reused between the atlas pages, for the layers which do not depend on the atlas feature
+    std::unique_ptr< QgsMapRendererCache > mAtlasRenderCache;
+    //! Map settings the atlas render cache was filled with, besides the extent and the scale handled by the cache
+    QByteArray mAtlasRenderCacheSignature;
+    //! Whether the vector layers, by layer id, do not depend on the atlas feature
+    QHash< QString, bool > mAtlasStaticLayers;
+
+    //! Render of the layers started ahead of an export, see startPrerender()
+    std::unique_ptr< QgsMapRendererParallelJob > mPrerenderJob;
+    //! Layer images rendered ahead of an export, used by the next drawMap()
+    std::unique_ptr< QgsMapRendererCache > mPrerenderCache;
+    //! Errors of the render ahead of the export
+    QgsMapRendererJob::Errors mPrerenderErrors;
+
+    /**
+     * Returns the cache to render the map with the specified \a settings on \a painter during an atlas
+     * export, or NULLPTR if the render should not be cached. Only raster outputs are cached, and the
+     * images of the layers which may change with the atlas feature are dropped from the cache.
+     */
+    QgsMapRendererCache *atlasRenderCache( const QgsMapSettings &settings, QPainter *painter );
+
     void init();
 
     //! Resets the item tooltip to reflect current map id
@@ -49,6 +49,7 @@ class CORE_EXPORT QgsLayoutRenderContext : public QObject
       FlagDisableTiledRasterLayerRenders = 1 << 8, //!< If set, then raster layers will not be drawn as separate tiles. This may improve the appearance in exported files, at the cost of much higher memory usage during exports.
       FlagRenderLabelsByMapLayer = 1 << 9, //!< When rendering map items to multi-layered exports, render labels belonging to different layers into separate export layers
       FlagLosslessImageRendering = 1 << 10, //!< Render images losslessly whenever possible, instead of the default lossy jpeg rendering used for some destination devices (e.g. PDF). This flag only works with builds based on Qt 5.13 or later.
+      FlagRenderMapsInParallel = 1 << 11, //!< When exporting to images, render the layers of the maps on several threads, all the maps at the same time (since QGIS 3.16)
     };
     Q_DECLARE_FLAGS( Flags, Flag )
 
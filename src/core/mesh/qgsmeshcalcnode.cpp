@@ -104,6 +104,68 @@ QStringList QgsMeshCalcNode::usedDatasetGroupNames() const
   return res;
 }
 
+bool QgsMeshCalcNode::compileElementWise( QVector<QgsMeshCalcUtils::ElementWiseStep> &steps ) const
+{
+  QgsMeshCalcUtils::ElementWiseStep step;
+  switch ( mType )
+  {
+    case tNumber:
+      step.kind = QgsMeshCalcUtils::ElementWiseStep::Number;
+      step.number = mNumber;
+      break;
+
+    case tNoData:
+      step.kind = QgsMeshCalcUtils::ElementWiseStep::Number;
+      step.number = std::numeric_limits<double>::quiet_NaN();
+      break;
+
+    case tDatasetGroupRef:
+      step.kind = QgsMeshCalcUtils::ElementWiseStep::DatasetGroup;
+      step.datasetGroupName = mDatasetGroupName;
+      break;
+
+    case tOperator:
+      switch ( mOperator )
+      {
+        case opNOT:
+        case opSIGN:
+        case opABS:
+          if ( !mLeft || mRight || !mLeft->compileElementWise( steps ) )
+            return false;
+          step.kind = QgsMeshCalcUtils::ElementWiseStep::UnaryOperation;
+          break;
+
+        case opPLUS:
+        case opMINUS:
+        case opMUL:
+        case opDIV:
+        case opPOW:
+        case opEQ:
+        case opNE:
+        case opGT:
+        case opLT:
+        case opGE:
+        case opLE:
+        case opAND:
+        case opOR:
+        case opMIN:
+        case opMAX:
+          if ( !mLeft || !mRight || !mLeft->compileElementWise( steps ) || !mRight->compileElementWise( steps ) )
+            return false;
+          step.kind = QgsMeshCalcUtils::ElementWiseStep::BinaryOperation;
+          break;
+
+        default:
+          return false;
+      }
+      step.operation = mOperator;
+      break;
+  }
+
+  steps << step;
+  return true;
+}
+
 bool QgsMeshCalcNode::calculate( const  QgsMeshCalcUtils &dsu, QgsMeshMemoryDatasetGroup &result ) const
 {
   if ( mType == tDatasetGroupRef )
@@ -113,6 +175,11 @@ bool QgsMeshCalcNode::calculate( const  QgsMeshCalcUtils &dsu, QgsMeshMemoryData
   }
   else if ( mType == tOperator )
   {
+    // the element wise operations are calculated in a single pass, without intermediate dataset groups
+    QVector<QgsMeshCalcUtils::ElementWiseStep> steps;
+    if ( compileElementWise( steps ) && dsu.calculateElementWise( steps, result ) )
+      return true;
+
     QgsMeshMemoryDatasetGroup leftDatasetGroup( "left", dsu.outputType() );
     QgsMeshMemoryDatasetGroup rightDatasetGroup( "right", dsu.outputType() );
 
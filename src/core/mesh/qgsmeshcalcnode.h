@@ -154,6 +154,12 @@ class CORE_EXPORT QgsMeshCalcNode
   private:
     Q_DISABLE_COPY( QgsMeshCalcNode )
 
+    /**
+     * Appends to \a steps the operations of this node and its children in postfix order.
+     * Returns FALSE if the calculation is not element wise, i.e. uses conditions or aggregates.
+     */
+    bool compileElementWise( QVector<QgsMeshCalcUtils::ElementWiseStep> &steps ) const;
+
     Type mType = tNoData;
     std::unique_ptr<QgsMeshCalcNode> mLeft;
     std::unique_ptr<QgsMeshCalcNode> mRight;
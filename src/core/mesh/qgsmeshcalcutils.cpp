@@ -17,6 +17,7 @@
 ///@cond PRIVATE
 
 #include <QFileInfo>
+#include <QtConcurrentMap>
 
 #include "qgsmeshcalcnode.h"
 #include "qgsmeshcalcutils.h"
@@ -31,6 +32,20 @@ const double D_TRUE = 1.0;
 const double D_FALSE = 0.0;
 const double D_NODATA = std::numeric_limits<double>::quiet_NaN();
 
+//! Calls \a function for each time index lesser than \a count, in parallel
+static void forEachTimeIndex( int count, const std::function<void( int )> &function )
+{
+  if ( count == 1 )
+  {
+    function( 0 );
+    return;
+  }
+
+  QVector<int> timeIndexes( count );
+  std::iota( timeIndexes.begin(), timeIndexes.end(), 0 );
+  QtConcurrent::blockingMap( timeIndexes, [&function]( int timeIndex ) { function( timeIndex ); } );
+}
+
 std::shared_ptr<QgsMeshMemoryDatasetGroup> QgsMeshCalcUtils::createMemoryDatasetGroup( const QString &datasetGroupName, const QgsInterval &relativeTime ) const
 {
   std::shared_ptr<QgsMeshMemoryDatasetGroup> grp;
@@ -617,7 +632,10 @@ void QgsMeshCalcUtils::func1( QgsMeshMemoryDatasetGroup &group,
 {
   Q_ASSERT( isValid() );
 
-  for ( int time_index = 0; time_index < group.datasetCount(); ++time_index )
+  // the mesh is not updated from the threads below
+  updateMesh();
+
+  forEachTimeIndex( group.datasetCount(), [&]( int time_index )
   {
     std::shared_ptr<QgsMeshMemoryDataset> output = canditateDataset( group, time_index );
 
@@ -632,7 +650,7 @@ void QgsMeshCalcUtils::func1( QgsMeshMemoryDatasetGroup &group,
 
     if ( group.dataType() == QgsMeshDatasetGroupMetadata::DataOnVertices )
       activate( output );
-  }
+  } );
 }
 
 
@@ -645,7 +663,11 @@ void QgsMeshCalcUtils::func2( QgsMeshMemoryDatasetGroup &group1,
 
   expand( group1, group2 );
 
-  for ( int time_index = 0; time_index < datasetCount( group1, group2 ); ++time_index )
+  // the mesh is not updated from the threads below
+  updateMesh();
+
+  // each time has its own dataset in group1 once expanded
+  forEachTimeIndex( datasetCount( group1, group2 ), [&]( int time_index )
   {
     std::shared_ptr<QgsMeshMemoryDataset> o1 = canditateDataset( group1, time_index );
     std::shared_ptr<const QgsMeshMemoryDataset> o2 = constCandidateDataset( group2, time_index );
@@ -665,7 +687,7 @@ void QgsMeshCalcUtils::func2( QgsMeshMemoryDatasetGroup &group1,
       activate( o1, o2 );
     }
 
-  }
+  } );
 }
 
 void QgsMeshCalcUtils::funcAggr(
@@ -788,7 +810,10 @@ void QgsMeshCalcUtils::addIf( QgsMeshMemoryDatasetGroup &trueGroup,
   Q_ASSERT( trueGroup.dataType() == falseGroup.dataType() ); // we do not support mixed output types
   Q_ASSERT( trueGroup.dataType() == condition.dataType() ); // we do not support mixed output types
 
-  for ( int time_index = 0; time_index < trueGroup.datasetCount(); ++time_index )
+  // the mesh is not updated from the threads below
+  updateMesh();
+
+  forEachTimeIndex( trueGroup.datasetCount(), [&]( int time_index )
   {
     std::shared_ptr<QgsMeshMemoryDataset> true_o = canditateDataset( trueGroup, time_index );
     std::shared_ptr<const QgsMeshMemoryDataset> false_o = constCandidateDataset( falseGroup, time_index );
@@ -813,7 +838,7 @@ void QgsMeshCalcUtils::addIf( QgsMeshMemoryDatasetGroup &trueGroup,
       // problem is that activate is on elements, but condition is on nodes...
       activate( true_o, condition_o );
     }
-  }
+  } );
 }
 
 
@@ -843,7 +868,7 @@ void QgsMeshCalcUtils::activate(
   Q_ASSERT( dataset );
 
   // Activate only faces that has some data and all vertices
-  for ( int idx = 0; idx < mMeshLayer->dataProvider()->faceCount(); ++idx )
+  for ( int idx = 0; idx < nativeMesh()->faceCount(); ++idx )
   {
     if ( refDataset && !refDataset->active.isEmpty() && ( !refDataset->active[idx] ) )
     {
@@ -1219,6 +1244,269 @@ void QgsMeshCalcUtils::maximum( QgsMeshMemoryDatasetGroup &group1, const QgsMesh
   return func2( group1, group2, std::bind( & QgsMeshCalcUtils::fmax, this, std::placeholders::_1, std::placeholders::_2 ) );
 }
 
+double QgsMeshCalcUtils::elementWiseOperation( int operation, double value ) const
+{
+  switch ( static_cast<QgsMeshCalcNode::Operator>( operation ) )
+  {
+    case QgsMeshCalcNode::opNOT:
+      return flogicalNot( value );
+    case QgsMeshCalcNode::opSIGN:
+      return fchangeSign( value );
+    case QgsMeshCalcNode::opABS:
+      return fabs( value );
+    default:
+      break;
+  }
+
+  Q_ASSERT( false );
+  return D_NODATA;
+}
+
+double QgsMeshCalcUtils::elementWiseOperation( int operation, double value1, double value2 ) const
+{
+  switch ( static_cast<QgsMeshCalcNode::Operator>( operation ) )
+  {
+    case QgsMeshCalcNode::opPLUS:
+      return fadd( value1, value2 );
+    case QgsMeshCalcNode::opMINUS:
+      return fsubtract( value1, value2 );
+    case QgsMeshCalcNode::opMUL:
+      return fmultiply( value1, value2 );
+    case QgsMeshCalcNode::opDIV:
+      return fdivide( value1, value2 );
+    case QgsMeshCalcNode::opPOW:
+      return fpower( value1, value2 );
+    case QgsMeshCalcNode::opEQ:
+      return fequal( value1, value2 );
+    case QgsMeshCalcNode::opNE:
+      return fnotEqual( value1, value2 );
+    case QgsMeshCalcNode::opGT:
+      return fgreaterThan( value1, value2 );
+    case QgsMeshCalcNode::opLT:
+      return flesserThan( value1, value2 );
+    case QgsMeshCalcNode::opGE:
+      return fgreaterEqual( value1, value2 );
+    case QgsMeshCalcNode::opLE:
+      return flesserEqual( value1, value2 );
+    case QgsMeshCalcNode::opAND:
+      return flogicalAnd( value1, value2 );
+    case QgsMeshCalcNode::opOR:
+      return flogicalOr( value1, value2 );
+    case QgsMeshCalcNode::opMIN:
+      return fmin( value1, value2 );
+    case QgsMeshCalcNode::opMAX:
+      return fmax( value1, value2 );
+    default:
+      break;
+  }
+
+  Q_ASSERT( false );
+  return D_NODATA;
+}
+
+bool QgsMeshCalcUtils::calculateElementWise( const QVector<ElementWiseStep> &steps, QgsMeshMemoryDatasetGroup &result ) const
+{
+  Q_ASSERT( isValid() );
+
+  // Times and validity of the datasets of an operand of the steps, following the operations on
+  // dataset groups: the result of an operation has the datasets of its left operand, expanded
+  // to all the times if the right operand has several datasets
+  struct Operand
+  {
+    bool hasSeveralDatasets = false;
+    QVector<double> times;
+    QVector<bool> valid;
+  };
+
+  const int timeCount = mTimes.size();
+  QVector<QVector<std::shared_ptr<const QgsMeshMemoryDataset>>> stepDatasets( steps.size() );
+  QVector<Operand> operands;
+  int maximumDepth = 0;
+  bool hasNoData = false;
+  for ( int i = 0; i < steps.size(); ++i )
+  {
+    const ElementWiseStep &step = steps.at( i );
+    switch ( step.kind )
+    {
+      case ElementWiseStep::Number:
+      {
+        Operand operand;
+        operand.times << mTimes.first();
+        operand.valid << true;
+        operands << operand;
+        // all faces of a NODATA dataset are inactive
+        hasNoData |= std::isnan( step.number );
+        break;
+      }
+
+      case ElementWiseStep::DatasetGroup:
+      {
+        std::shared_ptr<const QgsMeshMemoryDatasetGroup> datasetGroup = mDatasetGroupMap.value( step.datasetGroupName );
+        if ( !datasetGroup || datasetGroup->datasetCount() == 0 )
+          return false;
+
+        Operand operand;
+        if ( datasetGroup->datasetCount() == 1 )
+        {
+          stepDatasets[i] << datasetGroup->constDataset( 0 );
+        }
+        else
+        {
+          // same datasets as copy()
+          for ( int datasetIndex = 0; datasetIndex < datasetGroup->datasetCount(); ++datasetIndex )
+          {
+            std::shared_ptr<const QgsMeshMemoryDataset> dataset = datasetGroup->constDataset( datasetIndex );
+            if ( qgsDoubleNear( dataset->time, mTimes.first() ) ||
+                 qgsDoubleNear( dataset->time, mTimes.last() ) ||
+                 ( ( dataset->time >= mTimes.first() ) && ( dataset->time <= mTimes.last() ) ) )
+              stepDatasets[i] << dataset;
+          }
+          if ( stepDatasets.at( i ).size() != timeCount )
+            return false;
+          operand.hasSeveralDatasets = true;
+        }
+
+        for ( const std::shared_ptr<const QgsMeshMemoryDataset> &dataset : qgis::as_const( stepDatasets[i] ) )
+        {
+          operand.times << dataset->time;
+          operand.valid << dataset->valid;
+        }
+        operands << operand;
+        break;
+      }
+
+      case ElementWiseStep::UnaryOperation:
+        if ( operands.isEmpty() )
+          return false;
+        break;
+
+      case ElementWiseStep::BinaryOperation:
+      {
+        if ( operands.size() < 2 )
+          return false;
+
+        const Operand right = operands.takeLast();
+        Operand &left = operands.last();
+        if ( !left.hasSeveralDatasets && right.hasSeveralDatasets )
+        {
+          // same datasets as expand()
+          for ( int timeIndex = 1; timeIndex < timeCount; ++timeIndex )
+          {
+            left.times << mTimes.at( timeIndex );
+            left.valid << left.valid.first();
+          }
+          left.hasSeveralDatasets = true;
+        }
+        break;
+      }
+    }
+    maximumDepth = std::max( maximumDepth, operands.size() );
+  }
+
+  if ( operands.size() != 1 )
+    return false;
+
+  const Operand &output = operands.first();
+  const int datasetCount = output.hasSeveralDatasets ? timeCount : 1;
+  const bool isOnVertices = mOutputType == QgsMeshDatasetGroupMetadata::DataOnVertices;
+  // the mesh is not updated from the threads below
+  const QgsMesh *mesh = nativeMesh();
+
+  QVector<std::shared_ptr<QgsMeshMemoryDataset>> outputDatasets( datasetCount );
+  for ( int timeIndex = 0; timeIndex < datasetCount; ++timeIndex )
+  {
+    outputDatasets[timeIndex] = createMemoryDataset( mOutputType );
+    outputDatasets[timeIndex]->time = output.times.at( timeIndex );
+    outputDatasets[timeIndex]->valid = output.valid.at( timeIndex );
+  }
+
+  forEachTimeIndex( datasetCount, [&]( int timeIndex )
+  {
+    QgsMeshMemoryDataset &outputDataset = *outputDatasets.at( timeIndex );
+
+    QVector<const QgsMeshMemoryDataset *> datasets;
+    for ( int i = 0; i < steps.size(); ++i )
+    {
+      const QVector<std::shared_ptr<const QgsMeshMemoryDataset>> &datasetsOfStep = stepDatasets.at( i );
+      if ( datasetsOfStep.isEmpty() )
+        datasets << nullptr;
+      else
+        datasets << ( datasetsOfStep.size() == 1 ? datasetsOfStep.first().get() : datasetsOfStep.at( timeIndex ).get() );
+    }
+
+    QVector<double> stack( maximumDepth );
+    for ( int n = 0; n < outputDataset.values.size(); ++n )
+    {
+      int depth = 0;
+      for ( int i = 0; i < steps.size(); ++i )
+      {
+        const ElementWiseStep &step = steps.at( i );
+        switch ( step.kind )
+        {
+          case ElementWiseStep::Number:
+            stack[depth++] = step.number;
+            break;
+
+          case ElementWiseStep::DatasetGroup:
+            stack[depth++] = datasets.at( i )->values.at( n ).scalar();
+            break;
+
+          case ElementWiseStep::UnaryOperation:
+          {
+            double &value = stack[depth - 1];
+            value = std::isnan( value ) ? D_NODATA : elementWiseOperation( step.operation, value );
+            break;
+          }
+
+          case ElementWiseStep::BinaryOperation:
+          {
+            --depth;
+            const double value2 = stack.at( depth );
+            double &value1 = stack[depth - 1];
+            value1 = ( std::isnan( value1 ) || std::isnan( value2 ) ) ? D_NODATA : elementWiseOperation( step.operation, value1, value2 );
+            break;
+          }
+        }
+      }
+      outputDataset.values[n] = stack.at( 0 );
+    }
+
+    if ( isOnVertices )
+    {
+      // a face is active if it is active in all the datasets and has values on all its vertices, as with activate()
+      for ( int faceIndex = 0; faceIndex < mesh->faceCount(); ++faceIndex )
+      {
+        bool isActive = !hasNoData;
+        for ( const QgsMeshMemoryDataset *dataset : qgis::as_const( datasets ) )
+        {
+          if ( isActive && dataset && !dataset->active.isEmpty() && !dataset->active.at( faceIndex ) )
+            isActive = false;
+        }
+
+        if ( isActive )
+        {
+          const QgsMeshFace &face = mesh->faces.at( faceIndex );
+          for ( int vertexIndex : face )
+          {
+            if ( std::isnan( outputDataset.values.at( vertexIndex ).scalar() ) )
+            {
+              isActive = false;
+              break;
+            }
+          }
+        }
+        outputDataset.active[faceIndex] = isActive;
+      }
+    }
+  } );
+
+  result.clearDatasets();
+  for ( const std::shared_ptr<QgsMeshMemoryDataset> &outputDataset : qgis::as_const( outputDatasets ) )
+    result.addDataset( outputDataset );
+
+  return true;
+}
+
 QgsMeshDatasetGroupMetadata::DataType QgsMeshCalcUtils::determineResultDataType( QgsMeshLayer *layer, const QStringList &usedGroupNames )
 {
   QHash<QString, int> names;
@@ -28,6 +28,7 @@
 
 #include <algorithm>
 #include <functional>
+#include <limits>
 #include <math.h>
 #include <numeric>
 
@@ -49,6 +50,31 @@ class CORE_EXPORT QgsMeshCalcUtils
 {
   public:
 
+    /**
+     * A step of an element wise calculation, see calculateElementWise()
+     *
+     * \since QGIS 3.16
+     */
+    struct ElementWiseStep
+    {
+      //! Kinds of steps
+      enum Kind
+      {
+        Number, //!< Pushes a number
+        DatasetGroup, //!< Pushes the values of a dataset group
+        UnaryOperation, //!< Replaces the last value by the result of an unary operation
+        BinaryOperation, //!< Replaces the two last values by the result of a binary operation
+      };
+
+      Kind kind = Number;
+      //! Pushed number
+      double number = std::numeric_limits<double>::quiet_NaN();
+      //! Name of the dataset group whose values are pushed
+      QString datasetGroupName;
+      //! QgsMeshCalcNode::Operator of the operation
+      int operation = 0;
+    };
+
     /**
      * Creates the utils and validates the input
      *
@@ -190,6 +216,20 @@ class CORE_EXPORT QgsMeshCalcUtils
     //! Operator maximum
     void maximum( QgsMeshMemoryDatasetGroup &group1, const QgsMeshMemoryDatasetGroup &group2 ) const;
 
+    /**
+     * Calculates the element wise operations of \a steps, in reverse polish notation, to \a result.
+     *
+     * The operations are evaluated in a single pass over the values of the datasets, without intermediate
+     * dataset groups, and the datasets of the different times are calculated in parallel. The result
+     * is the same as the one of the matching operations on the dataset groups.
+     *
+     * Only the unary and binary operations that are applied element by element are supported, returns
+     * FALSE if \a steps cannot be calculated this way.
+     *
+     * \since QGIS 3.16
+     */
+    bool calculateElementWise( const QVector<ElementWiseStep> &steps, QgsMeshMemoryDatasetGroup &result ) const;
+
     //! Calculates the data type of result dataset group
     static QgsMeshDatasetGroupMetadata::DataType determineResultDataType( QgsMeshLayer *layer, const QStringList &usedGroupNames );
 
@@ -288,6 +328,12 @@ class CORE_EXPORT QgsMeshCalcUtils
                 const QgsMeshMemoryDatasetGroup &group2,
                 std::function<double( double, double )> func ) const;
 
+    //! Returns the result of the unary element wise \a operation on \a value
+    double elementWiseOperation( int operation, double value ) const;
+
+    //! Returns the result of the binary element wise \a operation on \a value1 and \a value2
+    double elementWiseOperation( int operation, double value1, double value2 ) const;
+
     //! Calculates unary aggregate operator (e.g. sum of values of one vertex for all times)
     void funcAggr( QgsMeshMemoryDatasetGroup &group1,
                    std::function<double( QVector<double>& )> func ) const;
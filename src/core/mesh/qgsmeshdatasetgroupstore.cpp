@@ -20,6 +20,38 @@
 #include "qgsmeshlayerutils.h"
 #include "qgsapplication.h"
 #include "qgsmeshvirtualdatasetgroup.h"
+#include "qgssettings.h"
+
+#include <QThread>
+#include <QTimer>
+
+//! Returns the \a count values from \a offset of a \a block
+static QgsMeshDataBlock sliceBlock( const QgsMeshDataBlock &block, int offset, int count )
+{
+  if ( offset == 0 && count == block.count() )
+    return block;
+
+  QgsMeshDataBlock slice( block.type(), count );
+  switch ( block.type() )
+  {
+    case QgsMeshDataBlock::ActiveFlagInteger:
+    {
+      const QVector<int> active = block.active();
+      if ( active.isEmpty() )
+        slice.setValid( true ); // all the faces are active
+      else
+        slice.setActive( active.mid( offset, count ) );
+      break;
+    }
+    case QgsMeshDataBlock::ScalarDouble:
+      slice.setValues( block.values().mid( offset, count ) );
+      break;
+    case QgsMeshDataBlock::Vector2DDouble:
+      slice.setValues( block.values().mid( 2 * offset, 2 * count ) );
+      break;
+  }
+  return slice;
+}
 
 
 QList<int> QgsMeshDatasetGroupStore::datasetGroupIndexes() const
@@ -41,7 +73,136 @@ QgsMeshDatasetGroupStore::QgsMeshDatasetGroupStore( QgsMeshLayer *layer ):
   mLayer( layer ),
   mExtraDatasets( new QgsMeshExtraDatasetStore ),
   mDatasetGroupTreeRootItem( new QgsMeshDatasetGroupTreeItem )
-{}
+{
+  setDatasetCacheMaximumBytes( QgsSettings().value( QStringLiteral( "qgis/meshDatasetCacheMemory" ), 256 ).toLongLong() * 1024 * 1024 );
+}
+
+void QgsMeshDatasetGroupStore::setDatasetCacheMaximumBytes( qint64 bytes )
+{
+  QMutexLocker locker( &mCacheMutex );
+  // the costs are in KB
+  mCache.setMaxCost( static_cast<int>( std::min( bytes / 1024, static_cast<qint64>( std::numeric_limits<int>::max() ) ) ) );
+}
+
+qint64 QgsMeshDatasetGroupStore::datasetCacheMaximumBytes() const
+{
+  QMutexLocker locker( &mCacheMutex );
+  return static_cast<qint64>( mCache.maxCost() ) * 1024;
+}
+
+void QgsMeshDatasetGroupStore::clearDatasetCache()
+{
+  QMutexLocker locker( &mCacheMutex );
+  mCache.clear();
+  mLastReadDatasets.clear();
+}
+
+bool QgsMeshDatasetGroupStore::cachedBlock( BlockKind kind, int group, int dataset, int start, int count, CachedBlock &block ) const
+{
+  QMutexLocker locker( &mCacheMutex );
+  const CachedBlock *cached = mCache.object( CacheKey( kind, qMakePair( group, dataset ) ) );
+  if ( !cached )
+    return false;
+
+  if ( kind == Values3dBlock ? ( cached->start != start || cached->count != count )
+       : ( start < cached->start || start + count > cached->start + cached->count ) )
+    return false;
+
+  block = *cached;
+  return true;
+}
+
+void QgsMeshDatasetGroupStore::cacheBlock( BlockKind kind, int group, int dataset, const CachedBlock &block ) const
+{
+  qint64 bytes = 0;
+  if ( kind == Values3dBlock )
+  {
+    if ( !block.block3d.isValid() )
+      return;
+    bytes = static_cast<qint64>( block.block3d.values().size() + block.block3d.verticalLevels().size() ) * sizeof( double ) +
+            static_cast<qint64>( block.block3d.verticalLevelsCount().size() + block.block3d.faceToVolumeIndex().size() ) * sizeof( int );
+  }
+  else
+  {
+    if ( !block.block.isValid() )
+      return;
+    bytes = block.block.type() == QgsMeshDataBlock::ActiveFlagInteger ? static_cast<qint64>( block.block.active().size() ) * sizeof( int )
+            : static_cast<qint64>( block.block.values().size() ) * sizeof( double );
+  }
+
+  QMutexLocker locker( &mCacheMutex );
+  const CacheKey key( kind, qMakePair( group, dataset ) );
+  // keep the largest block read for the dataset
+  const CachedBlock *cached = mCache.object( key );
+  if ( cached && cached->count > block.count )
+    return;
+
+  mCache.insert( key, new CachedBlock( block ), static_cast<int>( std::max( static_cast<qint64>( 1 ), bytes / 1024 ) ) );
+}
+
+QgsMeshDatasetGroupStore::CachedBlock QgsMeshDatasetGroupStore::readBlock( BlockKind kind, int group, int dataset, int start, int count ) const
+{
+  CachedBlock block;
+  block.start = start;
+  block.count = count;
+  const QgsMeshDatasetIndex nativeIndex( group, dataset );
+  switch ( kind )
+  {
+    case ValuesBlock:
+      block.block = mPersistentProvider->datasetValues( nativeIndex, start, count );
+      break;
+    case ActiveFlagsBlock:
+      block.block = mPersistentProvider->areFacesActive( nativeIndex, start, count );
+      break;
+    case Values3dBlock:
+      block.block3d = mPersistentProvider->dataset3dValues( nativeIndex, start, count );
+      break;
+  }
+  return block;
+}
+
+void QgsMeshDatasetGroupStore::prefetchNextDataset( BlockKind kind, int group, int dataset, int start, int count ) const
+{
+  // the provider is only read from the thread of the layer
+  if ( QThread::currentThread() != thread() || !mPersistentProvider )
+    return;
+
+  const int nextDataset = dataset + 1;
+  const CacheKey nextKey( kind, qMakePair( group, nextDataset ) );
+  {
+    QMutexLocker locker( &mCacheMutex );
+    const QPair<int, int> sequence( kind, group );
+    const bool sequential = mLastReadDatasets.contains( sequence ) && mLastReadDatasets.value( sequence ) == dataset - 1;
+    mLastReadDatasets[sequence] = dataset;
+    if ( !sequential || mPendingPrefetches.contains( nextKey ) )
+      return;
+    mPendingPrefetches.insert( nextKey );
+  }
+
+  if ( nextDataset >= mPersistentProvider->datasetCount( group ) )
+  {
+    QMutexLocker locker( &mCacheMutex );
+    mPendingPrefetches.remove( nextKey );
+    return;
+  }
+
+  // read the next dataset once the event loop is idle, e.g. while the current one is rendered
+  QgsMeshDatasetGroupStore *store = const_cast<QgsMeshDatasetGroupStore *>( this );
+  QTimer::singleShot( 0, store, [store, kind, group, nextDataset, nextKey, start, count]
+  {
+    {
+      QMutexLocker locker( &store->mCacheMutex );
+      store->mPendingPrefetches.remove( nextKey );
+    }
+
+    CachedBlock cached;
+    if ( !store->mPersistentProvider || group >= store->mPersistentProvider->datasetGroupCount() ||
+         store->cachedBlock( kind, group, nextDataset, start, count, cached ) )
+      return;
+
+    store->cacheBlock( kind, group, nextDataset, store->readBlock( kind, group, nextDataset, start, count ) );
+  } );
+}
 
 void QgsMeshDatasetGroupStore::setPersistentProvider( QgsMeshDataProvider *provider )
 {
@@ -158,46 +319,84 @@ QgsMeshDatasetMetadata QgsMeshDatasetGroupStore::datasetMetadata( const QgsMeshD
 QgsMeshDatasetValue QgsMeshDatasetGroupStore::datasetValue( const QgsMeshDatasetIndex &index, int valueIndex ) const
 {
   QgsMeshDatasetGroupStore::DatasetGroup  group = datasetGroup( index.group() );
-  if ( group.first )
-    return group.first->datasetValue( QgsMeshDatasetIndex( group.second, index.dataset() ), valueIndex );
-  else
+  if ( !group.first )
     return QgsMeshDatasetValue();
+
+  CachedBlock cached;
+  if ( group.first == mPersistentProvider && cachedBlock( ValuesBlock, group.second, index.dataset(), valueIndex, 1, cached ) )
+    return cached.block.value( valueIndex - cached.start );
+
+  return group.first->datasetValue( QgsMeshDatasetIndex( group.second, index.dataset() ), valueIndex );
 }
 
 QgsMeshDataBlock QgsMeshDatasetGroupStore::datasetValues( const QgsMeshDatasetIndex &index, int valueIndex, int count ) const
 {
   QgsMeshDatasetGroupStore::DatasetGroup  group = datasetGroup( index.group() );
-  if ( group.first )
-    return group.first->datasetValues( QgsMeshDatasetIndex( group.second, index.dataset() ), valueIndex, count );
-  else
+  if ( !group.first )
     return QgsMeshDataBlock();
+
+  if ( group.first != mPersistentProvider )
+    return group.first->datasetValues( QgsMeshDatasetIndex( group.second, index.dataset() ), valueIndex, count );
+
+  CachedBlock cached;
+  if ( !cachedBlock( ValuesBlock, group.second, index.dataset(), valueIndex, count, cached ) )
+  {
+    cached = readBlock( ValuesBlock, group.second, index.dataset(), valueIndex, count );
+    cacheBlock( ValuesBlock, group.second, index.dataset(), cached );
+  }
+  prefetchNextDataset( ValuesBlock, group.second, index.dataset(), valueIndex, count );
+  return cached.block.isValid() ? sliceBlock( cached.block, valueIndex - cached.start, count ) : cached.block;
 }
 
 QgsMesh3dDataBlock QgsMeshDatasetGroupStore::dataset3dValues( const QgsMeshDatasetIndex &index, int faceIndex, int count ) const
 {
   QgsMeshDatasetGroupStore::DatasetGroup  group = datasetGroup( index.group() );
-  if ( group.first )
-    return group.first->dataset3dValues( QgsMeshDatasetIndex( group.second, index.dataset() ), faceIndex, count );
-  else
+  if ( !group.first )
     return QgsMesh3dDataBlock();
+
+  if ( group.first != mPersistentProvider )
+    return group.first->dataset3dValues( QgsMeshDatasetIndex( group.second, index.dataset() ), faceIndex, count );
+
+  CachedBlock cached;
+  if ( !cachedBlock( Values3dBlock, group.second, index.dataset(), faceIndex, count, cached ) )
+  {
+    cached = readBlock( Values3dBlock, group.second, index.dataset(), faceIndex, count );
+    cacheBlock( Values3dBlock, group.second, index.dataset(), cached );
+  }
+  prefetchNextDataset( Values3dBlock, group.second, index.dataset(), faceIndex, count );
+  return cached.block3d;
 }
 
 QgsMeshDataBlock QgsMeshDatasetGroupStore::areFacesActive( const QgsMeshDatasetIndex &index, int faceIndex, int count ) const
 {
   QgsMeshDatasetGroupStore::DatasetGroup  group = datasetGroup( index.group() );
-  if ( group.first )
-    return group.first->areFacesActive( QgsMeshDatasetIndex( group.second, index.dataset() ), faceIndex, count );
-  else
+  if ( !group.first )
     return QgsMeshDataBlock();
+
+  if ( group.first != mPersistentProvider )
+    return group.first->areFacesActive( QgsMeshDatasetIndex( group.second, index.dataset() ), faceIndex, count );
+
+  CachedBlock cached;
+  if ( !cachedBlock( ActiveFlagsBlock, group.second, index.dataset(), faceIndex, count, cached ) )
+  {
+    cached = readBlock( ActiveFlagsBlock, group.second, index.dataset(), faceIndex, count );
+    cacheBlock( ActiveFlagsBlock, group.second, index.dataset(), cached );
+  }
+  prefetchNextDataset( ActiveFlagsBlock, group.second, index.dataset(), faceIndex, count );
+  return cached.block.isValid() ? sliceBlock( cached.block, faceIndex - cached.start, count ) : cached.block;
 }
 
 bool QgsMeshDatasetGroupStore::isFaceActive( const QgsMeshDatasetIndex &index, int faceIndex ) const
 {
   QgsMeshDatasetGroupStore::DatasetGroup  group = datasetGroup( index.group() );
-  if ( group.first )
-    return group.first->isFaceActive( QgsMeshDatasetIndex( group.second, index.dataset() ), faceIndex );
-  else
+  if ( !group.first )
     return false;
+
+  CachedBlock cached;
+  if ( group.first == mPersistentProvider && cachedBlock( ActiveFlagsBlock, group.second, index.dataset(), faceIndex, 1, cached ) )
+    return cached.block.active( faceIndex - cached.start );
+
+  return group.first->isFaceActive( QgsMeshDatasetIndex( group.second, index.dataset() ), faceIndex );
 }
 
 QgsMeshDatasetIndex QgsMeshDatasetGroupStore::datasetIndexAtTime(
@@ -384,6 +583,7 @@ void QgsMeshDatasetGroupStore::removePersistentProvider()
   }
 
   mPersistentProvider = nullptr;
+  clearDatasetCache();
 }
 
 int QgsMeshDatasetGroupStore::newIndex()
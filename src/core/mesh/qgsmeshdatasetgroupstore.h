@@ -23,6 +23,10 @@
 #include "qgsmeshdataprovider.h"
 #include "qgsmeshdataset.h"
 
+#include <QCache>
+#include <QMutex>
+#include <QSet>
+
 class QgsMeshLayer;
 
 /**
@@ -114,6 +118,10 @@ class QgsMeshExtraDatasetStore: public QgsMeshDatasetSourceInterface
  *
  * This class as also the responsibility to handle the dataset group tree item that contain information to display the available dataset (\see QgsMeshDatasetGroupTreeItem)
  *
+ * The blocks of values and active flags read from the persistent provider are kept in a least recently used cache, bounded
+ * in bytes. Reads of a part of a cached block, or of single values, are served from the cache. When the datasets of a group
+ * are read in sequence, e.g. during a temporal animation, the next dataset is read in advance, once the event loop is idle.
+ *
  * \since QGIS 3.16
  */
 class QgsMeshDatasetGroupStore: public QObject
@@ -203,6 +211,18 @@ class QgsMeshDatasetGroupStore: public QObject
     //! Reads the store's information from a DOM document
     void readXml( const QDomElement &storeElem, const QgsReadWriteContext &context );
 
+    /**
+     * Sets the maximum size in \a bytes of the blocks read from the persistent provider kept in the cache.
+     * The default value is read from the "qgis/meshDatasetCacheMemory" setting, in MB, 256 if not set.
+     */
+    void setDatasetCacheMaximumBytes( qint64 bytes );
+
+    //! Returns the maximum size in bytes of the blocks read from the persistent provider kept in the cache
+    qint64 datasetCacheMaximumBytes() const;
+
+    //! Drops the blocks read from the persistent provider from the cache, e.g. when its data is reloaded
+    void clearDatasetCache();
+
   signals:
     //! Emitted after dataset groups are added
     void datasetGroupsAdded( QList<int> indexes );
@@ -211,6 +231,47 @@ class QgsMeshDatasetGroupStore: public QObject
     void onPersistentDatasetAdded( int count );
 
   private:
+
+    //! Kinds of blocks read from the persistent provider
+    enum BlockKind
+    {
+      ValuesBlock,
+      ActiveFlagsBlock,
+      Values3dBlock,
+    };
+
+    //! Block read from the persistent provider, for the values from \a start
+    struct CachedBlock
+    {
+      int start = 0;
+      int count = 0;
+      QgsMeshDataBlock block;
+      QgsMesh3dDataBlock block3d;
+    };
+
+    //! Kind, native group index and dataset index of a cached block
+    typedef QPair<int, QPair<int, int>> CacheKey;
+
+    /**
+     * Returns in \a block the cached block of \a kind covering the \a count values from \a start of the
+     * \a dataset of the native \a group, returns FALSE if there is none. 3D blocks must match exactly.
+     */
+    bool cachedBlock( BlockKind kind, int group, int dataset, int start, int count, CachedBlock &block ) const;
+
+    //! Adds a \a block read from the persistent provider to the cache
+    void cacheBlock( BlockKind kind, int group, int dataset, const CachedBlock &block ) const;
+
+    //! Reads a block from the persistent provider
+    CachedBlock readBlock( BlockKind kind, int group, int dataset, int start, int count ) const;
+
+    //! Reads the next dataset of the \a group in advance if the datasets are read in sequence
+    void prefetchNextDataset( BlockKind kind, int group, int dataset, int start, int count ) const;
+
+    mutable QMutex mCacheMutex;
+    mutable QCache<CacheKey, CachedBlock> mCache;
+    mutable QHash<QPair<int, int>, int> mLastReadDatasets;
+    mutable QSet<CacheKey> mPendingPrefetches;
+
     QgsMeshLayer *mLayer = nullptr;
     QgsMeshDataProvider *mPersistentProvider = nullptr;
     std::unique_ptr<QgsMeshExtraDatasetStore> mExtraDatasets;
@@ -18,8 +18,15 @@
 #include <cstddef>
 #include <limits>
 
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
 #include <QUuid>
 
+#include "qgsapplication.h"
 #include "qgscolorramp.h"
 #include "qgslogger.h"
 #include "qgsmaplayerlegend.h"
@@ -27,6 +34,7 @@
 #include "qgsmeshdatasetgroupstore.h"
 #include "qgsmeshlayer.h"
 #include "qgsmeshlayerrenderer.h"
+#include "qgsmeshsimplificationtask_p.h"
 #include "qgsmeshlayertemporalproperties.h"
 #include "qgsmeshlayerutils.h"
 #include "qgsmeshtimesettings.h"
@@ -37,6 +45,156 @@
 #include "qgstriangularmesh.h"
 #include "qgsmesh3daveraging.h"
 
+///@cond PRIVATE
+
+//! Identifies the files storing simplified meshes
+static const quint32 LEVELS_FILE_MAGIC = 0x514d4c44;
+//! Version of the format of the files storing simplified meshes, part of their signature
+static const qint32 LEVELS_FILE_VERSION = 1;
+
+QgsMeshSimplificationTask::QgsMeshSimplificationTask( const QString &layerName, const QgsTriangularMesh &baseMesh, double reductionFactor, const QString &levelsFilePath )
+  : QgsTask( tr( "Simplifying mesh of %1" ).arg( layerName ), QgsTask::CanCancel | QgsTask::CancelWithoutPrompt )
+  , mBaseMesh( baseMesh )
+  , mReductionFactor( reductionFactor )
+  , mLevelsFilePath( levelsFilePath )
+{
+}
+
+bool QgsMeshSimplificationTask::run()
+{
+  const QByteArray meshSignature = signature();
+  if ( isCanceled() )
+    return false;
+
+  if ( !mLevelsFilePath.isEmpty() && readLevels( meshSignature ) )
+  {
+    QgsDebugMsgLevel( QStringLiteral( "%1 simplified meshes restored from %2" ).arg( mSimplifiedMeshes.size() ).arg( mLevelsFilePath ), 2 );
+    return true;
+  }
+
+  const QVector<QgsTriangularMesh *> simplifiedMeshes = mBaseMesh.simplifyMesh( mReductionFactor );
+  for ( QgsTriangularMesh *simplifiedMesh : simplifiedMeshes )
+    mSimplifiedMeshes.emplace_back( simplifiedMesh );
+
+  if ( isCanceled() )
+    return false;
+
+  if ( !mLevelsFilePath.isEmpty() && !writeLevels( meshSignature ) )
+    QgsDebugMsg( QStringLiteral( "Simplified meshes could not be stored in %1" ).arg( mLevelsFilePath ) );
+
+  return true;
+}
+
+std::vector<std::unique_ptr<QgsTriangularMesh>> QgsMeshSimplificationTask::takeSimplifiedMeshes()
+{
+  return std::move( mSimplifiedMeshes );
+}
+
+QString QgsMeshSimplificationTask::levelsFilePath( const QString &providerKey, const QString &source )
+{
+  const QByteArray sourceHash = QCryptographicHash::hash( QStringLiteral( "%1:%2" ).arg( providerKey, source ).toUtf8(), QCryptographicHash::Md5 );
+  return QgsApplication::qgisSettingsDirPath() + QStringLiteral( "mesh_levels/%1.lod" ).arg( QString::fromLatin1( sourceHash.toHex() ) );
+}
+
+QByteArray QgsMeshSimplificationTask::signature() const
+{
+  // the simplified meshes only depend on the vertices and the triangles of the base mesh
+  QCryptographicHash hash( QCryptographicHash::Md5 );
+  hash.addData( reinterpret_cast< const char * >( &LEVELS_FILE_VERSION ), sizeof( LEVELS_FILE_VERSION ) );
+  hash.addData( reinterpret_cast< const char * >( &mReductionFactor ), sizeof( mReductionFactor ) );
+  for ( const QgsMeshVertex &vertex : mBaseMesh.vertices() )
+  {
+    const double coordinates[] = { vertex.x(), vertex.y(), vertex.z() };
+    hash.addData( reinterpret_cast< const char * >( coordinates ), sizeof( coordinates ) );
+  }
+  for ( const QgsMeshFace &triangle : mBaseMesh.triangles() )
+    hash.addData( reinterpret_cast< const char * >( triangle.constData() ), triangle.size() * static_cast< int >( sizeof( int ) ) );
+  hash.addData( reinterpret_cast< const char * >( mBaseMesh.trianglesToNativeFaces().constData() ), mBaseMesh.trianglesToNativeFaces().size() * static_cast< int >( sizeof( int ) ) );
+  return hash.result();
+}
+
+bool QgsMeshSimplificationTask::readLevels( const QByteArray &signature )
+{
+  QFile file( mLevelsFilePath );
+  if ( !file.open( QIODevice::ReadOnly ) )
+    return false;
+
+  QDataStream stream( &file );
+  stream.setVersion( QDataStream::Qt_5_0 );
+  quint32 magic = 0;
+  qint32 version = 0;
+  QByteArray fileSignature;
+  qint32 levelCount = 0;
+  stream >> magic >> version >> fileSignature >> levelCount;
+  if ( stream.status() != QDataStream::Ok || magic != LEVELS_FILE_MAGIC || version != LEVELS_FILE_VERSION || fileSignature != signature )
+    return false;
+
+  const int vertexCount = mBaseMesh.vertices().count();
+  std::vector<std::unique_ptr<QgsTriangularMesh>> simplifiedMeshes;
+  for ( int level = 0; level < levelCount; ++level )
+  {
+    if ( isCanceled() )
+      return false;
+
+    qint32 levelOfDetail = 0;
+    QVector<int> indexes;
+    QVector<int> trianglesToNativeFaces;
+    stream >> levelOfDetail >> indexes >> trianglesToNativeFaces;
+    if ( stream.status() != QDataStream::Ok || indexes.size() != trianglesToNativeFaces.size() * 3 )
+      return false;
+
+    QVector<QgsMeshFace> triangles( trianglesToNativeFaces.size() );
+    for ( int i = 0; i < triangles.size(); ++i )
+    {
+      QgsMeshFace triangle( 3 );
+      for ( int j = 0; j < 3; ++j )
+      {
+        const int index = indexes.at( i * 3 + j );
+        if ( index < 0 || index >= vertexCount )
+          return false;
+        triangle[j] = index;
+      }
+      triangles[i] = triangle;
+    }
+
+    simplifiedMeshes.emplace_back( mBaseMesh.simplifiedMesh( triangles, trianglesToNativeFaces, levelOfDetail ) );
+  }
+
+  mSimplifiedMeshes = std::move( simplifiedMeshes );
+  return true;
+}
+
+bool QgsMeshSimplificationTask::writeLevels( const QByteArray &signature ) const
+{
+  if ( !QDir().mkpath( QFileInfo( mLevelsFilePath ).absolutePath() ) )
+    return false;
+
+  QSaveFile file( mLevelsFilePath );
+  if ( !file.open( QIODevice::WriteOnly ) )
+    return false;
+
+  QDataStream stream( &file );
+  stream.setVersion( QDataStream::Qt_5_0 );
+  stream << LEVELS_FILE_MAGIC << LEVELS_FILE_VERSION << signature << static_cast< qint32 >( mSimplifiedMeshes.size() );
+  for ( const std::unique_ptr<QgsTriangularMesh> &simplifiedMesh : mSimplifiedMeshes )
+  {
+    QVector<int> indexes;
+    indexes.reserve( simplifiedMesh->triangles().size() * 3 );
+    for ( const QgsMeshFace &triangle : simplifiedMesh->triangles() )
+      indexes << triangle.at( 0 ) << triangle.at( 1 ) << triangle.at( 2 );
+    stream << static_cast< qint32 >( simplifiedMesh->levelOfDetail() ) << indexes << simplifiedMesh->trianglesToNativeFaces();
+  }
+
+  if ( stream.status() != QDataStream::Ok )
+  {
+    file.cancelWriting();
+    return false;
+  }
+  return file.commit();
+}
+
+///@endcond
+
 QgsMeshLayer::QgsMeshLayer( const QString &meshLayerPath,
                             const QString &baseName,
                             const QString &providerKey,
@@ -122,18 +280,49 @@ void QgsMeshLayer::setDefaultRendererSettings( const QList<int> &groupIndexes )
 
 void QgsMeshLayer::createSimplifiedMeshes()
 {
-  if ( mSimplificationSettings.isEnabled() && !hasSimplifiedMeshes() )
+  if ( !mSimplificationSettings.isEnabled() || mSimplifiedMeshesBuilt || mSimplificationTask || mTriangularMeshes.empty() )
+    return;
+
+  // the base mesh is rendered until the simplified meshes are built
+  mSimplificationTask = new QgsMeshSimplificationTask( name(), *mTriangularMeshes[0], mSimplificationSettings.reductionFactor(),
+      QgsMeshSimplificationTask::levelsFilePath( mProviderKey, source() ) );
+  connect( mSimplificationTask, &QgsTask::taskCompleted, this, &QgsMeshLayer::onSimplificationTaskFinished );
+  connect( mSimplificationTask, &QgsTask::taskTerminated, this, &QgsMeshLayer::onSimplificationTaskFinished );
+  QgsApplication::taskManager()->addTask( mSimplificationTask );
+}
+
+void QgsMeshLayer::resetSimplifiedMeshes()
+{
+  if ( mSimplificationTask )
   {
-    double reductionFactor = mSimplificationSettings.reductionFactor();
+    disconnect( mSimplificationTask, nullptr, this, nullptr );
+    mSimplificationTask->cancel();
+    mSimplificationTask = nullptr;
+  }
+  mSimplifiedMeshesBuilt = false;
+
+  if ( !mTriangularMeshes.empty() )
+    mTriangularMeshes.resize( 1 );
+}
 
-    QVector<QgsTriangularMesh *> simplifyMeshes =
-      mTriangularMeshes[0]->simplifyMesh( reductionFactor );
+void QgsMeshLayer::onSimplificationTaskFinished()
+{
+  if ( !mSimplificationTask )
+    return;
 
-    for ( int i = 0; i < simplifyMeshes.count() ; ++i )
-    {
-      mTriangularMeshes.emplace_back( simplifyMeshes[i] );
-    }
+  if ( mSimplificationTask->status() == QgsTask::Complete )
+  {
+    std::vector<std::unique_ptr<QgsTriangularMesh>> simplifiedMeshes = mSimplificationTask->takeSimplifiedMeshes();
+    for ( std::unique_ptr<QgsTriangularMesh> &simplifiedMesh : simplifiedMeshes )
+      mTriangularMeshes.emplace_back( std::move( simplifiedMesh ) );
+
+    if ( !simplifiedMeshes.empty() )
+      triggerRepaint();
   }
+
+  // do not start again a canceled task at the next rendering
+  mSimplificationTask = nullptr;
+  mSimplifiedMeshesBuilt = true;
 }
 
 bool QgsMeshLayer::hasSimplifiedMeshes() const
@@ -144,6 +333,8 @@ bool QgsMeshLayer::hasSimplifiedMeshes() const
 
 QgsMeshLayer::~QgsMeshLayer()
 {
+  if ( mSimplificationTask )
+    mSimplificationTask->cancel();
   delete mDataProvider;
 }
 
@@ -253,6 +444,20 @@ QgsTriangularMesh *QgsMeshLayer::triangularMesh( double minimumTriangleSize ) co
     return nullptr;
 }
 
+QgsTriangularMesh *QgsMeshLayer::triangularMesh( double minimumTriangleSize, const QgsRectangle &extent ) const
+{
+  for ( const std::unique_ptr<QgsTriangularMesh> &lod : mTriangularMeshes )
+  {
+    if ( lod && lod->averageTriangleSize( extent ) > minimumTriangleSize )
+      return lod.get();
+  }
+
+  if ( !mTriangularMeshes.empty() )
+    return mTriangularMeshes.back().get();
+  else
+    return nullptr;
+}
+
 void  QgsMeshLayer::updateTriangularMesh( const QgsCoordinateTransform &transform )
 {
   // Native mesh
@@ -270,7 +475,7 @@ void  QgsMeshLayer::updateTriangularMesh( const QgsCoordinateTransform &transfor
   }
 
   if ( mTriangularMeshes[0].get()->update( mNativeMesh.get(), transform ) )
-    mTriangularMeshes.resize( 1 ); //if the base triangular mesh is effectivly updated, remove simplified meshes
+    resetSimplifiedMeshes(); //if the base triangular mesh is effectivly updated, remove simplified meshes
 }
 
 QgsMeshLayerRendererCache *QgsMeshLayer::rendererCache()
@@ -934,6 +1139,10 @@ QgsMeshSimplificationSettings QgsMeshLayer::meshSimplificationSettings() const
 
 void QgsMeshLayer::setMeshSimplificationSettings( const QgsMeshSimplificationSettings &simplifySettings )
 {
+  if ( simplifySettings.isEnabled() != mSimplificationSettings.isEnabled() ||
+       !qgsDoubleNear( simplifySettings.reductionFactor(), mSimplificationSettings.reductionFactor() ) )
+    resetSimplifiedMeshes();
+
   mSimplificationSettings = simplifySettings;
 }
 
@@ -1218,6 +1427,7 @@ void QgsMeshLayer::reload()
   if ( mDataProvider && mDataProvider->isValid() )
   {
     mDataProvider->reloadData();
+    mDatasetGroupStore->clearDatasetCache();
 
     //reload the mesh structure
     if ( !mNativeMesh )
@@ -1226,6 +1436,7 @@ void QgsMeshLayer::reload()
     dataProvider()->populateMesh( mNativeMesh.get() );
 
     //clear the TriangularMeshes
+    resetSimplifiedMeshes();
     mTriangularMeshes.clear();
 
     //clear the rendererCache
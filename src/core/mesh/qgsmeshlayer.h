@@ -19,6 +19,7 @@
 #define QGSMESHLAYER_H
 
 #include <memory>
+#include <QPointer>
 
 #include "qgis_core.h"
 #include "qgsinterval.h"
@@ -32,6 +33,7 @@ class QgsMapLayerRenderer;
 struct QgsMeshLayerRendererCache;
 class QgsSymbol;
 class QgsTriangularMesh;
+class QgsMeshSimplificationTask;
 class QgsRenderContext;
 struct QgsMesh;
 class QgsMesh3dAveragingMethod;
@@ -234,6 +236,21 @@ class CORE_EXPORT QgsMeshLayer : public QgsMapLayer
      */
     QgsTriangularMesh *triangularMesh( double minimumTriangleSize = 0 ) const SIP_SKIP;
 
+    /**
+     * Returns triangular mesh (NULLPTR before rendering or calling to updateMesh) with a level of detail
+     * matching the region covered by \a extent.
+     *
+     * Among the base triangular mesh and the simplified triangular meshes, the one returned is which has the
+     * average size of the triangles in \a extent just greater than \a minimumTriangleSize. The simplified meshes
+     * are built in a background task at the first rendering with mesh simplification enabled.
+     * \param minimumTriangleSize is the average size criteria in canvas map units
+     * \param extent is the region of the mesh to consider, in canvas map units
+     * \returns triangular mesh, the layer keeps the ownership
+     * \note Not available in Python bindings
+     * \since QGIS 3.16
+     */
+    QgsTriangularMesh *triangularMesh( double minimumTriangleSize, const QgsRectangle &extent ) const SIP_SKIP;
+
     /**
      * Gets native mesh and updates (creates if it doesn't exist) the base triangular mesh
      *
@@ -732,6 +749,8 @@ class CORE_EXPORT QgsMeshLayer : public QgsMapLayer
     void assignDefaultStyleToDatasetGroup( int groupIndex );
     void setDefaultRendererSettings( const QList<int> &groupIndexes );
     void createSimplifiedMeshes();
+    //! Cancels the building of the simplified meshes and removes them
+    void resetSimplifiedMeshes();
     int levelsOfDetailsIndex( double partOfMeshInView ) const;
 
     bool hasSimplifiedMeshes() const;
@@ -741,6 +760,7 @@ class CORE_EXPORT QgsMeshLayer : public QgsMapLayer
 
   private slots:
     void onDatasetGroupsAdded( const QList<int> &datasetGroupIndexes );
+    void onSimplificationTaskFinished();
 
   private:
     //! Pointer to data provider derived from the abastract base class QgsMeshDataProvider
@@ -766,6 +786,12 @@ class CORE_EXPORT QgsMeshLayer : public QgsMapLayer
     //! Simplify mesh configuration
     QgsMeshSimplificationSettings mSimplificationSettings;
 
+    //! Task building the simplified meshes
+    QPointer<QgsMeshSimplificationTask> mSimplificationTask;
+
+    //! Whether the simplified meshes of the base mesh have been built, even if there are none
+    bool mSimplifiedMeshesBuilt = false;
+
     QgsMeshLayerTemporalProperties *mTemporalProperties;
 
     int mStaticScalarDatasetIndex = 0;
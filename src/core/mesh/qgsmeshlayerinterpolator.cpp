@@ -34,6 +34,102 @@
 #include "qgscoordinatetransform.h"
 #include "qgsmeshdataprovider.h"
 
+#include <QtConcurrent>
+
+//! Number of triangles located in a single task
+static const int TRIANGLE_CHUNK_SIZE = 65536;
+
+//! Number of rows of a band of the block interpolated in a single task
+static const int BAND_HEIGHT = 32;
+
+namespace
+{
+
+  /**
+   * Barycentric coordinates in a triangle, computed as the interpolation functions of QgsMeshLayerUtils do,
+   * but with the terms depending only on the triangle computed once for all the pixels.
+   */
+  struct TriangleBarycentricCoordinates
+  {
+    TriangleBarycentricCoordinates( const QgsPointXY &pA, const QgsPointXY &pB, const QgsPointXY &pC )
+      : ax( pA.x() )
+      , ay( pA.y() )
+    {
+      valid = !( pA == pB || pA == pC || pB == pC );
+      v0x = pC.x() - pA.x();
+      v0y = pC.y() - pA.y();
+      v1x = pB.x() - pA.x();
+      v1y = pB.y() - pA.y();
+      dot00 = v0x * v0x + v0y * v0y;
+      dot01 = v0x * v1x + v0y * v1y;
+      dot11 = v1x * v1x + v1y * v1y;
+      invDenom = 1.0 / ( dot00 * dot11 - dot01 * dot01 );
+    }
+
+    //! Computes the coordinates of point ( \a x, \a y ), returns FALSE if it is outside of the triangle
+    bool coordinates( double x, double y, double &lam1, double &lam2, double &lam3 ) const
+    {
+      if ( !valid )
+        return false;
+
+      const double v2x = x - ax;
+      const double v2y = y - ay;
+      const double dot02 = v0x * v2x + v0y * v2y;
+      const double dot12 = v1x * v2x + v1y * v2y;
+      lam1 = ( dot11 * dot02 - dot01 * dot12 ) * invDenom;
+      lam2 = ( dot00 * dot12 - dot01 * dot02 ) * invDenom;
+      lam3 = 1.0 - lam1 - lam2;
+
+      // same tolerance to detect border points
+      const double eps = 1e-6;
+      if ( lam1 < 0.0 && lam1 > -eps )
+        lam1 = 0.0;
+      if ( lam2 < 0.0 && lam2 > -eps )
+        lam2 = 0.0;
+      if ( lam3 < 0.0 && lam3 > -eps )
+        lam3 = 0.0;
+
+      return lam1 >= 0 && lam2 >= 0 && lam3 >= 0;
+    }
+
+    bool valid = false;
+    double ax = 0;
+    double ay = 0;
+    double v0x = 0;
+    double v0y = 0;
+    double v1x = 0;
+    double v1y = 0;
+    double dot00 = 0;
+    double dot01 = 0;
+    double dot11 = 0;
+    double invDenom = 0;
+  };
+
+}
+
+bool QgsMeshPixelTriangles::isValidFor( const QgsTriangularMesh &mesh, bool spatialIndexActive, const QgsRectangle &extent, int width, int height, const QTransform &mapToPixel ) const
+{
+  return mesh.vertices().constData() == vertices &&
+         mesh.triangles().count() == triangleCount &&
+         spatialIndexActive == this->spatialIndexActive &&
+         extent == this->extent &&
+         width == this->width &&
+         height == this->height &&
+         mapToPixel == this->mapToPixel;
+}
+
+std::shared_ptr<const QgsMeshPixelTriangles> QgsMeshPixelTrianglesCache::pixelTriangles() const
+{
+  QMutexLocker locker( &mMutex );
+  return mPixelTriangles;
+}
+
+void QgsMeshPixelTrianglesCache::setPixelTriangles( const std::shared_ptr<const QgsMeshPixelTriangles> &triangles )
+{
+  QMutexLocker locker( &mMutex );
+  mPixelTriangles = triangles;
+}
+
 QgsMeshLayerInterpolator::QgsMeshLayerInterpolator(
   const QgsTriangularMesh &m,
   const QVector<double> &datasetValues,
@@ -76,6 +172,85 @@ QgsRasterBlock *QgsMeshLayerInterpolator::block( int, const QgsRectangle &extent
   outputBlock->setIsNoData();  // assume initially that all values are unset
   double *data = reinterpret_cast<double *>( outputBlock->bits() );
 
+  if ( mTriangularMesh.contains( QgsMesh::ElementType::Edge ) )
+  {
+    return outputBlock.release();
+  }
+
+  // currently expecting that triangulation does not add any new extra vertices on the way
+  if ( mDataType == QgsMeshDatasetGroupMetadata::DataType::DataOnVertices )
+    Q_ASSERT( mDatasetValues.count() == mTriangularMesh.vertices().count() );
+
+  const QTransform mapToPixel = mContext.mapToPixel().transform();
+  bool invertible = false;
+  const QTransform pixelToMap = mapToPixel.inverted( &invertible );
+  if ( !invertible )
+    return outputBlock.release();
+
+  auto isStopped = [this, feedback]
+  {
+    return ( feedback && feedback->isCanceled() ) || mContext.renderingStopped();
+  };
+
+  // the rows of the block are interpolated by bands, in parallel
+  const int bandCount = ( height + BAND_HEIGHT - 1 ) / BAND_HEIGHT;
+  QVector<int> bands;
+  bands.reserve( bandCount );
+  for ( int band = 0; band < bandCount; ++band )
+    bands << band;
+
+  // if the triangles of the pixels are known, only interpolate the values
+  const std::shared_ptr<const QgsMeshPixelTriangles> cachedTriangles = mPixelTrianglesCache ? mPixelTrianglesCache->pixelTriangles() : nullptr;
+  if ( cachedTriangles && cachedTriangles->isValidFor( mTriangularMesh, mSpatialIndexActive, extent, width, height, mapToPixel ) )
+  {
+    QtConcurrent::blockingMap( bands, [&]( int band )
+    {
+      const int bandBottom = std::min( ( band + 1 ) * BAND_HEIGHT, height );
+      for ( int j = band * BAND_HEIGHT; j < bandBottom; ++j )
+      {
+        if ( isStopped() )
+          return;
+
+        double *line = data + ( j * width );
+        for ( int k = 0; k < width; ++k )
+        {
+          const int pixel = j * width + k;
+          const int triangle = cachedTriangles->triangles.at( pixel );
+          if ( triangle < 0 )
+            continue;
+
+          qreal x, y;
+          pixelToMap.map( static_cast<qreal>( k ), static_cast<qreal>( j ), &x, &y );
+          const QgsPointXY p( x, y );
+
+          // the last active triangle with data is drawn
+          double val = std::numeric_limits<double>::quiet_NaN();
+          const auto shared = cachedTriangles->sharedPixels.constFind( pixel );
+          if ( shared == cachedTriangles->sharedPixels.constEnd() )
+          {
+            if ( isActive( triangle ) )
+              val = interpolate( triangle, p );
+          }
+          else
+          {
+            for ( int i = shared->size() - 1; i >= 0 && std::isnan( val ); --i )
+            {
+              if ( isActive( shared->at( i ) ) )
+                val = interpolate( shared->at( i ), p );
+            }
+          }
+
+          if ( !std::isnan( val ) )
+          {
+            line[k] = val;
+            outputBlock->setIsData( j, k );
+          }
+        }
+      }
+    } );
+    return outputBlock.release();
+  }
+
   QList<int> spatialIndexTriangles;
   int indexCount;
   if ( mSpatialIndexActive )
@@ -88,85 +263,145 @@ QgsRasterBlock *QgsMeshLayerInterpolator::block( int, const QgsRectangle &extent
     indexCount = mTriangularMesh.triangles().count();
   }
 
-  if ( mTriangularMesh.contains( QgsMesh::ElementType::Edge ) )
-  {
-    return outputBlock.release();
-  }
-
+  // locating the triangles of the pixels for the cache requires the inactive triangles too,
+  // since they may be active for another dataset
+  const bool locatePixelTriangles = static_cast< bool >( mPixelTrianglesCache );
   const QVector<QgsMeshVertex> &vertices = mTriangularMesh.vertices();
+  const QVector<QgsMeshFace> &triangles = mTriangularMesh.triangles();
 
-  // currently expecting that triangulation does not add any new extra vertices on the way
-  if ( mDataType == QgsMeshDatasetGroupMetadata::DataType::DataOnVertices )
-    Q_ASSERT( mDatasetValues.count() == mTriangularMesh.vertices().count() );
+  // first find the bands of the block crossed by each triangle, in parallel on chunks of triangles.
+  // Each band then draws its triangles in the original order, so that the result does not depend on threads
+  QVector<int> chunkStarts;
+  for ( int start = 0; start < indexCount; start += TRIANGLE_CHUNK_SIZE )
+    chunkStarts << start;
+  QVector<QVector<QVector<int>>> chunkBandTriangles( chunkStarts.size() );
+  QVector<QVector<int>> *chunkBandTrianglesData = chunkBandTriangles.data();
 
-  for ( int i = 0; i < indexCount; ++i )
+  QtConcurrent::blockingMap( chunkStarts, [&]( int start )
   {
-    if ( feedback && feedback->isCanceled() )
-      break;
-
-    if ( mContext.renderingStopped() )
-      break;
-
-    int triangleIndex;
-    if ( mSpatialIndexActive )
-      triangleIndex = spatialIndexTriangles[i];
-    else
-      triangleIndex = i;
-
-    const QgsMeshFace &face = mTriangularMesh.triangles()[triangleIndex];
-
-    const int v1 = face[0], v2 = face[1], v3 = face[2];
-    const QgsPoint p1 = vertices[v1], p2 = vertices[v2], p3 = vertices[v3];
-
-    const int nativeFaceIndex = mTriangularMesh.trianglesToNativeFaces()[triangleIndex];
-    const bool isActive = mActiveFaceFlagValues.active( nativeFaceIndex );
-    if ( !isActive )
-      continue;
-
-    QgsRectangle bbox = QgsMeshLayerUtils::triangleBoundingBox( p1, p2, p3 );
-    if ( !extent.intersects( bbox ) )
-      continue;
+    QVector<QVector<int>> &bandTriangles = chunkBandTrianglesData[start / TRIANGLE_CHUNK_SIZE];
+    bandTriangles.resize( bandCount );
+    const int end = std::min( start + TRIANGLE_CHUNK_SIZE, indexCount );
+    for ( int i = start; i < end; ++i )
+    {
+      if ( isStopped() )
+        return;
+
+      const int triangleIndex = mSpatialIndexActive ? spatialIndexTriangles.at( i ) : i;
+      if ( !locatePixelTriangles && !isActive( triangleIndex ) )
+        continue;
+
+      const QgsMeshFace &face = triangles.at( triangleIndex );
+      const QgsRectangle bbox = QgsMeshLayerUtils::triangleBoundingBox( vertices.at( face.at( 0 ) ), vertices.at( face.at( 1 ) ), vertices.at( face.at( 2 ) ) );
+      if ( !extent.intersects( bbox ) )
+        continue;
+
+      int topLim, bottomLim, leftLim, rightLim;
+      QgsMeshLayerUtils::boundingBoxToScreenRectangle( mContext.mapToPixel(), mOutputSize, bbox, leftLim, rightLim, topLim, bottomLim );
+      if ( topLim > bottomLim || leftLim > rightLim )
+        continue;
+
+      const int lastBand = std::min( bottomLim / BAND_HEIGHT, bandCount - 1 );
+      for ( int band = topLim / BAND_HEIGHT; band <= lastBand; ++band )
+        bandTriangles[band].append( triangleIndex );
+    }
+  } );
 
-    // Get the BBox of the element in pixels
-    int topLim, bottomLim, leftLim, rightLim;
-    QgsMeshLayerUtils::boundingBoxToScreenRectangle( mContext.mapToPixel(), mOutputSize, bbox, leftLim, rightLim, topLim, bottomLim );
+  std::shared_ptr<QgsMeshPixelTriangles> pixelTriangles;
+  QVector<QHash<int, QVector<int>>> bandSharedPixels;
+  if ( locatePixelTriangles )
+  {
+    pixelTriangles = std::make_shared<QgsMeshPixelTriangles>();
+    pixelTriangles->vertices = vertices.constData();
+    pixelTriangles->triangleCount = triangles.count();
+    pixelTriangles->spatialIndexActive = mSpatialIndexActive;
+    pixelTriangles->extent = extent;
+    pixelTriangles->width = width;
+    pixelTriangles->height = height;
+    pixelTriangles->mapToPixel = mapToPixel;
+    pixelTriangles->triangles = QVector<int>( width * height, -1 );
+    bandSharedPixels.resize( bandCount );
+  }
+  int *pixelTrianglesData = pixelTriangles ? pixelTriangles->triangles.data() : nullptr;
+  QHash<int, QVector<int>> *bandSharedPixelsData = bandSharedPixels.data();
 
-    // interpolate in the bounding box of the face
-    for ( int j = topLim; j <= bottomLim; j++ )
+  QtConcurrent::blockingMap( bands, [&]( int band )
+  {
+    const int bandTop = band * BAND_HEIGHT;
+    const int bandBottom = std::min( bandTop + BAND_HEIGHT, height ) - 1;
+    for ( const QVector<QVector<int>> &bandTriangles : qgis::as_const( chunkBandTriangles ) )
     {
-      double *line = data + ( j * width );
-      for ( int k = leftLim; k <= rightLim; k++ )
+      if ( bandTriangles.size() <= band )
+        continue;
+
+      for ( int triangleIndex : bandTriangles.at( band ) )
       {
-        double val;
-        const QgsPointXY p = mContext.mapToPixel().toMapCoordinates( k, j );
-        if ( mDataType == QgsMeshDatasetGroupMetadata::DataType::DataOnVertices )
-          val = QgsMeshLayerUtils::interpolateFromVerticesData(
-                  p1,
-                  p2,
-                  p3,
-                  mDatasetValues[v1],
-                  mDatasetValues[v2],
-                  mDatasetValues[v3],
-                  p );
-        else
+        if ( isStopped() )
+          return;
+
+        const QgsMeshFace &face = triangles.at( triangleIndex );
+        const int v1 = face[0], v2 = face[1], v3 = face[2];
+        const QgsPointXY p1 = vertices.at( v1 ), p2 = vertices.at( v2 ), p3 = vertices.at( v3 );
+        const TriangleBarycentricCoordinates barycentric( p1, p2, p3 );
+        if ( !barycentric.valid )
+          continue;
+
+        const bool active = isActive( triangleIndex );
+        const bool onVertices = mDataType == QgsMeshDatasetGroupMetadata::DataType::DataOnVertices;
+        const double val1 = onVertices ? mDatasetValues.at( v1 ) : mDatasetValues.at( mTriangularMesh.trianglesToNativeFaces().at( triangleIndex ) );
+        const double val2 = onVertices ? mDatasetValues.at( v2 ) : val1;
+        const double val3 = onVertices ? mDatasetValues.at( v3 ) : val1;
+
+        // Get the BBox of the element in pixels
+        int topLim, bottomLim, leftLim, rightLim;
+        QgsMeshLayerUtils::boundingBoxToScreenRectangle( mContext.mapToPixel(), mOutputSize,
+            QgsMeshLayerUtils::triangleBoundingBox( p1, p2, p3 ), leftLim, rightLim, topLim, bottomLim );
+
+        // interpolate in the bounding box of the face, within the band
+        for ( int j = std::max( topLim, bandTop ); j <= std::min( bottomLim, bandBottom ); j++ )
         {
-          const int faceIdx = mTriangularMesh.trianglesToNativeFaces()[triangleIndex];
-          val = QgsMeshLayerUtils::interpolateFromFacesData(
-                  p1,
-                  p2,
-                  p3,
-                  mDatasetValues[faceIdx],
-                  p
-                );
-        }
-        if ( !std::isnan( val ) )
-        {
-          line[k] = val;
-          outputBlock->setIsData( j, k );
+          double *line = data + ( j * width );
+          for ( int k = leftLim; k <= rightLim; k++ )
+          {
+            qreal x, y;
+            pixelToMap.map( static_cast<qreal>( k ), static_cast<qreal>( j ), &x, &y );
+            double lam1, lam2, lam3;
+            if ( !barycentric.coordinates( x, y, lam1, lam2, lam3 ) )
+              continue;
+
+            if ( pixelTrianglesData )
+            {
+              const int pixel = j * width + k;
+              if ( pixelTrianglesData[pixel] >= 0 )
+              {
+                QVector<int> &shared = bandSharedPixelsData[band][pixel];
+                if ( shared.isEmpty() )
+                  shared << pixelTrianglesData[pixel];
+                shared << triangleIndex;
+              }
+              pixelTrianglesData[pixel] = triangleIndex;
+            }
+
+            if ( !active )
+              continue;
+
+            const double val = onVertices ? lam1 * val3 + lam2 * val2 + lam3 * val1 : val1;
+            if ( !std::isnan( val ) )
+            {
+              line[k] = val;
+              outputBlock->setIsData( j, k );
+            }
+          }
         }
       }
     }
+  } );
 
+  if ( pixelTriangles && !isStopped() )
+  {
+    for ( const QHash<int, QVector<int>> &sharedPixels : qgis::as_const( bandSharedPixels ) )
+      pixelTriangles->sharedPixels.unite( sharedPixels );
+    mPixelTrianglesCache->setPixelTriangles( pixelTriangles );
   }
 
   return outputBlock.release();
@@ -174,6 +409,32 @@ QgsRasterBlock *QgsMeshLayerInterpolator::block( int, const QgsRectangle &extent
 
 void QgsMeshLayerInterpolator::setSpatialIndexActive( bool active ) {mSpatialIndexActive = active;}
 
+void QgsMeshLayerInterpolator::setPixelTrianglesCache( QgsMeshPixelTrianglesCache *cache )
+{
+  mPixelTrianglesCache = cache;
+}
+
+double QgsMeshLayerInterpolator::interpolate( int triangle, const QgsPointXY &p ) const
+{
+  const QgsMeshFace &face = mTriangularMesh.triangles().at( triangle );
+  const TriangleBarycentricCoordinates barycentric( mTriangularMesh.vertices().at( face[0] ),
+      mTriangularMesh.vertices().at( face[1] ),
+      mTriangularMesh.vertices().at( face[2] ) );
+  double lam1, lam2, lam3;
+  if ( !barycentric.coordinates( p.x(), p.y(), lam1, lam2, lam3 ) )
+    return std::numeric_limits<double>::quiet_NaN();
+
+  if ( mDataType == QgsMeshDatasetGroupMetadata::DataType::DataOnVertices )
+    return lam1 * mDatasetValues.at( face[2] ) + lam2 * mDatasetValues.at( face[1] ) + lam3 * mDatasetValues.at( face[0] );
+  else
+    return mDatasetValues.at( mTriangularMesh.trianglesToNativeFaces().at( triangle ) );
+}
+
+bool QgsMeshLayerInterpolator::isActive( int triangle ) const
+{
+  return mActiveFaceFlagValues.active( mTriangularMesh.trianglesToNativeFaces().at( triangle ) );
+}
+
 ///@endcond
 
 QgsRasterBlock *QgsMeshUtils::exportRasterBlock(
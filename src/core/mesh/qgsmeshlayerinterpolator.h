@@ -28,6 +28,10 @@ class QgsMeshDatasetIndex;
 #include "qgis_sip.h"
 
 #include <QSize>
+#include <QHash>
+#include <QMutex>
+#include <QTransform>
+#include <memory>
 #include "qgsmaplayerrenderer.h"
 #include "qgstriangularmesh.h"
 #include "qgsrasterinterface.h"
@@ -44,6 +48,59 @@ class QgsRenderContext;
 
 ///@cond PRIVATE
 
+/**
+ * \ingroup core
+ * Triangles of a triangular mesh covering the pixels of a raster block, for a given extent
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.16
+ */
+struct QgsMeshPixelTriangles SIP_SKIP
+{
+  //! Returns TRUE if the triangles were located for the same mesh, block and map to pixel transform
+  bool isValidFor( const QgsTriangularMesh &mesh, bool spatialIndexActive, const QgsRectangle &extent, int width, int height, const QTransform &mapToPixel ) const;
+
+  const QgsMeshVertex *vertices = nullptr;
+  int triangleCount = 0;
+  bool spatialIndexActive = false;
+  QgsRectangle extent;
+  int width = 0;
+  int height = 0;
+  QTransform mapToPixel;
+
+  //! Last triangle in drawing order covering each pixel, row by row, or -1
+  QVector<int> triangles;
+
+  //! All the triangles covering the pixels covered by several triangles, in drawing order
+  QHash<int, QVector<int>> sharedPixels;
+};
+
+/**
+ * \ingroup core
+ * Cache of the triangles covering the pixels of the last rendered block of a mesh layer,
+ * which can be shared by the renderers in different threads
+ *
+ * It is kept while changing the dataset, e.g. the time step: if the extent is the same,
+ * the values of the new dataset are interpolated without locating the triangles again.
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.16
+ */
+class QgsMeshPixelTrianglesCache SIP_SKIP
+{
+  public:
+
+    //! Returns the cached pixel triangles, or NULLPTR if there is none
+    std::shared_ptr<const QgsMeshPixelTriangles> pixelTriangles() const;
+
+    //! Replaces the cached pixel \a triangles
+    void setPixelTriangles( const std::shared_ptr<const QgsMeshPixelTriangles> &triangles );
+
+  private:
+    mutable QMutex mMutex;
+    std::shared_ptr<const QgsMeshPixelTriangles> mPixelTriangles;
+};
+
 /**
  * \ingroup core
  * Interpolate mesh scalar dataset to raster block
@@ -70,7 +127,22 @@ class QgsMeshLayerInterpolator : public QgsRasterInterface SIP_SKIP
 
     void setSpatialIndexActive( bool active );
 
+    /**
+     * Sets a \a cache of the triangles covering the pixels, reused by block() when the extent
+     * did not change, and else updated. The cache is not owned by the interpolator.
+     *
+     * \since QGIS 3.16
+     */
+    void setPixelTrianglesCache( QgsMeshPixelTrianglesCache *cache );
+
   private:
+
+    //! Interpolates the value of the \a triangle at point \a p, returns NaN if the triangle does not contains the point
+    double interpolate( int triangle, const QgsPointXY &p ) const;
+
+    //! Returns TRUE if the \a triangle is active
+    bool isActive( int triangle ) const;
+
     const QgsTriangularMesh &mTriangularMesh;
     const QVector<double> &mDatasetValues;
     const QgsMeshDataBlock &mActiveFaceFlagValues;
@@ -78,6 +150,7 @@ class QgsMeshLayerInterpolator : public QgsRasterInterface SIP_SKIP
     QgsMeshDatasetGroupMetadata::DataType mDataType = QgsMeshDatasetGroupMetadata::DataType::DataOnVertices;
     QSize mOutputSize;
     bool mSpatialIndexActive = false;
+    QgsMeshPixelTrianglesCache *mPixelTrianglesCache = nullptr;
 };
 
 ///@endcond
@@ -65,6 +65,11 @@ QgsMeshLayerRenderer::QgsMeshLayerRenderer(
   // copy triangular mesh
   copyTriangularMeshes( layer, context );
 
+  // the cache of the triangles covering the pixels is kept while the datasets change
+  if ( !layer->rendererCache()->mPixelTrianglesCache )
+    layer->rendererCache()->mPixelTrianglesCache = std::make_shared<QgsMeshPixelTrianglesCache>();
+  mPixelTrianglesCache = layer->rendererCache()->mPixelTrianglesCache;
+
   // copy datasets
   copyScalarDatasetValues( layer );
   copyVectorDatasetValues( layer );
@@ -81,7 +86,7 @@ void QgsMeshLayerRenderer::copyTriangularMeshes( QgsMeshLayer *layer, QgsRenderC
   if ( simplificationSettings.isEnabled() )
   {
     double triangleSize = simplificationSettings.meshResolution() * context.mapToPixel().mapUnitsPerPixel();
-    mTriangularMesh = *( layer->triangularMesh( triangleSize ) );
+    mTriangularMesh = *( layer->triangularMesh( triangleSize, context.mapExtent() ) );
     mIsMeshSimplificationActive = true;
   }
   else
@@ -544,6 +549,7 @@ void QgsMeshLayerRenderer::renderScalarDatasetOnFaces( const QgsMeshRendererScal
                                          context,
                                          mOutputSize );
   interpolator.setSpatialIndexActive( mIsMeshSimplificationActive );
+  interpolator.setPixelTrianglesCache( mPixelTrianglesCache.get() );
   QgsSingleBandPseudoColorRenderer renderer( &interpolator, 0, sh );  // takes ownership of sh
   renderer.setClassificationMin( scalarSettings.classificationMinimum() );
   renderer.setClassificationMax( scalarSettings.classificationMaximum() );
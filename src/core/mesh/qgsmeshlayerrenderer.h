@@ -37,6 +37,7 @@ class QgsMeshLayer;
 #include "qgsmapclippingregion.h"
 
 class QgsRenderContext;
+class QgsMeshPixelTrianglesCache;
 
 ///@cond PRIVATE
 
@@ -77,6 +78,9 @@ struct CORE_NO_EXPORT QgsMeshLayerRendererCache
   double mVectorDatasetGroupMagMaximum = std::numeric_limits<double>::quiet_NaN();
   QgsMeshDatasetGroupMetadata::DataType mVectorDataType = QgsMeshDatasetGroupMetadata::DataType::DataOnVertices;
   std::unique_ptr<QgsMesh3dAveragingMethod> mVectorAveragingMethod;
+
+  // triangles of the pixels of the last rendered scalar dataset
+  std::shared_ptr<QgsMeshPixelTrianglesCache> mPixelTrianglesCache;
 };
 
 
@@ -113,6 +117,9 @@ class QgsMeshLayerRenderer : public QgsMapLayerRenderer
     void calculateOutputSize();
     QgsPointXY fractionPoint( const QgsPointXY &p1, const QgsPointXY &p2, double fraction ) const;
     bool mIsMeshSimplificationActive = false;
+
+    // cache of the triangles of the pixels, shared with the layer renderer cache
+    std::shared_ptr<QgsMeshPixelTrianglesCache> mPixelTrianglesCache;
     QColor colorAt( QgsColorRampShader *shader, double val ) const;
 
   protected:
@@ -0,0 +1,89 @@
+/***************************************************************************
+                         qgsmeshsimplificationtask_p.h
+                         -----------------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSMESHSIMPLIFICATIONTASK_PRIVATE_H
+#define QGSMESHSIMPLIFICATIONTASK_PRIVATE_H
+
+#define SIP_NO_FILE
+
+/// @cond PRIVATE
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QGIS API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+
+#include "qgstaskmanager.h"
+#include "qgstriangularmesh.h"
+
+#include <memory>
+#include <vector>
+
+/**
+ * \ingroup core
+ * A task building the simplified meshes of a mesh layer in a background thread.
+ *
+ * The simplified meshes are stored in a file of the user profile, so that they are restored
+ * instead of built again the next time the same mesh is simplified with the same reduction factor.
+ */
+class QgsMeshSimplificationTask : public QgsTask
+{
+    Q_OBJECT
+
+  public:
+
+    /**
+     * Constructor for QgsMeshSimplificationTask, simplifying \a baseMesh with \a reductionFactor, storing
+     * the simplified meshes in \a levelsFilePath if not empty.
+     */
+    QgsMeshSimplificationTask( const QString &layerName, const QgsTriangularMesh &baseMesh, double reductionFactor, const QString &levelsFilePath );
+
+    bool run() override;
+
+    //! Returns the simplified meshes, once the task is completed
+    std::vector<std::unique_ptr<QgsTriangularMesh>> takeSimplifiedMeshes();
+
+    /**
+     * Returns the path of the file storing the simplified meshes of the layer from
+     * \a providerKey with \a source, in the user profile.
+     */
+    static QString levelsFilePath( const QString &providerKey, const QString &source );
+
+  private:
+
+    //! Returns a hash of the base mesh and the reduction factor, identifying the simplified meshes
+    QByteArray signature() const;
+
+    //! Restores the simplified meshes from the levels file, returns FALSE if it does not match the \a signature
+    bool readLevels( const QByteArray &signature );
+
+    //! Stores the simplified meshes in the levels file
+    bool writeLevels( const QByteArray &signature ) const;
+
+    QgsTriangularMesh mBaseMesh;
+    double mReductionFactor = 10;
+    QString mLevelsFilePath;
+    std::vector<std::unique_ptr<QgsTriangularMesh>> mSimplifiedMeshes;
+};
+
+/// @endcond
+
+#endif // QGSMESHSIMPLIFICATIONTASK_PRIVATE_H
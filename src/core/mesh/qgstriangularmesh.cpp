@@ -228,9 +228,21 @@ bool QgsTriangularMesh::update( QgsMesh *nativeMesh, const QgsCoordinateTransfor
   return true;
 }
 
+//! Number of columns and rows of the grid used to estimate the size of the triangles by region
+static const int TRIANGLE_SIZE_GRID_SIZE = 16;
+
+static int triangleSizeGridCell( double coordinate, double minimum, double size )
+{
+  if ( !( size > 0 ) )
+    return 0;
+  return qBound( 0, static_cast< int >( ( coordinate - minimum ) / size * TRIANGLE_SIZE_GRID_SIZE ), TRIANGLE_SIZE_GRID_SIZE - 1 );
+}
+
 void QgsTriangularMesh::finalizeTriangles()
 {
   mAverageTriangleSize = 0;
+  mTriangleSizeSums = QVector<double>( TRIANGLE_SIZE_GRID_SIZE * TRIANGLE_SIZE_GRID_SIZE, 0 );
+  mTriangleCounts = QVector<int>( TRIANGLE_SIZE_GRID_SIZE * TRIANGLE_SIZE_GRID_SIZE, 0 );
   for ( int i = 0; i < mTriangularMesh.faceCount(); ++i )
   {
     QgsMeshFace &face = mTriangularMesh.faces[i];
@@ -241,7 +253,14 @@ void QgsTriangularMesh::finalizeTriangles()
 
     QgsRectangle bbox = QgsMeshLayerUtils::triangleBoundingBox( v0, v1, v2 );
 
-    mAverageTriangleSize += std::fmax( bbox.width(), bbox.height() );
+    const double triangleSize = std::fmax( bbox.width(), bbox.height() );
+    mAverageTriangleSize += triangleSize;
+
+    const QgsPointXY center = bbox.center();
+    const int cell = triangleSizeGridCell( center.y(), mExtent.yMinimum(), mExtent.height() ) * TRIANGLE_SIZE_GRID_SIZE +
+                     triangleSizeGridCell( center.x(), mExtent.xMinimum(), mExtent.width() );
+    mTriangleSizeSums[cell] += triangleSize;
+    ++mTriangleCounts[cell];
 
     //To have consistent clock wise orientation of triangles which is necessary for 3D rendering
     //Check the clock wise, and if it is not counter clock wise, swap indexes to make the oientation counter clock wise
@@ -259,6 +278,33 @@ void QgsTriangularMesh::finalizeTriangles()
   mAverageTriangleSize /= mTriangularMesh.faceCount();
 }
 
+double QgsTriangularMesh::averageTriangleSize( const QgsRectangle &extent ) const
+{
+  if ( mTriangleCounts.isEmpty() || !extent.intersects( mExtent ) )
+    return mAverageTriangleSize;
+
+  const int columnMin = triangleSizeGridCell( extent.xMinimum(), mExtent.xMinimum(), mExtent.width() );
+  const int columnMax = triangleSizeGridCell( extent.xMaximum(), mExtent.xMinimum(), mExtent.width() );
+  const int rowMin = triangleSizeGridCell( extent.yMinimum(), mExtent.yMinimum(), mExtent.height() );
+  const int rowMax = triangleSizeGridCell( extent.yMaximum(), mExtent.yMinimum(), mExtent.height() );
+
+  double sizeSum = 0;
+  int count = 0;
+  for ( int row = rowMin; row <= rowMax; ++row )
+  {
+    for ( int column = columnMin; column <= columnMax; ++column )
+    {
+      sizeSum += mTriangleSizeSums.at( row * TRIANGLE_SIZE_GRID_SIZE + column );
+      count += mTriangleCounts.at( row * TRIANGLE_SIZE_GRID_SIZE + column );
+    }
+  }
+
+  if ( count == 0 )
+    return mAverageTriangleSize;
+
+  return sizeSum / count;
+}
+
 QgsRectangle QgsTriangularMesh::extent() const
 {
   return mExtent;
@@ -419,7 +465,6 @@ QVector<QgsTriangularMesh *> QgsTriangularMesh::simplifyMesh( double reductionFa
   int path = 0;
   while ( true )
   {
-    QgsTriangularMesh *simplifiedMesh = new QgsTriangularMesh( *this );
     size_t maxNumberOfIndexes = baseIndexCount / pow( reductionFactor, path + 1 );
 
     if ( indexes.size() <= int( maxNumberOfIndexes ) )
@@ -445,29 +490,19 @@ QVector<QgsTriangularMesh *> QgsTriangularMesh::simplifyMesh( double reductionFa
       break;
     }
 
-    QgsMesh newMesh;
-    newMesh.vertices = mTriangularMesh.vertices;
-
-    newMesh.faces.resize( returnIndexes.size() / 3 );
-    for ( int i = 0; i < newMesh.faces.size(); ++i )
+    QVector<QgsMeshFace> triangles( returnIndexes.size() / 3 );
+    for ( int i = 0; i < triangles.size(); ++i )
     {
       QgsMeshFace f( 3 );
       for ( size_t j = 0; j < 3 ; ++j )
         f[j] = returnIndexes.at( i * 3 + j ) ;
-      newMesh.faces[i ] = f;
+      triangles[i ] = f;
     }
 
-    simplifiedMesh->mTriangularMesh = newMesh;
-    simplifiedMesh->mSpatialFaceIndex = QgsMeshSpatialIndex( simplifiedMesh->mTriangularMesh );
-    simplifiedMesh->finalizeTriangles();
-    simplifiedMeshes.push_back( simplifiedMesh );
-
-    QgsDebugMsg( QStringLiteral( "Simplified mesh created with %1 triangles" ).arg( newMesh.faceCount() ) );
-
-    simplifiedMesh->mTrianglesToNativeFaces = QVector<int>( simplifiedMesh->triangles().count(), 0 );
-    for ( int i = 0; i < simplifiedMesh->mTrianglesToNativeFaces.count(); ++i )
+    QVector<int> trianglesToNativeFaces( triangles.count(), 0 );
+    for ( int i = 0; i < trianglesToNativeFaces.count(); ++i )
     {
-      QgsMeshFace triangle = simplifiedMesh->triangles().at( i );
+      const QgsMeshFace &triangle = triangles.at( i );
       double x = 0;
       double y = 0;
       for ( size_t j = 0; j < 3 ; ++j )
@@ -490,13 +525,15 @@ QVector<QgsTriangularMesh *> QgsTriangularMesh::simplifyMesh( double reductionFa
       }
 
       if ( indexInBaseMesh > -1 && indexInBaseMesh < mTrianglesToNativeFaces.count() )
-        simplifiedMesh->mTrianglesToNativeFaces[i] = mTrianglesToNativeFaces[indexInBaseMesh];
+        trianglesToNativeFaces[i] = mTrianglesToNativeFaces[indexInBaseMesh];
     }
 
-    simplifiedMesh->mLod = path + 1;
-    simplifiedMesh->mBaseTriangularMesh = this;
+    QgsTriangularMesh *mesh = simplifiedMesh( triangles, trianglesToNativeFaces, path + 1 );
+    simplifiedMeshes.push_back( mesh );
+
+    QgsDebugMsg( QStringLiteral( "Simplified mesh created with %1 triangles" ).arg( triangles.count() ) );
 
-    if ( simplifiedMesh->triangles().count() <  minimumTrianglesCount )
+    if ( mesh->triangles().count() <  minimumTrianglesCount )
       break;
 
     indexes = returnIndexes;
@@ -506,6 +543,23 @@ QVector<QgsTriangularMesh *> QgsTriangularMesh::simplifyMesh( double reductionFa
   return simplifiedMeshes;
 }
 
+QgsTriangularMesh *QgsTriangularMesh::simplifiedMesh( const QVector<QgsMeshFace> &triangles, const QVector<int> &trianglesToNativeFaces, int levelOfDetail ) const
+{
+  QgsTriangularMesh *mesh = new QgsTriangularMesh( *this );
+
+  QgsMesh newMesh;
+  newMesh.vertices = mTriangularMesh.vertices;
+  newMesh.faces = triangles;
+
+  mesh->mTriangularMesh = newMesh;
+  mesh->mSpatialFaceIndex = QgsMeshSpatialIndex( mesh->mTriangularMesh );
+  mesh->finalizeTriangles();
+  mesh->mTrianglesToNativeFaces = trianglesToNativeFaces;
+  mesh->mLod = levelOfDetail;
+
+  return mesh;
+}
+
 std::unique_ptr< QgsPolygon > QgsMeshUtils::toPolygon( const QgsMeshFace &face, const QVector<QgsMeshVertex> &vertices )
 {
   QVector<QgsPoint> ring;
@@ -170,6 +170,17 @@ class CORE_EXPORT QgsTriangularMesh // TODO rename to QgsRendererMesh in QGIS 4
      */
     QVector<QgsTriangularMesh *> simplifyMesh( double reductionFactor, int minimumTrianglesCount = 10 ) const;
 
+    /**
+     * Returns a simplified mesh made of \a triangles of the vertices of this mesh, with the matching
+     * \a trianglesToNativeFaces and \a levelOfDetail. It allows to restore the simplified meshes
+     * returned by simplifyMesh() without simplifying the mesh again.
+     *
+     * The caller has to take the ownership of returned mesh.
+     *
+     * \since QGIS 3.16
+     */
+    QgsTriangularMesh *simplifiedMesh( const QVector<QgsMeshFace> &triangles, const QVector<int> &trianglesToNativeFaces, int levelOfDetail ) const;
+
     /**
      * Returns the average size of triangles in map unit. It is calculated using the maximum of the height/width of the
      * bounding box of each triangles.
@@ -178,6 +189,16 @@ class CORE_EXPORT QgsTriangularMesh // TODO rename to QgsRendererMesh in QGIS 4
      */
     double averageTriangleSize() const;
 
+    /**
+     * Returns the average size of the triangles in map unit in the region covered by \a extent.
+     * It is estimated from a coarse grid over the mesh, so that the level of detail of meshes with triangles
+     * of very different sizes can match the displayed region. If there are no triangles in the region, returns
+     * averageTriangleSize().
+     *
+     * \since QGIS 3.16
+     */
+    double averageTriangleSize( const QgsRectangle &extent ) const;
+
     /**
      * Returns the corresponding index of level of detail on which this mesh is associated
      *
@@ -244,7 +265,9 @@ class CORE_EXPORT QgsTriangularMesh // TODO rename to QgsRendererMesh in QGIS 4
     double mAverageTriangleSize = 0;
     int mLod = 0;
 
-    const QgsTriangularMesh *mBaseTriangularMesh = nullptr;
+    // sum of the sizes and count of the triangles in each cell of a grid over the extent, to estimate the size of the triangles by region
+    QVector<double> mTriangleSizeSums;
+    QVector<int> mTriangleCounts;
 
     friend class TestQgsTriangularMesh;
 };
@@ -271,6 +271,16 @@ bool LabelPosition::isInConflict( const LabelPosition *lp ) const
     return isInConflictMultiPart( lp );
 }
 
+void LabelPosition::prepareConflictChecks() const
+{
+  for ( const LabelPosition *part = this; part; part = part->nextPart() )
+  {
+    if ( !part->mGeos )
+      part->createGeosGeom();
+    part->preparedGeom();
+  }
+}
+
 bool LabelPosition::isInConflictSinglePart( const LabelPosition *lp ) const
 {
   if ( qgsDoubleNear( alpha, 0 ) && qgsDoubleNear( lp->alpha, 0 ) )
@@ -136,6 +136,14 @@ namespace pal
        */
       bool isInConflict( const LabelPosition *ls ) const;
 
+      /**
+       * Creates the GEOS geometries used by isInConflict() for all the parts of the
+       * label position, which are otherwise created on the first conflict check.
+       * Conflicts can then be checked concurrently from several threads.
+       * \since QGIS 3.16
+       */
+      void prepareConflictChecks() const;
+
       //! Returns bounding box - amin: xmin,ymin - amax: xmax,ymax
       void getBoundingBox( double amin[2], double amax[2] ) const;
 
@@ -42,8 +42,11 @@
 #include "util.h"
 #include "palrtree.h"
 #include "qgssettings.h"
+#include "qgslabelplacements.h"
 #include <cfloat>
 #include <list>
+#include <QHash>
+#include <QtConcurrentMap>
 
 using namespace pal;
 
@@ -155,12 +158,56 @@ std::unique_ptr<Problem> Pal::extract( const QgsRectangle &extent, const QgsGeom
 
     QMutexLocker locker( &layer->mMutex );
 
-    // generate candidates for all features
-    for ( FeaturePart *featurePart : qgis::as_const( layer->mFeatureParts ) )
+    // generate candidates for all features, concurrently for the big layers. The parts of
+    // a label feature share its permissible zone, so they are handled by the same job.
+    const std::vector< FeaturePart * > featureParts( layer->mFeatureParts.begin(), layer->mFeatureParts.end() );
+    std::vector< std::vector< std::unique_ptr< LabelPosition > > > featurePartCandidates( featureParts.size() );
+    std::vector< std::vector< std::size_t > > candidatesJobs;
+    {
+      QHash< QgsLabelFeature *, std::size_t > jobIndexes;
+      for ( std::size_t i = 0; i < featureParts.size(); ++i )
+      {
+        const auto jobIndex = jobIndexes.constFind( featureParts[i]->feature() );
+        if ( jobIndex == jobIndexes.constEnd() )
+        {
+          jobIndexes.insert( featureParts[i]->feature(), candidatesJobs.size() );
+          candidatesJobs.emplace_back( std::vector< std::size_t > { i } );
+        }
+        else
+        {
+          candidatesJobs[ jobIndex.value() ].emplace_back( i );
+        }
+      }
+    }
+
+    auto createCandidates = [this, &featureParts, &featurePartCandidates]( const std::vector< std::size_t > &job )
+    {
+      for ( std::size_t i : job )
+      {
+        if ( isCanceled() )
+          return;
+
+        featurePartCandidates[i] = featureParts[i]->createCandidates( this );
+      }
+    };
+
+    if ( candidatesJobs.size() >= PARALLEL_CANDIDATES_THRESHOLD )
+    {
+      QtConcurrent::blockingMap( candidatesJobs, createCandidates );
+    }
+    else
+    {
+      for ( const std::vector< std::size_t > &job : candidatesJobs )
+        createCandidates( job );
+    }
+
+    for ( std::size_t featurePartIndex = 0; featurePartIndex < featureParts.size(); ++featurePartIndex )
     {
       if ( isCanceled() )
         break;
 
+      FeaturePart *featurePart = featureParts[ featurePartIndex ];
+
       // Holes of the feature are obstacles
       for ( int i = 0; i < featurePart->getNumSelfObstacles(); i++ )
       {
@@ -174,11 +221,23 @@ std::unique_ptr<Problem> Pal::extract( const QgsRectangle &extent, const QgsGeom
         }
       }
 
-      // generate candidates for the feature part
-      std::vector< std::unique_ptr< LabelPosition > > candidates = featurePart->createCandidates( this );
+      // candidates of the feature part
+      std::vector< std::unique_ptr< LabelPosition > > candidates = std::move( featurePartCandidates[ featurePartIndex ] );
 
-      if ( isCanceled() )
-        break;
+      // a feature which remains fully visible keeps the label position of the previous solve
+      if ( mPreviousPlacements && !candidates.empty() )
+      {
+        auto previous = std::find_if( candidates.begin(), candidates.end(), [this, featurePart, &mapBoundaryPrepared]( const std::unique_ptr< LabelPosition > &candidate )
+        {
+          return mPreviousPlacements->contains( featurePart, candidate.get() ) && candidate->within( mapBoundaryPrepared.get() );
+        } );
+        if ( previous != candidates.end() )
+        {
+          std::unique_ptr< LabelPosition > kept = std::move( *previous );
+          candidates.clear();
+          candidates.emplace_back( std::move( kept ) );
+        }
+      }
 
       // purge candidates that are outside the bbox
       candidates.erase( std::remove_if( candidates.begin(), candidates.end(), [&mapBoundaryPrepared, this]( std::unique_ptr< LabelPosition > &candidate )
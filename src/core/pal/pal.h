@@ -48,6 +48,7 @@
 // TODO ${MAJOR} ${MINOR} etc instead of 0.2
 
 class QgsAbstractLabelProvider;
+class QgsLabelPlacements;
 
 namespace pal
 {
@@ -163,6 +164,16 @@ namespace pal
        */
       bool showPartialLabels() const;
 
+      /**
+       * Sets the label \a placements of a previous solve of the same map. The features fully
+       * visible at a position of these placements keep that candidate alone.
+       *
+       * Ownership is not transferred, the placements must exist until the problem is extracted.
+       *
+       * \since QGIS 3.16
+       */
+      void setPreviousPlacements( const QgsLabelPlacements *placements ) { mPreviousPlacements = placements; }
+
       /**
        * Returns the maximum number of line label candidate positions per map unit.
        *
@@ -243,8 +254,13 @@ namespace pal
 
     private:
 
+      //! Minimum number of label features of a layer for their candidates to be generated concurrently
+      static const std::size_t PARALLEL_CANDIDATES_THRESHOLD = 64;
+
       std::unordered_map< QgsAbstractLabelProvider *, std::unique_ptr< Layer > > mLayers;
 
+      const QgsLabelPlacements *mPreviousPlacements = nullptr;
+
       QMutex mMutex;
 
       /*
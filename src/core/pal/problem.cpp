@@ -37,8 +37,10 @@
 #include "util.h"
 #include "priorityqueue.h"
 #include "internalexception.h"
+#include <algorithm>
 #include <cfloat>
 #include <limits> //for std::numeric_limits<int>::max()
+#include <QtConcurrentMap>
 
 #include "qgslabelingengine.h"
 
@@ -57,6 +59,7 @@ inline void delete_chain( Chain *chain )
 Problem::Problem( const QgsRectangle &extent )
   : mAllCandidatesIndex( extent )
   , mActiveCandidatesIndex( extent )
+  , mExtent( extent )
 {
 
 }
@@ -137,49 +140,141 @@ void Problem::reduce()
   delete[] ok;
 }
 
-void ignoreLabel( const LabelPosition *lp, PriorityQueue &list, PalRtree< LabelPosition > &candidatesIndex )
+/**
+ * Removes \a lp from \a list, the priority queue of the candidates of a component keyed by
+ * \a localIds, and decreases the keys of the candidates of the component it conflicts with.
+ * \a candidates are the ids of the candidates of the component.
+ */
+void ignoreLabel( const LabelPosition *lp, PriorityQueue &list, PalRtree< LabelPosition > &candidatesIndex,
+                  const std::vector< int > &localIds, const std::vector< int > &candidates )
 {
-  if ( list.isIn( lp->getId() ) )
+  const int key = localIds[ lp->getId() ];
+  if ( list.isIn( key ) )
   {
-    list.remove( lp->getId() );
+    list.remove( key );
 
     double amin[2];
     double amax[2];
     lp->getBoundingBox( amin, amax );
-    candidatesIndex.intersects( QgsRectangle( amin[0], amin[1], amax[0], amax[1] ), [lp, &list]( const LabelPosition * lp2 )->bool
+    candidatesIndex.intersects( QgsRectangle( amin[0], amin[1], amax[0], amax[1] ), [lp, &list, &localIds, &candidates]( const LabelPosition * lp2 )->bool
     {
-      if ( lp2->getId() != lp->getId() && list.isIn( lp2->getId() ) && lp2->isInConflict( lp ) )
+      // candidates of other components are not in the queue
+      const int key2 = localIds[ lp2->getId() ];
+      const bool inComponent = key2 >= 0 && key2 < static_cast< int >( candidates.size() ) && candidates[ key2 ] == lp2->getId();
+      if ( lp2->getId() != lp->getId() && inComponent && list.isIn( key2 ) && lp2->isInConflict( lp ) )
       {
-        list.decreaseKey( lp2->getId() );
+        list.decreaseKey( key2 );
       }
       return true;
     } );
   }
 }
 
+std::vector< Problem::Component > Problem::conflictComponents()
+{
+  // union-find of the features, joined when any of their candidates conflict
+  std::vector< int > parents( mFeatureCount );
+  for ( std::size_t i = 0; i < mFeatureCount; i++ )
+    parents[i] = static_cast< int >( i );
+
+  auto root = [&parents]( int feature ) -> int
+  {
+    while ( parents[feature] != feature )
+    {
+      parents[feature] = parents[ parents[feature] ];
+      feature = parents[feature];
+    }
+    return feature;
+  };
+
+  // candidates with more than one part or rotated are checked for conflicts with GEOS
+  auto usesGeos = []( const LabelPosition * lp ) -> bool
+  {
+    return lp->nextPart() || !qgsDoubleNear( lp->getAlpha(), 0 );
+  };
+
+  double amin[2];
+  double amax[2];
+  for ( std::size_t i = 0; i < mFeatureCount; i++ )
+  {
+    for ( int j = 0; j < mFeatNbLp[i]; j++ )
+    {
+      const LabelPosition *lp = mLabelPositions[ mFeatStartId[i] + j ].get();
+      bool geosRequired = false;
+      lp->getBoundingBox( amin, amax );
+      mAllCandidatesIndex.intersects( QgsRectangle( amin[0], amin[1], amax[0], amax[1] ), [lp, &root, &parents, &geosRequired, &usesGeos]( const LabelPosition * lp2 ) -> bool
+      {
+        geosRequired = geosRequired || usesGeos( lp ) || usesGeos( lp2 );
+        if ( lp->isInConflict( lp2 ) )
+        {
+          const int root1 = root( lp->getProblemFeatureId() );
+          const int root2 = root( lp2->getProblemFeatureId() );
+          if ( root1 != root2 )
+            parents[ std::max( root1, root2 ) ] = std::min( root1, root2 );
+        }
+        return true;
+      } );
+
+      // the GEOS geometries are created lazily, create them now as the components
+      // are solved concurrently and share the candidates close to their boundaries
+      if ( geosRequired )
+        lp->prepareConflictChecks();
+    }
+  }
+
+  std::vector< Component > components;
+  std::vector< int > componentIds( mFeatureCount, -1 );
+  mFeatureLocalIds.assign( mFeatureCount, -1 );
+  mCandidateLocalIds.assign( mLabelPositions.size(), -1 );
+  for ( std::size_t i = 0; i < mFeatureCount; i++ )
+  {
+    if ( mFeatNbLp[i] == 0 )
+      continue;
+
+    const int featureRoot = root( static_cast< int >( i ) );
+    if ( componentIds[ featureRoot ] == -1 )
+    {
+      componentIds[ featureRoot ] = static_cast< int >( components.size() );
+      components.emplace_back( Component() );
+    }
+
+    // features and candidates are kept in the problem order, so that a component holding
+    // all the features is solved exactly as the whole problem
+    Component &component = components[ componentIds[ featureRoot ] ];
+    mFeatureLocalIds[i] = static_cast< int >( component.features.size() );
+    component.features.emplace_back( static_cast< int >( i ) );
+    for ( int j = 0; j < mFeatNbLp[i]; j++ )
+    {
+      mCandidateLocalIds[ mFeatStartId[i] + j ] = static_cast< int >( component.candidates.size() );
+      component.candidates.emplace_back( mFeatStartId[i] + j );
+    }
+  }
+
+  return components;
+}
+
 /* Better initial solution
  * Step one FALP (Yamamoto, Camara, Lorena 2005)
  */
-void Problem::init_sol_falp()
+void Problem::init_sol_falp( const Component &component, PalRtree< LabelPosition > &activeIndex )
 {
   int label;
 
-  mSol.init( mFeatureCount );
-
-  PriorityQueue list( mTotalCandidates, mAllNblp, true );
+  const int candidateCount = static_cast< int >( component.candidates.size() );
+  PriorityQueue list( candidateCount, candidateCount - 1, true );
 
   double amin[2];
   double amax[2];
 
   LabelPosition *lp = nullptr;
 
-  for ( int i = 0; i < static_cast< int >( mFeatureCount ); i++ )
+  for ( int i : component.features )
     for ( int j = 0; j < mFeatNbLp[i]; j++ )
     {
       label = mFeatStartId[i] + j;
       try
       {
-        list.insert( label, mLabelPositions.at( label )->getNumOverlaps() );
+        list.insert( mCandidateLocalIds[label], mLabelPositions.at( label )->getNumOverlaps() );
       }
       catch ( pal::InternalException::Full & )
       {
@@ -194,7 +289,7 @@ void Problem::init_sol_falp()
       return;
     }
 
-    label = list.getBest();   // O (log size)
+    label = component.candidates[ list.getBest() ];   // O (log size)
 
     lp = mLabelPositions[ label ].get();
 
@@ -208,7 +303,7 @@ void Problem::init_sol_falp()
 
     for ( int i = mFeatStartId[probFeatId]; i < mFeatStartId[probFeatId] + mFeatNbLp[probFeatId]; i++ )
     {
-      ignoreLabel( mLabelPositions[ i ].get(), list, mAllCandidatesIndex );
+      ignoreLabel( mLabelPositions[ i ].get(), list, mAllCandidatesIndex, mCandidateLocalIds, component.candidates );
     }
 
 
@@ -226,10 +321,10 @@ void Problem::init_sol_falp()
 
     for ( const LabelPosition *conflict : conflictingPositions )
     {
-      ignoreLabel( conflict, list, mAllCandidatesIndex );
+      ignoreLabel( conflict, list, mAllCandidatesIndex, mCandidateLocalIds, component.candidates );
     }
 
-    mActiveCandidatesIndex.insert( lp, QgsRectangle( amin[0], amin[1], amax[0], amax[1] ) );
+    activeIndex.insert( lp, QgsRectangle( amin[0], amin[1], amax[0], amax[1] ) );
   }
 
   if ( mDisplayAll )
@@ -239,7 +334,7 @@ void Problem::init_sol_falp()
     LabelPosition *retainedLabel = nullptr;
     int p;
 
-    for ( std::size_t i = 0; i < mFeatureCount; i++ ) // forearch hidden feature
+    for ( int i : component.features ) // forearch hidden feature
     {
       if ( mSol.activeLabelIds[i] == -1 )
       {
@@ -253,7 +348,7 @@ void Problem::init_sol_falp()
           lp->getBoundingBox( amin, amax );
 
 
-          mActiveCandidatesIndex.intersects( QgsRectangle( amin[0], amin[1], amax[0], amax[1] ), [&lp]( const LabelPosition * lp2 )->bool
+          activeIndex.intersects( QgsRectangle( amin[0], amin[1], amax[0], amax[1] ), [&lp]( const LabelPosition * lp2 )->bool
           {
             if ( lp->isInConflict( lp2 ) )
             {
@@ -270,14 +365,14 @@ void Problem::init_sol_falp()
         }
         mSol.activeLabelIds[i] = retainedLabel->getId();
 
-        retainedLabel->insertIntoIndex( mActiveCandidatesIndex );
+        retainedLabel->insertIntoIndex( activeIndex );
 
       }
     }
   }
 }
 
-inline Chain *Problem::chain( int seed )
+inline Chain *Problem::chain( const Component &component, PalRtree< LabelPosition > &activeIndex, int seed )
 {
   int lid;
 
@@ -297,7 +392,11 @@ inline Chain *Problem::chain( int seed )
   QLinkedList<ElemTrans *> currentChain;
   QLinkedList<int> conflicts;
 
-  std::vector< int > tmpsol( mSol.activeLabelIds );
+  // solution of the features of the component, by local id
+  std::vector< int > tmpsol;
+  tmpsol.reserve( component.features.size() );
+  for ( int feature : component.features )
+    tmpsol.emplace_back( mSol.activeLabelIds[feature] );
 
   LabelPosition *lp = nullptr;
 
@@ -307,6 +406,7 @@ inline Chain *Problem::chain( int seed )
   delta = 0;
   while ( seed != -1 )
   {
+    const int localSeed = mFeatureLocalIds[seed];
     seedNbLp = mFeatNbLp[seed];
     delta_min = std::numeric_limits<double>::max();
 
@@ -314,17 +414,17 @@ inline Chain *Problem::chain( int seed )
     retainedLabel = -2;
 
     // sol[seed] is ejected
-    if ( tmpsol[seed] == -1 )
+    if ( tmpsol[localSeed] == -1 )
       delta -= mInactiveCost[seed];
     else
-      delta -= mLabelPositions.at( tmpsol[seed] )->cost();
+      delta -= mLabelPositions.at( tmpsol[localSeed] )->cost();
 
     for ( int i = -1; i < seedNbLp; i++ )
     {
       try
       {
         // Skip active label !
-        if ( !( tmpsol[seed] == -1 && i == -1 ) && i + mFeatStartId[seed] != tmpsol[seed] )
+        if ( !( tmpsol[localSeed] == -1 && i == -1 ) && i + mFeatStartId[seed] != tmpsol[localSeed] )
         {
           if ( i != -1 ) // new_label
           {
@@ -336,7 +436,7 @@ inline Chain *Problem::chain( int seed )
             // evaluate conflicts graph in solution after moving seed's label
 
             lp->getBoundingBox( amin, amax );
-            mActiveCandidatesIndex.intersects( QgsRectangle( amin[0], amin[1], amax[0], amax[1] ), [lp, &delta_tmp, &conflicts, &currentChain, this]( const LabelPosition * lp2 ) -> bool
+            activeIndex.intersects( QgsRectangle( amin[0], amin[1], amax[0], amax[1] ), [lp, &delta_tmp, &conflicts, &currentChain, this]( const LabelPosition * lp2 ) -> bool
             {
               if ( lp2->isInConflict( lp ) )
               {
@@ -518,22 +618,22 @@ inline Chain *Problem::chain( int seed )
     {
       ElemTrans *et = new ElemTrans();
       et->feat  = seed;
-      et->old_label = tmpsol[seed];
+      et->old_label = tmpsol[localSeed];
       et->new_label = retainedLabel;
       currentChain.append( et );
 
       if ( et->old_label != -1 )
       {
-        mLabelPositions.at( et->old_label )->removeFromIndex( mActiveCandidatesIndex );
+        mLabelPositions.at( et->old_label )->removeFromIndex( activeIndex );
       }
 
       if ( et->new_label != -1 )
       {
-        mLabelPositions.at( et->new_label )->insertIntoIndex( mActiveCandidatesIndex );
+        mLabelPositions.at( et->new_label )->insertIntoIndex( activeIndex );
       }
 
 
-      tmpsol[seed] = retainedLabel;
+      tmpsol[localSeed] = retainedLabel;
       // cppcheck-suppress invalidFunctionArg
       delta += mLabelPositions.at( retainedLabel )->cost();
       seed = next_seed;
@@ -546,12 +646,12 @@ inline Chain *Problem::chain( int seed )
 
     if ( et->new_label != -1 )
     {
-      mLabelPositions.at( et->new_label )->removeFromIndex( mActiveCandidatesIndex );
+      mLabelPositions.at( et->new_label )->removeFromIndex( activeIndex );
     }
 
     if ( et->old_label != -1 )
     {
-      mLabelPositions.at( et->old_label )->insertIntoIndex( mActiveCandidatesIndex );
+      mLabelPositions.at( et->old_label )->insertIntoIndex( activeIndex );
     }
   }
 
@@ -564,22 +664,62 @@ void Problem::chain_search()
   if ( mFeatureCount == 0 )
     return;
 
+  mSol.init( mFeatureCount );
+
+  // the candidates of different components never conflict, the components are solved
+  // concurrently, each one in the same way whatever the number of threads
+  std::vector< Component > components = conflictComponents();
+  std::sort( components.begin(), components.end(), []( const Component & c1, const Component & c2 )
+  {
+    return c1.candidates.size() > c2.candidates.size();
+  } );
+
+  auto solveComponent = [this]( Component & component )
+  {
+    PalRtree< LabelPosition > activeIndex( mExtent );
+    chain_search( component, activeIndex );
+  };
+
+  if ( components.size() > 1 && mTotalCandidates >= PARALLEL_SOLVE_THRESHOLD )
+  {
+    QtConcurrent::blockingMap( components, solveComponent );
+  }
+  else
+  {
+    for ( Component &component : components )
+      solveComponent( component );
+  }
+
+  if ( pal->isCanceled() )
+    return;
+
+  for ( std::size_t i = 0; i < mFeatureCount; i++ )
+  {
+    if ( mSol.activeLabelIds[i] >= 0 )
+      mLabelPositions.at( mSol.activeLabelIds[i] )->insertIntoIndex( mActiveCandidatesIndex );
+  }
+
+  solution_cost();
+}
+
+void Problem::chain_search( const Component &component, PalRtree< LabelPosition > &activeIndex )
+{
+  const int featureCount = static_cast< int >( component.features.size() );
+
   int i;
   int seed;
-  bool *ok = new bool[mFeatureCount];
+  std::vector< bool > ok( featureCount, false );
   int fid;
   int lid;
   int popit = 0;
 
   Chain *retainedChain = nullptr;
 
-  std::fill( ok, ok + mFeatureCount, false );
-
   //initialization();
-  init_sol_falp();
+  init_sol_falp( component, activeIndex );
 
-  //check_solution();
-  solution_cost();
+  if ( pal->isCanceled() )
+    return;
 
   int iter = 0;
 
@@ -591,9 +731,9 @@ void Problem::chain_search()
 
     //check_solution();
 
-    for ( seed = ( iter + 1 ) % mFeatureCount;
+    for ( seed = ( iter + 1 ) % featureCount;
           ok[seed] && seed != iter;
-          seed = ( seed + 1 ) % mFeatureCount )
+          seed = ( seed + 1 ) % featureCount )
       ;
 
     // All seeds are OK
@@ -602,8 +742,8 @@ void Problem::chain_search()
       break;
     }
 
-    iter = ( iter + 1 ) % mFeatureCount;
-    retainedChain = chain( seed );
+    iter = ( iter + 1 ) % featureCount;
+    retainedChain = chain( component, activeIndex, component.features[seed] );
 
     if ( retainedChain && retainedChain->delta < - EPSILON )
     {
@@ -616,13 +756,13 @@ void Problem::chain_search()
         if ( mSol.activeLabelIds[fid] >= 0 )
         {
           LabelPosition *old = mLabelPositions[ mSol.activeLabelIds[fid] ].get();
-          old->removeFromIndex( mActiveCandidatesIndex );
+          old->removeFromIndex( activeIndex );
           old->getBoundingBox( amin, amax );
-          mAllCandidatesIndex.intersects( QgsRectangle( amin[0], amin[1], amax[0], amax[1] ), [&ok, old]( const LabelPosition * lp ) ->bool
+          mAllCandidatesIndex.intersects( QgsRectangle( amin[0], amin[1], amax[0], amax[1] ), [&ok, old, this]( const LabelPosition * lp ) ->bool
           {
             if ( old->isInConflict( lp ) )
             {
-              ok[lp->getProblemFeatureId()] = false;
+              ok[ mFeatureLocalIds[ lp->getProblemFeatureId() ] ] = false;
             }
 
             return true;
@@ -633,12 +773,11 @@ void Problem::chain_search()
 
         if ( mSol.activeLabelIds[fid] >= 0 )
         {
-          mLabelPositions.at( lid )->insertIntoIndex( mActiveCandidatesIndex );
+          mLabelPositions.at( lid )->insertIntoIndex( activeIndex );
         }
 
-        ok[fid] = false;
+        ok[ mFeatureLocalIds[fid] ] = false;
       }
-      mSol.totalCost += retainedChain->delta;
     }
     else
     {
@@ -649,9 +788,6 @@ void Problem::chain_search()
     delete_chain( retainedChain );
     popit++;
   }
-
-  solution_cost();
-  delete[] ok;
 }
 
 QList<LabelPosition *> Problem::getSolution( bool returnInactive, QList<LabelPosition *> *unlabeled )
@@ -114,6 +114,10 @@ namespace pal
 
       /**
        * \brief Test with very-large scale neighborhood
+       *
+       * The features whose candidates conflict, directly or through other features, are
+       * grouped in components which are solved independently, concurrently on the global
+       * thread pool for big problems.
        */
       void chain_search();
 
@@ -134,8 +138,6 @@ namespace pal
       /* useful only for postscript post-conversion*/
       //void toFile(char *label_file);
 
-      void init_sol_falp();
-
       /**
        * Returns a reference to the list of label positions which correspond to
        * features with no candidates.
@@ -154,6 +156,21 @@ namespace pal
 
     private:
 
+      /**
+       * Connected component of the conflict graph: the candidates of the features of
+       * different components never conflict.
+       */
+      struct Component
+      {
+        //! Problem ids of the features, in increasing order
+        std::vector< int > features;
+        //! Ids of the candidates of the features, in increasing order
+        std::vector< int > candidates;
+      };
+
+      //! Minimum number of candidates for the components to be solved concurrently
+      static const int PARALLEL_SOLVE_THRESHOLD = 1000;
+
       /**
        * Total number of layers containing labels
        */
@@ -196,10 +213,17 @@ namespace pal
 
       std::vector< std::unique_ptr< LabelPosition > > mPositionsWithNoCandidates;
 
+      QgsRectangle mExtent;
+
       std::vector< int > mFeatStartId;
       std::vector< int > mFeatNbLp;
       std::vector< double > mInactiveCost;
 
+      //! Index of the features in their component
+      std::vector< int > mFeatureLocalIds;
+      //! Index of the candidates in the component of their feature
+      std::vector< int > mCandidateLocalIds;
+
       class Sol
       {
         public:
@@ -219,7 +243,18 @@ namespace pal
       Sol mSol;
       double mNbOverlap = 0.0;
 
-      Chain *chain( int seed );
+      /**
+       * Returns the connected components of the conflict graph of the features with candidates,
+       * and sets the local ids of the features and candidates.
+       */
+      std::vector< Component > conflictComponents();
+
+      void init_sol_falp( const Component &component, PalRtree< LabelPosition > &activeIndex );
+
+      //! Solves the features of \a component, \a activeIndex holds the active candidates of the component
+      void chain_search( const Component &component, PalRtree< LabelPosition > &activeIndex );
+
+      Chain *chain( const Component &component, PalRtree< LabelPosition > &activeIndex, int seed );
 
       Pal *pal = nullptr;
 
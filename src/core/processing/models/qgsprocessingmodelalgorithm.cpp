@@ -17,6 +17,7 @@
 
 #include "qgsprocessingmodelalgorithm.h"
 #include "qgsprocessingregistry.h"
+#include "qgsprocessingfeaturepipe.h"
 #include "qgsprocessingfeedback.h"
 #include "qgsprocessingutils.h"
 #include "qgis.h"
@@ -28,9 +29,15 @@
 #include "qgsprocessingparametertype.h"
 #include "qgsexpressioncontextutils.h"
 #include "qgsprocessingmodelgroupbox.h"
+#include "qgsmaplayerstore.h"
 
 #include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
 #include <QTextStream>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <QtConcurrentRun>
 
 ///@cond NOT_STABLE
 
@@ -292,159 +299,469 @@ QVariantMap QgsProcessingModelAlgorithm::processAlgorithm( const QVariantMap &pa
 
   QVariantMap finalResults;
   QSet< QString > executed;
-  bool executedAlg = true;
-  while ( executedAlg && executed.count() < toExecute.count() )
+  QSet< QString > started;
+
+  // a child algorithm running in a background thread, with its own context and feedback
+  struct BackgroundChild
   {
-    executedAlg = false;
-    for ( const QString &childId : qgis::as_const( toExecute ) )
-    {
-      if ( feedback && feedback->isCanceled() )
-        break;
+    QString childId;
+    std::unique_ptr< QgsProcessingAlgorithm > algorithm;
+    std::unique_ptr< QgsProcessingContext > context;
+    std::unique_ptr< QgsProcessingRecordingFeedback > feedback;
+    QVariantMap parameters;
+    QVariantMap results;
+    QString error;
+    bool ok;
+    bool finished;
+    bool skipGenericLogging;
+    QElapsedTimer time;
+    QFuture< void > future;
+    std::vector< std::shared_ptr< QgsProcessingFeaturePipe > > producedPipes;
+    std::shared_ptr< QgsProcessingFeaturePipe > consumedPipe;
+  };
 
-      if ( executed.contains( childId ) )
-        continue;
+  // a feature sink output of a child streamed through a pipe to the child reading it
+  struct StreamedOutput
+  {
+    QString outputName;
+    QString consumerId;
+    std::shared_ptr< QgsProcessingFeaturePipe > pipe;
+  };
 
-      bool canExecute = true;
-      const QSet< QString > dependencies = dependsOnChildAlgorithms( childId );
-      for ( const QString &dependency : dependencies )
+  // the background children are canceled and waited for whenever processAlgorithm() returns or throws
+  class BackgroundChildren
+  {
+    public:
+      ~BackgroundChildren()
       {
-        if ( !executed.contains( dependency ) )
+        for ( const std::unique_ptr< BackgroundChild > &child : children )
+          child->feedback->cancel();
+        // the producers and consumers of the streamed outputs do not wait for each other anymore
+        for ( const std::unique_ptr< BackgroundChild > &child : children )
         {
-          canExecute = false;
-          break;
+          for ( const std::shared_ptr< QgsProcessingFeaturePipe > &pipe : child->producedPipes )
+            pipe->release();
         }
+        for ( const std::unique_ptr< BackgroundChild > &child : children )
+          child->future.waitForFinished();
       }
 
-      if ( !canExecute )
-        continue;
+      std::vector< std::unique_ptr< BackgroundChild > > children;
+      QMutex mutex;
+      QWaitCondition finished;
+  };
+  BackgroundChildren background;
+  const int maxBackgroundChildren = QThreadPool::globalInstance()->maxThreadCount();
 
-      executedAlg = true;
+  // the layers of the pipes of the streamed outputs, by output name and by child id
+  QMap< QString, QVariantMap > streamedLayers;
 
-      const QgsProcessingModelChildAlgorithm &child = mChildAlgorithms[ childId ];
-      std::unique_ptr< QgsProcessingAlgorithm > childAlg( child.algorithm()->create( child.configuration() ) );
+  std::function< void( const QString &, const QString & )> pruneAlgorithmBranchRecursive;
+  pruneAlgorithmBranchRecursive = [&]( const QString & id, const QString &branch = QString() )
+  {
+    const QSet<QString> toPrune = dependentChildAlgorithms( id, branch );
+    for ( const QString &targetId : toPrune )
+    {
+      if ( executed.contains( targetId ) )
+        continue;
 
-      const bool skipGenericLogging = !verboseLog || childAlg->flags() & QgsProcessingAlgorithm::FlagSkipGenericModelLogging;
-      if ( feedback && !skipGenericLogging )
-        feedback->pushDebugInfo( QObject::tr( "Prepare algorithm: %1" ).arg( childId ) );
+      executed.insert( targetId );
+      pruneAlgorithmBranchRecursive( targetId, branch );
+    }
+  };
+
+  // records the results of an executed child algorithm, and prunes the branches which did not eventuate
+  auto childExecuted = [&]( const QString & childId, const QgsProcessingAlgorithm * childAlg, const QVariantMap & results, const QElapsedTimer & childTime, bool skipGenericLogging )
+  {
+    const QgsProcessingModelChildAlgorithm &child = mChildAlgorithms[ childId ];
+    childResults.insert( childId, results );
 
-      QgsExpressionContext expContext = baseContext;
-      expContext << QgsExpressionContextUtils::processingAlgorithmScope( child.algorithm(), parameters, context )
-                 << createExpressionContextScopeForChildAlgorithm( childId, context, parameters, childResults );
-      context.setExpressionContext( expContext );
+    // look through child alg's outputs to determine whether any of these should be copied
+    // to the final model outputs
+    QMap<QString, QgsProcessingModelOutput> outputs = child.modelOutputs();
+    QMap<QString, QgsProcessingModelOutput>::const_iterator outputIt = outputs.constBegin();
+    for ( ; outputIt != outputs.constEnd(); ++outputIt )
+    {
+      finalResults.insert( childId + ':' + outputIt->name(), results.value( outputIt->childOutputName() ) );
+    }
 
-      QVariantMap childParams = parametersForChildAlgorithm( child, parameters, childResults, expContext );
-      if ( feedback && !skipGenericLogging )
-        feedback->setProgressText( QObject::tr( "Running %1 [%2/%3]" ).arg( child.description() ).arg( executed.count() + 1 ).arg( toExecute.count() ) );
+    executed.insert( childId );
 
-      childInputs.insert( childId, childParams );
-      QStringList params;
-      for ( auto childParamIt = childParams.constBegin(); childParamIt != childParams.constEnd(); ++childParamIt )
+    // prune remaining algorithms if they are dependent on a branch from this child which didn't eventuate
+    const QgsProcessingOutputDefinitions outputDefs = childAlg->outputDefinitions();
+    for ( const QgsProcessingOutputDefinition *outputDef : outputDefs )
+    {
+      if ( outputDef->type() == QgsProcessingOutputConditionalBranch::typeName() && !results.value( outputDef->name() ).toBool() )
       {
-        params << QStringLiteral( "%1: %2" ).arg( childParamIt.key(),
-               child.algorithm()->parameterDefinition( childParamIt.key() )->valueAsPythonString( childParamIt.value(), context ) );
+        pruneAlgorithmBranchRecursive( childId, outputDef->name() );
       }
+    }
 
-      if ( feedback && !skipGenericLogging )
+    if ( childAlg->flags() & QgsProcessingAlgorithm::FlagPruneModelBranchesBasedOnAlgorithmResults )
+    {
+      // check if any dependent algorithms should be canceled based on the outputs of this algorithm run
+      // first find all direct dependencies of this algorithm by looking through all remaining child algorithms
+      for ( const QString &candidateId : qgis::as_const( toExecute ) )
       {
-        feedback->pushInfo( QObject::tr( "Input Parameters:" ) );
-        feedback->pushCommandInfo( QStringLiteral( "{ %1 }" ).arg( params.join( QStringLiteral( ", " ) ) ) );
+        if ( executed.contains( candidateId ) )
+          continue;
+
+        // a pending algorithm was found..., check it's parameter sources to see if it links to any of the current
+        // algorithm's outputs
+        const QgsProcessingModelChildAlgorithm &candidate = mChildAlgorithms[ candidateId ];
+        const QMap<QString, QgsProcessingModelChildParameterSources> candidateParams = candidate.parameterSources();
+        QMap<QString, QgsProcessingModelChildParameterSources>::const_iterator paramIt = candidateParams.constBegin();
+        bool pruned = false;
+        for ( ; paramIt != candidateParams.constEnd(); ++paramIt )
+        {
+          for ( const QgsProcessingModelChildParameterSource &source : paramIt.value() )
+          {
+            if ( source.source() == QgsProcessingModelChildParameterSource::ChildOutput && source.outputChildId() == childId )
+            {
+              // ok, this one is dependent on the current alg. Did we get a value for it?
+              if ( !results.contains( source.outputName() ) )
+              {
+                // oh no, nothing returned for this parameter. Gotta trim the branch back!
+                pruned = true;
+                // skip the dependent alg..
+                executed.insert( candidateId );
+                //... and everything which depends on it
+                pruneAlgorithmBranchRecursive( candidateId, QString() );
+                break;
+              }
+            }
+          }
+          if ( pruned )
+            break;
+        }
       }
+    }
+
+    modelFeedback.setCurrentStep( executed.count() );
+    if ( feedback && !skipGenericLogging )
+      feedback->pushInfo( QObject::tr( "OK. Execution took %1 s (%2 outputs)." ).arg( childTime.elapsed() / 1000.0 ).arg( results.count() ) );
+  };
+
+  auto childFailed = [&]( const QgsProcessingModelChildAlgorithm & child, const QgsProcessingAlgorithm * childAlg )
+  {
+    const QString error = ( childAlg->flags() & QgsProcessingAlgorithm::FlagCustomException ) ? QString() : QObject::tr( "Error encountered while running %1" ).arg( child.description() );
+    throw QgsProcessingException( error );
+  };
 
-      QElapsedTimer childTime;
-      childTime.start();
+  // prepares and runs a child, in a background thread if runInBackground is TRUE, with the results of the
+  // previous children. Returns FALSE if the child ran in the calling thread, without streaming its outputs
+  auto startChild = [&]( const QString & childId, std::unique_ptr< QgsProcessingAlgorithm > childAlg, bool runInBackground, const QVariantMap & availableResults,
+                         const QList< StreamedOutput > &streamedOutputs, const std::shared_ptr< QgsProcessingFeaturePipe > &consumedPipe ) -> bool
+  {
+    const QgsProcessingModelChildAlgorithm &child = mChildAlgorithms[ childId ];
+    started.insert( childId );
+
+    const bool skipGenericLogging = !verboseLog || childAlg->flags() & QgsProcessingAlgorithm::FlagSkipGenericModelLogging;
+    if ( feedback && !skipGenericLogging )
+      feedback->pushDebugInfo( QObject::tr( "Prepare algorithm: %1" ).arg( childId ) );
+
+    QgsExpressionContext expContext = baseContext;
+    expContext << QgsExpressionContextUtils::processingAlgorithmScope( child.algorithm(), parameters, context )
+               << createExpressionContextScopeForChildAlgorithm( childId, context, parameters, childResults );
+    context.setExpressionContext( expContext );
+
+    QVariantMap childParams = parametersForChildAlgorithm( child, parameters, availableResults, expContext );
+
+    // the background child has its own context, without the temporary layers of the previous children
+    QVariantMap backgroundParams;
+    for ( auto childParamIt = childParams.constBegin(); runInBackground && childParamIt != childParams.constEnd(); ++childParamIt )
+      backgroundParams.insert( childParamIt.key(), resolveTemporaryLayers( childParamIt.value(), context, runInBackground ) );
+
+    // the streamed outputs are written to their pipes, while the children reading them run
+    for ( const StreamedOutput &output : streamedOutputs )
+    {
+      if ( !runInBackground )
+        break;
 
+      childParams.insert( output.outputName, output.pipe->destination() );
+      backgroundParams.insert( output.outputName, output.pipe->destination() );
+    }
+
+    if ( feedback && !skipGenericLogging )
+      feedback->setProgressText( QObject::tr( "Running %1 [%2/%3]" ).arg( child.description() ).arg( executed.count() + static_cast< int >( background.children.size() ) + 1 ).arg( toExecute.count() ) );
+
+    childInputs.insert( childId, childParams );
+    QStringList params;
+    for ( auto childParamIt = childParams.constBegin(); childParamIt != childParams.constEnd(); ++childParamIt )
+    {
+      params << QStringLiteral( "%1: %2" ).arg( childParamIt.key(),
+             child.algorithm()->parameterDefinition( childParamIt.key() )->valueAsPythonString( childParamIt.value(), context ) );
+    }
+
+    if ( feedback && !skipGenericLogging )
+    {
+      feedback->pushInfo( QObject::tr( "Input Parameters:" ) );
+      feedback->pushCommandInfo( QStringLiteral( "{ %1 }" ).arg( params.join( QStringLiteral( ", " ) ) ) );
+    }
+
+    QElapsedTimer childTime;
+    childTime.start();
+
+    if ( !runInBackground )
+    {
       bool ok = false;
       QVariantMap results = childAlg->run( childParams, context, &modelFeedback, &ok, child.configuration() );
-      if ( !ok )
+      if ( consumedPipe )
       {
-        const QString error = ( childAlg->flags() & QgsProcessingAlgorithm::FlagCustomException ) ? QString() : QObject::tr( "Error encountered while running %1" ).arg( child.description() );
-        throw QgsProcessingException( error );
+        consumedPipe->release();
+        if ( ok && consumedPipe->wasReadAgain() )
+        {
+          modelFeedback.reportError( QObject::tr( "The streamed input of %1 was read more than once" ).arg( child.description() ) );
+          ok = false;
+        }
       }
-      childResults.insert( childId, results );
+      if ( !ok )
+        childFailed( child, childAlg.get() );
 
-      // look through child alg's outputs to determine whether any of these should be copied
-      // to the final model outputs
-      QMap<QString, QgsProcessingModelOutput> outputs = child.modelOutputs();
-      QMap<QString, QgsProcessingModelOutput>::const_iterator outputIt = outputs.constBegin();
-      for ( ; outputIt != outputs.constEnd(); ++outputIt )
+      childExecuted( childId, childAlg.get(), results, childTime, skipGenericLogging );
+      return false;
+    }
+
+    std::unique_ptr< BackgroundChild > backgroundChild = qgis::make_unique< BackgroundChild >();
+    backgroundChild->childId = childId;
+    backgroundChild->context = qgis::make_unique< QgsProcessingContext >();
+    backgroundChild->context->copyThreadSafeSettings( context );
+    backgroundChild->feedback = qgis::make_unique< QgsProcessingRecordingFeedback >();
+    backgroundChild->context->setFeedback( backgroundChild->feedback.get() );
+    if ( feedback )
+      QObject::connect( feedback, &QgsFeedback::canceled, backgroundChild->feedback.get(), &QgsFeedback::cancel, Qt::DirectConnection );
+    backgroundChild->parameters = backgroundParams;
+    backgroundChild->ok = false;
+    backgroundChild->finished = false;
+    backgroundChild->skipGenericLogging = skipGenericLogging;
+    backgroundChild->time = childTime;
+    for ( const StreamedOutput &output : streamedOutputs )
+      backgroundChild->producedPipes.push_back( output.pipe );
+    backgroundChild->consumedPipe = consumedPipe;
+
+    // prepared in the calling thread, as QgsProcessingAlgRunnerTask does
+    if ( !childAlg->prepare( backgroundChild->parameters, *backgroundChild->context, backgroundChild->feedback.get() ) )
+    {
+      if ( feedback )
+        backgroundChild->feedback->replay( feedback );
+      childFailed( child, childAlg.get() );
+    }
+    backgroundChild->algorithm = std::move( childAlg );
+
+    BackgroundChild *run = backgroundChild.get();
+    BackgroundChildren *state = &background;
+    backgroundChild->future = QtConcurrent::run( [run, state]
+    {
+      try
       {
-        finalResults.insert( childId + ':' + outputIt->name(), results.value( outputIt->childOutputName() ) );
+        run->results = run->algorithm->runPrepared( run->parameters, *run->context, run->feedback.get() );
+        run->ok = true;
+      }
+      catch ( QgsProcessingException &e )
+      {
+        run->error = e.what();
       }
 
-      executed.insert( childId );
+      // whatever the outcome, the children at the other end of the pipes of the child stop waiting for it
+      for ( const std::shared_ptr< QgsProcessingFeaturePipe > &pipe : run->producedPipes )
+        pipe->close();
+      if ( run->consumedPipe )
+        run->consumedPipe->release();
+
+      QMutexLocker locker( &state->mutex );
+      run->finished = true;
+      state->finished.wakeAll();
+    } );
+    background.children.push_back( std::move( backgroundChild ) );
+    return true;
+  };
 
-      std::function< void( const QString &, const QString & )> pruneAlgorithmBranchRecursive;
-      pruneAlgorithmBranchRecursive = [&]( const QString & id, const QString &branch = QString() )
-      {
-        const QSet<QString> toPrune = dependentChildAlgorithms( id, branch );
-        for ( const QString &targetId : toPrune )
-        {
-          if ( executed.contains( targetId ) )
-            continue;
+  while ( executed.count() < toExecute.count() )
+  {
+    if ( feedback && feedback->isCanceled() )
+      break;
 
-          executed.insert( targetId );
-          pruneAlgorithmBranchRecursive( targetId, branch );
-        }
-      };
+    // the child algorithms whose dependencies are executed
+    QStringList ready;
+    for ( const QString &childId : qgis::as_const( toExecute ) )
+    {
+      if ( executed.contains( childId ) || started.contains( childId ) )
+        continue;
 
-      // prune remaining algorithms if they are dependent on a branch from this child which didn't eventuate
-      const QgsProcessingOutputDefinitions outputDefs = childAlg->outputDefinitions();
-      for ( const QgsProcessingOutputDefinition *outputDef : outputDefs )
+      bool canExecute = true;
+      const QSet< QString > dependencies = dependsOnChildAlgorithms( childId );
+      for ( const QString &dependency : dependencies )
       {
-        if ( outputDef->type() == QgsProcessingOutputConditionalBranch::typeName() && !results.value( outputDef->name() ).toBool() )
+        if ( !executed.contains( dependency ) )
         {
-          pruneAlgorithmBranchRecursive( childId, outputDef->name() );
+          canExecute = false;
+          break;
         }
       }
 
-      if ( childAlg->flags() & QgsProcessingAlgorithm::FlagPruneModelBranchesBasedOnAlgorithmResults )
+      if ( canExecute )
+        ready << childId;
+    }
+
+    if ( ready.isEmpty() && background.children.empty() )
+      break;
+
+    for ( const QString &childId : qgis::as_const( ready ) )
+    {
+      if ( feedback && feedback->isCanceled() )
+        break;
+
+      // pruned by a child executed before
+      if ( executed.contains( childId ) )
+        continue;
+
+      const QgsProcessingModelChildAlgorithm &child = mChildAlgorithms[ childId ];
+      std::unique_ptr< QgsProcessingAlgorithm > childAlg( child.algorithm()->create( child.configuration() ) );
+
+      // the outputs streamed to the children reading them, which then run alongside the child
+      QList< StreamedOutput > streamedOutputs;
+      if ( maxBackgroundChildren > 1 && !( childAlg->flags() & QgsProcessingAlgorithm::FlagNoThreading ) )
       {
-        // check if any dependent algorithms should be canceled based on the outputs of this algorithm run
-        // first find all direct dependencies of this algorithm by looking through all remaining child algorithms
-        for ( const QString &candidateId : qgis::as_const( toExecute ) )
+        const QList< QPair< QString, QString > > streamable = streamableChildOutputs( childId );
+        for ( const QPair< QString, QString > &output : streamable )
         {
-          if ( executed.contains( candidateId ) )
-            continue;
+          // the child and each of the consumers need their own thread
+          if ( static_cast< int >( background.children.size() ) + streamedOutputs.size() + 2 > maxBackgroundChildren )
+            break;
 
-          // a pending algorithm was found..., check it's parameter sources to see if it links to any of the current
-          // algorithm's outputs
-          const QgsProcessingModelChildAlgorithm &candidate = mChildAlgorithms[ candidateId ];
-          const QMap<QString, QgsProcessingModelChildParameterSources> candidateParams = candidate.parameterSources();
-          QMap<QString, QgsProcessingModelChildParameterSources>::const_iterator paramIt = candidateParams.constBegin();
-          bool pruned = false;
-          for ( ; paramIt != candidateParams.constEnd(); ++paramIt )
+          bool canStream = !started.contains( output.second ) && !executed.contains( output.second );
+          const QSet< QString > dependencies = dependsOnChildAlgorithms( output.second );
+          for ( const QString &dependency : dependencies )
           {
-            for ( const QgsProcessingModelChildParameterSource &source : paramIt.value() )
+            if ( dependency != childId && !executed.contains( dependency ) )
             {
-              if ( source.source() == QgsProcessingModelChildParameterSource::ChildOutput && source.outputChildId() == childId )
-              {
-                // ok, this one is dependent on the current alg. Did we get a value for it?
-                if ( !results.contains( source.outputName() ) )
-                {
-                  // oh no, nothing returned for this parameter. Gotta trim the branch back!
-                  pruned = true;
-                  // skip the dependent alg..
-                  executed.insert( candidateId );
-                  //... and everything which depends on it
-                  pruneAlgorithmBranchRecursive( candidateId, QString() );
-                  break;
-                }
-              }
-            }
-            if ( pruned )
+              canStream = false;
               break;
+            }
           }
+          if ( canStream )
+            streamedOutputs << StreamedOutput { output.first, output.second, QgsProcessingFeaturePipe::create() };
         }
       }
 
-      childAlg.reset( nullptr );
-      modelFeedback.setCurrentStep( executed.count() );
-      if ( feedback && !skipGenericLogging )
-        feedback->pushInfo( QObject::tr( "OK. Execution took %1 s (%2 outputs)." ).arg( childTime.elapsed() / 1000.0 ).arg( results.count() ) );
+      // independent children run in background threads, a single child runs in the calling thread
+      const bool runInBackground = maxBackgroundChildren > 1
+                                   && ( ready.size() > 1 || !background.children.empty() || !streamedOutputs.isEmpty() )
+                                   && !( childAlg->flags() & QgsProcessingAlgorithm::FlagNoThreading );
+      if ( runInBackground && static_cast< int >( background.children.size() ) >= maxBackgroundChildren )
+        continue;
+
+      if ( !startChild( childId, std::move( childAlg ), runInBackground, childResults, streamedOutputs, nullptr ) )
+        continue;
+
+      for ( const StreamedOutput &output : qgis::as_const( streamedOutputs ) )
+      {
+        // the consumer reads the features from a layer of the pipe, once the child opened its sink
+        std::unique_ptr< QgsVectorLayer > layer;
+        if ( output.pipe->waitForOpen( feedback ) )
+        {
+          QgsVectorLayer::LayerOptions options { context.transformContext() };
+          options.loadDefaultStyle = false;
+          options.skipCrsValidation = true;
+          layer = qgis::make_unique< QgsVectorLayer >( output.pipe->id(), output.outputName, QgsProcessingFeaturePipeProvider::providerKey(), options );
+        }
+        if ( !layer || !layer->isValid() )
+        {
+          // the child ended without writing the output, the consumer is run as usual once the child is executed
+          output.pipe->release();
+          continue;
+        }
+
+        const QString layerId = layer->id();
+        context.temporaryLayerStore()->addMapLayer( layer.release() );
+        streamedLayers[ childId ].insert( output.outputName, layerId );
+
+        QVariantMap results = childResults;
+        QVariantMap outputs = results.value( childId ).toMap();
+        outputs.insert( output.outputName, layerId );
+        results.insert( childId, outputs );
+
+        const QgsProcessingModelChildAlgorithm &consumer = mChildAlgorithms[ output.consumerId ];
+        std::unique_ptr< QgsProcessingAlgorithm > consumerAlg( consumer.algorithm()->create( consumer.configuration() ) );
+        startChild( output.consumerId, std::move( consumerAlg ), true, results, QList< StreamedOutput >(), output.pipe );
+      }
     }
 
-    if ( feedback && feedback->isCanceled() )
-      break;
+    if ( background.children.empty() )
+      continue;
+
+    // wait for a background child to finish, reporting the overall progress and the messages of the children meanwhile
+    bool anyFinished = false;
+    while ( !anyFinished )
+    {
+      double progress = executed.count();
+      {
+        QMutexLocker locker( &background.mutex );
+        for ( const std::unique_ptr< BackgroundChild > &backgroundChild : background.children )
+        {
+          anyFinished = anyFinished || backgroundChild->finished;
+          progress += backgroundChild->feedback->progress() / 100.0;
+        }
+        if ( !anyFinished )
+          background.finished.wait( &background.mutex, 100 );
+      }
+      if ( feedback )
+        feedback->setProgress( std::min( 100.0, 100.0 * progress / toExecute.count() ) );
+    }
+
+    std::vector< std::unique_ptr< BackgroundChild > > finished;
+    {
+      QMutexLocker locker( &background.mutex );
+      for ( auto it = background.children.begin(); it != background.children.end(); )
+      {
+        if ( ( *it )->finished )
+        {
+          finished.push_back( std::move( *it ) );
+          it = background.children.erase( it );
+        }
+        else
+        {
+          ++it;
+        }
+      }
+    }
+
+    for ( const std::unique_ptr< BackgroundChild > &backgroundChild : finished )
+    {
+      backgroundChild->future.waitForFinished();
+      const QgsProcessingModelChildAlgorithm &child = mChildAlgorithms[ backgroundChild->childId ];
+      QVariantMap results;
+      if ( backgroundChild->ok && backgroundChild->consumedPipe && backgroundChild->consumedPipe->wasReadAgain() )
+      {
+        backgroundChild->ok = false;
+        backgroundChild->error = QObject::tr( "The streamed input of %1 was read more than once" ).arg( child.description() );
+      }
+      if ( backgroundChild->ok )
+      {
+        // post processed in the calling thread, which takes the temporary layers of the child
+        const QVariantMap ppResults = backgroundChild->algorithm->postProcess( *backgroundChild->context, backgroundChild->feedback.get() );
+        results = !ppResults.isEmpty() ? ppResults : backgroundChild->results;
+        context.takeResultsFrom( *backgroundChild->context );
+
+        // the streamed outputs are referred to by the layers of their pipes
+        const QVariantMap streamed = streamedLayers.value( backgroundChild->childId );
+        for ( auto streamedIt = streamed.constBegin(); streamedIt != streamed.constEnd(); ++streamedIt )
+          results.insert( streamedIt.key(), streamedIt.value() );
+      }
+      else
+      {
+        QgsMessageLog::logMessage( backgroundChild->error, QObject::tr( "Processing" ), Qgis::Critical );
+        backgroundChild->feedback->reportError( backgroundChild->error );
+      }
+
+      if ( feedback )
+        backgroundChild->feedback->replay( feedback );
+
+      if ( !backgroundChild->ok )
+        childFailed( child, backgroundChild->algorithm.get() );
+
+      childExecuted( backgroundChild->childId, backgroundChild->algorithm.get(), results, backgroundChild->time, backgroundChild->skipGenericLogging );
+    }
   }
   if ( feedback )
     feedback->pushDebugInfo( QObject::tr( "Model processed OK. Executed %1 algorithms total in %2 s." ).arg( executed.count() ).arg( totalTime.elapsed() / 1000.0 ) );
@@ -455,6 +772,132 @@ QVariantMap QgsProcessingModelAlgorithm::processAlgorithm( const QVariantMap &pa
   return mResults;
 }
 
+QVariant QgsProcessingModelAlgorithm::resolveTemporaryLayers( const QVariant &value, QgsProcessingContext &context, bool &resolved )
+{
+  if ( value.type() == QVariant::String )
+  {
+    if ( QgsMapLayer *layer = context.temporaryLayerStore()->mapLayer( value.toString() ) )
+      return QVariant::fromValue( layer );
+  }
+  else if ( value.type() == QVariant::List || value.type() == QVariant::StringList )
+  {
+    QVariantList list;
+    bool replaced = false;
+    const QVariantList values = value.toList();
+    for ( const QVariant &v : values )
+    {
+      list << resolveTemporaryLayers( v, context, resolved );
+      replaced = replaced || list.last().userType() != v.userType();
+    }
+    return replaced ? QVariant( list ) : value;
+  }
+  else if ( value.canConvert< QgsProcessingFeatureSourceDefinition >() )
+  {
+    // the source of the definition has to be a string, identifying a layer of the project or a file
+    const QgsProcessingFeatureSourceDefinition definition = value.value< QgsProcessingFeatureSourceDefinition >();
+    if ( definition.source.propertyType() != QgsProperty::StaticProperty || context.temporaryLayerStore()->mapLayer( definition.source.staticValue().toString() ) )
+      resolved = false;
+  }
+  return value;
+}
+
+QList< QPair< QString, QString > > QgsProcessingModelAlgorithm::streamableChildOutputs( const QString &childId ) const
+{
+  QList< QPair< QString, QString > > streamable;
+  const QgsProcessingModelChildAlgorithm child = mChildAlgorithms.value( childId );
+  const QgsProcessingAlgorithm *alg = child.algorithm();
+  // the outputs of a child pruning branches are checked before running the dependent children
+  if ( !alg || alg->flags() & ( QgsProcessingAlgorithm::FlagNoThreading | QgsProcessingAlgorithm::FlagPruneModelBranchesBasedOnAlgorithmResults ) )
+    return streamable;
+
+  const QgsProcessingOutputDefinitions outputDefs = alg->outputDefinitions();
+  for ( const QgsProcessingOutputDefinition *outputDef : outputDefs )
+  {
+    if ( outputDef->type() == QgsProcessingOutputConditionalBranch::typeName() )
+      return streamable;
+  }
+
+  const QgsProcessingParameterDefinitions destinations = alg->destinationParameterDefinitions();
+  for ( const QgsProcessingParameterDefinition *destination : destinations )
+  {
+    const QgsProcessingParameterFeatureSink *sinkParam = dynamic_cast< const QgsProcessingParameterFeatureSink * >( destination );
+    if ( !sinkParam || !sinkParam->supportsNonFileBasedOutput() || child.parameterSources().contains( destination->name() ) )
+      continue;
+
+    // final outputs are written where requested
+    bool isFinalOutput = false;
+    const QMap<QString, QgsProcessingModelOutput> outputs = child.modelOutputs();
+    for ( auto outputIt = outputs.constBegin(); outputIt != outputs.constEnd(); ++outputIt )
+      isFinalOutput = isFinalOutput || outputIt->childOutputName() == destination->name();
+    if ( isFinalOutput )
+      continue;
+
+    // the model variable of the output, which expressions may read
+    QString variableName = QStringLiteral( "%1_%2" ).arg( child.description().isEmpty() ? childId : child.description(), destination->name() );
+    variableName.replace( QRegularExpression( QStringLiteral( "[\\s'\"\\(\\):\\.]" ) ), QStringLiteral( "_" ) );
+
+    // the output has to be the only source of the input of a single feature based child, reading nothing else from the child
+    QString consumerId;
+    int references = 0;
+    bool streamableOutput = true;
+    for ( auto candidateIt = mChildAlgorithms.constBegin(); streamableOutput && candidateIt != mChildAlgorithms.constEnd(); ++candidateIt )
+    {
+      if ( candidateIt->childId() == childId || !candidateIt->isActive() )
+        continue;
+
+      const QMap<QString, QgsProcessingModelChildParameterSources> candidateParams = candidateIt->parameterSources();
+      for ( auto paramIt = candidateParams.constBegin(); paramIt != candidateParams.constEnd(); ++paramIt )
+      {
+        for ( const QgsProcessingModelChildParameterSource &source : paramIt.value() )
+        {
+          if ( ( source.source() == QgsProcessingModelChildParameterSource::Expression && source.expression().contains( variableName ) )
+               || ( source.source() == QgsProcessingModelChildParameterSource::ExpressionText && source.expressionText().contains( variableName ) ) )
+          {
+            streamableOutput = false;
+          }
+          else if ( source.source() == QgsProcessingModelChildParameterSource::ChildOutput && source.outputChildId() == childId && source.outputName() == destination->name() )
+          {
+            references++;
+            streamableOutput = streamableOutput && paramIt.key() == QLatin1String( "INPUT" ) && paramIt.value().size() == 1;
+            consumerId = candidateIt->childId();
+          }
+        }
+      }
+    }
+    if ( !streamableOutput || references != 1 )
+      continue;
+
+    // the consumer cannot wait for the child to be executed
+    const QgsProcessingModelChildAlgorithm consumer = mChildAlgorithms.value( consumerId );
+    int consumerReferences = 0;
+    const QMap<QString, QgsProcessingModelChildParameterSources> consumerParams = consumer.parameterSources();
+    for ( auto paramIt = consumerParams.constBegin(); paramIt != consumerParams.constEnd(); ++paramIt )
+    {
+      for ( const QgsProcessingModelChildParameterSource &source : paramIt.value() )
+      {
+        if ( source.source() == QgsProcessingModelChildParameterSource::ChildOutput && source.outputChildId() == childId )
+          consumerReferences++;
+      }
+    }
+    const QList< QgsProcessingModelChildDependency > dependencies = consumer.dependencies();
+    for ( const QgsProcessingModelChildDependency &dependency : dependencies )
+    {
+      if ( dependency.childId == childId )
+        consumerReferences++;
+    }
+    if ( consumerReferences != 1 )
+      continue;
+
+    const QgsProcessingAlgorithm *consumerAlg = consumer.algorithm();
+    if ( !dynamic_cast< const QgsProcessingFeatureBasedAlgorithm * >( consumerAlg ) || consumerAlg->flags() & QgsProcessingAlgorithm::FlagNoThreading
+         || !dynamic_cast< const QgsProcessingParameterFeatureSource * >( consumerAlg->parameterDefinition( QStringLiteral( "INPUT" ) ) ) )
+      continue;
+
+    streamable << qMakePair( destination->name(), consumerId );
+  }
+  return streamable;
+}
+
 QString QgsProcessingModelAlgorithm::sourceFilePath() const
 {
   return mSourceFile;
@@ -33,6 +33,12 @@
  * \class QgsProcessingModelAlgorithm
  * \ingroup core
  * Model based algorithm with processing.
+ *
+ * Since QGIS 3.16, the child algorithms which do not depend on each other are run
+ * concurrently, in background threads, except those with the FlagNoThreading flag.
+ * A temporary feature sink output which is only read by a feature based child algorithm
+ * is streamed to it through a QgsProcessingFeaturePipe, both children running concurrently.
+ *
   * \since QGIS 3.0
  */
 class CORE_EXPORT QgsProcessingModelAlgorithm : public QgsProcessingAlgorithm
@@ -541,6 +547,23 @@ class CORE_EXPORT QgsProcessingModelAlgorithm : public QgsProcessingAlgorithm
 
     QVariantMap parametersForChildAlgorithm( const QgsProcessingModelChildAlgorithm &child, const QVariantMap &modelParameters, const QVariantMap &results, const QgsExpressionContext &expressionContext ) const;
 
+    /**
+     * Returns the parameter \a value of a child algorithm, with the identifiers of the layers
+     * of the temporary layer store of \a context replaced by the layers themselves, so that the
+     * child algorithm can run with another context. Sets \a resolved to FALSE if \a value
+     * refers to such a layer in a way which cannot be replaced.
+     */
+    static QVariant resolveTemporaryLayers( const QVariant &value, QgsProcessingContext &context, bool &resolved );
+
+    /**
+     * Returns the temporary feature sink outputs of child \a childId which can be streamed
+     * to the child algorithm reading them while child \a childId writes them, as pairs
+     * of output name and id of the reading child. The reading child has to be a
+     * QgsProcessingFeatureBasedAlgorithm reading nothing else from child \a childId,
+     * and no other child may refer to the outputs.
+     */
+    QList< QPair< QString, QString > > streamableChildOutputs( const QString &childId ) const;
+
     /**
      * Returns TRUE if an output from a child algorithm is required elsewhere in
      * the model.
@@ -30,6 +30,13 @@
 #include "qgsmeshlayer.h"
 #include "qgsexpressioncontextutils.h"
 
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
+#include <vector>
+
 
 QgsProcessingAlgorithm::~QgsProcessingAlgorithm()
 {
@@ -917,6 +924,11 @@ QgsFeatureSink::SinkFlags QgsProcessingFeatureBasedAlgorithm::sinkFlags() const
   return nullptr;
 }
 
+bool QgsProcessingFeatureBasedAlgorithm::preservesFeatureOrder() const
+{
+  return true;
+}
+
 QgsWkbTypes::Type QgsProcessingFeatureBasedAlgorithm::outputWkbType( QgsWkbTypes::Type inputWkbType ) const
 {
   return inputWkbType;
@@ -968,22 +980,29 @@ QVariantMap QgsProcessingFeatureBasedAlgorithm::processAlgorithm( const QVariant
   QgsFeature f;
   QgsFeatureIterator it = mSource->getFeatures( request(), sourceFlags() );
 
-  double step = count > 0 ? 100.0 / count : 1;
-  int current = 0;
-  while ( it.nextFeature( f ) )
+  if ( ( flags() & FlagSupportsParallelFeatureProcessing ) && QThreadPool::globalInstance()->maxThreadCount() > 1 )
   {
-    if ( feedback->isCanceled() )
+    processFeaturesInParallel( it, sink.get(), count, context, feedback );
+  }
+  else
+  {
+    double step = count > 0 ? 100.0 / count : 1;
+    int current = 0;
+    while ( it.nextFeature( f ) )
     {
-      break;
-    }
+      if ( feedback->isCanceled() )
+      {
+        break;
+      }
 
-    context.expressionContext().setFeature( f );
-    const QgsFeatureList transformed = processFeature( f, context, feedback );
-    for ( QgsFeature transformedFeature : transformed )
-      sink->addFeature( transformedFeature, QgsFeatureSink::FastInsert );
+      context.expressionContext().setFeature( f );
+      const QgsFeatureList transformed = processFeature( f, context, feedback );
+      for ( QgsFeature transformedFeature : transformed )
+        sink->addFeature( transformedFeature, QgsFeatureSink::FastInsert );
 
-    feedback->setProgress( current * step );
-    current++;
+      feedback->setProgress( current * step );
+      current++;
+    }
   }
 
   mSource.reset();
@@ -996,6 +1015,131 @@ QVariantMap QgsProcessingFeatureBasedAlgorithm::processAlgorithm( const QVariant
   return outputs;
 }
 
+void QgsProcessingFeatureBasedAlgorithm::processFeaturesInParallel( QgsFeatureIterator &iterator, QgsFeatureSink *sink, long count, QgsProcessingContext &context, QgsProcessingFeedback *feedback )
+{
+  // each thread processes features with its own context and feedback, taken from the free workers
+  struct Worker
+  {
+    QgsProcessingContext context;
+    QgsProcessingRecordingFeedback feedback;
+  };
+
+  struct Item
+  {
+    QgsFeature feature;
+    QgsFeatureList outputs;
+  };
+
+  struct Chunk
+  {
+    std::size_t begin;
+    std::size_t end;
+  };
+
+  const int threadCount = QThreadPool::globalInstance()->maxThreadCount();
+  // the calling thread also processes chunks
+  std::vector< std::unique_ptr< Worker > > workers;
+  QList< Worker * > freeWorkers;
+  for ( int i = 0; i <= threadCount; ++i )
+  {
+    workers.emplace_back( qgis::make_unique< Worker >() );
+    workers.back()->context.copyThreadSafeSettings( context );
+    workers.back()->context.setFeedback( &workers.back()->feedback );
+    QObject::connect( feedback, &QgsFeedback::canceled, &workers.back()->feedback, &QgsFeedback::cancel, Qt::DirectConnection );
+    freeWorkers << workers.back().get();
+  }
+
+  const bool ordered = preservesFeatureOrder();
+  QMutex mutex;
+  QString error;
+  QAtomicInt failed( 0 );
+  std::vector< Item > items;
+
+  auto processChunk = [&]( const Chunk & chunk )
+  {
+    Worker *worker = nullptr;
+    {
+      QMutexLocker locker( &mutex );
+      worker = freeWorkers.takeLast();
+    }
+
+    for ( std::size_t i = chunk.begin; i < chunk.end && !feedback->isCanceled() && !failed.loadAcquire(); ++i )
+    {
+      Item &item = items[ i ];
+      worker->context.expressionContext().setFeature( item.feature );
+      try
+      {
+        item.outputs = processFeature( item.feature, worker->context, &worker->feedback );
+      }
+      catch ( QgsException &e )
+      {
+        // rethrown from the calling thread, once the chunks being processed are done
+        QMutexLocker locker( &mutex );
+        if ( error.isEmpty() )
+          error = e.what();
+        failed.storeRelease( 1 );
+        break;
+      }
+
+      if ( !ordered )
+      {
+        QMutexLocker locker( &mutex );
+        for ( QgsFeature outputFeature : qgis::as_const( item.outputs ) )
+          sink->addFeature( outputFeature, QgsFeatureSink::FastInsert );
+        item.outputs.clear();
+      }
+    }
+
+    QMutexLocker locker( &mutex );
+    freeWorkers << worker;
+  };
+
+  const std::size_t chunkSize = PARALLEL_FEATURES_PER_THREAD / 4;
+  const std::size_t batchSize = static_cast< std::size_t >( PARALLEL_FEATURES_PER_THREAD ) * threadCount;
+  const double step = count > 0 ? 100.0 / count : 1;
+  long current = 0;
+  QgsFeature f;
+  std::vector< Chunk > chunks;
+  bool finished = false;
+  while ( !finished && !feedback->isCanceled() )
+  {
+    // the features are read from the calling thread, the iterator not being thread safe
+    items.clear();
+    while ( items.size() < batchSize )
+    {
+      if ( !iterator.nextFeature( f ) )
+      {
+        finished = true;
+        break;
+      }
+      items.push_back( { f, QgsFeatureList() } );
+    }
+
+    chunks.clear();
+    for ( std::size_t begin = 0; begin < items.size(); begin += chunkSize )
+      chunks.push_back( { begin, std::min( begin + chunkSize, items.size() ) } );
+    QtConcurrent::blockingMap( chunks, processChunk );
+
+    for ( const std::unique_ptr< Worker > &worker : workers )
+      worker->feedback.replay( feedback );
+
+    if ( !error.isEmpty() )
+      throw QgsProcessingException( error );
+
+    if ( ordered )
+    {
+      for ( const Item &item : items )
+      {
+        for ( QgsFeature outputFeature : item.outputs )
+          sink->addFeature( outputFeature, QgsFeatureSink::FastInsert );
+      }
+    }
+
+    current += static_cast< long >( items.size() );
+    feedback->setProgress( current * step );
+  }
+}
+
 QgsFeatureRequest QgsProcessingFeatureBasedAlgorithm::request() const
 {
   return QgsFeatureRequest();
@@ -81,6 +81,7 @@ class CORE_EXPORT QgsProcessingAlgorithm
       FlagSkipGenericModelLogging = 1 << 12, //!< When running as part of a model, the generic algorithm setup and results logging should be skipped
       FlagNotAvailableInStandaloneTool = 1 << 13, //!< Algorithm should not be available from the standalone "qgis_process" tool. Used to flag algorithms which make no sense outside of the QGIS application, such as "select by..." style algorithms.
       FlagRequiresProject = 1 << 14, //!< The algorithm requires that a valid QgsProject is available from the processing context in order to execute
+      FlagSupportsParallelFeatureProcessing = 1 << 15, //!< Feature based algorithm whose processFeature() is thread safe, so that the features of its source can be processed in parallel. Since QGIS 3.16
       FlagDeprecated = FlagHideFromToolbox | FlagHideFromModeler, //!< Algorithm is deprecated
     };
     Q_DECLARE_FLAGS( Flags, Flag )
@@ -1078,6 +1079,10 @@ class CORE_EXPORT QgsProcessingFeatureBasedAlgorithm : public QgsProcessingAlgor
      * prevent the algorithm execution from continuing. This can be annoying for users though as it
      * can break valid model execution - so use with extreme caution, and consider using
      * \a feedback to instead report non-fatal processing failures for features instead.
+     *
+     * If the algorithm has the FlagSupportsParallelFeatureProcessing flag, this method is called
+     * from several threads at once, each with its own \a context and \a feedback. It must then not
+     * modify the algorithm, the messages pushed to \a feedback being reported by the calling thread.
      */
     virtual QgsFeatureList processFeature( const QgsFeature &feature, QgsProcessingContext &context, QgsProcessingFeedback *feedback ) SIP_THROW( QgsProcessingException ) = 0 SIP_VIRTUALERRORHANDLER( processing_exception_handler );
 
@@ -1135,6 +1140,18 @@ class CORE_EXPORT QgsProcessingFeatureBasedAlgorithm : public QgsProcessingAlgor
      */
     virtual QgsFeatureSink::SinkFlags sinkFlags() const;
 
+    /**
+     * Returns TRUE if the output features have to be added to the sink in the order of the
+     * input features, when they are processed in parallel (see FlagSupportsParallelFeatureProcessing).
+     * Otherwise the output features are added to the sink as soon as they are created, from
+     * the thread processing them, one thread at a time.
+     *
+     * The default implementation returns TRUE.
+     *
+     * \since QGIS 3.16
+     */
+    virtual bool preservesFeatureOrder() const;
+
     /**
      * Maps the input WKB geometry type (\a inputWkbType) to the corresponding
      * output WKB type generated by the algorithm. The default behavior is that the algorithm maintains
@@ -1212,6 +1229,15 @@ class CORE_EXPORT QgsProcessingFeatureBasedAlgorithm : public QgsProcessingAlgor
 
   private:
 
+    /**
+     * Processes in parallel the features of \a iterator, adding the output features to \a sink.
+     * \a count is the number of features of the source, for progress reports.
+     */
+    void processFeaturesInParallel( QgsFeatureIterator &iterator, QgsFeatureSink *sink, long count, QgsProcessingContext &context, QgsProcessingFeedback *feedback );
+
+    //! Number of features processed in parallel by each thread, between two progress reports
+    static const int PARALLEL_FEATURES_PER_THREAD = 256;
+
     std::unique_ptr< QgsProcessingFeatureSource > mSource;
 
 };
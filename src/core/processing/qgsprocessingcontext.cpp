@@ -23,6 +23,7 @@
 QgsProcessingContext::QgsProcessingContext()
   : mPreferredVectorFormat( QgsProcessingUtils::defaultVectorExtension() )
   , mPreferredRasterFormat( QgsProcessingUtils::defaultRasterExtension() )
+  , mMemoryOutputBudget( QgsSettings().value( QStringLiteral( "Processing/Configuration/MEMORY_OUTPUT_BUDGET" ), 0 ).toLongLong() * 1024 * 1024 )
 {
   auto callback = [ = ]( const QgsFeature & feature )
   {
@@ -80,6 +80,7 @@ class CORE_EXPORT QgsProcessingContext
       mFeedback = other.mFeedback;
       mPreferredVectorFormat = other.mPreferredVectorFormat;
       mPreferredRasterFormat = other.mPreferredRasterFormat;
+      mMemoryOutputBudget = other.mMemoryOutputBudget;
       mEllipsoid = other.mEllipsoid;
       mDistanceUnit = other.mDistanceUnit;
       mAreaUnit = other.mAreaUnit;
@@ -608,6 +609,26 @@ class CORE_EXPORT QgsProcessingContext
      */
     void setPreferredRasterFormat( const QString &format ) { mPreferredRasterFormat = format; }
 
+    /**
+     * Returns the maximum size in bytes of the features of each memory layer output, beyond which
+     * the layer is written to a temporary GeoPackage instead, or 0 if memory layer outputs are not limited.
+     *
+     * It defaults to the "Processing/Configuration/MEMORY_OUTPUT_BUDGET" setting, in megabytes.
+     *
+     * \see setMemoryOutputBudget()
+     * \since QGIS 3.16
+     */
+    qint64 memoryOutputBudget() const { return mMemoryOutputBudget; }
+
+    /**
+     * Sets the maximum size in bytes of the features of each memory layer output, beyond which
+     * the layer is written to a temporary GeoPackage instead. A \a budget of 0 does not limit memory layer outputs.
+     *
+     * \see memoryOutputBudget()
+     * \since QGIS 3.16
+     */
+    void setMemoryOutputBudget( qint64 budget ) { mMemoryOutputBudget = budget; }
+
   private:
 
     QgsProcessingContext::Flags mFlags = QgsProcessingContext::Flags();
@@ -632,6 +653,8 @@ class CORE_EXPORT QgsProcessingContext
     QString mPreferredVectorFormat;
     QString mPreferredRasterFormat;
 
+    qint64 mMemoryOutputBudget = 0;
+
 #ifdef SIP_RUN
     QgsProcessingContext( const QgsProcessingContext &other );
 #endif
@@ -0,0 +1,437 @@
+/***************************************************************************
+                         qgsprocessingfeaturepipe.cpp
+                         ----------------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsprocessingfeaturepipe.h"
+#include "qgsexception.h"
+#include "qgsfeedback.h"
+#include "qgsgeometry.h"
+#include "qgslogger.h"
+
+#include <QHash>
+#include <QMutexLocker>
+#include <QUuid>
+
+///@cond PRIVATE
+
+static QMutex sPipesMutex;
+
+static QHash< QString, std::weak_ptr< QgsProcessingFeaturePipe > > &pipes()
+{
+  static QHash< QString, std::weak_ptr< QgsProcessingFeaturePipe > > sPipes;
+  return sPipes;
+}
+
+QgsProcessingFeaturePipe::QgsProcessingFeaturePipe( int capacity )
+  : mId( QUuid::createUuid().toString().mid( 1, 36 ) )
+  , mCapacity( std::max( 1, capacity ) )
+{
+}
+
+std::shared_ptr< QgsProcessingFeaturePipe > QgsProcessingFeaturePipe::create( int capacity )
+{
+  std::shared_ptr< QgsProcessingFeaturePipe > pipe( new QgsProcessingFeaturePipe( capacity ) );
+  QMutexLocker locker( &sPipesMutex );
+  pipes().insert( pipe->id(), pipe );
+  return pipe;
+}
+
+std::shared_ptr< QgsProcessingFeaturePipe > QgsProcessingFeaturePipe::pipe( const QString &id )
+{
+  QMutexLocker locker( &sPipesMutex );
+  return pipes().value( id ).lock();
+}
+
+QgsProcessingFeaturePipe::~QgsProcessingFeaturePipe()
+{
+  QMutexLocker locker( &sPipesMutex );
+  pipes().remove( mId );
+}
+
+QString QgsProcessingFeaturePipe::destination() const
+{
+  return QStringLiteral( "pipe:%1" ).arg( mId );
+}
+
+void QgsProcessingFeaturePipe::open( const QgsFields &fields, QgsWkbTypes::Type wkbType, const QgsCoordinateReferenceSystem &crs )
+{
+  QMutexLocker locker( &mMutex );
+  if ( mOpen || mClosed )
+    return;
+
+  mFields = fields;
+  mWkbType = wkbType;
+  mCrs = crs;
+  mOpen = true;
+  mChanged.wakeAll();
+}
+
+bool QgsProcessingFeaturePipe::addFeature( QgsFeature &feature )
+{
+  QMutexLocker locker( &mMutex );
+  if ( !mOpen || mClosed )
+    return false;
+
+  while ( !mReleased && !mUnbounded && mFeatures.size() >= mCapacity )
+    mChanged.wait( &mMutex );
+
+  feature.setId( mFeatureCount++ );
+  if ( feature.hasGeometry() )
+    mExtent.combineExtentWith( feature.geometry().boundingBox() );
+
+  // the consumer does not need the features anymore
+  if ( mReleased )
+    return true;
+
+  QgsFeature queued = feature;
+  if ( queued.attributes().count() != mFields.count() )
+  {
+    QgsAttributes attributes = queued.attributes();
+    attributes.resize( mFields.count() );
+    queued.setAttributes( attributes );
+  }
+  mFeatures.enqueue( queued );
+  mChanged.wakeAll();
+  return true;
+}
+
+void QgsProcessingFeaturePipe::close()
+{
+  QMutexLocker locker( &mMutex );
+  mClosed = true;
+  mChanged.wakeAll();
+}
+
+bool QgsProcessingFeaturePipe::waitForOpen( QgsFeedback *feedback )
+{
+  QMutexLocker locker( &mMutex );
+  while ( !mOpen && !mClosed )
+  {
+    if ( feedback && feedback->isCanceled() )
+      return false;
+    mChanged.wait( &mMutex, 100 );
+  }
+  return mOpen;
+}
+
+bool QgsProcessingFeaturePipe::isOpen() const
+{
+  QMutexLocker locker( &mMutex );
+  return mOpen;
+}
+
+QgsFields QgsProcessingFeaturePipe::fields() const
+{
+  QMutexLocker locker( &mMutex );
+  return mFields;
+}
+
+QgsWkbTypes::Type QgsProcessingFeaturePipe::wkbType() const
+{
+  QMutexLocker locker( &mMutex );
+  return mWkbType;
+}
+
+QgsCoordinateReferenceSystem QgsProcessingFeaturePipe::crs() const
+{
+  QMutexLocker locker( &mMutex );
+  return mCrs;
+}
+
+bool QgsProcessingFeaturePipe::nextFeature( QgsFeature &feature )
+{
+  QMutexLocker locker( &mMutex );
+  while ( mFeatures.isEmpty() && !mClosed && !mReleased )
+    mChanged.wait( &mMutex );
+
+  if ( mFeatures.isEmpty() )
+    return false;
+
+  feature = mFeatures.dequeue();
+  mChanged.wakeAll();
+  return true;
+}
+
+bool QgsProcessingFeaturePipe::claim( const void *reader )
+{
+  QMutexLocker locker( &mMutex );
+  if ( !mReader )
+    mReader = reader;
+  else if ( mReader != reader )
+    mReadAgain = true;
+  return mReader == reader;
+}
+
+bool QgsProcessingFeaturePipe::wasReadAgain() const
+{
+  QMutexLocker locker( &mMutex );
+  return mReadAgain;
+}
+
+void QgsProcessingFeaturePipe::release()
+{
+  QMutexLocker locker( &mMutex );
+  mReleased = true;
+  mFeatures.clear();
+  mChanged.wakeAll();
+}
+
+long QgsProcessingFeaturePipe::featureCount() const
+{
+  QMutexLocker locker( &mMutex );
+  return mClosed ? mFeatureCount : static_cast< long >( QgsVectorDataProvider::UnknownCount );
+}
+
+QgsRectangle QgsProcessingFeaturePipe::extent()
+{
+  QMutexLocker locker( &mMutex );
+  // the features keep on being queued until the consumer reads them, so that the producer can finish
+  mUnbounded = true;
+  mChanged.wakeAll();
+  while ( !mClosed )
+    mChanged.wait( &mMutex );
+  return mExtent;
+}
+
+//
+// QgsProcessingFeaturePipeSink
+//
+
+QgsProcessingFeaturePipeSink::QgsProcessingFeaturePipeSink( const std::shared_ptr< QgsProcessingFeaturePipe > &pipe )
+  : mPipe( pipe )
+{
+}
+
+QgsProcessingFeaturePipeSink::~QgsProcessingFeaturePipeSink()
+{
+  mPipe->close();
+}
+
+bool QgsProcessingFeaturePipeSink::addFeature( QgsFeature &feature, QgsFeatureSink::Flags )
+{
+  return mPipe->addFeature( feature );
+}
+
+bool QgsProcessingFeaturePipeSink::addFeatures( QgsFeatureList &features, QgsFeatureSink::Flags )
+{
+  bool result = true;
+  for ( QgsFeature &feature : features )
+    result = mPipe->addFeature( feature ) && result;
+  return result;
+}
+
+//
+// QgsProcessingFeaturePipeFeatureSource
+//
+
+QgsProcessingFeaturePipeFeatureSource::QgsProcessingFeaturePipeFeatureSource( const std::shared_ptr< QgsProcessingFeaturePipe > &pipe )
+  : mPipe( pipe )
+{
+}
+
+QgsFeatureIterator QgsProcessingFeaturePipeFeatureSource::getFeatures( const QgsFeatureRequest &request )
+{
+  if ( !mPipe )
+    return QgsFeatureIterator();
+
+  return QgsFeatureIterator( new QgsProcessingFeaturePipeFeatureIterator( this, false, request ) );
+}
+
+//
+// QgsProcessingFeaturePipeFeatureIterator
+//
+
+QgsProcessingFeaturePipeFeatureIterator::QgsProcessingFeaturePipeFeatureIterator( QgsProcessingFeaturePipeFeatureSource *source, bool ownSource, const QgsFeatureRequest &request )
+  : QgsAbstractFeatureIteratorFromSource<QgsProcessingFeaturePipeFeatureSource>( source, ownSource, request )
+{
+  const QgsCoordinateReferenceSystem crs = mSource->mPipe->crs();
+  if ( mRequest.destinationCrs().isValid() && mRequest.destinationCrs() != crs )
+  {
+    mTransform = QgsCoordinateTransform( crs, mRequest.destinationCrs(), mRequest.transformContext() );
+  }
+  try
+  {
+    mFilterRect = filterRectToSourceCrs( mTransform );
+  }
+  catch ( QgsCsException & )
+  {
+    // can't reproject mFilterRect
+    close();
+    return;
+  }
+}
+
+QgsProcessingFeaturePipeFeatureIterator::~QgsProcessingFeaturePipeFeatureIterator()
+{
+  close();
+}
+
+bool QgsProcessingFeaturePipeFeatureIterator::fetchFeature( QgsFeature &feature )
+{
+  feature.setValid( false );
+
+  if ( mClosed )
+    return false;
+
+  // the features are streamed once, to the first iterator reading them
+  if ( !mSource->mPipe->claim( this ) )
+  {
+    QgsDebugMsg( QStringLiteral( "The features of pipe %1 were already read" ).arg( mSource->mPipe->id() ) );
+    close();
+    return false;
+  }
+
+  QgsFeature candidate;
+  while ( mSource->mPipe->nextFeature( candidate ) )
+  {
+    if ( mRequest.filterType() == QgsFeatureRequest::FilterFid && candidate.id() != mRequest.filterFid() )
+      continue;
+    if ( mRequest.filterType() == QgsFeatureRequest::FilterFids && !mRequest.filterFids().contains( candidate.id() ) )
+      continue;
+    if ( !mFilterRect.isNull() )
+    {
+      if ( !candidate.hasGeometry() )
+        continue;
+      if ( mRequest.flags() & QgsFeatureRequest::ExactIntersect )
+      {
+        if ( !candidate.geometry().intersects( mFilterRect ) )
+          continue;
+      }
+      else if ( !candidate.geometry().boundingBoxIntersects( mFilterRect ) )
+      {
+        continue;
+      }
+    }
+
+    feature = candidate;
+    feature.setFields( mSource->mPipe->fields() ); // allow name-based attribute lookups
+    feature.setValid( true );
+    geometryToDestinationCrs( feature, mTransform );
+    return true;
+  }
+
+  close();
+  return false;
+}
+
+bool QgsProcessingFeaturePipeFeatureIterator::rewind()
+{
+  // the features which were read are gone
+  return false;
+}
+
+bool QgsProcessingFeaturePipeFeatureIterator::close()
+{
+  if ( mClosed )
+    return false;
+
+  iteratorClosed();
+
+  mClosed = true;
+  return true;
+}
+
+//
+// QgsProcessingFeaturePipeProvider
+//
+
+QgsProcessingFeaturePipeProvider::QgsProcessingFeaturePipeProvider( const QString &uri, const QgsDataProvider::ProviderOptions &providerOptions )
+  : QgsVectorDataProvider( uri, providerOptions )
+  , mPipe( QgsProcessingFeaturePipe::pipe( uri ) )
+{
+  if ( mPipe )
+    mPipe->waitForOpen();
+}
+
+QString QgsProcessingFeaturePipeProvider::providerKey()
+{
+  return QStringLiteral( "processingpipe" );
+}
+
+QString QgsProcessingFeaturePipeProvider::providerDescription()
+{
+  return QStringLiteral( "Processing feature pipe provider" );
+}
+
+QgsProcessingFeaturePipeProvider *QgsProcessingFeaturePipeProvider::createProvider( const QString &uri, const QgsDataProvider::ProviderOptions &providerOptions )
+{
+  return new QgsProcessingFeaturePipeProvider( uri, providerOptions );
+}
+
+QgsAbstractFeatureSource *QgsProcessingFeaturePipeProvider::featureSource() const
+{
+  return new QgsProcessingFeaturePipeFeatureSource( mPipe );
+}
+
+QString QgsProcessingFeaturePipeProvider::storageType() const
+{
+  return QStringLiteral( "Processing feature pipe" );
+}
+
+QgsFeatureIterator QgsProcessingFeaturePipeProvider::getFeatures( const QgsFeatureRequest &request ) const
+{
+  if ( !mPipe )
+    return QgsFeatureIterator();
+
+  return QgsFeatureIterator( new QgsProcessingFeaturePipeFeatureIterator( new QgsProcessingFeaturePipeFeatureSource( mPipe ), true, request ) );
+}
+
+QgsWkbTypes::Type QgsProcessingFeaturePipeProvider::wkbType() const
+{
+  return mPipe ? mPipe->wkbType() : QgsWkbTypes::Unknown;
+}
+
+long QgsProcessingFeaturePipeProvider::featureCount() const
+{
+  return mPipe ? mPipe->featureCount() : 0;
+}
+
+QgsFields QgsProcessingFeaturePipeProvider::fields() const
+{
+  return mPipe ? mPipe->fields() : QgsFields();
+}
+
+QgsVectorDataProvider::Capabilities QgsProcessingFeaturePipeProvider::capabilities() const
+{
+  return QgsVectorDataProvider::NoCapabilities;
+}
+
+QString QgsProcessingFeaturePipeProvider::name() const
+{
+  return providerKey();
+}
+
+QString QgsProcessingFeaturePipeProvider::description() const
+{
+  return providerDescription();
+}
+
+QgsRectangle QgsProcessingFeaturePipeProvider::extent() const
+{
+  return mPipe ? mPipe->extent() : QgsRectangle();
+}
+
+bool QgsProcessingFeaturePipeProvider::isValid() const
+{
+  return mPipe && mPipe->isOpen();
+}
+
+QgsCoordinateReferenceSystem QgsProcessingFeaturePipeProvider::crs() const
+{
+  return mPipe ? mPipe->crs() : QgsCoordinateReferenceSystem();
+}
+
+///@endcond
@@ -0,0 +1,262 @@
+/***************************************************************************
+                         qgsprocessingfeaturepipe.h
+                         --------------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSPROCESSINGFEATUREPIPE_H
+#define QGSPROCESSINGFEATUREPIPE_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+#include "qgscoordinatereferencesystem.h"
+#include "qgscoordinatetransform.h"
+#include "qgsfeatureiterator.h"
+#include "qgsfeaturesink.h"
+#include "qgsfields.h"
+#include "qgsrectangle.h"
+#include "qgsvectordataprovider.h"
+
+#include <QMutex>
+#include <QQueue>
+#include <QWaitCondition>
+
+#include <memory>
+
+class QgsFeedback;
+
+///@cond PRIVATE
+
+/**
+ * \ingroup core
+ * \class QgsProcessingFeaturePipe
+ * \brief A bounded queue of features, written by a producer thread and read once by a consumer thread.
+ *
+ * QgsProcessingModelAlgorithm streams through a pipe the feature sink output of a child algorithm
+ * which is only read by a feature based child algorithm, so that both children run concurrently and
+ * the output is never held in full in a memory layer. The producer writes to the pipe through the
+ * sink QgsProcessingUtils::createFeatureSink() returns for a "pipe:" destination, and the consumer
+ * reads it through a vector layer of the QgsProcessingFeaturePipeProvider provider.
+ *
+ * The producer blocks while capacity() features are waiting to be read. The features can only be read
+ * once, by a single iterator: extent() waits for the producer to close the pipe, and lifts the bound
+ * meanwhile. The features added once the consumer released the pipe are discarded.
+ *
+ * Pipes are shared by the model, the sink and the provider, and are found from their id() by pipe().
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.16
+ */
+class CORE_EXPORT QgsProcessingFeaturePipe
+{
+  public:
+
+    //! Creates a pipe holding up to \a capacity features, and registers it for pipe()
+    static std::shared_ptr< QgsProcessingFeaturePipe > create( int capacity = DEFAULT_CAPACITY );
+
+    //! Returns the registered pipe with the matching \a id, or NULLPTR if it was destroyed
+    static std::shared_ptr< QgsProcessingFeaturePipe > pipe( const QString &id );
+
+    ~QgsProcessingFeaturePipe();
+
+    //! Returns the unique id of the pipe
+    QString id() const { return mId; }
+
+    //! Returns the sink destination string writing to the pipe
+    QString destination() const;
+
+    //! Returns the maximum number of features waiting to be read
+    int capacity() const { return mCapacity; }
+
+    /**
+     * Opens the pipe for features with the \a fields, \a wkbType and \a crs, called by the producer
+     * when it creates its sink.
+     */
+    void open( const QgsFields &fields, QgsWkbTypes::Type wkbType, const QgsCoordinateReferenceSystem &crs );
+
+    /**
+     * Adds a \a feature to the pipe, blocking while the pipe is full. The id of the feature
+     * is set to its position in the pipe. Returns FALSE if the pipe is not open.
+     */
+    bool addFeature( QgsFeature &feature );
+
+    //! Closes the pipe once the producer has added all its features, it is safe to call it several times
+    void close();
+
+    /**
+     * Waits for the producer to open the pipe. Returns FALSE if the pipe was closed without being
+     * opened, or if \a feedback was canceled meanwhile.
+     */
+    bool waitForOpen( QgsFeedback *feedback = nullptr );
+
+    //! Returns TRUE if the pipe was opened
+    bool isOpen() const;
+
+    //! Returns the fields of the features, once the pipe is open
+    QgsFields fields() const;
+
+    //! Returns the geometry type of the features, once the pipe is open
+    QgsWkbTypes::Type wkbType() const;
+
+    //! Returns the crs of the features, once the pipe is open
+    QgsCoordinateReferenceSystem crs() const;
+
+    /**
+     * Reads into \a feature the next feature, blocking until the producer adds it or closes the pipe.
+     * Returns FALSE once all the features are read.
+     */
+    bool nextFeature( QgsFeature &feature );
+
+    /**
+     * Claims the stream for the reader \a reader. Returns FALSE if another reader already claimed it,
+     * the features being read only once, which is then reported by wasReadAgain().
+     */
+    bool claim( const void *reader );
+
+    //! Returns TRUE if a reader tried reading the features after another one
+    bool wasReadAgain() const;
+
+    //! Releases the pipe once the consumer has read what it needed, the producer no longer blocks
+    void release();
+
+    //! Returns the number of features added, or QgsVectorDataProvider::UnknownCount until the pipe is closed
+    long featureCount() const;
+
+    //! Returns the extent of all the features, waiting for the producer to close the pipe
+    QgsRectangle extent();
+
+    //! Default value of capacity()
+    static const int DEFAULT_CAPACITY = 4096;
+
+  private:
+
+    explicit QgsProcessingFeaturePipe( int capacity );
+
+    QString mId;
+    int mCapacity = DEFAULT_CAPACITY;
+
+    mutable QMutex mMutex;
+    QWaitCondition mChanged;
+    QQueue< QgsFeature > mFeatures;
+    QgsFields mFields;
+    QgsWkbTypes::Type mWkbType = QgsWkbTypes::Unknown;
+    QgsCoordinateReferenceSystem mCrs;
+    QgsRectangle mExtent;
+    long mFeatureCount = 0;
+    bool mOpen = false;
+    bool mClosed = false;
+    bool mReleased = false;
+    bool mUnbounded = false;
+    const void *mReader = nullptr;
+    bool mReadAgain = false;
+};
+
+/**
+ * \ingroup core
+ * \class QgsProcessingFeaturePipeSink
+ * \brief A feature sink adding the features to a QgsProcessingFeaturePipe, closing it when destroyed.
+ * \note not available in Python bindings
+ * \since QGIS 3.16
+ */
+class CORE_EXPORT QgsProcessingFeaturePipeSink : public QgsFeatureSink
+{
+  public:
+
+    //! Constructor for QgsProcessingFeaturePipeSink, writing to \a pipe
+    explicit QgsProcessingFeaturePipeSink( const std::shared_ptr< QgsProcessingFeaturePipe > &pipe );
+    ~QgsProcessingFeaturePipeSink() override;
+
+    bool addFeature( QgsFeature &feature, QgsFeatureSink::Flags flags = QgsFeatureSink::Flags() ) override;
+    bool addFeatures( QgsFeatureList &features, QgsFeatureSink::Flags flags = QgsFeatureSink::Flags() ) override;
+
+  private:
+
+    std::shared_ptr< QgsProcessingFeaturePipe > mPipe;
+};
+
+class QgsProcessingFeaturePipeFeatureSource final : public QgsAbstractFeatureSource
+{
+  public:
+    explicit QgsProcessingFeaturePipeFeatureSource( const std::shared_ptr< QgsProcessingFeaturePipe > &pipe );
+
+    QgsFeatureIterator getFeatures( const QgsFeatureRequest &request ) override;
+
+  private:
+    std::shared_ptr< QgsProcessingFeaturePipe > mPipe;
+
+    friend class QgsProcessingFeaturePipeFeatureIterator;
+};
+
+class QgsProcessingFeaturePipeFeatureIterator final : public QgsAbstractFeatureIteratorFromSource<QgsProcessingFeaturePipeFeatureSource>
+{
+  public:
+    QgsProcessingFeaturePipeFeatureIterator( QgsProcessingFeaturePipeFeatureSource *source, bool ownSource, const QgsFeatureRequest &request );
+    ~QgsProcessingFeaturePipeFeatureIterator() override;
+
+    bool rewind() override;
+    bool close() override;
+
+  protected:
+    bool fetchFeature( QgsFeature &feature ) override;
+
+  private:
+    QgsRectangle mFilterRect;
+    QgsCoordinateTransform mTransform;
+};
+
+/**
+ * \ingroup core
+ * \class QgsProcessingFeaturePipeProvider
+ * \brief A read only vector data provider reading once the features of the QgsProcessingFeaturePipe
+ * whose id is the uri.
+ *
+ * The provider waits for the producer to open the pipe when created.
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.16
+ */
+class CORE_EXPORT QgsProcessingFeaturePipeProvider final : public QgsVectorDataProvider
+{
+    Q_OBJECT
+
+  public:
+    explicit QgsProcessingFeaturePipeProvider( const QString &uri, const QgsDataProvider::ProviderOptions &providerOptions );
+
+    static QString providerKey();
+    static QString providerDescription();
+
+    //! Creates a new pipe provider, reading from the pipe whose id is \a uri
+    static QgsProcessingFeaturePipeProvider *createProvider( const QString &uri, const QgsDataProvider::ProviderOptions &providerOptions );
+
+    QgsAbstractFeatureSource *featureSource() const override;
+    QString storageType() const override;
+    QgsFeatureIterator getFeatures( const QgsFeatureRequest &request ) const override;
+    QgsWkbTypes::Type wkbType() const override;
+    long featureCount() const override;
+    QgsFields fields() const override;
+    QgsVectorDataProvider::Capabilities capabilities() const override;
+    QString name() const override;
+    QString description() const override;
+    QgsRectangle extent() const override;
+    bool isValid() const override;
+    QgsCoordinateReferenceSystem crs() const override;
+
+  private:
+    std::shared_ptr< QgsProcessingFeaturePipe > mPipe;
+};
+
+///@endcond
+
+#endif // QGSPROCESSINGFEATUREPIPE_H
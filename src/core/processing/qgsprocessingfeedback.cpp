@@ -18,6 +18,7 @@
 #include "qgsprocessingfeedback.h"
 #include "qgsgeos.h"
 #include "qgsprocessingprovider.h"
+#include <QMutexLocker>
 #include <ogr_api.h>
 #include <gdal_version.h>
 #if PROJ_VERSION_MAJOR > 4
@@ -176,3 +177,76 @@ void QgsProcessingMultiStepFeedback::updateOverallProgress( double progress )
   mFeedback->setProgress( baseProgress + currentAlgorithmProgress );
 }
 
+
+///@cond PRIVATE
+
+QgsProcessingRecordingFeedback::QgsProcessingRecordingFeedback()
+  : QgsProcessingFeedback( false )
+{
+}
+
+void QgsProcessingRecordingFeedback::reportError( const QString &error, bool fatalError )
+{
+  QMutexLocker locker( &mMutex );
+  mMessages << Message { fatalError ? FatalError : Error, error };
+}
+
+void QgsProcessingRecordingFeedback::pushInfo( const QString &info )
+{
+  QMutexLocker locker( &mMutex );
+  mMessages << Message { Info, info };
+}
+
+void QgsProcessingRecordingFeedback::pushCommandInfo( const QString &info )
+{
+  QMutexLocker locker( &mMutex );
+  mMessages << Message { CommandInfo, info };
+}
+
+void QgsProcessingRecordingFeedback::pushDebugInfo( const QString &info )
+{
+  QMutexLocker locker( &mMutex );
+  mMessages << Message { DebugInfo, info };
+}
+
+void QgsProcessingRecordingFeedback::pushConsoleInfo( const QString &info )
+{
+  QMutexLocker locker( &mMutex );
+  mMessages << Message { ConsoleInfo, info };
+}
+
+void QgsProcessingRecordingFeedback::replay( QgsProcessingFeedback *feedback )
+{
+  QList< Message > messages;
+  {
+    QMutexLocker locker( &mMutex );
+    messages.swap( mMessages );
+  }
+
+  for ( const Message &message : qgis::as_const( messages ) )
+  {
+    switch ( message.type )
+    {
+      case Error:
+        feedback->reportError( message.text, false );
+        break;
+      case FatalError:
+        feedback->reportError( message.text, true );
+        break;
+      case Info:
+        feedback->pushInfo( message.text );
+        break;
+      case CommandInfo:
+        feedback->pushCommandInfo( message.text );
+        break;
+      case DebugInfo:
+        feedback->pushDebugInfo( message.text );
+        break;
+      case ConsoleInfo:
+        feedback->pushConsoleInfo( message.text );
+        break;
+    }
+  }
+}
+
+///@endcond
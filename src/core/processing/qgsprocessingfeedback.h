@@ -22,6 +22,8 @@
 #include "qgsfeedback.h"
 #include "qgsmessagelog.h"
 
+#include <QMutex>
+
 class QgsProcessingProvider;
 
 /**
@@ -181,6 +183,60 @@ class CORE_EXPORT QgsProcessingMultiStepFeedback : public QgsProcessingFeedback
     QgsProcessingFeedback *mFeedback = nullptr;
 };
 
+#ifndef SIP_RUN
+///@cond PRIVATE
+
+/**
+ * \class QgsProcessingRecordingFeedback
+ * \ingroup core
+ *
+ * Processing feedback object recording the messages pushed to it, so that the messages
+ * pushed from a worker thread can be reported to another feedback from the calling thread.
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.16
+ */
+class CORE_EXPORT QgsProcessingRecordingFeedback : public QgsProcessingFeedback
+{
+  public:
+
+    //! Constructor for QgsProcessingRecordingFeedback
+    QgsProcessingRecordingFeedback();
+
+    void reportError( const QString &error, bool fatalError = false ) override;
+    void pushInfo( const QString &info ) override;
+    void pushCommandInfo( const QString &info ) override;
+    void pushDebugInfo( const QString &info ) override;
+    void pushConsoleInfo( const QString &info ) override;
+
+    //! Reports to \a feedback the messages recorded since the last call, and clears them
+    void replay( QgsProcessingFeedback *feedback );
+
+  private:
+
+    enum MessageType
+    {
+      Error,
+      FatalError,
+      Info,
+      CommandInfo,
+      DebugInfo,
+      ConsoleInfo,
+    };
+
+    struct Message
+    {
+      MessageType type;
+      QString text;
+    };
+
+    QMutex mMutex;
+    QList< Message > mMessages;
+};
+
+///@endcond
+#endif
+
 #endif // QGSPROCESSINGFEEDBACK_H
 
 
@@ -0,0 +1,146 @@
+/***************************************************************************
+                         qgsprocessingmemoryoutputsink.cpp
+                         ---------------------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsprocessingmemoryoutputsink.h"
+#include "qgsabstractgeometry.h"
+#include "qgslogger.h"
+#include "qgsprocessingutils.h"
+#include "qgsvectordataprovider.h"
+#include "qgsvectorfilewriter.h"
+#include "qgsvectorlayer.h"
+
+///@cond PRIVATE
+
+QgsProcessingMemoryOutputSink::QgsProcessingMemoryOutputSink( QgsVectorLayer *layer, qint64 budget, const QgsCoordinateTransformContext &transformContext )
+  : mLayer( layer )
+  , mBudget( budget )
+  , mTransformContext( transformContext )
+{
+}
+
+QgsProcessingMemoryOutputSink::~QgsProcessingMemoryOutputSink()
+{
+  if ( !mWriter )
+    return;
+
+  // closes the GeoPackage before the layer reads it
+  QString error = mWriter->errorMessage();
+  mWriter.reset();
+  if ( !mLayer )
+    return;
+
+  QgsDataProvider::ProviderOptions options;
+  options.transformContext = mTransformContext;
+  mLayer->setDataSource( mPath, mLayer->name(), QStringLiteral( "ogr" ), options );
+  if ( !mLayer->isValid() )
+    QgsDebugMsg( QStringLiteral( "Could not open spilled memory output %1: %2" ).arg( mPath, error ) );
+}
+
+bool QgsProcessingMemoryOutputSink::addFeatures( QgsFeatureList &features, QgsFeatureSink::Flags flags )
+{
+  if ( mWriter )
+    return mWriter->addFeatures( features, flags );
+
+  if ( !mLayer )
+    return false;
+
+  const bool result = mLayer->dataProvider()->addFeatures( features, flags );
+  if ( mBudget <= 0 || mSpillFailed )
+    return result;
+
+  for ( const QgsFeature &feature : qgis::as_const( features ) )
+    mSize += featureSize( feature );
+  if ( mSize > mBudget && !spill() )
+    mSpillFailed = true;
+  return result;
+}
+
+QString QgsProcessingMemoryOutputSink::lastError() const
+{
+  if ( mWriter )
+    return mWriter->lastError();
+  return mLayer ? mLayer->dataProvider()->lastError() : QString();
+}
+
+qint64 QgsProcessingMemoryOutputSink::featureSize( const QgsFeature &feature )
+{
+  qint64 size = sizeof( QgsFeature );
+  if ( const QgsAbstractGeometry *geometry = feature.geometry().constGet() )
+  {
+    const int dimensions = 2 + ( geometry->is3D() ? 1 : 0 ) + ( geometry->isMeasure() ? 1 : 0 );
+    size += 64 + static_cast< qint64 >( geometry->nCoordinates() ) * dimensions * sizeof( double );
+  }
+
+  const QgsAttributes attributes = feature.attributes();
+  for ( const QVariant &attribute : attributes )
+  {
+    size += sizeof( QVariant );
+    switch ( attribute.type() )
+    {
+      case QVariant::String:
+        size += attribute.toString().size() * sizeof( QChar );
+        break;
+      case QVariant::ByteArray:
+        size += attribute.toByteArray().size();
+        break;
+      default:
+        break;
+    }
+  }
+  return size;
+}
+
+bool QgsProcessingMemoryOutputSink::spill()
+{
+  QgsVectorDataProvider *provider = mLayer->dataProvider();
+
+  QgsVectorFileWriter::SaveVectorOptions options;
+  options.driverName = QStringLiteral( "GPKG" );
+  options.layerName = mLayer->name();
+  options.fileEncoding = QStringLiteral( "UTF-8" );
+  options.symbologyExport = QgsVectorFileWriter::NoSymbology;
+  QString fileName;
+  QString layerName;
+  std::unique_ptr< QgsVectorFileWriter > writer( QgsVectorFileWriter::create( QgsProcessingUtils::generateTempFilename( QStringLiteral( "output.gpkg" ) ),
+      provider->fields(), provider->wkbType(), provider->crs(), mTransformContext, options, QgsFeatureSink::SinkFlags(), &fileName, &layerName ) );
+  if ( writer->hasError() )
+  {
+    QgsDebugMsg( QStringLiteral( "Could not spill memory output %1: %2" ).arg( mLayer->name(), writer->errorMessage() ) );
+    return false;
+  }
+
+  // the features are moved in the order of their ids, which the GeoPackage keeps
+  QgsFeatureIterator it = provider->getFeatures();
+  QgsFeature feature;
+  while ( it.nextFeature( feature ) )
+  {
+    if ( !writer->addFeature( feature, QgsFeatureSink::FastInsert ) )
+    {
+      QgsDebugMsg( QStringLiteral( "Could not spill memory output %1: %2" ).arg( mLayer->name(), writer->lastError() ) );
+      return false;
+    }
+  }
+  it.close();
+  provider->truncate();
+
+  mWriter = std::move( writer );
+  mPath = layerName.isEmpty() ? fileName : QStringLiteral( "%1|layername=%2" ).arg( fileName, layerName );
+  mSize = 0;
+  return true;
+}
+
+///@endcond
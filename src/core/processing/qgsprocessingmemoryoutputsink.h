@@ -0,0 +1,87 @@
+/***************************************************************************
+                         qgsprocessingmemoryoutputsink.h
+                         -------------------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSPROCESSINGMEMORYOUTPUTSINK_H
+#define QGSPROCESSINGMEMORYOUTPUTSINK_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+#include "qgsfeaturesink.h"
+#include "qgscoordinatetransformcontext.h"
+
+#include <QPointer>
+
+#include <memory>
+
+class QgsVectorLayer;
+class QgsVectorFileWriter;
+
+///@cond PRIVATE
+
+/**
+ * \ingroup core
+ * \class QgsProcessingMemoryOutputSink
+ * \brief A feature sink adding the features to a memory layer output until they exceed a memory budget,
+ * then spilling them to a temporary GeoPackage.
+ *
+ * Once the budget is exceeded, the features already added are moved from the memory layer to the GeoPackage,
+ * and the next ones are written there. When the sink is destroyed, the data source of the layer is switched to
+ * the GeoPackage, so that the layer keeps its id, and thus remains the output of the algorithm. The GeoPackage
+ * has a spatial index, and its feature ids follow the order in which the features were added, as in the memory layer.
+ *
+ * \see QgsProcessingContext::memoryOutputBudget()
+ * \note not available in Python bindings
+ * \since QGIS 3.16
+ */
+class CORE_EXPORT QgsProcessingMemoryOutputSink : public QgsFeatureSink
+{
+  public:
+
+    /**
+     * Constructor for QgsProcessingMemoryOutputSink, adding features to the memory \a layer
+     * until their size exceeds \a budget bytes.
+     */
+    QgsProcessingMemoryOutputSink( QgsVectorLayer *layer, qint64 budget, const QgsCoordinateTransformContext &transformContext );
+    ~QgsProcessingMemoryOutputSink() override;
+
+    bool addFeatures( QgsFeatureList &features, QgsFeatureSink::Flags flags = QgsFeatureSink::Flags() ) override;
+    QString lastError() const override;
+
+    //! Returns TRUE if the features were spilled to a temporary GeoPackage
+    bool hasSpilled() const { return static_cast< bool >( mWriter ); }
+
+    //! Returns the approximate size in bytes of a \a feature held in memory
+    static qint64 featureSize( const QgsFeature &feature );
+
+  private:
+
+    //! Moves the features of the memory layer to a new temporary GeoPackage, returns FALSE if it cannot be created
+    bool spill();
+
+    QPointer< QgsVectorLayer > mLayer;
+    qint64 mBudget = 0;
+    qint64 mSize = 0;
+    QgsCoordinateTransformContext mTransformContext;
+    std::unique_ptr< QgsVectorFileWriter > mWriter;
+    QString mPath;
+    bool mSpillFailed = false;
+};
+
+///@endcond
+
+#endif // QGSPROCESSINGMEMORYOUTPUTSINK_H
@@ -25,6 +25,8 @@
 #include "qgsmemoryproviderutils.h"
 #include "qgsprocessingparameters.h"
 #include "qgsprocessingalgorithm.h"
+#include "qgsprocessingfeaturepipe.h"
+#include "qgsprocessingmemoryoutputsink.h"
 #include "qgsvectorlayerfeatureiterator.h"
 #include "qgsexpressioncontextscopegenerator.h"
 #include "qgsfileutils.h"
@@ -719,11 +721,31 @@ QgsFeatureSink *QgsProcessingUtils::createFeatureSink( QString &destination, Qgs
     destination = layer->id();
 
     // this is a factory, so we need to return a proxy
-    std::unique_ptr< QgsProcessingFeatureSink > sink( new QgsProcessingFeatureSink( layer->dataProvider(), destination, context ) );
+    std::unique_ptr< QgsProcessingFeatureSink > sink;
+    if ( context.memoryOutputBudget() > 0 )
+    {
+      // spilled to a temporary GeoPackage beyond the budget
+      sink.reset( new QgsProcessingFeatureSink( new QgsProcessingMemoryOutputSink( layer.get(), context.memoryOutputBudget(), context.transformContext() ), destination, context, true ) );
+    }
+    else
+    {
+      sink.reset( new QgsProcessingFeatureSink( layer->dataProvider(), destination, context ) );
+    }
     context.temporaryLayerStore()->addMapLayer( layer.release() );
 
     return sink.release();
   }
+  else if ( destination.startsWith( QLatin1String( "pipe:" ) ) )
+  {
+    // streamed to the child algorithm of a model reading it, see QgsProcessingFeaturePipe
+    std::shared_ptr< QgsProcessingFeaturePipe > pipe = QgsProcessingFeaturePipe::pipe( destination.mid( 5 ) );
+    if ( !pipe )
+    {
+      throw QgsProcessingException( QObject::tr( "Could not create feature pipe %1" ).arg( destination ) );
+    }
+    pipe->open( fields, geometryType, crs );
+    return new QgsProcessingFeatureSink( new QgsProcessingFeaturePipeSink( pipe ), destination, context, true );
+  }
   else
   {
     QString providerKey;
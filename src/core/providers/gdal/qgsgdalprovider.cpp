@@ -25,6 +25,7 @@
 #include "qgsconfig.h"
 
 #include "qgsgdalutils.h"
+#include "qgsgdaltilecache.h"
 #include "qgsapplication.h"
 #include "qgsauthmanager.h"
 #include "qgscoordinatetransform.h"
@@ -1123,8 +1124,40 @@ bool QgsGdalProvider::readBlock( int bandNo, QgsRectangle  const &reqExtent, int
     tmpHeight = static_cast<int>( std::round( -1.*srcHeight * srcYRes / reqYRes ) );
   }
 
-  const double tmpXMin = mExtent.xMinimum() + srcLeft * srcXRes;
-  const double tmpYMax = mExtent.yMaximum() + srcTop * srcYRes;
+  double tmpXMin = mExtent.xMinimum() + srcLeft * srcXRes;
+  double tmpYMax = mExtent.yMaximum() + srcTop * srcYRes;
+  double tmpXRes = srcWidth * srcXRes / tmpWidth;
+  double tmpYRes = srcHeight * srcYRes / tmpHeight; // negative
+
+  // Remote datasets are read by tiles of the matching overview, kept in a cache shared by
+  // the providers, so that panning only fetches the tiles which became visible. The window
+  // is read at the overview resolution, and resampled to the request below
+  QgsGdalTileCache *tileCache = QgsGdalTileCache::instance();
+  const QString datasetPath = QString::fromUtf8( GDALGetDescription( mGdalBaseDataset ) );
+  GDALRasterBandH tileBand = nullptr;
+  int tileOverview = 0;
+  int tileLeft = 0;
+  int tileTop = 0;
+  if ( !mUpdate && mGdalDataset == mGdalBaseDataset && tileCache->maximumCost() > 0 && QgsGdalTileCache::isRemoteDataset( datasetPath ) )
+  {
+    tileOverview = QgsGdalTileCache::overviewForDownsampling( gdalBand, static_cast< double >( srcWidth ) / tmpWidth );
+    tileBand = QgsGdalTileCache::overviewBand( gdalBand, tileOverview );
+  }
+  if ( tileBand )
+  {
+    const double overviewXFactor = static_cast< double >( xSize() ) / GDALGetRasterBandXSize( tileBand );
+    const double overviewYFactor = static_cast< double >( ySize() ) / GDALGetRasterBandYSize( tileBand );
+    tileLeft = static_cast<int>( std::floor( srcLeft / overviewXFactor ) );
+    tileTop = static_cast<int>( std::floor( srcTop / overviewYFactor ) );
+    const int tileRight = std::min( GDALGetRasterBandXSize( tileBand ), static_cast<int>( std::ceil( ( srcRight + 1 ) / overviewXFactor ) ) ) - 1;
+    const int tileBottom = std::min( GDALGetRasterBandYSize( tileBand ), static_cast<int>( std::ceil( ( srcBottom + 1 ) / overviewYFactor ) ) ) - 1;
+    tmpWidth = tileRight - tileLeft + 1;
+    tmpHeight = tileBottom - tileTop + 1;
+    tmpXRes = srcXRes * overviewXFactor;
+    tmpYRes = srcYRes * overviewYFactor;
+    tmpXMin = mExtent.xMinimum() + tileLeft * tmpXRes;
+    tmpYMax = mExtent.yMaximum() + tileTop * tmpYRes;
+  }
   QgsDebugMsgLevel( QStringLiteral( "tmpXMin = %1 tmpYMax = %2 tmpWidth = %3 tmpHeight = %4" ).arg( tmpXMin ).arg( tmpYMax ).arg( tmpWidth ).arg( tmpHeight ), 5 );
 
   // Allocate temporary block
@@ -1146,11 +1179,20 @@ bool QgsGdalProvider::readBlock( int bandNo, QgsRectangle  const &reqExtent, int
   }
   CPLErrorReset();
 
-  CPLErr err = gdalRasterIO( gdalBand, GF_Read,
-                             srcLeft, srcTop, srcWidth, srcHeight,
-                             static_cast<void *>( tmpBlock ),
-                             tmpWidth, tmpHeight, type,
-                             0, 0, feedback );
+  CPLErr err = CE_None;
+  if ( tileBand )
+  {
+    if ( !tileCache->readWindow( datasetPath, bandNo, tileOverview, tileBand, tileLeft, tileTop, tmpWidth, tmpHeight, type, tmpBlock ) )
+      err = CE_Failure;
+  }
+  else
+  {
+    err = gdalRasterIO( gdalBand, GF_Read,
+                        srcLeft, srcTop, srcWidth, srcHeight,
+                        static_cast<void *>( tmpBlock ),
+                        tmpWidth, tmpHeight, type,
+                        0, 0, feedback );
+  }
 
   if ( err != CPLE_None )
   {
@@ -1163,9 +1205,6 @@ bool QgsGdalProvider::readBlock( int bandNo, QgsRectangle  const &reqExtent, int
     return false;
   }
 
-  const double tmpXRes = srcWidth * srcXRes / tmpWidth;
-  const double tmpYRes = srcHeight * srcYRes / tmpHeight; // negative
-
   double y = intersectExtent.yMaximum() - 0.5 * reqYRes;
   for ( int row = 0; row < tgtHeight; row++ )
   {
@@ -1878,6 +1917,8 @@ QgsRasterHistogram QgsGdalProvider::histogram( int bandNo,
   }
 #endif
 
+  // GDAL first looks for a matching histogram in the .aux.xml sidecar, and saves there
+  // the ones it computes
   GUIntBig *myHistogramArray = new GUIntBig[myHistogram.binCount];
   CPLErr myError = GDALGetRasterHistogramEx( myGdalBand, myMinVal, myMaxVal,
                    myHistogram.binCount, myHistogramArray,
@@ -1891,6 +1932,10 @@ QgsRasterHistogram QgsGdalProvider::histogram( int bandNo,
     return myHistogram;
   }
 
+  // keep the sidecar of a full resolution histogram, so that it is not computed again
+  if ( !bApproxOK )
+    mStatisticsAreReliable = true;
+
 #endif
 
   for ( int myBin = 0; myBin < myHistogram.binCount; myBin++ )
@@ -2768,13 +2813,30 @@ QgsRasterBandStats QgsGdalProvider::bandStatistics( int bandNo, int stats, const
   // see above and https://trac.osgeo.org/gdal/ticket/4857
   // -> Cannot used cached GDAL stats for exact
 
+#if GDAL_VERSION_NUM >= GDAL_COMPUTE_VERSION(3,2,0)
+  // GDAL flags the statistics it estimated, the exact ones saved in the .aux.xml
+  // sidecar by a previous session can be used as is, otherwise they are computed
+  // once below, with progress
+  CPLErr myerval =
+    GDALGetRasterStatistics( myGdalBand, bApproxOK, bApproxOK, &pdfMin, &pdfMax, &pdfMean, &pdfStdDev );
+
+  QgsDebugMsgLevel( QStringLiteral( "myerval = %1" ).arg( myerval ), 2 );
+
+  const char *approximate = GDALGetMetadataItem( myGdalBand, "STATISTICS_APPROXIMATE", nullptr );
+  const bool cachedStatisticsAreExact = !bApproxOK && CE_None == myerval && !( approximate && CPLTestBool( approximate ) );
+  if ( cachedStatisticsAreExact )
+    mStatisticsAreReliable = true;
+#else
   CPLErr myerval =
     GDALGetRasterStatistics( myGdalBand, bApproxOK, true, &pdfMin, &pdfMax, &pdfMean, &pdfStdDev );
 
   QgsDebugMsgLevel( QStringLiteral( "myerval = %1" ).arg( myerval ), 2 );
 
+  const bool cachedStatisticsAreExact = false;
+#endif
+
   // if cached stats are not found, compute them
-  if ( !bApproxOK || CE_None != myerval )
+  if ( ( !bApproxOK && !cachedStatisticsAreExact ) || CE_None != myerval )
   {
     QgsDebugMsgLevel( QStringLiteral( "Calculating statistics by GDAL" ), 2 );
     myerval = GDALComputeRasterStatistics( myGdalBand, bApproxOK,
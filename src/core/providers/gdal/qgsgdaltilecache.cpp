@@ -0,0 +1,294 @@
+/***************************************************************************
+                         qgsgdaltilecache.cpp
+                         --------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsgdaltilecache.h"
+#include "qgis.h"
+#include "qgslogger.h"
+#include "qgsogrutils.h"
+#include "qgssettings.h"
+
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <cstring>
+
+///@cond PRIVATE
+
+//! Reads tiles of a dataset into the QgsGdalTileCache, from its own handle of the dataset
+class QgsGdalTilePrefetcher : public QRunnable
+{
+  public:
+
+    QgsGdalTilePrefetcher( QgsGdalTileCache *cache, const QString &dataset, GDALDataType type, const QList<QgsGdalTileCache::TileKey> &tiles )
+      : mCache( cache )
+      , mDataset( dataset )
+      , mType( type )
+      , mTiles( tiles )
+    {
+    }
+
+    void run() override
+    {
+      gdal::dataset_unique_ptr dataset( GDALOpenEx( mDataset.toUtf8().constData(), GDAL_OF_RASTER | GDAL_OF_READONLY, nullptr, nullptr, nullptr ) );
+      for ( const QgsGdalTileCache::TileKey &key : qgis::as_const( mTiles ) )
+      {
+        GDALRasterBandH band = nullptr;
+        if ( dataset && GDALGetRasterCount( dataset.get() ) > 0 )
+        {
+          // the band after the last one is the mask band exposed as alpha
+          if ( key.band <= GDALGetRasterCount( dataset.get() ) )
+            band = GDALGetRasterBand( dataset.get(), key.band );
+          else
+            band = GDALGetMaskBand( GDALGetRasterBand( dataset.get(), 1 ) );
+        }
+
+        const QByteArray tile = band ? QgsGdalTileCache::readTile( QgsGdalTileCache::overviewBand( band, key.overview ), key.column, key.row, mType ) : QByteArray();
+        QMutexLocker locker( &mCache->mMutex );
+        mCache->mPrefetching.remove( key );
+        if ( !tile.isNull() )
+          mCache->insertTile( key, tile );
+      }
+    }
+
+  private:
+
+    QgsGdalTileCache *mCache = nullptr;
+    QString mDataset;
+    GDALDataType mType;
+    QList<QgsGdalTileCache::TileKey> mTiles;
+};
+
+///@endcond
+
+QgsGdalTileCache::QgsGdalTileCache()
+{
+  mTiles.setMaxCost( QgsSettings().value( QStringLiteral( "qgis/gdalTileCacheSize" ), 256 ).toInt() * 1024 * 1024 );
+}
+
+QgsGdalTileCache *QgsGdalTileCache::instance()
+{
+  static QgsGdalTileCache sInstance;
+  return &sInstance;
+}
+
+bool QgsGdalTileCache::isRemoteDataset( const QString &path )
+{
+  static const QStringList sPrefixes
+  {
+    QStringLiteral( "/vsicurl/" ),
+    QStringLiteral( "/vsicurl_streaming/" ),
+    QStringLiteral( "/vsis3/" ),
+    QStringLiteral( "/vsigs/" ),
+    QStringLiteral( "/vsiaz/" ),
+    QStringLiteral( "/vsiadls/" ),
+    QStringLiteral( "/vsioss/" ),
+    QStringLiteral( "/vsiswift/" ),
+    QStringLiteral( "/vsiwebhdfs/" ),
+    QStringLiteral( "http://" ),
+    QStringLiteral( "https://" ),
+  };
+  for ( const QString &prefix : sPrefixes )
+  {
+    if ( path.startsWith( prefix, Qt::CaseInsensitive ) )
+      return true;
+  }
+  return false;
+}
+
+int QgsGdalTileCache::overviewForDownsampling( GDALRasterBandH band, double downsampling )
+{
+  const int width = GDALGetRasterBandXSize( band );
+  int level = 0;
+  double levelDownsampling = 1;
+  for ( int i = 0; i < GDALGetOverviewCount( band ); ++i )
+  {
+    GDALRasterBandH overview = GDALGetOverview( band, i );
+    if ( !overview || GDALGetRasterBandXSize( overview ) <= 0 )
+      continue;
+
+    // overviews are not necessarily sorted
+    const double overviewDownsampling = static_cast< double >( width ) / GDALGetRasterBandXSize( overview );
+    if ( overviewDownsampling <= downsampling && overviewDownsampling > levelDownsampling )
+    {
+      level = i + 1;
+      levelDownsampling = overviewDownsampling;
+    }
+  }
+  return level;
+}
+
+GDALRasterBandH QgsGdalTileCache::overviewBand( GDALRasterBandH band, int level )
+{
+  return level == 0 ? band : GDALGetOverview( band, level - 1 );
+}
+
+QSize QgsGdalTileCache::tileSize( GDALRasterBandH band )
+{
+  int blockWidth = 0;
+  int blockHeight = 0;
+  GDALGetBlockSize( band, &blockWidth, &blockHeight );
+  // strips, or too small blocks, would make too many tiles
+  if ( blockWidth >= 128 && blockWidth <= 1024 && blockHeight >= 128 && blockHeight <= 1024 )
+    return QSize( blockWidth, blockHeight );
+  return QSize( 256, 256 );
+}
+
+void QgsGdalTileCache::setMaximumCost( int cost )
+{
+  QMutexLocker locker( &mMutex );
+  mTiles.setMaxCost( cost );
+}
+
+int QgsGdalTileCache::maximumCost() const
+{
+  QMutexLocker locker( &mMutex );
+  return mTiles.maxCost();
+}
+
+int QgsGdalTileCache::tileCount() const
+{
+  QMutexLocker locker( &mMutex );
+  return mTiles.count();
+}
+
+bool QgsGdalTileCache::contains( const TileKey &key ) const
+{
+  QMutexLocker locker( &mMutex );
+  return mTiles.contains( key );
+}
+
+void QgsGdalTileCache::clear()
+{
+  QMutexLocker locker( &mMutex );
+  mTiles.clear();
+}
+
+bool QgsGdalTileCache::readWindow( const QString &dataset, int bandNo, int overview, GDALRasterBandH band,
+                                   int left, int top, int width, int height, GDALDataType type, void *data )
+{
+  const QSize size = tileSize( band );
+  const int dataSize = GDALGetDataTypeSizeBytes( type );
+  const int firstColumn = left / size.width();
+  const int lastColumn = ( left + width - 1 ) / size.width();
+  const int firstRow = top / size.height();
+  const int lastRow = ( top + height - 1 ) / size.height();
+
+  for ( int row = firstRow; row <= lastRow; ++row )
+  {
+    for ( int column = firstColumn; column <= lastColumn; ++column )
+    {
+      const TileKey key { dataset, bandNo, overview, column, row };
+      QByteArray tile;
+      {
+        QMutexLocker locker( &mMutex );
+        if ( const QByteArray *cached = mTiles.object( key ) )
+          tile = *cached;
+      }
+      if ( tile.isNull() )
+      {
+        // read unlocked, a tile being prefetched may be read twice at worst
+        tile = readTile( band, column, row, type );
+        if ( tile.isNull() )
+          return false;
+
+        QMutexLocker locker( &mMutex );
+        insertTile( key, tile );
+      }
+
+      // the tiles of the last row and column are clipped to the band size
+      const int tileLeft = column * size.width();
+      const int tileTop = row * size.height();
+      const int tileWidth = std::min( size.width(), GDALGetRasterBandXSize( band ) - tileLeft );
+      const int copyLeft = std::max( left, tileLeft );
+      const int copyRight = std::min( left + width, tileLeft + tileWidth );
+      const int copyTop = std::max( top, tileTop );
+      const int copyBottom = std::min( top + height, tileTop + size.height() );
+      for ( int y = copyTop; y < copyBottom; ++y )
+      {
+        std::memcpy( static_cast< char * >( data ) + ( static_cast< size_t >( y - top ) * width + ( copyLeft - left ) ) * dataSize,
+                     tile.constData() + ( static_cast< size_t >( y - tileTop ) * tileWidth + ( copyLeft - tileLeft ) ) * dataSize,
+                     static_cast< size_t >( copyRight - copyLeft ) * dataSize );
+      }
+    }
+  }
+
+  // the tiles around the window are the next ones needed when panning
+  const int columnCount = ( GDALGetRasterBandXSize( band ) + size.width() - 1 ) / size.width();
+  const int rowCount = ( GDALGetRasterBandYSize( band ) + size.height() - 1 ) / size.height();
+  QList<TileKey> neighbors;
+  for ( int row = std::max( 0, firstRow - PREFETCH_MARGIN ); row <= std::min( rowCount - 1, lastRow + PREFETCH_MARGIN ); ++row )
+  {
+    for ( int column = std::max( 0, firstColumn - PREFETCH_MARGIN ); column <= std::min( columnCount - 1, lastColumn + PREFETCH_MARGIN ); ++column )
+    {
+      if ( row < firstRow || row > lastRow || column < firstColumn || column > lastColumn )
+        neighbors << TileKey { dataset, bandNo, overview, column, row };
+    }
+  }
+  prefetch( dataset, type, neighbors );
+  return true;
+}
+
+QByteArray QgsGdalTileCache::readTile( GDALRasterBandH band, int column, int row, GDALDataType type )
+{
+  if ( !band )
+    return QByteArray();
+
+  const QSize size = tileSize( band );
+  const int left = column * size.width();
+  const int top = row * size.height();
+  const int width = std::min( size.width(), GDALGetRasterBandXSize( band ) - left );
+  const int height = std::min( size.height(), GDALGetRasterBandYSize( band ) - top );
+  if ( width <= 0 || height <= 0 )
+    return QByteArray();
+
+  QByteArray tile( width * height * GDALGetDataTypeSizeBytes( type ), Qt::Uninitialized );
+  if ( GDALRasterIO( band, GF_Read, left, top, width, height, tile.data(), width, height, type, 0, 0 ) != CE_None )
+  {
+    QgsDebugMsg( QStringLiteral( "Cannot read tile %1, %2: %3" ).arg( column ).arg( row ).arg( QString::fromUtf8( CPLGetLastErrorMsg() ) ) );
+    return QByteArray();
+  }
+  return tile;
+}
+
+void QgsGdalTileCache::prefetch( const QString &dataset, GDALDataType type, const QList<TileKey> &tiles )
+{
+  QList<TileKey> missing;
+  {
+    QMutexLocker locker( &mMutex );
+    for ( const TileKey &key : tiles )
+    {
+      if ( !mTiles.contains( key ) && !mPrefetching.contains( key ) )
+      {
+        mPrefetching.insert( key );
+        missing << key;
+      }
+    }
+  }
+  if ( missing.isEmpty() )
+    return;
+
+  // QgsApplication::exitQgis() waits for the global pool before GDAL is cleaned up
+  QThreadPool::globalInstance()->start( new QgsGdalTilePrefetcher( this, dataset, type, missing ) );
+}
+
+void QgsGdalTileCache::insertTile( const TileKey &key, const QByteArray &tile )
+{
+  // mMutex must be locked, QCache deletes the tiles it evicts or cannot hold
+  mTiles.insert( key, new QByteArray( tile ), tile.size() );
+}
@@ -0,0 +1,153 @@
+/***************************************************************************
+                         qgsgdaltilecache.h
+                         ------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSGDALTILECACHE_H
+#define QGSGDALTILECACHE_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+
+#include <QByteArray>
+#include <QCache>
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QSize>
+#include <QString>
+
+#include <gdal.h>
+
+///@cond PRIVATE
+
+/**
+ * \ingroup core
+ * \class QgsGdalTileCache
+ * \brief Shared cache of the decoded tiles of the bands and overviews of GDAL datasets.
+ *
+ * Rendering a remote dataset, such as a cloud optimized GeoTIFF read through
+ * /vsicurl/ or /vsis3/, fetches again from the network the byte ranges of the
+ * whole visible window at each redraw, since the GDAL block cache is per dataset
+ * handle and too small for a map canvas. QgsGdalProvider rather reads remote
+ * datasets with readWindow(), by tiles of the overview matching the requested
+ * resolution, so that panning or redrawing only fetches the tiles which became
+ * visible. The tiles around the window are then prefetched in the background.
+ *
+ * Tiles are keyed by dataset path, band, overview level (0 for the full
+ * resolution band) and tile index, and are evicted least recently used first,
+ * when their total size exceeds maximumCost(). The default budget is read from the
+ * "qgis/gdalTileCacheSize" setting, in megabytes, 0 disabling the cache.
+ *
+ * The cache is thread-safe.
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.16
+ */
+class CORE_EXPORT QgsGdalTileCache
+{
+  public:
+
+    //! Identifies a tile of a band of a dataset at an overview level
+    struct TileKey
+    {
+      QString dataset;
+      int band;
+      int overview;
+      int column;
+      int row;
+
+      bool operator==( const TileKey &other ) const
+      {
+        return column == other.column && row == other.row && band == other.band && overview == other.overview && dataset == other.dataset;
+      }
+    };
+
+    //! Returns the cache shared by all the GDAL providers
+    static QgsGdalTileCache *instance();
+
+    //! Returns TRUE if the dataset at \a path is read through the network, and worth caching
+    static bool isRemoteDataset( const QString &path );
+
+    /**
+     * Returns the overview level of \a band to read at \a downsampling times the
+     * resolution of the band: the coarsest overview which is not coarser than requested,
+     * or 0 for the band itself.
+     */
+    static int overviewForDownsampling( GDALRasterBandH band, double downsampling );
+
+    //! Returns the band of overview \a level of \a band, \a band itself for level 0
+    static GDALRasterBandH overviewBand( GDALRasterBandH band, int level );
+
+    //! Returns the size of the tiles of \a band: its block size if reasonable, square tiles otherwise
+    static QSize tileSize( GDALRasterBandH band );
+
+    //! Sets the maximum size (in bytes) of the cached tiles
+    void setMaximumCost( int cost );
+
+    //! Returns the maximum size (in bytes) of the cached tiles
+    int maximumCost() const;
+
+    //! Returns the number of cached tiles
+    int tileCount() const;
+
+    //! Returns TRUE if the tile \a key is cached
+    bool contains( const TileKey &key ) const;
+
+    //! Removes all the cached tiles
+    void clear();
+
+    /**
+     * Reads into \a data the window of \a width by \a height pixels at \a left, \a top of
+     * overview \a overview of \a band, the band number \a bandNo of the dataset at \a dataset.
+     * The tiles of the window are taken from the cache, those which are missing are read
+     * from \a band with the \a type data type and cached, and the tiles around the window
+     * are prefetched in the background, from another handle of the dataset.
+     * Returns FALSE if a tile could not be read.
+     */
+    bool readWindow( const QString &dataset, int bandNo, int overview, GDALRasterBandH band,
+                     int left, int top, int width, int height, GDALDataType type, void *data );
+
+    //! Number of tiles prefetched beyond each side of the requested window
+    static const int PREFETCH_MARGIN = 1;
+
+  private:
+
+    QgsGdalTileCache();
+
+    //! Reads the tile \a column, \a row of \a band, clipped to the band size
+    static QByteArray readTile( GDALRasterBandH band, int column, int row, GDALDataType type );
+
+    //! Reads in the background from a new handle of \a dataset the \a tiles which are neither cached nor being read
+    void prefetch( const QString &dataset, GDALDataType type, const QList<TileKey> &tiles );
+
+    void insertTile( const TileKey &key, const QByteArray &tile );
+
+    mutable QMutex mMutex;
+    QCache<TileKey, QByteArray> mTiles;
+    QSet<TileKey> mPrefetching;
+
+    friend class QgsGdalTilePrefetcher;
+};
+
+inline uint qHash( const QgsGdalTileCache::TileKey &key, uint seed = 0 )
+{
+  return qHash( key.dataset, seed ) ^ qHash( key.band ) ^ ( qHash( key.overview ) << 4 ) ^ qHash( key.column << 16 ^ key.row );
+}
+
+///@endcond
+
+#endif // QGSGDALTILECACHE_H
@@ -23,6 +23,9 @@
 #include "qgsproject.h"
 #include "qgsexception.h"
 #include "qgsexpressioncontextutils.h"
+#include "qgsfeaturebatch.h"
+
+#include <algorithm>
 
 ///@cond PRIVATE
 
@@ -63,6 +66,8 @@ QgsMemoryFeatureIterator::QgsMemoryFeatureIterator( QgsMemoryFeatureSource *sour
   {
     mUsingFeatureIdList = true;
     mFeatureIdList = mSource->mSpatialIndex->intersects( mFilterRect );
+    // the features are then read in the order of their ids, as when traversing all of them
+    std::sort( mFeatureIdList.begin(), mFeatureIdList.end() );
     QgsDebugMsg( "Features returned by spatial index: " + QString::number( mFeatureIdList.count() ) );
   }
   else if ( mRequest.filterType() == QgsFeatureRequest::FilterFid )
@@ -103,6 +108,23 @@ bool QgsMemoryFeatureIterator::fetchFeature( QgsFeature &feature )
     return nextFeatureTraverseAll( feature );
 }
 
+bool QgsMemoryFeatureIterator::fetchBatch( QgsFeatureBatch &batch, int maxFeatures )
+{
+  // the batch can only be filled straight from the feature map when every feature is returned unchanged
+  if ( mClosed || mUsingFeatureIdList || !mFilterRect.isNull() || mSubsetExpression || mTransform.isValid() )
+    return false;
+
+  while ( batch.size() < maxFeatures && mSelectIterator != mSource->mFeatures.constEnd() )
+  {
+    batch.appendFeature( mSelectIterator.value() );
+    ++mSelectIterator;
+  }
+
+  if ( mSelectIterator == mSource->mFeatures.constEnd() )
+    close();
+
+  return true;
+}
 
 bool QgsMemoryFeatureIterator::nextFeatureUsingList( QgsFeature &feature )
 {
@@ -253,7 +275,7 @@ bool QgsMemoryFeatureIterator::close()
 QgsMemoryFeatureSource::QgsMemoryFeatureSource( const QgsMemoryProvider *p )
   : mFields( p->mFields )
   , mFeatures( p->mFeatures )
-  , mSpatialIndex( p->mSpatialIndex ? qgis::make_unique< QgsSpatialIndex >( *p->mSpatialIndex ) : nullptr ) // just shallow copy
+  , mSpatialIndex( p->spatialIndex() ? qgis::make_unique< QgsSpatialIndex >( *p->spatialIndex() ) : nullptr ) // just shallow copy
   , mSubsetString( p->mSubsetString )
   , mCrs( p->mCrs )
 {
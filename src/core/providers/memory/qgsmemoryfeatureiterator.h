@@ -63,6 +63,7 @@ class QgsMemoryFeatureIterator final: public QgsAbstractFeatureIteratorFromSourc
   protected:
 
     bool fetchFeature( QgsFeature &feature ) override;
+    bool fetchBatch( QgsFeatureBatch &batch, int maxFeatures ) override;
 
   private:
     bool nextFeatureUsingList( QgsFeature &feature );
@@ -369,6 +369,7 @@ void QgsMemoryProvider::handlePostCloneOperations( QgsVectorDataProvider *source
     mFeatures = other->mFeatures;
     mNextFeatureId = other->mNextFeatureId;
     mExtent = other->mExtent;
+    mSpatialIndexDirty = true;
   }
 }
 
@@ -456,19 +457,15 @@ bool QgsMemoryProvider::addFeatures( QgsFeatureList &flist, Flags flags )
     mFeatures.insert( mNextFeatureId, *it );
     addedFids.insert( mNextFeatureId );
 
-    if ( it->hasGeometry() )
-    {
-      if ( updateExtent )
-        mExtent.combineExtentWith( it->geometry().boundingBox() );
-
-      // update spatial index
-      if ( mSpatialIndex )
-        mSpatialIndex->addFeature( *it );
-    }
+    if ( it->hasGeometry() && updateExtent )
+      mExtent.combineExtentWith( it->geometry().boundingBox() );
 
     mNextFeatureId++;
   }
 
+  // the spatial index is loaded again when read next
+  mSpatialIndexDirty = true;
+
   // Roll back
   if ( ! result && flags.testFlag( QgsFeatureSink::Flag::RollBackOnErrors ) )
   {
@@ -497,13 +494,12 @@ bool QgsMemoryProvider::deleteFeatures( const QgsFeatureIds &id )
     if ( fit == mFeatures.end() )
       continue;
 
-    // update spatial index
-    if ( mSpatialIndex )
-      mSpatialIndex->deleteFeature( *fit );
-
     mFeatures.erase( fit );
   }
 
+  // the spatial index is loaded again when read next
+  mSpatialIndexDirty = true;
+
   updateExtents();
   clearMinMaxCache();
 
@@ -654,17 +650,12 @@ bool QgsMemoryProvider::changeGeometryValues( const QgsGeometryMap &geometry_map
     if ( fit == mFeatures.end() )
       continue;
 
-    // update spatial index
-    if ( mSpatialIndex )
-      mSpatialIndex->deleteFeature( *fit );
-
     fit->setGeometry( it.value() );
-
-    // update spatial index
-    if ( mSpatialIndex )
-      mSpatialIndex->addFeature( *fit );
   }
 
+  // the spatial index is loaded again when read next
+  mSpatialIndexDirty = true;
+
   updateExtents();
 
   return true;
@@ -702,16 +693,26 @@ bool QgsMemoryProvider::createSpatialIndex()
   if ( !mSpatialIndex )
   {
     mSpatialIndex = new QgsSpatialIndex();
-
-    // add existing features to index
-    for ( QgsFeatureMap::iterator it = mFeatures.begin(); it != mFeatures.end(); ++it )
-    {
-      mSpatialIndex->addFeature( *it );
-    }
+    mSpatialIndexDirty = true;
   }
   return true;
 }
 
+const QgsSpatialIndex *QgsMemoryProvider::spatialIndex() const
+{
+  if ( mSpatialIndex && mSpatialIndexDirty )
+  {
+    // rather than updating the index on each edit, it is bulk loaded from all the features once
+    // they are read, which packs its nodes and is much faster than inserting them one by one
+    delete mSpatialIndex;
+    mSpatialIndex = nullptr;
+    mSpatialIndexDirty = false;
+    QgsFeatureIterator it( new QgsMemoryFeatureIterator( new QgsMemoryFeatureSource( this ), true, QgsFeatureRequest().setNoAttributes() ) );
+    mSpatialIndex = new QgsSpatialIndex( it );
+  }
+  return mSpatialIndex;
+}
+
 QgsFeatureSource::SpatialIndexPresence QgsMemoryProvider::hasSpatialIndex() const
 {
   return mSpatialIndex ? SpatialIndexPresent : SpatialIndexNotPresent;
@@ -727,6 +728,7 @@ QgsVectorDataProvider::Capabilities QgsMemoryProvider::capabilities() const
 bool QgsMemoryProvider::truncate()
 {
   mFeatures.clear();
+  mSpatialIndexDirty = true;
   clearMinMaxCache();
   mExtent.setMinimal();
   return true;
@@ -95,7 +95,15 @@ class QgsMemoryProvider final: public QgsVectorDataProvider
     QgsFeatureId mNextFeatureId;
 
     // indexing
-    QgsSpatialIndex *mSpatialIndex = nullptr;
+    mutable QgsSpatialIndex *mSpatialIndex = nullptr;
+    // TRUE when the features were edited since the spatial index was bulk loaded
+    mutable bool mSpatialIndexDirty = false;
+
+    /**
+     * Returns the spatial index, bulk loading it again first if the features were edited since,
+     * or NULLPTR if there is no spatial index.
+     */
+    const QgsSpatialIndex *spatialIndex() const;
 
     QString mSubsetString;
 
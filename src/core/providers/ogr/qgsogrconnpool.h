@@ -19,6 +19,7 @@
 #include "qgsconnectionpool.h"
 #include "qgsogrprovider.h"
 #include <gdal.h>
+#include <QThreadPool>
 #include "qgis_sip.h"
 
 ///@cond PRIVATE
@@ -66,8 +67,15 @@ class QgsOgrConnPoolGroup : public QObject, public QgsConnectionPoolGroup<QgsOgr
     Q_OBJECT
 
   public:
+    /**
+     * Constructor for a group of read only datasets on the data source \a name.
+     *
+     * Each connection is an independent GDAL dataset handle, so that iterators in different
+     * threads never wait on each other. The group holds at least as many connections as
+     * the global thread pool has threads, to let a parallel reader use all of them.
+     */
     explicit QgsOgrConnPoolGroup( const QString &name )
-      : QgsConnectionPoolGroup<QgsOgrConn*>( name )
+      : QgsConnectionPoolGroup<QgsOgrConn*>( name, std::max( QgsApplication::instance()->maxConcurrentConnectionsPerPool(), QThreadPool::globalInstance()->maxThreadCount() ) )
     {
       initTimer( this );
     }
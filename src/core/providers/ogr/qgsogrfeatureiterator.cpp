@@ -27,10 +27,15 @@
 #include "qgsexception.h"
 #include "qgswkbtypes.h"
 #include "qgsogrtransaction.h"
+#include "qgsfeaturebatch.h"
+#include "qgshotpathinstrumentation.h"
+#include "qgswkbptr.h"
 
 #include <QTextCodec>
 #include <QFile>
 
+#include <cstring>
+
 // using from provider:
 // - setRelevantFields(), mRelevantFieldsForNextFeature
 // - ogrLayer
@@ -40,6 +45,12 @@
 
 ///@cond PRIVATE
 
+// Starting with GDAL 2.2, there are 2 concepts: unset fields and null fields
+// whereas previously there was only unset fields. For QGIS purposes, both
+// states (unset/null) are equivalent.
+#ifndef OGRNullMarker
+#define OGR_F_IsFieldSetAndNotNull OGR_F_IsFieldSet
+#endif
 
 QgsOgrFeatureIterator::QgsOgrFeatureIterator( QgsOgrFeatureSource *source, bool ownSource, const QgsFeatureRequest &request )
   : QgsAbstractFeatureIteratorFromSource<QgsOgrFeatureSource>( source, ownSource, request )
@@ -102,7 +113,7 @@ QgsOgrFeatureIterator::QgsOgrFeatureIterator( QgsOgrFeatureSource *source, bool
       }
     }
   }
-  QMutexLocker locker( mSharedDS ? &mSharedDS->mutex() : nullptr );
+  QgsHotPathInstrumentation::MutexLocker locker( mSharedDS ? &mSharedDS->mutex() : nullptr, QgsHotPathInstrumentation::OgrDatasetLock );
 
   if ( mRequest.destinationCrs().isValid() && mRequest.destinationCrs() != mSource->mCrs )
   {
@@ -184,7 +195,16 @@ QgsOgrFeatureIterator::QgsOgrFeatureIterator( QgsOgrFeatureSource *source, bool
     QgsSqlExpressionCompiler *compiler = nullptr;
     if ( source->mDriverName == QLatin1String( "SQLite" ) || source->mDriverName == QLatin1String( "GPKG" ) )
     {
-      compiler = new QgsSQLiteExpressionCompiler( source->mFields );
+      QgsSQLiteExpressionCompiler *sqliteCompiler = new QgsSQLiteExpressionCompiler( source->mFields );
+      // the filter is only applied to the table itself if the subset string is not a SQL query
+      if ( source->mDriverName == QLatin1String( "GPKG" ) && ( !mOgrLayerOri || mOgrLayerOri == mOgrLayer ) )
+      {
+        sqliteCompiler->setGeoPackageTable( QString::fromUtf8( OGR_L_GetName( mOgrLayer ) ),
+                                            QString::fromUtf8( OGR_L_GetGeometryColumn( mOgrLayer ) ),
+                                            QString::fromUtf8( OGR_L_GetFIDColumn( mOgrLayer ) ),
+                                            OGR_L_TestCapability( mOgrLayer, OLCFastSpatialFilter ) );
+      }
+      compiler = sqliteCompiler;
     }
     else
     {
@@ -206,6 +226,9 @@ QgsOgrFeatureIterator::QgsOgrFeatureIterator( QgsOgrFeatureSource *source, bool
         //if only partial success when compiling expression, we need to double-check results using QGIS' expressions
         mExpressionCompiled = ( result == QgsSqlExpressionCompiler::Complete );
         mCompileStatus = ( mExpressionCompiled ? Compiled : PartiallyCompiled );
+        QgsDebugMsgLevel( QStringLiteral( "Filter %1 %2 compiled to: %3" ).arg( request.filterExpression()->expression(),
+                          mExpressionCompiled ? QStringLiteral( "fully" ) : QStringLiteral( "partially" ),
+                          compiler->result() ), 2 );
       }
       else if ( !mSource->mSubsetString.isEmpty() )
       {
@@ -318,13 +341,19 @@ bool QgsOgrFeatureIterator::checkFeature( gdal::ogr_feature_unique_ptr &fet, Qgs
 
 bool QgsOgrFeatureIterator::fetchFeature( QgsFeature &feature )
 {
-  QMutexLocker locker( mSharedDS ? &mSharedDS->mutex() : nullptr );
+  QgsHotPathInstrumentation::MutexLocker locker( mSharedDS ? &mSharedDS->mutex() : nullptr, QgsHotPathInstrumentation::OgrDatasetLock );
 
   feature.setValid( false );
 
   if ( mClosed || !mOgrLayer )
     return false;
 
+#if GDAL_VERSION_NUM >= GDAL_COMPUTE_VERSION(3,6,0)
+  if ( mArrowStreamActive )
+    return fetchArrowFeature( feature );
+#endif
+  mReadStarted = true;
+
   if ( mRequest.filterType() == QgsFeatureRequest::FilterFid )
   {
     bool result = fetchFeatureWithId( mRequest.filterFid(), feature );
@@ -379,6 +408,384 @@ bool QgsOgrFeatureIterator::fetchFeature( QgsFeature &feature )
   return false;
 }
 
+bool QgsOgrFeatureIterator::canFetchBatch( const QgsFeatureBatch &batch ) const
+{
+  // the features must be stored as read from the layer, the filters and the transformation are applied to QgsFeature
+  if ( mRequest.filterType() != QgsFeatureRequest::FilterNone || !mFilterRect.isNull() || mTransform.isValid() ||
+       mSource->mOgrGeometryTypeFilter != wkbUnknown || ( batch.hasGeometry() && !mFetchGeometry ) ||
+       !QgsOgrProviderUtils::canDriverShareSameDatasetAmongLayers( mSource->mDriverName ) )
+    return false;
+
+  // the attributes of the batch must have been requested, the others are ignored by the layer
+  if ( mRequest.flags() & QgsFeatureRequest::SubsetOfAttributes )
+  {
+    const QgsAttributeList attrs = mRequest.subsetOfAttributes();
+    for ( int column = 0; column < batch.columnCount(); ++column )
+    {
+      if ( !attrs.contains( batch.attributeIndex( column ) ) )
+        return false;
+    }
+  }
+  return true;
+}
+
+QByteArray QgsOgrFeatureIterator::batchWkb( const char *data, int size ) const
+{
+  if ( QgsWkbTypes::isMultiType( mSource->mWkbType ) && size > 0 )
+  {
+    // Insure that multipart datasets return multipart geometry
+    QgsConstWkbPtr wkbPtr( reinterpret_cast< const unsigned char * >( data ), size );
+    if ( !QgsWkbTypes::isMultiType( wkbPtr.readHeader() ) )
+    {
+      QgsGeometry g;
+      g.fromWkb( QByteArray( data, size ) );
+      g.convertToMultiType();
+      return g.asWkb();
+    }
+  }
+  return QByteArray( data, size );
+}
+
+void QgsOgrFeatureIterator::appendToBatch( OGRFeatureH fet, QgsFeatureBatch &batch ) const
+{
+  batch.appendFeatureId( OGR_F_GetFID( fet ) );
+
+  const bool utf8 = !mSource->mEncoding || mSource->mEncoding->mibEnum() == 106;
+  for ( int column = 0; column < batch.columnCount(); ++column )
+  {
+    const int attindex = batch.attributeIndex( column );
+    if ( mFirstFieldIsFid && attindex == 0 )
+    {
+      batch.appendInt64( column, OGR_F_GetFID( fet ) );
+      continue;
+    }
+
+    const int attindexWithoutFid = ( mFirstFieldIsFid ) ? attindex - 1 : attindex;
+    if ( !OGR_F_IsFieldSetAndNotNull( fet, attindexWithoutFid ) )
+    {
+      batch.appendNull( column );
+      continue;
+    }
+
+    // numbers and UTF-8 strings are stored straight from OGR, without boxing them in a QVariant
+    switch ( mFieldsWithoutFid.at( attindexWithoutFid ).type() )
+    {
+      case QVariant::Int:
+      case QVariant::Bool:
+      case QVariant::LongLong:
+        batch.appendInt64( column, OGR_F_GetFieldAsInteger64( fet, attindexWithoutFid ) );
+        break;
+
+      case QVariant::Double:
+        batch.appendDouble( column, OGR_F_GetFieldAsDouble( fet, attindexWithoutFid ) );
+        break;
+
+      case QVariant::String:
+        if ( utf8 )
+        {
+          const char *value = OGR_F_GetFieldAsString( fet, attindexWithoutFid );
+          batch.appendString( column, value, static_cast< int >( std::strlen( value ) ) );
+          break;
+        }
+        FALLTHROUGH
+
+      default:
+        batch.appendValue( column, QgsOgrUtils::getOgrFeatureAttribute( fet, mFieldsWithoutFid, attindexWithoutFid, mSource->mEncoding ) );
+        break;
+    }
+  }
+
+  if ( batch.hasGeometry() )
+  {
+    OGRGeometryH geom = OGR_F_GetGeometryRef( fet );
+    if ( geom )
+    {
+      QgsGeometry g = QgsOgrUtils::ogrGeometryToQgsGeometry( geom );
+      if ( QgsWkbTypes::isMultiType( mSource->mWkbType ) && !g.isMultipart() )
+        g.convertToMultiType();
+      batch.appendWkb( g.asWkb() );
+    }
+    else
+    {
+      batch.appendWkb( QByteArray() );
+    }
+  }
+}
+
+bool QgsOgrFeatureIterator::fetchBatch( QgsFeatureBatch &batch, int maxFeatures )
+{
+  QgsHotPathInstrumentation::MutexLocker locker( mSharedDS ? &mSharedDS->mutex() : nullptr, QgsHotPathInstrumentation::OgrDatasetLock );
+
+  if ( mClosed || !mOgrLayer || !canFetchBatch( batch ) )
+    return false;
+
+#if GDAL_VERSION_NUM >= GDAL_COMPUTE_VERSION(3,6,0)
+  if ( !mArrowStreamActive && !mReadStarted )
+    startArrowStream( batch, maxFeatures );
+
+  if ( mArrowStreamActive )
+  {
+    appendArrowRows( batch, maxFeatures );
+    if ( mArrowStreamEnded )
+      close();
+    return true;
+  }
+#endif
+
+  mReadStarted = true;
+  gdal::ogr_feature_unique_ptr fet;
+  while ( batch.size() < maxFeatures )
+  {
+    fet.reset( OGR_L_GetNextFeature( mOgrLayer ) );
+    if ( !fet )
+    {
+      close();
+      break;
+    }
+    appendToBatch( fet.get(), batch );
+  }
+  return true;
+}
+
+#if GDAL_VERSION_NUM >= GDAL_COMPUTE_VERSION(3,6,0)
+
+static bool arrowValueIsNull( const ArrowArray *array, qint64 row )
+{
+  if ( array->null_count == 0 || !array->buffers[0] )
+    return false;
+  const qint64 i = array->offset + row;
+  return !( static_cast< const unsigned char * >( array->buffers[0] )[i / 8] & ( 1 << ( i % 8 ) ) );
+}
+
+//! Returns TRUE if the values of an Arrow array with the \a schema can be appended to a batch
+static bool arrowFormatIsSupported( const ArrowSchema *schema )
+{
+  const char *format = schema->format;
+  return !schema->dictionary && format[0] && !format[1] && std::strchr( "cslbfguU", format[0] );
+}
+
+static void appendArrowValue( QgsFeatureBatch &batch, int column, const ArrowSchema *schema, const ArrowArray *array, qint64 row )
+{
+  if ( arrowValueIsNull( array, row ) )
+  {
+    batch.appendNull( column );
+    return;
+  }
+
+  const qint64 i = array->offset + row;
+  switch ( schema->format[0] )
+  {
+    case 'c':
+      batch.appendInt64( column, static_cast< const int8_t * >( array->buffers[1] )[i] );
+      break;
+    case 's':
+      batch.appendInt64( column, static_cast< const int16_t * >( array->buffers[1] )[i] );
+      break;
+    case 'i':
+      batch.appendInt64( column, static_cast< const int32_t * >( array->buffers[1] )[i] );
+      break;
+    case 'l':
+      batch.appendInt64( column, static_cast< const int64_t * >( array->buffers[1] )[i] );
+      break;
+    case 'b':
+      batch.appendInt64( column, ( static_cast< const unsigned char * >( array->buffers[1] )[i / 8] >> ( i % 8 ) ) & 1 );
+      break;
+    case 'f':
+      batch.appendDouble( column, static_cast< const float * >( array->buffers[1] )[i] );
+      break;
+    case 'g':
+      batch.appendDouble( column, static_cast< const double * >( array->buffers[1] )[i] );
+      break;
+    case 'u':
+    {
+      const int32_t *offsets = static_cast< const int32_t * >( array->buffers[1] );
+      batch.appendString( column, static_cast< const char * >( array->buffers[2] ) + offsets[i], offsets[i + 1] - offsets[i] );
+      break;
+    }
+    case 'U':
+    {
+      const int64_t *offsets = static_cast< const int64_t * >( array->buffers[1] );
+      batch.appendString( column, static_cast< const char * >( array->buffers[2] ) + offsets[i], static_cast< int >( offsets[i + 1] - offsets[i] ) );
+      break;
+    }
+  }
+}
+
+bool QgsOgrFeatureIterator::startArrowStream( const QgsFeatureBatch &batch, int maxFeatures )
+{
+  // the strings of the stream are UTF-8
+  if ( ( mSource->mEncoding && mSource->mEncoding->mibEnum() != 106 ) || !OGR_L_TestCapability( mOgrLayer, OLCFastGetArrowStream ) )
+    return false;
+
+  char **options = CSLSetNameValue( nullptr, "INCLUDE_FID", "YES" );
+  options = CSLSetNameValue( options, "MAX_FEATURES_IN_BATCH", QByteArray::number( maxFeatures ).constData() );
+  const bool opened = OGR_L_GetArrowStream( mOgrLayer, &mArrowStream, options );
+  CSLDestroy( options );
+  if ( !opened )
+    return false;
+  mArrowStreamActive = true;
+
+  if ( mArrowStream.get_schema( &mArrowStream, &mArrowSchema ) != 0 )
+  {
+    releaseArrowStream();
+    return false;
+  }
+
+  // the ignored fields are not in the stream, the others are looked up by their OGR name
+  OGRFeatureDefnH featureDefn = OGR_L_GetLayerDefn( mOgrLayer );
+  const char *fidColumn = OGR_L_GetFIDColumn( mOgrLayer );
+  const char *geometryColumn = OGR_L_GetGeometryColumn( mOgrLayer );
+  mArrowChildForAttribute.fill( -1, mSource->mFields.count() );
+  mArrowFidChild = -1;
+  mArrowGeometryChild = -1;
+  bool supported = true;
+  for ( int child = 0; child < mArrowSchema.n_children; ++child )
+  {
+    const ArrowSchema *childSchema = mArrowSchema.children[child];
+    if ( std::strcmp( childSchema->name, fidColumn[0] ? fidColumn : "OGC_FID" ) == 0 )
+    {
+      mArrowFidChild = child;
+      continue;
+    }
+    if ( std::strcmp( childSchema->name, geometryColumn[0] ? geometryColumn : "wkb_geometry" ) == 0 )
+    {
+      mArrowGeometryChild = child;
+      supported = supported && ( std::strcmp( childSchema->format, "z" ) == 0 || std::strcmp( childSchema->format, "Z" ) == 0 );
+      continue;
+    }
+
+    const int ogrIndex = OGR_FD_GetFieldIndex( featureDefn, childSchema->name );
+    const int attindex = ( mFirstFieldIsFid ) ? ogrIndex + 1 : ogrIndex;
+    if ( ogrIndex >= 0 && attindex < mArrowChildForAttribute.size() )
+      mArrowChildForAttribute[attindex] = child;
+    supported = supported && arrowFormatIsSupported( childSchema );
+  }
+
+  if ( !supported || mArrowFidChild < 0 || ( batch.hasGeometry() && mArrowGeometryChild < 0 && OGR_L_GetGeomType( mOgrLayer ) != wkbNone ) )
+  {
+    releaseArrowStream();
+    resetReading();
+    return false;
+  }
+  mArrowRow = 0;
+  mArrowStreamEnded = false;
+  mReadStarted = true;
+  return true;
+}
+
+void QgsOgrFeatureIterator::releaseArrowStream()
+{
+  if ( mArrowArray.release )
+    mArrowArray.release( &mArrowArray );
+  if ( mArrowSchema.release )
+    mArrowSchema.release( &mArrowSchema );
+  if ( mArrowStream.release )
+    mArrowStream.release( &mArrowStream );
+  mArrowStreamActive = false;
+}
+
+void QgsOgrFeatureIterator::appendArrowRows( QgsFeatureBatch &batch, int maxFeatures )
+{
+  while ( batch.size() < maxFeatures && !mArrowStreamEnded )
+  {
+    if ( !mArrowArray.release || mArrowRow >= mArrowArray.length )
+    {
+      if ( mArrowArray.release )
+        mArrowArray.release( &mArrowArray );
+      mArrowRow = 0;
+      if ( mArrowStream.get_next( &mArrowStream, &mArrowArray ) != 0 )
+      {
+        const char *error = mArrowStream.get_last_error( &mArrowStream );
+        QgsMessageLog::logMessage( QObject::tr( "Error reading features from %1: %2" ).arg( mSource->mLayerName, QString::fromUtf8( error ? error : "" ) ), QObject::tr( "OGR" ) );
+        mArrowStreamEnded = true;
+        break;
+      }
+      // a released array marks the end of the stream
+      if ( !mArrowArray.release )
+      {
+        mArrowStreamEnded = true;
+        break;
+      }
+      continue;
+    }
+
+    const qint64 rows = std::min< qint64 >( maxFeatures - batch.size(), mArrowArray.length - mArrowRow );
+    const ArrowArray *fids = mArrowArray.children[mArrowFidChild];
+    const ArrowArray *geometries = mArrowGeometryChild >= 0 ? mArrowArray.children[mArrowGeometryChild] : nullptr;
+    for ( qint64 row = mArrowArray.offset + mArrowRow; row < mArrowArray.offset + mArrowRow + rows; ++row )
+    {
+      const QgsFeatureId fid = static_cast< const int64_t * >( fids->buffers[1] )[fids->offset + row];
+      batch.appendFeatureId( fid );
+      for ( int column = 0; column < batch.columnCount(); ++column )
+      {
+        const int attindex = batch.attributeIndex( column );
+        const int child = mArrowChildForAttribute.at( attindex );
+        if ( mFirstFieldIsFid && attindex == 0 )
+          batch.appendInt64( column, fid );
+        else if ( child < 0 )
+          batch.appendNull( column );
+        else
+          appendArrowValue( batch, column, mArrowSchema.children[child], mArrowArray.children[child], row );
+      }
+
+      if ( !batch.hasGeometry() )
+        continue;
+      if ( !geometries || arrowValueIsNull( geometries, row ) )
+      {
+        batch.appendWkb( QByteArray() );
+        continue;
+      }
+      const qint64 i = geometries->offset + row;
+      const char *data = static_cast< const char * >( geometries->buffers[2] );
+      if ( mArrowSchema.children[mArrowGeometryChild]->format[0] == 'Z' )
+      {
+        const int64_t *offsets = static_cast< const int64_t * >( geometries->buffers[1] );
+        batch.appendWkb( batchWkb( data + offsets[i], static_cast< int >( offsets[i + 1] - offsets[i] ) ) );
+      }
+      else
+      {
+        const int32_t *offsets = static_cast< const int32_t * >( geometries->buffers[1] );
+        batch.appendWkb( batchWkb( data + offsets[i], offsets[i + 1] - offsets[i] ) );
+      }
+    }
+    mArrowRow += rows;
+  }
+}
+
+bool QgsOgrFeatureIterator::fetchArrowFeature( QgsFeature &feature )
+{
+  const QgsAttributeList attrs = ( mRequest.flags() & QgsFeatureRequest::SubsetOfAttributes ) ? mRequest.subsetOfAttributes() : mSource->mFields.allAttributesList();
+  QgsFeatureBatch batch( mSource->mFields, attrs, mFetchGeometry );
+  appendArrowRows( batch, 1 );
+  if ( batch.isEmpty() )
+  {
+    close();
+    return false;
+  }
+
+  feature.setId( batch.featureIds().at( 0 ) );
+  feature.initAttributes( mSource->mFields.count() );
+  feature.setFields( mSource->mFields ); // allow name-based attribute lookups
+  for ( int column = 0; column < batch.columnCount(); ++column )
+    feature.setAttribute( batch.attributeIndex( column ), batch.value( column, 0 ) );
+
+  const QByteArray wkb = batch.wkb( 0 );
+  if ( wkb.isEmpty() )
+  {
+    feature.clearGeometry();
+  }
+  else
+  {
+    QgsGeometry g;
+    g.fromWkb( wkb );
+    feature.setGeometry( g );
+  }
+  feature.setValid( true );
+  return true;
+}
+
+#endif
+
 void QgsOgrFeatureIterator::resetReading()
 {
 #if GDAL_VERSION_NUM >= GDAL_COMPUTE_VERSION(2,2,0)
@@ -396,12 +803,16 @@ void QgsOgrFeatureIterator::resetReading()
 
 bool QgsOgrFeatureIterator::rewind()
 {
-  QMutexLocker locker( mSharedDS ? &mSharedDS->mutex() : nullptr );
+  QgsHotPathInstrumentation::MutexLocker locker( mSharedDS ? &mSharedDS->mutex() : nullptr, QgsHotPathInstrumentation::OgrDatasetLock );
 
   if ( mClosed || !mOgrLayer )
     return false;
 
+#if GDAL_VERSION_NUM >= GDAL_COMPUTE_VERSION(3,6,0)
+  releaseArrowStream();
+#endif
   resetReading();
+  mReadStarted = false;
 
   mFilterFidsIt = mFilterFids.begin();
 
@@ -411,6 +822,10 @@ bool QgsOgrFeatureIterator::rewind()
 
 bool QgsOgrFeatureIterator::close()
 {
+#if GDAL_VERSION_NUM >= GDAL_COMPUTE_VERSION(3,6,0)
+  releaseArrowStream();
+#endif
+
   if ( mSharedDS )
   {
     iteratorClosed();
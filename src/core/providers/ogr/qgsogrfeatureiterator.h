@@ -74,10 +74,52 @@ class QgsOgrFeatureIterator final: public QgsAbstractFeatureIteratorFromSource<Q
   protected:
     bool checkFeature( gdal::ogr_feature_unique_ptr &fet, QgsFeature &feature ) ;
     bool fetchFeature( QgsFeature &feature ) override;
+    bool fetchBatch( QgsFeatureBatch &batch, int maxFeatures ) override;
     bool nextFeatureFilterExpression( QgsFeature &f ) override;
 
   private:
 
+    //! Returns TRUE if the features read from the layer can be stored in \a batch without any filtering or transformation
+    bool canFetchBatch( const QgsFeatureBatch &batch ) const;
+
+    //! Appends the OGR feature \a fet to \a batch, without building a QgsFeature
+    void appendToBatch( OGRFeatureH fet, QgsFeatureBatch &batch ) const;
+
+    //! Returns the WKB of a geometry to store in a batch, converted to multipart if the layer is multipart
+    QByteArray batchWkb( const char *data, int size ) const;
+
+#if GDAL_VERSION_NUM >= GDAL_COMPUTE_VERSION(3,6,0)
+
+    /**
+     * Starts reading the layer by columnar batches through its Arrow stream.
+     * Returns FALSE if the layer has no fast Arrow stream, or if a column of \a batch cannot be read from it.
+     */
+    bool startArrowStream( const QgsFeatureBatch &batch, int maxFeatures );
+
+    //! Releases the Arrow stream and the array being read
+    void releaseArrowStream();
+
+    //! Appends at most \a maxFeatures rows of the Arrow stream to \a batch, sets mArrowStreamEnded at the end of the stream
+    void appendArrowRows( QgsFeatureBatch &batch, int maxFeatures );
+
+    //! Reads the next feature from the Arrow stream, once the iterator has started reading batches from it
+    bool fetchArrowFeature( QgsFeature &feature );
+
+    ArrowArrayStream mArrowStream {};
+    ArrowSchema mArrowSchema {};
+    ArrowArray mArrowArray {};
+    qint64 mArrowRow = 0;
+    bool mArrowStreamActive = false;
+    bool mArrowStreamEnded = false;
+    //! Index of the child array of each field in the Arrow stream, -1 if the field is not read
+    QVector<int> mArrowChildForAttribute;
+    int mArrowFidChild = -1;
+    int mArrowGeometryChild = -1;
+#endif
+
+    //! TRUE once features have been read from the layer since the last rewind
+    bool mReadStarted = false;
+
     bool readFeature( gdal::ogr_feature_unique_ptr fet, QgsFeature &feature ) const;
 
     //! Gets an attribute associated with a feature
@@ -2934,7 +2934,9 @@ QString createFilters( const QString &type )
   static QStringList sWildcards;
 
   // if we've already built the supported vector string, just return what
-  // we've already built
+  // we've already built, the filters may be requested concurrently by the browser threads
+  static QMutex sFiltersMutex;
+  QMutexLocker locker( &sFiltersMutex );
 
   if ( sFileFilters.isEmpty() || sFileFilters.isNull() )
   {
@@ -219,6 +219,32 @@ class CORE_EXPORT QgsAbstractContentCache : public QgsAbstractContentCacheBase
       qDeleteAll( mEntryLookup );
     }
 
+    /**
+     * Returns the maximum allowable total size of the cache, in bytes.
+     *
+     * \see setMaxCacheSize()
+     * \since QGIS 3.16
+     */
+    long maxCacheSize() const
+    {
+      QMutexLocker locker( &mMutex );
+      return mMaxCacheSize;
+    }
+
+    /**
+     * Sets the maximum allowable total \a size of the cache, in bytes. The least used
+     * entries are removed if the cache is already larger.
+     *
+     * \see maxCacheSize()
+     * \since QGIS 3.16
+     */
+    void setMaxCacheSize( long size )
+    {
+      QMutexLocker locker( &mMutex );
+      mMaxCacheSize = size;
+      trimToMaximumSize();
+    }
+
   protected:
 
     /**
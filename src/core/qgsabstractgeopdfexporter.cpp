@@ -26,11 +26,13 @@
 #include <gdal.h>
 #include "qgsgdalutils.h"
 #include "cpl_string.h"
+#include "cpl_vsi.h"
 
 #include <QMutex>
 #include <QMutexLocker>
 #include <QDomDocument>
 #include <QDomElement>
+#include <QtConcurrentMap>
 
 
 bool QgsAbstractGeoPdfExporter::geoPDFCreationAvailable()
@@ -105,18 +107,16 @@ bool QgsAbstractGeoPdfExporter::finalize( const QList<ComponentLayerDetail> &com
     return false;
   }
 
-  const QString xmlFilePath = generateTemporaryFilepath( QStringLiteral( "composition.xml" ) );
-  QFile file( xmlFilePath );
-  if ( file.open( QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate ) )
-  {
-    QTextStream out( &file );
-    out << composition;
-  }
-  else
+  // the composition is passed to GDAL through an in-memory file, instead of a temporary file on disk
+  const QString xmlFilePath = QStringLiteral( "/vsimem/geopdf_composition_%1.xml" ).arg( reinterpret_cast< quintptr >( this ) );
+  const QByteArray compositionData = composition.toUtf8();
+  VSILFILE *xmlFile = VSIFileFromMemBuffer( xmlFilePath.toUtf8().constData(), reinterpret_cast< GByte * >( const_cast< char * >( compositionData.constData() ) ), compositionData.size(), FALSE );
+  if ( !xmlFile )
   {
     mErrorMessage = QObject::tr( "Could not create GeoPDF composition file" );
     return false;
   }
+  VSIFCloseL( xmlFile );
 
   char **papszOptions = CSLSetNameValue( nullptr, "COMPOSITION_FILE", xmlFilePath.toUtf8().constData() );
 
@@ -126,6 +126,7 @@ bool QgsAbstractGeoPdfExporter::finalize( const QList<ComponentLayerDetail> &com
   outputDataset.reset();
 
   CSLDestroy( papszOptions );
+  VSIUnlink( xmlFilePath.toUtf8().constData() );
 
   return res;
 #endif
@@ -173,42 +174,63 @@ void QgsAbstractGeoPdfExporter::pushRenderedFeature( const QString &layerId, con
 
 bool QgsAbstractGeoPdfExporter::saveTemporaryLayers()
 {
+  // the component details are collected first, as componentDetailForLayerId() may access the project
+  // and the layout, then each layer is written to its own dataset in parallel
+  struct TemporaryLayer
+  {
+    VectorComponentDetail detail;
+    QgsFeatureList features;
+    QString errorMessage;
+  };
+  QList< TemporaryLayer > temporaryLayers;
   for ( auto groupIt = mCollatedFeatures.constBegin(); groupIt != mCollatedFeatures.constEnd(); ++groupIt )
   {
     for ( auto it = groupIt->constBegin(); it != groupIt->constEnd(); ++it )
     {
-      const QString filePath = generateTemporaryFilepath( it.key() + groupIt.key() + QStringLiteral( ".gpkg" ) );
-
-      VectorComponentDetail detail = componentDetailForLayerId( it.key() );
-      detail.sourceVectorPath = filePath;
-      detail.group = groupIt.key();
-
-      // write out features to disk
-      const QgsFeatureList features = it.value();
-      QString layerName;
-      QgsVectorFileWriter::SaveVectorOptions saveOptions;
-      saveOptions.driverName = QStringLiteral( "GPKG" );
-      saveOptions.symbologyExport = QgsVectorFileWriter::NoSymbology;
-      std::unique_ptr< QgsVectorFileWriter > writer( QgsVectorFileWriter::create( filePath, features.first().fields(), features.first().geometry().wkbType(), QgsCoordinateReferenceSystem(), QgsCoordinateTransformContext(), saveOptions, QgsFeatureSink::RegeneratePrimaryKey, nullptr, &layerName ) );
-      if ( writer->hasError() )
-      {
-        mErrorMessage = writer->errorMessage();
-        QgsDebugMsg( mErrorMessage );
-        return false;
-      }
-      for ( const QgsFeature &feature : features )
+      TemporaryLayer temporaryLayer;
+      temporaryLayer.detail = componentDetailForLayerId( it.key() );
+      temporaryLayer.detail.sourceVectorPath = generateTemporaryFilepath( it.key() + groupIt.key() + QStringLiteral( ".gpkg" ) );
+      temporaryLayer.detail.group = groupIt.key();
+      temporaryLayer.features = it.value();
+      temporaryLayers << temporaryLayer;
+    }
+  }
+
+  QtConcurrent::blockingMap( temporaryLayers, []( TemporaryLayer & temporaryLayer )
+  {
+    // write out features to disk
+    const QgsFeatureList &features = temporaryLayer.features;
+    QString layerName;
+    QgsVectorFileWriter::SaveVectorOptions saveOptions;
+    saveOptions.driverName = QStringLiteral( "GPKG" );
+    saveOptions.symbologyExport = QgsVectorFileWriter::NoSymbology;
+    std::unique_ptr< QgsVectorFileWriter > writer( QgsVectorFileWriter::create( temporaryLayer.detail.sourceVectorPath, features.first().fields(), features.first().geometry().wkbType(), QgsCoordinateReferenceSystem(), QgsCoordinateTransformContext(), saveOptions, QgsFeatureSink::RegeneratePrimaryKey, nullptr, &layerName ) );
+    if ( writer->hasError() )
+    {
+      temporaryLayer.errorMessage = writer->errorMessage();
+      return;
+    }
+    for ( const QgsFeature &feature : features )
+    {
+      QgsFeature f = feature;
+      if ( !writer->addFeature( f, QgsFeatureSink::FastInsert ) )
       {
-        QgsFeature f = feature;
-        if ( !writer->addFeature( f, QgsFeatureSink::FastInsert ) )
-        {
-          mErrorMessage = writer->errorMessage();
-          QgsDebugMsg( mErrorMessage );
-          return false;
-        }
+        temporaryLayer.errorMessage = writer->errorMessage();
+        return;
       }
-      detail.sourceVectorLayer = layerName;
-      mVectorComponents << detail;
     }
+    temporaryLayer.detail.sourceVectorLayer = layerName;
+  } );
+
+  for ( const TemporaryLayer &temporaryLayer : qgis::as_const( temporaryLayers ) )
+  {
+    if ( !temporaryLayer.errorMessage.isEmpty() )
+    {
+      mErrorMessage = temporaryLayer.errorMessage;
+      QgsDebugMsg( mErrorMessage );
+      return false;
+    }
+    mVectorComponents << temporaryLayer.detail;
   }
   return true;
 }
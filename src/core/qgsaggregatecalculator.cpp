@@ -17,12 +17,105 @@
 
 #include "qgsaggregatecalculator.h"
 #include "qgsfeature.h"
+#include "qgsfeaturebatch.h"
 #include "qgsfeaturerequest.h"
 #include "qgsfeatureiterator.h"
 #include "qgsgeometry.h"
 #include "qgsvectorlayer.h"
+#include "qgsexpressionfunction.h"
 
+#include <QThreadPool>
+#include <QtConcurrentMap>
 
+#include <functional>
+
+//! Number of features whose expression values are evaluated in parallel at once
+static const int PARALLEL_BATCH_SIZE = 8192;
+
+//! Number of features whose expression values are evaluated by a single task
+static const int PARALLEL_TASK_SIZE = 512;
+
+/**
+ * Returns TRUE if the values of \a expression can be evaluated from several threads at once:
+ * the functions reading other features, keeping a state or having side effects are evaluated
+ * in the calling thread, in the order of the features.
+ */
+static bool canEvaluateInParallel( const QgsExpression &expression )
+{
+  if ( QThreadPool::globalInstance()->maxThreadCount() < 2 )
+    return false;
+
+  const QSet<QString> functions = expression.referencedFunctions();
+  for ( const QString &function : functions )
+  {
+    if ( function == QLatin1String( "get_feature" ) || function == QLatin1String( "get_feature_by_id" )
+         || function == QLatin1String( "eval" ) || function == QLatin1String( "rand" ) || function == QLatin1String( "randf" )
+         || function == QLatin1String( "sqlite_fetch_and_increment" ) || function == QLatin1String( "represent_value" ) )
+      return false;
+
+    const int index = QgsExpression::functionIndex( function );
+    if ( index >= 0 && QgsExpression::Functions().at( index )->groups().contains( QStringLiteral( "Aggregates" ) ) )
+      return false;
+  }
+  return true;
+}
+
+/**
+ * Evaluates \a expression for the features of \a fit and passes the values to \a addValue, in
+ * the order of the features. The values of batches of features are evaluated in parallel, each
+ * task with its own copy of the expression and of the \a context.
+ */
+static void evaluateExpression( QgsFeatureIterator &fit, QgsExpression *expression, QgsExpressionContext *context, const std::function< void( const QVariant & ) > &addValue )
+{
+  QgsFeature f;
+  if ( !canEvaluateInParallel( *expression ) )
+  {
+    while ( fit.nextFeature( f ) )
+    {
+      context->setFeature( f );
+      addValue( expression->evaluate( context ) );
+    }
+    return;
+  }
+
+  const QString expressionString = expression->expression();
+  QVector< QgsFeature > features;
+  features.reserve( PARALLEL_BATCH_SIZE );
+  QVector< QVariant > values;
+  bool moreFeatures = true;
+  while ( moreFeatures )
+  {
+    features.clear();
+    while ( features.size() < PARALLEL_BATCH_SIZE && ( moreFeatures = fit.nextFeature( f ) ) )
+      features << f;
+    if ( features.isEmpty() )
+      break;
+
+    values.fill( QVariant(), features.size() );
+    const QgsFeature *featureData = features.constData();
+    QVariant *valueData = values.data();
+    const int count = features.size();
+    QVector< int > starts;
+    for ( int start = 0; start < count; start += PARALLEL_TASK_SIZE )
+      starts << start;
+
+    QtConcurrent::blockingMap( starts, [ =, &expressionString ]( int start )
+    {
+      QgsExpressionContext taskContext( *context );
+      QgsExpression taskExpression( expressionString );
+      taskExpression.prepare( &taskContext );
+      const int end = std::min( start + PARALLEL_TASK_SIZE, count );
+      for ( int i = start; i < end; ++i )
+      {
+        taskContext.setFeature( featureData[i] );
+        valueData[i] = taskExpression.evaluate( &taskContext );
+      }
+    } );
+
+    for ( const QVariant &value : qgis::as_const( values ) )
+      addValue( value );
+  }
+}
 
 QgsAggregateCalculator::QgsAggregateCalculator( const QgsVectorLayer *layer )
   : mLayer( layer )
@@ -124,7 +217,7 @@ QVariant QgsAggregateCalculator::calculate( QgsAggregateCalculator::Aggregate ag
     resultType = mLayer->fields().at( attrNum ).type();
 
   QgsFeatureIterator fit = mLayer->getFeatures( request );
-  return calculate( aggregate, fit, resultType, attrNum, expression.get(), mDelimiter, context, ok );
+  return calculate( aggregate, fit, resultType, attrNum, expression.get(), mDelimiter, context, ok, mLayer->fields() );
 }
 
 QgsAggregateCalculator::Aggregate QgsAggregateCalculator::stringToAggregate( const QString &string, bool *ok )
@@ -416,7 +509,7 @@ QList<QgsAggregateCalculator::AggregateInfo> QgsAggregateCalculator::aggregates(
 }
 
 QVariant QgsAggregateCalculator::calculate( QgsAggregateCalculator::Aggregate aggregate, QgsFeatureIterator &fit, QVariant::Type resultType,
-    int attr, QgsExpression *expression, const QString &delimiter, QgsExpressionContext *context, bool *ok )
+    int attr, QgsExpression *expression, const QString &delimiter, QgsExpressionContext *context, bool *ok, const QgsFields &fields )
 {
   if ( ok )
     *ok = false;
@@ -443,7 +536,7 @@ QVariant QgsAggregateCalculator::calculate( QgsAggregateCalculator::Aggregate ag
 
       if ( ok )
         *ok = true;
-      return calculateNumericAggregate( fit, attr, expression, context, stat );
+      return calculateNumericAggregate( fit, attr, expression, context, stat, fields );
     }
 
     case QVariant::Date:
@@ -664,26 +757,41 @@ QgsDateTimeStatisticalSummary::Statistic QgsAggregateCalculator::dateTimeStatFro
 }
 
 QVariant QgsAggregateCalculator::calculateNumericAggregate( QgsFeatureIterator &fit, int attr, QgsExpression *expression,
-    QgsExpressionContext *context, QgsStatisticalSummary::Statistic stat )
+    QgsExpressionContext *context, QgsStatisticalSummary::Statistic stat, const QgsFields &fields )
 {
   Q_ASSERT( expression || attr >= 0 );
 
   QgsStatisticalSummary s( stat );
-  QgsFeature f;
 
-  while ( fit.nextFeature( f ) )
+  if ( !expression && attr < fields.count() )
   {
-    if ( expression )
+    // plain field aggregates only need one column, fetch it in batches
+    QgsFeatureBatch batch( fields, QgsAttributeList() << attr );
+    while ( fit.nextBatch( batch, 4096 ) > 0 )
     {
-      Q_ASSERT( context );
-      context->setFeature( f );
-      QVariant v = expression->evaluate( context );
-      s.addVariant( v );
+      for ( int i = 0; i < batch.size(); ++i )
+      {
+        if ( batch.isNull( 0, i ) )
+          s.addVariant( QVariant() );
+        else
+          s.addValue( batch.doubleValue( 0, i ) );
+      }
     }
-    else
-    {
+    s.finalize();
+    double val = s.statistic( stat );
+    return std::isnan( val ) ? QVariant() : val;
+  }
+
+  if ( expression )
+  {
+    Q_ASSERT( context );
+    evaluateExpression( fit, expression, context, [&s]( const QVariant & v ) { s.addVariant( v ); } );
+  }
+  else
+  {
+    QgsFeature f;
+    while ( fit.nextFeature( f ) )
       s.addVariant( f.attribute( attr ) );
-    }
   }
   s.finalize();
   double val = s.statistic( stat );
@@ -696,21 +804,17 @@ QVariant QgsAggregateCalculator::calculateStringAggregate( QgsFeatureIterator &f
   Q_ASSERT( expression || attr >= 0 );
 
   QgsStringStatisticalSummary s( stat );
-  QgsFeature f;
 
-  while ( fit.nextFeature( f ) )
+  if ( expression )
   {
-    if ( expression )
-    {
-      Q_ASSERT( context );
-      context->setFeature( f );
-      QVariant v = expression->evaluate( context );
-      s.addValue( v );
-    }
-    else
-    {
+    Q_ASSERT( context );
+    evaluateExpression( fit, expression, context, [&s]( const QVariant & v ) { s.addValue( v ); } );
+  }
+  else
+  {
+    QgsFeature f;
+    while ( fit.nextFeature( f ) )
       s.addValue( f.attribute( attr ) );
-    }
   }
   s.finalize();
   return s.statistic( stat );
@@ -720,18 +824,15 @@ QVariant QgsAggregateCalculator::calculateGeometryAggregate( QgsFeatureIterator
 {
   Q_ASSERT( expression );
 
-  QgsFeature f;
+  Q_ASSERT( context );
   QVector< QgsGeometry > geometries;
-  while ( fit.nextFeature( f ) )
+  evaluateExpression( fit, expression, context, [&geometries]( const QVariant & v )
   {
-    Q_ASSERT( context );
-    context->setFeature( f );
-    QVariant v = expression->evaluate( context );
     if ( v.canConvert<QgsGeometry>() )
     {
       geometries << v.value<QgsGeometry>();
     }
-  }
+  } );
 
   return QVariant::fromValue( QgsGeometry::collectGeometry( geometries ) );
 }
@@ -741,25 +842,24 @@ QVariant QgsAggregateCalculator::concatenateStrings( QgsFeatureIterator &fit, in
 {
   Q_ASSERT( expression || attr >= 0 );
 
-  QgsFeature f;
   QStringList results;
-  while ( fit.nextFeature( f ) )
+  auto addResult = [&results, unique]( const QVariant & v )
   {
-    QString result;
-    if ( expression )
-    {
-      Q_ASSERT( context );
-      context->setFeature( f );
-      QVariant v = expression->evaluate( context );
-      result = v.toString();
-    }
-    else
-    {
-      result = f.attribute( attr ).toString();
-    }
-
+    const QString result = v.toString();
     if ( !unique || !results.contains( result ) )
       results << result;
+  };
+
+  if ( expression )
+  {
+    Q_ASSERT( context );
+    evaluateExpression( fit, expression, context, addResult );
+  }
+  else
+  {
+    QgsFeature f;
+    while ( fit.nextFeature( f ) )
+      addResult( f.attribute( attr ) );
   }
 
   return results.join( delimiter );
@@ -811,21 +911,17 @@ QVariant QgsAggregateCalculator::calculateDateTimeAggregate( QgsFeatureIterator
   Q_ASSERT( expression || attr >= 0 );
 
   QgsDateTimeStatisticalSummary s( stat );
-  QgsFeature f;
 
-  while ( fit.nextFeature( f ) )
+  if ( expression )
   {
-    if ( expression )
-    {
-      Q_ASSERT( context );
-      context->setFeature( f );
-      QVariant v = expression->evaluate( context );
-      s.addValue( v );
-    }
-    else
-    {
+    Q_ASSERT( context );
+    evaluateExpression( fit, expression, context, [&s]( const QVariant & v ) { s.addValue( v ); } );
+  }
+  else
+  {
+    QgsFeature f;
+    while ( fit.nextFeature( f ) )
       s.addValue( f.attribute( attr ) );
-    }
   }
   s.finalize();
   return s.statistic( stat );
@@ -836,23 +932,18 @@ QVariant QgsAggregateCalculator::calculateArrayAggregate( QgsFeatureIterator &fi
 {
   Q_ASSERT( expression || attr >= 0 );
 
-  QgsFeature f;
-
   QVariantList array;
 
-  while ( fit.nextFeature( f ) )
+  if ( expression )
   {
-    if ( expression )
-    {
-      Q_ASSERT( context );
-      context->setFeature( f );
-      QVariant v = expression->evaluate( context );
-      array.append( v );
-    }
-    else
-    {
+    Q_ASSERT( context );
+    evaluateExpression( fit, expression, context, [&array]( const QVariant & v ) { array.append( v ); } );
+  }
+  else
+  {
+    QgsFeature f;
+    while ( fit.nextFeature( f ) )
       array.append( f.attribute( attr ) );
-    }
   }
   return array;
 }
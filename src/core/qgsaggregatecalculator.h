@@ -216,7 +216,7 @@ class CORE_EXPORT QgsAggregateCalculator
     static QgsDateTimeStatisticalSummary::Statistic dateTimeStatFromAggregate( Aggregate aggregate, bool *ok = nullptr );
 
     static QVariant calculateNumericAggregate( QgsFeatureIterator &fit, int attr, QgsExpression *expression,
-        QgsExpressionContext *context, QgsStatisticalSummary::Statistic stat );
+        QgsExpressionContext *context, QgsStatisticalSummary::Statistic stat, const QgsFields &fields = QgsFields() );
 
     static QVariant calculateStringAggregate( QgsFeatureIterator &fit, int attr, QgsExpression *expression,
         QgsExpressionContext *context, QgsStringStatisticalSummary::Statistic stat );
@@ -231,7 +231,7 @@ class CORE_EXPORT QgsAggregateCalculator
     static QVariant calculate( Aggregate aggregate, QgsFeatureIterator &fit, QVariant::Type resultType,
                                int attr, QgsExpression *expression,
                                const QString &delimiter,
-                               QgsExpressionContext *context, bool *ok = nullptr );
+                               QgsExpressionContext *context, bool *ok = nullptr, const QgsFields &fields = QgsFields() );
     static QVariant concatenateStrings( QgsFeatureIterator &fit, int attr, QgsExpression *expression,
                                         QgsExpressionContext *context, const QString &delimiter, bool unique = false );
 
@@ -0,0 +1,281 @@
+/***************************************************************************
+                         qgsapproximatecoordinatetransform.cpp
+                         -------------------------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsapproximatecoordinatetransform.h"
+#include "qgsexception.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <cmath>
+
+QgsApproximateCoordinateTransform::QgsApproximateCoordinateTransform( const QgsCoordinateTransform &transform, const QgsRectangle &extent, double tolerance )
+  : mTransform( transform )
+  , mExtent( extent )
+  , mTolerance( tolerance )
+{
+  if ( !transform.isValid() || transform.isShortCircuited() || extent.isEmpty() || !extent.isFinite() )
+    return;
+
+  mGrid.xMinimum = extent.xMinimum();
+  mGrid.yMinimum = extent.yMinimum();
+  mGrid.cellWidth = extent.width() / GRID_SIZE;
+  mGrid.cellHeight = extent.height() / GRID_SIZE;
+  mGrid.size = GRID_SIZE;
+
+  QVector<double> x;
+  QVector<double> y;
+  addSamples( mGrid, x, y );
+  QVector<double> z( x.size(), 0.0 );
+  try
+  {
+    mTransform.transformCoords( x.size(), x.data(), y.data(), z.data() );
+  }
+  catch ( QgsCsException & )
+  {
+    // the cells around the points which failed are not approximated
+  }
+  mApproximatedCells = evaluate( mGrid, x.constData(), y.constData(), tolerance );
+
+  // the cells where the transform bends too much are refined, unless some of their corners failed
+  QVector<int> candidates;
+  for ( int cell = 0; cell < GRID_SIZE * GRID_SIZE && candidates.size() < MAX_REFINED_CELLS; ++cell )
+  {
+    if ( mGrid.accurateCells.at( cell ) )
+      continue;
+
+    const int row = cell / GRID_SIZE;
+    const int column = cell % GRID_SIZE;
+    bool finite = true;
+    for ( int node : { row * ( GRID_SIZE + 1 ) + column, row * ( GRID_SIZE + 1 ) + column + 1,
+                       ( row + 1 ) * ( GRID_SIZE + 1 ) + column, ( row + 1 ) * ( GRID_SIZE + 1 ) + column + 1 } )
+    {
+      finite = finite && std::isfinite( mGrid.nodes.at( node ).x() ) && std::isfinite( mGrid.nodes.at( node ).y() );
+    }
+    if ( finite )
+      candidates << cell;
+  }
+  if ( candidates.isEmpty() )
+    return;
+
+  QVector<Grid> grids( candidates.size() );
+  x.clear();
+  y.clear();
+  for ( int i = 0; i < candidates.size(); ++i )
+  {
+    Grid &grid = grids[ i ];
+    grid.xMinimum = mGrid.xMinimum + ( candidates.at( i ) % GRID_SIZE ) * mGrid.cellWidth;
+    grid.yMinimum = mGrid.yMinimum + ( candidates.at( i ) / GRID_SIZE ) * mGrid.cellHeight;
+    grid.cellWidth = mGrid.cellWidth / REFINED_GRID_SIZE;
+    grid.cellHeight = mGrid.cellHeight / REFINED_GRID_SIZE;
+    grid.size = REFINED_GRID_SIZE;
+    addSamples( grid, x, y );
+  }
+  z.fill( 0.0, x.size() );
+  try
+  {
+    mTransform.transformCoords( x.size(), x.data(), y.data(), z.data() );
+  }
+  catch ( QgsCsException & )
+  {
+    // as above, the refined cells around the points which failed are not approximated
+  }
+
+  const int samplesPerGrid = x.size() / candidates.size();
+  mRefinedCells.fill( -1, GRID_SIZE * GRID_SIZE );
+  for ( int i = 0; i < candidates.size(); ++i )
+  {
+    if ( evaluate( grids[ i ], x.constData() + i * samplesPerGrid, y.constData() + i * samplesPerGrid, tolerance ) == 0 )
+      continue;
+
+    mRefinedCells[ candidates.at( i ) ] = mRefinedGrids.size();
+    mRefinedGrids << grids.at( i );
+  }
+}
+
+std::shared_ptr< const QgsApproximateCoordinateTransform > QgsApproximateCoordinateTransform::cachedTransform( const QgsCoordinateTransform &transform, const QgsRectangle &extent, double tolerance )
+{
+  static QMutex sMutex;
+  // most recently used first
+  static QList< std::shared_ptr< const QgsApproximateCoordinateTransform > > sCache;
+
+  auto matches = [&]( const QgsApproximateCoordinateTransform & approximate )
+  {
+    // a grid checked with a smaller tolerance is accurate enough, whatever the extent it covers
+    return approximate.mTolerance <= tolerance
+           && approximate.mExtent.contains( extent )
+           && approximate.mTransform.sourceCrs() == transform.sourceCrs()
+           && approximate.mTransform.destinationCrs() == transform.destinationCrs()
+           && approximate.mTransform.coordinateOperation() == transform.coordinateOperation()
+           && approximate.mTransform.context() == transform.context();
+  };
+
+  {
+    QMutexLocker locker( &sMutex );
+    for ( int i = 0; i < sCache.size(); ++i )
+    {
+      if ( matches( *sCache.at( i ) ) )
+      {
+        sCache.move( i, 0 );
+        return sCache.first();
+      }
+    }
+  }
+
+  // built unlocked, the layers rendered in parallel may build the same grid twice at worst
+  std::shared_ptr< const QgsApproximateCoordinateTransform > approximate = std::make_shared< QgsApproximateCoordinateTransform >( transform, extent, tolerance );
+  if ( !approximate->isValid() )
+    return nullptr;
+
+  QMutexLocker locker( &sMutex );
+  sCache.prepend( approximate );
+  while ( sCache.size() > CACHE_SIZE )
+    sCache.removeLast();
+  return approximate;
+}
+
+void QgsApproximateCoordinateTransform::addSamples( const Grid &grid, QVector<double> &x, QVector<double> &y )
+{
+  const int n = grid.size;
+  const int offset = x.size();
+  const int nodeCount = ( n + 1 ) * ( n + 1 );
+  const int centerOffset = offset + nodeCount;
+  const int horizontalOffset = centerOffset + n * n;
+  const int verticalOffset = horizontalOffset + n * ( n + 1 );
+  const int pointCount = verticalOffset + ( n + 1 ) * n;
+
+  x.resize( pointCount );
+  y.resize( pointCount );
+  auto setPoint = [&]( int index, double column, double row )
+  {
+    x[ index ] = grid.xMinimum + column * grid.cellWidth;
+    y[ index ] = grid.yMinimum + row * grid.cellHeight;
+  };
+  for ( int row = 0; row <= n; ++row )
+  {
+    for ( int column = 0; column <= n; ++column )
+    {
+      setPoint( offset + row * ( n + 1 ) + column, column, row );
+      if ( row < n && column < n )
+        setPoint( centerOffset + row * n + column, column + 0.5, row + 0.5 );
+      if ( column < n )
+        setPoint( horizontalOffset + row * n + column, column + 0.5, row );
+      if ( row < n )
+        setPoint( verticalOffset + row * ( n + 1 ) + column, column, row + 0.5 );
+    }
+  }
+}
+
+int QgsApproximateCoordinateTransform::evaluate( Grid &grid, const double *x, const double *y, double tolerance )
+{
+  const int n = grid.size;
+  const int nodeCount = ( n + 1 ) * ( n + 1 );
+  const int centerOffset = nodeCount;
+  const int horizontalOffset = centerOffset + n * n;
+  const int verticalOffset = horizontalOffset + n * ( n + 1 );
+
+  grid.nodes.resize( nodeCount );
+  for ( int i = 0; i < nodeCount; ++i )
+    grid.nodes[ i ] = QPointF( x[ i ], y[ i ] );
+
+  auto isAccurate = [&]( int index, const QPointF & approximated )
+  {
+    return std::isfinite( x[ index ] ) && std::isfinite( y[ index ] )
+           && std::fabs( x[ index ] - approximated.x() ) <= tolerance
+           && std::fabs( y[ index ] - approximated.y() ) <= tolerance;
+  };
+
+  int accurateCount = 0;
+  grid.accurateCells.fill( false, n * n );
+  for ( int row = 0; row < n; ++row )
+  {
+    for ( int column = 0; column < n; ++column )
+    {
+      const QPointF &p00 = grid.nodes.at( row * ( n + 1 ) + column );
+      const QPointF &p10 = grid.nodes.at( row * ( n + 1 ) + column + 1 );
+      const QPointF &p01 = grid.nodes.at( ( row + 1 ) * ( n + 1 ) + column );
+      const QPointF &p11 = grid.nodes.at( ( row + 1 ) * ( n + 1 ) + column + 1 );
+      bool accurate = true;
+      for ( const QPointF &p : { p00, p10, p01, p11 } )
+        accurate = accurate && std::isfinite( p.x() ) && std::isfinite( p.y() );
+
+      accurate = accurate
+                 && isAccurate( centerOffset + row * n + column, ( p00 + p10 + p01 + p11 ) / 4 )
+                 && isAccurate( horizontalOffset + row * n + column, ( p00 + p10 ) / 2 )
+                 && isAccurate( horizontalOffset + ( row + 1 ) * n + column, ( p01 + p11 ) / 2 )
+                 && isAccurate( verticalOffset + row * ( n + 1 ) + column, ( p00 + p01 ) / 2 )
+                 && isAccurate( verticalOffset + row * ( n + 1 ) + column + 1, ( p10 + p11 ) / 2 );
+
+      if ( accurate )
+      {
+        grid.accurateCells[ row * n + column ] = true;
+        accurateCount++;
+      }
+    }
+  }
+  return accurateCount;
+}
+
+void QgsApproximateCoordinateTransform::transformPolygon( QPolygonF &polygon ) const
+{
+  QVector<int> exact;
+  QPointF *point = polygon.data();
+  for ( int i = 0; i < polygon.size(); ++i, ++point )
+  {
+    if ( !transformInPlace( point->rx(), point->ry() ) )
+      exact << i;
+  }
+
+  if ( exact.isEmpty() )
+    return;
+
+  QVector<double> x( exact.size() );
+  QVector<double> y( exact.size() );
+  QVector<double> z( exact.size(), 0.0 );
+  for ( int i = 0; i < exact.size(); ++i )
+  {
+    x[ i ] = polygon.at( exact.at( i ) ).x();
+    y[ i ] = polygon.at( exact.at( i ) ).y();
+  }
+
+  QString error;
+  try
+  {
+    mTransform.transformCoords( exact.size(), x.data(), y.data(), z.data() );
+  }
+  catch ( const QgsCsException &e )
+  {
+    // rethrown once the coordinates which could be transformed are recorded
+    error = e.what();
+  }
+
+  for ( int i = 0; i < exact.size(); ++i )
+    polygon[ exact.at( i ) ] = QPointF( x.at( i ), y.at( i ) );
+
+  if ( !error.isEmpty() )
+    throw QgsCsException( error );
+}
+
+QPointF QgsApproximateCoordinateTransform::transform( double x, double y ) const
+{
+  if ( !transformInPlace( x, y ) )
+  {
+    double z = 0;
+    mTransform.transformInPlace( x, y, z );
+  }
+  return QPointF( x, y );
+}
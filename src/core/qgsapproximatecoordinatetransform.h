@@ -0,0 +1,198 @@
+/***************************************************************************
+                         qgsapproximatecoordinatetransform.h
+                         -----------------------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSAPPROXIMATECOORDINATETRANSFORM_H
+#define QGSAPPROXIMATECOORDINATETRANSFORM_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+#include "qgis_sip.h"
+#include "qgscoordinatetransform.h"
+#include "qgsrectangle.h"
+
+#include <QPolygonF>
+#include <QVector>
+
+#include <memory>
+
+/**
+ * \ingroup core
+ * \class QgsApproximateCoordinateTransform
+ * \brief Approximates a coordinate transform by bilinear interpolation over a grid of the rendered extent.
+ *
+ * Transforming the vertices of each feature with QgsCoordinateTransform pays the
+ * PROJ setup of every call, which dominates for the small coordinate arrays of
+ * most features. This class transforms once, in a single PROJ call, the nodes of a
+ * grid covering an extent of the source CRS, and checks in each cell that bilinear
+ * interpolation between its corners is within a tolerance of the exact transform,
+ * at the cell center and the middles of its edges. The cells where it is not are
+ * refined into a finer grid, checked the same way. Points in the accurate cells are
+ * then transformed by interpolation, the other points are transformed exactly, in
+ * one call per polygon.
+ *
+ * This is similar to the approximate mode of QgsRasterProjector. Instances are
+ * immutable once constructed, and can be shared between threads. cachedTransform()
+ * returns the instances shared by the renders of a same map extent.
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.16
+ */
+class CORE_EXPORT QgsApproximateCoordinateTransform
+{
+  public:
+
+    /**
+     * Constructor for QgsApproximateCoordinateTransform, approximating \a transform
+     * in \a extent (in the source CRS) within \a tolerance (in destination CRS units).
+     */
+    QgsApproximateCoordinateTransform( const QgsCoordinateTransform &transform, const QgsRectangle &extent, double tolerance );
+
+    /**
+     * Returns an approximation of \a transform in \a extent within \a tolerance, shared
+     * with the previous calls whose approximation covers \a extent at least as accurately,
+     * for instance for the layers of a same CRS or the redraws of a same map extent.
+     * Returns NULLPTR if the transform cannot be approximated anywhere in the extent.
+     */
+    static std::shared_ptr< const QgsApproximateCoordinateTransform > cachedTransform( const QgsCoordinateTransform &transform, const QgsRectangle &extent, double tolerance );
+
+    //! Returns FALSE if the transform cannot be approximated anywhere in the extent
+    bool isValid() const { return mApproximatedCells > 0 || !mRefinedGrids.isEmpty(); }
+
+    //! Returns the number of cells of the grid where the transform is approximated
+    int approximatedCellCount() const { return mApproximatedCells; }
+
+    //! Returns the number of cells of the grid which are refined, because the transform could not be approximated in them
+    int refinedCellCount() const { return mRefinedGrids.size(); }
+
+    //! Returns the extent (in the source CRS) of the approximation
+    QgsRectangle extent() const { return mExtent; }
+
+    //! Returns the maximum error (in destination CRS units) of the approximation
+    double tolerance() const { return mTolerance; }
+
+    /**
+     * Transforms the point \a x, \a y in place, returns FALSE if it lies in a cell
+     * where the transform cannot be approximated (the point is then unchanged).
+     */
+    bool transformInPlace( double &x, double &y ) const
+    {
+      int cell = -1;
+      if ( mGrid.interpolate( x, y, cell ) )
+        return true;
+      if ( cell < 0 || mRefinedGrids.isEmpty() )
+        return false;
+
+      const int refined = mRefinedCells.at( cell );
+      return refined >= 0 && mRefinedGrids.at( refined ).interpolate( x, y, cell );
+    }
+
+    /**
+     * Transforms the \a polygon in place. The points which cannot be approximated are
+     * transformed exactly, in a single call of the coordinate transform.
+     * \throws QgsCsException if the exact transform of some points failed, the points
+     * which could be transformed are transformed nevertheless
+     */
+    void transformPolygon( QPolygonF &polygon ) const SIP_THROW( QgsCsException );
+
+    /**
+     * Returns the point \a x, \a y transformed, approximated if possible.
+     * \throws QgsCsException if the exact transform of the point failed
+     */
+    QPointF transform( double x, double y ) const SIP_THROW( QgsCsException );
+
+  private:
+
+    struct Grid
+    {
+      double xMinimum = 0;
+      double yMinimum = 0;
+      double cellWidth = 0;
+      double cellHeight = 0;
+      int size = 0;
+
+      //! Transformed grid nodes, by row
+      QVector<QPointF> nodes;
+
+      //! TRUE for the cells where the interpolation is accurate, by row
+      QVector<bool> accurateCells;
+
+      /**
+       * Interpolates the point \a x, \a y in place if it lies in an accurate cell.
+       * Sets \a cell to the index of the cell of the point, or -1 if it is outside.
+       */
+      bool interpolate( double &x, double &y, int &cell ) const
+      {
+        const double fx = ( x - xMinimum ) / cellWidth;
+        const double fy = ( y - yMinimum ) / cellHeight;
+        // also rejects NaN coordinates
+        if ( !( fx >= 0 && fx < size && fy >= 0 && fy < size ) )
+        {
+          cell = -1;
+          return false;
+        }
+
+        const int column = static_cast< int >( fx );
+        const int row = static_cast< int >( fy );
+        cell = row * size + column;
+        if ( !accurateCells.at( cell ) )
+          return false;
+
+        const double u = fx - column;
+        const double v = fy - row;
+        const QPointF &p00 = nodes.at( row * ( size + 1 ) + column );
+        const QPointF &p10 = nodes.at( row * ( size + 1 ) + column + 1 );
+        const QPointF &p01 = nodes.at( ( row + 1 ) * ( size + 1 ) + column );
+        const QPointF &p11 = nodes.at( ( row + 1 ) * ( size + 1 ) + column + 1 );
+        x = ( 1 - v ) * ( ( 1 - u ) * p00.x() + u * p10.x() ) + v * ( ( 1 - u ) * p01.x() + u * p11.x() );
+        y = ( 1 - v ) * ( ( 1 - u ) * p00.y() + u * p10.y() ) + v * ( ( 1 - u ) * p01.y() + u * p11.y() );
+        return true;
+      }
+    };
+
+    //! Appends to \a x and \a y the points of \a grid to transform: nodes, cell centers, then middles of the horizontal and vertical cell edges
+    static void addSamples( const Grid &grid, QVector<double> &x, QVector<double> &y );
+
+    //! Sets the nodes and accurate cells of \a grid from its transformed samples \a x and \a y, returns the number of accurate cells
+    static int evaluate( Grid &grid, const double *x, const double *y, double tolerance );
+
+    //! Number of cells of each side of the grid
+    static const int GRID_SIZE = 32;
+
+    //! Number of cells of each side of the grid of a refined cell
+    static const int REFINED_GRID_SIZE = 8;
+
+    //! Maximum number of refined cells, the transform is so distorted elsewhere that it is transformed exactly
+    static const int MAX_REFINED_CELLS = 128;
+
+    //! Maximum number of approximations kept by cachedTransform()
+    static const int CACHE_SIZE = 16;
+
+    QgsCoordinateTransform mTransform;
+    QgsRectangle mExtent;
+    double mTolerance = 0;
+
+    Grid mGrid;
+
+    //! Index in mRefinedGrids of the refined grid of each cell of mGrid, or -1
+    QVector<int> mRefinedCells;
+    QVector<Grid> mRefinedGrids;
+
+    int mApproximatedCells = 0;
+};
+
+#endif // QGSAPPROXIMATECOORDINATETRANSFORM_H
@@ -68,8 +68,8 @@ bool QgsArchive::zip( const QString &filename )
   QString uuid = QUuid::createUuid().toString();
   QFile tmpFile( tempPath + QDir::separator() + uuid );
 
-  // zip content
-  if ( ! QgsZipUtils::zip( tmpFile.fileName(), mFiles ) )
+  // zip content, the unchanged files are copied from the existing zip file without being compressed again
+  if ( ! QgsZipUtils::zip( tmpFile.fileName(), mFiles, filename ) )
   {
     QString err = QObject::tr( "Unable to zip content" );
     QgsMessageLog::logMessage( err, QStringLiteral( "QgsArchive" ) );
@@ -79,6 +79,9 @@ QgsAuxiliaryLayer::QgsAuxiliaryLayer( const QString &pkField, const QString &fil
   mJoinInfo.setEditable( true );
   mJoinInfo.setUpsertOnEdit( true );
   mJoinInfo.setCascadedDelete( true );
+  // the auxiliary fields are read from a memory cache indexed by the join value, which is updated
+  // feature by feature when the auxiliary layer is edited
+  mJoinInfo.setUsingMemoryCache( true );
   mJoinInfo.setJoinFieldNamesBlockList( QStringList() << QStringLiteral( "rowid" ) ); // introduced by ogr provider
 }
 
@@ -592,6 +595,11 @@ QgsAuxiliaryLayer *QgsAuxiliaryStorage::createAuxiliaryLayer( const QgsField &fi
         return alayer;
       }
     }
+    else
+    {
+      // tables of projects saved by previous versions have no index on the join field
+      createJoinFieldIndex( table, database.get() );
+    }
 
     alayer = new QgsAuxiliaryLayer( field.name(), currentFileName(), table, layer );
     alayer->startEditing();
@@ -636,7 +644,7 @@ bool QgsAuxiliaryStorage::duplicateTable( const QgsDataSourceUri &ogrUri, const
     if ( database )
     {
       QString sql = QStringLiteral( "CREATE TABLE %1 AS SELECT * FROM %2" ).arg( newTable, uri.table() );
-      rc = exec( sql, database.get() );
+      rc = exec( sql, database.get() ) && createJoinFieldIndex( newTable, database.get() );
     }
   }
 
@@ -722,7 +730,14 @@ bool QgsAuxiliaryStorage::createTable( const QString &type, const QString &table
   if ( !exec( sql, handler ) )
     return false;
 
-  return true;
+  return createJoinFieldIndex( table, handler );
+}
+
+bool QgsAuxiliaryStorage::createJoinFieldIndex( const QString &table, sqlite3 *handler )
+{
+  // the joined features are looked up by their join field when the auxiliary fields are edited
+  const QString sql = QStringLiteral( "CREATE INDEX IF NOT EXISTS '%1_%2_idx' ON '%1' ( '%2' )" ).arg( table, AS_JOINFIELD );
+  return exec( sql, handler );
 }
 
 spatialite_database_unique_ptr QgsAuxiliaryStorage::createDB( const QString &filename )
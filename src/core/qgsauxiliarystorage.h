@@ -406,6 +406,7 @@ class CORE_EXPORT QgsAuxiliaryStorage
     static spatialite_database_unique_ptr openDB( const QString &filename );
     static bool tableExists( const QString &table, sqlite3 *handler );
     static bool createTable( const QString &type, const QString &table, sqlite3 *handler );
+    static bool createJoinFieldIndex( const QString &table, sqlite3 *handler );
 
     static bool exec( const QString &sql, sqlite3 *handler );
     static void debugMsg( const QString &sql, sqlite3 *handler );
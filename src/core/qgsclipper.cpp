@@ -19,6 +19,7 @@
 #include "qgsclipper.h"
 #include "qgsgeometry.h"
 #include "qgscurve.h"
+#include "qgslinestring.h"
 #include "qgslogger.h"
 
 // Where has all the code gone?
@@ -41,20 +42,82 @@ const double QgsClipper::SMALL_NUM = 1e-12;
 QPolygonF QgsClipper::clippedLine( const QgsCurve &curve, const QgsRectangle &clipExtent )
 {
   const int nPoints = curve.numPoints();
+  if ( nPoints < 2 )
+    return QPolygonF();
+
+  // read the coordinates of line strings directly from their arrays
+  QVector< double > curveX;
+  QVector< double > curveY;
+  const double *xData = nullptr;
+  const double *yData = nullptr;
+  if ( const QgsLineString *lineString = qgsgeometry_cast< const QgsLineString * >( &curve ) )
+  {
+    xData = lineString->xData();
+    yData = lineString->yData();
+  }
+  else
+  {
+    curveX.resize( nPoints );
+    curveY.resize( nPoints );
+    for ( int i = 0; i < nPoints; ++i )
+    {
+      curveX[i] = curve.xAt( i );
+      curveY[i] = curve.yAt( i );
+    }
+    xData = curveX.constData();
+    yData = curveY.constData();
+  }
+
+  // lines lying inside the extent are returned unchanged, and lines entirely on one side
+  // of the extent are clipped away
+  bool allInside = true;
+  bool allLeft = true;
+  bool allRight = true;
+  bool allBelow = true;
+  bool allAbove = true;
+  const double xMin = clipExtent.xMinimum();
+  const double xMax = clipExtent.xMaximum();
+  const double yMin = clipExtent.yMinimum();
+  const double yMax = clipExtent.yMaximum();
+  for ( int i = 0; i < nPoints; ++i )
+  {
+    const double x = xData[i];
+    const double y = yData[i];
+    allInside &= x >= xMin && x <= xMax && y >= yMin && y <= yMax;
+    allLeft &= x < xMin;
+    allRight &= x > xMax;
+    allBelow &= y < yMin;
+    allAbove &= y > yMax;
+  }
+
+  QPolygonF line;
+  if ( allLeft || allRight || allBelow || allAbove )
+    return line;
+
+  if ( allInside )
+  {
+    line.resize( nPoints );
+    QPointF *dest = line.data();
+    for ( int i = 0; i < nPoints; ++i, ++dest )
+    {
+      dest->rx() = xData[i];
+      dest->ry() = yData[i];
+    }
+    return line;
+  }
 
   double p0x, p0y, p1x = 0.0, p1y = 0.0; //original coordinates
   double p1x_c, p1y_c; //clipped end coordinates
   double lastClipX = 0.0, lastClipY = 0.0; //last successfully clipped coords
 
-  QPolygonF line;
   line.reserve( nPoints + 1 );
 
   for ( int i = 0; i < nPoints; ++i )
   {
     if ( i == 0 )
     {
-      p1x = curve.xAt( i );
-      p1y = curve.yAt( i );
+      p1x = xData[i];
+      p1y = yData[i];
       continue;
     }
     else
@@ -62,8 +125,8 @@ QPolygonF QgsClipper::clippedLine( const QgsCurve &curve, const QgsRectangle &cl
       p0x = p1x;
       p0y = p1y;
 
-      p1x = curve.xAt( i );
-      p1y = curve.yAt( i );
+      p1x = xData[i];
+      p1y = yData[i];
 
       p1x_c = p1x;
       p1y_c = p1y;
@@ -201,16 +201,45 @@ inline void QgsClipper::trimFeature( QVector<double> &x,
 
 inline void QgsClipper::trimPolygon( QPolygonF &pts, const QgsRectangle &clipRect )
 {
+  // classify all the vertices first: a boundary with every vertex inside leaves the polygon
+  // unchanged, and so do the points created by the other boundaries, which lie between vertices
+  const double xMax = clipRect.xMaximum();
+  const double yMax = clipRect.yMaximum();
+  const double xMin = clipRect.xMinimum();
+  const double yMin = clipRect.yMinimum();
+  bool allInsideXMax = true;
+  bool allInsideYMax = true;
+  bool allInsideXMin = true;
+  bool allInsideYMin = true;
+  const QPointF *pt = pts.constData();
+  for ( int i = 0; i < pts.size(); ++i, ++pt )
+  {
+    allInsideXMax &= pt->x() < xMax;
+    allInsideYMax &= pt->y() < yMax;
+    allInsideXMin &= pt->x() > xMin;
+    allInsideYMin &= pt->y() > yMin;
+  }
+  if ( allInsideXMax && allInsideYMax && allInsideXMin && allInsideYMin )
+    return;
+
   QPolygonF tmpPts;
-  tmpPts.reserve( pts.size() );
-
-  trimPolygonToBoundary( pts, tmpPts, clipRect, XMax, clipRect.xMaximum() );
-  pts.resize( 0 );
-  trimPolygonToBoundary( tmpPts, pts, clipRect, YMax, clipRect.yMaximum() );
-  tmpPts.resize( 0 );
-  trimPolygonToBoundary( pts, tmpPts, clipRect, XMin, clipRect.xMinimum() );
-  pts.resize( 0 );
-  trimPolygonToBoundary( tmpPts, pts, clipRect, YMin, clipRect.yMinimum() );
+  tmpPts.reserve( pts.size() + 4 );
+
+  const auto clipToBoundary = [&tmpPts, &pts, &clipRect]( Boundary b, double boundaryValue )
+  {
+    tmpPts.resize( 0 );
+    trimPolygonToBoundary( pts, tmpPts, clipRect, b, boundaryValue );
+    pts.swap( tmpPts );
+  };
+
+  if ( !allInsideXMax )
+    clipToBoundary( XMax, xMax );
+  if ( !allInsideYMax )
+    clipToBoundary( YMax, yMax );
+  if ( !allInsideXMin )
+    clipToBoundary( XMin, xMin );
+  if ( !allInsideYMin )
+    clipToBoundary( YMin, yMin );
 }
 
 // An auxiliary function that is part of the polygon trimming
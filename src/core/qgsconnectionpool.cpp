@@ -0,0 +1,67 @@
+/***************************************************************************
+    qgsconnectionpool.cpp
+    ---------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsconnectionpool.h"
+#include "qgsdatasourceuri.h"
+
+#include <atomic>
+
+///@cond PRIVATE
+static std::atomic<int> sMinimumConnections( 0 );
+///@endcond
+
+QgsConnectionPoolMonitor *QgsConnectionPoolMonitor::instance()
+{
+  static QgsConnectionPoolMonitor sInstance;
+  return &sInstance;
+}
+
+void QgsConnectionPoolMonitor::setMinimumConnections( int count )
+{
+  sMinimumConnections = std::max( 0, count );
+}
+
+int QgsConnectionPoolMonitor::minimumConnections()
+{
+  return sMinimumConnections;
+}
+
+void QgsConnectionPoolMonitor::updateGroup( const QString &connInfo, const QgsConnectionPoolMonitor::GroupStatistics &statistics )
+{
+  QMutexLocker locker( &mMutex );
+  mGroups.insert( connInfo, statistics );
+}
+
+void QgsConnectionPoolMonitor::removeGroup( const QString &connInfo )
+{
+  QMutexLocker locker( &mMutex );
+  mGroups.remove( connInfo );
+}
+
+QMap<QString, QgsConnectionPoolMonitor::GroupStatistics> QgsConnectionPoolMonitor::statistics() const
+{
+  QMap<QString, GroupStatistics> groups;
+  {
+    QMutexLocker locker( &mMutex );
+    groups = mGroups;
+  }
+
+  QMap<QString, GroupStatistics> result;
+  for ( auto it = groups.constBegin(); it != groups.constEnd(); ++it )
+  {
+    result.insert( QgsDataSourceUri::removePassword( it.key() ), it.value() );
+  }
+  return result;
+}
@@ -19,21 +19,87 @@
 #define SIP_NO_FILE
 
 #include "qgis.h"
+#include "qgis_core.h"
 #include "qgsapplication.h"
 #include <QCoreApplication>
 #include <QMap>
 #include <QMutex>
+#include <QMutexLocker>
 #include <QSemaphore>
 #include <QStack>
 #include <QTime>
 #include <QTimer>
 #include <QThread>
 
+#include <algorithm>
+
 
 #define CONN_POOL_EXPIRATION_TIME           60    // in seconds
 #define CONN_POOL_SPARE_CONNECTIONS          2    // number of spare connections in case all the base connections are used but we have a nested request with the risk of a deadlock
 
 
+/**
+ * \ingroup core
+ * Settings and usage statistics shared by all the connection pools.
+ *
+ * A minimum number of connections can be opened when the group of connections
+ * to a data source is created, so that the first requests do not pay the connection
+ * handshakes. These connections are kept open when idle and are checked for health
+ * (and reopened if needed) by the expiration timer of the group.
+ *
+ * The statistics of the groups are keyed by connection information, without
+ * passwords.
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.16
+ */
+class CORE_EXPORT QgsConnectionPoolMonitor
+{
+  public:
+
+    //! Usage of a group of connections
+    struct GroupStatistics
+    {
+      //! Number of open connections which are not in use
+      int idle = 0;
+      //! Number of connections in use
+      int acquired = 0;
+      //! Number of connections acquired since the group was created
+      quint64 acquisitions = 0;
+      //! Number of connections opened since the group was created
+      quint64 connectionsCreated = 0;
+      //! Number of acquisitions which failed because of a timeout
+      quint64 timeouts = 0;
+    };
+
+    //! Returns the process wide instance
+    static QgsConnectionPoolMonitor *instance();
+
+    /**
+     * Sets the minimum number of connections opened when a group is created and kept
+     * open when idle, 0 to open connections on demand only (the default).
+     */
+    static void setMinimumConnections( int count );
+
+    //! Returns the minimum number of connections opened when a group is created and kept open when idle
+    static int minimumConnections();
+
+    //! Stores the statistics of the group of connections to \a connInfo
+    void updateGroup( const QString &connInfo, const GroupStatistics &statistics );
+
+    //! Removes the statistics of the group of connections to \a connInfo
+    void removeGroup( const QString &connInfo );
+
+    //! Returns the statistics of the groups, by connection information without password
+    QMap<QString, QgsConnectionPoolMonitor::GroupStatistics> statistics() const;
+
+  private:
+
+    mutable QMutex mMutex;
+    QMap<QString, GroupStatistics> mGroups;
+};
+
+
 /**
  * \ingroup core
  * Template that stores data related to a connection to a single server or datasource.
@@ -68,9 +134,15 @@ class QgsConnectionPoolGroup
       QTime lastUsedTime;
     };
 
-    QgsConnectionPoolGroup( const QString &ci )
+    /**
+     * Constructor for a group of connections to \a ci, holding at most \a maxConnectionCount
+     * concurrent connections, or the maximum number of concurrent connections per pool
+     * of the application if \a maxConnectionCount is not greater than 0.
+     */
+    QgsConnectionPoolGroup( const QString &ci, int maxConnectionCount = -1 )
       : connInfo( ci )
-      , sem( QgsApplication::instance()->maxConcurrentConnectionsPerPool() + CONN_POOL_SPARE_CONNECTIONS )
+      , maxConnections( maxConnectionCount > 0 ? maxConnectionCount : QgsApplication::instance()->maxConcurrentConnectionsPerPool() )
+      , sem( maxConnections + CONN_POOL_SPARE_CONNECTIONS )
     {
     }
 
@@ -80,6 +152,7 @@ class QgsConnectionPoolGroup
       {
         qgsConnectionPool_ConnectionDestroy( item.c );
       }
+      QgsConnectionPoolMonitor::instance()->removeGroup( connInfo );
     }
 
     //! QgsConnectionPoolGroup cannot be copied
@@ -101,7 +174,12 @@ class QgsConnectionPoolGroup
       if ( timeout >= 0 )
       {
         if ( !sem.tryAcquire( requiredFreeConnectionCount, timeout ) )
+        {
+          QMutexLocker locker( &connMutex );
+          ++statistics.timeouts;
+          publishStatistics();
           return nullptr;
+        }
       }
       else
       {
@@ -124,6 +202,7 @@ class QgsConnectionPoolGroup
           {
             qgsConnectionPool_ConnectionDestroy( i.c );
             qgsConnectionPool_ConnectionCreate( connInfo, i.c );
+            ++statistics.connectionsCreated;
           }
 
 
@@ -135,6 +214,8 @@ class QgsConnectionPoolGroup
           }
 
           acquiredConns.append( i.c );
+          ++statistics.acquisitions;
+          publishStatistics();
 
           return i.c;
         }
@@ -151,6 +232,9 @@ class QgsConnectionPoolGroup
 
       connMutex.lock();
       acquiredConns.append( c );
+      ++statistics.acquisitions;
+      ++statistics.connectionsCreated;
+      publishStatistics();
       connMutex.unlock();
       return c;
     }
@@ -176,12 +260,41 @@ class QgsConnectionPoolGroup
           QMetaObject::invokeMethod( expirationTimer->parent(), "startExpirationTimer" );
         }
       }
+      publishStatistics();
 
       connMutex.unlock();
 
       sem.release(); // this can unlock a thread waiting in acquire()
     }
 
+    /**
+     * Opens connections until the group holds \a count connections, at most the
+     * maximum number of concurrent connections of the group. The new connections are idle.
+     * \since QGIS 3.16
+     */
+    void warmup( int count )
+    {
+      QMutexLocker locker( &connMutex );
+      count = std::min( count, maxConnections );
+      while ( conns.count() + acquiredConns.count() < count )
+      {
+        Item i;
+        qgsConnectionPool_ConnectionCreate( connInfo, i.c );
+        if ( !i.c )
+          break;
+        i.lastUsedTime = QTime::currentTime();
+        conns.push( i );
+        ++statistics.connectionsCreated;
+      }
+      publishStatistics();
+
+      if ( !conns.isEmpty() && expirationTimer && !expirationTimer->isActive() )
+      {
+        // will call the slot directly or queue the call (if the object lives in a different thread)
+        QMetaObject::invokeMethod( expirationTimer->parent(), "startExpirationTimer" );
+      }
+    }
+
     void invalidateConnections()
     {
       connMutex.lock();
@@ -192,6 +305,7 @@ class QgsConnectionPoolGroup
       conns.clear();
       for ( T c : qgis::as_const( acquiredConns ) )
         qgsConnectionPool_InvalidateConnection( c );
+      publishStatistics();
       connMutex.unlock();
     }
 
@@ -214,9 +328,10 @@ class QgsConnectionPoolGroup
 
       QTime now = QTime::currentTime();
 
-      // what connections have expired?
+      // what connections have expired? the minimum number of connections is kept open
       QList<int> toDelete;
-      for ( int i = 0; i < conns.count(); ++i )
+      const int maxDeleted = conns.count() + acquiredConns.count() - QgsConnectionPoolMonitor::minimumConnections();
+      for ( int i = 0; i < conns.count() && toDelete.count() < maxDeleted; ++i )
       {
         if ( conns.at( i ).lastUsedTime.secsTo( now ) >= CONN_POOL_EXPIRATION_TIME )
           toDelete.append( i );
@@ -230,20 +345,48 @@ class QgsConnectionPoolGroup
         conns.remove( index );
       }
 
+      // health check of the connections kept open, so that they are ready when needed
+      for ( Item &item : conns )
+      {
+        if ( !qgsConnectionPool_ConnectionIsValid( item.c ) )
+        {
+          qgsConnectionPool_ConnectionDestroy( item.c );
+          qgsConnectionPool_ConnectionCreate( connInfo, item.c );
+          ++statistics.connectionsCreated;
+        }
+      }
+      // a connection which could not be reopened is dropped
+      for ( int i = conns.count() - 1; i >= 0; --i )
+      {
+        if ( !conns.at( i ).c )
+          conns.remove( i );
+      }
+      publishStatistics();
+
       if ( conns.isEmpty() )
         expirationTimer->stop();
 
       connMutex.unlock();
     }
 
+    //! Publishes the statistics of the group to QgsConnectionPoolMonitor, the mutex must be locked
+    void publishStatistics()
+    {
+      statistics.idle = conns.count();
+      statistics.acquired = acquiredConns.count();
+      QgsConnectionPoolMonitor::instance()->updateGroup( connInfo, statistics );
+    }
+
   protected:
 
     QString connInfo;
     QStack<Item> conns;
     QList<T> acquiredConns;
     QMutex connMutex;
+    int maxConnections = 0;
     QSemaphore sem;
     QTimer *expirationTimer = nullptr;
+    QgsConnectionPoolMonitor::GroupStatistics statistics;
 
 };
 
@@ -293,13 +436,18 @@ class QgsConnectionPool
     {
       mMutex.lock();
       typename T_Groups::iterator it = mGroups.find( connInfo );
+      bool newGroup = false;
       if ( it == mGroups.end() )
       {
         it = mGroups.insert( connInfo, new T_Group( connInfo ) );
+        newGroup = true;
       }
       T_Group *group = *it;
       mMutex.unlock();
 
+      if ( newGroup && QgsConnectionPoolMonitor::minimumConnections() > 0 )
+        group->warmup( QgsConnectionPoolMonitor::minimumConnections() );
+
       return group->acquire( timeout, requestMayBeNested );
     }
 
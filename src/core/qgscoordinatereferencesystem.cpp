@@ -19,6 +19,7 @@
 #include "qgscoordinatereferencesystem_p.h"
 
 #include "qgscoordinatereferencesystem_legacy.h"
+#include "qgshotpathinstrumentation.h"
 #include "qgsreadwritelocker.h"
 
 #include <cmath>
@@ -515,7 +516,9 @@ bool QgsCoordinateReferenceSystem::createFromSrid( const long id )
 
 bool QgsCoordinateReferenceSystem::createFromPostgisSrid( const long id )
 {
+  QgsHotPathInstrumentation::LockWait lockWait( QgsHotPathInstrumentation::SrIdCacheLock );
   QgsReadWriteLocker locker( *sSrIdCacheLock(), QgsReadWriteLocker::Read );
+  lockWait.acquired();
   if ( !sDisableSrIdCache )
   {
     QHash< long, QgsCoordinateReferenceSystem >::const_iterator crsIt = sSrIdCache()->constFind( id );
@@ -311,6 +311,20 @@ static void proj_logger( void *, int level, const char *message )
 }
 #endif
 
+#if PROJ_VERSION_MAJOR>=6
+ProjData QgsCoordinateTransformPrivate::cloneProjData( QMap < uintptr_t, ProjData > &projections, PJ_CONTEXT *context )
+{
+  if ( projections.isEmpty() )
+    return nullptr;
+
+  // objects without an ISO definition cannot be cloned, they are created again by the caller
+  ProjData res = proj_clone( context, projections.constBegin().value() );
+  if ( res )
+    projections.insert( reinterpret_cast< uintptr_t>( context ), res );
+  return res;
+}
+#endif
+
 ProjData QgsCoordinateTransformPrivate::threadLocalProjData()
 {
   QgsReadWriteLocker locker( mProjLock, QgsReadWriteLocker::Read );
@@ -346,6 +360,16 @@ ProjData QgsCoordinateTransformPrivate::threadLocalProjData()
   locker.changeMode( QgsReadWriteLocker::Write );
 
 #if PROJ_VERSION_MAJOR>=6
+  // another thread may have created them while the lock was released
+  it = mProjProjections.constFind( reinterpret_cast< uintptr_t>( context ) );
+  if ( it != mProjProjections.constEnd() )
+    return it.value();
+
+  // the coordinate operation was already resolved for another thread: cloning it for the context
+  // of this thread avoids searching again the operations between the reference systems
+  if ( ProjData res = cloneProjData( mProjProjections, context ) )
+    return res;
+
   // use a temporary proj error collector
   QStringList projErrors;
   proj_log_func( context, &projErrors, proj_collecting_logger );
@@ -618,6 +642,13 @@ ProjData QgsCoordinateTransformPrivate::threadLocalFallbackProjData()
   // proj projections don't exist yet, so we need to create
   locker.changeMode( QgsReadWriteLocker::Write );
 
+  it = mProjFallbackProjections.constFind( reinterpret_cast< uintptr_t>( context ) );
+  if ( it != mProjFallbackProjections.constEnd() )
+    return it.value();
+
+  if ( ProjData res = cloneProjData( mProjFallbackProjections, context ) )
+    return res;
+
   QgsProjUtils::proj_pj_unique_ptr transform( proj_create_crs_to_crs_from_pj( context, mSourceCRS.projObject(), mDestCRS.projObject(), nullptr, nullptr ) );
   if ( transform )
     transform.reset( proj_normalize_for_visualization( QgsProjContext::get(), transform.get() ) );
@@ -43,6 +43,8 @@ typedef QPair< projPJ, projPJ > ProjData;
 struct PJconsts;
 typedef struct PJconsts PJ;
 typedef PJ *ProjData;
+struct projCtx_t;
+typedef struct projCtx_t PJ_CONTEXT;
 #endif
 
 #include "qgscoordinatereferencesystem.h"
@@ -106,6 +108,13 @@ class QgsCoordinateTransformPrivate : public QSharedData
     int mAvailableOpCount = -1;
     ProjData threadLocalFallbackProjData();
 
+    /**
+     * Clones one of the \a projections created for another thread into \a context and inserts the clone
+     * into \a projections. Must be called with a write lock on mProjLock. Returns nullptr if there is
+     * no projection to clone or if it cannot be cloned.
+     */
+    static ProjData cloneProjData( QMap < uintptr_t, ProjData > &projections, PJ_CONTEXT *context );
+
     // Only meant to be called by QgsCoordinateTransform::removeFromCacheObjectsBelongingToCurrentThread()
     bool removeObjectsBelongingToCurrentThread( void *pj_context );
 #endif
@@ -28,7 +28,9 @@
 #include <QTreeWidgetItem>
 #include <QVector>
 #include <QStyle>
+#include <QThread>
 #include <mutex>
+#include <vector>
 
 #include "qgis.h"
 #include "qgsdataitem.h"
@@ -1024,6 +1026,7 @@ QVector<QgsDataItem *> QgsDirectoryItem::createChildren()
   QDir dir( mDirPath );
 
   const QList<QgsDataItemProvider *> providers = QgsApplication::dataItemProviderRegistry()->providers();
+  const QStringList hiddenPaths = QgsSettings().value( QStringLiteral( "browser/hiddenPaths" ), QStringList() ).toStringList();
 
   QStringList entries = dir.entryList( QDir::AllDirs | QDir::NoDotAndDotDot, QDir::Name | QDir::IgnoreCase );
   const auto constEntries = entries;
@@ -1040,7 +1043,7 @@ QVector<QgsDataItem *> QgsDirectoryItem::createChildren()
     QgsDebugMsgLevel( QStringLiteral( "creating subdir: %1" ).arg( subdirPath ), 2 );
 
     QString path = mPath + '/' + subdir; // may differ from subdirPath
-    if ( QgsDirectoryItem::hiddenPath( path ) )
+    if ( hiddenPaths.contains( path ) )
       continue;
 
     bool handledByProvider = false;
@@ -1065,31 +1068,59 @@ QVector<QgsDataItem *> QgsDirectoryItem::createChildren()
     children.append( item );
   }
 
-  QStringList fileEntries = dir.entryList( QDir::Dirs | QDir::NoDotAndDotDot | QDir::Files, QDir::Name );
-  const auto constFileEntries = fileEntries;
-  for ( const QString &name : constFileEntries )
+  struct FileEntry
   {
-    if ( mRefreshLater )
-    {
-      deleteLater( children );
-      return children;
-    }
+    QFileInfo fileInfo;
+    QVector<QgsDataItem *> items;
+  };
+  std::vector< FileEntry > fileEntries;
+  const QFileInfoList fileInfos = dir.entryInfoList( QDir::Dirs | QDir::NoDotAndDotDot | QDir::Files, QDir::Name );
+  fileEntries.reserve( fileInfos.size() );
+  for ( const QFileInfo &fileInfo : fileInfos )
+    fileEntries.push_back( { fileInfo, QVector<QgsDataItem *>() } );
 
-    QString path = dir.absoluteFilePath( name );
-    QFileInfo fileInfo( path );
+  // providers may have to open each file to identify it, large directories populated in the
+  // background are probed in parallel, the items are then moved to the populating thread
+  QThread *populatingThread = QThread::currentThread();
+  auto probe = [this, &providers, populatingThread]( FileEntry & entry )
+  {
+    if ( !mRefreshLater )
+      entry.items = createFileItems( entry.fileInfo, providers, populatingThread );
+  };
+  if ( fileEntries.size() >= 32 && qApp && populatingThread != qApp->thread() )
+  {
+    QtConcurrent::blockingMap( fileEntries, probe );
+  }
+  else
+  {
+    for ( FileEntry &entry : fileEntries )
+      probe( entry );
+  }
 
-    if ( fileInfo.suffix().compare( QLatin1String( "zip" ), Qt::CaseInsensitive ) == 0 ||
-         fileInfo.suffix().compare( QLatin1String( "tar" ), Qt::CaseInsensitive ) == 0 )
-    {
-      QgsDataItem *item = QgsZipItem::itemFromPath( this, path, name, mPath + '/' + name );
-      if ( item )
-      {
-        children.append( item );
-        continue;
-      }
-    }
+  for ( const FileEntry &entry : fileEntries )
+    children << entry.items;
 
-    bool createdItem = false;
+  if ( mRefreshLater )
+    deleteLater( children );
+  return children;
+}
+
+QVector<QgsDataItem *> QgsDirectoryItem::createFileItems( const QFileInfo &fileInfo, const QList<QgsDataItemProvider *> &providers, QThread *targetThread )
+{
+  QVector<QgsDataItem *> items;
+  const QString path = fileInfo.absoluteFilePath();
+  const QString name = fileInfo.fileName();
+
+  if ( fileInfo.suffix().compare( QLatin1String( "zip" ), Qt::CaseInsensitive ) == 0 ||
+       fileInfo.suffix().compare( QLatin1String( "tar" ), Qt::CaseInsensitive ) == 0 )
+  {
+    QgsDataItem *item = QgsZipItem::itemFromPath( this, path, name, mPath + '/' + name );
+    if ( item )
+      items.append( item );
+  }
+
+  if ( items.isEmpty() )
+  {
     for ( QgsDataItemProvider *provider : providers )
     {
       int capabilities = provider->capabilities();
@@ -1103,26 +1134,28 @@ QVector<QgsDataItem *> QgsDirectoryItem::createChildren()
       QgsDataItem *item = provider->createDataItem( path, this );
       if ( item )
       {
-        children.append( item );
-        createdItem = true;
+        items.append( item );
       }
     }
+  }
 
-    if ( !createdItem )
+  if ( items.isEmpty() )
+  {
+    // if item is a QGIS project, and no specific item provider has overridden handling of
+    // project items, then use the default project item behavior
+    if ( fileInfo.suffix().compare( QLatin1String( "qgs" ), Qt::CaseInsensitive ) == 0 ||
+         fileInfo.suffix().compare( QLatin1String( "qgz" ), Qt::CaseInsensitive ) == 0 )
     {
-      // if item is a QGIS project, and no specific item provider has overridden handling of
-      // project items, then use the default project item behavior
-      if ( fileInfo.suffix().compare( QLatin1String( "qgs" ), Qt::CaseInsensitive ) == 0 ||
-           fileInfo.suffix().compare( QLatin1String( "qgz" ), Qt::CaseInsensitive ) == 0 )
-      {
-        QgsDataItem *item = new QgsProjectItem( this, fileInfo.completeBaseName(), path );
-        children.append( item );
-        continue;
-      }
+      items.append( new QgsProjectItem( this, fileInfo.completeBaseName(), path ) );
     }
+  }
 
+  if ( QThread::currentThread() != targetThread )
+  {
+    for ( QgsDataItem *item : qgis::as_const( items ) )
+      item->moveToThread( targetThread );
   }
-  return children;
+  return items;
 }
 
 void QgsDirectoryItem::setState( State state )
@@ -38,6 +38,8 @@ class QgsDataProvider;
 class QgsDataItem;
 class QgsAnimatedIcon;
 class QgsBookmarkManager;
+class QgsDataItemProvider;
+class QFileInfo;
 
 typedef QgsDataItem *dataItem_t( QString, QgsDataItem * ) SIP_SKIP;
 
@@ -804,6 +806,10 @@ class CORE_EXPORT QgsDirectoryItem : public QgsDataCollectionItem
     QString mDirPath;
 
   private:
+
+    //! Creates the items of the providers for the file or directory at \a fileInfo, in the thread \a targetThread
+    QVector<QgsDataItem *> createFileItems( const QFileInfo &fileInfo, const QList<QgsDataItemProvider *> &providers, QThread *targetThread );
+
     QFileSystemWatcher *mFileSystemWatcher = nullptr;
     bool mRefreshLater;
     QDateTime mLastScan;
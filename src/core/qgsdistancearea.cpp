@@ -13,7 +13,9 @@
  *                                                                         *
  ***************************************************************************/
 
+#include <algorithm>
 #include <cmath>
+#include <memory>
 #include <QString>
 #include <QObject>
 
@@ -41,6 +43,71 @@
 #define RAD2DEG(r) (180.0 * (r) / M_PI)
 #define POW2(x) ((x)*(x))
 
+/**
+ * Inverse Vincenty formula, for two points with a longitude difference \a L (in radians) and the
+ * sines and cosines of their reduced latitudes. Returns -1 if the formula does not converge.
+ */
+static double vincentyDistanceBearing( double a, double b, double f, double L,
+                                       double sinU1, double cosU1, double sinU2, double cosU2,
+                                       double *course1, double *course2 )
+{
+  double lambda = L;
+  double lambdaP = 2 * M_PI;
+
+  double sinLambda = 0;
+  double cosLambda = 0;
+  double sinSigma = 0;
+  double cosSigma = 0;
+  double sigma = 0;
+  double alpha = 0;
+  double cosSqAlpha = 0;
+  double cos2SigmaM = 0;
+  double C = 0;
+  double tu1 = 0;
+  double tu2 = 0;
+
+  int iterLimit = 20;
+  while ( std::fabs( lambda - lambdaP ) > 1e-12 && --iterLimit > 0 )
+  {
+    sinLambda = std::sin( lambda );
+    cosLambda = std::cos( lambda );
+    tu1 = ( cosU2 * sinLambda );
+    tu2 = ( cosU1 * sinU2 - sinU1 * cosU2 * cosLambda );
+    sinSigma = std::sqrt( tu1 * tu1 + tu2 * tu2 );
+    cosSigma = sinU1 * sinU2 + cosU1 * cosU2 * cosLambda;
+    sigma = std::atan2( sinSigma, cosSigma );
+    alpha = std::asin( cosU1 * cosU2 * sinLambda / sinSigma );
+    cosSqAlpha = std::cos( alpha ) * std::cos( alpha );
+    cos2SigmaM = cosSigma - 2 * sinU1 * sinU2 / cosSqAlpha;
+    C = f / 16 * cosSqAlpha * ( 4 + f * ( 4 - 3 * cosSqAlpha ) );
+    lambdaP = lambda;
+    lambda = L + ( 1 - C ) * f * std::sin( alpha ) *
+             ( sigma + C * sinSigma * ( cos2SigmaM + C * cosSigma * ( -1 + 2 * cos2SigmaM * cos2SigmaM ) ) );
+  }
+
+  if ( iterLimit == 0 )
+    return -1;  // formula failed to converge
+
+  double uSq = cosSqAlpha * ( a * a - b * b ) / ( b * b );
+  double A = 1 + uSq / 16384 * ( 4096 + uSq * ( -768 + uSq * ( 320 - 175 * uSq ) ) );
+  double B = uSq / 1024 * ( 256 + uSq * ( -128 + uSq * ( 74 - 47 * uSq ) ) );
+  double deltaSigma = B * sinSigma * ( cos2SigmaM + B / 4 * ( cosSigma * ( -1 + 2 * cos2SigmaM * cos2SigmaM ) -
+                                       B / 6 * cos2SigmaM * ( -3 + 4 * sinSigma * sinSigma ) * ( -3 + 4 * cos2SigmaM * cos2SigmaM ) ) );
+  double s = b * A * ( sigma - deltaSigma );
+
+  if ( course1 )
+  {
+    *course1 = std::atan2( tu1, tu2 );
+  }
+  if ( course2 )
+  {
+    // PI is added to return azimuth from P2 to P1
+    *course2 = std::atan2( cosU1 * sinLambda, -sinU1 * cosU2 + cosU1 * sinU2 * cosLambda ) + M_PI;
+  }
+
+  return s;
+}
+
 QgsDistanceArea::QgsDistanceArea()
 {
   // init with default settings
@@ -152,10 +219,13 @@ double QgsDistanceArea::measure( const QgsAbstractGeometry *geomV2, MeasureType
         return 0.0;
       }
 
-      QgsLineString *lineString = curve->curveToLine();
-      double length = measureLine( lineString );
-      delete lineString;
-      return length;
+      if ( QgsWkbTypes::isCurvedType( curve->wkbType() ) )
+      {
+        std::unique_ptr< QgsLineString > lineString( curve->curveToLine() );
+        return measureLine( lineString.get() );
+      }
+      // straight curves are measured without a copy
+      return measureLine( curve );
     }
     else
     {
@@ -263,6 +333,52 @@ double QgsDistanceArea::measureLine( const QgsCurve *curve ) const
     return 0.0;
   }
 
+  const QgsLineString *line = qgsgeometry_cast< const QgsLineString * >( curve );
+  if ( line && willUseEllipsoid() )
+  {
+    const int nPoints = line->numPoints();
+    if ( nPoints < 2 )
+      return 0;
+
+    // all the vertices are transformed in a single call
+    QVector< double > x( nPoints );
+    QVector< double > y( nPoints );
+    QVector< double > z( nPoints );
+    std::copy( line->xData(), line->xData() + nPoints, x.begin() );
+    std::copy( line->yData(), line->yData() + nPoints, y.begin() );
+    try
+    {
+      mCoordTransform.transformInPlace( x, y, z );
+    }
+    catch ( QgsCsException & )
+    {
+      QgsMessageLog::logMessage( QObject::tr( "Caught a coordinate system exception while trying to transform a point. Unable to calculate line length." ) );
+      return 0.0;
+    }
+
+    // the reduced latitude of each vertex is computed once, and shared by its two segments
+    const double f = 1 / mInvFlattening;
+    QVector< double > sinU( nPoints );
+    QVector< double > cosU( nPoints );
+    for ( int i = 0; i < nPoints; ++i )
+    {
+      const double U = std::atan( ( 1 - f ) * std::tan( DEG2RAD( y.at( i ) ) ) );
+      sinU[i] = std::sin( U );
+      cosU[i] = std::cos( U );
+    }
+
+    double total = 0;
+    for ( int i = 1; i < nPoints; ++i )
+    {
+      if ( qgsDoubleNear( x.at( i - 1 ), x.at( i ) ) && qgsDoubleNear( y.at( i - 1 ), y.at( i ) ) )
+        continue;
+
+      total += vincentyDistanceBearing( mSemiMajor, mSemiMinor, f, DEG2RAD( x.at( i ) ) - DEG2RAD( x.at( i - 1 ) ),
+                                        sinU.at( i - 1 ), cosU.at( i - 1 ), sinU.at( i ), cosU.at( i ), nullptr, nullptr );
+    }
+    return total;
+  }
+
   QgsPointSequence linePointsV2;
   QVector<QgsPointXY> linePoints;
   curve->points( linePointsV2 );
@@ -275,41 +391,19 @@ double QgsDistanceArea::measureLine( const QVector<QgsPointXY> &points ) const
   if ( points.size() < 2 )
     return 0;
 
-  double total = 0;
-  QgsPointXY p1, p2;
-
-  try
+  if ( willUseEllipsoid() )
   {
-    if ( willUseEllipsoid() )
-      p1 = mCoordTransform.transform( points[0] );
-    else
-      p1 = points[0];
-
-    for ( QVector<QgsPointXY>::const_iterator i = points.constBegin(); i != points.constEnd(); ++i )
-    {
-      if ( willUseEllipsoid() )
-      {
-        p2 = mCoordTransform.transform( *i );
-        total += computeDistanceBearing( p1, p2 );
-      }
-      else
-      {
-        p2 = *i;
-        total += measureLine( p1, p2 );
-      }
-
-      p1 = p2;
-    }
-
-    return total;
+    // measured as a line string, for which all the vertices are transformed in a single call
+    const QgsLineString line( points );
+    return measureLine( &line );
   }
-  catch ( QgsCsException &cse )
+
+  double total = 0;
+  for ( int i = 1; i < points.size(); ++i )
   {
-    Q_UNUSED( cse )
-    QgsMessageLog::logMessage( QObject::tr( "Caught a coordinate system exception while trying to transform a point. Unable to calculate line length." ) );
-    return 0.0;
+    total += points.at( i ).distance( points.at( i - 1 ) );
   }
-
+  return total;
 }
 
 double QgsDistanceArea::measureLine( const QgsPointXY &p1, const QgsPointXY &p2 ) const
@@ -814,21 +908,23 @@ double QgsDistanceArea::measurePolygon( const QgsCurve *curve ) const
 
 double QgsDistanceArea::measurePolygon( const QVector<QgsPointXY> &points ) const
 {
+  if ( !willUseEllipsoid() )
+    return computePolygonArea( points );
+
+  // all the vertices are transformed in a single call
+  const int nPoints = points.size();
+  QVector< double > x( nPoints );
+  QVector< double > y( nPoints );
+  QVector< double > z( nPoints );
+  for ( int i = 0; i < nPoints; ++i )
+  {
+    x[i] = points.at( i ).x();
+    y[i] = points.at( i ).y();
+  }
+
   try
   {
-    if ( willUseEllipsoid() )
-    {
-      QVector<QgsPointXY> pts;
-      for ( QVector<QgsPointXY>::const_iterator i = points.constBegin(); i != points.constEnd(); ++i )
-      {
-        pts.append( mCoordTransform.transform( *i ) );
-      }
-      return computePolygonArea( pts );
-    }
-    else
-    {
-      return computePolygonArea( points );
-    }
+    mCoordTransform.transformInPlace( x, y, z );
   }
   catch ( QgsCsException &cse )
   {
@@ -836,6 +932,12 @@ double QgsDistanceArea::measurePolygon( const QVector<QgsPointXY> &points ) cons
     QgsMessageLog::logMessage( QObject::tr( "Caught a coordinate system exception while trying to transform a point. Unable to calculate polygon area." ) );
     return 0.0;
   }
+
+  QVector<QgsPointXY> pts;
+  pts.reserve( nPoints );
+  for ( int i = 0; i < nPoints; ++i )
+    pts << QgsPointXY( x.at( i ), y.at( i ) );
+  return computePolygonArea( pts );
 }
 
 
@@ -882,63 +984,7 @@ double QgsDistanceArea::computeDistanceBearing(
   double L = p2_lon - p1_lon;
   double U1 = std::atan( ( 1 - f ) * std::tan( p1_lat ) );
   double U2 = std::atan( ( 1 - f ) * std::tan( p2_lat ) );
-  double sinU1 = std::sin( U1 ), cosU1 = std::cos( U1 );
-  double sinU2 = std::sin( U2 ), cosU2 = std::cos( U2 );
-  double lambda = L;
-  double lambdaP = 2 * M_PI;
-
-  double sinLambda = 0;
-  double cosLambda = 0;
-  double sinSigma = 0;
-  double cosSigma = 0;
-  double sigma = 0;
-  double alpha = 0;
-  double cosSqAlpha = 0;
-  double cos2SigmaM = 0;
-  double C = 0;
-  double tu1 = 0;
-  double tu2 = 0;
-
-  int iterLimit = 20;
-  while ( std::fabs( lambda - lambdaP ) > 1e-12 && --iterLimit > 0 )
-  {
-    sinLambda = std::sin( lambda );
-    cosLambda = std::cos( lambda );
-    tu1 = ( cosU2 * sinLambda );
-    tu2 = ( cosU1 * sinU2 - sinU1 * cosU2 * cosLambda );
-    sinSigma = std::sqrt( tu1 * tu1 + tu2 * tu2 );
-    cosSigma = sinU1 * sinU2 + cosU1 * cosU2 * cosLambda;
-    sigma = std::atan2( sinSigma, cosSigma );
-    alpha = std::asin( cosU1 * cosU2 * sinLambda / sinSigma );
-    cosSqAlpha = std::cos( alpha ) * std::cos( alpha );
-    cos2SigmaM = cosSigma - 2 * sinU1 * sinU2 / cosSqAlpha;
-    C = f / 16 * cosSqAlpha * ( 4 + f * ( 4 - 3 * cosSqAlpha ) );
-    lambdaP = lambda;
-    lambda = L + ( 1 - C ) * f * std::sin( alpha ) *
-             ( sigma + C * sinSigma * ( cos2SigmaM + C * cosSigma * ( -1 + 2 * cos2SigmaM * cos2SigmaM ) ) );
-  }
-
-  if ( iterLimit == 0 )
-    return -1;  // formula failed to converge
-
-  double uSq = cosSqAlpha * ( a * a - b * b ) / ( b * b );
-  double A = 1 + uSq / 16384 * ( 4096 + uSq * ( -768 + uSq * ( 320 - 175 * uSq ) ) );
-  double B = uSq / 1024 * ( 256 + uSq * ( -128 + uSq * ( 74 - 47 * uSq ) ) );
-  double deltaSigma = B * sinSigma * ( cos2SigmaM + B / 4 * ( cosSigma * ( -1 + 2 * cos2SigmaM * cos2SigmaM ) -
-                                       B / 6 * cos2SigmaM * ( -3 + 4 * sinSigma * sinSigma ) * ( -3 + 4 * cos2SigmaM * cos2SigmaM ) ) );
-  double s = b * A * ( sigma - deltaSigma );
-
-  if ( course1 )
-  {
-    *course1 = std::atan2( tu1, tu2 );
-  }
-  if ( course2 )
-  {
-    // PI is added to return azimuth from P2 to P1
-    *course2 = std::atan2( cosU1 * sinLambda, -sinU1 * cosU2 + cosU1 * sinU2 * cosLambda ) + M_PI;
-  }
-
-  return s;
+  return vincentyDistanceBearing( a, b, f, L, std::sin( U1 ), std::cos( U1 ), std::sin( U2 ), std::cos( U2 ), course1, course2 );
 }
 
 ///////////////////////////////////////////////////////////
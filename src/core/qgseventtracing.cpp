@@ -17,6 +17,7 @@
 
 #include <QCoreApplication>
 #include <QFile>
+#include <QStringList>
 #include <QThread>
 
 /// @cond PRIVATE
@@ -29,6 +30,7 @@ struct TraceItem
   QString category;
   QString name;
   QString id;
+  QMap< QString, double > values;
 };
 
 //! Whether we are tracing right now
@@ -79,6 +81,7 @@ static char _eventTypeToChar( QgsEventTracing::EventType type )
     case QgsEventTracing::Instant: return 'i';
     case QgsEventTracing::AsyncBegin: return 'b';
     case QgsEventTracing::AsyncEnd: return 'e';
+    case QgsEventTracing::Counter: return 'C';
   }
   return '?';
 }
@@ -113,6 +116,15 @@ bool QgsEventTracing::writeTrace( const QString &fileName )
     if ( item.type == AsyncBegin || item.type == AsyncEnd )
       msg += QStringLiteral( ", \"id\": \"%1\"" ).arg( item.id );
 
+    // counter events have the values of the counters as arguments
+    if ( item.type == Counter )
+    {
+      QStringList args;
+      for ( auto it = item.values.constBegin(); it != item.values.constEnd(); ++it )
+        args << QStringLiteral( "\"%1\": %2" ).arg( it.key() ).arg( it.value() );
+      msg += QStringLiteral( ", \"args\": {%1}" ).arg( args.join( QStringLiteral( ", " ) ) );
+    }
+
     msg += " }";
 
     f.write( msg.toUtf8() );
@@ -143,4 +155,24 @@ void QgsEventTracing::addEvent( QgsEventTracing::EventType type, const QString &
   sTraceEventsMutex()->unlock();
 }
 
+void QgsEventTracing::addCounterEvent( const QString &category, const QString &name, const QMap< QString, double > &values )
+{
+  if ( !sIsTracing )
+    return;
+
+  sTraceEventsMutex()->lock();
+  TraceItem item;
+  item.type = Counter;
+  item.timestamp = sTracingTimer()->nsecsElapsed() / 1000;
+  if ( QThread::currentThread() == QCoreApplication::instance()->thread() )
+    item.threadId = 0;
+  else
+    item.threadId = static_cast<uint>( reinterpret_cast<quint64>( QThread::currentThreadId() ) );
+  item.category = category;
+  item.name = name;
+  item.values = values;
+  sTraceEvents()->append( item );
+  sTraceEventsMutex()->unlock();
+}
+
 ///@endcond
@@ -22,6 +22,7 @@
 
 #include <QMutex>
 #include <QElapsedTimer>
+#include <QMap>
 #include <QString>
 #include <QVector>
 
@@ -59,6 +60,7 @@
  *   associated with it.
  * # Async events - they are used to specify asynchronous operations. They also require
  *   additional "id" parameter to group them into the same event tree.
+ * # Counter events - they record the values of a set of counters, shown as a stacked graph.
  *
  * Duration events are for example to record run of a single function. Async events
  * are useful for cases where e.g. main thread starts some work in background and there
@@ -90,6 +92,7 @@ class CORE_EXPORT QgsEventTracing
       Instant,     //!< Marks an instant event (which does not have any duration)
       AsyncBegin,  //!< Marks start of an async event - should be paired with "AsyncEnd" event type
       AsyncEnd,    //!< Marks end of an async event - should be paired with "AsyncBegin" event type
+      Counter,     //!< Records the values of counters, see addCounterEvent() (since QGIS 3.16)
     };
 
     /**
@@ -119,6 +122,14 @@ class CORE_EXPORT QgsEventTracing
      */
     static void addEvent( EventType type, const QString &category, const QString &name, const QString &id = QString() );
 
+    /**
+     * Adds a counter event to the trace, with the \a values of the counters by name.
+     * Does nothing if tracing is not started.
+     * \note This method is thread-safe: it can be run from any thread.
+     * \since QGIS 3.16
+     */
+    static void addCounterEvent( const QString &category, const QString &name, const QMap< QString, double > &values );
+
     /**
      * ScopedEvent can be used to trace a single function duration - the constructor adds a "begin" event
      * and the destructor adds "end" event of the same name and category.
@@ -44,6 +44,8 @@ void QgsExpressionFieldBuffer::writeXml( QDomNode &layerNode, QDomDocument &docu
 {
   QDomElement expressionFieldsElem = document.createElement( QStringLiteral( "expressionfields" ) );
   layerNode.appendChild( expressionFieldsElem );
+  if ( mValueCachingEnabled )
+    expressionFieldsElem.setAttribute( QStringLiteral( "cacheValues" ), 1 );
 
   const auto constMExpressions = mExpressions;
   for ( const ExpressionField &fld : constMExpressions )
@@ -68,6 +70,7 @@ void QgsExpressionFieldBuffer::readXml( const QDomNode &layerNode )
   mExpressions.clear();
 
   const QDomElement expressionFieldsElem = layerNode.firstChildElement( QStringLiteral( "expressionfields" ) );
+  mValueCachingEnabled = expressionFieldsElem.attribute( QStringLiteral( "cacheValues" ), QStringLiteral( "0" ) ).toInt();
 
   if ( !expressionFieldsElem.isNull() )
   {
@@ -105,8 +105,26 @@ class CORE_EXPORT QgsExpressionFieldBuffer
 
     QList<QgsExpressionFieldBuffer::ExpressionField> expressions() const { return mExpressions; }
 
+    /**
+     * Sets whether the values of the expression fields are cached by feature id, instead of
+     * being evaluated each time the features are fetched.
+     *
+     * \see QgsVectorLayer::setExpressionFieldValueCachingEnabled()
+     * \since QGIS 3.16
+     */
+    void setValueCachingEnabled( bool enabled ) { mValueCachingEnabled = enabled; }
+
+    /**
+     * Returns TRUE if the values of the expression fields are cached by feature id.
+     *
+     * \see setValueCachingEnabled()
+     * \since QGIS 3.16
+     */
+    bool valueCachingEnabled() const { return mValueCachingEnabled; }
+
   private:
     QList<ExpressionField> mExpressions;
+    bool mValueCachingEnabled = false;
 };
 
 #endif // QGSEXPRESSIONFIELDBUFFER_H
@@ -0,0 +1,165 @@
+/***************************************************************************
+                         qgsexpressionfieldvaluecache.cpp
+                         --------------------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsexpressionfieldvaluecache.h"
+#include "qgsexpression.h"
+#include "qgsexpressionfunction.h"
+#include "qgsexpressionnodeimpl.h"
+
+#include <QMutexLocker>
+
+bool QgsExpressionFieldValueCache::isCacheable( const QgsExpression &expression )
+{
+  if ( expression.hasParserError() || !expression.referencedVariables().isEmpty() )
+    return false;
+
+  const QSet<QString> functions = expression.referencedFunctions();
+  for ( const QString &function : functions )
+  {
+    // values changing on each call, or depending on state which is not tracked
+    if ( function == QLatin1String( "rand" ) || function == QLatin1String( "randf" )
+         || function == QLatin1String( "uuid" ) || function == QLatin1String( "now" )
+         || function == QLatin1String( "eval" ) || function == QLatin1String( "is_selected" )
+         || function == QLatin1String( "num_selected" ) || function == QLatin1String( "represent_value" )
+         || function == QLatin1String( "sqlite_fetch_and_increment" ) )
+      return false;
+  }
+
+  QSet<QString> layers;
+  QSet<QString> relations;
+  return referencedLayers( expression, layers, relations );
+}
+
+bool QgsExpressionFieldValueCache::referencedLayers( const QgsExpression &expression, QSet<QString> &layers, QSet<QString> &relations )
+{
+  if ( !expression.rootNode() )
+    return true;
+
+  const QList<const QgsExpressionNode *> nodes = expression.rootNode()->nodes();
+  for ( const QgsExpressionNode *node : nodes )
+  {
+    if ( node->nodeType() != QgsExpressionNode::ntFunction )
+      continue;
+
+    const QgsExpressionNodeFunction *functionNode = static_cast<const QgsExpressionNodeFunction *>( node );
+    const QString name = QgsExpression::Functions().at( functionNode->fnIndex() )->name();
+    const bool layerArgument = name == QLatin1String( "get_feature" ) || name == QLatin1String( "get_feature_by_id" )
+                               || name == QLatin1String( "aggregate" ) || name == QLatin1String( "layer_property" );
+    const bool relationArgument = name == QLatin1String( "relation_aggregate" );
+    if ( !layerArgument && !relationArgument )
+      continue;
+
+    // the layer or relation must be known before the evaluation to track its changes
+    const QgsExpressionNode *argument = functionNode->args() ? functionNode->args()->list().value( 0 ) : nullptr;
+    if ( !argument || argument->nodeType() != QgsExpressionNode::ntLiteral )
+      return false;
+
+    const QString reference = static_cast<const QgsExpressionNodeLiteral *>( argument )->value().toString();
+    if ( layerArgument )
+      layers << reference;
+    else
+      relations << reference;
+  }
+  return true;
+}
+
+bool QgsExpressionFieldValueCache::isFeatureLocal( const QgsExpression &expression )
+{
+  const QSet<QString> functions = expression.referencedFunctions();
+  for ( const QString &function : functions )
+  {
+    if ( function == QLatin1String( "get_feature" ) || function == QLatin1String( "get_feature_by_id" )
+         || function == QLatin1String( "eval" ) )
+      return false;
+
+    const int index = QgsExpression::functionIndex( function );
+    if ( index >= 0 && QgsExpression::Functions().at( index )->groups().contains( QStringLiteral( "Aggregates" ) ) )
+      return false;
+  }
+  return true;
+}
+
+void QgsExpressionFieldValueCache::setMaximumSize( int size )
+{
+  QMutexLocker locker( &mMutex );
+  mMaximumSize = size;
+}
+
+int QgsExpressionFieldValueCache::maximumSize() const
+{
+  QMutexLocker locker( &mMutex );
+  return mMaximumSize;
+}
+
+int QgsExpressionFieldValueCache::size() const
+{
+  QMutexLocker locker( &mMutex );
+  return mSize;
+}
+
+int QgsExpressionFieldValueCache::generation() const
+{
+  QMutexLocker locker( &mMutex );
+  return mGeneration;
+}
+
+bool QgsExpressionFieldValueCache::value( int fieldIndex, QgsFeatureId fid, int generation, QVariant &value ) const
+{
+  QMutexLocker locker( &mMutex );
+  if ( generation != mGeneration )
+    return false;
+
+  const auto featureIt = mValues.constFind( fid );
+  if ( featureIt == mValues.constEnd() )
+    return false;
+
+  const auto valueIt = featureIt->constFind( fieldIndex );
+  if ( valueIt == featureIt->constEnd() )
+    return false;
+
+  value = valueIt.value();
+  return true;
+}
+
+bool QgsExpressionFieldValueCache::insert( int fieldIndex, QgsFeatureId fid, int generation, const QVariant &value )
+{
+  QMutexLocker locker( &mMutex );
+  if ( generation != mGeneration || mSize >= mMaximumSize )
+    return false;
+
+  QMap<int, QVariant> &values = mValues[ fid ];
+  if ( !values.contains( fieldIndex ) )
+    ++mSize;
+  values.insert( fieldIndex, value );
+  return true;
+}
+
+void QgsExpressionFieldValueCache::invalidateFeature( QgsFeatureId fid )
+{
+  QMutexLocker locker( &mMutex );
+  // the iterators created before may have read the feature before the change
+  ++mGeneration;
+  mSize -= mValues.take( fid ).size();
+}
+
+void QgsExpressionFieldValueCache::clear()
+{
+  QMutexLocker locker( &mMutex );
+  ++mGeneration;
+  mValues.clear();
+  mSize = 0;
+}
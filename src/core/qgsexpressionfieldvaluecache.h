@@ -0,0 +1,135 @@
+/***************************************************************************
+                         qgsexpressionfieldvaluecache.h
+                         ------------------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSEXPRESSIONFIELDVALUECACHE_H
+#define QGSEXPRESSIONFIELDVALUECACHE_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+#include "qgsfeatureid.h"
+
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QSet>
+#include <QVariant>
+
+class QgsExpression;
+
+/**
+ * \ingroup core
+ * \class QgsExpressionFieldValueCache
+ * \brief Store of the values of the expression fields of a vector layer, by feature id.
+ *
+ * When the caching of the expression field values is enabled for a layer,
+ * QgsVectorLayerFeatureIterator takes the values of the expression fields from
+ * the cache instead of evaluating their expressions, and stores the values it
+ * evaluates. This mostly helps the expressions which are costly to evaluate, such
+ * as the ones using aggregates or get_feature(), when the features are read again
+ * by the attribute table or the renderers.
+ *
+ * The layer invalidates the values of a feature when an attribute referenced by an
+ * expression or its geometry is changed, and the whole cache when the expressions
+ * depend on other features (see isFeatureLocal()) or when its data changed. The
+ * layers read by the expressions (see referencedLayers()) invalidate the whole cache
+ * when their features change.
+ *
+ * Each invalidation increments the generation of the cache: the values are only read
+ * and stored for the generation at which the feature source of an iterator was
+ * created, so that the values evaluated from an outdated snapshot of the layer are
+ * never stored.
+ *
+ * Once the cache holds maximumSize() values, no more values are stored until the cache
+ * is cleared.
+ *
+ * The cache is thread-safe.
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.16
+ */
+class CORE_EXPORT QgsExpressionFieldValueCache
+{
+  public:
+
+    /**
+     * Returns TRUE if the values of \a expression can be cached, i.e. if they only depend
+     * on the feature they are evaluated for and on the features of layers. Expressions using
+     * variables, the selection, eval() or functions whose result differs on each call (like rand()
+     * or now()) are not cached, nor expressions reading layers which are only known when evaluated.
+     *
+     * \see referencedLayers()
+     */
+    static bool isCacheable( const QgsExpression &expression );
+
+    /**
+     * Adds to \a layers the names or ids of the layers read by the get_feature(), aggregate()
+     * and layer_property() functions of \a expression, and to \a relations the ids of the relations
+     * of its relation_aggregate() functions.
+     *
+     * Returns FALSE if one of these functions takes its layer or relation from an expression
+     * instead of a literal value.
+     */
+    static bool referencedLayers( const QgsExpression &expression, QSet<QString> &layers, QSet<QString> &relations );
+
+    /**
+     * Returns TRUE if the value of \a expression for a feature only depends on this feature, i.e.
+     * if the expression does not use aggregates, get_feature() or eval().
+     */
+    static bool isFeatureLocal( const QgsExpression &expression );
+
+    //! Sets the maximum number of cached values
+    void setMaximumSize( int size );
+
+    //! Returns the maximum number of cached values
+    int maximumSize() const;
+
+    //! Returns the number of cached values
+    int size() const;
+
+    //! Returns the generation of the cache, incremented each time values are invalidated
+    int generation() const;
+
+    /**
+     * Sets \a value to the cached value of the field at \a fieldIndex for the feature \a fid.
+     * Returns FALSE if the value is not cached or if the cache is not at \a generation anymore.
+     */
+    bool value( int fieldIndex, QgsFeatureId fid, int generation, QVariant &value ) const;
+
+    /**
+     * Stores the \a value of the field at \a fieldIndex for the feature \a fid, evaluated at the
+     * cache \a generation. Returns FALSE if the value is discarded because the cache was invalidated
+     * in between or because it is full.
+     */
+    bool insert( int fieldIndex, QgsFeatureId fid, int generation, const QVariant &value );
+
+    //! Removes the values of the feature \a fid
+    void invalidateFeature( QgsFeatureId fid );
+
+    //! Removes all the values
+    void clear();
+
+  private:
+
+    mutable QMutex mMutex;
+    QHash<QgsFeatureId, QMap<int, QVariant>> mValues;
+    int mSize = 0;
+    int mMaximumSize = 1000000;
+    int mGeneration = 0;
+};
+
+#endif // QGSEXPRESSIONFIELDVALUECACHE_H
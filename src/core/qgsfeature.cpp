@@ -17,6 +17,7 @@ email                : sherman at mrcc.com
 #include "qgsfeature_p.h"
 #include "qgsfields.h"
 #include "qgsgeometry.h"
+#include "qgshotpathinstrumentation.h"
 #include "qgsrectangle.h"
 
 #include "qgsmessagelog.h"
@@ -30,6 +31,16 @@ email                : sherman at mrcc.com
  ****************************************************************************/
 
 
+//! Detaches the shared data of a feature, counting the copies in instrumented builds
+static inline void detachFeature( QExplicitlySharedDataPointer<QgsFeaturePrivate> &d )
+{
+#ifdef QGIS_HOTPATH_INSTRUMENTATION
+  if ( d->ref.load() != 1 )
+    QgsHotPathInstrumentation::count( QgsHotPathInstrumentation::FeatureDetach );
+#endif
+  d.detach();
+}
+
 //
 // QgsFeature
 //
@@ -94,7 +105,7 @@ QgsFeatureId QgsFeature::id() const
 
 void QgsFeature::deleteAttribute( int field )
 {
-  d.detach();
+  detachFeature( d );
   d->attributes.remove( field );
 }
 
@@ -114,7 +125,7 @@ void QgsFeature::setId( QgsFeatureId id )
   if ( id == d->fid )
     return;
 
-  d.detach();
+  detachFeature( d );
   d->fid = id;
   d->valid = true;
 }
@@ -129,21 +140,21 @@ void QgsFeature::setAttributes( const QgsAttributes &attrs )
   if ( attrs == d->attributes )
     return;
 
-  d.detach();
+  detachFeature( d );
   d->attributes = attrs;
   d->valid = true;
 }
 
 void QgsFeature::setGeometry( const QgsGeometry &geometry )
 {
-  d.detach();
+  detachFeature( d );
   d->geometry = geometry;
   d->valid = true;
 }
 
 void QgsFeature::setGeometry( std::unique_ptr<QgsAbstractGeometry> geometry )
 {
-  d.detach();
+  detachFeature( d );
   d->geometry = QgsGeometry( std::move( geometry ) );
   d->valid = true;
 }
@@ -161,7 +172,7 @@ void QgsFeature::clearGeometry()
 
 void QgsFeature::setFields( const QgsFields &fields, bool init )
 {
-  d.detach();
+  detachFeature( d );
   d->fields = fields;
   if ( init )
   {
@@ -190,7 +201,7 @@ void QgsFeature::setValid( bool validity )
   if ( d->valid == validity )
     return;
 
-  d.detach();
+  detachFeature( d );
   d->valid = validity;
 }
 
@@ -201,7 +212,7 @@ bool QgsFeature::hasGeometry() const
 
 void QgsFeature::initAttributes( int fieldCount )
 {
-  d.detach();
+  detachFeature( d );
   d->attributes.resize( 0 ); // clears existing elements, while still preserving the currently allocated capacity of the list (unlike clear)
   // ensures ALL attributes, including previously existing ones are default constructed.
   // doing it this way also avoids clearing individual QVariants -- which can trigger a detachment. Cheaper just to make a new one.
@@ -216,7 +227,7 @@ bool QgsFeature::setAttribute( int idx, const QVariant &value )
     return false;
   }
 
-  d.detach();
+  detachFeature( d );
   d->attributes[idx] = value;
   d->valid = true;
   return true;
@@ -234,7 +245,7 @@ bool QgsFeature::setAttribute( const QString &name, const QVariant &value )
   if ( fieldIdx == -1 )
     return false;
 
-  d.detach();
+  detachFeature( d );
   d->attributes[fieldIdx] = value;
   d->valid = true;
   return true;
@@ -246,7 +257,7 @@ bool QgsFeature::deleteAttribute( const QString &name )
   if ( fieldIdx == -1 )
     return false;
 
-  d.detach();
+  detachFeature( d );
   d->attributes[fieldIdx].clear();
   return true;
 }
@@ -0,0 +1,305 @@
+/***************************************************************************
+                         qgsfeaturebatch.cpp
+                         -------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsfeaturebatch.h"
+#include "qgsfeature.h"
+#include "qgsgeometry.h"
+
+#include <limits>
+
+QgsFeatureBatch::QgsFeatureBatch( const QgsFields &fields, const QgsAttributeList &attributes, bool withGeometry )
+  : mFields( fields )
+  , mWithGeometry( withGeometry )
+{
+  const QgsAttributeList columns = attributes.isEmpty() ? fields.allAttributesList() : attributes;
+  mColumns.reserve( columns.size() );
+  for ( int attributeIndex : columns )
+  {
+    if ( attributeIndex < 0 || attributeIndex >= fields.count() )
+      continue;
+
+    Column column;
+    column.attributeIndex = attributeIndex;
+    column.fieldType = fields.at( attributeIndex ).type();
+    switch ( column.fieldType )
+    {
+      case QVariant::Int:
+      case QVariant::UInt:
+      case QVariant::LongLong:
+      case QVariant::ULongLong:
+      case QVariant::Bool:
+        column.type = Int64;
+        break;
+
+      case QVariant::Double:
+        column.type = Double;
+        break;
+
+      default:
+        column.type = String;
+        column.stringOffsets.append( 0 );
+        break;
+    }
+    mAttributeToColumn.insert( attributeIndex, mColumns.size() );
+    mColumns.append( column );
+  }
+
+  if ( mWithGeometry )
+    mWkbOffsets.append( 0 );
+}
+
+void QgsFeatureBatch::clear()
+{
+  mIds.resize( 0 );
+  for ( Column &column : mColumns )
+  {
+    column.nulls.resize( 0 );
+    column.doubles.resize( 0 );
+    column.integers.resize( 0 );
+    column.strings.resize( 0 );
+    if ( column.type == String )
+      column.stringOffsets.resize( 1 );
+  }
+  mWkb.resize( 0 );
+  if ( mWithGeometry )
+    mWkbOffsets.resize( 1 );
+}
+
+double QgsFeatureBatch::doubleValue( int column, int row ) const
+{
+  const Column &c = mColumns.at( column );
+  if ( c.nulls.at( row ) )
+    return std::numeric_limits<double>::quiet_NaN();
+
+  switch ( c.type )
+  {
+    case Double:
+      return c.doubles.at( row );
+    case Int64:
+      return static_cast< double >( c.integers.at( row ) );
+    case String:
+      break;
+  }
+  return std::numeric_limits<double>::quiet_NaN();
+}
+
+QString QgsFeatureBatch::stringValue( int column, int row ) const
+{
+  const Column &c = mColumns.at( column );
+  if ( c.nulls.at( row ) )
+    return QString();
+
+  switch ( c.type )
+  {
+    case Double:
+      return QString::number( c.doubles.at( row ) );
+    case Int64:
+      return QString::number( c.integers.at( row ) );
+    case String:
+    {
+      const int start = c.stringOffsets.at( row );
+      return QString::fromUtf8( c.strings.constData() + start, c.stringOffsets.at( row + 1 ) - start );
+    }
+  }
+  return QString();
+}
+
+const char *QgsFeatureBatch::utf8Value( int column, int row, int &length ) const
+{
+  const Column &c = mColumns.at( column );
+  const int start = c.stringOffsets.at( row );
+  length = c.stringOffsets.at( row + 1 ) - start;
+  return c.strings.constData() + start;
+}
+
+QVariant QgsFeatureBatch::value( int column, int row ) const
+{
+  const Column &c = mColumns.at( column );
+  if ( c.nulls.at( row ) )
+    return QVariant( c.fieldType );
+
+  QVariant v;
+  switch ( c.type )
+  {
+    case Double:
+      return c.doubles.at( row );
+    case Int64:
+      v = c.integers.at( row );
+      break;
+    case String:
+      v = stringValue( column, row );
+      break;
+  }
+  if ( v.type() != c.fieldType )
+    v.convert( c.fieldType );
+  return v;
+}
+
+QByteArray QgsFeatureBatch::wkb( int row ) const
+{
+  if ( !mWithGeometry )
+    return QByteArray();
+
+  const int start = mWkbOffsets.at( row );
+  return mWkb.mid( start, mWkbOffsets.at( row + 1 ) - start );
+}
+
+void QgsFeatureBatch::appendNull( int column )
+{
+  Column &c = mColumns[ column ];
+  c.nulls.append( true );
+  switch ( c.type )
+  {
+    case Double:
+      c.doubles.append( std::numeric_limits<double>::quiet_NaN() );
+      break;
+    case Int64:
+      c.integers.append( 0 );
+      break;
+    case String:
+      c.stringOffsets.append( c.strings.size() );
+      break;
+  }
+}
+
+void QgsFeatureBatch::appendDouble( int column, double value )
+{
+  Column &c = mColumns[ column ];
+  switch ( c.type )
+  {
+    case Double:
+      c.nulls.append( false );
+      c.doubles.append( value );
+      break;
+    case Int64:
+      c.nulls.append( false );
+      c.integers.append( static_cast< qint64 >( value ) );
+      break;
+    case String:
+    {
+      const QByteArray str = QByteArray::number( value, 'g', 17 );
+      appendString( column, str.constData(), str.size() );
+      break;
+    }
+  }
+}
+
+void QgsFeatureBatch::appendInt64( int column, qint64 value )
+{
+  Column &c = mColumns[ column ];
+  switch ( c.type )
+  {
+    case Double:
+      c.nulls.append( false );
+      c.doubles.append( static_cast< double >( value ) );
+      break;
+    case Int64:
+      c.nulls.append( false );
+      c.integers.append( value );
+      break;
+    case String:
+    {
+      const QByteArray str = QByteArray::number( value );
+      appendString( column, str.constData(), str.size() );
+      break;
+    }
+  }
+}
+
+void QgsFeatureBatch::appendString( int column, const char *value, int length )
+{
+  Column &c = mColumns[ column ];
+  if ( c.type != String )
+  {
+    bool ok = false;
+    const double d = QByteArray::fromRawData( value, length ).toDouble( &ok );
+    if ( ok )
+      appendDouble( column, d );
+    else
+      appendNull( column );
+    return;
+  }
+
+  c.nulls.append( false );
+  c.strings.append( value, length );
+  c.stringOffsets.append( c.strings.size() );
+}
+
+void QgsFeatureBatch::appendWkb( const QByteArray &wkb )
+{
+  if ( !mWithGeometry )
+    return;
+
+  mWkb.append( wkb );
+  mWkbOffsets.append( mWkb.size() );
+}
+
+void QgsFeatureBatch::appendValue( int column, const QVariant &value )
+{
+  if ( value.isNull() )
+  {
+    appendNull( column );
+    return;
+  }
+
+  bool ok = true;
+  switch ( mColumns.at( column ).type )
+  {
+    case Double:
+    {
+      const double d = value.toDouble( &ok );
+      if ( ok )
+        appendDouble( column, d );
+      break;
+    }
+    case Int64:
+    {
+      const qlonglong i = value.toLongLong( &ok );
+      if ( ok )
+        appendInt64( column, i );
+      break;
+    }
+    case String:
+    {
+      const QByteArray str = value.toString().toUtf8();
+      appendString( column, str.constData(), str.size() );
+      break;
+    }
+  }
+
+  if ( !ok )
+    appendNull( column );
+}
+
+void QgsFeatureBatch::appendFeature( const QgsFeature &feature )
+{
+  mIds.append( feature.id() );
+
+  const QgsAttributes attributes = feature.attributes();
+  const int attributeCount = attributes.count();
+  for ( int column = 0; column < mColumns.size(); ++column )
+  {
+    const int attributeIndex = mColumns.at( column ).attributeIndex;
+    if ( attributeIndex < attributeCount )
+      appendValue( column, attributes.at( attributeIndex ) );
+    else
+      appendNull( column );
+  }
+
+  if ( mWithGeometry )
+    appendWkb( feature.hasGeometry() ? feature.geometry().asWkb() : QByteArray() );
+}
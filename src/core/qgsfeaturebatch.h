@@ -0,0 +1,204 @@
+/***************************************************************************
+                         qgsfeaturebatch.h
+                         -----------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSFEATUREBATCH_H
+#define QGSFEATUREBATCH_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+#include "qgsfeatureid.h"
+#include "qgsfields.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QVariant>
+#include <QVector>
+
+class QgsFeature;
+
+/**
+ * \ingroup core
+ * \class QgsFeatureBatch
+ * \brief A batch of features stored by columns (structure of arrays).
+ *
+ * Each requested attribute is stored in a typed column buffer: 64 bit integers,
+ * doubles or UTF-8 strings (a single data buffer with offsets), together with
+ * a null mask. Geometries are stored as WKB in a single buffer with offsets.
+ * This avoids the QVariant boxing and the per feature allocations of QgsFeature
+ * when scanning large layers, e.g. to compute aggregates or statistics.
+ *
+ * Batches are filled with QgsFeatureIterator::nextBatch(). The buffers are reused
+ * between calls, so a batch should be kept alive while iterating.
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.16
+ */
+class CORE_EXPORT QgsFeatureBatch
+{
+  public:
+
+    //! Storage type of a column
+    enum ColumnType
+    {
+      Int64, //!< Integer values, stored as 64 bit integers
+      Double, //!< Floating point values
+      String, //!< Any other value, stored as a UTF-8 string
+    };
+
+    /**
+     * Constructor for QgsFeatureBatch.
+     * \param fields fields of the iterated layer
+     * \param attributes indexes of the attributes to store (all the attributes if empty)
+     * \param withGeometry TRUE if the geometries have to be stored
+     */
+    QgsFeatureBatch( const QgsFields &fields, const QgsAttributeList &attributes = QgsAttributeList(), bool withGeometry = false );
+
+    //! Removes all the features from the batch, keeping the allocated buffers
+    void clear();
+
+    //! Returns the number of features in the batch
+    int size() const { return mIds.size(); }
+
+    //! Returns TRUE if the batch does not contain any feature
+    bool isEmpty() const { return mIds.isEmpty(); }
+
+    //! Returns TRUE if the batch stores geometries
+    bool hasGeometry() const { return mWithGeometry; }
+
+    //! Returns the feature ids
+    const QVector<QgsFeatureId> &featureIds() const { return mIds; }
+
+    //! Returns the number of attribute columns
+    int columnCount() const { return mColumns.size(); }
+
+    //! Returns the column index of the field with index \a attributeIndex, or -1 if the attribute is not stored
+    int columnForAttribute( int attributeIndex ) const { return mAttributeToColumn.value( attributeIndex, -1 ); }
+
+    //! Returns the field index of the \a column
+    int attributeIndex( int column ) const { return mColumns.at( column ).attributeIndex; }
+
+    //! Returns the storage type of the \a column
+    ColumnType columnType( int column ) const { return mColumns.at( column ).type; }
+
+    //! Returns TRUE if the value of the feature at \a row is NULL in \a column
+    bool isNull( int column, int row ) const { return mColumns.at( column ).nulls.at( row ); }
+
+    //! Returns the null mask of the \a column
+    const QVector<bool> &nullMask( int column ) const { return mColumns.at( column ).nulls; }
+
+    /**
+     * Returns the values of a Double column. For Int64 and String columns the
+     * returned vector is empty.
+     */
+    const QVector<double> &doubleValues( int column ) const { return mColumns.at( column ).doubles; }
+
+    /**
+     * Returns the values of an Int64 column. For Double and String columns the
+     * returned vector is empty.
+     */
+    const QVector<qint64> &int64Values( int column ) const { return mColumns.at( column ).integers; }
+
+    /**
+     * Returns the value of the feature at \a row as a double, for any numeric column.
+     * NULL values are returned as NaN.
+     */
+    double doubleValue( int column, int row ) const;
+
+    //! Returns the value of the feature at \a row of a String column
+    QString stringValue( int column, int row ) const;
+
+    /**
+     * Returns the UTF-8 encoded value of the feature at \a row of a String \a column, without
+     * decoding it, and sets \a length to its size in bytes. The data is not null terminated and
+     * remains valid until the batch is cleared or refilled.
+     */
+    const char *utf8Value( int column, int row, int &length ) const;
+
+    /**
+     * Returns the value of the feature at \a row in \a column as a QVariant
+     * of the original field type.
+     */
+    QVariant value( int column, int row ) const;
+
+    //! Returns the WKB of the geometry at \a row, empty if the feature has no geometry
+    QByteArray wkb( int row ) const;
+
+    /**
+     * Returns the WKB buffer storing all the geometries, see wkbOffsets().
+     */
+    const QByteArray &wkbData() const { return mWkb; }
+
+    /**
+     * Returns the offsets of the geometries in wkbData(). The geometry at row i
+     * is stored between offsets[i] and offsets[i + 1], the vector contains size() + 1 values.
+     */
+    const QVector<int> &wkbOffsets() const { return mWkbOffsets; }
+
+    /**
+     * Appends the feature \a id to the batch: the values of the attributes
+     * have to be appended with appendNull(), appendDouble(), appendInt64() or appendString()
+     * for each column in order, then the geometry with appendWkb() if hasGeometry().
+     * This is intended for providers filling batches natively.
+     */
+    void appendFeatureId( QgsFeatureId id ) { mIds.append( id ); }
+
+    //! Appends a NULL value to \a column
+    void appendNull( int column );
+
+    //! Appends a numeric \a value to a Double or Int64 \a column
+    void appendDouble( int column, double value );
+
+    //! Appends an integer \a value to an Int64 or Double \a column
+    void appendInt64( int column, qint64 value );
+
+    //! Appends a UTF-8 encoded string \a value of \a length bytes to a String \a column
+    void appendString( int column, const char *value, int length );
+
+    //! Appends a \a value to \a column, converted to the column type
+    void appendValue( int column, const QVariant &value );
+
+    //! Appends the geometry of the last feature, an empty array means no geometry
+    void appendWkb( const QByteArray &wkb );
+
+    //! Appends a \a feature, converting its attributes to the column types
+    void appendFeature( const QgsFeature &feature );
+
+  private:
+
+    struct Column
+    {
+      int attributeIndex = -1;
+      ColumnType type = String;
+      QVariant::Type fieldType = QVariant::Invalid;
+      QVector<bool> nulls;
+      QVector<double> doubles;
+      QVector<qint64> integers;
+      QByteArray strings;
+      QVector<int> stringOffsets;
+    };
+
+    QgsFields mFields;
+    bool mWithGeometry = false;
+    QVector<QgsFeatureId> mIds;
+    QVector<Column> mColumns;
+    QHash<int, int> mAttributeToColumn;
+    QByteArray mWkb;
+    QVector<int> mWkbOffsets;
+};
+
+#endif // QGSFEATUREBATCH_H
@@ -100,14 +100,25 @@ class QgsFeatureExpressionValuesGatherer: public QThread
       for ( const QString &fieldName : qgis::as_const( mIdentifierFields ) )
         attributeIndexes << mSource->fields().indexOf( fieldName );
 
+      // a display expression made of a single field is read directly from the attributes
+      const int displayFieldIndex = mDisplayExpression.isField() ? mSource->fields().lookupField( *mDisplayExpression.referencedColumns().constBegin() ) : -1;
+
       while ( iterator.nextFeature( feature ) )
       {
-        mExpressionContext.setFeature( feature );
         QVariantList attributes;
         for ( const int idx : attributeIndexes )
           attributes << feature.attribute( idx );
 
-        const QString expressionValue = mDisplayExpression.evaluate( &mExpressionContext ).toString();
+        QString expressionValue;
+        if ( displayFieldIndex >= 0 )
+        {
+          expressionValue = feature.attribute( displayFieldIndex ).toString();
+        }
+        else
+        {
+          mExpressionContext.setFeature( feature );
+          expressionValue = mDisplayExpression.evaluate( &mExpressionContext ).toString();
+        }
 
         mEntries.append( Entry( attributes, expressionValue, feature ) );
 
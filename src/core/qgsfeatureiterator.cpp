@@ -17,13 +17,18 @@
 
 #include "qgssimplifymethod.h"
 #include "qgsexception.h"
-#include "qgsexpressionsorter.h"
+#include "qgsfeaturebatch.h"
+#include "qgsfeaturemergesorter_p.h"
+
+#include <algorithm>
 
 QgsAbstractFeatureIterator::QgsAbstractFeatureIterator( const QgsFeatureRequest &request )
   : mRequest( request )
 {
 }
 
+QgsAbstractFeatureIterator::~QgsAbstractFeatureIterator() = default;
+
 bool QgsAbstractFeatureIterator::nextFeature( QgsFeature &f )
 {
   bool dataOk = false;
@@ -34,10 +39,8 @@ bool QgsAbstractFeatureIterator::nextFeature( QgsFeature &f )
 
   if ( mUseCachedFeatures )
   {
-    if ( mFeatureIterator != mCachedFeatures.constEnd() )
+    if ( mOrderBySorter->nextFeature( f ) )
     {
-      f = mFeatureIterator->mFeature;
-      ++mFeatureIterator;
       dataOk = true;
     }
     else
@@ -71,6 +74,38 @@ bool QgsAbstractFeatureIterator::nextFeature( QgsFeature &f )
   return dataOk;
 }
 
+int QgsAbstractFeatureIterator::nextBatch( QgsFeatureBatch &batch, int maxFeatures )
+{
+  batch.clear();
+
+  if ( mRequest.limit() >= 0 )
+    maxFeatures = static_cast< int >( std::min< long >( maxFeatures, mRequest.limit() - mFetchedCount ) );
+
+  if ( maxFeatures <= 0 )
+    return 0;
+
+  // features can be returned as fetched by the provider
+  if ( !mUseCachedFeatures &&
+       ( mRequest.filterType() == QgsFeatureRequest::FilterNone || mRequest.filterType() == QgsFeatureRequest::FilterFid ) &&
+       fetchBatch( batch, maxFeatures ) )
+  {
+    mFetchedCount += batch.size();
+    return batch.size();
+  }
+
+  QgsFeature f;
+  while ( batch.size() < maxFeatures && nextFeature( f ) )
+  {
+    batch.appendFeature( f );
+  }
+  return batch.size();
+}
+
+bool QgsAbstractFeatureIterator::fetchBatch( QgsFeatureBatch &, int )
+{
+  return false;
+}
+
 bool QgsAbstractFeatureIterator::nextFeatureFilterExpression( QgsFeature &f )
 {
   while ( fetchFeature( f ) )
@@ -176,29 +211,28 @@ void QgsAbstractFeatureIterator::setupOrderBy( const QList<QgsFeatureRequest::Or
     }
     while ( ++orderByIt != preparedOrderBys.end() );
 
-    // Fetch all features
-    QgsIndexedFeature indexedFeature;
-    indexedFeature.mIndexes.resize( preparedOrderBys.size() );
+    // Fetch all features, sorted by runs which are spilled to temporary files once the memory budget is exceeded
+    mOrderBySorter = qgis::make_unique< QgsFeatureMergeSorter >( preparedOrderBys );
+    QgsFeature feature;
+    QVector<QVariant> values( preparedOrderBys.size() );
 
-    while ( nextFeature( indexedFeature.mFeature ) )
+    while ( nextFeature( feature ) )
     {
-      expressionContext->setFeature( indexedFeature.mFeature );
+      expressionContext->setFeature( feature );
       int i = 0;
-      const auto constPreparedOrderBys = preparedOrderBys;
-      for ( const QgsFeatureRequest::OrderByClause &orderBy : constPreparedOrderBys )
+      for ( const QgsFeatureRequest::OrderByClause &orderBy : qgis::as_const( preparedOrderBys ) )
       {
-        indexedFeature.mIndexes.replace( i++, orderBy.expression().evaluate( expressionContext ) );
+        values[ i++ ] = orderBy.expression().evaluate( expressionContext );
       }
 
       // We need all features, to ignore the limit for this pre-fetch
       // keep the fetched count at 0.
       mFetchedCount = 0;
-      mCachedFeatures.append( indexedFeature );
+      mOrderBySorter->addFeature( feature, values );
     }
 
-    std::sort( mCachedFeatures.begin(), mCachedFeatures.end(), QgsExpressionSorter( preparedOrderBys ) );
+    mOrderBySorter->finish();
 
-    mFeatureIterator = mCachedFeatures.constBegin();
     mUseCachedFeatures = true;
     // The real iterator is closed, we are only serving cached features
     mZombie = true;
@@ -19,7 +19,11 @@
 #include "qgsfeaturerequest.h"
 #include "qgsindexedfeature.h"
 
+#include <memory>
+
 class QgsFeedback;
+class QgsFeatureBatch;
+class QgsFeatureMergeSorter;
 
 /**
  * \ingroup core
@@ -41,11 +45,25 @@ class CORE_EXPORT QgsAbstractFeatureIterator
     QgsAbstractFeatureIterator( const QgsFeatureRequest &request );
 
     //! destructor makes sure that the iterator is closed properly
-    virtual ~QgsAbstractFeatureIterator() = default;
+    virtual ~QgsAbstractFeatureIterator();
 
     //! fetch next feature, return TRUE on success
     virtual bool nextFeature( QgsFeature &f );
 
+    /**
+     * Fetches the next \a maxFeatures features (at most) into a columnar \a batch.
+     * The batch is cleared first.
+     *
+     * Iterators implementing fetchBatch() fill the batch natively when no
+     * client side filtering or ordering is required, otherwise the features
+     * are fetched with nextFeature() and appended to the batch.
+     *
+     * \returns the number of features stored in the batch, 0 when there are no more features
+     * \note not available in Python bindings
+     * \since QGIS 3.16
+     */
+    int nextBatch( QgsFeatureBatch &batch, int maxFeatures ) SIP_SKIP;
+
     //! reset the iterator to the starting position
     virtual bool rewind() = 0;
     //! end of iterating: free the resources / lock
@@ -102,6 +120,21 @@ class CORE_EXPORT QgsAbstractFeatureIterator
      */
     virtual bool fetchFeature( QgsFeature &f ) = 0;
 
+    /**
+     * Iterators able to fill a columnar \a batch without building a QgsFeature
+     * for each feature can implement this method. It is only called when the
+     * features can be returned as fetched, i.e. when no filter expression, fids
+     * filter or local ordering has to be applied by the base class.
+     *
+     * Implementations must append at most \a maxFeatures features to \a batch
+     * and return TRUE, or return FALSE without fetching any feature if the
+     * batch cannot be filled natively (the default implementation).
+     *
+     * \note not available in Python bindings
+     * \since QGIS 3.16
+     */
+    virtual bool fetchBatch( QgsFeatureBatch &batch, int maxFeatures ) SIP_SKIP;
+
     /**
      * By default, the iterator will fetch all features and check if the feature
      * matches the expression.
@@ -198,8 +231,7 @@ class CORE_EXPORT QgsAbstractFeatureIterator
 
   private:
     bool mUseCachedFeatures = false;
-    QList<QgsIndexedFeature> mCachedFeatures;
-    QList<QgsIndexedFeature>::ConstIterator mFeatureIterator;
+    std::unique_ptr< QgsFeatureMergeSorter > mOrderBySorter;
 
     //! returns whether the iterator supports simplify geometries on provider side
     virtual bool providerCanSimplify( QgsSimplifyMethod::MethodType methodType ) const;
@@ -216,7 +248,8 @@ class CORE_EXPORT QgsAbstractFeatureIterator
 
     /**
      * Setup the orderby. Internally calls prepareOrderBy and if FALSE is returned will
-     * cache all features and order them with local expression evaluation.
+     * fetch all features and order them with local expression evaluation, spilling sorted
+     * runs to temporary files when they do not fit in memory.
      *
      * \since QGIS 2.14
      */
@@ -298,6 +331,16 @@ class CORE_EXPORT QgsFeatureIterator
     QgsFeatureIterator &operator=( const QgsFeatureIterator &other );
 
     bool nextFeature( QgsFeature &f );
+
+    /**
+     * Fetches the next \a maxFeatures features (at most) into a columnar \a batch.
+     * \returns the number of features stored in the batch, 0 when there are no more features
+     * \see QgsAbstractFeatureIterator::nextBatch()
+     * \note not available in Python bindings
+     * \since QGIS 3.16
+     */
+    int nextBatch( QgsFeatureBatch &batch, int maxFeatures ) SIP_SKIP;
+
     bool rewind();
     bool close();
 
@@ -375,6 +418,11 @@ inline bool QgsFeatureIterator::nextFeature( QgsFeature &f )
   return mIter ? mIter->nextFeature( f ) : false;
 }
 
+inline int QgsFeatureIterator::nextBatch( QgsFeatureBatch &batch, int maxFeatures )
+{
+  return mIter ? mIter->nextBatch( batch, maxFeatures ) : 0;
+}
+
 inline bool QgsFeatureIterator::rewind()
 {
   if ( mIter )
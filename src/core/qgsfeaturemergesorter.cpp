@@ -0,0 +1,501 @@
+/***************************************************************************
+                         qgsfeaturemergesorter.cpp
+                         -------------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsfeaturemergesorter_p.h"
+#include "qgsabstractgeometry.h"
+#include "qgslogger.h"
+
+#include <QDir>
+#include <QLocale>
+#include <QThread>
+#include <QtConcurrentMap>
+#include <QtConcurrentRun>
+
+#include <algorithm>
+#include <limits>
+
+///@cond PRIVATE
+
+// entries sorted at once by a single thread, larger runs are sorted by blocks merged afterwards
+static const std::size_t PARALLEL_SORT_BLOCK_SIZE = 16384;
+
+QgsFeatureMergeSorter::QgsFeatureMergeSorter( const QList<QgsFeatureRequest::OrderByClause> &orderBys, qint64 memoryBudget )
+  : mOrderBys( orderBys )
+    // QString::localeAwareCompare() is case insensitive for common locales,
+    // but case sensitive for the C locale. So use an explicit case
+    // insensitive comparison in that later case, as QgsExpressionSorter does.
+  , mUseCaseInsensitiveComparison( QLocale().name() == QLocale::c().name() )
+{
+  // the features of the pending spilled runs and of the run being collected share the budget
+  mMaxPendingSpills = std::max( 1, QThread::idealThreadCount() - 1 );
+  mRunBudget = ( memoryBudget > 0 ? memoryBudget : defaultMemoryBudget() ) / ( mMaxPendingSpills + 1 );
+}
+
+QgsFeatureMergeSorter::~QgsFeatureMergeSorter()
+{
+  waitForSpills( 0 );
+}
+
+qint64 QgsFeatureMergeSorter::defaultMemoryBudget()
+{
+  return 256 * 1024 * 1024;
+}
+
+void QgsFeatureMergeSorter::addFeature( const QgsFeature &feature, const QVector<QVariant> &values )
+{
+  if ( mEntries.empty() && mSpilledRunCount == 0 )
+    mFields = feature.fields();
+
+  Entry entry;
+  entry.feature = feature;
+  entry.keys.reserve( values.size() );
+  for ( const QVariant &value : values )
+    entry.keys << sortKey( value );
+
+  mEntriesSize += entrySize( entry );
+  mEntries.emplace_back( std::move( entry ) );
+
+  if ( mEntriesSize > mRunBudget )
+    spillRun();
+}
+
+void QgsFeatureMergeSorter::finish()
+{
+  startMerge();
+}
+
+bool QgsFeatureMergeSorter::nextFeature( QgsFeature &feature )
+{
+  if ( !mMerging )
+    startMerge();
+
+  if ( mHeap.empty() )
+    return false;
+
+  auto greater = [this]( int run1, int run2 )
+  {
+    return lessThan( mRuns[ run2 ]->current, mRuns[ run1 ]->current )
+           || ( !lessThan( mRuns[ run1 ]->current, mRuns[ run2 ]->current ) && run2 < run1 );
+  };
+
+  std::pop_heap( mHeap.begin(), mHeap.end(), greater );
+  Run &run = *mRuns[ mHeap.back() ];
+  feature = run.current.feature;
+  if ( advance( run ) )
+    std::push_heap( mHeap.begin(), mHeap.end(), greater );
+  else
+    mHeap.pop_back();
+  return true;
+}
+
+QgsFeatureMergeSorter::SortKey QgsFeatureMergeSorter::sortKey( const QVariant &value )
+{
+  SortKey key;
+  if ( value.isNull() )
+    return key;
+
+  switch ( value.type() )
+  {
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+      key.kind = SortKey::Integer;
+      key.integer = value.toLongLong();
+      break;
+
+    case QVariant::Double:
+      key.kind = SortKey::Double;
+      key.number = value.toDouble();
+      break;
+
+    case QVariant::Date:
+      key.kind = SortKey::Date;
+      key.integer = value.toDate().toJulianDay();
+      break;
+
+    case QVariant::Time:
+      key.kind = SortKey::Time;
+      key.integer = value.toTime().msecsSinceStartOfDay();
+      break;
+
+    case QVariant::DateTime:
+      key.kind = SortKey::DateTime;
+      key.integer = value.toDateTime().toMSecsSinceEpoch();
+      break;
+
+    case QVariant::Bool:
+      key.kind = SortKey::Bool;
+      key.integer = value.toBool() ? 1 : 0;
+      break;
+
+    default:
+      key.kind = SortKey::String;
+      key.string = value.toString();
+      break;
+  }
+  return key;
+}
+
+QgsFeatureMergeSorter::SortKey QgsFeatureMergeSorter::convertedKey( const SortKey &key, SortKey::Kind kind )
+{
+  // values of different types are compared as the type of the first one, like QgsExpressionSorter
+  QVariant value;
+  switch ( key.kind )
+  {
+    case SortKey::Null:
+      break;
+    case SortKey::Integer:
+      value = key.integer;
+      break;
+    case SortKey::Double:
+      value = key.number;
+      break;
+    case SortKey::Date:
+      value = QDate::fromJulianDay( key.integer );
+      break;
+    case SortKey::Time:
+      value = QTime::fromMSecsSinceStartOfDay( static_cast< int >( key.integer ) );
+      break;
+    case SortKey::DateTime:
+      value = QDateTime::fromMSecsSinceEpoch( key.integer );
+      break;
+    case SortKey::Bool:
+      value = key.integer != 0;
+      break;
+    case SortKey::String:
+      value = key.string;
+      break;
+  }
+
+  SortKey converted;
+  converted.kind = kind;
+  switch ( kind )
+  {
+    case SortKey::Null:
+      break;
+    case SortKey::Integer:
+      converted.integer = value.toLongLong();
+      break;
+    case SortKey::Double:
+      converted.number = value.toDouble();
+      break;
+    case SortKey::Date:
+      converted.integer = value.toDate().toJulianDay();
+      break;
+    case SortKey::Time:
+      converted.integer = value.toTime().msecsSinceStartOfDay();
+      break;
+    case SortKey::DateTime:
+      converted.integer = value.toDateTime().toMSecsSinceEpoch();
+      break;
+    case SortKey::Bool:
+      converted.integer = value.toBool() ? 1 : 0;
+      break;
+    case SortKey::String:
+      converted.string = value.toString();
+      break;
+  }
+  return converted;
+}
+
+qint64 QgsFeatureMergeSorter::entrySize( const Entry &entry )
+{
+  // rough estimate of the memory used by an entry, dominated by the geometry and the strings
+  qint64 size = sizeof( Entry ) + 64;
+  if ( entry.feature.hasGeometry() )
+    size += entry.feature.geometry().constGet()->wkbSize();
+  const QgsAttributes attributes = entry.feature.attributes();
+  for ( const QVariant &attribute : attributes )
+  {
+    size += sizeof( QVariant );
+    if ( attribute.type() == QVariant::String )
+      size += attribute.toString().size() * 2;
+    else if ( attribute.type() == QVariant::ByteArray )
+      size += attribute.toByteArray().size();
+  }
+  for ( const SortKey &key : entry.keys )
+    size += sizeof( SortKey ) + key.string.size() * 2;
+  return size;
+}
+
+bool QgsFeatureMergeSorter::lessThan( const Entry &entry1, const Entry &entry2 ) const
+{
+  int i = 0;
+  for ( const QgsFeatureRequest::OrderByClause &orderBy : qgis::as_const( mOrderBys ) )
+  {
+    const SortKey &v1 = entry1.keys.at( i );
+    const SortKey &key2 = entry2.keys.at( i );
+    ++i;
+
+    // Both NULL: don't care
+    if ( v1.kind == SortKey::Null && key2.kind == SortKey::Null )
+      continue;
+
+    // Check for NULLs first
+    if ( ( v1.kind == SortKey::Null ) != ( key2.kind == SortKey::Null ) )
+    {
+      if ( orderBy.nullsFirst() )
+        return v1.kind == SortKey::Null;
+      else
+        return v1.kind != SortKey::Null;
+    }
+
+    SortKey converted;
+    if ( key2.kind != v1.kind )
+      converted = convertedKey( key2, v1.kind );
+    const SortKey &v2 = key2.kind == v1.kind ? key2 : converted;
+
+    switch ( v1.kind )
+    {
+      case SortKey::Null:
+        break;
+
+      case SortKey::Integer:
+      case SortKey::Date:
+      case SortKey::Time:
+      case SortKey::DateTime:
+      case SortKey::Bool:
+        if ( v1.integer == v2.integer )
+          continue;
+        if ( orderBy.ascending() )
+          return v1.integer < v2.integer;
+        else
+          return v1.integer > v2.integer;
+
+      case SortKey::Double:
+        if ( qgsDoubleNear( v1.number, v2.number ) )
+          continue;
+        if ( orderBy.ascending() )
+          return v1.number < v2.number;
+        else
+          return v1.number > v2.number;
+
+      case SortKey::String:
+      {
+        const int localeCompare = v1.string.localeAwareCompare( v2.string );
+        if ( localeCompare == 0 )
+          continue;
+        const int compare = mUseCaseInsensitiveComparison ? v1.string.compare( v2.string, Qt::CaseInsensitive ) : localeCompare;
+        if ( orderBy.ascending() )
+          return compare < 0;
+        else
+          return compare > 0;
+      }
+    }
+  }
+
+  // Equal
+  return false;
+}
+
+void QgsFeatureMergeSorter::sortEntries( std::vector<Entry> &entries ) const
+{
+  auto less = [this]( const Entry & entry1, const Entry & entry2 ) { return lessThan( entry1, entry2 ); };
+
+  const std::size_t blockCount = std::min( static_cast< std::size_t >( std::max( 1, QThread::idealThreadCount() ) ), entries.size() / PARALLEL_SORT_BLOCK_SIZE );
+  if ( blockCount < 2 )
+  {
+    std::sort( entries.begin(), entries.end(), less );
+    return;
+  }
+
+  // sort blocks in parallel, then merge neighbor blocks in parallel until a single block remains
+  QVector< std::size_t > bounds;
+  for ( std::size_t i = 0; i <= blockCount; ++i )
+    bounds << entries.size() * i / blockCount;
+
+  QVector< int > blocks;
+  for ( int i = 0; i < bounds.size() - 1; ++i )
+    blocks << i;
+  QtConcurrent::blockingMap( blocks, [&]( int block )
+  {
+    std::sort( entries.begin() + bounds.at( block ), entries.begin() + bounds.at( block + 1 ), less );
+  } );
+
+  while ( bounds.size() > 2 )
+  {
+    QVector< int > pairs;
+    for ( int i = 0; i + 2 < bounds.size(); i += 2 )
+      pairs << i;
+    QtConcurrent::blockingMap( pairs, [&]( int first )
+    {
+      std::inplace_merge( entries.begin() + bounds.at( first ), entries.begin() + bounds.at( first + 1 ), entries.begin() + bounds.at( first + 2 ), less );
+    } );
+
+    QVector< std::size_t > merged;
+    for ( int i = 0; i < bounds.size(); i += 2 )
+      merged << bounds.at( i );
+    if ( merged.last() != bounds.last() )
+      merged << bounds.last();
+    bounds = merged;
+  }
+}
+
+void QgsFeatureMergeSorter::spillRun()
+{
+  std::unique_ptr< QTemporaryFile > file = qgis::make_unique< QTemporaryFile >( QDir::tempPath() + QStringLiteral( "/qgis_orderby_XXXXXX.run" ) );
+  if ( !file->open() )
+  {
+    // keep the features in memory, the sort still succeeds
+    QgsDebugMsg( QStringLiteral( "Could not create a temporary file to sort features: %1" ).arg( file->errorString() ) );
+    mRunBudget = std::numeric_limits< qint64 >::max();
+    return;
+  }
+
+  waitForSpills( mMaxPendingSpills - 1 );
+
+  std::shared_ptr< std::vector< Entry > > entries = std::make_shared< std::vector< Entry > >();
+  entries->swap( mEntries );
+  mEntriesSize = 0;
+
+  QTemporaryFile *runFile = file.get();
+  mSpilledCounts.push_back( static_cast< qint64 >( entries->size() ) );
+  mSpilledFiles.emplace_back( std::move( file ) );
+  mSpilledRunCount++;
+
+  mPendingSpills << QtConcurrent::run( [this, entries, runFile]
+  {
+    std::sort( entries->begin(), entries->end(), [this]( const Entry & entry1, const Entry & entry2 ) { return lessThan( entry1, entry2 ); } );
+
+    QDataStream out( runFile );
+    for ( const Entry &entry : qgis::as_const( *entries ) )
+    {
+      out << entry.feature;
+      for ( const SortKey &key : entry.keys )
+      {
+        out << static_cast< qint8 >( key.kind );
+        switch ( key.kind )
+        {
+          case SortKey::Null:
+            break;
+          case SortKey::Double:
+            out << key.number;
+            break;
+          case SortKey::String:
+            out << key.string;
+            break;
+          default:
+            out << key.integer;
+            break;
+        }
+      }
+    }
+    runFile->flush();
+    entries->clear();
+  } );
+}
+
+void QgsFeatureMergeSorter::waitForSpills( int pending )
+{
+  while ( mPendingSpills.size() > pending )
+    mPendingSpills.takeFirst().waitForFinished();
+}
+
+void QgsFeatureMergeSorter::startMerge()
+{
+  if ( mMerging )
+    return;
+  mMerging = true;
+
+  waitForSpills( 0 );
+
+  for ( std::size_t i = 0; i < mSpilledFiles.size(); ++i )
+  {
+    std::unique_ptr< Run > run = qgis::make_unique< Run >();
+    run->file = std::move( mSpilledFiles[ i ] );
+    run->file->seek( 0 );
+    run->stream = qgis::make_unique< QDataStream >( run->file.get() );
+    run->remaining = mSpilledCounts[ i ];
+    mRuns.emplace_back( std::move( run ) );
+  }
+  mSpilledFiles.clear();
+
+  if ( !mEntries.empty() )
+  {
+    sortEntries( mEntries );
+    std::unique_ptr< Run > run = qgis::make_unique< Run >();
+    run->entries.swap( mEntries );
+    run->end = run->entries.size();
+    mRuns.emplace_back( std::move( run ) );
+  }
+
+  auto greater = [this]( int run1, int run2 )
+  {
+    return lessThan( mRuns[ run2 ]->current, mRuns[ run1 ]->current )
+           || ( !lessThan( mRuns[ run1 ]->current, mRuns[ run2 ]->current ) && run2 < run1 );
+  };
+  for ( std::size_t i = 0; i < mRuns.size(); ++i )
+  {
+    if ( advance( *mRuns[ i ] ) )
+    {
+      mHeap.push_back( static_cast< int >( i ) );
+      std::push_heap( mHeap.begin(), mHeap.end(), greater );
+    }
+  }
+}
+
+bool QgsFeatureMergeSorter::advance( Run &run )
+{
+  if ( !run.file )
+  {
+    if ( run.position >= run.end )
+    {
+      std::vector< Entry >().swap( run.entries );
+      return false;
+    }
+    run.current = std::move( run.entries[ run.position++ ] );
+    return true;
+  }
+
+  if ( run.remaining <= 0 || run.stream->status() != QDataStream::Ok )
+  {
+    run.stream.reset();
+    run.file.reset();
+    return false;
+  }
+
+  run.remaining--;
+  QDataStream &in = *run.stream;
+  in >> run.current.feature;
+  run.current.feature.setFields( mFields, false );
+  run.current.keys.resize( mOrderBys.size() );
+  for ( SortKey &key : run.current.keys )
+  {
+    qint8 kind = 0;
+    in >> kind;
+    key = SortKey();
+    key.kind = static_cast< SortKey::Kind >( kind );
+    switch ( key.kind )
+    {
+      case SortKey::Null:
+        break;
+      case SortKey::Double:
+        in >> key.number;
+        break;
+      case SortKey::String:
+        in >> key.string;
+        break;
+      default:
+        in >> key.integer;
+        break;
+    }
+  }
+  return true;
+}
+
+///@endcond
@@ -0,0 +1,168 @@
+/***************************************************************************
+                         qgsfeaturemergesorter_p.h
+                         -------------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSFEATUREMERGESORTER_PRIVATE_H
+#define QGSFEATUREMERGESORTER_PRIVATE_H
+
+#define SIP_NO_FILE
+
+/// @cond PRIVATE
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QGIS API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+
+#include "qgis_core.h"
+#include "qgsfeature.h"
+#include "qgsfeaturerequest.h"
+
+#include <QFuture>
+#include <QTemporaryFile>
+#include <QDataStream>
+
+#include <memory>
+#include <vector>
+
+/**
+ * \ingroup core
+ * Sorts features on the client side for the order by clauses of a feature request which
+ * the provider cannot handle.
+ *
+ * The order by values are converted once to typed sort keys when a feature is added. Features
+ * are collected in runs bounded by the memory budget, each full run is sorted in a background
+ * thread and spilled to a temporary file, and the sorted runs are merged while the features are
+ * fetched.
+ */
+class CORE_EXPORT QgsFeatureMergeSorter
+{
+  public:
+
+    /**
+     * Constructor for QgsFeatureMergeSorter, ordering by the already prepared \a orderBys.
+     * A positive \a memoryBudget in bytes overrides the default budget.
+     */
+    explicit QgsFeatureMergeSorter( const QList<QgsFeatureRequest::OrderByClause> &orderBys, qint64 memoryBudget = 0 );
+    ~QgsFeatureMergeSorter();
+
+    //! QgsFeatureMergeSorter cannot be copied
+    QgsFeatureMergeSorter( const QgsFeatureMergeSorter &other ) = delete;
+    //! QgsFeatureMergeSorter cannot be copied
+    QgsFeatureMergeSorter &operator=( const QgsFeatureMergeSorter &other ) = delete;
+
+    //! Adds a \a feature, with the \a values of the order by expressions
+    void addFeature( const QgsFeature &feature, const QVector<QVariant> &values );
+
+    //! Sorts the remaining features, to be called once all features are added and before nextFeature()
+    void finish();
+
+    //! Fetches the next \a feature in order, returns FALSE once all features were fetched
+    bool nextFeature( QgsFeature &feature );
+
+    //! Returns the number of runs spilled to temporary files
+    int spilledRunCount() const { return mSpilledRunCount; }
+
+    //! Returns the default memory budget in bytes, used for the features waiting to be sorted
+    static qint64 defaultMemoryBudget();
+
+    //! Typed value of an order by clause, compared without converting variants
+    struct SortKey
+    {
+      enum Kind
+      {
+        Null,
+        Integer,
+        Double,
+        Date,
+        Time,
+        DateTime,
+        Bool,
+        String,
+      };
+
+      Kind kind = Null;
+      qint64 integer = 0;
+      double number = 0;
+      QString string;
+    };
+
+    //! Feature with its sort keys
+    struct Entry
+    {
+      QgsFeature feature;
+      QVector<SortKey> keys;
+    };
+
+  private:
+
+    //! Sorted run, either held in memory or spilled to a temporary file
+    struct Run
+    {
+      std::vector<Entry> entries;
+      std::size_t position = 0;
+      std::size_t end = 0;
+      std::unique_ptr< QTemporaryFile > file;
+      std::unique_ptr< QDataStream > stream;
+      qint64 remaining = 0;
+      Entry current;
+    };
+
+    static SortKey sortKey( const QVariant &value );
+    static SortKey convertedKey( const SortKey &key, SortKey::Kind kind );
+    static qint64 entrySize( const Entry &entry );
+
+    //! Returns TRUE if \a entry1 is sorted before \a entry2
+    bool lessThan( const Entry &entry1, const Entry &entry2 ) const;
+
+    //! Sorts \a entries, in parallel for large runs
+    void sortEntries( std::vector<Entry> &entries ) const;
+
+    //! Sorts the collected entries in a background thread and spills them to a temporary file
+    void spillRun();
+
+    //! Waits for the spilled runs, keeping at most \a pending runs in progress
+    void waitForSpills( int pending );
+
+    void startMerge();
+    bool advance( Run &run );
+
+    QList<QgsFeatureRequest::OrderByClause> mOrderBys;
+    bool mUseCaseInsensitiveComparison = false;
+    qint64 mRunBudget = 0;
+    int mMaxPendingSpills = 1;
+
+    QgsFields mFields;
+    std::vector<Entry> mEntries;
+    qint64 mEntriesSize = 0;
+
+    std::vector< std::unique_ptr< QTemporaryFile > > mSpilledFiles;
+    std::vector< qint64 > mSpilledCounts;
+    QList< QFuture< void > > mPendingSpills;
+    int mSpilledRunCount = 0;
+
+    std::vector< std::unique_ptr< Run > > mRuns;
+    std::vector< int > mHeap;
+    bool mMerging = false;
+};
+
+/// @endcond
+
+#endif // QGSFEATUREMERGESORTER_PRIVATE_H
@@ -21,6 +21,19 @@
 #include "qgsapplication.h"
 #include "qgssettings.h"
 
+// providers compiling the order by clauses of requests to their SQL query, which can then return the first features in order without a full scan
+static bool compilesOrderBy( QgsVectorLayer *layer )
+{
+  static const QStringList sProviders
+  {
+    QStringLiteral( "postgres" ),
+    QStringLiteral( "spatialite" ),
+    QStringLiteral( "mssql" ),
+    QStringLiteral( "DB2" )
+  };
+  return sProviders.contains( layer->providerType() )
+         && QgsSettings().value( QStringLiteral( "qgis/compileExpressions" ), true ).toBool();
+}
 
 QgsFeaturePickerModelBase::QgsFeaturePickerModelBase( QObject *parent )
   : QAbstractItemModel( parent )
@@ -411,8 +424,15 @@ void QgsFeaturePickerModelBase::scheduledReload()
   if ( !mFetchGeometry )
     request.setFlags( QgsFeatureRequest::NoGeometry );
   if ( mFetchLimit > 0 )
+  {
     request.setLimit( mFetchLimit );
 
+    // with a limit, the provider returns the first features in the order of the display field
+    // instead of arbitrary ones, as long as it sorts them in its query
+    if ( !mShouldReloadCurrentFeature && mDisplayExpression.isField() && compilesOrderBy( mSourceLayer ) )
+      request.addOrderBy( mDisplayExpression.expression() );
+  }
+
   mGatherer = createValuesGatherer( request );
   mGatherer->setData( mShouldReloadCurrentFeature );
   connect( mGatherer, &QgsFeatureExpressionValuesGatherer::finished, this, &QgsFeaturePickerModelBase::updateCompleter );
@@ -18,6 +18,14 @@ email                : jef at norbit dot de
 #include "qgsgeometry.h"
 #include "qgslogger.h"
 #include "qgsgeos.h"
+#include "qgsfeature.h"
+#include "qgsfeatureiterator.h"
+#include "qgsfeedback.h"
+
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
+#include <vector>
 
 QgsGeometryValidator::QgsGeometryValidator( const QgsGeometry &geometry, QVector<QgsGeometry::Error> *errors, QgsGeometry::ValidationMethod method )
   : mGeometry( geometry )
@@ -339,10 +347,111 @@ void QgsGeometryValidator::addError( const QgsGeometry::Error &e )
 
 void QgsGeometryValidator::validateGeometry( const QgsGeometry &geometry, QVector<QgsGeometry::Error> &errors, QgsGeometry::ValidationMethod method )
 {
-  QgsGeometryValidator *gv = new QgsGeometryValidator( geometry, &errors, method );
-  connect( gv, &QgsGeometryValidator::errorFound, gv, &QgsGeometryValidator::addError );
-  gv->run();
-  gv->wait();
+  QgsGeometryValidator gv( geometry, &errors, method );
+  connect( &gv, &QgsGeometryValidator::errorFound, &gv, &QgsGeometryValidator::addError );
+  gv.run();
+  gv.wait();
+}
+
+///@cond PRIVATE
+
+//! Number of features processed by each thread in a batch
+static const int FEATURES_PER_THREAD = 256;
+
+struct QgsGeometryValidatorItem
+{
+  QgsFeature feature;
+  QVector<QgsGeometry::Error> errors;
+  bool changed;
+};
+
+/**
+ * Reads the features from \a fi in batches, calls \a process on the features of each batch in parallel, then
+ * \a deliver on every feature of the batch from the calling thread, in the order of the features.
+ */
+static void processInParallel( QgsFeatureIterator &fi, const std::function< void( QgsGeometryValidatorItem & ) > &process,
+                               const std::function< void( const QgsGeometryValidatorItem & ) > &deliver, QgsFeedback *feedback )
+{
+  const int threadCount = std::max( 1, QThreadPool::globalInstance()->maxThreadCount() );
+  const std::size_t batchSize = static_cast< std::size_t >( threadCount ) * FEATURES_PER_THREAD * 4;
+
+  std::vector< QgsGeometryValidatorItem > items;
+  std::vector< std::pair< std::size_t, std::size_t > > chunks;
+  QgsFeature feature;
+  bool finished = false;
+  while ( !finished )
+  {
+    items.clear();
+    while ( items.size() < batchSize )
+    {
+      if ( !fi.nextFeature( feature ) )
+      {
+        finished = true;
+        break;
+      }
+      items.push_back( QgsGeometryValidatorItem { feature, QVector<QgsGeometry::Error>(), false } );
+    }
+    if ( feedback && feedback->isCanceled() )
+      return;
+
+    chunks.clear();
+    for ( std::size_t begin = 0; begin < items.size(); begin += FEATURES_PER_THREAD )
+      chunks.emplace_back( begin, std::min( begin + FEATURES_PER_THREAD, items.size() ) );
+    QtConcurrent::blockingMap( chunks, [&items, &process, feedback]( const std::pair< std::size_t, std::size_t > &chunk )
+    {
+      for ( std::size_t i = chunk.first; i < chunk.second; ++i )
+      {
+        if ( feedback && feedback->isCanceled() )
+          return;
+        if ( items[ i ].feature.hasGeometry() )
+          process( items[ i ] );
+      }
+    } );
+    if ( feedback && feedback->isCanceled() )
+      return;
+
+    for ( const QgsGeometryValidatorItem &item : items )
+      deliver( item );
+  }
+}
+
+///@endcond
+
+long QgsGeometryValidator::validateGeometries( QgsFeatureIterator &fi, const std::function<void ( const QgsFeature &, const QVector<QgsGeometry::Error> & )> &callback,
+    QgsGeometry::ValidationMethod method, QgsGeometry::ValidityFlags flags, QgsFeedback *feedback )
+{
+  long invalidCount = 0;
+  processInParallel( fi, [method, flags]( QgsGeometryValidatorItem & item )
+  {
+    // the GEOS validation uses the GEOS context of the thread
+    item.feature.geometry().validateGeometry( item.errors, method, flags );
+  }, [&callback, &invalidCount]( const QgsGeometryValidatorItem & item )
+  {
+    if ( item.errors.isEmpty() )
+      return;
+    invalidCount++;
+    callback( item.feature, item.errors );
+  }, feedback );
+  return invalidCount;
+}
+
+long QgsGeometryValidator::makeValidGeometries( QgsFeatureIterator &fi, const std::function<void ( const QgsFeature & )> &callback, QgsFeedback *feedback )
+{
+  long repairedCount = 0;
+  processInParallel( fi, []( QgsGeometryValidatorItem & item )
+  {
+    const QgsGeometry geometry = item.feature.geometry();
+    if ( geometry.isGeosValid() )
+      return;
+    item.feature.setGeometry( geometry.makeValid() );
+    item.changed = true;
+  }, [&callback, &repairedCount]( const QgsGeometryValidatorItem & item )
+  {
+    if ( item.changed )
+      repairedCount++;
+    callback( item.feature );
+  }, feedback );
+  return repairedCount;
 }
 
 //
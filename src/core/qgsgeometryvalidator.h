@@ -21,6 +21,12 @@ email                : jef at norbit dot de
 #include <QThread>
 #include "qgsgeometry.h"
 
+#include <functional>
+
+class QgsFeature;
+class QgsFeatureIterator;
+class QgsFeedback;
+
 /**
  * \ingroup core
  * \class QgsGeometryValidator
@@ -46,6 +52,39 @@ class CORE_EXPORT QgsGeometryValidator : public QThread
      */
     static void validateGeometry( const QgsGeometry &geometry, QVector<QgsGeometry::Error> &errors SIP_OUT, QgsGeometry::ValidationMethod method = QgsGeometry::ValidatorQgisInternal );
 
+    /**
+     * Validates the geometries of the features from the iterator \a fi, in parallel on the global thread pool.
+     *
+     * The features are read in batches from the calling thread, and validated by several threads, each one
+     * with its own GEOS context. The \a callback is then called from the calling thread for each invalid feature
+     * with its errors, in the order of the features, as soon as its batch is validated. Validation stops once
+     * \a feedback is canceled.
+     *
+     * Returns the number of invalid features.
+     *
+     * \note Not available in Python bindings
+     * \since QGIS 3.16
+     */
+    static long validateGeometries( QgsFeatureIterator &fi, const std::function< void( const QgsFeature &feature, const QVector<QgsGeometry::Error> &errors ) > &callback,
+                                    QgsGeometry::ValidationMethod method = QgsGeometry::ValidatorQgisInternal,
+                                    QgsGeometry::ValidityFlags flags = QgsGeometry::ValidityFlags(), QgsFeedback *feedback = nullptr ) SIP_SKIP;
+
+    /**
+     * Repairs the geometries of the features from the iterator \a fi, in parallel on the global thread pool.
+     *
+     * The features are read in batches from the calling thread, and repaired by several threads, each one
+     * with its own GEOS context. Only the features whose geometry is not valid according to GEOS are repaired,
+     * with QgsGeometry::makeValid(). The \a callback is then called from the calling thread for every feature,
+     * with its geometry repaired if needed, in the order of the features, as soon as its batch is processed.
+     * Repairing stops once \a feedback is canceled.
+     *
+     * Returns the number of repaired features.
+     *
+     * \note Not available in Python bindings
+     * \since QGIS 3.16
+     */
+    static long makeValidGeometries( QgsFeatureIterator &fi, const std::function< void( const QgsFeature &feature ) > &callback, QgsFeedback *feedback = nullptr ) SIP_SKIP;
+
   signals:
 
     /**
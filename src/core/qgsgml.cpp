@@ -932,7 +932,7 @@ void QgsGmlStreamingParser::endElement( const XML_Char *el )
   }
   else if ( parseMode == LowerCorner && isGMLNS && LOCALNAME_EQUALS( "lowerCorner" ) )
   {
-    QList<QgsPointXY> points;
+    QgsPolylineXY points;
     pointsFromPosListString( points, mStringCash, 2 );
     if ( points.size() == 1 )
     {
@@ -943,7 +943,7 @@ void QgsGmlStreamingParser::endElement( const XML_Char *el )
   }
   else if ( parseMode == UpperCorner && isGMLNS && LOCALNAME_EQUALS( "upperCorner" ) )
   {
-    QList<QgsPointXY> points;
+    QgsPolylineXY points;
     pointsFromPosListString( points, mStringCash, 2 );
     if ( points.size() == 1 )
     {
@@ -988,7 +988,7 @@ void QgsGmlStreamingParser::endElement( const XML_Char *el )
   }
   else if ( isGMLNS && LOCALNAME_EQUALS( "Point" ) )
   {
-    QList<QgsPointXY> pointList;
+    QgsPolylineXY pointList;
     if ( pointsFromString( pointList, mStringCash ) != 0 )
     {
       //error
@@ -1032,7 +1032,7 @@ void QgsGmlStreamingParser::endElement( const XML_Char *el )
   {
     //add WKB point to the feature
 
-    QList<QgsPointXY> pointList;
+    QgsPolylineXY pointList;
     if ( pointsFromString( pointList, mStringCash ) != 0 )
     {
       //error
@@ -1070,7 +1070,7 @@ void QgsGmlStreamingParser::endElement( const XML_Char *el )
   else if ( ( parseMode == Geometry || parseMode == MultiPolygon ) &&
             isGMLNS && LOCALNAME_EQUALS( "LinearRing" ) )
   {
-    QList<QgsPointXY> pointList;
+    QgsPolylineXY pointList;
     if ( pointsFromString( pointList, mStringCash ) != 0 )
     {
       //error
@@ -1278,7 +1278,7 @@ QString QgsGmlStreamingParser::readAttribute( const QString &attributeName, cons
 
 bool QgsGmlStreamingParser::createBBoxFromCoordinateString( QgsRectangle &r, const QString &coordString ) const
 {
-  QList<QgsPointXY> points;
+  QgsPolylineXY points;
   if ( pointsFromCoordinateString( points, coordString ) != 0 )
   {
     return false;
@@ -1294,28 +1294,28 @@ bool QgsGmlStreamingParser::createBBoxFromCoordinateString( QgsRectangle &r, con
   return true;
 }
 
-int QgsGmlStreamingParser::pointsFromCoordinateString( QList<QgsPointXY> &points, const QString &coordString ) const
+int QgsGmlStreamingParser::pointsFromCoordinateString( QgsPolylineXY &points, const QString &coordString ) const
 {
   //tuples are separated by space, x/y by ','
-  QStringList tuples = coordString.split( mTupleSeparator, QString::SkipEmptyParts );
-  QStringList tuples_coordinates;
+  // the string references avoid allocating a string per tuple and per coordinate
+  const QVector<QStringRef> tuples = coordString.splitRef( mTupleSeparator, QString::SkipEmptyParts );
+  points.reserve( points.size() + tuples.size() );
   double x, y;
   bool conversionSuccess;
 
-  QStringList::const_iterator tupleIterator;
-  for ( tupleIterator = tuples.constBegin(); tupleIterator != tuples.constEnd(); ++tupleIterator )
+  for ( const QStringRef &tuple : tuples )
   {
-    tuples_coordinates = tupleIterator->split( mCoordinateSeparator, QString::SkipEmptyParts );
-    if ( tuples_coordinates.size() < 2 )
+    const QVector<QStringRef> tupleCoordinates = tuple.split( mCoordinateSeparator, QString::SkipEmptyParts );
+    if ( tupleCoordinates.size() < 2 )
     {
       continue;
     }
-    x = tuples_coordinates.at( 0 ).toDouble( &conversionSuccess );
+    x = tupleCoordinates.at( 0 ).toDouble( &conversionSuccess );
     if ( !conversionSuccess )
     {
       continue;
     }
-    y = tuples_coordinates.at( 1 ).toDouble( &conversionSuccess );
+    y = tupleCoordinates.at( 1 ).toDouble( &conversionSuccess );
     if ( !conversionSuccess )
     {
       continue;
@@ -1325,10 +1325,10 @@ int QgsGmlStreamingParser::pointsFromCoordinateString( QList<QgsPointXY> &points
   return 0;
 }
 
-int QgsGmlStreamingParser::pointsFromPosListString( QList<QgsPointXY> &points, const QString &coordString, int dimension ) const
+int QgsGmlStreamingParser::pointsFromPosListString( QgsPolylineXY &points, const QString &coordString, int dimension ) const
 {
-  // coordinates separated by spaces
-  QStringList coordinates = coordString.split( ' ', QString::SkipEmptyParts );
+  // coordinates separated by spaces, read as string references to avoid allocating a string per coordinate
+  const QVector<QStringRef> coordinates = coordString.splitRef( ' ', QString::SkipEmptyParts );
 
   if ( coordinates.size() % dimension != 0 )
   {
@@ -1336,6 +1336,7 @@ int QgsGmlStreamingParser::pointsFromPosListString( QList<QgsPointXY> &points, c
   }
 
   int ncoor = coordinates.size() / dimension;
+  points.reserve( points.size() + ncoor );
   for ( int i = 0; i < ncoor; i++ )
   {
     bool conversionSuccess;
@@ -1354,7 +1355,7 @@ int QgsGmlStreamingParser::pointsFromPosListString( QList<QgsPointXY> &points, c
   return 0;
 }
 
-int QgsGmlStreamingParser::pointsFromString( QList<QgsPointXY> &points, const QString &coordString ) const
+int QgsGmlStreamingParser::pointsFromString( QgsPolylineXY &points, const QString &coordString ) const
 {
   if ( mCoorMode == QgsGmlStreamingParser::Coordinate )
   {
@@ -1378,7 +1379,7 @@ int QgsGmlStreamingParser::getPointWKB( QgsWkbPtr &wkbPtr, const QgsPointXY &poi
   return 0;
 }
 
-int QgsGmlStreamingParser::getLineWKB( QgsWkbPtr &wkbPtr, const QList<QgsPointXY> &lineCoordinates ) const
+int QgsGmlStreamingParser::getLineWKB( QgsWkbPtr &wkbPtr, const QgsPolylineXY &lineCoordinates ) const
 {
   int wkbSize = 1 + 2 * sizeof( int ) + lineCoordinates.size() * 2 * sizeof( double );
   wkbPtr = QgsWkbPtr( new unsigned char[wkbSize], wkbSize );
@@ -1387,7 +1388,7 @@ int QgsGmlStreamingParser::getLineWKB( QgsWkbPtr &wkbPtr, const QList<QgsPointXY
 
   fillPtr << mEndian << QgsWkbTypes::LineString << lineCoordinates.size();
 
-  QList<QgsPointXY>::const_iterator iter;
+  QgsPolylineXY::const_iterator iter;
   for ( iter = lineCoordinates.constBegin(); iter != lineCoordinates.constEnd(); ++iter )
   {
     fillPtr << iter->x() << iter->y();
@@ -1396,7 +1397,7 @@ int QgsGmlStreamingParser::getLineWKB( QgsWkbPtr &wkbPtr, const QList<QgsPointXY
   return 0;
 }
 
-int QgsGmlStreamingParser::getRingWKB( QgsWkbPtr &wkbPtr, const QList<QgsPointXY> &ringCoordinates ) const
+int QgsGmlStreamingParser::getRingWKB( QgsWkbPtr &wkbPtr, const QgsPolylineXY &ringCoordinates ) const
 {
   int wkbSize = sizeof( int ) + ringCoordinates.size() * 2 * sizeof( double );
   wkbPtr = QgsWkbPtr( new unsigned char[wkbSize], wkbSize );
@@ -1405,7 +1406,7 @@ int QgsGmlStreamingParser::getRingWKB( QgsWkbPtr &wkbPtr, const QList<QgsPointXY
 
   fillPtr << ringCoordinates.size();
 
-  QList<QgsPointXY>::const_iterator iter;
+  QgsPolylineXY::const_iterator iter;
   for ( iter = ringCoordinates.constBegin(); iter != ringCoordinates.constEnd(); ++iter )
   {
     fillPtr << iter->x() << iter->y();
@@ -216,7 +216,7 @@ class CORE_EXPORT QgsGmlStreamingParser
      * \param coordString the text containing the coordinates
      * \returns 0 in case of success
      */
-    int pointsFromCoordinateString( QList<QgsPointXY> &points, const QString &coordString ) const;
+    int pointsFromCoordinateString( QgsPolylineXY &points, const QString &coordString ) const;
 
     /**
      * Creates a set of points from a gml:posList or gml:pos coordinate string.
@@ -225,12 +225,12 @@ class CORE_EXPORT QgsGmlStreamingParser
      * \param dimension number of dimensions
      * \returns 0 in case of success
       */
-    int pointsFromPosListString( QList<QgsPointXY> &points, const QString &coordString, int dimension ) const;
+    int pointsFromPosListString( QgsPolylineXY &points, const QString &coordString, int dimension ) const;
 
-    int pointsFromString( QList<QgsPointXY> &points, const QString &coordString ) const;
+    int pointsFromString( QgsPolylineXY &points, const QString &coordString ) const;
     int getPointWKB( QgsWkbPtr &wkbPtr, const QgsPointXY & ) const;
-    int getLineWKB( QgsWkbPtr &wkbPtr, const QList<QgsPointXY> &lineCoordinates ) const;
-    int getRingWKB( QgsWkbPtr &wkbPtr, const QList<QgsPointXY> &ringCoordinates ) const;
+    int getLineWKB( QgsWkbPtr &wkbPtr, const QgsPolylineXY &lineCoordinates ) const;
+    int getRingWKB( QgsWkbPtr &wkbPtr, const QgsPolylineXY &ringCoordinates ) const;
 
     /**
      * Creates a multiline from the information in mCurrentWKBFragments and
@@ -0,0 +1,129 @@
+/***************************************************************************
+  qgshotpathinstrumentation.cpp
+  --------------------------------------
+  Date                 : October 2020
+  Copyright            : (C) 2020 by the QGIS project
+  Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgshotpathinstrumentation.h"
+
+/// @cond PRIVATE
+
+#ifdef QGIS_HOTPATH_INSTRUMENTATION
+
+#include "qgseventtracing.h"
+
+#include <atomic>
+
+static std::atomic< quint64 > sCounters[QgsHotPathInstrumentation::CounterCount];
+static std::atomic< quint64 > sLockWaits[QgsHotPathInstrumentation::LockCount][QgsHotPathInstrumentation::HISTOGRAM_BUCKET_COUNT];
+static std::atomic< qint64 > sLockWaitTime[QgsHotPathInstrumentation::LockCount];
+
+static QString counterName( QgsHotPathInstrumentation::Counter counter )
+{
+  switch ( counter )
+  {
+    case QgsHotPathInstrumentation::FeatureDetach:
+      return QStringLiteral( "Feature detaches" );
+    case QgsHotPathInstrumentation::VariantConversion:
+      return QStringLiteral( "Value conversions" );
+    case QgsHotPathInstrumentation::CounterCount:
+      break;
+  }
+  return QString();
+}
+
+static QString lockName( QgsHotPathInstrumentation::Lock lock )
+{
+  switch ( lock )
+  {
+    case QgsHotPathInstrumentation::OgrDatasetLock:
+      return QStringLiteral( "OGR dataset lock" );
+    case QgsHotPathInstrumentation::ContentCacheLock:
+      return QStringLiteral( "Content cache lock" );
+    case QgsHotPathInstrumentation::SrIdCacheLock:
+      return QStringLiteral( "SRID cache lock" );
+    case QgsHotPathInstrumentation::LockCount:
+      break;
+  }
+  return QString();
+}
+
+void QgsHotPathInstrumentation::count( Counter counter )
+{
+  sCounters[counter].fetch_add( 1, std::memory_order_relaxed );
+}
+
+void QgsHotPathInstrumentation::recordLockWait( Lock lock, qint64 nsecs )
+{
+  int bucket = 0;
+  for ( qint64 microseconds = nsecs / 1000; microseconds > 0 && bucket < HISTOGRAM_BUCKET_COUNT - 1; microseconds >>= 1 )
+    bucket++;
+  sLockWaits[lock][bucket].fetch_add( 1, std::memory_order_relaxed );
+  sLockWaitTime[lock].fetch_add( nsecs, std::memory_order_relaxed );
+}
+
+QgsHotPathInstrumentation::Snapshot QgsHotPathInstrumentation::snapshot()
+{
+  Snapshot snapshot;
+  for ( int counter = 0; counter < CounterCount; ++counter )
+    snapshot.counters[counter] = sCounters[counter].load( std::memory_order_relaxed );
+  for ( int lock = 0; lock < LockCount; ++lock )
+  {
+    for ( int bucket = 0; bucket < HISTOGRAM_BUCKET_COUNT; ++bucket )
+      snapshot.lockWaits[lock][bucket] = sLockWaits[lock][bucket].load( std::memory_order_relaxed );
+    snapshot.lockWaitTime[lock] = sLockWaitTime[lock].load( std::memory_order_relaxed );
+  }
+  return snapshot;
+}
+
+void QgsHotPathInstrumentation::reset()
+{
+  for ( int counter = 0; counter < CounterCount; ++counter )
+    sCounters[counter] = 0;
+  for ( int lock = 0; lock < LockCount; ++lock )
+  {
+    for ( int bucket = 0; bucket < HISTOGRAM_BUCKET_COUNT; ++bucket )
+      sLockWaits[lock][bucket] = 0;
+    sLockWaitTime[lock] = 0;
+  }
+}
+
+void QgsHotPathInstrumentation::addTraceEvents( const QString &name, const Snapshot &start )
+{
+  if ( !QgsEventTracing::isTracingEnabled() )
+    return;
+
+  const Snapshot end = snapshot();
+
+  QMap< QString, double > counters;
+  for ( int counter = 0; counter < CounterCount; ++counter )
+    counters.insert( counterName( static_cast< Counter >( counter ) ), end.counters[counter] - start.counters[counter] );
+  QgsEventTracing::addCounterEvent( QStringLiteral( "Hot paths" ), name, counters );
+
+  for ( int lock = 0; lock < LockCount; ++lock )
+  {
+    // waits by upper bound of the bucket, in microseconds
+    QMap< QString, double > histogram;
+    for ( int bucket = 0; bucket < HISTOGRAM_BUCKET_COUNT; ++bucket )
+    {
+      const quint64 waits = end.lockWaits[lock][bucket] - start.lockWaits[lock][bucket];
+      if ( waits > 0 )
+        histogram.insert( bucket < HISTOGRAM_BUCKET_COUNT - 1 ? QStringLiteral( "< %1 us" ).arg( 1 << bucket, 5, 10, QChar( '0' ) ) : QStringLiteral( "longer" ), waits );
+    }
+    histogram.insert( QStringLiteral( "total wait (ms)" ), ( end.lockWaitTime[lock] - start.lockWaitTime[lock] ) / 1000000.0 );
+    QgsEventTracing::addCounterEvent( QStringLiteral( "Hot paths" ), QStringLiteral( "%1: %2" ).arg( name, lockName( static_cast< Lock >( lock ) ) ), histogram );
+  }
+}
+
+#endif
+
+/// @endcond
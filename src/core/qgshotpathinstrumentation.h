@@ -0,0 +1,211 @@
+/***************************************************************************
+  qgshotpathinstrumentation.h
+  --------------------------------------
+  Date                 : October 2020
+  Copyright            : (C) 2020 by the QGIS project
+  Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSHOTPATHINSTRUMENTATION_H
+#define QGSHOTPATHINSTRUMENTATION_H
+
+#include "qgis_core.h"
+
+#define SIP_NO_FILE
+
+#include <QMutexLocker>
+#include <QString>
+
+#ifdef QGIS_HOTPATH_INSTRUMENTATION
+#include <QElapsedTimer>
+#endif
+
+/// @cond PRIVATE
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QGIS API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+
+/**
+ * Counting hooks of the hot paths, to measure the copies of the feature data, the
+ * conversions of values and the time spent waiting for some shared locks.
+ *
+ * The hooks only count when QGIS is built with the ENABLE_HOTPATH_INSTRUMENTATION
+ * CMake option, which defines QGIS_HOTPATH_INSTRUMENTATION. Otherwise they are empty
+ * inline methods, which the compiler removes.
+ *
+ * The counters are global. The renderer jobs and the server requests open a Scope,
+ * which adds the changes of the counters during the scope to the event trace as
+ * counter events, see QgsEventTracing. Scopes running at the same time in several
+ * threads overlap.
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.16
+ */
+class CORE_EXPORT QgsHotPathInstrumentation
+{
+  public:
+
+    //! Counted events
+    enum Counter
+    {
+      FeatureDetach, //!< Copy of the shared data of a feature before it is modified
+      VariantConversion, //!< Conversion of an expression value to another type
+      CounterCount
+    };
+
+    //! Instrumented locks
+    enum Lock
+    {
+      OgrDatasetLock, //!< Mutex of the datasets shared by the OGR feature iterators
+      ContentCacheLock, //!< Mutex of the SVG and image caches
+      SrIdCacheLock, //!< Lock of the cache of the CRS by PostGIS SRID
+      LockCount
+    };
+
+    //! Number of buckets of the histograms of the lock wait times, bucket i counting waits below 2^i microseconds
+    static const int HISTOGRAM_BUCKET_COUNT = 16;
+
+    //! Values of the counters at a time
+    struct Snapshot
+    {
+      quint64 counters[CounterCount];
+      quint64 lockWaits[LockCount][HISTOGRAM_BUCKET_COUNT];
+      qint64 lockWaitTime[LockCount];
+    };
+
+#ifdef QGIS_HOTPATH_INSTRUMENTATION
+
+    //! Returns TRUE if QGIS is built with the instrumentation
+    static bool isEnabled() { return true; }
+
+    //! Counts an occurrence of \a counter
+    static void count( Counter counter );
+
+    //! Records a wait of \a nsecs nanoseconds to acquire \a lock
+    static void recordLockWait( Lock lock, qint64 nsecs );
+
+    //! Returns the current values of the counters
+    static Snapshot snapshot();
+
+    //! Sets the counters to zero
+    static void reset();
+
+    /**
+     * Adds one counter event per counter and per lock to the event trace, with the changes
+     * since \a start. The events are named with \a name.
+     */
+    static void addTraceEvents( const QString &name, const Snapshot &start );
+
+    /**
+     * Measures the time spent to acquire a lock, between the constructor and acquired().
+     */
+    class LockWait
+    {
+      public:
+        explicit LockWait( Lock lock ) : mLock( lock ) { mTimer.start(); }
+        void acquired() { recordLockWait( mLock, mTimer.nsecsElapsed() ); }
+      private:
+        Lock mLock;
+        QElapsedTimer mTimer;
+    };
+
+    /**
+     * Adds the changes of the counters between the constructor and the destructor to the
+     * event trace, with addTraceEvents().
+     */
+    class Scope
+    {
+      public:
+        explicit Scope( const QString &name ) : mName( name ), mStart( snapshot() ) {}
+        ~Scope() { addTraceEvents( mName, mStart ); }
+        Scope( const Scope &other ) = delete;
+        Scope &operator=( const Scope &other ) = delete;
+      private:
+        QString mName;
+        Snapshot mStart;
+    };
+
+#else
+
+    static bool isEnabled() { return false; }
+    static void count( Counter ) {}
+    static void recordLockWait( Lock, qint64 ) {}
+
+    class LockWait
+    {
+      public:
+        explicit LockWait( Lock ) {}
+        void acquired() {}
+    };
+
+    class Scope
+    {
+      public:
+        explicit Scope( const QString & ) {}
+    };
+
+#endif
+
+    /**
+     * QMutexLocker which records the time spent to acquire the mutex as a wait of \a lock.
+     */
+    class MutexLocker
+    {
+      public:
+        MutexLocker( QMutex *mutex, Lock lock )
+          : mMutex( mutex )
+          , mLock( lock )
+        {
+          relock();
+        }
+
+        ~MutexLocker() { unlock(); }
+
+        MutexLocker( const MutexLocker &other ) = delete;
+        MutexLocker &operator=( const MutexLocker &other ) = delete;
+
+        //! Unlocks the mutex
+        void unlock()
+        {
+          if ( mMutex && mLocked )
+          {
+            mMutex->unlock();
+            mLocked = false;
+          }
+        }
+
+        //! Locks the mutex again after unlock()
+        void relock()
+        {
+          if ( mMutex && !mLocked )
+          {
+            LockWait wait( mLock );
+            mMutex->lock();
+            wait.acquired();
+            mLocked = true;
+          }
+        }
+
+      private:
+        QMutex *mMutex = nullptr;
+        Lock mLock;
+        bool mLocked = false;
+    };
+};
+
+/// @endcond
+
+#endif // QGSHOTPATHINSTRUMENTATION_H
@@ -18,11 +18,13 @@
 #include "qgsimagecache.h"
 
 #include "qgis.h"
+#include "qgshotpathinstrumentation.h"
 #include "qgsimageoperation.h"
 #include "qgslogger.h"
 #include "qgsnetworkaccessmanager.h"
 #include "qgsmessagelog.h"
 #include "qgsnetworkcontentfetchertask.h"
+#include "qgssettings.h"
 
 #include <QApplication>
 #include <QCoreApplication>
@@ -99,6 +101,11 @@ QgsImageCache::QgsImageCache( QObject *parent )
   }
 
   connect( this, &QgsAbstractContentCacheBase::remoteContentFetched, this, &QgsImageCache::remoteImageFetched );
+
+  // maximum size in bytes, the default size is kept if not set
+  const qlonglong maxCacheSize = QgsSettings().value( QStringLiteral( "qgis/maxImageCacheSize" ), 0 ).toLongLong();
+  if ( maxCacheSize > 0 )
+    mMaxCacheSize = static_cast< long >( maxCacheSize );
 }
 
 QImage QgsImageCache::pathAsImage( const QString &f, const QSize size, const bool keepAspectRatio, const double opacity, bool &fitsInCache, bool blocking, bool *isMissing )
@@ -110,7 +117,7 @@ QImage QgsImageCache::pathAsImage( const QString &f, const QSize size, const boo
   if ( file.isEmpty() )
     return QImage();
 
-  QMutexLocker locker( &mMutex );
+  QgsHotPathInstrumentation::MutexLocker locker( &mMutex, QgsHotPathInstrumentation::ContentCacheLock );
 
   fitsInCache = true;
 
@@ -125,14 +132,22 @@ QImage QgsImageCache::pathAsImage( const QString &f, const QSize size, const boo
   {
     long cachedDataSize = 0;
     bool isBroken = false;
+
+    // render the image without holding the lock, so that the cached entries can be read meanwhile
+    locker.unlock();
     result = renderImage( file, size, keepAspectRatio, opacity, isBroken, blocking );
+    locker.relock();
+
+    // the entry may have been removed from the cache while it was not locked
+    currentEntry = findExistingEntry( new QgsImageCacheEntry( file, size, keepAspectRatio, opacity ) );
+
     cachedDataSize += result.width() * result.height() * 32;
     if ( cachedDataSize > mMaxCacheSize / 2 )
     {
       fitsInCache = false;
       currentEntry->image = QImage();
     }
-    else
+    else if ( currentEntry->image.isNull() )
     {
       mTotalSize += ( result.width() * result.height() * 32 );
       currentEntry->image = result;
@@ -18,8 +18,64 @@
 #include "qgsrendercontext.h"
 #include "qgsmapclippingregion.h"
 #include "qgslogger.h"
+
+#include <QCache>
+#include <QCryptographicHash>
+#include <QMutex>
+
 #include <algorithm>
 
+///@cond PRIVATE
+
+/**
+ * Intersections of several clipping regions, shared by the layers of a render and by the successive
+ * renders with the same regions, since the same intersection is used by the feature requests, the
+ * feature clipping, the painter clipping and the labeling of every layer.
+ */
+class QgsClippingRegionIntersectionCache
+{
+  public:
+
+    QgsGeometry intersection( const QVector< QgsGeometry > &geometries )
+    {
+      if ( geometries.size() == 1 )
+        return geometries.at( 0 );
+
+      QCryptographicHash hash( QCryptographicHash::Sha1 );
+      for ( const QgsGeometry &geometry : geometries )
+        hash.addData( geometry.asWkb() );
+      const QByteArray key = hash.result();
+
+      {
+        QMutexLocker locker( &mMutex );
+        if ( const QgsGeometry *cached = mCache.object( key ) )
+          return *cached;
+      }
+
+      QgsGeometry result = geometries.at( 0 );
+      for ( int i = 1; i < geometries.size(); ++i )
+        result = result.intersection( geometries.at( i ) );
+
+      QMutexLocker locker( &mMutex );
+      mCache.insert( key, new QgsGeometry( result ) );
+      return result;
+    }
+
+  private:
+
+    QMutex mMutex;
+    QCache< QByteArray, QgsGeometry > mCache { 16 };
+};
+
+Q_GLOBAL_STATIC( QgsClippingRegionIntersectionCache, sClippingRegionIntersectionCache )
+
+static QgsGeometry intersectedRegions( const QVector< QgsGeometry > &geometries )
+{
+  return sClippingRegionIntersectionCache()->intersection( geometries );
+}
+
+///@endcond
+
 QList<QgsMapClippingRegion> QgsMapClippingUtils::collectClippingRegionsForLayer( const QgsRenderContext &context, const QgsMapLayer *layer )
 {
   QList< QgsMapClippingRegion > res;
@@ -37,7 +93,7 @@ QList<QgsMapClippingRegion> QgsMapClippingUtils::collectClippingRegionsForLayer(
 QgsGeometry QgsMapClippingUtils::calculateFeatureRequestGeometry( const QList< QgsMapClippingRegion > &regions, const QgsRenderContext &context, bool &shouldFilter )
 {
   QgsGeometry result;
-  bool first = true;
+  QVector< QgsGeometry > geometries;
   shouldFilter = false;
   for ( const QgsMapClippingRegion &region : regions )
   {
@@ -45,20 +101,14 @@ QgsGeometry QgsMapClippingUtils::calculateFeatureRequestGeometry( const QList< Q
       continue;
 
     shouldFilter = true;
-    if ( first )
-    {
-      result = region.geometry();
-      first = false;
-    }
-    else
-    {
-      result = result.intersection( region.geometry() );
-    }
+    geometries << region.geometry();
   }
 
   if ( !shouldFilter )
     return QgsGeometry();
 
+  result = intersectedRegions( geometries );
+
   // filter out polygon parts from result only
   result.convertGeometryCollectionToSubclass( QgsWkbTypes::PolygonGeometry );
 
@@ -80,7 +130,7 @@ QgsGeometry QgsMapClippingUtils::calculateFeatureRequestGeometry( const QList< Q
 QgsGeometry QgsMapClippingUtils::calculateFeatureIntersectionGeometry( const QList<QgsMapClippingRegion> &regions, const QgsRenderContext &context, bool &shouldClip )
 {
   QgsGeometry result;
-  bool first = true;
+  QVector< QgsGeometry > geometries;
   shouldClip = false;
   for ( const QgsMapClippingRegion &region : regions )
   {
@@ -91,20 +141,14 @@ QgsGeometry QgsMapClippingUtils::calculateFeatureIntersectionGeometry( const QLi
       continue;
 
     shouldClip = true;
-    if ( first )
-    {
-      result = region.geometry();
-      first = false;
-    }
-    else
-    {
-      result = result.intersection( region.geometry() );
-    }
+    geometries << region.geometry();
   }
 
   if ( !shouldClip )
     return QgsGeometry();
 
+  result = intersectedRegions( geometries );
+
   // filter out polygon parts from result only
   result.convertGeometryCollectionToSubclass( QgsWkbTypes::PolygonGeometry );
 
@@ -126,7 +170,7 @@ QgsGeometry QgsMapClippingUtils::calculateFeatureIntersectionGeometry( const QLi
 QPainterPath QgsMapClippingUtils::calculatePainterClipRegion( const QList<QgsMapClippingRegion> &regions, const QgsRenderContext &context, QgsMapLayerType layerType, bool &shouldClip )
 {
   QgsGeometry result;
-  bool first = true;
+  QVector< QgsGeometry > geometries;
   shouldClip = false;
   for ( const QgsMapClippingRegion &region : regions )
   {
@@ -156,20 +200,14 @@ QPainterPath QgsMapClippingUtils::calculatePainterClipRegion( const QList<QgsMap
     }
 
     shouldClip = true;
-    if ( first )
-    {
-      result = region.geometry();
-      first = false;
-    }
-    else
-    {
-      result = result.intersection( region.geometry() );
-    }
+    geometries << region.geometry();
   }
 
   if ( !shouldClip )
     return QPainterPath();
 
+  result = intersectedRegions( geometries );
+
   // transform to painter coordinates
   result.mapToPixel( context.mapToPixel() );
 
@@ -179,7 +217,7 @@ QPainterPath QgsMapClippingUtils::calculatePainterClipRegion( const QList<QgsMap
 QgsGeometry QgsMapClippingUtils::calculateLabelIntersectionGeometry( const QList<QgsMapClippingRegion> &regions, const QgsRenderContext &context, bool &shouldClip )
 {
   QgsGeometry result;
-  bool first = true;
+  QVector< QgsGeometry > geometries;
   shouldClip = false;
   for ( const QgsMapClippingRegion &region : regions )
   {
@@ -194,20 +232,14 @@ QgsGeometry QgsMapClippingUtils::calculateLabelIntersectionGeometry( const QList
       continue;
 
     shouldClip = true;
-    if ( first )
-    {
-      result = region.geometry();
-      first = false;
-    }
-    else
-    {
-      result = result.intersection( region.geometry() );
-    }
+    geometries << region.geometry();
   }
 
   if ( !shouldClip )
     return QgsGeometry();
 
+  result = intersectedRegions( geometries );
+
   // filter out polygon parts from result only
   result.convertGeometryCollectionToSubclass( QgsWkbTypes::PolygonGeometry );
 
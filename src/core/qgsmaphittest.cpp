@@ -26,6 +26,14 @@
 #include "qgsgeometry.h"
 #include "qgsgeometryengine.h"
 #include "qgsexpressioncontextutils.h"
+#include "qgscategorizedsymbolrenderer.h"
+#include "qgssettings.h"
+#include "qgsvectorlayerfeatureiterator.h"
+
+#include <QtConcurrent>
+
+// categorized renderers with more categories are tested by reading the features
+static const int MAXIMUM_CATEGORY_QUERIES = 64;
 
 QgsMapHitTest::QgsMapHitTest( const QgsMapSettings &settings, const QgsGeometry &polygon, const LayerFilterExpression &layerFilterExpression )
   : mSettings( settings )
@@ -45,17 +53,87 @@ QgsMapHitTest::QgsMapHitTest( const QgsMapSettings &settings, const LayerFilterE
 {
 }
 
-void QgsMapHitTest::run()
+///@cond PRIVATE
+struct QgsMapHitTest::LayerHitTest
 {
-  // TODO: do we need this temp image?
-  QImage tmpImage( mSettings.outputSize(), mSettings.outputImageFormat() );
-  tmpImage.setDotsPerMeterX( mSettings.outputDpi() * 25.4 );
-  tmpImage.setDotsPerMeterY( mSettings.outputDpi() * 25.4 );
-  QPainter painter( &tmpImage );
+  QgsVectorLayer *layer = nullptr;
+  std::unique_ptr< QgsVectorLayerFeatureSource > source;
+  std::unique_ptr< QgsFeatureRenderer > renderer;
+  QgsFields fields;
+  QgsRenderContext context;
+  bool onlyExpressions = true;
+  QgsGeometry polygon;
+  QString filterExpression;
+  //! Filter expressions of the categories, by legend key, when they can be tested with queries to the provider
+  QMap< QString, QString > categoryFilters;
+  QSize outputSize;
+  QImage::Format outputImageFormat = QImage::Format_ARGB32_Premultiplied;
+  int outputDpi = 96;
+  SymbolSet usedSymbols;
+  SymbolSet usedSymbolsRuleKey;
+};
+///@endcond
+
+// providers compiling the filter expressions of requests to their SQL WHERE clause, for which a query per category with a limit is cheap
+static bool compilesFilterExpressions( QgsVectorLayer *layer )
+{
+  static const QStringList sProviders
+  {
+    QStringLiteral( "postgres" ),
+    QStringLiteral( "spatialite" ),
+    QStringLiteral( "oracle" ),
+    QStringLiteral( "mssql" ),
+    QStringLiteral( "DB2" ),
+    QStringLiteral( "hana" )
+  };
+  return sProviders.contains( layer->providerType() )
+         && QgsSettings().value( QStringLiteral( "qgis/compileExpressions" ), true ).toBool();
+}
+
+// filter expressions of the categories of a renderer, by legend key, or an empty map if the categories cannot be queried
+static QMap< QString, QString > queryableCategoryFilters( const QgsFeatureRenderer *renderer, const QgsFields &fields )
+{
+  QMap< QString, QString > filters;
+  if ( renderer->type() != QLatin1String( "categorizedSymbol" ) )
+    return filters;
+
+  const QgsCategorizedSymbolRenderer *categorized = static_cast< const QgsCategorizedSymbolRenderer * >( renderer );
+  const QString attribute = categorized->classAttribute();
+  if ( fields.lookupField( attribute ) < 0 )
+    return filters;
 
+  const QgsCategoryList categories = categorized->categories();
+  if ( categories.size() > MAXIMUM_CATEGORY_QUERIES )
+    return filters;
+
+  for ( int i = 0; i < categories.size(); ++i )
+  {
+    const QgsRendererCategory &category = categories.at( i );
+    // features of disabled categories are neither drawn nor shown in the legend
+    if ( !category.renderState() )
+      continue;
+
+    const QVariantList values = category.value().type() == QVariant::List ? category.value().toList() : QVariantList() << category.value();
+    QStringList valueFilters;
+    for ( const QVariant &value : values )
+    {
+      // the catch all category matches the values of no other category, and the renderer does not distinguish NULL from empty strings
+      if ( value.toString().isEmpty() )
+        return QMap< QString, QString >();
+      valueFilters << QgsExpression::createFieldEqualityExpression( attribute, value );
+    }
+    if ( !valueFilters.isEmpty() )
+      filters.insert( QString::number( i ), valueFilters.join( QStringLiteral( " OR " ) ) );
+  }
+  return filters;
+}
+
+void QgsMapHitTest::run()
+{
+  // the layers are prepared in the calling thread, where the style overrides are applied
   QgsRenderContext context = QgsRenderContext::fromMapSettings( mSettings );
-  context.setPainter( &painter ); // we are not going to draw anything, but we still need a working painter
 
+  std::vector< LayerHitTest > layerHitTests;
   const auto constLayers = mSettings.layers();
   for ( QgsMapLayer *layer : constLayers )
   {
@@ -63,26 +141,67 @@ void QgsMapHitTest::run()
     if ( !vl || !vl->renderer() )
       continue;
 
+    if ( !mOnlyExpressions && !vl->isInScaleRange( mSettings.scale() ) )
+    {
+      mHitTest[vl] = SymbolSet(); // no symbols -> will not be shown
+      mHitTestRuleKey[vl] = SymbolSet();
+      continue;
+    }
+
+    LayerHitTest layerHitTest;
+    layerHitTest.layer = vl;
+    layerHitTest.context = context;
+    layerHitTest.onlyExpressions = mOnlyExpressions;
     if ( !mOnlyExpressions )
     {
-      if ( !vl->isInScaleRange( mSettings.scale() ) )
+      layerHitTest.context.setCoordinateTransform( mSettings.layerTransform( vl ) );
+      layerHitTest.context.setExtent( mSettings.outputExtentToLayerExtent( vl, mSettings.visibleExtent() ) );
+
+      layerHitTest.polygon = mPolygon;
+      if ( !mPolygon.isNull() && mSettings.destinationCrs() != vl->crs() )
       {
-        mHitTest[vl] = SymbolSet(); // no symbols -> will not be shown
-        mHitTestRuleKey[vl] = SymbolSet();
-        continue;
+        QgsCoordinateTransform ct( mSettings.destinationCrs(), vl->crs(), mSettings.transformContext() );
+        layerHitTest.polygon.transform( ct );
       }
+    }
+    layerHitTest.context.expressionContext() << QgsExpressionContextUtils::layerScope( vl );
+    layerHitTest.filterExpression = mLayerFilterExpression.value( vl->id() );
+    layerHitTest.outputSize = mSettings.outputSize();
+    layerHitTest.outputImageFormat = mSettings.outputImageFormat();
+    layerHitTest.outputDpi = mSettings.outputDpi();
 
-      context.setCoordinateTransform( mSettings.layerTransform( vl ) );
-      context.setExtent( mSettings.outputExtentToLayerExtent( vl, mSettings.visibleExtent() ) );
+    {
+      QgsMapLayerStyleOverride styleOverride( vl );
+      if ( mSettings.layerStyleOverrides().contains( vl->id() ) )
+        styleOverride.setOverrideStyle( mSettings.layerStyleOverrides().value( vl->id() ) );
+      layerHitTest.renderer.reset( vl->renderer()->clone() );
     }
+    layerHitTest.source = qgis::make_unique< QgsVectorLayerFeatureSource >( vl );
+    layerHitTest.fields = vl->fields();
+    if ( layerHitTest.polygon.isNull() && compilesFilterExpressions( vl ) )
+      layerHitTest.categoryFilters = queryableCategoryFilters( layerHitTest.renderer.get(), layerHitTest.fields );
 
-    context.expressionContext() << QgsExpressionContextUtils::layerScope( vl );
-    SymbolSet &usedSymbols = mHitTest[vl];
-    SymbolSet &usedSymbolsRuleKey = mHitTestRuleKey[vl];
-    runHitTestLayer( vl, usedSymbols, usedSymbolsRuleKey, context );
+    layerHitTests.emplace_back( std::move( layerHitTest ) );
   }
 
-  painter.end();
+  // the features of the layers are then read in parallel
+  if ( layerHitTests.size() > 1 )
+  {
+    QtConcurrent::blockingMap( layerHitTests, []( LayerHitTest & layerHitTest )
+    {
+      runHitTestLayer( layerHitTest );
+    } );
+  }
+  else if ( !layerHitTests.empty() )
+  {
+    runHitTestLayer( layerHitTests.front() );
+  }
+
+  for ( const LayerHitTest &layerHitTest : layerHitTests )
+  {
+    mHitTest[layerHitTest.layer] = layerHitTest.usedSymbols;
+    mHitTestRuleKey[layerHitTest.layer] = layerHitTest.usedSymbolsRuleKey;
+  }
 }
 
 bool QgsMapHitTest::symbolVisible( QgsSymbol *symbol, QgsVectorLayer *layer ) const
@@ -101,32 +220,75 @@ bool QgsMapHitTest::legendKeyVisible( const QString &ruleKey, QgsVectorLayer *la
   return mHitTestRuleKey.value( layer ).contains( ruleKey );
 }
 
-void QgsMapHitTest::runHitTestLayer( QgsVectorLayer *vl, SymbolSet &usedSymbols, SymbolSet &usedSymbolsRuleKey, QgsRenderContext &context )
+bool QgsMapHitTest::hasSameResults( const QgsMapHitTest &other, QgsVectorLayer *layer ) const
 {
-  QgsMapLayerStyleOverride styleOverride( vl );
-  if ( mSettings.layerStyleOverrides().contains( vl->id() ) )
-    styleOverride.setOverrideStyle( mSettings.layerStyleOverrides().value( vl->id() ) );
+  if ( mHitTest.contains( layer ) != other.mHitTest.contains( layer ) )
+    return false;
 
-  std::unique_ptr< QgsFeatureRenderer > r( vl->renderer()->clone() );
-  bool moreSymbolsPerFeature = r->capabilities() & QgsFeatureRenderer::MoreSymbolsPerFeature;
-  r->startRender( context, vl->fields() );
+  return mHitTest.value( layer ) == other.mHitTest.value( layer )
+         && mHitTestRuleKey.value( layer ) == other.mHitTestRuleKey.value( layer );
+}
 
-  QgsGeometry transformedPolygon = mPolygon;
-  if ( !mOnlyExpressions && !mPolygon.isNull() )
+bool QgsMapHitTest::runCategoryQueries( LayerHitTest &layerHitTest, const QgsFeatureRequest &request, const std::function< void( const QgsFeature & ) > &addFeature )
+{
+  // one query per visible category: each one looks for a feature of the categories which were not seen yet
+  QMap< QString, QString > remainingFilters = layerHitTest.categoryFilters;
+  while ( !remainingFilters.isEmpty() )
   {
-    if ( mSettings.destinationCrs() != vl->crs() )
-    {
-      QgsCoordinateTransform ct( mSettings.destinationCrs(), vl->crs(), mSettings.transformContext() );
-      transformedPolygon.transform( ct );
-    }
+    QStringList filters;
+    for ( const QString &filter : qgis::as_const( remainingFilters ) )
+      filters << QStringLiteral( "(%1)" ).arg( filter );
+    QString filter = filters.join( QStringLiteral( " OR " ) );
+    if ( !layerHitTest.filterExpression.isEmpty() )
+      filter = QStringLiteral( "(%1) AND (%2)" ).arg( layerHitTest.filterExpression, filter );
+
+    QgsFeatureRequest categoryRequest( request );
+    categoryRequest.setFilterExpression( filter );
+    categoryRequest.setExpressionContext( layerHitTest.context.expressionContext() );
+    categoryRequest.setLimit( 1 );
+
+    QgsFeature f;
+    QgsFeatureIterator fi = layerHitTest.source->getFeatures( categoryRequest );
+    if ( !fi.nextFeature( f ) )
+      return true;
+
+    layerHitTest.context.expressionContext().setFeature( f );
+    const QSet< QString > legendKeys = layerHitTest.renderer->legendKeysForFeature( f, layerHitTest.context );
+    bool removed = false;
+    for ( const QString &legendKey : legendKeys )
+      removed = remainingFilters.remove( legendKey ) || removed;
+    // the provider does not compare the values like the renderer, all the features have to be read
+    if ( !removed )
+      return false;
+
+    addFeature( f );
   }
+  return true;
+}
+
+void QgsMapHitTest::runHitTestLayer( LayerHitTest &layerHitTest )
+{
+  // TODO: do we need this temp image?
+  QImage tmpImage( layerHitTest.outputSize, layerHitTest.outputImageFormat );
+  tmpImage.setDotsPerMeterX( layerHitTest.outputDpi * 25.4 );
+  tmpImage.setDotsPerMeterY( layerHitTest.outputDpi * 25.4 );
+  QPainter painter( &tmpImage );
+
+  QgsRenderContext &context = layerHitTest.context;
+  context.setPainter( &painter ); // we are not going to draw anything, but we still need a working painter
+
+  QgsFeatureRenderer *r = layerHitTest.renderer.get();
+  bool moreSymbolsPerFeature = r->capabilities() & QgsFeatureRenderer::MoreSymbolsPerFeature;
+  r->startRender( context, layerHitTest.fields );
+
+  const QgsGeometry &transformedPolygon = layerHitTest.polygon;
 
   QgsFeature f;
   QgsFeatureRequest request;
   std::unique_ptr< QgsGeometryEngine > polygonEngine;
-  if ( !mOnlyExpressions )
+  if ( !layerHitTest.onlyExpressions )
   {
-    if ( mPolygon.isNull() )
+    if ( transformedPolygon.isNull() )
     {
       request.setFilterRect( context.extent() );
       request.setFlags( QgsFeatureRequest::ExactIntersect );
@@ -138,42 +300,37 @@ void QgsMapHitTest::runHitTestLayer( QgsVectorLayer *vl, SymbolSet &usedSymbols,
       polygonEngine->prepareGeometry();
     }
   }
-  QgsFeatureIterator fi = vl->getFeatures( request );
 
   SymbolSet lUsedSymbols;
   SymbolSet lUsedSymbolsRuleKey;
-  bool allExpressionFalse = false;
-  bool hasExpression = mLayerFilterExpression.contains( vl->id() );
-  std::unique_ptr<QgsExpression> expr;
-  if ( hasExpression )
+
+  // once all the symbols and legend keys of the renderer are used the remaining features cannot change the result
+  SymbolSet allSymbols;
+  SymbolSet allRuleKeys;
+  const QgsLegendSymbolList legendSymbols = r->legendSymbolItems();
+  for ( const QgsLegendSymbolItem &item : legendSymbols )
   {
-    expr.reset( new QgsExpression( mLayerFilterExpression[vl->id()] ) );
-    expr->prepare( &context.expressionContext() );
+    if ( item.symbol() )
+      allSymbols.insert( QgsSymbolLayerUtils::symbolProperties( item.symbol() ) );
+    if ( !item.ruleKey().isEmpty() )
+      allRuleKeys.insert( item.ruleKey() );
   }
-  while ( fi.nextFeature( f ) )
-  {
-    context.expressionContext().setFeature( f );
-    // filter out elements outside of the polygon
-    if ( f.hasGeometry() && polygonEngine )
-    {
-      if ( !polygonEngine->intersects( f.geometry().constGet() ) )
-      {
-        continue;
-      }
-    }
 
-    // filter out elements where the expression is false
-    if ( hasExpression )
-    {
-      if ( !expr->evaluate( &context.expressionContext() ).toBool() )
-        continue;
-      else
-        allExpressionFalse = false;
-    }
+  // the symbols of the renderer are shared by the features, they are only converted once to strings
+  QHash< QgsSymbol *, QString > symbolPropertiesCache;
+  auto symbolProperties = [&symbolPropertiesCache]( QgsSymbol * symbol )
+  {
+    auto it = symbolPropertiesCache.constFind( symbol );
+    if ( it == symbolPropertiesCache.constEnd() )
+      it = symbolPropertiesCache.insert( symbol, QgsSymbolLayerUtils::symbolProperties( symbol ) );
+    return it.value();
+  };
 
+  auto addFeature = [&]( const QgsFeature & feature )
+  {
     //make sure we store string representation of symbol, not pointer
     //otherwise layer style override changes will delete original symbols and leave hanging pointers
-    const auto constLegendKeysForFeature = r->legendKeysForFeature( f, context );
+    const auto constLegendKeysForFeature = r->legendKeysForFeature( feature, context );
     for ( const QString &legendKey : constLegendKeysForFeature )
     {
       lUsedSymbolsRuleKey.insert( legendKey );
@@ -181,27 +338,71 @@ void QgsMapHitTest::runHitTestLayer( QgsVectorLayer *vl, SymbolSet &usedSymbols,
 
     if ( moreSymbolsPerFeature )
     {
-      const auto constOriginalSymbolsForFeature = r->originalSymbolsForFeature( f, context );
+      const auto constOriginalSymbolsForFeature = r->originalSymbolsForFeature( feature, context );
       for ( QgsSymbol *s : constOriginalSymbolsForFeature )
       {
         if ( s )
-          lUsedSymbols.insert( QgsSymbolLayerUtils::symbolProperties( s ) );
+          lUsedSymbols.insert( symbolProperties( s ) );
       }
     }
     else
     {
-      QgsSymbol *s = r->originalSymbolForFeature( f, context );
+      QgsSymbol *s = r->originalSymbolForFeature( feature, context );
       if ( s )
-        lUsedSymbols.insert( QgsSymbolLayerUtils::symbolProperties( s ) );
+        lUsedSymbols.insert( symbolProperties( s ) );
+    }
+  };
+
+  bool allExpressionFalse = false;
+  bool hasExpression = !layerHitTest.filterExpression.isEmpty();
+  if ( layerHitTest.categoryFilters.isEmpty() || !runCategoryQueries( layerHitTest, request, addFeature ) )
+  {
+    lUsedSymbols.clear();
+    lUsedSymbolsRuleKey.clear();
+
+    std::unique_ptr<QgsExpression> expr;
+    if ( hasExpression )
+    {
+      expr.reset( new QgsExpression( layerHitTest.filterExpression ) );
+      expr->prepare( &context.expressionContext() );
+    }
+    QgsFeatureIterator fi = layerHitTest.source->getFeatures( request );
+    while ( fi.nextFeature( f ) )
+    {
+      context.expressionContext().setFeature( f );
+      // filter out elements outside of the polygon
+      if ( f.hasGeometry() && polygonEngine )
+      {
+        if ( !polygonEngine->intersects( f.geometry().constGet() ) )
+        {
+          continue;
+        }
+      }
+
+      // filter out elements where the expression is false
+      if ( hasExpression )
+      {
+        if ( !expr->evaluate( &context.expressionContext() ).toBool() )
+          continue;
+        else
+          allExpressionFalse = false;
+      }
+
+      addFeature( f );
+
+      if ( !allSymbols.isEmpty() && lUsedSymbols.size() >= allSymbols.size() && lUsedSymbolsRuleKey.size() >= allRuleKeys.size()
+           && lUsedSymbols.contains( allSymbols ) && lUsedSymbolsRuleKey.contains( allRuleKeys ) )
+        break;
     }
   }
   r->stopRender( context );
+  painter.end();
+  context.setPainter( nullptr );
 
   if ( !allExpressionFalse )
   {
     // QSet is implicitly shared => constant time
-    usedSymbols = lUsedSymbols;
-    usedSymbolsRuleKey = lUsedSymbolsRuleKey;
+    layerHitTest.usedSymbols = lUsedSymbols;
+    layerHitTest.usedSymbolsRuleKey = lUsedSymbolsRuleKey;
   }
 }
-
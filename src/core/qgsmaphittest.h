@@ -22,10 +22,14 @@
 
 #include <QSet>
 
+#include <functional>
+
 class QgsRenderContext;
 class QgsSymbol;
 class QgsVectorLayer;
 class QgsExpression;
+class QgsFeature;
+class QgsFeatureRequest;
 
 /**
  * \ingroup core
@@ -71,6 +75,13 @@ class CORE_EXPORT QgsMapHitTest
      */
     bool legendKeyVisible( const QString &ruleKey, QgsVectorLayer *layer ) const;
 
+    /**
+     * Returns TRUE if the same symbols and legend keys are visible for \a layer in this
+     * hit test and in \a other.
+     * \since QGIS 3.16
+     */
+    bool hasSameResults( const QgsMapHitTest &other, QgsVectorLayer *layer ) const;
+
   private:
 
     //! \note not available in Python bindings
@@ -79,16 +90,21 @@ class CORE_EXPORT QgsMapHitTest
     //! \note not available in Python bindings
     typedef QMap<QgsVectorLayer *, SymbolSet> HitTest;
 
+    struct LayerHitTest;
+
     /**
-     * Runs test for visible symbols within a layer
-     * \param vl vector layer
-     * \param usedSymbols set for storage of visible symbols
-     * \param usedSymbolsRuleKey set of storage of visible legend rule keys
-     * \param context render context
+     * Runs test for visible symbols within a layer, from its feature source and a clone
+     * of its renderer, possibly in a worker thread
+     * \note not available in Python bindings
+     */
+    static void runHitTestLayer( LayerHitTest &layerHitTest );
+
+    /**
+     * Looks for the visible categories of a categorized renderer with a query per category,
+     * filtered by the provider. Returns FALSE if all the features have to be read.
      * \note not available in Python bindings
-     * \since QGIS 2.12
      */
-    void runHitTestLayer( QgsVectorLayer *vl, SymbolSet &usedSymbols, SymbolSet &usedSymbolsRuleKey, QgsRenderContext &context );
+    static bool runCategoryQueries( LayerHitTest &layerHitTest, const QgsFeatureRequest &request, const std::function< void( const QgsFeature & ) > &addFeature );
 
     //! The initial map settings
     QgsMapSettings mSettings;
@@ -23,6 +23,39 @@
 class QgsFeedback;
 class QgsRenderContext;
 
+/**
+ * \ingroup core
+ * Statistics collected by a map layer renderer while rendering a layer, when the
+ * QgsRenderContext::RecordRenderingStatistics flag is set. Times are in milliseconds.
+ *
+ * \since QGIS 3.16
+ */
+class CORE_EXPORT QgsMapLayerRenderingStatistics
+{
+  public:
+
+    //! Time spent to fetch the features from the provider
+    double fetchTime = 0;
+
+    //! Time spent to evaluate the symbols of the features and to draw them
+    double symbolDrawingTime = 0;
+
+    //! Time spent to register the features for labeling and diagrams
+    double labelingTime = 0;
+
+    //! Number of features fetched from the provider
+    long long featuresFetched = 0;
+
+    //! Number of fetched features which were drawn
+    long long featuresDrawn = 0;
+
+    //! TRUE if the layer was not rendered, its image being taken from the cache
+    bool cached = false;
+
+    //! Total rendering time of the layer, including the preparation of the renderer
+    double renderingTime = 0;
+};
+
 /**
  * \ingroup core
  * Base class for utility classes that encapsulate information necessary
@@ -83,10 +116,25 @@ class CORE_EXPORT QgsMapLayerRenderer
      */
     QgsRenderContext *renderContext() { return mContext; }
 
+    /**
+     * Returns the statistics collected during the rendering, when the
+     * QgsRenderContext::RecordRenderingStatistics flag is set.
+     *
+     * \since QGIS 3.16
+     */
+    QgsMapLayerRenderingStatistics statistics() const { return mStatistics; }
+
   protected:
     QStringList mErrors;
     QString mLayerID;
 
+    /**
+     * Statistics collected by the renderer.
+     *
+     * \since QGIS 3.16
+     */
+    QgsMapLayerRenderingStatistics mStatistics;
+
   private:
 
     // TODO QGIS 4.0 - make reference instead of pointer!
@@ -27,6 +27,7 @@ void QgsMapRendererCache::clear()
 {
   QMutexLocker lock( &mMutex );
   clearInternal();
+  mLabelPlacements.reset();
 }
 
 void QgsMapRendererCache::clearInternal()
@@ -45,9 +46,20 @@ void QgsMapRendererCache::clearInternal()
     }
   }
   mCachedImages.clear();
+  mPreviousImages.clear();
   mConnectedLayers.clear();
 }
 
+void QgsMapRendererCache::connectLayer( QgsMapLayer *layer )
+{
+  if ( !mConnectedLayers.contains( QgsWeakMapLayerPointer( layer ) ) )
+  {
+    connect( layer, &QgsMapLayer::repaintRequested, this, &QgsMapRendererCache::layerRequestedRepaint );
+    connect( layer, &QgsMapLayer::willBeDeleted, this, &QgsMapRendererCache::layerRequestedRepaint );
+    mConnectedLayers << layer;
+  }
+}
+
 void QgsMapRendererCache::dropUnusedConnections()
 {
   QSet< QgsWeakMapLayerPointer > stillDepends = dependentLayers();
@@ -68,14 +80,17 @@ void QgsMapRendererCache::dropUnusedConnections()
 QSet<QgsWeakMapLayerPointer > QgsMapRendererCache::dependentLayers() const
 {
   QSet< QgsWeakMapLayerPointer > result;
-  QMap<QString, CacheParameters>::const_iterator it = mCachedImages.constBegin();
-  for ( ; it != mCachedImages.constEnd(); ++it )
+  for ( const QMap<QString, CacheParameters> *images : { &mCachedImages, &mPreviousImages } )
   {
-    const auto dependentLayers { it.value().dependentLayers };
-    for ( const QgsWeakMapLayerPointer &l : dependentLayers )
+    QMap<QString, CacheParameters>::const_iterator it = images->constBegin();
+    for ( ; it != images->constEnd(); ++it )
     {
-      if ( l.data() )
-        result << l;
+      const auto dependentLayers { it.value().dependentLayers };
+      for ( const QgsWeakMapLayerPointer &l : dependentLayers )
+      {
+        if ( l.data() )
+          result << l;
+      }
     }
   }
   return result;
@@ -90,12 +105,29 @@ bool QgsMapRendererCache::init( const QgsRectangle &extent, double scale )
        qgsDoubleNear( scale, mScale ) )
     return true;
 
+  // after a pan the images are still valid for the part of the new extent they cover
+  QMap<QString, CacheParameters> previousImages;
+  const QgsRectangle previousExtent = mExtent;
+  if ( qgsDoubleNear( scale, mScale ) && !mExtent.isEmpty() && mExtent.intersects( extent ) )
+    previousImages = mCachedImages;
+
   clearInternal();
 
   // set new params
   mExtent = extent;
   mScale = scale;
 
+  mPreviousImages = previousImages;
+  mPreviousExtent = previousExtent;
+  for ( const CacheParameters &params : qgis::as_const( mPreviousImages ) )
+  {
+    for ( const QgsWeakMapLayerPointer &layer : params.dependentLayers )
+    {
+      if ( layer.data() )
+        connectLayer( layer.data() );
+    }
+  }
+
   return false;
 }
 
@@ -113,16 +145,12 @@ void QgsMapRendererCache::setCacheImage( const QString &cacheKey, const QImage &
     if ( layer )
     {
       params.dependentLayers << layer;
-      if ( !mConnectedLayers.contains( QgsWeakMapLayerPointer( layer ) ) )
-      {
-        connect( layer, &QgsMapLayer::repaintRequested, this, &QgsMapRendererCache::layerRequestedRepaint );
-        connect( layer, &QgsMapLayer::willBeDeleted, this, &QgsMapRendererCache::layerRequestedRepaint );
-        mConnectedLayers << layer;
-      }
+      connectLayer( layer );
     }
   }
 
   mCachedImages[cacheKey] = params;
+  mPreviousImages.remove( cacheKey );
 }
 
 bool QgsMapRendererCache::hasCacheImage( const QString &cacheKey ) const
@@ -160,16 +188,19 @@ void QgsMapRendererCache::invalidateCacheForLayer( QgsMapLayer *layer )
   QMutexLocker lock( &mMutex );
 
   // check through all cached images to clear any which depend on this layer
-  QMap<QString, CacheParameters>::iterator it = mCachedImages.begin();
-  for ( ; it != mCachedImages.end(); )
+  for ( QMap<QString, CacheParameters> *images : { &mCachedImages, &mPreviousImages } )
   {
-    if ( !it.value().dependentLayers.contains( layer ) )
+    QMap<QString, CacheParameters>::iterator it = images->begin();
+    for ( ; it != images->end(); )
     {
-      ++it;
-      continue;
-    }
+      if ( !it.value().dependentLayers.contains( layer ) )
+      {
+        ++it;
+        continue;
+      }
 
-    it = mCachedImages.erase( it );
+      it = images->erase( it );
+    }
   }
   dropUnusedConnections();
 }
@@ -179,6 +210,37 @@ void QgsMapRendererCache::clearCacheImage( const QString &cacheKey )
   QMutexLocker lock( &mMutex );
 
   mCachedImages.remove( cacheKey );
+  mPreviousImages.remove( cacheKey );
   dropUnusedConnections();
 }
 
+void QgsMapRendererCache::setLabelPlacements( std::shared_ptr<const QgsLabelPlacements> placements )
+{
+  QMutexLocker lock( &mMutex );
+  mLabelPlacements = std::move( placements );
+}
+
+std::shared_ptr<const QgsLabelPlacements> QgsMapRendererCache::labelPlacements() const
+{
+  QMutexLocker lock( &mMutex );
+  return mLabelPlacements;
+}
+
+QImage QgsMapRendererCache::previousCacheImage( const QString &cacheKey, QgsRectangle &extent ) const
+{
+  QMutexLocker lock( &mMutex );
+  extent = mPreviousExtent;
+  return mPreviousImages.value( cacheKey ).cachedImage;
+}
+
+void QgsMapRendererCache::setLayerRenderingTime( const QString &layerId, int time )
+{
+  QMutexLocker lock( &mMutex );
+  mLayerRenderingTimes.insert( layerId, time );
+}
+
+int QgsMapRendererCache::layerRenderingTime( const QString &layerId ) const
+{
+  QMutexLocker lock( &mMutex );
+  return mLayerRenderingTimes.value( layerId, -1 );
+}
@@ -17,13 +17,19 @@
 #define QGSMAPRENDERERCACHE_H
 
 #include "qgis_core.h"
+#include <QHash>
 #include <QMap>
 #include <QImage>
 #include <QMutex>
 
+#include <memory>
+
 #include "qgsrectangle.h"
 #include "qgsmaplayer.h"
 
+#ifndef SIP_RUN
+class QgsLabelPlacements;
+#endif
 
 /**
  * \ingroup core
@@ -35,6 +41,10 @@
  * If triggered, the cache removes the rendered image (and disconnects from the
  * layers).
  *
+ * When the cache is initialized for another extent at the same scale (e.g. after
+ * a pan), the images of the previous extent are kept as previous cache images,
+ * so that the renderer only has to draw the newly uncovered part of the layers.
+ *
  * The class is thread-safe (multiple classes can access the same instance safely).
  *
  * \since QGIS 2.4
@@ -104,6 +114,59 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
      */
     void invalidateCacheForLayer( QgsMapLayer *layer );
 
+#ifndef SIP_RUN
+
+    /**
+     * Sets the label \a placements solved by the last render of the map, which are kept
+     * when the cache is initialized for another extent.
+     * \see labelPlacements()
+     * \note not available in Python bindings
+     * \since QGIS 3.16
+     */
+    void setLabelPlacements( std::shared_ptr< const QgsLabelPlacements > placements );
+
+    /**
+     * Returns the label placements solved by the last render of the map, or NULLPTR.
+     * \see setLabelPlacements()
+     * \note not available in Python bindings
+     * \since QGIS 3.16
+     */
+    std::shared_ptr< const QgsLabelPlacements > labelPlacements() const;
+
+    /**
+     * Returns the image cached for \a cacheKey before the cache was initialized for
+     * the current extent at the same scale, or a null image. The map extent of the
+     * image is set in \a extent.
+     *
+     * The previous images are dropped by the next initialization of the cache, and
+     * when their dependent layers request a repaint, like the cached images. The
+     * previous image of \a cacheKey is also dropped by setCacheImage() and clearCacheImage().
+     *
+     * \note not available in Python bindings
+     * \since QGIS 3.16
+     */
+    QImage previousCacheImage( const QString &cacheKey, QgsRectangle &extent ) const;
+
+    /**
+     * Sets the \a time in milliseconds the last complete rendering of the layer with
+     * the given \a layerId took. The rendering times are kept when the cache is
+     * initialized or cleared.
+     * \see layerRenderingTime()
+     * \note not available in Python bindings
+     * \since QGIS 3.16
+     */
+    void setLayerRenderingTime( const QString &layerId, int time );
+
+    /**
+     * Returns the time in milliseconds the last complete rendering of the layer with
+     * the given \a layerId took, or -1 if it is unknown.
+     * \see setLayerRenderingTime()
+     * \note not available in Python bindings
+     * \since QGIS 3.16
+     */
+    int layerRenderingTime( const QString &layerId ) const;
+#endif
+
   private slots:
     //! Remove layer (that emitted the signal) from the cache
     void layerRequestedRepaint();
@@ -122,6 +185,9 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
     //! Disconnects from layers we no longer care about
     void dropUnusedConnections();
 
+    //! Listens to the repaint requests of \a layer, if not connected yet
+    void connectLayer( QgsMapLayer *layer );
+
     QSet< QgsWeakMapLayerPointer > dependentLayers() const;
 
     mutable QMutex mMutex;
@@ -130,8 +196,18 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
 
     //! Map of cache key to cache parameters
     QMap<QString, CacheParameters> mCachedImages;
+    //! Images of the previous extent at the same scale, by cache key
+    QMap<QString, CacheParameters> mPreviousImages;
+    //! Map extent of the previous images
+    QgsRectangle mPreviousExtent;
+    //! Rendering times of the layers, by layer id
+    QHash<QString, int> mLayerRenderingTimes;
     //! List of all layers on which this cache is currently connected
     QSet< QgsWeakMapLayerPointer > mConnectedLayers;
+#ifndef SIP_RUN
+    //! Label placements of the last render, they do not depend on the extent
+    std::shared_ptr< const QgsLabelPlacements > mLabelPlacements;
+#endif
 };
 
 
@@ -310,8 +310,7 @@ void QgsMapRendererCustomPainterJob::doRender()
 
       if ( job.img )
       {
-        job.img->fill( 0 );
-        job.imageInitialized = true;
+        initializeLayerImage( job );
       }
 
       job.renderer->render();
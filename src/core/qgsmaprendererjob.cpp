@@ -17,6 +17,9 @@
 
 #include <QPainter>
 #include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QTimer>
 #include <QtConcurrentMap>
 
@@ -84,6 +87,64 @@ QHash<QgsMapLayer *, int> QgsMapRendererJob::perLayerRenderingTime() const
   return result;
 }
 
+QByteArray QgsMapRendererJob::renderingStatisticsChromeTrace() const
+{
+  QJsonArray events;
+  auto addEvent = [&events]( const QString & name, int thread, double start, double duration, const QJsonObject & args = QJsonObject() )
+  {
+    QJsonObject event;
+    event.insert( QStringLiteral( "name" ), name );
+    event.insert( QStringLiteral( "cat" ), QStringLiteral( "render" ) );
+    event.insert( QStringLiteral( "ph" ), QStringLiteral( "X" ) );
+    event.insert( QStringLiteral( "pid" ), 1 );
+    event.insert( QStringLiteral( "tid" ), thread );
+    // times are in microseconds
+    event.insert( QStringLiteral( "ts" ), start * 1000 );
+    event.insert( QStringLiteral( "dur" ), duration * 1000 );
+    if ( !args.isEmpty() )
+      event.insert( QStringLiteral( "args" ), args );
+    events.append( event );
+  };
+
+  const QList< QgsMapLayer * > layers = mSettings.layers();
+  int thread = 1;
+  for ( auto it = mPerLayerRenderingStatistics.constBegin(); it != mPerLayerRenderingStatistics.constEnd(); ++it, ++thread )
+  {
+    const QgsMapLayerRenderingStatistics &statistics = it.value();
+    QgsMapLayer *layer = _qgis_findLayer( layers, it.key() );
+    QJsonObject args;
+    args.insert( QStringLiteral( "layerId" ), it.key() );
+    args.insert( QStringLiteral( "cached" ), statistics.cached );
+    args.insert( QStringLiteral( "featuresFetched" ), statistics.featuresFetched );
+    args.insert( QStringLiteral( "featuresDrawn" ), statistics.featuresDrawn );
+    addEvent( layer ? layer->name() : it.key(), thread, 0, statistics.renderingTime, args );
+
+    // the phases are interleaved feature by feature, they are shown one after the other
+    double start = 0;
+    const QList< QPair< QString, double > > phases
+    {
+      qMakePair( QStringLiteral( "Fetching" ), statistics.fetchTime ),
+      qMakePair( QStringLiteral( "Drawing" ), statistics.symbolDrawingTime ),
+      qMakePair( QStringLiteral( "Labeling" ), statistics.labelingTime )
+    };
+    for ( const QPair< QString, double > &phase : phases )
+    {
+      if ( phase.second <= 0 )
+        continue;
+      addEvent( phase.first, thread, start, phase.second );
+      start += phase.second;
+    }
+  }
+
+  if ( mLabelingTime >= 0 )
+    addEvent( QStringLiteral( "Labels" ), thread, 0, mLabelingTime );
+
+  QJsonObject trace;
+  trace.insert( QStringLiteral( "traceEvents" ), events );
+  trace.insert( QStringLiteral( "displayTimeUnit" ), QStringLiteral( "ms" ) );
+  return QJsonDocument( trace ).toJson( QJsonDocument::Compact );
+}
+
 const QgsMapSettings &QgsMapRendererJob::mapSettings() const
 {
   return mSettings;
@@ -291,6 +352,9 @@ LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter *painter, QgsLabelingEn
 {
   LayerRenderJobs layerJobs;
 
+  if ( QgsHotPathInstrumentation::isEnabled() )
+    mInstrumentationScope = qgis::make_unique< QgsHotPathInstrumentation::Scope >( QStringLiteral( "Map render" ) );
+
   // render all layers in the stack, starting at the base
   QListIterator<QgsMapLayer *> li( mSettings.layers() );
   li.toBack();
@@ -304,6 +368,22 @@ LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter *painter, QgsLabelingEn
 
   bool requiresLabelRedraw = !( mCache && mCache->hasCacheImage( LABEL_CACHE_ID ) );
 
+  // the second pass of the selective masking renders the layers again, in full
+  bool hasMasks = false;
+  if ( mCache )
+  {
+    const QList< QgsMapLayer * > layers = mSettings.layers();
+    for ( QgsMapLayer *layer : layers )
+    {
+      QgsVectorLayer *vl = qobject_cast< QgsVectorLayer * >( layer );
+      if ( vl && ( !QgsVectorLayerUtils::labelMasks( vl ).isEmpty() || !QgsVectorLayerUtils::symbolLayerMasks( vl ).isEmpty() ) )
+      {
+        hasMasks = true;
+        break;
+      }
+    }
+  }
+
   while ( li.hasPrevious() )
   {
     QgsMapLayer *ml = li.previous();
@@ -382,6 +462,11 @@ LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter *painter, QgsLabelingEn
     if ( mFeatureFilterProvider )
       job.context.setFeatureFilterProvider( mFeatureFilterProvider );
 
+    // layers which were slow to render first draw a quick preview
+    if ( mCache && vl && mSettings.testFlag( QgsMapSettings::ProgressiveRendering )
+         && mCache->layerRenderingTime( ml->id() ) > PROGRESSIVE_RENDERING_THRESHOLD )
+      job.context.setFlag( QgsRenderContext::ProgressiveRendering );
+
     QgsMapLayerStyleOverride styleOverride( ml );
     if ( mSettings.layerStyleOverrides().contains( ml->id() ) )
       styleOverride.setOverrideStyle( mSettings.layerStyleOverrides().value( ml->id() ) );
@@ -409,6 +494,16 @@ LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter *painter, QgsLabelingEn
       continue;
     }
 
+    // after a pan, reuse the part of the image of the previous extent which is still visible.
+    // Not for labeled layers, the features of the whole extent must be registered for labeling
+    QImage previousImage;
+    QRect previousRect;
+    QgsRectangle uncoveredExtent;
+    if ( mCache && vl && !vl->isEditable() && !hasMasks && !( labelingEngine2 && QgsPalLabeling::staticWillUseLayer( ml ) ) )
+    {
+      previousImage = previousLayerImage( vl, previousRect, uncoveredExtent );
+    }
+
     // If we are drawing with an alternative blending mode then we need to render to a separate image
     // before compositing this on the map. This effectively flattens the layer and prevents
     // blending occurring between objects on the layer
@@ -421,6 +516,25 @@ LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter *painter, QgsLabelingEn
         layerJobs.removeLast();
         continue;
       }
+
+      if ( !previousImage.isNull() )
+      {
+        job.previousImage = previousImage;
+        job.previousImageOffset = previousRect.topLeft();
+        job.context.painter()->setClipRegion( QRegion( QRect( QPoint( 0, 0 ), mSettings.outputSize() ) ).subtracted( QRegion( previousRect ) ) );
+
+        // only the features of the uncovered area are fetched, if it can be transformed
+        uncoveredExtent.grow( mSettings.extentBuffer() );
+        bool validExtent = true;
+        if ( ct.isValid() )
+        {
+          QgsRectangle uncoveredExtent2;
+          reprojectToLayerExtent( ml, ct, uncoveredExtent, uncoveredExtent2 );
+          validExtent = uncoveredExtent.isFinite();
+        }
+        if ( validExtent )
+          job.context.setExtent( uncoveredExtent );
+      }
     }
 
     QElapsedTimer layerTime;
@@ -628,6 +742,10 @@ LabelRenderJob QgsMapRendererJob::prepareLabelingJob( QPainter *painter, QgsLabe
     {
       job.img = allocateImage( QStringLiteral( "labels" ) );
     }
+
+    // labels of the features which stay visible are kept in place
+    if ( mCache && labelingEngine2 )
+      labelingEngine2->setPreviousPlacements( mCache->labelPlacements() );
   }
 
   return job;
@@ -648,6 +766,8 @@ void QgsMapRendererJob::cleanupJobs( LayerRenderJobs &jobs )
       {
         QgsDebugMsgLevel( QStringLiteral( "caching image for %1" ).arg( job.layerId ), 2 );
         mCache->setCacheImage( job.layerId, *job.img, QList< QgsMapLayer * >() << job.layer );
+        if ( job.renderingTime >= 0 )
+          mCache->setLayerRenderingTime( job.layerId, job.renderingTime );
       }
 
       delete job.img;
@@ -662,6 +782,14 @@ void QgsMapRendererJob::cleanupJobs( LayerRenderJobs &jobs )
       delete job.maskImage;
     }
 
+    if ( mSettings.testFlag( QgsMapSettings::RecordRenderingStatistics ) && ( job.renderer || job.cached ) )
+    {
+      QgsMapLayerRenderingStatistics statistics = job.renderer ? job.renderer->statistics() : QgsMapLayerRenderingStatistics();
+      statistics.cached = job.cached;
+      statistics.renderingTime = std::max( job.renderingTime, 0 );
+      mPerLayerRenderingStatistics.insert( job.layerId, statistics );
+    }
+
     if ( job.renderer )
     {
       const auto constErrors = job.renderer->errors();
@@ -707,6 +835,14 @@ void QgsMapRendererJob::cleanupSecondPassJobs( LayerRenderJobs &jobs )
 
 void QgsMapRendererJob::cleanupLabelJob( LabelRenderJob &job )
 {
+  mLabelingTime = job.renderingTime;
+  mInstrumentationScope.reset();
+
+  if ( mCache && !job.cached && !job.context.renderingStopped() && job.context.labelingEngine() && job.context.labelingEngine()->placements() )
+  {
+    mCache->setLabelPlacements( job.context.labelingEngine()->placements() );
+  }
+
   if ( job.img )
   {
     if ( mCache && !job.cached && !job.context.renderingStopped() )
@@ -922,6 +1058,90 @@ void QgsMapRendererJob::logRenderingTime( const LayerRenderJobs &jobs, const Lay
   QgsMessageLog::logMessage( QStringLiteral( "---" ), tr( "Rendering" ) );
 }
 
+QImage QgsMapRendererJob::previousLayerImage( QgsVectorLayer *vl, QRect &rect, QgsRectangle &uncoveredExtent ) const
+{
+  QgsRectangle previousExtent;
+  const QImage image = mCache->previousCacheImage( vl->id(), previousExtent );
+  if ( image.isNull() || !qgsDoubleNear( mSettings.rotation(), 0.0 ) || image.size() != mSettings.deviceOutputSize()
+       || !qgsDoubleNear( image.devicePixelRatioF(), mSettings.devicePixelRatio() ) )
+    return QImage();
+
+  // same resolution, shifted by whole pixels
+  const QSize size = mSettings.outputSize();
+  const QgsRectangle extent = mSettings.visibleExtent();
+  const double mapUnitsPerPixel = mSettings.mapUnitsPerPixel();
+  if ( !qgsDoubleNear( previousExtent.width() / size.width(), mapUnitsPerPixel, mapUnitsPerPixel * 1e-6 ) )
+    return QImage();
+  const double dx = ( previousExtent.xMinimum() - extent.xMinimum() ) / mapUnitsPerPixel;
+  const double dy = ( extent.yMaximum() - previousExtent.yMaximum() ) / mapUnitsPerPixel;
+  if ( std::fabs( dx - std::round( dx ) ) > 0.01 || std::fabs( dy - std::round( dy ) ) > 0.01 )
+    return QImage();
+
+  const QRect map( QPoint( 0, 0 ), size );
+  rect = QRect( QPoint( static_cast< int >( std::round( dx ) ), static_cast< int >( std::round( dy ) ) ), size );
+  const QRect covered = rect.intersected( map );
+  if ( covered.isEmpty() || covered == map )
+    return QImage();
+
+  // uncovered area, a band after a horizontal or vertical pan, the whole map otherwise
+  QRect uncovered = map;
+  if ( covered.width() == size.width() )
+  {
+    if ( covered.top() > 0 )
+      uncovered.setBottom( covered.top() - 1 );
+    else
+      uncovered.setTop( covered.bottom() + 1 );
+  }
+  else if ( covered.height() == size.height() )
+  {
+    if ( covered.left() > 0 )
+      uncovered.setRight( covered.left() - 1 );
+    else
+      uncovered.setLeft( covered.right() + 1 );
+  }
+
+  // the symbols of the features close to the uncovered area may paint in it
+  if ( vl->renderer() )
+  {
+    QgsRenderContext context = QgsRenderContext::fromMapSettings( mSettings );
+    double bleed = 2;
+    const QgsSymbolList symbols = vl->renderer()->symbols( context );
+    for ( QgsSymbol *symbol : symbols )
+    {
+      bleed = std::max( bleed, QgsSymbolLayerUtils::estimateMaxSymbolBleed( symbol, context ) );
+      if ( symbol->type() == QgsSymbol::Marker )
+        bleed = std::max( bleed, static_cast< QgsMarkerSymbol * >( symbol )->size( context ) );
+      else if ( symbol->type() == QgsSymbol::Line )
+        bleed = std::max( bleed, static_cast< QgsLineSymbol * >( symbol )->width( context ) );
+    }
+    const int margin = static_cast< int >( std::ceil( bleed ) );
+    uncovered.adjust( -margin, -margin, margin, margin );
+  }
+
+  uncoveredExtent = QgsRectangle( extent.xMinimum() + uncovered.left() * mapUnitsPerPixel,
+                                  extent.yMaximum() - ( uncovered.bottom() + 1 ) * mapUnitsPerPixel,
+                                  extent.xMinimum() + ( uncovered.right() + 1 ) * mapUnitsPerPixel,
+                                  extent.yMaximum() - uncovered.top() * mapUnitsPerPixel );
+  return image;
+}
+
+void QgsMapRendererJob::initializeLayerImage( LayerRenderJob &job )
+{
+  job.img->fill( 0 );
+  if ( !job.previousImage.isNull() && job.context.painter() )
+  {
+    // the painter is clipped to the uncovered area
+    QPainter *painter = job.context.painter();
+    painter->save();
+    painter->setClipping( false );
+    painter->setCompositionMode( QPainter::CompositionMode_Source );
+    painter->drawImage( job.previousImageOffset, job.previousImage );
+    painter->restore();
+    job.previousImage = QImage();
+  }
+  job.imageInitialized = true;
+}
+
 bool QgsMapRendererJob::needTemporaryImage( QgsMapLayer *ml )
 {
   switch ( ml->type() )
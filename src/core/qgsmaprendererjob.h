@@ -26,6 +26,8 @@
 
 #include "qgsrendercontext.h"
 
+#include "qgshotpathinstrumentation.h"
+#include "qgsmaplayerrenderer.h"
 #include "qgsmapsettings.h"
 #include "qgsmaskidprovider.h"
 
@@ -35,6 +37,7 @@ class QgsLabelingResults;
 class QgsMapLayerRenderer;
 class QgsMapRendererCache;
 class QgsFeatureFilterProvider;
+class QgsVectorLayer;
 
 #ifndef SIP_RUN
 /// @cond PRIVATE
@@ -60,6 +63,15 @@ struct LayerRenderJob
   double opacity;
   //! If TRUE, img already contains cached image from previous rendering
   bool cached;
+
+  /**
+   * Image of the layer cached for the previous extent, drawn at previousImageOffset when
+   * img is initialized. The painter of the job is then clipped to the uncovered area.
+   * \since QGIS 3.16
+   */
+  QImage previousImage;
+  //! Position of previousImage in img, in logical pixels (since QGIS 3.16)
+  QPoint previousImageOffset;
   QgsWeakMapLayerPointer layer;
   int renderingTime; //!< Time it took to render the layer in ms (it is -1 if not rendered or still rendering)
   QStringList errors; //!< Rendering errors
@@ -283,6 +295,32 @@ class CORE_EXPORT QgsMapRendererJob : public QObject
      */
     QHash< QgsMapLayer *, int > perLayerRenderingTime() const SIP_SKIP;
 
+    /**
+     * Returns the time (in ms) it took to render the labels, or -1 if no labels
+     * were rendered.
+     * \see perLayerRenderingTime()
+     * \since QGIS 3.16
+     */
+    int labelingTime() const { return mLabelingTime; }
+
+    /**
+     * Returns the statistics of the rendering of each layer, by layer ID. They are only
+     * recorded with the QgsMapSettings::RecordRenderingStatistics flag.
+     * \note Not available in Python bindings.
+     * \see renderingStatisticsChromeTrace()
+     * \since QGIS 3.16
+     */
+    QHash< QString, QgsMapLayerRenderingStatistics > perLayerRenderingStatistics() const SIP_SKIP { return mPerLayerRenderingStatistics; }
+
+    /**
+     * Returns the rendering statistics of the layers and the labeling time as a JSON document
+     * in the Chrome trace event format, which can be loaded in chrome://tracing or Perfetto.
+     * Each layer is shown as a separate thread, with its fetching, drawing and labeling phases.
+     * \see perLayerRenderingStatistics()
+     * \since QGIS 3.16
+     */
+    QByteArray renderingStatisticsChromeTrace() const;
+
     /**
      * Returns map settings with which this job was started.
      * \returns A QgsMapSettings instance with render settings
@@ -296,6 +334,14 @@ class CORE_EXPORT QgsMapRendererJob : public QObject
      */
     static const QString LABEL_CACHE_ID SIP_SKIP;
 
+    /**
+     * Minimum time in milliseconds of the last rendering of a layer for which a preview
+     * is drawn with the QgsMapSettings::ProgressiveRendering flag.
+     * \note not available in Python bindings
+     * \since QGIS 3.16
+     */
+    static const int PROGRESSIVE_RENDERING_THRESHOLD SIP_SKIP = 500;
+
   signals:
 
     /**
@@ -323,6 +369,12 @@ class CORE_EXPORT QgsMapRendererJob : public QObject
     //! Render time (in ms) per layer, by layer ID
     QHash< QgsWeakMapLayerPointer, int > mPerLayerRenderingTime;
 
+    //! Label render time (in ms)
+    int mLabelingTime = -1;
+
+    //! Rendering statistics per layer, by layer ID
+    QHash< QString, QgsMapLayerRenderingStatistics > mPerLayerRenderingStatistics;
+
     /**
      * TRUE if layer rendering time should be recorded.
      */
@@ -402,6 +454,14 @@ class CORE_EXPORT QgsMapRendererJob : public QObject
     //! \note not available in Python bindings
     static void drawLabeling( QgsRenderContext &renderContext, QgsLabelingEngine *labelingEngine2, QPainter *painter ) SIP_SKIP;
 
+    /**
+     * Fills the image of a layer \a job with transparent pixels and draws the part
+     * of the previous image of the layer which is reused, if any.
+     * \note not available in Python bindings
+     * \since QGIS 3.16
+     */
+    static void initializeLayerImage( LayerRenderJob &job ) SIP_SKIP;
+
   private:
 
     /**
@@ -415,6 +475,14 @@ class CORE_EXPORT QgsMapRendererJob : public QObject
 
     bool needTemporaryImage( QgsMapLayer *ml );
 
+    /**
+     * Returns the image of the vector layer \a vl cached for the previous extent, if it
+     * can be reused for the current extent: same resolution and shifted by whole pixels.
+     * Sets \a rect to the area of the map covered by the image, in logical pixels, and
+     * \a uncoveredExtent to the map extent which must be rendered again.
+     */
+    QImage previousLayerImage( QgsVectorLayer *vl, QRect &rect, QgsRectangle &uncoveredExtent ) const;
+
     const QgsFeatureFilterProvider *mFeatureFilterProvider = nullptr;
 
     //! Convenient method to allocate a new image and stack an error if not enough memory is available
@@ -422,6 +490,9 @@ class CORE_EXPORT QgsMapRendererJob : public QObject
 
     //! Convenient method to allocate a new image and a new QPainter on this image
     QPainter *allocateImageAndPainter( QString layerId, QImage *&image );
+
+    //! Counters of the hot paths during the rendering, in instrumented builds
+    std::unique_ptr< QgsHotPathInstrumentation::Scope > mInstrumentationScope;
 };
 
 
@@ -341,8 +341,7 @@ void QgsMapRendererParallelJob::renderLayerStatic( LayerRenderJob &job )
 
   if ( job.img )
   {
-    job.img->fill( 0 );
-    job.imageInitialized = true;
+    initializeLayerImage( job );
   }
 
   QElapsedTimer t;
@@ -314,6 +314,13 @@ class CORE_EXPORT QgsMapSettings : public QgsTemporalRangeObject
       RenderBlocking           = 0x800, //!< Render and load remote sources in the same thread to ensure rendering remote sources (svg and images). WARNING: this flag must NEVER be used from GUI based applications (like the main QGIS application) or crashes will result. Only for use in external scripts or QGIS server.
       LosslessImageRendering   = 0x1000, //!< Render images losslessly whenever possible, instead of the default lossy jpeg rendering used for some destination devices (e.g. PDF). This flag only works with builds based on Qt 5.13 or later.
       Render3DMap              = 0x2000, //!< Render is for a 3D map
+      ParallelFeatureRendering = 0x4000, //!< Render the features of each vector layer with several threads, each one drawing a horizontal band of the map image. Only applies to layers which can be rendered this way. Added in QGIS 3.16
+      GpuRendering             = 0x8000, //!< Draw the features of vector layers with OpenGL in an offscreen framebuffer, when an OpenGL context is available and the layer only uses simple fill, line and marker symbol layers. Added in QGIS 3.16
+      ProgressiveRendering     = 0x10000, //!< Draw a simplified preview of the vector layers which were slow to render the last time, before drawing them in full. Requires a QgsMapRendererCache. Added in QGIS 3.16
+      ApproximateReprojection  = 0x20000, //!< Reproject the vertices of vector layers by interpolation in a grid of the map extent, within a quarter of a pixel of the exact transform. Added in QGIS 3.16
+      ParallelRasterRendering  = 0x40000, //!< Render each raster layer with several threads, each one drawing a horizontal band of the layer with its own copy of the raster pipe. Only applies to layers read from local data. Added in QGIS 3.16
+      RecordRenderingStatistics = 0x80000, //!< Record the time spent to fetch, draw and label the features of each layer, available from QgsMapRendererJob::perLayerRenderingStatistics(). Added in QGIS 3.16
+      PrefetchTiles            = 0x100000, //!< Request the tiles around the map extent of tiled remote layers in the background, for when an interactive map canvas is panned. Added in QGIS 3.16
       // TODO: ignore scale-based visibility (overview)
     };
     Q_DECLARE_FLAGS( Flags, Flag )
@@ -26,6 +26,9 @@
 #include "qgslinestring.h"
 #include "qgspolygon.h"
 #include "qgsgeometrycollection.h"
+#include "qgsmultilinestring.h"
+#include "qgsmultipolygon.h"
+#include "qgswkbgeometryview.h"
 
 QgsMapToPixelSimplifier::QgsMapToPixelSimplifier( int simplifyFlags, double tolerance, SimplifyAlgorithm simplifyAlgorithm )
   : mSimplifyFlags( simplifyFlags )
@@ -67,6 +70,85 @@ bool QgsMapToPixelSimplifier::equalSnapToGrid( double x1, double y1, double x2,
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 
+//! Returns the BBOX as a line string: one segment, or a closed rectangle for rings
+static std::unique_ptr< QgsLineString > boundingBoxLineString( const QgsRectangle &envelope, bool isRing )
+{
+  const double x1 = envelope.xMinimum();
+  const double y1 = envelope.yMinimum();
+  const double x2 = envelope.xMaximum();
+  const double y2 = envelope.yMaximum();
+
+  if ( !isRing )
+    return qgis::make_unique< QgsLineString >( QVector<double>() << x1 << x2, QVector<double>() << y1 << y2 );
+
+  return qgis::make_unique< QgsLineString >(
+           QVector< double >() << x1
+           << x2
+           << x2
+           << x1
+           << x1,
+           QVector< double >() << y1
+           << y1
+           << y2
+           << y2
+           << y1 );
+}
+
+/**
+ * Makes sure a simplified linear ring is closed, \a lastX and \a lastY being its last kept vertex.
+ * Returns FALSE if the curve was simplified too much to be valid.
+ */
+static bool closeSimplifiedCurve( QgsCurve &output, bool isaLinearRing, double lastX, double lastY )
+{
+  if ( output.numPoints() < ( isaLinearRing ? 4 : 2 ) )
+    return false;
+
+  if ( isaLinearRing )
+  {
+    // make sure we keep the linear ring closed
+    if ( !qgsDoubleNear( lastX, output.xAt( 0 ) ) || !qgsDoubleNear( lastY, output.yAt( 0 ) ) )
+    {
+      output.insertVertex( QgsVertexId( 0, 0, output.numPoints() ), QgsPoint( output.xAt( 0 ), output.yAt( 0 ) ) );
+    }
+  }
+  return true;
+}
+
+template< typename VertexReader, typename VertexWriter >
+bool QgsMapToPixelSimplifier::simplifyVertices( int numPoints, VertexReader vertexAt, VertexWriter appendVertex, SimplifyAlgorithm simplifyAlgorithm, const QgsRectangle &envelope, double map2pixelTol, bool isGeneralizable, bool isaLinearRing, double &lastX, double &lastY )
+{
+  const double gridOriginX = envelope.xMinimum();
+  const double gridOriginY = envelope.yMinimum();
+
+  // Use a factor for the maximum displacement distance for simplification, similar as GeoServer does
+  const float gridInverseSizeXY = map2pixelTol != 0 ? ( float )( 1.0f / ( 0.8 * map2pixelTol ) ) : 0.0f;
+
+  const double squaredTol = map2pixelTol * map2pixelTol; //-> Use mappixelTol for 'LengthSquare' calculations.
+
+  bool hasLongSegments = false;
+  double x = 0.0, y = 0.0;
+  for ( int i = 0; i < numPoints; ++i )
+  {
+    vertexAt( i, x, y );
+
+    bool isLongSegment = false;
+
+    if ( i == 0 ||
+         !isGeneralizable ||
+         ( simplifyAlgorithm == SnapToGrid ? !equalSnapToGrid( x, y, lastX, lastY, gridOriginX, gridOriginY, gridInverseSizeXY )
+           : ( isLongSegment = ( calculateLengthSquared2D( x, y, lastX, lastY ) > squaredTol ) ) ) ||
+         ( !isaLinearRing && ( i == 1 || i >= numPoints - 2 ) ) )
+    {
+      appendVertex( x, y );
+      lastX = x;
+      lastY = y;
+
+      hasLongSegments |= isLongSegment;
+    }
+  }
+  return hasLongSegments;
+}
+
 //! Generalize the WKB-geometry using the BBOX of the original geometry
 static std::unique_ptr< QgsAbstractGeometry > generalizeWkbGeometryByBoundingBox(
   QgsWkbTypes::Type wkbType,
@@ -84,29 +166,14 @@ static std::unique_ptr< QgsAbstractGeometry > generalizeWkbGeometryByBoundingBox
     return std::unique_ptr< QgsAbstractGeometry >( geometry.clone() );
   }
 
-  const double x1 = envelope.xMinimum();
-  const double y1 = envelope.yMinimum();
-  const double x2 = envelope.xMaximum();
-  const double y2 = envelope.yMaximum();
-
   // Write the generalized geometry
   if ( geometryType == QgsWkbTypes::LineString && !isRing )
   {
-    return qgis::make_unique< QgsLineString >( QVector<double>() << x1 << x2, QVector<double>() << y1 << y2 );
+    return boundingBoxLineString( envelope, false );
   }
   else
   {
-    std::unique_ptr< QgsLineString > ext = qgis::make_unique< QgsLineString >(
-        QVector< double >() << x1
-        << x2
-        << x2
-        << x1
-        << x1,
-        QVector< double >() << y1
-        << y1
-        << y2
-        << y2
-        << y1 );
+    std::unique_ptr< QgsLineString > ext = boundingBoxLineString( envelope, true );
     if ( geometryType == QgsWkbTypes::LineString )
       return std::move( ext );
     else
@@ -161,12 +228,11 @@ std::unique_ptr< QgsAbstractGeometry > QgsMapToPixelSimplifier::simplifyGeometry
       output.reset( qgsgeometry_cast< QgsCurve * >( srcCurve.createEmptyWithSameType() ) );
     }
 
-    double x = 0.0, y = 0.0, lastX = 0.0, lastY = 0.0;
+    double lastX = 0.0, lastY = 0.0;
 
     if ( numPoints <= ( isaLinearRing ? 4 : 2 ) )
       isGeneralizable = false;
 
-    bool isLongSegment;
     bool hasLongSegments = false; //-> To avoid replace the simplified geometry by its BBOX when there are 'long' segments.
 
     // Check whether the LinearRing is really closed.
@@ -180,13 +246,8 @@ std::unique_ptr< QgsAbstractGeometry > QgsMapToPixelSimplifier::simplifyGeometry
     switch ( simplifyAlgorithm )
     {
       case SnapToGrid:
+      case Distance:
       {
-        double gridOriginX = envelope.xMinimum();
-        double gridOriginY = envelope.yMinimum();
-
-        // Use a factor for the maximum displacement distance for simplification, similar as GeoServer does
-        float gridInverseSizeXY = map2pixelTol != 0 ? ( float )( 1.0f / ( 0.8 * map2pixelTol ) ) : 0.0f;
-
         const double *xData = nullptr;
         const double *yData = nullptr;
         if ( flatType == QgsWkbTypes::LineString )
@@ -195,35 +256,30 @@ std::unique_ptr< QgsAbstractGeometry > QgsMapToPixelSimplifier::simplifyGeometry
           yData = qgsgeometry_cast< const QgsLineString * >( &srcCurve )->yData();
         }
 
-        for ( int i = 0; i < numPoints; ++i )
+        auto vertexAt = [&]( int i, double & x, double & y )
         {
           if ( xData && yData )
           {
-            x = *xData++;
-            y = *yData++;
+            x = xData[i];
+            y = yData[i];
           }
           else
           {
             x = srcCurve.xAt( i );
             y = srcCurve.yAt( i );
           }
-
-          if ( i == 0 ||
-               !isGeneralizable ||
-               !equalSnapToGrid( x, y, lastX, lastY, gridOriginX, gridOriginY, gridInverseSizeXY ) ||
-               ( !isaLinearRing && ( i == 1 || i >= numPoints - 2 ) ) )
+        };
+        auto appendVertex = [&]( double x, double y )
+        {
+          if ( output )
+            output->insertVertex( QgsVertexId( 0, 0, output->numPoints() ), QgsPoint( x, y ) );
+          else
           {
-            if ( output )
-              output->insertVertex( QgsVertexId( 0, 0, output->numPoints() ), QgsPoint( x, y ) );
-            else
-            {
-              lineStringX.append( x );
-              lineStringY.append( y );
-            }
-            lastX = x;
-            lastY = y;
+            lineStringX.append( x );
+            lineStringY.append( y );
           }
-        }
+        };
+        hasLongSegments = simplifyVertices( numPoints, vertexAt, appendVertex, simplifyAlgorithm, envelope, map2pixelTol, isGeneralizable, isaLinearRing, lastX, lastY );
         break;
       }
 
@@ -257,60 +313,13 @@ std::unique_ptr< QgsAbstractGeometry > QgsMapToPixelSimplifier::simplifyGeometry
         }
         break;
       }
-
-      case Distance:
-      {
-        map2pixelTol *= map2pixelTol; //-> Use mappixelTol for 'LengthSquare' calculations.
-
-        const double *xData = nullptr;
-        const double *yData = nullptr;
-        if ( flatType == QgsWkbTypes::LineString )
-        {
-          xData = qgsgeometry_cast< const QgsLineString * >( &srcCurve )->xData();
-          yData = qgsgeometry_cast< const QgsLineString * >( &srcCurve )->yData();
-        }
-
-        for ( int i = 0; i < numPoints; ++i )
-        {
-          if ( xData && yData )
-          {
-            x = *xData++;
-            y = *yData++;
-          }
-          else
-          {
-            x = srcCurve.xAt( i );
-            y = srcCurve.yAt( i );
-          }
-
-          isLongSegment = false;
-
-          if ( i == 0 ||
-               !isGeneralizable ||
-               ( isLongSegment = ( calculateLengthSquared2D( x, y, lastX, lastY ) > map2pixelTol ) ) ||
-               ( !isaLinearRing && ( i == 1 || i >= numPoints - 2 ) ) )
-          {
-            if ( output )
-              output->insertVertex( QgsVertexId( 0, 0, output->numPoints() ), QgsPoint( x, y ) );
-            else
-            {
-              lineStringX.append( x );
-              lineStringY.append( y );
-            }
-            lastX = x;
-            lastY = y;
-
-            hasLongSegments |= isLongSegment;
-          }
-        }
-      }
     }
 
     if ( !output )
     {
       output = qgis::make_unique< QgsLineString >( lineStringX, lineStringY );
     }
-    if ( output->numPoints() < ( isaLinearRing ? 4 : 2 ) )
+    if ( !closeSimplifiedCurve( *output, isaLinearRing, lastX, lastY ) )
     {
       // we simplified the geometry too much!
       if ( !hasLongSegments )
@@ -328,15 +337,6 @@ std::unique_ptr< QgsAbstractGeometry > QgsMapToPixelSimplifier::simplifyGeometry
       }
     }
 
-    if ( isaLinearRing )
-    {
-      // make sure we keep the linear ring closed
-      if ( !qgsDoubleNear( lastX, output->xAt( 0 ) ) || !qgsDoubleNear( lastY, output->yAt( 0 ) ) )
-      {
-        output->insertVertex( QgsVertexId( 0, 0, output->numPoints() ), QgsPoint( output->xAt( 0 ), output->yAt( 0 ) ) );
-      }
-    }
-
     return std::move( output );
   }
   else if ( flatType == QgsWkbTypes::Polygon )
@@ -415,3 +415,157 @@ QgsGeometry QgsMapToPixelSimplifier::simplify( const QgsGeometry &geometry ) con
 
   return QgsGeometry( simplifyGeometry( mSimplifyFlags, mSimplifyAlgorithm, *geometry.constGet(), mTolerance, false ) );
 }
+
+std::unique_ptr<QgsLineString> QgsMapToPixelSimplifier::simplifyRing( int simplifyFlags, SimplifyAlgorithm simplifyAlgorithm, const QgsWkbGeometryView &view, int part, int ring, double map2pixelTol, bool isaLinearRing )
+{
+  // the line string branch of simplifyGeometry(), reading the vertices from the view
+  const int numPoints = view.pointCount( part, ring );
+  const QgsRectangle envelope = view.boundingBox( part, ring );
+  const bool isRing = isaLinearRing;
+
+  auto generalizeByBoundingBox = [&]
+  {
+    if ( numPoints <= 2 )
+      return view.lineString( part, ring );
+    return boundingBoxLineString( envelope, isRing );
+  };
+
+  if ( ( simplifyFlags & QgsMapToPixelSimplifier::SimplifyEnvelope ) &&
+       isGeneralizableByMapBoundingBox( envelope, map2pixelTol ) )
+  {
+    return generalizeByBoundingBox();
+  }
+
+  const bool isGeneralizable = ( simplifyFlags & QgsMapToPixelSimplifier::SimplifyGeometry ) && numPoints > ( isaLinearRing ? 4 : 2 );
+
+  // Check whether the LinearRing is really closed.
+  if ( isaLinearRing )
+  {
+    isaLinearRing = numPoints > 0 &&
+                    qgsDoubleNear( view.x( part, ring, 0 ), view.x( part, ring, numPoints - 1 ) ) &&
+                    qgsDoubleNear( view.y( part, ring, 0 ), view.y( part, ring, numPoints - 1 ) );
+  }
+
+  QVector< double > lineStringX;
+  QVector< double > lineStringY;
+  lineStringX.reserve( numPoints );
+  lineStringY.reserve( numPoints );
+
+  auto vertexAt = [&]( int i, double & x, double & y )
+  {
+    x = view.x( part, ring, i );
+    y = view.y( part, ring, i );
+  };
+  auto appendVertex = [&]( double x, double y )
+  {
+    lineStringX.append( x );
+    lineStringY.append( y );
+  };
+  double lastX = 0.0, lastY = 0.0;
+  const bool hasLongSegments = simplifyVertices( numPoints, vertexAt, appendVertex, simplifyAlgorithm, envelope, map2pixelTol, isGeneralizable, isaLinearRing, lastX, lastY );
+
+  std::unique_ptr< QgsLineString > output = qgis::make_unique< QgsLineString >( lineStringX, lineStringY );
+  if ( !closeSimplifiedCurve( *output, isaLinearRing, lastX, lastY ) )
+  {
+    // we simplified the geometry too much!
+    if ( !hasLongSegments )
+      return generalizeByBoundingBox();
+    else
+      return view.lineString( part, ring );
+  }
+
+  return output;
+}
+
+QgsGeometry QgsMapToPixelSimplifier::simplify( const QgsWkbGeometryView &view ) const
+{
+  if ( !view.isValid() || mSimplifyFlags == QgsMapToPixelSimplifier::NoFlags ||
+       ( mSimplifyAlgorithm != Distance && mSimplifyAlgorithm != SnapToGrid ) )
+  {
+    return simplify( view.toGeometry() );
+  }
+
+  const QgsWkbTypes::Type flatType = QgsWkbTypes::flatType( QgsWkbTypes::singleType( view.wkbType() ) );
+  if ( flatType != QgsWkbTypes::LineString && flatType != QgsWkbTypes::Polygon )
+  {
+    // points and triangles are not simplified by the view
+    return simplify( view.toGeometry() );
+  }
+
+  const bool isaLinearRing = flatType == QgsWkbTypes::Polygon;
+  const int numPoints = view.nCoordinates();
+
+  if ( numPoints <= ( isaLinearRing ? 6 : 3 ) )
+  {
+    // No simplify simple geometries
+    return view.toGeometry();
+  }
+
+  const QgsRectangle envelope = view.boundingBox();
+  if ( std::max( envelope.width(), envelope.height() ) / numPoints > mTolerance * 2.0 )
+  {
+    //points are in average too far apart to lead to any significant simplification
+    return view.toGeometry();
+  }
+
+  // Can replace the geometry by its BBOX ?
+  if ( ( mSimplifyFlags & QgsMapToPixelSimplifier::SimplifyEnvelope ) &&
+       isGeneralizableByMapBoundingBox( envelope, mTolerance ) )
+  {
+    std::unique_ptr< QgsLineString > ext = boundingBoxLineString( envelope, isaLinearRing );
+    if ( !isaLinearRing )
+      return QgsGeometry( std::move( ext ) );
+    std::unique_ptr< QgsPolygon > polygon = qgis::make_unique< QgsPolygon >();
+    polygon->setExteriorRing( ext.release() );
+    return QgsGeometry( std::move( polygon ) );
+  }
+
+  const bool isMulti = QgsWkbTypes::isMultiType( view.wkbType() );
+  auto simplifyPart = [this, &view, isaLinearRing, isMulti]( int part ) -> std::unique_ptr< QgsAbstractGeometry >
+  {
+    if ( !isaLinearRing )
+      return simplifyRing( mSimplifyFlags, mSimplifyAlgorithm, view, part, 0, mTolerance, false );
+
+    std::unique_ptr< QgsPolygon > polygon = qgis::make_unique< QgsPolygon >();
+    const int ringCount = view.ringCount( part );
+
+    // parts of collections are generalized by their own BBOX, like whole polygons
+    if ( isMulti && ringCount > 0 && ( mSimplifyFlags & QgsMapToPixelSimplifier::SimplifyEnvelope ) &&
+         isGeneralizableByMapBoundingBox( view.boundingBox( part, 0 ), mTolerance ) )
+    {
+      int partPoints = 0;
+      for ( int ring = 0; ring < ringCount; ++ring )
+        partPoints += view.pointCount( part, ring );
+      if ( partPoints > 5 )
+      {
+        polygon->setExteriorRing( boundingBoxLineString( view.boundingBox( part, 0 ), true ).release() );
+      }
+      else
+      {
+        polygon->setExteriorRing( view.lineString( part, 0 ).release() );
+        for ( int ring = 1; ring < ringCount; ++ring )
+          polygon->addInteriorRing( view.lineString( part, ring ).release() );
+      }
+      return std::move( polygon );
+    }
+
+    if ( ringCount > 0 )
+      polygon->setExteriorRing( simplifyRing( mSimplifyFlags, mSimplifyAlgorithm, view, part, 0, mTolerance, true ).release() );
+    for ( int ring = 1; ring < ringCount; ++ring )
+      polygon->addInteriorRing( simplifyRing( mSimplifyFlags, mSimplifyAlgorithm, view, part, ring, mTolerance, true ).release() );
+    return std::move( polygon );
+  };
+
+  if ( !isMulti )
+    return QgsGeometry( simplifyPart( 0 ) );
+
+  std::unique_ptr< QgsGeometryCollection > collection;
+  if ( isaLinearRing )
+    collection = qgis::make_unique< QgsMultiPolygon >();
+  else
+    collection = qgis::make_unique< QgsMultiLineString >();
+  collection->reserve( view.partCount() );
+  for ( int part = 0; part < view.partCount(); ++part )
+    collection->addGeometry( simplifyPart( part ).release() );
+  return QgsGeometry( std::move( collection ) );
+}
@@ -24,8 +24,10 @@
 #include <memory>
 
 class QgsAbstractGeometry;
+class QgsLineString;
 class QgsWkbPtr;
 class QgsConstWkbPtr;
+class QgsWkbGeometryView;
 
 
 /**
@@ -62,6 +64,20 @@ class CORE_EXPORT QgsMapToPixelSimplifier : public QgsAbstractGeometrySimplifier
     //! Simplify the geometry using the specified tolerance
     static std::unique_ptr<QgsAbstractGeometry> simplifyGeometry( int simplifyFlags, SimplifyAlgorithm simplifyAlgorithm, const QgsAbstractGeometry &geometry, double map2pixelTol, bool isaLinearRing );
 
+    //! Simplify a ring of a WKB geometry view using the specified tolerance
+    static std::unique_ptr<QgsLineString> simplifyRing( int simplifyFlags, SimplifyAlgorithm simplifyAlgorithm, const QgsWkbGeometryView &view, int part, int ring, double map2pixelTol, bool isaLinearRing ) SIP_SKIP;
+
+#ifndef SIP_RUN
+
+    /**
+     * Passes to \a appendVertex( x, y ) the vertices of a line string or a ring kept by the Distance or
+     * SnapToGrid \a simplifyAlgorithm. The \a numPoints vertices are read with \a vertexAt( i, x, y ).
+     * Sets \a lastX and \a lastY to the last kept vertex, and returns TRUE if long segments were kept.
+     */
+    template< typename VertexReader, typename VertexWriter >
+    static bool simplifyVertices( int numPoints, VertexReader vertexAt, VertexWriter appendVertex, SimplifyAlgorithm simplifyAlgorithm, const QgsRectangle &envelope, double map2pixelTol, bool isGeneralizable, bool isaLinearRing, double &lastX, double &lastY );
+#endif
+
   protected:
     //! Current simplification flags
     int mSimplifyFlags;
@@ -92,6 +108,19 @@ class CORE_EXPORT QgsMapToPixelSimplifier : public QgsAbstractGeometrySimplifier
     //! Returns a simplified version the specified geometry
     QgsGeometry simplify( const QgsGeometry &geometry ) const override;
 
+    /**
+     * Returns a simplified version of the geometry viewed by \a view.
+     *
+     * Line strings and polygons are simplified by reading their vertices straight from the WKB,
+     * so only the simplified geometry is built. The result is the same as simplifying the
+     * full geometry, to which this falls back for the Visvalingam and SnappedToGridGlobal
+     * algorithms and for views of unsupported geometry types.
+     *
+     * \note not available in Python bindings
+     * \since QGIS 3.16
+     */
+    QgsGeometry simplify( const QgsWkbGeometryView &view ) const SIP_SKIP;
+
     //! Sets the tolerance of the vector layer managed
     void setTolerance( double value ) { mTolerance = value; }
 
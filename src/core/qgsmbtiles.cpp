@@ -189,24 +189,70 @@ void QgsMbTiles::setTileData( int z, int x, int y, const QByteArray &data )
     return;
   }
 
-  int result;
-  QString sql = QStringLiteral( "insert into tiles values (%1, %2, %3, ?)" ).arg( z ).arg( x ).arg( y );
-  sqlite3_statement_unique_ptr preparedStatement = mDatabase.prepare( sql, result );
-  if ( result != SQLITE_OK )
+  if ( !mInsertTileStatement )
   {
-    QgsDebugMsg( QStringLiteral( "MBTile failed to prepare statement: " ) + sql );
-    return;
+    int result;
+    QString sql = QStringLiteral( "insert into tiles values (?, ?, ?, ?)" );
+    mInsertTileStatement = mDatabase.prepare( sql, result );
+    if ( result != SQLITE_OK )
+    {
+      QgsDebugMsg( QStringLiteral( "MBTile failed to prepare statement: " ) + sql );
+      mInsertTileStatement.reset();
+      return;
+    }
   }
 
-  sqlite3_bind_blob( preparedStatement.get(), 1, data.constData(), data.size(), SQLITE_TRANSIENT );
+  sqlite3_reset( mInsertTileStatement.get() );
+  sqlite3_bind_int( mInsertTileStatement.get(), 1, z );
+  sqlite3_bind_int( mInsertTileStatement.get(), 2, x );
+  sqlite3_bind_int( mInsertTileStatement.get(), 3, y );
+  sqlite3_bind_blob( mInsertTileStatement.get(), 4, data.constData(), data.size(), SQLITE_TRANSIENT );
 
-  if ( preparedStatement.step() != SQLITE_DONE )
+  if ( mInsertTileStatement.step() != SQLITE_DONE )
   {
     QgsDebugMsg( QStringLiteral( "MBTile tile failed to be set: %1,%2,%3" ).arg( z ).arg( x ).arg( y ) );
     return;
   }
 }
 
+bool QgsMbTiles::beginTransaction()
+{
+  if ( !mDatabase )
+  {
+    QgsDebugMsg( QStringLiteral( "MBTiles database not open: " ) + mFilename );
+    return false;
+  }
+
+  QString errorMessage;
+  if ( mDatabase.exec( QStringLiteral( "BEGIN" ), errorMessage ) != SQLITE_OK )
+  {
+    QgsDebugMsg( QStringLiteral( "MBTile failed to begin transaction: " ) + errorMessage );
+    return false;
+  }
+  return true;
+}
+
+bool QgsMbTiles::commitTransaction()
+{
+  if ( !mDatabase )
+  {
+    QgsDebugMsg( QStringLiteral( "MBTiles database not open: " ) + mFilename );
+    return false;
+  }
+
+  // the insert statement must not be running any more when the transaction is committed
+  if ( mInsertTileStatement )
+    sqlite3_reset( mInsertTileStatement.get() );
+
+  QString errorMessage;
+  if ( mDatabase.exec( QStringLiteral( "COMMIT" ), errorMessage ) != SQLITE_OK )
+  {
+    QgsDebugMsg( QStringLiteral( "MBTile failed to commit transaction: " ) + errorMessage );
+    return false;
+  }
+  return true;
+}
+
 bool QgsMbTiles::decodeGzip( const QByteArray &bytesIn, QByteArray &bytesOut )
 {
   unsigned char *bytesInPtr = reinterpret_cast<unsigned char *>( const_cast<char *>( bytesIn.constData() ) );
@@ -78,6 +78,20 @@ class CORE_EXPORT QgsMbTiles
      */
     void setTileData( int z, int x, int y, const QByteArray &data );
 
+    /**
+     * Starts a transaction, so that the tiles added until commitTransaction() is called are
+     * written at once, which is much faster than writing each tile in its own transaction.
+     * Returns true on success.
+     * \since QGIS 3.16
+     */
+    bool beginTransaction();
+
+    /**
+     * Commits the transaction started with beginTransaction(). Returns true on success.
+     * \since QGIS 3.16
+     */
+    bool commitTransaction();
+
     //! Decodes gzip byte stream, returns true on success. Useful for reading vector tiles.
     static bool decodeGzip( const QByteArray &bytesIn, QByteArray &bytesOut );
     //! Encodes gzip byte stream, returns true on success. Useful for writing vector tiles.
@@ -86,6 +100,8 @@ class CORE_EXPORT QgsMbTiles
   private:
     QString mFilename;
     sqlite3_database_unique_ptr mDatabase;
+    //! Statement inserting tiles, prepared once and reused for all the tiles
+    sqlite3_statement_unique_ptr mInsertTileStatement;
 };
 
 
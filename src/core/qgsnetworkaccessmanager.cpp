@@ -30,6 +30,7 @@
 #include "qgsauthmanager.h"
 #include "qgsnetworkreply.h"
 #include "qgsblockingnetworkrequest.h"
+#include "qgsfeedback.h"
 
 #include <QUrl>
 #include <QTimer>
@@ -38,6 +39,13 @@
 #include <QThreadStorage>
 #include <QAuthenticator>
 #include <QStandardPaths>
+#include <QDateTime>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QPointer>
+
+#include <algorithm>
+#include <memory>
 
 #ifndef QT_NO_SSL
 #include <QSslConfiguration>
@@ -224,6 +232,13 @@ QNetworkReply *QgsNetworkAccessManager::createRequest( QNetworkAccessManager::Op
   userAgent += QStringLiteral( "QGIS/%1" ).arg( Qgis::versionInt() );
   pReq->setRawHeader( "User-Agent", userAgent.toLatin1() );
 
+#if QT_VERSION >= QT_VERSION_CHECK( 5, 15, 0 )
+  // HTTP/2 multiplexes the requests to a host over a single connection, servers which
+  // do not support it are still queried with HTTP/1.1
+  if ( !pReq->attribute( QNetworkRequest::Http2AllowedAttribute ).isValid() )
+    pReq->setAttribute( QNetworkRequest::Http2AllowedAttribute, s.value( QStringLiteral( "/qgis/networkAndProxy/http2Allowed" ), true ).toBool() );
+#endif
+
 #ifndef QT_NO_SSL
   bool ishttps = pReq->url().scheme().compare( QLatin1String( "https" ), Qt::CaseInsensitive ) == 0;
   if ( ishttps && !QgsApplication::authManager()->isDisabled() )
@@ -263,6 +278,7 @@ QNetworkReply *QgsNetworkAccessManager::createRequest( QNetworkAccessManager::Op
   Q_NOWARN_DEPRECATED_POP
   QNetworkReply *reply = QNetworkAccessManager::createRequest( op, req, outgoingData );
   reply->setProperty( "requestId", requestId );
+  reply->setProperty( "requestStartTime", QDateTime::currentMSecsSinceEpoch() );
 
   Q_NOWARN_DEPRECATED_PUSH
   emit requestCreated( reply );
@@ -649,12 +665,87 @@ void QgsNetworkAccessManager::setTimeout( const int time )
   QgsSettings().setValue( QStringLiteral( "/qgis/networkAndProxy/networkTimeout" ), time );
 }
 
+///@cond PRIVATE
+class QgsInFlightNetworkRequests
+{
+  public:
+
+    struct Request
+    {
+      bool finished = false;
+      bool canceled = false;
+      QgsNetworkReplyContent reply;
+    };
+
+    QMutex mutex;
+    QWaitCondition finishedCondition;
+    QHash< QString, std::shared_ptr< Request > > requests;
+};
+///@endcond
+
+Q_GLOBAL_STATIC( QgsInFlightNetworkRequests, sInFlightRequests )
+
+static QString inFlightRequestKey( const QNetworkRequest &request, const QString &authCfg, bool forceRefresh )
+{
+  QStringList key;
+  key << request.url().toString( QUrl::FullyEncoded ) << authCfg << QString::number( forceRefresh )
+      << request.attribute( QNetworkRequest::CacheLoadControlAttribute ).toString();
+  QList<QByteArray> headers = request.rawHeaderList();
+  std::sort( headers.begin(), headers.end() );
+  for ( const QByteArray &header : qgis::as_const( headers ) )
+    key << QString::fromUtf8( header + ": " + request.rawHeader( header ) );
+  return key.join( QLatin1Char( '\n' ) );
+}
+
 QgsNetworkReplyContent QgsNetworkAccessManager::blockingGet( QNetworkRequest &request, const QString &authCfg, bool forceRefresh, QgsFeedback *feedback )
 {
-  QgsBlockingNetworkRequest br;
-  br.setAuthCfg( authCfg );
-  br.get( request, forceRefresh, feedback );
-  return br.reply();
+  auto performRequest = [&request, &authCfg, forceRefresh, feedback]
+  {
+    QgsBlockingNetworkRequest br;
+    br.setAuthCfg( authCfg );
+    br.get( request, forceRefresh, feedback );
+    return br.reply();
+  };
+
+  // the main thread never waits for the request of another thread, which may need it
+  // to handle authentication or SSL errors
+  if ( !QCoreApplication::instance() || QThread::currentThread() == QCoreApplication::instance()->thread() )
+    return performRequest();
+
+  // identical requests issued concurrently by worker threads share the reply of the first one
+  const QString key = inFlightRequestKey( request, authCfg, forceRefresh );
+  QgsInFlightNetworkRequests *inFlightRequests = sInFlightRequests();
+  QMutexLocker locker( &inFlightRequests->mutex );
+  std::shared_ptr< QgsInFlightNetworkRequests::Request > inFlight = inFlightRequests->requests.value( key );
+  if ( inFlight )
+  {
+    while ( !inFlight->finished )
+    {
+      if ( feedback && feedback->isCanceled() )
+        return QgsNetworkReplyContent();
+      inFlightRequests->finishedCondition.wait( &inFlightRequests->mutex, 100 );
+    }
+    // the other request may have been canceled by its own feedback
+    if ( !inFlight->canceled )
+      return inFlight->reply;
+
+    locker.unlock();
+    return performRequest();
+  }
+
+  inFlight = std::make_shared< QgsInFlightNetworkRequests::Request >();
+  inFlightRequests->requests.insert( key, inFlight );
+  locker.unlock();
+
+  const QgsNetworkReplyContent reply = performRequest();
+
+  locker.relock();
+  inFlight->reply = reply;
+  inFlight->canceled = feedback && feedback->isCanceled();
+  inFlight->finished = true;
+  inFlightRequests->requests.remove( key );
+  inFlightRequests->finishedCondition.wakeAll();
+  return reply;
 }
 
 QgsNetworkReplyContent QgsNetworkAccessManager::blockingPost( QNetworkRequest &request, const QByteArray &data, const QString &authCfg, bool forceRefresh, QgsFeedback *feedback )
@@ -665,6 +756,45 @@ QgsNetworkReplyContent QgsNetworkAccessManager::blockingPost( QNetworkRequest &r
   return br.reply();
 }
 
+int QgsNetworkAccessManager::asyncGet( const QNetworkRequest &request, const QString &authCfg, QObject *context, const std::function< void( const QgsNetworkReplyContent & ) > &callback, QgsFeedback *feedback )
+{
+  Q_ASSERT( context && context->thread() == QThread::currentThread() );
+
+  QNetworkRequest req( request );
+  if ( !authCfg.isEmpty() && !QgsApplication::authManager()->updateNetworkRequest( req, authCfg ) )
+  {
+    QgsMessageLog::logMessage( tr( "network request update failed for authentication config" ), tr( "Network" ) );
+    return -1;
+  }
+  if ( !req.attribute( QNetworkRequest::RedirectPolicyAttribute ).isValid() )
+    req.setAttribute( QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::NoLessSafeRedirectPolicy );
+
+  QNetworkReply *reply = instance()->get( req );
+  if ( !authCfg.isEmpty() && !QgsApplication::authManager()->updateNetworkReply( reply, authCfg ) )
+  {
+    reply->abort();
+    reply->deleteLater();
+    QgsMessageLog::logMessage( tr( "network reply update failed for authentication config" ), tr( "Network" ) );
+    return -1;
+  }
+
+  // guards are cleared before the destroyed signal is emitted
+  QPointer< QObject > guard( context );
+  connect( reply, &QNetworkReply::finished, context, [reply, guard, callback]
+  {
+    QgsNetworkReplyContent content( reply );
+    content.setContent( reply->readAll() );
+    reply->deleteLater();
+    if ( guard )
+      callback( content );
+  } );
+  connect( context, &QObject::destroyed, reply, &QNetworkReply::abort );
+  if ( feedback )
+    connect( feedback, &QgsFeedback::canceled, reply, &QNetworkReply::abort );
+
+  return getRequestId( reply );
+}
+
 
 //
 // QgsNetworkRequestParameters
@@ -28,6 +28,7 @@
 #include <QMutex>
 #include <QWaitCondition>
 #include <memory>
+#include <functional>
 
 #include "qgis_core.h"
 #include "qgis_sip.h"
@@ -447,6 +448,9 @@ class CORE_EXPORT QgsNetworkAccessManager : public QNetworkAccessManager
      *
      * The contents of the reply will be returned after the request is completed or an error occurs.
      *
+     * Since QGIS 3.16, identical requests made concurrently from worker threads are only sent once,
+     * and all callers receive a copy of the same reply.
+     *
      * \see blockingPost()
      * \since QGIS 3.6
      */
@@ -474,6 +478,30 @@ class CORE_EXPORT QgsNetworkAccessManager : public QNetworkAccessManager
      */
     static QgsNetworkReplyContent blockingPost( QNetworkRequest &request, const QByteArray &data, const QString &authCfg = QString(), bool forceRefresh = false, QgsFeedback *feedback = nullptr );
 
+#ifndef SIP_RUN
+
+    /**
+     * Posts a GET request to obtain the contents of the target \a request without blocking the current thread,
+     * and returns the id of the request.
+     *
+     * The request is made with the network access manager of the current thread, and \a callback is called
+     * with the contents of the reply from the event loop of this thread once the request is completed or an error occurs.
+     * Many requests can be made concurrently this way, and callbacks can chain further requests.
+     *
+     * The \a context object must live in the current thread. The request is aborted and \a callback is not called
+     * if \a context is deleted before the request completes. The optional \a feedback argument can also be used to
+     * abort the request, \a callback is then called with the canceled reply.
+     *
+     * If an \a authCfg has been specified, then that authentication configuration will automatically be applied to
+     * \a request. If it cannot be applied, -1 is returned and \a callback is not called.
+     *
+     * \note not available in Python bindings
+     * \see blockingGet()
+     * \since QGIS 3.16
+     */
+    static int asyncGet( const QNetworkRequest &request, const QString &authCfg, QObject *context, const std::function< void( const QgsNetworkReplyContent &reply ) > &callback, QgsFeedback *feedback = nullptr );
+#endif
+
   signals:
 
     /**
@@ -15,6 +15,7 @@
 
 #include "qgsnetworkreply.h"
 #include <QNetworkReply>
+#include <QDateTime>
 
 QgsNetworkReplyContent::QgsNetworkReplyContent( QNetworkReply *reply )
   : mError( reply->error() )
@@ -36,6 +37,10 @@ QgsNetworkReplyContent::QgsNetworkReplyContent( QNetworkReply *reply )
   int requestId = reply->property( "requestId" ).toInt( &ok );
   if ( ok )
     mRequestId = requestId;
+
+  const qint64 startTime = reply->property( "requestStartTime" ).toLongLong( &ok );
+  if ( ok )
+    mElapsedTime = QDateTime::currentMSecsSinceEpoch() - startTime;
 }
 
 void QgsNetworkReplyContent::clear()
@@ -157,6 +157,14 @@ class CORE_EXPORT QgsNetworkReplyContent
      */
     QByteArray content() const { return mContent; }
 
+    /**
+     * Returns the time in milliseconds between the creation of the request and the
+     * completion of the reply, or -1 if it is not known.
+     *
+     * \since QGIS 3.16
+     */
+    qint64 elapsedTime() const { return mElapsedTime; }
+
   private:
 
     QNetworkReply::NetworkError mError = QNetworkReply::NoError;
@@ -166,6 +174,7 @@ class CORE_EXPORT QgsNetworkReplyContent
     int mRequestId = -1;
     QNetworkRequest mRequest;
     QByteArray mContent;
+    qint64 mElapsedTime = -1;
 };
 
 #endif // QGSNETWORKREPLY_H
@@ -48,6 +48,8 @@
 #include <QFile>
 #include <QMessageBox>
 
+#include <algorithm>
+
 #include <ogr_srs_api.h>
 
 extern "C"
@@ -63,6 +65,9 @@ extern "C"
 #define PROJECT_ENTRY_SCOPE_OFFLINE "OfflineEditingPlugin"
 #define PROJECT_ENTRY_KEY_OFFLINE_DB_PATH "/OfflineDbPath"
 
+// number of features added at once to the offline layer
+static const int COPY_BATCH_SIZE = 1000;
+
 QgsOfflineEditing::QgsOfflineEditing()
 {
   connect( QgsProject::instance(), &QgsProject::layerWasAdded, this, &QgsOfflineEditing::layerAdded );
@@ -292,6 +297,9 @@ void QgsOfflineEditing::synchronize()
       {
         remoteLayer->startEditing();
 
+        // the fid lookup is read at once, its table has no index
+        const QMap<QgsFeatureId, QgsFeatureId> remoteFids = remoteFidLookup( database.get(), layerId );
+
         // TODO: only get commitNos of this layer?
         int commitNo = getCommitNo( database.get() );
         QgsDebugMsgLevel( QStringLiteral( "Found %1 commits" ).arg( commitNo ), 4 );
@@ -300,19 +308,30 @@ void QgsOfflineEditing::synchronize()
           QgsDebugMsgLevel( QStringLiteral( "Apply commits chronologically" ), 4 );
           // apply commits chronologically
           applyAttributesAdded( remoteLayer, database.get(), layerId, i );
-          applyAttributeValueChanges( offlineLayer, remoteLayer, database.get(), layerId, i );
-          applyGeometryChanges( remoteLayer, database.get(), layerId, i );
+          applyAttributeValueChanges( offlineLayer, remoteLayer, database.get(), layerId, i, remoteFids );
+          applyGeometryChanges( remoteLayer, database.get(), layerId, i, remoteFids );
         }
 
         applyFeaturesAdded( offlineLayer, remoteLayer, database.get(), layerId );
-        applyFeaturesRemoved( remoteLayer, database.get(), layerId );
+        applyFeaturesRemoved( remoteLayer, database.get(), layerId, remoteFids );
 
-        if ( remoteLayer->commitChanges() )
+        // the edit buffer sends each kind of change to the provider in a single call, which sets the fids of the added features
+        QList<QgsFeatureId> addedRemoteFids;
+        const QMetaObject::Connection addedFeaturesConnection = connect( remoteLayer, &QgsVectorLayer::committedFeaturesAdded, this, [&addedRemoteFids]( const QString &, const QgsFeatureList & addedFeatures )
+        {
+          for ( const QgsFeature &feature : addedFeatures )
+            addedRemoteFids << feature.id();
+        } );
+        const bool committed = remoteLayer->commitChanges();
+        disconnect( addedFeaturesConnection );
+
+        if ( committed )
         {
           // update fid lookup
-          updateFidLookup( remoteLayer, database.get(), layerId );
+          updateFidLookup( remoteLayer, database.get(), layerId, remoteFids, addedRemoteFids );
 
           // clear edit log for this layer
+          sqlExec( database.get(), QStringLiteral( "BEGIN" ) );
           sql = QStringLiteral( "DELETE FROM 'log_added_attrs' WHERE \"layer_id\" = %1" ).arg( layerId );
           sqlExec( database.get(), sql );
           sql = QStringLiteral( "DELETE FROM 'log_added_features' WHERE \"layer_id\" = %1" ).arg( layerId );
@@ -323,6 +342,7 @@ void QgsOfflineEditing::synchronize()
           sqlExec( database.get(), sql );
           sql = QStringLiteral( "DELETE FROM 'log_geometry_updates' WHERE \"layer_id\" = %1" ).arg( layerId );
           sqlExec( database.get(), sql );
+          sqlExec( database.get(), QStringLiteral( "COMMIT" ) );
         }
         else
         {
@@ -767,8 +787,7 @@ QgsVectorLayer *QgsOfflineEditing::copyVectorLayer( QgsVectorLayer *layer, sqlit
   if ( newLayer->isValid() )
   {
 
-    // copy features
-    newLayer->startEditing();
+    // copy features, added in batches to the provider of the offline layer
     QgsFeature f;
 
     QgsFeatureRequest req;
@@ -793,7 +812,22 @@ QgsVectorLayer *QgsOfflineEditing::copyVectorLayer( QgsVectorLayer *layer, sqlit
     int featureCount = 1;
 
     QList<QgsFeatureId> remoteFeatureIds;
-    while ( fit.nextFeature( f ) )
+    QList<QgsFeatureId> offlineFeatureIds;
+    QgsFeatureList batch;
+    bool copied = true;
+    auto addBatch = [&]
+    {
+      if ( batch.isEmpty() )
+        return;
+
+      // the provider sets the fids of the added features
+      copied = newLayer->dataProvider()->addFeatures( batch );
+      for ( const QgsFeature &feature : qgis::as_const( batch ) )
+        offlineFeatureIds << feature.id();
+      batch.clear();
+    };
+
+    while ( copied && fit.nextFeature( f ) )
     {
       remoteFeatureIds << f.id();
 
@@ -809,26 +843,25 @@ QgsVectorLayer *QgsOfflineEditing::copyVectorLayer( QgsVectorLayer *layer, sqlit
       }
       f.setAttributes( newAttrs );
 
-      newLayer->addFeature( f );
+      batch << f;
+      if ( batch.size() >= COPY_BATCH_SIZE )
+        addBatch();
 
       emit progressUpdated( featureCount++ );
     }
-    if ( newLayer->commitChanges() )
+    if ( copied )
+      addBatch();
+
+    if ( copied )
     {
+      newLayer->updateExtents();
+
       emit progressModeSet( QgsOfflineEditing::ProcessFeatures, layer->dataProvider()->featureCount() );
       featureCount = 1;
 
       // update feature id lookup
       int layerId = getOrCreateLayerId( db, newLayer->id() );
-      QList<QgsFeatureId> offlineFeatureIds;
-
-      QgsFeatureIterator fit = newLayer->getFeatures( QgsFeatureRequest().setFlags( QgsFeatureRequest::NoGeometry ).setNoAttributes() );
-      while ( fit.nextFeature( f ) )
-      {
-        offlineFeatureIds << f.id();
-      }
 
-      // NOTE: insert fids in this loop, as the db is locked during newLayer->nextFeature()
       sqlExec( db, QStringLiteral( "BEGIN" ) );
       int remoteCount = remoteFeatureIds.size();
       for ( int i = 0; i < remoteCount; i++ )
@@ -849,7 +882,7 @@ QgsVectorLayer *QgsOfflineEditing::copyVectorLayer( QgsVectorLayer *layer, sqlit
     }
     else
     {
-      showWarning( newLayer->commitErrors().join( QStringLiteral( "\n" ) ) );
+      showWarning( newLayer->dataProvider()->errors().join( QStringLiteral( "\n" ) ) );
     }
 
     // copy the custom properties from original layer
@@ -977,44 +1010,47 @@ void QgsOfflineEditing::applyFeaturesAdded( QgsVectorLayer *offlineLayer, QgsVec
 
   int i = 1;
   int newAttrsCount = remoteLayer->fields().count();
+  // NOTE: SpatiaLite provider ignores position of geometry column
+  // restore gap in QgsAttributeMap if geometry column is not last (WORKAROUND)
+  const QMap<int, int> attrLookup = attributeLookup( offlineLayer, remoteLayer );
+  QgsFeatureList remoteFeatures;
+  remoteFeatures.reserve( features.size() );
   for ( QgsFeatureList::iterator it = features.begin(); it != features.end(); ++it )
   {
-    // NOTE: SpatiaLite provider ignores position of geometry column
-    // restore gap in QgsAttributeMap if geometry column is not last (WORKAROUND)
-    QMap<int, int> attrLookup = attributeLookup( offlineLayer, remoteLayer );
     QgsAttributes newAttrs( newAttrsCount );
     QgsAttributes attrs = it->attributes();
     for ( int it = 0; it < attrs.count(); ++it )
     {
-      newAttrs[ attrLookup[ it ] ] = attrs.at( it );
+      newAttrs[ attrLookup.value( it ) ] = attrs.at( it );
     }
 
     // respect constraints and provider default values
-    QgsFeature f = QgsVectorLayerUtils::createFeature( remoteLayer, it->geometry(), newAttrs.toMap(), &context );
-    remoteLayer->addFeature( f );
+    remoteFeatures << QgsVectorLayerUtils::createFeature( remoteLayer, it->geometry(), newAttrs.toMap(), &context );
 
     emit progressUpdated( i++ );
   }
+  remoteLayer->addFeatures( remoteFeatures );
 }
 
-void QgsOfflineEditing::applyFeaturesRemoved( QgsVectorLayer *remoteLayer, sqlite3 *db, int layerId )
+void QgsOfflineEditing::applyFeaturesRemoved( QgsVectorLayer *remoteLayer, sqlite3 *db, int layerId, const QMap<QgsFeatureId, QgsFeatureId> &remoteFids )
 {
   QString sql = QStringLiteral( "SELECT \"fid\" FROM 'log_removed_features' WHERE \"layer_id\" = %1" ).arg( layerId );
   QgsFeatureIds values = sqlQueryFeaturesRemoved( db, sql );
 
   emit progressModeSet( QgsOfflineEditing::RemoveFeatures, values.size() );
 
+  QgsFeatureIds fids;
   int i = 1;
   for ( QgsFeatureIds::const_iterator it = values.constBegin(); it != values.constEnd(); ++it )
   {
-    QgsFeatureId fid = remoteFid( db, layerId, *it );
-    remoteLayer->deleteFeature( fid );
+    fids << remoteFids.value( *it, -1 );
 
     emit progressUpdated( i++ );
   }
+  remoteLayer->deleteFeatures( fids );
 }
 
-void QgsOfflineEditing::applyAttributeValueChanges( QgsVectorLayer *offlineLayer, QgsVectorLayer *remoteLayer, sqlite3 *db, int layerId, int commitNo )
+void QgsOfflineEditing::applyAttributeValueChanges( QgsVectorLayer *offlineLayer, QgsVectorLayer *remoteLayer, sqlite3 *db, int layerId, int commitNo, const QMap<QgsFeatureId, QgsFeatureId> &remoteFids )
 {
   QString sql = QStringLiteral( "SELECT \"fid\", \"attr\", \"value\" FROM 'log_feature_updates' WHERE \"layer_id\" = %1 AND \"commit_no\" = %2 " ).arg( layerId ).arg( commitNo );
   AttributeValueChanges values = sqlQueryAttributeValueChanges( db, sql );
@@ -1025,7 +1061,7 @@ void QgsOfflineEditing::applyAttributeValueChanges( QgsVectorLayer *offlineLayer
 
   for ( int i = 0; i < values.size(); i++ )
   {
-    QgsFeatureId fid = remoteFid( db, layerId, values.at( i ).fid );
+    QgsFeatureId fid = remoteFids.value( values.at( i ).fid, -1 );
     QgsDebugMsgLevel( QStringLiteral( "Offline changeAttributeValue %1 = %2" ).arg( QString( attrLookup[ values.at( i ).attr ] ), values.at( i ).value ), 4 );
     remoteLayer->changeAttributeValue( fid, attrLookup[ values.at( i ).attr ], values.at( i ).value );
 
@@ -1033,7 +1069,7 @@ void QgsOfflineEditing::applyAttributeValueChanges( QgsVectorLayer *offlineLayer
   }
 }
 
-void QgsOfflineEditing::applyGeometryChanges( QgsVectorLayer *remoteLayer, sqlite3 *db, int layerId, int commitNo )
+void QgsOfflineEditing::applyGeometryChanges( QgsVectorLayer *remoteLayer, sqlite3 *db, int layerId, int commitNo, const QMap<QgsFeatureId, QgsFeatureId> &remoteFids )
 {
   QString sql = QStringLiteral( "SELECT \"fid\", \"geom_wkt\" FROM 'log_geometry_updates' WHERE \"layer_id\" = %1 AND \"commit_no\" = %2" ).arg( layerId ).arg( commitNo );
   GeometryChanges values = sqlQueryGeometryChanges( db, sql );
@@ -1042,7 +1078,7 @@ void QgsOfflineEditing::applyGeometryChanges( QgsVectorLayer *remoteLayer, sqlit
 
   for ( int i = 0; i < values.size(); i++ )
   {
-    QgsFeatureId fid = remoteFid( db, layerId, values.at( i ).fid );
+    QgsFeatureId fid = remoteFids.value( values.at( i ).fid, -1 );
     QgsGeometry newGeom = QgsGeometry::fromWkt( values.at( i ).geom_wkt );
     remoteLayer->changeGeometry( fid, newGeom );
 
@@ -1050,34 +1086,40 @@ void QgsOfflineEditing::applyGeometryChanges( QgsVectorLayer *remoteLayer, sqlit
   }
 }
 
-void QgsOfflineEditing::updateFidLookup( QgsVectorLayer *remoteLayer, sqlite3 *db, int layerId )
+void QgsOfflineEditing::updateFidLookup( QgsVectorLayer *remoteLayer, sqlite3 *db, int layerId, const QMap<QgsFeatureId, QgsFeatureId> &remoteFids, const QList<QgsFeatureId> &addedRemoteFids )
 {
   // update fid lookup for added features
 
-  // get remote added fids
-  // NOTE: use QMap for sorted fids
-  QMap < QgsFeatureId, bool /*dummy*/ > newRemoteFids;
-  QgsFeature f;
+  // get local added fids
+  // NOTE: fids are sorted
+  QString sql = QStringLiteral( "SELECT \"fid\" FROM 'log_added_features' WHERE \"layer_id\" = %1" ).arg( layerId );
+  QList<int> newOfflineFids = sqlQueryInts( db, sql );
 
-  QgsFeatureIterator fit = remoteLayer->getFeatures( QgsFeatureRequest().setFlags( QgsFeatureRequest::NoGeometry ).setNoAttributes() );
+  // get remote added fids, as set by the provider on commit
+  QList<QgsFeatureId> newRemoteFids = addedRemoteFids;
+  if ( newRemoteFids.size() != newOfflineFids.size() )
+  {
+    // otherwise they are the remote features without an offline fid
+    newRemoteFids.clear();
+    const QSet<QgsFeatureId> knownRemoteFids = qgis::listToSet( remoteFids.values() );
+    QgsFeature f;
 
-  emit progressModeSet( QgsOfflineEditing::ProcessFeatures, remoteLayer->featureCount() );
+    QgsFeatureIterator fit = remoteLayer->getFeatures( QgsFeatureRequest().setFlags( QgsFeatureRequest::NoGeometry ).setNoAttributes() );
 
-  int i = 1;
-  while ( fit.nextFeature( f ) )
-  {
-    if ( offlineFid( db, layerId, f.id() ) == -1 )
+    emit progressModeSet( QgsOfflineEditing::ProcessFeatures, remoteLayer->featureCount() );
+
+    int i = 1;
+    while ( fit.nextFeature( f ) )
     {
-      newRemoteFids[ f.id()] = true;
-    }
+      if ( !knownRemoteFids.contains( f.id() ) )
+      {
+        newRemoteFids << f.id();
+      }
 
-    emit progressUpdated( i++ );
+      emit progressUpdated( i++ );
+    }
   }
-
-  // get local added fids
-  // NOTE: fids are sorted
-  QString sql = QStringLiteral( "SELECT \"fid\" FROM 'log_added_features' WHERE \"layer_id\" = %1" ).arg( layerId );
-  QList<int> newOfflineFids = sqlQueryInts( db, sql );
+  std::sort( newRemoteFids.begin(), newRemoteFids.end() );
 
   if ( newRemoteFids.size() != newOfflineFids.size() )
   {
@@ -1086,11 +1128,10 @@ void QgsOfflineEditing::updateFidLookup( QgsVectorLayer *remoteLayer, sqlite3 *d
   else
   {
     // add new fid lookups
-    i = 0;
     sqlExec( db, QStringLiteral( "BEGIN" ) );
-    for ( QMap<QgsFeatureId, bool>::const_iterator it = newRemoteFids.constBegin(); it != newRemoteFids.constEnd(); ++it )
+    for ( int i = 0; i < newRemoteFids.size(); ++i )
     {
-      addFidLookup( db, layerId, newOfflineFids.at( i++ ), it.key() );
+      addFidLookup( db, layerId, newOfflineFids.at( i ), newRemoteFids.at( i ) );
     }
     sqlExec( db, QStringLiteral( "COMMIT" ) );
   }
@@ -1275,16 +1316,28 @@ void QgsOfflineEditing::addFidLookup( sqlite3 *db, int layerId, QgsFeatureId off
   sqlExec( db, sql );
 }
 
-QgsFeatureId QgsOfflineEditing::remoteFid( sqlite3 *db, int layerId, QgsFeatureId offlineFid )
+QMap<QgsFeatureId, QgsFeatureId> QgsOfflineEditing::remoteFidLookup( sqlite3 *db, int layerId )
 {
-  QString sql = QStringLiteral( "SELECT \"remote_fid\" FROM 'log_fids' WHERE \"layer_id\" = %1 AND \"offline_fid\" = %2" ).arg( layerId ).arg( offlineFid );
-  return sqlQueryInt( db, sql, -1 );
-}
+  QMap<QgsFeatureId, QgsFeatureId> lookup;
 
-QgsFeatureId QgsOfflineEditing::offlineFid( sqlite3 *db, int layerId, QgsFeatureId remoteFid )
-{
-  QString sql = QStringLiteral( "SELECT \"offline_fid\" FROM 'log_fids' WHERE \"layer_id\" = %1 AND \"remote_fid\" = %2" ).arg( layerId ).arg( remoteFid );
-  return sqlQueryInt( db, sql, -1 );
+  QString sql = QStringLiteral( "SELECT \"offline_fid\", \"remote_fid\" FROM 'log_fids' WHERE \"layer_id\" = %1" ).arg( layerId );
+  sqlite3_stmt *stmt = nullptr;
+  if ( sqlite3_prepare_v2( db, sql.toUtf8().constData(), -1, &stmt, nullptr ) != SQLITE_OK )
+  {
+    showWarning( sqlite3_errmsg( db ) );
+    return lookup;
+  }
+
+  int ret = sqlite3_step( stmt );
+  while ( ret == SQLITE_ROW )
+  {
+    lookup.insert( sqlite3_column_int64( stmt, 0 ), sqlite3_column_int64( stmt, 1 ) );
+
+    ret = sqlite3_step( stmt );
+  }
+  sqlite3_finalize( stmt );
+
+  return lookup;
 }
 
 bool QgsOfflineEditing::isAddedFeature( sqlite3 *db, int layerId, QgsFeatureId fid )
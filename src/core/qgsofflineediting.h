@@ -121,10 +121,15 @@ class CORE_EXPORT QgsOfflineEditing : public QObject
 
     void applyAttributesAdded( QgsVectorLayer *remoteLayer, sqlite3 *db, int layerId, int commitNo );
     void applyFeaturesAdded( QgsVectorLayer *offlineLayer, QgsVectorLayer *remoteLayer, sqlite3 *db, int layerId );
-    void applyFeaturesRemoved( QgsVectorLayer *remoteLayer, sqlite3 *db, int layerId );
-    void applyAttributeValueChanges( QgsVectorLayer *offlineLayer, QgsVectorLayer *remoteLayer, sqlite3 *db, int layerId, int commitNo );
-    void applyGeometryChanges( QgsVectorLayer *remoteLayer, sqlite3 *db, int layerId, int commitNo );
-    void updateFidLookup( QgsVectorLayer *remoteLayer, sqlite3 *db, int layerId );
+    void applyFeaturesRemoved( QgsVectorLayer *remoteLayer, sqlite3 *db, int layerId, const QMap<QgsFeatureId, QgsFeatureId> &remoteFids );
+    void applyAttributeValueChanges( QgsVectorLayer *offlineLayer, QgsVectorLayer *remoteLayer, sqlite3 *db, int layerId, int commitNo, const QMap<QgsFeatureId, QgsFeatureId> &remoteFids );
+    void applyGeometryChanges( QgsVectorLayer *remoteLayer, sqlite3 *db, int layerId, int commitNo, const QMap<QgsFeatureId, QgsFeatureId> &remoteFids );
+
+    /**
+     * Adds the fid lookup of the added features, from the remote fids set by the provider on commit
+     * or, when they are not known, from the remote features without an offline fid in \a remoteFids.
+     */
+    void updateFidLookup( QgsVectorLayer *remoteLayer, sqlite3 *db, int layerId, const QMap<QgsFeatureId, QgsFeatureId> &remoteFids, const QList<QgsFeatureId> &addedRemoteFids );
     void copySymbology( QgsVectorLayer *sourceLayer, QgsVectorLayer *targetLayer );
 
     /**
@@ -151,8 +156,8 @@ class CORE_EXPORT QgsOfflineEditing : public QObject
     int getCommitNo( sqlite3 *db );
     void increaseCommitNo( sqlite3 *db );
     void addFidLookup( sqlite3 *db, int layerId, QgsFeatureId offlineFid, QgsFeatureId remoteFid );
-    QgsFeatureId remoteFid( sqlite3 *db, int layerId, QgsFeatureId offlineFid );
-    QgsFeatureId offlineFid( sqlite3 *db, int layerId, QgsFeatureId remoteFid );
+    //! Returns the remote fids of the layer, by offline fid
+    QMap<QgsFeatureId, QgsFeatureId> remoteFidLookup( sqlite3 *db, int layerId );
     bool isAddedFeature( sqlite3 *db, int layerId, QgsFeatureId fid );
 
     int sqlExec( sqlite3 *db, const QString &sql );
@@ -32,6 +32,8 @@
 #include <QLinkedListIterator>
 #include <QtConcurrent>
 
+#include <cmath>
+
 using namespace SpatialIndex;
 
 
@@ -773,9 +775,45 @@ void QgsPointLocator::setExtent( const QgsRectangle *extent )
     // already indexing, return!
     return;
 
-  mExtent.reset( extent ? new QgsRectangle( *extent ) : nullptr );
+  if ( !extent )
+  {
+    mExtent.reset();
+    mTileSize = 0;
+    destroyIndex();
+    return;
+  }
+
+  // the extent is enlarged to whole tiles, about an eighth of its size: small moves keep the index,
+  // and larger ones only read the features of the new tiles, as long as the size of the extent is similar
+  const double side = std::max( extent->width(), extent->height() );
+  const double tileSize = side > 0 && std::isfinite( side ) ? std::pow( 2.0, std::ceil( std::log2( side / 8 ) ) ) : 0;
+  const bool sameTiles = tileSize > 0 && mTileSize > 0 && tileSize < 4 * mTileSize && 4 * tileSize > mTileSize;
+  if ( !sameTiles )
+    mTileSize = tileSize;
 
-  destroyIndex();
+  QgsRectangle alignedExtent = *extent;
+  if ( mTileSize > 0 )
+  {
+    alignedExtent = QgsRectangle( std::floor( extent->xMinimum() / mTileSize ) * mTileSize,
+                                  std::floor( extent->yMinimum() / mTileSize ) * mTileSize,
+                                  std::ceil( extent->xMaximum() / mTileSize ) * mTileSize,
+                                  std::ceil( extent->yMaximum() / mTileSize ) * mTileSize );
+  }
+
+  if ( sameTiles && mExtent && *mExtent == alignedExtent )
+    return;
+
+  mExtent.reset( new QgsRectangle( alignedExtent ) );
+
+  if ( sameTiles && mRTree && mIndexedExtent.intersects( alignedExtent ) )
+  {
+    // updated by the next init()
+    mExtentChanged = true;
+  }
+  else
+  {
+    destroyIndex();
+  }
 }
 
 void QgsPointLocator::setRenderContext( const QgsRenderContext *context )
@@ -784,6 +822,13 @@ void QgsPointLocator::setRenderContext( const QgsRenderContext *context )
     // already indexing, return!
     return;
 
+  // the visibility of the features depends on the scale, the index is kept when only the map extent changes
+  if ( context && mContext && qgsDoubleNear( context->rendererScale(), mContext->rendererScale() ) )
+  {
+    mContext.reset( new QgsRenderContext( *context ) );
+    return;
+  }
+
   disconnect( mLayer, &QgsVectorLayer::styleChanged, this, &QgsPointLocator::destroyIndex );
 
   destroyIndex();
@@ -872,7 +917,7 @@ void QgsPointLocator::waitForIndexingFinished()
 
 bool QgsPointLocator::hasIndex() const
 {
-  return mIsIndexing || mRTree || mIsEmptyLayer;
+  return mIsIndexing || ( ( mRTree || mIsEmptyLayer ) && !mExtentChanged );
 }
 
 bool QgsPointLocator::prepare( bool relaxed )
@@ -885,7 +930,7 @@ bool QgsPointLocator::prepare( bool relaxed )
       waitForIndexingFinished();
   }
 
-  if ( !mRTree )
+  if ( !mRTree || mExtentChanged )
   {
     init( -1, relaxed );
     if ( ( relaxed && mIsIndexing ) || !mRTree ) // relaxed mode and currently indexing or still invalid?
@@ -895,24 +940,16 @@ bool QgsPointLocator::prepare( bool relaxed )
   return true;
 }
 
-bool QgsPointLocator::rebuildIndex( int maxFeaturesToIndex )
+bool QgsPointLocator::readFeatures( const QgsRectangle *extent, const std::function<bool ( const QgsFeature & )> &visitor )
 {
-  QElapsedTimer t;
-  t.start();
-
-  QgsDebugMsgLevel( QStringLiteral( "RebuildIndex start : %1" ).arg( mSource->id() ), 2 );
-
-  destroyIndex();
-
-  QLinkedList<RTree::Data *> dataList;
   QgsFeature f;
 
   QgsFeatureRequest request;
   request.setNoAttributes();
 
-  if ( mExtent )
+  if ( extent )
   {
-    QgsRectangle rect = *mExtent;
+    QgsRectangle rect = *extent;
     if ( mTransform.isValid() )
     {
       try
@@ -943,9 +980,8 @@ bool QgsPointLocator::rebuildIndex( int maxFeaturesToIndex )
     }
   }
 
+  bool completed = true;
   QgsFeatureIterator fi = mSource->getFeatures( request );
-  int indexedCount = 0;
-
   while ( fi.nextFeature( f ) )
   {
     if ( !f.hasGeometry() )
@@ -977,6 +1013,42 @@ bool QgsPointLocator::rebuildIndex( int maxFeaturesToIndex )
       }
     }
 
+    if ( !visitor( f ) )
+    {
+      completed = false;
+      break;
+    }
+  }
+
+  if ( ctx && mRenderer )
+  {
+    mRenderer->stopRender( *ctx );
+  }
+
+  return completed;
+}
+
+bool QgsPointLocator::rebuildIndex( int maxFeaturesToIndex )
+{
+  QElapsedTimer t;
+  t.start();
+
+  QgsDebugMsgLevel( QStringLiteral( "RebuildIndex start : %1" ).arg( mSource->id() ), 2 );
+
+  if ( mRTree && mExtentChanged )
+  {
+    const bool ok = updateIndex( maxFeaturesToIndex );
+    QgsDebugMsgLevel( QStringLiteral( "RebuildIndex updated : %1 ms (%2)" ).arg( t.elapsed() ).arg( mSource->id() ), 2 );
+    return ok;
+  }
+
+  destroyIndex();
+
+  QLinkedList<RTree::Data *> dataList;
+  int indexedCount = 0;
+
+  const bool completed = readFeatures( mExtent.get(), [this, &dataList, &indexedCount, maxFeaturesToIndex]( const QgsFeature & f ) -> bool
+  {
     const QgsRectangle bbox = f.geometry().boundingBox();
     if ( bbox.isFinite() )
     {
@@ -989,14 +1061,18 @@ bool QgsPointLocator::rebuildIndex( int maxFeaturesToIndex )
       ++indexedCount;
     }
 
-    if ( maxFeaturesToIndex != -1 && indexedCount > maxFeaturesToIndex )
-    {
-      qDeleteAll( dataList );
-      destroyIndex();
-      return false;
-    }
+    return maxFeaturesToIndex == -1 || indexedCount <= maxFeaturesToIndex;
+  } );
+
+  if ( !completed )
+  {
+    qDeleteAll( dataList );
+    destroyIndex();
+    return false;
   }
 
+  mIndexedExtent = mExtent ? *mExtent : QgsRectangle();
+
   // R-Tree parameters
   double fillFactor = 0.7;
   unsigned long indexCapacity = 10;
@@ -1015,13 +1091,65 @@ bool QgsPointLocator::rebuildIndex( int maxFeaturesToIndex )
   mRTree.reset( RTree::createAndBulkLoadNewRTree( RTree::BLM_STR, stream, *mStorage, fillFactor, indexCapacity,
                 leafCapacity, dimension, variant, indexId ) );
 
-  if ( ctx && mRenderer )
+  QgsDebugMsgLevel( QStringLiteral( "RebuildIndex end : %1 ms (%2)" ).arg( t.elapsed() ).arg( mSource->id() ), 2 );
+
+  return true;
+}
+
+bool QgsPointLocator::updateIndex( int maxFeaturesToIndex )
+{
+  const QgsRectangle extent = *mExtent;
+
+  // drop the features out of the new extent
+  for ( auto it = mGeoms.begin(); it != mGeoms.end(); )
   {
-    mRenderer->stopRender( *ctx );
+    const QgsRectangle bbox = it.value()->boundingBox();
+    if ( bbox.intersects( extent ) )
+    {
+      ++it;
+      continue;
+    }
+    mRTree->deleteData( rect2region( bbox ), it.key() );
+    delete it.value();
+    it = mGeoms.erase( it );
   }
 
-  QgsDebugMsgLevel( QStringLiteral( "RebuildIndex end : %1 ms (%2)" ).arg( t.elapsed() ).arg( mSource->id() ), 2 );
+  // the features intersecting the part of the previous extent which is kept are indexed already,
+  // only the stripes around it are read
+  const QgsRectangle kept = mIndexedExtent.intersect( extent );
+  QVector< QgsRectangle > stripes;
+  if ( extent.yMaximum() > kept.yMaximum() )
+    stripes << QgsRectangle( extent.xMinimum(), kept.yMaximum(), extent.xMaximum(), extent.yMaximum() );
+  if ( extent.yMinimum() < kept.yMinimum() )
+    stripes << QgsRectangle( extent.xMinimum(), extent.yMinimum(), extent.xMaximum(), kept.yMinimum() );
+  if ( extent.xMinimum() < kept.xMinimum() )
+    stripes << QgsRectangle( extent.xMinimum(), kept.yMinimum(), kept.xMinimum(), kept.yMaximum() );
+  if ( extent.xMaximum() > kept.xMaximum() )
+    stripes << QgsRectangle( kept.xMaximum(), kept.yMinimum(), extent.xMaximum(), kept.yMaximum() );
+
+  for ( const QgsRectangle &stripe : qgis::as_const( stripes ) )
+  {
+    const bool completed = readFeatures( &stripe, [this, maxFeaturesToIndex]( const QgsFeature & f ) -> bool
+    {
+      const QgsRectangle bbox = f.geometry().boundingBox();
+      if ( bbox.isFinite() && !mGeoms.contains( f.id() ) )
+      {
+        mRTree->insertData( 0, nullptr, rect2region( bbox ), f.id() );
+        mGeoms[f.id()] = new QgsGeometry( f.geometry() );
+      }
+
+      return maxFeaturesToIndex == -1 || mGeoms.count() <= maxFeaturesToIndex;
+    } );
+
+    if ( !completed )
+    {
+      destroyIndex();
+      return false;
+    }
+  }
 
+  mIndexedExtent = extent;
+  mExtentChanged = false;
   return true;
 }
 
@@ -1031,6 +1159,7 @@ void QgsPointLocator::destroyIndex()
   mRTree.reset();
 
   mIsEmptyLayer = false;
+  mExtentChanged = false;
 
   qDeleteAll( mGeoms );
 
@@ -32,6 +32,7 @@ class QgsVectorLayerFeatureSource;
 #include "qgsvectorlayer.h"
 #include "qgslinestring.h"
 #include "qgspointlocatorinittask.h"
+#include <functional>
 #include <memory>
 
 /**
@@ -137,12 +138,18 @@ class CORE_EXPORT QgsPointLocator : public QObject
 
     /**
      * Configure extent - if not NULLPTR, it will index only that area
+     *
+     * The extent is enlarged to whole tiles of about an eighth of its size. When the new extent overlaps the previous
+     * one and has a similar size, the index is not rebuilt: the next init() only drops the features out of the new extent
+     * and reads the features of the new tiles.
      * \since QGIS 2.14
      */
     void setExtent( const QgsRectangle *extent );
 
     /**
      * Configure render context  - if not NULLPTR, it will use to index only visible feature
+     *
+     * The index is kept if the renderer scale of the new context is the same as the previous one.
      * \since QGIS 3.2
      */
     void setRenderContext( const QgsRenderContext *context );
@@ -438,6 +445,15 @@ class CORE_EXPORT QgsPointLocator : public QObject
      */
     bool prepare( bool relaxed );
 
+    /**
+     * Reads the features of the layer which intersect \a extent, in destination CRS, or all of them if \a extent is NULLPTR.
+     * Calls \a visitor with each feature in destination CRS, as long as it returns TRUE. Returns FALSE if the visitor stopped.
+     */
+    bool readFeatures( const QgsRectangle *extent, const std::function< bool( const QgsFeature &feature ) > &visitor ) SIP_SKIP;
+
+    //! Updates the index of the previous extent to the current one, reading only the features of the new parts
+    bool updateIndex( int maxFeaturesToIndex );
+
     //! Storage manager
     std::unique_ptr< SpatialIndex::IStorageManager > mStorage;
 
@@ -452,6 +468,12 @@ class CORE_EXPORT QgsPointLocator : public QObject
     QgsCoordinateTransform mTransform;
     QgsVectorLayer *mLayer = nullptr;
     std::unique_ptr< QgsRectangle > mExtent;
+    //! Size of the tiles the extent is aligned to, 0 if the extent is not aligned
+    double mTileSize = 0;
+    //! Extent covered by the index, which differs from mExtent until the index is updated
+    QgsRectangle mIndexedExtent;
+    //! Whether the extent changed since the index was built, and the index needs to be updated
+    bool mExtentChanged = false;
 
     std::unique_ptr<QgsRenderContext> mContext;
     std::unique_ptr<QgsFeatureRenderer> mRenderer;
@@ -63,6 +63,7 @@
 #include "qgsvectortilelayer.h"
 #include "qgsruntimeprofiler.h"
 #include "qgsannotationlayer.h"
+#include "qgsauthmanager.h"
 
 #include <algorithm>
 #include <QApplication>
@@ -71,8 +72,10 @@
 #include <QObject>
 #include <QTextStream>
 #include <QTemporaryFile>
+#include <QThread>
 #include <QDir>
 #include <QUrl>
+#include <QtConcurrentMap>
 
 
 #ifdef _MSC_VER
@@ -1080,6 +1083,18 @@ bool QgsProject::_getMapLayers( const QDomDocument &doc, QList<QDomNode> &broken
   const QVector<QDomNode> sortedLayerNodes = depSorter.sortedLayerNodes();
   const int totalLayerCount = sortedLayerNodes.count();
 
+  // the layers which can be read in a background thread are read concurrently first, they are then
+  // added to the project in the same order as the other layers
+  std::vector< PreparedLayer > preparedLayers;
+  QHash< QString, std::size_t > preparedLayerIndexes;
+  if ( ( flags & QgsProject::ReadFlag::FlagReadLayersInParallel ) && !( flags & QgsProject::ReadFlag::FlagDontResolveLayers ) )
+  {
+    profile.switchTask( tr( "Read layers in parallel" ) );
+    prepareLayers( sortedLayerNodes, preparedLayers, flags );
+    for ( std::size_t index = 0; index < preparedLayers.size(); ++index )
+      preparedLayerIndexes.insert( preparedLayers[ index ].element.namedItem( QStringLiteral( "id" ) ).toElement().text(), index );
+  }
+
   int i = 0;
   for ( const QDomNode &node : sortedLayerNodes )
   {
@@ -1091,10 +1106,24 @@ bool QgsProject::_getMapLayers( const QDomDocument &doc, QList<QDomNode> &broken
 
     profile.switchTask( name );
 
+    auto preparedIt = preparedLayerIndexes.constFind( node.namedItem( QStringLiteral( "id" ) ).toElement().text() );
     if ( element.attribute( QStringLiteral( "embedded" ) ) == QLatin1String( "1" ) )
     {
       createEmbeddedLayer( element.attribute( QStringLiteral( "id" ) ), readPath( element.attribute( QStringLiteral( "project" ) ) ), brokenNodes, true, flags );
     }
+    else if ( preparedIt != preparedLayerIndexes.constEnd() && preparedLayers[ *preparedIt ].layer )
+    {
+      PreparedLayer &prepared = preparedLayers[ *preparedIt ];
+      if ( !addReadLayer( std::move( prepared.layer ), prepared.isValid, element, brokenNodes, flags ) )
+      {
+        returnStatus = false;
+      }
+      const auto messages = prepared.context.takeMessages();
+      if ( !messages.isEmpty() )
+      {
+        emit loadingLayerMessageReceived( tr( "Loading layer %1" ).arg( name ), messages );
+      }
+    }
     else
     {
       QgsReadWriteContext context;
@@ -1119,13 +1148,88 @@ bool QgsProject::_getMapLayers( const QDomDocument &doc, QList<QDomNode> &broken
   return returnStatus;
 }
 
-bool QgsProject::addLayer( const QDomElement &layerElem, QList<QDomNode> &brokenNodes, QgsReadWriteContext &context, QgsProject::ReadFlags flags )
+bool QgsProject::canReadLayerInThread( const QDomElement &layerElem )
+{
+  if ( layerElem.attribute( QStringLiteral( "embedded" ) ) == QLatin1String( "1" ) )
+    return false;
+
+  // plugin layers may be implemented in Python, annotation layers have no provider
+  const QString type = layerElem.attribute( QStringLiteral( "type" ) );
+  if ( type != QLatin1String( "vector" ) && type != QLatin1String( "raster" ) && type != QLatin1String( "mesh" ) )
+    return false;
+
+  // layers depending on other layers are read once these are in the project
+  if ( !layerElem.firstChildElement( QStringLiteral( "layerDependencies" ) ).elementsByTagName( QStringLiteral( "layer" ) ).isEmpty() )
+    return false;
+
+  // virtual layers look up the layers of their queries in the project, memory layers are created immediately
+  const QString provider = layerElem.firstChildElement( QStringLiteral( "provider" ) ).text();
+  return provider != QLatin1String( "virtual" ) && provider != QLatin1String( "memory" );
+}
+
+void QgsProject::prepareLayers( const QVector<QDomNode> &layerNodes, std::vector< PreparedLayer > &preparedLayers, QgsProject::ReadFlags flags )
+{
+  // the master password may have to be asked to the user, this is only possible in the main thread
+  const QRegExp authConfigRx( QStringLiteral( "authcfg=([a-z]|[A-Z]|[0-9]){7}" ) );
+  bool authConfigChecked = false;
+  bool masterPasswordIsSet = false;
+
+  for ( const QDomNode &node : layerNodes )
+  {
+    const QDomElement element = node.toElement();
+    if ( !canReadLayerInThread( element ) )
+      continue;
+
+    if ( authConfigRx.indexIn( element.firstChildElement( QStringLiteral( "datasource" ) ).text() ) != -1 )
+    {
+      if ( !authConfigChecked )
+      {
+        masterPasswordIsSet = QgsApplication::authManager()->setMasterPassword( true );
+        authConfigChecked = true;
+      }
+      if ( !masterPasswordIsSet )
+        continue;
+    }
+
+    PreparedLayer prepared;
+    prepared.element = element;
+    // each thread reads its own copy of the layer element, DOM documents cannot be shared between threads
+    prepared.document.appendChild( prepared.document.importNode( element, true ) );
+    prepared.context.setPathResolver( pathResolver() );
+    prepared.context.setProjectTranslator( this );
+    prepared.context.setTransformContext( transformContext() );
+    preparedLayers.emplace_back( std::move( prepared ) );
+  }
+
+  if ( preparedLayers.size() < 2 )
+  {
+    // nothing to gain, the layer is read with the others
+    preparedLayers.clear();
+    return;
+  }
+
+  QThread *projectThread = thread();
+  const QgsMapLayer::ReadFlags layerFlags = layerReadFlags( flags );
+  QtConcurrent::blockingMap( preparedLayers, [this, projectThread, layerFlags, flags]( PreparedLayer & prepared )
+  {
+    const QDomElement layerElem = prepared.document.documentElement();
+    std::unique_ptr<QgsMapLayer> mapLayer = createLayer( layerElem, flags );
+    if ( !mapLayer )
+      return;
+
+    prepared.isValid = mapLayer->readLayerXml( layerElem, prepared.context, layerFlags ) && mapLayer->isValid();
+    // the layer and its provider are owned by the thread of the project
+    mapLayer->moveToThread( projectThread );
+    prepared.layer = std::move( mapLayer );
+  } );
+}
+
+std::unique_ptr<QgsMapLayer> QgsProject::createLayer( const QDomElement &layerElem, QgsProject::ReadFlags flags ) const
 {
   QString type = layerElem.attribute( QStringLiteral( "type" ) );
   QgsDebugMsgLevel( "Layer type is " + type, 4 );
   std::unique_ptr<QgsMapLayer> mapLayer;
 
-  QgsScopedRuntimeProfile profile( tr( "Create layer" ), QStringLiteral( "projectload" ) );
   if ( type == QLatin1String( "vector" ) )
   {
     mapLayer = qgis::make_unique<QgsVectorLayer>();
@@ -1160,26 +1264,43 @@ bool QgsProject::addLayer( const QDomElement &layerElem, QList<QDomNode> &broken
   if ( !mapLayer )
   {
     QgsDebugMsg( QStringLiteral( "Unable to create layer" ) );
-    return false;
   }
+  return mapLayer;
+}
+
+QgsMapLayer::ReadFlags QgsProject::layerReadFlags( QgsProject::ReadFlags flags )
+{
+  QgsMapLayer::ReadFlags layerFlags = QgsMapLayer::ReadFlags();
+  if ( flags & QgsProject::ReadFlag::FlagDontResolveLayers )
+    layerFlags |= QgsMapLayer::FlagDontResolveLayers;
+  return layerFlags;
+}
+
+bool QgsProject::addLayer( const QDomElement &layerElem, QList<QDomNode> &brokenNodes, QgsReadWriteContext &context, QgsProject::ReadFlags flags )
+{
+  QgsScopedRuntimeProfile profile( tr( "Create layer" ), QStringLiteral( "projectload" ) );
+  std::unique_ptr<QgsMapLayer> mapLayer = createLayer( layerElem, flags );
+  if ( !mapLayer )
+    return false;
 
   Q_CHECK_PTR( mapLayer ); // NOLINT
 
+  // have the layer restore state that is stored in Dom node
+  profile.switchTask( tr( "Load layer source" ) );
+  bool layerIsValid = mapLayer->readLayerXml( layerElem, context, layerReadFlags( flags ) ) && mapLayer->isValid();
+
+  profile.switchTask( tr( "Add layer to project" ) );
+  return addReadLayer( std::move( mapLayer ), layerIsValid, layerElem, brokenNodes, flags );
+}
+
+bool QgsProject::addReadLayer( std::unique_ptr<QgsMapLayer> mapLayer, bool layerIsValid, const QDomElement &layerElem, QList<QDomNode> &brokenNodes, QgsProject::ReadFlags flags )
+{
   // This is tricky: to avoid a leak we need to check if the layer was already in the store
   // because if it was, the newly created layer will not be added to the store and it would leak.
   const QString layerId { layerElem.namedItem( QStringLiteral( "id" ) ).toElement().text() };
   Q_ASSERT( ! layerId.isEmpty() );
   const bool layerWasStored { layerStore()->mapLayer( layerId ) != nullptr };
 
-  // have the layer restore state that is stored in Dom node
-  QgsMapLayer::ReadFlags layerFlags = QgsMapLayer::ReadFlags();
-  if ( flags & QgsProject::ReadFlag::FlagDontResolveLayers )
-    layerFlags |= QgsMapLayer::FlagDontResolveLayers;
-
-  profile.switchTask( tr( "Load layer source" ) );
-  bool layerIsValid = mapLayer->readLayerXml( layerElem, context, layerFlags ) && mapLayer->isValid();
-
-  profile.switchTask( tr( "Add layer to project" ) );
   QList<QgsMapLayer *> newLayers;
   newLayers << mapLayer.get();
   if ( layerIsValid || flags & QgsProject::ReadFlag::FlagDontResolveLayers )
@@ -1192,7 +1313,7 @@ bool QgsProject::addLayer( const QDomElement &layerElem, QList<QDomNode> &broken
     // It's a bad layer: do not add to legend (the user will decide if she wants to do so)
     addMapLayers( newLayers, false );
     newLayers.first();
-    QgsDebugMsg( "Unable to load " + type + " layer" );
+    QgsDebugMsg( "Unable to load " + layerElem.attribute( QStringLiteral( "type" ) ) + " layer" );
     brokenNodes.push_back( layerElem );
   }
 
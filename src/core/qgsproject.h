@@ -24,6 +24,7 @@
 #include "qgis_core.h"
 #include "qgis_sip.h"
 #include <memory>
+#include <vector>
 #include <QHash>
 #include <QList>
 #include <QObject>
@@ -31,6 +32,7 @@
 #include <QFileInfo>
 #include <QStringList>
 #include <QTranslator>
+#include <QDomDocument>
 
 #include "qgsunittypes.h"
 #include "qgssnappingconfig.h"
@@ -121,6 +123,7 @@ class CORE_EXPORT QgsProject : public QObject, public QgsExpressionContextGenera
       FlagDontResolveLayers = 1 << 0, //!< Don't resolve layer paths (i.e. don't load any layer content). Dramatically improves project read time if the actual data from the layers is not required.
       FlagDontLoadLayouts = 1 << 1, //!< Don't load print layouts. Improves project read time if layouts are not required, and allows projects to be safely read in background threads (since print layouts are not thread safe).
       FlagTrustLayerMetadata = 1 << 2, //!< Trust layer metadata. Improves project read time. Do not use it if layers' extent is not fixed during the project's use by QGIS and QGIS Server.
+      FlagReadLayersInParallel = 1 << 3, //!< Read the layers without dependencies concurrently in background threads before adding them to the project, in the project order. Improves project read time when the data providers wait for network connections (since QGIS 3.16)
     };
     Q_DECLARE_FLAGS( ReadFlags, ReadFlag )
 
@@ -1878,6 +1881,39 @@ class CORE_EXPORT QgsProject : public QObject, public QgsExpressionContextGenera
      */
     bool addLayer( const QDomElement &layerElem, QList<QDomNode> &brokenNodes, QgsReadWriteContext &context, QgsProject::ReadFlags flags = QgsProject::ReadFlags() ) SIP_SKIP;
 
+#ifndef SIP_RUN
+
+    //! Layer read in a background thread, waiting to be added to the project
+    struct PreparedLayer
+    {
+      //! Layer element in the project document
+      QDomElement element;
+      //! Copy of the layer element read by the thread
+      QDomDocument document;
+      QgsReadWriteContext context;
+      std::unique_ptr<QgsMapLayer> layer;
+      bool isValid = false;
+    };
+
+    //! Returns TRUE if the layer of \a layerElem can be read in a background thread
+    static bool canReadLayerInThread( const QDomElement &layerElem );
+
+    /**
+     * Reads the layers of \a layerNodes which can be read in a background thread concurrently,
+     * into \a preparedLayers.
+     */
+    void prepareLayers( const QVector<QDomNode> &layerNodes, std::vector< PreparedLayer > &preparedLayers, QgsProject::ReadFlags flags );
+
+    //! Creates the empty layer for \a layerElem, returns nullptr if the type of layer is unknown
+    std::unique_ptr<QgsMapLayer> createLayer( const QDomElement &layerElem, QgsProject::ReadFlags flags ) const;
+
+    //! Returns the flags used to read the layers with the project read \a flags
+    static QgsMapLayer::ReadFlags layerReadFlags( QgsProject::ReadFlags flags );
+
+    //! Adds the \a mapLayer read from \a layerElem to the project
+    bool addReadLayer( std::unique_ptr<QgsMapLayer> mapLayer, bool layerIsValid, const QDomElement &layerElem, QList<QDomNode> &brokenNodes, QgsProject::ReadFlags flags );
+#endif
+
     /**
      * The optional \a flags argument can be used to control layer reading behavior.
      *
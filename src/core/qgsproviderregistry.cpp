@@ -21,6 +21,7 @@
 #include <QString>
 #include <QDir>
 #include <QLibrary>
+#include <QMutexLocker>
 
 #include "qgis.h"
 #include "qgsdataprovider.h"
@@ -36,6 +37,7 @@
 #include "providers/gdal/qgsgdalprovider.h"
 #include "providers/ogr/qgsogrprovider.h"
 #include "providers/meshmemory/qgsmeshmemorydataprovider.h"
+#include "processing/qgsprocessingfeaturepipe.h"
 #include "qgsruntimeprofiler.h"
 
 #ifdef HAVE_STATIC_PROVIDERS
@@ -123,6 +125,10 @@ void QgsProviderRegistry::init()
     QgsScopedRuntimeProfile profile( QObject::tr( "Create mesh memory layer provider" ) );
     mProviders[ QgsMeshMemoryDataProvider::providerKey() ] = new QgsProviderMetadata( QgsMeshMemoryDataProvider::providerKey(), QgsMeshMemoryDataProvider::providerDescription(), &QgsMeshMemoryDataProvider::createProvider );
   }
+  {
+    QgsScopedRuntimeProfile profile( QObject::tr( "Create processing feature pipe provider" ) );
+    mProviders[ QgsProcessingFeaturePipeProvider::providerKey() ] = new QgsProviderMetadata( QgsProcessingFeaturePipeProvider::providerKey(), QgsProcessingFeaturePipeProvider::providerDescription(), &QgsProcessingFeaturePipeProvider::createProvider );
+  }
   Q_NOWARN_DEPRECATED_POP
   {
     QgsScopedRuntimeProfile profile( QObject::tr( "Create GDAL provider" ) );
@@ -247,10 +253,27 @@ void QgsProviderRegistry::init()
   // now initialize all providers
   for ( Providers::const_iterator it = mProviders.begin(); it != mProviders.end(); ++it )
   {
-    const QString &key = it->first;
+    QgsScopedRuntimeProfile profile( QObject::tr( "Initialize %1" ).arg( it->first ) );
+
+    // call initProvider() - allows provider to register its services to QGIS
+    it->second->initProvider();
+  }
+
+  // the file filters and drivers are built on first use, enumerating the GDAL and OGR drivers is not
+  // needed by most headless applications
+} // QgsProviderRegistry ctor
+
 
-    QgsScopedRuntimeProfile profile( QObject::tr( "Initialize %1" ).arg( key ) );
+void QgsProviderRegistry::buildFileFilters() const
+{
+  QMutexLocker locker( &mFileFiltersMutex );
+  if ( mFileFiltersBuilt )
+    return;
 
+  QgsScopedRuntimeProfile profile( QObject::tr( "Build file filters" ) );
+  for ( Providers::const_iterator it = mProviders.begin(); it != mProviders.end(); ++it )
+  {
+    const QString &key = it->first;
     QgsProviderMetadata *meta = it->second;
 
     // now get vector file filters, if any
@@ -285,9 +308,6 @@ void QgsProviderRegistry::init()
       mMeshDatasetFileFilters += fileMeshDatasetFilters;
       QgsDebugMsgLevel( QStringLiteral( "Checking %1: ...loaded OK (%2 file dataset filters)" ).arg( key ).arg( mMeshDatasetFileFilters.split( ";;" ).count() ), 2 );
     }
-
-    // call initProvider() - allows provider to register its services to QGIS
-    meta->initProvider();
   }
 
   // load database drivers (only OGR)
@@ -298,8 +318,9 @@ void QgsProviderRegistry::init()
 
   // load protocol drivers (only OGR)
   mProtocolDrivers =  QgsOgrProviderUtils::protocolDrivers();
-} // QgsProviderRegistry ctor
 
+  mFileFiltersBuilt = true;
+}
 
 // typedef for the unload dataprovider function
 typedef void cleanupProviderFunction_t();
@@ -320,6 +341,16 @@ void QgsProviderRegistry::clean()
     ++it;
   }
   mProviders.clear();
+
+  QMutexLocker locker( &mFileFiltersMutex );
+  mFileFiltersBuilt = false;
+  mVectorFileFilters.clear();
+  mRasterFileFilters.clear();
+  mMeshFileFilters.clear();
+  mMeshDatasetFileFilters.clear();
+  mDatabaseDrivers.clear();
+  mDirectoryDrivers.clear();
+  mProtocolDrivers.clear();
 }
 
 bool QgsProviderRegistry::exists()
@@ -676,36 +707,43 @@ bool QgsProviderRegistry::registerProvider( QgsProviderMetadata *providerMetadat
 
 QString QgsProviderRegistry::fileVectorFilters() const
 {
+  buildFileFilters();
   return mVectorFileFilters;
 }
 
 QString QgsProviderRegistry::fileRasterFilters() const
 {
+  buildFileFilters();
   return mRasterFileFilters;
 }
 
 QString QgsProviderRegistry::fileMeshFilters() const
 {
+  buildFileFilters();
   return mMeshFileFilters;
 }
 
 QString QgsProviderRegistry::fileMeshDatasetFilters() const
 {
+  buildFileFilters();
   return mMeshDatasetFileFilters;
 }
 
 QString QgsProviderRegistry::databaseDrivers() const
 {
+  buildFileFilters();
   return mDatabaseDrivers;
 }
 
 QString QgsProviderRegistry::directoryDrivers() const
 {
+  buildFileFilters();
   return mDirectoryDrivers;
 }
 
 QString QgsProviderRegistry::protocolDrivers() const
 {
+  buildFileFilters();
   return mProtocolDrivers;
 }
 
@@ -23,6 +23,7 @@
 
 #include <QDir>
 #include <QLibrary>
+#include <QMutex>
 #include <QString>
 
 #include "qgsvectorlayerexporter.h"
@@ -371,6 +372,9 @@ class CORE_EXPORT QgsProviderRegistry
     void init();
     void clean();
 
+    //! Builds the file filters and the driver strings of the providers, on first use
+    void buildFileFilters() const;
+
     //! Associative container of provider metadata handles
     Providers mProviders;
 
@@ -380,28 +384,28 @@ class CORE_EXPORT QgsProviderRegistry
     /**
      * File filter string for vector files
      *
-     * Built once when registry is constructed by appending strings returned
-     * from iteratively calling vectorFileFilter() for each visited data
-     * provider.  The alternative would have been to do this each time
-     * fileVectorFilters was invoked; instead we only have to build it the
-     * one time.
+     * Built once, when the filters or the drivers are first requested, by
+     * appending strings returned from iteratively calling vectorFileFilter()
+     * for each visited data provider.  The alternative would have been to do
+     * this each time fileVectorFilters was invoked; instead we only have to
+     * build it the one time.
      */
-    QString mVectorFileFilters;
+    mutable QString mVectorFileFilters;
 
     /**
      * File filter string for raster files
      */
-    QString mRasterFileFilters;
+    mutable QString mRasterFileFilters;
 
     /**
      * File filter string for raster files
      */
-    QString mMeshFileFilters;
+    mutable QString mMeshFileFilters;
 
     /**
      * File filter string for raster files
      */
-    QString mMeshDatasetFileFilters;
+    mutable QString mMeshDatasetFileFilters;
 
     /**
      * Available database drivers string for vector databases
@@ -409,14 +413,14 @@ class CORE_EXPORT QgsProviderRegistry
      * This is a string of form:
      * DriverNameToShow,DriverName;DriverNameToShow,DriverName;...
      */
-    QString mDatabaseDrivers;
+    mutable QString mDatabaseDrivers;
 
     /**
      * Available directory drivers string for vector databases
      * This is a string of form:
      * DriverNameToShow,DriverName;DriverNameToShow,DriverName;...
      */
-    QString mDirectoryDrivers;
+    mutable QString mDirectoryDrivers;
 
     /**
      * Available protocol drivers string for vector databases
@@ -424,7 +428,11 @@ class CORE_EXPORT QgsProviderRegistry
      * This is a string of form:
      * DriverNameToShow,DriverName;DriverNameToShow,DriverName;...
      */
-    QString mProtocolDrivers;
+    mutable QString mProtocolDrivers;
+
+    //! Guards the lazy build of the file filters and of the driver strings
+    mutable QMutex mFileFiltersMutex;
+    mutable bool mFileFiltersBuilt = false;
 
     /**
      * Returns TRUE if registry instance exists.
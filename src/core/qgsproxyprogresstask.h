@@ -40,8 +40,12 @@ class CORE_EXPORT QgsProxyProgressTask : public QgsTask
 
     /**
      * Constructor for QgsProxyProgressTask, with the specified \a description.
+     *
+     * If \a canCancel is TRUE, the task can be canceled from the task manager, and the
+     * canceled() signal is emitted when it is. The proxied operation must then be
+     * stopped, and the task finalized (since QGIS 3.16).
      */
-    QgsProxyProgressTask( const QString &description );
+    QgsProxyProgressTask( const QString &description, bool canCancel = false );
 
     /**
      * Finalizes the task, with the specified \a result.
@@ -60,6 +64,17 @@ class CORE_EXPORT QgsProxyProgressTask : public QgsTask
      */
     void setProxyProgress( double progress );
 
+    void cancel() override;
+
+  signals:
+
+    /**
+     * Emitted when the task is canceled. The proxied operation should stop as soon as possible.
+     *
+     * \since QGIS 3.16
+     */
+    void canceled();
+
   private:
 
     QWaitCondition mNotFinishedWaitCondition;
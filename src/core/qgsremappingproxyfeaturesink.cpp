@@ -41,6 +41,26 @@ void QgsRemappingProxyFeatureSink::setTransformContext( const QgsCoordinateTrans
   mTransform = QgsCoordinateTransform( mDefinition.sourceCrs(), mDefinition.destinationCrs(), context );
 }
 
+//! Sets the \a geometry of a \a feature, reprojected with \a transform
+static void setReprojectedGeometry( QgsFeature &feature, QgsGeometry &geometry, const QgsCoordinateTransform &transform )
+{
+  // the geometries still shared with the source feature are only detached, and copied, when they are reprojected
+  if ( !transform.isShortCircuited() )
+  {
+    try
+    {
+      geometry.transform( transform );
+    }
+    catch ( QgsCsException & )
+    {
+      QgsLogger::warning( QObject::tr( "Error reprojecting feature geometry" ) );
+      feature.clearGeometry();
+      return;
+    }
+  }
+  feature.setGeometry( geometry );
+}
+
 QgsFeatureList QgsRemappingProxyFeatureSink::remapFeature( const QgsFeature &feature ) const
 {
   QgsFeatureList res;
@@ -48,58 +68,39 @@ QgsFeatureList QgsRemappingProxyFeatureSink::remapFeature( const QgsFeature &fea
   mContext.setFeature( feature );
 
   // remap fields first
-  QgsFeature f;
-  f.setFields( mDefinition.destinationFields(), true );
-  QgsAttributes attributes;
+  const QgsFields destinationFields = mDefinition.destinationFields();
   const QMap< QString, QgsProperty > fieldMap = mDefinition.fieldMap();
-  for ( const QgsField &field : mDefinition.destinationFields() )
+  QgsAttributes attributes;
+  attributes.reserve( destinationFields.count() );
+  for ( const QgsField &field : destinationFields )
   {
-    if ( fieldMap.contains( field.name() ) )
-    {
-      attributes.append( fieldMap.value( field.name() ).value( mContext ) );
-    }
-    else
-    {
-      attributes.append( QVariant() );
-    }
+    const auto it = fieldMap.constFind( field.name() );
+    attributes.append( it != fieldMap.constEnd() ? it.value().value( mContext ) : QVariant() );
   }
+  QgsFeature f;
+  f.setFields( destinationFields, false );
   f.setAttributes( attributes );
 
   // make geometries compatible, and reproject if necessary
+  QVector< QgsGeometry > geometries;
   if ( feature.hasGeometry() )
+    geometries = feature.geometry().coerceToType( mDefinition.destinationWkbType() );
+  if ( geometries.isEmpty() )
   {
-    const QVector< QgsGeometry > geometries = feature.geometry().coerceToType( mDefinition.destinationWkbType() );
-    if ( !geometries.isEmpty() )
-    {
-      res.reserve( geometries.size() );
-      for ( const QgsGeometry &geometry : geometries )
-      {
-        QgsFeature featurePart = f;
-
-        QgsGeometry reproject = geometry;
-        try
-        {
-          reproject.transform( mTransform );
-          featurePart.setGeometry( reproject );
-        }
-        catch ( QgsCsException & )
-        {
-          QgsLogger::warning( QObject::tr( "Error reprojecting feature geometry" ) );
-          featurePart.clearGeometry();
-        }
-        res << featurePart;
-      }
-    }
-    else
-    {
-      f.clearGeometry();
-      res << f;
-    }
+    res << f;
+    return res;
   }
-  else
+
+  res.reserve( geometries.size() );
+  for ( int i = 0; i < geometries.size() - 1; ++i )
   {
-    res << f;
+    QgsFeature featurePart = f;
+    setReprojectedGeometry( featurePart, geometries[i], mTransform );
+    res << featurePart;
   }
+  // the last part is set on the remapped feature itself, which avoids detaching a copy of it
+  setReprojectedGeometry( f, geometries.last(), mTransform );
+  res << f;
   return res;
 }
 
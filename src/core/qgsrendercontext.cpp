@@ -70,6 +70,7 @@ QgsRenderContext::QgsRenderContext( const QgsRenderContext &rh )
   , mClippingRegions( rh.mClippingRegions )
   , mFeatureClipGeometry( rh.mFeatureClipGeometry )
   , mTextureOrigin( rh.mTextureOrigin )
+  , mApproximateCoordTransform( rh.mApproximateCoordTransform )
 #ifdef QGISDEBUG
   , mHasTransformContext( rh.mHasTransformContext )
 #endif
@@ -106,6 +107,7 @@ QgsRenderContext &QgsRenderContext::operator=( const QgsRenderContext &rh )
   mClippingRegions = rh.mClippingRegions;
   mFeatureClipGeometry = rh.mFeatureClipGeometry;
   mTextureOrigin = rh.mTextureOrigin;
+  mApproximateCoordTransform = rh.mApproximateCoordTransform;
   setIsTemporal( rh.isTemporal() );
   if ( isTemporal() )
     setTemporalRange( rh.temporalRange() );
@@ -217,6 +219,12 @@ QgsRenderContext QgsRenderContext::fromMapSettings( const QgsMapSettings &mapSet
   ctx.setFlag( RenderBlocking, mapSettings.testFlag( QgsMapSettings::RenderBlocking ) );
   ctx.setFlag( LosslessImageRendering, mapSettings.testFlag( QgsMapSettings::LosslessImageRendering ) );
   ctx.setFlag( Render3DMap, mapSettings.testFlag( QgsMapSettings::Render3DMap ) );
+  ctx.setFlag( ParallelFeatureRendering, mapSettings.testFlag( QgsMapSettings::ParallelFeatureRendering ) );
+  ctx.setFlag( GpuRendering, mapSettings.testFlag( QgsMapSettings::GpuRendering ) );
+  ctx.setFlag( ApproximateReprojection, mapSettings.testFlag( QgsMapSettings::ApproximateReprojection ) );
+  ctx.setFlag( ParallelRasterRendering, mapSettings.testFlag( QgsMapSettings::ParallelRasterRendering ) );
+  ctx.setFlag( RecordRenderingStatistics, mapSettings.testFlag( QgsMapSettings::RecordRenderingStatistics ) );
+  ctx.setFlag( PrefetchTiles, mapSettings.testFlag( QgsMapSettings::PrefetchTiles ) );
   ctx.setScaleFactor( mapSettings.outputDpi() / 25.4 ); // = pixels per mm
   ctx.setRendererScale( mapSettings.scale() );
   ctx.setExpressionContext( mapSettings.expressionContext() );
@@ -271,6 +279,7 @@ bool QgsRenderContext::showSelection() const
 void QgsRenderContext::setCoordinateTransform( const QgsCoordinateTransform &t )
 {
   mCoordTransform = t;
+  mApproximateCoordTransform.reset();
 }
 
 void QgsRenderContext::setDrawEditingInformation( bool b )
@@ -39,6 +39,7 @@
 
 class QPainter;
 class QgsAbstractGeometry;
+class QgsApproximateCoordinateTransform;
 class QgsLabelingEngine;
 class QgsMapSettings;
 class QgsRenderedFeatureHandlerInterface;
@@ -84,6 +85,13 @@ class CORE_EXPORT QgsRenderContext : public QgsTemporalRangeObject
       LosslessImageRendering   = 0x1000, //!< Render images losslessly whenever possible, instead of the default lossy jpeg rendering used for some destination devices (e.g. PDF). This flag only works with builds based on Qt 5.13 or later.
       ApplyScalingWorkaroundForTextRendering = 0x2000, //!< Whether a scaling workaround designed to stablise the rendering of small font sizes (or for painters scaled out by a large amount) when rendering text. Generally this is recommended, but it may incur some performance cost.
       Render3DMap              = 0x4000, //!< Render is for a 3D map
+      ParallelFeatureRendering = 0x8000, //!< Render the features of vector layers with several threads, each one drawing a horizontal band of the destination image (since QGIS 3.16)
+      GpuRendering             = 0x10000, //!< Draw the features of vector layers with OpenGL in an offscreen framebuffer, when possible (since QGIS 3.16)
+      ProgressiveRendering     = 0x20000, //!< Draw a simplified preview of the features within a short time budget, replaced by the full rendering when it is finished (since QGIS 3.16)
+      ApproximateReprojection  = 0x40000, //!< Reproject the vertices of vector layers by interpolation in a grid of the rendered extent, within a quarter of a pixel of the exact transform (since QGIS 3.16)
+      ParallelRasterRendering  = 0x80000, //!< Render raster layers in horizontal bands drawn in parallel, when possible (since QGIS 3.16)
+      RecordRenderingStatistics = 0x100000, //!< Record the statistics of the rendering of the layers, see QgsMapLayerRenderer::statistics() (since QGIS 3.16)
+      PrefetchTiles            = 0x200000, //!< Request the tiles around the map extent of tiled remote layers in the background, for an interactive map canvas (since QGIS 3.16)
     };
     Q_DECLARE_FLAGS( Flags, Flag )
 
@@ -243,6 +251,29 @@ class CORE_EXPORT QgsRenderContext : public QgsTemporalRangeObject
      */
     QgsCoordinateTransform coordinateTransform() const {return mCoordTransform;}
 
+#ifndef SIP_RUN
+
+    /**
+     * Returns the approximation of coordinateTransform() to use for rendering, or NULLPTR
+     * if the coordinates must be transformed exactly.
+     *
+     * \see setApproximateCoordinateTransform()
+     * \note not available in Python bindings
+     * \since QGIS 3.16
+     */
+    const QgsApproximateCoordinateTransform *approximateCoordinateTransform() const { return mApproximateCoordTransform.get(); }
+
+    /**
+     * Sets the approximation of coordinateTransform() to use for rendering. It is
+     * reset by setCoordinateTransform().
+     *
+     * \see approximateCoordinateTransform()
+     * \note not available in Python bindings
+     * \since QGIS 3.16
+     */
+    void setApproximateCoordinateTransform( const std::shared_ptr< const QgsApproximateCoordinateTransform > &transform ) { mApproximateCoordTransform = transform; }
+#endif
+
     /**
      * A general purpose distance and area calculator, capable of performing ellipsoid based calculations.
      * \since QGIS 3.0
@@ -951,6 +982,8 @@ class CORE_EXPORT QgsRenderContext : public QgsTemporalRangeObject
 
     QPointF mTextureOrigin;
 
+    std::shared_ptr< const QgsApproximateCoordinateTransform > mApproximateCoordTransform;
+
 #ifdef QGISDEBUG
     bool mHasTransformContext = false;
 #endif
@@ -219,6 +219,17 @@ class CORE_EXPORT QgsRuntimeProfiler : public QAbstractItemModel
      */
     void end( const QString &group = "startup" );
 
+    /**
+     * Records a profile event with the given \a name, whose duration \a time (in seconds)
+     * has been measured elsewhere, as a child of the current event of \a group.
+     *
+     * This allows timings collected by other components (e.g. the per layer rendering
+     * times of a map render job) to be part of the profile.
+     *
+     * \since QGIS 3.16
+     */
+    void record( const QString &name, double time, const QString &group = "startup" );
+
     /**
      * Returns the profile time for the specified \a name.
      * \since QGIS 3.14
@@ -0,0 +1,224 @@
+/***************************************************************************
+                         qgssimplifiedgeometrycache.cpp
+                         ------------------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgssimplifiedgeometrycache.h"
+#include "qgis.h"
+#include "qgsfeatureiterator.h"
+#include "qgsfeaturesource.h"
+#include "qgsgeometrysimplifier.h"
+#include "qgssimplifymethod.h"
+#include "qgstaskmanager.h"
+
+#include <QMutexLocker>
+
+#include <cmath>
+
+///@cond PRIVATE
+
+//! Builds a level of a QgsSimplifiedGeometryCache from the features of a source
+class QgsSimplifiedGeometryCacheTask : public QgsTask
+{
+  public:
+
+    QgsSimplifiedGeometryCacheTask( const std::shared_ptr< QgsSimplifiedGeometryCache > &cache, int level, QgsAbstractFeatureSource *source, const QString &layerName )
+      : QgsTask( QObject::tr( "Simplifying geometries of %1" ).arg( layerName ) )
+      , mCache( cache )
+      , mLevel( level )
+      , mGeneration( cache->generation() )
+      , mMaximumCost( cache->maximumCost() )
+      , mSource( source )
+    {
+    }
+
+    bool run() override
+    {
+      QgsSimplifyMethod simplifyMethod;
+      simplifyMethod.setMethodType( QgsSimplifyMethod::OptimizeForRendering );
+      simplifyMethod.setTolerance( QgsSimplifiedGeometryCache::levelTolerance( mLevel ) );
+      std::unique_ptr< QgsAbstractGeometrySimplifier > simplifier( QgsSimplifyMethod::createGeometrySimplifier( simplifyMethod ) );
+
+      QgsFeatureIterator fit = mSource->getFeatures( QgsFeatureRequest().setNoAttributes() );
+      QgsFeature feature;
+      while ( fit.nextFeature( feature ) )
+      {
+        if ( isCanceled() || mCost > mMaximumCost )
+          return false;
+
+        if ( !feature.hasGeometry() )
+          continue;
+
+        const QgsGeometry geometry = simplifier->simplify( feature.geometry() );
+        if ( geometry.isNull() )
+          continue;
+
+        mCost += geometry.constGet()->wkbSize() + sizeof( QgsFeatureId ) + sizeof( QgsGeometry );
+        mGeometries.insert( feature.id(), geometry );
+      }
+      return true;
+    }
+
+    void finished( bool result ) override
+    {
+      const std::shared_ptr< QgsSimplifiedGeometryCache > cache = mCache.lock();
+      if ( !cache )
+        return;
+
+      // a level too large for the cache is stored anyway, so that it is not requested again
+      if ( result || mCost > mMaximumCost )
+        cache->insertLevel( mLevel, mGeneration, mGeometries, mCost );
+      else
+        cache->abortLevel( mLevel, mGeneration );
+    }
+
+  private:
+
+    std::weak_ptr< QgsSimplifiedGeometryCache > mCache;
+    int mLevel = 0;
+    int mGeneration = 0;
+    qint64 mMaximumCost = 0;
+    qint64 mCost = 0;
+    std::unique_ptr< QgsAbstractFeatureSource > mSource;
+    QHash<QgsFeatureId, QgsGeometry> mGeometries;
+};
+
+///@endcond
+
+int QgsSimplifiedGeometryCache::levelForTolerance( double tolerance )
+{
+  return static_cast< int >( std::floor( std::log2( tolerance ) ) );
+}
+
+double QgsSimplifiedGeometryCache::levelTolerance( int level )
+{
+  return std::ldexp( 1.0, level );
+}
+
+void QgsSimplifiedGeometryCache::setMaximumCost( qint64 cost )
+{
+  QMutexLocker locker( &mMutex );
+  mMaximumCost = cost;
+}
+
+qint64 QgsSimplifiedGeometryCache::maximumCost() const
+{
+  QMutexLocker locker( &mMutex );
+  return mMaximumCost;
+}
+
+void QgsSimplifiedGeometryCache::setLayerExtent( const QgsRectangle &extent )
+{
+  QMutexLocker locker( &mMutex );
+  mLayerExtent = extent;
+}
+
+bool QgsSimplifiedGeometryCache::geometries( int level, QHash<QgsFeatureId, QgsGeometry> &geometries ) const
+{
+  QMutexLocker locker( &mMutex );
+  const auto it = mLevels.find( level );
+  if ( it == mLevels.end() )
+    return false;
+
+  it->lastUsed = ++mUseCounter;
+  // implicitly shared, nothing is copied
+  geometries = it->geometries;
+  return true;
+}
+
+void QgsSimplifiedGeometryCache::requestLevel( int level, const QgsRectangle &rect )
+{
+  QMutexLocker locker( &mMutex );
+  if ( mLevels.contains( level ) || mBuilding.contains( level ) || mTooLarge.contains( level ) )
+    return;
+
+  // zoomed in views fetch a small part of the layer, building the level would cost more than it saves
+  if ( !rect.isNull() && ( mLayerExtent.isEmpty() || rect.intersect( mLayerExtent ).area() < mLayerExtent.area() * MINIMUM_COVERAGE ) )
+    return;
+
+  mRequested.insert( level );
+}
+
+QList<int> QgsSimplifiedGeometryCache::takeRequestedLevels()
+{
+  QMutexLocker locker( &mMutex );
+  const QList<int> levels = qgis::setToList( mRequested );
+  mBuilding.unite( mRequested );
+  mRequested.clear();
+  return levels;
+}
+
+bool QgsSimplifiedGeometryCache::insertLevel( int level, int generation, const QHash<QgsFeatureId, QgsGeometry> &geometries, qint64 cost )
+{
+  QMutexLocker locker( &mMutex );
+  if ( generation != mGeneration )
+    return false;
+
+  mBuilding.remove( level );
+  if ( cost > mMaximumCost )
+  {
+    mTooLarge.insert( level );
+    return false;
+  }
+
+  // least recently used levels first
+  while ( !mLevels.isEmpty() && mCost + cost > mMaximumCost )
+  {
+    auto oldest = mLevels.begin();
+    for ( auto it = mLevels.begin(); it != mLevels.end(); ++it )
+    {
+      if ( it->lastUsed < oldest->lastUsed )
+        oldest = it;
+    }
+    mCost -= oldest->cost;
+    mLevels.erase( oldest );
+  }
+
+  Level &entry = mLevels[ level ];
+  entry.geometries = geometries;
+  entry.cost = cost;
+  entry.lastUsed = ++mUseCounter;
+  mCost += cost;
+  return true;
+}
+
+void QgsSimplifiedGeometryCache::abortLevel( int level, int generation )
+{
+  QMutexLocker locker( &mMutex );
+  if ( generation == mGeneration )
+    mBuilding.remove( level );
+}
+
+int QgsSimplifiedGeometryCache::generation() const
+{
+  QMutexLocker locker( &mMutex );
+  return mGeneration;
+}
+
+void QgsSimplifiedGeometryCache::clear()
+{
+  QMutexLocker locker( &mMutex );
+  mLevels.clear();
+  mRequested.clear();
+  mBuilding.clear();
+  mTooLarge.clear();
+  mCost = 0;
+  ++mGeneration;
+}
+
+QgsTask *QgsSimplifiedGeometryCache::createBuildTask( const std::shared_ptr< QgsSimplifiedGeometryCache > &cache, int level, QgsAbstractFeatureSource *source, const QString &layerName )
+{
+  return new QgsSimplifiedGeometryCacheTask( cache, level, source, layerName );
+}
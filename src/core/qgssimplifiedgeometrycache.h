@@ -0,0 +1,148 @@
+/***************************************************************************
+                         qgssimplifiedgeometrycache.h
+                         ----------------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSSIMPLIFIEDGEOMETRYCACHE_H
+#define QGSSIMPLIFIEDGEOMETRYCACHE_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+#include "qgsfeatureid.h"
+#include "qgsgeometry.h"
+#include "qgsrectangle.h"
+
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QSet>
+
+#include <memory>
+
+class QgsAbstractFeatureSource;
+class QgsTask;
+
+/**
+ * \ingroup core
+ * \class QgsSimplifiedGeometryCache
+ * \brief Multi-resolution store of the geometries of a vector layer, simplified for rendering.
+ *
+ * Each level holds the geometries of all the features of the layer, simplified
+ * with the QgsSimplifyMethod::OptimizeForRendering method and a tolerance of
+ * 2^level layer units. When a layer is rendered with a simplification tolerance
+ * whose level is available, QgsVectorLayerFeatureIterator fetches the features
+ * from the provider without their geometries and takes them from the cache
+ * instead, so that the full resolution geometries are neither transferred nor
+ * parsed nor simplified again.
+ *
+ * Levels are requested by the iterators with requestLevel() when the rendered
+ * extent covers a large part of the layer (small scale views), and are built by
+ * a background task created with createBuildTask(). The levels are evicted,
+ * least recently used first, when their total size exceeds maximumCost().
+ * A level which does not fit alone is not requested again until clear().
+ *
+ * The cache is thread-safe.
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.16
+ */
+class CORE_EXPORT QgsSimplifiedGeometryCache
+{
+  public:
+
+    //! Returns the level whose tolerance is the largest one not greater than \a tolerance
+    static int levelForTolerance( double tolerance );
+
+    //! Returns the simplification tolerance, in layer units, of the geometries of \a level
+    static double levelTolerance( int level );
+
+    //! Sets the maximum size (in bytes) of the cached geometries
+    void setMaximumCost( qint64 cost );
+
+    //! Returns the maximum size (in bytes) of the cached geometries
+    qint64 maximumCost() const;
+
+    //! Sets the \a extent of the layer, in layer units, used to decide whether a level is worth building
+    void setLayerExtent( const QgsRectangle &extent );
+
+    /**
+     * Sets \a geometries to the simplified geometries of \a level, by feature id.
+     * Returns FALSE if the level is not available.
+     */
+    bool geometries( int level, QHash<QgsFeatureId, QgsGeometry> &geometries ) const;
+
+    /**
+     * Requests the level to be built, if the features are fetched in \a rect (in
+     * layer units, null for the whole layer) and \a rect covers a large part of
+     * the layer extent.
+     * \see takeRequestedLevels()
+     */
+    void requestLevel( int level, const QgsRectangle &rect );
+
+    /**
+     * Returns the requested levels which are neither available nor being built.
+     * They are then considered as being built, until insertLevel() or abortLevel()
+     * is called for them.
+     */
+    QList<int> takeRequestedLevels();
+
+    /**
+     * Stores the simplified \a geometries of \a level, whose building started at
+     * the cache \a generation. Returns FALSE if the geometries are discarded
+     * because the cache was cleared in between or because they are too large.
+     */
+    bool insertLevel( int level, int generation, const QHash<QgsFeatureId, QgsGeometry> &geometries, qint64 cost );
+
+    //! Cancels the building of \a level started at the cache \a generation, it may be requested again
+    void abortLevel( int level, int generation );
+
+    //! Returns the generation of the cache, incremented by clear()
+    int generation() const;
+
+    //! Removes all the levels, for instance when the features of the layer changed
+    void clear();
+
+    /**
+     * Creates a task building \a level of \a cache from the features of \a source,
+     * which is owned by the task. The task only holds a weak reference to the cache.
+     */
+    static QgsTask *createBuildTask( const std::shared_ptr< QgsSimplifiedGeometryCache > &cache, int level, QgsAbstractFeatureSource *source, const QString &layerName );
+
+  private:
+
+    struct Level
+    {
+      QHash<QgsFeatureId, QgsGeometry> geometries;
+      qint64 cost = 0;
+      quint64 lastUsed = 0;
+    };
+
+    //! Fraction of the layer extent a request must cover for a level to be built
+    static constexpr double MINIMUM_COVERAGE = 0.25;
+
+    mutable QMutex mMutex;
+    mutable QMap<int, Level> mLevels;
+    mutable quint64 mUseCounter = 0;
+    QSet<int> mRequested;
+    QSet<int> mBuilding;
+    QSet<int> mTooLarge;
+    QgsRectangle mLayerExtent;
+    qint64 mCost = 0;
+    qint64 mMaximumCost = 64 * 1024 * 1024;
+    int mGeneration = 0;
+};
+
+#endif // QGSSIMPLIFIEDGEOMETRYCACHE_H
@@ -0,0 +1,121 @@
+/***************************************************************************
+                         qgsspatialindexcache.cpp
+                         ------------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsspatialindexcache.h"
+#include "qgslogger.h"
+#include "qgsproviderregistry.h"
+#include "qgssettings.h"
+#include "qgsspatialindexpackedrtree.h"
+#include "qgsvectorlayer.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+QString QgsSpatialIndexCache::cacheDirectory()
+{
+  // next to the network cache
+  QString directory = QgsSettings().value( QStringLiteral( "cache/directory" ) ).toString();
+  if ( directory.isEmpty() )
+    directory = QStandardPaths::writableLocation( QStandardPaths::CacheLocation );
+  return QDir( directory ).filePath( QStringLiteral( "spatialindex" ) );
+}
+
+bool QgsSpatialIndexCache::isCacheable( const QgsVectorLayer *layer )
+{
+  return layer && layer->isValid() && !layer->isModified() && !sourceFilePath( layer ).isEmpty();
+}
+
+bool QgsSpatialIndexCache::storeIndex( const QgsVectorLayer *layer, const QgsSpatialIndexPackedRTree &index )
+{
+  if ( !isCacheable( layer ) )
+    return false;
+
+  if ( !QDir().mkpath( cacheDirectory() ) )
+    return false;
+
+  QSaveFile file( indexFilePath( layer ) );
+  if ( !file.open( QIODevice::WriteOnly ) )
+    return false;
+
+  QDataStream stream( &file );
+  stream << contentKey( layer );
+  if ( stream.status() != QDataStream::Ok || !index.write( &file ) )
+  {
+    file.cancelWriting();
+    return false;
+  }
+  return file.commit();
+}
+
+bool QgsSpatialIndexCache::loadIndex( const QgsVectorLayer *layer, QgsSpatialIndexPackedRTree &index )
+{
+  if ( !isCacheable( layer ) )
+    return false;
+
+  QFile file( indexFilePath( layer ) );
+  if ( !file.open( QIODevice::ReadOnly ) )
+    return false;
+
+  // an index of a previous version of the file is not valid anymore
+  QDataStream stream( &file );
+  QString key;
+  stream >> key;
+  if ( stream.status() != QDataStream::Ok || key != contentKey( layer ) )
+    return false;
+
+  if ( !index.read( &file ) )
+  {
+    QgsDebugMsg( QStringLiteral( "Invalid cached spatial index %1" ).arg( file.fileName() ) );
+    return false;
+  }
+  return true;
+}
+
+void QgsSpatialIndexCache::removeIndex( const QgsVectorLayer *layer )
+{
+  if ( layer && !sourceFilePath( layer ).isEmpty() )
+    QFile::remove( indexFilePath( layer ) );
+}
+
+QString QgsSpatialIndexCache::sourceFilePath( const QgsVectorLayer *layer )
+{
+  const QString path = QgsProviderRegistry::instance()->decodeUri( layer->providerType(), layer->source() ).value( QStringLiteral( "path" ) ).toString();
+  if ( path.isEmpty() || !QFileInfo( path ).isFile() )
+    return QString();
+  return path;
+}
+
+QString QgsSpatialIndexCache::indexFilePath( const QgsVectorLayer *layer )
+{
+  // the features of a given source and subset are indexed in the same file, whatever the version of the source file
+  const QString source = QStringLiteral( "%1\n%2\n%3" ).arg( layer->providerType(), layer->source(), layer->subsetString() );
+  const QString name = QString::fromLatin1( QCryptographicHash::hash( source.toUtf8(), QCryptographicHash::Sha1 ).toHex() );
+  return QDir( cacheDirectory() ).filePath( QStringLiteral( "%1.qsi" ).arg( name ) );
+}
+
+QString QgsSpatialIndexCache::contentKey( const QgsVectorLayer *layer )
+{
+  const QFileInfo fileInfo( sourceFilePath( layer ) );
+  return QStringLiteral( "%1\n%2\n%3\n%4\n%5" ).arg( layer->providerType(), layer->source(), layer->subsetString() )
+         .arg( fileInfo.size() ).arg( fileInfo.lastModified().toMSecsSinceEpoch() );
+}
@@ -0,0 +1,89 @@
+/***************************************************************************
+                         qgsspatialindexcache.h
+                         ----------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSSPATIALINDEXCACHE_H
+#define QGSSPATIALINDEXCACHE_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+
+#include <QString>
+
+class QgsSpatialIndexPackedRTree;
+class QgsVectorLayer;
+
+/**
+ * \class QgsSpatialIndexCache
+ * \ingroup core
+ *
+ * An on-disk cache of the spatial indexes of file based layers whose data provider cannot
+ * create a native index, like GeoJSON or CSV files.
+ *
+ * The indexes are QgsSpatialIndexPackedRTree of the bounding boxes of the features, in the
+ * CRS of the layer. An index is identified by the provider, the source and the subset string
+ * of the layer, and is only returned while the size and the modification time of the file
+ * are the ones recorded when the index was stored.
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.16
+ */
+class CORE_EXPORT QgsSpatialIndexCache
+{
+  public:
+
+    /**
+     * Returns the directory of the cached indexes, in the QGIS cache directory.
+     */
+    static QString cacheDirectory();
+
+    /**
+     * Returns TRUE if an index of \a layer can be cached: its source must be a local file,
+     * and it must not have uncommitted changes.
+     */
+    static bool isCacheable( const QgsVectorLayer *layer );
+
+    /**
+     * Stores the \a index of all the features of \a layer, replacing a previous one.
+     * Returns FALSE if the layer is not cacheable or if the index could not be written.
+     */
+    static bool storeIndex( const QgsVectorLayer *layer, const QgsSpatialIndexPackedRTree &index );
+
+    /**
+     * Sets \a index to the cached index of \a layer.
+     * Returns FALSE if there is no valid cached index for the current content of the layer.
+     */
+    static bool loadIndex( const QgsVectorLayer *layer, QgsSpatialIndexPackedRTree &index );
+
+    /**
+     * Removes the cached index of \a layer, if there is one.
+     */
+    static void removeIndex( const QgsVectorLayer *layer );
+
+  private:
+
+    //! Returns the path of the source file of \a layer, or an empty string if it is not a local file
+    static QString sourceFilePath( const QgsVectorLayer *layer );
+
+    //! Returns the path of the cached index of \a layer
+    static QString indexFilePath( const QgsVectorLayer *layer );
+
+    //! Returns the key identifying the content indexed for \a layer, stored in the cached index
+    static QString contentKey( const QgsVectorLayer *layer );
+};
+
+#endif // QGSSPATIALINDEXCACHE_H
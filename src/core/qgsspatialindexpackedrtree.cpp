@@ -0,0 +1,587 @@
+/***************************************************************************
+                         qgsspatialindexpackedrtree.cpp
+                         ------------------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsspatialindexpackedrtree.h"
+#include "qgsfeatureiterator.h"
+#include "qgsfeaturesource.h"
+#include "qgsfeedback.h"
+#include "qgsgeometry.h"
+
+#include <QAtomicInt>
+#include <QDataStream>
+#include <QIODevice>
+#include <QMutex>
+#include <QSysInfo>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <vector>
+
+///@cond PRIVATE
+
+//! Minimum number of items processed by each thread when building or querying in parallel
+static const std::size_t ITEMS_PER_THREAD = 16384;
+
+/**
+ * Calls \a function on consecutive ranges of [0, \a count), on the global thread pool
+ * if there are enough items to share.
+ */
+static void parallelFor( std::size_t count, std::size_t itemsPerThread, const std::function< void( std::size_t, std::size_t ) > &function )
+{
+  const std::size_t threadCount = static_cast< std::size_t >( std::max( 1, QThreadPool::globalInstance()->maxThreadCount() ) );
+  const std::size_t rangeSize = std::max( itemsPerThread, ( count + threadCount - 1 ) / threadCount );
+  if ( threadCount == 1 || count <= rangeSize )
+  {
+    function( 0, count );
+    return;
+  }
+
+  std::vector< std::pair< std::size_t, std::size_t > > ranges;
+  for ( std::size_t begin = 0; begin < count; begin += rangeSize )
+    ranges.emplace_back( begin, std::min( count, begin + rangeSize ) );
+  QtConcurrent::blockingMap( ranges, [&function]( const std::pair< std::size_t, std::size_t > &range )
+  {
+    function( range.first, range.second );
+  } );
+}
+
+//! Identifies the data written by QgsSpatialIndexPackedRTree::write()
+static const quint32 SERIALIZATION_MAGIC = 0x51535052; // "QSPR"
+static const quint32 SERIALIZATION_VERSION = 1;
+
+//! Writes the size and the raw content of \a values
+template< typename T >
+static bool writeArray( QDataStream &stream, const std::vector< T > &values )
+{
+  stream << static_cast< quint64 >( values.size() );
+  const qint64 bytes = static_cast< qint64 >( values.size() * sizeof( T ) );
+  return bytes == 0 || stream.writeRawData( reinterpret_cast< const char * >( values.data() ), bytes ) == bytes;
+}
+
+//! Reads values written by writeArray(), checking that the device holds them before allocating
+template< typename T >
+static bool readArray( QDataStream &stream, std::vector< T > &values )
+{
+  quint64 size = 0;
+  stream >> size;
+  if ( stream.status() != QDataStream::Ok || size > static_cast< quint64 >( stream.device()->bytesAvailable() ) / sizeof( T ) )
+    return false;
+
+  values.resize( static_cast< std::size_t >( size ) );
+  const qint64 bytes = static_cast< qint64 >( size * sizeof( T ) );
+  return bytes == 0 || stream.readRawData( reinterpret_cast< char * >( values.data() ), bytes ) == bytes;
+}
+
+//! Returns the position of ( \a x, \a y ) along a Hilbert curve filling a 65536 x 65536 grid
+static quint32 hilbertIndex( quint32 x, quint32 y )
+{
+  quint32 index = 0;
+  for ( quint32 s = 1 << 15; s > 0; s >>= 1 )
+  {
+    const quint32 rx = ( x & s ) > 0 ? 1 : 0;
+    const quint32 ry = ( y & s ) > 0 ? 1 : 0;
+    index += s * s * ( ( 3 * rx ) ^ ry );
+    // rotate the quadrant so that the curve is continuous
+    if ( ry == 0 )
+    {
+      if ( rx == 1 )
+      {
+        x = 0xFFFF - x;
+        y = 0xFFFF - y;
+      }
+      std::swap( x, y );
+    }
+  }
+  return index;
+}
+
+class QgsSpatialIndexPackedRTreePrivate
+{
+  public:
+
+    QgsSpatialIndexPackedRTreePrivate( int nodeSize )
+      : nodeSize( static_cast< std::size_t >( std::max( 2, nodeSize ) ) )
+    {}
+
+    //! Adds an item to the index, before build()
+    void addItem( QgsFeatureId id, const QgsRectangle &box )
+    {
+      if ( !( box.xMinimum() <= box.xMaximum() ) || !( box.yMinimum() <= box.yMaximum() ) )
+        return;
+
+      ids.push_back( id );
+      boxes.push_back( box.xMinimum() );
+      boxes.push_back( box.yMinimum() );
+      boxes.push_back( box.xMaximum() );
+      boxes.push_back( box.yMaximum() );
+    }
+
+    //! Sorts the items along a Hilbert curve, then packs them into the nodes of the tree
+    void build();
+
+    //! Returns the end of the level of the node at \a nodeIndex
+    std::size_t levelEnd( std::size_t nodeIndex ) const
+    {
+      return *std::upper_bound( levelBounds.begin(), levelBounds.end(), nodeIndex );
+    }
+
+    //! Returns the index of the first child of the node at \a nodeIndex, which is not a leaf
+    std::size_t firstChild( std::size_t nodeIndex ) const
+    {
+      return children[ nodeIndex - numItems ];
+    }
+
+    void intersects( const QgsRectangle &rectangle, const std::function< void( QgsFeatureId ) > &visitor ) const;
+
+    QAtomicInt ref = 1;
+    std::size_t nodeSize = QgsSpatialIndexPackedRTree::DEFAULT_NODE_SIZE;
+    std::size_t numItems = 0;
+    //! End of each level of nodes, from the leaves to the root
+    std::vector< std::size_t > levelBounds;
+    //! Bounding boxes of the nodes, as xmin, ymin, xmax, ymax, from the leaves to the root
+    std::vector< double > boxes;
+    //! Index of the first child of each node above the leaves
+    std::vector< std::size_t > children;
+    //! Ids of the leaves
+    std::vector< QgsFeatureId > ids;
+};
+
+void QgsSpatialIndexPackedRTreePrivate::build()
+{
+  numItems = ids.size();
+  if ( numItems == 0 )
+    return;
+
+  std::size_t count = numItems;
+  std::size_t numNodes = count;
+  levelBounds.push_back( numNodes );
+  do
+  {
+    count = ( count + nodeSize - 1 ) / nodeSize;
+    numNodes += count;
+    levelBounds.push_back( numNodes );
+  }
+  while ( count != 1 );
+
+  double xMin = std::numeric_limits< double >::max();
+  double yMin = std::numeric_limits< double >::max();
+  double xMax = std::numeric_limits< double >::lowest();
+  double yMax = std::numeric_limits< double >::lowest();
+  for ( std::size_t i = 0; i < numItems; ++i )
+  {
+    xMin = std::min( xMin, boxes[ 4 * i ] );
+    yMin = std::min( yMin, boxes[ 4 * i + 1 ] );
+    xMax = std::max( xMax, boxes[ 4 * i + 2 ] );
+    yMax = std::max( yMax, boxes[ 4 * i + 3 ] );
+  }
+
+  // the items are sorted by the Hilbert index of their center, in sorted blocks which are then merged
+  const double xScale = xMax > xMin ? 0xFFFF / ( xMax - xMin ) : 0;
+  const double yScale = yMax > yMin ? 0xFFFF / ( yMax - yMin ) : 0;
+  std::vector< std::pair< quint32, std::size_t > > keys( numItems );
+  std::vector< std::size_t > blocks;
+  QMutex blocksMutex;
+  parallelFor( numItems, ITEMS_PER_THREAD, [&]( std::size_t begin, std::size_t end )
+  {
+    for ( std::size_t i = begin; i < end; ++i )
+    {
+      const quint32 x = static_cast< quint32 >( ( ( boxes[ 4 * i ] + boxes[ 4 * i + 2 ] ) / 2 - xMin ) * xScale );
+      const quint32 y = static_cast< quint32 >( ( ( boxes[ 4 * i + 1 ] + boxes[ 4 * i + 3 ] ) / 2 - yMin ) * yScale );
+      keys[ i ] = std::make_pair( hilbertIndex( x, y ), i );
+    }
+    std::sort( keys.begin() + begin, keys.begin() + end );
+    QMutexLocker locker( &blocksMutex );
+    blocks.push_back( begin );
+  } );
+  std::sort( blocks.begin(), blocks.end() );
+  blocks.push_back( numItems );
+  while ( blocks.size() > 2 )
+  {
+    std::vector< std::size_t > merges;
+    for ( std::size_t i = 0; i + 2 < blocks.size(); i += 2 )
+      merges.push_back( i );
+    QtConcurrent::blockingMap( merges, [&keys, &blocks]( std::size_t i )
+    {
+      std::inplace_merge( keys.begin() + blocks[ i ], keys.begin() + blocks[ i + 1 ], keys.begin() + blocks[ i + 2 ] );
+    } );
+
+    std::vector< std::size_t > merged;
+    for ( std::size_t i = 0; i < blocks.size(); i += 2 )
+      merged.push_back( blocks[ i ] );
+    if ( merged.back() != numItems )
+      merged.push_back( numItems );
+    blocks = merged;
+  }
+
+  // the leaves are stored in the sorted order
+  std::vector< double > itemBoxes;
+  itemBoxes.swap( boxes );
+  std::vector< QgsFeatureId > itemIds;
+  itemIds.swap( ids );
+  boxes.resize( 4 * numNodes );
+  ids.resize( numItems );
+  parallelFor( numItems, ITEMS_PER_THREAD, [&]( std::size_t begin, std::size_t end )
+  {
+    for ( std::size_t i = begin; i < end; ++i )
+    {
+      const std::size_t item = keys[ i ].second;
+      std::copy( itemBoxes.begin() + 4 * item, itemBoxes.begin() + 4 * item + 4, boxes.begin() + 4 * i );
+      ids[ i ] = itemIds[ item ];
+    }
+  } );
+
+  // each node of a level covers the next nodeSize nodes of the level below
+  children.resize( numNodes - numItems );
+  for ( std::size_t level = 0; level + 1 < levelBounds.size(); ++level )
+  {
+    const std::size_t childrenBegin = level == 0 ? 0 : levelBounds[ level - 1 ];
+    const std::size_t childrenEnd = levelBounds[ level ];
+    const std::size_t nodesBegin = childrenEnd;
+    const std::size_t nodesEnd = levelBounds[ level + 1 ];
+    parallelFor( nodesEnd - nodesBegin, ITEMS_PER_THREAD / nodeSize, [&]( std::size_t begin, std::size_t end )
+    {
+      for ( std::size_t i = begin; i < end; ++i )
+      {
+        const std::size_t node = nodesBegin + i;
+        const std::size_t first = childrenBegin + i * nodeSize;
+        const std::size_t last = std::min( first + nodeSize, childrenEnd );
+        double nodeXMin = std::numeric_limits< double >::max();
+        double nodeYMin = std::numeric_limits< double >::max();
+        double nodeXMax = std::numeric_limits< double >::lowest();
+        double nodeYMax = std::numeric_limits< double >::lowest();
+        for ( std::size_t child = first; child < last; ++child )
+        {
+          nodeXMin = std::min( nodeXMin, boxes[ 4 * child ] );
+          nodeYMin = std::min( nodeYMin, boxes[ 4 * child + 1 ] );
+          nodeXMax = std::max( nodeXMax, boxes[ 4 * child + 2 ] );
+          nodeYMax = std::max( nodeYMax, boxes[ 4 * child + 3 ] );
+        }
+        boxes[ 4 * node ] = nodeXMin;
+        boxes[ 4 * node + 1 ] = nodeYMin;
+        boxes[ 4 * node + 2 ] = nodeXMax;
+        boxes[ 4 * node + 3 ] = nodeYMax;
+        children[ node - numItems ] = first;
+      }
+    } );
+  }
+}
+
+void QgsSpatialIndexPackedRTreePrivate::intersects( const QgsRectangle &rectangle, const std::function< void( QgsFeatureId ) > &visitor ) const
+{
+  if ( numItems == 0 )
+    return;
+
+  const double xMin = rectangle.xMinimum();
+  const double yMin = rectangle.yMinimum();
+  const double xMax = rectangle.xMaximum();
+  const double yMax = rectangle.yMaximum();
+
+  // the nodes are visited by groups of siblings, starting from the root
+  std::vector< std::size_t > stack;
+  std::size_t nodeIndex = boxes.size() / 4 - 1;
+  while ( true )
+  {
+    const std::size_t end = std::min( nodeIndex + nodeSize, levelEnd( nodeIndex ) );
+    for ( std::size_t node = nodeIndex; node < end; ++node )
+    {
+      if ( xMax < boxes[ 4 * node ] || yMax < boxes[ 4 * node + 1 ] || xMin > boxes[ 4 * node + 2 ] || yMin > boxes[ 4 * node + 3 ] )
+        continue;
+
+      if ( nodeIndex < numItems )
+        visitor( ids[ node ] );
+      else
+        stack.push_back( firstChild( node ) );
+    }
+
+    if ( stack.empty() )
+      break;
+    nodeIndex = stack.back();
+    stack.pop_back();
+  }
+}
+
+///@endcond
+
+QgsSpatialIndexPackedRTree::QgsSpatialIndexPackedRTree( QgsFeatureIterator &fi, QgsFeedback *feedback, int nodeSize )
+  : d( new QgsSpatialIndexPackedRTreePrivate( nodeSize ) )
+{
+  QgsFeature f;
+  while ( fi.nextFeature( f ) )
+  {
+    if ( feedback && feedback->isCanceled() )
+      break;
+
+    if ( f.hasGeometry() )
+      d->addItem( f.id(), f.geometry().boundingBox() );
+  }
+  d->build();
+}
+
+QgsSpatialIndexPackedRTree::QgsSpatialIndexPackedRTree( const QgsFeatureSource &source, QgsFeedback *feedback, int nodeSize )
+  : d( new QgsSpatialIndexPackedRTreePrivate( nodeSize ) )
+{
+  const long count = source.featureCount();
+  if ( count > 0 )
+  {
+    d->ids.reserve( static_cast< std::size_t >( count ) );
+    d->boxes.reserve( 4 * static_cast< std::size_t >( count ) );
+  }
+
+  QgsFeatureIterator it = source.getFeatures( QgsFeatureRequest().setNoAttributes() );
+  QgsFeature f;
+  while ( it.nextFeature( f ) )
+  {
+    if ( feedback && feedback->isCanceled() )
+      break;
+
+    if ( f.hasGeometry() )
+      d->addItem( f.id(), f.geometry().boundingBox() );
+  }
+  d->build();
+}
+
+QgsSpatialIndexPackedRTree::QgsSpatialIndexPackedRTree( const QVector< QgsFeatureId > &ids, const QVector< QgsRectangle > &boundingBoxes, int nodeSize )
+  : d( new QgsSpatialIndexPackedRTreePrivate( nodeSize ) )
+{
+  const int count = std::min( ids.size(), boundingBoxes.size() );
+  d->ids.reserve( static_cast< std::size_t >( count ) );
+  d->boxes.reserve( 4 * static_cast< std::size_t >( count ) );
+  for ( int i = 0; i < count; ++i )
+    d->addItem( ids.at( i ), boundingBoxes.at( i ) );
+  d->build();
+}
+
+QgsSpatialIndexPackedRTree::QgsSpatialIndexPackedRTree( const QgsSpatialIndexPackedRTree &other )
+  : d( other.d )
+{
+  d->ref.ref();
+}
+
+QgsSpatialIndexPackedRTree &QgsSpatialIndexPackedRTree::operator=( const QgsSpatialIndexPackedRTree &other )
+{
+  if ( this != &other )
+  {
+    if ( !d->ref.deref() )
+    {
+      delete d;
+    }
+
+    d = other.d;
+    d->ref.ref();
+  }
+  return *this;
+}
+
+QgsSpatialIndexPackedRTree::~QgsSpatialIndexPackedRTree()
+{
+  if ( !d->ref.deref() )
+    delete d;
+}
+
+QList< QgsFeatureId > QgsSpatialIndexPackedRTree::intersects( const QgsRectangle &rectangle ) const
+{
+  QList< QgsFeatureId > result;
+  d->intersects( rectangle, [&result]( QgsFeatureId id ) { result << id; } );
+  return result;
+}
+
+void QgsSpatialIndexPackedRTree::intersects( const QgsRectangle &rectangle, const std::function< void( QgsFeatureId ) > &visitor ) const
+{
+  d->intersects( rectangle, visitor );
+}
+
+QVector< QList< QgsFeatureId > > QgsSpatialIndexPackedRTree::intersects( const QVector< QgsRectangle > &rectangles ) const
+{
+  QVector< QList< QgsFeatureId > > results( rectangles.size() );
+  QList< QgsFeatureId > *resultsData = results.data();
+  const QgsSpatialIndexPackedRTreePrivate *index = d;
+  // a query is much cheaper than building, smaller ranges balance the threads better
+  parallelFor( static_cast< std::size_t >( rectangles.size() ), 64, [&]( std::size_t begin, std::size_t end )
+  {
+    for ( std::size_t i = begin; i < end; ++i )
+    {
+      QList< QgsFeatureId > &result = resultsData[ i ];
+      index->intersects( rectangles.at( static_cast< int >( i ) ), [&result]( QgsFeatureId id ) { result << id; } );
+    }
+  } );
+  return results;
+}
+
+QList< QgsFeatureId > QgsSpatialIndexPackedRTree::nearestNeighbor( const QgsPointXY &point, int neighbors, double maxDistance ) const
+{
+  QList< QgsFeatureId > result;
+  if ( d->numItems == 0 || neighbors < 1 )
+    return result;
+
+  struct Candidate
+  {
+    double distance;
+    std::size_t index;
+    bool leaf;
+
+    bool operator>( const Candidate &other ) const
+    {
+      return distance > other.distance;
+    }
+  };
+
+  const double x = point.x();
+  const double y = point.y();
+  const double maxDistanceSquared = maxDistance > 0 ? maxDistance * maxDistance : std::numeric_limits< double >::infinity();
+  std::priority_queue< Candidate, std::vector< Candidate >, std::greater< Candidate > > queue;
+  std::size_t nodeIndex = d->boxes.size() / 4 - 1;
+  while ( true )
+  {
+    const std::size_t end = std::min( nodeIndex + d->nodeSize, d->levelEnd( nodeIndex ) );
+    for ( std::size_t node = nodeIndex; node < end; ++node )
+    {
+      const double *box = d->boxes.data() + 4 * node;
+      const double dx = x < box[0] ? box[0] - x : ( x > box[2] ? x - box[2] : 0 );
+      const double dy = y < box[1] ? box[1] - y : ( y > box[3] ? y - box[3] : 0 );
+      const double distance = dx * dx + dy * dy;
+      if ( distance > maxDistanceSquared )
+        continue;
+
+      if ( nodeIndex < d->numItems )
+        queue.push( Candidate{ distance, node, true } );
+      else
+        queue.push( Candidate{ distance, d->firstChild( node ), false } );
+    }
+
+    // the leaves closer than any remaining node are the nearest
+    while ( !queue.empty() && queue.top().leaf )
+    {
+      result << d->ids[ queue.top().index ];
+      queue.pop();
+      if ( result.size() == neighbors )
+        return result;
+    }
+
+    if ( queue.empty() )
+      break;
+    nodeIndex = queue.top().index;
+    queue.pop();
+  }
+  return result;
+}
+
+QgsRectangle QgsSpatialIndexPackedRTree::boundingBox( QgsFeatureId id ) const
+{
+  for ( std::size_t i = 0; i < d->numItems; ++i )
+  {
+    if ( d->ids[ i ] == id )
+      return QgsRectangle( d->boxes[ 4 * i ], d->boxes[ 4 * i + 1 ], d->boxes[ 4 * i + 2 ], d->boxes[ 4 * i + 3 ], false );
+  }
+  return QgsRectangle();
+}
+
+QgsRectangle QgsSpatialIndexPackedRTree::extent() const
+{
+  if ( d->numItems == 0 )
+    return QgsRectangle();
+
+  const double *box = d->boxes.data() + d->boxes.size() - 4;
+  return QgsRectangle( box[0], box[1], box[2], box[3], false );
+}
+
+qgssize QgsSpatialIndexPackedRTree::size() const
+{
+  return d->numItems;
+}
+
+bool QgsSpatialIndexPackedRTree::write( QIODevice *device ) const
+{
+  QDataStream stream( device );
+  stream << SERIALIZATION_MAGIC << SERIALIZATION_VERSION << static_cast< quint8 >( QSysInfo::ByteOrder );
+  stream << static_cast< quint64 >( d->nodeSize ) << static_cast< quint64 >( d->numItems );
+
+  std::vector< quint64 > levelBounds( d->levelBounds.begin(), d->levelBounds.end() );
+  std::vector< quint64 > children( d->children.begin(), d->children.end() );
+  if ( !writeArray( stream, levelBounds ) || !writeArray( stream, d->boxes ) || !writeArray( stream, children ) || !writeArray( stream, d->ids ) )
+    return false;
+  return stream.status() == QDataStream::Ok;
+}
+
+bool QgsSpatialIndexPackedRTree::read( QIODevice *device )
+{
+  QDataStream stream( device );
+  quint32 magic = 0;
+  quint32 version = 0;
+  quint8 byteOrder = 0;
+  quint64 nodeSize = 0;
+  quint64 numItems = 0;
+  stream >> magic >> version >> byteOrder >> nodeSize >> numItems;
+  if ( stream.status() != QDataStream::Ok || magic != SERIALIZATION_MAGIC || version != SERIALIZATION_VERSION
+       || byteOrder != static_cast< quint8 >( QSysInfo::ByteOrder ) || nodeSize < 2 || nodeSize > static_cast< quint64 >( std::numeric_limits< int >::max() ) )
+    return false;
+
+  std::unique_ptr< QgsSpatialIndexPackedRTreePrivate > data = qgis::make_unique< QgsSpatialIndexPackedRTreePrivate >( static_cast< int >( nodeSize ) );
+  data->numItems = static_cast< std::size_t >( numItems );
+  std::vector< quint64 > levelBounds;
+  std::vector< quint64 > children;
+  if ( !readArray( stream, levelBounds ) || !readArray( stream, data->boxes ) || !readArray( stream, children ) || !readArray( stream, data->ids ) )
+    return false;
+
+  // the queries trust the structure of the tree, so it is checked before replacing the index
+  if ( data->ids.size() != data->numItems )
+    return false;
+  if ( data->numItems == 0 )
+  {
+    if ( !levelBounds.empty() || !data->boxes.empty() || !children.empty() )
+      return false;
+  }
+  else
+  {
+    if ( levelBounds.size() < 2 || levelBounds.front() != numItems )
+      return false;
+    for ( std::size_t level = 1; level < levelBounds.size(); ++level )
+    {
+      const quint64 levelCount = levelBounds[ level ] - levelBounds[ level - 1 ];
+      const quint64 childCount = levelBounds[ level - 1 ] - ( level == 1 ? 0 : levelBounds[ level - 2 ] );
+      if ( levelBounds[ level ] <= levelBounds[ level - 1 ] || levelCount != ( childCount + nodeSize - 1 ) / nodeSize )
+        return false;
+    }
+    if ( levelBounds.back() - levelBounds[ levelBounds.size() - 2 ] != 1 )
+      return false;
+
+    const quint64 numNodes = levelBounds.back();
+    if ( data->boxes.size() != 4 * numNodes || children.size() != numNodes - numItems )
+      return false;
+    for ( std::size_t level = 0; level + 1 < levelBounds.size(); ++level )
+    {
+      const quint64 childrenBegin = level == 0 ? 0 : levelBounds[ level - 1 ];
+      for ( quint64 node = levelBounds[ level ]; node < levelBounds[ level + 1 ]; ++node )
+      {
+        if ( children[ node - numItems ] != childrenBegin + ( node - levelBounds[ level ] ) * nodeSize )
+          return false;
+      }
+    }
+  }
+
+  data->levelBounds.assign( levelBounds.begin(), levelBounds.end() );
+  data->children.assign( children.begin(), children.end() );
+
+  if ( !d->ref.deref() )
+    delete d;
+  d = data.release();
+  return true;
+}
@@ -0,0 +1,166 @@
+/***************************************************************************
+                         qgsspatialindexpackedrtree.h
+                         ----------------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSSPATIALINDEXPACKEDRTREE_H
+#define QGSSPATIALINDEXPACKEDRTREE_H
+
+#define SIP_NO_FILE
+
+class QgsFeatureIterator;
+class QgsFeedback;
+class QgsFeatureSource;
+class QIODevice;
+class QgsSpatialIndexPackedRTreePrivate;
+
+#include "qgis_core.h"
+#include "qgsfeatureid.h"
+#include "qgspointxy.h"
+#include "qgsrectangle.h"
+#include <QList>
+#include <QVector>
+#include <functional>
+
+/**
+ * \class QgsSpatialIndexPackedRTree
+ * \ingroup core
+ *
+ * A fast static spatial index for feature bounding boxes, based on a packed Hilbert R-tree.
+ *
+ * The index is bulk loaded once: the bounding boxes are sorted along a Hilbert curve, then
+ * packed into full nodes, stored level by level in flat arrays. Compared to QgsSpatialIndex, this index:
+ *
+ * - is static (features cannot be added or removed from the index after construction)
+ * - is much faster to build, on several threads, and to query
+ * - uses much less memory, with no allocation per node
+ * - can run a batch of queries in parallel
+ *
+ * QgsSpatialIndexPackedRTree objects are implicitly shared and can be inexpensively copied. Queries
+ * are safe to run from several threads at once.
+ *
+ * \see QgsSpatialIndex, which is an general, mutable index for geometry bounding boxes.
+ * \see QgsSpatialIndexKDBush, which is a static index for points.
+ * \note not available in Python bindings
+ * \since QGIS 3.16
+*/
+class CORE_EXPORT QgsSpatialIndexPackedRTree
+{
+  public:
+
+    /**
+     * Constructor - creates an index and bulk loads it with the bounding boxes of the features from the iterator.
+     *
+     * The optional \a feedback object can be used to allow cancellation of bulk feature loading. Ownership
+     * of \a feedback is not transferred, and callers must take care that the lifetime of feedback exceeds
+     * that of the spatial index construction.
+     *
+     * Features without geometry are ignored and not included in the index.
+     */
+    explicit QgsSpatialIndexPackedRTree( QgsFeatureIterator &fi, QgsFeedback *feedback = nullptr, int nodeSize = DEFAULT_NODE_SIZE );
+
+    /**
+     * Constructor - creates an index and bulk loads it with the bounding boxes of the features from the source.
+     *
+     * The optional \a feedback object can be used to allow cancellation of bulk feature loading. Ownership
+     * of \a feedback is not transferred, and callers must take care that the lifetime of feedback exceeds
+     * that of the spatial index construction.
+     *
+     * Features without geometry are ignored and not included in the index.
+     */
+    explicit QgsSpatialIndexPackedRTree( const QgsFeatureSource &source, QgsFeedback *feedback = nullptr, int nodeSize = DEFAULT_NODE_SIZE );
+
+    /**
+     * Constructor - creates an index of the \a boundingBoxes of the items with the matching \a ids, which
+     * must have the same size.
+     *
+     * Null bounding boxes are ignored and not included in the index.
+     */
+    QgsSpatialIndexPackedRTree( const QVector< QgsFeatureId > &ids, const QVector< QgsRectangle > &boundingBoxes, int nodeSize = DEFAULT_NODE_SIZE );
+
+    //! Copy constructor
+    QgsSpatialIndexPackedRTree( const QgsSpatialIndexPackedRTree &other );
+
+    //! Assignment operator
+    QgsSpatialIndexPackedRTree &operator=( const QgsSpatialIndexPackedRTree &other );
+
+    ~QgsSpatialIndexPackedRTree();
+
+    /**
+     * Returns the ids of the features whose bounding box intersects the specified \a rectangle.
+     */
+    QList< QgsFeatureId > intersects( const QgsRectangle &rectangle ) const;
+
+    /**
+     * Calls a \a visitor function for all features whose bounding box intersects the specified \a rectangle.
+     */
+    void intersects( const QgsRectangle &rectangle, const std::function< void( QgsFeatureId ) > &visitor ) const;
+
+    /**
+     * Returns the ids of the features whose bounding box intersects each of the \a rectangles.
+     *
+     * The queries run in parallel on the global thread pool, and the results are in the order of the \a rectangles.
+     */
+    QVector< QList< QgsFeatureId > > intersects( const QVector< QgsRectangle > &rectangles ) const;
+
+    /**
+     * Returns the ids of the nearest \a neighbors to a \a point, by the distance to their bounding box,
+     * closest first. If \a maxDistance is greater than 0, only the features whose bounding box is within
+     * this distance of the \a point are returned.
+     */
+    QList< QgsFeatureId > nearestNeighbor( const QgsPointXY &point, int neighbors = 1, double maxDistance = 0 ) const;
+
+    /**
+     * Returns the bounding box of the feature with the specified \a id, or a null rectangle if it is not in the index.
+     *
+     * The lookup scans the leaves of the index, it is not meant to be called for many features.
+     */
+    QgsRectangle boundingBox( QgsFeatureId id ) const;
+
+    /**
+     * Returns the extent of all the features in the index.
+     */
+    QgsRectangle extent() const;
+
+    /**
+     * Returns the size of the index, i.e. the number of features contained within the index.
+     */
+    qgssize size() const;
+
+    /**
+     * Writes the index to \a device, in a binary format which can be read back with read()
+     * on a machine with the same byte order.
+     *
+     * Returns FALSE if the data could not be written.
+     */
+    bool write( QIODevice *device ) const;
+
+    /**
+     * Replaces the index with one written by write() to \a device.
+     *
+     * Returns FALSE and leaves the index unchanged if the data are not a valid index.
+     */
+    bool read( QIODevice *device );
+
+    //! Default maximum number of children of a node
+    static const int DEFAULT_NODE_SIZE = 16;
+
+  private:
+
+    //! Implicitly shared data pointer
+    QgsSpatialIndexPackedRTreePrivate *d = nullptr;
+};
+
+#endif // QGSSPATIALINDEXPACKEDRTREE_H
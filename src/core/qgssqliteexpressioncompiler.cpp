@@ -21,14 +21,49 @@
 #include "qgsexpressionnodeimpl.h"
 #include "qgsexpression.h"
 #include "qgssqliteutils.h"
+#include "qgsgeometry.h"
+
+//! Returns the value of an integer literal \a node, \a ok is set to FALSE if the node is not an integer literal
+static qlonglong literalInteger( const QgsExpressionNode *node, bool &ok )
+{
+  ok = false;
+  if ( node->nodeType() != QgsExpressionNode::ntLiteral )
+    return 0;
+
+  const QVariant value = static_cast<const QgsExpressionNodeLiteral *>( node )->value();
+  if ( value.type() != QVariant::Int && value.type() != QVariant::LongLong )
+    return 0;
+
+  ok = true;
+  return value.toLongLong();
+}
 
 QgsSQLiteExpressionCompiler::QgsSQLiteExpressionCompiler( const QgsFields &fields )
   : QgsSqlExpressionCompiler( fields, QgsSqlExpressionCompiler::LikeIsCaseInsensitive | QgsSqlExpressionCompiler::IntegerDivisionResultsInInteger )
 {
 }
 
+void QgsSQLiteExpressionCompiler::setGeoPackageTable( const QString &table, const QString &geometryColumn, const QString &fidColumn, bool hasSpatialIndex )
+{
+  mTable = table;
+  mGeometryColumn = geometryColumn;
+  mFidColumn = fidColumn;
+  mHasSpatialIndex = hasSpatialIndex;
+}
+
+QgsSqlExpressionCompiler::Result QgsSQLiteExpressionCompiler::compile( const QgsExpression *exp )
+{
+  // the root node is the condition of the filter
+  mPredicatePosition = true;
+  return QgsSqlExpressionCompiler::compile( exp );
+}
+
 QgsSqlExpressionCompiler::Result QgsSQLiteExpressionCompiler::compileNode( const QgsExpressionNode *node, QString &result )
 {
+  // a node is only in a predicate position if its parent passed it on
+  const bool predicatePosition = mPredicatePosition;
+  mPredicatePosition = false;
+
   switch ( node->nodeType() )
   {
     case QgsExpressionNode::ntBinaryOperator:
@@ -36,6 +71,36 @@ QgsSqlExpressionCompiler::Result QgsSQLiteExpressionCompiler::compileNode( const
       const QgsExpressionNodeBinaryOperator *op = static_cast<const QgsExpressionNodeBinaryOperator *>( node );
       switch ( op->op() )
       {
+        case QgsExpressionNodeBinaryOperator::boAnd:
+        case QgsExpressionNodeBinaryOperator::boOr:
+        {
+          if ( !predicatePosition )
+            return QgsSqlExpressionCompiler::compileNode( node, result );
+
+          // the operands of a filter condition are conditions too, which may be relaxed to a partial filter:
+          // the features are double-checked by QGIS, so an AND can even drop an operand which cannot be compiled
+          QString opL, opR;
+          mPredicatePosition = true;
+          const Result lr = compileNode( op->opLeft(), opL );
+          mPredicatePosition = true;
+          const Result rr = compileNode( op->opRight(), opR );
+          mPredicatePosition = false;
+
+          const bool leftCompiled = lr == Complete || lr == Partial;
+          const bool rightCompiled = rr == Complete || rr == Partial;
+          if ( leftCompiled && rightCompiled )
+          {
+            result = QStringLiteral( "(%1 %2 %3)" ).arg( opL, op->op() == QgsExpressionNodeBinaryOperator::boAnd ? QStringLiteral( "AND" ) : QStringLiteral( "OR" ), opR );
+            return lr == Complete && rr == Complete ? Complete : Partial;
+          }
+          else if ( op->op() == QgsExpressionNodeBinaryOperator::boAnd && ( leftCompiled || rightCompiled ) )
+          {
+            result = leftCompiled ? opL : opR;
+            return Partial;
+          }
+          return Fail;
+        }
+
         case QgsExpressionNodeBinaryOperator::boPow:
         case QgsExpressionNodeBinaryOperator::boRegexp:
           return Fail; //not supported by SQLite
@@ -68,19 +133,86 @@ QgsSqlExpressionCompiler::Result QgsSQLiteExpressionCompiler::compileNode( const
       const QgsExpressionNodeFunction *n = static_cast<const QgsExpressionNodeFunction *>( node );
       QgsExpressionFunction *fd = QgsExpression::Functions()[n->fnIndex()];
 
+      const QList<QgsExpressionNode *> args = n->args() ? n->args()->list() : QList<QgsExpressionNode *>();
+
       if ( fd->name() == QLatin1String( "make_datetime" ) || fd->name() == QLatin1String( "make_date" ) || fd->name() == QLatin1String( "make_time" ) )
       {
-        const auto constList = n->args()->list();
-        for ( const QgsExpressionNode *ln : constList )
+        for ( const QgsExpressionNode *ln : args )
         {
           if ( ln->nodeType() != QgsExpressionNode::ntLiteral )
             return Fail;
         }
       }
+      else if ( fd->name() == QLatin1String( "substr" ) )
+      {
+        // SQLite differs for a start <= 0 or a negative length
+        bool ok = false;
+        if ( args.size() < 2 || literalInteger( args.at( 1 ), ok ) <= 0 || !ok )
+          return Fail;
+        if ( args.size() > 2 && ( literalInteger( args.at( 2 ), ok ) < 0 || !ok ) )
+          return Fail;
+      }
+      else if ( fd->name() == QLatin1String( "left" ) || fd->name() == QLatin1String( "right" ) )
+      {
+        bool ok = false;
+        const qlonglong length = args.size() == 2 ? literalInteger( args.at( 1 ), ok ) : 0;
+        if ( !ok || length < 0 || ( length == 0 && fd->name() == QLatin1String( "right" ) ) )
+          return Fail;
+      }
+      else if ( fd->name() == QLatin1String( "replace" ) )
+      {
+        // QGIS replaces an empty string between each character, while SQLite leaves the string unchanged
+        if ( args.size() != 3 || args.at( 1 )->nodeType() != QgsExpressionNode::ntLiteral
+             || static_cast<const QgsExpressionNodeLiteral *>( args.at( 1 ) )->value().type() != QVariant::String
+             || static_cast<const QgsExpressionNodeLiteral *>( args.at( 1 ) )->value().toString().isEmpty() )
+          return Fail;
+      }
+      else if ( fd->name() == QLatin1String( "intersects" ) || fd->name() == QLatin1String( "bbox" )
+                || fd->name() == QLatin1String( "contains" ) || fd->name() == QLatin1String( "within" )
+                || fd->name() == QLatin1String( "overlaps" ) || fd->name() == QLatin1String( "touches" )
+                || fd->name() == QLatin1String( "crosses" ) || fd->name() == QLatin1String( "equals" ) )
+      {
+        // the R-tree lookup is a relaxed filter, which only stands in for a condition
+        if ( !predicatePosition )
+          return Fail;
+        return compileSpatialPredicate( n, result );
+      }
+      else if ( fd->name() == QLatin1String( "year" ) || fd->name() == QLatin1String( "month" ) || fd->name() == QLatin1String( "day" )
+                || fd->name() == QLatin1String( "hour" ) || fd->name() == QLatin1String( "minute" ) || fd->name() == QLatin1String( "second" ) )
+      {
+        return compileDatePart( n, result );
+      }
 
       return QgsSqlExpressionCompiler::compileNode( node, result );
     }
 
+    case QgsExpressionNode::ntCondition:
+    {
+      const QgsExpressionNodeCondition *n = static_cast<const QgsExpressionNodeCondition *>( node );
+
+      QString condition = QStringLiteral( "CASE" );
+      const QgsExpressionNodeCondition::WhenThenList conditions = n->conditions();
+      for ( const QgsExpressionNodeCondition::WhenThen *whenThen : conditions )
+      {
+        QString whenSql, thenSql;
+        if ( compileNode( whenThen->whenExp(), whenSql ) != Complete ||
+             compileNode( whenThen->thenExp(), thenSql ) != Complete )
+          return Fail;
+        condition += QStringLiteral( " WHEN %1 THEN %2" ).arg( whenSql, thenSql );
+      }
+
+      if ( n->elseExp() )
+      {
+        QString elseSql;
+        if ( compileNode( n->elseExp(), elseSql ) != Complete )
+          return Fail;
+        condition += QStringLiteral( " ELSE %1" ).arg( elseSql );
+      }
+
+      result = condition + QStringLiteral( " END" );
+      return Complete;
+    }
+
     default:
       break;
   }
@@ -88,6 +220,92 @@ QgsSqlExpressionCompiler::Result QgsSQLiteExpressionCompiler::compileNode( const
   return QgsSqlExpressionCompiler::compileNode( node, result );
 }
 
+QgsSqlExpressionCompiler::Result QgsSQLiteExpressionCompiler::compileSpatialPredicate( const QgsExpressionNodeFunction *node, QString &result )
+{
+  if ( !mHasSpatialIndex || mTable.isEmpty() || mGeometryColumn.isEmpty() || mFidColumn.isEmpty() )
+    return Fail;
+
+  const QList<QgsExpressionNode *> args = node->args() ? node->args()->list() : QList<QgsExpressionNode *>();
+  if ( args.size() != 2 )
+    return Fail;
+
+  auto isFeatureGeometry = []( const QgsExpressionNode * arg )
+  {
+    return arg->nodeType() == QgsExpressionNode::ntFunction
+           && QgsExpression::Functions()[static_cast<const QgsExpressionNodeFunction *>( arg )->fnIndex()]->name() == QLatin1String( "$geometry" );
+  };
+
+  const QgsExpressionNode *other = nullptr;
+  if ( isFeatureGeometry( args.at( 0 ) ) )
+    other = args.at( 1 );
+  else if ( isFeatureGeometry( args.at( 1 ) ) )
+    other = args.at( 0 );
+  else
+    return Fail;
+
+  // the other geometry must not depend on the feature, it is evaluated once
+  QgsExpression otherExpression( other->dump() );
+  if ( otherExpression.hasParserError() || otherExpression.needsGeometry()
+       || !otherExpression.referencedColumns().isEmpty() || !otherExpression.referencedVariables().isEmpty() )
+    return Fail;
+
+  const QVariant value = otherExpression.evaluate();
+  if ( otherExpression.hasEvalError() || !value.canConvert<QgsGeometry>() )
+    return Fail;
+
+  const QgsGeometry geometry = value.value<QgsGeometry>();
+  if ( geometry.isNull() || geometry.isEmpty() )
+    return Fail;
+
+  // all these predicates imply that the bounding boxes intersect, which the R-tree of the GeoPackage answers.
+  // Its boxes are rounded outwards, so the lookup returns a superset of the features which QGIS double-checks
+  const QgsRectangle box = geometry.boundingBox();
+  result = QStringLiteral( "%1 IN (SELECT id FROM %2 WHERE minx <= %3 AND maxx >= %4 AND miny <= %5 AND maxy >= %6)" )
+           .arg( quotedIdentifier( mFidColumn ),
+                 quotedIdentifier( QStringLiteral( "rtree_%1_%2" ).arg( mTable, mGeometryColumn ) ),
+                 qgsDoubleToString( box.xMaximum() ),
+                 qgsDoubleToString( box.xMinimum() ),
+                 qgsDoubleToString( box.yMaximum() ),
+                 qgsDoubleToString( box.yMinimum() ) );
+  return Partial;
+}
+
+QgsSqlExpressionCompiler::Result QgsSQLiteExpressionCompiler::compileDatePart( const QgsExpressionNodeFunction *node, QString &result )
+{
+  // only GeoPackage enforces the ISO 8601 formats of the dates, in UTC, which SQLite date functions read
+  if ( mTable.isEmpty() )
+    return Fail;
+
+  const QList<QgsExpressionNode *> args = node->args() ? node->args()->list() : QList<QgsExpressionNode *>();
+  if ( args.size() != 1 || args.at( 0 )->nodeType() != QgsExpressionNode::ntColumnRef )
+    return Fail;
+
+  const QString name = QgsExpression::Functions()[node->fnIndex()]->name();
+  const QString column = static_cast<const QgsExpressionNodeColumnRef *>( args.at( 0 ) )->name();
+  const int fieldIndex = mFields.lookupField( column );
+  if ( fieldIndex < 0 )
+    return Fail;
+
+  // the time parts of a date are not extracted by QGIS
+  const QVariant::Type type = mFields.at( fieldIndex ).type();
+  const bool isTimePart = name == QLatin1String( "hour" ) || name == QLatin1String( "minute" ) || name == QLatin1String( "second" );
+  if ( type != QVariant::DateTime && ( type != QVariant::Date || isTimePart ) )
+    return Fail;
+
+  static const QMap<QString, QString> FORMATS
+  {
+    { "year", "%Y" },
+    { "month", "%m" },
+    { "day", "%d" },
+    { "hour", "%H" },
+    { "minute", "%M" },
+    { "second", "%S" },
+  };
+
+  result = castToInt( QStringLiteral( "strftime('%1', %2)" ).arg( FORMATS.value( name ), quotedIdentifier( mFields.at( fieldIndex ).name() ) ) );
+  return Complete;
+}
+
 QString QgsSQLiteExpressionCompiler::quotedIdentifier( const QString &identifier )
 {
   return QgsSqliteUtils::quotedIdentifier( identifier );
@@ -106,8 +324,13 @@ QString QgsSQLiteExpressionCompiler::sqlFunctionFromFunctionName( const QString
     { "abs", "abs" },
     { "char", "char" },
     { "coalesce", "coalesce" },
+    { "left", "substr" },
     { "lower", "lower" },
+    { "replace", "replace" },
+    { "right", "substr" },
     { "round", "round" },
+    { "strpos", "instr" },
+    { "substr", "substr" },
     { "trim", "trim" },
     { "upper", "upper" },
     { "make_datetime", "" },
@@ -142,6 +365,14 @@ QStringList QgsSQLiteExpressionCompiler::sqlArgumentsFromFunctionName( const QSt
                         .arg( args[1].rightJustified( 2, '0' ) )
                         .arg( args[2].rightJustified( 2, '0' ) ) );
   }
+  else if ( fnName == QLatin1String( "left" ) )
+  {
+    args = QStringList() << args[0] << QStringLiteral( "1" ) << args[1];
+  }
+  else if ( fnName == QLatin1String( "right" ) )
+  {
+    args = QStringList() << args[0] << QStringLiteral( "-%1" ).arg( args[1] );
+  }
   return args;
 }
 
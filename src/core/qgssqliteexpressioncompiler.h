@@ -44,6 +44,19 @@ class CORE_EXPORT QgsSQLiteExpressionCompiler : public QgsSqlExpressionCompiler
      */
     explicit QgsSQLiteExpressionCompiler( const QgsFields &fields );
 
+    /**
+     * Sets the GeoPackage \a table being filtered, with its \a geometryColumn and \a fidColumn.
+     *
+     * This allows compiling the date and time functions, which expect the GeoPackage date
+     * formats, and if the table has a spatial index (\a hasSpatialIndex), the spatial predicates
+     * of the feature geometry against a constant geometry, as a partial filter on its R-tree.
+     *
+     * \since QGIS 3.16
+     */
+    void setGeoPackageTable( const QString &table, const QString &geometryColumn, const QString &fidColumn, bool hasSpatialIndex );
+
+    Result compile( const QgsExpression *exp ) override;
+
   protected:
 
     Result compileNode( const QgsExpressionNode *node, QString &str ) override;
@@ -55,6 +68,21 @@ class CORE_EXPORT QgsSQLiteExpressionCompiler : public QgsSqlExpressionCompiler
     QString castToInt( const QString &value ) const override;
     QString castToText( const QString &value ) const override;
 
+  private:
+
+    //! Compiles a spatial predicate of the feature geometry against a constant geometry as an R-tree lookup
+    Result compileSpatialPredicate( const QgsExpressionNodeFunction *node, QString &result );
+
+    //! Compiles an extraction of a date or time part
+    Result compileDatePart( const QgsExpressionNodeFunction *node, QString &result );
+
+    QString mTable;
+    QString mGeometryColumn;
+    QString mFidColumn;
+    bool mHasSpatialIndex = false;
+
+    //! TRUE while the node being compiled is a boolean condition of the filter, where a partial condition can be relaxed
+    bool mPredicatePosition = false;
 };
 
 ///@endcond
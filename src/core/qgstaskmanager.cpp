@@ -18,6 +18,8 @@
 #include "qgstaskmanager.h"
 #include "qgsproject.h"
 #include "qgsmaplayerlistutils.h"
+#include <algorithm>
+#include <limits>
 #include <mutex>
 #include <QtConcurrentRun>
 
@@ -837,18 +839,47 @@ void QgsTaskManager::processQueue()
   int prevActiveCount = countActiveTasks();
   mTaskMutex->lock();
   mActiveTasks.clear();
+
+  // count the started tasks of each resource class, and collect the tasks ready to start
+  QMap< QgsTask::ResourceClass, int > startedCounts;
+  QVector< QPair< int, long > > readyTasks;
   for ( QMap< long, TaskInfo >::iterator it = mTasks.begin(); it != mTasks.end(); ++it )
   {
     QgsTask *task = it.value().task;
-    if ( task && task->mStatus == QgsTask::Queued && dependenciesSatisfied( it.key() ) && it.value().added.testAndSetRelaxed( 0, 1 ) )
+    if ( !task )
+      continue;
+
+    const bool isFinished = task->mStatus == QgsTask::Complete || task->mStatus == QgsTask::Terminated;
+    if ( !isFinished )
     {
-      it.value().createRunnable();
-      QThreadPool::globalInstance()->start( it.value().runnable, it.value().priority );
+      mActiveTasks << task;
+      if ( it.value().runnable )
+        startedCounts[ task->resourceClass() ]++;
     }
 
-    if ( task && ( task->mStatus != QgsTask::Complete && task->mStatus != QgsTask::Terminated ) )
+    if ( task->mStatus == QgsTask::Queued && !it.value().runnable && dependenciesSatisfied( it.key() ) )
+      readyTasks << qMakePair( effectivePriority( it.value() ), it.key() );
+  }
+
+  // higher priorities first, then in submission order
+  std::sort( readyTasks.begin(), readyTasks.end(), []( const QPair< int, long > &task1, const QPair< int, long > &task2 )
+  {
+    return task1.first > task2.first || ( task1.first == task2.first && task1.second < task2.second );
+  } );
+
+  for ( const QPair< int, long > &readyTask : qgis::as_const( readyTasks ) )
+  {
+    TaskInfo &info = mTasks[ readyTask.second ];
+    const QgsTask::ResourceClass resourceClass = info.task->resourceClass();
+    const int maximumCount = mMaximumConcurrentTasks.value( resourceClass, -1 );
+    if ( maximumCount >= 0 && startedCounts.value( resourceClass ) >= maximumCount )
+      continue;
+
+    if ( info.added.testAndSetRelaxed( 0, 1 ) )
     {
-      mActiveTasks << task;
+      info.createRunnable();
+      startedCounts[ resourceClass ]++;
+      QThreadPool::globalInstance()->start( info.runnable, readyTask.first );
     }
   }
 
@@ -867,6 +898,33 @@ void QgsTaskManager::processQueue()
   }
 }
 
+int QgsTaskManager::effectivePriority( const TaskInfo &info )
+{
+  // a waiting task gains one priority level for each second spent in the queue, so that
+  // the tasks of low priority are eventually started before new tasks of higher priority
+  const qint64 agingSteps = info.queuedTimer.isValid() ? info.queuedTimer.elapsed() / 1000 : 0;
+  return static_cast< int >( std::min( static_cast< qint64 >( info.priority ) + agingSteps, static_cast< qint64 >( std::numeric_limits< int >::max() ) ) );
+}
+
+void QgsTaskManager::setMaximumConcurrentTasks( QgsTask::ResourceClass resourceClass, int count )
+{
+  mTaskMutex->lock();
+  if ( count < 0 )
+    mMaximumConcurrentTasks.remove( resourceClass );
+  else
+    mMaximumConcurrentTasks.insert( resourceClass, count );
+  mTaskMutex->unlock();
+
+  // tasks held by a lower limit may start now
+  processQueue();
+}
+
+int QgsTaskManager::maximumConcurrentTasks( QgsTask::ResourceClass resourceClass ) const
+{
+  QMutexLocker ml( mTaskMutex );
+  return mMaximumConcurrentTasks.value( resourceClass, -1 );
+}
+
 void QgsTaskManager::cancelDependentTasks( long taskId )
 {
   QgsTask *canceledTask = task( taskId );
@@ -897,7 +955,10 @@ QgsTaskManager::TaskInfo::TaskInfo( QgsTask *task, int priority )
   : task( task )
   , added( 0 )
   , priority( priority )
-{}
+{
+  if ( task )
+    queuedTimer.start();
+}
 
 void QgsTaskManager::TaskInfo::createRunnable()
 {
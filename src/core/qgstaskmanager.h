@@ -23,6 +23,7 @@
 #include <QMap>
 #include <QFuture>
 #include <QReadWriteLock>
+#include <QElapsedTimer>
 
 #include "qgis_core.h"
 #include "qgsmaplayer.h"
@@ -75,6 +76,19 @@ class CORE_EXPORT QgsTask : public QObject
     };
     Q_DECLARE_FLAGS( Flags, Flag )
 
+    /**
+     * Main resource used by a task. The number of tasks of a resource class running
+     * concurrently can be limited with QgsTaskManager::setMaximumConcurrentTasks().
+     * \since QGIS 3.16
+     */
+    enum ResourceClass
+    {
+      ResourceCpu, //!< Task mostly using the processor (the default)
+      ResourceIo, //!< Task mostly reading or writing files, e.g. an export
+      ResourceNetwork, //!< Task mostly waiting for network replies, e.g. a download
+    };
+    Q_ENUM( ResourceClass )
+
     /**
      * Constructor for QgsTask.
      * \param description text description of task
@@ -96,6 +110,21 @@ class CORE_EXPORT QgsTask : public QObject
      */
     void setDescription( const QString &description );
 
+    /**
+     * Sets the main resource used by the task. This must be called before adding the task to a
+     * QgsTaskManager, changing the resource class after queuing the task has no effect.
+     * \see resourceClass()
+     * \since QGIS 3.16
+     */
+    void setResourceClass( ResourceClass resourceClass ) { mResourceClass = resourceClass; }
+
+    /**
+     * Returns the main resource used by the task.
+     * \see setResourceClass()
+     * \since QGIS 3.16
+     */
+    ResourceClass resourceClass() const { return mResourceClass; }
+
     /**
      * Returns TRUE if the task can be canceled.
      */
@@ -301,6 +330,7 @@ class CORE_EXPORT QgsTask : public QObject
   private:
 
     Flags mFlags;
+    ResourceClass mResourceClass = ResourceCpu;
     QString mDescription;
     //! Status of this (parent) task alone
     TaskStatus mStatus = Queued;
@@ -512,6 +542,28 @@ class CORE_EXPORT QgsTaskManager : public QObject
      */
     int countActiveTasks() const;
 
+    /**
+     * Sets the maximum \a count of tasks of a \a resourceClass which are started
+     * concurrently. The other tasks of the resource class stay queued until a task
+     * of the class finishes. A negative \a count removes the limit, the tasks are
+     * then only limited by the global thread pool.
+     *
+     * By default, the tasks of all the resource classes are not limited.
+     *
+     * \see maximumConcurrentTasks()
+     * \since QGIS 3.16
+     */
+    void setMaximumConcurrentTasks( QgsTask::ResourceClass resourceClass, int count );
+
+    /**
+     * Returns the maximum count of tasks of a \a resourceClass which are started concurrently,
+     * or -1 if the tasks of the resource class are not limited.
+     *
+     * \see setMaximumConcurrentTasks()
+     * \since QGIS 3.16
+     */
+    int maximumConcurrentTasks( QgsTask::ResourceClass resourceClass ) const;
+
   public slots:
 
     /**
@@ -590,9 +642,17 @@ class CORE_EXPORT QgsTaskManager : public QObject
       QgsTask *task = nullptr;
       QAtomicInt added;
       int priority;
+      //! Measures the time spent in the queue, raising the priority of the waiting task
+      QElapsedTimer queuedTimer;
       QgsTaskRunnableWrapper *runnable = nullptr;
     };
 
+    //! Returns the priority of a task raised by the time it waited in the queue
+    static int effectivePriority( const TaskInfo &info );
+
+    //! Maximum count of concurrent tasks by resource class
+    QMap< QgsTask::ResourceClass, int > mMaximumConcurrentTasks;
+
     bool mInitialized = false;
 
     mutable QMutex *mTaskMutex;
@@ -622,7 +682,8 @@ class CORE_EXPORT QgsTaskManager : public QObject
 
     /**
      * Process the queue of outstanding jobs and starts up any
-     * which are ready to go.
+     * which are ready to go, by decreasing priority and within
+     * the limits of their resource classes.
      */
     void processQueue();
 
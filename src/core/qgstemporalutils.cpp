@@ -25,9 +25,15 @@
 #include "qgstemporalnavigationobject.h"
 #include "qgsmapdecoration.h"
 #include "qgsmapsettings.h"
-#include "qgsmaprenderercustompainterjob.h"
+#include "qgsmaprendererparalleljob.h"
 #include "qgsexpressioncontextutils.h"
 
+#include <QPainter>
+#include <QThread>
+
+#include <algorithm>
+#include <deque>
+
 QgsDateTimeRange QgsTemporalUtils::calculateTemporalRangeForProject( QgsProject *project )
 {
   const QMap<QString, QgsMapLayer *> &mapLayers = project->mapLayers();
@@ -81,27 +87,80 @@ bool QgsTemporalUtils::exportAnimation( const QgsMapSettings &mapSettings, const
   QgsTemporalNavigationObject navigator;
   navigator.setTemporalExtents( settings.animationRange );
   navigator.setFrameDuration( settings.frameDuration );
-  QgsMapSettings ms = mapSettings;
-  const QgsExpressionContext context = ms.expressionContext();
+  const QgsExpressionContext context = mapSettings.expressionContext();
 
   const long long totalFrames = navigator.totalFrameCount();
   long long currentFrame = 0;
 
-  while ( currentFrame < totalFrames )
+  // frames are rendered in parallel, with the layers of each frame also rendered in parallel,
+  // and saved in order as they finish
+  struct FrameJob
+  {
+    QString path;
+    QgsMapSettings settings;
+    std::unique_ptr< QgsMapRendererParallelJob > job;
+  };
+  std::deque< std::unique_ptr< FrameJob > > jobs;
+  const std::size_t maxRenderingFrames = static_cast< std::size_t >( std::max( 1, QThread::idealThreadCount() ) );
+  long long savedFrames = 0;
+
+  const auto saveFrame = [&settings, &jobs, &savedFrames]
+  {
+    std::unique_ptr< FrameJob > frameJob = std::move( jobs.front() );
+    jobs.pop_front();
+    frameJob->job->waitForFinished();
+    const QgsMapSettings &ms = frameJob->settings;
+
+    QImage img = QImage( ms.outputSize(), ms.outputImageFormat() );
+    img.setDotsPerMeterX( 1000 * ms.outputDpi() / 25.4 );
+    img.setDotsPerMeterY( 1000 * ms.outputDpi() / 25.4 );
+    img.fill( ms.backgroundColor().rgb() );
+
+    QPainter p( &img );
+    p.drawImage( 0, 0, frameJob->job->renderedImage() );
+
+    QgsRenderContext context = QgsRenderContext::fromMapSettings( ms );
+    context.setPainter( &p );
+
+    const auto constMDecorations = settings.decorations;
+    for ( QgsMapDecoration *decoration : constMDecorations )
+    {
+      decoration->render( ms, context );
+    }
+
+    p.end();
+
+    img.save( frameJob->path );
+    ++savedFrames;
+  };
+
+  while ( currentFrame < totalFrames || !jobs.empty() )
   {
     if ( feedback )
     {
       if ( feedback->isCanceled() )
       {
+        for ( const std::unique_ptr< FrameJob > &frameJob : jobs )
+          frameJob->job->cancel();
         error = QObject::tr( "Export canceled" );
         return false;
       }
-      feedback->setProgress( currentFrame / static_cast<double>( totalFrames ) * 100 );
+      feedback->setProgress( savedFrames / static_cast<double>( totalFrames ) * 100 );
     }
+
+    if ( currentFrame >= totalFrames || jobs.size() >= maxRenderingFrames )
+    {
+      saveFrame();
+      continue;
+    }
+
     ++currentFrame;
 
     navigator.setCurrentFrameNumber( currentFrame );
 
+    std::unique_ptr< FrameJob > frameJob = qgis::make_unique< FrameJob >();
+    QgsMapSettings &ms = frameJob->settings;
+    ms = mapSettings;
     ms.setIsTemporal( true );
     ms.setTemporalRange( navigator.dateTimeRangeForFrameNumber( currentFrame ) );
 
@@ -113,30 +172,11 @@ bool QgsTemporalUtils::exportAnimation( const QgsMapSettings &mapSettings, const
     QString fileName( settings.fileNameTemplate );
     const QString frameNoPaddedLeft( QStringLiteral( "%1" ).arg( currentFrame, numberOfDigits, 10, QChar( '0' ) ) ); // e.g. 0001
     fileName.replace( token, frameNoPaddedLeft );
-    const QString path = QDir( settings.outputDirectory ).filePath( fileName );
-
-    QImage img = QImage( ms.outputSize(), ms.outputImageFormat() );
-    img.setDotsPerMeterX( 1000 * ms.outputDpi() / 25.4 );
-    img.setDotsPerMeterY( 1000 * ms.outputDpi() / 25.4 );
-    img.fill( ms.backgroundColor().rgb() );
-
-    QPainter p( &img );
-    QgsMapRendererCustomPainterJob job( ms, &p );
-    job.start();
-    job.waitForFinished();
-
-    QgsRenderContext context = QgsRenderContext::fromMapSettings( ms );
-    context.setPainter( &p );
-
-    const auto constMDecorations = settings.decorations;
-    for ( QgsMapDecoration *decoration : constMDecorations )
-    {
-      decoration->render( ms, context );
-    }
-
-    p.end();
+    frameJob->path = QDir( settings.outputDirectory ).filePath( fileName );
 
-    img.save( path );
+    frameJob->job = qgis::make_unique< QgsMapRendererParallelJob >( ms );
+    frameJob->job->start();
+    jobs.push_back( std::move( frameJob ) );
   }
 
   return true;
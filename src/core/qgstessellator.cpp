@@ -27,11 +27,13 @@
 
 #include "poly2tri.h"
 
+#include <QtConcurrentMap>
 #include <QtDebug>
 #include <QMatrix4x4>
 #include <QVector3D>
 #include <QtMath>
 #include <algorithm>
+#include <numeric>
 #include <unordered_set>
 
 static std::pair<float, float> rotateCoords( float x, float y, float origin_x, float origin_y, float r )
@@ -798,6 +800,58 @@ void QgsTessellator::addPolygon( const QgsPolygon &polygon, float extrusionHeigh
     mZMax = zMax;
 }
 
+QVector<int> QgsTessellator::addPolygons( const QVector<const QgsPolygon *> &polygons, const QVector<float> &extrusionHeights )
+{
+  Q_ASSERT( polygons.size() == extrusionHeights.size() );
+
+  // each polygon is tessellated with a copy of this tessellator starting with no data
+  QgsTessellator emptyTessellator( *this );
+  emptyTessellator.mData.clear();
+  emptyTessellator.mZMin = std::numeric_limits<float>::max();
+  emptyTessellator.mZMax = std::numeric_limits<float>::min();
+  std::vector<QgsTessellator> tessellators( polygons.size(), emptyTessellator );
+
+  QVector<int> indexes( polygons.size() );
+  std::iota( indexes.begin(), indexes.end(), 0 );
+  QtConcurrent::blockingMap( indexes, [&]( int index )
+  {
+    tessellators[index].addPolygon( *polygons.at( index ), extrusionHeights.at( index ) );
+  } );
+
+  QVector<int> firstVertices;
+  firstVertices.reserve( polygons.size() );
+  int dataSize = mData.size();
+  for ( const QgsTessellator &tessellator : tessellators )
+    dataSize += tessellator.mData.size();
+  mData.reserve( dataSize );
+  for ( const QgsTessellator &tessellator : tessellators )
+  {
+    firstVertices << dataVerticesCount();
+    mData << tessellator.mData;
+    if ( tessellator.mZMin < mZMin )
+      mZMin = tessellator.mZMin;
+    if ( tessellator.mZMax > mZMax )
+      mZMax = tessellator.mZMax;
+  }
+  return firstVertices;
+}
+
+void QgsTessellator::addData( const QVector<float> &data )
+{
+  Q_ASSERT( data.size() % ( stride() / sizeof( float ) ) == 0 );
+
+  // the vertices are stored as (x, z, -y)
+  const int floatsPerVertex = stride() / sizeof( float );
+  for ( int i = 1; i < data.size(); i += floatsPerVertex )
+  {
+    if ( data.at( i ) < mZMin )
+      mZMin = data.at( i );
+    if ( data.at( i ) > mZMax )
+      mZMax = data.at( i );
+  }
+  mData << data;
+}
+
 QgsPoint getPointFromData( QVector< float >::const_iterator &it )
 {
   // tessellator geometry is x, z, -y
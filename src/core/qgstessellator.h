@@ -59,6 +59,27 @@ class CORE_EXPORT QgsTessellator
     //! Tessellates a triangle and adds its vertex entries to the output data array
     void addPolygon( const QgsPolygon &polygon, float extrusionHeight );
 
+    /**
+     * Tessellates the \a polygons, each one extruded by the matching item of \a extrusionHeights, and adds their
+     * vertex entries to the output data array in the order of the polygons. The polygons are tessellated in
+     * parallel on the global thread pool.
+     *
+     * Returns the index of the first vertex of each polygon in the output data array.
+     *
+     * \note not available in Python bindings
+     * \since QGIS 3.16
+     */
+    QVector<int> addPolygons( const QVector<const QgsPolygon *> &polygons, const QVector<float> &extrusionHeights ) SIP_SKIP;
+
+    /**
+     * Adds vertex entries to the output data array, which must have been built by a tessellator
+     * with the same settings, e.g. kept from an earlier tessellation of the same polygon.
+     *
+     * \note not available in Python bindings
+     * \since QGIS 3.16
+     */
+    void addData( const QVector<float> &data ) SIP_SKIP;
+
     /**
      * Returns array of triangle vertex data
      *
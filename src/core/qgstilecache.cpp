@@ -32,14 +32,19 @@ void QgsTileCache::insertTile( const QUrl &url, const QImage &image )
 
 bool QgsTileCache::tile( const QUrl &url, QImage &image )
 {
-  QMutexLocker locker( &sTileCacheMutex );
-  bool success = false;
-  if ( QImage *i = sTileCache.object( url ) )
   {
-    image = *i;
-    success = true;
+    QMutexLocker locker( &sTileCacheMutex );
+    if ( QImage *i = sTileCache.object( url ) )
+    {
+      image = *i;
+      return true;
+    }
   }
-  else if ( QgsNetworkAccessManager::instance()->cache()->metaData( url ).isValid() )
+
+  // read and decode the tile from the disk cache without holding the mutex,
+  // so that several threads can decode their tiles at the same time
+  bool success = false;
+  if ( QgsNetworkAccessManager::instance()->cache()->metaData( url ).isValid() )
   {
     if ( QIODevice *data = QgsNetworkAccessManager::instance()->cache()->data( url ) )
     {
@@ -48,11 +53,11 @@ bool QgsTileCache::tile( const QUrl &url, QImage &image )
 
       image = QImage::fromData( imageData );
 
-      // cache it as well (mutex is already locked)
+      // cache it as well
       // Check for null because it could be a redirect (see: https://github.com/qgis/QGIS/issues/24336 )
       if ( ! image.isNull( ) )
       {
-        sTileCache.insert( url, new QImage( image ) );
+        insertTile( url, image );
         success = true;
       }
     }
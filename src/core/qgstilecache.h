@@ -55,6 +55,19 @@ class CORE_EXPORT QgsTileCache
     //! how many tiles can be stored in the in-memory cache
     static int maxCost() { QMutexLocker locker( &sTileCacheMutex ); return sTileCache.maxCost(); }
 
+    /**
+     * Sets how many tiles can be stored in the in-memory cache.
+     * \since QGIS 3.16
+     */
+    static void setMaxCost( int maxCost ) { QMutexLocker locker( &sTileCacheMutex ); sTileCache.setMaxCost( maxCost ); }
+
+    /**
+     * Returns TRUE if a tile with given URL is in the in-memory cache. Unlike tile(),
+     * the disk cache is not looked up.
+     * \since QGIS 3.16
+     */
+    static bool hasTile( const QUrl &url ) { QMutexLocker locker( &sTileCacheMutex ); return sTileCache.contains( url ); }
+
   private:
     //! in-memory cache
     static QCache<QUrl, QImage> sTileCache;
@@ -26,7 +26,18 @@
 #include "qgsrenderer.h"
 #include "qgssettings.h"
 #include "qgsexpressioncontextutils.h"
-
+#include "qgsvectorlayerfeatureiterator.h"
+
+#include <QThreadPool>
+#include <QTimer>
+#include <QtConcurrentMap>
+#include <QtConcurrentRun>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <limits>
+#include <numeric>
 #include <queue>
 #include <vector>
 
@@ -464,18 +475,264 @@ void extractLinework( const QgsGeometry &g, QgsMultiPolylineXY &mpl )
   }
 }
 
-// -------------
+// below this number of segments, the linework is noded in one go
+static const int PARALLEL_NODING_MIN_SEGMENTS = 10000;
 
+//! Nodes the linework with GEOS, returns FALSE if GEOS failed, in which case the linework is left unchanged
+static bool nodeLinework( QgsMultiPolylineXY &mpl )
+{
+  QgsGeometry allGeom = QgsGeometry::fromMultiPolylineXY( mpl );
 
-QgsTracer::QgsTracer() = default;
+  try
+  {
+    // GEOSNode_r may throw an exception
+    geos::unique_ptr allGeomGeos( QgsGeos::asGeos( allGeom ) );
+    geos::unique_ptr allNoded( GEOSNode_r( QgsGeos::getGEOSHandler(), allGeomGeos.get() ) );
 
-bool QgsTracer::initGraph()
+    QgsGeometry noded = QgsGeos::geometryFromGeos( allNoded.release() );
+
+    if ( noded.isMultipart() )
+      mpl = noded.asMultiPolyline();
+    else if ( !noded.isEmpty() )
+      mpl = QgsMultiPolylineXY() << noded.asPolyline();
+    else
+      mpl.clear();
+  }
+  catch ( GEOSException &e )
+  {
+    // no big deal... we will just not have nicely noded linework, potentially
+    // missing some intersections
+
+    QgsDebugMsg( QStringLiteral( "Tracer Noding Exception: %1" ).arg( e.what() ) );
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Joins back the lines which were cut at the \a cuts points, where no other line starts or ends.
+ * The cut points which were added to the lines (as opposed to existing vertices) are removed again.
+ */
+static void joinAtCuts( QgsMultiPolylineXY &lines, const QHash< QgsPointXY, bool > &cuts )
 {
-  if ( mGraph )
-    return true; // already initialized
+  QHash< QgsPointXY, QVector< int > > ends;
+  for ( int i = 0; i < lines.count(); ++i )
+  {
+    if ( cuts.contains( lines.at( i ).first() ) )
+      ends[ lines.at( i ).first() ] << i;
+    if ( cuts.contains( lines.at( i ).last() ) )
+      ends[ lines.at( i ).last() ] << i;
+  }
+
+  // index of the line each line was joined to
+  QVector< int > joinedTo( lines.count() );
+  std::iota( joinedTo.begin(), joinedTo.end(), 0 );
+  for ( auto it = ends.constBegin(); it != ends.constEnd(); ++it )
+  {
+    if ( it.value().count() != 2 )
+      continue;
+
+    int a = it.value().at( 0 );
+    while ( joinedTo.at( a ) != a )
+      a = joinedTo.at( a );
+    int b = it.value().at( 1 );
+    while ( joinedTo.at( b ) != b )
+      b = joinedTo.at( b );
+    if ( a == b )
+      continue; // closed line
+
+    const QgsPointXY &pt = it.key();
+    QgsPolylineXY &lineA = lines[a];
+    QgsPolylineXY &lineB = lines[b];
+    if ( lineA.first() == pt )
+      std::reverse( lineA.begin(), lineA.end() );
+    if ( lineB.last() == pt )
+      std::reverse( lineB.begin(), lineB.end() );
+
+    if ( cuts.value( pt ) )
+      lineA.removeLast();
+    lineA.reserve( lineA.count() + lineB.count() - 1 );
+    for ( int i = 1; i < lineB.count(); ++i )
+      lineA << lineB.at( i );
+    lineB.clear();
+    joinedTo[b] = a;
+  }
+
+  lines.erase( std::remove_if( lines.begin(), lines.end(), []( const QgsPolylineXY & line ) { return line.isEmpty(); } ), lines.end() );
+}
+
+/**
+ * Nodes the linework with GEOS in \a strips vertical strips, in parallel. Returns FALSE if GEOS failed
+ * for any strip, in which case the linework of this strip is left unchanged.
+ *
+ * The lines are first cut where they cross the borders of the strips, so that each part lies within a single strip,
+ * and the parts on either side of a border share the same cut point. The parts of each strip are then noded together
+ * with the parts of the neighboring strips which touch it, and only the noded lines of the strip itself are kept.
+ * Finally the lines are joined back at the cuts.
+ */
+static bool nodeLineworkInStrips( QgsMultiPolylineXY &mpl, int strips )
+{
+  // the borders are quantiles of the segment centers, so that the strips hold about as many segments
+  std::vector< double > centers;
+  for ( const QgsPolylineXY &line : qgis::as_const( mpl ) )
+  {
+    for ( int i = 0; i + 1 < line.count(); ++i )
+      centers.push_back( ( line.at( i ).x() + line.at( i + 1 ).x() ) / 2 );
+  }
+
+  std::vector< double > borders;
+  for ( int i = 1; i < strips; ++i )
+  {
+    const auto quantile = centers.begin() + static_cast< std::ptrdiff_t >( centers.size() * i / strips );
+    std::nth_element( centers.begin(), quantile, centers.end() );
+    borders.push_back( *quantile );
+  }
+  std::sort( borders.begin(), borders.end() );
+  borders.erase( std::unique( borders.begin(), borders.end() ), borders.end() );
+  if ( borders.empty() )
+    return nodeLinework( mpl );
+
+  // a point on a border belongs to the strip on its right
+  auto stripOf = [&borders]( double x ) -> int
+  {
+    return static_cast< int >( std::upper_bound( borders.begin(), borders.end(), x ) - borders.begin() );
+  };
+
+  struct Part
+  {
+    QgsPolylineXY points;
+    int strip;
+    double xMin;
+    double xMax;
+  };
+  std::vector< Part > parts;
+  // points at which the lines were cut, with whether they were added to the line
+  QHash< QgsPointXY, bool > cuts;
 
-  mHasTopologyProblem = false;
+  for ( const QgsPolylineXY &line : qgis::as_const( mpl ) )
+  {
+    Part part { QgsPolylineXY(), -1, 0, 0 };
+    auto addSegment = [&]( const QgsPointXY & from, const QgsPointXY & to, bool fromAdded )
+    {
+      const int strip = stripOf( ( from.x() + to.x() ) / 2 );
+      if ( strip != part.strip )
+      {
+        if ( part.points.count() >= 2 )
+        {
+          cuts.insert( from, fromAdded );
+          parts.push_back( part );
+        }
+        part = Part { QgsPolylineXY() << from, strip, from.x(), from.x() };
+      }
+      part.points << to;
+      part.xMin = std::min( part.xMin, to.x() );
+      part.xMax = std::max( part.xMax, to.x() );
+    };
 
+    for ( int i = 0; i + 1 < line.count(); ++i )
+    {
+      const QgsPointXY &a = line.at( i );
+      const QgsPointXY &b = line.at( i + 1 );
+      if ( a.x() == b.x() && a.y() == b.y() )
+        continue;
+
+      // cut the segment at the borders strictly between its ends, in the direction of the segment
+      const int firstBorder = static_cast< int >( std::upper_bound( borders.begin(), borders.end(), std::min( a.x(), b.x() ) ) - borders.begin() );
+      const int lastBorder = static_cast< int >( std::lower_bound( borders.begin(), borders.end(), std::max( a.x(), b.x() ) ) - borders.begin() ) - 1;
+      QgsPointXY from = a;
+      bool fromAdded = false;
+      for ( int j = 0; j <= lastBorder - firstBorder; ++j )
+      {
+        const double x = borders[ a.x() < b.x() ? firstBorder + j : lastBorder - j ];
+        const QgsPointXY cut( x, a.y() + ( x - a.x() ) * ( b.y() - a.y() ) / ( b.x() - a.x() ) );
+        addSegment( from, cut, fromAdded );
+        from = cut;
+        fromAdded = true;
+      }
+      addSegment( from, b, fromAdded );
+    }
+    if ( part.points.count() >= 2 )
+      parts.push_back( part );
+  }
+
+  const int stripCount = static_cast< int >( borders.size() ) + 1;
+  std::vector< QgsMultiPolylineXY > noded( stripCount );
+  std::vector< char > failed( stripCount, 0 );
+  std::vector< int > stripIndexes( stripCount );
+  std::iota( stripIndexes.begin(), stripIndexes.end(), 0 );
+  QtConcurrent::blockingMap( stripIndexes, [&]( int strip )
+  {
+    const double xMin = strip == 0 ? std::numeric_limits< double >::lowest() : borders[strip - 1];
+    const double xMax = strip == stripCount - 1 ? std::numeric_limits< double >::max() : borders[strip];
+
+    QgsMultiPolylineXY lines;
+    QgsMultiPolylineXY ownLines;
+    for ( const Part &part : parts )
+    {
+      if ( part.strip == strip )
+        ownLines << part.points;
+      if ( std::abs( part.strip - strip ) <= 1 && part.xMin <= xMax && part.xMax >= xMin )
+        lines << part.points;
+    }
+
+    if ( !nodeLinework( lines ) )
+    {
+      failed[strip] = 1;
+      noded[strip] = ownLines;
+      return;
+    }
+
+    // the noded lines lie within the strip of their parts, the first segment tells which one
+    for ( const QgsPolylineXY &line : qgis::as_const( lines ) )
+    {
+      if ( line.count() >= 2 && stripOf( ( line.at( 0 ).x() + line.at( 1 ).x() ) / 2 ) == strip )
+        noded[strip] << line;
+    }
+  } );
+
+  mpl.clear();
+  for ( const QgsMultiPolylineXY &lines : noded )
+    mpl << lines;
+  joinAtCuts( mpl, cuts );
+
+  return std::find( failed.begin(), failed.end(), 1 ) == failed.end();
+}
+
+// -------------
+
+///@cond PRIVATE
+
+/**
+ * Builds the graph of a tracer from snapshots of its layers, so that it can run on any thread.
+ */
+class QgsTracerGraphBuilder
+{
+  public:
+
+    struct Layer
+    {
+      std::unique_ptr< QgsVectorLayerFeatureSource > source;
+      QgsFields fields;
+      QgsFeatureRequest request;
+      std::unique_ptr< QgsFeatureRenderer > renderer;
+      std::unique_ptr< QgsRenderContext > context;
+    };
+
+    std::vector< Layer > layers;
+    int maxFeatureCount = 0;
+
+    //! Set when the tracer does not need the graph anymore
+    std::atomic< bool > canceled { false };
+
+    //! The built graph, or NULLPTR if too many features were read or the build was canceled
+    std::unique_ptr< QgsTracerGraph > graph;
+    bool hasTopologyProblem = false;
+
+    void run();
+};
+
+void QgsTracerGraphBuilder::run()
+{
   QgsFeature f;
   QgsMultiPolylineXY mpl;
 
@@ -483,48 +740,36 @@ bool QgsTracer::initGraph()
 
   // TODO: use QgsPointLocator as a source for the linework
 
-  QElapsedTimer t1, t2, t2a, t3;
+  QElapsedTimer t1, t2, t3;
 
   t1.start();
   int featuresCounted = 0;
-  bool enableInvisibleFeature = QgsSettings().value( QStringLiteral( "/qgis/digitizing/snap_invisible_feature" ), false ).toBool();
-  for ( const QgsVectorLayer *vl : qgis::as_const( mLayers ) )
+  for ( Layer &layer : layers )
   {
-    QgsFeatureRequest request;
     bool filter = false;
-    std::unique_ptr< QgsFeatureRenderer > renderer;
-    std::unique_ptr<QgsRenderContext> ctx;
-
-    if ( !enableInvisibleFeature && mRenderContext && vl->renderer() )
+    if ( layer.renderer )
     {
-      renderer.reset( vl->renderer()->clone() );
-      ctx.reset( new QgsRenderContext( *mRenderContext.get() ) );
-      ctx->expressionContext() << QgsExpressionContextUtils::layerScope( vl );
-
       // setup scale for scale dependent visibility (rule based)
-      renderer->startRender( *ctx.get(), vl->fields() );
-      filter = renderer->capabilities() & QgsFeatureRenderer::Filter;
-      request.setSubsetOfAttributes( renderer->usedAttributes( *ctx.get() ), vl->fields() );
+      layer.renderer->startRender( *layer.context, layer.fields );
+      filter = layer.renderer->capabilities() & QgsFeatureRenderer::Filter;
+      layer.request.setSubsetOfAttributes( layer.renderer->usedAttributes( *layer.context ), layer.fields );
     }
     else
     {
-      request.setNoAttributes();
+      layer.request.setNoAttributes();
     }
 
-    request.setDestinationCrs( mCRS, mTransformContext );
-    if ( !mExtent.isEmpty() )
-      request.setFilterRect( mExtent );
-
-    QgsFeatureIterator fi = vl->getFeatures( request );
-    while ( fi.nextFeature( f ) )
+    bool tooManyFeatures = false;
+    QgsFeatureIterator fi = layer.source->getFeatures( layer.request );
+    while ( !canceled && fi.nextFeature( f ) )
     {
       if ( !f.hasGeometry() )
         continue;
 
       if ( filter )
       {
-        ctx->expressionContext().setFeature( f );
-        if ( !renderer->willRenderFeature( f, *ctx.get() ) )
+        layer.context->expressionContext().setFeature( f );
+        if ( !layer.renderer->willRenderFeature( f, *layer.context ) )
         {
           continue;
         }
@@ -533,14 +778,20 @@ bool QgsTracer::initGraph()
       extractLinework( f.geometry(), mpl );
 
       ++featuresCounted;
-      if ( mMaxFeatureCount != 0 && featuresCounted >= mMaxFeatureCount )
-        return false;
+      if ( maxFeatureCount != 0 && featuresCounted >= maxFeatureCount )
+      {
+        tooManyFeatures = true;
+        break;
+      }
     }
 
-    if ( renderer )
+    if ( layer.renderer )
     {
-      renderer->stopRender( *ctx.get() );
+      layer.renderer->stopRender( *layer.context );
     }
+
+    if ( tooManyFeatures || canceled )
+      return;
   }
   int timeExtract = t1.elapsed();
 
@@ -548,56 +799,93 @@ bool QgsTracer::initGraph()
 
   t2.start();
 
-  int timeNodingCall = 0;
+  int segmentCount = 0;
+  for ( const QgsPolylineXY &line : qgis::as_const( mpl ) )
+    segmentCount += line.count() - 1;
 
 #if 0
   // without noding - if data are known to be noded beforehand
 #else
-  QgsGeometry allGeom = QgsGeometry::fromMultiPolylineXY( mpl );
-
-  try
-  {
-    t2a.start();
-    // GEOSNode_r may throw an exception
-    geos::unique_ptr allGeomGeos( QgsGeos::asGeos( allGeom ) );
-    geos::unique_ptr allNoded( GEOSNode_r( QgsGeos::getGEOSHandler(), allGeomGeos.get() ) );
-    timeNodingCall = t2a.elapsed();
-
-    QgsGeometry noded = QgsGeos::geometryFromGeos( allNoded.release() );
-
-    mpl = noded.asMultiPolyline();
-  }
-  catch ( GEOSException &e )
-  {
-    // no big deal... we will just not have nicely noded linework, potentially
-    // missing some intersections
-
-    mHasTopologyProblem = true;
-
-    QgsDebugMsg( QStringLiteral( "Tracer Noding Exception: %1" ).arg( e.what() ) );
-  }
+  const int threadCount = QThreadPool::globalInstance()->maxThreadCount();
+  if ( threadCount > 1 && segmentCount >= PARALLEL_NODING_MIN_SEGMENTS )
+    hasTopologyProblem = !nodeLineworkInStrips( mpl, threadCount );
+  else
+    hasTopologyProblem = !nodeLinework( mpl );
 #endif
 
   int timeNoding = t2.elapsed();
 
   t3.start();
 
-  mGraph.reset( makeGraph( mpl ) );
+  graph.reset( makeGraph( mpl ) );
 
   int timeMake = t3.elapsed();
 
   Q_UNUSED( timeExtract )
   Q_UNUSED( timeNoding )
-  Q_UNUSED( timeNodingCall )
   Q_UNUSED( timeMake )
-  QgsDebugMsg( QStringLiteral( "tracer extract %1 ms, noding %2 ms (call %3 ms), make %4 ms" )
-               .arg( timeExtract ).arg( timeNoding ).arg( timeNodingCall ).arg( timeMake ) );
+  QgsDebugMsg( QStringLiteral( "tracer extract %1 ms, noding %2 ms (%3 segments), make %4 ms" )
+               .arg( timeExtract ).arg( timeNoding ).arg( segmentCount ).arg( timeMake ) );
+}
+
+///@endcond
+
+// -------------
+
+
+QgsTracer::QgsTracer() = default;
+
+std::shared_ptr< QgsTracerGraphBuilder > QgsTracer::createGraphBuilder() const
+{
+  std::shared_ptr< QgsTracerGraphBuilder > builder = std::make_shared< QgsTracerGraphBuilder >();
+  builder->maxFeatureCount = mMaxFeatureCount;
+
+  bool enableInvisibleFeature = QgsSettings().value( QStringLiteral( "/qgis/digitizing/snap_invisible_feature" ), false ).toBool();
+  for ( const QgsVectorLayer *vl : qgis::as_const( mLayers ) )
+  {
+    QgsTracerGraphBuilder::Layer layer;
+    layer.source.reset( new QgsVectorLayerFeatureSource( vl ) );
+    layer.fields = vl->fields();
 
+    if ( !enableInvisibleFeature && mRenderContext && vl->renderer() )
+    {
+      layer.renderer.reset( vl->renderer()->clone() );
+      layer.context.reset( new QgsRenderContext( *mRenderContext.get() ) );
+      layer.context->expressionContext() << QgsExpressionContextUtils::layerScope( vl );
+    }
+
+    layer.request.setDestinationCrs( mCRS, mTransformContext );
+    if ( !mExtent.isEmpty() )
+      layer.request.setFilterRect( mExtent );
+
+    builder->layers.push_back( std::move( layer ) );
+  }
+  return builder;
+}
+
+bool QgsTracer::takeGraph( QgsTracerGraphBuilder &builder )
+{
+  mHasTopologyProblem = builder.hasTopologyProblem;
+  if ( !builder.graph )
+    return false;
+
+  mGraph = std::move( builder.graph );
   return true;
 }
 
+bool QgsTracer::initGraph()
+{
+  if ( mGraph )
+    return true; // already initialized
+
+  std::shared_ptr< QgsTracerGraphBuilder > builder = createGraphBuilder();
+  builder->run();
+  return takeGraph( *builder );
+}
+
 QgsTracer::~QgsTracer()
 {
+  mBuildInBackground = false;
   invalidateGraph();
 }
 
@@ -674,11 +962,26 @@ void QgsTracer::setOffsetParameters( int quadSegments, int joinStyle, double mit
   mOffsetMiterLimit = miterLimit;
 }
 
+void QgsTracer::setBuildInBackground( bool enabled )
+{
+  mBuildInBackground = enabled;
+  if ( enabled && !mGraph && !mBuilder )
+    scheduleBackgroundBuild();
+}
+
 bool QgsTracer::init()
 {
   if ( mGraph )
     return true;
 
+  if ( mBuilder )
+  {
+    // any change of the configuration since the build started would have canceled it
+    mBuilderFuture.waitForFinished();
+    std::shared_ptr< QgsTracerGraphBuilder > builder = std::move( mBuilder );
+    return takeGraph( *builder );
+  }
+
   // configuration from derived class?
   configure();
 
@@ -689,6 +992,47 @@ bool QgsTracer::init()
 void QgsTracer::invalidateGraph()
 {
   mGraph.reset( nullptr );
+
+  if ( mBuilder )
+  {
+    // the running build holds its own snapshot of the layers, it is left to finish on its own
+    mBuilder->canceled = true;
+    mBuilder.reset();
+    mBuilderFuture = QFuture< void >();
+  }
+
+  if ( mBuildInBackground )
+    scheduleBackgroundBuild();
+}
+
+void QgsTracer::scheduleBackgroundBuild()
+{
+  // several invalidations in a row, e.g. while features are added one by one, start a single build
+  if ( mBuildScheduled )
+    return;
+
+  mBuildScheduled = true;
+  QTimer::singleShot( 0, this, &QgsTracer::startBackgroundBuild );
+}
+
+void QgsTracer::startBackgroundBuild()
+{
+  if ( !mBuildInBackground || mGraph || mBuilder )
+  {
+    mBuildScheduled = false;
+    return;
+  }
+
+  // the derived class configuration invalidates the graph, which must not schedule yet another build
+  configure();
+  mBuildScheduled = false;
+
+  std::shared_ptr< QgsTracerGraphBuilder > builder = createGraphBuilder();
+  mBuilder = builder;
+  mBuilderFuture = QtConcurrent::run( [builder]
+  {
+    builder->run();
+  } );
 }
 
 void QgsTracer::onFeatureAdded( QgsFeatureId fid )
@@ -19,6 +19,7 @@
 class QgsVectorLayer;
 
 #include "qgis_core.h"
+#include <QFuture>
 #include <QSet>
 #include <QVector>
 #include <memory>
@@ -29,6 +30,7 @@ class QgsVectorLayer;
 #include "qgsgeometry.h"
 
 struct QgsTracerGraph;
+class QgsTracerGraphBuilder;
 class QgsFeatureRenderer;
 class QgsRenderContext;
 
@@ -110,6 +112,22 @@ class CORE_EXPORT QgsTracer : public QObject
     //! Gets maximum possible number of features in graph. If the number is exceeded, graph is not created.
     void setMaxFeatureCount( int count ) { mMaxFeatureCount = count; }
 
+    /**
+     * Returns TRUE if the graph is built in the background as soon as it is invalidated.
+     * \see setBuildInBackground()
+     * \since QGIS 3.16
+     */
+    bool buildInBackground() const { return mBuildInBackground; }
+
+    /**
+     * Sets whether the graph is built on the global thread pool as soon as it is invalidated, e.g. by a change
+     * of the extent or by an edit of one of the layers. init() then waits for the build in progress instead of
+     * building the graph itself.
+     * \see buildInBackground()
+     * \since QGIS 3.16
+     */
+    void setBuildInBackground( bool enabled );
+
     /**
      * Build the internal data structures. This may take some time
      * depending on how big the input layers are. It is not necessary
@@ -163,6 +181,12 @@ class CORE_EXPORT QgsTracer : public QObject
 
   private:
     bool initGraph();
+    //! Creates a builder of the graph for the current configuration, which can run on any thread
+    std::shared_ptr< QgsTracerGraphBuilder > createGraphBuilder() const;
+    //! Takes the graph out of a finished \a builder, returns FALSE if there is none
+    bool takeGraph( QgsTracerGraphBuilder &builder );
+    void scheduleBackgroundBuild();
+    void startBackgroundBuild();
 
   private slots:
     void onFeatureAdded( QgsFeatureId fid );
@@ -176,6 +200,12 @@ class CORE_EXPORT QgsTracer : public QObject
   private:
     //! Graph data structure for path searching
     std::unique_ptr< QgsTracerGraph > mGraph;
+    //! Build of the graph in progress in the background, if any
+    std::shared_ptr< QgsTracerGraphBuilder > mBuilder;
+    QFuture< void > mBuilderFuture;
+    //! Whether the graph is built in the background as soon as it is invalidated
+    bool mBuildInBackground = false;
+    bool mBuildScheduled = false;
     //! Input layers for the graph building
     QList<QgsVectorLayer *> mLayers;
     //! Destination CRS in which graph is built and tracing done
@@ -43,6 +43,8 @@
 #include <QTextStream>
 #include <QSet>
 #include <QMetaType>
+#include <QThreadPool>
+#include <QtConcurrentMap>
 
 #include <cassert>
 #include <cstdlib> // size_t
@@ -54,6 +56,12 @@
 #include <cpl_string.h>
 #include <gdal.h>
 
+//! Number of feature geometries converted to OGR by a single task when a batch of features is added
+static const int PARALLEL_TASK_SIZE = 256;
+
+//! Number of features read by writeAsVectorFormatV2() before they are added as a batch
+static const int WRITE_BATCH_SIZE = 4096;
+
 // Thin wrapper around OGROpen() to workaround a bug in GDAL < 2.3.1
 // where a existing BNA file is wrongly reported to be openable in update mode
 // but attempting to add features in it crashes the BNA driver.
@@ -446,6 +454,27 @@ void QgsVectorFileWriter::init( QString vectorFileName,
   // datasource created, now create the output layer
   OGRwkbGeometryType wkbType = ogrTypeFromWkbType( geometryType );
 
+  // SpatiaLite updates the spatial index of a layer with triggers for each inserted feature, which
+  // is very slow for large layers: the index of new databases is rather built in bulk once all the
+  // features are written. (GDAL already defers the creation of the index of new GeoPackage layers)
+  if ( mOgrDriverName == QLatin1String( "SQLite" ) && action == CreateOrOverwriteFile && wkbType != wkbNone
+       && datasourceOptions.contains( QStringLiteral( "SPATIALITE=YES" ) ) )
+  {
+    int spatialIndexOption = -1;
+    for ( int i = 0; i < layerOptions.size(); ++i )
+    {
+      if ( layerOptions.at( i ).startsWith( QLatin1String( "SPATIAL_INDEX=" ), Qt::CaseInsensitive ) )
+        spatialIndexOption = i;
+    }
+    if ( spatialIndexOption == -1 || layerOptions.at( spatialIndexOption ).compare( QLatin1String( "SPATIAL_INDEX=NO" ), Qt::CaseInsensitive ) != 0 )
+    {
+      if ( spatialIndexOption != -1 )
+        layerOptions.removeAt( spatialIndexOption );
+      layerOptions.append( QStringLiteral( "SPATIAL_INDEX=NO" ) );
+      mDeferredSpatialIndex = true;
+    }
+  }
+
   // Remove FEATURE_DATASET layer option (used for ESRI File GDB driver) if its value is not set
   int optIndex = layerOptions.indexOf( QStringLiteral( "FEATURE_DATASET=" ) );
   if ( optIndex != -1 )
@@ -2287,13 +2316,7 @@ bool QgsVectorFileWriter::addFeature( QgsFeature &feature, QgsFeatureSink::Flags
 
 bool QgsVectorFileWriter::addFeatures( QgsFeatureList &features, QgsFeatureSink::Flags )
 {
-  QgsFeatureList::iterator fIt = features.begin();
-  bool result = true;
-  for ( ; fIt != features.end(); ++fIt )
-  {
-    result = result && addFeatureWithStyle( *fIt, nullptr, QgsUnitTypes::DistanceMeters );
-  }
-  return result;
+  return addFeaturesWithStyle( features, nullptr, QgsUnitTypes::DistanceMeters, true ) == 0;
 }
 
 QString QgsVectorFileWriter::lastError() const
@@ -2308,6 +2331,60 @@ bool QgsVectorFileWriter::addFeatureWithStyle( QgsFeature &feature, QgsFeatureRe
   if ( !poFeature )
     return false;
 
+  return writeFeatureWithStyle( feature, poFeature.get(), renderer, outputUnit );
+}
+
+int QgsVectorFileWriter::addFeaturesWithStyle( QgsFeatureList &features, QgsFeatureRenderer *renderer, QgsUnitTypes::DistanceUnit outputUnit, bool stopOnError, QStringList *errors )
+{
+  const int count = features.size();
+  std::vector< gdal::ogr_geometry_unique_ptr > geometries( count );
+  QVector< QString > geometryErrors( count );
+  if ( mWkbType != QgsWkbTypes::NoGeometry )
+  {
+    // the geometries are converted to WKB and imported by OGR on worker threads, the writer thread
+    // then only sets the attributes and writes the features, in their order
+    const QgsFeatureList &constFeatures = features;
+    gdal::ogr_geometry_unique_ptr *geometryData = geometries.data();
+    QString *errorData = geometryErrors.data();
+    if ( count > PARALLEL_TASK_SIZE && QThreadPool::globalInstance()->maxThreadCount() > 1 )
+    {
+      QVector< int > starts;
+      for ( int start = 0; start < count; start += PARALLEL_TASK_SIZE )
+        starts << start;
+
+      QtConcurrent::blockingMap( starts, [ =, &constFeatures ]( int start )
+      {
+        const int end = std::min( start + PARALLEL_TASK_SIZE, count );
+        for ( int i = start; i < end; ++i )
+          geometryData[i] = createOgrGeometry( constFeatures.at( i ), errorData[i] );
+      } );
+    }
+    else
+    {
+      for ( int i = 0; i < count; ++i )
+        geometryData[i] = createOgrGeometry( constFeatures.at( i ), errorData[i] );
+    }
+  }
+
+  int failed = 0;
+  for ( int i = 0; i < count; ++i )
+  {
+    QgsFeature &feature = features[i];
+    gdal::ogr_feature_unique_ptr poFeature = createFeature( feature, std::move( geometries[i] ), geometryErrors.at( i ) );
+    if ( !poFeature || !writeFeatureWithStyle( feature, poFeature.get(), renderer, outputUnit ) )
+    {
+      failed++;
+      if ( errors && mError != NoError )
+        errors->append( mErrorMessage );
+      if ( stopOnError )
+        break;
+    }
+  }
+  return failed;
+}
+
+bool QgsVectorFileWriter::writeFeatureWithStyle( QgsFeature &feature, OGRFeatureH poFeature, QgsFeatureRenderer *renderer, QgsUnitTypes::DistanceUnit outputUnit )
+{
   //add OGR feature style type
   if ( mSymbologyExport != NoSymbology && renderer )
   {
@@ -2345,20 +2422,20 @@ bool QgsVectorFileWriter::addFeatureWithStyle( QgsFeature &feature, QgsFeatureRe
         }
         else if ( mSymbologyExport == SymbolLayerSymbology )
         {
-          OGR_F_SetStyleString( poFeature.get(), currentStyle.toLocal8Bit().constData() );
-          if ( !writeFeature( mLayer, poFeature.get() ) )
+          OGR_F_SetStyleString( poFeature, currentStyle.toLocal8Bit().constData() );
+          if ( !writeFeature( mLayer, poFeature ) )
           {
             return false;
           }
         }
       }
     }
-    OGR_F_SetStyleString( poFeature.get(), styleString.toLocal8Bit().constData() );
+    OGR_F_SetStyleString( poFeature, styleString.toLocal8Bit().constData() );
   }
 
   if ( mSymbologyExport == NoSymbology || mSymbologyExport == FeatureSymbology )
   {
-    if ( !writeFeature( mLayer, poFeature.get() ) )
+    if ( !writeFeature( mLayer, poFeature ) )
     {
       return false;
     }
@@ -2369,6 +2446,26 @@ bool QgsVectorFileWriter::addFeatureWithStyle( QgsFeature &feature, QgsFeatureRe
 
 gdal::ogr_feature_unique_ptr QgsVectorFileWriter::createFeature( const QgsFeature &feature )
 {
+  QString geometryError;
+  gdal::ogr_geometry_unique_ptr geometry;
+  if ( mWkbType != QgsWkbTypes::NoGeometry )
+    geometry = createOgrGeometry( feature, geometryError );
+
+  return createFeature( feature, std::move( geometry ), geometryError );
+}
+
+gdal::ogr_feature_unique_ptr QgsVectorFileWriter::createFeature( const QgsFeature &feature, gdal::ogr_geometry_unique_ptr geometry, const QString &geometryError )
+{
+  if ( mWkbType != QgsWkbTypes::NoGeometry && !geometry )
+  {
+    if ( !geometryError.isEmpty() )
+    {
+      mErrorMessage = geometryError;
+      mError = ErrFeatureWriteFailed;
+    }
+    return nullptr;
+  }
+
   QgsLocaleNumC l; // Make sure the decimal delimiter is a dot
   Q_UNUSED( l )
 
@@ -2541,126 +2638,122 @@ gdal::ogr_feature_unique_ptr QgsVectorFileWriter::createFeature( const QgsFeatur
     }
   }
 
-  if ( mWkbType != QgsWkbTypes::NoGeometry )
-  {
-    if ( feature.hasGeometry() )
-    {
-      // build geometry from WKB
-      QgsGeometry geom = feature.geometry();
-      if ( mCoordinateTransform )
-      {
-        // output dataset requires coordinate transform
-        try
-        {
-          geom.transform( *mCoordinateTransform );
-        }
-        catch ( QgsCsException & )
-        {
-          QgsLogger::warning( QObject::tr( "Feature geometry failed to transform" ) );
-          return nullptr;
-        }
-      }
+  // set geometry (ownership is passed to OGR)
+  if ( geometry )
+    OGR_F_SetGeometryDirectly( poFeature.get(), geometry.release() );
 
-      // turn single geometry to multi geometry if needed
-      if ( QgsWkbTypes::flatType( geom.wkbType() ) != QgsWkbTypes::flatType( mWkbType ) &&
-           QgsWkbTypes::flatType( geom.wkbType() ) == QgsWkbTypes::flatType( QgsWkbTypes::singleType( mWkbType ) ) )
-      {
-        geom.convertToMultiType();
-      }
+  return poFeature;
+}
 
-      if ( geom.wkbType() != mWkbType )
-      {
-        OGRGeometryH mGeom2 = nullptr;
+gdal::ogr_geometry_unique_ptr QgsVectorFileWriter::createOgrGeometry( const QgsFeature &feature, QString &error ) const
+{
+  if ( !feature.hasGeometry() )
+    return gdal::ogr_geometry_unique_ptr( createEmptyGeometry( mWkbType ) );
 
-        // If requested WKB type is 25D and geometry WKB type is 3D,
-        // we must force the use of 25D.
-        if ( mWkbType >= QgsWkbTypes::Point25D && mWkbType <= QgsWkbTypes::MultiPolygon25D )
-        {
-          //ND: I suspect there's a bug here, in that this is NOT converting the geometry's WKB type,
-          //so the exported WKB has a different type to what the OGRGeometry is expecting.
-          //possibly this is handled already in OGR, but it should be fixed regardless by actually converting
-          //geom to the correct WKB type
-          QgsWkbTypes::Type wkbType = geom.wkbType();
-          if ( wkbType >= QgsWkbTypes::PointZ && wkbType <= QgsWkbTypes::MultiPolygonZ )
-          {
-            QgsWkbTypes::Type wkbType25d = static_cast<QgsWkbTypes::Type>( geom.wkbType() - QgsWkbTypes::PointZ + QgsWkbTypes::Point25D );
-            mGeom2 = createEmptyGeometry( wkbType25d );
-          }
-        }
+  // build geometry from WKB
+  QgsGeometry geom = feature.geometry();
+  if ( mCoordinateTransform )
+  {
+    // output dataset requires coordinate transform
+    try
+    {
+      geom.transform( *mCoordinateTransform );
+    }
+    catch ( QgsCsException & )
+    {
+      QgsLogger::warning( QObject::tr( "Feature geometry failed to transform" ) );
+      return nullptr;
+    }
+  }
+
+  // turn single geometry to multi geometry if needed
+  if ( QgsWkbTypes::flatType( geom.wkbType() ) != QgsWkbTypes::flatType( mWkbType ) &&
+       QgsWkbTypes::flatType( geom.wkbType() ) == QgsWkbTypes::flatType( QgsWkbTypes::singleType( mWkbType ) ) )
+  {
+    geom.convertToMultiType();
+  }
 
-        // drop m/z value if not present in output wkb type
-        if ( !QgsWkbTypes::hasZ( mWkbType ) && QgsWkbTypes::hasZ( geom.wkbType() ) )
-          geom.get()->dropZValue();
-        if ( !QgsWkbTypes::hasM( mWkbType ) && QgsWkbTypes::hasM( geom.wkbType() ) )
-          geom.get()->dropMValue();
+  if ( geom.wkbType() != mWkbType )
+  {
+    gdal::ogr_geometry_unique_ptr mGeom2;
 
-        // add m/z values if not present in the input wkb type -- this is needed for formats which determine
-        // geometry type based on features, e.g. geojson
-        if ( QgsWkbTypes::hasZ( mWkbType ) && !QgsWkbTypes::hasZ( geom.wkbType() ) )
-          geom.get()->addZValue( 0 );
-        if ( QgsWkbTypes::hasM( mWkbType ) && !QgsWkbTypes::hasM( geom.wkbType() ) )
-          geom.get()->addMValue( 0 );
+    // If requested WKB type is 25D and geometry WKB type is 3D,
+    // we must force the use of 25D.
+    if ( mWkbType >= QgsWkbTypes::Point25D && mWkbType <= QgsWkbTypes::MultiPolygon25D )
+    {
+      //ND: I suspect there's a bug here, in that this is NOT converting the geometry's WKB type,
+      //so the exported WKB has a different type to what the OGRGeometry is expecting.
+      //possibly this is handled already in OGR, but it should be fixed regardless by actually converting
+      //geom to the correct WKB type
+      QgsWkbTypes::Type wkbType = geom.wkbType();
+      if ( wkbType >= QgsWkbTypes::PointZ && wkbType <= QgsWkbTypes::MultiPolygonZ )
+      {
+        QgsWkbTypes::Type wkbType25d = static_cast<QgsWkbTypes::Type>( geom.wkbType() - QgsWkbTypes::PointZ + QgsWkbTypes::Point25D );
+        mGeom2.reset( createEmptyGeometry( wkbType25d ) );
+      }
+    }
 
-        if ( !mGeom2 )
-        {
-          // there's a problem when layer type is set as wkbtype Polygon
-          // although there are also features of type MultiPolygon
-          // (at least in OGR provider)
-          // If the feature's wkbtype is different from the layer's wkbtype,
-          // try to export it too.
-          //
-          // Btw. OGRGeometry must be exactly of the type of the geometry which it will receive
-          // i.e. Polygons can't be imported to OGRMultiPolygon
-          mGeom2 = createEmptyGeometry( geom.wkbType() );
-        }
+    // drop m/z value if not present in output wkb type
+    if ( !QgsWkbTypes::hasZ( mWkbType ) && QgsWkbTypes::hasZ( geom.wkbType() ) )
+      geom.get()->dropZValue();
+    if ( !QgsWkbTypes::hasM( mWkbType ) && QgsWkbTypes::hasM( geom.wkbType() ) )
+      geom.get()->dropMValue();
 
-        if ( !mGeom2 )
-        {
-          mErrorMessage = QObject::tr( "Feature geometry not imported (OGR error: %1)" )
-                          .arg( QString::fromUtf8( CPLGetLastErrorMsg() ) );
-          mError = ErrFeatureWriteFailed;
-          QgsMessageLog::logMessage( mErrorMessage, QObject::tr( "OGR" ) );
-          return nullptr;
-        }
+    // add m/z values if not present in the input wkb type -- this is needed for formats which determine
+    // geometry type based on features, e.g. geojson
+    if ( QgsWkbTypes::hasZ( mWkbType ) && !QgsWkbTypes::hasZ( geom.wkbType() ) )
+      geom.get()->addZValue( 0 );
+    if ( QgsWkbTypes::hasM( mWkbType ) && !QgsWkbTypes::hasM( geom.wkbType() ) )
+      geom.get()->addMValue( 0 );
 
-        QByteArray wkb( geom.asWkb() );
-        OGRErr err = OGR_G_ImportFromWkb( mGeom2, reinterpret_cast<unsigned char *>( const_cast<char *>( wkb.constData() ) ), wkb.length() );
-        if ( err != OGRERR_NONE )
-        {
-          mErrorMessage = QObject::tr( "Feature geometry not imported (OGR error: %1)" )
-                          .arg( QString::fromUtf8( CPLGetLastErrorMsg() ) );
-          mError = ErrFeatureWriteFailed;
-          QgsMessageLog::logMessage( mErrorMessage, QObject::tr( "OGR" ) );
-          return nullptr;
-        }
+    if ( !mGeom2 )
+    {
+      // there's a problem when layer type is set as wkbtype Polygon
+      // although there are also features of type MultiPolygon
+      // (at least in OGR provider)
+      // If the feature's wkbtype is different from the layer's wkbtype,
+      // try to export it too.
+      //
+      // Btw. OGRGeometry must be exactly of the type of the geometry which it will receive
+      // i.e. Polygons can't be imported to OGRMultiPolygon
+      mGeom2.reset( createEmptyGeometry( geom.wkbType() ) );
+    }
 
-        // pass ownership to geometry
-        OGR_F_SetGeometryDirectly( poFeature.get(), mGeom2 );
-      }
-      else // wkb type matches
-      {
-        QByteArray wkb( geom.asWkb( QgsAbstractGeometry::FlagExportTrianglesAsPolygons ) );
-        OGRGeometryH ogrGeom = createEmptyGeometry( mWkbType );
-        OGRErr err = OGR_G_ImportFromWkb( ogrGeom, reinterpret_cast<unsigned char *>( const_cast<char *>( wkb.constData() ) ), wkb.length() );
-        if ( err != OGRERR_NONE )
-        {
-          mErrorMessage = QObject::tr( "Feature geometry not imported (OGR error: %1)" )
-                          .arg( QString::fromUtf8( CPLGetLastErrorMsg() ) );
-          mError = ErrFeatureWriteFailed;
-          QgsMessageLog::logMessage( mErrorMessage, QObject::tr( "OGR" ) );
-          return nullptr;
-        }
+    if ( !mGeom2 )
+    {
+      error = QObject::tr( "Feature geometry not imported (OGR error: %1)" )
+              .arg( QString::fromUtf8( CPLGetLastErrorMsg() ) );
+      QgsMessageLog::logMessage( error, QObject::tr( "OGR" ) );
+      return nullptr;
+    }
 
-        // set geometry (ownership is passed to OGR)
-        OGR_F_SetGeometryDirectly( poFeature.get(), ogrGeom );
-      }
+    QByteArray wkb( geom.asWkb() );
+    OGRErr err = OGR_G_ImportFromWkb( mGeom2.get(), reinterpret_cast<unsigned char *>( const_cast<char *>( wkb.constData() ) ), wkb.length() );
+    if ( err != OGRERR_NONE )
+    {
+      error = QObject::tr( "Feature geometry not imported (OGR error: %1)" )
+              .arg( QString::fromUtf8( CPLGetLastErrorMsg() ) );
+      QgsMessageLog::logMessage( error, QObject::tr( "OGR" ) );
+      return nullptr;
     }
-    else
+
+    return mGeom2;
+  }
+  else // wkb type matches
+  {
+    QByteArray wkb( geom.asWkb( QgsAbstractGeometry::FlagExportTrianglesAsPolygons ) );
+    gdal::ogr_geometry_unique_ptr ogrGeom( createEmptyGeometry( mWkbType ) );
+    OGRErr err = OGR_G_ImportFromWkb( ogrGeom.get(), reinterpret_cast<unsigned char *>( const_cast<char *>( wkb.constData() ) ), wkb.length() );
+    if ( err != OGRERR_NONE )
     {
-      OGR_F_SetGeometryDirectly( poFeature.get(), createEmptyGeometry( mWkbType ) );
+      error = QObject::tr( "Feature geometry not imported (OGR error: %1)" )
+              .arg( QString::fromUtf8( CPLGetLastErrorMsg() ) );
+      QgsMessageLog::logMessage( error, QObject::tr( "OGR" ) );
+      return nullptr;
     }
+
+    return ogrGeom;
   }
-  return poFeature;
 }
 
 void QgsVectorFileWriter::resetMap( const QgsAttributeList &attributes )
@@ -2686,6 +2779,25 @@ bool QgsVectorFileWriter::writeFeature( OGRLayerH layer, OGRFeatureH feature )
   return true;
 }
 
+void QgsVectorFileWriter::createDeferredSpatialIndex()
+{
+  QString layerName = QString::fromUtf8( OGR_L_GetName( mLayer ) );
+  QString geometryColumn = QString::fromUtf8( OGR_L_GetGeometryColumn( mLayer ) );
+  const QString sql = QStringLiteral( "SELECT CreateSpatialIndex('%1', '%2')" )
+                      .arg( layerName.replace( '\'', QLatin1String( "''" ) ),
+                            geometryColumn.replace( '\'', QLatin1String( "''" ) ) );
+
+  CPLErrorReset();
+  OGRLayerH result = OGR_DS_ExecuteSQL( mDS.get(), sql.toUtf8().constData(), nullptr, nullptr );
+  if ( result )
+    OGR_DS_ReleaseResultSet( mDS.get(), result );
+  if ( CPLGetLastErrorType() == CE_Failure )
+  {
+    QgsMessageLog::logMessage( QObject::tr( "Error while creating the spatial index of layer %1 (OGR error: %2)" )
+                               .arg( QString::fromUtf8( OGR_L_GetName( mLayer ) ), QString::fromUtf8( CPLGetLastErrorMsg() ) ), QObject::tr( "OGR" ) );
+  }
+}
+
 QgsVectorFileWriter::~QgsVectorFileWriter()
 {
   if ( mUsingTransaction )
@@ -2696,6 +2808,9 @@ QgsVectorFileWriter::~QgsVectorFileWriter()
     }
   }
 
+  if ( mDeferredSpatialIndex && mLayer )
+    createDeferredSpatialIndex();
+
   mDS.reset();
 
   if ( mOgrRef )
@@ -3060,6 +3175,38 @@ QgsVectorFileWriter::WriterError QgsVectorFileWriter::writeAsVectorFormatV2( Pre
   // Reset mFields to layer fields, and not just exported fields
   writer->mFields = details.sourceFields;
 
+  // features are added in batches, so that their geometries are converted in parallel
+  QgsFeatureList batch;
+  QStringList batchErrors;
+  auto writeBatch = [&]() -> bool
+  {
+    batchErrors.clear();
+    errors += writer->addFeaturesWithStyle( batch, writer->mRenderer.get(), mapUnits, false, &batchErrors );
+    n += batch.size();
+    batch.clear();
+    if ( !batchErrors.isEmpty() && errorMessage )
+    {
+      if ( errorMessage->isEmpty() )
+      {
+        *errorMessage = QObject::tr( "Feature write errors:" );
+      }
+      for ( const QString &error : qgis::as_const( batchErrors ) )
+        *errorMessage += '\n' + error;
+    }
+
+    if ( errors > 1000 )
+    {
+      if ( errorMessage )
+      {
+        *errorMessage += QObject::tr( "Stopping after %1 errors" ).arg( errors );
+      }
+
+      n = -1;
+      return false;
+    }
+    return true;
+  };
+
   // write all features
   long saved = 0;
   int initialProgress = lastProgressReport;
@@ -3113,33 +3260,14 @@ QgsVectorFileWriter::WriterError QgsVectorFileWriter::writeAsVectorFormatV2( Pre
       fet.initAttributes( 0 );
     }
 
-    if ( !writer->addFeatureWithStyle( fet, writer->mRenderer.get(), mapUnits ) )
-    {
-      WriterError err = writer->hasError();
-      if ( err != NoError && errorMessage )
-      {
-        if ( errorMessage->isEmpty() )
-        {
-          *errorMessage = QObject::tr( "Feature write errors:" );
-        }
-        *errorMessage += '\n' + writer->errorMessage();
-      }
-      errors++;
-
-      if ( errors > 1000 )
-      {
-        if ( errorMessage )
-        {
-          *errorMessage += QObject::tr( "Stopping after %1 errors" ).arg( errors );
-        }
-
-        n = -1;
-        break;
-      }
-    }
-    n++;
+    batch << fet;
+    if ( batch.size() >= WRITE_BATCH_SIZE && !writeBatch() )
+      break;
   }
 
+  if ( !batch.isEmpty() )
+    writeBatch();
+
   writer->stopRender();
 
   if ( errors > 0 && errorMessage && n > 0 )
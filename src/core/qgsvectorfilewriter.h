@@ -979,10 +979,40 @@ class CORE_EXPORT QgsVectorFileWriter : public QgsFeatureSink
     bool mUsingTransaction = false;
     bool supportsStringList = false;
 
+    //! TRUE if the spatial index is built in bulk once all features are written, instead of being updated for each feature
+    bool mDeferredSpatialIndex = false;
+
     void createSymbolLayerTable( QgsVectorLayer *vl, const QgsCoordinateTransform &ct, OGRDataSourceH ds );
     gdal::ogr_feature_unique_ptr createFeature( const QgsFeature &feature );
+
+    /**
+     * Creates the OGR feature for a \a feature whose \a geometry was already converted by createOgrGeometry(),
+     * which set \a geometryError if the conversion failed.
+     */
+    gdal::ogr_feature_unique_ptr createFeature( const QgsFeature &feature, gdal::ogr_geometry_unique_ptr geometry, const QString &geometryError );
+
+    /**
+     * Converts the geometry of a \a feature to an OGR geometry of the layer type, transformed to the
+     * layer CRS if needed. Returns nullptr and sets \a error if the geometry cannot be converted.
+     * This is safe to call from several threads at once.
+     */
+    gdal::ogr_geometry_unique_ptr createOgrGeometry( const QgsFeature &feature, QString &error ) const;
+
+    /**
+     * Adds a batch of \a features, whose geometries are converted on the global thread pool before they are written
+     * in order. Stops at the first failure if \a stopOnError is TRUE. Returns the number of features which could
+     * not be written, and appends their error messages to \a errors.
+     */
+    int addFeaturesWithStyle( QgsFeatureList &features, QgsFeatureRenderer *renderer, QgsUnitTypes::DistanceUnit outputUnit, bool stopOnError, QStringList *errors = nullptr );
+
+    //! Writes an OGR \a poFeature created for \a feature, with the styles of the \a renderer symbols if symbology is exported
+    bool writeFeatureWithStyle( QgsFeature &feature, OGRFeatureH poFeature, QgsFeatureRenderer *renderer, QgsUnitTypes::DistanceUnit outputUnit );
+
     bool writeFeature( OGRLayerH layer, OGRFeatureH feature );
 
+    //! Builds the spatial index deferred by init() in bulk, once all the features are written
+    void createDeferredSpatialIndex();
+
     //! Writes features considering symbol level order
     QgsVectorFileWriter::WriterError exportFeaturesSymbolLevels( const PreparedWriterDetails &details, QgsFeatureIterator &fit, const QgsCoordinateTransform &ct, QString *errorMessage = nullptr );
     double mmScaleFactor( double scale, QgsUnitTypes::RenderUnit symbolUnits, QgsUnitTypes::DistanceUnit mapUnits );
@@ -50,6 +50,7 @@
 #include "qgscurve.h"
 #include "qgsdatasourceuri.h"
 #include "qgsexpressionfieldbuffer.h"
+#include "qgsexpressionfieldvaluecache.h"
 #include "qgsexpressionnodeimpl.h"
 #include "qgsfeature.h"
 #include "qgsfeaturerequest.h"
@@ -88,6 +89,7 @@
 #include "qgsstyle.h"
 #include "qgspallabeling.h"
 #include "qgsrulebasedlabeling.h"
+#include "qgssimplifiedgeometrycache.h"
 #include "qgssimplifymethod.h"
 #include "qgsstoredexpressionmanager.h"
 #include "qgsexpressioncontext.h"
@@ -143,6 +145,9 @@ typedef bool deleteStyleById_t(
   QString &errCause
 );
 
+//! Maximum number of aggregate results cached by a layer
+static const int MAX_CACHED_AGGREGATES = 1000;
+
 
 QgsVectorLayer::QgsVectorLayer( const QString &vectorLayerPath,
                                 const QString &baseName,
@@ -174,6 +179,7 @@ QgsVectorLayer::QgsVectorLayer( const QString &vectorLayerPath,
   connect( mJoinBuffer, &QgsVectorLayerJoinBuffer::joinedFieldsChanged, this, &QgsVectorLayer::onJoinedFieldsChanged );
 
   mExpressionFieldBuffer = new QgsExpressionFieldBuffer();
+  mExpressionFieldValueCache = std::make_shared< QgsExpressionFieldValueCache >();
   // if we're given a provider type, try to create and bind one to this layer
   if ( !vectorLayerPath.isEmpty() && !mProviderKey.isEmpty() )
   {
@@ -209,6 +215,42 @@ QgsVectorLayer::QgsVectorLayer( const QString &vectorLayerPath,
   mSimplifyMethod.setThreshold( settings.value( QStringLiteral( "qgis/simplifyDrawingTol" ), mSimplifyMethod.threshold() ).toFloat() );
   mSimplifyMethod.setForceLocalOptimization( settings.value( QStringLiteral( "qgis/simplifyLocal" ), mSimplifyMethod.forceLocalOptimization() ).toBool() );
   mSimplifyMethod.setMaximumScale( settings.value( QStringLiteral( "qgis/simplifyMaxScale" ), mSimplifyMethod.maximumScale() ).toFloat() );
+
+  if ( settings.value( QStringLiteral( "qgis/simplifyCachedLevels" ), true ).toBool() )
+  {
+    mSimplifiedGeometryCache = std::make_shared< QgsSimplifiedGeometryCache >();
+    auto clearSimplifiedGeometries = [ = ] { mSimplifiedGeometryCache->clear(); };
+    connect( this, &QgsMapLayer::dataChanged, this, clearSimplifiedGeometries );
+    connect( this, &QgsMapLayer::dataSourceChanged, this, clearSimplifiedGeometries );
+    connect( this, &QgsVectorLayer::subsetStringChanged, this, clearSimplifiedGeometries );
+    connect( this, &QgsVectorLayer::afterCommitChanges, this, clearSimplifiedGeometries );
+  }
+
+  connect( this, &QgsMapLayer::dataChanged, this, &QgsVectorLayer::clearAggregateCache );
+  connect( this, &QgsMapLayer::dataSourceChanged, this, &QgsVectorLayer::clearAggregateCache );
+  connect( this, &QgsVectorLayer::layerModified, this, &QgsVectorLayer::clearAggregateCache );
+  connect( this, &QgsVectorLayer::subsetStringChanged, this, &QgsVectorLayer::clearAggregateCache );
+  connect( this, &QgsVectorLayer::afterCommitChanges, this, &QgsVectorLayer::clearAggregateCache );
+  connect( this, &QgsVectorLayer::afterRollBack, this, &QgsVectorLayer::clearAggregateCache );
+  connect( this, &QgsVectorLayer::updatedFields, this, &QgsVectorLayer::clearAggregateCache );
+
+  connect( this, &QgsMapLayer::dataChanged, this, [ = ] { invalidateExpressionFieldValues(); } );
+  connect( this, &QgsMapLayer::dataSourceChanged, this, [ = ] { invalidateExpressionFieldValues(); } );
+  connect( this, &QgsVectorLayer::subsetStringChanged, this, [ = ] { invalidateExpressionFieldValues(); } );
+  connect( this, &QgsVectorLayer::afterCommitChanges, this, [ = ] { invalidateExpressionFieldValues(); } );
+  connect( this, &QgsVectorLayer::afterRollBack, this, [ = ] { invalidateExpressionFieldValues(); } );
+  connect( this, &QgsVectorLayer::featureAdded, this, [ = ]( QgsFeatureId fid ) { invalidateExpressionFieldValues( fid ); } );
+  connect( this, &QgsVectorLayer::featureDeleted, this, [ = ]( QgsFeatureId fid ) { invalidateExpressionFieldValues( fid ); } );
+  connect( this, &QgsVectorLayer::attributeValueChanged, this, [ = ]( QgsFeatureId fid, int idx )
+  {
+    if ( !mExpressionFieldsFeatureLocal || mExpressionFieldsUseAllAttributes || mExpressionFieldInputs.contains( idx ) )
+      invalidateExpressionFieldValues( fid );
+  } );
+  connect( this, &QgsVectorLayer::geometryChanged, this, [ = ]( QgsFeatureId fid )
+  {
+    if ( !mExpressionFieldsFeatureLocal || mExpressionFieldsNeedGeometry )
+      invalidateExpressionFieldValues( fid );
+  } );
 } // QgsVectorLayer ctor
 
 
@@ -387,6 +429,15 @@ void QgsVectorLayer::reload()
 
 QgsMapLayerRenderer *QgsVectorLayer::createMapRenderer( QgsRenderContext &rendererContext )
 {
+  // build the simplified geometry levels requested by the previous renders
+  if ( mSimplifiedGeometryCache && mDataProvider && mSimplifyMethod.simplifyHints().testFlag( QgsVectorSimplifyMethod::GeometrySimplification ) )
+  {
+    mSimplifiedGeometryCache->setLayerExtent( extent() );
+    const QList<int> levels = mSimplifiedGeometryCache->takeRequestedLevels();
+    for ( int level : levels )
+      QgsApplication::taskManager()->addTask( QgsSimplifiedGeometryCache::createBuildTask( mSimplifiedGeometryCache, level, mDataProvider->featureSource(), name() ) );
+  }
+
   return new QgsVectorLayerRenderer( this, rendererContext );
 }
 
@@ -839,7 +890,8 @@ QgsRectangle QgsVectorLayer::extent() const
   if ( !isSpatial() )
     return rect;
 
-  if ( !mValidExtent && mLazyExtent && mDataProvider && !mDataProvider->hasMetadata() && mReadExtentFromXml && !mXmlExtent.isNull() )
+  // the stored extent is also used by layers read without their data provider
+  if ( !mValidExtent && mLazyExtent && ( !mDataProvider || !mDataProvider->hasMetadata() ) && mReadExtentFromXml && !mXmlExtent.isNull() )
   {
     mExtent = mXmlExtent;
     mValidExtent = true;
@@ -3045,6 +3097,42 @@ bool QgsVectorLayer::changeAttributeValue( QgsFeatureId fid, int field, const QV
   return result;
 }
 
+bool QgsVectorLayer::changeFieldValues( int field, const QHash<QgsFeatureId, QVariant> &newValues, const QHash<QgsFeatureId, QVariant> &oldValues, bool skipDefaultValues )
+{
+  bool result = false;
+
+  switch ( fields().fieldOrigin( field ) )
+  {
+    case QgsFields::OriginJoin:
+    {
+      result = true;
+      for ( auto it = newValues.constBegin(); it != newValues.constEnd(); ++it )
+        result &= changeAttributeValue( it.key(), field, it.value(), oldValues.value( it.key() ), true );
+      break;
+    }
+
+    case QgsFields::OriginProvider:
+    case QgsFields::OriginEdit:
+    case QgsFields::OriginExpression:
+    {
+      if ( mEditBuffer && mDataProvider )
+        result = mEditBuffer->changeFieldValues( field, newValues, oldValues );
+      break;
+    }
+
+    case QgsFields::OriginUnknown:
+      break;
+  }
+
+  if ( !skipDefaultValues && !mDefaultValueOnUpdateFields.isEmpty() )
+  {
+    for ( auto it = newValues.constBegin(); it != newValues.constEnd(); ++it )
+      updateDefaultValues( it.key() );
+  }
+
+  return result;
+}
+
 bool QgsVectorLayer::changeAttributeValues( QgsFeatureId fid, const QgsAttributeMap &newValues, const QgsAttributeMap &oldValues, bool skipDefaultValues )
 {
   bool result = true;
@@ -3815,6 +3903,120 @@ void QgsVectorLayer::updateExpressionField( int index, const QString &exp )
 {
   int oi = mFields.fieldOriginIndex( index );
   mExpressionFieldBuffer->updateExpression( oi, exp );
+  updateExpressionFieldInputs();
+}
+
+void QgsVectorLayer::setExpressionFieldValueCachingEnabled( bool enabled )
+{
+  if ( enabled == mExpressionFieldBuffer->valueCachingEnabled() )
+    return;
+
+  mExpressionFieldBuffer->setValueCachingEnabled( enabled );
+  mExpressionFieldValueCache->clear();
+}
+
+bool QgsVectorLayer::expressionFieldValueCachingEnabled() const
+{
+  return mExpressionFieldBuffer && mExpressionFieldBuffer->valueCachingEnabled();
+}
+
+void QgsVectorLayer::invalidateExpressionFieldValues()
+{
+  if ( expressionFieldValueCachingEnabled() )
+    mExpressionFieldValueCache->clear();
+}
+
+void QgsVectorLayer::invalidateExpressionFieldValues( QgsFeatureId fid )
+{
+  if ( !expressionFieldValueCachingEnabled() )
+    return;
+
+  // the values of all the features may depend on the changed one
+  if ( mExpressionFieldsFeatureLocal )
+    mExpressionFieldValueCache->invalidateFeature( fid );
+  else
+    mExpressionFieldValueCache->clear();
+}
+
+void QgsVectorLayer::updateExpressionFieldInputs()
+{
+  mExpressionFieldInputs.clear();
+  mExpressionFieldsNeedGeometry = false;
+  mExpressionFieldsFeatureLocal = true;
+  mExpressionFieldsUseAllAttributes = false;
+  mExpressionFieldLayers.clear();
+  mExpressionFieldRelations.clear();
+
+  // the values are invalidated by feature, whichever expression field depends on the changed attribute
+  const QList<QgsExpressionFieldBuffer::ExpressionField> expressions = mExpressionFieldBuffer->expressions();
+  for ( const QgsExpressionFieldBuffer::ExpressionField &field : expressions )
+  {
+    const QgsExpression &expression = field.cachedExpression;
+    mExpressionFieldInputs.unite( expression.referencedAttributeIndexes( mFields ) );
+    mExpressionFieldsUseAllAttributes |= expression.referencedColumns().contains( QgsFeatureRequest::ALL_ATTRIBUTES );
+    mExpressionFieldsNeedGeometry |= expression.needsGeometry();
+    mExpressionFieldsFeatureLocal &= QgsExpressionFieldValueCache::isFeatureLocal( expression );
+    // the expressions whose layers are not known are not cached
+    QgsExpressionFieldValueCache::referencedLayers( expression, mExpressionFieldLayers, mExpressionFieldRelations );
+  }
+
+  connectExpressionFieldLayers();
+  mExpressionFieldValueCache->clear();
+}
+
+void QgsVectorLayer::connectExpressionFieldLayers()
+{
+  for ( const QMetaObject::Connection &connection : qgis::as_const( mExpressionFieldLayerConnections ) )
+    disconnect( connection );
+  mExpressionFieldLayerConnections.clear();
+
+  if ( mExpressionFieldLayers.isEmpty() && mExpressionFieldRelations.isEmpty() )
+    return;
+
+  // the layers are resolved like the expression functions do, the ones added or removed later are resolved again
+  QgsProject *project = QgsProject::instance();
+  auto resolveAgain = [ = ]
+  {
+    connectExpressionFieldLayers();
+    invalidateExpressionFieldValues();
+  };
+  mExpressionFieldLayerConnections << connect( project, &QgsProject::layersAdded, this, resolveAgain );
+  mExpressionFieldLayerConnections << connect( project, &QgsProject::layersRemoved, this, resolveAgain );
+  mExpressionFieldLayerConnections << connect( project->relationManager(), &QgsRelationManager::changed, this, resolveAgain );
+
+  QSet<QgsMapLayer *> layers;
+  for ( const QString &layerRef : qgis::as_const( mExpressionFieldLayers ) )
+  {
+    QgsMapLayer *layer = project->mapLayer( layerRef );
+    if ( !layer )
+      layer = project->mapLayersByName( layerRef ).value( 0 );
+    if ( layer )
+      layers << layer;
+  }
+  for ( const QString &relationId : qgis::as_const( mExpressionFieldRelations ) )
+  {
+    if ( QgsVectorLayer *layer = project->relationManager()->relation( relationId ).referencingLayer() )
+      layers << layer;
+  }
+  // the edits of this layer are tracked already
+  layers.remove( this );
+
+  auto invalidate = [ = ] { invalidateExpressionFieldValues(); };
+  for ( QgsMapLayer *layer : qgis::as_const( layers ) )
+  {
+    mExpressionFieldLayerConnections << connect( layer, &QgsMapLayer::dataChanged, this, invalidate );
+    mExpressionFieldLayerConnections << connect( layer, &QgsMapLayer::dataSourceChanged, this, invalidate );
+    if ( QgsVectorLayer *vectorLayer = qobject_cast<QgsVectorLayer *>( layer ) )
+    {
+      mExpressionFieldLayerConnections << connect( vectorLayer, &QgsVectorLayer::featureAdded, this, invalidate );
+      mExpressionFieldLayerConnections << connect( vectorLayer, &QgsVectorLayer::featureDeleted, this, invalidate );
+      mExpressionFieldLayerConnections << connect( vectorLayer, &QgsVectorLayer::attributeValueChanged, this, invalidate );
+      mExpressionFieldLayerConnections << connect( vectorLayer, &QgsVectorLayer::geometryChanged, this, invalidate );
+      mExpressionFieldLayerConnections << connect( vectorLayer, &QgsVectorLayer::subsetStringChanged, this, invalidate );
+      mExpressionFieldLayerConnections << connect( vectorLayer, &QgsVectorLayer::afterRollBack, this, invalidate );
+      mExpressionFieldLayerConnections << connect( vectorLayer, &QgsVectorLayer::updatedFields, this, invalidate );
+    }
+  }
 }
 
 void QgsVectorLayer::updateFields()
@@ -3925,6 +4127,9 @@ void QgsVectorLayer::updateFields()
     mFields[index].setEditorWidgetSetup( fieldWidgetIterator.value() );
   }
 
+  if ( mExpressionFieldBuffer )
+    updateExpressionFieldInputs();
+
   if ( oldFields != mFields )
   {
     emit updatedFields();
@@ -4334,33 +4539,113 @@ QVariant QgsVectorLayer::aggregate( QgsAggregateCalculator::Aggregate aggregate,
     return QVariant();
   }
 
+  const QString cacheKey = aggregateCacheKey( aggregate, fieldOrExpression, parameters, fids );
+  int cacheGeneration = 0;
+  if ( !cacheKey.isEmpty() )
+  {
+    QMutexLocker locker( &mAggregateCacheMutex );
+    const auto it = mAggregateCache.constFind( cacheKey );
+    if ( it != mAggregateCache.constEnd() )
+    {
+      if ( ok )
+        *ok = true;
+      return it.value();
+    }
+    cacheGeneration = mAggregateCacheGeneration;
+  }
+
+  QVariant result;
+  bool resultOk = false;
+
   // test if we are calculating based on a field
   int attrIndex = mFields.lookupField( fieldOrExpression );
-  if ( attrIndex >= 0 )
+  // aggregate is based on a field - if it's a provider field, we could possibly hand over the calculation
+  // to the provider itself, unless the provider does not have the uncommitted changes
+  if ( attrIndex >= 0 && mFields.fieldOrigin( attrIndex ) == QgsFields::OriginProvider && !( mEditBuffer && mEditBuffer->isModified() ) )
+  {
+    result = mDataProvider->aggregate( aggregate, attrIndex, parameters, context, resultOk, fids );
+  }
+
+  if ( !resultOk )
   {
-    // aggregate is based on a field - if it's a provider field, we could possibly hand over the calculation
-    // to the provider itself
-    QgsFields::FieldOrigin origin = mFields.fieldOrigin( attrIndex );
-    if ( origin == QgsFields::OriginProvider )
+    // fallback to using aggregate calculator to determine aggregate
+    QgsAggregateCalculator c( this );
+    if ( fids )
+      c.setFidsFilter( *fids );
+    c.setParameters( parameters );
+    result = c.calculate( aggregate, fieldOrExpression, context, &resultOk );
+  }
+
+  if ( resultOk && !cacheKey.isEmpty() )
+  {
+    QMutexLocker locker( &mAggregateCacheMutex );
+    // the features may have changed during the calculation
+    if ( cacheGeneration == mAggregateCacheGeneration )
     {
-      bool providerOk = false;
-      QVariant val = mDataProvider->aggregate( aggregate, attrIndex, parameters, context, providerOk, fids );
-      if ( providerOk )
-      {
-        // provider handled calculation
-        if ( ok )
-          *ok = true;
-        return val;
-      }
+      if ( mAggregateCache.size() >= MAX_CACHED_AGGREGATES )
+        mAggregateCache.clear();
+      mAggregateCache.insert( cacheKey, result );
     }
   }
 
-  // fallback to using aggregate calculator to determine aggregate
-  QgsAggregateCalculator c( this );
+  if ( ok )
+    *ok = resultOk;
+  return result;
+}
+
+void QgsVectorLayer::clearAggregateCache()
+{
+  QMutexLocker locker( &mAggregateCacheMutex );
+  mAggregateCache.clear();
+  ++mAggregateCacheGeneration;
+}
+
+QString QgsVectorLayer::aggregateCacheKey( QgsAggregateCalculator::Aggregate aggregate, const QString &fieldOrExpression,
+    const QgsAggregateCalculator::AggregateParameters &parameters, const QgsFeatureIds *fids ) const
+{
   if ( fids )
-    c.setFidsFilter( *fids );
-  c.setParameters( parameters );
-  return c.calculate( aggregate, fieldOrExpression, context, ok );
+    return QString();
+
+  // the results only depend on the provider and edited fields of the features of this layer
+  auto dependsOnFeaturesOnly = [ = ]( const QString & expressionString ) -> bool
+  {
+    const QgsExpression expression( expressionString );
+    if ( !QgsExpressionFieldValueCache::isCacheable( expression ) || !QgsExpressionFieldValueCache::isFeatureLocal( expression ) )
+      return false;
+
+    const QSet<QString> columns = expression.referencedColumns();
+    for ( const QString &column : columns )
+    {
+      const int index = mFields.lookupField( column );
+      if ( column == QgsFeatureRequest::ALL_ATTRIBUTES ||
+           ( index >= 0 && mFields.fieldOrigin( index ) != QgsFields::OriginProvider && mFields.fieldOrigin( index ) != QgsFields::OriginEdit ) )
+        return false;
+    }
+    return true;
+  };
+
+  const int attrIndex = mFields.lookupField( fieldOrExpression );
+  if ( attrIndex >= 0 )
+  {
+    if ( mFields.fieldOrigin( attrIndex ) != QgsFields::OriginProvider && mFields.fieldOrigin( attrIndex ) != QgsFields::OriginEdit )
+      return QString();
+  }
+  else if ( !dependsOnFeaturesOnly( fieldOrExpression ) )
+  {
+    return QString();
+  }
+
+  if ( !parameters.filter.isEmpty() && !dependsOnFeaturesOnly( parameters.filter ) )
+    return QString();
+
+  for ( const QgsFeatureRequest::OrderByClause &clause : parameters.orderBy )
+  {
+    if ( !dependsOnFeaturesOnly( clause.expression().expression() ) )
+      return QString();
+  }
+
+  return QStringLiteral( "%1:%2:%3:%4:%5" ).arg( QString::number( static_cast< int >( aggregate ) ), fieldOrExpression,
+         parameters.filter, parameters.delimiter, parameters.orderBy.dump() );
 }
 
 void QgsVectorLayer::setFeatureBlendMode( QPainter::CompositionMode featureBlendMode )
@@ -64,6 +64,8 @@ class QgsRectangle;
 class QgsRelation;
 class QgsWeakRelation;
 class QgsRelationManager;
+class QgsSimplifiedGeometryCache;
+class QgsExpressionFieldValueCache;
 class QgsSingleSymbolRenderer;
 class QgsStoredExpressionManager;
 class QgsSymbol;
@@ -711,6 +713,43 @@ class CORE_EXPORT QgsVectorLayer : public QgsMapLayer, public QgsExpressionConte
      */
     void updateExpressionField( int index, const QString &exp );
 
+    /**
+     * Sets whether the values of the expression based (virtual) fields are cached by feature id.
+     *
+     * When enabled, the values are evaluated once per feature and then read from the cache,
+     * which mostly speeds up expressions which are costly to evaluate, like the ones with
+     * aggregates or get_feature(). The values of a feature are invalidated when one of the
+     * attributes referenced by the expressions or its geometry is edited. If an expression
+     * depends on other features, all the values are invalidated when any feature changes.
+     * Expressions using variables or random values and expressions using joined fields are
+     * not cached.
+     *
+     * Expressions reading other layers with get_feature(), aggregate(), relation_aggregate()
+     * or layer_property() are cached when these layers are given as literal values, and all
+     * the values are invalidated when the features of these layers change.
+     *
+     * \see expressionFieldValueCachingEnabled()
+     * \since QGIS 3.16
+     */
+    void setExpressionFieldValueCachingEnabled( bool enabled );
+
+    /**
+     * Returns TRUE if the values of the expression based (virtual) fields are cached by feature id.
+     *
+     * \see setExpressionFieldValueCachingEnabled()
+     * \since QGIS 3.16
+     */
+    bool expressionFieldValueCachingEnabled() const;
+
+    /**
+     * Removes all the cached values of the expression based (virtual) fields, so that they
+     * are evaluated again.
+     *
+     * \see setExpressionFieldValueCachingEnabled()
+     * \since QGIS 3.16
+     */
+    void invalidateExpressionFieldValues();
+
     /**
      * Returns all layer actions defined on this layer.
      *
@@ -1786,6 +1825,29 @@ class CORE_EXPORT QgsVectorLayer : public QgsMapLayer, public QgsExpressionConte
      */
     bool changeAttributeValues( QgsFeatureId fid, const QgsAttributeMap &newValues, const QgsAttributeMap &oldValues = QgsAttributeMap(), bool skipDefaultValues = false );
 
+    /**
+     * Changes the values of the attribute \a field for several features (but does not
+     * immediately commit the changes).
+     *
+     * The new values are given by feature ID in \a newValues. As with changeAttributeValue(),
+     * the values in \a oldValues are used for undo operations, and the current values of the
+     * features without a valid old value are retrieved from the provider when the change is undone.
+     *
+     * Unlike repeated calls to changeAttributeValue(), the changes are stored as a single
+     * undo command, which makes bulk edits of many features much faster.
+     *
+     * If \a skipDefaultValues is set to TRUE, default field values will not
+     * be updated.
+     *
+     * \returns TRUE if the values of all the features were successfully changed.
+     *
+     * \note only valid for layers in which edits have been enabled by a call to startEditing().
+     *
+     * \see changeAttributeValue()
+     * \since QGIS 3.16
+     */
+    bool changeFieldValues( int field, const QHash<QgsFeatureId, QVariant> &newValues, const QHash<QgsFeatureId, QVariant> &oldValues = QHash<QgsFeatureId, QVariant>(), bool skipDefaultValues = false );
+
     /**
      * Add an attribute field (but does not commit it)
      * returns TRUE if the field was added
@@ -2187,6 +2249,11 @@ class CORE_EXPORT QgsVectorLayer : public QgsMapLayer, public QgsExpressionConte
      * \param ok if specified, will be set to TRUE if aggregate calculation was successful
      * \param fids list of fids to filter, otherwise will use all fids
      * \returns calculated aggregate value
+     *
+     * Since QGIS 3.16, the results are cached by the layer until its features change,
+     * when \a fids is not set and neither the aggregated expression nor the filter
+     * depend on variables, the selection, other features or joined and virtual fields.
+     *
      * \since QGIS 2.16
      */
     QVariant aggregate( QgsAggregateCalculator::Aggregate aggregate,
@@ -2751,6 +2818,25 @@ class CORE_EXPORT QgsVectorLayer : public QgsMapLayer, public QgsExpressionConte
   private:
     void updateDefaultValues( QgsFeatureId fid, QgsFeature feature = QgsFeature() );
 
+    //! Updates the inputs of the expression fields and clears their cached values
+    void updateExpressionFieldInputs();
+
+    //! Connects the changes of the layers read by the expression fields to the invalidation of their cached values
+    void connectExpressionFieldLayers();
+
+    //! Clears the cached aggregate results
+    void clearAggregateCache();
+
+    /**
+     * Returns the key of the aggregate cache for the parameters of aggregate(), or an empty
+     * string if the result cannot be cached.
+     */
+    QString aggregateCacheKey( QgsAggregateCalculator::Aggregate aggregate, const QString &fieldOrExpression,
+                               const QgsAggregateCalculator::AggregateParameters &parameters, const QgsFeatureIds *fids ) const;
+
+    //! Invalidates the cached expression field values depending on the feature \a fid
+    void invalidateExpressionFieldValues( QgsFeatureId fid );
+
     /**
      * Returns TRUE if the provider is in read-only mode
      */
@@ -2921,8 +3007,44 @@ class CORE_EXPORT QgsVectorLayer : public QgsMapLayer, public QgsExpressionConte
 
     mutable QMutex mFeatureSourceConstructorMutex;
 
+    //! Protects the aggregate cache, aggregates are calculated from several threads
+    mutable QMutex mAggregateCacheMutex;
+
+    //! Cached aggregate results, by aggregate, expression and parameters
+    mutable QHash<QString, QVariant> mAggregateCache;
+
+    //! Incremented each time the aggregate cache is cleared
+    int mAggregateCacheGeneration = 0;
+
     QgsVectorLayerFeatureCounter *mFeatureCounter = nullptr;
 
+    //! Geometries simplified at several tolerances for rendering, shared with the feature sources
+    std::shared_ptr< QgsSimplifiedGeometryCache > mSimplifiedGeometryCache;
+
+    //! Cached values of the expression fields, shared with the feature sources
+    std::shared_ptr< QgsExpressionFieldValueCache > mExpressionFieldValueCache;
+
+    //! Indexes of the fields referenced by the expression fields
+    QSet<int> mExpressionFieldInputs;
+
+    //! TRUE if an expression field uses the geometry
+    bool mExpressionFieldsNeedGeometry = false;
+
+    //! TRUE if the expression fields only depend on the feature they are evaluated for
+    bool mExpressionFieldsFeatureLocal = true;
+
+    //! TRUE if an expression field reads all the attributes, e.g. with attributes()
+    bool mExpressionFieldsUseAllAttributes = false;
+
+    //! Names or ids of the layers read by the expression fields
+    QSet<QString> mExpressionFieldLayers;
+
+    //! Ids of the relations read by the expression fields
+    QSet<QString> mExpressionFieldRelations;
+
+    //! Connections invalidating the cached expression field values on changes of the layers they read
+    QList<QMetaObject::Connection> mExpressionFieldLayerConnections;
+
     std::unique_ptr<QgsGeometryOptions> mGeometryOptions;
 
     bool mAllowCommit = true;
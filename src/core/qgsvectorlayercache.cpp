@@ -16,12 +16,91 @@
  ***************************************************************************/
 
 #include "qgsvectorlayercache.h"
+#include "qgsvectorlayercache_p.h"
+#include "qgsabstractgeometry.h"
+#include "qgsapplication.h"
 #include "qgscacheindex.h"
 #include "qgscachedfeatureiterator.h"
 #include "qgsvectorlayerjoininfo.h"
 #include "qgsvectorlayerjoinbuffer.h"
 #include "qgsvectorlayer.h"
 
+#include <algorithm>
+
+// the layer caches live in the main thread, like their layers
+static qint64 sSharedCacheBytes = 0;
+static qint64 sMaximumSharedCacheBytes = 0;
+
+//! Returns the approximate size in bytes of a cached \a feature
+static qint64 featureBytes( const QgsFeature &feature )
+{
+  qint64 bytes = sizeof( QgsFeature );
+  if ( const QgsAbstractGeometry *geometry = feature.geometry().constGet() )
+  {
+    const int dimensions = 2 + ( geometry->is3D() ? 1 : 0 ) + ( geometry->isMeasure() ? 1 : 0 );
+    bytes += 64 + static_cast< qint64 >( geometry->nCoordinates() ) * dimensions * sizeof( double );
+  }
+
+  const QgsAttributes attributes = feature.attributes();
+  for ( const QVariant &attribute : attributes )
+  {
+    bytes += sizeof( QVariant );
+    switch ( attribute.type() )
+    {
+      case QVariant::String:
+        bytes += attribute.toString().size() * sizeof( QChar );
+        break;
+      case QVariant::ByteArray:
+        bytes += attribute.toByteArray().size();
+        break;
+      default:
+        break;
+    }
+  }
+  return bytes;
+}
+
+///@cond PRIVATE
+
+QgsVectorLayerCacheFillTask::QgsVectorLayerCacheFillTask( QgsVectorLayer *layer, const QgsFeatureRequest &request )
+  : QgsTask( tr( "Loading features of %1" ).arg( layer->name() ), QgsTask::CanCancel | QgsTask::CancelWithoutPrompt )
+  , mSource( new QgsVectorLayerFeatureSource( layer ) )
+  , mRequest( request )
+  , mFeatureCount( layer->featureCount() )
+{
+}
+
+bool QgsVectorLayerCacheFillTask::run()
+{
+  QgsFeatureIterator it = mSource->getFeatures( mRequest );
+  QgsFeatureList features;
+  features.reserve( CHUNK_SIZE );
+  long count = 0;
+  QgsFeature feature;
+  while ( it.nextFeature( feature ) )
+  {
+    if ( isCanceled() )
+      return false;
+
+    features << feature;
+    ++count;
+    if ( features.size() == CHUNK_SIZE )
+    {
+      emit featuresFetched( features );
+      features.clear();
+      if ( mFeatureCount > 0 )
+        setProgress( 100.0 * count / mFeatureCount );
+    }
+  }
+
+  if ( !features.isEmpty() )
+    emit featuresFetched( features );
+  emit allFeaturesFetched();
+  return true;
+}
+
+///@endcond
+
 QgsVectorLayerCache::QgsVectorLayerCache( QgsVectorLayer *layer, int cacheSize, QObject *parent )
   : QObject( parent )
   , mLayer( layer )
@@ -46,8 +125,11 @@ QgsVectorLayerCache::QgsVectorLayerCache( QgsVectorLayer *layer, int cacheSize,
 
 QgsVectorLayerCache::~QgsVectorLayerCache()
 {
+  cancelBackgroundFill();
   qDeleteAll( mCacheIndices );
   mCacheIndices.clear();
+  // releases the size of the features from the shared budget while the members are alive
+  mCache.clear();
 }
 
 void QgsVectorLayerCache::setCacheSize( int cacheSize )
@@ -86,6 +168,7 @@ void QgsVectorLayerCache::setCacheSubsetOfAttributes( const QgsAttributeList &at
 
 void QgsVectorLayerCache::setFullCache( bool fullCache )
 {
+  cancelBackgroundFill();
   mFullCache = fullCache;
 
   if ( mFullCache )
@@ -125,6 +208,56 @@ void QgsVectorLayerCache::setFullCache( bool fullCache )
   }
 }
 
+void QgsVectorLayerCache::fillFullCacheInBackground()
+{
+  if ( mFillTask || !mLayer )
+    return;
+
+  mFillChangedFeatureIds.clear();
+  mFillDeletedFeatureIds.clear();
+  // Add a little more than necessary...
+  setCacheSize( mLayer->featureCount() + 100 );
+
+  QgsVectorLayerCacheFillTask *task = new QgsVectorLayerCacheFillTask( mLayer, QgsFeatureRequest()
+      .setSubsetOfAttributes( mCachedAttributes )
+      .setFlags( mCacheGeometry ? QgsFeatureRequest::NoFlags : QgsFeatureRequest::NoGeometry ) );
+  connect( task, &QgsVectorLayerCacheFillTask::featuresFetched, this, &QgsVectorLayerCache::onFeaturesFetched );
+  connect( task, &QgsVectorLayerCacheFillTask::allFeaturesFetched, this, &QgsVectorLayerCache::onAllFeaturesFetched );
+  mFillTask = task;
+  QgsApplication::taskManager()->addTask( task );
+}
+
+bool QgsVectorLayerCache::isFillingInBackground() const
+{
+  return !mFillTask.isNull();
+}
+
+void QgsVectorLayerCache::cancelBackgroundFill()
+{
+  if ( !mFillTask )
+    return;
+
+  mFillTask->cancel();
+  mFillTask = nullptr;
+  mFillChangedFeatureIds.clear();
+  mFillDeletedFeatureIds.clear();
+}
+
+void QgsVectorLayerCache::setMaximumSharedCacheBytes( qint64 bytes )
+{
+  sMaximumSharedCacheBytes = bytes;
+}
+
+qint64 QgsVectorLayerCache::maximumSharedCacheBytes()
+{
+  return sMaximumSharedCacheBytes;
+}
+
+qint64 QgsVectorLayerCache::sharedCacheBytes()
+{
+  return sSharedCacheBytes;
+}
+
 void QgsVectorLayerCache::addCacheIndex( QgsAbstractCacheIndex *cacheIndex )
 {
   mCacheIndices.append( cacheIndex );
@@ -234,7 +367,10 @@ void QgsVectorLayerCache::onAttributeValueChanged( QgsFeatureId fid, int field,
   if ( cachedFeat )
   {
     cachedFeat->mFeature->setAttribute( field, value );
+    updateCachedFeatureBytes( cachedFeat );
   }
+  if ( mFillTask )
+    mFillChangedFeatureIds.insert( fid );
 
   emit attributeValueChanged( fid, field, value );
 }
@@ -265,6 +401,8 @@ void QgsVectorLayerCache::onJoinAttributeValueChanged( QgsFeatureId fid, int fie
 void QgsVectorLayerCache::featureDeleted( QgsFeatureId fid )
 {
   mCache.remove( fid );
+  if ( mFillTask )
+    mFillDeletedFeatureIds.insert( fid );
 }
 
 void QgsVectorLayerCache::onFeatureAdded( QgsFeatureId fid )
@@ -279,6 +417,10 @@ void QgsVectorLayerCache::onFeatureAdded( QgsFeatureId fid )
     QgsFeature feat;
     featureAtId( fid, feat );
   }
+  else if ( mFillTask )
+  {
+    mFillChangedFeatureIds.insert( fid );
+  }
   emit featureAdded( fid );
 }
 
@@ -311,22 +453,111 @@ void QgsVectorLayerCache::geometryChanged( QgsFeatureId fid, const QgsGeometry &
   if ( cachedFeat )
   {
     cachedFeat->mFeature->setGeometry( geom );
+    updateCachedFeatureBytes( cachedFeat );
   }
+  if ( mFillTask )
+    mFillChangedFeatureIds.insert( fid );
 }
 
 void QgsVectorLayerCache::layerDeleted()
 {
+  cancelBackgroundFill();
   emit cachedLayerDeleted();
   mLayer = nullptr;
 }
 
 void QgsVectorLayerCache::invalidate()
 {
+  cancelBackgroundFill();
   mCache.clear();
   mFullCache = false;
   emit invalidated();
 }
 
+void QgsVectorLayerCache::onFeaturesFetched( const QgsFeatureList &features )
+{
+  // ignores the chunks still queued from a canceled task
+  if ( !mFillTask || sender() != mFillTask.data() )
+    return;
+
+  QgsFeatureIds fids;
+  for ( QgsFeature feature : features )
+  {
+    // the layer has a more recent version of these features
+    if ( mFillChangedFeatureIds.contains( feature.id() ) || mFillDeletedFeatureIds.contains( feature.id() ) )
+      continue;
+
+    cacheFeature( feature );
+    fids << feature.id();
+  }
+  emit featuresCached( fids );
+}
+
+void QgsVectorLayerCache::onAllFeaturesFetched()
+{
+  if ( !mFillTask || sender() != mFillTask.data() )
+    return;
+
+  mFillTask = nullptr;
+  mFullCache = true;
+  if ( cacheSize() <= mLayer->featureCount() )
+    setCacheSize( mLayer->featureCount() + 100 );
+
+  // reads the features added or changed while the task was running from the layer
+  QgsFeatureIds fids;
+  for ( QgsFeatureId fid : qgis::as_const( mFillChangedFeatureIds ) )
+  {
+    QgsFeature feature;
+    if ( !mFillDeletedFeatureIds.contains( fid ) && featureAtId( fid, feature, true ) )
+      fids << fid;
+  }
+  mFillChangedFeatureIds.clear();
+  mFillDeletedFeatureIds.clear();
+
+  if ( !fids.isEmpty() )
+    emit featuresCached( fids );
+  emit finished();
+}
+
+void QgsVectorLayerCache::cacheFeature( QgsFeature &feat )
+{
+  QgsCachedFeature *cachedFeature = new QgsCachedFeature( feat, this );
+  cachedFeature->mBytes = featureBytes( feat );
+  updateCacheBytes( cachedFeature->mBytes );
+  mCache.insert( feat.id(), cachedFeature );
+  trimToSharedBudget();
+}
+
+void QgsVectorLayerCache::updateCacheBytes( qint64 delta )
+{
+  mCacheBytes += delta;
+  sSharedCacheBytes += delta;
+}
+
+void QgsVectorLayerCache::updateCachedFeatureBytes( QgsCachedFeature *cachedFeature )
+{
+  const qint64 bytes = featureBytes( *cachedFeature->mFeature );
+  updateCacheBytes( bytes - cachedFeature->mBytes );
+  cachedFeature->mBytes = bytes;
+}
+
+void QgsVectorLayerCache::trimToSharedBudget()
+{
+  if ( sMaximumSharedCacheBytes <= 0 || mFullCache || mFillTask )
+    return;
+
+  while ( sSharedCacheBytes > sMaximumSharedCacheBytes && mCache.size() > 1 )
+  {
+    const qint64 excess = sSharedCacheBytes - sMaximumSharedCacheBytes;
+    const qint64 averageBytes = std::max< qint64 >( 1, mCacheBytes / mCache.size() );
+    const int drop = static_cast< int >( std::min< qint64 >( mCache.size() - 1, excess / averageBytes + 1 ) );
+    // QCache only drops its least recently used entries when its maximum cost is lowered
+    const int maxCost = mCache.maxCost();
+    mCache.setMaxCost( mCache.size() - drop );
+    mCache.setMaxCost( maxCost );
+  }
+}
+
 bool QgsVectorLayerCache::canUseCacheForRequest( const QgsFeatureRequest &featureRequest, QgsFeatureIterator &it )
 {
   // check first for available indices
@@ -26,11 +26,13 @@
 #include "qgsfeatureiterator.h"
 
 #include <QCache>
+#include <QPointer>
 
 class QgsVectorLayer;
 class QgsFeature;
 class QgsCachedFeatureIterator;
 class QgsAbstractCacheIndex;
+class QgsVectorLayerCacheFillTask;
 
 /**
  * \ingroup core
@@ -74,6 +76,7 @@ class CORE_EXPORT QgsVectorLayerCache : public QObject
           // That's the reason we need this wrapper:
           // Inform the cache that this feature has been removed
           mCache->featureRemoved( mFeature->id() );
+          mCache->updateCacheBytes( -mBytes );
           delete mFeature;
         }
 
@@ -82,6 +85,7 @@ class CORE_EXPORT QgsVectorLayerCache : public QObject
       private:
         QgsFeature *mFeature = nullptr;
         QgsVectorLayerCache *mCache = nullptr;
+        qint64 mBytes = 0;
 
         friend class QgsVectorLayerCache;
         Q_DISABLE_COPY( QgsCachedFeature )
@@ -162,6 +166,70 @@ class CORE_EXPORT QgsVectorLayerCache : public QObject
      */
     bool hasFullCache() const { return mFullCache; }
 
+    /**
+     * Reads all the features into the cache in a background task, as setFullCache( TRUE ) does
+     * in the calling thread.
+     *
+     * The features are added to the cache in chunks, with featuresCached() emitted for each of them, so that
+     * views can show the features progressively, and finished() once the cache is full, when hasFullCache()
+     * returns TRUE. Unlike setFullCache(), progress() is not emitted. Edits made to the layer while the cache
+     * is being filled are taken into account.
+     *
+     * \see isFillingInBackground()
+     * \see cancelBackgroundFill()
+     * \since QGIS 3.16
+     */
+    void fillFullCacheInBackground();
+
+    /**
+     * Returns TRUE if the cache is being filled by a background task started with fillFullCacheInBackground().
+     * \since QGIS 3.16
+     */
+    bool isFillingInBackground() const;
+
+    /**
+     * Cancels the background task started with fillFullCacheInBackground(), if any. The features
+     * already read are kept in the cache.
+     * \since QGIS 3.16
+     */
+    void cancelBackgroundFill();
+
+    /**
+     * Returns the approximate size in bytes of the features held in the cache.
+     * \see setMaximumSharedCacheBytes()
+     * \since QGIS 3.16
+     */
+    qint64 cacheBytes() const { return mCacheBytes; }
+
+    /**
+     * Sets the maximum approximate size in \a bytes of the features held by all the layer caches
+     * of the application, or 0 for no limit (the default).
+     *
+     * When this budget is exceeded, a cache adding features drops its least recently used features
+     * until the budget is met again. Caches holding all the features of their layer (see hasFullCache())
+     * or being filled in the background are never trimmed, as they need to keep all the features.
+     *
+     * \see maximumSharedCacheBytes()
+     * \see sharedCacheBytes()
+     * \since QGIS 3.16
+     */
+    static void setMaximumSharedCacheBytes( qint64 bytes );
+
+    /**
+     * Returns the maximum approximate size in bytes of the features held by all the layer caches
+     * of the application, or 0 for no limit.
+     * \see setMaximumSharedCacheBytes()
+     * \since QGIS 3.16
+     */
+    static qint64 maximumSharedCacheBytes();
+
+    /**
+     * Returns the approximate size in bytes of the features held by all the layer caches of the application.
+     * \see setMaximumSharedCacheBytes()
+     * \since QGIS 3.16
+     */
+    static qint64 sharedCacheBytes();
+
     /**
      * \brief
      * Adds a QgsAbstractCacheIndex to this cache. Cache indices know about features present
@@ -345,6 +413,13 @@ class CORE_EXPORT QgsVectorLayerCache : public QObject
      */
     void finished();
 
+    /**
+     * Emitted when the features with the specified \a fids are read into the cache by the background task
+     * started with fillFullCacheInBackground().
+     * \since QGIS 3.16
+     */
+    void featuresCached( const QgsFeatureIds &fids );
+
     /**
      * \brief Is emitted when the cached layer is deleted. Is emitted when the cached layers layerDelete()
      * signal is being emitted, but before the local reference to it has been set to NULLPTR. So call to
@@ -384,16 +459,23 @@ class CORE_EXPORT QgsVectorLayerCache : public QObject
     void geometryChanged( QgsFeatureId fid, const QgsGeometry &geom );
     void layerDeleted();
     void invalidate();
+    void onFeaturesFetched( const QgsFeatureList &features );
+    void onAllFeaturesFetched();
 
   private:
 
     void connectJoinedLayers() const;
 
-    inline void cacheFeature( QgsFeature &feat )
-    {
-      QgsCachedFeature *cachedFeature = new QgsCachedFeature( feat, this );
-      mCache.insert( feat.id(), cachedFeature );
-    }
+    void cacheFeature( QgsFeature &feat );
+
+    //! Adds \a delta to the size of the features held by this cache and all caches
+    void updateCacheBytes( qint64 delta );
+
+    //! Recomputes the size of a cached feature after it changed
+    void updateCachedFeatureBytes( QgsCachedFeature *cachedFeature );
+
+    //! Drops the least recently used features while all the caches exceed the shared budget
+    void trimToSharedBudget();
 
     QgsVectorLayer *mLayer = nullptr;
     QCache< QgsFeatureId, QgsCachedFeature > mCache;
@@ -404,6 +486,15 @@ class CORE_EXPORT QgsVectorLayerCache : public QObject
 
     QgsAttributeList mCachedAttributes;
 
+    qint64 mCacheBytes = 0;
+
+    QPointer< QgsVectorLayerCacheFillTask > mFillTask;
+    //! Features added or changed while the cache is being filled in the background, read again once it ends
+    QgsFeatureIds mFillChangedFeatureIds;
+    //! Features deleted while the cache is being filled in the background
+    QgsFeatureIds mFillDeletedFeatureIds;
+    int mFillFeatureCount = 0;
+
     friend class QgsCachedFeatureIterator;
     friend class QgsCachedFeatureWriterIterator;
     friend class QgsCachedFeature;
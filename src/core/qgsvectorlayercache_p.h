@@ -0,0 +1,77 @@
+/***************************************************************************
+                         qgsvectorlayercache_p.h
+                         -----------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSVECTORLAYERCACHE_PRIVATE_H
+#define QGSVECTORLAYERCACHE_PRIVATE_H
+
+#define SIP_NO_FILE
+
+/// @cond PRIVATE
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QGIS API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+
+#include "qgsfeature.h"
+#include "qgsfeaturerequest.h"
+#include "qgstaskmanager.h"
+#include "qgsvectorlayerfeatureiterator.h"
+
+#include <memory>
+
+/**
+ * \ingroup core
+ * A task reading all the features of a layer in a background thread for QgsVectorLayerCache,
+ * passing them to the cache in chunks.
+ */
+class QgsVectorLayerCacheFillTask : public QgsTask
+{
+    Q_OBJECT
+
+  public:
+
+    //! Number of features passed to the cache at once
+    static const int CHUNK_SIZE = 10000;
+
+    //! Constructor for QgsVectorLayerCacheFillTask, reading the features of \a layer matching \a request.
+    QgsVectorLayerCacheFillTask( QgsVectorLayer *layer, const QgsFeatureRequest &request );
+
+    bool run() override;
+
+  signals:
+
+    //! Emitted from the background thread for each chunk of read \a features
+    void featuresFetched( const QgsFeatureList &features );
+
+    //! Emitted from the background thread once all the features have been read, after the last featuresFetched()
+    void allFeaturesFetched();
+
+  private:
+
+    std::unique_ptr< QgsVectorLayerFeatureSource > mSource;
+    QgsFeatureRequest mRequest;
+    long mFeatureCount = 0;
+};
+
+/// @endcond
+
+#endif // QGSVECTORLAYERCACHE_PRIVATE_H
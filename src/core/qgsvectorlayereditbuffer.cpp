@@ -256,6 +256,36 @@ bool QgsVectorLayerEditBuffer::changeAttributeValue( QgsFeatureId fid, int field
   return true;
 }
 
+bool QgsVectorLayerEditBuffer::changeFieldValues( int field, const QHash<QgsFeatureId, QVariant> &newValues, const QHash<QgsFeatureId, QVariant> &oldValues )
+{
+  if ( field < 0 || field >= L->fields().count() ||
+       L->fields().fieldOrigin( field ) == QgsFields::OriginJoin ||
+       L->fields().fieldOrigin( field ) == QgsFields::OriginExpression )
+    return false;
+
+  const bool canChangeExisting = L->dataProvider()->capabilities() & QgsVectorDataProvider::ChangeAttributeValues;
+
+  // same checks as changeAttributeValue(), the features which cannot be changed are skipped
+  bool success = true;
+  QHash<QgsFeatureId, QVariant> values;
+  values.reserve( newValues.size() );
+  for ( auto it = newValues.constBegin(); it != newValues.constEnd(); ++it )
+  {
+    if ( FID_IS_NEW( it.key() ) ? !mAddedFeatures.contains( it.key() ) : !canChangeExisting )
+    {
+      success = false;
+      continue;
+    }
+    values.insert( it.key(), it.value() );
+  }
+
+  if ( values.isEmpty() )
+    return false;
+
+  L->undoStack()->push( new QgsVectorLayerUndoCommandChangeFieldValues( this, field, values, oldValues ) );
+  return success;
+}
+
 
 bool QgsVectorLayerEditBuffer::addAttribute( const QgsField &field )
 {
@@ -91,6 +91,15 @@ bool QgsVectorLayerEditPassthrough::changeAttributeValues( QgsFeatureId fid, con
   return modify( new QgsVectorLayerUndoPassthroughCommandChangeAttributes( this, fid, newValues, oldValues ) );
 }
 
+bool QgsVectorLayerEditPassthrough::changeFieldValues( int field, const QHash<QgsFeatureId, QVariant> &newValues, const QHash<QgsFeatureId, QVariant> & )
+{
+  // the changes are sent to the provider right away, one feature at a time
+  bool success = true;
+  for ( auto it = newValues.constBegin(); it != newValues.constEnd(); ++it )
+    success &= changeAttributeValue( it.key(), field, it.value() );
+  return success;
+}
+
 bool QgsVectorLayerEditPassthrough::addAttribute( const QgsField &field )
 {
   return modify( new QgsVectorLayerUndoPassthroughCommandAddAttribute( this, field ) );
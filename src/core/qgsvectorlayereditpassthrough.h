@@ -61,6 +61,7 @@ class CORE_EXPORT QgsVectorLayerEditPassthrough : public QgsVectorLayerEditBuffe
      * \since QGIS 3.0
      */
     bool changeAttributeValues( QgsFeatureId fid, const QgsAttributeMap &newValues, const QgsAttributeMap &oldValues ) override;
+    bool changeFieldValues( int field, const QHash<QgsFeatureId, QVariant> &newValues, const QHash<QgsFeatureId, QVariant> &oldValues ) override;
 
     bool addAttribute( const QgsField &field ) override;
     bool deleteAttribute( int attr ) override;
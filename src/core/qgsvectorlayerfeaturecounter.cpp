@@ -66,18 +66,44 @@ bool QgsVectorLayerFeatureCounter::run()
 
     mRenderer->startRender( renderContext, mSource->fields() );
 
+    // categorized and graduated renderers on a field classify the features by their value only,
+    // the features are then grouped by value and the legend keys are looked up once per value
+    const bool classifiesByValue = mRenderer->type() == QLatin1String( "categorizedSymbol" ) || mRenderer->type() == QLatin1String( "graduatedSymbol" );
+    const int classificationField = classifiesByValue ? mSource->fields().lookupField( mRenderer->legendClassificationAttribute() ) : -1;
+    struct ValueGroup
+    {
+      QVariant value;
+      long count = 0;
+      QgsFeatureIds ids;
+    };
+    QHash< QString, ValueGroup > valueGroups;
+    ValueGroup nullValueGroup;
+
     double progress = 0;
     QgsFeature f;
     while ( fit.nextFeature( f ) )
     {
-      renderContext.expressionContext().setFeature( f );
-
-      const QSet<QString> featureKeyList = mRenderer->legendKeysForFeature( f, renderContext );
-      for ( const QString &key : featureKeyList )
+      if ( classificationField >= 0 )
       {
-        mSymbolFeatureCountMap[key] += 1;
+        const QVariant value = f.attribute( classificationField );
+        ValueGroup &group = value.isNull() ? nullValueGroup : valueGroups[ value.toString() ];
+        if ( group.count == 0 )
+          group.value = value;
+        group.count++;
         if ( mWithFids )
-          mSymbolFeatureIdMap[key].insert( f.id() );
+          group.ids.insert( f.id() );
+      }
+      else
+      {
+        renderContext.expressionContext().setFeature( f );
+
+        const QSet<QString> featureKeyList = mRenderer->legendKeysForFeature( f, renderContext );
+        for ( const QString &key : featureKeyList )
+        {
+          mSymbolFeatureCountMap[key] += 1;
+          if ( mWithFids )
+            mSymbolFeatureIdMap[key].insert( f.id() );
+        }
       }
       ++featuresCounted;
 
@@ -94,6 +120,29 @@ bool QgsVectorLayerFeatureCounter::run()
         return false;
       }
     }
+
+    if ( classificationField >= 0 )
+    {
+      QgsFeature valueFeature( mSource->fields() );
+      auto countValueGroup = [ & ]( const ValueGroup & group )
+      {
+        if ( group.count == 0 )
+          return;
+
+        valueFeature.setAttribute( classificationField, group.value );
+        renderContext.expressionContext().setFeature( valueFeature );
+        const QSet<QString> featureKeyList = mRenderer->legendKeysForFeature( valueFeature, renderContext );
+        for ( const QString &key : featureKeyList )
+        {
+          mSymbolFeatureCountMap[key] += group.count;
+          if ( mWithFids )
+            mSymbolFeatureIdMap[key].unite( group.ids );
+        }
+      };
+      countValueGroup( nullValueGroup );
+      for ( const ValueGroup &group : qgis::as_const( valueGroups ) )
+        countValueGroup( group );
+    }
     mRenderer->stopRender( renderContext );
   }
   setProgress( 100 );
@@ -14,8 +14,11 @@
  ***************************************************************************/
 #include "qgsvectorlayerfeatureiterator.h"
 
+#include "qgsexpression.h"
 #include "qgsexpressionfieldbuffer.h"
+#include "qgsexpressionfieldvaluecache.h"
 #include "qgsgeometrysimplifier.h"
+#include "qgssimplifiedgeometrycache.h"
 #include "qgssimplifymethod.h"
 #include "qgsvectordataprovider.h"
 #include "qgsvectorlayereditbuffer.h"
@@ -26,8 +29,12 @@
 #include "qgsproject.h"
 #include "qgsmessagelog.h"
 #include "qgsexception.h"
+#include "qgsfeaturebatch.h"
 #include "qgsexpressioncontextutils.h"
 
+//! Maximum number of provider features whose joined features are looked up with a single request
+static const int MAX_JOIN_BATCH_SIZE = 1000;
+
 QgsVectorLayerFeatureSource::QgsVectorLayerFeatureSource( const QgsVectorLayer *layer )
 {
   QMutexLocker locker( &layer->mFeatureSourceConstructorMutex );
@@ -84,6 +91,14 @@ QgsVectorLayerFeatureSource::QgsVectorLayerFeatureSource( const QgsVectorLayer *
 
   std::unique_ptr< QgsExpressionContextScope > layerScope( QgsExpressionContextUtils::layerScope( layer ) );
   mLayerScope = *layerScope;
+
+  mSimplifiedGeometryCache = layer->mSimplifiedGeometryCache;
+
+  if ( mExpressionFieldBuffer->valueCachingEnabled() && !mExpressionFieldBuffer->expressions().isEmpty() )
+  {
+    mExpressionFieldValueCache = layer->mExpressionFieldValueCache;
+    mExpressionFieldValueCacheGeneration = mExpressionFieldValueCache->generation();
+  }
 }
 
 QgsVectorLayerFeatureSource::~QgsVectorLayerFeatureSource()
@@ -285,6 +300,22 @@ QgsVectorLayerFeatureIterator::QgsVectorLayerFeatureIterator( QgsVectorLayerFeat
     }
   }
 
+  // the geometries simplified beforehand replace the ones of the provider
+  if ( canUseSimplifiedGeometries() )
+  {
+    const int level = QgsSimplifiedGeometryCache::levelForTolerance( mRequest.simplifyMethod().tolerance() );
+    if ( mSource->mSimplifiedGeometryCache->geometries( level, mSimplifiedGeometries ) )
+    {
+      mUseSimplifiedGeometries = true;
+      mProviderRequest.setFlags( mProviderRequest.flags() | QgsFeatureRequest::NoGeometry );
+      mProviderRequest.setSimplifyMethod( QgsSimplifyMethod() );
+    }
+    else
+    {
+      mSource->mSimplifiedGeometryCache->requestLevel( level, mFilterRect );
+    }
+  }
+
   if ( request.filterType() == QgsFeatureRequest::FilterFid )
   {
     mFetchedFid = false;
@@ -439,7 +470,7 @@ bool QgsVectorLayerFeatureIterator::fetchFeature( QgsFeature &f )
     mProviderIterator.setInterruptionChecker( mInterruptionChecker );
   }
 
-  while ( mProviderIterator.nextFeature( f ) )
+  while ( nextProviderFeature( f ) )
   {
     if ( mFetchConsidered.contains( f.id() ) )
       continue;
@@ -447,6 +478,9 @@ bool QgsVectorLayerFeatureIterator::fetchFeature( QgsFeature &f )
     // TODO[MD]: just one resize of attributes
     f.setFields( mSource->mFields );
 
+    if ( mUseSimplifiedGeometries )
+      f.setGeometry( mSimplifiedGeometries.value( f.id() ) );
+
     // update attributes
     if ( mSource->mHasEditBuffer )
       updateChangedAttributes( f );
@@ -481,6 +515,27 @@ bool QgsVectorLayerFeatureIterator::fetchFeature( QgsFeature &f )
   return false;
 }
 
+bool QgsVectorLayerFeatureIterator::fetchBatch( QgsFeatureBatch &batch, int maxFeatures )
+{
+  if ( mClosed || mSource->mHasEditBuffer || mHasVirtualAttributes || mUseSimplifiedGeometries ||
+       mRequest.filterType() != QgsFeatureRequest::FilterNone ||
+       mRequest.invalidGeometryCheck() != QgsFeatureRequest::GeometryNoCheck ||
+       mTransform.isValid() )
+    return false;
+
+  if ( mProviderIterator.isClosed() )
+  {
+    mChangedFeaturesIterator.close();
+    mProviderIterator = mSource->mProviderFeatureSource->getFeatures( mProviderRequest );
+    mProviderIterator.setInterruptionChecker( mInterruptionChecker );
+  }
+
+  // the provider iterator must not be restarted once exhausted
+  if ( mProviderIterator.nextBatch( batch, maxFeatures ) == 0 || mProviderIterator.isClosed() )
+    close();
+
+  return true;
+}
 
 
 bool QgsVectorLayerFeatureIterator::rewind()
@@ -496,6 +551,8 @@ bool QgsVectorLayerFeatureIterator::rewind()
   {
     mProviderIterator.rewind();
     rewindEditBuffer();
+    mReadAheadFeatures.clear();
+    mReadAheadSize = 1;
   }
 
   return true;
@@ -507,6 +564,7 @@ bool QgsVectorLayerFeatureIterator::close()
     return false;
 
   mProviderIterator.close();
+  mReadAheadFeatures.clear();
 
   iteratorClosed();
 
@@ -704,6 +762,8 @@ void QgsVectorLayerFeatureIterator::prepareJoin( int fieldIdx )
     info.indexOffset = mSource->mJoinBuffer->joinedFieldsOffset( joinInfo, mSource->mFields );
     info.targetField = mSource->mFields.indexFromName( joinInfo->targetFieldName() );
     info.joinField = joinLayer->fields().indexFromName( joinInfo->joinFieldName() );
+    if ( joinInfo->hasSubset() )
+      info.subsetIndices = QgsVectorLayerJoinBuffer::joinSubsetIndices( joinLayer, QgsVectorLayerJoinInfo::joinFieldNamesSubset( *joinInfo ) );
 
     // for joined fields, we always need to request the targetField from the provider too
     if ( !mPreparedFields.contains( info.targetField ) && !mFieldsToPrepare.contains( info.targetField ) )
@@ -772,6 +832,19 @@ void QgsVectorLayerFeatureIterator::prepareExpression( int fieldIdx )
     mRequest.setFlags( mRequest.flags() & ~QgsFeatureRequest::NoGeometry );
   }
 
+  // the values computed from simplified geometries or from joined fields, which change with the joined layers, are not cached
+  if ( mSource->mExpressionFieldValueCache && QgsExpressionFieldValueCache::isCacheable( *exp )
+       && ( !exp->needsGeometry() || mRequest.simplifyMethod().methodType() == QgsSimplifyMethod::NoSimplification ) )
+  {
+    bool referencesJoin = false;
+    const QgsAttributeList inputs = exp->referencedColumns().contains( QgsFeatureRequest::ALL_ATTRIBUTES )
+                                    ? mSource->mFields.allAttributesList() : qgis::setToList( referencedColumns );
+    for ( int dependentFieldIdx : inputs )
+      referencesJoin |= mSource->mFields.fieldOrigin( dependentFieldIdx ) == QgsFields::OriginJoin;
+    if ( !referencesJoin )
+      mCachedExpressionFields << fieldIdx;
+  }
+
   mExpressionFieldInfo.insert( fieldIdx, exp.release() );
 }
 
@@ -801,6 +874,14 @@ void QgsVectorLayerFeatureIterator::prepareFields()
   {
     createOrderedJoinList();
   }
+
+  // joins without memory cache driven by a provider field can look up the joined features of batches of features
+  mHasBatchedJoins = false;
+  for ( const FetchJoinInfo &info : qgis::as_const( mOrderedJoinInfoList ) )
+  {
+    if ( info.joinInfo->cachedAttributes.isEmpty() && mSource->mFields.fieldOrigin( info.targetField ) == QgsFields::OriginProvider )
+      mHasBatchedJoins = true;
+  }
 }
 
 void QgsVectorLayerFeatureIterator::createOrderedJoinList()
@@ -931,6 +1012,60 @@ void QgsVectorLayerFeatureIterator::prepareField( int fieldIdx )
   }
 }
 
+bool QgsVectorLayerFeatureIterator::nextProviderFeature( QgsFeature &f )
+{
+  if ( mReadAheadFeatures.isEmpty() && mHasBatchedJoins )
+  {
+    QgsFeature feature;
+    while ( mReadAheadFeatures.count() < mReadAheadSize && mProviderIterator.nextFeature( feature ) )
+      mReadAheadFeatures.enqueue( feature );
+
+    // start with small batches, in case only a few features are fetched
+    mReadAheadSize = std::min( mReadAheadSize * 2, MAX_JOIN_BATCH_SIZE );
+
+    for ( FetchJoinInfo &info : mOrderedJoinInfoList )
+    {
+      info.prefetchedAttributes.clear();
+      info.hasPrefetchedNull = false;
+      info.prefetchedNullAttributes.clear();
+      if ( !info.joinInfo->cachedAttributes.isEmpty() || mSource->mFields.fieldOrigin( info.targetField ) != QgsFields::OriginProvider )
+        continue;
+
+      // the values of the edited features are looked up directly if they are not in the batch
+      const int providerIndex = mSource->mFields.fieldOriginIndex( info.targetField );
+      QSet<QString> keys;
+      QList<QVariant> joinValues;
+      bool lookupNull = false;
+      for ( const QgsFeature &readAheadFeature : qgis::as_const( mReadAheadFeatures ) )
+      {
+        const QVariant value = readAheadFeature.attribute( providerIndex );
+        if ( !value.isValid() )
+          continue;
+
+        if ( value.isNull() )
+        {
+          lookupNull = true;
+          continue;
+        }
+
+        if ( keys.contains( value.toString() ) )
+          continue;
+
+        keys.insert( value.toString() );
+        joinValues << value;
+      }
+      info.prefetchJoinedAttributes( joinValues, lookupNull );
+    }
+  }
+
+  if ( !mReadAheadFeatures.isEmpty() )
+  {
+    f = mReadAheadFeatures.dequeue();
+    return true;
+  }
+  return mProviderIterator.nextFeature( f );
+}
+
 void QgsVectorLayerFeatureIterator::addJoinedAttributes( QgsFeature &f )
 {
   QList< FetchJoinInfo >::const_iterator joinIt = mOrderedJoinInfoList.constBegin();
@@ -942,7 +1077,22 @@ void QgsVectorLayerFeatureIterator::addJoinedAttributes( QgsFeature &f )
 
     const QHash< QString, QgsAttributes> &memoryCache = joinIt->joinInfo->cachedAttributes;
     if ( memoryCache.isEmpty() )
-      joinIt->addJoinedAttributesDirect( f, targetFieldValue );
+    {
+      if ( targetFieldValue.isNull() )
+      {
+        if ( !joinIt->hasPrefetchedNull )
+          joinIt->addJoinedAttributesDirect( f, targetFieldValue );
+        else if ( !joinIt->prefetchedNullAttributes.isEmpty() )
+          joinIt->setJoinedAttributes( f, joinIt->prefetchedNullAttributes );
+        continue;
+      }
+
+      QHash<QString, QgsAttributes>::const_iterator prefetchedIt = joinIt->prefetchedAttributes.constFind( targetFieldValue.toString() );
+      if ( prefetchedIt == joinIt->prefetchedAttributes.constEnd() )
+        joinIt->addJoinedAttributesDirect( f, targetFieldValue );
+      else if ( !prefetchedIt.value().isEmpty() )
+        joinIt->setJoinedAttributes( f, prefetchedIt.value() );
+    }
     else
       joinIt->addJoinedAttributesCached( f, targetFieldValue );
   }
@@ -993,13 +1143,24 @@ void QgsVectorLayerFeatureIterator::addExpressionAttribute( QgsFeature &f, int a
   QgsExpression *exp = mExpressionFieldInfo.value( attrIndex );
   if ( exp )
   {
+    const bool cached = mCachedExpressionFields.contains( attrIndex );
+    QVariant val;
+    if ( cached && mSource->mExpressionFieldValueCache->value( attrIndex, f.id(), mSource->mExpressionFieldValueCacheGeneration, val ) )
+    {
+      f.setAttribute( attrIndex, val );
+      return;
+    }
+
     if ( !mExpressionContext )
       createExpressionContext();
 
     mExpressionContext->setFeature( f );
-    QVariant val = exp->evaluate( mExpressionContext.get() );
+    val = exp->evaluate( mExpressionContext.get() );
     ( void )mSource->mFields.at( attrIndex ).convertCompatible( val );
     f.setAttribute( attrIndex, val );
+
+    if ( cached )
+      mSource->mExpressionFieldValueCache->insert( attrIndex, f.id(), mSource->mExpressionFieldValueCacheGeneration, val );
   }
   else
   {
@@ -1013,6 +1174,35 @@ bool QgsVectorLayerFeatureIterator::prepareSimplification( const QgsSimplifyMeth
   return false;
 }
 
+bool QgsVectorLayerFeatureIterator::canUseSimplifiedGeometries() const
+{
+  if ( !mSource->mSimplifiedGeometryCache || mSource->mHasEditBuffer || mHasVirtualAttributes )
+    return false;
+
+  const QgsSimplifyMethod &simplifyMethod = mRequest.simplifyMethod();
+  if ( simplifyMethod.methodType() != QgsSimplifyMethod::OptimizeForRendering || simplifyMethod.tolerance() <= 0 )
+    return false;
+
+  // the exact geometries are needed
+  if ( mRequest.flags() & ( QgsFeatureRequest::NoGeometry | QgsFeatureRequest::ExactIntersect ) )
+    return false;
+
+  if ( mRequest.filterType() == QgsFeatureRequest::FilterFid || mRequest.filterType() == QgsFeatureRequest::FilterFids )
+    return false;
+
+  if ( mRequest.filterType() == QgsFeatureRequest::FilterExpression && mRequest.filterExpression()->needsGeometry() )
+    return false;
+
+  const QgsFeatureRequest::OrderBy orderBy = mRequest.orderBy();
+  for ( const QgsFeatureRequest::OrderByClause &clause : orderBy )
+  {
+    if ( clause.expression().needsGeometry() )
+      return false;
+  }
+
+  return true;
+}
+
 bool QgsVectorLayerFeatureIterator::providerCanSimplify( QgsSimplifyMethod::MethodType methodType ) const
 {
   Q_UNUSED( methodType )
@@ -1076,15 +1266,6 @@ void QgsVectorLayerFeatureIterator::FetchJoinInfo::addJoinedAttributesDirect( Qg
     subsetString += '=' + v;
   }
 
-  // maybe user requested just a subset of layer's attributes
-  // so we do not have to cache everything
-  QVector<int> subsetIndices;
-  if ( joinInfo->hasSubset() )
-  {
-    const QStringList subsetNames = QgsVectorLayerJoinInfo::joinFieldNamesSubset( *joinInfo );
-    subsetIndices = QgsVectorLayerJoinBuffer::joinSubsetIndices( joinLayer, subsetNames );
-  }
-
   // select (no geometry)
   QgsFeatureRequest request;
   request.setFlags( QgsFeatureRequest::NoGeometry );
@@ -1097,28 +1278,102 @@ void QgsVectorLayerFeatureIterator::FetchJoinInfo::addJoinedAttributesDirect( Qg
   QgsFeature fet;
   if ( fi.nextFeature( fet ) )
   {
-    int index = indexOffset;
-    QgsAttributes attr = fet.attributes();
-    if ( joinInfo->hasSubset() )
+    setJoinedAttributes( f, fet.attributes() );
+  }
+  else
+  {
+    // no suitable join feature found, keeping empty (null) attributes
+  }
+}
+
+static bool isIntegerType( QVariant::Type type )
+{
+  return type == QVariant::Int || type == QVariant::UInt || type == QVariant::LongLong || type == QVariant::ULongLong;
+}
+
+void QgsVectorLayerFeatureIterator::FetchJoinInfo::prefetchJoinedAttributes( const QList<QVariant> &joinValues, bool lookupNull )
+{
+  if ( joinLayer && !joinLayer->hasFeatures() )
+    return;
+
+  // the join field is needed to match the joined features with the features
+  QgsAttributeList requestAttributes = attributes;
+  if ( !requestAttributes.contains( joinField ) )
+    requestAttributes << joinField;
+
+  if ( lookupNull )
+  {
+    QgsFeatureRequest request;
+    request.setFlags( QgsFeatureRequest::NoGeometry );
+    request.setSubsetOfAttributes( requestAttributes );
+    request.setFilterExpression( QStringLiteral( "%1 IS NULL" ).arg( QgsExpression::quotedColumnRef( joinInfo->joinFieldName() ) ) );
+    request.setLimit( 1 );
+    QgsFeatureIterator fi = joinLayer->getFeatures( request );
+    if ( fi.isValid() )
     {
-      for ( int i = 0; i < subsetIndices.count(); ++i )
-        f.setAttribute( index++, attr.at( subsetIndices.at( i ) ) );
+      QgsFeature fet;
+      if ( fi.nextFeature( fet ) )
+        prefetchedNullAttributes = fet.attributes();
+      hasPrefetchedNull = true;
     }
-    else
-    {
-      // use all fields except for the one used for join (has same value as exiting field in target layer)
-      for ( int i = 0; i < attr.count(); ++i )
-      {
-        if ( i == joinField )
-          continue;
+  }
 
-        f.setAttribute( index++, attr.at( i ) );
-      }
+  if ( joinValues.isEmpty() )
+    return;
+
+  // a single IN filter, which the providers able to compile expressions run as a single query
+  QStringList quotedValues;
+  quotedValues.reserve( joinValues.count() );
+  for ( const QVariant &value : joinValues )
+    quotedValues << QgsExpression::quotedValue( value );
+
+  QgsFeatureRequest request;
+  request.setFlags( QgsFeatureRequest::NoGeometry );
+  request.setSubsetOfAttributes( requestAttributes );
+  request.setFilterExpression( QStringLiteral( "%1 IN (%2)" ).arg( QgsExpression::quotedColumnRef( joinInfo->joinFieldName() ), quotedValues.join( ',' ) ) );
+  QgsFeatureIterator fi = joinLayer->getFeatures( request );
+  if ( !fi.isValid() )
+    return;  // the features will be looked up one by one
+
+  QgsFeature fet;
+  while ( fi.nextFeature( fet ) )
+  {
+    // like with a direct request, only the first joined feature is used
+    const QString key = fet.attribute( joinField ).toString();
+    if ( !prefetchedAttributes.contains( key ) )
+      prefetchedAttributes.insert( key, fet.attributes() );
+  }
+
+  // integer values are matched exactly by their string value, so the ones not found have no joined feature.
+  // Other values are looked up directly, as the filter may match values of another type or case
+  if ( isIntegerType( joinLayer->fields().at( joinField ).type() ) )
+  {
+    for ( const QVariant &value : joinValues )
+    {
+      if ( isIntegerType( value.type() ) && !prefetchedAttributes.contains( value.toString() ) )
+        prefetchedAttributes.insert( value.toString(), QgsAttributes() );
     }
   }
+}
+
+void QgsVectorLayerFeatureIterator::FetchJoinInfo::setJoinedAttributes( QgsFeature &f, const QgsAttributes &joinedFeatureAttributes ) const
+{
+  int index = indexOffset;
+  if ( joinInfo->hasSubset() )
+  {
+    for ( int i = 0; i < subsetIndices.count(); ++i )
+      f.setAttribute( index++, joinedFeatureAttributes.at( subsetIndices.at( i ) ) );
+  }
   else
   {
-    // no suitable join feature found, keeping empty (null) attributes
+    // use all fields except for the one used for join (has same value as exiting field in target layer)
+    for ( int i = 0; i < joinedFeatureAttributes.count(); ++i )
+    {
+      if ( i == joinField )
+        continue;
+
+      f.setAttribute( index++, joinedFeatureAttributes.at( i ) );
+    }
   }
 }
 
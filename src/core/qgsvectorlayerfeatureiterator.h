@@ -24,12 +24,15 @@
 #include "qgsexpressioncontextscopegenerator.h"
 
 #include <QPointer>
+#include <QQueue>
 #include <QSet>
 #include <memory>
 
 typedef QMap<QgsFeatureId, QgsFeature> QgsFeatureMap SIP_SKIP;
 
 class QgsExpressionFieldBuffer;
+class QgsExpressionFieldValueCache;
+class QgsSimplifiedGeometryCache;
 class QgsVectorLayer;
 class QgsVectorLayerEditBuffer;
 class QgsVectorLayerJoinBuffer;
@@ -112,6 +115,15 @@ class CORE_EXPORT QgsVectorLayerFeatureSource : public QgsAbstractFeatureSource
     QgsAttributeList mDeletedAttributeIds;
 
     QgsCoordinateReferenceSystem mCrs;
+
+    //! Simplified geometries of the layer, may be NULLPTR
+    std::shared_ptr< QgsSimplifiedGeometryCache > mSimplifiedGeometryCache SIP_SKIP;
+
+    //! Cached values of the expression fields, NULLPTR if their values are not cached
+    std::shared_ptr< QgsExpressionFieldValueCache > mExpressionFieldValueCache SIP_SKIP;
+
+    //! Generation of the expression field value cache when the source was created
+    int mExpressionFieldValueCacheGeneration SIP_SKIP = 0;
 };
 
 /**
@@ -145,8 +157,48 @@ class CORE_EXPORT QgsVectorLayerFeatureIterator : public QgsAbstractFeatureItera
       int targetField;                  //!< Index of field (of this layer) that drives the join
       int joinField;                    //!< Index of field (of the joined layer) must have equal value
 
+      /**
+       * Indexes of the subset of the joined layer fields, if the join has a subset.
+       * \note not available in Python bindings
+       * \since QGIS 3.16
+       */
+      QVector<int> subsetIndices SIP_SKIP;
+
+      /**
+       * Attributes of the joined features looked up at once for a batch of features, by joined value.
+       * Empty attributes mean that no joined feature has the value.
+       * \note not available in Python bindings
+       * \since QGIS 3.16
+       */
+      QHash<QString, QgsAttributes> prefetchedAttributes SIP_SKIP;
+
+      /**
+       * TRUE if the joined feature of the NULL value was looked up for the current batch of features,
+       * its attributes are then in prefetchedNullAttributes (empty if there is none).
+       * \note not available in Python bindings
+       * \since QGIS 3.16
+       */
+      bool hasPrefetchedNull SIP_SKIP = false;
+      QgsAttributes prefetchedNullAttributes SIP_SKIP;
+
       void addJoinedAttributesCached( QgsFeature &f, const QVariant &joinValue ) const;
       void addJoinedAttributesDirect( QgsFeature &f, const QVariant &joinValue ) const;
+
+      /**
+       * Looks up the joined features of all the distinct non NULL \a joinValues with a single request,
+       * and stores their attributes in prefetchedAttributes. The joined feature of the NULL value
+       * is looked up too if \a lookupNull is TRUE.
+       * \note not available in Python bindings
+       * \since QGIS 3.16
+       */
+      void prefetchJoinedAttributes( const QList<QVariant> &joinValues, bool lookupNull ) SIP_SKIP;
+
+      /**
+       * Sets the attributes of the \a joinedFeatureAttributes taking part in the join on the feature \a f.
+       * \note not available in Python bindings
+       * \since QGIS 3.16
+       */
+      void setJoinedAttributes( QgsFeature &f, const QgsAttributes &joinedFeatureAttributes ) const SIP_SKIP;
     };
 
 
@@ -156,6 +208,15 @@ class CORE_EXPORT QgsVectorLayerFeatureIterator : public QgsAbstractFeatureItera
     //! fetch next feature, return TRUE on success
     bool fetchFeature( QgsFeature &feature ) override;
 
+    /**
+     * Forwards the batch request to the provider iterator when the provider
+     * features do not need any change (no edit buffer, no joined or virtual
+     * fields, no geometry check nor transformation).
+     * \note not available in Python bindings
+     * \since QGIS 3.16
+     */
+    bool fetchBatch( QgsFeatureBatch &batch, int maxFeatures ) override SIP_SKIP;
+
     /**
      * Overrides default method as we only need to filter features in the edit buffer
      * while for others filtering is left to the provider implementation.
@@ -254,6 +315,23 @@ class CORE_EXPORT QgsVectorLayerFeatureIterator : public QgsAbstractFeatureItera
     bool mHasVirtualAttributes;
 
   private:
+
+    /**
+     * Returns TRUE if the geometries can be taken from the simplified geometry
+     * cache of the layer: they are only used for rendering with the provider
+     * request simplification method.
+     */
+    bool canUseSimplifiedGeometries() const;
+
+    //! TRUE if the provider features are fetched without geometries, which are taken from mSimplifiedGeometries
+    bool mUseSimplifiedGeometries = false;
+
+    //! Cached simplified geometries, by feature id
+    QHash<QgsFeatureId, QgsGeometry> mSimplifiedGeometries;
+
+    //! Indexes of the expression fields whose values are read from and stored in the expression field value cache
+    QSet<int> mCachedExpressionFields;
+
 #ifdef SIP_RUN
     QgsVectorLayerFeatureIterator( const QgsVectorLayerFeatureIterator &rhs );
 #endif
@@ -269,6 +347,20 @@ class CORE_EXPORT QgsVectorLayerFeatureIterator : public QgsAbstractFeatureItera
     //! Join list sorted by dependency
     QList< FetchJoinInfo > mOrderedJoinInfoList;
 
+    /**
+     * Returns the next feature of the provider iterator. If some joins query the joined layer directly,
+     * the provider features are read ahead by batches, so that each join looks up the joined features of
+     * a whole batch with a single request, instead of one request per feature.
+     */
+    bool nextProviderFeature( QgsFeature &f );
+
+    //! TRUE if at least one join queries the joined layer directly and can look up batches of features
+    bool mHasBatchedJoins = false;
+    //! Provider features read ahead, whose joined features have been looked up
+    QQueue<QgsFeature> mReadAheadFeatures;
+    //! Number of provider features read ahead in the next batch
+    int mReadAheadSize = 1;
+
     /**
      * Will always return TRUE. We assume that ordering has been done on provider level already.
      *
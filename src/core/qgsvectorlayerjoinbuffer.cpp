@@ -159,21 +159,7 @@ void QgsVectorLayerJoinBuffer::cacheJoinLayer( QgsVectorLayerJoinInfo &joinInfo
     QgsFeature f;
     while ( fit.nextFeature( f ) )
     {
-      QgsAttributes attrs = f.attributes();
-      QString key = attrs.at( joinFieldIndex ).toString();
-      if ( joinInfo.hasSubset() )
-      {
-        QgsAttributes subsetAttrs( subsetIndices.count() );
-        for ( int i = 0; i < subsetIndices.count(); ++i )
-          subsetAttrs[i] = attrs.at( subsetIndices.at( i ) );
-        joinInfo.cachedAttributes.insert( key, subsetAttrs );
-      }
-      else
-      {
-        QgsAttributes attrs2 = attrs;
-        attrs2.remove( joinFieldIndex );  // skip the join field to avoid double field names (fields often have the same name)
-        joinInfo.cachedAttributes.insert( key, attrs2 );
-      }
+      cacheJoinedFeature( joinInfo, f, joinFieldIndex, subsetIndices );
     }
     joinInfo.cacheDirty = false;
   }
@@ -201,6 +187,25 @@ QVector<int> QgsVectorLayerJoinBuffer::joinSubsetIndices( QgsVectorLayer *joinLa
   return subsetIndices;
 }
 
+void QgsVectorLayerJoinBuffer::cacheJoinedFeature( QgsVectorLayerJoinInfo &joinInfo, const QgsFeature &feature, int joinFieldIndex, const QVector<int> &subsetIndices )
+{
+  const QgsAttributes attrs = feature.attributes();
+  QString key = attrs.at( joinFieldIndex ).toString();
+  if ( joinInfo.hasSubset() )
+  {
+    QgsAttributes subsetAttrs( subsetIndices.count() );
+    for ( int i = 0; i < subsetIndices.count(); ++i )
+      subsetAttrs[i] = attrs.at( subsetIndices.at( i ) );
+    joinInfo.cachedAttributes.insert( key, subsetAttrs );
+  }
+  else
+  {
+    QgsAttributes attrs2 = attrs;
+    attrs2.remove( joinFieldIndex );  // skip the join field to avoid double field names (fields often have the same name)
+    joinInfo.cachedAttributes.insert( key, attrs2 );
+  }
+}
+
 void QgsVectorLayerJoinBuffer::updateFields( QgsFields &fields )
 {
   QString prefix;
@@ -503,6 +508,10 @@ void QgsVectorLayerJoinBuffer::joinedLayerModified()
   QgsVectorLayer *joinedLayer = qobject_cast<QgsVectorLayer *>( sender() );
   Q_ASSERT( joinedLayer );
 
+  // the memory caches were already updated feature by feature
+  if ( mUpdatedJoinedLayers.remove( joinedLayer ) )
+    return;
+
   // recache the joined layer
   for ( QgsVectorJoinList::iterator it = mVectorJoins.begin(); it != mVectorJoins.end(); ++it )
   {
@@ -513,11 +522,90 @@ void QgsVectorLayerJoinBuffer::joinedLayerModified()
   }
 }
 
+void QgsVectorLayerJoinBuffer::joinedLayerAttributeValueChanged( QgsFeatureId fid, int idx )
+{
+  QgsVectorLayer *joinedLayer = qobject_cast<QgsVectorLayer *>( sender() );
+  Q_ASSERT( joinedLayer );
+
+  updateCachedJoinedFeature( joinedLayer, fid, idx );
+}
+
+void QgsVectorLayerJoinBuffer::joinedLayerFeatureAdded( QgsFeatureId fid )
+{
+  QgsVectorLayer *joinedLayer = qobject_cast<QgsVectorLayer *>( sender() );
+  Q_ASSERT( joinedLayer );
+
+  updateCachedJoinedFeature( joinedLayer, fid, -1 );
+}
+
+void QgsVectorLayerJoinBuffer::joinedLayerFeatureDeleted()
+{
+  QgsVectorLayer *joinedLayer = qobject_cast<QgsVectorLayer *>( sender() );
+  Q_ASSERT( joinedLayer );
+
+  // the join value of a deleted feature is not known anymore, recache the joined layer
+  QMutexLocker locker( &mMutex );
+  for ( QgsVectorJoinList::iterator it = mVectorJoins.begin(); it != mVectorJoins.end(); ++it )
+  {
+    if ( joinedLayer == it->joinLayer() )
+    {
+      it->cacheDirty = true;
+    }
+  }
+}
+
+void QgsVectorLayerJoinBuffer::joinedLayerGeometryChanged()
+{
+  QgsVectorLayer *joinedLayer = qobject_cast<QgsVectorLayer *>( sender() );
+  Q_ASSERT( joinedLayer );
+
+  // geometries are not cached
+  mUpdatedJoinedLayers.insert( joinedLayer );
+}
+
+void QgsVectorLayerJoinBuffer::updateCachedJoinedFeature( QgsVectorLayer *joinedLayer, QgsFeatureId fid, int changedField )
+{
+  QMutexLocker locker( &mMutex );
+  QgsFeature feature;
+  bool fetched = false;
+  for ( QgsVectorJoinList::iterator it = mVectorJoins.begin(); it != mVectorJoins.end(); ++it )
+  {
+    if ( joinedLayer != it->joinLayer() || !it->isUsingMemoryCache() || it->cacheDirty )
+      continue;
+
+    const int joinFieldIndex = joinedLayer->fields().indexFromName( it->joinFieldName() );
+    if ( joinFieldIndex < 0 || joinFieldIndex == changedField )
+    {
+      // the join value changed, the previous one is not known anymore
+      it->cacheDirty = true;
+      continue;
+    }
+
+    if ( !fetched )
+    {
+      joinedLayer->getFeatures( QgsFeatureRequest( fid ).setFlags( QgsFeatureRequest::NoGeometry ) ).nextFeature( feature );
+      fetched = true;
+    }
+    if ( !feature.isValid() )
+    {
+      it->cacheDirty = true;
+      continue;
+    }
+
+    QVector<int> subsetIndices;
+    if ( it->hasSubset() )
+      subsetIndices = joinSubsetIndices( joinedLayer, QgsVectorLayerJoinInfo::joinFieldNamesSubset( *it ) );
+    cacheJoinedFeature( *it, feature, joinFieldIndex, subsetIndices );
+  }
+  mUpdatedJoinedLayers.insert( joinedLayer );
+}
+
 void QgsVectorLayerJoinBuffer::joinedLayerWillBeDeleted()
 {
   QgsVectorLayer *joinedLayer = qobject_cast<QgsVectorLayer *>( sender() );
   Q_ASSERT( joinedLayer );
 
+  mUpdatedJoinedLayers.remove( joinedLayer );
   removeJoin( joinedLayer->id() );
 }
 
@@ -525,6 +613,10 @@ void QgsVectorLayerJoinBuffer::connectJoinedLayer( QgsVectorLayer *vl )
 {
   connect( vl, &QgsVectorLayer::updatedFields, this, &QgsVectorLayerJoinBuffer::joinedLayerUpdatedFields, Qt::UniqueConnection );
   connect( vl, &QgsVectorLayer::layerModified, this, &QgsVectorLayerJoinBuffer::joinedLayerModified, Qt::UniqueConnection );
+  connect( vl, &QgsVectorLayer::attributeValueChanged, this, &QgsVectorLayerJoinBuffer::joinedLayerAttributeValueChanged, Qt::UniqueConnection );
+  connect( vl, &QgsVectorLayer::featureAdded, this, &QgsVectorLayerJoinBuffer::joinedLayerFeatureAdded, Qt::UniqueConnection );
+  connect( vl, &QgsVectorLayer::featureDeleted, this, &QgsVectorLayerJoinBuffer::joinedLayerFeatureDeleted, Qt::UniqueConnection );
+  connect( vl, &QgsVectorLayer::geometryChanged, this, &QgsVectorLayerJoinBuffer::joinedLayerGeometryChanged, Qt::UniqueConnection );
   connect( vl, &QgsVectorLayer::willBeDeleted, this, &QgsVectorLayerJoinBuffer::joinedLayerWillBeDeleted, Qt::UniqueConnection );
 }
 
@@ -645,18 +737,65 @@ bool QgsVectorLayerJoinBuffer::changeAttributeValue( QgsFeatureId fid, int field
 
 bool QgsVectorLayerJoinBuffer::changeAttributeValues( QgsFeatureId fid, const QgsAttributeMap &newValues, const QgsAttributeMap &oldValues )
 {
-  bool success = true;
+  // the values of a joined layer are changed with a single lookup of the joined feature and a single edit
+  struct JoinedValues
+  {
+    QgsAttributeMap newValues;
+    QgsAttributeMap oldValues;
+    QgsAttributeMap targetValues;
+  };
+  QList< const QgsVectorLayerJoinInfo * > joins;
+  QHash< const QgsVectorLayerJoinInfo *, JoinedValues > joinedValues;
 
+  bool success = true;
   for ( auto it = newValues.constBegin(); it != newValues.constEnd(); ++it )
   {
     const int field = it.key();
-    const QVariant newValue = it.value();
-    QVariant oldValue;
+    if ( mLayer->fields().fieldOrigin( field ) != QgsFields::OriginJoin )
+    {
+      success = false;
+      continue;
+    }
+
+    int srcFieldIndex;
+    const QgsVectorLayerJoinInfo *info = joinForFieldIndex( field, mLayer->fields(), srcFieldIndex );
+    if ( !info || !info->joinLayer() || !info->isEditable() )
+    {
+      success = false;
+      continue;
+    }
 
-    if ( oldValues.contains( field ) )
-      oldValue = oldValues[field];
+    if ( !joinedValues.contains( info ) )
+      joins << info;
+    JoinedValues &values = joinedValues[ info ];
+    values.newValues.insert( srcFieldIndex, it.value() );
+    values.oldValues.insert( srcFieldIndex, oldValues.value( field ) );
+    values.targetValues.insert( field, it.value() );
+  }
+
+  if ( joins.isEmpty() )
+    return success;
+
+  QgsFeature feature = mLayer->getFeature( fid );
+  if ( !feature.isValid() )
+    return false;
 
-    success &= changeAttributeValue( fid, field, newValue, oldValue );
+  for ( const QgsVectorLayerJoinInfo *info : qgis::as_const( joins ) )
+  {
+    const JoinedValues &values = joinedValues[ info ];
+    const QgsFeature joinFeature = joinedFeatureOf( info, feature );
+
+    if ( joinFeature.isValid() )
+      success &= info->joinLayer()->changeAttributeValues( joinFeature.id(), values.newValues, values.oldValues );
+    else
+    {
+      QgsFeature targetFeature( feature );
+      for ( auto it = values.targetValues.constBegin(); it != values.targetValues.constEnd(); ++it )
+        targetFeature.setAttribute( it.key(), it.value() );
+      QgsFeatureList features;
+      features << targetFeature;
+      success &= addFeatures( features );
+    }
   }
 
   return success;
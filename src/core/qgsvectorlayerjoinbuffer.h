@@ -24,6 +24,7 @@
 #include "qgsfeaturesink.h"
 
 #include <QHash>
+#include <QSet>
 #include <QString>
 
 
@@ -232,11 +233,25 @@ class CORE_EXPORT QgsVectorLayerJoinBuffer : public QObject, public QgsFeatureSi
 
     void joinedLayerModified();
 
+    void joinedLayerAttributeValueChanged( QgsFeatureId fid, int idx );
+
+    void joinedLayerFeatureAdded( QgsFeatureId fid );
+
+    void joinedLayerFeatureDeleted();
+
+    void joinedLayerGeometryChanged();
+
     void joinedLayerWillBeDeleted();
 
   private:
     void connectJoinedLayer( QgsVectorLayer *vl );
 
+    /**
+     * Updates the memory caches of the joins of \a joinedLayer with the feature \a fid of \a joinedLayer,
+     * after a change of its field \a changedField, or of all its fields if \a changedField is -1.
+     */
+    void updateCachedJoinedFeature( QgsVectorLayer *joinedLayer, QgsFeatureId fid, int changedField );
+
   private:
 
     QgsVectorLayer *mLayer = nullptr;
@@ -247,6 +262,12 @@ class CORE_EXPORT QgsVectorLayerJoinBuffer : public QObject, public QgsFeatureSi
     //! Caches attributes of join layer in memory if QgsVectorJoinInfo.memoryCache is TRUE (and the cache is not already there)
     void cacheJoinLayer( QgsVectorLayerJoinInfo &joinInfo );
 
+    //! Inserts the attributes of \a feature of the joined layer in the memory cache of \a joinInfo
+    static void cacheJoinedFeature( QgsVectorLayerJoinInfo &joinInfo, const QgsFeature &feature, int joinFieldIndex, const QVector<int> &subsetIndices );
+
+    //! Joined layers whose memory caches are already updated for their pending modification
+    QSet< QgsVectorLayer * > mUpdatedJoinedLayers;
+
     //! Main mutex to protect most data members that can be modified concurrently
     QMutex mMutex;
 };
@@ -17,6 +17,7 @@
 
 #include "diagram/qgsdiagram.h"
 
+#include "qgsapproximatecoordinatetransform.h"
 #include "qgsdiagramrenderer.h"
 #include "qgsmessagelog.h"
 #include "qgspallabeling.h"
@@ -41,7 +42,54 @@
 #include "qgsvectorlayertemporalproperties.h"
 #include "qgsmapclippingutils.h"
 
+#include <QElapsedTimer>
+#include <QGuiApplication>
+#include <QOffscreenSurface>
 #include <QPicture>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+#ifndef QT_NO_OPENGL
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLPaintDevice>
+#endif
+
+///@cond PRIVATE
+
+//! Computes the symbol levels of a started \a renderer
+static QgsSymbolLevelOrder rendererSymbolLevels( QgsFeatureRenderer *renderer, QgsRenderContext &context )
+{
+  QgsSymbolLevelOrder levels;
+  QgsSymbolList symbols = renderer->symbols( context );
+  for ( int i = 0; i < symbols.count(); i++ )
+  {
+    QgsSymbol *sym = symbols[i];
+    for ( int j = 0; j < sym->symbolLayerCount(); j++ )
+    {
+      int level = sym->symbolLayer( j )->renderingPass();
+      if ( level < 0 || level >= 1000 ) // ignore invalid levels
+        continue;
+      QgsSymbolLevelItem item( sym, j );
+      while ( level >= levels.count() ) // append new empty levels
+        levels.append( QgsSymbolLevel() );
+      levels[level].append( item );
+    }
+  }
+  return levels;
+}
+
+//! Horizontal band of the destination image, drawn by a dedicated thread
+struct QgsVectorLayerRenderBand
+{
+  int top = 0;
+  int height = 0;
+  QVector<QgsFeature> features;
+  std::unique_ptr< QgsFeatureRenderer > renderer;
+  QImage image;
+};
+
+///@endcond
 
 
 QgsVectorLayerRenderer::QgsVectorLayerRenderer( QgsVectorLayer *layer, QgsRenderContext &context )
@@ -127,6 +175,16 @@ QgsVectorLayerRenderer::QgsVectorLayerRenderer( QgsVectorLayer *layer, QgsRender
   prepareDiagrams( layer, mAttrNames );
 
   mClippingRegions = QgsMapClippingUtils::collectClippingRegionsForLayer( context, layer );
+
+#ifndef QT_NO_OPENGL
+  // the surface must be created in the GUI thread, the OpenGL context is created in the rendering thread
+  if ( context.testFlag( QgsRenderContext::GpuRendering ) && qobject_cast< QGuiApplication * >( QCoreApplication::instance() )
+       && QThread::currentThread() == QCoreApplication::instance()->thread() )
+  {
+    mGpuSurface = qgis::make_unique< QOffscreenSurface >();
+    mGpuSurface->create();
+  }
+#endif
 }
 
 QgsVectorLayerRenderer::~QgsVectorLayerRenderer()
@@ -180,6 +238,18 @@ bool QgsVectorLayerRenderer::render()
     context.painter()->setCompositionMode( mFeatureBlendMode );
   }
 
+  // reprojected vertices are interpolated in a grid of the rendered extent, which also
+  // covers the margin kept by the clipping of the symbols
+  const QgsCoordinateTransform ct = context.coordinateTransform();
+  if ( context.testFlag( QgsRenderContext::ApproximateReprojection ) && ct.isValid() && !ct.isShortCircuited() )
+  {
+    const QgsRectangle &e = context.extent();
+    const QgsRectangle gridExtent( e.xMinimum() - e.width() / 10, e.yMinimum() - e.height() / 10,
+                                   e.xMaximum() + e.width() / 10, e.yMaximum() + e.height() / 10 );
+    context.setApproximateCoordinateTransform( QgsApproximateCoordinateTransform::cachedTransform( ct, gridExtent,
+        context.mapToPixel().mapUnitsPerPixel() * APPROXIMATE_TRANSFORM_TOLERANCE ) );
+  }
+
   mRenderer->startRender( context, mFields );
 
   QString rendererFilter = mRenderer->filter( mFields );
@@ -302,23 +372,66 @@ bool QgsVectorLayerRenderer::render()
     context.setVectorSimplifyMethod( vectorMethod );
   }
 
+  // slow layers first draw a quick preview, which stays visible until the full
+  // rendering, drawn aside, replaces it
+  QPainter *destinationPainter = context.painter();
+  QImage fullImage;
+  std::unique_ptr< QPainter > fullPainter;
+  if ( progressiveRenderingSupported() )
+  {
+    drawPreview( featureRequest );
+
+    const QImage *destinationImage = static_cast< QImage * >( destinationPainter->device() );
+    fullImage = QImage( destinationImage->size(), destinationImage->format() );
+    fullImage.fill( Qt::transparent );
+    fullPainter = qgis::make_unique< QPainter >( &fullImage );
+    fullPainter->setRenderHints( destinationPainter->renderHints() );
+    context.setPainter( fullPainter.get() );
+  }
+
+  mRecordStatistics = context.testFlag( QgsRenderContext::RecordRenderingStatistics );
+  if ( mRecordStatistics )
+  {
+    mStatisticsTimer.start();
+    mStatisticsStep = 0;
+  }
+
   QgsFeatureIterator fit = mSource->getFeatures( featureRequest );
+  recordStatisticsStep( mStatistics.fetchTime );
   // Attach an interruption checker so that iterators that have potentially
   // slow fetchFeature() implementations, such as in the WFS provider, can
   // check it, instead of relying on just the mContext.renderingStopped() check
   // in drawRenderer()
   fit.setInterruptionChecker( mInterruptionChecker.get() );
 
-  if ( ( mRenderer->capabilities() & QgsFeatureRenderer::SymbolLevels ) && mRenderer->usingSymbolLevels() )
-    drawRendererLevels( fit );
-  else
-    drawRenderer( fit );
+  if ( !gpuRenderingSupported() || !drawRendererGpu( fit ) )
+  {
+    const int threadCount = parallelRenderingThreadCount();
+    if ( threadCount > 1 )
+      drawRendererParallel( fit, threadCount );
+    else if ( ( mRenderer->capabilities() & QgsFeatureRenderer::SymbolLevels ) && mRenderer->usingSymbolLevels() )
+      drawRendererLevels( fit );
+    else
+      drawRenderer( fit );
+  }
 
   if ( !fit.isValid() )
   {
     mErrors.append( QStringLiteral( "Data source invalid" ) );
   }
 
+  if ( fullPainter )
+  {
+    fullPainter->end();
+    context.setPainter( destinationPainter );
+    if ( !context.renderingStopped() )
+    {
+      QgsScopedQPainterState destinationState( destinationPainter );
+      destinationPainter->setCompositionMode( QPainter::CompositionMode_Source );
+      destinationPainter->drawImage( 0, 0, fullImage );
+    }
+  }
+
   if ( usingEffect )
   {
     mRenderer->paintEffect()->end( context );
@@ -345,6 +458,8 @@ void QgsVectorLayerRenderer::drawRenderer( QgsFeatureIterator &fit )
   QgsFeature fet;
   while ( fit.nextFeature( fet ) )
   {
+    recordStatisticsStep( mStatistics.fetchTime );
+    mStatistics.featuresFetched++;
     try
     {
       if ( context.renderingStopped() )
@@ -369,10 +484,13 @@ void QgsVectorLayerRenderer::drawRenderer( QgsFeatureIterator &fit )
 
       // render feature
       bool rendered = mRenderer->renderFeature( fet, context, -1, sel, drawMarker );
+      recordStatisticsStep( mStatistics.symbolDrawingTime );
 
       // labeling - register feature
       if ( rendered )
       {
+        mStatistics.featuresDrawn++;
+
         // new labeling engine
         if ( context.labelingEngine() && ( mLabelProvider || mDiagramProvider ) )
         {
@@ -404,6 +522,7 @@ void QgsVectorLayerRenderer::drawRenderer( QgsFeatureIterator &fit )
 
           if ( mApplyLabelClipGeometries )
             context.setFeatureClipGeometry( QgsGeometry() );
+          recordStatisticsStep( mStatistics.labelingTime );
         }
       }
     }
@@ -452,6 +571,8 @@ void QgsVectorLayerRenderer::drawRendererLevels( QgsFeatureIterator &fit )
   QgsFeature fet;
   while ( fit.nextFeature( fet ) )
   {
+    recordStatisticsStep( mStatistics.fetchTime );
+    mStatistics.featuresFetched++;
     if ( context.renderingStopped() )
     {
       qDebug( "rendering stop!" );
@@ -467,6 +588,7 @@ void QgsVectorLayerRenderer::drawRendererLevels( QgsFeatureIterator &fit )
 
     context.expressionContext().setFeature( fet );
     QgsSymbol *sym = mRenderer->symbolForFeature( fet, context );
+    recordStatisticsStep( mStatistics.symbolDrawingTime );
     if ( !sym )
     {
       continue;
@@ -477,6 +599,7 @@ void QgsVectorLayerRenderer::drawRendererLevels( QgsFeatureIterator &fit )
       features.insert( sym, QList<QgsFeature>() );
     }
     features[sym].append( fet );
+    mStatistics.featuresDrawn++;
 
     // new labeling engine
     if ( context.labelingEngine() && ( mLabelProvider || mDiagramProvider ) )
@@ -503,6 +626,7 @@ void QgsVectorLayerRenderer::drawRendererLevels( QgsFeatureIterator &fit )
       {
         mDiagramProvider->registerFeature( fet, context, obstacleGeometry );
       }
+      recordStatisticsStep( mStatistics.labelingTime );
     }
   }
 
@@ -519,22 +643,7 @@ void QgsVectorLayerRenderer::drawRendererLevels( QgsFeatureIterator &fit )
   }
 
   // find out the order
-  QgsSymbolLevelOrder levels;
-  QgsSymbolList symbols = mRenderer->symbols( context );
-  for ( int i = 0; i < symbols.count(); i++ )
-  {
-    QgsSymbol *sym = symbols[i];
-    for ( int j = 0; j < sym->symbolLayerCount(); j++ )
-    {
-      int level = sym->symbolLayer( j )->renderingPass();
-      if ( level < 0 || level >= 1000 ) // ignore invalid levels
-        continue;
-      QgsSymbolLevelItem item( sym, j );
-      while ( level >= levels.count() ) // append new empty levels
-        levels.append( QgsSymbolLevel() );
-      levels[level].append( item );
-    }
-  }
+  QgsSymbolLevelOrder levels = rendererSymbolLevels( mRenderer, context );
 
   if ( mApplyClipGeometries )
     context.setFeatureClipGeometry( mClipFeatureGeom );
@@ -578,6 +687,7 @@ void QgsVectorLayerRenderer::drawRendererLevels( QgsFeatureIterator &fit )
           QgsDebugMsg( QStringLiteral( "Failed to transform a point while drawing a feature with ID '%1'. Ignoring this feature. %2" )
                        .arg( fet.id() ).arg( cse.what() ) );
         }
+        recordStatisticsStep( mStatistics.symbolDrawingTime );
       }
     }
   }
@@ -585,6 +695,493 @@ void QgsVectorLayerRenderer::drawRendererLevels( QgsFeatureIterator &fit )
   stopRenderer( selRenderer );
 }
 
+bool QgsVectorLayerRenderer::progressiveRenderingSupported()
+{
+  QgsRenderContext &context = *renderContext();
+  if ( !context.testFlag( QgsRenderContext::ProgressiveRendering ) )
+    return false;
+
+  // the full rendering is drawn aside and then copied over the preview
+  if ( mRenderer->paintEffect() && mRenderer->paintEffect()->enabled() )
+    return false;
+
+  if ( context.useAdvancedEffects() && mFeatureBlendMode != QPainter::CompositionMode_SourceOver )
+    return false;
+
+  if ( context.hasRenderedFeatureHandlers() || context.maskPainter( context.currentMaskId() ) )
+    return false;
+
+  QImage *image = context.painter() ? dynamic_cast< QImage * >( context.painter()->device() ) : nullptr;
+  return image && context.painter()->transform().isIdentity() && qgsDoubleNear( image->devicePixelRatioF(), 1.0 );
+}
+
+void QgsVectorLayerRenderer::drawPreview( const QgsFeatureRequest &featureRequest )
+{
+  QgsRenderContext &context = *renderContext();
+
+  QgsFeatureRequest previewRequest( featureRequest );
+  previewRequest.setOrderBy( QgsFeatureRequest::OrderBy() );
+
+  // coarser simplification, the tolerance of the full rendering is in the source crs
+  QgsSimplifyMethod simplifyMethod = featureRequest.simplifyMethod();
+  if ( simplifyMethod.methodType() == QgsSimplifyMethod::OptimizeForRendering )
+  {
+    simplifyMethod.setTolerance( simplifyMethod.tolerance() * PREVIEW_SIMPLIFY_FACTOR );
+    previewRequest.setSimplifyMethod( simplifyMethod );
+  }
+  else if ( !context.coordinateTransform().isValid() || context.coordinateTransform().isShortCircuited() )
+  {
+    simplifyMethod.setMethodType( QgsSimplifyMethod::OptimizeForRendering );
+    simplifyMethod.setTolerance( context.mapToPixel().mapUnitsPerPixel() * PREVIEW_SIMPLIFY_FACTOR );
+    previewRequest.setSimplifyMethod( simplifyMethod );
+  }
+
+  QgsFeatureIterator fit = mSource->getFeatures( previewRequest );
+  fit.setInterruptionChecker( mInterruptionChecker.get() );
+
+  QgsExpressionContextScope *symbolScope = QgsExpressionContextUtils::updateSymbolScope( nullptr, new QgsExpressionContextScope() );
+  context.expressionContext().appendScope( symbolScope );
+
+  std::unique_ptr< QgsGeometryEngine > clipEngine;
+  if ( mApplyClipFilter )
+  {
+    clipEngine.reset( QgsGeometry::createGeometryEngine( mClipFilterGeom.constGet() ) );
+    clipEngine->prepareGeometry();
+  }
+
+  QElapsedTimer timer;
+  timer.start();
+
+  // features are neither selected nor labeled in the preview
+  QgsFeature fet;
+  while ( timer.elapsed() < PREVIEW_TIME_BUDGET && !context.renderingStopped() && fit.nextFeature( fet ) )
+  {
+    try
+    {
+      if ( !fet.hasGeometry() || fet.geometry().isEmpty() )
+        continue;
+
+      if ( clipEngine && !clipEngine->intersects( fet.geometry().constGet() ) )
+        continue;
+
+      if ( mApplyClipGeometries )
+        context.setFeatureClipGeometry( mClipFeatureGeom );
+
+      context.expressionContext().setFeature( fet );
+      mRenderer->renderFeature( fet, context, -1, false, false );
+    }
+    catch ( const QgsCsException &cse )
+    {
+      Q_UNUSED( cse )
+      QgsDebugMsg( QStringLiteral( "Failed to transform a point while drawing the preview of feature with ID '%1'. Ignoring this feature. %2" )
+                   .arg( fet.id() ).arg( cse.what() ) );
+    }
+  }
+
+  delete context.expressionContext().popScope();
+  context.setFeatureClipGeometry( QgsGeometry() );
+}
+
+int QgsVectorLayerRenderer::parallelRenderingThreadCount()
+{
+  QgsRenderContext &context = *renderContext();
+  if ( !context.testFlag( QgsRenderContext::ParallelFeatureRendering ) )
+    return 1;
+
+  // only renderers drawing each feature on its own, as soon as it is received
+  static const QStringList sBandRenderers
+  {
+    QStringLiteral( "singleSymbol" ),
+    QStringLiteral( "categorizedSymbol" ),
+    QStringLiteral( "graduatedSymbol" ),
+    QStringLiteral( "RuleRenderer" )
+  };
+  if ( !sBandRenderers.contains( mRenderer->type() ) )
+    return 1;
+
+  // these are bound to the calling thread or to the renderer instance
+  if ( context.hasRenderedFeatureHandlers() || !context.disabledSymbolLayers().isEmpty() || context.maskPainter( context.currentMaskId() ) )
+    return 1;
+
+  if ( mRenderer->paintEffect() && mRenderer->paintEffect()->enabled() )
+    return 1;
+
+  if ( context.useAdvancedEffects() && mFeatureBlendMode != QPainter::CompositionMode_SourceOver )
+    return 1;
+
+  QImage *image = context.painter() ? dynamic_cast< QImage * >( context.painter()->device() ) : nullptr;
+  if ( !image || !context.painter()->transform().isIdentity() || !qgsDoubleNear( image->devicePixelRatioF(), 1.0 ) )
+    return 1;
+
+  // the area painted by each feature must be predictable from its bounding box
+  const QgsSymbolList symbols = mRenderer->symbols( context );
+  for ( QgsSymbol *symbol : symbols )
+  {
+    for ( int i = 0; i < symbol->symbolLayerCount(); ++i )
+    {
+      const QgsSymbolLayer *layer = symbol->symbolLayer( i );
+      if ( layer->layerType() == QLatin1String( "GeometryGenerator" ) || layer->dataDefinedProperties().hasActiveProperties() )
+        return 1;
+    }
+  }
+
+  // keep bands tall enough, features crossing a band limit are drawn by each band
+  return std::min( QThreadPool::globalInstance()->maxThreadCount(), image->height() / 64 );
+}
+
+bool QgsVectorLayerRenderer::gpuRenderingSupported()
+{
+  QgsRenderContext &context = *renderContext();
+  if ( !context.testFlag( QgsRenderContext::GpuRendering ) || !mGpuSurface )
+    return false;
+
+  // these are bound to the destination painter
+  if ( !context.disabledSymbolLayers().isEmpty() || context.maskPainter( context.currentMaskId() ) )
+    return false;
+
+  if ( mRenderer->paintEffect() && mRenderer->paintEffect()->enabled() )
+    return false;
+
+  if ( context.useAdvancedEffects() && mFeatureBlendMode != QPainter::CompositionMode_SourceOver )
+    return false;
+
+  QImage *image = context.painter() ? dynamic_cast< QImage * >( context.painter()->device() ) : nullptr;
+  if ( !image || !context.painter()->transform().isIdentity() || !qgsDoubleNear( image->devicePixelRatioF(), 1.0 ) )
+    return false;
+
+  // only symbol layers drawing plain polygons, polylines and shapes, which the OpenGL
+  // paint engine tessellates on the GPU. Others (images, fonts, effects) are faster
+  // or exact only on the CPU, the whole layer is then drawn on the CPU.
+  static const QStringList sGpuSymbolLayers
+  {
+    QStringLiteral( "SimpleFill" ),
+    QStringLiteral( "SimpleLine" ),
+    QStringLiteral( "SimpleMarker" )
+  };
+  const QgsSymbolList symbols = mRenderer->symbols( context );
+  for ( QgsSymbol *symbol : symbols )
+  {
+    for ( int i = 0; i < symbol->symbolLayerCount(); ++i )
+    {
+      const QgsSymbolLayer *layer = symbol->symbolLayer( i );
+      if ( !sGpuSymbolLayers.contains( layer->layerType() ) || ( layer->paintEffect() && layer->paintEffect()->enabled() ) )
+        return false;
+    }
+  }
+  return true;
+}
+
+bool QgsVectorLayerRenderer::drawRendererGpu( QgsFeatureIterator &fit )
+{
+#ifndef QT_NO_OPENGL
+  QgsRenderContext &context = *renderContext();
+  QPainter *painter = context.painter();
+  const QImage *destination = static_cast< const QImage * >( painter->device() );
+
+  QOpenGLContext glContext;
+  glContext.setFormat( mGpuSurface->format() );
+  if ( !glContext.create() || !glContext.makeCurrent( mGpuSurface.get() ) )
+  {
+    QgsDebugMsgLevel( QStringLiteral( "Could not create an OpenGL context, drawing %1 on the CPU" ).arg( layerId() ), 2 );
+    return false;
+  }
+
+  bool drawn = false;
+  {
+    // multisampling gives about the same antialiasing as the raster paint engine
+    QOpenGLFramebufferObjectFormat format;
+    format.setAttachment( QOpenGLFramebufferObject::CombinedDepthStencil );
+    format.setSamples( context.testFlag( QgsRenderContext::Antialiasing ) ? 8 : 0 );
+    QOpenGLFramebufferObject framebuffer( destination->size(), format );
+    if ( framebuffer.isValid() && framebuffer.bind() )
+    {
+      QOpenGLPaintDevice device( destination->size() );
+      device.setDotsPerMeterX( destination->dotsPerMeterX() );
+      device.setDotsPerMeterY( destination->dotsPerMeterY() );
+
+      QPainter gpuPainter( &device );
+      gpuPainter.setRenderHints( painter->renderHints() );
+      gpuPainter.setCompositionMode( QPainter::CompositionMode_Source );
+      gpuPainter.fillRect( QRect( QPoint( 0, 0 ), destination->size() ), Qt::transparent );
+      gpuPainter.setCompositionMode( QPainter::CompositionMode_SourceOver );
+
+      context.setPainter( &gpuPainter );
+      if ( ( mRenderer->capabilities() & QgsFeatureRenderer::SymbolLevels ) && mRenderer->usingSymbolLevels() )
+        drawRendererLevels( fit );
+      else
+        drawRenderer( fit );
+      gpuPainter.end();
+      context.setPainter( painter );
+
+      // the clip path of the layer applies to the destination painter
+      painter->drawImage( 0, 0, framebuffer.toImage() );
+      drawn = true;
+    }
+    else
+    {
+      QgsDebugMsgLevel( QStringLiteral( "Could not create an OpenGL framebuffer, drawing %1 on the CPU" ).arg( layerId() ), 2 );
+    }
+  }
+  glContext.doneCurrent();
+  return drawn;
+#else
+  Q_UNUSED( fit )
+  return false;
+#endif
+}
+
+void QgsVectorLayerRenderer::drawRendererParallel( QgsFeatureIterator &fit, int bandCount )
+{
+  QgsRenderContext &context = *renderContext();
+  const QImage *destination = static_cast< QImage * >( context.painter()->device() );
+  const bool symbolLevels = ( mRenderer->capabilities() & QgsFeatureRenderer::SymbolLevels ) && mRenderer->usingSymbolLevels();
+
+  std::vector< QgsVectorLayerRenderBand > bands;
+  const int bandHeight = static_cast< int >( std::ceil( destination->height() / static_cast< double >( bandCount ) ) );
+  for ( int top = 0; top < destination->height(); top += bandHeight )
+  {
+    QgsVectorLayerRenderBand band;
+    band.top = top;
+    band.height = std::min( bandHeight, destination->height() - top );
+    bands.push_back( std::move( band ) );
+  }
+
+  // largest distance painted outside of the feature bounding box, in pixels (plus antialiasing)
+  double bleed = 2;
+  const QgsSymbolList symbols = mRenderer->symbols( context );
+  for ( QgsSymbol *symbol : symbols )
+  {
+    bleed = std::max( bleed, QgsSymbolLayerUtils::estimateMaxSymbolBleed( symbol, context ) );
+    if ( symbol->type() == QgsSymbol::Marker )
+      bleed = std::max( bleed, static_cast< QgsMarkerSymbol * >( symbol )->size( context ) );
+    else if ( symbol->type() == QgsSymbol::Line )
+      bleed = std::max( bleed, static_cast< QgsLineSymbol * >( symbol )->width( context ) );
+  }
+
+  QgsExpressionContextScope *symbolScope = QgsExpressionContextUtils::updateSymbolScope( nullptr, new QgsExpressionContextScope() );
+  std::unique_ptr< QgsExpressionContextScopePopper > scopePopper = qgis::make_unique< QgsExpressionContextScopePopper >( context.expressionContext(), symbolScope );
+
+  std::unique_ptr< QgsGeometryEngine > clipEngine;
+  if ( mApplyClipFilter )
+  {
+    clipEngine.reset( QgsGeometry::createGeometryEngine( mClipFilterGeom.constGet() ) );
+    clipEngine->prepareGeometry();
+  }
+
+  const QgsCoordinateTransform ct = context.coordinateTransform();
+  const QgsMapToPixel &mtp = context.mapToPixel();
+
+  // 1. fetch features, dispatch them to the bands and register them for labeling
+  QgsFeature fet;
+  while ( fit.nextFeature( fet ) )
+  {
+    if ( context.renderingStopped() )
+    {
+      QgsDebugMsgLevel( QStringLiteral( "Drawing of vector layer %1 canceled." ).arg( layerId() ), 2 );
+      break;
+    }
+
+    if ( !fet.hasGeometry() || fet.geometry().isEmpty() )
+      continue; // skip features without geometry
+
+    if ( clipEngine && !clipEngine->intersects( fet.geometry().constGet() ) )
+      continue; // skip features outside of clipping region
+
+    context.expressionContext().setFeature( fet );
+    if ( !mRenderer->willRenderFeature( fet, context ) )
+      continue;
+
+    double top = 0;
+    double bottom = destination->height();
+    try
+    {
+      QgsRectangle bbox = fet.geometry().boundingBox();
+      if ( ct.isValid() && !ct.isShortCircuited() )
+        bbox = ct.transformBoundingBox( bbox );
+
+      const QgsPointXY corners[] =
+      {
+        mtp.transform( bbox.xMinimum(), bbox.yMinimum() ),
+        mtp.transform( bbox.xMinimum(), bbox.yMaximum() ),
+        mtp.transform( bbox.xMaximum(), bbox.yMinimum() ),
+        mtp.transform( bbox.xMaximum(), bbox.yMaximum() )
+      };
+      top = std::numeric_limits< double >::max();
+      bottom = std::numeric_limits< double >::lowest();
+      for ( const QgsPointXY &corner : corners )
+      {
+        top = std::min( top, corner.y() - bleed );
+        bottom = std::max( bottom, corner.y() + bleed );
+      }
+    }
+    catch ( const QgsCsException & )
+    {
+      // let every band try to draw it
+    }
+
+    for ( QgsVectorLayerRenderBand &band : bands )
+    {
+      if ( band.top <= bottom && band.top + band.height >= top )
+        band.features.append( fet );
+    }
+
+    // new labeling engine
+    if ( context.labelingEngine() && ( mLabelProvider || mDiagramProvider ) )
+    {
+      try
+      {
+        QgsGeometry obstacleGeometry;
+        QgsSymbolList symbols = mRenderer->originalSymbolsForFeature( fet, context );
+        QgsSymbol *symbol = nullptr;
+        if ( !symbols.isEmpty() && fet.geometry().type() == QgsWkbTypes::PointGeometry )
+        {
+          obstacleGeometry = QgsVectorLayerLabelProvider::getPointObstacleGeometry( fet, context, symbols );
+        }
+
+        if ( !symbols.isEmpty() )
+        {
+          symbol = symbols.at( 0 );
+          QgsExpressionContextUtils::updateSymbolScope( symbol, symbolScope );
+        }
+
+        if ( mApplyLabelClipGeometries )
+          context.setFeatureClipGeometry( mLabelClipFeatureGeom );
+
+        if ( mLabelProvider )
+        {
+          mLabelProvider->registerFeature( fet, context, obstacleGeometry, symbol );
+        }
+        if ( mDiagramProvider )
+        {
+          mDiagramProvider->registerFeature( fet, context, obstacleGeometry );
+        }
+
+        if ( mApplyLabelClipGeometries )
+          context.setFeatureClipGeometry( QgsGeometry() );
+      }
+      catch ( const QgsCsException &cse )
+      {
+        Q_UNUSED( cse )
+        QgsDebugMsg( QStringLiteral( "Failed to transform a point while registering a feature with ID '%1'. Ignoring this feature. %2" )
+                     .arg( fet.id() ).arg( cse.what() ) );
+      }
+    }
+  }
+
+  scopePopper.reset();
+
+  // 2. draw the bands in parallel, with renderers cloned in this thread
+  if ( !context.renderingStopped() )
+  {
+    for ( QgsVectorLayerRenderBand &band : bands )
+    {
+      if ( band.features.isEmpty() )
+        continue;
+
+      band.renderer.reset( mRenderer->clone() );
+      band.image = QImage( destination->width(), band.height, QImage::Format_ARGB32_Premultiplied );
+      band.image.setDotsPerMeterX( destination->dotsPerMeterX() );
+      band.image.setDotsPerMeterY( destination->dotsPerMeterY() );
+      band.image.fill( Qt::transparent );
+    }
+
+    QtConcurrent::blockingMap( bands, [this, symbolLevels]( QgsVectorLayerRenderBand & band )
+    {
+      if ( band.renderer )
+        drawBand( band.renderer.get(), band.features, band.top, band.image, symbolLevels );
+    } );
+
+    // 3. compose the bands, they do not overlap
+    for ( const QgsVectorLayerRenderBand &band : bands )
+    {
+      if ( band.renderer )
+        context.painter()->drawImage( 0, band.top, band.image );
+    }
+  }
+
+  stopRenderer( nullptr );
+}
+
+void QgsVectorLayerRenderer::drawBand( QgsFeatureRenderer *renderer, const QVector<QgsFeature> &features, int top, QImage &image, bool symbolLevels )
+{
+  const QgsRenderContext &mainContext = *renderContext();
+
+  QPainter painter( &image );
+  painter.setRenderHints( mainContext.painter()->renderHints() );
+  // same painter coordinates as the destination image
+  painter.translate( 0, -top );
+
+  QgsRenderContext context( mainContext );
+  context.setPainter( &painter );
+  if ( mApplyClipGeometries )
+    context.setFeatureClipGeometry( mClipFeatureGeom );
+
+  QgsExpressionContextScope *symbolScope = QgsExpressionContextUtils::updateSymbolScope( nullptr, new QgsExpressionContextScope() );
+  context.expressionContext().appendScope( symbolScope );
+
+  renderer->startRender( context, mFields );
+
+  auto renderBandFeature = [ & ]( const QgsFeature & feature, int layer )
+  {
+    bool sel = context.showSelection() && mSelectedFeatureIds.contains( feature.id() );
+    bool drawMarker = ( mDrawVertexMarkers && context.drawEditingInformation() && ( !mVertexMarkerOnlyForSelection || sel ) );
+
+    context.expressionContext().setFeature( feature );
+    try
+    {
+      renderer->renderFeature( feature, context, layer, sel, drawMarker );
+    }
+    catch ( const QgsCsException &cse )
+    {
+      Q_UNUSED( cse )
+      QgsDebugMsg( QStringLiteral( "Failed to transform a point while drawing a feature with ID '%1'. Ignoring this feature. %2" )
+                   .arg( feature.id() ).arg( cse.what() ) );
+    }
+  };
+
+  if ( !symbolLevels )
+  {
+    for ( const QgsFeature &feature : features )
+    {
+      if ( mainContext.renderingStopped() )
+        break;
+
+      renderBandFeature( feature, -1 );
+    }
+  }
+  else
+  {
+    QHash< QgsSymbol *, QList<QgsFeature> > symbolFeatures;
+    for ( const QgsFeature &feature : features )
+    {
+      context.expressionContext().setFeature( feature );
+      if ( QgsSymbol *sym = renderer->symbolForFeature( feature, context ) )
+        symbolFeatures[sym].append( feature );
+    }
+
+    const QgsSymbolLevelOrder levels = rendererSymbolLevels( renderer, context );
+    for ( const QgsSymbolLevel &level : levels )
+    {
+      for ( const QgsSymbolLevelItem &item : level )
+      {
+        const auto it = symbolFeatures.constFind( item.symbol() );
+        if ( it == symbolFeatures.constEnd() )
+          continue;
+
+        for ( const QgsFeature &feature : it.value() )
+        {
+          if ( mainContext.renderingStopped() )
+            break;
+
+          renderBandFeature( feature, item.layer() );
+        }
+      }
+    }
+  }
+
+  renderer->stopRender( context );
+  delete context.expressionContext().popScope();
+}
 
 void QgsVectorLayerRenderer::stopRenderer( QgsSingleSymbolRenderer *selRenderer )
 {
@@ -597,6 +1194,15 @@ void QgsVectorLayerRenderer::stopRenderer( QgsSingleSymbolRenderer *selRenderer
   }
 }
 
+void QgsVectorLayerRenderer::recordStatisticsStep( double &time )
+{
+  if ( !mRecordStatistics )
+    return;
+
+  const qint64 step = mStatisticsTimer.nsecsElapsed();
+  time += ( step - mStatisticsStep ) / 1000000.0;
+  mStatisticsStep = step;
+}
 
 
 
@@ -27,9 +27,12 @@ class QgsDiagramLayerSettings;
 class QgsFeatureIterator;
 class QgsSingleSymbolRenderer;
 class QgsMapClippingRegion;
+class QImage;
+class QOffscreenSurface;
 
 #define SIP_NO_FILE
 
+#include <QElapsedTimer>
 #include <QList>
 #include <QPainter>
 
@@ -90,6 +93,15 @@ class QgsVectorLayerRenderer : public QgsMapLayerRenderer
 
   private:
 
+    //! Time budget (in ms) of the preview drawn by drawPreview()
+    static const int PREVIEW_TIME_BUDGET = 150;
+
+    //! Factor applied to the simplification tolerance of the preview
+    static constexpr double PREVIEW_SIMPLIFY_FACTOR = 4.0;
+
+    //! Maximum error (in pixels) of the approximation of the coordinate transform
+    static constexpr double APPROXIMATE_TRANSFORM_TOLERANCE = 0.25;
+
     /**
      * Registers label and diagram layer
      * \param layer diagram layer
@@ -108,9 +120,68 @@ class QgsVectorLayerRenderer : public QgsMapLayerRenderer
      */
     void drawRendererLevels( QgsFeatureIterator &fit );
 
+    /**
+     * Returns TRUE if the layer is drawn progressively: a simplified preview first,
+     * then the full rendering drawn on a separate image which replaces the preview
+     * once it is finished.
+     */
+    bool progressiveRenderingSupported();
+
+    /**
+     * Draws a preview of the features of \a featureRequest, with a coarser
+     * simplification and within a short time budget. The features are not
+     * registered for labeling.
+     */
+    void drawPreview( const QgsFeatureRequest &featureRequest );
+
+    /**
+     * Returns the number of threads which can draw the layer features in parallel,
+     * or 1 if the layer has to be rendered in the calling thread.
+     */
+    int parallelRenderingThreadCount();
+
+    /**
+     * Draws the layer with \a bandCount threads, each one rendering the features
+     * intersecting a horizontal band of the destination image with its own copy
+     * of the renderer. Features are fetched and registered for labeling in the
+     * calling thread. The bands are disjoint, so the result is the same as
+     * drawRenderer() or drawRendererLevels().
+     */
+    void drawRendererParallel( QgsFeatureIterator &fit, int bandCount );
+
+    /**
+     * Draws \a features on the \a image of a band, whose first row is the row \a top
+     * of the destination image. It runs in a worker thread: \a renderer is the clone
+     * owned by the band, started and stopped with a copy of the render context which
+     * paints on \a image. If \a symbolLevels is TRUE the features are drawn in the
+     * order of the symbol levels of \a renderer, otherwise in the order of \a features.
+     */
+    void drawBand( QgsFeatureRenderer *renderer, const QVector<QgsFeature> &features, int top, QImage &image, bool symbolLevels );
+
+    /**
+     * Returns TRUE if the layer can be drawn with drawRendererGpu(): GPU rendering
+     * is enabled, an offscreen surface was created and the symbols only use
+     * simple fill, line and marker symbol layers.
+     */
+    bool gpuRenderingSupported();
+
+    /**
+     * Draws the layer with an OpenGL paint engine in an offscreen framebuffer,
+     * which is then drawn on the destination painter. Returns FALSE without
+     * fetching any feature if the OpenGL context or the framebuffer cannot be
+     * created, the layer must then be drawn on the CPU.
+     */
+    bool drawRendererGpu( QgsFeatureIterator &fit );
+
     //! Stop version 2 renderer and selected renderer (if required)
     void stopRenderer( QgsSingleSymbolRenderer *selRenderer );
 
+    /**
+     * Adds the time elapsed since the previous step to \a time, when the
+     * rendering statistics are recorded.
+     */
+    void recordStatisticsStep( double &time );
+
 
   protected:
 
@@ -168,6 +239,13 @@ class QgsVectorLayerRenderer : public QgsMapLayerRenderer
     QgsGeometry mLabelClipFeatureGeom;
     bool mApplyLabelClipGeometries = false;
 
+    //! Offscreen surface of the GPU rendering, it must be created in the GUI thread
+    std::unique_ptr< QOffscreenSurface > mGpuSurface;
+
+    bool mRecordStatistics = false;
+    QElapsedTimer mStatisticsTimer;
+    qint64 mStatisticsStep = 0;
+
 };
 
 
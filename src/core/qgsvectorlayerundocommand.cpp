@@ -286,6 +286,126 @@ void QgsVectorLayerUndoCommandChangeAttribute::redo()
 }
 
 
+QgsVectorLayerUndoCommandChangeFieldValues::QgsVectorLayerUndoCommandChangeFieldValues( QgsVectorLayerEditBuffer *buffer, int fieldIndex, const QHash<QgsFeatureId, QVariant> &newValues, const QHash<QgsFeatureId, QVariant> &oldValues )
+  : QgsVectorLayerUndoCommand( buffer )
+  , mFieldIndex( fieldIndex )
+  , mFirstChanges( newValues.size(), true )
+{
+  mFids.reserve( newValues.size() );
+  mOldValues.reserve( newValues.size() );
+  mNewValues.reserve( newValues.size() );
+
+  // same as QgsVectorLayerUndoCommandChangeAttribute, for each feature
+  int i = 0;
+  for ( auto it = newValues.constBegin(); it != newValues.constEnd(); ++it, ++i )
+  {
+    const QgsFeatureId fid = it.key();
+    QVariant oldValue = oldValues.value( fid );
+    if ( FID_IS_NEW( fid ) )
+    {
+      QgsFeatureMap::const_iterator featureIt = mBuffer->mAddedFeatures.constFind( fid );
+      Q_ASSERT( featureIt != mBuffer->mAddedFeatures.constEnd() );
+      if ( featureIt.value().attribute( mFieldIndex ).isValid() )
+      {
+        oldValue = featureIt.value().attribute( mFieldIndex );
+        mFirstChanges.clearBit( i );
+      }
+    }
+    else
+    {
+      QgsChangedAttributesMap::const_iterator changedIt = mBuffer->mChangedAttributeValues.constFind( fid );
+      if ( changedIt != mBuffer->mChangedAttributeValues.constEnd() && changedIt->contains( mFieldIndex ) )
+      {
+        oldValue = changedIt->value( mFieldIndex );
+        mFirstChanges.clearBit( i );
+      }
+    }
+
+    mFids << fid;
+    mOldValues << oldValue;
+    mNewValues << it.value();
+  }
+}
+
+void QgsVectorLayerUndoCommandChangeFieldValues::undo()
+{
+  QVector<QVariant> originals = mOldValues;
+  QgsFeatureIds unknownOriginals;
+
+  for ( int i = 0; i < mFids.size(); ++i )
+  {
+    const QgsFeatureId fid = mFids.at( i );
+    if ( FID_IS_NEW( fid ) )
+    {
+      QgsFeatureMap::iterator it = mBuffer->mAddedFeatures.find( fid );
+      Q_ASSERT( it != mBuffer->mAddedFeatures.end() );
+      it.value().setAttribute( mFieldIndex, mOldValues.at( i ) );
+    }
+    else if ( mFirstChanges.testBit( i ) )
+    {
+      QgsChangedAttributesMap::iterator it = mBuffer->mChangedAttributeValues.find( fid );
+      if ( it != mBuffer->mChangedAttributeValues.end() )
+      {
+        it->remove( mFieldIndex );
+        if ( it->isEmpty() )
+          mBuffer->mChangedAttributeValues.erase( it );
+      }
+
+      if ( !mOldValues.at( i ).isValid() )
+        unknownOriginals << fid;
+    }
+    else
+    {
+      mBuffer->mChangedAttributeValues[fid][mFieldIndex] = mOldValues.at( i );
+    }
+  }
+
+  // the original values which were not given are read from the provider with a single request
+  if ( !unknownOriginals.isEmpty() )
+  {
+    QHash<QgsFeatureId, QVariant> providerValues;
+    QgsFeatureRequest request;
+    request.setFilterFids( unknownOriginals );
+    request.setFlags( QgsFeatureRequest::NoGeometry );
+    request.setSubsetOfAttributes( QgsAttributeList() << mFieldIndex );
+    QgsFeatureIterator fi = layer()->getFeatures( request );
+    QgsFeature tmp;
+    while ( fi.nextFeature( tmp ) )
+      providerValues.insert( tmp.id(), tmp.attribute( mFieldIndex ) );
+
+    for ( int i = 0; i < mFids.size(); ++i )
+    {
+      if ( unknownOriginals.contains( mFids.at( i ) ) )
+        originals[i] = providerValues.value( mFids.at( i ) );
+    }
+  }
+
+  for ( int i = 0; i < mFids.size(); ++i )
+    emit mBuffer->attributeValueChanged( mFids.at( i ), mFieldIndex, originals.at( i ) );
+}
+
+void QgsVectorLayerUndoCommandChangeFieldValues::redo()
+{
+  for ( int i = 0; i < mFids.size(); ++i )
+  {
+    const QgsFeatureId fid = mFids.at( i );
+    if ( FID_IS_NEW( fid ) )
+    {
+      QgsFeatureMap::iterator it = mBuffer->mAddedFeatures.find( fid );
+      Q_ASSERT( it != mBuffer->mAddedFeatures.end() );
+      it.value().setAttribute( mFieldIndex, mNewValues.at( i ) );
+    }
+    else
+    {
+      mBuffer->mChangedAttributeValues[fid].insert( mFieldIndex, mNewValues.at( i ) );
+    }
+  }
+
+  for ( int i = 0; i < mFids.size(); ++i )
+    emit mBuffer->attributeValueChanged( mFids.at( i ), mFieldIndex, mNewValues.at( i ) );
+}
+
+
 QgsVectorLayerUndoCommandAddAttribute::QgsVectorLayerUndoCommandAddAttribute( QgsVectorLayerEditBuffer *buffer, const QgsField &field )
   : QgsVectorLayerUndoCommand( buffer )
   , mField( field )
@@ -21,8 +21,10 @@
 #include <QUndoCommand>
 
 #include <QVariant>
+#include <QBitArray>
 #include <QSet>
 #include <QList>
+#include <QVector>
 
 #include "qgsfields.h"
 #include "qgsfeature.h"
@@ -171,6 +173,40 @@ class CORE_EXPORT QgsVectorLayerUndoCommandChangeAttribute : public QgsVectorLay
     bool mFirstChange;
 };
 
+/**
+ * \ingroup core
+ * \class QgsVectorLayerUndoCommandChangeFieldValues
+ * \brief Undo command for modifying an attribute of several features from a vector layer.
+ *
+ * The values are stored in compact arrays, so that a single command can hold the changes
+ * of a bulk edit of millions of features.
+ *
+ * \since QGIS 3.16
+ */
+
+class CORE_EXPORT QgsVectorLayerUndoCommandChangeFieldValues : public QgsVectorLayerUndoCommand
+{
+  public:
+
+    /**
+     * Constructor for QgsVectorLayerUndoCommandChangeFieldValues
+     * \param buffer associated edit buffer
+     * \param fieldIndex index of field to modify
+     * \param newValues new values of the attribute, by feature ID
+     * \param oldValues previous values of the attribute, by feature ID
+     */
+    QgsVectorLayerUndoCommandChangeFieldValues( QgsVectorLayerEditBuffer *buffer SIP_TRANSFER, int fieldIndex, const QHash<QgsFeatureId, QVariant> &newValues, const QHash<QgsFeatureId, QVariant> &oldValues );
+    void undo() override;
+    void redo() override;
+
+  private:
+    int mFieldIndex;
+    QVector<QgsFeatureId> mFids;
+    QVector<QVariant> mOldValues;
+    QVector<QVariant> mNewValues;
+    QBitArray mFirstChanges;
+};
+
 /**
  * \ingroup core
  * \class QgsVectorLayerUndoCommandAddAttribute
@@ -16,6 +16,7 @@
 #include <QRegularExpression>
 
 #include "qgsexpressioncontext.h"
+#include "qgsfeaturebatch.h"
 #include "qgsfeatureiterator.h"
 #include "qgsfeaturerequest.h"
 #include "qgsvectorlayerutils.h"
@@ -130,6 +131,39 @@ QList<double> QgsVectorLayerUtils::getDoubleValues( const QgsVectorLayer *layer,
   if ( nullCount )
     *nullCount = 0;
 
+  const int attrNum = layer->fields().lookupField( fieldOrExpression );
+  if ( attrNum != -1 && layer->fields().at( attrNum ).isNumeric() )
+  {
+    // plain numeric fields are read in batches, without converting each value from a QVariant
+    QgsFeatureIterator fit = getValuesIterator( layer, fieldOrExpression, ok, selectedOnly );
+    if ( !ok )
+      return values;
+
+    QgsFeatureBatch batch( layer->fields(), QgsAttributeList() << attrNum );
+    while ( fit.nextBatch( batch, 4096 ) > 0 )
+    {
+      values.reserve( values.size() + batch.size() );
+      for ( int i = 0; i < batch.size(); ++i )
+      {
+        if ( batch.isNull( 0, i ) )
+        {
+          if ( nullCount )
+            *nullCount += 1;
+        }
+        else
+        {
+          values << batch.doubleValue( 0, i );
+        }
+      }
+      if ( feedback && feedback->isCanceled() )
+      {
+        ok = false;
+        return values;
+      }
+    }
+    return values;
+  }
+
   QList<QVariant> variantValues = getValues( layer, fieldOrExpression, ok, selectedOnly, feedback );
   if ( !ok )
     return values;
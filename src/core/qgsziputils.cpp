@@ -14,11 +14,14 @@
  ***************************************************************************/
 
 #include <fstream>
+#include <memory>
 
+#include <QFile>
 #include <QFileInfo>
 #include <QDir>
 
 #include "zip.h"
+#include <zlib.h>
 
 #include "qgsmessagelog.h"
 #include "qgsziputils.h"
@@ -129,7 +132,26 @@ bool QgsZipUtils::unzip( const QString &zipFilename, const QString &dir, QString
   return true;
 }
 
-bool QgsZipUtils::zip( const QString &zipFilename, const QStringList &files )
+// CRC-32 of a file, as stored in zip archives
+static bool fileCrc32( const QString &filename, quint32 &crc )
+{
+  QFile file( filename );
+  if ( !file.open( QIODevice::ReadOnly ) )
+    return false;
+
+  uLong checksum = crc32( 0L, Z_NULL, 0 );
+  std::unique_ptr< char[] > buf( new char[1024 * 1024] );
+  qint64 read = 0;
+  while ( ( read = file.read( buf.get(), 1024 * 1024 ) ) > 0 )
+    checksum = crc32( checksum, reinterpret_cast< const Bytef * >( buf.get() ), static_cast< uInt >( read ) );
+  if ( read < 0 )
+    return false;
+
+  crc = static_cast< quint32 >( checksum );
+  return true;
+}
+
+bool QgsZipUtils::zip( const QString &zipFilename, const QStringList &files, const QString &previousZipFilename )
 {
   if ( zipFilename.isEmpty() )
   {
@@ -137,6 +159,25 @@ bool QgsZipUtils::zip( const QString &zipFilename, const QStringList &files )
     return false;
   }
 
+  // files which did not change since the previous archive are copied from it, still compressed
+  struct zip *previous = nullptr;
+#if LIBZIP_VERSION_MAJOR >= 1
+  if ( !previousZipFilename.isEmpty() && QFileInfo::exists( previousZipFilename ) )
+  {
+    int previousRc = 0;
+    const QByteArray previousFileNamePtr = previousZipFilename.toUtf8();
+    previous = zip_open( previousFileNamePtr.constData(), ZIP_RDONLY, &previousRc );
+  }
+#else
+  Q_UNUSED( previousZipFilename )
+#endif
+  auto closePrevious = [&previous]
+  {
+    if ( previous )
+      zip_discard( previous );
+    previous = nullptr;
+  };
+
   int rc = 0;
   const QByteArray zipFileNamePtr = zipFilename.toUtf8();
   struct zip *z = zip_open( zipFileNamePtr.constData(), ZIP_CREATE, &rc );
@@ -150,14 +191,33 @@ bool QgsZipUtils::zip( const QString &zipFilename, const QStringList &files )
       {
         QgsMessageLog::logMessage( QObject::tr( "Error input file does not exist: '%1'" ).arg( file ) );
         zip_close( z );
+        closePrevious();
         return false;
       }
 
       const QByteArray fileNamePtr = file.toUtf8();
-      zip_source *src = zip_source_file( z, fileNamePtr.constData(), 0, 0 );
+      const QByteArray fileInfoPtr = fileInfo.fileName().toUtf8();
+      zip_source *src = nullptr;
+#if LIBZIP_VERSION_MAJOR >= 1
+      if ( previous )
+      {
+        const zip_int64_t index = zip_name_locate( previous, fileInfoPtr.constData(), 0 );
+        struct zip_stat stat;
+        zip_stat_init( &stat );
+        quint32 crc = 0;
+        if ( index >= 0 && zip_stat_index( previous, static_cast< zip_uint64_t >( index ), 0, &stat ) == 0
+             && ( stat.valid & ZIP_STAT_SIZE ) && ( stat.valid & ZIP_STAT_CRC )
+             && stat.size == static_cast< zip_uint64_t >( fileInfo.size() )
+             && fileCrc32( file, crc ) && crc == stat.crc )
+        {
+          src = zip_source_zip( z, previous, static_cast< zip_uint64_t >( index ), ZIP_FL_COMPRESSED, 0, -1 );
+        }
+      }
+#endif
+      if ( !src )
+        src = zip_source_file( z, fileNamePtr.constData(), 0, 0 );
       if ( src )
       {
-        const QByteArray fileInfoPtr = fileInfo.fileName().toUtf8();
 #if LIBZIP_VERSION_MAJOR < 1
         rc = ( int ) zip_add( z, fileInfoPtr.constData(), src );
 #else
@@ -167,6 +227,7 @@ bool QgsZipUtils::zip( const QString &zipFilename, const QStringList &files )
         {
           QgsMessageLog::logMessage( QObject::tr( "Error adding file '%1': %2" ).arg( file, zip_strerror( z ) ) );
           zip_close( z );
+          closePrevious();
           return false;
         }
       }
@@ -174,15 +235,19 @@ bool QgsZipUtils::zip( const QString &zipFilename, const QStringList &files )
       {
         QgsMessageLog::logMessage( QObject::tr( "Error creating data source '%1': %2" ).arg( file, zip_strerror( z ) ) );
         zip_close( z );
+        closePrevious();
         return false;
       }
     }
 
+    // the copied entries are read from the previous archive when the new one is written
     zip_close( z );
+    closePrevious();
   }
   else
   {
     QgsMessageLog::logMessage( QObject::tr( "Error creating zip archive '%1': %2" ).arg( zipFilename, zip_strerror( z ) ) );
+    closePrevious();
     return false;
   }
 
@@ -54,9 +54,12 @@ namespace QgsZipUtils
    *  also returned.
    * \param zip The zip filename
    * \param files The absolute path to files to embed within the zip
+   * \param previousZip An optional zip file, usually the previous version of
+   *  the zip file. The files found unchanged in it, with the same name, size and
+   *  CRC, are copied from it without being compressed again. Since QGIS 3.16.
    * \since QGIS 3.0
    */
-  CORE_EXPORT bool zip( const QString &zip, const QStringList &files );
+  CORE_EXPORT bool zip( const QString &zip, const QStringList &files, const QString &previousZip = QString() );
 };
 
 #endif //QGSZIPUTILS_H
@@ -29,6 +29,8 @@ class originally created circa 2004 by T.Sutton, Gary E.Sherman, Steve Halasz
 #include <QDomDocument>
 #include <QDomElement>
 
+#include <cmath>
+
 QgsContrastEnhancement::QgsContrastEnhancement( Qgis::DataType dataType )
   : mMinimumValue( minimumValuePossible( dataType ) )
   , mMaximumValue( maximumValuePossible( dataType ) )
@@ -92,9 +94,139 @@ int QgsContrastEnhancement::enhanceContrast( double value )
   }
 }
 
+///@cond PRIVATE
+
+//! Sets \a values to the enhanced values of \a table for the \a count values of \a data, shifted by \a offset
+template <typename T>
+static void lookupValues( const T *data, const int *table, int offset, int *values, qgssize count )
+{
+  for ( qgssize i = 0; i < count; ++i )
+    values[i] = table[static_cast< int >( data[i] ) + offset];
+}
+
+//! Sets \a values to the linear stretch of the \a count values of \a data, -1 outside of the displayable range
+template <typename T>
+static void stretchValues( const T *data, double minimum, double range, double displayableMinimum, double displayableMaximum, int *values, qgssize count )
+{
+  for ( qgssize i = 0; i < count; ++i )
+  {
+    // same computation as QgsLinearMinMaxEnhancement and QgsLinearMinMaxEnhancementWithClip
+    const double value = static_cast< double >( data[i] );
+    const int stretched = static_cast< int >( ( ( value - minimum ) / range ) * 255.0 );
+    values[i] = !( value >= displayableMinimum && value <= displayableMaximum ) ? -1 : ( stretched < 0 ? 0 : ( stretched > 255 ? 255 : stretched ) );
+  }
+}
+
+//! Sets to -1 the \a values of the no data pixels of \a block, whose data is \a data
+template <typename T>
+static void maskNoData( const QgsRasterBlock &block, const T *data, int *values, qgssize count )
+{
+  if ( block.hasNoDataValue() )
+  {
+    const double noDataValue = block.noDataValue();
+    for ( qgssize i = 0; i < count; ++i )
+    {
+      const double value = static_cast< double >( data[i] );
+      if ( std::isnan( value ) || qgsDoubleNear( value, noDataValue ) )
+        values[i] = -1;
+    }
+  }
+  else if ( block.hasNoData() )
+  {
+    for ( qgssize i = 0; i < count; ++i )
+    {
+      if ( block.isNoData( i ) )
+        values[i] = -1;
+    }
+  }
+}
+
+///@endcond
+
+template <typename T>
+void QgsContrastEnhancement::enhanceData( const QgsRasterBlock &block, const T *data, int *values, qgssize count )
+{
+  if ( block.dataType() == mRasterDataType && ( mRasterDataType == Qgis::Byte || mRasterDataType == Qgis::UInt16 || mRasterDataType == Qgis::Int16 ) )
+  {
+    if ( mBlockLookupTable.empty() )
+    {
+      mBlockLookupTable.resize( static_cast< std::size_t >( mRasterDataTypeRange + 1 ) );
+      for ( std::size_t i = 0; i < mBlockLookupTable.size(); ++i )
+      {
+        const double value = static_cast< double >( i ) - mLookupTableOffset;
+        mBlockLookupTable[i] = isValueInDisplayableRange( value ) ? enhanceContrast( value ) : -1;
+      }
+    }
+    lookupValues( data, mBlockLookupTable.data(), static_cast< int >( mLookupTableOffset ), values, count );
+  }
+  else if ( mContrastEnhancementAlgorithm == StretchToMinimumMaximum || mContrastEnhancementAlgorithm == StretchAndClipToMinimumMaximum )
+  {
+    const bool clip = mContrastEnhancementAlgorithm == StretchAndClipToMinimumMaximum;
+    stretchValues( data, mMinimumValue, mMaximumValue - mMinimumValue,
+                   clip ? mMinimumValue : minimumValuePossible( mRasterDataType ),
+                   clip ? mMaximumValue : maximumValuePossible( mRasterDataType ), values, count );
+  }
+  else
+  {
+    for ( qgssize i = 0; i < count; ++i )
+    {
+      const double value = static_cast< double >( data[i] );
+      values[i] = isValueInDisplayableRange( value ) ? enhanceContrast( value ) : -1;
+    }
+  }
+
+  maskNoData( block, data, values, count );
+}
+
+void QgsContrastEnhancement::enhanceBlock( const QgsRasterBlock &block, int *values )
+{
+  if ( mEnhancementDirty )
+  {
+    generateLookupTable();
+  }
+
+  const qgssize count = static_cast< qgssize >( block.width() ) * block.height();
+  const char *data = block.constBits();
+  if ( !data )
+  {
+    std::fill( values, values + count, -1 );
+    return;
+  }
+
+  switch ( block.dataType() )
+  {
+    case Qgis::Byte:
+      enhanceData( block, reinterpret_cast< const quint8 * >( data ), values, count );
+      break;
+    case Qgis::UInt16:
+      enhanceData( block, reinterpret_cast< const quint16 * >( data ), values, count );
+      break;
+    case Qgis::Int16:
+      enhanceData( block, reinterpret_cast< const qint16 * >( data ), values, count );
+      break;
+    case Qgis::UInt32:
+      enhanceData( block, reinterpret_cast< const quint32 * >( data ), values, count );
+      break;
+    case Qgis::Int32:
+      enhanceData( block, reinterpret_cast< const qint32 * >( data ), values, count );
+      break;
+    case Qgis::Float32:
+      enhanceData( block, reinterpret_cast< const float * >( data ), values, count );
+      break;
+    case Qgis::Float64:
+      enhanceData( block, reinterpret_cast< const double * >( data ), values, count );
+      break;
+    default:
+      // complex and color data are not enhanced
+      std::fill( values, values + count, -1 );
+      break;
+  }
+}
+
 bool QgsContrastEnhancement::generateLookupTable()
 {
   mEnhancementDirty = false;
+  mBlockLookupTable.clear();
 
   if ( !mContrastEnhancementFunction )
     return false;
@@ -27,8 +27,10 @@ class originally created circa 2004 by T.Sutton, Gary E.Sherman, Steve Halasz
 #include "qgis_sip.h"
 #include "qgsraster.h"
 #include <memory>
+#include <vector>
 
 class QgsContrastEnhancementFunction;
+class QgsRasterBlock;
 class QDomDocument;
 class QDomElement;
 class QString;
@@ -167,6 +169,20 @@ class CORE_EXPORT QgsContrastEnhancement
      */
     bool isValueInDisplayableRange( double value );
 
+    /**
+     * Applies the contrast enhancement to all the pixels of \a block, and stores the
+     * enhanced values in \a values, which must hold as many values as the block.
+     * The pixels which are no data or outside of the displayable range are set to -1.
+     *
+     * The results are the same as isValueInDisplayableRange() and enhanceContrast() for
+     * each pixel, but the loops are specialized for the data type of the block and read
+     * the lookup table directly for 8 and 16 bit data.
+     *
+     * \note not available in Python bindings
+     * \since QGIS 3.16
+     */
+    void enhanceBlock( const QgsRasterBlock &block, int *values ) SIP_SKIP;
+
     /**
      * Sets the contrast enhancement \a algorithm.
      *
@@ -237,6 +253,9 @@ class CORE_EXPORT QgsContrastEnhancement
     //! \brief Pointer to the lookup table
     int *mLookupTable = nullptr;
 
+    //! Lookup table of enhanceBlock(), also set to -1 for the values outside of the displayable range
+    std::vector< int > mBlockLookupTable;
+
     //! \brief User defineable minimum value for the band, used for enhanceContrasting
     double mMinimumValue;
 
@@ -255,6 +274,12 @@ class CORE_EXPORT QgsContrastEnhancement
     //! Generates a new lookup table
     bool generateLookupTable();
 
+#ifndef SIP_RUN
+    //! Sets \a values to the enhanced values of the \a count pixels of \a block, whose data is \a data
+    template <typename T>
+    void enhanceData( const QgsRasterBlock &block, const T *data, int *values, qgssize count );
+#endif
+
     //! \brief Method to calculate the actual enhanceContrasted value(s)
     int calculateContrastEnhancementValue( double );
 
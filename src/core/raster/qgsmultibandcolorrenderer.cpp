@@ -25,6 +25,8 @@
 #include <QImage>
 #include <QSet>
 
+#include <vector>
+
 QgsMultiBandColorRenderer::QgsMultiBandColorRenderer( QgsRasterInterface *input, int redBand, int greenBand, int blueBand,
     QgsContrastEnhancement *redEnhancement,
     QgsContrastEnhancement *greenEnhancement,
@@ -262,6 +264,37 @@ QgsRasterBlock *QgsMultiBandColorRenderer::block( int bandNo, QgsRectangle  cons
   }
 
   qgssize count = ( qgssize )width * height;
+
+  // the contrast enhancements of the whole blocks are computed at once
+  std::vector< int > redEnhanced;
+  std::vector< int > greenEnhanced;
+  std::vector< int > blueEnhanced;
+  if ( !fastDraw )
+  {
+    auto enhance = [width, height, count]( QgsContrastEnhancement * enhancement, const QgsRasterBlock * block, std::vector< int > &values )
+    {
+      if ( !enhancement || !block )
+        return;
+
+      values.assign( count, -1 );
+      if ( block->width() == width && block->height() == height )
+        enhancement->enhanceBlock( *block, values.data() );
+    };
+    enhance( mRedContrastEnhancement, redBlock, redEnhanced );
+    enhance( mGreenContrastEnhancement, greenBlock, greenEnhanced );
+    enhance( mBlueContrastEnhancement, blueBlock, blueEnhanced );
+  }
+
+  // no data and values outside of the displayable range are both negative in the enhanced values
+  auto bandValue = []( const QgsRasterBlock * block, const std::vector< int > &enhanced, qgssize i, bool & isNoData )
+  {
+    if ( enhanced.empty() )
+      return block->valueAndNoData( i, isNoData );
+
+    isNoData = enhanced[i] < 0;
+    return static_cast< double >( enhanced[i] );
+  };
+
   for ( qgssize i = 0; i < count; i++ )
   {
     if ( fastDraw ) //fast rendering if no transparency, stretching, color inversion, etc.
@@ -295,15 +328,15 @@ QgsRasterBlock *QgsMultiBandColorRenderer::block( int bandNo, QgsRectangle  cons
     double blueVal = 0;
     if ( mRedBand > 0 )
     {
-      redVal = redBlock->valueAndNoData( i, isNoData );
+      redVal = bandValue( redBlock, redEnhanced, i, isNoData );
     }
     if ( !isNoData && mGreenBand > 0 )
     {
-      greenVal = greenBlock->valueAndNoData( i, isNoData );
+      greenVal = bandValue( greenBlock, greenEnhanced, i, isNoData );
     }
     if ( !isNoData && mBlueBand > 0 )
     {
-      blueVal = blueBlock->valueAndNoData( i, isNoData );
+      blueVal = bandValue( blueBlock, blueEnhanced, i, isNoData );
     }
     if ( isNoData )
     {
@@ -311,29 +344,6 @@ QgsRasterBlock *QgsMultiBandColorRenderer::block( int bandNo, QgsRectangle  cons
       continue;
     }
 
-    //apply default color if red, green or blue not in displayable range
-    if ( ( mRedContrastEnhancement && !mRedContrastEnhancement->isValueInDisplayableRange( redVal ) )
-         || ( mGreenContrastEnhancement && !mGreenContrastEnhancement->isValueInDisplayableRange( redVal ) )
-         || ( mBlueContrastEnhancement && !mBlueContrastEnhancement->isValueInDisplayableRange( redVal ) ) )
-    {
-      outputBlock->setColor( i, myDefaultColor );
-      continue;
-    }
-
-    //stretch color values
-    if ( mRedContrastEnhancement )
-    {
-      redVal = mRedContrastEnhancement->enhanceContrast( redVal );
-    }
-    if ( mGreenContrastEnhancement )
-    {
-      greenVal = mGreenContrastEnhancement->enhanceContrast( greenVal );
-    }
-    if ( mBlueContrastEnhancement )
-    {
-      blueVal = mBlueContrastEnhancement->enhanceContrast( blueVal );
-    }
-
     //opacity
     double currentOpacity = mOpacity;
     if ( mRasterTransparency )
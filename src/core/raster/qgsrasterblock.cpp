@@ -532,6 +532,67 @@ char *QgsRasterBlock::bits()
   return nullptr;
 }
 
+///@cond PRIVATE
+
+//! Sets the no data mask of typed values equal to a no data value
+struct QgsRasterBlockNoDataMask
+{
+  template <typename T>
+  void operator()( const T *values, qgssize count )
+  {
+    for ( qgssize i = 0; i < count; ++i )
+    {
+      const double value = static_cast< double >( values[i] );
+      mask[i] = std::isnan( value ) || qgsDoubleNear( value, noDataValue );
+    }
+  }
+
+  double noDataValue;
+  char *mask;
+};
+
+///@endcond
+
+QByteArray QgsRasterBlock::noDataMask( int firstRow, int rowCount ) const
+{
+  if ( rowCount < 0 )
+    rowCount = mHeight - firstRow;
+  if ( firstRow < 0 || rowCount < 0 || firstRow + rowCount > mHeight )
+    return QByteArray();
+
+  QByteArray mask( rowCount * mWidth, 0 );
+  if ( mHasNoDataValue )
+  {
+    QgsRasterBlockNoDataMask visitor = { mNoDataValue, mask.data() };
+    apply( visitor, firstRow, rowCount );
+  }
+  else if ( mNoDataBitmap )
+  {
+    char *maskData = mask.data();
+    for ( int row = firstRow; row < firstRow + rowCount; ++row )
+    {
+      const char *bitmapRow = mNoDataBitmap + static_cast< qgssize >( row ) * mNoDataBitmapWidth;
+      for ( int column = 0; column < mWidth; ++column )
+        *maskData++ = ( bitmapRow[column / 8] >> ( 7 - column % 8 ) ) & 1;
+    }
+  }
+  return mask;
+}
+
+const char *QgsRasterBlock::constBits() const
+{
+  if ( mData )
+  {
+    return reinterpret_cast< const char * >( mData );
+  }
+  if ( mImage && mImage->constBits() )
+  {
+    return reinterpret_cast< const char * >( mImage->constBits() );
+  }
+
+  return nullptr;
+}
+
 bool QgsRasterBlock::convert( Qgis::DataType destDataType )
 {
   if ( isEmpty() ) return false;
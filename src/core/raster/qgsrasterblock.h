@@ -561,6 +561,109 @@ class CORE_EXPORT QgsRasterBlock
      */
     char *bits() SIP_SKIP;
 
+    /**
+     * Returns a const pointer to block data.
+     * \note not available in Python bindings
+     * \since QGIS 3.16
+     */
+    const char *constBits() const SIP_SKIP;
+
+#ifndef SIP_RUN
+
+    /**
+     * Returns the values of the block typed as T, or NULLPTR if T is not the type of the
+     * data type of the block: quint8 for Qgis::Byte, quint16 for Qgis::UInt16, qint16 for
+     * Qgis::Int16, quint32 for Qgis::UInt32, qint32 for Qgis::Int32, float for Qgis::Float32
+     * and double for Qgis::Float64.
+     * \note not available in Python bindings
+     * \since QGIS 3.16
+     */
+    template <typename T>
+    const T *typedData() const
+    {
+      return mData && mDataType == dataTypeOf<T>() ? static_cast< const T * >( mData ) : nullptr;
+    }
+
+    /**
+     * Returns the values of the block typed as T, or NULLPTR if T is not the type of the
+     * data type of the block.
+     * \see typedData() const
+     * \note not available in Python bindings
+     * \since QGIS 3.16
+     */
+    template <typename T>
+    T *typedData()
+    {
+      return mData && mDataType == dataTypeOf<T>() ? static_cast< T * >( mData ) : nullptr;
+    }
+
+    /**
+     * Returns the width() values of \a row typed as T, or NULLPTR if T is not the type of
+     * the data type of the block or the row is out of the block.
+     * \see typedData()
+     * \note not available in Python bindings
+     * \since QGIS 3.16
+     */
+    template <typename T>
+    const T *typedRow( int row ) const
+    {
+      const T *data = typedData<T>();
+      return data && row >= 0 && row < mHeight ? data + static_cast< qgssize >( row ) * mWidth : nullptr;
+    }
+
+    /**
+     * Returns the width() values of \a row typed as T, or NULLPTR if T is not the type of
+     * the data type of the block or the row is out of the block.
+     * \see typedData()
+     * \note not available in Python bindings
+     * \since QGIS 3.16
+     */
+    template <typename T>
+    T *typedRow( int row )
+    {
+      T *data = typedData<T>();
+      return data && row >= 0 && row < mHeight ? data + static_cast< qgssize >( row ) * mWidth : nullptr;
+    }
+
+    /**
+     * Calls the templated call operator of \a visitor once, with the values of \a rowCount rows
+     * from \a firstRow (all the rows by default) typed as the data type of the block, and their
+     * count. Kernels can so be written once for all the numeric data types and loop over the
+     * native values, without the switch of value() for each pixel:
+     *
+     * \code{.cpp}
+     * struct Sum
+     * {
+     *   template <typename T>
+     *   void operator()( const T *values, qgssize count )
+     *   {
+     *     for ( qgssize i = 0; i < count; ++i )
+     *       sum += values[i];
+     *   }
+     *   double sum = 0;
+     * };
+     * \endcode
+     *
+     * Returns FALSE without calling the visitor if the block has no numeric data or the rows
+     * are out of the block.
+     * \see noDataMask()
+     * \note not available in Python bindings
+     * \since QGIS 3.16
+     */
+    template <typename Visitor>
+    bool apply( Visitor &visitor, int firstRow = 0, int rowCount = -1 ) const;
+
+    /**
+     * Returns the no data mask of \a rowCount rows from \a firstRow (all the rows by default),
+     * with one byte per pixel set to 1 for no data and 0 otherwise. The mask is computed for
+     * all the pixels at once, which is much faster than calling isNoData() for each one.
+     * \see apply()
+     * \note not available in Python bindings
+     * \since QGIS 3.16
+     */
+    QByteArray noDataMask( int firstRow = 0, int rowCount = -1 ) const;
+#endif
+
     /**
      * \brief Print double value with all necessary significant digits.
      *         It is ensured that conversion back to double gives the same number.
@@ -646,6 +749,12 @@ class CORE_EXPORT QgsRasterBlock
     int height() const { return mHeight; }
 
   private:
+#ifndef SIP_RUN
+    //! Returns the data type of the values of type T
+    template <typename T>
+    static Qgis::DataType dataTypeOf();
+#endif
+
     static QImage::Format imageFormat( Qgis::DataType dataType );
     static Qgis::DataType dataType( QImage::Format format );
 
@@ -733,6 +842,55 @@ class CORE_EXPORT QgsRasterBlock
     QgsError mError;
 };
 
+#ifndef SIP_RUN
+template <> inline Qgis::DataType QgsRasterBlock::dataTypeOf< quint8 >() { return Qgis::Byte; }
+template <> inline Qgis::DataType QgsRasterBlock::dataTypeOf< quint16 >() { return Qgis::UInt16; }
+template <> inline Qgis::DataType QgsRasterBlock::dataTypeOf< qint16 >() { return Qgis::Int16; }
+template <> inline Qgis::DataType QgsRasterBlock::dataTypeOf< quint32 >() { return Qgis::UInt32; }
+template <> inline Qgis::DataType QgsRasterBlock::dataTypeOf< qint32 >() { return Qgis::Int32; }
+template <> inline Qgis::DataType QgsRasterBlock::dataTypeOf< float >() { return Qgis::Float32; }
+template <> inline Qgis::DataType QgsRasterBlock::dataTypeOf< double >() { return Qgis::Float64; }
+
+template <typename Visitor>
+bool QgsRasterBlock::apply( Visitor &visitor, int firstRow, int rowCount ) const
+{
+  if ( rowCount < 0 )
+    rowCount = mHeight - firstRow;
+  if ( !mData || firstRow < 0 || rowCount < 0 || firstRow + rowCount > mHeight )
+    return false;
+
+  const qgssize offset = static_cast< qgssize >( firstRow ) * mWidth;
+  const qgssize count = static_cast< qgssize >( rowCount ) * mWidth;
+  switch ( mDataType )
+  {
+    case Qgis::Byte:
+      visitor( static_cast< const quint8 * >( mData ) + offset, count );
+      return true;
+    case Qgis::UInt16:
+      visitor( static_cast< const quint16 * >( mData ) + offset, count );
+      return true;
+    case Qgis::Int16:
+      visitor( static_cast< const qint16 * >( mData ) + offset, count );
+      return true;
+    case Qgis::UInt32:
+      visitor( static_cast< const quint32 * >( mData ) + offset, count );
+      return true;
+    case Qgis::Int32:
+      visitor( static_cast< const qint32 * >( mData ) + offset, count );
+      return true;
+    case Qgis::Float32:
+      visitor( static_cast< const float * >( mData ) + offset, count );
+      return true;
+    case Qgis::Float64:
+      visitor( static_cast< const double * >( mData ) + offset, count );
+      return true;
+    default:
+      break;
+  }
+  return false;
+}
+#endif
+
 inline double QgsRasterBlock::readValue( void *data, Qgis::DataType type, qgssize index ) SIP_SKIP
 {
   if ( !data )
@@ -30,11 +30,58 @@
 #include <QTextStream>
 #include <QMessageBox>
 
+#include <algorithm>
 #include <cmath>
 
 #include <gdal.h>
 #include <cpl_string.h>
 
+// value of the creation option \a name in \a options, or \a defaultValue if it is not set
+static QString creationOption( const QStringList &options, const QString &name, const QString &defaultValue = QString() )
+{
+  for ( const QString &option : options )
+  {
+    const int separator = option.indexOf( '=' );
+    if ( separator > 0 && option.left( separator ).compare( name, Qt::CaseInsensitive ) == 0 )
+      return option.mid( separator + 1 );
+  }
+  return defaultValue;
+}
+
+static bool isGeoTiff( const QString &providerKey, const QString &format )
+{
+  return providerKey == QLatin1String( "gdal" ) && format.compare( QLatin1String( "GTiff" ), Qt::CaseInsensitive ) == 0;
+}
+
+// creation options of a GeoTIFF output, with the compression of its blocks done by all the cores unless the options already set it
+static QStringList outputCreateOptions( const QString &providerKey, const QString &format, const QStringList &createOptions )
+{
+  QStringList options = createOptions;
+  if ( isGeoTiff( providerKey, format )
+       && creationOption( options, QStringLiteral( "COMPRESS" ), QStringLiteral( "NONE" ) ).compare( QLatin1String( "NONE" ), Qt::CaseInsensitive ) != 0
+       && creationOption( options, QStringLiteral( "NUM_THREADS" ) ).isEmpty() )
+  {
+    options << QStringLiteral( "NUM_THREADS=ALL_CPUS" );
+  }
+  return options;
+}
+
+// size of the parts read from the pipe, aligned on the blocks of a tiled GeoTIFF so that each block is
+// compressed once rather than read back and compressed again by each part overlapping it
+static int alignedPartSize( int maxPartSize, const QString &providerKey, const QString &format, const QStringList &createOptions, const QString &blockSizeOption )
+{
+  if ( !isGeoTiff( providerKey, format )
+       || creationOption( createOptions, QStringLiteral( "TILED" ), QStringLiteral( "NO" ) ).compare( QLatin1String( "YES" ), Qt::CaseInsensitive ) != 0 )
+    return maxPartSize;
+
+  bool ok = false;
+  const int blockSize = creationOption( createOptions, blockSizeOption, QStringLiteral( "256" ) ).toInt( &ok );
+  if ( !ok || blockSize <= 0 )
+    return maxPartSize;
+
+  return std::max( blockSize, maxPartSize / blockSize * blockSize );
+}
+
 QgsRasterDataProvider *QgsRasterFileWriter::createOneBandRaster( Qgis::DataType dataType, int width, int height, const QgsRectangle &extent, const QgsCoordinateReferenceSystem &crs )
 {
   if ( mTiledMode )
@@ -180,8 +227,16 @@ QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeDataRaster( const Qgs
     return SourceProviderError;
   }
 
-  iter->setMaximumTileWidth( mMaxTileWidth );
-  iter->setMaximumTileHeight( mMaxTileHeight );
+  if ( mTiledMode )
+  {
+    iter->setMaximumTileWidth( mMaxTileWidth );
+    iter->setMaximumTileHeight( mMaxTileHeight );
+  }
+  else
+  {
+    iter->setMaximumTileWidth( alignedPartSize( mMaxTileWidth, mOutputProviderKey, mOutputFormat, mCreateOptions, QStringLiteral( "BLOCKXSIZE" ) ) );
+    iter->setMaximumTileHeight( alignedPartSize( mMaxTileHeight, mOutputProviderKey, mOutputFormat, mCreateOptions, QStringLiteral( "BLOCKYSIZE" ) ) );
+  }
 
   int nBands = iface->bandCount();
   if ( nBands < 1 )
@@ -575,10 +630,12 @@ QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeImageRaster( QgsRaste
   }
   const bool isPremultiplied = ( inputDataType == Qgis::ARGB32_Premultiplied );
 
-  iter->setMaximumTileWidth( mMaxTileWidth );
-  iter->setMaximumTileHeight( mMaxTileHeight );
+  const int maxTileWidth = mTiledMode ? mMaxTileWidth : alignedPartSize( mMaxTileWidth, mOutputProviderKey, mOutputFormat, mCreateOptions, QStringLiteral( "BLOCKXSIZE" ) );
+  const int maxTileHeight = mTiledMode ? mMaxTileHeight : alignedPartSize( mMaxTileHeight, mOutputProviderKey, mOutputFormat, mCreateOptions, QStringLiteral( "BLOCKYSIZE" ) );
+  iter->setMaximumTileWidth( maxTileWidth );
+  iter->setMaximumTileHeight( maxTileHeight );
 
-  const size_t nMaxPixels = static_cast<size_t>( mMaxTileWidth ) * mMaxTileHeight;
+  const size_t nMaxPixels = static_cast<size_t>( maxTileWidth ) * maxTileHeight;
   std::vector<unsigned char> redData( nMaxPixels );
   std::vector<unsigned char> greenData( nMaxPixels );
   std::vector<unsigned char> blueData( nMaxPixels );
@@ -820,8 +877,13 @@ void QgsRasterFileWriter::buildPyramids( const QString &filename, QgsRasterDataP
 
   QgsDebugMsgLevel( QStringLiteral( "building pyramids : %1 pyramids, %2 resampling, %3 format, %4 options" ).arg( myPyramidList.count() ).arg( mPyramidsResampling ).arg( mPyramidsFormat ).arg( mPyramidsConfigOptions.count() ), 4 );
   // QApplication::setOverrideCursor( Qt::WaitCursor );
+  // overviews are computed and compressed by all the cores, unless the options already set it
+  QStringList configOptions = mPyramidsConfigOptions;
+  if ( creationOption( configOptions, QStringLiteral( "GDAL_NUM_THREADS" ) ).isEmpty() )
+    configOptions << QStringLiteral( "GDAL_NUM_THREADS=ALL_CPUS" );
+
   QString res = destProvider->buildPyramids( myPyramidList, mPyramidsResampling,
-                mPyramidsFormat, mPyramidsConfigOptions );
+                mPyramidsFormat, configOptions );
   // QApplication::restoreOverrideCursor();
 
   // TODO put this in provider or elsewhere
@@ -992,7 +1054,8 @@ QgsRasterDataProvider *QgsRasterFileWriter::createPartProvider( const QgsRectang
 
   // perhaps we need a separate createOptions for tiles ?
 
-  QgsRasterDataProvider *destProvider = QgsRasterDataProvider::create( mOutputProviderKey, outputFile, mOutputFormat, nBands, type, iterCols, iterRows, geoTransform, crs, mCreateOptions );
+  QgsRasterDataProvider *destProvider = QgsRasterDataProvider::create( mOutputProviderKey, outputFile, mOutputFormat, nBands, type, iterCols, iterRows, geoTransform, crs,
+                                        outputCreateOptions( mOutputProviderKey, mOutputFormat, mCreateOptions ) );
 
   // TODO: return provider and report error
   return destProvider;
@@ -1016,7 +1079,8 @@ QgsRasterDataProvider *QgsRasterFileWriter::initOutput( int nCols, int nRows, co
       mCreateOptions << "COPY_SRC_OVERVIEWS=YES";
 #endif
 
-    QgsRasterDataProvider *destProvider = QgsRasterDataProvider::create( mOutputProviderKey, mOutputUrl, mOutputFormat, nBands, type, nCols, nRows, geoTransform, crs, mCreateOptions );
+    QgsRasterDataProvider *destProvider = QgsRasterDataProvider::create( mOutputProviderKey, mOutputUrl, mOutputFormat, nBands, type, nCols, nRows, geoTransform, crs,
+                                          outputCreateOptions( mOutputProviderKey, mOutputFormat, mCreateOptions ) );
 
     if ( !destProvider )
     {
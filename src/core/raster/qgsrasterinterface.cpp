@@ -28,6 +28,199 @@
 #include "qgsrasterinterface.h"
 #include "qgsrectangle.h"
 
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+///@cond PRIVATE
+
+//! Statistics of some blocks of a band, which can be merged with the statistics of other blocks
+struct QgsRasterStatisticsAccumulator
+{
+  qgssize elementCount = 0;
+  double sum = 0;
+  double minimum = std::numeric_limits<double>::max();
+  double maximum = std::numeric_limits<double>::lowest();
+
+  // single pass stdev, of the finite values
+  qgssize finiteCount = 0;
+  double mean = 0;
+  double sumOfSquares = 0;
+
+  void add( const QgsRasterBlock &block )
+  {
+    bool isNoData = false;
+    for ( qgssize i = 0; i < static_cast< qgssize >( block.height() ) * block.width(); i++ )
+    {
+      const double value = block.valueAndNoData( i, isNoData );
+      if ( isNoData )
+        continue; // NULL
+
+      sum += value;
+      elementCount++;
+
+      if ( !std::isfinite( value ) ) continue; // inf
+
+      minimum = std::min( minimum, value );
+      maximum = std::max( maximum, value );
+
+      finiteCount++;
+      const double delta = value - mean;
+      mean += delta / finiteCount;
+      sumOfSquares += delta * ( value - mean );
+    }
+  }
+
+  void merge( const QgsRasterStatisticsAccumulator &other )
+  {
+    if ( other.finiteCount > 0 )
+    {
+      // parallel variant of the single pass stdev, Chan et al.
+      const double count = static_cast< double >( finiteCount + other.finiteCount );
+      const double delta = other.mean - mean;
+      mean += delta * other.finiteCount / count;
+      sumOfSquares += other.sumOfSquares + delta * delta * finiteCount * other.finiteCount / count;
+      finiteCount += other.finiteCount;
+      minimum = std::min( minimum, other.minimum );
+      maximum = std::max( maximum, other.maximum );
+    }
+    elementCount += other.elementCount;
+    sum += other.sum;
+  }
+};
+
+//! Histogram of some blocks of a band, which can be merged with the histogram of other blocks
+struct QgsRasterHistogramAccumulator
+{
+  double minimum = 0;
+  double binSize = 1;
+  int binCount = 0;
+  bool includeOutOfRange = false;
+  QgsRasterHistogram::HistogramVector counts;
+  int nonNullCount = 0;
+
+  void add( const QgsRasterBlock &block )
+  {
+    counts.fill( 0, binCount );
+    bool isNoData = false;
+    for ( qgssize i = 0; i < static_cast< qgssize >( block.height() ) * block.width(); i++ )
+    {
+      const double value = block.valueAndNoData( i, isNoData );
+      if ( isNoData )
+        continue; // NULL
+
+      int binIndex = static_cast <int>( std::floor( ( value - minimum ) / binSize ) );
+      if ( ( binIndex < 0 || binIndex > ( binCount - 1 ) ) && !includeOutOfRange )
+        continue;
+      binIndex = qBound( 0, binIndex, binCount - 1 );
+
+      counts[binIndex] += 1;
+      nonNullCount++;
+    }
+  }
+
+  void merge( const QgsRasterHistogramAccumulator &other )
+  {
+    if ( other.counts.isEmpty() )
+      return;
+    if ( counts.isEmpty() )
+      counts.fill( 0, binCount );
+    for ( int i = 0; i < binCount; ++i )
+      counts[i] += other.counts.at( i );
+    nonNullCount += other.nonNullCount;
+  }
+};
+
+//! Accumulates a block into a copy of an empty accumulator
+template <typename Accumulator>
+struct QgsRasterBlockReducer
+{
+  typedef Accumulator result_type;
+
+  Accumulator empty;
+
+  Accumulator operator()( const std::shared_ptr< QgsRasterBlock > &block ) const
+  {
+    Accumulator accumulator = empty;
+    if ( block )
+      accumulator.add( *block );
+    return accumulator;
+  }
+};
+
+///@endcond
+
+/**
+ * Accumulates into \a result the blocks of \a bandNo of \a interface in \a extent, sampled
+ * at \a width by \a height pixels. The blocks are read in order on the calling thread, as
+ * the interfaces are not thread-safe, and are accumulated in parallel by batches. The batch
+ * results are merged in order, so that the result does not depend on the thread count.
+ * Returns FALSE if canceled.
+ */
+template <typename Accumulator>
+static bool accumulateBlocks( QgsRasterInterface *interface, int bandNo, const QgsRectangle &extent, int width, int height,
+                              Accumulator &result, QgsRasterBlockFeedback *feedback )
+{
+  int xBlockSize = interface->xBlockSize();
+  int yBlockSize = interface->yBlockSize();
+  if ( xBlockSize == 0 ) // should not happen, but happens
+  {
+    xBlockSize = 500;
+  }
+  if ( yBlockSize == 0 ) // should not happen, but happens
+  {
+    yBlockSize = 500;
+  }
+
+  const int nXBlocks = ( width + xBlockSize - 1 ) / xBlockSize;
+  const int nYBlocks = ( height + yBlockSize - 1 ) / yBlockSize;
+
+  const double xRes = extent.width() / width;
+  const double yRes = extent.height() / height;
+
+  // a few blocks per thread, not to keep too many blocks in memory
+  const int batchSize = 2 * std::max( 1, QThreadPool::globalInstance()->maxThreadCount() );
+  const QgsRasterBlockReducer< Accumulator > reducer { result };
+  QVector< std::shared_ptr< QgsRasterBlock > > batch;
+  batch.reserve( batchSize );
+
+  auto reduceBatch = [&]
+  {
+    const QList< Accumulator > accumulators = QtConcurrent::blockingMapped< QList< Accumulator > >( batch, reducer );
+    for ( const Accumulator &accumulator : accumulators )
+      result.merge( accumulator );
+    batch.clear();
+  };
+
+  for ( int yBlock = 0; yBlock < nYBlocks; yBlock++ )
+  {
+    for ( int xBlock = 0; xBlock < nXBlocks; xBlock++ )
+    {
+      if ( feedback && feedback->isCanceled() )
+        return false;
+
+      QgsDebugMsgLevel( QStringLiteral( "myYBlock = %1 myXBlock = %2" ).arg( yBlock ).arg( xBlock ), 4 );
+      const int blockWidth = std::min( xBlockSize, width - xBlock * xBlockSize );
+      const int blockHeight = std::min( yBlockSize, height - yBlock * yBlockSize );
+
+      const double xmin = extent.xMinimum() + xBlock * xBlockSize * xRes;
+      const double xmax = xmin + blockWidth * xRes;
+      const double ymin = extent.yMaximum() - yBlock * yBlockSize * yRes;
+      const double ymax = ymin - blockHeight * yRes;
+
+      batch << std::shared_ptr< QgsRasterBlock >( interface->block( bandNo, QgsRectangle( xmin, ymin, xmax, ymax ), blockWidth, blockHeight, feedback ) );
+      if ( batch.size() == batchSize )
+        reduceBatch();
+    }
+  }
+  if ( !batch.isEmpty() )
+    reduceBatch();
+  return true;
+}
+
 QgsRasterInterface::QgsRasterInterface( QgsRasterInterface *input )
   : mInput( input )
 {
@@ -135,93 +328,18 @@ QgsRasterBandStats QgsRasterInterface::bandStatistics( int bandNo,
     }
   }
 
-  QgsRectangle myExtent = myRasterBandStats.extent;
-  int myWidth = myRasterBandStats.width;
-  int myHeight = myRasterBandStats.height;
-
-  //int myDataType = dataType( bandNo );
-
-  int myXBlockSize = xBlockSize();
-  int myYBlockSize = yBlockSize();
-  if ( myXBlockSize == 0 ) // should not happen, but happens
-  {
-    myXBlockSize = 500;
-  }
-  if ( myYBlockSize == 0 ) // should not happen, but happens
-  {
-    myYBlockSize = 500;
-  }
-
-  int myNXBlocks = ( myWidth + myXBlockSize - 1 ) / myXBlockSize;
-  int myNYBlocks = ( myHeight + myYBlockSize - 1 ) / myYBlockSize;
-
-  double myXRes = myExtent.width() / myWidth;
-  double myYRes = myExtent.height() / myHeight;
-  // TODO: progress signals
-
-  // used by single pass stdev
-  double myMean = 0;
-  double mySumOfSquares = 0;
+  QgsRasterStatisticsAccumulator accumulator;
+  if ( !accumulateBlocks( this, bandNo, myRasterBandStats.extent, myRasterBandStats.width, myRasterBandStats.height, accumulator, feedback ) )
+    return myRasterBandStats;
 
-  bool myFirstIterationFlag = true;
-  bool isNoData = false;
-  for ( int myYBlock = 0; myYBlock < myNYBlocks; myYBlock++ )
+  myRasterBandStats.elementCount = accumulator.elementCount;
+  myRasterBandStats.sum = accumulator.sum;
+  if ( accumulator.finiteCount > 0 )
   {
-    for ( int myXBlock = 0; myXBlock < myNXBlocks; myXBlock++ )
-    {
-      if ( feedback && feedback->isCanceled() )
-        return myRasterBandStats;
-
-      QgsDebugMsgLevel( QStringLiteral( "myYBlock = %1 myXBlock = %2" ).arg( myYBlock ).arg( myXBlock ), 4 );
-      int myBlockWidth = std::min( myXBlockSize, myWidth - myXBlock * myXBlockSize );
-      int myBlockHeight = std::min( myYBlockSize, myHeight - myYBlock * myYBlockSize );
-
-      double xmin = myExtent.xMinimum() + myXBlock * myXBlockSize * myXRes;
-      double xmax = xmin + myBlockWidth * myXRes;
-      double ymin = myExtent.yMaximum() - myYBlock * myYBlockSize * myYRes;
-      double ymax = ymin - myBlockHeight * myYRes;
-
-      QgsRectangle myPartExtent( xmin, ymin, xmax, ymax );
-
-      std::unique_ptr< QgsRasterBlock > blk( block( bandNo, myPartExtent, myBlockWidth, myBlockHeight, feedback ) );
-
-      // Collect the histogram counts.
-      for ( qgssize i = 0; i < ( static_cast< qgssize >( myBlockHeight ) ) * myBlockWidth; i++ )
-      {
-        double myValue = blk->valueAndNoData( i, isNoData );
-        if ( isNoData )
-          continue; // NULL
-
-        myRasterBandStats.sum += myValue;
-        myRasterBandStats.elementCount++;
-
-        if ( !std::isfinite( myValue ) ) continue; // inf
-
-        if ( myFirstIterationFlag )
-        {
-          myFirstIterationFlag = false;
-          myRasterBandStats.minimumValue = myValue;
-          myRasterBandStats.maximumValue = myValue;
-        }
-        else
-        {
-          if ( myValue < myRasterBandStats.minimumValue )
-          {
-            myRasterBandStats.minimumValue = myValue;
-          }
-          if ( myValue > myRasterBandStats.maximumValue )
-          {
-            myRasterBandStats.maximumValue = myValue;
-          }
-        }
-
-        // Single pass stdev
-        double myDelta = myValue - myMean;
-        myMean += myDelta / myRasterBandStats.elementCount;
-        mySumOfSquares += myDelta * ( myValue - myMean );
-      }
-    }
+    myRasterBandStats.minimumValue = accumulator.minimum;
+    myRasterBandStats.maximumValue = accumulator.maximum;
   }
+  const double mySumOfSquares = accumulator.sumOfSquares;
 
   myRasterBandStats.range = myRasterBandStats.maximumValue - myRasterBandStats.minimumValue;
   myRasterBandStats.mean = myRasterBandStats.sum / myRasterBandStats.elementCount;
@@ -424,28 +542,7 @@ QgsRasterHistogram QgsRasterInterface::histogram( int bandNo,
     }
   }
 
-  int myBinCount = myHistogram.binCount;
-  int myWidth = myHistogram.width;
-  int myHeight = myHistogram.height;
-  QgsRectangle myExtent = myHistogram.extent;
-  myHistogram.histogramVector.resize( myBinCount );
-
-  int myXBlockSize = xBlockSize();
-  int myYBlockSize = yBlockSize();
-  if ( myXBlockSize == 0 ) // should not happen, but happens
-  {
-    myXBlockSize = 500;
-  }
-  if ( myYBlockSize == 0 ) // should not happen, but happens
-  {
-    myYBlockSize = 500;
-  }
-
-  int myNXBlocks = ( myWidth + myXBlockSize - 1 ) / myXBlockSize;
-  int myNYBlocks = ( myHeight + myYBlockSize - 1 ) / myYBlockSize;
-
-  double myXRes = myExtent.width() / myWidth;
-  double myYRes = myExtent.height() / myHeight;
+  const int myBinCount = myHistogram.binCount;
 
   double myMinimum = myHistogram.minimum;
   double myMaximum = myHistogram.maximum;
@@ -458,52 +555,19 @@ QgsRasterHistogram QgsRasterInterface::histogram( int bandNo,
 
   QgsDebugMsgLevel( QStringLiteral( "binCount = %1 myMinimum = %2 myMaximum = %3" ).arg( myHistogram.binCount ).arg( myMinimum ).arg( myMaximum ), 4 );
 
-  double myBinSize = ( myMaximum - myMinimum ) / myBinCount;
+  QgsRasterHistogramAccumulator accumulator;
+  accumulator.minimum = myMinimum;
+  accumulator.binSize = ( myMaximum - myMinimum ) / myBinCount;
+  accumulator.binCount = myBinCount;
+  accumulator.includeOutOfRange = includeOutOfRange;
+  accumulator.counts.fill( 0, myBinCount );
 
   // TODO: progress signals
-  bool isNoData = false;
-  for ( int myYBlock = 0; myYBlock < myNYBlocks; myYBlock++ )
-  {
-    for ( int myXBlock = 0; myXBlock < myNXBlocks; myXBlock++ )
-    {
-      if ( feedback && feedback->isCanceled() )
-        return myHistogram;
-
-      int myBlockWidth = std::min( myXBlockSize, myWidth - myXBlock * myXBlockSize );
-      int myBlockHeight = std::min( myYBlockSize, myHeight - myYBlock * myYBlockSize );
-
-      double xmin = myExtent.xMinimum() + myXBlock * myXBlockSize * myXRes;
-      double xmax = xmin + myBlockWidth * myXRes;
-      double ymin = myExtent.yMaximum() - myYBlock * myYBlockSize * myYRes;
-      double ymax = ymin - myBlockHeight * myYRes;
-
-      QgsRectangle myPartExtent( xmin, ymin, xmax, ymax );
-
-      std::unique_ptr< QgsRasterBlock > blk( block( bandNo, myPartExtent, myBlockWidth, myBlockHeight, feedback ) );
-
-      // Collect the histogram counts.
-      for ( qgssize i = 0; i < ( static_cast< qgssize >( myBlockHeight ) ) * myBlockWidth; i++ )
-      {
-        double myValue = blk->valueAndNoData( i, isNoData );
-        if ( isNoData )
-        {
-          continue; // NULL
-        }
-
-        int myBinIndex = static_cast <int>( std::floor( ( myValue - myMinimum ) /  myBinSize ) );
-
-        if ( ( myBinIndex < 0 || myBinIndex > ( myBinCount - 1 ) ) && !includeOutOfRange )
-        {
-          continue;
-        }
-        if ( myBinIndex < 0 ) myBinIndex = 0;
-        if ( myBinIndex > ( myBinCount - 1 ) ) myBinIndex = myBinCount - 1;
-
-        myHistogram.histogramVector[myBinIndex] += 1;
-        myHistogram.nonNullCount++;
-      }
-    }
-  }
+  const bool completed = accumulateBlocks( this, bandNo, myHistogram.extent, myHistogram.width, myHistogram.height, accumulator, feedback );
+  myHistogram.histogramVector = accumulator.counts;
+  myHistogram.nonNullCount = accumulator.nonNullCount;
+  if ( !completed )
+    return myHistogram;
 
   myHistogram.valid = true;
   mHistograms.append( myHistogram );
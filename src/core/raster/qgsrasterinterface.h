@@ -76,6 +76,21 @@ class CORE_EXPORT QgsRasterBlockFeedback : public QgsFeedback
      */
     void setRenderPartialOutput( bool enable ) { mRenderPartialOutput = enable; }
 
+    /**
+     * Whether the provider may request the tiles around the rendered extent in the background,
+     * for when the map is panned. Only enabled for the renders of an interactive map canvas.
+     * \see setPrefetchTiles()
+     * \since QGIS 3.16
+     */
+    bool prefetchTiles() const { return mPrefetchTiles; }
+
+    /**
+     * Sets whether the provider may request the tiles around the rendered extent in the background.
+     * \see prefetchTiles()
+     * \since QGIS 3.16
+     */
+    void setPrefetchTiles( bool enable ) { mPrefetchTiles = enable; }
+
     /**
      * Appends an error message to the stored list of errors. Should be called
      * whenever an error is encountered while retrieving a raster block.
@@ -104,6 +119,9 @@ class CORE_EXPORT QgsRasterBlockFeedback : public QgsFeedback
     //! Whether our painter is drawing to a temporary image used just by this layer
     bool mRenderPartialOutput = false;
 
+    //! Whether the provider may prefetch the tiles around the rendered extent
+    bool mPrefetchTiles = false;
+
     //! List of errors encountered while retrieving block
     QStringList mErrors;
 };
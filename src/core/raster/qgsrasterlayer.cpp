@@ -55,6 +55,7 @@ email                : tim at linfiniti.com
 #include "qgscubicrasterresampler.h"
 #include "qgsrasterlayertemporalproperties.h"
 #include "qgsruntimeprofiler.h"
+#include "qgsxmlutils.h"
 
 #include <cmath>
 #include <cstdio>
@@ -1958,6 +1959,13 @@ bool QgsRasterLayer::readXml( const QDomNode &layer_node, QgsReadWriteContext &c
     {
       QgsDebugMsg( QStringLiteral( "Raster data provider could not be created for %1" ).arg( mDataSource ) );
     }
+    else
+    {
+      // keep the stored extent, e.g. to describe the layer before its data provider is created
+      const QDomNode extentNode = layer_node.namedItem( QStringLiteral( "extent" ) );
+      if ( !extentNode.isNull() )
+        setExtent( QgsXmlUtils::readRectangle( extentNode.toElement() ) );
+    }
     return false;
   }
 
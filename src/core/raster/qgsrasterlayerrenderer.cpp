@@ -26,14 +26,33 @@
 #include "qgsexception.h"
 #include "qgsrasterlayertemporalproperties.h"
 #include "qgsmapclippingutils.h"
+#include "qgsrasterviewport.h"
+
+#include <QImage>
+#include <QPainter>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
+#include <memory>
+#include <vector>
 
 ///@cond PRIVATE
 
+//! Horizontal band of the viewport of a raster layer, drawn with its own copy of the pipe
+struct QgsRasterLayerRenderBand
+{
+  QgsRasterViewPort viewPort;
+  std::unique_ptr< QgsRasterPipe > pipe;
+  std::unique_ptr< QgsRasterBlockFeedback > feedback;
+  QImage image;
+};
+
 QgsRasterLayerRendererFeedback::QgsRasterLayerRendererFeedback( QgsRasterLayerRenderer *r )
   : mR( r )
   , mMinimalPreviewInterval( 250 )
 {
   setRenderPartialOutput( r->renderContext()->testFlag( QgsRenderContext::RenderPartialOutput ) );
+  setPrefetchTiles( r->renderContext()->testFlag( QgsRenderContext::PrefetchTiles ) );
 }
 
 void QgsRasterLayerRendererFeedback::onNewData()
@@ -313,10 +332,18 @@ bool QgsRasterLayerRenderer::render()
     projector->setCrs( mRasterViewPort->mSrcCRS, mRasterViewPort->mDestCRS, mRasterViewPort->mTransformContext );
   }
 
-  // Drawer to pipe?
-  QgsRasterIterator iterator( mPipe->last() );
-  QgsRasterDrawer drawer( &iterator );
-  drawer.draw( renderContext()->painter(), mRasterViewPort, &renderContext()->mapToPixel(), mFeedback );
+  const int bandCount = parallelRenderingBandCount();
+  if ( bandCount > 1 )
+  {
+    drawParallel( bandCount );
+  }
+  else
+  {
+    // Drawer to pipe?
+    QgsRasterIterator iterator( mPipe->last() );
+    QgsRasterDrawer drawer( &iterator );
+    drawer.draw( renderContext()->painter(), mRasterViewPort, &renderContext()->mapToPixel(), mFeedback );
+  }
 
   if ( restoreOldResamplingStage )
   {
@@ -339,3 +366,83 @@ QgsFeedback *QgsRasterLayerRenderer::feedback() const
   return mFeedback;
 }
 
+int QgsRasterLayerRenderer::parallelRenderingBandCount()
+{
+  QgsRenderContext &context = *renderContext();
+  if ( !context.testFlag( QgsRenderContext::ParallelRasterRendering ) )
+    return 1;
+
+  // remote providers already fetch their tiles in parallel, and report them for previews
+  if ( mProviderCapabilities & QgsRasterInterface::Capability::Prefetch )
+    return 1;
+
+  // the bands are composed without the rotation applied by QgsRasterDrawer
+  if ( !qgsDoubleNear( context.mapToPixel().mapRotation(), 0.0 ) )
+    return 1;
+
+  QImage *image = context.painter() ? dynamic_cast< QImage * >( context.painter()->device() ) : nullptr;
+  if ( !image || !context.painter()->transform().isIdentity() || !qgsDoubleNear( image->devicePixelRatioF(), 1.0 ) )
+    return 1;
+
+  return static_cast< int >( std::min( static_cast< qgssize >( QThreadPool::globalInstance()->maxThreadCount() ), mRasterViewPort->mHeight / MIN_BAND_HEIGHT ) );
+}
+
+void QgsRasterLayerRenderer::drawParallel( int bandCount )
+{
+  QgsRenderContext &context = *renderContext();
+  const QImage *destination = static_cast< QImage * >( context.painter()->device() );
+  const QgsRectangle extent = mRasterViewPort->mDrawnExtent;
+  const qgssize height = mRasterViewPort->mHeight;
+  const double rowHeight = extent.height() / height;
+
+  // the pipes are copied in this thread, their interfaces and providers are then only used by one band
+  std::vector< QgsRasterLayerRenderBand > bands( bandCount );
+  for ( int i = 0; i < bandCount; ++i )
+  {
+    const qgssize top = height * i / bandCount;
+    const qgssize bottom = height * ( i + 1 ) / bandCount;
+
+    QgsRasterLayerRenderBand &band = bands[ i ];
+    band.viewPort = *mRasterViewPort;
+    band.viewPort.mTopLeftPoint.setY( mRasterViewPort->mTopLeftPoint.y() + top );
+    band.viewPort.mBottomRightPoint.setY( mRasterViewPort->mTopLeftPoint.y() + bottom );
+    band.viewPort.mHeight = bottom - top;
+    band.viewPort.mDrawnExtent = QgsRectangle( extent.xMinimum(), extent.yMaximum() - bottom * rowHeight,
+                                 extent.xMaximum(), extent.yMaximum() - top * rowHeight );
+    band.pipe.reset( new QgsRasterPipe( *mPipe ) );
+    band.feedback = qgis::make_unique< QgsRasterBlockFeedback >();
+    QObject::connect( mFeedback, &QgsFeedback::canceled, band.feedback.get(), &QgsFeedback::cancel, Qt::DirectConnection );
+    band.image = QImage( static_cast< int >( band.viewPort.mWidth ), static_cast< int >( band.viewPort.mHeight ), QImage::Format_ARGB32_Premultiplied );
+    band.image.setDotsPerMeterX( destination->dotsPerMeterX() );
+    band.image.setDotsPerMeterY( destination->dotsPerMeterY() );
+    band.image.fill( Qt::transparent );
+  }
+
+  const QgsMapToPixel &mapToPixel = context.mapToPixel();
+  QtConcurrent::blockingMap( bands, [&mapToPixel]( QgsRasterLayerRenderBand & band )
+  {
+    QPainter painter( &band.image );
+    // same painter coordinates as the destination image
+    painter.translate( -band.viewPort.mTopLeftPoint.x(), -band.viewPort.mTopLeftPoint.y() );
+    QgsRasterIterator iterator( band.pipe->last() );
+    QgsRasterDrawer drawer( &iterator );
+    drawer.draw( &painter, &band.viewPort, &mapToPixel, band.feedback.get() );
+  } );
+
+  if ( mFeedback->isCanceled() )
+    return;
+
+  // there could have been partial previews drawn before, see QgsRasterDrawer::draw()
+  if ( mFeedback->renderPartialOutput() )
+    context.painter()->setCompositionMode( QPainter::CompositionMode_Source );
+
+  // the bands do not overlap
+  for ( const QgsRasterLayerRenderBand &band : bands )
+  {
+    context.painter()->drawImage( QPointF( band.viewPort.mTopLeftPoint.x(), band.viewPort.mTopLeftPoint.y() ), band.image );
+    mErrors << band.feedback->errors();
+  }
+
+  context.painter()->setCompositionMode( QPainter::CompositionMode_SourceOver );
+}
+
@@ -78,6 +78,22 @@ class CORE_EXPORT QgsRasterLayerRenderer : public QgsMapLayerRenderer
 
   private:
 
+    //! Minimum height (in pixels) of the bands drawn in parallel, each one pays a copy of the pipe
+    static const int MIN_BAND_HEIGHT = 256;
+
+    /**
+     * Returns the number of horizontal bands of the viewport which can be drawn in
+     * parallel, or 1 if the layer has to be drawn in the calling thread.
+     */
+    int parallelRenderingBandCount();
+
+    /**
+     * Draws the viewport in \a bandCount horizontal bands rendered in parallel, each one
+     * by its own copy of the pipe and of the data provider, then composes them on the
+     * destination painter.
+     */
+    void drawParallel( int bandCount );
+
     QgsRasterViewPort *mRasterViewPort = nullptr;
 
     QgsRasterPipe *mPipe = nullptr;
@@ -23,6 +23,7 @@
 #include <QImage>
 #include <QColor>
 #include <memory>
+#include <vector>
 
 QgsSingleBandGrayRenderer::QgsSingleBandGrayRenderer( QgsRasterInterface *input, int grayBand )
   : QgsRasterRenderer( input, QStringLiteral( "singlebandgray" ) )
@@ -116,38 +117,53 @@ QgsRasterBlock *QgsSingleBandGrayRenderer::block( int bandNo, const QgsRectangle
     return outputBlock.release();
   }
 
+  const qgssize count = static_cast< qgssize >( width ) * height;
+
+  // the contrast enhancement of the whole block is computed at once
+  std::vector< int > enhancedValues;
+  if ( mContrastEnhancement )
+  {
+    enhancedValues.assign( count, -1 );
+    if ( inputBlock->width() == width && inputBlock->height() == height )
+      mContrastEnhancement->enhanceBlock( *inputBlock, enhancedValues.data() );
+  }
+
   const QRgb myDefaultColor = renderColorForNodataPixel();
   bool isNoData = false;
-  for ( qgssize i = 0; i < ( qgssize )width * height; i++ )
+  for ( qgssize i = 0; i < count; i++ )
   {
-    double grayVal = inputBlock->valueAndNoData( i, isNoData );
-
-    if ( isNoData )
+    double grayVal = 0;
+    if ( mContrastEnhancement )
+    {
+      // no data and values outside of the displayable range are both negative
+      if ( enhancedValues[i] < 0 )
+      {
+        outputBlock->setColor( i, myDefaultColor );
+        continue;
+      }
+      grayVal = enhancedValues[i];
+    }
+    else
     {
-      outputBlock->setColor( i, myDefaultColor );
-      continue;
+      grayVal = inputBlock->valueAndNoData( i, isNoData );
+      if ( isNoData )
+      {
+        outputBlock->setColor( i, myDefaultColor );
+        continue;
+      }
     }
 
     double currentAlpha = mOpacity;
     if ( mRasterTransparency )
     {
-      currentAlpha = mRasterTransparency->alphaValue( grayVal, mOpacity * 255 ) / 255.0;
+      // the transparency applies to the raw value
+      currentAlpha = mRasterTransparency->alphaValue( mContrastEnhancement ? inputBlock->value( i ) : grayVal, mOpacity * 255 ) / 255.0;
     }
     if ( mAlphaBand > 0 )
     {
       currentAlpha *= alphaBlock->value( i ) / 255.0;
     }
 
-    if ( mContrastEnhancement )
-    {
-      if ( !mContrastEnhancement->isValueInDisplayableRange( grayVal ) )
-      {
-        outputBlock->setColor( i, myDefaultColor );
-        continue;
-      }
-      grayVal = mContrastEnhancement->enhanceContrast( grayVal );
-    }
-
     if ( mGradient == WhiteToBlack )
     {
       grayVal = 255 - grayVal;
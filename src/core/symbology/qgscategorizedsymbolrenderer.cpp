@@ -184,6 +184,20 @@ QgsCategorizedSymbolRenderer::~QgsCategorizedSymbolRenderer() = default;
 void QgsCategorizedSymbolRenderer::rebuildHash()
 {
   mSymbolHash.clear();
+  mIntegerSymbolHash.clear();
+
+  auto insertValue = [this]( const QVariant & value, QgsSymbol * symbol )
+  {
+    const QString key = value.toString();
+    mSymbolHash.insert( key, symbol );
+
+    // integer feature values are looked up without converting them to strings, which
+    // only match the category values written as canonical integers
+    bool ok = false;
+    const qlonglong integer = key.toLongLong( &ok );
+    if ( ok && QString::number( integer ) == key )
+      mIntegerSymbolHash.insert( integer, symbol );
+  };
 
   for ( const QgsRendererCategory &cat : qgis::as_const( mCategories ) )
   {
@@ -193,12 +207,12 @@ void QgsCategorizedSymbolRenderer::rebuildHash()
       const QVariantList list = val.toList();
       for ( const QVariant &v : list )
       {
-        mSymbolHash.insert( v.toString(), ( cat.renderState() || mCounting ) ? cat.symbol() : nullptr );
+        insertValue( v, ( cat.renderState() || mCounting ) ? cat.symbol() : nullptr );
       }
     }
     else
     {
-      mSymbolHash.insert( val.toString(), ( cat.renderState() || mCounting ) ? cat.symbol() : nullptr );
+      insertValue( val, ( cat.renderState() || mCounting ) ? cat.symbol() : nullptr );
     }
   }
 }
@@ -218,7 +232,30 @@ QgsSymbol *QgsCategorizedSymbolRenderer::symbolForValue( const QVariant &value,
 {
   foundMatchingSymbol = false;
 
-  // TODO: special case for int, double
+  switch ( value.type() )
+  {
+    case QVariant::Int:
+    case QVariant::LongLong:
+    case QVariant::UInt:
+    {
+      if ( value.isNull() )
+        break;
+
+      QHash<qlonglong, QgsSymbol *>::const_iterator integerIt = mIntegerSymbolHash.constFind( value.toLongLong() );
+      if ( integerIt == mIntegerSymbolHash.constEnd() )
+      {
+        QgsDebugMsgLevel( "attribute value not found: " + value.toString(), 3 );
+        return nullptr;
+      }
+
+      foundMatchingSymbol = true;
+      return *integerIt;
+    }
+
+    default:
+      break;
+  }
+
   QHash<QString, QgsSymbol *>::const_iterator it = mSymbolHash.constFind( value.isNull() ? QString() : value.toString() );
   if ( it == mSymbolHash.constEnd() )
   {
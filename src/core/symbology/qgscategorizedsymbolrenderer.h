@@ -451,6 +451,10 @@ class CORE_EXPORT QgsCategorizedSymbolRenderer : public QgsFeatureRenderer
 
     //! hashtable for faster access to symbols
     QHash<QString, QgsSymbol *> mSymbolHash;
+#ifndef SIP_RUN
+    //! hashtable of the symbols of the integer category values, for integer feature values
+    QHash<qlonglong, QgsSymbol *> mIntegerSymbolHash;
+#endif
     bool mCounting = false;
 
     void rebuildHash();
@@ -31,6 +31,16 @@
 
 #include <QDomDocument>
 #include <QDomElement>
+#include <QThread>
+#include <QtConcurrentMap>
+
+#include <numeric>
+
+// number of points added to the heatmap at once
+static const std::size_t POINT_BATCH_SIZE = 100000;
+// minimum number of points and grid cells for adding the points in parallel
+static const std::size_t PARALLEL_MINIMUM_POINTS = 1000;
+static const int PARALLEL_MINIMUM_CELLS = 100000;
 
 QgsHeatmapRenderer::QgsHeatmapRenderer()
   : QgsFeatureRenderer( QStringLiteral( "heatmapRenderer" ) )
@@ -47,10 +57,35 @@ void QgsHeatmapRenderer::initializeValues( QgsRenderContext &context )
 {
   mValues.resize( context.painter()->device()->width() * context.painter()->device()->height() / ( mRenderQuality * mRenderQuality ) );
   mValues.fill( 0 );
+  mGridWidth = context.painter()->device()->width() / mRenderQuality;
+  mGridHeight = context.painter()->device()->height() / mRenderQuality;
   mCalculatedMaxValue = 0;
   mFeaturesRendered = 0;
   mRadiusPixels = std::round( context.convertToPainterUnits( mRadius, mRadiusUnit, mRadiusMapUnitScale ) / mRenderQuality );
   mRadiusSquared = mRadiusPixels * mRadiusPixels;
+  mPendingPoints.clear();
+
+  // the kernel is evaluated once for all the cells around a point, the points within the radius
+  // of each row are contiguous
+  const int stampSize = 2 * std::max( mRadiusPixels, 0 );
+  mKernelValues.assign( static_cast< std::size_t >( stampSize ) * stampSize, 0 );
+  mKernelSpans.assign( stampSize, std::make_pair( 0, 0 ) );
+  for ( int dy = -mRadiusPixels; dy < mRadiusPixels; ++dy )
+  {
+    int first = mRadiusPixels;
+    int last = -mRadiusPixels - 1;
+    for ( int dx = -mRadiusPixels; dx < mRadiusPixels; ++dx )
+    {
+      const double distanceSquared = static_cast< double >( dx ) * dx + static_cast< double >( dy ) * dy;
+      if ( distanceSquared > mRadiusSquared )
+        continue;
+
+      mKernelValues[ static_cast< std::size_t >( dy + mRadiusPixels ) * stampSize + dx + mRadiusPixels ] = quarticKernel( std::sqrt( distanceSquared ), mRadiusPixels );
+      first = std::min( first, dx );
+      last = std::max( last, dx );
+    }
+    mKernelSpans[ dy + mRadiusPixels ] = std::make_pair( first, last + 1 );
+  }
 }
 
 void QgsHeatmapRenderer::startRender( QgsRenderContext &context, const QgsFields &fields )
@@ -127,9 +162,6 @@ bool QgsHeatmapRenderer::renderFeature( const QgsFeature &feature, QgsRenderCont
     }
   }
 
-  int width = context.painter()->device()->width() / mRenderQuality;
-  int height = context.painter()->device()->height() / mRenderQuality;
-
   //transform geometry if required
   QgsGeometry geom = feature.geometry();
   QgsCoordinateTransform xform = context.coordinateTransform();
@@ -141,41 +173,20 @@ bool QgsHeatmapRenderer::renderFeature( const QgsFeature &feature, QgsRenderCont
   //convert point to multipoint
   QgsMultiPointXY multiPoint = convertToMultipoint( &geom );
 
-  //loop through all points in multipoint
+  //loop through all points in multipoint, the points are added to the heatmap by batches
   for ( QgsMultiPointXY::const_iterator pointIt = multiPoint.constBegin(); pointIt != multiPoint.constEnd(); ++pointIt )
   {
     QgsPointXY pixel = context.mapToPixel().transform( *pointIt );
-    int pointX = pixel.x() / mRenderQuality;
-    int pointY = pixel.y() / mRenderQuality;
-    for ( int x = std::max( pointX - mRadiusPixels, 0 ); x < std::min( pointX + mRadiusPixels, width ); ++x )
-    {
-      if ( context.renderingStopped() )
-        break;
-
-      for ( int y = std::max( pointY - mRadiusPixels, 0 ); y < std::min( pointY + mRadiusPixels, height ); ++y )
-      {
-        int index = y * width + x;
-        if ( index >= mValues.count() )
-        {
-          continue;
-        }
-        double distanceSquared = std::pow( pointX - x, 2.0 ) + std::pow( pointY - y, 2.0 );
-        if ( distanceSquared > mRadiusSquared )
-        {
-          continue;
-        }
-
-        double score = weight * quarticKernel( std::sqrt( distanceSquared ), mRadiusPixels );
-        double value = mValues.at( index ) + score;
-        if ( value > mCalculatedMaxValue )
-        {
-          mCalculatedMaxValue = value;
-        }
-        mValues[ index ] = value;
-      }
-    }
+    PendingPoint point;
+    point.x = pixel.x() / mRenderQuality;
+    point.y = pixel.y() / mRenderQuality;
+    point.weight = weight;
+    mPendingPoints.push_back( point );
   }
 
+  if ( mPendingPoints.size() >= POINT_BATCH_SIZE )
+    addPendingPoints( context );
+
   mFeaturesRendered++;
 #if 0
   //TODO - enable progressive rendering
@@ -215,10 +226,87 @@ double QgsHeatmapRenderer::triangularKernel( const double distance, const int ba
   return ( 1. - ( distance / static_cast< double >( bandwidth ) ) );
 }
 
+void QgsHeatmapRenderer::addPendingPoints( QgsRenderContext &context )
+{
+  if ( mPendingPoints.empty() || mValues.isEmpty() || mGridWidth <= 0 || mGridHeight <= 0 )
+  {
+    mPendingPoints.clear();
+    return;
+  }
+
+  // the grid is split in bands of rows, each band adds the points near its rows in their
+  // original order so that the values do not depend on the number of threads
+  const bool parallel = mPendingPoints.size() >= PARALLEL_MINIMUM_POINTS && mGridWidth * mGridHeight >= PARALLEL_MINIMUM_CELLS;
+  const int bandCount = parallel ? std::max( 1, std::min( mGridHeight, QThread::idealThreadCount() * 4 ) ) : 1;
+  const int bandRows = ( mGridHeight + bandCount - 1 ) / bandCount;
+
+  std::vector< std::vector< int > > bandPoints( bandCount );
+  for ( int i = 0; i < static_cast< int >( mPendingPoints.size() ); ++i )
+  {
+    const PendingPoint &point = mPendingPoints[ i ];
+    const int firstRow = std::max( point.y - mRadiusPixels, 0 );
+    const int lastRow = std::min( point.y + mRadiusPixels, mGridHeight ) - 1;
+    if ( firstRow > lastRow || point.x + mRadiusPixels <= 0 || point.x - mRadiusPixels >= mGridWidth )
+      continue;
+
+    for ( int band = firstRow / bandRows; band <= lastRow / bandRows; ++band )
+      bandPoints[ band ].push_back( i );
+  }
+
+  double *values = mValues.data();
+  const int stampSize = 2 * mRadiusPixels;
+  auto addBandPoints = [this, &context, &bandPoints, values, bandRows, stampSize]( int band )
+  {
+    const int bandFirstRow = band * bandRows;
+    const int bandEndRow = std::min( bandFirstRow + bandRows, mGridHeight );
+    int count = 0;
+    for ( int index : bandPoints[ band ] )
+    {
+      if ( ++count % 1000 == 0 && context.renderingStopped() )
+        break;
+
+      const PendingPoint &point = mPendingPoints[ index ];
+      const int endRow = std::min( point.y + mRadiusPixels, bandEndRow );
+      for ( int y = std::max( point.y - mRadiusPixels, bandFirstRow ); y < endRow; ++y )
+      {
+        const int kernelRow = y - point.y + mRadiusPixels;
+        const std::pair< int, int > &span = mKernelSpans[ kernelRow ];
+        const int firstColumn = std::max( point.x + span.first, 0 );
+        const int endColumn = std::min( point.x + span.second, mGridWidth );
+
+        // contiguous cells and kernel values, vectorized by the compiler
+        double *cells = values + static_cast< std::size_t >( y ) * mGridWidth + firstColumn;
+        const double *kernel = mKernelValues.data() + static_cast< std::size_t >( kernelRow ) * stampSize + mRadiusPixels + firstColumn - point.x;
+        const double weight = point.weight;
+        for ( int i = 0; i < endColumn - firstColumn; ++i )
+          cells[ i ] += weight * kernel[ i ];
+      }
+    }
+  };
+
+  if ( bandCount == 1 )
+  {
+    addBandPoints( 0 );
+  }
+  else
+  {
+    std::vector< int > bands( bandCount );
+    std::iota( bands.begin(), bands.end(), 0 );
+    QtConcurrent::blockingMap( bands, addBandPoints );
+  }
+
+  mPendingPoints.clear();
+}
+
 void QgsHeatmapRenderer::stopRender( QgsRenderContext &context )
 {
   QgsFeatureRenderer::stopRender( context );
 
+  addPendingPoints( context );
+  mCalculatedMaxValue = 0;
+  for ( double value : qgis::as_const( mValues ) )
+    mCalculatedMaxValue = std::max( mCalculatedMaxValue, value );
+
   renderImage( context );
   mWeightExpression.reset();
 }
@@ -237,26 +325,44 @@ void QgsHeatmapRenderer::renderImage( QgsRenderContext &context )
 
   double scaleMax = mExplicitMax > 0 ? mExplicitMax : mCalculatedMaxValue;
 
-  int idx = 0;
-  double pixVal = 0;
-  QColor pixColor;
-  for ( int heightIndex = 0; heightIndex < image.height(); ++heightIndex )
+  // the rows are colored by blocks, each with its own copy of the ramp
+  auto colorRows = [this, &context, &image, scaleMax]( const std::pair< int, int > &rows )
   {
-    if ( context.renderingStopped() )
-      break;
-
-    QRgb *scanLine = reinterpret_cast< QRgb * >( image.scanLine( heightIndex ) );
-    for ( int widthIndex = 0; widthIndex < image.width(); ++widthIndex )
+    std::unique_ptr< QgsColorRamp > ramp( mGradientRamp->clone() );
+    double pixVal = 0;
+    QColor pixColor;
+    for ( int heightIndex = rows.first; heightIndex < rows.second; ++heightIndex )
     {
-      //scale result to fit in the range [0, 1]
-      pixVal = mValues.at( idx ) > 0 ? std::min( ( mValues.at( idx ) / scaleMax ), 1.0 ) : 0;
+      if ( context.renderingStopped() )
+        break;
+
+      int idx = heightIndex * image.width();
+      QRgb *scanLine = reinterpret_cast< QRgb * >( image.scanLine( heightIndex ) );
+      for ( int widthIndex = 0; widthIndex < image.width(); ++widthIndex )
+      {
+        //scale result to fit in the range [0, 1]
+        pixVal = mValues.at( idx ) > 0 ? std::min( ( mValues.at( idx ) / scaleMax ), 1.0 ) : 0;
 
-      //convert value to color from ramp
-      pixColor = mGradientRamp->color( pixVal );
+        //convert value to color from ramp
+        pixColor = ramp->color( pixVal );
 
-      scanLine[widthIndex] = pixColor.rgba();
-      idx++;
+        scanLine[widthIndex] = pixColor.rgba();
+        idx++;
+      }
     }
+  };
+
+  if ( image.width() * image.height() < PARALLEL_MINIMUM_CELLS )
+  {
+    colorRows( std::make_pair( 0, image.height() ) );
+  }
+  else
+  {
+    std::vector< std::pair< int, int > > blocks;
+    const int blockRows = std::max( 1, image.height() / ( QThread::idealThreadCount() * 4 ) );
+    for ( int row = 0; row < image.height(); row += blockRows )
+      blocks.emplace_back( row, std::min( row + blockRows, image.height() ) );
+    QtConcurrent::blockingMap( blocks, colorRows );
   }
 
   if ( mRenderQuality > 1 )
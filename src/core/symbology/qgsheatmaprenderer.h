@@ -22,6 +22,8 @@
 #include "qgsexpression.h"
 #include "qgsgeometry.h"
 
+#include <vector>
+
 class QgsColorRamp;
 
 /**
@@ -182,6 +184,8 @@ class CORE_EXPORT QgsHeatmapRenderer : public QgsFeatureRenderer
   private:
 
     QVector<double> mValues;
+    int mGridWidth = 0;
+    int mGridHeight = 0;
 
     double mCalculatedMaxValue = 0;
 
@@ -202,6 +206,23 @@ class CORE_EXPORT QgsHeatmapRenderer : public QgsFeatureRenderer
 
     int mFeaturesRendered = 0;
 
+#ifndef SIP_RUN
+    //! Point waiting to be added to the heatmap, in grid cells
+    struct PendingPoint
+    {
+      int x;
+      int y;
+      double weight;
+    };
+
+    std::vector< PendingPoint > mPendingPoints;
+
+    //! Kernel values for the offsets around a point, by rows of 2 * mRadiusPixels values
+    std::vector< double > mKernelValues;
+    //! First and last offsets of each kernel row within the radius
+    std::vector< std::pair< int, int > > mKernelSpans;
+#endif
+
     double uniformKernel( double distance, int bandwidth ) const;
     double quarticKernel( double distance, int bandwidth ) const;
     double triweightKernel( double distance, int bandwidth ) const;
@@ -211,6 +232,9 @@ class CORE_EXPORT QgsHeatmapRenderer : public QgsFeatureRenderer
     QgsMultiPointXY convertToMultipoint( const QgsGeometry *geom );
     void initializeValues( QgsRenderContext &context );
     void renderImage( QgsRenderContext &context );
+
+    //! Adds the pending points to the heatmap values, in parallel by bands of rows
+    void addPendingPoints( QgsRenderContext &context );
 };
 
 
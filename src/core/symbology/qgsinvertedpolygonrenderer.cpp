@@ -29,6 +29,57 @@
 
 #include <QDomDocument>
 #include <QDomElement>
+#include <QCache>
+#include <QCryptographicHash>
+#include <QMutex>
+
+///@cond PRIVATE
+
+/**
+ * Merged geometries of the inverted polygon renders, shared by the renderers and keyed by a hash
+ * of the source geometries, so that renders of the same features (e.g. redraws, or server requests
+ * for the same extent) do not merge them again. Edited or different features give another key.
+ */
+class QgsInvertedPolygonGeometryCache
+{
+  public:
+
+    bool find( const QByteArray &key, QgsGeometry &geometry )
+    {
+      QMutexLocker locker( &mMutex );
+      if ( const QgsGeometry *cached = mCache.object( key ) )
+      {
+        geometry = *cached;
+        return true;
+      }
+      return false;
+    }
+
+    void insert( const QByteArray &key, const QgsGeometry &geometry )
+    {
+      // approximate cost in kilobytes
+      const int cost = std::max( 1, geometry.constGet() ? geometry.constGet()->nCoordinates() / 64 : 1 );
+      QMutexLocker locker( &mMutex );
+      mCache.insert( key, new QgsGeometry( geometry ), cost );
+    }
+
+  private:
+
+    QMutex mMutex;
+    QCache< QByteArray, QgsGeometry > mCache { 64 * 1024 };
+};
+
+Q_GLOBAL_STATIC( QgsInvertedPolygonGeometryCache, sInvertedPolygonGeometryCache )
+
+static QByteArray geometriesKey( const QVector<QgsGeometry> &geometries )
+{
+  QCryptographicHash hash( QCryptographicHash::Sha1 );
+  for ( const QgsGeometry &geometry : geometries )
+    hash.addData( geometry.asWkb() );
+  return hash.result();
+}
+
+///@endcond
 
 QgsInvertedPolygonRenderer::QgsInvertedPolygonRenderer( QgsFeatureRenderer *subRenderer )
   : QgsFeatureRenderer( QStringLiteral( "invertedPolygonRenderer" ) )
@@ -234,15 +285,7 @@ bool QgsInvertedPolygonRenderer::renderFeature( const QgsFeature &feature, QgsRe
     geom.transform( xform );
   }
 
-  if ( mPreprocessingEnabled )
-  {
-    // fix the polygon if it is not valid
-    if ( ! geom.isGeosValid() )
-    {
-      geom = geom.buffer( 0, 0 );
-    }
-  }
-
+  // when preprocessing, invalid polygons are fixed in stopRender() if the merged geometry is not cached
   if ( geom.isNull() )
     return false; // do not let invalid geometries sneak in!
 
@@ -280,11 +323,39 @@ void QgsInvertedPolygonRenderer::stopRender( QgsRenderContext &context )
     QgsFeature feat = cit.feature; // just a copy, so that we do not accumulate geometries again
     if ( mPreprocessingEnabled )
     {
-      // compute the unary union on the polygons
-      QgsGeometry unioned( QgsGeometry::unaryUnion( cit.geometries ) );
-      // compute the difference with the extent
+      const QByteArray unionKey = geometriesKey( cit.geometries );
       QgsGeometry rect = QgsGeometry::fromPolygonXY( mExtentPolygon );
-      QgsGeometry final = rect.difference( unioned );
+      const QByteArray differenceKey = unionKey + rect.asWkb();
+
+      QgsGeometry final;
+      if ( !sInvertedPolygonGeometryCache()->find( differenceKey, final ) )
+      {
+        QgsGeometry unioned;
+        if ( !sInvertedPolygonGeometryCache()->find( unionKey, unioned ) )
+        {
+          QVector<QgsGeometry> geometries;
+          geometries.reserve( cit.geometries.size() );
+          for ( QgsGeometry geom : cit.geometries )
+          {
+            // fix the polygon if it is not valid
+            if ( ! geom.isGeosValid() )
+            {
+              geom = geom.buffer( 0, 0 );
+            }
+            // do not let invalid geometries sneak in!
+            if ( !geom.isNull() )
+              geometries.append( geom );
+          }
+
+          // compute the unary union on the polygons
+          unioned = QgsGeometry::unaryUnion( geometries );
+          sInvertedPolygonGeometryCache()->insert( unionKey, unioned );
+        }
+
+        // compute the difference with the extent
+        final = rect.difference( unioned );
+        sInvertedPolygonGeometryCache()->insert( differenceKey, final );
+      }
       feat.setGeometry( final );
     }
     else
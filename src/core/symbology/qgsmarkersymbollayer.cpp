@@ -872,6 +872,15 @@ void QgsSimpleMarkerSymbolLayer::startRender( QgsSymbolRenderContext &context )
     mCache = QImage();
     mSelCache = QImage();
   }
+
+  // markers with data defined properties are drawn with sprites, quantized so that
+  // features sharing about the same size, rotation and colors share the same sprite
+  mSpriteCache.clear();
+  mSpriteCache.setMaxCost( MAXIMUM_SPRITE_CACHE_SIZE );
+  // (not for the symbol previews, which draw a single marker)
+  mUsingSpriteCache = !mUsingCache && !context.renderContext().forceVectorOutput()
+                      && !( context.renderContext().flags() & QgsRenderContext::RenderSymbolPreview )
+                      && !mDataDefinedProperties.isActive( QgsSymbolLayer::PropertyName );
 }
 
 
@@ -947,17 +956,8 @@ bool QgsSimpleMarkerSymbolLayer::prepareCache( QgsSymbolRenderContext &context )
   return true;
 }
 
-void QgsSimpleMarkerSymbolLayer::draw( QgsSymbolRenderContext &context, QgsSimpleMarkerSymbolLayerBase::Shape shape, const QPolygonF &polygon, const QPainterPath &path )
+void QgsSimpleMarkerSymbolLayer::applyDataDefinedStyle( QgsSymbolRenderContext &context )
 {
-  //making changes here? Don't forget to also update ::bounds if the changes affect the bounding box
-  //of the rendered point!
-
-  QPainter *p = context.renderContext().painter();
-  if ( !p )
-  {
-    return;
-  }
-
   bool ok = true;
   if ( mDataDefinedProperties.isActive( QgsSymbolLayer::PropertyFillColor ) )
   {
@@ -1006,6 +1006,20 @@ void QgsSimpleMarkerSymbolLayer::draw( QgsSymbolRenderContext &context, QgsSimpl
       mSelPen.setJoinStyle( QgsSymbolLayerUtils::decodePenJoinStyle( style ) );
     }
   }
+}
+
+void QgsSimpleMarkerSymbolLayer::draw( QgsSymbolRenderContext &context, QgsSimpleMarkerSymbolLayerBase::Shape shape, const QPolygonF &polygon, const QPainterPath &path )
+{
+  //making changes here? Don't forget to also update ::bounds if the changes affect the bounding box
+  //of the rendered point!
+
+  QPainter *p = context.renderContext().painter();
+  if ( !p )
+  {
+    return;
+  }
+
+  applyDataDefinedStyle( context );
 
   if ( shapeIsFilled( shape ) )
   {
@@ -1051,12 +1065,118 @@ void QgsSimpleMarkerSymbolLayer::renderPoint( QPointF point, QgsSymbolRenderCont
                           point.y() - s / 2.0 + offset.y(),
                           s, s ), img );
   }
-  else
+  else if ( !mUsingSpriteCache || !renderSprite( point, context ) )
   {
     QgsSimpleMarkerSymbolLayerBase::renderPoint( point, context );
   }
 }
 
+bool QgsSimpleMarkerSymbolLayer::renderSprite( QPointF point, QgsSymbolRenderContext &context )
+{
+  //making changes here? Don't forget to also update ::bounds if the changes affect the bounding box
+  //of the rendered point!
+
+  // sprites are positioned to the nearest pixel, the quantized size and rotation must not
+  // move the marker outline further than a quarter of a pixel
+  const double tolerance = 0.25;
+
+  QPainter *p = context.renderContext().painter();
+
+  bool hasDataDefinedSize = false;
+  double scaledSize = calculateSize( context, hasDataDefinedSize );
+
+  bool hasDataDefinedRotation = false;
+  QPointF offset;
+  double angle = 0;
+  calculateOffsetAndRotation( context, scaledSize, hasDataDefinedRotation, offset, angle );
+
+  double size = context.renderContext().convertToPainterUnits( scaledSize, mSizeUnit, mSizeMapUnitScale );
+  if ( mSizeUnit == QgsUnitTypes::RenderMetersInMapUnits && context.renderContext().flags() & QgsRenderContext::RenderSymbolPreview )
+  {
+    // rendering for symbol previews -- a size in meters in map units can't be calculated, so treat the size as millimeters
+    // and clamp it to a reasonable range. It's the best we can do in this situation!
+    size = std::min( std::max( context.renderContext().convertToPainterUnits( mSize, QgsUnitTypes::RenderMillimeters ), 3.0 ), 100.0 );
+  }
+
+  SpriteKey key;
+  if ( hasDataDefinedSize )
+  {
+    // the outline moves by half the size difference
+    key.size = static_cast< int >( std::round( size / ( 2 * tolerance ) ) );
+    size = key.size * 2 * tolerance;
+  }
+  const bool rotate = hasDataDefinedRotation && !qgsDoubleNear( angle, 0.0 );
+  if ( rotate )
+  {
+    // the outline moves by the angle difference (in radians) times the half size
+    const double step = tolerance / std::max( size / 2, tolerance ) * 180 / M_PI;
+    key.angle = static_cast< int >( std::round( std::fmod( angle, 360.0 ) / step ) );
+    angle = key.angle * step;
+  }
+
+  applyDataDefinedStyle( context );
+  const QBrush &brush = context.selected() ? mSelBrush : mBrush;
+  const QPen &pen = context.selected() ? mSelPen : mPen;
+  const bool needsBrush = shapeIsFilled( mShape );
+  key.fillColor = needsBrush ? brush.color().rgba() : 0;
+  key.strokeColor = pen.color().rgba();
+  key.strokeWidth = pen.widthF();
+  key.strokeStyle = pen.style();
+  key.joinStyle = pen.joinStyle();
+
+  QImage sprite;
+  if ( const QImage *cached = mSpriteCache.object( key ) )
+  {
+    sprite = *cached;
+  }
+  else
+  {
+    // same image size as prepareCache()
+    double extent = size;
+    if ( !qgsDoubleNear( angle, 0.0 ) )
+    {
+      extent = ( std::abs( std::sin( angle * M_PI / 180 ) ) + std::abs( std::cos( angle * M_PI / 180 ) ) ) * size;
+    }
+    double pw = static_cast< int >( std::round( ( ( qgsDoubleNear( pen.widthF(), 0.0 ) ? 1 : pen.widthF() * 4 ) + 1 ) ) ) / 2 * 2; // make even (round up); handle cosmetic pen
+    int imageSize = ( static_cast< int >( extent ) + pw ) / 2 * 2 + 1; //  make image width, height odd; account for pen width
+    double center = imageSize / 2.0;
+    if ( imageSize > MAXIMUM_CACHE_WIDTH )
+    {
+      return false;
+    }
+
+    // same transform as QgsSimpleMarkerSymbolLayerBase::renderPoint(), centered on the sprite
+    QTransform transform;
+    transform.translate( center, center );
+    if ( hasDataDefinedSize )
+      transform.scale( size / 2.0, size / 2.0 );
+    if ( rotate )
+      transform.rotate( angle );
+
+    sprite = QImage( QSize( imageSize, imageSize ), QImage::Format_ARGB32_Premultiplied );
+    sprite.fill( 0 );
+
+    QPainter spritePainter;
+    spritePainter.begin( &sprite );
+    spritePainter.setRenderHint( QPainter::Antialiasing );
+    spritePainter.setBrush( needsBrush ? brush : Qt::NoBrush );
+    spritePainter.setPen( pen );
+    if ( !mPolygon.isEmpty() )
+      spritePainter.drawPolygon( transform.map( mPolygon ) );
+    else
+      spritePainter.drawPath( transform.map( mPath ) );
+    spritePainter.end();
+
+    mSpriteCache.insert( key, new QImage( sprite ), sprite.bytesPerLine() * sprite.height() );
+  }
+
+  const double s = sprite.width();
+  p->drawImage( QRectF( point.x() - s / 2.0 + offset.x(),
+                        point.y() - s / 2.0 + offset.y(),
+                        s, s ), sprite );
+  return true;
+}
+
 QgsStringMap QgsSimpleMarkerSymbolLayer::properties() const
 {
   QgsStringMap map;
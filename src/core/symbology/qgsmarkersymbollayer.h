@@ -29,6 +29,7 @@
 
 #include <QPen>
 #include <QBrush>
+#include <QCache>
 #include <QPicture>
 #include <QPolygonF>
 #include <QFont>
@@ -413,6 +414,63 @@ class CORE_EXPORT QgsSimpleMarkerSymbolLayer : public QgsSimpleMarkerSymbolLayer
 
   private:
 
+#ifndef SIP_RUN
+
+    /**
+     * Quantized size, rotation and style of a marker rendered in the sprite cache.
+     * Markers with the same key are drawn with the same sprite.
+     */
+    struct SpriteKey
+    {
+      int size = 0;
+      int angle = 0;
+      QRgb fillColor = 0;
+      QRgb strokeColor = 0;
+      double strokeWidth = 0;
+      Qt::PenStyle strokeStyle = Qt::SolidLine;
+      Qt::PenJoinStyle joinStyle = Qt::BevelJoin;
+
+      bool operator==( const SpriteKey &other ) const
+      {
+        return size == other.size && angle == other.angle && fillColor == other.fillColor && strokeColor == other.strokeColor
+               && strokeWidth == other.strokeWidth && strokeStyle == other.strokeStyle && joinStyle == other.joinStyle;
+      }
+
+      friend uint qHash( const SpriteKey &key, uint seed = 0 )
+      {
+        return ::qHash( key.size, seed ) ^ ::qHash( key.angle ) * 31 ^ ::qHash( key.fillColor ) * 131 ^ ::qHash( key.strokeColor ) * 257
+               ^ ::qHash( key.strokeWidth ) * 521 ^ ::qHash( static_cast< int >( key.strokeStyle ) * 16 + key.joinStyle ) * 1031;
+      }
+    };
+
+    /**
+     * Sprites of the markers with data defined size, rotation or style, least recently
+     * used first out. Only used when drawing to screen, see mUsingSpriteCache.
+     */
+    QCache< SpriteKey, QImage > mSpriteCache;
+#endif
+
+    /**
+     * TRUE if the markers are drawn with the sprites of mSpriteCache, when mUsingCache
+     * cannot be used because of data defined properties
+     */
+    bool mUsingSpriteCache = false;
+
+    //! Maximum size of the sprite cache, in bytes
+    static const int MAXIMUM_SPRITE_CACHE_SIZE = 16 * 1024 * 1024;
+
+    /**
+     * Applies the data defined fill color and the data defined stroke properties to the
+     * pens and brushes.
+     */
+    void applyDataDefinedStyle( QgsSymbolRenderContext &context );
+
+    /**
+     * Draws the marker with a sprite of the sprite cache, rendering the sprite if needed.
+     * Returns FALSE if the sprite would be larger than MAXIMUM_CACHE_WIDTH, nothing is drawn then.
+     */
+    bool renderSprite( QPointF point, QgsSymbolRenderContext &context );
+
     void draw( QgsSymbolRenderContext &context, QgsSimpleMarkerSymbolLayerBase::Shape shape, const QPolygonF &polygon, const QPainterPath &path ) override SIP_FORCE;
 };
 
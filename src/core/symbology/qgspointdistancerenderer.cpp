@@ -91,10 +91,37 @@ bool QgsPointDistanceRenderer::renderFeature( const QgsFeature &feature, QgsRend
     transformedFeature.setGeometry( geom );
   }
 
-  double searchDistance = context.convertToMapUnits( mTolerance, mToleranceUnit, mToleranceMapUnitScale );
   QgsPointXY point = transformedFeature.geometry().asPoint();
-  QList<QgsFeatureId> intersectList = mSpatialIndex->intersects( searchRect( point, searchDistance ) );
-  if ( intersectList.empty() )
+
+  // find group with closest location to this point (may be more than one within search tolerance),
+  // among the groups whose first feature is within the search rectangle
+  const QPair< qint64, qint64 > cell = gridCell( point );
+  int groupIdx = -1;
+  double minDist = 0;
+  for ( qint64 cellX = cell.first - 1; cellX <= cell.first + 1; ++cellX )
+  {
+    for ( qint64 cellY = cell.second - 1; cellY <= cell.second + 1; ++cellY )
+    {
+      auto seedsIt = mGroupSeeds.constFind( qMakePair( cellX, cellY ) );
+      if ( seedsIt == mGroupSeeds.constEnd() )
+        continue;
+
+      for ( const GroupSeed &seed : *seedsIt )
+      {
+        if ( std::fabs( seed.x - point.x() ) > mSearchDistance || std::fabs( seed.y - point.y() ) > mSearchDistance )
+          continue;
+
+        const double newDist = mGroupLocations.value( seed.id ).distance( point );
+        if ( groupIdx < 0 || newDist < minDist || ( newDist == minDist && seed.group < groupIdx ) )
+        {
+          minDist = newDist;
+          groupIdx = seed.group;
+        }
+      }
+    }
+  }
+
+  if ( groupIdx < 0 )
   {
     mSpatialIndex->addFeature( transformedFeature );
     // create new group
@@ -104,30 +131,22 @@ bool QgsPointDistanceRenderer::renderFeature( const QgsFeature &feature, QgsRend
     // add to group index
     mGroupIndex.insert( transformedFeature.id(), mClusteredGroups.count() - 1 );
     mGroupLocations.insert( transformedFeature.id(), point );
+    GroupSeed seed;
+    seed.x = point.x();
+    seed.y = point.y();
+    seed.id = transformedFeature.id();
+    seed.group = mClusteredGroups.count() - 1;
+    mGroupSeeds[ cell ].push_back( seed );
   }
   else
   {
-    // find group with closest location to this point (may be more than one within search tolerance)
-    QgsFeatureId minDistFeatureId = intersectList.at( 0 );
-    double minDist = mGroupLocations.value( minDistFeatureId ).distance( point );
-    for ( int i = 1; i < intersectList.count(); ++i )
-    {
-      QgsFeatureId candidateId = intersectList.at( i );
-      double newDist = mGroupLocations.value( candidateId ).distance( point );
-      if ( newDist < minDist )
-      {
-        minDist = newDist;
-        minDistFeatureId = candidateId;
-      }
-    }
-
-    int groupIdx = mGroupIndex[ minDistFeatureId ];
     ClusteredGroup &group = mClusteredGroups[groupIdx];
+    const QgsFeatureId seedId = group.at( 0 ).feature.id();
 
     // calculate new centroid of group
-    QgsPointXY oldCenter = mGroupLocations.value( minDistFeatureId );
-    mGroupLocations[ minDistFeatureId ] = QgsPointXY( ( oldCenter.x() * group.size() + point.x() ) / ( group.size() + 1.0 ),
-                                          ( oldCenter.y() * group.size() + point.y() ) / ( group.size() + 1.0 ) );
+    QgsPointXY oldCenter = mGroupLocations.value( seedId );
+    mGroupLocations[ seedId ] = QgsPointXY( ( oldCenter.x() * group.size() + point.x() ) / ( group.size() + 1.0 ),
+                                            ( oldCenter.y() * group.size() + point.y() ) / ( group.size() + 1.0 ) );
 
     // add to a group
     group << GroupedFeature( transformedFeature, symbol->clone(), selected, label );
@@ -310,7 +329,10 @@ void QgsPointDistanceRenderer::startRender( QgsRenderContext &context, const Qgs
   mClusteredGroups.clear();
   mGroupIndex.clear();
   mGroupLocations.clear();
+  mGroupSeeds.clear();
+  delete mSpatialIndex;
   mSpatialIndex = new QgsSpatialIndex;
+  mSearchDistance = context.convertToMapUnits( mTolerance, mToleranceUnit, mToleranceMapUnitScale );
 
   if ( mLabelAttributeName.isEmpty() )
   {
@@ -349,6 +371,7 @@ void QgsPointDistanceRenderer::stopRender( QgsRenderContext &context )
   mClusteredGroups.clear();
   mGroupIndex.clear();
   mGroupLocations.clear();
+  mGroupSeeds.clear();
   delete mSpatialIndex;
   mSpatialIndex = nullptr;
 
@@ -364,9 +387,16 @@ QgsLegendSymbolList QgsPointDistanceRenderer::legendSymbolItems() const
   return QgsLegendSymbolList();
 }
 
-QgsRectangle QgsPointDistanceRenderer::searchRect( const QgsPointXY &p, double distance ) const
+QPair< qint64, qint64 > QgsPointDistanceRenderer::gridCell( const QgsPointXY &point ) const
 {
-  return QgsRectangle( p.x() - distance, p.y() - distance, p.x() + distance, p.y() + distance );
+  // the seeds within the search distance of a point are in the 3 x 3 cells around its cell
+  const double cellSize = mSearchDistance > 0 ? mSearchDistance : 1;
+  const double cellX = std::floor( point.x() / cellSize );
+  const double cellY = std::floor( point.y() / cellSize );
+  if ( !( std::fabs( cellX ) < 1e15 ) || !( std::fabs( cellY ) < 1e15 ) )
+    return qMakePair( static_cast< qint64 >( 0 ), static_cast< qint64 >( 0 ) );
+
+  return qMakePair( static_cast< qint64 >( cellX ), static_cast< qint64 >( cellY ) );
 }
 
 void QgsPointDistanceRenderer::printGroupInfo() const
@@ -22,6 +22,7 @@
 #include "qgis.h"
 #include "qgsrenderer.h"
 #include <QFont>
+#include <QHash>
 
 class QgsSpatialIndex;
 
@@ -279,6 +280,29 @@ class CORE_EXPORT QgsPointDistanceRenderer: public QgsFeatureRenderer
 
   private:
 
+#ifndef SIP_RUN
+    //! Location of the first feature of a group
+    struct GroupSeed
+    {
+      double x;
+      double y;
+      QgsFeatureId id;
+      int group;
+    };
+
+    /**
+     * Group seeds by cell of a grid with the size of the search distance, for fast lookup of the groups near a point.
+     * The groups are still added to mSpatialIndex, mGroupIndex and mGroupLocations for the subclasses.
+     */
+    QHash< QPair< qint64, qint64 >, QVector< GroupSeed > > mGroupSeeds;
+
+    //! Search distance in map units, also used as the size of the cells of the grid of group seeds
+    double mSearchDistance = 0;
+
+    //! Returns the cell of the grid of group seeds containing \a point
+    QPair< qint64, qint64 > gridCell( const QgsPointXY &point ) const;
+#endif
+
     /**
      * Draws a group of clustered points.
      * \param centerPoint central point (geographic centroid) of all points contained within the cluster
@@ -287,9 +311,6 @@ class CORE_EXPORT QgsPointDistanceRenderer: public QgsFeatureRenderer
      */
     virtual void drawGroup( QPointF centerPoint, QgsRenderContext &context, const ClusteredGroup &group ) = 0 SIP_FORCE;
 
-    //! Creates a search rectangle with specified distance tolerance.
-    QgsRectangle searchRect( const QgsPointXY &p, double distance ) const;
-
     //! Debugging function to check the entries in the clustered groups
     void printGroupInfo() const;
 
@@ -14,6 +14,7 @@
  ***************************************************************************/
 
 #include "qgsrulebasedrenderer.h"
+#include "qgsrulebasedrendererfilterindex_p.h"
 #include "qgssymbollayer.h"
 #include "qgsexpression.h"
 #include "qgssymbollayerutils.h"
@@ -441,6 +442,22 @@ bool QgsRuleBasedRenderer::Rule::startRender( QgsRenderContext &context, const Q
     }
   }
 
+  // when the children filters all compare a single field with constant values, index them
+  // so that only the filters which may match a feature are evaluated
+  QList< const QgsExpression * > childrenFilters;
+  mIndexedChildren.clear();
+  for ( Rule *rule : constMChildren )
+  {
+    if ( !rule->isElse() )
+    {
+      childrenFilters << rule->mFilter.get();
+      mIndexedChildren << rule;
+    }
+  }
+  mChildrenFilterIndex = QgsRuleBasedRendererFilterIndex::create( childrenFilters, fields );
+  if ( !mChildrenFilterIndex )
+    mIndexedChildren.clear();
+
   // subfilters (on the same level) are joined with OR
   // Finally they are joined with their parent (this) with AND
   QString sf;
@@ -575,17 +592,30 @@ QgsRuleBasedRenderer::Rule::RenderResult QgsRuleBasedRenderer::Rule::renderFeatu
 
   // process children
   const auto constMChildren = mChildren;
-  for ( Rule *rule : constMChildren )
+  if ( mChildrenFilterIndex && mChildrenFilterIndex->candidates( featToRender.feat, mCandidateChildren ) )
   {
-    // Don't process else rules yet
-    if ( !rule->isElse() )
+    // the filters of the other children are FALSE for this feature, they would be filtered out
+    for ( int child : qgis::as_const( mCandidateChildren ) )
     {
-      RenderResult res = rule->renderFeature( featToRender, context, renderQueue );
-      // consider inactive items as "rendered" so the else rule will ignore them
+      RenderResult res = mIndexedChildren.at( child )->renderFeature( featToRender, context, renderQueue );
       willrendersomething |= ( res == Rendered || res == Inactive );
       rendered |= ( res == Rendered );
     }
   }
+  else
+  {
+    for ( Rule *rule : constMChildren )
+    {
+      // Don't process else rules yet
+      if ( !rule->isElse() )
+      {
+        RenderResult res = rule->renderFeature( featToRender, context, renderQueue );
+        // consider inactive items as "rendered" so the else rule will ignore them
+        willrendersomething |= ( res == Rendered || res == Inactive );
+        rendered |= ( res == Rendered );
+      }
+    }
+  }
 
   // If none of the rules passed then we jump into the else rules and process them.
   if ( !willrendersomething )
@@ -724,6 +754,8 @@ void QgsRuleBasedRenderer::Rule::stopRender( QgsRenderContext &context )
 
   mActiveChildren.clear();
   mSymbolNormZLevels.clear();
+  mChildrenFilterIndex.reset();
+  mIndexedChildren.clear();
 }
 
 QgsRuleBasedRenderer::Rule *QgsRuleBasedRenderer::Rule::create( QDomElement &ruleElem, QgsSymbolMap &symbolMap )
@@ -27,6 +27,9 @@
 class QgsExpression;
 
 class QgsCategorizedSymbolRenderer;
+#ifndef SIP_RUN
+class QgsRuleBasedRendererFilterIndex;
+#endif
 class QgsGraduatedSymbolRenderer;
 
 /**
@@ -469,6 +472,14 @@ class CORE_EXPORT QgsRuleBasedRenderer : public QgsFeatureRenderer
         // temporary while rendering
         QSet<int> mSymbolNormZLevels;
         RuleList mActiveChildren;
+#ifndef SIP_RUN
+        //! Index of the filters of the children which are not else rules, if they all test a single field
+        std::unique_ptr< QgsRuleBasedRendererFilterIndex > mChildrenFilterIndex;
+        //! Children which are not else rules, in the order of the filter index
+        RuleList mIndexedChildren;
+        //! Positions in mChildren of the children whose filter may match the rendered feature
+        QVector< int > mCandidateChildren;
+#endif
 
         /**
          * Check which child rules are else rules and update the internal list of else rules
@@ -0,0 +1,345 @@
+/***************************************************************************
+                         qgsrulebasedrendererfilterindex.cpp
+                         -----------------------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsrulebasedrendererfilterindex_p.h"
+#include "qgsexpression.h"
+#include "qgsexpressionnodeimpl.h"
+#include "qgsexpressionutils.h"
+#include "qgsfeature.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+///@cond PRIVATE
+
+// numeric values are hashed by buckets of 1/1024, wide enough to contain the values
+// compared as equal by the expression engine (qgsDoubleNear)
+static const double NUMERIC_BUCKETS_PER_UNIT = 1024;
+static const double NUMERIC_EQUALITY_MARGIN = 1e-12;
+
+static double intervalMargin( double bound )
+{
+  return 1e-9 * std::max( 1.0, std::fabs( bound ) );
+}
+
+static bool isIndexedType( QVariant::Type type )
+{
+  switch ( type )
+  {
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+    case QVariant::Double:
+    case QVariant::String:
+    case QVariant::Bool:
+      return true;
+    default:
+      return false;
+  }
+}
+
+std::unique_ptr< QgsRuleBasedRendererFilterIndex > QgsRuleBasedRendererFilterIndex::create( const QList< const QgsExpression * > &filters, const QgsFields &fields )
+{
+  if ( filters.size() < MINIMUM_RULE_COUNT )
+    return nullptr;
+
+  std::unique_ptr< QgsRuleBasedRendererFilterIndex > index = qgis::make_unique< QgsRuleBasedRendererFilterIndex >();
+  index->mFields = fields;
+  for ( int rule = 0; rule < filters.size(); ++rule )
+  {
+    const QgsExpression *filter = filters.at( rule );
+    if ( !filter || filter->hasParserError() || !filter->rootNode() || !index->addFilter( filter->rootNode(), rule ) )
+      return nullptr;
+  }
+
+  std::sort( index->mIntervals.begin(), index->mIntervals.end(), []( const Interval & interval1, const Interval & interval2 )
+  {
+    return interval1.lower < interval2.lower;
+  } );
+  double maximumUpper = -std::numeric_limits< double >::infinity();
+  for ( const Interval &interval : index->mIntervals )
+  {
+    maximumUpper = std::max( maximumUpper, interval.upper );
+    index->mMaximumUpper.push_back( maximumUpper );
+  }
+
+  return index;
+}
+
+bool QgsRuleBasedRendererFilterIndex::candidates( const QgsFeature &feature, QVector< int > &rules ) const
+{
+  rules.clear();
+
+  const QgsAttributes attributes = feature.attributes();
+  if ( mFieldIndex >= attributes.size() )
+    return false;
+
+  // comparisons with NULL are never TRUE
+  const QVariant value = attributes.at( mFieldIndex );
+  if ( value.isNull() )
+    return true;
+
+  if ( !isIndexedType( value.type() ) )
+    return false;
+
+  // values compared as strings
+  auto stringIt = mStringRules.constFind( value.toString() );
+  if ( stringIt != mStringRules.constEnd() )
+    rules << *stringIt;
+
+  if ( QgsExpressionUtils::isDoubleSafe( value ) )
+  {
+    // values compared as numbers
+    const double number = value.toDouble();
+    qint64 bucket = 0;
+    if ( !numericBucket( number, bucket ) )
+      return false;
+    auto numericIt = mNumericRules.constFind( bucket );
+    if ( numericIt != mNumericRules.constEnd() )
+      rules << *numericIt;
+
+    // intervals with a lower bound below the value, until none of the previous ones reaches it
+    auto end = std::upper_bound( mIntervals.begin(), mIntervals.end(), number, []( double number, const Interval & interval )
+    {
+      return number < interval.lower;
+    } );
+    for ( int i = static_cast< int >( end - mIntervals.begin() ) - 1; i >= 0 && mMaximumUpper[ i ] >= number; --i )
+    {
+      if ( mIntervals[ i ].upper >= number )
+        rules << mIntervals[ i ].rule;
+    }
+  }
+  else if ( !mIntervals.empty() )
+  {
+    // bounds are compared as strings with non numeric values
+    return false;
+  }
+
+  std::sort( rules.begin(), rules.end() );
+  rules.erase( std::unique( rules.begin(), rules.end() ), rules.end() );
+  return true;
+}
+
+bool QgsRuleBasedRendererFilterIndex::addFilter( const QgsExpressionNode *node, int rule )
+{
+  switch ( node->nodeType() )
+  {
+    case QgsExpressionNode::ntBinaryOperator:
+    {
+      const QgsExpressionNodeBinaryOperator *binary = static_cast< const QgsExpressionNodeBinaryOperator * >( node );
+      switch ( binary->op() )
+      {
+        case QgsExpressionNodeBinaryOperator::boEQ:
+        {
+          QVariant value;
+          if ( fieldFromNode( binary->opLeft() ) && literalFromNode( binary->opRight(), value ) )
+            return addValue( value, rule );
+          if ( fieldFromNode( binary->opRight() ) && literalFromNode( binary->opLeft(), value ) )
+            return addValue( value, rule );
+          return false;
+        }
+
+        case QgsExpressionNodeBinaryOperator::boGE:
+        case QgsExpressionNodeBinaryOperator::boGT:
+        case QgsExpressionNodeBinaryOperator::boLE:
+        case QgsExpressionNodeBinaryOperator::boLT:
+        case QgsExpressionNodeBinaryOperator::boAnd:
+        {
+          double lower = -std::numeric_limits< double >::infinity();
+          double upper = std::numeric_limits< double >::infinity();
+          if ( binary->op() == QgsExpressionNodeBinaryOperator::boAnd )
+          {
+            if ( !addBound( binary->opLeft(), lower, upper ) || !addBound( binary->opRight(), lower, upper ) )
+              return false;
+          }
+          else if ( !addBound( binary, lower, upper ) )
+          {
+            return false;
+          }
+          if ( !mFields.at( mFieldIndex ).isNumeric() )
+            return false;
+
+          Interval interval;
+          interval.lower = lower - intervalMargin( lower );
+          interval.upper = upper + intervalMargin( upper );
+          interval.rule = rule;
+          mIntervals.push_back( interval );
+          return true;
+        }
+
+        default:
+          return false;
+      }
+    }
+
+    case QgsExpressionNode::ntInOperator:
+    {
+      const QgsExpressionNodeInOperator *in = static_cast< const QgsExpressionNodeInOperator * >( node );
+      if ( in->isNotIn() || !fieldFromNode( in->node() ) )
+        return false;
+
+      const QList< QgsExpressionNode * > nodes = in->list()->list();
+      for ( const QgsExpressionNode *item : nodes )
+      {
+        QVariant value;
+        if ( !literalFromNode( item, value ) || !addValue( value, rule ) )
+          return false;
+      }
+      return true;
+    }
+
+    default:
+      return false;
+  }
+}
+
+bool QgsRuleBasedRendererFilterIndex::addValue( const QVariant &value, int rule )
+{
+  const QVariant::Type fieldType = mFields.at( mFieldIndex ).type();
+  if ( !mFields.at( mFieldIndex ).isNumeric() && fieldType != QVariant::String && fieldType != QVariant::Bool )
+    return false;
+
+  // comparisons with NULL are never TRUE
+  if ( value.isNull() )
+    return true;
+
+  if ( !isIndexedType( value.type() ) )
+    return false;
+
+  mStringRules[ value.toString() ] << rule;
+
+  if ( QgsExpressionUtils::isDoubleSafe( value ) )
+  {
+    const double number = value.toDouble();
+    qint64 lowerBucket = 0;
+    qint64 upperBucket = 0;
+    if ( !numericBucket( number - NUMERIC_EQUALITY_MARGIN, lowerBucket ) || !numericBucket( number + NUMERIC_EQUALITY_MARGIN, upperBucket ) )
+      return false;
+    for ( qint64 bucket = lowerBucket; bucket <= upperBucket; ++bucket )
+      mNumericRules[ bucket ] << rule;
+  }
+  return true;
+}
+
+bool QgsRuleBasedRendererFilterIndex::addBound( const QgsExpressionNode *node, double &lower, double &upper )
+{
+  if ( node->nodeType() != QgsExpressionNode::ntBinaryOperator )
+    return false;
+
+  const QgsExpressionNodeBinaryOperator *binary = static_cast< const QgsExpressionNodeBinaryOperator * >( node );
+  bool isLowerBound = false;
+  switch ( binary->op() )
+  {
+    case QgsExpressionNodeBinaryOperator::boGE:
+    case QgsExpressionNodeBinaryOperator::boGT:
+      isLowerBound = true;
+      break;
+    case QgsExpressionNodeBinaryOperator::boLE:
+    case QgsExpressionNodeBinaryOperator::boLT:
+      isLowerBound = false;
+      break;
+    default:
+      return false;
+  }
+
+  QVariant value;
+  if ( fieldFromNode( binary->opLeft() ) && literalFromNode( binary->opRight(), value ) )
+  {
+    // "field" >= value
+  }
+  else if ( fieldFromNode( binary->opRight() ) && literalFromNode( binary->opLeft(), value ) )
+  {
+    // value >= "field"
+    isLowerBound = !isLowerBound;
+  }
+  else
+  {
+    return false;
+  }
+
+  if ( value.isNull() || !QgsExpressionUtils::isDoubleSafe( value ) )
+    return false;
+
+  const double bound = value.toDouble();
+  if ( isLowerBound )
+    lower = std::max( lower, bound );
+  else
+    upper = std::min( upper, bound );
+  return true;
+}
+
+bool QgsRuleBasedRendererFilterIndex::fieldFromNode( const QgsExpressionNode *node )
+{
+  if ( node->nodeType() != QgsExpressionNode::ntColumnRef )
+    return false;
+
+  const int fieldIndex = mFields.lookupField( static_cast< const QgsExpressionNodeColumnRef * >( node )->name() );
+  if ( fieldIndex < 0 || ( mFieldIndex >= 0 && fieldIndex != mFieldIndex ) )
+    return false;
+
+  mFieldIndex = fieldIndex;
+  return true;
+}
+
+bool QgsRuleBasedRendererFilterIndex::literalFromNode( const QgsExpressionNode *node, QVariant &value )
+{
+  if ( node->nodeType() == QgsExpressionNode::ntLiteral )
+  {
+    value = static_cast< const QgsExpressionNodeLiteral * >( node )->value();
+    return true;
+  }
+
+  // negative numbers are parsed as a minus operator applied to a literal
+  if ( node->nodeType() == QgsExpressionNode::ntUnaryOperator )
+  {
+    const QgsExpressionNodeUnaryOperator *unary = static_cast< const QgsExpressionNodeUnaryOperator * >( node );
+    if ( unary->op() != QgsExpressionNodeUnaryOperator::uoMinus || unary->operand()->nodeType() != QgsExpressionNode::ntLiteral )
+      return false;
+
+    const QVariant operand = static_cast< const QgsExpressionNodeLiteral * >( unary->operand() )->value();
+    switch ( operand.type() )
+    {
+      case QVariant::Int:
+        value = -operand.toInt();
+        return true;
+      case QVariant::LongLong:
+        value = -operand.toLongLong();
+        return true;
+      case QVariant::Double:
+        value = -operand.toDouble();
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  return false;
+}
+
+bool QgsRuleBasedRendererFilterIndex::numericBucket( double value, qint64 &bucket )
+{
+  // also rejects NaN
+  if ( !( std::fabs( value ) < 1099511627776.0 ) )
+    return false;
+
+  bucket = static_cast< qint64 >( std::floor( value * NUMERIC_BUCKETS_PER_UNIT ) );
+  return true;
+}
+
+///@endcond
@@ -0,0 +1,105 @@
+/***************************************************************************
+                         qgsrulebasedrendererfilterindex_p.h
+                         -----------------------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSRULEBASEDRENDERERFILTERINDEX_PRIVATE_H
+#define QGSRULEBASEDRENDERERFILTERINDEX_PRIVATE_H
+
+#define SIP_NO_FILE
+
+/// @cond PRIVATE
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QGIS API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+
+#include "qgis_core.h"
+#include "qgsfields.h"
+
+#include <QHash>
+#include <QVector>
+
+#include <memory>
+#include <vector>
+
+class QgsExpression;
+class QgsExpressionNode;
+class QgsFeature;
+
+/**
+ * \ingroup core
+ * Index of the filters of sibling rules of QgsRuleBasedRenderer which all test a single field
+ * against literal values, with "field" = value, "field" IN (values) or numeric bounds like
+ * "field" >= 1 AND "field" < 5.
+ *
+ * For a feature, the index returns the rules whose filter may be TRUE, from a hash of the
+ * values and a list of intervals sorted by lower bound, so that the filters of the other
+ * rules do not need to be evaluated. The returned rules are a superset of the matching ones:
+ * their filters still have to be evaluated.
+ */
+class CORE_EXPORT QgsRuleBasedRendererFilterIndex
+{
+  public:
+
+    //! Minimum number of rules for which an index is built
+    static const int MINIMUM_RULE_COUNT = 8;
+
+    /**
+     * Builds the index for the filters of the rules, identified by their position in \a filters.
+     * Returns nullptr if a filter is not supported or if the filters do not test the same field.
+     */
+    static std::unique_ptr< QgsRuleBasedRendererFilterIndex > create( const QList< const QgsExpression * > &filters, const QgsFields &fields );
+
+    /**
+     * Sets \a rules to the positions of the rules whose filter may be TRUE for \a feature, in increasing order.
+     * Returns FALSE if the value of the feature cannot be looked up, then all the filters have to be evaluated.
+     */
+    bool candidates( const QgsFeature &feature, QVector< int > &rules ) const;
+
+  private:
+
+    struct Interval
+    {
+      double lower;
+      double upper;
+      int rule;
+    };
+
+    bool addFilter( const QgsExpressionNode *node, int rule );
+    bool addValue( const QVariant &value, int rule );
+    bool addBound( const QgsExpressionNode *node, double &lower, double &upper );
+    bool fieldFromNode( const QgsExpressionNode *node );
+    static bool literalFromNode( const QgsExpressionNode *node, QVariant &value );
+    static bool numericBucket( double value, qint64 &bucket );
+
+    QgsFields mFields;
+    int mFieldIndex = -1;
+
+    QHash< QString, QVector< int > > mStringRules;
+    QHash< qint64, QVector< int > > mNumericRules;
+
+    std::vector< Interval > mIntervals;
+    std::vector< double > mMaximumUpper;
+};
+
+/// @endcond
+
+#endif // QGSRULEBASEDRENDERERFILTERINDEX_PRIVATE_H
@@ -17,11 +17,13 @@
 
 #include "qgssvgcache.h"
 #include "qgis.h"
+#include "qgshotpathinstrumentation.h"
 #include "qgslogger.h"
 #include "qgsnetworkaccessmanager.h"
 #include "qgsmessagelog.h"
 #include "qgssymbollayerutils.h"
 #include "qgsnetworkcontentfetchertask.h"
+#include "qgssettings.h"
 
 #include <QApplication>
 #include <QCoreApplication>
@@ -117,12 +119,17 @@ QgsSvgCache::QgsSvgCache( QObject *parent )
   }
 
   connect( this, &QgsAbstractContentCacheBase::remoteContentFetched, this, &QgsSvgCache::remoteSvgFetched );
+
+  // maximum size in bytes, the default size is kept if not set
+  const qlonglong maxCacheSize = QgsSettings().value( QStringLiteral( "qgis/maxSvgCacheSize" ), 0 ).toLongLong();
+  if ( maxCacheSize > 0 )
+    mMaxCacheSize = static_cast< long >( maxCacheSize );
 }
 
 QImage QgsSvgCache::svgAsImage( const QString &file, double size, const QColor &fill, const QColor &stroke, double strokeWidth,
                                 double widthScaleFactor, bool &fitsInCache, double fixedAspectRatio, bool blocking )
 {
-  QMutexLocker locker( &mMutex );
+  QgsHotPathInstrumentation::MutexLocker locker( &mMutex, QgsHotPathInstrumentation::ContentCacheLock );
 
   fitsInCache = true;
   QgsSvgCacheEntry *currentEntry = cacheEntry( file, size, fill, stroke, strokeWidth, widthScaleFactor, fixedAspectRatio, blocking );
@@ -166,7 +173,19 @@ QImage QgsSvgCache::svgAsImage( const QString &file, double size, const QColor &
     }
     else
     {
-      cacheImage( currentEntry );
+      // render the image without holding the lock, so that the cached entries can be read meanwhile
+      const std::unique_ptr< QgsSvgCacheEntry > renderEntry = copyForRendering( *currentEntry );
+      locker.unlock();
+      std::unique_ptr< QImage > image = renderImage( *renderEntry );
+      locker.relock();
+
+      // the entry may have been removed from the cache while it was not locked
+      currentEntry = cacheEntry( file, size, fill, stroke, strokeWidth, widthScaleFactor, fixedAspectRatio, blocking );
+      if ( !currentEntry->image )
+      {
+        mTotalSize += ( image->width() * image->height() * 32 );
+        currentEntry->image = std::move( image );
+      }
       result = *( currentEntry->image );
     }
     trimToMaximumSize();
@@ -182,7 +201,7 @@ QImage QgsSvgCache::svgAsImage( const QString &file, double size, const QColor &
 QPicture QgsSvgCache::svgAsPicture( const QString &path, double size, const QColor &fill, const QColor &stroke, double strokeWidth,
                                     double widthScaleFactor, bool forceVectorOutput, double fixedAspectRatio, bool blocking )
 {
-  QMutexLocker locker( &mMutex );
+  QgsHotPathInstrumentation::MutexLocker locker( &mMutex, QgsHotPathInstrumentation::ContentCacheLock );
 
   QgsSvgCacheEntry *currentEntry = cacheEntry( path, size, fill, stroke, strokeWidth, widthScaleFactor, fixedAspectRatio, blocking );
 
@@ -190,7 +209,19 @@ QPicture QgsSvgCache::svgAsPicture( const QString &path, double size, const QCol
   //update stats for memory usage
   if ( !currentEntry->picture )
   {
-    cachePicture( currentEntry, forceVectorOutput );
+    // render the picture without holding the lock, so that the cached entries can be read meanwhile
+    const std::unique_ptr< QgsSvgCacheEntry > renderEntry = copyForRendering( *currentEntry );
+    locker.unlock();
+    std::unique_ptr< QPicture > picture = renderPicture( *renderEntry );
+    locker.relock();
+
+    // the entry may have been removed from the cache while it was not locked
+    currentEntry = cacheEntry( path, size, fill, stroke, strokeWidth, widthScaleFactor, fixedAspectRatio, blocking );
+    if ( !currentEntry->picture )
+    {
+      mTotalSize += picture->size();
+      currentEntry->picture = std::move( picture );
+    }
     trimToMaximumSize();
   }
 
@@ -206,7 +237,7 @@ QPicture QgsSvgCache::svgAsPicture( const QString &path, double size, const QCol
 QByteArray QgsSvgCache::svgContent( const QString &path, double size, const QColor &fill, const QColor &stroke, double strokeWidth,
                                     double widthScaleFactor, double fixedAspectRatio, bool blocking, bool *isMissingImage )
 {
-  QMutexLocker locker( &mMutex );
+  QgsHotPathInstrumentation::MutexLocker locker( &mMutex, QgsHotPathInstrumentation::ContentCacheLock );
 
   QgsSvgCacheEntry *currentEntry = cacheEntry( path, size, fill, stroke, strokeWidth, widthScaleFactor, fixedAspectRatio, blocking, isMissingImage );
 
@@ -216,7 +247,7 @@ QByteArray QgsSvgCache::svgContent( const QString &path, double size, const QCol
 QSizeF QgsSvgCache::svgViewboxSize( const QString &path, double size, const QColor &fill, const QColor &stroke, double strokeWidth,
                                     double widthScaleFactor, double fixedAspectRatio, bool blocking )
 {
-  QMutexLocker locker( &mMutex );
+  QgsHotPathInstrumentation::MutexLocker locker( &mMutex, QgsHotPathInstrumentation::ContentCacheLock );
 
   QgsSvgCacheEntry *currentEntry = cacheEntry( path, size, fill, stroke, strokeWidth, widthScaleFactor, fixedAspectRatio, blocking );
   return currentEntry->viewboxSize;
@@ -414,27 +445,20 @@ bool QgsSvgCache::checkReply( QNetworkReply *reply, const QString &path ) const
   return true;
 }
 
-void QgsSvgCache::cacheImage( QgsSvgCacheEntry *entry )
+std::unique_ptr< QImage > QgsSvgCache::renderImage( const QgsSvgCacheEntry &entry ) const
 {
-  if ( !entry )
-  {
-    return;
-  }
-
-  entry->image.reset();
-
   QSizeF viewBoxSize;
   QSizeF scaledSize;
-  QSize imageSize = sizeForImage( *entry, viewBoxSize, scaledSize );
+  QSize imageSize = sizeForImage( entry, viewBoxSize, scaledSize );
 
   // cast double image sizes to int for QImage
   std::unique_ptr< QImage > image = qgis::make_unique< QImage >( imageSize, QImage::Format_ARGB32_Premultiplied );
   image->fill( 0 ); // transparent background
 
-  const bool isFixedAR = entry->fixedAspectRatio > 0;
+  const bool isFixedAR = entry.fixedAspectRatio > 0;
 
   QPainter p( image.get() );
-  QSvgRenderer r( entry->svgContent );
+  QSvgRenderer r( entry.svgContent );
   if ( qgsDoubleNear( viewBoxSize.width(), viewBoxSize.height() ) )
   {
     r.render( &p );
@@ -446,9 +470,9 @@ void QgsSvgCache::cacheImage( QgsSvgCacheEntry *entry )
     QRectF rect( ( imageSize.width() - s.width() ) / 2, ( imageSize.height() - s.height() ) / 2, s.width(), s.height() );
     r.render( &p, rect );
   }
+  p.end();
 
-  mTotalSize += ( image->width() * image->height() * 32 );
-  entry->image = std::move( image );
+  return image;
 }
 
 void QgsSvgCache::cachePicture( QgsSvgCacheEntry *entry, bool forceVectorOutput )
@@ -459,20 +483,24 @@ void QgsSvgCache::cachePicture( QgsSvgCacheEntry *entry, bool forceVectorOutput
     return;
   }
 
-  entry->picture.reset();
+  entry->picture = renderPicture( *entry );
+  mTotalSize += entry->picture->size();
+}
 
-  bool isFixedAR = entry->fixedAspectRatio > 0;
+std::unique_ptr< QPicture > QgsSvgCache::renderPicture( const QgsSvgCacheEntry &entry ) const
+{
+  bool isFixedAR = entry.fixedAspectRatio > 0;
 
   //correct QPictures dpi correction
   std::unique_ptr< QPicture > picture = qgis::make_unique< QPicture >();
   QRectF rect;
-  QSvgRenderer r( entry->svgContent );
+  QSvgRenderer r( entry.svgContent );
   double hwRatio = 1.0;
   if ( r.viewBoxF().width() > 0 )
   {
     if ( isFixedAR )
     {
-      hwRatio = entry->fixedAspectRatio;
+      hwRatio = entry.fixedAspectRatio;
     }
     else
     {
@@ -480,7 +508,7 @@ void QgsSvgCache::cachePicture( QgsSvgCacheEntry *entry, bool forceVectorOutput
     }
   }
 
-  double wSize = entry->size;
+  double wSize = entry.size;
   double hSize = wSize * hwRatio;
 
   QSizeF s( r.viewBoxF().size() );
@@ -489,8 +517,17 @@ void QgsSvgCache::cachePicture( QgsSvgCacheEntry *entry, bool forceVectorOutput
 
   QPainter p( picture.get() );
   r.render( &p, rect );
-  entry->picture = std::move( picture );
-  mTotalSize += entry->picture->size();
+  p.end();
+
+  return picture;
+}
+
+std::unique_ptr< QgsSvgCacheEntry > QgsSvgCache::copyForRendering( const QgsSvgCacheEntry &entry )
+{
+  std::unique_ptr< QgsSvgCacheEntry > copy = qgis::make_unique< QgsSvgCacheEntry >( entry.path, entry.size, entry.strokeWidth, entry.widthScaleFactor, entry.fill, entry.stroke, entry.fixedAspectRatio );
+  copy->svgContent = entry.svgContent;
+  copy->viewboxSize = entry.viewboxSize;
+  return copy;
 }
 
 QgsSvgCacheEntry *QgsSvgCache::cacheEntry( const QString &path, double size, const QColor &fill, const QColor &stroke, double strokeWidth,
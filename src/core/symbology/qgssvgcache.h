@@ -269,8 +269,16 @@ class CORE_EXPORT QgsSvgCache : public QgsAbstractContentCache< QgsSvgCacheEntry
   private:
 
     void replaceParamsAndCacheSvg( QgsSvgCacheEntry *entry, bool blocking = false );
-    void cacheImage( QgsSvgCacheEntry *entry );
     void cachePicture( QgsSvgCacheEntry *entry, bool forceVectorOutput = false );
+
+    //! Renders the image of an \a entry, without adding it to the cache
+    std::unique_ptr< QImage > renderImage( const QgsSvgCacheEntry &entry ) const;
+
+    //! Renders the picture of an \a entry, without adding it to the cache
+    std::unique_ptr< QPicture > renderPicture( const QgsSvgCacheEntry &entry ) const;
+
+    //! Returns a copy of the parameters and content of an \a entry, rendered while the cache is not locked
+    static std::unique_ptr< QgsSvgCacheEntry > copyForRendering( const QgsSvgCacheEntry &entry );
     //! Returns entry from cache or creates a new entry if it does not exist already
     QgsSvgCacheEntry *cacheEntry( const QString &path, double size, const QColor &fill, const QColor &stroke, double strokeWidth,
                                   double widthScaleFactor, double fixedAspectRatio = 0, bool blocking = false, bool *isMissingImage = nullptr );
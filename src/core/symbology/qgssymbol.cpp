@@ -26,6 +26,7 @@
 #include "qgssymbol.h"
 #include "qgssymbollayer.h"
 
+#include "qgsapproximatecoordinatetransform.h"
 #include "qgslinesymbollayer.h"
 #include "qgsmarkersymbollayer.h"
 #include "qgsfillsymbollayer.h"
@@ -101,6 +102,29 @@ QgsSymbol::QgsSymbol( SymbolType type, const QgsSymbolLayerList &layers )
 }
 Q_NOWARN_DEPRECATED_POP
 
+QPointF QgsSymbol::_getPoint( QgsRenderContext &context, const QgsPoint &point )
+{
+  QPointF pt;
+  if ( const QgsApproximateCoordinateTransform *approximateTransform = context.approximateCoordinateTransform() )
+  {
+    pt = approximateTransform->transform( point.x(), point.y() );
+  }
+  else if ( context.coordinateTransform().isValid() )
+  {
+    double x = point.x();
+    double y = point.y();
+    double z = 0.0;
+    context.coordinateTransform().transformInPlace( x, y, z );
+    pt = QPointF( x, y );
+
+  }
+  else
+    pt = point.toQPointF();
+
+  context.mapToPixel().transformInPlace( pt.rx(), pt.ry() );
+  return pt;
+}
+
 QPolygonF QgsSymbol::_getLineString( QgsRenderContext &context, const QgsCurve &curve, bool clipToExtent )
 {
   const unsigned int nPoints = curve.numPoints();
@@ -128,7 +152,10 @@ QPolygonF QgsSymbol::_getLineString( QgsRenderContext &context, const QgsCurve &
   {
     try
     {
-      ct.transformPolygon( pts );
+      if ( const QgsApproximateCoordinateTransform *approximateTransform = context.approximateCoordinateTransform() )
+        approximateTransform->transformPolygon( pts );
+      else
+        ct.transformPolygon( pts );
     }
     catch ( QgsCsException & )
     {
@@ -187,7 +214,10 @@ QPolygonF QgsSymbol::_getPolygonRing( QgsRenderContext &context, const QgsCurve
   {
     try
     {
-      ct.transformPolygon( poly );
+      if ( const QgsApproximateCoordinateTransform *approximateTransform = context.approximateCoordinateTransform() )
+        approximateTransform->transformPolygon( poly );
+      else
+        ct.transformPolygon( poly );
     }
     catch ( QgsCsException & )
     {
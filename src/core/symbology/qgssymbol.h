@@ -550,24 +550,7 @@ class CORE_EXPORT QgsSymbol
     /**
      * Creates a point in screen coordinates from a QgsPoint in map coordinates
      */
-    static inline QPointF _getPoint( QgsRenderContext &context, const QgsPoint &point )
-    {
-      QPointF pt;
-      if ( context.coordinateTransform().isValid() )
-      {
-        double x = point.x();
-        double y = point.y();
-        double z = 0.0;
-        context.coordinateTransform().transformInPlace( x, y, z );
-        pt = QPointF( x, y );
-
-      }
-      else
-        pt = point.toQPointF();
-
-      context.mapToPixel().transformInPlace( pt.rx(), pt.ry() );
-      return pt;
-    }
+    static QPointF _getPoint( QgsRenderContext &context, const QgsPoint &point );
 
     /**
      * Creates a line string in screen coordinates from a QgsCurve in map coordinates
@@ -35,6 +35,7 @@
 #include "qgseffectstack.h"
 #include "qgsstyleentityvisitor.h"
 #include "qgsrenderer.h"
+#include "qgsstyle.h"
 
 #include <QColor>
 #include <QFont>
@@ -46,6 +47,7 @@
 #include <QSettings>
 #include <QRegExp>
 #include <QPicture>
+#include <QtConcurrentMap>
 
 #define POINTS_TO_MM 2.83464567
 
@@ -4670,3 +4672,97 @@ QgsSymbol *QgsSymbolLayerUtils::restrictedSizeSymbol( const QgsSymbol *s, double
   }
   return 0;
 }
+
+///@cond PRIVATE
+// finds whether a symbol draws cached SVG or raster images, and whether their sizes only depend on the dpi
+static void findCachedImageLayers( const QgsSymbol *symbol, bool &usesImages, bool &fixedSizes )
+{
+  for ( int i = 0; i < symbol->symbolLayerCount(); ++i )
+  {
+    const QgsSymbolLayer *layer = symbol->symbolLayer( i );
+    const QString type = layer->layerType();
+    if ( type == QLatin1String( "SvgMarker" ) || type == QLatin1String( "RasterMarker" )
+         || type == QLatin1String( "SVGFill" ) || type == QLatin1String( "RasterFill" ) )
+    {
+      usesImages = true;
+      const QgsUnitTypes::RenderUnit unit = layer->outputUnit();
+      if ( layer->hasDataDefinedProperties() || unit == QgsUnitTypes::RenderMapUnits
+           || unit == QgsUnitTypes::RenderMetersInMapUnits || unit == QgsUnitTypes::RenderUnknownUnit )
+        fixedSizes = false;
+    }
+
+    if ( const QgsSymbol *subSymbol = const_cast< QgsSymbolLayer * >( layer )->subSymbol() )
+      findCachedImageLayers( subSymbol, usesImages, fixedSizes );
+  }
+}
+///@endcond
+
+int QgsSymbolLayerUtils::prewarmImageCaches( const QgsProject *project, double dpi, bool blocking )
+{
+  class ImageSymbolVisitor : public QgsStyleEntityVisitorInterface
+  {
+    public:
+
+      bool visit( const QgsStyleEntityVisitorInterface::StyleLeaf &leaf ) override
+      {
+        if ( leaf.entity && leaf.entity->type() == QgsStyle::SymbolEntity )
+        {
+          const QgsSymbol *symbol = static_cast<const QgsStyleSymbolEntity *>( leaf.entity )->symbol();
+          bool usesImages = false;
+          bool fixedSizes = true;
+          if ( symbol )
+            findCachedImageLayers( symbol, usesImages, fixedSizes );
+          if ( usesImages && fixedSizes )
+            mSymbols.emplace_back( symbol->clone() );
+        }
+        return true;
+      }
+
+      std::vector< std::unique_ptr< QgsSymbol > > mSymbols;
+  };
+
+  if ( !project )
+    return 0;
+
+  // the symbols are cloned, each thread renders its own symbols
+  ImageSymbolVisitor visitor;
+  project->accept( &visitor );
+
+  QtConcurrent::blockingMap( visitor.mSymbols, [dpi, blocking]( std::unique_ptr< QgsSymbol > &symbol )
+  {
+    // the images are clipped to the painted image, only the cache entries matter
+    QImage image( 1, 1, QImage::Format_ARGB32_Premultiplied );
+    image.fill( Qt::transparent );
+    QPainter painter( &image );
+
+    QgsRenderContext context = QgsRenderContext::fromQPainter( &painter );
+    context.setScaleFactor( dpi / 25.4 );
+    context.setFlag( QgsRenderContext::RenderBlocking, blocking );
+    QgsExpressionContext expressionContext;
+    expressionContext << QgsExpressionContextUtils::globalScope();
+    context.setExpressionContext( expressionContext );
+
+    symbol->startRender( context );
+    switch ( symbol->type() )
+    {
+      case QgsSymbol::Marker:
+        static_cast< QgsMarkerSymbol * >( symbol.get() )->renderPoint( QPointF( 0, 0 ), nullptr, context );
+        break;
+
+      case QgsSymbol::Line:
+        static_cast< QgsLineSymbol * >( symbol.get() )->renderPolyline( QPolygonF() << QPointF( 0, 0 ) << QPointF( 100, 0 ), nullptr, context );
+        break;
+
+      case QgsSymbol::Fill:
+        static_cast< QgsFillSymbol * >( symbol.get() )->renderPolygon( QPolygonF() << QPointF( 0, 0 ) << QPointF( 100, 0 ) << QPointF( 100, 100 ) << QPointF( 0, 100 ) << QPointF( 0, 0 ), nullptr, nullptr, context );
+        break;
+
+      case QgsSymbol::Hybrid:
+        break;
+    }
+    symbol->stopRender( context );
+    painter.end();
+  } );
+
+  return static_cast< int >( visitor.mSymbols.size() );
+}
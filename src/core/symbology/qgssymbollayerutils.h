@@ -33,6 +33,7 @@
 
 class QgsExpression;
 class QgsPathResolver;
+class QgsProject;
 class QgsReadWriteContext;
 class QgsSymbolLayer;
 
@@ -773,6 +774,24 @@ class CORE_EXPORT QgsSymbolLayerUtils
      * \return 0 if size is within minSize/maxSize range. New symbol if size was out of min/max range. Caller takes ownership
      */
     static QgsSymbol *restrictedSizeSymbol( const QgsSymbol *s, double minSize, double maxSize, QgsRenderContext *context, double &width, double &height );
+
+    /**
+     * Renders the SVG and raster images of the symbols used by a \a project into the SVG and image caches,
+     * at the sizes they are drawn with a \a dpi resolution, so that the first renders of the project
+     * do not have to render them. The symbols are rendered in parallel.
+     *
+     * Only the symbols whose image sizes do not depend on the features or on the map scale are rendered,
+     * i.e. symbols without data defined properties and without sizes in map units.
+     *
+     * If \a blocking is TRUE, remote images are fetched before returning. WARNING: the \a blocking
+     * parameter must NEVER be TRUE from GUI based applications (like the main QGIS application) or
+     * crashes will result. Only for use in external scripts or QGIS server.
+     *
+     * Returns the number of rendered symbols.
+     *
+     * \since QGIS 3.16
+     */
+    static int prewarmImageCaches( const QgsProject *project, double dpi, bool blocking = false );
 };
 
 class QPolygonF;
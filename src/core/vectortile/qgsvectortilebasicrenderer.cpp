@@ -17,10 +17,12 @@
 
 #include "qgsapplication.h"
 #include "qgscolorschemeregistry.h"
+#include "qgsexpression.h"
 #include "qgsexpressioncontextutils.h"
 #include "qgsfillsymbollayer.h"
 #include "qgslinesymbollayer.h"
 #include "qgsmarkersymbollayer.h"
+#include "qgsrulebasedrendererfilterindex_p.h"
 #include "qgssymbollayerutils.h"
 #include "qgsvectortileutils.h"
 
@@ -102,6 +104,8 @@ QgsVectorTileBasicRenderer::QgsVectorTileBasicRenderer()
 {
 }
 
+QgsVectorTileBasicRenderer::~QgsVectorTileBasicRenderer() = default;
+
 QString QgsVectorTileBasicRenderer::type() const
 {
   return QStringLiteral( "basic" );
@@ -120,13 +124,24 @@ void QgsVectorTileBasicRenderer::startRender( QgsRenderContext &context, int til
   Q_UNUSED( context )
   Q_UNUSED( tileRange )
   // figure out required fields for different layers
-  for ( const QgsVectorTileBasicRendererStyle &layerStyle : qgis::as_const( mStyles ) )
+  // and parse the filters once, instead of once per tile
+  mFilters.clear();
+  mFilterIndexes.clear();
+  for ( int i = 0; i < mStyles.count(); ++i )
   {
+    const QgsVectorTileBasicRendererStyle &layerStyle = mStyles.at( i );
+    std::unique_ptr< QgsExpression > filter;
     if ( layerStyle.isActive( tileZoom ) && !layerStyle.filterExpression().isEmpty() )
     {
-      QgsExpression expr( layerStyle.filterExpression() );
-      mRequiredFields[layerStyle.layerName()].unite( expr.referencedColumns() );
+      filter = qgis::make_unique< QgsExpression >( layerStyle.filterExpression() );
+      mRequiredFields[layerStyle.layerName()].unite( filter->referencedColumns() );
+
+      // styles converted from MapBox GL styles often test a single attribute of a sub-layer
+      // against literal values, these filters are indexed once the fields are known
+      if ( !layerStyle.layerName().isEmpty() )
+        mFilterIndexes[layerStyle.layerName()].styles << i;
     }
+    mFilters.push_back( std::move( filter ) );
   }
 }
 
@@ -135,9 +150,23 @@ QMap<QString, QSet<QString> > QgsVectorTileBasicRenderer::usedAttributes( const
   return mRequiredFields;
 }
 
+QSet<QString> QgsVectorTileBasicRenderer::requiredLayers( QgsRenderContext &, int tileZoom ) const
+{
+  QSet< QString > res;
+  for ( const QgsVectorTileBasicRendererStyle &layerStyle : qgis::as_const( mStyles ) )
+  {
+    // an empty layer name matches all layers
+    if ( layerStyle.isActive( tileZoom ) )
+      res.insert( layerStyle.layerName() );
+  }
+  return res;
+}
+
 void QgsVectorTileBasicRenderer::stopRender( QgsRenderContext &context )
 {
   Q_UNUSED( context )
+  mFilters.clear();
+  mFilterIndexes.clear();
 }
 
 void QgsVectorTileBasicRenderer::renderTile( const QgsVectorTileRendererData &tile, QgsRenderContext &context )
@@ -145,8 +174,50 @@ void QgsVectorTileBasicRenderer::renderTile( const QgsVectorTileRendererData &ti
   const QgsVectorTileFeatures tileData = tile.features();
   int zoomLevel = tile.id().zoomLevel();
 
-  for ( const QgsVectorTileBasicRendererStyle &layerStyle : qgis::as_const( mStyles ) )
+  // positions of the features of the indexed sub-layers whose filter may be TRUE, for each style
+  QHash< int, QVector< int > > candidateFeatures;
+  QVector< int > candidateFilters;
+  for ( auto it = mFilterIndexes.begin(); it != mFilterIndexes.end(); ++it )
   {
+    LayerFilterIndex &filterIndex = it->second;
+    if ( !tileData.contains( it->first ) )
+      continue;
+
+    const QgsFields fields = tile.fields().value( it->first );
+    if ( !filterIndex.built || filterIndex.fields != fields )
+    {
+      QList< const QgsExpression * > filters;
+      for ( int style : qgis::as_const( filterIndex.styles ) )
+        filters << mFilters[ style ].get();
+      filterIndex.index = QgsRuleBasedRendererFilterIndex::create( filters, fields );
+      filterIndex.fields = fields;
+      filterIndex.built = true;
+    }
+    if ( !filterIndex.index )
+      continue;
+
+    for ( int style : qgis::as_const( filterIndex.styles ) )
+      candidateFeatures[ style ].clear();
+
+    const QVector<QgsFeature> features = tileData.value( it->first );
+    for ( int i = 0; i < features.count(); ++i )
+    {
+      if ( filterIndex.index->candidates( features.at( i ), candidateFilters ) )
+      {
+        for ( int filter : qgis::as_const( candidateFilters ) )
+          candidateFeatures[ filterIndex.styles.at( filter ) ] << i;
+      }
+      else
+      {
+        for ( int style : qgis::as_const( filterIndex.styles ) )
+          candidateFeatures[ style ] << i;
+      }
+    }
+  }
+
+  for ( int styleIndex = 0; styleIndex < mStyles.count(); ++styleIndex )
+  {
+    const QgsVectorTileBasicRendererStyle &layerStyle = mStyles.at( styleIndex );
     if ( !layerStyle.isActive( zoomLevel ) )
       continue;
 
@@ -154,60 +225,65 @@ void QgsVectorTileBasicRenderer::renderTile( const QgsVectorTileRendererData &ti
     scope->setFields( tile.fields()[layerStyle.layerName()] );
     QgsExpressionContextScopePopper popper( context.expressionContext(), scope );
 
-    QgsExpression filterExpression( layerStyle.filterExpression() );
-    filterExpression.prepare( &context.expressionContext() );
+    QgsExpression *filterExpression = styleIndex < static_cast< int >( mFilters.size() ) ? mFilters[ styleIndex ].get() : nullptr;
+    if ( filterExpression && filterExpression->isValid() )
+      filterExpression->prepare( &context.expressionContext() );
+    else
+      filterExpression = nullptr;
 
     QgsSymbol *sym = layerStyle.symbol();
     sym->startRender( context, QgsFields() );
+
+    auto renderFeature = [&]( const QgsFeature & f )
+    {
+      // the geometry type is cheaper to test than the filter
+      const QgsWkbTypes::GeometryType featureType = QgsWkbTypes::geometryType( f.geometry().wkbType() );
+      const bool polygonBorder = featureType == QgsWkbTypes::PolygonGeometry && layerStyle.geometryType() == QgsWkbTypes::LineGeometry;
+      if ( featureType != layerStyle.geometryType() && !polygonBorder )
+        return;
+
+      scope->setFeature( f );
+      if ( filterExpression && !filterExpression->evaluate( &context.expressionContext() ).toBool() )
+        return;
+
+      if ( !polygonBorder )
+      {
+        sym->renderFeature( f, context );
+      }
+      else
+      {
+        // be tolerant and permit rendering polygons with a line layer style, as some style definitions use this approach
+        // to render the polygon borders only
+        QgsFeature exterior = f;
+        exterior.setGeometry( QgsGeometry( f.geometry().constGet()->boundary() ) );
+        sym->renderFeature( exterior, context );
+      }
+    };
+
     if ( layerStyle.layerName().isEmpty() )
     {
       // matching all layers
       for ( QString layerName : tileData.keys() )
       {
         for ( const QgsFeature &f : tileData[layerName] )
-        {
-          scope->setFeature( f );
-          if ( filterExpression.isValid() && !filterExpression.evaluate( &context.expressionContext() ).toBool() )
-            continue;
-
-          const QgsWkbTypes::GeometryType featureType = QgsWkbTypes::geometryType( f.geometry().wkbType() );
-          if ( featureType == layerStyle.geometryType() )
-          {
-            sym->renderFeature( f, context );
-          }
-          else if ( featureType == QgsWkbTypes::PolygonGeometry && layerStyle.geometryType() == QgsWkbTypes::LineGeometry )
-          {
-            // be tolerant and permit rendering polygons with a line layer style, as some style definitions use this approach
-            // to render the polygon borders only
-            QgsFeature exterior = f;
-            exterior.setGeometry( QgsGeometry( f.geometry().constGet()->boundary() ) );
-            sym->renderFeature( exterior, context );
-          }
-        }
+          renderFeature( f );
       }
     }
     else if ( tileData.contains( layerStyle.layerName() ) )
     {
       // matching one particular layer
-      for ( const QgsFeature &f : tileData[layerStyle.layerName()] )
+      const QVector<QgsFeature> features = tileData.value( layerStyle.layerName() );
+      auto candidatesIt = candidateFeatures.constFind( styleIndex );
+      if ( candidatesIt != candidateFeatures.constEnd() )
+      {
+        // the filter of this style is FALSE for the other features
+        for ( int i : *candidatesIt )
+          renderFeature( features.at( i ) );
+      }
+      else
       {
-        scope->setFeature( f );
-        if ( filterExpression.isValid() && !filterExpression.evaluate( &context.expressionContext() ).toBool() )
-          continue;
-
-        const QgsWkbTypes::GeometryType featureType = QgsWkbTypes::geometryType( f.geometry().wkbType() );
-        if ( featureType == layerStyle.geometryType() )
-        {
-          sym->renderFeature( f, context );
-        }
-        else if ( featureType == QgsWkbTypes::PolygonGeometry && layerStyle.geometryType() == QgsWkbTypes::LineGeometry )
-        {
-          // be tolerant and permit rendering polygons with a line layer style, as some style definitions use this approach
-          // to render the polygon borders only
-          QgsFeature exterior = f;
-          exterior.setGeometry( QgsGeometry( f.geometry().constGet()->boundary() ) );
-          sym->renderFeature( exterior, context );
-        }
+        for ( const QgsFeature &f : features )
+          renderFeature( f );
       }
     }
     sym->stopRender( context );
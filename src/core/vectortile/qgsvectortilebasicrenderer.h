@@ -21,11 +21,17 @@
 
 #include "qgsvectortilerenderer.h"
 
+#include <map>
+#include <memory>
+#include <vector>
+
+class QgsExpression;
 class QgsLineSymbol;
 class QgsFillSymbol;
 class QgsMarkerSymbol;
 
 class QgsSymbol;
+class QgsRuleBasedRendererFilterIndex;
 
 /**
  * \ingroup core
@@ -129,11 +135,13 @@ class CORE_EXPORT QgsVectorTileBasicRenderer : public QgsVectorTileRenderer
   public:
     //! Constructs renderer with no styles
     QgsVectorTileBasicRenderer();
+    ~QgsVectorTileBasicRenderer() override;
 
     QString type() const override;
     QgsVectorTileBasicRenderer *clone() const override SIP_FACTORY;
     void startRender( QgsRenderContext &context, int tileZoom, const QgsTileRange &tileRange ) override;
     QMap<QString, QSet<QString> > usedAttributes( const QgsRenderContext & ) override SIP_SKIP;
+    QSet< QString > requiredLayers( QgsRenderContext &context, int tileZoom ) const override;
     void stopRender( QgsRenderContext &context ) override;
     void renderTile( const QgsVectorTileRendererData &tile, QgsRenderContext &context ) override;
     void writeXml( QDomElement &elem, const QgsReadWriteContext &context ) const override;
@@ -169,6 +177,24 @@ class CORE_EXPORT QgsVectorTileBasicRenderer : public QgsVectorTileRenderer
     //! Names of required fields for each sub-layer (only valid between startRender/stopRender calls)
     QMap<QString, QSet<QString> > mRequiredFields;
 
+#ifndef SIP_RUN
+    //! Index of the filters of the styles of a sub-layer, built for the fields of its first tile
+    struct LayerFilterIndex
+    {
+      bool built = false;
+      QgsFields fields;
+      std::unique_ptr< QgsRuleBasedRendererFilterIndex > index;
+      //! Positions in mStyles of the indexed styles
+      QVector< int > styles;
+    };
+
+    //! Parsed filters of the styles, nullptr for styles without filter (only valid between startRender/stopRender calls)
+    std::vector< std::unique_ptr< QgsExpression > > mFilters;
+
+    //! Filter indexes of the sub-layers (only valid between startRender/stopRender calls)
+    std::map< QString, LayerFilterIndex > mFilterIndexes;
+#endif
+
 };
 
 #endif // QGSVECTORTILEBASICRENDERER_H
@@ -39,6 +39,12 @@ class QgsVectorTileLabelProvider : public QgsVectorLayerLabelProvider
     //! Returns field names for each sub-layer that are required for labeling
     virtual QMap<QString, QSet<QString> > usedAttributes( const QgsRenderContext &context, int tileZoom ) const = 0;
 
+    /**
+     * Returns the names of the sub-layers that are labeled at the \a tileZoom level. An empty string
+     * in the set means that all sub-layers are required. The default implementation requires all sub-layers.
+     */
+    virtual QSet< QString > requiredLayers( QgsRenderContext &context, int tileZoom ) const { Q_UNUSED( context ) Q_UNUSED( tileZoom ) return QSet< QString >() << QString(); }
+
     //! Sets fields for each sub-layer
     virtual void setFields( const QMap<QString, QgsFields> &perLayerFields ) = 0;
 
@@ -15,7 +15,13 @@
 
 #include "qgsvectortilelayerrenderer.h"
 
+#include <QCache>
+#include <QCryptographicHash>
 #include <QElapsedTimer>
+#include <QMutex>
+#include <QtConcurrentRun>
+
+#include <algorithm>
 
 #include "qgsexpressioncontextutils.h"
 #include "qgsfeedback.h"
@@ -30,6 +36,42 @@
 #include "qgsvectortilelabeling.h"
 #include "qgsmapclippingutils.h"
 
+//! Maximum total estimated size of the features in the decoded tile cache, in kilobytes
+static const int DECODED_TILE_CACHE_SIZE = 64 * 1024;
+
+/**
+ * Features of the decoded tiles, shared by all the vector tile layer renderers, so that the tiles
+ * are not decoded again while the map is panned. The entries are keyed by the content of the raw
+ * tiles, and their cost is the estimated size of the decoded features in kilobytes.
+ */
+static QCache<QString, QgsVectorTileFeatures> sDecodedTileCache( DECODED_TILE_CACHE_SIZE );
+//! Mutex to protect the decoded tile cache
+static QMutex sDecodedTileCacheMutex;
+
+//! Returns an estimate of the memory used by decoded \a features, in kilobytes
+static int decodedTileCost( const QgsVectorTileFeatures &features )
+{
+  qint64 bytes = 0;
+  for ( auto it = features.constBegin(); it != features.constEnd(); ++it )
+  {
+    for ( const QgsFeature &feature : it.value() )
+    {
+      // feature and geometry private data, attribute values
+      bytes += 256;
+      const QgsAttributes attributes = feature.attributes();
+      bytes += static_cast< qint64 >( attributes.size() ) * sizeof( QVariant );
+      for ( const QVariant &value : attributes )
+      {
+        if ( value.type() == QVariant::String )
+          bytes += static_cast< qint64 >( value.toString().size() ) * sizeof( QChar );
+      }
+      if ( const QgsAbstractGeometry *geometry = feature.geometry().constGet() )
+        bytes += static_cast< qint64 >( geometry->nCoordinates() ) * 2 * sizeof( double );
+    }
+  }
+  return static_cast< int >( std::min< qint64 >( bytes / 1024 + 1, DECODED_TILE_CACHE_SIZE ) );
+}
+
 QgsVectorTileLayerRenderer::QgsVectorTileLayerRenderer( QgsVectorTileLayer *layer, QgsRenderContext &context )
   : QgsMapLayerRenderer( layer->id(), &context )
   , mSourceType( layer->sourceType() )
@@ -122,7 +164,10 @@ bool QgsVectorTileLayerRenderer::render()
     {
       QgsDebugMsgLevel( QStringLiteral( "Got tile asynchronously: " ) + rawTile.id.toString(), 2 );
       if ( !rawTile.data.isEmpty() )
-        decodeAndDrawTile( rawTile );
+      {
+        enqueueTile( rawTile );
+        drawDecodedTiles( false );
+      }
     } );
   }
 
@@ -151,6 +196,24 @@ bool QgsVectorTileLayerRenderer::render()
   for ( QString layerName : requiredFields.keys() )
     mPerLayerFields[layerName] = QgsVectorTileUtils::makeQgisFields( requiredFields[layerName] );
 
+  // sub-layers which are neither rendered nor labeled at this zoom level are not decoded
+  mRequiredLayers = mRenderer->requiredLayers( ctx, mTileZoom );
+  if ( mLabelProvider )
+    mRequiredLayers.unite( mLabelProvider->requiredLayers( ctx, mTileZoom ) );
+  mAllLayersRequired = mRequiredLayers.contains( QString() );
+
+  // decoded features only depend on the tile, the sub-layers, the fields and the coordinate transform
+  mTransform = ctx.coordinateTransform();
+  mDecodedTileCacheKey = mSourceType + '|' + mSourcePath + '|' + mTransform.sourceCrs().authid() + '|' + mTransform.destinationCrs().toWkt() + '|' + mTransform.coordinateOperation();
+  for ( auto it = mPerLayerFields.constBegin(); it != mPerLayerFields.constEnd(); ++it )
+    mDecodedTileCacheKey += '|' + it.key() + ':' + it.value().names().join( ',' );
+  if ( !mAllLayersRequired )
+  {
+    QStringList requiredLayers = mRequiredLayers.toList();
+    requiredLayers.sort();
+    mDecodedTileCacheKey += "|layers:" + requiredLayers.join( ',' );
+  }
+
   if ( mLabelProvider )
   {
     mLabelProvider->setFields( mPerLayerFields );
@@ -164,19 +227,20 @@ bool QgsVectorTileLayerRenderer::render()
 
   if ( !isAsync )
   {
-    for ( QgsVectorTileRawData &rawTile : rawTiles )
+    // tiles are decoded in parallel, and drawn in their fetching order
+    for ( const QgsVectorTileRawData &rawTile : qgis::as_const( rawTiles ) )
     {
-      if ( ctx.renderingStopped() )
-        break;
-
-      decodeAndDrawTile( rawTile );
+      if ( !rawTile.data.isEmpty() )
+        enqueueTile( rawTile );
     }
+    drawDecodedTiles( true );
   }
   else
   {
     // Block until tiles are fetched and rendered. If the rendering gets canceled at some point,
     // the async loader will catch the signal, abort requests and return from downloadBlocking()
     asyncLoader->downloadBlocking();
+    drawDecodedTiles( true );
   }
 
   mRenderer->stopRender( ctx );
@@ -188,39 +252,89 @@ bool QgsVectorTileLayerRenderer::render()
   return !ctx.renderingStopped();
 }
 
-void QgsVectorTileLayerRenderer::decodeAndDrawTile( const QgsVectorTileRawData &rawTile )
+QgsVectorTileLayerRenderer::DecodedTile QgsVectorTileLayerRenderer::decodeTile( const QgsVectorTileRawData &rawTile ) const
 {
-  QgsRenderContext &ctx = *renderContext();
+  DecodedTile decodedTile;
+  decodedTile.id = rawTile.id;
 
-  QgsDebugMsgLevel( QStringLiteral( "Drawing tile " ) + rawTile.id.toString(), 2 );
+  if ( mFeedback->isCanceled() )
+    return decodedTile;
 
   QElapsedTimer tLoad;
   tLoad.start();
 
+  // the content of a remote tile or of a tile in a file may change after it was cached
+  const QString cacheKey = mDecodedTileCacheKey + '|' + rawTile.id.toString() + '|'
+                           + QString::fromLatin1( QCryptographicHash::hash( rawTile.data, QCryptographicHash::Md5 ).toHex() );
+  {
+    QMutexLocker locker( &sDecodedTileCacheMutex );
+    if ( const QgsVectorTileFeatures *features = sDecodedTileCache.object( cacheKey ) )
+    {
+      decodedTile.features = *features;
+      decodedTile.valid = true;
+      decodedTile.decodeTime = tLoad.elapsed();
+      return decodedTile;
+    }
+  }
+
   // currently only MVT encoding supported
   QgsVectorTileMVTDecoder decoder;
   if ( !decoder.decode( rawTile.id, rawTile.data ) )
   {
     QgsDebugMsgLevel( QStringLiteral( "Failed to parse raw tile data! " ) + rawTile.id.toString(), 2 );
-    return;
+    return decodedTile;
   }
 
-  if ( ctx.renderingStopped() )
-    return;
+  if ( mFeedback->isCanceled() )
+    return decodedTile;
 
-  QgsCoordinateTransform ct = ctx.coordinateTransform();
+  // each thread uses its own copy of the transform
+  const QgsCoordinateTransform ct = mTransform;
+  decodedTile.features = decoder.layerFeatures( mPerLayerFields, ct, mAllLayersRequired ? nullptr : &mRequiredLayers );
+  decodedTile.valid = true;
 
-  QgsVectorTileRendererData tile( rawTile.id );
-  tile.setFields( mPerLayerFields );
-  tile.setFeatures( decoder.layerFeatures( mPerLayerFields, ct ) );
-  tile.setTilePolygon( QgsVectorTileUtils::tilePolygon( rawTile.id, ct, mTileMatrix, ctx.mapToPixel() ) );
+  {
+    QMutexLocker locker( &sDecodedTileCacheMutex );
+    sDecodedTileCache.insert( cacheKey, new QgsVectorTileFeatures( decodedTile.features ), decodedTileCost( decodedTile.features ) );
+  }
 
-  mTotalDecodeTime += tLoad.elapsed();
+  decodedTile.decodeTime = tLoad.elapsed();
+  return decodedTile;
+}
+
+void QgsVectorTileLayerRenderer::enqueueTile( const QgsVectorTileRawData &rawTile )
+{
+  mDecodingTiles.enqueue( QtConcurrent::run( [this, rawTile]() -> DecodedTile
+  {
+    return decodeTile( rawTile );
+  } ) );
+}
+
+void QgsVectorTileLayerRenderer::drawDecodedTiles( bool waitForAll )
+{
+  while ( !mDecodingTiles.isEmpty() && ( waitForAll || mDecodingTiles.head().isFinished() ) )
+  {
+    // result() waits for the tile to be decoded, which must happen even when the rendering is canceled
+    const DecodedTile decodedTile = mDecodingTiles.dequeue().result();
+    if ( decodedTile.valid && !renderContext()->renderingStopped() )
+      drawTile( decodedTile );
+  }
+}
+
+void QgsVectorTileLayerRenderer::drawTile( const DecodedTile &decodedTile )
+{
+  QgsRenderContext &ctx = *renderContext();
+
+  QgsDebugMsgLevel( QStringLiteral( "Drawing tile " ) + decodedTile.id.toString(), 2 );
+
+  QgsVectorTileRendererData tile( decodedTile.id );
+  tile.setFields( mPerLayerFields );
+  tile.setFeatures( decodedTile.features );
 
   // calculate tile polygon in screen coordinates
+  tile.setTilePolygon( QgsVectorTileUtils::tilePolygon( decodedTile.id, mTransform, mTileMatrix, ctx.mapToPixel() ) );
 
-  if ( ctx.renderingStopped() )
-    return;
+  mTotalDecodeTime += decodedTile.decodeTime;
 
   // set up clipping so that rendering does not go behind tile's extent
   QgsScopedQPainterState savePainterState( ctx.painter() );
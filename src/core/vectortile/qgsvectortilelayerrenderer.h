@@ -27,13 +27,16 @@ class QgsVectorTileLabelProvider;
 #include "qgsvectortilerenderer.h"
 #include "qgsmapclippingregion.h"
 
+#include <QFuture>
+#include <QQueue>
+
 /**
  * \ingroup core
  * This class provides map rendering functionality for vector tile layers.
  * In render() function (assumed to be run in a worker thread) it will:
  *
  * # fetch vector tiles using QgsVectorTileLoader
- * # decode raw tiles into QgsFeature objects using QgsVectorTileDecoder
+ * # decode raw tiles into QgsFeature objects using QgsVectorTileDecoder (on worker threads of the global thread pool)
  * # render tiles using a class derived from QgsVectorTileRenderer
  *
  * \since QGIS 3.14
@@ -48,7 +51,24 @@ class QgsVectorTileLayerRenderer : public QgsMapLayerRenderer
     virtual QgsFeedback *feedback() const override { return mFeedback.get(); }
 
   private:
-    void decodeAndDrawTile( const QgsVectorTileRawData &rawTile );
+
+    //! Features decoded from a raw tile
+    struct DecodedTile
+    {
+      QgsTileXYZ id;
+      QgsVectorTileFeatures features;
+      //! Elapsed time to decode the tile (ms)
+      int decodeTime = 0;
+      bool valid = false;
+    };
+
+    //! Decodes a raw tile or gets its features from the decoded tile cache. Thread safe
+    DecodedTile decodeTile( const QgsVectorTileRawData &rawTile ) const;
+    //! Starts decoding a raw tile on a worker thread
+    void enqueueTile( const QgsVectorTileRawData &rawTile );
+    //! Draws the decoded tiles in the order they were enqueued, waiting for them if \a waitForAll is TRUE, or until a tile is still being decoded otherwise
+    void drawDecodedTiles( bool waitForAll );
+    void drawTile( const DecodedTile &decodedTile );
 
     // data coming from the vector tile layer
 
@@ -88,6 +108,16 @@ class QgsVectorTileLayerRenderer : public QgsMapLayerRenderer
     QgsTileRange mTileRange;
     //! Cached QgsFields object for each sub-layer that will be rendered
     QMap<QString, QgsFields> mPerLayerFields;
+    //! Names of the sub-layers to decode, if not all of them are used by the renderer and the labeling
+    QSet<QString> mRequiredLayers;
+    //! Whether all sub-layers must be decoded
+    bool mAllLayersRequired = true;
+    //! Transform from the tile CRS to the map CRS
+    QgsCoordinateTransform mTransform;
+    //! Prefix of the keys of the rendered tiles in the decoded tile cache
+    QString mDecodedTileCacheKey;
+    //! Tiles being decoded, in the order they are drawn
+    QQueue< QFuture< DecodedTile > > mDecodingTiles;
     //! Counter of total elapsed time to decode tiles (ms)
     int mTotalDecodeTime = 0;
     //! Counter of total elapsed time to render tiles (ms)
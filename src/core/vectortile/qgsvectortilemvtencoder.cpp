@@ -148,6 +148,11 @@ QgsVectorTileMVTEncoder::QgsVectorTileMVTEncoder( QgsTileXYZ tileID )
 }
 
 void QgsVectorTileMVTEncoder::addLayer( QgsVectorLayer *layer, QgsFeedback *feedback, QString filterExpression, QString layerName )
+{
+  addLayer( layer, layer->attributeList(), feedback, filterExpression, layerName );
+}
+
+void QgsVectorTileMVTEncoder::addLayer( QgsVectorLayer *layer, const QgsAttributeList &attributes, QgsFeedback *feedback, QString filterExpression, QString layerName )
 {
   if ( feedback && feedback->isCanceled() )
     return;
@@ -174,14 +179,24 @@ void QgsVectorTileMVTEncoder::addLayer( QgsVectorLayer *layer, QgsFeedback *feed
 
   // add buffer to both filter extent in layer CRS (for feature request) and tile extent in target CRS (for clipping)
   double bufferRatio = static_cast<double>( mBuffer ) / mResolution;
-  QgsRectangle tileExtent = mTileExtent;
-  tileExtent.grow( bufferRatio * mTileExtent.width() );
+  const QgsRectangle tileExtent = bufferedTileExtent();
+  const double onePixel = std::max( layerTileExtent.width(), layerTileExtent.height() ) / mResolution;
   layerTileExtent.grow( bufferRatio * std::max( layerTileExtent.width(), layerTileExtent.height() ) );
 
   QgsFeatureRequest request;
   request.setFilterRect( layerTileExtent );
+  request.setSubsetOfAttributes( attributes );
   if ( !filterExpression.isEmpty() )
     request.setFilterExpression( filterExpression );
+  if ( mSimplifyGeometries )
+  {
+    // vertices closer than one pixel of the tile are merged by the encoding
+    QgsSimplifyMethod simplifyMethod;
+    simplifyMethod.setMethodType( QgsSimplifyMethod::OptimizeForRendering );
+    simplifyMethod.setTolerance( onePixel );
+    simplifyMethod.setThreshold( 1 );
+    request.setSimplifyMethod( simplifyMethod );
+  }
   QgsFeatureIterator fit = layer->getFeatures( request );
 
   QgsFeature f;
@@ -190,16 +205,7 @@ void QgsVectorTileMVTEncoder::addLayer( QgsVectorLayer *layer, QgsFeedback *feed
     return;  // nothing to write - do not add the layer at all
   }
 
-  vector_tile::Tile_Layer *tileLayer = tile.add_layers();
-  tileLayer->set_name( layerName.toUtf8() );
-  tileLayer->set_version( 2 );  // 2 means MVT spec version 2.1
-  tileLayer->set_extent( static_cast<::google::protobuf::uint32>( mResolution ) );
-
-  const QgsFields fields = layer->fields();
-  for ( int i = 0; i < fields.count(); ++i )
-  {
-    tileLayer->add_keys( fields[i].name().toUtf8() );
-  }
+  vector_tile::Tile_Layer *tileLayer = addTileLayer( layerName, layer->fields(), attributes );
 
   do
   {
@@ -224,14 +230,59 @@ void QgsVectorTileMVTEncoder::addLayer( QgsVectorLayer *layer, QgsFeedback *feed
 
     f.setGeometry( g );
 
-    addFeature( tileLayer, f );
+    addFeature( tileLayer, f, attributes );
   }
   while ( fit.nextFeature( f ) );
 
   mKnownValues.clear();
 }
 
-void QgsVectorTileMVTEncoder::addFeature( vector_tile::Tile_Layer *tileLayer, const QgsFeature &f )
+void QgsVectorTileMVTEncoder::addLayerFeatures( const QString &layerName, const QgsFields &fields, const QgsAttributeList &attributes, const QVector<QgsFeature> &features, QgsFeedback *feedback )
+{
+  if ( features.isEmpty() || ( feedback && feedback->isCanceled() ) )
+    return;
+
+  const QgsRectangle tileExtent = bufferedTileExtent();
+  vector_tile::Tile_Layer *tileLayer = addTileLayer( layerName, fields, attributes );
+
+  for ( QgsFeature f : features )
+  {
+    if ( feedback && feedback->isCanceled() )
+      break;
+
+    const QgsGeometry g = f.geometry().clipped( tileExtent );
+    if ( g.isEmpty() )
+      continue;
+
+    f.setGeometry( g );
+    addFeature( tileLayer, f, attributes );
+  }
+
+  mKnownValues.clear();
+}
+
+QgsRectangle QgsVectorTileMVTEncoder::bufferedTileExtent() const
+{
+  QgsRectangle tileExtent = mTileExtent;
+  tileExtent.grow( static_cast<double>( mBuffer ) / mResolution * mTileExtent.width() );
+  return tileExtent;
+}
+
+vector_tile::Tile_Layer *QgsVectorTileMVTEncoder::addTileLayer( const QString &layerName, const QgsFields &fields, const QgsAttributeList &attributes )
+{
+  vector_tile::Tile_Layer *tileLayer = tile.add_layers();
+  tileLayer->set_name( layerName.toUtf8() );
+  tileLayer->set_version( 2 );  // 2 means MVT spec version 2.1
+  tileLayer->set_extent( static_cast<::google::protobuf::uint32>( mResolution ) );
+
+  for ( int attribute : attributes )
+  {
+    tileLayer->add_keys( fields.at( attribute ).name().toUtf8() );
+  }
+  return tileLayer;
+}
+
+void QgsVectorTileMVTEncoder::addFeature( vector_tile::Tile_Layer *tileLayer, const QgsFeature &f, const QgsAttributeList &attributes )
 {
   QgsGeometry g = f.geometry();
   QgsWkbTypes::GeometryType geomType = g.type();
@@ -257,9 +308,9 @@ void QgsVectorTileMVTEncoder::addFeature( vector_tile::Tile_Layer *tileLayer, co
   //
 
   const QgsAttributes attrs = f.attributes();
-  for ( int i = 0; i < attrs.count(); ++i )
+  for ( int i = 0; i < attributes.count(); ++i )
   {
-    const QVariant v = attrs.at( i );
+    const QVariant v = attrs.value( attributes.at( i ) );
     if ( !v.isValid() || v.isNull() )
       continue;
 
@@ -56,6 +56,21 @@ class CORE_EXPORT QgsVectorTileMVTEncoder
     //! Sets coordinate transform context for transforms between layers and tile matrix CRS
     void setTransformContext( const QgsCoordinateTransformContext &transformContext ) { mTransformContext = transformContext; }
 
+    /**
+     * Returns whether the geometries are simplified to the resolution of the tile when
+     * they are fetched from the layers. The default is FALSE.
+     * \since QGIS 3.16
+     */
+    bool simplifyGeometries() const { return mSimplifyGeometries; }
+
+    /**
+     * Sets whether the geometries are simplified to the resolution of the tile when they
+     * are fetched from the layers. The providers able to simplify the geometries (e.g.
+     * PostGIS) then send fewer vertices, which are dropped by the encoding anyway.
+     * \since QGIS 3.16
+     */
+    void setSimplifyGeometries( bool simplify ) { mSimplifyGeometries = simplify; }
+
     /**
      * Fetches data from vector layer for the given tile, does reprojection and clipping
      *
@@ -63,16 +78,46 @@ class CORE_EXPORT QgsVectorTileMVTEncoder
      */
     void addLayer( QgsVectorLayer *layer, QgsFeedback *feedback = nullptr, QString filterExpression = QString(), QString layerName = QString() );
 
+    /**
+     * Fetches data from vector layer for the given tile, does reprojection and clipping.
+     * Only the fields with the indexes in \a attributes are encoded.
+     *
+     * Optional feedback object may be provided to support cancellation.
+     * \since QGIS 3.16
+     */
+    void addLayer( QgsVectorLayer *layer, const QgsAttributeList &attributes, QgsFeedback *feedback = nullptr, QString filterExpression = QString(), QString layerName = QString() );
+
+    /**
+     * Adds already fetched \a features as a layer with the given \a layerName, and clips them to the tile.
+     * The geometries of the features must be in EPSG:3857. Only the fields of \a fields with the indexes
+     * in \a attributes are encoded. The layer is not added if there are no features.
+     *
+     * Unlike addLayer(), this method does not access any vector layer, so encoders of different tiles
+     * can add the same features from several threads at once.
+     *
+     * Optional feedback object may be provided to support cancellation.
+     * \since QGIS 3.16
+     */
+    void addLayerFeatures( const QString &layerName, const QgsFields &fields, const QgsAttributeList &attributes, const QVector<QgsFeature> &features, QgsFeedback *feedback = nullptr );
+
+    /**
+     * Returns the extent of the tile grown by the tile buffer, in EPSG:3857. The features are clipped to this extent.
+     * \since QGIS 3.16
+     */
+    QgsRectangle bufferedTileExtent() const;
+
     //! Encodes MVT using data stored previously with addLayer() calls
     QByteArray encode() const;
 
   private:
-    void addFeature( vector_tile::Tile_Layer *tileLayer, const QgsFeature &f );
+    vector_tile::Tile_Layer *addTileLayer( const QString &layerName, const QgsFields &fields, const QgsAttributeList &attributes );
+    void addFeature( vector_tile::Tile_Layer *tileLayer, const QgsFeature &f, const QgsAttributeList &attributes );
 
   private:
     QgsTileXYZ mTileID;
     int mResolution = 4096;
     int mBuffer = 256;
+    bool mSimplifyGeometries = false;
     QgsCoordinateTransformContext mTransformContext;
 
     QgsRectangle mTileExtent;
@@ -115,6 +115,15 @@ class CORE_EXPORT QgsVectorTileRenderer
     //! Returns field names of sub-layers that will be used for rendering. Must be called between startRender/stopRender.
     virtual QMap<QString, QSet<QString> > usedAttributes( const QgsRenderContext & ) SIP_SKIP { return QMap<QString, QSet<QString> >(); }
 
+    /**
+     * Returns the names of the sub-layers that will be rendered at the \a tileZoom level, so that
+     * the other sub-layers of the tiles are not decoded. An empty string in the set means that all
+     * sub-layers are required. The default implementation requires all sub-layers.
+     * Must be called between startRender/stopRender.
+     * \since QGIS 3.16
+     */
+    virtual QSet< QString > requiredLayers( QgsRenderContext &context, int tileZoom ) const { Q_UNUSED( context ) Q_UNUSED( tileZoom ) return QSet< QString >() << QString(); }
+
     //! Finishes rendering and cleans up any resources
     virtual void stopRender( QgsRenderContext &context ) = 0;
 
@@ -20,6 +20,7 @@
 #include "qgsjsonutils.h"
 #include "qgslogger.h"
 #include "qgsmbtiles.h"
+#include "qgsspatialindexpackedrtree.h"
 #include "qgstiles.h"
 #include "qgsvectorlayer.h"
 #include "qgsvectortilemvtencoder.h"
@@ -31,7 +32,97 @@
 #include <QFile>
 #include <QFileInfo>
 #include <QUrl>
+#include <QtConcurrentMap>
 
+#include <algorithm>
+
+//! Number of tiles encoded in parallel before they are written at once
+static const int TILES_PER_BATCH = 1024;
+
+///@cond PRIVATE
+
+//! Features of an input layer, reprojected to EPSG:3857, with an index of their bounding boxes
+struct QgsVectorTileWriterLayerFeatures
+{
+  QString layerName;
+  QgsFields fields;
+  QgsAttributeList attributes;
+  int minZoom = -1;
+  int maxZoom = -1;
+  QVector<QgsFeature> features;
+  //! Index of the features by their position in the features vector
+  std::unique_ptr<QgsSpatialIndexPackedRTree> index;
+};
+
+//! Tile encoded on a worker thread
+struct QgsVectorTileWriterEncodedTile
+{
+  QgsTileXYZ id;
+  QByteArray data;
+};
+
+/**
+ * Reads the features of a \a layer within the \a extent (in EPSG:3857) once, and indexes them.
+ * Returns false if the operation was canceled.
+ */
+static bool readLayerFeatures( const QgsVectorTileWriter::Layer &layer, const QgsRectangle &extent, const QgsCoordinateTransformContext &transformContext,
+                               QgsFeedback *feedback, QgsVectorTileWriterLayerFeatures &layerFeatures )
+{
+  QgsVectorLayer *vl = layer.layer();
+  layerFeatures.layerName = layer.layerName().isEmpty() ? vl->name() : layer.layerName();
+  layerFeatures.fields = vl->fields();
+  layerFeatures.attributes = vl->attributeList();
+  layerFeatures.minZoom = layer.minZoom();
+  layerFeatures.maxZoom = layer.maxZoom();
+
+  QgsCoordinateTransform ct( vl->crs(), QgsCoordinateReferenceSystem( "EPSG:3857" ), transformContext );
+
+  QgsFeatureRequest request;
+  try
+  {
+    request.setFilterRect( ct.transformBoundingBox( extent, QgsCoordinateTransform::ReverseTransform ) );
+  }
+  catch ( const QgsCsException & )
+  {
+    QgsDebugMsg( "Failed to reproject output extent to the layer" );
+  }
+  if ( !layer.filterExpression().isEmpty() )
+    request.setFilterExpression( layer.filterExpression() );
+
+  QVector<QgsFeatureId> ids;
+  QVector<QgsRectangle> boundingBoxes;
+  QgsFeatureIterator fit = vl->getFeatures( request );
+  QgsFeature f;
+  while ( fit.nextFeature( f ) )
+  {
+    if ( feedback && feedback->isCanceled() )
+      return false;
+
+    if ( !f.hasGeometry() )
+      continue;
+
+    QgsGeometry g = f.geometry();
+    try
+    {
+      g.transform( ct );
+    }
+    catch ( const QgsCsException & )
+    {
+      QgsDebugMsg( "Failed to reproject geometry " + QString::number( f.id() ) );
+      continue;
+    }
+    f.setGeometry( g );
+
+    ids << layerFeatures.features.count();
+    boundingBoxes << g.boundingBox();
+    layerFeatures.features << f;
+  }
+
+  layerFeatures.index.reset( new QgsSpatialIndexPackedRTree( ids, boundingBoxes ) );
+  return true;
+}
+
+///@endcond
 
 QgsVectorTileWriter::QgsVectorTileWriter()
 {
@@ -151,28 +242,98 @@ bool QgsVectorTileWriter::writeTiles( QgsFeedback *feedback )
     }
   }
 
+  // the features of each layer are read once, for the tiles of all the zoom levels, which cover
+  // a larger extent than the output extent, with their buffer
+  QgsRectangle readExtent;
+  for ( int zoomLevel = mMinZoom; zoomLevel <= mMaxZoom; ++zoomLevel )
+  {
+    QgsTileMatrix tileMatrix = QgsTileMatrix::fromWebMercator( zoomLevel );
+    QgsTileRange tileRange = tileMatrix.tileRangeFromExtent( outputExtent );
+    QgsVectorTileMVTEncoder firstTileEncoder( QgsTileXYZ( tileRange.startColumn(), tileRange.startRow(), zoomLevel ) );
+    QgsVectorTileMVTEncoder lastTileEncoder( QgsTileXYZ( tileRange.endColumn(), tileRange.endRow(), zoomLevel ) );
+    readExtent.combineExtentWith( firstTileEncoder.bufferedTileExtent() );
+    readExtent.combineExtentWith( lastTileEncoder.bufferedTileExtent() );
+  }
+
+  std::vector< std::unique_ptr<QgsVectorTileWriterLayerFeatures> > layersFeatures;
+  for ( const Layer &layer : qgis::as_const( mLayers ) )
+  {
+    if ( ( layer.minZoom() >= 0 && mMaxZoom < layer.minZoom() ) ||
+         ( layer.maxZoom() >= 0 && mMinZoom > layer.maxZoom() ) )
+      continue;
+
+    std::unique_ptr<QgsVectorTileWriterLayerFeatures> layerFeatures = qgis::make_unique<QgsVectorTileWriterLayerFeatures>();
+    if ( !readLayerFeatures( layer, readExtent, mTransformContext, feedback, *layerFeatures ) )
+    {
+      mErrorMessage = tr( "Operation has been canceled" );
+      return false;
+    }
+    layersFeatures.push_back( std::move( layerFeatures ) );
+  }
+
+  const bool gzipTiles = static_cast<bool>( mbtiles );
   int tilesCreated = 0;
   for ( int zoomLevel = mMinZoom; zoomLevel <= mMaxZoom; ++zoomLevel )
   {
     QgsTileMatrix tileMatrix = QgsTileMatrix::fromWebMercator( zoomLevel );
 
+    QList<const QgsVectorTileWriterLayerFeatures *> zoomLayersFeatures;
+    for ( const std::unique_ptr<QgsVectorTileWriterLayerFeatures> &layerFeatures : layersFeatures )
+    {
+      if ( ( layerFeatures->minZoom >= 0 && zoomLevel < layerFeatures->minZoom ) ||
+           ( layerFeatures->maxZoom >= 0 && zoomLevel > layerFeatures->maxZoom ) )
+        continue;
+
+      zoomLayersFeatures << layerFeatures.get();
+    }
+
+    // the tiles are clipped and encoded in parallel, by batches, then written in order
+    auto encodeTile = [&zoomLayersFeatures, gzipTiles, feedback]( QgsVectorTileWriterEncodedTile & tile )
+    {
+      QgsVectorTileMVTEncoder encoder( tile.id );
+      const QgsRectangle tileExtent = encoder.bufferedTileExtent();
+      for ( const QgsVectorTileWriterLayerFeatures *layerFeatures : zoomLayersFeatures )
+      {
+        QList<QgsFeatureId> ids = layerFeatures->index->intersects( tileExtent );
+        if ( ids.isEmpty() )
+          continue;
+
+        // keep the order of the features in the layer
+        std::sort( ids.begin(), ids.end() );
+        QVector<QgsFeature> features;
+        features.reserve( ids.count() );
+        for ( QgsFeatureId id : qgis::as_const( ids ) )
+          features << layerFeatures->features.at( static_cast<int>( id ) );
+
+        encoder.addLayerFeatures( layerFeatures->layerName, layerFeatures->fields, layerFeatures->attributes, features, feedback );
+      }
+
+      if ( feedback && feedback->isCanceled() )
+        return;
+
+      QByteArray tileData = encoder.encode();
+      if ( gzipTiles && !tileData.isEmpty() )
+        QgsMbTiles::encodeGzip( tileData, tile.data );
+      else
+        tile.data = tileData;
+    };
+
     QgsTileRange tileRange = tileMatrix.tileRangeFromExtent( outputExtent );
+    QVector<QgsVectorTileWriterEncodedTile> tiles;
+    tiles.reserve( TILES_PER_BATCH );
     for ( int row = tileRange.startRow(); row <= tileRange.endRow(); ++row )
     {
       for ( int col = tileRange.startColumn(); col <= tileRange.endColumn(); ++col )
       {
-        QgsTileXYZ tileID( col, row, zoomLevel );
-        QgsVectorTileMVTEncoder encoder( tileID );
-        encoder.setTransformContext( mTransformContext );
+        QgsVectorTileWriterEncodedTile tile;
+        tile.id = QgsTileXYZ( col, row, zoomLevel );
+        tiles << tile;
 
-        for ( const Layer &layer : qgis::as_const( mLayers ) )
-        {
-          if ( ( layer.minZoom() >= 0 && zoomLevel < layer.minZoom() ) ||
-               ( layer.maxZoom() >= 0 && zoomLevel > layer.maxZoom() ) )
-            continue;
+        const bool lastTile = row == tileRange.endRow() && col == tileRange.endColumn();
+        if ( tiles.count() < TILES_PER_BATCH && !lastTile )
+          continue;
 
-          encoder.addLayer( layer.layer(), feedback, layer.filterExpression(), layer.layerName() );
-        }
+        QtConcurrent::blockingMap( tiles, encodeTile );
 
         if ( feedback && feedback->isCanceled() )
         {
@@ -180,32 +341,38 @@ bool QgsVectorTileWriter::writeTiles( QgsFeedback *feedback )
           return false;
         }
 
-        QByteArray tileData = encoder.encode();
+        if ( mbtiles )
+          mbtiles->beginTransaction();
 
-        ++tilesCreated;
-        if ( feedback )
+        for ( const QgsVectorTileWriterEncodedTile &encodedTile : qgis::as_const( tiles ) )
         {
-          feedback->setProgress( static_cast<double>( tilesCreated ) / tilesToCreate * 100 );
+          if ( encodedTile.data.isEmpty() )
+          {
+            // skipping empty tile - no need to write it
+            continue;
+          }
+
+          if ( sourceType == QStringLiteral( "xyz" ) )
+          {
+            if ( !writeTileFileXYZ( sourcePath, encodedTile.id, tileMatrix, encodedTile.data ) )
+              return false;  // error message already set
+          }
+          else  // mbtiles
+          {
+            int rowTMS = pow( 2, encodedTile.id.zoomLevel() ) - encodedTile.id.row() - 1;
+            mbtiles->setTileData( encodedTile.id.zoomLevel(), encodedTile.id.column(), rowTMS, encodedTile.data );
+          }
         }
 
-        if ( tileData.isEmpty() )
-        {
-          // skipping empty tile - no need to write it
-          continue;
-        }
+        if ( mbtiles )
+          mbtiles->commitTransaction();
 
-        if ( sourceType == QStringLiteral( "xyz" ) )
-        {
-          if ( !writeTileFileXYZ( sourcePath, tileID, tileMatrix, tileData ) )
-            return false;  // error message already set
-        }
-        else  // mbtiles
+        tilesCreated += tiles.count();
+        if ( feedback )
         {
-          QByteArray gzipTileData;
-          QgsMbTiles::encodeGzip( tileData, gzipTileData );
-          int rowTMS = pow( 2, tileID.zoomLevel() ) - tileID.row() - 1;
-          mbtiles->setTileData( tileID.zoomLevel(), tileID.column(), rowTMS, gzipTileData );
+          feedback->setProgress( static_cast<double>( tilesCreated ) / tilesToCreate * 100 );
         }
+        tiles.clear();
       }
     }
   }
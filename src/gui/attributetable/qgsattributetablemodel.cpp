@@ -22,6 +22,7 @@
 #include "qgseditorwidgetfactory.h"
 #include "qgsexpression.h"
 #include "qgsfeatureiterator.h"
+#include "qgscachedfeatureiterator.h"
 #include "qgsconditionalstyle.h"
 #include "qgsfields.h"
 #include "qgsfieldformatter.h"
@@ -75,6 +76,7 @@ QgsAttributeTableModel::QgsAttributeTableModel( QgsVectorLayerCache *layerCache,
   connect( layer(), &QgsVectorLayer::editCommandEnded, this, &QgsAttributeTableModel::editCommandEnded );
   connect( mLayerCache, &QgsVectorLayerCache::attributeValueChanged, this, &QgsAttributeTableModel::attributeValueChanged );
   connect( mLayerCache, &QgsVectorLayerCache::featureAdded, this, [ = ]( QgsFeatureId id ) { featureAdded( id ); } );
+  connect( mLayerCache, &QgsVectorLayerCache::featuresCached, this, &QgsAttributeTableModel::featuresCached );
   connect( mLayerCache, &QgsVectorLayerCache::cachedLayerDeleted, this, &QgsAttributeTableModel::layerDeleted );
 
 }
@@ -225,22 +227,7 @@ void QgsAttributeTableModel::featureAdded( QgsFeatureId fid )
 
   if ( featOk && mFeatureRequest.acceptFeature( mFeat ) )
   {
-    for ( SortCache &cache : mSortCaches )
-    {
-      if ( cache.sortFieldIndex >= 0 )
-      {
-        QgsFieldFormatter *fieldFormatter = mFieldFormatters.at( cache.sortFieldIndex );
-        const QVariant &widgetCache = mAttributeWidgetCaches.at( cache.sortFieldIndex );
-        const QVariantMap &widgetConfig = mWidgetConfigs.at( cache.sortFieldIndex );
-        QVariant sortValue = fieldFormatter->representValue( layer(), cache.sortFieldIndex, widgetConfig, widgetCache, mFeat.attribute( cache.sortFieldIndex ) );
-        cache.sortCache.insert( mFeat.id(), sortValue );
-      }
-      else if ( cache.sortCacheExpression.isValid() )
-      {
-        mExpressionContext.setFeature( mFeat );
-        cache.sortCache[mFeat.id()] = cache.sortCacheExpression.evaluate( &mExpressionContext );
-      }
-    }
+    addToSortCaches( mFeat );
 
     // Skip if the fid is already in the map (do not add twice)!
     if ( ! mIdRowMap.contains( fid ) )
@@ -251,8 +238,58 @@ void QgsAttributeTableModel::featureAdded( QgsFeatureId fid )
       mIdRowMap.insert( fid, n );
       mRowIdMap.insert( n, fid );
       if ( !mResettingModel )
+      {
         endInsertRows();
-      reload( index( rowCount() - 1, 0 ), index( rowCount() - 1, columnCount() ) );
+        reload( index( rowCount() - 1, 0 ), index( rowCount() - 1, columnCount() ) );
+      }
+    }
+  }
+}
+
+void QgsAttributeTableModel::featuresCached( const QgsFeatureIds &fids )
+{
+  QList<QgsFeatureId> acceptedIds;
+  for ( QgsFeatureId fid : fids )
+  {
+    if ( mIdRowMap.contains( fid ) || !loadFeatureAtId( fid ) || !mFeatureRequest.acceptFeature( mFeat ) )
+      continue;
+
+    addToSortCaches( mFeat );
+    acceptedIds << fid;
+  }
+
+  if ( acceptedIds.isEmpty() )
+    return;
+
+  int n = mRowIdMap.size();
+  if ( !mResettingModel )
+    beginInsertRows( QModelIndex(), n, n + acceptedIds.size() - 1 );
+  for ( QgsFeatureId fid : qgis::as_const( acceptedIds ) )
+  {
+    mIdRowMap.insert( fid, n );
+    mRowIdMap.insert( n, fid );
+    ++n;
+  }
+  if ( !mResettingModel )
+    endInsertRows();
+}
+
+void QgsAttributeTableModel::addToSortCaches( const QgsFeature &feature )
+{
+  for ( SortCache &cache : mSortCaches )
+  {
+    if ( cache.sortFieldIndex >= 0 )
+    {
+      QgsFieldFormatter *fieldFormatter = mFieldFormatters.at( cache.sortFieldIndex );
+      const QVariant &widgetCache = mAttributeWidgetCaches.at( cache.sortFieldIndex );
+      const QVariantMap &widgetConfig = mWidgetConfigs.at( cache.sortFieldIndex );
+      QVariant sortValue = fieldFormatter->representValue( layer(), cache.sortFieldIndex, widgetConfig, widgetCache, feature.attribute( cache.sortFieldIndex ) );
+      cache.sortCache.insert( feature.id(), sortValue );
+    }
+    else if ( cache.sortCacheExpression.isValid() )
+    {
+      mExpressionContext.setFeature( feature );
+      cache.sortCache[feature.id()] = cache.sortCacheExpression.evaluate( &mExpressionContext );
     }
   }
 }
@@ -452,7 +489,22 @@ void QgsAttributeTableModel::loadLayer()
   // Layer might have been deleted and cache set to nullptr!
   if ( mLayerCache )
   {
-    QgsFeatureIterator features = mLayerCache->getFeatures( mFeatureRequest );
+    // while the cache is filled in the background, only the features it already holds are loaded,
+    // the others are added as they are cached
+    QgsFeatureIterator features = mLayerCache->isFillingInBackground()
+                                  ? QgsFeatureIterator( new QgsCachedFeatureIterator( mLayerCache, mFeatureRequest ) )
+                                  : mLayerCache->getFeatures( mFeatureRequest );
+
+    // without filter, all the features of the layer are loaded
+    if ( mFeatureRequest.filterType() == QgsFeatureRequest::FilterNone && mFeatureRequest.filterRect().isNull() )
+    {
+      const long featureCount = mLayerCache->layer()->featureCount();
+      if ( featureCount > 0 )
+      {
+        mIdRowMap.reserve( featureCount );
+        mRowIdMap.reserve( featureCount );
+      }
+    }
 
     int i = 0;
 
@@ -474,6 +526,8 @@ void QgsAttributeTableModel::loadLayer()
       }
       featureAdded( mFeat.id() );
     }
+    // the rows are not reloaded one by one while the model is reset
+    mFeat.setId( std::numeric_limits<int>::min() );
 
     emit finished();
     connect( mLayerCache, &QgsVectorLayerCache::invalidated, this, &QgsAttributeTableModel::loadLayer, Qt::UniqueConnection );
@@ -928,6 +982,8 @@ void QgsAttributeTableModel::prefetchSortData( const QString &expressionString,
                               .setSubsetOfAttributes( cache.sortCacheAttributes );
   QgsFeatureIterator it = mLayerCache->getFeatures( request );
 
+  cache.sortCache.reserve( mRowIdMap.size() );
+
   QgsFeature f;
   while ( it.nextFeature( f ) )
   {
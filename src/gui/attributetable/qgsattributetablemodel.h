@@ -321,6 +321,13 @@ class GUI_EXPORT QgsAttributeTableModel: public QAbstractTableModel
      */
     virtual void featureAdded( QgsFeatureId fid );
 
+    /**
+     * Launched when features have been read into the layer cache in the background,
+     * adds the accepted ones with a single insertion of rows
+     * \param fids feature ids
+     */
+    void featuresCached( const QgsFeatureIds &fids );
+
     /**
      * Launched when layer has been deleted
      */
@@ -360,6 +367,9 @@ class GUI_EXPORT QgsAttributeTableModel: public QAbstractTableModel
      */
     virtual bool loadFeatureAtId( QgsFeatureId fid ) const;
 
+    //! Adds the sort values of \a feature to the sort caches
+    void addToSortCaches( const QgsFeature &feature );
+
     QgsFeatureRequest mFeatureRequest;
 
     struct SortCache
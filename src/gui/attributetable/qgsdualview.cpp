@@ -380,6 +380,8 @@ void QgsDualView::initLayerCache( bool cacheGeometry )
   // Initialize the cache
   QgsSettings settings;
   int cacheSize = settings.value( QStringLiteral( "qgis/attributeTableRowCache" ), "10000" ).toInt();
+  // the memory budget is shared by the caches of all the attribute tables and forms
+  QgsVectorLayerCache::setMaximumSharedCacheBytes( settings.value( QStringLiteral( "qgis/attributeTableCacheMemory" ), 512 ).toLongLong() * 1024 * 1024 );
   mLayerCache = new QgsVectorLayerCache( mLayer, cacheSize, this );
   mLayerCache->setCacheGeometry( cacheGeometry );
   if ( 0 == cacheSize || 0 == ( QgsVectorDataProvider::SelectAtId & mLayer->dataProvider()->capabilities() ) )
@@ -1062,10 +1064,10 @@ void QgsDualView::flashCurrentFeature()
 
 void QgsDualView::rebuildFullLayerCache()
 {
-  connect( mLayerCache, &QgsVectorLayerCache::progress, this, &QgsDualView::progress, Qt::UniqueConnection );
   connect( mLayerCache, &QgsVectorLayerCache::finished, this, &QgsDualView::finished, Qt::UniqueConnection );
 
-  mLayerCache->setFullCache( true );
+  // the rows are added to the attribute table as the features are read
+  mLayerCache->fillFullCacheInBackground();
 }
 
 void QgsDualView::previewExpressionChanged( const QString &expression )
@@ -154,6 +154,10 @@ QgsMapCanvas::QgsMapCanvas( QWidget *parent )
     mSettings.setFlag( QgsMapSettings::DrawEditingInfo );
     mSettings.setFlag( QgsMapSettings::UseRenderingOptimization );
     mSettings.setFlag( QgsMapSettings::RenderPartialOutput );
+    mSettings.setFlag( QgsMapSettings::ProgressiveRendering );
+    mSettings.setFlag( QgsMapSettings::ApproximateReprojection );
+    mSettings.setFlag( QgsMapSettings::ParallelRasterRendering );
+    mSettings.setFlag( QgsMapSettings::PrefetchTiles );
     mSettings.setEllipsoid( QgsProject::instance()->ellipsoid() );
     connect( QgsProject::instance(), &QgsProject::ellipsoidChanged,
              this, [ = ]
@@ -592,6 +596,9 @@ void QgsMapCanvas::refreshMap()
   allLayers.insert( 0, QgsProject::instance()->mainAnnotationLayer() );
   renderSettings.setLayers( allLayers );
 
+  if ( QgsSettings().value( QStringLiteral( "Map/recordRenderingStatistics" ), false ).toBool() )
+    renderSettings.setFlag( QgsMapSettings::RecordRenderingStatistics );
+
   // create the renderer job
   Q_ASSERT( !mJob );
   mJobCanceled = false;
@@ -712,6 +719,32 @@ void QgsMapCanvas::rendererJobFinished()
     {
       mLastLayerRenderTime.insert( it.key()->id(), it.value() );
     }
+
+    // the profile of the last refresh is shown in the debugging panel
+    if ( mJob->mapSettings().testFlag( QgsMapSettings::RecordRenderingStatistics ) )
+    {
+      QgsRuntimeProfiler *profiler = QgsApplication::profiler();
+      profiler->clear( QStringLiteral( "render" ) );
+      const QHash< QString, QgsMapLayerRenderingStatistics > statistics = mJob->perLayerRenderingStatistics();
+      for ( auto it = statistics.constBegin(); it != statistics.constEnd(); ++it )
+      {
+        QgsMapLayer *layer = QgsProject::instance()->mapLayer( it.key() );
+        const QString name = layer ? layer->name() : it.key();
+        const QgsMapLayerRenderingStatistics &layerStatistics = it.value();
+        if ( layerStatistics.cached )
+        {
+          profiler->record( tr( "%1 (cached)" ).arg( name ), layerStatistics.renderingTime / 1000.0, QStringLiteral( "render" ) );
+          continue;
+        }
+        profiler->record( tr( "%1 (%2 features fetched, %3 drawn)" ).arg( name ).arg( layerStatistics.featuresFetched ).arg( layerStatistics.featuresDrawn ),
+                          layerStatistics.renderingTime / 1000.0, QStringLiteral( "render" ) );
+        profiler->record( tr( "%1: fetching features" ).arg( name ), layerStatistics.fetchTime / 1000.0, QStringLiteral( "render" ) );
+        profiler->record( tr( "%1: drawing symbols" ).arg( name ), layerStatistics.symbolDrawingTime / 1000.0, QStringLiteral( "render" ) );
+        profiler->record( tr( "%1: registering labels" ).arg( name ), layerStatistics.labelingTime / 1000.0, QStringLiteral( "render" ) );
+      }
+      if ( mJob->labelingTime() >= 0 )
+        profiler->record( tr( "Labeling" ), mJob->labelingTime() / 1000.0, QStringLiteral( "render" ) );
+    }
     if ( mUsePreviewJobs && !mRefreshAfterJob )
       startPreviewJobs();
   }
@@ -2718,6 +2751,8 @@ void QgsMapCanvas::startPreviewJob( int number )
   jobSettings.setExtent( jobExtent );
   jobSettings.setFlag( QgsMapSettings::DrawLabeling, false );
   jobSettings.setFlag( QgsMapSettings::RenderPreviewJob, true );
+  // the preview jobs already render the surroundings of the view
+  jobSettings.setFlag( QgsMapSettings::PrefetchTiles, false );
 
   // truncate preview layers to fast layers
   const QList<QgsMapLayer *> layers = jobSettings.layers();
@@ -62,6 +62,18 @@ QgsMapCanvasTracer *QgsMapCanvasTracer::tracerForCanvas( QgsMapCanvas *canvas )
   return sTracers->value( canvas, nullptr );
 }
 
+void QgsMapCanvasTracer::setActionEnableTracing( QAction *action )
+{
+  if ( mActionEnableTracing )
+    disconnect( mActionEnableTracing, &QAction::toggled, this, &QgsTracer::setBuildInBackground );
+
+  mActionEnableTracing = action;
+
+  if ( mActionEnableTracing )
+    connect( mActionEnableTracing, &QAction::toggled, this, &QgsTracer::setBuildInBackground );
+  setBuildInBackground( mActionEnableTracing && mActionEnableTracing->isChecked() );
+}
+
 void QgsMapCanvasTracer::reportError( QgsTracer::PathError err, bool addingVertex )
 {
   Q_UNUSED( addingVertex )
@@ -99,6 +111,9 @@ void QgsMapCanvasTracer::reportError( QgsTracer::PathError err, bool addingVerte
 
 void QgsMapCanvasTracer::configure()
 {
+  if ( !mCanvas )
+    return;
+
   setDestinationCrs( mCanvas->mapSettings().destinationCrs(), mCanvas->mapSettings().transformContext() );
   QgsRenderContext ctx = QgsRenderContext::fromMapSettings( mCanvas->mapSettings() );
   setRenderContext( &ctx );
@@ -52,9 +52,10 @@ class GUI_EXPORT QgsMapCanvasTracer : public QgsTracer
 
     /**
      * Assign "enable tracing" checkable action to the tracer.
-     * The action is used to determine whether tracing is currently enabled by the user
+     * The action is used to determine whether tracing is currently enabled by the user.
+     * While it is checked, the graph is built in the background as soon as the canvas or the layers change.
      */
-    void setActionEnableTracing( QAction *action ) { mActionEnableTracing = action; }
+    void setActionEnableTracing( QAction *action );
 
     /**
      * Access to action that user may use to toggle snapping on/off. May be NULLPTR if no action was associated.
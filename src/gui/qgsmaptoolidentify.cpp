@@ -36,6 +36,7 @@
 #include "qgscoordinatereferencesystem.h"
 #include "qgsvectordataprovider.h"
 #include "qgsvectorlayer.h"
+#include "qgsvectorlayerfeatureiterator.h"
 #include "qgsvectortilelayer.h"
 #include "qgsvectortilemvtdecoder.h"
 #include "qgsvectortileutils.h"
@@ -56,6 +57,9 @@
 #include <QStatusBar>
 #include <QVariant>
 #include <QMenu>
+#include <QtConcurrent>
+
+#include <memory>
 
 QgsMapToolIdentify::QgsMapToolIdentify( QgsMapCanvas *canvas )
   : QgsMapTool( canvas )
@@ -154,6 +158,18 @@ QList<QgsMapToolIdentify::IdentifyResult> QgsMapToolIdentify::identify( const Qg
     else
       layerCount = layerList.count();
 
+    // all the layers will be identified, their features are fetched at the same time
+    if ( mode != TopDownStopAtFirst && layerType.testFlag( VectorLayer ) )
+    {
+      QList<QgsVectorLayer *> vectorLayers;
+      for ( int i = 0; i < layerCount; i++ )
+      {
+        QgsVectorLayer *vectorLayer = qobject_cast<QgsVectorLayer *>( layerList.isEmpty() ? mCanvas->layer( i ) : layerList.value( i ) );
+        if ( vectorLayer && vectorLayer->flags().testFlag( QgsMapLayer::Identifiable ) )
+          vectorLayers << vectorLayer;
+      }
+      prefetchVectorLayerFeatures( vectorLayers, mLastGeometry );
+    }
 
     for ( int i = 0; i < layerCount; i++ )
     {
@@ -179,6 +195,8 @@ QList<QgsMapToolIdentify::IdentifyResult> QgsMapToolIdentify::identify( const Qg
 
     emit identifyProgress( mCanvas->layerCount(), mCanvas->layerCount() );
     emit identifyMessage( tr( "Identifying done." ) );
+
+    mPrefetchedFeatures.clear();
   }
 
   QApplication::restoreOverrideCursor();
@@ -186,6 +204,69 @@ QList<QgsMapToolIdentify::IdentifyResult> QgsMapToolIdentify::identify( const Qg
   return results;
 }
 
+QgsRectangle QgsMapToolIdentify::identifyRectangle( QgsVectorLayer *layer, const QgsGeometry &geometry )
+{
+  if ( geometry.type() == QgsWkbTypes::PointGeometry )
+  {
+    const QgsPointXY point = geometry.asPoint();
+    double sr = mOverrideCanvasSearchRadius < 0 ? searchRadiusMU( mCanvas ) : mOverrideCanvasSearchRadius;
+    return toLayerCoordinates( layer, QgsRectangle( point.x() - sr, point.y() - sr, point.x() + sr, point.y() + sr ) );
+  }
+  else
+  {
+    return toLayerCoordinates( layer, geometry.boundingBox() );
+  }
+}
+
+void QgsMapToolIdentify::prefetchVectorLayerFeatures( const QList<QgsVectorLayer *> &layers, const QgsGeometry &geometry )
+{
+  struct PrefetchJob
+  {
+    QgsVectorLayer *layer = nullptr;
+    std::shared_ptr< QgsVectorLayerFeatureSource > source;
+    QgsRectangle rectangle;
+  };
+
+  // the feature sources are created in the main thread, like for the rendering of the layers
+  QVector< PrefetchJob > jobs;
+  for ( QgsVectorLayer *layer : layers )
+  {
+    if ( !layer->isSpatial() || !layer->isInScaleRange( mCanvas->mapSettings().scale() ) )
+      continue;
+
+    PrefetchJob job;
+    try
+    {
+      job.rectangle = identifyRectangle( layer, geometry );
+    }
+    catch ( QgsCsException & )
+    {
+      // identifyVectorLayer() will report no features
+      continue;
+    }
+    job.layer = layer;
+    job.source = std::make_shared< QgsVectorLayerFeatureSource >( layer );
+    jobs << job;
+  }
+
+  // a single layer is better queried directly
+  if ( jobs.size() < 2 )
+    return;
+
+  const QVector< QgsFeatureList > featureLists = QtConcurrent::blockingMapped< QVector< QgsFeatureList > >( jobs, []( const PrefetchJob & job )
+  {
+    QgsFeatureList features;
+    QgsFeatureIterator fit = job.source->getFeatures( QgsFeatureRequest().setFilterRect( job.rectangle ).setFlags( QgsFeatureRequest::ExactIntersect ) );
+    QgsFeature f;
+    while ( fit.nextFeature( f ) )
+      features << f;
+    return features;
+  } );
+
+  for ( int i = 0; i < jobs.size(); ++i )
+    mPrefetchedFeatures.insert( jobs.at( i ).layer, featureLists.at( i ) );
+}
+
 void QgsMapToolIdentify::setCanvasPropertiesOverrides( double searchRadiusMapUnits )
 {
   mOverrideCanvasSearchRadius = searchRadiusMapUnits;
@@ -538,16 +619,9 @@ bool QgsMapToolIdentify::identifyVectorLayer( QList<QgsMapToolIdentify::Identify
   // and then click somewhere off the globe, an exception will be thrown.
   try
   {
-    QgsRectangle r;
-    if ( isSingleClick )
-    {
-      double sr = mOverrideCanvasSearchRadius < 0 ? searchRadiusMU( mCanvas ) : mOverrideCanvasSearchRadius;
-      r = toLayerCoordinates( layer, QgsRectangle( point.x() - sr, point.y() - sr, point.x() + sr, point.y() + sr ) );
-    }
-    else
+    QgsRectangle r = identifyRectangle( layer, selectionGeom );
+    if ( !isSingleClick )
     {
-      r = toLayerCoordinates( layer, selectionGeom.boundingBox() );
-
       if ( !isPointOrRectangle )
       {
         QgsCoordinateTransform ct( mCanvas->mapSettings().destinationCrs(), layer->crs(), mCanvas->mapSettings().transformContext() );
@@ -559,12 +633,26 @@ bool QgsMapToolIdentify::identifyVectorLayer( QList<QgsMapToolIdentify::Identify
       }
     }
 
-    QgsFeatureIterator fit = layer->getFeatures( QgsFeatureRequest().setFilterRect( r ).setFlags( QgsFeatureRequest::ExactIntersect ) );
-    QgsFeature f;
-    while ( fit.nextFeature( f ) )
+    auto prefetchedIt = mPrefetchedFeatures.find( layer );
+    if ( prefetchedIt != mPrefetchedFeatures.end() )
     {
-      if ( !selectionGeomPrepared || selectionGeomPrepared->intersects( f.geometry().constGet() ) )
-        featureList << QgsFeature( f );
+      const QgsFeatureList prefetchedFeatures = *prefetchedIt;
+      mPrefetchedFeatures.erase( prefetchedIt );
+      for ( const QgsFeature &f : prefetchedFeatures )
+      {
+        if ( !selectionGeomPrepared || selectionGeomPrepared->intersects( f.geometry().constGet() ) )
+          featureList << f;
+      }
+    }
+    else
+    {
+      QgsFeatureIterator fit = layer->getFeatures( QgsFeatureRequest().setFilterRect( r ).setFlags( QgsFeatureRequest::ExactIntersect ) );
+      QgsFeature f;
+      while ( fit.nextFeature( f ) )
+      {
+        if ( !selectionGeomPrepared || selectionGeomPrepared->intersects( f.geometry().constGet() ) )
+          featureList << QgsFeature( f );
+      }
     }
   }
   catch ( QgsCsException &cse )
@@ -22,6 +22,7 @@
 #include "qgspointxy.h"
 #include "qgsunittypes.h"
 
+#include <QHash>
 #include <QObject>
 #include <QPointer>
 #include "qgis_gui.h"
@@ -212,6 +213,18 @@ class GUI_EXPORT QgsMapToolIdentify : public QgsMapTool
     bool identifyMeshLayer( QList<QgsMapToolIdentify::IdentifyResult> *results, QgsMeshLayer *layer, const QgsGeometry &geometry );
     bool identifyVectorTileLayer( QList<QgsMapToolIdentify::IdentifyResult> *results, QgsVectorTileLayer *layer, const QgsGeometry &geometry );
 
+    /**
+     * Returns the rectangle, in the CRS of \a layer, of the features to identify with \a geometry.
+     * Throws a QgsCsException if the rectangle cannot be transformed.
+     */
+    QgsRectangle identifyRectangle( QgsVectorLayer *layer, const QgsGeometry &geometry );
+
+    /**
+     * Fetches in parallel the features of the vector \a layers in the identify rectangles of
+     * \a geometry, then used by identifyVectorLayer() instead of querying the layers one after another.
+     */
+    void prefetchVectorLayerFeatures( const QList<QgsVectorLayer *> &layers, const QgsGeometry &geometry );
+
     /**
      * Desired units for distance display.
      * \see displayAreaUnits()
@@ -278,6 +291,9 @@ class GUI_EXPORT QgsMapToolIdentify : public QgsMapTool
     int mCoordinatePrecision;
 
     double mOverrideCanvasSearchRadius = -1;
+
+    // Features fetched by prefetchVectorLayerFeatures() during identify()
+    QHash< QgsVectorLayer *, QgsFeatureList > mPrefetchedFeatures;
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS( QgsMapToolIdentify::LayerType )
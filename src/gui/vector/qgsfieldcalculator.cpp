@@ -14,6 +14,7 @@
  ***************************************************************************/
 
 #include <QMessageBox>
+#include <QCoreApplication>
 
 
 #include "qgsfieldcalculator.h"
@@ -30,6 +31,8 @@
 #include "qgsgui.h"
 #include "qgsguiutils.h"
 #include "qgsproxyprogresstask.h"
+#include "qgsfeedback.h"
+#include "qgsapplication.h"
 #include "qgsexpressioncontextutils.h"
 #include "qgsvectorlayerjoinbuffer.h"
 
@@ -43,6 +46,12 @@ constexpr int FTC_MINPREC_IDX = 4;
 constexpr int FTC_MAXPREC_IDX = 5;
 constexpr int FTC_SUBTYPE_IDX = 6;
 
+//! Number of calculated values changed with a single undo command
+constexpr int CHANGED_VALUES_BLOCK_SIZE = 100000;
+
+// number of calculated features between two updates of the progress
+constexpr int PROGRESS_STEP = 1000;
+
 QgsFieldCalculator::QgsFieldCalculator( QgsVectorLayer *vl, QWidget *parent )
   : QDialog( parent )
   , mVectorLayer( vl )
@@ -287,13 +296,28 @@ void QgsFieldCalculator::accept()
     }
     QgsFeatureIterator fit = mVectorLayer->getFeatures( req );
 
-    std::unique_ptr< QgsScopedProxyProgressTask > task = qgis::make_unique< QgsScopedProxyProgressTask >( tr( "Calculating field" ) );
+    // the calculation can be canceled from the task manager
+    QgsFeedback feedback;
+    QgsProxyProgressTask *task = new QgsProxyProgressTask( tr( "Calculating field" ), true );
+    connect( task, &QgsProxyProgressTask::canceled, &feedback, &QgsFeedback::cancel );
+    QgsApplication::taskManager()->addTask( task );
+    // the dialog is disabled while the pending events are processed, so that the calculation is not started again
+    setEnabled( false );
+
     long long count = mOnlyUpdateSelectedCheckBox->isChecked() ? mVectorLayer->selectedFeatureCount() : mVectorLayer->featureCount();
     long long i = 0;
+    QHash<QgsFeatureId, QVariant> newValues;
+    QHash<QgsFeatureId, QVariant> oldValues;
     while ( fit.nextFeature( feature ) )
     {
       i++;
-      task->setProgress( i / static_cast< double >( count ) * 100 );
+      if ( i % PROGRESS_STEP == 0 )
+      {
+        task->setProxyProgress( count > 0 ? i / static_cast< double >( count ) * 100 : 0 );
+        QCoreApplication::processEvents();
+      }
+      if ( feedback.isCanceled() )
+        break;
 
       expContext.setFeature( feature );
       expContext.lastScope()->addVariable( QgsExpressionContextScope::StaticVariable( QStringLiteral( "row_number" ), rownum, true ) );
@@ -316,16 +340,35 @@ void QgsFieldCalculator::accept()
       else
       {
         ( void )field.convertCompatible( value );
-        mVectorLayer->changeAttributeValue( feature.id(), mAttributeId, value, newField ? emptyAttribute : feature.attributes().value( mAttributeId ) );
+        newValues.insert( feature.id(), value );
+        oldValues.insert( feature.id(), newField ? emptyAttribute : feature.attributes().value( mAttributeId ) );
+        // the values are applied by blocks, each one stored as a single undo command
+        if ( newValues.size() >= CHANGED_VALUES_BLOCK_SIZE )
+        {
+          mVectorLayer->changeFieldValues( mAttributeId, newValues, oldValues );
+          newValues.clear();
+          oldValues.clear();
+        }
       }
 
       rownum++;
     }
+    const bool canceled = feedback.isCanceled();
+    if ( calculationSuccess && !canceled && !newValues.isEmpty() )
+      mVectorLayer->changeFieldValues( mAttributeId, newValues, oldValues );
+    task->finalize( calculationSuccess && !canceled );
+    setEnabled( true );
+
+    if ( canceled )
+    {
+      // the values already changed are discarded
+      mVectorLayer->destroyEditCommand();
+      return;
+    }
 
     if ( !calculationSuccess )
     {
       cursorOverride.release();
-      task.reset();
       QMessageBox::critical( nullptr, tr( "Evaluation Error" ), tr( "An error occurred while evaluating the calculation string:\n%1" ).arg( error ) );
       mVectorLayer->destroyEditCommand();
       return;
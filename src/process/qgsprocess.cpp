@@ -32,8 +32,16 @@
 #include "sigwatch.h"
 #endif
 
+#include <functional>
 #include <iostream>
+#include <string>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
 #include <QObject>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
 
 ConsoleFeedback::ConsoleFeedback()
 {
@@ -264,6 +272,28 @@ int QgsProcessingExec::run( const QStringList &args )
 
     return execute( algId, params, ellipsoid, distanceUnit, areaUnit, projectPath );
   }
+  else if ( command == QLatin1String( "batch" ) )
+  {
+    int threads = QThread::idealThreadCount();
+    for ( int i = 2; i < args.count(); i++ )
+    {
+      QString arg = args.at( i );
+      if ( arg.startsWith( QLatin1String( "--" ) ) )
+        arg = arg.mid( 2 );
+
+      const QStringList parts = arg.split( '=' );
+      bool ok = false;
+      if ( parts.count() == 2 && parts.at( 0 ).compare( QLatin1String( "threads" ), Qt::CaseInsensitive ) == 0 )
+        threads = parts.at( 1 ).toInt( &ok );
+      if ( !ok || threads < 1 )
+      {
+        std::cerr << QStringLiteral( "Invalid batch argument %1. The number of threads must be specified via the \"--THREADS=N\" argument\n" ).arg( args.at( i ) ).toLocal8Bit().constData();
+        return 1;
+      }
+    }
+
+    return executeBatch( threads );
+  }
   else
   {
     std::cerr << QStringLiteral( "Command %1 not known!\n" ).arg( command ).toLocal8Bit().constData();
@@ -284,7 +314,10 @@ void QgsProcessingExec::showUsage( const QString &appName )
       << "\thelp\tshow help for an algorithm. The algorithm id or a path to a model file must be specified.\n"
       << "\trun\truns an algorithm. The algorithm id or a path to a model file and parameter values must be specified. Parameter values are specified via the --PARAMETER=VALUE syntax.\n"
       << "\t\tIf required, the ellipsoid to use for distance and area calculations can be specified via the \"--ELLIPSOID=name\" argument.\n"
-      << "\t\tIf required, an existing QGIS project to use during the algorithm execution can be specified via the \"--PROJECT_PATH=path\" argument.\n";
+      << "\t\tIf required, an existing QGIS project to use during the algorithm execution can be specified via the \"--PROJECT_PATH=path\" argument.\n"
+      << "\tbatch\truns the algorithms specified on each line of the standard input, as a JSON object with the \"algorithm\" id or path to a model file and its \"parameters\" object.\n"
+      << "\t\tThe \"ellipsoid\", \"distance_units\", \"area_units\" and \"project_path\" of each algorithm, and an \"id\" reported with its results, can also be specified.\n"
+      << "\t\tThe algorithms run concurrently, on as many threads as specified via the \"--THREADS=N\" argument. The results of each are written as a JSON object on a line of the standard output as soon as it finishes.\n";
 
   std::cout << msg.join( QString() ).toLocal8Bit().constData();
 }
@@ -606,3 +639,223 @@ int QgsProcessingExec::execute( const QString &id, const QVariantMap &params, co
     return 1;
   }
 }
+
+//! An algorithm invocation of a batch
+struct BatchJob
+{
+  QVariant id;
+  QString algId;
+  std::shared_ptr< QgsProcessingModelAlgorithm > model;
+  const QgsProcessingAlgorithm *alg;
+  QVariantMap parameters;
+  QString ellipsoid;
+  QgsUnitTypes::DistanceUnit distanceUnit;
+  QgsUnitTypes::AreaUnit areaUnit;
+  QString projectPath;
+};
+
+class BatchJobRunnable : public QRunnable
+{
+  public:
+    explicit BatchJobRunnable( const std::function< void() > &function )
+      : mFunction( function )
+    {}
+
+    void run() override
+    {
+      mFunction();
+    }
+
+  private:
+    std::function< void() > mFunction;
+};
+
+/**
+ * Runs a batch \a job, from any thread, and returns its results record. Everything reported
+ * by the algorithm is kept in the record log, so that the output of concurrent jobs does not
+ * interleave.
+ */
+static QVariantMap runBatchJob( const BatchJob &job )
+{
+  QVariantMap record;
+  record.insert( QStringLiteral( "id" ), job.id );
+  record.insert( QStringLiteral( "algorithm" ), job.algId );
+  record.insert( QStringLiteral( "ok" ), false );
+
+  std::unique_ptr< QgsProject > project;
+  if ( !job.projectPath.isEmpty() )
+  {
+    project = qgis::make_unique< QgsProject >();
+    if ( !project->read( job.projectPath ) )
+    {
+      record.insert( QStringLiteral( "error" ), QStringLiteral( "Could not load the QGIS project \"%1\"" ).arg( job.projectPath ) );
+      return record;
+    }
+  }
+
+  QgsProcessingContext context;
+  context.setEllipsoid( job.ellipsoid );
+  context.setDistanceUnit( job.distanceUnit );
+  context.setAreaUnit( job.areaUnit );
+  context.setProject( project.get() );
+
+  QStringList missingParams;
+  const QgsProcessingParameterDefinitions defs = job.alg->parameterDefinitions();
+  for ( const QgsProcessingParameterDefinition *p : defs )
+  {
+    if ( !p->checkValueIsAcceptable( job.parameters.value( p->name() ), &context )
+         && !( p->flags() & QgsProcessingParameterDefinition::FlagOptional ) && !job.parameters.contains( p->name() ) )
+      missingParams << p->name();
+  }
+  if ( !missingParams.isEmpty() )
+  {
+    record.insert( QStringLiteral( "error" ), QStringLiteral( "The following mandatory parameters were not specified: %1" ).arg( missingParams.join( QStringLiteral( ", " ) ) ) );
+    return record;
+  }
+
+  QString message;
+  if ( !job.alg->checkParameterValues( job.parameters, context, &message ) )
+  {
+    record.insert( QStringLiteral( "error" ), QStringLiteral( "An error was encountered while checking parameter values: %1" ).arg( message ) );
+    return record;
+  }
+
+  QgsProcessingFeedback feedback( false );
+  bool ok = false;
+  const QVariantMap res = job.alg->run( job.parameters, context, &feedback, &ok );
+  record.insert( QStringLiteral( "ok" ), ok );
+  record.insert( QStringLiteral( "log" ), feedback.textLog() );
+  if ( !ok )
+    return record;
+
+  QVariantMap results;
+  for ( auto it = res.constBegin(); it != res.constEnd(); ++it )
+  {
+    if ( it.key() == QLatin1String( "CHILD_INPUTS" ) || it.key() == QLatin1String( "CHILD_RESULTS" ) )
+      continue;
+
+    const QVariant result = it.value();
+    switch ( result.type() )
+    {
+      case QVariant::Bool:
+      case QVariant::Int:
+      case QVariant::LongLong:
+      case QVariant::Double:
+        results.insert( it.key(), result );
+        break;
+
+      case QVariant::List:
+      case QVariant::StringList:
+      {
+        QStringList list;
+        for ( const QVariant &v : result.toList() )
+          list << v.toString();
+        results.insert( it.key(), list );
+        break;
+      }
+
+      default:
+        results.insert( it.key(), result.toString() );
+        break;
+    }
+  }
+  record.insert( QStringLiteral( "results" ), results );
+  return record;
+}
+
+int QgsProcessingExec::executeBatch( int threads )
+{
+  QThreadPool pool;
+  pool.setMaxThreadCount( threads );
+
+  QMutex outputMutex;
+  int failures = 0;
+  auto writeRecord = [&outputMutex, &failures]( const QVariantMap & record )
+  {
+    const QByteArray line = QJsonDocument( QJsonObject::fromVariantMap( record ) ).toJson( QJsonDocument::Compact );
+    QMutexLocker locker( &outputMutex );
+    if ( !record.value( QStringLiteral( "ok" ) ).toBool() )
+      failures++;
+    std::cout << line.constData() << std::endl;
+  };
+
+  int lineNumber = 0;
+  std::string line;
+  while ( std::getline( std::cin, line ) )
+  {
+    lineNumber++;
+    const QByteArray json = QByteArray::fromStdString( line ).trimmed();
+    if ( json.isEmpty() )
+      continue;
+
+    QVariantMap record;
+    record.insert( QStringLiteral( "id" ), lineNumber );
+    record.insert( QStringLiteral( "ok" ), false );
+
+    QJsonParseError error;
+    const QJsonDocument document = QJsonDocument::fromJson( json, &error );
+    if ( !document.isObject() )
+    {
+      record.insert( QStringLiteral( "error" ), error.error != QJsonParseError::NoError ? QStringLiteral( "Invalid JSON: %1" ).arg( error.errorString() ) : QStringLiteral( "Each line must be a JSON object" ) );
+      writeRecord( record );
+      continue;
+    }
+
+    const QVariantMap map = document.object().toVariantMap();
+    BatchJob job;
+    job.id = map.value( QStringLiteral( "id" ), lineNumber );
+    job.algId = map.value( QStringLiteral( "algorithm" ) ).toString();
+    job.alg = nullptr;
+    job.parameters = map.value( QStringLiteral( "parameters" ) ).toMap();
+    job.ellipsoid = map.value( QStringLiteral( "ellipsoid" ) ).toString();
+    job.distanceUnit = map.contains( QStringLiteral( "distance_units" ) ) ? QgsUnitTypes::decodeDistanceUnit( map.value( QStringLiteral( "distance_units" ) ).toString() ) : QgsUnitTypes::DistanceUnknownUnit;
+    job.areaUnit = map.contains( QStringLiteral( "area_units" ) ) ? QgsUnitTypes::decodeAreaUnit( map.value( QStringLiteral( "area_units" ) ).toString() ) : QgsUnitTypes::AreaUnknownUnit;
+    job.projectPath = map.value( QStringLiteral( "project_path" ) ).toString();
+    record.insert( QStringLiteral( "id" ), job.id );
+    record.insert( QStringLiteral( "algorithm" ), job.algId );
+
+    if ( QFile::exists( job.algId ) && QFileInfo( job.algId ).suffix() == QLatin1String( "model3" ) )
+    {
+      job.model = std::make_shared< QgsProcessingModelAlgorithm >();
+      if ( !job.model->fromFile( job.algId ) )
+      {
+        record.insert( QStringLiteral( "error" ), QStringLiteral( "File %1 is not a valid Processing model!" ).arg( job.algId ) );
+        writeRecord( record );
+        continue;
+      }
+      job.alg = job.model.get();
+    }
+    else
+    {
+      job.alg = QgsApplication::processingRegistry()->algorithmById( job.algId );
+      if ( !job.alg )
+        record.insert( QStringLiteral( "error" ), QStringLiteral( "Algorithm %1 not found!" ).arg( job.algId ) );
+      else if ( job.alg->flags() & QgsProcessingAlgorithm::FlagNotAvailableInStandaloneTool )
+        record.insert( QStringLiteral( "error" ), QStringLiteral( "The \"%1\" algorithm is not available for use outside of the QGIS desktop application" ).arg( job.algId ) );
+      else if ( job.alg->flags() & QgsProcessingAlgorithm::FlagRequiresProject && job.projectPath.isEmpty() )
+        record.insert( QStringLiteral( "error" ), QStringLiteral( "The \"%1\" algorithm requires a QGIS project to execute. Specify a path to an existing project with \"project_path\"." ).arg( job.algId ) );
+      if ( record.contains( QStringLiteral( "error" ) ) )
+      {
+        writeRecord( record );
+        continue;
+      }
+    }
+
+    // algorithms which cannot run in a background thread, and jobs loading a project, whose
+    // layers must live in the main thread, run on the main thread in between reading the next jobs
+    if ( job.alg->flags() & QgsProcessingAlgorithm::FlagNoThreading || !job.projectPath.isEmpty() )
+    {
+      writeRecord( runBatchJob( job ) );
+    }
+    else
+    {
+      pool.start( new BatchJobRunnable( [job, writeRecord]
+      {
+        writeRecord( runBatchJob( job ) );
+      } ) );
+    }
+  }
+
+  pool.waitForDone();
+  return failures > 0 ? 1 : 0;
+}
@@ -76,6 +76,13 @@ class QgsProcessingExec
                  QgsUnitTypes::AreaUnit areaUnit,
                  const QString &projectPath = QString() );
 
+    /**
+     * Runs the algorithm invocations read as JSON objects from the lines of the standard input,
+     * up to \a threads at a time, and writes a JSON object with the result of each on a line of
+     * the standard output.
+     */
+    int executeBatch( int threads );
+
     std::unique_ptr< QgsPythonUtils > mPythonUtils;
     std::unique_ptr<QgsPythonUtils> loadPythonSupport();
 };
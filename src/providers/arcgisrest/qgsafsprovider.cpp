@@ -24,6 +24,7 @@
 #include "qgsdataitemprovider.h"
 #include "qgsapplication.h"
 #include "qgsruntimeprofiler.h"
+#include "qgssettings.h"
 
 const QString QgsAfsProvider::AFS_PROVIDER_KEY = QStringLiteral( "arcgisfeatureserver" );
 const QString QgsAfsProvider::AFS_PROVIDER_DESCRIPTION = QStringLiteral( "ArcGIS Feature Service data provider" );
@@ -63,6 +64,12 @@ QgsAfsProvider::QgsAfsProvider( const QString &uri, const ProviderOptions &optio
   mLayerName = layerData[QStringLiteral( "name" )].toString();
   mLayerDescription = layerData[QStringLiteral( "description" )].toString();
 
+  // features are requested by batches of the maximum record count, several at once when they are read in sequence
+  mSharedData->mMaxRecordCount = layerData.value( QStringLiteral( "maxRecordCount" ) ).toInt();
+  const QgsSettings settings;
+  mSharedData->mParallelRequests = std::max( 1, settings.value( QStringLiteral( "qgis/arcgisFeatureServiceParallelRequests" ), 4 ).toInt() );
+  mSharedData->mRequestPool.setMaxThreadCount( mSharedData->mParallelRequests );
+
   // Set extent
   QStringList coords = mSharedData->mDataSource.param( QStringLiteral( "bbox" ) ).split( ',' );
   bool limitBbox = false;
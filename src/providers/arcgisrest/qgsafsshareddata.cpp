@@ -17,10 +17,27 @@
 #include "qgsarcgisrestutils.h"
 #include "qgslogger.h"
 
+#include <QtConcurrentRun>
+
+//! Maximum number of features requested at once
+static const int MAX_BATCH_SIZE = 2000;
+
+//! Number of features requested at once when the maximum record count of the service is unknown
+static const int DEFAULT_BATCH_SIZE = 1000;
+
+//! Maximum number of object ids listed in the url of a single query
+static const int OBJECT_ID_LIST_SIZE = 100;
+
 void QgsAfsSharedData::clearCache()
 {
   QMutexLocker locker( &mMutex );
   mCache.clear();
+  mFetchedBatches.clear();
+}
+
+int QgsAfsSharedData::batchSize() const
+{
+  return mMaxRecordCount > 0 ? std::min( mMaxRecordCount, MAX_BATCH_SIZE ) : DEFAULT_BATCH_SIZE;
 }
 
 bool QgsAfsSharedData::getFeature( QgsFeatureId id, QgsFeature &f, const QgsRectangle &filterRect, QgsFeedback *feedback )
@@ -35,26 +52,74 @@ bool QgsAfsSharedData::getFeature( QgsFeatureId id, QgsFeature &f, const QgsRect
     return filterRect.isNull() || ( f.hasGeometry() && f.geometry().intersects( filterRect ) );
   }
 
-  // Fetch 100 features at the time
-  int startId = ( id / 100 ) * 100;
-  int stopId = std::min( startId + 100, mObjectIds.length() );
-  QList<quint32> objectIds;
-  objectIds.reserve( stopId );
-  for ( int i = startId; i < stopId; ++i )
+  // Fetch the batch of the feature. If the features are read in sequence, the next batches
+  // are requested at the same time, from other threads
+  const int size = batchSize();
+  const int batch = static_cast< int >( id / size );
+  if ( id < 0 || batch * size >= mObjectIds.count() )
   {
-    if ( i >= 0 && i < mObjectIds.count() )
-      objectIds.append( mObjectIds[i] );
+    QgsDebugMsg( QStringLiteral( "No valid features IDs to fetch" ) );
+    return false;
   }
 
-  if ( objectIds.empty() )
+  QList< int > batches;
+  batches << batch;
+  if ( filterRect.isNull() && ( batch == 0 || mFetchedBatches.contains( batch - 1 ) ) )
   {
-    QgsDebugMsg( QStringLiteral( "No valid features IDs to fetch" ) );
-    return false;
+    for ( int next = batch + 1; batches.size() < mParallelRequests && next * size < mObjectIds.count() && !mFetchedBatches.contains( next ); ++next )
+      batches << next;
   }
+  QVector< QList<quint32> > objectIds;
+  objectIds.reserve( batches.size() );
+  for ( int b : qgis::as_const( batches ) )
+    objectIds << mObjectIds.mid( b * size, size );
 
   // don't lock while doing the fetch
   locker.unlock();
 
+  QVector< QgsFeatureList > features( batches.size() );
+  QgsFeatureList *featureData = features.data();
+  QVector< bool > fetched( batches.size(), false );
+  bool *fetchedData = fetched.data();
+  QList< QFuture< void > > futures;
+  for ( int i = 1; i < batches.size(); ++i )
+  {
+    const int startId = batches.at( i ) * size;
+    futures << QtConcurrent::run( &mRequestPool, [ =, &objectIds ]
+    {
+      fetchedData[i] = fetchFeatures( startId, objectIds.at( i ), filterRect, feedback, featureData[i] );
+    } );
+  }
+  fetchedData[0] = fetchFeatures( batch * size, objectIds.at( 0 ), filterRect, feedback, featureData[0] );
+  for ( QFuture< void > &future : futures )
+    future.waitForFinished();
+
+  // but re-lock while updating cache
+  locker.relock();
+  for ( int i = 0; i < batches.size(); ++i )
+  {
+    if ( !fetched.at( i ) )
+      continue;
+
+    for ( const QgsFeature &feature : features.at( i ) )
+      mCache.insert( feature.id(), feature );
+    if ( filterRect.isNull() )
+      mFetchedBatches.insert( batches.at( i ) );
+  }
+
+  // If added to cache, return feature
+  it = mCache.constFind( id );
+  if ( it != mCache.constEnd() )
+  {
+    f = it.value();
+    return filterRect.isNull() || ( f.hasGeometry() && f.geometry().intersects( filterRect ) );
+  }
+
+  return false;
+}
+
+bool QgsAfsSharedData::fetchFeatures( int startId, const QList<quint32> &objectIds, const QgsRectangle &filterRect, QgsFeedback *feedback, QgsFeatureList &features ) const
+{
   // Query
   QString errorTitle, errorMessage;
 
@@ -64,84 +129,119 @@ bool QgsAfsSharedData::getFeature( QgsFeatureId id, QgsFeature &f, const QgsRect
   if ( !referer.isEmpty() )
     headers[ QStringLiteral( "Referer" )] = referer;
 
-  const QVariantMap queryData = QgsArcGisRestUtils::getObjects(
-                                  mDataSource.param( QStringLiteral( "url" ) ), authcfg, objectIds, mDataSource.param( QStringLiteral( "crs" ) ), true,
-                                  QStringList(), QgsWkbTypes::hasM( mGeometryType ), QgsWkbTypes::hasZ( mGeometryType ),
-                                  filterRect, errorTitle, errorMessage, headers, feedback );
+  const QString url = mDataSource.param( QStringLiteral( "url" ) );
+  const QString crs = mDataSource.param( QStringLiteral( "crs" ) );
+  const bool fetchM = QgsWkbTypes::hasM( mGeometryType );
+  const bool fetchZ = QgsWkbTypes::hasZ( mGeometryType );
 
-  if ( queryData.isEmpty() )
-  {
-//    const_cast<QgsAfsProvider *>( this )->pushError( errorTitle + ": " + errorMessage );
-    QgsDebugMsg( QStringLiteral( "Query returned empty result" ) );
-    return false;
-  }
+  // A range of increasing object ids is requested by a single query, whose url stays short
+  // whatever the number of features. Other object ids are listed by several smaller queries.
+  bool increasing = !mObjectIdFieldName.isEmpty() && mFields.indexFromName( mObjectIdFieldName ) >= 0;
+  for ( int i = 1; i < objectIds.size() && increasing; ++i )
+    increasing = objectIds.at( i - 1 ) < objectIds.at( i );
 
-  // but re-lock while updating cache
-  locker.relock();
-  const QVariantList featuresData = queryData[QStringLiteral( "features" )].toList();
-  if ( featuresData.isEmpty() )
+  // responses, with the index in objectIds of their first object
+  QList< QPair< int, QVariantMap > > responses;
+  if ( increasing )
   {
-    QgsDebugMsgLevel( QStringLiteral( "Query returned no features" ), 3 );
-    return false;
+    const QVariantMap queryData = QgsArcGisRestUtils::getObjectsInRange( url, authcfg, mObjectIdFieldName, objectIds.first(), objectIds.last(), crs, true,
+                                  QStringList(), fetchM, fetchZ, filterRect, errorTitle, errorMessage, headers, feedback );
+    if ( queryData.isEmpty() )
+    {
+      QgsDebugMsg( QStringLiteral( "Query returned empty result" ) );
+      return false;
+    }
+
+    // the range holds more objects than the batch (e.g. objects added since the object ids were read),
+    // and the response was truncated: list the object ids instead
+    if ( !queryData.value( QStringLiteral( "exceededTransferLimit" ) ).toBool() )
+      responses << qMakePair( 0, queryData );
   }
-  for ( int i = 0, n = featuresData.size(); i < n; ++i )
+  if ( responses.isEmpty() )
   {
-    const QVariantMap featureData = featuresData[i].toMap();
-    QgsFeature feature;
-    int featureId = startId + i;
-
-    // Set attributes
-    const QVariantMap attributesData = featureData[QStringLiteral( "attributes" )].toMap();
-    feature.setFields( mFields );
-    QgsAttributes attributes( mFields.size() );
-    for ( int idx = 0; idx < mFields.size(); ++idx )
+    for ( int start = 0; start < objectIds.size(); start += OBJECT_ID_LIST_SIZE )
     {
-      QVariant attribute = attributesData[mFields.at( idx ).name()];
-      if ( attribute.isNull() )
+      const QVariantMap queryData = QgsArcGisRestUtils::getObjects( url, authcfg, objectIds.mid( start, OBJECT_ID_LIST_SIZE ), crs, true,
+                                    QStringList(), fetchM, fetchZ, filterRect, errorTitle, errorMessage, headers, feedback );
+      if ( queryData.isEmpty() )
       {
-        // ensure that null values are mapped correctly for PyQGIS
-        attribute = QVariant( QVariant::Int );
+        QgsDebugMsg( QStringLiteral( "Query returned empty result" ) );
+        return false;
       }
+      responses << qMakePair( start, queryData );
+    }
+  }
 
-      // date/datetime fields must be converted
-      if ( mFields.at( idx ).type() == QVariant::DateTime || mFields.at( idx ).type() == QVariant::Date )
-        attribute = QgsArcGisRestUtils::parseDateTime( attribute );
+  QHash< quint32, int > objectIdIndex;
+  objectIdIndex.reserve( objectIds.size() );
+  for ( int i = 0; i < objectIds.size(); ++i )
+    objectIdIndex.insert( objectIds.at( i ), i );
 
-      if ( !mFields.at( idx ).convertCompatible( attribute ) )
-      {
-        QgsDebugMsg( QStringLiteral( "Invalid value %1 for field %2 of type %3" ).arg( attributesData[mFields.at( idx ).name()].toString(), mFields.at( idx ).name(), mFields.at( idx ).typeName() ) );
-      }
-      attributes[idx] = attribute;
-      if ( mFields.at( idx ).name() == mObjectIdFieldName )
+  for ( const QPair< int, QVariantMap > &response : qgis::as_const( responses ) )
+  {
+    const QVariantMap &queryData = response.second;
+    const QVariantList featuresData = queryData[QStringLiteral( "features" )].toList();
+    if ( featuresData.isEmpty() )
+    {
+      QgsDebugMsgLevel( QStringLiteral( "Query returned no features" ), 3 );
+      continue;
+    }
+    for ( int i = 0, n = featuresData.size(); i < n; ++i )
+    {
+      const QVariantMap featureData = featuresData[i].toMap();
+      QgsFeature feature;
+      int featureId = startId + response.first + i;
+
+      // Set attributes
+      const QVariantMap attributesData = featureData[QStringLiteral( "attributes" )].toMap();
+      feature.setFields( mFields );
+      QgsAttributes attributes( mFields.size() );
+      for ( int idx = 0; idx < mFields.size(); ++idx )
       {
-        featureId = startId + objectIds.indexOf( attributesData[mFields.at( idx ).name()].toInt() );
+        QVariant attribute = attributesData[mFields.at( idx ).name()];
+        if ( attribute.isNull() )
+        {
+          // ensure that null values are mapped correctly for PyQGIS
+          attribute = QVariant( QVariant::Int );
+        }
+
+        // date/datetime fields must be converted
+        if ( mFields.at( idx ).type() == QVariant::DateTime || mFields.at( idx ).type() == QVariant::Date )
+          attribute = QgsArcGisRestUtils::parseDateTime( attribute );
+
+        if ( !mFields.at( idx ).convertCompatible( attribute ) )
+        {
+          QgsDebugMsg( QStringLiteral( "Invalid value %1 for field %2 of type %3" ).arg( attributesData[mFields.at( idx ).name()].toString(), mFields.at( idx ).name(), mFields.at( idx ).typeName() ) );
+        }
+        attributes[idx] = attribute;
+        if ( mFields.at( idx ).name() == mObjectIdFieldName )
+        {
+          const int index = objectIdIndex.value( attributesData[mFields.at( idx ).name()].toInt(), -1 );
+          featureId = index >= 0 ? startId + index : -1;
+        }
       }
-    }
-    feature.setAttributes( attributes );
-
-    // Set FID
-    feature.setId( featureId );
-
-    // Set geometry
-    const QVariantMap geometryData = featureData[QStringLiteral( "geometry" )].toMap();
-    std::unique_ptr< QgsAbstractGeometry > geometry = QgsArcGisRestUtils::parseEsriGeoJSON( geometryData, queryData[QStringLiteral( "geometryType" )].toString(),
-        QgsWkbTypes::hasM( mGeometryType ), QgsWkbTypes::hasZ( mGeometryType ) );
-    // Above might return 0, which is OK since in theory empty geometries are allowed
-    if ( geometry )
-      feature.setGeometry( QgsGeometry( std::move( geometry ) ) );
-    feature.setValid( true );
-    mCache.insert( feature.id(), feature );
-  }
 
-  // If added to cache, return feature
-  it = mCache.constFind( id );
-  if ( it != mCache.constEnd() )
-  {
-    f = it.value();
-    return filterRect.isNull() || ( f.hasGeometry() && f.geometry().intersects( filterRect ) );
-  }
+      // skip the objects which were not in the batch
+      if ( featureId < 0 )
+        continue;
 
-  return false;
+      feature.setAttributes( attributes );
+
+      // Set FID
+      feature.setId( featureId );
+
+      // Set geometry
+      const QVariantMap geometryData = featureData[QStringLiteral( "geometry" )].toMap();
+      std::unique_ptr< QgsAbstractGeometry > geometry = QgsArcGisRestUtils::parseEsriGeoJSON( geometryData, queryData[QStringLiteral( "geometryType" )].toString(),
+          fetchM, fetchZ );
+      // Above might return 0, which is OK since in theory empty geometries are allowed
+      if ( geometry )
+        feature.setGeometry( QgsGeometry( std::move( geometry ) ) );
+      feature.setValid( true );
+      features << feature;
+    }
+  }
+  return true;
 }
 
 QgsFeatureIds QgsAfsSharedData::getFeatureIdsInExtent( const QgsRectangle &extent, QgsFeedback *feedback )
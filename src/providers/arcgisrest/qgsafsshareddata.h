@@ -18,6 +18,8 @@
 
 #include <QObject>
 #include <QMutex>
+#include <QSet>
+#include <QThreadPool>
 #include "qgsfields.h"
 #include "qgsfeature.h"
 #include "qgsdatasourceuri.h"
@@ -45,6 +47,17 @@ class QgsAfsSharedData : public QObject
 
   private:
     friend class QgsAfsProvider;
+
+    /**
+     * Requests the features with the given \a objectIds, whose first feature has the id \a startId, and
+     * converts them to features. Returns FALSE if the features could not be requested.
+     * This is safe to call from several threads at once.
+     */
+    bool fetchFeatures( int startId, const QList<quint32> &objectIds, const QgsRectangle &filterRect, QgsFeedback *feedback, QgsFeatureList &features ) const;
+
+    //! Returns the number of features requested at once
+    int batchSize() const;
+
     QMutex mMutex;
     QgsDataSourceUri mDataSource;
     QgsRectangle mExtent;
@@ -54,6 +67,15 @@ class QgsAfsSharedData : public QObject
     QList<quint32> mObjectIds;
     QMap<QgsFeatureId, QgsFeature> mCache;
     QgsCoordinateReferenceSystem mSourceCRS;
+
+    //! Maximum number of features returned by the service for a query, or 0 if unknown
+    int mMaxRecordCount = 0;
+    //! Number of batches of features requested concurrently when the features are read in sequence
+    int mParallelRequests = 1;
+    //! Indexes of the batches whose features were all fetched in the cache
+    QSet<int> mFetchedBatches;
+    //! Threads requesting the batches of features following the one of a read feature
+    QThreadPool mRequestPool;
 };
 
 #endif
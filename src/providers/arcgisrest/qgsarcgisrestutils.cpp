@@ -443,10 +443,31 @@ QVariantMap QgsArcGisRestUtils::getObjects( const QString &layerurl, const QStri
   {
     ids.append( QString::number( id ) );
   }
+  return queryObjects( layerurl, authcfg, QStringLiteral( "objectIds" ), ids.join( QStringLiteral( "," ) ), crs, fetchGeometry, fetchAttributes,
+                       fetchM, fetchZ, filterRect, errorTitle, errorText, requestHeaders, feedback );
+}
+
+QVariantMap QgsArcGisRestUtils::getObjectsInRange( const QString &layerurl, const QString &authcfg, const QString &objectIdField, quint32 minimumId, quint32 maximumId,
+    const QString &crs, bool fetchGeometry, const QStringList &fetchAttributes,
+    bool fetchM, bool fetchZ,
+    const QgsRectangle &filterRect,
+    QString &errorTitle, QString &errorText, const QgsStringMap &requestHeaders, QgsFeedback *feedback )
+{
+  const QString where = QStringLiteral( "%1>=%2 AND %1<=%3" ).arg( objectIdField ).arg( minimumId ).arg( maximumId );
+  return queryObjects( layerurl, authcfg, QStringLiteral( "where" ), where, crs, fetchGeometry, fetchAttributes,
+                       fetchM, fetchZ, filterRect, errorTitle, errorText, requestHeaders, feedback );
+}
+
+QVariantMap QgsArcGisRestUtils::queryObjects( const QString &layerurl, const QString &authcfg, const QString &selectionKey, const QString &selection, const QString &crs,
+    bool fetchGeometry, const QStringList &fetchAttributes,
+    bool fetchM, bool fetchZ,
+    const QgsRectangle &filterRect,
+    QString &errorTitle, QString &errorText, const QgsStringMap &requestHeaders, QgsFeedback *feedback )
+{
   QUrl queryUrl( layerurl + "/query" );
   QUrlQuery query( queryUrl );
   query.addQueryItem( QStringLiteral( "f" ), QStringLiteral( "json" ) );
-  query.addQueryItem( QStringLiteral( "objectIds" ), ids.join( QStringLiteral( "," ) ) );
+  query.addQueryItem( selectionKey, selection );
   QString wkid = crs.indexOf( QLatin1String( ":" ) ) >= 0 ? crs.split( ':' )[1] : QString();
   query.addQueryItem( QStringLiteral( "inSR" ), wkid );
   query.addQueryItem( QStringLiteral( "outSR" ), wkid );
@@ -74,6 +74,14 @@ class QgsArcGisRestUtils
     static QVariantMap getObjects( const QString &layerurl, const QString &authcfg, const QList<quint32> &objectIds, const QString &crs,
                                    bool fetchGeometry, const QStringList &fetchAttributes, bool fetchM, bool fetchZ,
                                    const QgsRectangle &filterRect, QString &errorTitle, QString &errorText, const QgsStringMap &requestHeaders = QgsStringMap(), QgsFeedback *feedback = nullptr );
+
+    /**
+     * Returns the objects whose object id, stored in \a objectIdField, is between \a minimumId and \a maximumId included.
+     * The response is limited to the maxRecordCount of the layer, which is then reported with exceededTransferLimit.
+     */
+    static QVariantMap getObjectsInRange( const QString &layerurl, const QString &authcfg, const QString &objectIdField, quint32 minimumId, quint32 maximumId,
+                                          const QString &crs, bool fetchGeometry, const QStringList &fetchAttributes, bool fetchM, bool fetchZ,
+                                          const QgsRectangle &filterRect, QString &errorTitle, QString &errorText, const QgsStringMap &requestHeaders = QgsStringMap(), QgsFeedback *feedback = nullptr );
     static QList<quint32> getObjectIdsByExtent( const QString &layerurl, const QgsRectangle &filterRect, QString &errorTitle, QString &errorText, const QString &authcfg, const QgsStringMap &requestHeaders = QgsStringMap(), QgsFeedback *feedback = nullptr );
     static QByteArray queryService( const QUrl &url, const QString &authcfg, QString &errorTitle, QString &errorText, const QgsStringMap &requestHeaders = QgsStringMap(), QgsFeedback *feedback = nullptr, QString *contentType = nullptr );
     static QVariantMap queryServiceJSON( const QUrl &url, const QString &authcfg, QString &errorTitle, QString &errorText, const QgsStringMap &requestHeaders = QgsStringMap(), QgsFeedback *feedback = nullptr );
@@ -109,6 +117,13 @@ class QgsArcGisRestUtils
     static void visitFolderItems( const std::function<void ( const QString &folderName, const QString &url )> &visitor, const QVariantMap &serviceData, const QString &baseUrl );
     static void visitServiceItems( const std::function<void ( const QString &serviceName, const QString &url )> &visitor, const QVariantMap &serviceData, const QString &baseUrl, const ServiceTypeFilter filter = QgsArcGisRestUtils::AllTypes );
     static void addLayerItems( const std::function<void ( const QString &parentLayerId, const QString &layerId, const QString &name, const QString &description, const QString &url, bool isParentLayer, const QString &authid, const QString &format )> &visitor, const QVariantMap &serviceData, const QString &parentUrl, const ServiceTypeFilter filter = QgsArcGisRestUtils::AllTypes );
+
+  private:
+
+    //! Queries the objects selected by the \a selectionKey query item, set to \a selection
+    static QVariantMap queryObjects( const QString &layerurl, const QString &authcfg, const QString &selectionKey, const QString &selection, const QString &crs,
+                                     bool fetchGeometry, const QStringList &fetchAttributes, bool fetchM, bool fetchZ,
+                                     const QgsRectangle &filterRect, QString &errorTitle, QString &errorText, const QgsStringMap &requestHeaders, QgsFeedback *feedback );
 };
 
 class QgsArcGisAsyncQuery : public QObject
@@ -27,6 +27,8 @@
 #include <QRegExp>
 #include <QUrl>
 #include <QUrlQuery>
+#include <QThreadPool>
+#include <QtConcurrentMap>
 
 #include "qgsapplication.h"
 #include "qgscoordinateutils.h"
@@ -56,6 +58,50 @@ const QString QgsDelimitedTextProvider::TEXT_PROVIDER_DESCRIPTION = QStringLiter
 
 static const int SUBSET_ID_THRESHOLD_FACTOR = 10;
 
+// Number of records parsed by each thread of the global thread pool, for each chunk of
+// records read while scanning the file
+
+static const int SCAN_CHUNK_SIZE = 1024;
+
+// Types a value of a column can be converted to
+
+enum ScannedValueType
+{
+  CouldBeInt = 1,
+  CouldBeLongLong = 1 << 1,
+  CouldBeDouble = 1 << 2,
+  CouldBeDateTime = 1 << 3,
+  CouldBeDate = 1 << 4,
+  CouldBeTime = 1 << 5,
+};
+static const int ALL_VALUE_TYPES = CouldBeInt | CouldBeLongLong | CouldBeDouble | CouldBeDateTime | CouldBeDate | CouldBeTime;
+
+///@cond PRIVATE
+
+//! A record read by QgsDelimitedTextProvider::scanFile(), with the results of QgsDelimitedTextProvider::scanRecord()
+struct QgsDelimitedTextProvider::ScannedRecord
+{
+  enum GeometryStatus
+  {
+    GeometryEmpty,
+    GeometryValid,
+    GeometryInvalid,
+  };
+
+  QgsDelimitedTextFile::Status status = QgsDelimitedTextFile::RecordOk;
+  QStringList parts;
+  long recordId = -1;
+  bool isEmpty = false;
+  GeometryStatus geometryStatus = GeometryEmpty;
+  QgsGeometry geometry;
+  bool wktHasPrefix = false;
+  QgsPoint point;
+  //! Types each value can be converted to, as ScannedValueType flags
+  QVector<int> valueTypes;
+};
+
+///@endcond
+
 QRegExp QgsDelimitedTextProvider::sWktPrefixRegexp( "^\\s*(?:\\d+\\s+|SRID\\=\\d+\\;)", Qt::CaseInsensitive );
 QRegExp QgsDelimitedTextProvider::sCrdDmsRegexp( "^\\s*(?:([-+nsew])\\s*)?(\\d{1,3})(?:[^0-9.]+([0-5]?\\d))?[^0-9.]+([0-5]?\\d(?:\\.\\d+)?)[^0-9.]*([-+nsew])?\\s*$", Qt::CaseInsensitive );
 
@@ -392,7 +438,6 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
   //
   // Also build subset and spatial indexes.
 
-  QStringList parts;
   long nEmptyRecords = 0;
   long nBadFormatRecords = 0;
   long nIncompatibleGeometry = 0;
@@ -411,118 +456,135 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
 
   bool foundFirstGeometry = false;
 
-  while ( true )
+  // The records are read sequentially, as quoted fields may span several lines, but
+  // their geometries and values are parsed in parallel, by chunks. The results are then
+  // merged in the order of the records.
+  const int chunkSize = SCAN_CHUNK_SIZE * std::max( 1, QThreadPool::globalInstance()->maxThreadCount() );
+  QVector<ScannedRecord> records;
+  records.reserve( chunkSize );
+  bool endOfFile = false;
+  while ( !endOfFile )
   {
-    QgsDelimitedTextFile::Status status = mFile->nextRecord( parts );
-    if ( status == QgsDelimitedTextFile::RecordEOF )
-      break;
-    if ( status != QgsDelimitedTextFile::RecordOk )
+    records.resize( 0 );
+    while ( records.size() < chunkSize )
     {
-      nBadFormatRecords++;
-      recordInvalidLine( tr( "Invalid record format at line %1" ) );
-      continue;
+      ScannedRecord record;
+      record.status = mFile->nextRecord( record.parts );
+      if ( record.status == QgsDelimitedTextFile::RecordEOF )
+      {
+        endOfFile = true;
+        break;
+      }
+      record.recordId = mFile->recordId();
+      records.append( record );
     }
-    // Skip over empty records
-    if ( recordIsEmpty( parts ) )
+
+    // The possible types of a column can only be narrowed, there is no need to test the others
+    QVector<int> possibleTypes( couldBeInt.size(), ALL_VALUE_TYPES );
+    for ( int i = 0; i < couldBeInt.size(); i++ )
     {
-      nEmptyRecords++;
-      continue;
+      if ( isEmpty[i] )
+        continue;
+      possibleTypes[i] = ( couldBeInt[i] ? CouldBeInt : 0 ) | ( couldBeLongLong[i] ? CouldBeLongLong : 0 ) |
+                         ( couldBeDouble[i] ? CouldBeDouble : 0 ) | ( couldBeDateTime[i] ? CouldBeDateTime : 0 ) |
+                         ( couldBeDate[i] ? CouldBeDate : 0 ) | ( couldBeTime[i] ? CouldBeTime : 0 );
     }
 
-    // Check geometries are valid
-    bool geomValid = true;
+    QtConcurrent::blockingMap( records, [this, &possibleTypes]( ScannedRecord & record )
+    {
+      scanRecord( record, possibleTypes );
+    } );
 
-    if ( mGeomRep == GeomAsWkt )
+    for ( ScannedRecord &record : records )
     {
-      if ( mWktFieldIndex >= parts.size() || parts[mWktFieldIndex].isEmpty() )
+      if ( record.status != QgsDelimitedTextFile::RecordOk )
       {
-        nEmptyGeometry++;
-        mNumberFeatures++;
+        nBadFormatRecords++;
+        recordInvalidLine( tr( "Invalid record format at line %1" ), record.recordId );
+        continue;
       }
-      else
+      // Skip over empty records
+      if ( record.isEmpty )
       {
-        // Get the wkt - confirm it is valid, get the type, and
-        // if compatible with the rest of file, add to the extents
+        nEmptyRecords++;
+        continue;
+      }
 
-        QString sWkt = parts[mWktFieldIndex];
-        QgsGeometry geom;
-        if ( !mWktHasPrefix && sWkt.indexOf( sWktPrefixRegexp ) >= 0 )
-          mWktHasPrefix = true;
-        geom = geomFromWkt( sWkt, mWktHasPrefix );
+      // Check geometries are valid
+      bool geomValid = true;
 
-        if ( !geom.isNull() )
+      if ( mGeomRep == GeomAsWkt )
+      {
+        if ( record.geometryStatus == ScannedRecord::GeometryEmpty )
         {
-          QgsWkbTypes::Type type = geom.wkbType();
-          if ( type != QgsWkbTypes::NoGeometry )
+          nEmptyGeometry++;
+          mNumberFeatures++;
+        }
+        else
+        {
+          // The wkt was parsed by scanRecord(), check the type, and
+          // if compatible with the rest of file, add to the extents
+
+          if ( record.wktHasPrefix )
+            mWktHasPrefix = true;
+          const QgsGeometry &geom = record.geometry;
+
+          if ( record.geometryStatus == ScannedRecord::GeometryValid )
           {
-            if ( mGeometryType == QgsWkbTypes::UnknownGeometry || geom.type() == mGeometryType )
+            QgsWkbTypes::Type type = geom.wkbType();
+            if ( type != QgsWkbTypes::NoGeometry )
             {
-              mGeometryType = geom.type();
-              if ( !foundFirstGeometry )
-              {
-                mNumberFeatures++;
-                mWkbType = type;
-                mExtent = geom.boundingBox();
-                foundFirstGeometry = true;
-              }
-              else
+              if ( mGeometryType == QgsWkbTypes::UnknownGeometry || geom.type() == mGeometryType )
               {
-                mNumberFeatures++;
-                if ( geom.isMultipart() )
+                mGeometryType = geom.type();
+                if ( !foundFirstGeometry )
+                {
+                  mNumberFeatures++;
                   mWkbType = type;
-                QgsRectangle bbox( geom.boundingBox() );
-                mExtent.combineExtentWith( bbox );
+                  mExtent = geom.boundingBox();
+                  foundFirstGeometry = true;
+                }
+                else
+                {
+                  mNumberFeatures++;
+                  if ( geom.isMultipart() )
+                    mWkbType = type;
+                  QgsRectangle bbox( geom.boundingBox() );
+                  mExtent.combineExtentWith( bbox );
+                }
+                if ( buildSpatialIndex )
+                {
+                  QgsFeature f;
+                  f.setId( record.recordId );
+                  f.setGeometry( geom );
+                  mSpatialIndex->addFeature( f );
+                }
               }
-              if ( buildSpatialIndex )
+              else
               {
-                QgsFeature f;
-                f.setId( mFile->recordId() );
-                f.setGeometry( geom );
-                mSpatialIndex->addFeature( f );
+                nIncompatibleGeometry++;
+                geomValid = false;
               }
             }
-            else
-            {
-              nIncompatibleGeometry++;
-              geomValid = false;
-            }
           }
-        }
-        else
-        {
-          geomValid = false;
-          nInvalidGeometry++;
-          recordInvalidLine( tr( "Invalid WKT at line %1" ) );
+          else
+          {
+            geomValid = false;
+            nInvalidGeometry++;
+            recordInvalidLine( tr( "Invalid WKT at line %1" ), record.recordId );
+          }
         }
       }
-    }
-    else if ( mGeomRep == GeomAsXy )
-    {
-      // Get the x and y values, first checking to make sure they
-      // aren't null.
-
-      QString sX = mXFieldIndex < parts.size() ? parts[mXFieldIndex] : QString();
-      QString sY = mYFieldIndex < parts.size() ? parts[mYFieldIndex] : QString();
-      QString sZ, sM;
-      if ( mZFieldIndex > -1 )
-        sZ = mZFieldIndex < parts.size() ? parts[mZFieldIndex] : QString();
-      if ( mMFieldIndex > -1 )
-        sM = mMFieldIndex < parts.size() ? parts[mMFieldIndex] : QString();
-      if ( sX.isEmpty() && sY.isEmpty() )
+      else if ( mGeomRep == GeomAsXy )
       {
-        nEmptyGeometry++;
-        mNumberFeatures++;
-      }
-      else
-      {
-        QgsPoint pt;
-        bool ok = pointFromXY( sX, sY, pt, mDecimalPoint, mXyDms );
-
-        if ( ok )
+        if ( record.geometryStatus == ScannedRecord::GeometryEmpty )
         {
-          if ( !sZ.isEmpty() || sM.isEmpty() )
-            appendZM( sZ, sM, pt, mDecimalPoint );
-
+          nEmptyGeometry++;
+          mNumberFeatures++;
+        }
+        else if ( record.geometryStatus == ScannedRecord::GeometryValid )
+        {
+          const QgsPoint &pt = record.point;
           if ( foundFirstGeometry )
           {
             mExtent.combineExtentWith( pt.x(), pt.y() );
@@ -543,7 +605,7 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
           if ( buildSpatialIndex && std::isfinite( pt.x() ) && std::isfinite( pt.y() ) )
           {
             QgsFeature f;
-            f.setId( mFile->recordId() );
+            f.setId( record.recordId );
             f.setGeometry( QgsGeometry::fromPointXY( pt ) );
             mSpatialIndex->addFeature( f );
           }
@@ -552,108 +614,80 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
         {
           geomValid = false;
           nInvalidGeometry++;
-          recordInvalidLine( tr( "Invalid X or Y fields at line %1" ) );
+          recordInvalidLine( tr( "Invalid X or Y fields at line %1" ), record.recordId );
         }
       }
-    }
-    else
-    {
-      mWkbType = QgsWkbTypes::NoGeometry;
-      mNumberFeatures++;
-    }
-
-    if ( !geomValid )
-      continue;
-
-    if ( buildSubsetIndex )
-      mSubsetIndex.append( mFile->recordId() );
-
-
-    // If we are going to use this record, then assess the potential types of each column
-
-    for ( int i = 0; i < parts.size(); i++ )
-    {
-
-      QString &value = parts[i];
-      // Ignore empty fields - spreadsheet generated CSV files often
-      // have random empty fields at the end of a row
-      if ( value.isEmpty() )
-        continue;
-
-      // Expand the columns to include this non empty field if necessary
-
-      while ( couldBeInt.size() <= i )
-      {
-        isEmpty.append( true );
-        couldBeInt.append( false );
-        couldBeLongLong.append( false );
-        couldBeDouble.append( false );
-        couldBeDateTime.append( false );
-        couldBeDate.append( false );
-        couldBeTime.append( false );
-      }
-
-      // If this column has been empty so far then initiallize it
-      // for possible types
-
-      if ( isEmpty[i] )
+      else
       {
-        isEmpty[i] = false;
-        couldBeInt[i] = true;
-        couldBeLongLong[i] = true;
-        couldBeDouble[i] = true;
-        couldBeDateTime[i] = true;
-        couldBeDate[i] = true;
-        couldBeTime[i] = true;
+        mWkbType = QgsWkbTypes::NoGeometry;
+        mNumberFeatures++;
       }
 
-      if ( ! mDetectTypes )
-      {
+      if ( !geomValid )
         continue;
-      }
 
-      // Now test for still valid possible types for the field
-      // Types are possible until first record which cannot be parsed
+      if ( buildSubsetIndex )
+        mSubsetIndex.append( record.recordId );
 
-      if ( couldBeInt[i] )
-      {
-        ( void )value.toInt( &couldBeInt[i] );
-      }
+      // If we are going to use this record, then assess the potential types of each column,
+      // from the types found by scanRecord()
 
-      if ( couldBeLongLong[i] && !couldBeInt[i] )
+      const QStringList &parts = record.parts;
+      for ( int i = 0; i < parts.size(); i++ )
       {
-        ( void )value.toLongLong( &couldBeLongLong[i] );
-      }
+        // Ignore empty fields - spreadsheet generated CSV files often
+        // have random empty fields at the end of a row
+        if ( parts[i].isEmpty() )
+          continue;
 
-      if ( couldBeDouble[i] && !couldBeLongLong[i] )
-      {
-        if ( ! mDecimalPoint.isEmpty() )
+        // Expand the columns to include this non empty field if necessary
+
+        while ( couldBeInt.size() <= i )
         {
-          value.replace( mDecimalPoint, QLatin1String( "." ) );
+          isEmpty.append( true );
+          couldBeInt.append( false );
+          couldBeLongLong.append( false );
+          couldBeDouble.append( false );
+          couldBeDateTime.append( false );
+          couldBeDate.append( false );
+          couldBeTime.append( false );
         }
-        ( void )value.toDouble( &couldBeDouble[i] );
-      }
 
-      if ( couldBeDateTime[i] )
-      {
-        QDateTime dt;
-        if ( value.length() > 10 )
+        // If this column has been empty so far then initiallize it
+        // for possible types
+
+        if ( isEmpty[i] )
         {
-          dt = QDateTime::fromString( value, Qt::ISODate );
+          isEmpty[i] = false;
+          couldBeInt[i] = true;
+          couldBeLongLong[i] = true;
+          couldBeDouble[i] = true;
+          couldBeDateTime[i] = true;
+          couldBeDate[i] = true;
+          couldBeTime[i] = true;
         }
-        couldBeDateTime[i] = ( dt.isValid() );
-      }
 
-      if ( couldBeDate[i] && !couldBeDateTime[i] )
-      {
-        QDate d = QDate::fromString( value, Qt::ISODate );
-        couldBeDate[i] = d.isValid();
-      }
+        if ( ! mDetectTypes )
+        {
+          continue;
+        }
 
-      if ( couldBeTime[i] && !couldBeDateTime[i] )
-      {
-        QTime t = QTime::fromString( value );
-        couldBeTime[i] = t.isValid();
+        // Now test for still valid possible types for the field
+        // Types are possible until first record which cannot be parsed
+
+        const int types = record.valueTypes.at( i );
+        if ( couldBeInt[i] )
+          couldBeInt[i] = types & CouldBeInt;
+        if ( couldBeLongLong[i] && !couldBeInt[i] )
+          couldBeLongLong[i] = types & CouldBeLongLong;
+        if ( couldBeDouble[i] && !couldBeLongLong[i] )
+          couldBeDouble[i] = types & CouldBeDouble;
+        if ( couldBeDateTime[i] )
+          couldBeDateTime[i] = types & CouldBeDateTime;
+        if ( couldBeDate[i] && !couldBeDateTime[i] )
+          couldBeDate[i] = types & CouldBeDate;
+        if ( couldBeTime[i] && !couldBeDateTime[i] )
+          couldBeTime[i] = types & CouldBeTime;
       }
     }
   }
@@ -783,6 +817,106 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
   connect( mFile.get(), &QgsDelimitedTextFile::fileUpdated, this, &QgsDelimitedTextProvider::onFileUpdated );
 }
 
+void QgsDelimitedTextProvider::scanRecord( ScannedRecord &record, const QVector<int> &possibleTypes ) const
+{
+  if ( record.status != QgsDelimitedTextFile::RecordOk )
+    return;
+  record.isEmpty = recordIsEmpty( record.parts );
+  if ( record.isEmpty )
+    return;
+
+  const QStringList &parts = record.parts;
+  if ( mGeomRep == GeomAsWkt )
+  {
+    if ( mWktFieldIndex >= parts.size() || parts[mWktFieldIndex].isEmpty() )
+    {
+      record.geometryStatus = ScannedRecord::GeometryEmpty;
+    }
+    else
+    {
+      QString sWkt = parts[mWktFieldIndex];
+      record.wktHasPrefix = sWkt.indexOf( sWktPrefixRegexp ) >= 0;
+      record.geometry = geomFromWkt( sWkt, record.wktHasPrefix );
+      record.geometryStatus = record.geometry.isNull() ? ScannedRecord::GeometryInvalid : ScannedRecord::GeometryValid;
+    }
+  }
+  else if ( mGeomRep == GeomAsXy )
+  {
+    // Get the x and y values, first checking to make sure they
+    // aren't null.
+
+    QString sX = mXFieldIndex < parts.size() ? parts[mXFieldIndex] : QString();
+    QString sY = mYFieldIndex < parts.size() ? parts[mYFieldIndex] : QString();
+    QString sZ, sM;
+    if ( mZFieldIndex > -1 )
+      sZ = mZFieldIndex < parts.size() ? parts[mZFieldIndex] : QString();
+    if ( mMFieldIndex > -1 )
+      sM = mMFieldIndex < parts.size() ? parts[mMFieldIndex] : QString();
+    if ( sX.isEmpty() && sY.isEmpty() )
+    {
+      record.geometryStatus = ScannedRecord::GeometryEmpty;
+    }
+    else if ( pointFromXY( sX, sY, record.point, mDecimalPoint, mXyDms ) )
+    {
+      if ( !sZ.isEmpty() || sM.isEmpty() )
+        appendZM( sZ, sM, record.point, mDecimalPoint );
+      record.geometryStatus = ScannedRecord::GeometryValid;
+    }
+    else
+    {
+      record.geometryStatus = ScannedRecord::GeometryInvalid;
+    }
+  }
+
+  if ( ! mDetectTypes || record.geometryStatus == ScannedRecord::GeometryInvalid )
+    return;
+
+  record.valueTypes.fill( 0, parts.size() );
+  for ( int i = 0; i < parts.size(); i++ )
+  {
+    QString value = parts[i];
+    if ( value.isEmpty() )
+      continue;
+
+    const int possible = i < possibleTypes.size() ? possibleTypes.at( i ) : ALL_VALUE_TYPES;
+    int types = 0;
+    bool ok = false;
+    if ( possible & CouldBeInt )
+    {
+      ( void )value.toInt( &ok );
+      types |= ok ? CouldBeInt : 0;
+    }
+    if ( possible & CouldBeLongLong )
+    {
+      ( void )value.toLongLong( &ok );
+      types |= ok ? CouldBeLongLong : 0;
+    }
+    if ( possible & CouldBeDouble )
+    {
+      QString number = value;
+      if ( ! mDecimalPoint.isEmpty() )
+      {
+        number.replace( mDecimalPoint, QLatin1String( "." ) );
+      }
+      ( void )number.toDouble( &ok );
+      types |= ok ? CouldBeDouble : 0;
+    }
+    if ( ( possible & CouldBeDateTime ) && value.length() > 10 && QDateTime::fromString( value, Qt::ISODate ).isValid() )
+    {
+      types |= CouldBeDateTime;
+    }
+    if ( ( possible & CouldBeDate ) && QDate::fromString( value, Qt::ISODate ).isValid() )
+    {
+      types |= CouldBeDate;
+    }
+    if ( ( possible & CouldBeTime ) && QTime::fromString( value ).isValid() )
+    {
+      types |= CouldBeTime;
+    }
+    record.valueTypes[i] = types;
+  }
+}
+
 // rescanFile.  Called if something has changed file definition, such as
 // selecting a subset, the file has been changed by another program, etc
 
@@ -990,11 +1124,11 @@ bool QgsDelimitedTextProvider::recordIsEmpty( QStringList &record )
   return true;
 }
 
-void QgsDelimitedTextProvider::recordInvalidLine( const QString &message )
+void QgsDelimitedTextProvider::recordInvalidLine( const QString &message, long recordId )
 {
   if ( mInvalidLines.size() < mMaxInvalidLines )
   {
-    mInvalidLines.append( message.arg( mFile->recordId() ) );
+    mInvalidLines.append( message.arg( recordId ) );
   }
   else
   {
@@ -142,12 +142,21 @@ class QgsDelimitedTextProvider final: public QgsVectorDataProvider
 
     void scanFile( bool buildIndexes );
 
+    struct ScannedRecord;
+
+    /**
+     * Parses the geometry of a \a record read by scanFile(), and finds the types its values
+     * can be converted to, among the \a possibleTypes of each column. This is called
+     * on several records in parallel.
+     */
+    void scanRecord( ScannedRecord &record, const QVector<int> &possibleTypes ) const;
+
     //some of these methods const, as they need to be called from const methods such as extent()
     void rescanFile() const;
     void resetCachedSubset() const;
     void resetIndexes() const;
     void clearInvalidLines() const;
-    void recordInvalidLine( const QString &message );
+    void recordInvalidLine( const QString &message, long recordId );
     void reportErrors( const QStringList &messages = QStringList(), bool showDialog = false ) const;
     static bool recordIsEmpty( QStringList &record );
     void setUriParameter( const QString &parameter, const QString &value );
@@ -38,12 +38,19 @@
 #include <QFileInfo>
 #include <QFile>
 #include <QHash>
+#include <QCache>
+#include <QMutex>
 
 #define ERR(message) QGS_ERROR_MESSAGE(message,"GRASS provider")
 #define QGS_ERROR(message) QgsError(message,"GRASS provider")
 
 // Do not use warning dialogs, providers are also created on threads (rendering) where dialogs cannot be used (constructing QPixmap icon)
 
+// Values read by qgis.d.rast, shared by the clones of the providers used by the renderers.
+// The cost is in kilobytes.
+static QMutex sRasterDataCacheMutex;
+static QCache<QString, QByteArray> sRasterDataCache( 100 * 1024 );
+
 QgsGrassRasterProvider::QgsGrassRasterProvider( QString const &uri )
   : QgsRasterDataProvider( uri )
   , mNoDataValue( std::numeric_limits<double>::quiet_NaN() )
@@ -202,11 +209,10 @@ bool QgsGrassRasterProvider::readBlock( int bandNo, int xBlock, int yBlock, void
                       .arg( mCols ).arg( mYBlockSize ) ) );
 
   arguments.append( QStringLiteral( "format=value" ) );
-  QString cmd = QgsApplication::libexecPath() + "grass/modules/qgis.d.rast";
   QByteArray data;
   try
   {
-    data = QgsGrass::runModule( mGisdbase, mLocation, mMapset, cmd, arguments );
+    data = readRasterData( arguments );
   }
   catch ( QgsGrass::Exception &e )
   {
@@ -254,11 +260,10 @@ bool QgsGrassRasterProvider::readBlock( int bandNo, QgsRectangle  const &viewExt
                             QgsRasterBlock::printValue( viewExtent.yMaximum() ) )
                       .arg( pixelWidth ).arg( pixelHeight ) ) );
   arguments.append( QStringLiteral( "format=value" ) );
-  QString cmd = QgsApplication::libexecPath() + "grass/modules/qgis.d.rast";
   QByteArray data;
   try
   {
-    data = QgsGrass::runModule( mGisdbase, mLocation, mMapset, cmd, arguments );
+    data = readRasterData( arguments );
   }
   catch ( QgsGrass::Exception &e )
   {
@@ -285,6 +290,27 @@ bool QgsGrassRasterProvider::readBlock( int bandNo, QgsRectangle  const &viewExt
   return true;
 }
 
+QByteArray QgsGrassRasterProvider::readRasterData( const QStringList &arguments ) const
+{
+  // the timestamp of the map is part of the key, so that the values of a modified map are read again
+  const QString key = QStringLiteral( "%1/%2/%3/%4|%5|%6" ).arg( mGisdbase, mLocation, mMapset, mMapName )
+                      .arg( dataTimestamp().toMSecsSinceEpoch() ).arg( arguments.join( '|' ) );
+  {
+    QMutexLocker locker( &sRasterDataCacheMutex );
+    if ( const QByteArray *cachedData = sRasterDataCache.object( key ) )
+    {
+      return *cachedData;
+    }
+  }
+
+  QString cmd = QgsApplication::libexecPath() + "grass/modules/qgis.d.rast";
+  QByteArray data = QgsGrass::runModule( mGisdbase, mLocation, mMapset, cmd, arguments );
+
+  QMutexLocker locker( &sRasterDataCacheMutex );
+  sRasterDataCache.insert( key, new QByteArray( data ), data.size() / 1024 + 1 );
+  return data;
+}
+
 QgsRasterBandStats QgsGrassRasterProvider::bandStatistics( int bandNo, int stats, const QgsRectangle &boundingBox, int sampleSize, QgsRasterBlockFeedback * )
 {
   QgsDebugMsg( QString( "theBandNo = %1 sampleSize = %2" ).arg( bandNo ).arg( sampleSize ) );
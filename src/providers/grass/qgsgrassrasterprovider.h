@@ -219,6 +219,12 @@ class GRASS_LIB_EXPORT QgsGrassRasterProvider : public QgsRasterDataProvider
     // append error if it is not empty
     void appendIfError( const QString &error );
 
+    /**
+     * Returns the values read by qgis.d.rast with \a arguments. The values are cached, so that
+     * redrawing the same extent does not start the module again. Throws QgsGrass::Exception.
+     */
+    QByteArray readRasterData( const QStringList &arguments ) const;
+
     /**
      * Flag indicating if the layer data source is a valid layer
      */
@@ -374,7 +374,7 @@ bool QgsMssqlFeatureIterator::fetchFeature( QgsFeature &feature )
     for ( int i = 0; i < mAttributesToFetch.count(); i++ )
     {
       const QVariant originalValue = mQuery->value( i );
-      QgsField fld = mSource->mFields.at( mAttributesToFetch.at( i ) );
+      const QgsField &fld = mSource->mFields.at( mAttributesToFetch.at( i ) );
       QVariant v = originalValue;
       if ( v.type() != fld.type() )
         v = QgsVectorDataProvider::convertValue( fld.type(), originalValue.toString() );
@@ -398,15 +398,17 @@ bool QgsMssqlFeatureIterator::fetchFeature( QgsFeature &feature )
       feature.setAttribute( mAttributesToFetch.at( i ), v );
     }
 
-    feature.setId( mQuery->record().value( mSource->mFidColName ).toLongLong() );
+    // QSqlQuery::record() would copy the values of all the columns, so they are read by index
+    feature.setId( mQuery->value( mFidQueryColumn ).toLongLong() );
 
     feature.clearGeometry();
-    if ( mSource->isSpatial() )
+    if ( mGeometryQueryColumn >= 0 )
     {
-      QByteArray ar = mQuery->record().value( mSource->mGeometryColName ).toByteArray();
+      // the blob is shared with the driver's row cache, and only read by the parser: it must not be detached
+      const QByteArray ar = mQuery->value( mGeometryQueryColumn ).toByteArray();
       if ( !ar.isEmpty() )
       {
-        std::unique_ptr<QgsAbstractGeometry> geom = mParser.parseSqlGeometry( reinterpret_cast< unsigned char * >( ar.data() ), ar.size() );
+        std::unique_ptr<QgsAbstractGeometry> geom = mParser.parseSqlGeometry( reinterpret_cast< unsigned char * >( const_cast< char * >( ar.constData() ) ), ar.size() );
         if ( geom )
         {
           feature.setGeometry( QgsGeometry( std::move( geom ) ) );
@@ -492,6 +494,10 @@ bool QgsMssqlFeatureIterator::rewind()
     return false;
   }
 
+  const QSqlRecord record = mQuery->record();
+  mFidQueryColumn = record.indexOf( mSource->mFidColName );
+  mGeometryQueryColumn = mSource->isSpatial() ? record.indexOf( mSource->mGeometryColName ) : -1;
+
   return true;
 }
 
@@ -113,6 +113,10 @@ class QgsMssqlFeatureIterator final: public QgsAbstractFeatureIteratorFromSource
     // Field index of FID column
     int mFidCol = -1;
 
+    // Indexes of the FID and geometry columns in the query results, resolved once per query
+    int mFidQueryColumn = -1;
+    int mGeometryQueryColumn = -1;
+
     // List of attribute indices to fetch with nextFeature calls
     QgsAttributeList mAttributesToFetch;
 
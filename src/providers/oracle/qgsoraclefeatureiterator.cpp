@@ -353,7 +353,7 @@ bool QgsOracleFeatureIterator::fetchFeature( QgsFeature &feature )
       case PktInt:
         // get 64bit integer from result
         fid = mQry.value( col++ ).toLongLong();
-        if ( mAttributeList.contains( mSource->mPrimaryKeyAttrs.value( 0 ) ) )
+        if ( mFetchPrimaryKeyAttribute )
           feature.setAttribute( mSource->mPrimaryKeyAttrs.value( 0 ), fid );
         break;
 
@@ -396,18 +396,12 @@ bool QgsOracleFeatureIterator::fetchFeature( QgsFeature &feature )
     QgsDebugMsgLevel( QStringLiteral( "fid=%1" ).arg( fid ), 5 );
 
     // iterate attributes
-    const auto constMAttributeList = mAttributeList;
-    for ( int idx : constMAttributeList )
+    for ( const FetchedAttribute &attribute : qgis::as_const( mFetchedAttributes ) )
     {
-      if ( mSource->mPrimaryKeyAttrs.contains( idx ) )
-        continue;
-
-      QgsField fld = mSource->mFields.at( idx );
-
       QVariant v = mQry.value( col );
-      if ( fld.type() == QVariant::ByteArray && fld.typeName().endsWith( QStringLiteral( ".SDO_GEOMETRY" ) ) )
+      if ( attribute.isSdoGeometry )
       {
-        QByteArray ba( v.toByteArray() );
+        const QByteArray ba( v.toByteArray() );
         if ( ba.size() > 0 )
         {
           QgsGeometry g;
@@ -419,9 +413,9 @@ bool QgsOracleFeatureIterator::fetchFeature( QgsFeature &feature )
           v = QVariant( QVariant::String );
         }
       }
-      else if ( v.type() != fld.type() )
-        v = QgsVectorDataProvider::convertValue( fld.type(), v.toString() );
-      feature.setAttribute( idx, v );
+      else if ( v.type() != attribute.type )
+        v = QgsVectorDataProvider::convertValue( attribute.type, v.toString() );
+      feature.setAttribute( attribute.index, v );
 
       col++;
     }
@@ -497,13 +491,23 @@ bool QgsOracleFeatureIterator::openQuery( const QString &whereClause, const QVar
         return false;
     }
 
+    // the types of the fetched attributes are resolved once, not for each feature
+    mFetchPrimaryKeyAttribute = mSource->mPrimaryKeyType == PktInt && mAttributeList.contains( mSource->mPrimaryKeyAttrs.value( 0 ) );
+    mFetchedAttributes.clear();
     const auto constMAttributeList = mAttributeList;
     for ( int idx : constMAttributeList )
     {
       if ( mSource->mPrimaryKeyAttrs.contains( idx ) )
         continue;
 
-      query += delim + mConnection->fieldExpression( mSource->mFields.at( idx ) );
+      const QgsField &field = mSource->mFields.at( idx );
+      query += delim + mConnection->fieldExpression( field );
+
+      FetchedAttribute attribute;
+      attribute.index = idx;
+      attribute.type = field.type();
+      attribute.isSdoGeometry = field.type() == QVariant::ByteArray && field.typeName().endsWith( QStringLiteral( ".SDO_GEOMETRY" ) );
+      mFetchedAttributes << attribute;
     }
 
     query += QStringLiteral( " FROM %1 \"FEATUREREQUEST\"" ).arg( mSource->mQuery );
@@ -93,6 +93,19 @@ class QgsOracleFeatureIterator final: public QgsAbstractFeatureIteratorFromSourc
     bool mExpressionCompiled = false;
     bool mFetchGeometry = false;
     QgsAttributeList mAttributeList;
+
+    //! Attribute fetched after the geometry and the primary key, with what is needed to convert its values
+    struct FetchedAttribute
+    {
+      int index;
+      QVariant::Type type;
+      bool isSdoGeometry;
+    };
+    //! Attributes fetched after the geometry and the primary key, in the order of the query columns
+    QVector<FetchedAttribute> mFetchedAttributes;
+    //! Whether the integer primary key is also a requested attribute
+    bool mFetchPrimaryKeyAttribute = false;
+
     QString mSql;
     QVariantList mArgs;
 
@@ -16,6 +16,7 @@
  ***************************************************************************/
 
 #include "qgsfeature.h"
+#include "qgsfeedback.h"
 #include "qgsfields.h"
 #include "qgsgeometry.h"
 #include "qgscurve.h"
@@ -1142,6 +1143,63 @@ QSet<QVariant> QgsOracleProvider::uniqueValues( int index, int limit ) const
   return uniqueValues;
 }
 
+QStringList QgsOracleProvider::uniqueStringsMatching( int index, const QString &substring, int limit, QgsFeedback *feedback ) const
+{
+  QStringList results;
+
+  QgsOracleConn *conn = connectionRO();
+  if ( !conn )
+    return results;
+
+  try
+  {
+    // get the field name
+    QgsField fld = field( index );
+    QString sql = QString( "SELECT DISTINCT %1 FROM %2 WHERE" )
+                  .arg( quotedIdentifier( fld.name() ) )
+                  .arg( mQuery );
+
+    if ( !mSqlWhereClause.isEmpty() )
+    {
+      sql += QString( " (%1) AND" ).arg( mSqlWhereClause );
+    }
+
+    sql += QString( " upper(to_char(%1)) LIKE upper(?)" )
+           .arg( quotedIdentifier( fld.name() ) );
+
+    sql += QString( " ORDER BY %1" )
+           .arg( quotedIdentifier( fld.name() ) );
+
+    if ( limit >= 0 )
+    {
+      sql = QString( "SELECT * FROM (%1) WHERE rownum<=%2" ).arg( sql ).arg( limit );
+    }
+
+    QSqlQuery qry( *conn );
+
+    if ( !exec( qry, sql, QVariantList() << QStringLiteral( "%%1%" ).arg( substring ) ) )
+    {
+      QgsMessageLog::logMessage( tr( "Unable to execute the query.\nThe error message from the database was:\n%1.\nSQL: %2" )
+                                 .arg( qry.lastError().text() )
+                                 .arg( qry.lastQuery() ), tr( "Oracle" ) );
+      return QStringList();
+    }
+
+    while ( qry.next() )
+    {
+      results << qry.value( 0 ).toString();
+      if ( feedback && feedback->isCanceled() )
+        break;
+    }
+  }
+  catch ( OracleFieldNotFound )
+  {
+    return QStringList();
+  }
+
+  return results;
+}
+
 // Returns the maximum value of an attribute
 QVariant QgsOracleProvider::maximumValue( int index ) const
 {
@@ -42,8 +42,10 @@ inline void qgsConnectionPool_InvalidateConnection( QgsPostgresConn *c )
 
 inline bool qgsConnectionPool_ConnectionIsValid( QgsPostgresConn *c )
 {
-  Q_UNUSED( c )
-  return true;
+  // reading the pending input of the idle connection detects the connections
+  // closed by the server (restart, idle timeout) without a round trip
+  PQconsumeInput( c->pgConnection() );
+  return c->PQstatus() == CONNECTION_OK;
 }
 
 
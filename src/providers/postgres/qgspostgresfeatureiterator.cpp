@@ -23,8 +23,30 @@
 #include "qgssettings.h"
 #include "qgsexception.h"
 
-#include <QElapsedTimer>
 #include <QObject>
+#include <QtEndian>
+
+///@cond PRIVATE
+
+/**
+ * Returns TRUE if the values of \a field are fetched from the binary cursor
+ * in their native representation instead of being cast to text.
+ */
+static bool isBinaryNumericField( const QgsField &field )
+{
+  const QString &type = field.typeName();
+  switch ( field.type() )
+  {
+    case QVariant::Int:
+      return type == QLatin1String( "int2" ) || type == QLatin1String( "int4" );
+    case QVariant::Double:
+      return type == QLatin1String( "float8" );
+    default:
+      return false; // including arrays of numbers
+  }
+}
+
+///@endcond
 
 QgsPostgresFeatureIterator::QgsPostgresFeatureIterator( QgsPostgresFeatureSource *source, bool ownSource, const QgsFeatureRequest &request )
   : QgsAbstractFeatureIteratorFromSource<QgsPostgresFeatureSource>( source, ownSource, request )
@@ -255,77 +277,107 @@ bool QgsPostgresFeatureIterator::fetchFeature( QgsFeature &feature )
 
   if ( mFeatureQueue.empty() && !mLastFetch )
   {
-#if 0 //disabled dynamic queue size
-    QElapsedTimer timer;
-    timer.start();
-#endif
+    fetchNextBatch();
+  }
+
+  if ( mFeatureQueue.empty() )
+  {
+    QgsDebugMsg( QStringLiteral( "Finished after %1 features" ).arg( mFetched ) );
+    close();
 
-    QString fetch = QStringLiteral( "FETCH FORWARD %1 FROM %2" ).arg( mFeatureQueueSize ).arg( mCursorName );
-    QgsDebugMsgLevel( QStringLiteral( "fetching %1 features." ).arg( mFeatureQueueSize ), 4 );
+    mSource->mShared->ensureFeaturesCountedAtLeast( mFetched );
 
-    lock();
-    if ( mConn->PQsendQuery( fetch ) == 0 ) // fetch features asynchronously
-    {
-      QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
-    }
+    return false;
+  }
+
+  feature = mFeatureQueue.dequeue();
+  mFetched++;
+
+  feature.setValid( true );
+  feature.setFields( mSource->mFields ); // allow name-based attribute lookups
+  geometryToDestinationCrs( feature, mTransform );
+
+  return true;
+}
+
+bool QgsPostgresFeatureIterator::sendFetch()
+{
+  QString fetch = QStringLiteral( "FETCH FORWARD %1 FROM %2" ).arg( mFeatureQueueSize ).arg( mCursorName );
+  QgsDebugMsgLevel( QStringLiteral( "fetching %1 features." ).arg( mFeatureQueueSize ), 4 );
+
+  if ( mConn->PQsendQuery( fetch ) == 0 ) // fetch features asynchronously
+  {
+    QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
+    return false;
+  }
+
+  mFetchPending = true;
+  return true;
+}
 
-    QgsPostgresResult queryResult;
+void QgsPostgresFeatureIterator::fetchNextBatch()
+{
+  std::vector< std::unique_ptr< QgsPostgresResult > > results;
+  int rows = 0;
+
+  lock();
+  if ( mFetchPending || sendFetch() )
+  {
     for ( ;; )
     {
-      queryResult = mConn->PQgetResult();
-      if ( !queryResult.result() )
+      std::unique_ptr< QgsPostgresResult > queryResult = qgis::make_unique< QgsPostgresResult >( mConn->PQgetResult() );
+      if ( !queryResult->result() )
         break;
 
-      if ( queryResult.PQresultStatus() != PGRES_TUPLES_OK )
+      if ( queryResult->PQresultStatus() != PGRES_TUPLES_OK )
       {
         QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
-        break;
+        continue;
       }
 
-      int rows = queryResult.PQntuples();
-      if ( rows == 0 )
+      if ( queryResult->PQntuples() == 0 )
         continue;
 
-      mLastFetch = rows < mFeatureQueueSize;
-
-      for ( int row = 0; row < rows; row++ )
-      {
-        mFeatureQueue.enqueue( QgsFeature() );
-        getFeature( queryResult, row, mFeatureQueue.back() );
-      } // for each row in queue
-    }
-    unlock();
-
-#if 0 //disabled dynamic queue size
-    if ( timer.elapsed() > 500 && mFeatureQueueSize > 1 )
-    {
-      mFeatureQueueSize /= 2;
+      rows += queryResult->PQntuples();
+      results.push_back( std::move( queryResult ) );
     }
-    else if ( timer.elapsed() < 50 && mFeatureQueueSize < 10000 )
-    {
-      mFeatureQueueSize *= 2;
-    }
-#endif
+    mFetchPending = false;
   }
 
-  if ( mFeatureQueue.empty() )
-  {
-    QgsDebugMsg( QStringLiteral( "Finished after %1 features" ).arg( mFetched ) );
-    close();
+  mLastFetch = rows < mFeatureQueueSize;
 
-    mSource->mShared->ensureFeaturesCountedAtLeast( mFetched );
+  // let the server prepare the next rows while the current ones are decoded.
+  // Transaction connections are shared with other iterators, so nothing can be
+  // left pending on them.
+  if ( !mLastFetch && !mIsTransactionConnection )
+    sendFetch();
+  unlock();
 
-    return false;
+  for ( const std::unique_ptr< QgsPostgresResult > &queryResult : results )
+  {
+    const int resultRows = queryResult->PQntuples();
+    for ( int row = 0; row < resultRows; row++ )
+    {
+      mFeatureQueue.enqueue( QgsFeature() );
+      getFeature( *queryResult, row, mFeatureQueue.back() );
+    } // for each row in queue
   }
+}
 
-  feature = mFeatureQueue.dequeue();
-  mFetched++;
-
-  feature.setValid( true );
-  feature.setFields( mSource->mFields ); // allow name-based attribute lookups
-  geometryToDestinationCrs( feature, mTransform );
+void QgsPostgresFeatureIterator::discardPendingFetch()
+{
+  if ( !mFetchPending )
+    return;
 
-  return true;
+  lock();
+  for ( ;; )
+  {
+    QgsPostgresResult queryResult( mConn->PQgetResult() );
+    if ( !queryResult.result() )
+      break;
+  }
+  unlock();
+  mFetchPending = false;
 }
 
 bool QgsPostgresFeatureIterator::nextFeatureFilterExpression( QgsFeature &f )
@@ -386,6 +438,8 @@ bool QgsPostgresFeatureIterator::rewind()
   if ( mClosed )
     return false;
 
+  discardPendingFetch();
+
   // move cursor to first record
 
   mConn->PQexecNR( QStringLiteral( "move absolute 0 in %1" ).arg( mCursorName ) );
@@ -401,6 +455,7 @@ bool QgsPostgresFeatureIterator::close()
   if ( !mConn )
     return false;
 
+  discardPendingFetch();
   mConn->closeCursor( mCursorName );
 
   if ( !mIsTransactionConnection )
@@ -637,7 +692,8 @@ bool QgsPostgresFeatureIterator::declareCursor( const QString &whereClause, long
     if ( mSource->mPrimaryKeyAttrs.contains( idx ) )
       continue;
 
-    query += delim + mConn->fieldExpression( mSource->mFields.at( idx ) );
+    const QgsField &fld = mSource->mFields.at( idx );
+    query += delim + ( isBinaryNumericField( fld ) ? QgsPostgresConn::quotedIdentifier( fld.name() ) : mConn->fieldExpression( fld ) );
   }
 
   query += " FROM " + mSource->mQuery;
@@ -879,7 +935,42 @@ void QgsPostgresFeatureIterator::getFeatureAttribute( int idx, QgsPostgresResult
     }
     default:
     {
-      v = QgsPostgresProvider::convertValue( fld.type(), fld.subType(), queryResult.PQgetvalue( row, col ), fld.typeName() );
+      if ( isBinaryNumericField( fld ) )
+      {
+        // decoded from the binary cursor representation (network byte order)
+        if ( ::PQgetisnull( queryResult.result(), row, col ) )
+        {
+          v = QVariant( fld.type() );
+        }
+        else
+        {
+          const uchar *value = reinterpret_cast< const uchar * >( ::PQgetvalue( queryResult.result(), row, col ) );
+          switch ( ::PQgetlength( queryResult.result(), row, col ) )
+          {
+            case 2:
+              v = static_cast< int >( qFromBigEndian< qint16 >( value ) );
+              break;
+            case 4:
+              v = qFromBigEndian< qint32 >( value );
+              break;
+            case 8:
+            {
+              const quint64 bits = qFromBigEndian< quint64 >( value );
+              double d;
+              memcpy( &d, &bits, sizeof( d ) );
+              v = d;
+              break;
+            }
+            default:
+              v = QVariant( fld.type() );
+              break;
+          }
+        }
+      }
+      else
+      {
+        v = QgsPostgresProvider::convertValue( fld.type(), fld.subType(), queryResult.PQgetvalue( row, col ), fld.typeName() );
+      }
       break;
     }
   }
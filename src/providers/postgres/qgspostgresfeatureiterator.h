@@ -94,6 +94,18 @@ class QgsPostgresFeatureIterator final: public QgsAbstractFeatureIteratorFromSou
     void getFeatureAttribute( int idx, QgsPostgresResult &queryResult, int row, int &col, QgsFeature &feature );
     bool declareCursor( const QString &whereClause, long limit = -1, bool closeOnFail = true, const QString &orderBy = QString() );
 
+    //! Sends the FETCH of the next mFeatureQueueSize rows, without waiting for its result
+    bool sendFetch();
+
+    /**
+     * Fills the feature queue with the result of the pending FETCH (sending it
+     * first if needed) and requests the next rows before decoding the features.
+     */
+    void fetchNextBatch();
+
+    //! Drops the result of a FETCH sent ahead, before any other command is run on the connection
+    void discardPendingFetch();
+
     QString mCursorName;
 
     /**
@@ -123,6 +135,8 @@ class QgsPostgresFeatureIterator final: public QgsAbstractFeatureIteratorFromSou
     bool mExpressionCompiled = false;
     bool mOrderByCompiled = false;
     bool mLastFetch = false;
+    //! Sets to true when a FETCH was sent and its result was not read yet
+    bool mFetchPending = false;
     bool mFilterRequiresGeometry = false;
 
     QgsCoordinateTransform mTransform;
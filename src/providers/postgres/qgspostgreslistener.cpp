@@ -17,8 +17,11 @@
 
 #include "qgspostgreslistener.h"
 
+#include "qgis.h"
 #include "qgslogger.h"
 
+#include <QStringList>
+
 #ifdef Q_OS_WIN
 #include <winsock.h>
 #else
@@ -101,19 +104,26 @@ void QgsPostgresListener::run()
       break;
     }
 
+    // all the pending notifications are read at once, a burst of identical
+    // notifications (e.g. one per modified row) is emitted only once
     PQconsumeInput( conn );
-    PGnotify *n = PQnotifies( conn );
-    if ( n )
+    QStringList messages;
+    while ( PGnotify *n = PQnotifies( conn ) )
     {
       const QString msg( n->extra );
-      emit notify( msg );
-      QgsDebugMsg( "notify " + msg );
+      if ( !messages.contains( msg ) )
+        messages << msg;
       PQfreemem( n );
     }
-    else
+    if ( messages.isEmpty() )
     {
       QgsDebugMsg( QStringLiteral( "not a notify" ) );
     }
+    for ( const QString &msg : qgis::as_const( messages ) )
+    {
+      emit notify( msg );
+      QgsDebugMsg( "notify " + msg );
+    }
 
     if ( mStop )
     {
@@ -35,6 +35,7 @@
 #include "qgspostgresconnpool.h"
 #include "qgspostgresdataitems.h"
 #include "qgspostgresfeatureiterator.h"
+#include "qgspostgresexpressioncompiler.h"
 #include "qgspostgrestransaction.h"
 #include "qgspostgreslistener.h"
 #include "qgspostgresprojectstorage.h"
@@ -2073,6 +2074,101 @@ QVariant QgsPostgresProvider::maximumValue( int index ) const
   }
 }
 
+QVariant QgsPostgresProvider::aggregate( QgsAggregateCalculator::Aggregate aggregate, int index, const QgsAggregateCalculator::AggregateParameters &parameters,
+    QgsExpressionContext *context, bool &ok, QgsFeatureIds *fids ) const
+{
+  ok = false;
+
+  // the feature ids would have to be translated to primary key values
+  if ( fids || index < 0 || index >= mAttributeFields.count() )
+    return QVariant();
+
+  // only the numeric aggregates have the same semantics in SQL, the string ones differ on
+  // NULL and empty values and on collation
+  const QgsField fld = field( index );
+  if ( !fld.isNumeric() )
+    return QVariant();
+
+  const QString column = quotedIdentifier( fld.name() );
+  QString function;
+  switch ( aggregate )
+  {
+    case QgsAggregateCalculator::Count:
+      function = QStringLiteral( "count(%1)" ).arg( column );
+      break;
+    case QgsAggregateCalculator::CountDistinct:
+      function = QStringLiteral( "count(DISTINCT %1)" ).arg( column );
+      break;
+    case QgsAggregateCalculator::CountMissing:
+      function = QStringLiteral( "count(*)-count(%1)" ).arg( column );
+      break;
+    case QgsAggregateCalculator::Min:
+      function = QStringLiteral( "min(%1)" ).arg( column );
+      break;
+    case QgsAggregateCalculator::Max:
+      function = QStringLiteral( "max(%1)" ).arg( column );
+      break;
+    case QgsAggregateCalculator::Sum:
+      // the sum of no values is 0, as in QgsStatisticalSummary
+      function = QStringLiteral( "coalesce(sum(%1),0)" ).arg( column );
+      break;
+    case QgsAggregateCalculator::Mean:
+      function = QStringLiteral( "avg(%1)" ).arg( column );
+      break;
+    case QgsAggregateCalculator::StDev:
+      function = QStringLiteral( "stddev_pop(%1)" ).arg( column );
+      break;
+    case QgsAggregateCalculator::StDevSample:
+      function = QStringLiteral( "stddev_samp(%1)" ).arg( column );
+      break;
+    case QgsAggregateCalculator::Range:
+      function = QStringLiteral( "max(%1)-min(%1)" ).arg( column );
+      break;
+    case QgsAggregateCalculator::Median:
+      // ordered-set aggregates are available from PostgreSQL 9.4
+      if ( connectionRO()->pgVersion() < 90400 )
+        return QVariant();
+      function = QStringLiteral( "percentile_cont(0.5) WITHIN GROUP (ORDER BY %1)" ).arg( column );
+      break;
+
+    // the quartiles of QgsStatisticalSummary are not interpolated as percentile_cont() does
+    default:
+      return QVariant();
+  }
+
+  QString whereClause = mSqlWhereClause;
+  if ( !parameters.filter.isEmpty() )
+  {
+    if ( !QgsSettings().value( QStringLiteral( "qgis/compileExpressions" ), true ).toBool() )
+      return QVariant();
+
+    QgsExpression filter( parameters.filter );
+    if ( context )
+      filter.prepare( context );
+    QgsPostgresFeatureSource source( this );
+    QgsPostgresExpressionCompiler compiler( &source );
+    if ( compiler.compile( &filter ) != QgsSqlExpressionCompiler::Complete )
+      return QVariant();
+    whereClause = QgsPostgresUtils::andWhereClauses( whereClause, compiler.result() );
+  }
+
+  QString sql = QStringLiteral( "SELECT (%1)::float8 FROM %2" ).arg( function, mQuery );
+  if ( !whereClause.isEmpty() )
+    sql += QStringLiteral( " WHERE %1" ).arg( whereClause );
+
+  QgsPostgresResult result( connectionRO()->PQexec( sql ) );
+  if ( result.PQresultStatus() != PGRES_TUPLES_OK || result.PQntuples() != 1 )
+  {
+    QgsDebugMsg( QStringLiteral( "Could not calculate aggregate: %1" ).arg( result.PQresultErrorMessage() ) );
+    return QVariant();
+  }
+
+  ok = true;
+  if ( result.PQgetisnull( 0, 0 ) )
+    return QVariant();
+  return result.PQgetvalue( 0, 0 ).toDouble();
+}
+
 
 bool QgsPostgresProvider::isValid() const
 {
@@ -16,6 +16,9 @@
 
 #include <QDebug>
 #include <QObject>
+#include <QtConcurrent>
+
+#include <numeric>
 
 #include "cpl_string.h"
 #include "gdal.h"
@@ -27,6 +30,19 @@
 #include "qgspolygon.h"
 #include "qgslogger.h"
 
+//! Decodes the hex encoded WKB rasters in \a column of \a rows of \a result, in parallel
+static QVector<QVariantMap> parseHexWkbRows( PGresult *result, const QVector<int> &rows, int column )
+{
+  return QtConcurrent::blockingMapped< QVector<QVariantMap> >( rows, [result, column]( int row )
+  {
+    int dataRead;
+    GByte *binaryData { CPLHexToBinary( ::PQgetvalue( result, row, column ), &dataRead ) };
+    const QVariantMap parsedData { QgsPostgresRasterUtils::parseWkb( QByteArray::fromRawData( reinterpret_cast<char *>( binaryData ), dataRead ) ) };
+    CPLFree( binaryData );
+    return parsedData;
+  } );
+}
+
 QgsPostgresRasterSharedData::~QgsPostgresRasterSharedData()
 {
   for ( auto idx : mSpatialIndexes )
@@ -58,7 +74,9 @@ QgsPostgresRasterSharedData::TilesResponse QgsPostgresRasterSharedData::tiles( c
   // Fast track for first tile (where index is empty)
   if ( mLoadedIndexBounds[ cacheKey ].isNull() )
   {
-    return fetchTilesIndexAndData( requestedRect, request );
+    result = fetchTilesIndexAndData( requestedRect, request );
+    discardTilesData();
+    return result;
   }
   else if ( ! mLoadedIndexBounds[ cacheKey].contains( requestedRect ) )
   {
@@ -82,6 +100,7 @@ QgsPostgresRasterSharedData::TilesResponse QgsPostgresRasterSharedData::tiles( c
     }
     else
     {
+      touchTile( tilePtr );
       result.tiles.push_back( TileBand
       {
         tilePtr->tileId,
@@ -128,6 +147,10 @@ QgsPostgresRasterSharedData::TilesResponse QgsPostgresRasterSharedData::tiles( c
                                  .arg( sql ), QObject::tr( "PostGIS" ), Qgis::Critical );
     }
 
+    QVector<int> rows( dataResult.PQntuples() );
+    std::iota( rows.begin(), rows.end(), 0 );
+    const QVector<QVariantMap> parsedRows { parseHexWkbRows( dataResult.result(), rows, 1 ) };
+
     for ( int row = 0; row < dataResult.PQntuples(); ++row )
     {
       // Note: if we change tile id type we need to sync this
@@ -139,10 +162,7 @@ QgsPostgresRasterSharedData::TilesResponse QgsPostgresRasterSharedData::tiles( c
                                    .arg( sql ), QObject::tr( "PostGIS" ), Qgis::Critical );
       }
 
-      int dataRead;
-      GByte *binaryData { CPLHexToBinary( dataResult.PQgetvalue( row, 1 ).toLatin1().constData(), &dataRead ) };
-      Tile const *tilePtr { setTileData( cacheKey, tileId, QByteArray::fromRawData( reinterpret_cast<char *>( binaryData ), dataRead ) ) };
-      CPLFree( binaryData );
+      Tile const *tilePtr { setTileData( cacheKey, tileId, parsedRows.at( row ) ) };
 
       if ( ! tilePtr )
       {
@@ -175,21 +195,27 @@ QgsPostgresRasterSharedData::TilesResponse QgsPostgresRasterSharedData::tiles( c
     }
   }
 
+  discardTilesData();
   return result;
 }
 
 void QgsPostgresRasterSharedData::invalidateCache()
 {
   QMutexLocker locker( &mMutex );
+  for ( auto idx : mSpatialIndexes )
+  {
+    delete idx.second;
+  }
   mSpatialIndexes.clear();
   mTiles.clear();
   mLoadedIndexBounds.clear();
+  mUsedTiles.clear();
+  mCachedDataSize = 0;
 }
 
 
-QgsPostgresRasterSharedData::Tile const *QgsPostgresRasterSharedData::setTileData( const QString &cacheKey, TileIdType tileId, const QByteArray &data )
+QgsPostgresRasterSharedData::Tile const *QgsPostgresRasterSharedData::setTileData( const QString &cacheKey, TileIdType tileId, const QVariantMap &parsedData )
 {
-  Q_ASSERT( ! data.isEmpty() );
   if ( mTiles.find( cacheKey ) == mTiles.end() ||
        mTiles[ cacheKey ].find( tileId ) == mTiles[ cacheKey ].end() )
   {
@@ -197,12 +223,53 @@ QgsPostgresRasterSharedData::Tile const *QgsPostgresRasterSharedData::setTileDat
   }
 
   Tile *const tile { mTiles[ cacheKey ][ tileId ].get() };
-  const QVariantMap parsedData { QgsPostgresRasterUtils::parseWkb( data ) };
+  storeTileData( tile, parsedData );
+  return tile;
+}
+
+void QgsPostgresRasterSharedData::storeTileData( Tile *tile, const QVariantMap &parsedData )
+{
+  if ( ! tile->data.empty() )
+  {
+    mUsedTiles.erase( tile->usedTilesIterator );
+    mCachedDataSize -= tile->dataSize;
+  }
+
+  std::vector<QByteArray> data;
+  std::size_t dataSize = 0;
   for ( int bandCnt = 1; bandCnt <= tile->numBands; ++bandCnt )
   {
-    tile->data.emplace_back( parsedData[ QStringLiteral( "band%1" ).arg( bandCnt ) ].toByteArray() );
+    data.emplace_back( parsedData[ QStringLiteral( "band%1" ).arg( bandCnt ) ].toByteArray() );
+    dataSize += static_cast<std::size_t>( data.back().size() );
+  }
+  tile->data.swap( data );
+  tile->dataSize = dataSize;
+
+  if ( ! tile->data.empty() )
+  {
+    mUsedTiles.push_front( tile );
+    tile->usedTilesIterator = mUsedTiles.begin();
+    mCachedDataSize += dataSize;
+  }
+}
+
+void QgsPostgresRasterSharedData::touchTile( Tile *tile )
+{
+  mUsedTiles.splice( mUsedTiles.begin(), mUsedTiles, tile->usedTilesIterator );
+}
+
+void QgsPostgresRasterSharedData::discardTilesData()
+{
+  // the data of the tiles of the last response is shared with the response, it stays valid
+  while ( mCachedDataSize > MAX_CACHED_DATA_SIZE && ! mUsedTiles.empty() )
+  {
+    Tile *tile { mUsedTiles.back() };
+    mUsedTiles.pop_back();
+    mCachedDataSize -= tile->dataSize;
+    std::vector<QByteArray>().swap( tile->data );
+    tile->dataSize = 0;
+    QgsDebugMsgLevel( QStringLiteral( "Tile data discarded, ID: %1" ).arg( tile->tileId ), 3 );
   }
-  return tile;
 }
 
 QString QgsPostgresRasterSharedData::keyFromRequest( const QgsPostgresRasterSharedData::TilesRequest &request )
@@ -331,12 +398,23 @@ QgsPostgresRasterSharedData::TilesResponse QgsPostgresRasterSharedData::fetchTil
 
   const QString cacheKey { keyFromRequest( request ) };
 
+  // the data of the new tiles is decoded in parallel
+  QVector<int> newRows;
+  for ( int row = 0; row < dataResult.PQntuples(); ++row )
+  {
+    if ( mTiles[ cacheKey ].find( dataResult.PQgetvalue( row, 0 ) ) == mTiles[ cacheKey ].end() )
+      newRows.push_back( row );
+  }
+  const QVector<QVariantMap> parsedRows { parseHexWkbRows( dataResult.result(), newRows, 11 ) };
+
+  int newRowIndex = 0;
   for ( int row = 0; row < dataResult.PQntuples(); ++row )
   {
     // rid | upperleftx | upperlefty | width | height | scalex | scaley | skewx | skewy | srid | numbands | data
     const TileIdType tileId { dataResult.PQgetvalue( row, 0 ) };
 
-    if ( mTiles[ cacheKey ].find( tileId ) == mTiles[ cacheKey ].end() )
+    const int parsedRowIndex { ( newRowIndex < newRows.size() && newRows.at( newRowIndex ) == row ) ? newRowIndex++ : -1 };
+    if ( parsedRowIndex >= 0 && mTiles[ cacheKey ].find( tileId ) == mTiles[ cacheKey ].end() )
     {
       const double upperleftx { dataResult.PQgetvalue( row, 1 ).toDouble() };
       const double upperlefty { dataResult.PQgetvalue( row, 2 ).toDouble() };
@@ -373,14 +451,7 @@ QgsPostgresRasterSharedData::TilesResponse QgsPostgresRasterSharedData::fetchTil
             numbands
           );
 
-      int dataRead;
-      GByte *binaryData { CPLHexToBinary( dataResult.PQgetvalue( row, 11 ).toLatin1().constData(), &dataRead ) };
-      const QVariantMap parsedData { QgsPostgresRasterUtils::parseWkb( QByteArray::fromRawData( reinterpret_cast<char *>( binaryData ), dataRead ) ) };
-      CPLFree( binaryData );
-      for ( int bandCnt = 1; bandCnt <= tile->numBands; ++bandCnt )
-      {
-        tile->data.emplace_back( parsedData[ QStringLiteral( "band%1" ).arg( bandCnt ) ].toByteArray() );
-      }
+      storeTileData( tile.get(), parsedRows.at( parsedRowIndex ) );
       mSpatialIndexes[ cacheKey ]->insert( tile.get(), tile->extent );
 
       response.tiles.push_back( TileBand
@@ -18,6 +18,8 @@
 
 #include <QMutex>
 
+#include <list>
+
 #include "qgsrectangle.h"
 #include "qgsgenericspatialindex.h"
 #include "qgsgeometry.h"
@@ -102,6 +104,9 @@ class QgsPostgresRasterSharedData
 
   private:
 
+    //! Maximum size in bytes of the data of the cached tiles, the least recently used are discarded
+    static const std::size_t MAX_CACHED_DATA_SIZE = 128 * 1024 * 1024;
+
     //! Protect access to tiles
     QMutex mMutex;
 
@@ -145,6 +150,12 @@ class QgsPostgresRasterSharedData
 
         std::vector<QByteArray> data;
 
+        //! Size in bytes of data
+        std::size_t dataSize = 0;
+
+        //! Position in the list of the tiles with data, if data is not empty
+        std::list<Tile *>::iterator usedTilesIterator;
+
         friend class QgsPostgresRasterSharedData;
 
     };
@@ -153,7 +164,16 @@ class QgsPostgresRasterSharedData
     bool fetchTilesIndex( const QgsGeometry &requestPolygon, const TilesRequest &request );
     //! Fast track for first fetch
     TilesResponse fetchTilesIndexAndData( const QgsGeometry &requestPolygon, const TilesRequest &request );
-    Tile const *setTileData( const QString &cacheKey, TileIdType tileId, const QByteArray &data );
+    Tile const *setTileData( const QString &cacheKey, TileIdType tileId, const QVariantMap &parsedData );
+
+    //! Stores the bands of \a parsedData in \a tile
+    void storeTileData( Tile *tile, const QVariantMap &parsedData );
+
+    //! Marks \a tile, which has data, as the most recently used
+    void touchTile( Tile *tile );
+
+    //! Discards the data of the least recently used tiles, until the cache fits in MAX_CACHED_DATA_SIZE
+    void discardTilesData();
 
     /**
     * Tile caches, index is a key generated from the overview factor (1 is the full resolution data)
@@ -168,6 +188,12 @@ class QgsPostgresRasterSharedData
     //! Keeps track of loaded index bounds
     std::map<QString, QgsGeometry> mLoadedIndexBounds;
 
+    //! Tiles with data, the most recently used first
+    std::list<Tile *> mUsedTiles;
+
+    //! Size in bytes of the data of the tiles
+    std::size_t mCachedDataSize = 0;
+
 };
 
 #endif // QGSPOSTGRESRASTERSHAREDDATA_H
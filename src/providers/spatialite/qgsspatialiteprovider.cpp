@@ -4123,6 +4123,8 @@ bool QgsSpatiaLiteProvider::addFeatures( QgsFeatureList &flist, Flags flags )
   int ia, ret;
   // SQL for single row
   QString sql;
+  // SQL of the current prepared statement
+  QString preparedSql;
 
   if ( flist.isEmpty() )
     return true;
@@ -4188,8 +4190,21 @@ bool QgsSpatiaLiteProvider::addFeatures( QgsFeatureList &flist, Flags flags )
       sql += values;
       sql += ')';
 
-      // SQLite prepared statement
-      ret = sqlite3_prepare_v2( sqliteHandle( ), sql.toUtf8().constData(), -1, &stmt, nullptr );
+      // SQLite prepared statement, reused by the following features as long as they
+      // insert the same columns
+      if ( stmt && sql == preparedSql )
+      {
+        sqlite3_reset( stmt );
+        sqlite3_clear_bindings( stmt );
+        ret = SQLITE_OK;
+      }
+      else
+      {
+        sqlite3_finalize( stmt );
+        stmt = nullptr;
+        ret = sqlite3_prepare_v2( sqliteHandle( ), sql.toUtf8().constData(), -1, &stmt, nullptr );
+        preparedSql = ret == SQLITE_OK ? sql : QString();
+      }
       if ( ret == SQLITE_OK )
       {
 
@@ -4307,8 +4322,6 @@ bool QgsSpatiaLiteProvider::addFeatures( QgsFeatureList &flist, Flags flags )
         // performing actual row insert
         ret = sqlite3_step( stmt );
 
-        sqlite3_finalize( stmt );
-
         if ( ret == SQLITE_DONE || ret == SQLITE_ROW )
         {
           // update feature id
@@ -4329,6 +4342,8 @@ bool QgsSpatiaLiteProvider::addFeatures( QgsFeatureList &flist, Flags flags )
       }
     } // prepared statement
 
+    sqlite3_finalize( stmt );
+
     if ( ret == SQLITE_DONE || ret == SQLITE_ROW )
     {
       ret = exec_sql( QStringLiteral( "RELEASE SAVEPOINT \"%1\"" ).arg( savepointId ), errMsg );
@@ -16,6 +16,7 @@ email                : hugo dot mercier at oslandia dot com
  ***************************************************************************/
 
 #include "qgsvirtuallayerblob.h"
+#include "qgswkbgeometryview.h"
 #include <cstring>
 #include <limits>
 
@@ -61,16 +62,11 @@ void SpatialiteBlobHeader::writeTo( char *p ) const
   memcpy( p, &end, 1 );
 }
 
-//
-// Convert a QgsGeometry into a SpatiaLite geometry BLOB
-void qgsGeometryToSpatialiteBlob( const QgsGeometry &geom, int32_t srid, char *&blob, int &size )
+// Builds a SpatiaLite geometry BLOB from the WKB of a geometry without curves
+static void writeSpatialiteBlob( const QByteArray &wkb, const QgsRectangle &bbox, int32_t srid, char *&blob, int &size )
 {
   const int header_len = SpatialiteBlobHeader::LENGTH;
 
-  // we segment the geometry as spatialite doesn't support curves
-  std::unique_ptr < QgsAbstractGeometry > segmentized( geom.constGet()->segmentize() );
-  QByteArray wkb( segmentized->asWkb() );
-
   const int wkb_size = wkb.length();
   size = header_len + wkb_size;
   blob = new char[size];
@@ -79,7 +75,6 @@ void qgsGeometryToSpatialiteBlob( const QgsGeometry &geom, int32_t srid, char *&
 
   // write the header
   SpatialiteBlobHeader pHeader;
-  QgsRectangle bbox = const_cast<QgsGeometry &>( geom ).boundingBox(); // boundingBox should be const
   pHeader.srid = srid;
   pHeader.mbrMinX = bbox.xMinimum();
   pHeader.mbrMinY = bbox.yMinimum();
@@ -104,6 +99,34 @@ void qgsGeometryToSpatialiteBlob( const QgsGeometry &geom, int32_t srid, char *&
   *p = '\xFE';
 }
 
+//
+// Convert a QgsGeometry into a SpatiaLite geometry BLOB
+void qgsGeometryToSpatialiteBlob( const QgsGeometry &geom, int32_t srid, char *&blob, int &size )
+{
+  // we segment the geometry as spatialite doesn't support curves
+  std::unique_ptr < QgsAbstractGeometry > segmentized( geom.constGet()->segmentize() );
+  const QgsRectangle bbox = const_cast<QgsGeometry &>( geom ).boundingBox(); // boundingBox should be const
+  writeSpatialiteBlob( segmentized->asWkb(), bbox, srid, blob, size );
+}
+
+//
+// Convert a WKB buffer into a SpatiaLite geometry BLOB
+void qgsWkbToSpatialiteBlob( const QByteArray &wkb, int32_t srid, char *&blob, int &size )
+{
+  // linear geometries already exported by asWkb() can be copied as is,
+  // without building a QgsGeometry for them
+  const QgsWkbGeometryView view( wkb );
+  if ( view.isNativeIsoWkb() )
+  {
+    writeSpatialiteBlob( wkb, view.boundingBox(), srid, blob, size );
+    return;
+  }
+
+  QgsGeometry geom;
+  geom.fromWkb( wkb );
+  qgsGeometryToSpatialiteBlob( geom, srid, blob, size );
+}
+
 //
 // Return the bounding box of a SpatiaLite geometry blob
 QgsRectangle spatialiteBlobBbox( const char *blob, size_t size )
@@ -57,6 +57,13 @@ struct SpatialiteBlobHeader
  */
 void qgsGeometryToSpatialiteBlob( const QgsGeometry &geom, int32_t srid, char *&blob, int &size );
 
+/**
+ * Convert the WKB of a geometry into a SpatiaLite geometry BLOB
+ * The WKB is copied as is when it is already in the form SpatiaLite expects.
+ * The blob will be allocated and must be handled by the caller
+ */
+void qgsWkbToSpatialiteBlob( const QByteArray &wkb, int32_t srid, char *&blob, int &size );
+
 /**
  * Returns the bounding box of a SpatiaLite geometry blob
  */
@@ -36,8 +36,12 @@ email                : hugo dot mercier at oslandia dot com
 #include "qgsvirtuallayerblob.h"
 #include "qgsslottofunction.h"
 #include "qgsfeatureiterator.h"
+#include "qgsfeaturebatch.h"
 #include "qgsexpressioncontextutils.h"
 
+#include <algorithm>
+#include <memory>
+
 /**
  * Create metadata tables if needed
  */
@@ -259,16 +263,26 @@ struct VTableCursor
   VTable *mVtab = nullptr;
 
   // specific members
-  QgsFeature mCurrentFeature;
   QgsFeatureIterator mIterator;
+  // the features are read in batches, stored by columns
+  std::unique_ptr< QgsFeatureBatch > mBatch;
+  int mRow = 0;
   bool mEof;
 
+  // spatialite blob of the geometry of the current row, encoded once even if SQLite reads the column several times
+  std::unique_ptr< char[] > mBlob;
+  int mBlobSize = 0;
+  int mBlobRow = -1;
+
+  //! Number of features read at once from the iterator
+  static const int BATCH_SIZE = 1024;
+
   explicit VTableCursor( VTable *vtab )
     : mVtab( vtab )
     , mEof( true )
   {}
 
-  void filter( const QgsFeatureRequest &request )
+  void filter( const QgsFeatureRequest &request, const QgsAttributeList &attributes, bool withGeometry )
   {
     if ( !mVtab->valid() )
     {
@@ -277,17 +291,25 @@ struct VTableCursor
     }
 
     mIterator = mVtab->layer() ? mVtab->layer()->getFeatures( request ) : mVtab->provider()->getFeatures( request );
+    mBatch.reset( new QgsFeatureBatch( mVtab->fields(), attributes, withGeometry ) );
     // get on the first record
+    mRow = -1;
     mEof = false;
     next();
   }
 
   void next()
   {
-    if ( !mEof )
+    if ( mEof )
+      return;
+
+    ++mRow;
+    if ( mRow >= mBatch->size() )
     {
-      mEof = !mIterator.nextFeature( mCurrentFeature );
+      mRow = 0;
+      mEof = mIterator.nextBatch( *mBatch, BATCH_SIZE ) == 0;
     }
+    mBlobRow = -1;
   }
 
   bool eof() const { return mEof; }
@@ -296,23 +318,58 @@ struct VTableCursor
   {
     if ( !mVtab->valid() )
       return 0;
-    return mVtab->layer() ? mVtab->layer()->fields().count() : mVtab->provider()->fields().count();
+    return mVtab->fields().count();
   }
 
-  sqlite3_int64 currentId() const { return mCurrentFeature.id(); }
+  sqlite3_int64 currentId() const { return mBatch->featureIds().at( mRow ); }
 
-  QVariant currentAttribute( int column ) const { return mCurrentFeature.attribute( column ); }
+  void resultAttribute( sqlite3_context *ctxt, int attributeIndex ) const
+  {
+    const int column = mBatch->columnForAttribute( attributeIndex );
+    if ( column < 0 || mBatch->isNull( column, mRow ) )
+    {
+      sqlite3_result_null( ctxt );
+      return;
+    }
 
-  QPair<char *, int> currentGeometry() const
+    switch ( mBatch->columnType( column ) )
+    {
+      case QgsFeatureBatch::Int64:
+        sqlite3_result_int64( ctxt, mBatch->int64Values( column ).at( mRow ) );
+        break;
+      case QgsFeatureBatch::Double:
+        sqlite3_result_double( ctxt, mBatch->doubleValues( column ).at( mRow ) );
+        break;
+      case QgsFeatureBatch::String:
+      {
+        int length = 0;
+        const char *text = mBatch->utf8Value( column, mRow, length );
+        sqlite3_result_text( ctxt, text, length, SQLITE_TRANSIENT );
+        break;
+      }
+    }
+  }
+
+  void resultGeometry( sqlite3_context *ctxt )
   {
-    int blob_len = 0;
-    char *blob = nullptr;
-    QgsGeometry g = mCurrentFeature.geometry();
-    if ( ! g.isNull() )
+    if ( mBlobRow != mRow )
     {
-      qgsGeometryToSpatialiteBlob( g, mVtab->crs(), blob, blob_len );
+      mBlobRow = mRow;
+      mBlob.reset();
+      mBlobSize = 0;
+      const QByteArray wkb = mBatch->wkb( mRow );
+      if ( !wkb.isEmpty() )
+      {
+        char *blob = nullptr;
+        qgsWkbToSpatialiteBlob( wkb, mVtab->crs(), blob, mBlobSize );
+        mBlob.reset( blob );
+      }
     }
-    return qMakePair( blob, blob_len );
+
+    if ( !mBlob )
+      sqlite3_result_null( ctxt );
+    else
+      sqlite3_result_blob( ctxt, mBlob.get(), mBlobSize, SQLITE_TRANSIENT );
   }
 };
 
@@ -474,100 +531,216 @@ int vtableRename( sqlite3_vtab *vtab, const char *newName )
   return SQLITE_OK;
 }
 
+// Returns the QGIS expression operator matching a SQLite constraint operator, or an empty string
+static QString constraintOperator( unsigned char op )
+{
+  switch ( op )
+  {
+    case SQLITE_INDEX_CONSTRAINT_EQ:
+      return QStringLiteral( " = " );
+    case SQLITE_INDEX_CONSTRAINT_GT:
+      return QStringLiteral( " > " );
+    case SQLITE_INDEX_CONSTRAINT_LE:
+      return QStringLiteral( " <= " );
+    case SQLITE_INDEX_CONSTRAINT_LT:
+      return QStringLiteral( " < " );
+    case SQLITE_INDEX_CONSTRAINT_GE:
+      return QStringLiteral( " >= " );
+#ifdef SQLITE_INDEX_CONSTRAINT_LIKE
+    case SQLITE_INDEX_CONSTRAINT_LIKE:
+      // SQLite LIKE is case insensitive
+      return QStringLiteral( " ILIKE " );
+#endif
+    default:
+      break;
+  }
+  return QString();
+}
+
+// Returns TRUE if SQLite and QGIS order the values of the field in the same way
+static bool isOrderPreserved( const QgsField &field )
+{
+  switch ( field.type() )
+  {
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+    case QVariant::Double:
+      return true;
+    default:
+      // text collations differ between SQLite and the providers
+      return false;
+  }
+}
+
+//
+// The plan chosen by xBestIndex is passed to xFilter in idxStr, one step per line:
+//
+// A <indexes>     attributes read by the query, comma separated
+// G <0|1>         whether the geometry is read by the query
+// F               feature id equal to the next argument
+// FI              feature id in the list of the next argument
+// R               bounding box of the next argument (rtree filter)
+// E <prefix>      expression comparing a field to the next argument
+// EI <column>     field in the list of the next argument
+// L, O            limit and offset of the next argument
+// S <index> <0|1> order by a field, ascending or descending
+//
 int vtableBestIndex( sqlite3_vtab *pvtab, sqlite3_index_info *indexInfo )
 {
   VTable *vtab = reinterpret_cast< VTable * >( pvtab );
-  for ( int i = 0; i < indexInfo->nConstraint; i++ )
+  const QgsFields fields = vtab->fields();
+  const int geometryColumn = fields.count();
+  const int searchFrameColumn = fields.count() + 1;
+
+  QStringList plan;
+  int argvIndex = 0;
+  // whether SQLite has no other constraint to check, so that a limit can be pushed down
+  bool allConsumed = true;
+  bool fidFilter = false;
+  bool rectFilter = false;
+  int expressionFilters = 0;
+  QList<int> limitConstraints;
+
+  // a filter on the primary key is preferred to any other filter
+  for ( int i = 0; i < indexInfo->nConstraint && !fidFilter; i++ )
   {
-    // request for primary key filter with '='
     if ( ( indexInfo->aConstraint[i].usable ) &&
          ( vtab->pkColumn() == indexInfo->aConstraint[i].iColumn ) &&
          ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_EQ ) )
     {
-      indexInfo->aConstraintUsage[i].argvIndex = 1;
+      bool in = false;
+#if SQLITE_VERSION_NUMBER >= 3038000
+      in = sqlite3_vtab_in( indexInfo, i, 1 );
+#endif
+      plan << ( in ? QStringLiteral( "FI" ) : QStringLiteral( "F" ) );
+      indexInfo->aConstraintUsage[i].argvIndex = ++argvIndex;
       indexInfo->aConstraintUsage[i].omit = 1;
-      indexInfo->idxNum = 1; // PK filter
-      indexInfo->estimatedCost = 1.0;
-      indexInfo->idxStr = nullptr;
-      indexInfo->needToFreeIdxStr = 0;
-      return SQLITE_OK;
+      fidFilter = true;
     }
+  }
 
-    // request for filter with a comparison operator
-    if ( ( indexInfo->aConstraint[i].usable ) &&
-         ( indexInfo->aConstraint[i].iColumn >= 0 ) &&
-         ( indexInfo->aConstraint[i].iColumn < vtab->fields().count() ) &&
-         ( ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_EQ ) || // if no PK
-           ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_GT ) ||
-           ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_LE ) ||
-           ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_LT ) ||
-           ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_GE )
-#ifdef SQLITE_INDEX_CONSTRAINT_LIKE
-           || ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_LIKE )
-#endif
-         ) )
-    {
-      indexInfo->aConstraintUsage[i].argvIndex = 1;
-      indexInfo->aConstraintUsage[i].omit = 1;
-      indexInfo->idxNum = 3; // expression filter
-      indexInfo->estimatedCost = 2.0; // probably better than no index
+  for ( int i = 0; i < indexInfo->nConstraint; i++ )
+  {
+    const auto &constraint = indexInfo->aConstraint[i];
+    if ( indexInfo->aConstraintUsage[i].argvIndex > 0 )
+      continue;
 
-      QString expr = QgsExpression::quotedColumnRef( vtab->fields().at( indexInfo->aConstraint[i].iColumn ).name() );
-      switch ( indexInfo->aConstraint[i].op )
-      {
-        case SQLITE_INDEX_CONSTRAINT_EQ:
-          expr += QLatin1String( " = " );
-          break;
-        case SQLITE_INDEX_CONSTRAINT_GT:
-          expr += QLatin1String( " > " );
-          break;
-        case SQLITE_INDEX_CONSTRAINT_LE:
-          expr += QLatin1String( " <= " );
-          break;
-        case SQLITE_INDEX_CONSTRAINT_LT:
-          expr += QLatin1String( " < " );
-          break;
-        case SQLITE_INDEX_CONSTRAINT_GE:
-          expr += QLatin1String( " >= " );
-          break;
-#ifdef SQLITE_INDEX_CONSTRAINT_LIKE
-        case SQLITE_INDEX_CONSTRAINT_LIKE:
-          expr += QLatin1String( " LIKE " );
-          break;
+#ifdef SQLITE_INDEX_CONSTRAINT_LIMIT
+    if ( constraint.op == SQLITE_INDEX_CONSTRAINT_LIMIT || constraint.op == SQLITE_INDEX_CONSTRAINT_OFFSET )
+    {
+      if ( constraint.usable )
+        limitConstraints << i;
+      continue;
+    }
 #endif
-        default:
-          break;
-      }
 
-      QByteArray ba = expr.toUtf8();
-      char *cp = ( char * )sqlite3_malloc( ba.size() + 1 );
-      memcpy( cp, ba.constData(), ba.size() + 1 );
+    if ( !constraint.usable )
+    {
+      allConsumed = false;
+      continue;
+    }
 
-      indexInfo->idxStr = cp;
-      indexInfo->needToFreeIdxStr = 1;
-      return SQLITE_OK;
+    // request for filter with a comparison operator, combined with AND
+    // (the feature request can not filter by feature id and by expression at once)
+    const QString op = constraintOperator( constraint.op );
+    if ( !fidFilter &&
+         ( constraint.iColumn >= 0 ) &&
+         ( constraint.iColumn < fields.count() ) &&
+         !op.isEmpty() )
+    {
+      const QString column = QgsExpression::quotedColumnRef( fields.at( constraint.iColumn ).name() );
+      bool in = false;
+#if SQLITE_VERSION_NUMBER >= 3038000
+      in = constraint.op == SQLITE_INDEX_CONSTRAINT_EQ && sqlite3_vtab_in( indexInfo, i, 1 );
+#endif
+      plan << ( in ? QStringLiteral( "EI %1" ).arg( column ) : QStringLiteral( "E %1%2" ).arg( column, op ) );
+      indexInfo->aConstraintUsage[i].argvIndex = ++argvIndex;
+      indexInfo->aConstraintUsage[i].omit = 1;
+      expressionFilters++;
+      continue;
     }
 
-    // request for rtree filtering
-    if ( ( indexInfo->aConstraint[i].usable ) &&
-         // request on _search_frame_ column
-         ( vtab->fields().count() + 1 == indexInfo->aConstraint[i].iColumn ) &&
-         ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_EQ ) )
+    // request for rtree filtering, on the _search_frame_ column
+    if ( !rectFilter &&
+         ( searchFrameColumn == constraint.iColumn ) &&
+         ( constraint.op == SQLITE_INDEX_CONSTRAINT_EQ ) )
     {
-      indexInfo->aConstraintUsage[i].argvIndex = 1;
+      plan << QStringLiteral( "R" );
+      indexInfo->aConstraintUsage[i].argvIndex = ++argvIndex;
       // do not test for equality, since it is used for filtering, not to return an actual value
       indexInfo->aConstraintUsage[i].omit = 1;
-      indexInfo->idxNum = 2; // RTree filter
-      indexInfo->estimatedCost = 1.0;
-      indexInfo->idxStr = nullptr;
-      indexInfo->needToFreeIdxStr = 0;
-      return SQLITE_OK;
+      rectFilter = true;
+      continue;
+    }
+
+    allConsumed = false;
+  }
+
+  // order by numeric fields, SQLite sorts the NULL values first
+  bool orderByConsumed = false;
+  if ( indexInfo->nOrderBy > 0 )
+  {
+    QStringList orderBy;
+    for ( int i = 0; i < indexInfo->nOrderBy; i++ )
+    {
+      const int column = indexInfo->aOrderBy[i].iColumn;
+      if ( column < 0 || column >= fields.count() || !isOrderPreserved( fields.at( column ) ) )
+      {
+        orderBy.clear();
+        break;
+      }
+      orderBy << QStringLiteral( "S %1 %2" ).arg( column ).arg( indexInfo->aOrderBy[i].desc ? 1 : 0 );
+    }
+    if ( !orderBy.isEmpty() )
+    {
+      plan << orderBy;
+      orderByConsumed = true;
+      indexInfo->orderByConsumed = 1;
     }
   }
+
+  // the limit is only a hint for the feature request: SQLite still applies it, and the offset
+  if ( allConsumed && ( indexInfo->nOrderBy == 0 || orderByConsumed ) )
+  {
+#ifdef SQLITE_INDEX_CONSTRAINT_LIMIT
+    for ( int i : qgis::as_const( limitConstraints ) )
+    {
+      plan << ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_LIMIT ? QStringLiteral( "L" ) : QStringLiteral( "O" ) );
+      indexInfo->aConstraintUsage[i].argvIndex = ++argvIndex;
+      indexInfo->aConstraintUsage[i].omit = 0;
+    }
+#endif
+  }
+
+  // only read the columns used by the query
+#if SQLITE_VERSION_NUMBER >= 3010000
+  const sqlite3_uint64 colUsed = indexInfo->colUsed;
+  QStringList attributes;
+  for ( int i = 0; i < fields.count(); i++ )
+  {
+    // the last bit stands for all the columns after the 63rd
+    if ( colUsed & ( static_cast< sqlite3_uint64 >( 1 ) << std::min( i, 63 ) ) )
+      attributes << QString::number( i );
+  }
+  plan << QStringLiteral( "A %1" ).arg( attributes.join( ',' ) );
+  plan << QStringLiteral( "G %1" ).arg( ( colUsed & ( static_cast< sqlite3_uint64 >( 1 ) << std::min( geometryColumn, 63 ) ) ) ? 1 : 0 );
+#endif
+
+  if ( fidFilter )
+    indexInfo->estimatedCost = 1.0;
+  else if ( rectFilter || expressionFilters > 0 )
+    indexInfo->estimatedCost = ( rectFilter ? 1.0 : 2.0 ) - 0.1 * std::min( expressionFilters, 5 );
+  else
+    indexInfo->estimatedCost = 10.0;
+
   indexInfo->idxNum = 0;
-  indexInfo->estimatedCost = 10.0;
-  indexInfo->idxStr = nullptr;
-  indexInfo->needToFreeIdxStr = 0;
+  const QByteArray ba = plan.join( '\n' ).toUtf8();
+  char *cp = ( char * )sqlite3_malloc( ba.size() + 1 );
+  memcpy( cp, ba.constData(), ba.size() + 1 );
+  indexInfo->idxStr = cp;
+  indexInfo->needToFreeIdxStr = 1;
   return SQLITE_OK;
 }
 
@@ -587,58 +760,178 @@ int vtableClose( sqlite3_vtab_cursor *cursor )
   return SQLITE_OK;
 }
 
+// Returns a QGIS expression literal for a SQLite value, an empty string for NULL and blobs
+static QString expressionLiteral( sqlite3_value *value )
+{
+  switch ( sqlite3_value_type( value ) )
+  {
+    case SQLITE_INTEGER:
+      return QString::number( sqlite3_value_int64( value ) );
+    case SQLITE_FLOAT:
+      return QString::number( sqlite3_value_double( value ), 'g', 17 );
+    case SQLITE_TEXT:
+    {
+      int n = sqlite3_value_bytes( value );
+      const char *t = reinterpret_cast<const char *>( sqlite3_value_text( value ) );
+      return QgsExpression::quotedString( QString::fromUtf8( t, n ) );
+    }
+    case SQLITE_NULL:
+    case SQLITE_BLOB: // comparison to blob ignored
+    default:
+      break;
+  }
+  return QString();
+}
+
+// Returns the values of the list of an IN constraint
+static QList<sqlite3_value *> inValues( sqlite3_value *list )
+{
+  QList<sqlite3_value *> values;
+#if SQLITE_VERSION_NUMBER >= 3038000
+  sqlite3_value *value = nullptr;
+  for ( int rc = sqlite3_vtab_in_first( list, &value ); rc == SQLITE_OK && value; rc = sqlite3_vtab_in_next( list, &value ) )
+    values << value;
+#else
+  values << list;
+#endif
+  return values;
+}
+
 int vtableFilter( sqlite3_vtab_cursor *cursor, int idxNum, const char *idxStr, int argc, sqlite3_value **argv )
 {
-  Q_UNUSED( argc )
+  Q_UNUSED( idxNum )
+
+  VTableCursor *c = reinterpret_cast<VTableCursor *>( cursor );
+  const QgsFields fields = c->mVtab->fields();
 
   QgsFeatureRequest request;
-  if ( idxNum == 1 )
-  {
-    // id filter
-    request.setFilterFid( sqlite3_value_int( argv[0] ) );
-  }
-  else if ( idxNum == 2 )
+  QStringList expressions;
+  QgsFeatureRequest::OrderBy orderBy;
+  QgsAttributeList attributes = fields.allAttributesList();
+  bool withGeometry = true;
+  qint64 limit = -1;
+  qint64 offset = 0;
+  bool emptyResult = false;
+  int arg = 0;
+
+  const QStringList plan = QString::fromUtf8( idxStr ? idxStr : "" ).split( '\n', QString::SkipEmptyParts );
+  for ( const QString &step : plan )
   {
-    // rtree filter
-    const char *blob = reinterpret_cast< const char * >( sqlite3_value_blob( argv[0] ) );
-    if ( blob )
+    const QString kind = step.section( ' ', 0, 0 );
+    const QString parameter = step.section( ' ', 1 );
+    if ( kind == QLatin1String( "A" ) )
     {
-      int bytes = sqlite3_value_bytes( argv[0] );
-      QgsRectangle r( spatialiteBlobBbox( blob, bytes ) );
-      request.setFilterRect( r );
+      attributes.clear();
+      const QStringList indexes = parameter.split( ',', QString::SkipEmptyParts );
+      for ( const QString &index : indexes )
+        attributes << index.toInt();
+      continue;
     }
-  }
-  else if ( idxNum == 3 )
-  {
-    // comparison operator filter
-    // build an expression filter and rely on expression compiler if available
-    QString expr = idxStr;
-    switch ( sqlite3_value_type( argv[0] ) )
+    if ( kind == QLatin1String( "G" ) )
     {
-      case SQLITE_INTEGER:
-        expr += QString::number( sqlite3_value_int64( argv[0] ) );
-        break;
-      case SQLITE_FLOAT:
-        expr += QString::number( sqlite3_value_double( argv[0] ) );
-        break;
-      case SQLITE_TEXT:
+      withGeometry = parameter == QLatin1String( "1" );
+      continue;
+    }
+    if ( kind == QLatin1String( "S" ) )
+    {
+      const int index = parameter.section( ' ', 0, 0 ).toInt();
+      const bool descending = parameter.section( ' ', 1, 1 ) == QLatin1String( "1" );
+      orderBy << QgsFeatureRequest::OrderByClause( QgsExpression::quotedColumnRef( fields.at( index ).name() ), !descending, !descending );
+      continue;
+    }
+
+    if ( arg >= argc )
+      break;
+    sqlite3_value *value = argv[arg++];
+
+    if ( kind == QLatin1String( "F" ) )
+    {
+      // id filter
+      request.setFilterFid( sqlite3_value_int64( value ) );
+    }
+    else if ( kind == QLatin1String( "FI" ) )
+    {
+      QgsFeatureIds fids;
+      const QList<sqlite3_value *> values = inValues( value );
+      for ( sqlite3_value *v : values )
       {
-        int n = sqlite3_value_bytes( argv[0] );
-        const char *t = reinterpret_cast<const char *>( sqlite3_value_text( argv[0] ) );
-        QString str = QString::fromUtf8( t, n );
-        expr += QgsExpression::quotedString( str );
-        break;
+        if ( sqlite3_value_type( v ) != SQLITE_NULL )
+          fids << sqlite3_value_int64( v );
       }
-      case SQLITE_NULL:
-      case SQLITE_BLOB: // comparison to blob ignored
-      default:
-        expr += QLatin1String( " is null" );
-        break;
+      request.setFilterFids( fids );
+      emptyResult = fids.isEmpty();
+    }
+    else if ( kind == QLatin1String( "R" ) )
+    {
+      // rtree filter
+      const char *blob = reinterpret_cast< const char * >( sqlite3_value_blob( value ) );
+      if ( blob )
+      {
+        int bytes = sqlite3_value_bytes( value );
+        QgsRectangle r( spatialiteBlobBbox( blob, bytes ) );
+        request.setFilterRect( r );
+      }
+    }
+    else if ( kind == QLatin1String( "E" ) )
+    {
+      // comparison operator filter
+      // build an expression filter and rely on expression compiler if available
+      if ( sqlite3_value_type( value ) == SQLITE_NULL )
+      {
+        // a comparison to NULL is never true
+        emptyResult = true;
+        continue;
+      }
+      const QString literal = expressionLiteral( value );
+      if ( !literal.isEmpty() )
+        expressions << parameter + literal;
+    }
+    else if ( kind == QLatin1String( "EI" ) )
+    {
+      QStringList literals;
+      const QList<sqlite3_value *> values = inValues( value );
+      for ( sqlite3_value *v : values )
+      {
+        const QString literal = expressionLiteral( v );
+        if ( !literal.isEmpty() )
+          literals << literal;
+      }
+      if ( literals.isEmpty() )
+        emptyResult = true;
+      else
+        expressions << QStringLiteral( "%1 IN (%2)" ).arg( parameter, literals.join( QStringLiteral( ", " ) ) );
+    }
+    else if ( kind == QLatin1String( "L" ) )
+    {
+      limit = sqlite3_value_int64( value );
+    }
+    else if ( kind == QLatin1String( "O" ) )
+    {
+      offset = std::max< qint64 >( 0, sqlite3_value_int64( value ) );
     }
-    request.setFilterExpression( expr );
   }
-  VTableCursor *c = reinterpret_cast<VTableCursor *>( cursor );
-  c->filter( request );
+
+  if ( !expressions.isEmpty() )
+    request.setFilterExpression( expressions.join( QStringLiteral( " AND " ) ) );
+  if ( !orderBy.isEmpty() )
+    request.setOrderBy( orderBy );
+  if ( limit >= 0 )
+    request.setLimit( static_cast< long >( limit + offset ) );
+  if ( emptyResult )
+    request.setLimit( 0 );
+
+  // the rtree filter needs the geometries
+  if ( !withGeometry && request.filterRect().isNull() )
+    request.setFlags( request.flags() | QgsFeatureRequest::NoGeometry );
+  if ( attributes.count() < fields.count() )
+  {
+    request.setSubsetOfAttributes( attributes );
+    // an invalid index keeps the batch from storing all the attributes when none is read
+    if ( attributes.isEmpty() )
+      attributes << -1;
+  }
+
+  c->filter( request, attributes, withGeometry );
   return SQLITE_OK;
 }
 
@@ -670,11 +963,7 @@ int vtableColumn( sqlite3_vtab_cursor *cursor, sqlite3_context *ctxt, int idx )
   // geometry column
   if ( idx == c->nColumns() )
   {
-    QPair<char *, int> g = c->currentGeometry();
-    if ( !g.first )
-      sqlite3_result_null( ctxt );
-    else
-      sqlite3_result_blob( ctxt, g.first, g.second, deleteGeometryBlob );
+    c->resultGeometry( ctxt );
     return SQLITE_OK;
   }
 
@@ -685,32 +974,7 @@ int vtableColumn( sqlite3_vtab_cursor *cursor, sqlite3_context *ctxt, int idx )
     return SQLITE_OK;
   }
 
-  QVariant v = c->currentAttribute( idx );
-  if ( v.isNull() )
-  {
-    sqlite3_result_null( ctxt );
-  }
-  else
-  {
-    switch ( v.type() )
-    {
-      case QVariant::Int:
-      case QVariant::UInt:
-        sqlite3_result_int( ctxt, v.toInt() );
-        break;
-      case QVariant::LongLong:
-        sqlite3_result_int64( ctxt, v.toLongLong() );
-        break;
-      case QVariant::Double:
-        sqlite3_result_double( ctxt, v.toDouble() );
-        break;
-      default:
-      {
-        sqlite3_result_text( ctxt, v.toString().toUtf8(), -1, SQLITE_TRANSIENT );
-      }
-      break;
-    }
-  }
+  c->resultAttribute( ctxt, idx );
   return SQLITE_OK;
 }
 
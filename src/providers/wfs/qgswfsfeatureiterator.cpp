@@ -79,6 +79,40 @@ QString QgsWFSFeatureHitsAsyncRequest::errorMessageWithReason( const QString &re
 
 // -------------------------
 
+QgsWFSFeaturePageRequest::QgsWFSFeaturePageRequest( QgsWFSDataSourceURI &uri, qint64 startIndex )
+  : QgsWfsRequest( uri )
+  , mStartIndex( startIndex )
+{
+  // errors are reported when the page is requested again by the downloader
+  setLogErrors( false );
+  connect( this, &QgsWfsRequest::downloadFinished, this, &QgsWFSFeaturePageRequest::pageReplyFinished );
+}
+
+void QgsWFSFeaturePageRequest::launch( const QUrl &url )
+{
+  mFinished = false;
+  if ( !sendGET( url,
+                 QString(), // content-type
+                 false, /* synchronous */
+                 true, /* forceRefresh */
+                 false /* cache */ ) )
+  {
+    mFinished = true;
+  }
+}
+
+void QgsWFSFeaturePageRequest::pageReplyFinished()
+{
+  mFinished = true;
+}
+
+QString QgsWFSFeaturePageRequest::errorMessageWithReason( const QString &reason )
+{
+  return tr( "Download of features failed: %1" ).arg( reason );
+}
+
+// -------------------------
+
 QgsWFSFeatureDownloaderImpl::QgsWFSFeatureDownloaderImpl( QgsWFSSharedData *shared, QgsFeatureDownloader *downloader ):
   QgsWfsRequest( shared->mURI ),
   QgsFeatureDownloaderImpl( shared, downloader ),
@@ -342,6 +376,29 @@ void QgsWFSFeatureDownloaderImpl::createProgressDialog()
   CONNECT_PROGRESS_DIALOG( QgsWFSFeatureDownloaderImpl );
 }
 
+void QgsWFSFeatureDownloaderImpl::prefetchPages( int maxConcurrentRequests, qint64 maxTotalFeatures )
+{
+  const int pageSize = mShared->mPageSize;
+  qint64 startIndex = mPrefetchedPages.empty() ? mTotalDownloadedFeatureCount : mPrefetchedPages.back()->startIndex() + pageSize;
+  while ( static_cast< int >( mPrefetchedPages.size() ) < maxConcurrentRequests )
+  {
+    if ( maxTotalFeatures > 0 && startIndex >= maxTotalFeatures )
+      break;
+    // No need to ask for pages past the end of the result set
+    if ( mNumberMatched > 0 && startIndex >= mNumberMatched )
+      break;
+
+    int maxFeaturesThisRequest = pageSize;
+    if ( maxTotalFeatures > 0 )
+      maxFeaturesThisRequest = static_cast<int>( std::min( static_cast<qint64>( pageSize ), maxTotalFeatures - startIndex ) );
+
+    std::unique_ptr< QgsWFSFeaturePageRequest > page = qgis::make_unique< QgsWFSFeaturePageRequest >( mShared->mURI, startIndex );
+    page->launch( buildURL( startIndex, maxFeaturesThisRequest, false ) );
+    mPrefetchedPages.push_back( std::move( page ) );
+    startIndex += pageSize;
+  }
+}
+
 void QgsWFSFeatureDownloaderImpl::run( bool serializeFeatures, int maxFeatures )
 {
   bool success = true;
@@ -370,6 +427,9 @@ void QgsWFSFeatureDownloaderImpl::run( bool serializeFeatures, int maxFeatures )
   bool truncatedResponse = false;
   QgsSettings s;
   const int maxRetry = s.value( QStringLiteral( "qgis/defaultTileMaxRetry" ), "3" ).toInt();
+  // Once paging is known to work, pages are independent and the next ones
+  // can be downloaded while the current one is processed
+  const int maxConcurrentPageRequests = s.value( QStringLiteral( "qgis/wfsMaxConcurrentPageRequests" ), "4" ).toInt();
   int retryIter = 0;
   int lastValidTotalDownloadedFeatureCount = 0;
   int pagingIter = 1;
@@ -423,18 +483,52 @@ void QgsWFSFeatureDownloaderImpl::run( bool serializeFeatures, int maxFeatures )
       url.setQuery( query );
     }
 
-    sendGET( url,
-             QString(), // content-type
-             false, /* synchronous */
-             true, /* forceRefresh */
-             false /* cache */ );
+    // Use the page downloaded in advance when there is one. Otherwise, or if
+    // its download failed, issue the request ourselves, so that the usual
+    // retry logic applies
+    std::unique_ptr< QgsWFSFeaturePageRequest > prefetchedPage;
+    if ( retryIter == 0 && !mPrefetchedPages.empty() &&
+         mPrefetchedPages.front()->startIndex() == mTotalDownloadedFeatureCount )
+    {
+      prefetchedPage = std::move( mPrefetchedPages.front() );
+      mPrefetchedPages.pop_front();
+      connect( prefetchedPage.get(), &QgsWfsRequest::downloadFinished, &loop, &QEventLoop::quit );
+      while ( !prefetchedPage->isFinished() && !mStop )
+      {
+        loop.exec( QEventLoop::ExcludeUserInputEvents );
+      }
+      if ( prefetchedPage->errorCode() != NoError )
+      {
+        prefetchedPage.reset();
+        mPrefetchedPages.clear();
+      }
+    }
+    else
+    {
+      mPrefetchedPages.clear();
+    }
+
+    if ( prefetchedPage )
+    {
+      mErrorCode = NoError;
+      mErrorMessage.clear();
+      mResponse = prefetchedPage->response();
+    }
+    else
+    {
+      sendGET( url,
+               QString(), // content-type
+               false, /* synchronous */
+               true, /* forceRefresh */
+               false /* cache */ );
+    }
 
     int featureCountForThisResponse = 0;
     bool bytesStillAvailableInReply = false;
     // Loop until there is no data coming from the current request
     while ( true )
     {
-      if ( !bytesStillAvailableInReply )
+      if ( !bytesStillAvailableInReply && !prefetchedPage )
       {
         loop.exec( QEventLoop::ExcludeUserInputEvents );
       }
@@ -703,6 +797,7 @@ void QgsWFSFeatureDownloaderImpl::run( bool serializeFeatures, int maxFeatures )
       break;
     if ( !success )
     {
+      mPrefetchedPages.clear();
       if ( ++retryIter <= maxRetry )
       {
         QgsMessageLog::logMessage( tr( "Retrying request %1: %2/%3" ).arg( url.toString() ).arg( retryIter ).arg( maxRetry ), tr( "WFS" ) );
@@ -735,7 +830,12 @@ void QgsWFSFeatureDownloaderImpl::run( bool serializeFeatures, int maxFeatures )
         mShared->mMaxFeatures = 0;
       }
     }
+    else if ( pagingIter > 2 && maxConcurrentPageRequests > 1 )
+    {
+      prefetchPages( maxConcurrentPageRequests, maxTotalFeatures );
+    }
   }
+  mPrefetchedPages.clear();
 
   endOfRun( serializeFeatures, success, mTotalDownloadedFeatureCount, truncatedResponse, interrupted, mErrorMessage );
 
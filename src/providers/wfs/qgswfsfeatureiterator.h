@@ -23,6 +23,7 @@
 
 #include "qgsbackgroundcachedfeatureiterator.h"
 
+#include <deque>
 #include <memory>
 #include <QMutex>
 #include <QWaitCondition>
@@ -56,6 +57,35 @@ class QgsWFSFeatureHitsAsyncRequest final: public QgsWfsRequest
     int mNumberMatched;
 };
 
+/**
+ * Utility class to download in advance a page of a GetFeature request, while
+ * the previous pages are being processed
+ */
+class QgsWFSFeaturePageRequest final: public QgsWfsRequest
+{
+    Q_OBJECT
+  public:
+    QgsWFSFeaturePageRequest( QgsWFSDataSourceURI &uri, qint64 startIndex );
+
+    void launch( const QUrl &url );
+
+    //! Returns the index of the first feature of the page
+    qint64 startIndex() const { return mStartIndex; }
+
+    //! Returns whether the download is finished, successfully or not
+    bool isFinished() const { return mFinished; }
+
+  private slots:
+    void pageReplyFinished();
+
+  protected:
+    QString errorMessageWithReason( const QString &reason ) override;
+
+  private:
+    qint64 mStartIndex;
+    bool mFinished = false;
+};
+
 /**
  * This class runs one (or several if paging is needed) GetFeature request,
     process the results as soon as they arrived and notify them to the
@@ -97,6 +127,12 @@ class QgsWFSFeatureDownloaderImpl final: public QgsWfsRequest, public QgsFeature
     void pushError( const QString &errorMsg );
     QString sanitizeFilter( QString filter );
 
+    /**
+     * Launches the requests of the pages following the current one, so that up
+     * to maxConcurrentRequests pages are downloaded at the same time.
+     */
+    void prefetchPages( int maxConcurrentRequests, qint64 maxTotalFeatures );
+
     //! Mutable data shared between provider, feature sources and downloader.
     QgsWFSSharedData *mShared = nullptr;
 
@@ -105,6 +141,8 @@ class QgsWFSFeatureDownloaderImpl final: public QgsWfsRequest, public QgsFeature
     int mNumberMatched = -1;
     QgsWFSFeatureHitsAsyncRequest mFeatureHitsAsyncRequest;
     qint64 mTotalDownloadedFeatureCount = 0;
+    //! Requests of the next pages, by increasing start index
+    std::deque< std::unique_ptr< QgsWFSFeaturePageRequest > > mPrefetchedPages;
 };
 
 
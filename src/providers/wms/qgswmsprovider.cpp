@@ -65,6 +65,8 @@
 #include <QNetworkDiskCache>
 #include <QTimer>
 #include <QStringBuilder>
+#include <QFutureWatcher>
+#include <QtConcurrentRun>
 
 #include <ogr_api.h>
 
@@ -81,6 +83,9 @@ QString QgsWmsProvider::WMS_DESCRIPTION = QStringLiteral( "OGC Web Map Service v
 
 static QString DEFAULT_LATLON_CRS = QStringLiteral( "CRS:84" );
 
+//! Maximum number of tiles requested in advance for a view
+static const int MAX_PREFETCHED_TILES = 256;
+
 QMap<QString, QgsWmsStatistics::Stat> QgsWmsStatistics::sData;
 
 //! a helper class for ordering tile requests according to the distance from view center
@@ -666,6 +671,95 @@ void QgsWmsProvider::fetchOtherResTiles( QgsTileMode tileMode, const QgsRectangl
                     .arg( otherResTiles.count() ), 3 );
 }
 
+void QgsWmsProvider::prefetchTiles( QgsTileMode tileMode, const QgsRectangle &viewExtent, const QgsWmtsTileMatrix *tm, const QgsWmtsTileMatrixLimits *tml, int col0, int row0, int col1, int row1 )
+{
+  QgsSettings s;
+  const int ringSize = s.value( QStringLiteral( "qgis/wmsTilePrefetchRing" ), 1 ).toInt();
+  const bool nextZoom = s.value( QStringLiteral( "qgis/wmsTilePrefetchNextZoom" ), false ).toBool();
+  if ( ringSize <= 0 && !nextZoom )
+    return;
+
+  const auto createTileRequests = [this, tileMode]( const QgsWmtsTileMatrix * matrix, const TilePositions & tiles, TileRequests & requests )
+  {
+    switch ( tileMode )
+    {
+      case WMSC:
+        createTileRequestsWMSC( matrix, tiles, requests );
+        break;
+
+      case WMTS:
+        createTileRequestsWMTS( matrix, tiles, requests );
+        break;
+
+      case XYZ:
+        createTileRequestsXYZ( matrix, tiles, requests );
+        break;
+    }
+  };
+
+  TileRequests requests;
+  if ( ringSize > 0 )
+  {
+    QgsRectangle ringExtent( viewExtent );
+    const double dx = ringSize * tm->tileWidth * tm->tres;
+    const double dy = ringSize * tm->tileHeight * tm->tres;
+    ringExtent.setXMinimum( ringExtent.xMinimum() - dx );
+    ringExtent.setXMaximum( ringExtent.xMaximum() + dx );
+    ringExtent.setYMinimum( ringExtent.yMinimum() - dy );
+    ringExtent.setYMaximum( ringExtent.yMaximum() + dy );
+
+    int ringCol0, ringRow0, ringCol1, ringRow1;
+    tm->viewExtentIntersection( ringExtent, tml, ringCol0, ringRow0, ringCol1, ringRow1 );
+
+    TilePositions tiles;
+    for ( int row = ringRow0; row <= ringRow1; row++ )
+    {
+      for ( int col = ringCol0; col <= ringCol1; col++ )
+      {
+        if ( row < row0 || row > row1 || col < col0 || col > col1 )
+          tiles << TilePosition( row, col );
+      }
+    }
+    createTileRequests( tm, tiles, requests );
+  }
+
+  if ( nextZoom )
+  {
+    if ( const QgsWmtsTileMatrix *tmNext = mTileMatrixSet->findOtherResolution( tm->tres, -1 ) )
+    {
+      const QgsWmtsTileMatrixLimits *tmlNext = nullptr;
+      if ( mTileLayer->setLinks.contains( mTileMatrixSet->identifier ) &&
+           mTileLayer->setLinks[ mTileMatrixSet->identifier ].limits.contains( tmNext->identifier ) )
+      {
+        tmlNext = &mTileLayer->setLinks[ mTileMatrixSet->identifier ].limits[ tmNext->identifier ];
+      }
+
+      int nextCol0, nextRow0, nextCol1, nextRow1;
+      tmNext->viewExtentIntersection( viewExtent, tmlNext, nextCol0, nextRow0, nextCol1, nextRow1 );
+
+      TilePositions tiles;
+      for ( int row = nextRow0; row <= nextRow1; row++ )
+      {
+        for ( int col = nextCol0; col <= nextCol1; col++ )
+        {
+          tiles << TilePosition( row, col );
+        }
+      }
+      createTileRequests( tmNext, tiles, requests );
+    }
+  }
+
+  // the tiles closest to the view first, and not more than for a large view
+  LessThanTileRequest cmp;
+  cmp.center = viewExtent.center();
+  std::sort( requests.begin(), requests.end(), cmp );
+  if ( requests.size() > MAX_PREFETCHED_TILES )
+    requests.erase( requests.begin() + MAX_PREFETCHED_TILES, requests.end() );
+
+  if ( !requests.isEmpty() )
+    QgsWmsTilePrefetcher::prefetch( dataSourceUri(), mSettings.authorization(), requests );
+}
+
 uint qHash( QgsWmsProvider::TilePosition tp )
 {
   return ( uint ) tp.col + ( ( uint ) tp.row << 16 );
@@ -742,18 +836,9 @@ QImage *QgsWmsProvider::draw( QgsRectangle const &viewExtent, int pixelWidth, in
     }
     else if ( ( mSettings.mMaxWidth != 0 && mSettings.mMaxHeight != 0 ) || pixelWidth > maxWidth || pixelHeight > maxHeight )
     {
-      int w = mSettings.mMaxWidth != 0 && mSettings.mMaxWidth < maxWidth ? mSettings.mMaxWidth : maxWidth;
-      int h = mSettings.mMaxHeight != 0 && mSettings.mMaxHeight < maxHeight ? mSettings.mMaxHeight : maxHeight;
-
       // this is an ordinary WMS server, but the user requested tiled approach
       // so we will pretend it is a WMS-C server with just one tile matrix
-      tempTm.reset( new QgsWmtsTileMatrix );
-      tempTm->topLeft      = QgsPointXY( mLayerExtent.xMinimum(), mLayerExtent.yMaximum() );
-      tempTm->tileWidth    = w;
-      tempTm->tileHeight   = h;
-      tempTm->matrixWidth  = std::ceil( mLayerExtent.width() / w / vres );
-      tempTm->matrixHeight = std::ceil( mLayerExtent.height() / h / vres );
-      tempTm->tres = vres;
+      tempTm = createTileMatrixWMS( vres, maxWidth, maxHeight );
       tm = tempTm.get();
 
       tileMode = WMSC;
@@ -954,6 +1039,10 @@ QImage *QgsWmsProvider::draw( QgsRectangle const &viewExtent, int pixelWidth, in
     int t2 = t.elapsed() - t1;
     Q_UNUSED( t2 ) // only used in debug build
 
+    // request the tiles around the view in the background, for when the map canvas is panned
+    if ( mSettings.mTiled && !mSettings.mIsMBTiles && feedback && feedback->prefetchTiles() && !feedback->isPreviewOnly() )
+      prefetchTiles( tileMode, viewExtent, tm, tml, col0, row0, col1, row1 );
+
     if ( feedback && feedback->isPreviewOnly() )
     {
       QgsDebugMsgLevel( QStringLiteral( "PREVIEW - CACHED: %1 / MISSING: %2" ).arg( tileImages.count() ).arg( requests.count() - tileImages.count() ), 4 );
@@ -1195,6 +1284,29 @@ void QgsWmsProvider::addWmstParameters( QUrlQuery &query )
   }
 }
 
+std::unique_ptr<QgsWmtsTileMatrix> QgsWmsProvider::createTileMatrixWMS( double resolution, int maxWidth, int maxHeight ) const
+{
+  int w = mSettings.mMaxWidth != 0 && mSettings.mMaxWidth < maxWidth ? mSettings.mMaxWidth : maxWidth;
+  int h = mSettings.mMaxHeight != 0 && mSettings.mMaxHeight < maxHeight ? mSettings.mMaxHeight : maxHeight;
+
+  // the server may only limit one of the dimensions, the other one then gets
+  // the step size instead of a tile size no server would accept
+  if ( w == std::numeric_limits<int>::max() )
+    w = mSettings.mStepWidth;
+  if ( h == std::numeric_limits<int>::max() )
+    h = mSettings.mStepHeight;
+
+  std::unique_ptr<QgsWmtsTileMatrix> tm = qgis::make_unique<QgsWmtsTileMatrix>();
+  tm->topLeft      = QgsPointXY( mLayerExtent.xMinimum(), mLayerExtent.yMaximum() );
+  tm->tileWidth    = w;
+  tm->tileHeight   = h;
+  // an extent which is a multiple of the tile size does not get an extra column or row from rounding errors
+  tm->matrixWidth  = std::ceil( mLayerExtent.width() / w / resolution - 1e-9 );
+  tm->matrixHeight = std::ceil( mLayerExtent.height() / h / resolution - 1e-9 );
+  tm->tres = resolution;
+  return tm;
+}
+
 void QgsWmsProvider::createTileRequestsWMSC( const QgsWmtsTileMatrix *tm, const QgsWmsProvider::TilePositions &tiles, QgsWmsProvider::TileRequests &requests )
 {
   bool changeXY = mCaps.shouldInvertAxisOrientation( mImageCrs );
@@ -4134,29 +4246,14 @@ void QgsWmsTiledImageDownloadHandler::downloadBlocking()
 }
 
 
-void QgsWmsTiledImageDownloadHandler::tileReplyFinished()
+static QImage decodeTile( const QByteArray &data )
 {
-  QNetworkReply *reply = qobject_cast<QNetworkReply *>( sender() );
-
-#if defined(QGISDEBUG)
-  bool fromCache = reply->attribute( QNetworkRequest::SourceIsFromCacheAttribute ).toBool();
-  QgsWmsStatistics::Stat &stat = QgsWmsStatistics::statForUri( mProviderUri );
-  if ( fromCache )
-    stat.cacheHits++;
-  else
-    stat.cacheMisses++;
-#endif
-#if defined(QGISDEBUG)
-  QgsDebugMsgLevel( QStringLiteral( "raw headers:" ), 3 );
-  const auto constRawHeaderPairs = reply->rawHeaderPairs();
-  for ( const QNetworkReply::RawHeaderPair &pair : constRawHeaderPairs )
-  {
-    QgsDebugMsgLevel( QStringLiteral( " %1:%2" )
-                      .arg( QString::fromUtf8( pair.first ),
-                            QString::fromUtf8( pair.second ) ), 3 );
-  }
-#endif
+  return QImage::fromData( data );
+}
 
+//! Keeps the tile of the \a reply in the network cache, even if the server does not allow it
+static void updateTileCacheExpiry( QNetworkReply *reply )
+{
   if ( QgsNetworkAccessManager::instance()->cache() )
   {
     QNetworkCacheMetaData cmd = QgsNetworkAccessManager::instance()->cache()->metaData( reply->request().url() );
@@ -4179,6 +4276,32 @@ void QgsWmsTiledImageDownloadHandler::tileReplyFinished()
 
     QgsNetworkAccessManager::instance()->cache()->updateMetaData( cmd );
   }
+}
+
+void QgsWmsTiledImageDownloadHandler::tileReplyFinished()
+{
+  QNetworkReply *reply = qobject_cast<QNetworkReply *>( sender() );
+
+#if defined(QGISDEBUG)
+  bool fromCache = reply->attribute( QNetworkRequest::SourceIsFromCacheAttribute ).toBool();
+  QgsWmsStatistics::Stat &stat = QgsWmsStatistics::statForUri( mProviderUri );
+  if ( fromCache )
+    stat.cacheHits++;
+  else
+    stat.cacheMisses++;
+#endif
+#if defined(QGISDEBUG)
+  QgsDebugMsgLevel( QStringLiteral( "raw headers:" ), 3 );
+  const auto constRawHeaderPairs = reply->rawHeaderPairs();
+  for ( const QNetworkReply::RawHeaderPair &pair : constRawHeaderPairs )
+  {
+    QgsDebugMsgLevel( QStringLiteral( " %1:%2" )
+                      .arg( QString::fromUtf8( pair.first ),
+                            QString::fromUtf8( pair.second ) ), 3 );
+  }
+#endif
+
+  updateTileCacheExpiry( reply );
 
   int tileReqNo = reply->request().attribute( static_cast<QNetworkRequest::Attribute>( TileReqNo ) ).toInt();
   int tileNo = reply->request().attribute( static_cast<QNetworkRequest::Attribute>( TileIndex ) ).toInt();
@@ -4233,7 +4356,7 @@ void QgsWmsTiledImageDownloadHandler::tileReplyFinished()
       mReplies.removeOne( reply );
       reply->deleteLater();
 
-      if ( mReplies.isEmpty() )
+      if ( mReplies.isEmpty() && mDecodingTiles == 0 )
         finish();
 
       return;
@@ -4272,7 +4395,7 @@ void QgsWmsTiledImageDownloadHandler::tileReplyFinished()
       mReplies.removeOne( reply );
       reply->deleteLater();
 
-      if ( mReplies.isEmpty() )
+      if ( mReplies.isEmpty() && mDecodingTiles == 0 )
         finish();
 
       return;
@@ -4290,37 +4413,20 @@ void QgsWmsTiledImageDownloadHandler::tileReplyFinished()
 
       QgsDebugMsgLevel( QStringLiteral( "tile reply: length %1" ).arg( reply->bytesAvailable() ), 2 );
 
-      QImage myLocalImage = QImage::fromData( reply->readAll() );
-
-      if ( !myLocalImage.isNull() )
-      {
-        QPainter p( mImage );
-        // if image size is "close enough" to destination size, don't smooth it out. Instead try for pixel-perfect placement!
-        const bool disableSmoothing = ( qgsDoubleNear( dst.width(), myLocalImage.width(), 2 ) && qgsDoubleNear( dst.height(), myLocalImage.height(), 2 ) );
-        if ( !disableSmoothing && mSmoothPixmapTransform )
-          p.setRenderHint( QPainter::SmoothPixmapTransform, true );
-        p.drawImage( dst, myLocalImage );
-        p.end();
-#if 0
-        myLocalImage.save( QString( "%1/%2-tile-%3.png" ).arg( QDir::tempPath() ).arg( mTileReqNo ).arg( tileNo ) );
-        p.drawRect( dst ); // show tile bounds
-        p.drawText( dst, Qt::AlignCenter, QString( "(%1)\n%2,%3\n%4,%5\n%6x%7" )
-                    .arg( tileNo )
-                    .arg( r.left() ).arg( r.bottom() )
-                    .arg( r.right() ).arg( r.top() )
-                    .arg( r.width() ).arg( r.height() ) );
-#endif
-
-        QgsTileCache::insertTile( reply->url(), myLocalImage );
-
-        if ( mFeedback )
-          mFeedback->onNewData();
-      }
-      else
+      // decode the tile on a worker thread, so that the next replies are processed
+      // meanwhile, and draw it when it is ready
+      const QUrl url = reply->url();
+      QFutureWatcher< QImage > *watcher = new QFutureWatcher< QImage >( this );
+      connect( watcher, &QFutureWatcherBase::finished, this, [this, watcher, dst, url, contentType]
       {
-        QgsMessageLog::logMessage( tr( "Returned image is flawed [Content-Type: %1; URL: %2]" )
-                                   .arg( contentType, reply->url().toString() ), tr( "WMS" ) );
-      }
+        drawTile( dst, watcher->result(), url, contentType );
+        watcher->deleteLater();
+        mDecodingTiles--;
+        if ( mReplies.isEmpty() && mDecodingTiles == 0 )
+          finish();
+      } );
+      mDecodingTiles++;
+      watcher->setFuture( QtConcurrent::run( decodeTile, reply->readAll() ) );
     }
     else
     {
@@ -4330,7 +4436,7 @@ void QgsWmsTiledImageDownloadHandler::tileReplyFinished()
     mReplies.removeOne( reply );
     reply->deleteLater();
 
-    if ( mReplies.isEmpty() )
+    if ( mReplies.isEmpty() && mDecodingTiles == 0 )
       finish();
 
   }
@@ -4353,7 +4459,7 @@ void QgsWmsTiledImageDownloadHandler::tileReplyFinished()
     mReplies.removeOne( reply );
     reply->deleteLater();
 
-    if ( mReplies.isEmpty() )
+    if ( mReplies.isEmpty() && mDecodingTiles == 0 )
       finish();
   }
 
@@ -4367,6 +4473,30 @@ void QgsWmsTiledImageDownloadHandler::tileReplyFinished()
 #endif
 }
 
+void QgsWmsTiledImageDownloadHandler::drawTile( const QRectF &dst, const QImage &myLocalImage, const QUrl &url, const QString &contentType )
+{
+  if ( !myLocalImage.isNull() )
+  {
+    QPainter p( mImage );
+    // if image size is "close enough" to destination size, don't smooth it out. Instead try for pixel-perfect placement!
+    const bool disableSmoothing = ( qgsDoubleNear( dst.width(), myLocalImage.width(), 2 ) && qgsDoubleNear( dst.height(), myLocalImage.height(), 2 ) );
+    if ( !disableSmoothing && mSmoothPixmapTransform )
+      p.setRenderHint( QPainter::SmoothPixmapTransform, true );
+    p.drawImage( dst, myLocalImage );
+    p.end();
+
+    QgsTileCache::insertTile( url, myLocalImage );
+
+    if ( mFeedback )
+      mFeedback->onNewData();
+  }
+  else
+  {
+    QgsMessageLog::logMessage( tr( "Returned image is flawed [Content-Type: %1; URL: %2]" )
+                               .arg( contentType, url.toString() ), tr( "WMS" ) );
+  }
+}
+
 void QgsWmsTiledImageDownloadHandler::canceled()
 {
   QgsDebugMsgLevel( QStringLiteral( "Caught canceled() signal" ), 3 );
@@ -4423,6 +4553,115 @@ void QgsWmsTiledImageDownloadHandler::repeatTileRequest( QNetworkRequest const &
   connect( reply, &QNetworkReply::finished, this, &QgsWmsTiledImageDownloadHandler::tileReplyFinished );
 }
 
+// ----------
+
+QgsWmsTilePrefetcher::QgsWmsTilePrefetcher()
+{
+  // the in-memory cache keeps its size unless a larger one is configured for the prefetched tiles
+  QgsSettings s;
+  const int tileCacheSize = s.value( QStringLiteral( "qgis/tileCacheSize" ), QgsTileCache::maxCost() ).toInt();
+  if ( tileCacheSize > QgsTileCache::maxCost() )
+    QgsTileCache::setMaxCost( tileCacheSize );
+
+  moveToThread( qApp->thread() );
+}
+
+QgsWmsTilePrefetcher *QgsWmsTilePrefetcher::instance()
+{
+  static QgsWmsTilePrefetcher *sInstance = new QgsWmsTilePrefetcher();
+  return sInstance;
+}
+
+void QgsWmsTilePrefetcher::prefetch( const QString &providerUri, const QgsWmsAuthorization &auth, const QgsWmsProvider::TileRequests &requests )
+{
+#if QT_VERSION >= QT_VERSION_CHECK( 5, 10, 0 )
+  if ( !qApp )
+    return;
+
+  // the requests are issued from the main thread, whose event loop keeps
+  // running after the rendering of the view is finished
+  QgsWmsTilePrefetcher *prefetcher = instance();
+  QMetaObject::invokeMethod( prefetcher, [prefetcher, providerUri, auth, requests]
+  {
+    prefetcher->startRequests( providerUri, auth, requests );
+  }, Qt::QueuedConnection );
+#else
+  Q_UNUSED( providerUri )
+  Q_UNUSED( auth )
+  Q_UNUSED( requests )
+#endif
+}
+
+void QgsWmsTilePrefetcher::startRequests( const QString &providerUri, const QgsWmsAuthorization &auth, const QgsWmsProvider::TileRequests &requests )
+{
+  QSet<QUrl> urls;
+  for ( const QgsWmsProvider::TileRequest &r : requests )
+    urls << r.url;
+
+  // the view has moved away from the tiles which are not requested any more
+  const QList<QNetworkReply *> replies = mReplies.value( providerUri );
+  QSet<QUrl> pendingUrls;
+  for ( QNetworkReply *reply : replies )
+  {
+    if ( urls.contains( reply->request().url() ) )
+      pendingUrls << reply->request().url();
+    else
+      reply->abort();
+  }
+
+  for ( const QgsWmsProvider::TileRequest &r : requests )
+  {
+    if ( pendingUrls.contains( r.url ) || QgsTileCache::hasTile( r.url ) )
+      continue;
+
+    QNetworkRequest request( r.url );
+    QgsSetRequestInitiatorClass( request, QStringLiteral( "QgsWmsTilePrefetcher" ) );
+    auth.setAuthorization( request );
+    request.setRawHeader( "Accept", "*/*" );
+    request.setAttribute( QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::PreferCache );
+    request.setAttribute( QNetworkRequest::CacheSaveControlAttribute, true );
+
+    QNetworkReply *reply = QgsNetworkAccessManager::instance()->get( request );
+    connect( reply, &QNetworkReply::finished, this, [this, providerUri, reply]
+    {
+      tileReplyFinished( providerUri, reply );
+    } );
+    mReplies[ providerUri ] << reply;
+  }
+}
+
+void QgsWmsTilePrefetcher::tileReplyFinished( const QString &providerUri, QNetworkReply *reply )
+{
+  QList<QNetworkReply *> &replies = mReplies[ providerUri ];
+  replies.removeOne( reply );
+  if ( replies.isEmpty() )
+    mReplies.remove( providerUri );
+  reply->deleteLater();
+
+  // errors and redirections are left to the view requests, if the tile is ever needed
+  if ( reply->error() != QNetworkReply::NoError ||
+       !reply->attribute( QNetworkRequest::RedirectionTargetAttribute ).isNull() )
+    return;
+
+  const QVariant status = reply->attribute( QNetworkRequest::HttpStatusCodeAttribute );
+  const QString contentType = reply->header( QNetworkRequest::ContentTypeHeader ).toString();
+  if ( ( !status.isNull() && status.toInt() >= 400 ) ||
+       ( !contentType.isEmpty() && !contentType.startsWith( QLatin1String( "image/" ), Qt::CaseInsensitive ) &&
+         contentType.compare( QLatin1String( "application/octet-stream" ), Qt::CaseInsensitive ) != 0 ) )
+    return;
+
+  updateTileCacheExpiry( reply );
+
+  const QUrl url = reply->request().url();
+  const QByteArray data = reply->readAll();
+  QtConcurrent::run( [url, data]
+  {
+    const QImage image = decodeTile( data );
+    if ( !image.isNull() )
+      QgsTileCache::insertTile( url, image );
+  } );
+}
+
 // Some servers like http://glogow.geoportal2.pl/map/wms/wms.php? do not BBOX
 // to be formatted with excessive precision. As a double is exactly represented
 // with 19 decimal figures, do not attempt to output more
@@ -339,6 +339,14 @@ class QgsWmsProvider final: public QgsRasterDataProvider
   private:
 
     QUrl createRequestUrlWMS( const QgsRectangle &viewExtent, int pixelWidth, int pixelHeight );
+
+    /**
+     * Returns the tile matrix of the pseudo WMS-C grid used to split the requests to an ordinary WMS server
+     * at the \a resolution in map units per pixel. The tiles are no larger than the \a maxWidth x \a maxHeight
+     * limits of the server, in pixels, nor than the limits of the URI. A dimension limited by neither of
+     * them gets the step size.
+     */
+    std::unique_ptr<QgsWmtsTileMatrix> createTileMatrixWMS( double resolution, int maxWidth, int maxHeight ) const;
     void createTileRequestsWMSC( const QgsWmtsTileMatrix *tm, const QgsWmsProvider::TilePositions &tiles, QgsWmsProvider::TileRequests &requests );
     void createTileRequestsWMTS( const QgsWmtsTileMatrix *tm, const QgsWmsProvider::TilePositions &tiles, QgsWmsProvider::TileRequests &requests );
     void createTileRequestsXYZ( const QgsWmtsTileMatrix *tm, const QgsWmsProvider::TilePositions &tiles, QgsWmsProvider::TileRequests &requests );
@@ -361,6 +369,14 @@ class QgsWmsProvider final: public QgsRasterDataProvider
     //! Gets tiles from a different resolution to cover the missing areas
     void fetchOtherResTiles( QgsTileMode tileMode, const QgsRectangle &viewExtent, int imageWidth, QList<QRectF> &missing, double tres, int resOffset, QList<TileImage> &otherResTiles );
 
+    /**
+     * Requests in the background a ring of tiles around the view tiles \a col0, \a row0 to \a col1, \a row1
+     * of the tile matrix \a tm, and optionally the view tiles of the next zoom level, so that they are
+     * cached when the view moves to them. Only called for the renders of an interactive map canvas,
+     * whose feedback has QgsRasterBlockFeedback::prefetchTiles() set.
+     */
+    void prefetchTiles( QgsTileMode tileMode, const QgsRectangle &viewExtent, const QgsWmtsTileMatrix *tm, const QgsWmtsTileMatrixLimits *tml, int col0, int row0, int col1, int row1 );
+
     /**
      * Returns the full url to request legend graphic
      * The visibleExtent isi only used if provider supports contextual
@@ -550,6 +566,9 @@ class QgsWmsTiledImageDownloadHandler : public QObject
 
     void finish() { QMetaObject::invokeMethod( mEventLoop, "quit", Qt::QueuedConnection ); }
 
+    //! Draws a decoded tile on the image, at the \a dst rectangle
+    void drawTile( const QRectF &dst, const QImage &image, const QUrl &url, const QString &contentType );
+
     QString mProviderUri;
 
     QgsWmsAuthorization mAuth;
@@ -565,10 +584,43 @@ class QgsWmsTiledImageDownloadHandler : public QObject
     //! Running tile requests
     QList<QNetworkReply *> mReplies;
 
+    //! Number of tiles being decoded on worker threads
+    int mDecodingTiles = 0;
+
     QgsRasterBlockFeedback *mFeedback = nullptr;
 };
 
 
+/**
+ * Downloads tiles in the background, from the main thread, so that they are in the caches
+ * when the view moves to them. Unlike QgsWmsTiledImageDownloadHandler, nothing waits for
+ * these requests, and the downloaded tiles are decoded on worker threads.
+ */
+class QgsWmsTilePrefetcher : public QObject
+{
+    Q_OBJECT
+  public:
+
+    /**
+     * Requests the tiles, and cancels the prefetch requests of the provider with the same
+     * \a providerUri that are not in \a requests any more. Can be called from any thread.
+     */
+    static void prefetch( const QString &providerUri, const QgsWmsAuthorization &auth, const QgsWmsProvider::TileRequests &requests );
+
+  private:
+    QgsWmsTilePrefetcher();
+
+    //! Returns the prefetcher, which lives in the main thread
+    static QgsWmsTilePrefetcher *instance();
+
+    void startRequests( const QString &providerUri, const QgsWmsAuthorization &auth, const QgsWmsProvider::TileRequests &requests );
+    void tileReplyFinished( const QString &providerUri, QNetworkReply *reply );
+
+    //! Running prefetch requests, per provider URI
+    QHash<QString, QList<QNetworkReply *> > mReplies;
+};
+
+
 //! Class keeping simple statistics for WMS provider - per unique URI
 class QgsWmsStatistics
 {
@@ -18,6 +18,7 @@
 #include <QSGSimpleTextureNode>
 #include <QtConcurrent>
 
+#include "qgsmaprenderercache.h"
 #include "qgsmaprendererparalleljob.h"
 #include "qgsmessagelog.h"
 #include "qgspallabeling.h"
@@ -33,6 +34,7 @@
 QgsQuickMapCanvasMap::QgsQuickMapCanvasMap( QQuickItem *parent )
   : QQuickItem( parent )
   , mMapSettings( new QgsQuickMapSettings() )
+  , mCache( new QgsMapRendererCache() )
 {
   connect( this, &QQuickItem::windowChanged, this, &QgsQuickMapCanvasMap::onWindowChanged );
   connect( &mRefreshTimer, &QTimer::timeout, this, &QgsQuickMapCanvasMap::refreshMap );
@@ -41,6 +43,13 @@ QgsQuickMapCanvasMap::QgsQuickMapCanvasMap( QQuickItem *parent )
   connect( mMapSettings.get(), &QgsQuickMapSettings::extentChanged, this, &QgsQuickMapCanvasMap::onExtentChanged );
   connect( mMapSettings.get(), &QgsQuickMapSettings::layersChanged, this, &QgsQuickMapCanvasMap::onLayersChanged );
 
+  // the cached images are only valid for the same map settings
+  const auto clearCache = [this] { mCache->clear(); };
+  connect( mMapSettings.get(), &QgsQuickMapSettings::projectChanged, this, clearCache );
+  connect( mMapSettings.get(), &QgsQuickMapSettings::destinationCrsChanged, this, clearCache );
+  connect( mMapSettings.get(), &QgsQuickMapSettings::rotationChanged, this, clearCache );
+  connect( mMapSettings.get(), &QgsQuickMapSettings::outputDpiChanged, this, clearCache );
+
   connect( this, &QgsQuickMapCanvasMap::renderStarting, this, &QgsQuickMapCanvasMap::isRenderingChanged );
   connect( this, &QgsQuickMapCanvasMap::mapCanvasRefreshed, this, &QgsQuickMapCanvasMap::isRenderingChanged );
 
@@ -51,6 +60,16 @@ QgsQuickMapCanvasMap::QgsQuickMapCanvasMap( QQuickItem *parent )
   setFlags( QQuickItem::ItemHasContents );
 }
 
+QgsQuickMapCanvasMap::~QgsQuickMapCanvasMap()
+{
+  // the job renders into the cache
+  if ( mJob )
+  {
+    whileBlocking( mJob )->cancel();
+    delete mJob;
+  }
+}
+
 QgsQuickMapSettings *QgsQuickMapCanvasMap::mapSettings() const
 {
   return mMapSettings.get();
@@ -125,7 +144,9 @@ void QgsQuickMapCanvasMap::refreshMap()
 
   connect( mJob, &QgsMapRendererJob::renderingLayersFinished, this, &QgsQuickMapCanvasMap::renderJobUpdated );
   connect( mJob, &QgsMapRendererJob::finished, this, &QgsQuickMapCanvasMap::renderJobFinished );
-  mJob->setCache( mCache );
+  // the images of the layers which did not change are reused, and after a pan only
+  // the newly uncovered part of the layers is rendered
+  mJob->setCache( mCache.get() );
 
   mJob->start();
 
@@ -362,6 +383,7 @@ void QgsQuickMapCanvasMap::stopRendering()
   {
     disconnect( mJob, &QgsMapRendererJob::renderingLayersFinished, this, &QgsQuickMapCanvasMap::renderJobUpdated );
     disconnect( mJob, &QgsMapRendererJob::finished, this, &QgsQuickMapCanvasMap::renderJobFinished );
+    connect( mJob, &QgsMapRendererJob::finished, mJob, &QgsMapRendererJob::deleteLater );
 
     mJob->cancelWithoutBlocking();
     mJob = nullptr;
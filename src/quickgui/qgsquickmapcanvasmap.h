@@ -91,7 +91,7 @@ class QUICK_EXPORT QgsQuickMapCanvasMap : public QQuickItem
   public:
     //! Create map canvas map
     QgsQuickMapCanvasMap( QQuickItem *parent = nullptr );
-    ~QgsQuickMapCanvasMap() = default;
+    ~QgsQuickMapCanvasMap() override;
 
     QSGNode *updatePaintNode( QSGNode *oldNode, QQuickItem::UpdatePaintNodeData * ) override;
 
@@ -189,7 +189,7 @@ class QUICK_EXPORT QgsQuickMapCanvasMap : public QQuickItem
     bool mPinching = false;
     QPoint mPinchStartPoint;
     QgsMapRendererParallelJob *mJob = nullptr;
-    QgsMapRendererCache *mCache = nullptr;
+    std::unique_ptr<QgsMapRendererCache> mCache;
     QgsLabelingResults *mLabelingResults = nullptr;
     QImage mImage;
     QgsMapSettings mImageMapSettings;
@@ -19,8 +19,13 @@
 //for CMAKE_INSTALL_PREFIX
 #include "qgsconfig.h"
 #include "qgsserver.h"
+#ifdef HAVE_SERVER_PYTHON_PLUGINS
+#include "qgsaccesscontrol.h"
+#endif
 #include "qgsfcgiserverresponse.h"
 #include "qgsfcgiserverrequest.h"
+#include "qgsbufferserverrequest.h"
+#include "qgsbufferserverresponse.h"
 #include "qgsapplication.h"
 
 #include <fcgi_stdio.h>
@@ -28,6 +33,9 @@
 
 #include <QFontDatabase>
 #include <QString>
+#include <QMutex>
+#include <QThreadPool>
+#include <QtConcurrent>
 
 int fcgi_accept()
 {
@@ -41,6 +49,163 @@ int fcgi_accept()
 #endif
 }
 
+///@cond PRIVATE
+
+/**
+ * Accepts and handles FCGI requests with the reentrant FCGX API until the
+ * listening socket is closed. This is the loop run by each worker thread
+ * when the server is configured with more than one QGIS_SERVER_WORKER_THREADS:
+ * requests are read in buffers because QgsFcgiServerRequest and QgsFcgiServerResponse
+ * rely on the process-wide FCGI stdio streams, and responses are written to the
+ * request stream each time they are flushed.
+ */
+void fcgxWorkerLoop( QgsServer &server )
+{
+  static QMutex sAcceptMutex;
+
+  FCGX_Request fcgxRequest;
+  FCGX_InitRequest( &fcgxRequest, 0, 0 );
+
+  while ( true )
+  {
+    int rc;
+    {
+      // Some platforms require accept() to be serialized
+      QMutexLocker locker( &sAcceptMutex );
+      rc = FCGX_Accept_r( &fcgxRequest );
+    }
+
+    if ( rc < 0 )
+    {
+      break;
+    }
+
+    auto param = [ &fcgxRequest ]( const char *name ) -> QString
+    {
+      return QString( FCGX_GetParam( name, fcgxRequest.envp ) );
+    };
+
+    // Same logic as in QgsFcgiServerRequest, based on the request parameters
+    QString uri = param( "REQUEST_URI" );
+    if ( uri.isEmpty() )
+    {
+      uri = param( "SCRIPT_NAME" );
+    }
+
+    QUrl url( uri );
+    if ( url.host().isEmpty() )
+    {
+      url.setHost( param( "SERVER_NAME" ) );
+    }
+
+    if ( url.port( -1 ) == -1 )
+    {
+      bool portOk;
+      const int portNumber = param( "SERVER_PORT" ).toInt( &portOk );
+      if ( portOk && portNumber != 80 )
+      {
+        url.setPort( portNumber );
+      }
+    }
+
+    if ( url.scheme().isEmpty() )
+    {
+      url.setScheme( param( "HTTPS" ).compare( QLatin1String( "on" ), Qt::CaseInsensitive ) == 0 ? QStringLiteral( "https" ) : QStringLiteral( "http" ) );
+    }
+
+    if ( FCGX_GetParam( "QUERY_STRING", fcgxRequest.envp ) )
+    {
+      url.setQuery( param( "QUERY_STRING" ) );
+    }
+
+    const QString methodString = param( "REQUEST_METHOD" );
+    QgsServerRequest::Method method = QgsServerRequest::GetMethod;
+    if ( methodString == QLatin1String( "POST" ) )
+      method = QgsServerRequest::PostMethod;
+    else if ( methodString == QLatin1String( "PUT" ) )
+      method = QgsServerRequest::PutMethod;
+    else if ( methodString == QLatin1String( "DELETE" ) )
+      method = QgsServerRequest::DeleteMethod;
+    else if ( methodString == QLatin1String( "HEAD" ) )
+      method = QgsServerRequest::HeadMethod;
+    else if ( methodString == QLatin1String( "PATCH" ) )
+      method = QgsServerRequest::PatchMethod;
+
+    QgsServerRequest::Headers headers;
+    if ( FCGX_GetParam( "HTTP_ACCEPT", fcgxRequest.envp ) )
+    {
+      headers.insert( QStringLiteral( "Accept" ), param( "HTTP_ACCEPT" ) );
+    }
+
+    QByteArray data;
+    bool lengthOk = true;
+    if ( method == QgsServerRequest::PostMethod || method == QgsServerRequest::PutMethod )
+    {
+      const int length = param( "CONTENT_LENGTH" ).toInt( &lengthOk );
+      if ( lengthOk && length > 0 )
+      {
+        data.resize( length );
+        data.resize( FCGX_GetStr( data.data(), length, fcgxRequest.in ) );
+      }
+    }
+
+    QgsBufferServerResponse response;
+
+    // Writes the status and the headers once they are final, i.e. on the
+    // first flush of the response
+    bool headersWritten = false;
+    auto writeHeaders = [ &fcgxRequest, &response, &headersWritten ]
+    {
+      headersWritten = true;
+      // fcgi applications must return HTTP status in header
+      FCGX_FPrintF( fcgxRequest.out, "Status: %d\r\n", response.statusCode() );
+      const QMap<QString, QString> responseHeaders = response.headers();
+      for ( auto it = responseHeaders.constBegin(); it != responseHeaders.constEnd(); ++it )
+      {
+        const QByteArray header = QStringLiteral( "%1: %2\r\n" ).arg( it.key(), it.value() ).toUtf8();
+        FCGX_PutStr( header.constData(), header.size(), fcgxRequest.out );
+      }
+      FCGX_PutS( "\r\n", fcgxRequest.out );
+    };
+
+    // Write the flushed data as it comes instead of buffering the whole body,
+    // so that large responses (e.g. WFS GetFeature) are streamed to the web
+    // server. Responses only flushed when finished get their Content-Length.
+    response.setFlushCallback( [ &fcgxRequest, &writeHeaders, &headersWritten, method ]( const QByteArray & data )
+    {
+      if ( !headersWritten )
+      {
+        writeHeaders();
+      }
+      if ( method != QgsServerRequest::HeadMethod )
+      {
+        FCGX_PutStr( data.constData(), data.size(), fcgxRequest.out );
+      }
+      FCGX_FFlush( fcgxRequest.out );
+    } );
+
+    if ( lengthOk )
+    {
+      QgsBufferServerRequest request( url, method, headers, &data );
+      server.handleRequest( request, response );
+    }
+    else
+    {
+      response.sendError( 400, QStringLiteral( "Bad request" ) );
+    }
+
+    // Empty responses are never passed to the flush callback
+    if ( !headersWritten )
+    {
+      writeHeaders();
+    }
+
+    FCGX_Finish_r( &fcgxRequest );
+  }
+}
+
+///@endcond
+
 int main( int argc, char *argv[] )
 {
   // Test if the environ variable DISPLAY is defined
@@ -73,6 +238,46 @@ int main( int argc, char *argv[] )
   QFontDatabase fontDB;
 #endif
 
+  int workerThreads = server.serverInterface()->serverSettings()->workerThreads();
+  bool pythonFilters = ! server.serverInterface()->filters().isEmpty();
+#ifdef HAVE_SERVER_PYTHON_PLUGINS
+  // access control filters change the subset strings of the shared layers
+  pythonFilters |= ! server.serverInterface()->accessControls()->isEmpty();
+#endif
+  if ( workerThreads > 1 && pythonFilters )
+  {
+    // Python filters are not thread-safe
+    QgsMessageLog::logMessage( QStringLiteral( "Server filters are registered, requests will be handled by a single thread" ), QStringLiteral( "Server" ), Qgis::Warning );
+    workerThreads = 1;
+  }
+
+  if ( workerThreads > 1 && ! FCGX_IsCGI() )
+  {
+    // Starts a FCGI loop for each worker thread, all the workers share
+    // the same project and capabilities caches
+    QgsMessageLog::logMessage( QStringLiteral( "Handling requests with %1 worker threads" ).arg( workerThreads ), QStringLiteral( "Server" ), Qgis::Info );
+    FCGX_Init();
+    QThreadPool workerPool;
+    workerPool.setMaxThreadCount( workerThreads );
+    QAtomicInt runningWorkers( workerThreads );
+    for ( int i = 0; i < workerThreads; ++i )
+    {
+      QtConcurrent::run( &workerPool, [ &server, &runningWorkers ]
+      {
+        fcgxWorkerLoop( server );
+        if ( ! runningWorkers.deref() )
+        {
+          QMetaObject::invokeMethod( qApp, "quit", Qt::QueuedConnection );
+        }
+      } );
+    }
+    // The main thread event loop keeps serving the caches file system watchers
+    app.exec();
+    workerPool.waitForDone();
+    app.exitQgis();
+    return 0;
+  }
+
   // Starts FCGI loop
   while ( fcgi_accept() >= 0 )
   {
@@ -27,6 +27,9 @@ while QGIS server internal logging is printed to stderr.
 //for CMAKE_INSTALL_PREFIX
 #include "qgsconfig.h"
 #include "qgsserver.h"
+#ifdef HAVE_SERVER_PYTHON_PLUGINS
+#include "qgsaccesscontrol.h"
+#endif
 #include "qgsbufferserverrequest.h"
 #include "qgsbufferserverresponse.h"
 #include "qgsapplication.h"
@@ -39,6 +42,9 @@ while QGIS server internal logging is printed to stderr.
 #include <QNetworkInterface>
 #include <QCommandLineParser>
 #include <QObject>
+#include <QThreadPool>
+#include <QFutureWatcher>
+#include <QtConcurrent>
 
 
 #ifndef Q_OS_WIN
@@ -47,6 +53,7 @@ while QGIS server internal logging is printed to stderr.
 
 #include <string>
 #include <chrono>
+#include <memory>
 
 ///@cond PRIVATE
 
@@ -148,6 +155,12 @@ int main( int argc, char *argv[] )
                                      "2: CRITICAL" ), "logLevel", "0" );
   parser.addOption( logLevelOption );
 
+  QCommandLineOption workersOption( "w", QObject::tr( "Number of worker threads handling requests (default: 1)\n"
+                                    "worker threads share the projects cache, 0 means one\n"
+                                    "worker for each available core. It can also be specified\n"
+                                    "with the environment variable QGIS_SERVER_WORKER_THREADS." ), "workers", "" );
+  parser.addOption( workersOption );
+
   QCommandLineOption projectOption( "p", QObject::tr( "Path to a QGIS project file (*.qgs or *.qgz),\n"
                                     "if specified it will override the query string MAP argument\n"
                                     "and the QGIS_PROJECT_FILE environment variable." ), "projectPath", "" );
@@ -171,6 +184,11 @@ int main( int argc, char *argv[] )
   qputenv( "QGIS_SERVER_LOG_LEVEL", logLevel.toUtf8() );
   qputenv( "QGIS_SERVER_LOG_STDERR", "1" );
 
+  if ( ! parser.value( workersOption ).isEmpty( ) )
+  {
+    qputenv( "QGIS_SERVER_WORKER_THREADS", parser.value( workersOption ).toUtf8() );
+  }
+
   if ( ! parser.value( projectOption ).isEmpty( ) )
   {
     // Check it!
@@ -233,6 +251,27 @@ int main( int argc, char *argv[] )
     server.initPython();
 #endif
 
+    // Worker threads pool, requests are handled in the main thread if only one worker is set
+    std::unique_ptr<QThreadPool> workerPool;
+    int workerThreads { server.serverInterface()->serverSettings()->workerThreads() };
+    bool pythonFilters { ! server.serverInterface()->filters().isEmpty() };
+#ifdef HAVE_SERVER_PYTHON_PLUGINS
+    // access control filters change the subset strings of the shared layers
+    pythonFilters |= ! server.serverInterface()->accessControls()->isEmpty();
+#endif
+    if ( workerThreads > 1 && pythonFilters )
+    {
+      // Python filters are not thread-safe
+      std::cout << QObject::tr( "Server filters are registered, requests will be handled by a single thread" ).toStdString() << std::endl;
+      workerThreads = 1;
+    }
+    if ( workerThreads > 1 )
+    {
+      workerPool = qgis::make_unique<QThreadPool>();
+      workerPool->setMaxThreadCount( workerThreads );
+      std::cout << QObject::tr( "Handling requests with %1 worker threads" ).arg( workerThreads ).toStdString() << std::endl;
+    }
+
     std::cout << QObject::tr( "QGIS Development Server listening on http://%1:%2" )
               .arg( ipAddress ).arg( port ).toStdString() << std::endl;
 #ifndef Q_OS_WIN
@@ -266,7 +305,7 @@ int main( int argc, char *argv[] )
       clientConnection->connect( clientConnection, &QAbstractSocket::disconnected, context, connectionDeleter, Qt::QueuedConnection );
 
       // Incoming connection parser
-      clientConnection->connect( clientConnection, &QIODevice::readyRead, context, [ =, &server, &connCounter ] {
+      clientConnection->connect( clientConnection, &QIODevice::readyRead, context, [ =, &server, &workerPool, &connCounter ] {
 
         // Read all incoming data
         while ( clientConnection->bytesAvailable() > 0 )
@@ -385,59 +424,89 @@ int main( int argc, char *argv[] )
           // Inefficient copy :(
           QByteArray data { incomingData->mid( headersSize ).toUtf8() };
 
-          auto start = std::chrono::steady_clock::now();
-
-          QgsBufferServerRequest request { url, method, headers, &data };
-          QgsBufferServerResponse response;
+          const auto start = std::chrono::steady_clock::now();
 
-          server.handleRequest( request, response );
+          // Request and response are shared with the worker thread (if any)
+          // and released after the response has been sent
+          std::shared_ptr<QgsBufferServerRequest> request = std::make_shared<QgsBufferServerRequest>( url, method, headers, &data );
+          std::shared_ptr<QgsBufferServerResponse> response = std::make_shared<QgsBufferServerResponse>();
 
-          // The QGIS server machinery calls processEvents and has internal loop events
-          // that might change the connection state
-          if ( clientConnection->state() == QAbstractSocket::SocketState::ConnectedState )
+          // Writes the response to the client, must be called from the main thread
+          auto sendResponse = [ =, &connCounter ]
           {
-            clientConnection->connect( clientConnection, &QAbstractSocket::disconnected,
-                                       clientConnection, connectionDeleter, Qt::QueuedConnection );
-          }
-          else
-          {
-            connCounter --;
-            clientConnection->deleteLater();
-            delete incomingData;
-            return;
-          }
+            // The QGIS server machinery calls processEvents and has internal loop events
+            // that might change the connection state
+            if ( clientConnection->state() == QAbstractSocket::SocketState::ConnectedState )
+            {
+              clientConnection->connect( clientConnection, &QAbstractSocket::disconnected,
+                                         clientConnection, connectionDeleter, Qt::QueuedConnection );
+            }
+            else
+            {
+              connCounter --;
+              clientConnection->deleteLater();
+              delete incomingData;
+              return;
+            }
+
+            auto elapsedTime { std::chrono::steady_clock::now() - start };
 
-          auto elapsedTime { std::chrono::steady_clock::now() - start };
+            int statusCode { response->statusCode() };
+            QByteArray body { response->body() };
+            if ( ! knownStatuses.contains( statusCode ) )
+            {
+              body = QStringLiteral( "HTTP error unsupported status code: %1" ).arg( statusCode ).toUtf8();
+              statusCode = 500;
+            }
 
-          if ( ! knownStatuses.contains( response.statusCode() ) )
+            // Output stream
+            clientConnection->write( QStringLiteral( "HTTP/1.0 %1 %2\r\n" ).arg( statusCode ).arg( knownStatuses.value( statusCode ) ).toUtf8() );
+            clientConnection->write( QStringLiteral( "Server: QGIS\r\n" ).toUtf8() );
+            if ( statusCode == response->statusCode() )
+            {
+              const auto responseHeaders { response->headers() };
+              for ( auto it = responseHeaders.constBegin(); it != responseHeaders.constEnd(); ++it )
+              {
+                clientConnection->write( QStringLiteral( "%1: %2\r\n" ).arg( it.key(), it.value() ).toUtf8() );
+              }
+            }
+            clientConnection->write( "\r\n" );
+            clientConnection->write( body );
+
+            // 10.185.248.71 [09/Jan/2015:19:12:06 +0000] 808840 <time> "GET / HTTP/1.1" 500"
+            std::cout << QStringLiteral( "%1 [%2] %3 %4ms \"%5\" %6" )
+                      .arg( clientConnection->peerAddress().toString(),
+                            QDateTime::currentDateTime().toString(),
+                            QString::number( body.size() ),
+                            QString::number( std::chrono::duration_cast<std::chrono::milliseconds>( elapsedTime ).count() ),
+                            firstLinePieces.join( ' ' ),
+                            QString::number( statusCode ) )
+                      .toStdString()
+                      << std::endl;
+
+            clientConnection->disconnectFromHost();
+          };
+
+          if ( workerPool )
           {
-            throw HttpException( QStringLiteral( "HTTP error unsupported status code: %1" ).arg( response.statusCode() ) );
+            // Handle the request in a worker thread, the projects are shared
+            // through the (thread-safe) config cache
+            QFutureWatcher<void> *watcher = new QFutureWatcher<void>();
+            QObject::connect( watcher, &QFutureWatcher<void>::finished, clientConnection, [ = ]
+            {
+              sendResponse();
+              watcher->deleteLater();
+            } );
+            watcher->setFuture( QtConcurrent::run( workerPool.get(), [ =, &server ]
+            {
+              server.handleRequest( *request, *response );
+            } ) );
           }
-
-          // Output stream
-          clientConnection->write( QStringLiteral( "HTTP/1.0 %1 %2\r\n" ).arg( response.statusCode() ).arg( knownStatuses.value( response.statusCode() ) ).toUtf8() );
-          clientConnection->write( QStringLiteral( "Server: QGIS\r\n" ).toUtf8() );
-          const auto responseHeaders { response.headers() };
-          for ( auto it = responseHeaders.constBegin(); it != responseHeaders.constEnd(); ++it )
+          else
           {
-            clientConnection->write( QStringLiteral( "%1: %2\r\n" ).arg( it.key(), it.value() ).toUtf8() );
+            server.handleRequest( *request, *response );
+            sendResponse();
           }
-          clientConnection->write( "\r\n" );
-          const QByteArray body { response.body() };
-          clientConnection->write( body );
-
-          // 10.185.248.71 [09/Jan/2015:19:12:06 +0000] 808840 <time> "GET / HTTP/1.1" 500"
-          std::cout << QStringLiteral( "%1 [%2] %3 %4ms \"%5\" %6" )
-                    .arg( clientConnection->peerAddress().toString(),
-                          QDateTime::currentDateTime().toString(),
-                          QString::number( body.size() ),
-                          QString::number( std::chrono::duration_cast<std::chrono::milliseconds>( elapsedTime ).count() ),
-                          firstLinePieces.join( ' ' ),
-                          QString::number( response.statusCode() ) )
-                    .toStdString()
-                    << std::endl;
-
-          clientConnection->disconnectFromHost();
         }
         catch ( HttpException &ex )
         {
@@ -473,28 +542,34 @@ int main( int argc, char *argv[] )
 
     } );
 
-  }
-
-  // Exit handlers
+    // Exit handlers
 #ifndef Q_OS_WIN
 
-  auto exitHandler = [ ]( int signal )
-  {
-    std::cout << QStringLiteral( "Signal %1 received: quitting" ).arg( signal ).toStdString() << std::endl;
-    qApp->quit();
-  };
-
-  signal( SIGTERM, exitHandler );
-  signal( SIGABRT, exitHandler );
-  signal( SIGINT, exitHandler );
-  signal( SIGPIPE, [ ]( int )
-  {
-    std::cerr << QStringLiteral( "Signal SIGPIPE received: ignoring" ).toStdString() << std::endl;
-  } );
+    auto exitHandler = [ ]( int signal )
+    {
+      std::cout << QStringLiteral( "Signal %1 received: quitting" ).arg( signal ).toStdString() << std::endl;
+      qApp->quit();
+    };
+
+    signal( SIGTERM, exitHandler );
+    signal( SIGABRT, exitHandler );
+    signal( SIGINT, exitHandler );
+    signal( SIGPIPE, [ ]( int )
+    {
+      std::cerr << QStringLiteral( "Signal SIGPIPE received: ignoring" ).toStdString() << std::endl;
+    } );
 
 #endif
 
-  app.exec();
+    app.exec();
+
+    // Wait for the requests being handled by worker threads
+    if ( workerPool )
+    {
+      workerPool->waitForDone();
+    }
+  }
+
   app.exitQgis();
   return 0;
 }
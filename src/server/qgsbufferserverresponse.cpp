@@ -104,7 +104,15 @@ void QgsBufferServerResponse::flush()
 
   mBuffer.seek( 0 );
   QByteArray &ba = mBuffer.buffer();
-  mBody.append( ba );
+  if ( mFlushCallback )
+  {
+    if ( !ba.isEmpty() )
+      mFlushCallback( ba );
+  }
+  else
+  {
+    mBody.append( ba );
+  }
   ba.clear();
 }
 
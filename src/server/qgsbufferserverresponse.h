@@ -28,6 +28,8 @@
 #include <QMap>
 #include <QString>
 
+#include <functional>
+
 /**
  * \ingroup server
  * \class QgsBufferServerResponse
@@ -139,6 +141,21 @@ class SERVER_EXPORT QgsBufferServerResponse: public QgsServerResponse
      */
     QByteArray body() const { return mBody; }
 
+#ifndef SIP_RUN
+
+    /**
+     * Sets a \a callback which receives the buffered data on each flush(), instead of
+     * accumulating it in body().
+     *
+     * This allows streaming large responses with a bounded amount of memory. The headers
+     * and status code are final when the callback is called for the first time.
+     *
+     * \note not available in Python bindings
+     * \since QGIS 3.16
+     */
+    void setFlushCallback( const std::function< void( const QByteArray &data ) > &callback ) { mFlushCallback = callback; }
+#endif
+
 
   private:
 
@@ -152,6 +169,7 @@ class SERVER_EXPORT QgsBufferServerResponse: public QgsServerResponse
     bool                   mFinished = false;
     bool                   mHeadersSent = false;
     int                    mStatusCode = 200;
+    std::function< void( const QByteArray &data ) > mFlushCallback;
 };
 
 #endif
@@ -18,16 +18,23 @@
 #include "qgscapabilitiescache.h"
 
 #include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDir>
 #include <QFileInfo>
+#include <QSaveFile>
+#include <QThread>
 
 #if defined(Q_OS_LINUX)
 #include <sys/vfs.h>
 #endif
 
+#include "qgsconfigcache.h"
 #include "qgslogger.h"
+#include "qgsmessagelog.h"
 
 
-QgsCapabilitiesCache::QgsCapabilitiesCache()
+QgsCapabilitiesCache::QgsCapabilitiesCache( const QString &directory )
+  : mDirectory( directory )
 {
   QObject::connect( &mFileSystemWatcher, &QFileSystemWatcher::fileChanged, this, &QgsCapabilitiesCache::removeChangedEntry );
 
@@ -36,37 +43,64 @@ QgsCapabilitiesCache::QgsCapabilitiesCache()
 #endif
 }
 
-const QDomDocument *QgsCapabilitiesCache::searchCapabilitiesDocument( const QString &configFilePath, const QString &key )
+std::shared_ptr<const QDomDocument> QgsCapabilitiesCache::searchCapabilitiesDocument( const QString &configFilePath, const QString &key )
 {
-  QCoreApplication::processEvents(); //get updates from file system watcher
+  if ( QThread::currentThread() == thread() )
+  {
+    QCoreApplication::processEvents(); //get updates from file system watcher
+  }
+
+  QMutexLocker locker( &mMutex );
 
   if ( mCachedCapabilities.contains( configFilePath ) && mCachedCapabilities[ configFilePath ].contains( key ) )
   {
-    return &mCachedCapabilities[ configFilePath ][ key ];
+    return mCachedCapabilities[ configFilePath ][ key ];
   }
-  else
+  else if ( mDirectory.isEmpty() )
   {
     return nullptr;
   }
+
+  // not in memory, look for a document persisted by a previous run or another process
+  locker.unlock();
+  const QDomDocument doc = readCapabilitiesDocument( configFilePath, key );
+  if ( doc.isNull() )
+    return nullptr;
+
+  locker.relock();
+  if ( !mCachedCapabilities.contains( configFilePath ) || !mCachedCapabilities[ configFilePath ].contains( key ) )
+    insertDocument( configFilePath, key, doc );
+  return mCachedCapabilities[ configFilePath ][ key ];
 }
 
 void QgsCapabilitiesCache::insertCapabilitiesDocument( const QString &configFilePath, const QString &key, const QDomDocument *doc )
+{
+  {
+    QMutexLocker locker( &mMutex );
+    insertDocument( configFilePath, key, *doc );
+  }
+
+  if ( !mDirectory.isEmpty() )
+    writeCapabilitiesDocument( configFilePath, key, *doc );
+}
+
+void QgsCapabilitiesCache::insertDocument( const QString &configFilePath, const QString &key, const QDomDocument &doc )
 {
   if ( mCachedCapabilities.size() > 40 )
   {
     //remove another cache entry to avoid memory problems
-    QHash<QString, QHash<QString, QDomDocument> >::iterator capIt = mCachedCapabilities.begin();
-    mFileSystemWatcher.removePath( capIt.key() );
+    QHash<QString, QHash<QString, std::shared_ptr<const QDomDocument> > >::iterator capIt = mCachedCapabilities.begin();
+    QMetaObject::invokeMethod( this, "unwatchPath", Qt::AutoConnection, Q_ARG( QString, capIt.key() ) );
     mCachedCapabilities.erase( capIt );
   }
 
   if ( !mCachedCapabilities.contains( configFilePath ) )
   {
-    mFileSystemWatcher.addPath( configFilePath );
-    mCachedCapabilities.insert( configFilePath, QHash<QString, QDomDocument>() );
+    QMetaObject::invokeMethod( this, "watchPath", Qt::AutoConnection, Q_ARG( QString, configFilePath ) );
+    mCachedCapabilities.insert( configFilePath, QHash<QString, std::shared_ptr<const QDomDocument> >() );
   }
 
-  mCachedCapabilities[ configFilePath ].insert( key, doc->cloneNode().toDocument() );
+  mCachedCapabilities[ configFilePath ].insert( key, std::make_shared<const QDomDocument>( doc.cloneNode().toDocument() ) );
 
 #if defined(Q_OS_LINUX)
   struct statfs sStatFS;
@@ -78,36 +112,125 @@ void QgsCapabilitiesCache::insertCapabilitiesDocument( const QString &configFile
   {
     QFileInfo fi( configFilePath );
     mCachedCapabilitiesTimestamps[ configFilePath ] = fi.lastModified();
-    mTimer.start( 1000 );
+    // timers can only be started from the thread owning them
+    QMetaObject::invokeMethod( &mTimer, "start", Qt::AutoConnection, Q_ARG( int, 1000 ) );
   }
 #endif
 }
 
 void QgsCapabilitiesCache::removeCapabilitiesDocument( const QString &path )
+{
+  QMutexLocker locker( &mMutex );
+  removeDocuments( path );
+  if ( !mDirectory.isEmpty() )
+    QDir( projectDirectory( path ) ).removeRecursively();
+}
+
+void QgsCapabilitiesCache::removeDocuments( const QString &path )
 {
   mCachedCapabilities.remove( path );
   mCachedCapabilitiesTimestamps.remove( path );
-  mFileSystemWatcher.removePath( path );
+  QMetaObject::invokeMethod( this, "unwatchPath", Qt::AutoConnection, Q_ARG( QString, path ) );
+}
+
+QString QgsCapabilitiesCache::projectDirectory( const QString &configFilePath ) const
+{
+  const QByteArray hash = QCryptographicHash::hash( configFilePath.toUtf8(), QCryptographicHash::Sha1 ).toHex();
+  return QDir( mDirectory ).filePath( QString::fromLatin1( hash ) );
+}
+
+QDomDocument QgsCapabilitiesCache::readCapabilitiesDocument( const QString &configFilePath, const QString &key ) const
+{
+  // persisted documents are only valid for the project version currently loaded
+  const QByteArray checksum = QgsConfigCache::instance()->projectChecksum( configFilePath );
+  if ( checksum.isEmpty() )
+    return QDomDocument();
+
+  const QDir directory( projectDirectory( configFilePath ) );
+  QFile stampFile( directory.filePath( QStringLiteral( "project.sha1" ) ) );
+  if ( !stampFile.open( QIODevice::ReadOnly ) || stampFile.readAll().trimmed() != checksum )
+    return QDomDocument();
+
+  const QByteArray keyHash = QCryptographicHash::hash( key.toUtf8(), QCryptographicHash::Sha1 ).toHex();
+  QFile file( directory.filePath( QString::fromLatin1( keyHash ) + QStringLiteral( ".xml" ) ) );
+  if ( !file.open( QIODevice::ReadOnly ) )
+    return QDomDocument();
+
+  QDomDocument doc;
+  if ( !doc.setContent( &file ) )
+    return QDomDocument();
+
+  QgsMessageLog::logMessage( QStringLiteral( "Capabilities document loaded from %1" ).arg( file.fileName() ), QStringLiteral( "Server" ) );
+  return doc;
+}
+
+void QgsCapabilitiesCache::writeCapabilitiesDocument( const QString &configFilePath, const QString &key, const QDomDocument &doc ) const
+{
+  const QByteArray checksum = QgsConfigCache::instance()->projectChecksum( configFilePath );
+  if ( checksum.isEmpty() )
+    return;
+
+  // replace the documents of previous project versions, files are written
+  // with QSaveFile as they may be read concurrently by other processes
+  const QDir directory( projectDirectory( configFilePath ) );
+  QFile stampFile( directory.filePath( QStringLiteral( "project.sha1" ) ) );
+  if ( !stampFile.open( QIODevice::ReadOnly ) || stampFile.readAll().trimmed() != checksum )
+  {
+    stampFile.close();
+    QDir( directory ).removeRecursively();
+    if ( !QDir().mkpath( directory.path() ) )
+      return;
+
+    QSaveFile stamp( stampFile.fileName() );
+    if ( !stamp.open( QIODevice::WriteOnly ) || stamp.write( checksum ) != checksum.size() || !stamp.commit() )
+      return;
+  }
+
+  const QByteArray keyHash = QCryptographicHash::hash( key.toUtf8(), QCryptographicHash::Sha1 ).toHex();
+  QSaveFile file( directory.filePath( QString::fromLatin1( keyHash ) + QStringLiteral( ".xml" ) ) );
+  const QByteArray content = doc.toByteArray();
+  if ( !file.open( QIODevice::WriteOnly ) || file.write( content ) != content.size() || !file.commit() )
+  {
+    QgsMessageLog::logMessage( QStringLiteral( "Cannot write capabilities document %1" ).arg( file.fileName() ), QStringLiteral( "Server" ), Qgis::Warning );
+  }
 }
 
 void QgsCapabilitiesCache::removeChangedEntry( const QString &path )
 {
   QgsDebugMsg( QStringLiteral( "Remove capabilities cache entry because file changed" ) );
-  removeCapabilitiesDocument( path );
+  // persisted documents are kept, they are checked against the project checksum when read
+  QMutexLocker locker( &mMutex );
+  removeDocuments( path );
 }
 
 void QgsCapabilitiesCache::removeOutdatedEntries()
 {
   QgsDebugMsg( QStringLiteral( "Checking for outdated entries" ) );
-  for ( const QString &configFilePath : mCachedCapabilitiesTimestamps.keys() )
+  QHash< QString, QDateTime> timestamps;
   {
-    QFileInfo fi( configFilePath );
-    if ( !fi.exists() || mCachedCapabilitiesTimestamps[ configFilePath ] < fi.lastModified() )
-      removeChangedEntry( configFilePath );
+    QMutexLocker locker( &mMutex );
+    timestamps = mCachedCapabilitiesTimestamps;
+  }
+  for ( auto it = timestamps.constBegin(); it != timestamps.constEnd(); ++it )
+  {
+    QFileInfo fi( it.key() );
+    if ( !fi.exists() || it.value() < fi.lastModified() )
+      removeChangedEntry( it.key() );
   }
 
+  QMutexLocker locker( &mMutex );
   if ( !mCachedCapabilitiesTimestamps.isEmpty() )
   {
     mTimer.start( 1000 );
   }
 }
+
+void QgsCapabilitiesCache::watchPath( const QString &path )
+{
+  mFileSystemWatcher.addPath( path );
+}
+
+void QgsCapabilitiesCache::unwatchPath( const QString &path )
+{
+  mFileSystemWatcher.removePath( path );
+}
@@ -23,26 +23,46 @@
 #include <QHash>
 #include <QObject>
 #include <QDateTime>
+#include <QMutex>
 #include <QTimer>
 
+#include <memory>
+
 #include "qgis_server.h"
+#include "qgis_sip.h"
 
 /**
  * \ingroup server
  * A cache for capabilities xml documents (by configuration file path)
+ *
+ * The cache is thread-safe and it is shared by all the worker threads
+ * handling requests concurrently.
+ *
+ * When a directory is set (see QgsServerSettings::capabilitiesCacheDirectory())
+ * the documents are also persisted on disk, along with the checksum of the
+ * project they were generated from (see QgsConfigCache::projectChecksum()). They
+ * are then loaded from disk after a server restart or a change notification for an
+ * unmodified project file, instead of being generated again.
  */
 class SERVER_EXPORT QgsCapabilitiesCache : public QObject
 {
     Q_OBJECT
   public:
-    QgsCapabilitiesCache();
+
+    /**
+     * Constructor for QgsCapabilitiesCache.
+     * \param directory directory where the documents are persisted, documents are only cached in memory if empty (since QGIS 3.16)
+     */
+    explicit QgsCapabilitiesCache( const QString &directory = QString() );
 
     /**
      * Returns cached capabilities document (or 0 if document for configuration file not in cache)
+     *
+     * The document stays valid as long as the caller keeps it, even if it is removed from the cache.
      * \param configFilePath the progect file path
      * \param key key used to separate different version in different cache
      */
-    const QDomDocument *searchCapabilitiesDocument( const QString &configFilePath, const QString &key );
+    std::shared_ptr<const QDomDocument> searchCapabilitiesDocument( const QString &configFilePath, const QString &key ) SIP_SKIP;
 
     /**
      * Inserts new capabilities document (creates a copy of the document, does not take ownership)
@@ -60,16 +80,38 @@ class SERVER_EXPORT QgsCapabilitiesCache : public QObject
     void removeCapabilitiesDocument( const QString &path );
 
   private:
-    QHash< QString, QHash< QString, QDomDocument > > mCachedCapabilities;
+
+    //! Returns the directory storing the persisted documents of the project at \a configFilePath
+    QString projectDirectory( const QString &configFilePath ) const;
+
+    //! Returns the persisted document, if it has been generated from the currently loaded project
+    QDomDocument readCapabilitiesDocument( const QString &configFilePath, const QString &key ) const;
+
+    //! Persists \a doc for the currently loaded project
+    void writeCapabilitiesDocument( const QString &configFilePath, const QString &key, const QDomDocument &doc ) const;
+
+    //! Adds a copy of \a doc to the memory cache, the mutex must be locked
+    void insertDocument( const QString &configFilePath, const QString &key, const QDomDocument &doc );
+
+    //! Removes the documents of the project from memory, the mutex must be locked
+    void removeDocuments( const QString &path );
+
+    QString mDirectory;
+    QHash< QString, QHash< QString, std::shared_ptr<const QDomDocument> > > mCachedCapabilities;
     QHash< QString, QDateTime> mCachedCapabilitiesTimestamps;
     QFileSystemWatcher mFileSystemWatcher;
     QTimer mTimer;
+    QMutex mMutex;
 
   private slots:
     //! Removes changed entry from this cache
     void removeChangedEntry( const QString &path );
     //! Remove outdated enties
     void removeOutdatedEntries();
+    //! Adds \a path to the file system watcher, from the thread owning the watcher
+    void watchPath( const QString &path );
+    //! Removes \a path from the file system watcher, from the thread owning the watcher
+    void unwatchPath( const QString &path );
 };
 
 #endif // QGSCAPABILITIESCACHE_H
@@ -16,11 +16,20 @@
  ***************************************************************************/
 
 #include "qgsconfigcache.h"
+#include "qgsconnectionpool.h"
+#include "qgscoordinatetransform.h"
+#include "qgsdataprovider.h"
+#include "qgsfeatureiterator.h"
 #include "qgsmessagelog.h"
 #include "qgsserverexception.h"
+#include "qgsserverfeaturecountcache.h"
+#include "qgsserverprojectlocker.h"
 #include "qgsstorebadlayerinfo.h"
 #include "qgsserverprojectutils.h"
+#include "qgssymbollayerutils.h"
+#include "qgsvectorlayer.h"
 
+#include <QCryptographicHash>
 #include <QFile>
 
 QgsConfigCache *QgsConfigCache::instance()
@@ -39,81 +48,280 @@ QgsConfigCache::QgsConfigCache()
 }
 
 
-const QgsProject *QgsConfigCache::project( const QString &path, QgsServerSettings *settings )
+std::shared_ptr<const QgsProject> QgsConfigCache::project( const QString &path, QgsServerSettings *settings )
 {
-  if ( ! mProjectCache[ path ] )
+  QMutexLocker locker( &mMutex );
+
+  // a single worker reads a project, the others wait for it to be cached
+  while ( mLoadingProjects.contains( path ) )
+    mProjectLoaded.wait( &mMutex );
+
+  if ( std::shared_ptr<QgsProject> *cachedProject = mProjectCache.object( path ) )
+    return *cachedProject;
+
+  mLoadingProjects.insert( path );
+  locker.unlock();
+
+  std::shared_ptr<QgsProject> project;
+  QList<QgsMapLayer *> unresolvedLayers;
+  try
   {
-    std::unique_ptr<QgsProject> prj( new QgsProject() );
+    project = readProject( path, settings, unresolvedLayers );
+  }
+  catch ( ... )
+  {
+    locker.relock();
+    mLoadingProjects.remove( path );
+    mProjectLoaded.wakeAll();
+    throw;
+  }
 
-    QgsStoreBadLayerInfo *badLayerHandler = new QgsStoreBadLayerInfo();
-    prj->setBadLayerHandler( badLayerHandler );
+  const QByteArray checksum = project ? fileChecksum( path ) : QByteArray();
 
-    QgsProject::ReadFlags readFlags = QgsProject::ReadFlag();
-    if ( settings )
+  locker.relock();
+  if ( project )
+  {
+    for ( QgsMapLayer *layer : qgis::as_const( unresolvedLayers ) )
+      mUnresolvedLayers.insert( layer, path );
+    mProjectCache.insert( path, new std::shared_ptr<QgsProject>( project ) );
+    mProjectChecksums.insert( path, checksum );
+    // file system watcher must be used from its own thread
+    QMetaObject::invokeMethod( this, "watchPath", Qt::AutoConnection, Q_ARG( QString, path ) );
+  }
+  mLoadingProjects.remove( path );
+  mProjectLoaded.wakeAll();
+  return project;
+}
+
+std::shared_ptr<QgsProject> QgsConfigCache::readProject( const QString &path, QgsServerSettings *settings, QList<QgsMapLayer *> &unresolvedLayers )
+{
+  std::unique_ptr<QgsProject> prj( new QgsProject() );
+
+  QgsStoreBadLayerInfo *badLayerHandler = new QgsStoreBadLayerInfo();
+  prj->setBadLayerHandler( badLayerHandler );
+
+  QgsProject::ReadFlags readFlags = QgsProject::ReadFlag();
+  if ( settings )
+  {
+    // Activate trust layer metadata flag
+    if ( settings->trustLayerMetadata() )
     {
-      // Activate trust layer metadata flag
-      if ( settings->trustLayerMetadata() )
-      {
-        readFlags |= QgsProject::ReadFlag::FlagTrustLayerMetadata;
-      }
-      // Activate don't load layouts flag
-      if ( settings->getPrintDisabled() )
-      {
-        readFlags |= QgsProject::ReadFlag::FlagDontLoadLayouts;
-      }
+      readFlags |= QgsProject::ReadFlag::FlagTrustLayerMetadata;
+    }
+    // Activate don't load layouts flag
+    if ( settings->getPrintDisabled() )
+    {
+      readFlags |= QgsProject::ReadFlag::FlagDontLoadLayouts;
+    }
+    // Activate lazy layer loading, the stored layer metadata is trusted until
+    // the layers are loaded by resolveLayers()
+    if ( settings->lazyLayerLoading() )
+    {
+      readFlags |= QgsProject::ReadFlag::FlagDontResolveLayers;
+      readFlags |= QgsProject::ReadFlag::FlagTrustLayerMetadata;
+    }
+    if ( settings->readLayersInParallel() )
+    {
+      readFlags |= QgsProject::ReadFlag::FlagReadLayersInParallel;
     }
+  }
 
-    if ( prj->read( path, readFlags ) )
+  if ( prj->read( path, readFlags ) )
+  {
+    if ( !badLayerHandler->badLayers().isEmpty() )
     {
-      if ( !badLayerHandler->badLayers().isEmpty() )
+      // if bad layers are not restricted layers so service failed
+      QStringList unrestrictedBadLayers;
+      // test bad layers through restrictedlayers
+      const QStringList badLayerIds = badLayerHandler->badLayers();
+      const QMap<QString, QString> badLayerNames = badLayerHandler->badLayerNames();
+      const QStringList resctrictedLayers = QgsServerProjectUtils::wmsRestrictedLayers( *prj );
+      for ( const QString &badLayerId : badLayerIds )
       {
-        // if bad layers are not restricted layers so service failed
-        QStringList unrestrictedBadLayers;
-        // test bad layers through restrictedlayers
-        const QStringList badLayerIds = badLayerHandler->badLayers();
-        const QMap<QString, QString> badLayerNames = badLayerHandler->badLayerNames();
-        const QStringList resctrictedLayers = QgsServerProjectUtils::wmsRestrictedLayers( *prj );
-        for ( const QString &badLayerId : badLayerIds )
+        // if this bad layer is in restricted layers
+        // it doesn't need to be added to unrestricted bad layers
+        if ( badLayerNames.contains( badLayerId ) &&
+             resctrictedLayers.contains( badLayerNames.value( badLayerId ) ) )
         {
-          // if this bad layer is in restricted layers
-          // it doesn't need to be added to unrestricted bad layers
-          if ( badLayerNames.contains( badLayerId ) &&
-               resctrictedLayers.contains( badLayerNames.value( badLayerId ) ) )
-          {
-            continue;
-          }
-          unrestrictedBadLayers.append( badLayerId );
+          continue;
         }
-        if ( !unrestrictedBadLayers.isEmpty() )
+        unrestrictedBadLayers.append( badLayerId );
+      }
+      if ( !unrestrictedBadLayers.isEmpty() )
+      {
+        // This is a critical error unless QGIS_SERVER_IGNORE_BAD_LAYERS is set to TRUE
+        if ( ! settings || ! settings->ignoreBadLayers() )
         {
-          // This is a critical error unless QGIS_SERVER_IGNORE_BAD_LAYERS is set to TRUE
-          if ( ! settings || ! settings->ignoreBadLayers() )
-          {
-            QgsMessageLog::logMessage(
-              QStringLiteral( "Error, Layer(s) %1 not valid in project %2" ).arg( unrestrictedBadLayers.join( QStringLiteral( ", " ) ), path ),
-              QStringLiteral( "Server" ), Qgis::Critical );
-            throw QgsServerException( QStringLiteral( "Layer(s) not valid" ) );
-          }
-          else
-          {
-            QgsMessageLog::logMessage(
-              QStringLiteral( "Warning, Layer(s) %1 not valid in project %2" ).arg( unrestrictedBadLayers.join( QStringLiteral( ", " ) ), path ),
-              QStringLiteral( "Server" ), Qgis::Warning );
-          }
+          QgsMessageLog::logMessage(
+            QStringLiteral( "Error, Layer(s) %1 not valid in project %2" ).arg( unrestrictedBadLayers.join( QStringLiteral( ", " ) ), path ),
+            QStringLiteral( "Server" ), Qgis::Critical );
+          throw QgsServerException( QStringLiteral( "Layer(s) not valid" ) );
+        }
+        else
+        {
+          QgsMessageLog::logMessage(
+            QStringLiteral( "Warning, Layer(s) %1 not valid in project %2" ).arg( unrestrictedBadLayers.join( QStringLiteral( ", " ) ), path ),
+            QStringLiteral( "Server" ), Qgis::Warning );
         }
       }
-      mProjectCache.insert( path, prj.release() );
-      mFileSystemWatcher.addPath( path );
     }
-    else
+    const QMap<QString, QgsMapLayer *> layers = prj->mapLayers();
+    for ( QgsMapLayer *layer : layers )
+    {
+      if ( !( readFlags & QgsProject::ReadFlag::FlagDontResolveLayers ) )
+        warmupConnections( layer );
+      else if ( !layer->isValid() )
+        unresolvedLayers << layer;
+    }
+    if ( settings && settings->prewarmImageCaches() )
     {
-      QgsMessageLog::logMessage(
-        QStringLiteral( "Error when loading project file '%1': %2 " ).arg( path, prj->error() ),
-        QStringLiteral( "Server" ), Qgis::Critical );
+      // WMS renders use the resolution of the OGC standard pixel size (0.28 mm), rounded by the images
+      QgsSymbolLayerUtils::prewarmImageCaches( prj.get(), qRound( 0.0254 / 0.00028 ), true );
     }
+    if ( settings && settings->prewarmCoordinateTransforms() )
+    {
+      prewarmCoordinateTransforms( *prj );
+    }
+    return std::shared_ptr<QgsProject>( prj.release() );
+  }
+  else
+  {
+    QgsMessageLog::logMessage(
+      QStringLiteral( "Error when loading project file '%1': %2 " ).arg( path, prj->error() ),
+      QStringLiteral( "Server" ), Qgis::Critical );
+    return nullptr;
   }
-  return mProjectCache[ path ];
+}
+
+void QgsConfigCache::resolveLayers( const QList<QgsMapLayer *> &layers )
+{
+  QMutexLocker resolveLocker( &mResolveMutex );
+
+  QStringList invalidLayers;
+  for ( QgsMapLayer *layer : layers )
+  {
+    // keeps the project alive while its layer is loaded, it may be evicted from the cache meanwhile
+    std::shared_ptr<QgsProject> project;
+    {
+      QMutexLocker locker( &mMutex );
+      if ( !layer || !mUnresolvedLayers.contains( layer ) )
+        continue;
+      // the project may have been evicted from the cache, together with its layers
+      const std::shared_ptr<QgsProject> *cachedProject = mProjectCache.object( mUnresolvedLayers.value( layer ) );
+      if ( !cachedProject || ( *cachedProject )->mapLayer( layer->id() ) != layer )
+      {
+        mUnresolvedLayers.remove( layer );
+        continue;
+      }
+      project = *cachedProject;
+    }
+
+    {
+      // the layer is shared by the requests handled by the other worker threads
+      const QgsServerProjectLocker projectLocker( project.get(), QgsServerProjectLocker::Exclusive );
+
+      if ( !layer->isValid() )
+      {
+        QgsDataProvider::ProviderOptions options { project->transformContext() };
+        layer->setDataSource( layer->source(), layer->name(), layer->providerType(), options, false );
+      }
+
+      if ( !layer->isValid() )
+      {
+        // the layer stays unresolved, the next requests using it fail as well
+        invalidLayers << layer->name();
+        continue;
+      }
+
+      // the provider is created by the worker thread, hand it over to the thread owning the layer
+      if ( layer->dataProvider() && layer->dataProvider()->thread() != layer->thread() )
+        layer->dataProvider()->moveToThread( layer->thread() );
+    }
 
+    {
+      QMutexLocker locker( &mMutex );
+      mUnresolvedLayers.remove( layer );
+    }
+
+    warmupConnections( layer );
+  }
+
+  if ( !invalidLayers.isEmpty() )
+  {
+    QgsMessageLog::logMessage(
+      QStringLiteral( "Error, Layer(s) %1 not valid" ).arg( invalidLayers.join( QStringLiteral( ", " ) ) ),
+      QStringLiteral( "Server" ), Qgis::Critical );
+    throw QgsServerException( QStringLiteral( "Layer(s) not valid" ) );
+  }
+}
+
+void QgsConfigCache::warmupConnections( QgsMapLayer *layer )
+{
+  if ( QgsConnectionPoolMonitor::minimumConnections() <= 0 )
+    return;
+
+  QgsVectorLayer *vectorLayer = qobject_cast<QgsVectorLayer *>( layer );
+  if ( !vectorLayer || !vectorLayer->isValid() )
+    return;
+
+  // the connection pool of the provider opens its minimum number of connections
+  // when the first connection is acquired, no feature needs to be fetched
+  QgsFeatureIterator it = vectorLayer->getFeatures( QgsFeatureRequest()
+                          .setNoAttributes()
+                          .setFlags( QgsFeatureRequest::NoGeometry )
+                          .setLimit( 1 ) );
+  it.close();
+}
+
+void QgsConfigCache::prewarmCoordinateTransforms( const QgsProject &project )
+{
+  QList<QgsCoordinateReferenceSystem> layerCrsList;
+  const QMap<QString, QgsMapLayer *> layers = project.mapLayers();
+  for ( QgsMapLayer *layer : layers )
+  {
+    if ( layer->crs().isValid() && !layerCrsList.contains( layer->crs() ) )
+      layerCrsList << layer->crs();
+  }
+
+  QList<QgsCoordinateReferenceSystem> destinationCrsList;
+  if ( project.crs().isValid() )
+    destinationCrsList << project.crs();
+  const QStringList outputCrsList = QgsServerProjectUtils::wmsOutputCrsList( project );
+  for ( const QString &authid : outputCrsList )
+  {
+    const QgsCoordinateReferenceSystem crs = QgsCoordinateReferenceSystem::fromOgcWmsCrs( authid );
+    if ( crs.isValid() && !destinationCrsList.contains( crs ) )
+      destinationCrsList << crs;
+  }
+
+  // the transforms are created in the current thread, whose proj objects live as long as the server,
+  // the proj objects of the other threads are then cloned from them
+  for ( const QgsCoordinateReferenceSystem &layerCrs : qgis::as_const( layerCrsList ) )
+  {
+    for ( const QgsCoordinateReferenceSystem &destinationCrs : qgis::as_const( destinationCrsList ) )
+    {
+      if ( layerCrs != destinationCrs )
+        const QgsCoordinateTransform transform( layerCrs, destinationCrs, project.transformContext() );
+    }
+  }
+}
+
+QByteArray QgsConfigCache::projectChecksum( const QString &path ) const
+{
+  QMutexLocker locker( &mMutex );
+  return mProjectCache.contains( path ) ? mProjectChecksums.value( path ) : QByteArray();
+}
+
+QByteArray QgsConfigCache::fileChecksum( const QString &path )
+{
+  QFile file( path );
+  if ( !file.open( QIODevice::ReadOnly ) )
+    return QByteArray();
+
+  QCryptographicHash hash( QCryptographicHash::Sha1 );
+  if ( !hash.addData( &file ) )
+    return QByteArray();
+  return hash.result().toHex();
 }
 
 QDomDocument *QgsConfigCache::xmlDocument( const QString &filePath )
@@ -148,7 +356,7 @@ QDomDocument *QgsConfigCache::xmlDocument( const QString &filePath )
       return nullptr;
     }
     mXmlDocumentCache.insert( filePath, xmlDoc );
-    mFileSystemWatcher.addPath( filePath );
+    QMetaObject::invokeMethod( this, "watchPath", Qt::AutoConnection, Q_ARG( QString, filePath ) );
     xmlDoc = mXmlDocumentCache.object( filePath );
     Q_ASSERT( xmlDoc );
   }
@@ -157,16 +365,58 @@ QDomDocument *QgsConfigCache::xmlDocument( const QString &filePath )
 
 void QgsConfigCache::removeChangedEntry( const QString &path )
 {
-  mProjectCache.remove( path );
-
-  //xml document must be removed last, as other config cache destructors may require it
-  mXmlDocumentCache.remove( path );
+  // Deployments often rewrite the project files without changing them, do not
+  // reload such projects. The file may have been replaced, so watch it again.
+  QByteArray checksum;
+  {
+    QMutexLocker locker( &mMutex );
+    checksum = mProjectChecksums.value( path );
+  }
+  if ( !checksum.isEmpty() && fileChecksum( path ) == checksum )
+  {
+    QMetaObject::invokeMethod( this, "watchPath", Qt::AutoConnection, Q_ARG( QString, path ) );
+    return;
+  }
 
-  mFileSystemWatcher.removePath( path );
+  removeEntry( path );
 }
 
 
 void QgsConfigCache::removeEntry( const QString &path )
 {
-  removeChangedEntry( path );
+  {
+    QMutexLocker locker( &mMutex );
+
+    if ( const std::shared_ptr<QgsProject> *project = mProjectCache.object( path ) )
+    {
+      // the project is deleted once the requests using it are finished
+      const QMap<QString, QgsMapLayer *> layers = ( *project )->mapLayers();
+      for ( QgsMapLayer *layer : layers )
+      {
+        mUnresolvedLayers.remove( layer );
+        // the project may have been changed because the data changed
+        QgsServerFeatureCountCache::instance()->invalidate( layer );
+      }
+    }
+    mProjectCache.remove( path );
+    mProjectChecksums.remove( path );
+
+    //xml document must be removed last, as other config cache destructors may require it
+    mXmlDocumentCache.remove( path );
+
+    QMetaObject::invokeMethod( this, "unwatchPath", Qt::AutoConnection, Q_ARG( QString, path ) );
+  }
+
+  emit projectRemovedFromCache( path );
+}
+
+
+void QgsConfigCache::watchPath( const QString &path )
+{
+  mFileSystemWatcher.addPath( path );
+}
+
+void QgsConfigCache::unwatchPath( const QString &path )
+{
+  mFileSystemWatcher.removePath( path );
 }
@@ -21,9 +21,15 @@
 #include "qgsconfig.h"
 
 #include <QCache>
+#include <QHash>
 #include <QFileSystemWatcher>
 #include <QObject>
 #include <QDomDocument>
+#include <QMutex>
+#include <QSet>
+#include <QWaitCondition>
+
+#include <memory>
 
 #include "qgis_server.h"
 #include "qgis_sip.h"
@@ -33,6 +39,11 @@
 /**
  * \ingroup server
  * \brief Cache for server configuration.
+ *
+ * The cache is thread-safe: it may be shared by the worker threads
+ * handling requests concurrently (see QgsServerSettings::workerThreads()).
+ * Cached projects must be considered read-only.
+ *
  * \since QGIS 2.8
  */
 class SERVER_EXPORT QgsConfigCache : public QObject
@@ -58,12 +69,66 @@ class SERVER_EXPORT QgsConfigCache : public QObject
      * unless the server configuration variable QGIS_SERVER_IGNORE_BAD_LAYERS
      * passed in the optional settings argument is set to TRUE (the default
      * value is FALSE).
+     *
+     * The project is read without locking the cache, the workers asking for a
+     * project which is being read wait for it. The returned project stays alive
+     * as long as the caller keeps it, even if it is removed from the cache meanwhile.
      * \param path the filename of the QGIS project
      * \param settings QGIS server settings
      * \returns the project or NULLPTR if an error happened
      * \since QGIS 3.0
      */
-    const QgsProject *project( const QString &path, QgsServerSettings *settings = nullptr );
+    std::shared_ptr<const QgsProject> project( const QString &path, QgsServerSettings *settings = nullptr ) SIP_SKIP;
+
+    /**
+     * Loads the data providers of the \a layers which have been read without their data
+     * source because of the lazy layer loading (see QgsServerSettings::lazyLayerLoading()).
+     *
+     * The styles read from the project are kept. Layers which are already loaded are left
+     * untouched, so this is cheap to call for all the layers a request needs. It may be
+     * called concurrently by several worker threads: the project of a layer is locked
+     * exclusively while its provider is loaded (see QgsServerProjectLocker), so the caller
+     * must not hold a shared lock on it.
+     *
+     * A layer which cannot be loaded stays unresolved, each request using it fails.
+     *
+     * \throws QgsServerException if a layer cannot be loaded
+     * \since QGIS 3.16
+     */
+    void resolveLayers( const QList<QgsMapLayer *> &layers ) SIP_THROW( QgsServerException );
+
+    /**
+     * Returns the checksum of the file content of the cached project with the given
+     * \a path, as it was when the project was read, or an empty array if the project
+     * is not cached or is not stored in a file.
+     *
+     * The checksum identifies the project version, e.g. for caches persisted
+     * across server restarts (see QgsServerSettings::capabilitiesCacheDirectory()).
+     *
+     * \since QGIS 3.16
+     */
+    QByteArray projectChecksum( const QString &path ) const;
+
+    /**
+     * Returns the checksum of the content of the file at \a path, or an empty
+     * array if the file cannot be read.
+     *
+     * \since QGIS 3.16
+     */
+    static QByteArray fileChecksum( const QString &path );
+
+  signals:
+
+    /**
+     * Emitted when the project with the given \a path is removed from the cache,
+     * either because the project file changed or because the entry was explicitly removed.
+     *
+     * Caches depending on the project content (e.g. rendered tiles) should be
+     * invalidated when this signal is emitted.
+     *
+     * \since QGIS 3.16
+     */
+    void projectRemovedFromCache( const QString &path );
 
   private:
     QgsConfigCache() SIP_FORCE;
@@ -71,15 +136,62 @@ class SERVER_EXPORT QgsConfigCache : public QObject
     //! Check for configuration file updates (remove entry from cache if file changes)
     QFileSystemWatcher mFileSystemWatcher;
 
+    /**
+     * Reads the project at \a path, the layers which are not loaded yet because of the
+     * lazy layer loading are appended to \a unresolvedLayers.
+     * \returns the project or NULLPTR if an error happened
+     * \throws QgsServerException if the project contains bad layers
+     */
+    static std::shared_ptr<QgsProject> readProject( const QString &path, QgsServerSettings *settings, QList<QgsMapLayer *> &unresolvedLayers );
+
     //! Returns xml document for project file / sld or 0 in case of errors
     QDomDocument *xmlDocument( const QString &filePath );
 
+    /**
+     * Opens the minimum number of pooled connections of the data source of \a layer
+     * (see QgsServerSettings::connectionPoolMinimumSize()), by creating its first
+     * feature iterator.
+     */
+    static void warmupConnections( QgsMapLayer *layer );
+
+    /**
+     * Creates the coordinate transforms from the CRSs of the layers of \a project to
+     * the CRS of the project and to the WMS output CRSs, so that they are found in
+     * the cache of the coordinate transforms by the requests.
+     */
+    static void prewarmCoordinateTransforms( const QgsProject &project );
+
     QCache<QString, QDomDocument> mXmlDocumentCache;
-    QCache<QString, QgsProject> mProjectCache;
+    //! Cached projects, shared with the requests using them
+    QCache<QString, std::shared_ptr<QgsProject> > mProjectCache;
+
+    //! Paths of the projects being read
+    QSet<QString> mLoadingProjects;
+
+    //! Notified when a project has been read
+    QWaitCondition mProjectLoaded;
+
+    //! Checksums of the project files, as they were when the cached projects were read
+    QHash<QString, QByteArray> mProjectChecksums;
+
+    //! Layers of the cached projects which have not been loaded yet, with their project path
+    QHash<QgsMapLayer *, QString> mUnresolvedLayers;
+
+    //! Protects the caches when requests are handled by worker threads
+    mutable QMutex mMutex;
+
+    //! Serializes the loading of unresolved layers
+    QMutex mResolveMutex;
 
   private slots:
-    //! Removes changed entry from this cache
+    //! Removes changed entry from this cache, unless the file content is unchanged
     void removeChangedEntry( const QString &path );
+
+    //! Adds \a path to the file system watcher, from the thread owning the watcher
+    void watchPath( const QString &path );
+
+    //! Removes \a path from the file system watcher, from the thread owning the watcher
+    void unwatchPath( const QString &path );
 };
 
 #endif // QGSCONFIGCACHE_H
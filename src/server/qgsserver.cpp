@@ -23,26 +23,34 @@
 #include "qgsserver.h"
 #include "qgsauthmanager.h"
 #include "qgscapabilitiescache.h"
+#include "qgsconnectionpool.h"
 #include "qgsfontutils.h"
+#include "qgshotpathinstrumentation.h"
+#include "qgsimagecache.h"
 #include "qgsrequesthandler.h"
 #include "qgsproject.h"
 #include "qgsproviderregistry.h"
 #include "qgslogger.h"
 #include "qgsmapserviceexception.h"
 #include "qgsnetworkaccessmanager.h"
+#include "qgsserverfeaturecountcache.h"
 #include "qgsserverlogger.h"
+#include "qgsservermetrics.h"
 #include "qgsserverrequest.h"
+#include "qgssvgcache.h"
 #include "qgsfilterresponsedecorator.h"
 #include "qgsservice.h"
 #include "qgsserverapi.h"
 #include "qgsserverapicontext.h"
 #include "qgsserverparameters.h"
 #include "qgsapplication.h"
+#include "qgsruntimeprofiler.h"
 
 #include <QDomDocument>
 #include <QNetworkDiskCache>
 #include <QSettings>
 #include <QElapsedTimer>
+#include <QThread>
 
 // TODO: remove, it's only needed by a single debug message
 #include <fcgi_stdio.h>
@@ -261,7 +269,20 @@ bool QgsServer::init()
   sConfigFilePath = new QString( defaultConfigFilePath );
 
   //create cache for capabilities XML
-  sCapabilitiesCache = new QgsCapabilitiesCache();
+  sCapabilitiesCache = new QgsCapabilitiesCache( sSettings()->capabilitiesCacheDirectory() );
+
+  // feature counts and extents, shared by the services
+  QgsServerFeatureCountCache::instance()->setTimeToLive( sSettings()->featureCountCacheTimeToLive() );
+
+  // connections opened in advance by the connection pools of the providers
+  QgsConnectionPoolMonitor::setMinimumConnections( sSettings()->connectionPoolMinimumSize() );
+
+  // rendered SVG and raster images of the symbols
+  if ( sSettings()->imageCacheSize() > 0 )
+  {
+    QgsApplication::svgCache()->setMaxCacheSize( static_cast< long >( sSettings()->imageCacheSize() ) );
+    QgsApplication::imageCache()->setMaxCacheSize( static_cast< long >( sSettings()->imageCacheSize() ) );
+  }
 
   QgsFontUtils::loadStandardTestFonts( QStringList() << QStringLiteral( "Roman" ) << QStringLiteral( "Bold" ) );
 
@@ -297,15 +318,27 @@ void QgsServer::putenv( const QString &var, const QString &val )
 void QgsServer::handleRequest( QgsServerRequest &request, QgsServerResponse &response, const QgsProject *project )
 {
   Qgis::MessageLevel logLevel = QgsServerLogger::instance()->logLevel();
-  QElapsedTimer time; //used for measuring request time if loglevel < 1
+  QElapsedTimer time; //used for measuring request time
 
-  qApp->processEvents();
+  // Requests may be handled by worker threads (see QGIS_SERVER_WORKER_THREADS),
+  // the main event loop and the global project instance belong to the main thread
+  const bool isMainThread = QThread::currentThread() == qApp->thread();
 
-  if ( logLevel == Qgis::Info )
+  if ( isMainThread )
   {
-    time.start();
+    qApp->processEvents();
   }
 
+  time.start();
+
+  // counters of the hot paths during the request, in instrumented builds
+  QgsHotPathInstrumentation::Scope instrumentationScope( QStringLiteral( "Server request" ) );
+
+  // phases of the request are profiled in the server group of the thread profiler
+  QgsServerMetrics::clearRequestTimings();
+  QString serviceName;
+  QString requestName;
+
   response.clear();
 
   // Pass the filters to the requestHandler, this is needed for the following reasons:
@@ -356,6 +389,10 @@ void QgsServer::handleRequest( QgsServerRequest &request, QgsServerResponse &res
     QgsMessageLog::logMessage( ex.what(), QStringLiteral( "Server" ), Qgis::Critical );
   }
 
+  // The cached project is kept alive until the request is handled, even if it is
+  // removed from the cache meanwhile
+  std::shared_ptr<const QgsProject> cachedProject;
+
   // Plugins may have set exceptions
   if ( !requestHandler.exceptionRaised() )
   {
@@ -363,6 +400,8 @@ void QgsServer::handleRequest( QgsServerRequest &request, QgsServerResponse &res
     {
       const QgsServerParameters params = request.serverParameters();
       printRequestParameters( params.toMap(), logLevel );
+      serviceName = params.service();
+      requestName = params.request();
 
       // Setup project (config file path)
       if ( ! project )
@@ -370,11 +409,16 @@ void QgsServer::handleRequest( QgsServerRequest &request, QgsServerResponse &res
         QString configFilePath = configPath( *sConfigFilePath, params.map() );
 
         // load the project if needed and not empty
-        project = mConfigCache->project( configFilePath, sServerInterface->serverSettings() );
+        QgsScopedRuntimeProfile profile( QStringLiteral( "project" ), QgsServerMetrics::profilerGroup() );
+        cachedProject = mConfigCache->project( configFilePath, sServerInterface->serverSettings() );
+        project = cachedProject.get();
       }
 
       // Set the current project instance
-      QgsProject::setInstance( const_cast<QgsProject *>( project ) );
+      if ( isMainThread )
+      {
+        QgsProject::setInstance( const_cast<QgsProject *>( project ) );
+      }
 
       if ( project )
       {
@@ -386,6 +430,8 @@ void QgsServer::handleRequest( QgsServerRequest &request, QgsServerResponse &res
       QgsServerApi *api = nullptr;
       if ( params.service().isEmpty() && ( api = sServiceRegistry->apiForRequest( request ) ) )
       {
+        serviceName = QStringLiteral( "API" );
+        requestName = api->name();
         QgsServerApiContext context { api->rootPath(), &request, &responseDecorator, project, sServerInterface };
         api->executeRequest( context );
       }
@@ -431,8 +477,17 @@ void QgsServer::handleRequest( QgsServerRequest &request, QgsServerResponse &res
     }
   }
 
+  // Phases which are finished before the response is sent
+  QList<QgsServerMetrics::Timing> timings = QgsServerMetrics::requestTimings();
+  if ( sServerInterface->serverSettings()->serverTimingHeader() && !response.headersSent() )
+  {
+    response.setHeader( QStringLiteral( "Server-Timing" ), QgsServerMetrics::serverTimingHeader( timings, time.nsecsElapsed() / 1e9 ) );
+  }
+
   // Terminate the response
   // This may also throw exceptions if there are errors in python plugins code
+  QElapsedTimer responseTime;
+  responseTime.start();
   try
   {
     responseDecorator.finish();
@@ -449,6 +504,9 @@ void QgsServer::handleRequest( QgsServerRequest &request, QgsServerResponse &res
   // to a deleted request handler from Python bindings
   sServerInterface->clearRequestHandler();
 
+  timings << QgsServerMetrics::Timing( QStringLiteral( "response" ), responseTime.nsecsElapsed() / 1e9 );
+  QgsServerMetrics::instance()->record( serviceName, requestName, timings, time.nsecsElapsed() / 1e9 );
+
   if ( logLevel == Qgis::Info )
   {
     QgsMessageLog::logMessage( "Request finished in " + QString::number( time.elapsed() ) + " ms", QStringLiteral( "Server" ), Qgis::Info );
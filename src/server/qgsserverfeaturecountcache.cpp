@@ -0,0 +1,234 @@
+/***************************************************************************
+                              qgsserverfeaturecountcache.cpp
+                              ------------------------------
+  begin                : October 2020
+  copyright            : (C) 2020 by the QGIS project
+  email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsserverfeaturecountcache.h"
+#include "qgscoordinatereferencesystem.h"
+#include "qgsexpression.h"
+#include "qgsfeatureiterator.h"
+#include "qgsproviderregistry.h"
+#include "qgsvectorlayer.h"
+
+#include <QDateTime>
+#include <QMutexLocker>
+
+#include <algorithm>
+
+QgsServerFeatureCountCache *QgsServerFeatureCountCache::instance()
+{
+  static QgsServerFeatureCountCache sInstance;
+  return &sInstance;
+}
+
+void QgsServerFeatureCountCache::setTimeToLive( int seconds )
+{
+  QMutexLocker locker( &mMutex );
+  mTimeToLive = std::max( 0, seconds );
+  if ( mTimeToLive == 0 )
+    mEntries.clear();
+}
+
+int QgsServerFeatureCountCache::timeToLive() const
+{
+  QMutexLocker locker( &mMutex );
+  return mTimeToLive;
+}
+
+long long QgsServerFeatureCountCache::featureCount( const QgsVectorLayer *layer, const QgsFeatureRequest &request )
+{
+  if ( !layer )
+    return 0;
+
+  const QString key = countKey( layer, request );
+  {
+    QMutexLocker locker( &mMutex );
+    if ( const Entry *entry = validEntry( key ) )
+      return entry->count;
+  }
+
+  // counted without the lock, concurrent requests may count the same features twice
+  long long count = 0;
+  const bool filtered = request.filterType() != QgsFeatureRequest::FilterNone || !request.filterRect().isNull();
+  if ( !filtered )
+  {
+    count = layer->featureCount();
+  }
+  else
+  {
+    QgsFeatureRequest countRequest( request );
+    if ( request.filterType() != QgsFeatureRequest::FilterExpression )
+    {
+      countRequest.setNoAttributes();
+    }
+    countRequest.setFlags( countRequest.flags() | QgsFeatureRequest::Flag::NoGeometry );
+    countRequest.setLimit( -1 );
+    countRequest.setOrderBy( QgsFeatureRequest::OrderBy() );
+
+    QgsFeatureIterator features = layer->getFeatures( countRequest );
+    QgsFeature feature;
+    while ( features.nextFeature( feature ) )
+    {
+      ++count;
+    }
+  }
+
+  QMutexLocker locker( &mMutex );
+  Entry entry;
+  entry.count = count;
+  insertEntry( key, entry );
+  return count;
+}
+
+bool QgsServerFeatureCountCache::cachedFeatureCount( const QgsVectorLayer *layer, const QgsFeatureRequest &request, long long &count ) const
+{
+  if ( !layer )
+    return false;
+
+  const QString key = countKey( layer, request );
+  QMutexLocker locker( &mMutex );
+  if ( const Entry *entry = validEntry( key ) )
+  {
+    count = entry->count;
+    return true;
+  }
+  return false;
+}
+
+QgsRectangle QgsServerFeatureCountCache::extent( const QgsMapLayer *layer )
+{
+  if ( !layer )
+    return QgsRectangle();
+
+  const QString key = extentKey( layer );
+  {
+    QMutexLocker locker( &mMutex );
+    if ( const Entry *entry = validEntry( key ) )
+      return entry->extent;
+  }
+
+  const QgsRectangle extent = layer->extent();
+
+  QMutexLocker locker( &mMutex );
+  Entry entry;
+  entry.extent = extent;
+  insertEntry( key, entry );
+  return extent;
+}
+
+void QgsServerFeatureCountCache::invalidate( const QgsMapLayer *layer )
+{
+  if ( !layer )
+    return;
+
+  const QString prefix = sourceKey( layer );
+  QMutexLocker locker( &mMutex );
+  for ( auto it = mEntries.begin(); it != mEntries.end(); )
+  {
+    if ( it.key().startsWith( prefix ) )
+      it = mEntries.erase( it );
+    else
+      ++it;
+  }
+}
+
+void QgsServerFeatureCountCache::clear()
+{
+  QMutexLocker locker( &mMutex );
+  mEntries.clear();
+}
+
+QString QgsServerFeatureCountCache::sourceKey( const QgsMapLayer *layer )
+{
+  // some providers store the subset string in the source, which must not tell the data sources apart
+  QString source = layer->source();
+  QVariantMap parts = QgsProviderRegistry::instance()->decodeUri( layer->providerType(), source );
+  if ( parts.remove( QStringLiteral( "subset" ) ) + parts.remove( QStringLiteral( "sql" ) ) > 0 )
+    source = QgsProviderRegistry::instance()->encodeUri( layer->providerType(), parts );
+  return QStringLiteral( "%1\n%2\n" ).arg( layer->providerType(), source );
+}
+
+QString QgsServerFeatureCountCache::countKey( const QgsVectorLayer *layer, const QgsFeatureRequest &request )
+{
+  QString filter;
+  switch ( request.filterType() )
+  {
+    case QgsFeatureRequest::FilterNone:
+      break;
+
+    case QgsFeatureRequest::FilterFid:
+      filter = QStringLiteral( "fid:%1" ).arg( request.filterFid() );
+      break;
+
+    case QgsFeatureRequest::FilterExpression:
+      filter = QStringLiteral( "expression:%1" ).arg( request.filterExpression() ? request.filterExpression()->expression() : QString() );
+      break;
+
+    case QgsFeatureRequest::FilterFids:
+    {
+      QStringList fids;
+      const QgsFeatureIds ids = request.filterFids();
+      for ( QgsFeatureId id : ids )
+        fids << QString::number( id );
+      fids.sort();
+      filter = QStringLiteral( "fids:%1" ).arg( fids.join( ',' ) );
+      break;
+    }
+  }
+
+  // the filter rectangle is in the destination crs of the request
+  const QgsRectangle rect = request.filterRect();
+  const QString rectFilter = rect.isNull() ? QString() : QStringLiteral( "%1 %2" ).arg( request.destinationCrs().authid(), rect.toString( 17 ) );
+  return QStringLiteral( "%1%2\ncount\n%3\n%4" ).arg( sourceKey( layer ), layer->subsetString(), filter, rectFilter );
+}
+
+QString QgsServerFeatureCountCache::extentKey( const QgsMapLayer *layer )
+{
+  const QgsVectorLayer *vectorLayer = qobject_cast<const QgsVectorLayer *>( layer );
+  return QStringLiteral( "%1%2\nextent" ).arg( sourceKey( layer ), vectorLayer ? vectorLayer->subsetString() : QString() );
+}
+
+const QgsServerFeatureCountCache::Entry *QgsServerFeatureCountCache::validEntry( const QString &key ) const
+{
+  if ( mTimeToLive == 0 )
+    return nullptr;
+
+  const auto it = mEntries.constFind( key );
+  if ( it == mEntries.constEnd() || it->expiry < QDateTime::currentMSecsSinceEpoch() )
+    return nullptr;
+  return &it.value();
+}
+
+void QgsServerFeatureCountCache::insertEntry( const QString &key, Entry entry )
+{
+  if ( mTimeToLive == 0 )
+    return;
+
+  const qint64 now = QDateTime::currentMSecsSinceEpoch();
+  entry.expiry = now + mTimeToLive * 1000LL;
+  mEntries.insert( key, entry );
+
+  // drop the expired entries from time to time, so that the cache does not grow forever
+  if ( mEntries.size() % 1024 == 0 )
+  {
+    for ( auto it = mEntries.begin(); it != mEntries.end(); )
+    {
+      if ( it->expiry < now )
+        it = mEntries.erase( it );
+      else
+        ++it;
+    }
+  }
+}
@@ -0,0 +1,117 @@
+/***************************************************************************
+                              qgsserverfeaturecountcache.h
+                              ----------------------------
+  begin                : October 2020
+  copyright            : (C) 2020 by the QGIS project
+  email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSSERVERFEATURECOUNTCACHE_H
+#define QGSSERVERFEATURECOUNTCACHE_H
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+#include "qgis_server.h"
+#include "qgis_sip.h"
+#include "qgsfeaturerequest.h"
+#include "qgsrectangle.h"
+
+#define SIP_NO_FILE
+
+class QgsMapLayer;
+class QgsVectorLayer;
+
+/**
+ * \ingroup server
+ * \class QgsServerFeatureCountCache
+ * \brief Cache of the feature counts and extents of the vector layers served.
+ *
+ * Counting the features matching a filter (e.g. numberMatched of OGC API Features)
+ * or computing the extent of a layer may require a full scan of big tables. The
+ * results are cached for timeToLive() seconds, by data source, subset string
+ * and filter, so that they are shared by the WMS, WFS and OGC API services and by
+ * all the projects using the same data. Access control filters are part of the
+ * subset string or of the request filter, so that the counts of users with
+ * different permissions are kept apart.
+ *
+ * The entries of a data source are invalidated by invalidate(), which is called
+ * after WFS-T and OGC API Features transactions and when projects are removed from
+ * QgsConfigCache.
+ *
+ * The cache is thread-safe. It is disabled if timeToLive() is 0, see
+ * QgsServerSettings::featureCountCacheTimeToLive().
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.16
+ */
+class SERVER_EXPORT QgsServerFeatureCountCache
+{
+  public:
+
+    //! Returns the process wide instance
+    static QgsServerFeatureCountCache *instance();
+
+    //! Sets the number of \a seconds the entries are valid, 0 disables the cache
+    void setTimeToLive( int seconds );
+
+    //! Returns the number of seconds the entries are valid, 0 if the cache is disabled
+    int timeToLive() const;
+
+    /**
+     * Returns the number of features of \a layer matching the filters of \a request.
+     * The limit and the attributes of \a request are ignored. The count is computed
+     * only if it is not cached.
+     */
+    long long featureCount( const QgsVectorLayer *layer, const QgsFeatureRequest &request = QgsFeatureRequest() );
+
+    /**
+     * Sets \a count to the cached number of features of \a layer matching the filters
+     * of \a request. Returns FALSE if the count is not cached (nothing is computed).
+     */
+    bool cachedFeatureCount( const QgsVectorLayer *layer, const QgsFeatureRequest &request, long long &count ) const;
+
+    //! Returns the extent of \a layer, it is computed only if it is not cached
+    QgsRectangle extent( const QgsMapLayer *layer );
+
+    //! Removes the entries of the data source of \a layer, whatever the subset string
+    void invalidate( const QgsMapLayer *layer );
+
+    //! Removes all the entries
+    void clear();
+
+  private:
+
+    struct Entry
+    {
+      long long count = -1;
+      QgsRectangle extent;
+      qint64 expiry = 0;
+    };
+
+    static QString sourceKey( const QgsMapLayer *layer );
+    static QString countKey( const QgsVectorLayer *layer, const QgsFeatureRequest &request );
+    static QString extentKey( const QgsMapLayer *layer );
+
+    //! Returns the valid entry for \a key, or NULLPTR. The mutex must be locked.
+    const Entry *validEntry( const QString &key ) const;
+
+    //! Inserts \a entry for \a key. The mutex must be locked.
+    void insertEntry( const QString &key, Entry entry );
+
+    mutable QMutex mMutex;
+    QHash<QString, Entry> mEntries;
+    int mTimeToLive = 0;
+};
+
+#endif // QGSSERVERFEATURECOUNTCACHE_H
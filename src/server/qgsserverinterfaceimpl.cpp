@@ -26,7 +26,6 @@ QgsServerInterfaceImpl::QgsServerInterfaceImpl( QgsCapabilitiesCache *capCache,
   , mServiceRegistry( srvRegistry )
   , mServerSettings( settings )
 {
-  mRequestHandler = nullptr;
 #ifdef HAVE_SERVER_PYTHON_PLUGINS
   mAccessControls = new QgsAccessControl();
   mCacheManager = new QgsServerCacheManager();
@@ -50,17 +49,17 @@ QgsServerInterfaceImpl::~QgsServerInterfaceImpl()
 
 void QgsServerInterfaceImpl::clearRequestHandler()
 {
-  mRequestHandler = nullptr;
+  mRequestState.localData().requestHandler = nullptr;
 }
 
 void QgsServerInterfaceImpl::setRequestHandler( QgsRequestHandler *requestHandler )
 {
-  mRequestHandler = requestHandler;
+  mRequestState.localData().requestHandler = requestHandler;
 }
 
 void QgsServerInterfaceImpl::setConfigFilePath( const QString &configFilePath )
 {
-  mConfigFilePath = configFilePath;
+  mRequestState.localData().configFilePath = configFilePath;
 }
 
 void QgsServerInterfaceImpl::registerFilter( QgsServerFilter *filter, int priority )
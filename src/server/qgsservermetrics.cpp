@@ -0,0 +1,199 @@
+/***************************************************************************
+                              qgsservermetrics.cpp
+                              --------------------
+  begin                : October 2020
+  copyright            : (C) 2020 by the QGIS project
+  email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsservermetrics.h"
+#include "qgsapplication.h"
+#include "qgsconnectionpool.h"
+#include "qgsruntimeprofiler.h"
+
+#include <QHash>
+#include <QMutexLocker>
+#include <QRegularExpression>
+#include <QStringList>
+
+#include <algorithm>
+
+const QVector<double> QgsServerMetrics::BUCKETS { 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30 };
+
+namespace
+{
+  void collectTimings( const QgsRuntimeProfiler *profiler, const QModelIndex &parent, const QString &prefix,
+                       QList<QgsServerMetrics::Timing> &timings, QHash<QString, int> &indexes )
+  {
+    const QString group = QgsServerMetrics::profilerGroup();
+    for ( int row = 0; row < profiler->rowCount( parent ); ++row )
+    {
+      const QModelIndex index = profiler->index( row, 0, parent );
+      if ( profiler->data( index, QgsRuntimeProfilerNode::Group ).toString() != group )
+        continue;
+
+      const QString name = prefix + profiler->data( index, QgsRuntimeProfilerNode::Name ).toString();
+      const double elapsed = profiler->data( index, QgsRuntimeProfilerNode::Elapsed ).toDouble();
+      const auto it = indexes.constFind( name );
+      if ( it == indexes.constEnd() )
+      {
+        indexes.insert( name, timings.size() );
+        timings << QgsServerMetrics::Timing( name, elapsed );
+      }
+      else
+      {
+        timings[ it.value() ].second += elapsed;
+      }
+
+      collectTimings( profiler, index, name + '.', timings, indexes );
+    }
+  }
+
+  //! Returns \a name as a token, as required for Server-Timing metric names
+  QString timingToken( QString name )
+  {
+    static const QRegularExpression sInvalid( QStringLiteral( "[^A-Za-z0-9!#$%&'*+.^_`|~-]" ) );
+    return name.replace( sInvalid, QStringLiteral( "_" ) );
+  }
+
+  //! Escapes a Prometheus label value
+  QString labelValue( QString value )
+  {
+    return value.replace( '\\', QLatin1String( "\\\\" ) )
+           .replace( '"', QLatin1String( "\\\"" ) )
+           .replace( '\n', QLatin1String( "\\n" ) );
+  }
+}
+
+QgsServerMetrics *QgsServerMetrics::instance()
+{
+  static QgsServerMetrics sInstance;
+  return &sInstance;
+}
+
+void QgsServerMetrics::clearRequestTimings()
+{
+  QgsApplication::profiler()->clear( profilerGroup() );
+}
+
+QList<QgsServerMetrics::Timing> QgsServerMetrics::requestTimings()
+{
+  QList<Timing> timings;
+  QHash<QString, int> indexes;
+  collectTimings( QgsApplication::profiler(), QModelIndex(), QString(), timings, indexes );
+  return timings;
+}
+
+QString QgsServerMetrics::serverTimingHeader( const QList<QgsServerMetrics::Timing> &timings, double total )
+{
+  QStringList metrics;
+  metrics.reserve( timings.size() + 1 );
+  for ( const Timing &timing : timings )
+    metrics << QStringLiteral( "%1;dur=%2" ).arg( timingToken( timing.first ) ).arg( timing.second * 1000, 0, 'f', 1 );
+  metrics << QStringLiteral( "total;dur=%1" ).arg( total * 1000, 0, 'f', 1 );
+  return metrics.join( QStringLiteral( ", " ) );
+}
+
+void QgsServerMetrics::record( const QString &service, const QString &request, const QList<QgsServerMetrics::Timing> &timings, double total )
+{
+  QMutexLocker locker( &mMutex );
+
+  Histogram &histogram = mRequests[ qMakePair( service, request ) ];
+  if ( histogram.buckets.isEmpty() )
+    histogram.buckets.fill( 0, BUCKETS.size() );
+  for ( int i = 0; i < BUCKETS.size(); ++i )
+  {
+    if ( total <= BUCKETS.at( i ) )
+      ++histogram.buckets[ i ];
+  }
+  ++histogram.count;
+  histogram.sum += total;
+
+  for ( const Timing &timing : timings )
+  {
+    Summary &summary = mPhases[ timing.first ];
+    ++summary.count;
+    summary.sum += timing.second;
+    summary.max = std::max( summary.max, timing.second );
+  }
+}
+
+QString QgsServerMetrics::toPrometheus() const
+{
+  QMutexLocker locker( &mMutex );
+
+  QString result;
+  result += QLatin1String( "# HELP qgis_server_request_duration_seconds Duration of the requests handled by QGIS Server\n"
+                           "# TYPE qgis_server_request_duration_seconds histogram\n" );
+  for ( auto it = mRequests.constBegin(); it != mRequests.constEnd(); ++it )
+  {
+    const QString labels = QStringLiteral( "service=\"%1\",request=\"%2\"" ).arg( labelValue( it.key().first ), labelValue( it.key().second ) );
+    for ( int i = 0; i < BUCKETS.size(); ++i )
+    {
+      result += QStringLiteral( "qgis_server_request_duration_seconds_bucket{%1,le=\"%2\"} %3\n" ).arg( labels ).arg( BUCKETS.at( i ) ).arg( it->buckets.at( i ) );
+    }
+    result += QStringLiteral( "qgis_server_request_duration_seconds_bucket{%1,le=\"+Inf\"} %2\n" ).arg( labels ).arg( it->count );
+    result += QStringLiteral( "qgis_server_request_duration_seconds_sum{%1} %2\n" ).arg( labels ).arg( it->sum, 0, 'f', 6 );
+    result += QStringLiteral( "qgis_server_request_duration_seconds_count{%1} %2\n" ).arg( labels ).arg( it->count );
+  }
+
+  result += QLatin1String( "# HELP qgis_server_phase_duration_seconds Duration of the phases of the requests handled by QGIS Server\n"
+                           "# TYPE qgis_server_phase_duration_seconds summary\n" );
+  for ( auto it = mPhases.constBegin(); it != mPhases.constEnd(); ++it )
+  {
+    const QString labels = QStringLiteral( "phase=\"%1\"" ).arg( labelValue( it.key() ) );
+    result += QStringLiteral( "qgis_server_phase_duration_seconds_sum{%1} %2\n" ).arg( labels ).arg( it->sum, 0, 'f', 6 );
+    result += QStringLiteral( "qgis_server_phase_duration_seconds_count{%1} %2\n" ).arg( labels ).arg( it->count );
+  }
+
+  result += QLatin1String( "# HELP qgis_server_phase_duration_max_seconds Longest duration of the phases of the requests handled by QGIS Server\n"
+                           "# TYPE qgis_server_phase_duration_max_seconds gauge\n" );
+  for ( auto it = mPhases.constBegin(); it != mPhases.constEnd(); ++it )
+  {
+    result += QStringLiteral( "qgis_server_phase_duration_max_seconds{phase=\"%1\"} %2\n" ).arg( labelValue( it.key() ) ).arg( it->max, 0, 'f', 6 );
+  }
+
+  // provider connection pools, the connection strings are stripped of their passwords
+  const QMap<QString, QgsConnectionPoolMonitor::GroupStatistics> pools = QgsConnectionPoolMonitor::instance()->statistics();
+  result += QLatin1String( "# HELP qgis_server_connection_pool_connections Connections of the provider connection pools\n"
+                           "# TYPE qgis_server_connection_pool_connections gauge\n" );
+  for ( auto it = pools.constBegin(); it != pools.constEnd(); ++it )
+  {
+    const QString connection = labelValue( it.key() );
+    result += QStringLiteral( "qgis_server_connection_pool_connections{connection=\"%1\",state=\"idle\"} %2\n" ).arg( connection ).arg( it->idle );
+    result += QStringLiteral( "qgis_server_connection_pool_connections{connection=\"%1\",state=\"acquired\"} %2\n" ).arg( connection ).arg( it->acquired );
+  }
+
+  result += QLatin1String( "# HELP qgis_server_connection_pool_acquisitions_total Connections acquired from the provider connection pools\n"
+                           "# TYPE qgis_server_connection_pool_acquisitions_total counter\n" );
+  for ( auto it = pools.constBegin(); it != pools.constEnd(); ++it )
+    result += QStringLiteral( "qgis_server_connection_pool_acquisitions_total{connection=\"%1\"} %2\n" ).arg( labelValue( it.key() ) ).arg( it->acquisitions );
+
+  result += QLatin1String( "# HELP qgis_server_connection_pool_connections_created_total Connections opened by the provider connection pools\n"
+                           "# TYPE qgis_server_connection_pool_connections_created_total counter\n" );
+  for ( auto it = pools.constBegin(); it != pools.constEnd(); ++it )
+    result += QStringLiteral( "qgis_server_connection_pool_connections_created_total{connection=\"%1\"} %2\n" ).arg( labelValue( it.key() ) ).arg( it->connectionsCreated );
+
+  result += QLatin1String( "# HELP qgis_server_connection_pool_timeouts_total Connection requests to the provider connection pools which timed out\n"
+                           "# TYPE qgis_server_connection_pool_timeouts_total counter\n" );
+  for ( auto it = pools.constBegin(); it != pools.constEnd(); ++it )
+    result += QStringLiteral( "qgis_server_connection_pool_timeouts_total{connection=\"%1\"} %2\n" ).arg( labelValue( it.key() ) ).arg( it->timeouts );
+
+  return result;
+}
+
+void QgsServerMetrics::clear()
+{
+  QMutexLocker locker( &mMutex );
+  mRequests.clear();
+  mPhases.clear();
+}
@@ -0,0 +1,124 @@
+/***************************************************************************
+                              qgsservermetrics.h
+                              ------------------
+  begin                : October 2020
+  copyright            : (C) 2020 by the QGIS project
+  email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSSERVERMETRICS_H
+#define QGSSERVERMETRICS_H
+
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+#include "qgis_server.h"
+#include "qgis_sip.h"
+
+#define SIP_NO_FILE
+
+/**
+ * \ingroup server
+ * \class QgsServerMetrics
+ * \brief Collects the timings of the requests handled by the server.
+ *
+ * The phases of a request (project lookup, layer preparation, access control,
+ * rendering of each layer, labeling, image encoding, response writing, ...) are
+ * profiled with QgsScopedRuntimeProfile in the profilerGroup() group of the
+ * runtime profiler of the thread handling the request. Their durations are read
+ * back with requestTimings(), written to the Server-Timing response header if
+ * QgsServerSettings::serverTimingHeader() is set, and aggregated by record()
+ * over the lifetime of the server.
+ *
+ * The aggregated metrics are exposed in the Prometheus text format by toPrometheus(),
+ * see the metrics server module.
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.16
+ */
+class SERVER_EXPORT QgsServerMetrics
+{
+  public:
+
+    //! Name of a phase of a request and its duration in seconds
+    typedef QPair<QString, double> Timing;
+
+    //! Returns the runtime profiler group used for the phases of the requests
+    static QString profilerGroup() { return QStringLiteral( "server" ); }
+
+    //! Returns the process wide instance
+    static QgsServerMetrics *instance();
+
+    /**
+     * Clears the profiled phases of the current thread. Called when the handling
+     * of a request starts.
+     */
+    static void clearRequestTimings();
+
+    /**
+     * Returns the durations of the finished phases of the request handled by the
+     * current thread, in the order they were started. Nested phases are named
+     * "parent.child", phases with the same name are summed up.
+     */
+    static QList<QgsServerMetrics::Timing> requestTimings();
+
+    /**
+     * Returns the value of a Server-Timing header for \a timings and the \a total
+     * duration (in seconds) of the request.
+     */
+    static QString serverTimingHeader( const QList<QgsServerMetrics::Timing> &timings, double total );
+
+    /**
+     * Records a finished request of \a service and \a request type, with the
+     * durations of its phases and its \a total duration (in seconds).
+     */
+    void record( const QString &service, const QString &request, const QList<QgsServerMetrics::Timing> &timings, double total );
+
+    //! Returns the aggregated metrics in the Prometheus text exposition format
+    QString toPrometheus() const;
+
+    //! Clears all the aggregated metrics
+    void clear();
+
+  private:
+
+    struct Histogram
+    {
+      QVector<quint64> buckets;
+      quint64 count = 0;
+      double sum = 0;
+    };
+
+    struct Summary
+    {
+      quint64 count = 0;
+      double sum = 0;
+      double max = 0;
+    };
+
+    //! Upper bounds (in seconds) of the request duration histogram buckets
+    static const QVector<double> BUCKETS;
+
+    mutable QMutex mMutex;
+
+    //! Request duration histograms, by service and request type
+    QMap<QPair<QString, QString>, Histogram> mRequests;
+
+    //! Phase durations, by phase
+    QMap<QString, Summary> mPhases;
+};
+
+#endif // QGSSERVERMETRICS_H
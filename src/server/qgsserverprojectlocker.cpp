@@ -0,0 +1,69 @@
+/***************************************************************************
+                              qgsserverprojectlocker.cpp
+                              --------------------------
+  begin                : October 2020
+  copyright            : (C) 2020 by the QGIS project
+  email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsserverprojectlocker.h"
+#include "qgsproject.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QReadWriteLock>
+
+typedef QHash< const QgsProject *, std::shared_ptr< QReadWriteLock > > QgsProjectLocks;
+Q_GLOBAL_STATIC( QgsProjectLocks, sProjectLocks )
+Q_GLOBAL_STATIC( QMutex, sProjectLocksMutex )
+
+static std::shared_ptr< QReadWriteLock > projectLock( const QgsProject *project )
+{
+  QMutexLocker locker( sProjectLocksMutex() );
+
+  std::shared_ptr< QReadWriteLock > &lock = ( *sProjectLocks() )[ project ];
+  if ( !lock )
+  {
+    lock = std::make_shared< QReadWriteLock >( QReadWriteLock::Recursive );
+    // the address may be reused by another project
+    QObject::connect( project, &QObject::destroyed, [project]
+    {
+      QMutexLocker locker( sProjectLocksMutex() );
+      sProjectLocks()->remove( project );
+    } );
+  }
+  return lock;
+}
+
+QgsServerProjectLocker::QgsServerProjectLocker( const QgsProject *project, Mode mode )
+  : mMode( mode )
+{
+  if ( !project )
+    return;
+
+  mLock = projectLock( project );
+  switch ( mMode )
+  {
+    case Shared:
+      mLock->lockForRead();
+      break;
+    case Exclusive:
+      mLock->lockForWrite();
+      break;
+  }
+}
+
+QgsServerProjectLocker::~QgsServerProjectLocker()
+{
+  if ( mLock )
+    mLock->unlock();
+}
@@ -0,0 +1,78 @@
+/***************************************************************************
+                              qgsserverprojectlocker.h
+                              ------------------------
+  begin                : October 2020
+  copyright            : (C) 2020 by the QGIS project
+  email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSSERVERPROJECTLOCKER_H
+#define QGSSERVERPROJECTLOCKER_H
+
+#define SIP_NO_FILE
+
+#include "qgis_server.h"
+
+#include <memory>
+
+class QReadWriteLock;
+class QgsProject;
+
+/**
+ * \ingroup server
+ * \brief RAII class locking the layers of a project while a request uses them.
+ *
+ * The layers of a cached project are shared by the requests handled concurrently
+ * by worker threads (see QgsServerSettings::workerThreads()). Requests which only
+ * read the layers share the lock, requests which temporarily change them (their
+ * style, opacity, filter or selection, e.g. with a QgsLayerRestorer) must lock the
+ * project exclusively until the layers are restored.
+ *
+ * A thread may lock a project several times in the same mode, but it must not
+ * ask for an exclusive lock while it holds a shared one.
+ *
+ * \since QGIS 3.16
+ */
+class SERVER_EXPORT QgsServerProjectLocker
+{
+  public:
+
+    //! Locking mode
+    enum Mode
+    {
+      Shared, //!< The layers are only read
+      Exclusive, //!< The layers are changed
+    };
+
+    /**
+     * Locks the layers of \a project in the given \a mode, waiting for the
+     * requests holding a conflicting lock to release it.
+     */
+    QgsServerProjectLocker( const QgsProject *project, Mode mode );
+
+    //! Unlocks the project
+    ~QgsServerProjectLocker();
+
+    QgsServerProjectLocker( const QgsServerProjectLocker &other ) = delete;
+    QgsServerProjectLocker &operator=( const QgsServerProjectLocker &other ) = delete;
+
+    //! Returns the locking mode
+    Mode mode() const { return mMode; }
+
+  private:
+
+    // keeps the lock alive when the project is deleted while it is locked
+    std::shared_ptr< QReadWriteLock > mLock;
+    Mode mMode = Shared;
+};
+
+#endif // QGSSERVERPROJECTLOCKER_H
@@ -21,6 +21,7 @@
 
 #include <QSettings>
 #include <QDir>
+#include <QThread>
 
 QgsServerSettings::QgsServerSettings()
 {
@@ -265,6 +266,234 @@ void QgsServerSettings::initSettings()
                                          };
 
   mSettings[ sProjectsPgConnections.envVar ] = sProjectsPgConnections;
+
+  // worker threads
+  const Setting sWorkerThreads = { QgsServerSettingsEnv::QGIS_SERVER_WORKER_THREADS,
+                                   QgsServerSettingsEnv::DEFAULT_VALUE,
+                                   QStringLiteral( "Number of worker threads handling requests concurrently" ),
+                                   QStringLiteral( "/qgis/server_worker_threads" ),
+                                   QVariant::Int,
+                                   QVariant( 1 ),
+                                   QVariant()
+                                 };
+
+  mSettings[ sWorkerThreads.envVar ] = sWorkerThreads;
+
+  // WMTS tile cache directory
+  const Setting sWmtsTileCacheDirectory = { QgsServerSettingsEnv::QGIS_SERVER_WMTS_TILE_CACHE_DIRECTORY,
+                                            QgsServerSettingsEnv::DEFAULT_VALUE,
+                                            QStringLiteral( "Directory where WMTS tiles are stored, the tile cache is disabled if empty" ),
+                                            QStringLiteral( "/qgis/server_wmts_tile_cache_directory" ),
+                                            QVariant::String,
+                                            QVariant( "" ),
+                                            QVariant()
+                                          };
+
+  mSettings[ sWmtsTileCacheDirectory.envVar ] = sWmtsTileCacheDirectory;
+
+  // WMTS tile cache size
+  const Setting sWmtsTileCacheSize = { QgsServerSettingsEnv::QGIS_SERVER_WMTS_TILE_CACHE_SIZE,
+                                       QgsServerSettingsEnv::DEFAULT_VALUE,
+                                       QStringLiteral( "Maximum size in bytes of the WMTS tile cache, 0 for no limit" ),
+                                       QStringLiteral( "/qgis/server_wmts_tile_cache_size" ),
+                                       QVariant::LongLong,
+                                       QVariant( 0 ),
+                                       QVariant()
+                                     };
+
+  mSettings[ sWmtsTileCacheSize.envVar ] = sWmtsTileCacheSize;
+
+  // WMTS metatile size
+  const Setting sWmtsMetatileSize = { QgsServerSettingsEnv::QGIS_SERVER_WMTS_METATILE_SIZE,
+                                      QgsServerSettingsEnv::DEFAULT_VALUE,
+                                      QStringLiteral( "Number of tiles rendered at once along each axis by WMTS GetTile" ),
+                                      QStringLiteral( "/qgis/server_wmts_metatile_size" ),
+                                      QVariant::Int,
+                                      QVariant( 1 ),
+                                      QVariant()
+                                    };
+
+  mSettings[ sWmtsMetatileSize.envVar ] = sWmtsMetatileSize;
+
+  // WMTS metatile buffer
+  const Setting sWmtsMetatileBuffer = { QgsServerSettingsEnv::QGIS_SERVER_WMTS_METATILE_BUFFER,
+                                        QgsServerSettingsEnv::DEFAULT_VALUE,
+                                        QStringLiteral( "Size in pixels of the margin rendered around the WMTS metatiles" ),
+                                        QStringLiteral( "/qgis/server_wmts_metatile_buffer" ),
+                                        QVariant::Int,
+                                        QVariant( 64 ),
+                                        QVariant()
+                                      };
+
+  mSettings[ sWmtsMetatileBuffer.envVar ] = sWmtsMetatileBuffer;
+
+  // capabilities cache directory
+  const Setting sCapabilitiesCacheDirectory = { QgsServerSettingsEnv::QGIS_SERVER_CAPABILITIES_CACHE_DIRECTORY,
+                                                QgsServerSettingsEnv::DEFAULT_VALUE,
+                                                QStringLiteral( "Directory where capabilities documents are persisted, they are only cached in memory if empty" ),
+                                                QStringLiteral( "/qgis/server_capabilities_cache_directory" ),
+                                                QVariant::String,
+                                                QVariant( "" ),
+                                                QVariant()
+                                              };
+
+  mSettings[ sCapabilitiesCacheDirectory.envVar ] = sCapabilitiesCacheDirectory;
+
+  // lazy layer loading
+  const Setting sLazyLayerLoading = { QgsServerSettingsEnv::QGIS_SERVER_LAZY_LAYER_LOADING,
+                                      QgsServerSettingsEnv::DEFAULT_VALUE,
+                                      QStringLiteral( "Only load the layers of a project when a request needs them" ),
+                                      QStringLiteral( "/qgis/server_lazy_layer_loading" ),
+                                      QVariant::Bool,
+                                      QVariant( false ),
+                                      QVariant()
+                                    };
+
+  mSettings[ sLazyLayerLoading.envVar ] = sLazyLayerLoading;
+
+  // server timing header
+  const Setting sServerTimingHeader = { QgsServerSettingsEnv::QGIS_SERVER_TIMING_HEADER,
+                                        QgsServerSettingsEnv::DEFAULT_VALUE,
+                                        QStringLiteral( "Add a Server-Timing header to the responses" ),
+                                        QStringLiteral( "/qgis/server_timing_header" ),
+                                        QVariant::Bool,
+                                        QVariant( false ),
+                                        QVariant()
+                                      };
+
+  mSettings[ sServerTimingHeader.envVar ] = sServerTimingHeader;
+
+  // png compression level
+  const Setting sPngCompressionLevel = { QgsServerSettingsEnv::QGIS_SERVER_PNG_COMPRESSION_LEVEL,
+                                         QgsServerSettingsEnv::DEFAULT_VALUE,
+                                         QStringLiteral( "Zlib compression level (0-9) of the PNG images, -1 for the default level" ),
+                                         QStringLiteral( "/qgis/server_png_compression_level" ),
+                                         QVariant::Int,
+                                         QVariant( -1 ),
+                                         QVariant()
+                                       };
+
+  mSettings[ sPngCompressionLevel.envVar ] = sPngCompressionLevel;
+
+  // feature count cache time to live
+  const Setting sFeatureCountCacheTtl = { QgsServerSettingsEnv::QGIS_SERVER_FEATURE_COUNT_CACHE_TTL,
+                                          QgsServerSettingsEnv::DEFAULT_VALUE,
+                                          QStringLiteral( "Number of seconds the feature counts and extents of the layers are cached, 0 to disable the cache" ),
+                                          QStringLiteral( "/qgis/server_feature_count_cache_ttl" ),
+                                          QVariant::Int,
+                                          QVariant( 0 ),
+                                          QVariant()
+                                        };
+
+  mSettings[ sFeatureCountCacheTtl.envVar ] = sFeatureCountCacheTtl;
+
+  // estimated feature count
+  const Setting sEstimatedFeatureCount = { QgsServerSettingsEnv::QGIS_SERVER_ESTIMATED_FEATURE_COUNT,
+                                           QgsServerSettingsEnv::DEFAULT_VALUE,
+                                           QStringLiteral( "Do not count the features matching a filter in OGC API Features if the count is not cached" ),
+                                           QStringLiteral( "/qgis/server_estimated_feature_count" ),
+                                           QVariant::Bool,
+                                           QVariant( false ),
+                                           QVariant()
+                                         };
+
+  mSettings[ sEstimatedFeatureCount.envVar ] = sEstimatedFeatureCount;
+
+  // vector tiles cache size
+  const Setting sVectorTilesCacheSize = { QgsServerSettingsEnv::QGIS_SERVER_VECTOR_TILES_CACHE_SIZE,
+                                          QgsServerSettingsEnv::DEFAULT_VALUE,
+                                          QStringLiteral( "Size in bytes of the in-memory cache of the encoded vector tiles" ),
+                                          QStringLiteral( "/qgis/server_vector_tiles_cache_size" ),
+                                          QVariant::LongLong,
+                                          QVariant( 50 * 1024 * 1024 ),
+                                          QVariant()
+                                        };
+
+  mSettings[ sVectorTilesCacheSize.envVar ] = sVectorTilesCacheSize;
+
+  // vector tiles cache time to live
+  const Setting sVectorTilesCacheTtl = { QgsServerSettingsEnv::QGIS_SERVER_VECTOR_TILES_CACHE_TTL,
+                                         QgsServerSettingsEnv::DEFAULT_VALUE,
+                                         QStringLiteral( "Number of seconds the encoded vector tiles are cached, 0 to disable the cache" ),
+                                         QStringLiteral( "/qgis/server_vector_tiles_cache_ttl" ),
+                                         QVariant::Int,
+                                         QVariant( 60 ),
+                                         QVariant()
+                                       };
+
+  mSettings[ sVectorTilesCacheTtl.envVar ] = sVectorTilesCacheTtl;
+
+  // connection pool minimum size
+  const Setting sConnectionPoolMinSize = { QgsServerSettingsEnv::QGIS_SERVER_CONNECTION_POOL_MIN_SIZE,
+                                           QgsServerSettingsEnv::DEFAULT_VALUE,
+                                           QStringLiteral( "Minimum number of connections opened and kept open by each connection pool" ),
+                                           QStringLiteral( "/qgis/server_connection_pool_min_size" ),
+                                           QVariant::Int,
+                                           QVariant( 0 ),
+                                           QVariant()
+                                         };
+
+  mSettings[ sConnectionPoolMinSize.envVar ] = sConnectionPoolMinSize;
+
+  // gpu rendering
+  const Setting sGpuRendering = { QgsServerSettingsEnv::QGIS_SERVER_GPU_RENDERING,
+                                  QgsServerSettingsEnv::DEFAULT_VALUE,
+                                  QStringLiteral( "Draw the vector layers with OpenGL when an OpenGL context is available" ),
+                                  QStringLiteral( "/qgis/server_gpu_rendering" ),
+                                  QVariant::Bool,
+                                  QVariant( false ),
+                                  QVariant()
+                                };
+
+  mSettings[ sGpuRendering.envVar ] = sGpuRendering;
+
+  // image cache size
+  const Setting sImageCacheSize = { QgsServerSettingsEnv::QGIS_SERVER_IMAGE_CACHE_SIZE,
+                                    QgsServerSettingsEnv::DEFAULT_VALUE,
+                                    QStringLiteral( "Size in bytes of each of the in-memory caches of the rendered SVG and raster images of the symbols" ),
+                                    QStringLiteral( "/qgis/server_image_cache_size" ),
+                                    QVariant::LongLong,
+                                    QVariant( 0 ),
+                                    QVariant()
+                                  };
+
+  mSettings[ sImageCacheSize.envVar ] = sImageCacheSize;
+
+  // prewarm image caches
+  const Setting sPrewarmImageCaches = { QgsServerSettingsEnv::QGIS_SERVER_PREWARM_IMAGE_CACHES,
+                                        QgsServerSettingsEnv::DEFAULT_VALUE,
+                                        QStringLiteral( "Render the SVG and raster images of the symbols into the image caches when a project is loaded" ),
+                                        QStringLiteral( "/qgis/server_prewarm_image_caches" ),
+                                        QVariant::Bool,
+                                        QVariant( false ),
+                                        QVariant()
+                                      };
+
+  mSettings[ sPrewarmImageCaches.envVar ] = sPrewarmImageCaches;
+
+  // prewarm coordinate transforms
+  const Setting sPrewarmCoordinateTransforms = { QgsServerSettingsEnv::QGIS_SERVER_PREWARM_COORDINATE_TRANSFORMS,
+                                                 QgsServerSettingsEnv::DEFAULT_VALUE,
+                                                 QStringLiteral( "Create the coordinate transforms from the layers to the project and WMS CRSs when a project is loaded" ),
+                                                 QStringLiteral( "/qgis/server_prewarm_coordinate_transforms" ),
+                                                 QVariant::Bool,
+                                                 QVariant( false ),
+                                                 QVariant()
+                                               };
+
+  mSettings[ sPrewarmCoordinateTransforms.envVar ] = sPrewarmCoordinateTransforms;
+
+  // read layers in parallel
+  const Setting sReadLayersInParallel = { QgsServerSettingsEnv::QGIS_SERVER_READ_LAYERS_IN_PARALLEL,
+                                          QgsServerSettingsEnv::DEFAULT_VALUE,
+                                          QStringLiteral( "Read the layers of a project concurrently in background threads when the project is loaded" ),
+                                          QStringLiteral( "/qgis/server_read_layers_in_parallel" ),
+                                          QVariant::Bool,
+                                          QVariant( false ),
+                                          QVariant()
+                                        };
+
+  mSettings[ sReadLayersInParallel.envVar ] = sReadLayersInParallel;
 }
 
 void QgsServerSettings::load()
@@ -513,3 +742,101 @@ bool QgsServerSettings::getPrintDisabled() const
 {
   return value( QgsServerSettingsEnv::QGIS_SERVER_DISABLE_GETPRINT ).toBool();
 }
+
+int QgsServerSettings::workerThreads() const
+{
+  const int threads = value( QgsServerSettingsEnv::QGIS_SERVER_WORKER_THREADS ).toInt();
+  return threads < 1 ? QThread::idealThreadCount() : threads;
+}
+
+QString QgsServerSettings::wmtsTileCacheDirectory() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_WMTS_TILE_CACHE_DIRECTORY ).toString();
+}
+
+qint64 QgsServerSettings::wmtsTileCacheSize() const
+{
+  return qMax( static_cast< qint64 >( 0 ), value( QgsServerSettingsEnv::QGIS_SERVER_WMTS_TILE_CACHE_SIZE ).toLongLong() );
+}
+
+int QgsServerSettings::wmtsMetatileSize() const
+{
+  return qMax( 1, value( QgsServerSettingsEnv::QGIS_SERVER_WMTS_METATILE_SIZE ).toInt() );
+}
+
+int QgsServerSettings::wmtsMetatileBuffer() const
+{
+  return qMax( 0, value( QgsServerSettingsEnv::QGIS_SERVER_WMTS_METATILE_BUFFER ).toInt() );
+}
+
+QString QgsServerSettings::capabilitiesCacheDirectory() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_CAPABILITIES_CACHE_DIRECTORY ).toString();
+}
+
+bool QgsServerSettings::lazyLayerLoading() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_LAZY_LAYER_LOADING ).toBool();
+}
+
+bool QgsServerSettings::serverTimingHeader() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_TIMING_HEADER ).toBool();
+}
+
+int QgsServerSettings::pngCompressionLevel() const
+{
+  bool ok;
+  const int level = value( QgsServerSettingsEnv::QGIS_SERVER_PNG_COMPRESSION_LEVEL ).toInt( &ok );
+  return ok && level >= 0 && level <= 9 ? level : -1;
+}
+
+int QgsServerSettings::featureCountCacheTimeToLive() const
+{
+  return qMax( 0, value( QgsServerSettingsEnv::QGIS_SERVER_FEATURE_COUNT_CACHE_TTL ).toInt() );
+}
+
+bool QgsServerSettings::estimatedFeatureCount() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_ESTIMATED_FEATURE_COUNT ).toBool();
+}
+
+qint64 QgsServerSettings::vectorTilesCacheSize() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_VECTOR_TILES_CACHE_SIZE ).toLongLong();
+}
+
+int QgsServerSettings::vectorTilesCacheTimeToLive() const
+{
+  return qMax( 0, value( QgsServerSettingsEnv::QGIS_SERVER_VECTOR_TILES_CACHE_TTL ).toInt() );
+}
+
+int QgsServerSettings::connectionPoolMinimumSize() const
+{
+  return qMax( 0, value( QgsServerSettingsEnv::QGIS_SERVER_CONNECTION_POOL_MIN_SIZE ).toInt() );
+}
+
+bool QgsServerSettings::gpuRendering() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_GPU_RENDERING ).toBool();
+}
+
+qint64 QgsServerSettings::imageCacheSize() const
+{
+  return qMax( static_cast< qint64 >( 0 ), value( QgsServerSettingsEnv::QGIS_SERVER_IMAGE_CACHE_SIZE ).toLongLong() );
+}
+
+bool QgsServerSettings::prewarmImageCaches() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_PREWARM_IMAGE_CACHES ).toBool();
+}
+
+bool QgsServerSettings::prewarmCoordinateTransforms() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_PREWARM_COORDINATE_TRANSFORMS ).toBool();
+}
+
+bool QgsServerSettings::readLayersInParallel() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_READ_LAYERS_IN_PARALLEL ).toBool();
+}
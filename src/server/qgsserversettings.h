@@ -70,7 +70,26 @@ class SERVER_EXPORT QgsServerSettingsEnv : public QObject
       QGIS_SERVER_TRUST_LAYER_METADATA, //!< Trust layer metadata. Improves project read time. (since QGIS 3.16).
       QGIS_SERVER_DISABLE_GETPRINT, //!< Disabled WMS GetPrint request and don't load layouts. Improves project read time. (since QGIS 3.16).
       QGIS_SERVER_LANDING_PAGE_PROJECTS_DIRECTORIES, //!< Directories used by the landing page service to find .qgs and .qgz projects (since QGIS 3.16)
-      QGIS_SERVER_LANDING_PAGE_PROJECTS_PG_CONNECTIONS //!< PostgreSQL connection strings used by the landing page service to find projects (since QGIS 3.16)
+      QGIS_SERVER_LANDING_PAGE_PROJECTS_PG_CONNECTIONS, //!< PostgreSQL connection strings used by the landing page service to find projects (since QGIS 3.16)
+      QGIS_SERVER_WORKER_THREADS, //!< Number of worker threads handling requests concurrently and sharing the project cache (since QGIS 3.16)
+      QGIS_SERVER_WMTS_TILE_CACHE_DIRECTORY, //!< Directory where WMTS tiles rendered by GetTile are stored, the tile cache is disabled if empty (since QGIS 3.16)
+      QGIS_SERVER_WMTS_METATILE_SIZE, //!< Number of tiles rendered at once along each axis by WMTS GetTile when the tile cache is enabled (since QGIS 3.16)
+      QGIS_SERVER_CAPABILITIES_CACHE_DIRECTORY, //!< Directory where capabilities documents are persisted across restarts, disabled if empty (since QGIS 3.16)
+      QGIS_SERVER_LAZY_LAYER_LOADING, //!< Only load the layers of a project when a request needs them. Improves project read time and memory use. (since QGIS 3.16)
+      QGIS_SERVER_TIMING_HEADER, //!< Add a Server-Timing header with the duration of each phase of the request to the responses (since QGIS 3.16)
+      QGIS_SERVER_PNG_COMPRESSION_LEVEL, //!< Zlib compression level (0-9) of the PNG images (since QGIS 3.16)
+      QGIS_SERVER_FEATURE_COUNT_CACHE_TTL, //!< Number of seconds the feature counts and extents of the layers are cached, 0 to disable the cache (since QGIS 3.16)
+      QGIS_SERVER_ESTIMATED_FEATURE_COUNT, //!< Do not count the features matching a filter in OGC API Features if the count is not cached (since QGIS 3.16)
+      QGIS_SERVER_VECTOR_TILES_CACHE_SIZE, //!< Size in bytes of the in-memory cache of the encoded vector tiles (since QGIS 3.16)
+      QGIS_SERVER_VECTOR_TILES_CACHE_TTL, //!< Number of seconds the encoded vector tiles are cached, 0 to disable the cache (since QGIS 3.16)
+      QGIS_SERVER_CONNECTION_POOL_MIN_SIZE, //!< Minimum number of connections opened and kept open by each connection pool (since QGIS 3.16)
+      QGIS_SERVER_GPU_RENDERING, //!< Draw the vector layers with OpenGL when an OpenGL context is available (since QGIS 3.16)
+      QGIS_SERVER_IMAGE_CACHE_SIZE, //!< Size in bytes of each of the in-memory caches of the rendered SVG and raster images of the symbols (since QGIS 3.16)
+      QGIS_SERVER_PREWARM_IMAGE_CACHES, //!< Render the SVG and raster images of the symbols into the image caches when a project is loaded (since QGIS 3.16)
+      QGIS_SERVER_PREWARM_COORDINATE_TRANSFORMS, //!< Create the coordinate transforms from the layers to the project and WMS CRSs when a project is loaded (since QGIS 3.16)
+      QGIS_SERVER_READ_LAYERS_IN_PARALLEL, //!< Read the layers of a project concurrently in background threads when the project is loaded (since QGIS 3.16)
+      QGIS_SERVER_WMTS_METATILE_BUFFER, //!< Size in pixels of the margin rendered around the WMTS metatiles and discarded when they are split (since QGIS 3.16)
+      QGIS_SERVER_WMTS_TILE_CACHE_SIZE //!< Maximum size in bytes of the WMTS tile cache, 0 for no limit (since QGIS 3.16)
     };
     Q_ENUM( EnvVar )
 };
@@ -273,6 +292,257 @@ class SERVER_EXPORT QgsServerSettings
      */
     bool getPrintDisabled() const;
 
+    /**
+     * Returns the number of worker threads used to handle requests concurrently.
+     *
+     * Worker threads share the same read-only project and capabilities caches,
+     * each request getting its own rendering context. The default value is 1,
+     * which means that requests are handled one at a time in the main thread.
+     * This value can be changed by setting the environment variable
+     * QGIS_SERVER_WORKER_THREADS, a value lower than 1 means the number of
+     * available cores.
+     *
+     * \since QGIS 3.16
+     */
+    int workerThreads() const;
+
+    /**
+     * Returns the directory where the tiles rendered by WMTS GetTile requests
+     * are persisted. Tiles are stored by project, layer set, style, tile matrix
+     * and tile coordinates and they are invalidated when the project changes.
+     *
+     * The default value is an empty string, which means that the tile cache is
+     * disabled. This value can be changed by setting the environment variable
+     * QGIS_SERVER_WMTS_TILE_CACHE_DIRECTORY.
+     *
+     * \since QGIS 3.16
+     */
+    QString wmtsTileCacheDirectory() const;
+
+    /**
+     * Returns the maximum size in bytes of the tiles stored in the WMTS tile
+     * cache directory (see wmtsTileCacheDirectory()). When the limit is exceeded
+     * the oldest tiles are removed. The value 0 does not limit the size.
+     *
+     * The default value is 0, this value can be changed by setting the environment
+     * variable QGIS_SERVER_WMTS_TILE_CACHE_SIZE.
+     *
+     * \since QGIS 3.16
+     */
+    qint64 wmtsTileCacheSize() const;
+
+    /**
+     * Returns the metatile size used by WMTS GetTile requests: when greater
+     * than 1 and the tile cache is enabled (see wmtsTileCacheDirectory()),
+     * a block of size x size tiles is rendered in a single map render and
+     * all the tiles of the block are stored in the tile cache. This shares
+     * layer preparation, feature iteration and labeling between adjacent
+     * tiles and avoids labeling seams at the tile edges.
+     *
+     * The default value is 1 (no metatiling), this value can be changed by
+     * setting the environment variable QGIS_SERVER_WMTS_METATILE_SIZE.
+     *
+     * \since QGIS 3.16
+     */
+    int wmtsMetatileSize() const;
+
+    /**
+     * Returns the size in pixels of the margin rendered around each WMTS
+     * metatile (see wmtsMetatileSize()). The margin is discarded when the
+     * metatile is split into tiles, so that the labels and symbols crossing
+     * the metatile edges are not clipped.
+     *
+     * The default value is 64, this value can be changed by setting the
+     * environment variable QGIS_SERVER_WMTS_METATILE_BUFFER.
+     *
+     * \since QGIS 3.16
+     */
+    int wmtsMetatileBuffer() const;
+
+    /**
+     * Returns the directory where the capabilities documents are persisted,
+     * so that they survive server restarts and may be shared by several server
+     * processes. Documents are stored by project and are discarded when the
+     * content of the project file changes.
+     *
+     * The default value is an empty string, which means that capabilities are
+     * only cached in memory. This value can be changed by setting the environment
+     * variable QGIS_SERVER_CAPABILITIES_CACHE_DIRECTORY.
+     *
+     * \since QGIS 3.16
+     */
+    QString capabilitiesCacheDirectory() const;
+
+    /**
+     * Returns TRUE if the layers of the projects are only loaded when a request
+     * needs them.
+     *
+     * Projects are then read with the QgsProject::ReadFlag::FlagDontResolveLayers
+     * and QgsProject::ReadFlag::FlagTrustLayerMetadata flags: layers keep their
+     * style and stored metadata (extent, CRS) but their data provider is only
+     * created by QgsConfigCache::resolveLayers() when a GetMap, GetFeatureInfo,
+     * GetFeature, DescribeFeatureType, Transaction or coverage request uses them.
+     * Capabilities are answered from the stored metadata. Invalid layers are only
+     * reported when they are requested, whatever ignoreBadLayers() returns.
+     *
+     * The default value is FALSE, this value can be changed by setting the environment
+     * variable QGIS_SERVER_LAZY_LAYER_LOADING.
+     *
+     * \since QGIS 3.16
+     */
+    bool lazyLayerLoading() const;
+
+    /**
+     * Returns TRUE if the responses include a Server-Timing header, with the
+     * duration of each phase of the request (project lookup, layer preparation,
+     * rendering, encoding, ...) as collected in the "server" group of the
+     * runtime profiler. The header reveals the names of the layers, it should
+     * only be activated for debugging.
+     *
+     * The default value is FALSE, this value can be changed by setting the environment
+     * variable QGIS_SERVER_TIMING_HEADER.
+     *
+     * \since QGIS 3.16
+     */
+    bool serverTimingHeader() const;
+
+    /**
+     * Returns the zlib compression level, from 0 (fastest) to 9 (smallest), of the
+     * PNG images sent by the server. Lower levels noticeably reduce the encoding
+     * time of GetMap responses, for slightly larger images. The value -1 keeps the
+     * default level of the PNG encoder.
+     *
+     * The default value is -1, this value can be changed by setting the environment
+     * variable QGIS_SERVER_PNG_COMPRESSION_LEVEL.
+     *
+     * \since QGIS 3.16
+     */
+    int pngCompressionLevel() const;
+
+    /**
+     * Returns the number of seconds the feature counts and the extents of the layers
+     * are cached by QgsServerFeatureCountCache. The cache is shared by the WMS, WFS
+     * and OGC API Features services, and avoids full scans of big tables for every
+     * GetCapabilities or items request. The value 0 disables the cache.
+     *
+     * The default value is 0, this value can be changed by setting the environment
+     * variable QGIS_SERVER_FEATURE_COUNT_CACHE_TTL.
+     *
+     * \since QGIS 3.16
+     */
+    int featureCountCacheTimeToLive() const;
+
+    /**
+     * Returns TRUE if OGC API Features may omit the number of features matching a
+     * filter (numberMatched) when it is not cached, instead of counting them.
+     *
+     * The default value is FALSE, this value can be changed by setting the environment
+     * variable QGIS_SERVER_ESTIMATED_FEATURE_COUNT.
+     *
+     * \since QGIS 3.16
+     */
+    bool estimatedFeatureCount() const;
+
+    /**
+     * Returns the size in bytes of the in-memory cache of the vector tiles encoded
+     * by the vector tiles API.
+     *
+     * The default value is 50 MB, this value can be changed by setting the environment
+     * variable QGIS_SERVER_VECTOR_TILES_CACHE_SIZE.
+     *
+     * \since QGIS 3.16
+     */
+    qint64 vectorTilesCacheSize() const;
+
+    /**
+     * Returns the number of seconds the vector tiles encoded by the vector tiles API
+     * are cached. The tiles of a project are also dropped when the project is removed
+     * from the cache of projects. The value 0 disables the cache.
+     *
+     * The default value is 60, this value can be changed by setting the environment
+     * variable QGIS_SERVER_VECTOR_TILES_CACHE_TTL.
+     *
+     * \since QGIS 3.16
+     */
+    int vectorTilesCacheTimeToLive() const;
+
+    /**
+     * Returns the minimum number of connections opened to each data source by the
+     * connection pools of the providers (e.g. PostgreSQL). These connections are
+     * opened when the projects are loaded and kept open when idle, so that the first
+     * requests after a quiet period do not pay the connection handshakes. The value 0
+     * opens the connections on demand.
+     *
+     * The default value is 0, this value can be changed by setting the environment
+     * variable QGIS_SERVER_CONNECTION_POOL_MIN_SIZE.
+     *
+     * \since QGIS 3.16
+     */
+    int connectionPoolMinimumSize() const;
+
+    /**
+     * Returns TRUE if the vector layers are drawn with OpenGL, in an offscreen
+     * framebuffer. Only the layers using simple fill, line and marker symbol layers
+     * are drawn this way, and only if an OpenGL context can be created (e.g. with
+     * the EGL or GLX platforms), the others are drawn on the CPU.
+     *
+     * The default value is FALSE, this value can be changed by setting the environment
+     * variable QGIS_SERVER_GPU_RENDERING.
+     *
+     * \since QGIS 3.16
+     */
+    bool gpuRendering() const;
+
+    /**
+     * Returns the maximum size in bytes of each of the in-memory caches of the
+     * rendered SVG and raster images of the symbols. The value 0 keeps the default
+     * size of the caches (20 MB), which is quickly exceeded by high resolution renders.
+     *
+     * The default value is 0, this value can be changed by setting the environment
+     * variable QGIS_SERVER_IMAGE_CACHE_SIZE.
+     *
+     * \since QGIS 3.16
+     */
+    qint64 imageCacheSize() const;
+
+    /**
+     * Returns TRUE if the SVG and raster images of the symbols of a project are
+     * rendered into the image caches, in parallel, when the project is loaded. The
+     * images are rendered at the sizes they have with the OGC standard pixel size,
+     * for the symbols whose sizes do not depend on the features or on the map scale.
+     *
+     * The default value is FALSE, this value can be changed by setting the environment
+     * variable QGIS_SERVER_PREWARM_IMAGE_CACHES.
+     *
+     * \since QGIS 3.16
+     */
+    bool prewarmImageCaches() const;
+
+    /**
+     * Returns TRUE if the coordinate transforms from the CRSs of the layers of a
+     * project to the CRS of the project and to the CRSs advertised by its WMS
+     * capabilities are created when the project is loaded. The coordinate operations
+     * are then resolved once, and only cloned by the threads rendering the requests.
+     *
+     * The default value is FALSE, this value can be changed by setting the environment
+     * variable QGIS_SERVER_PREWARM_COORDINATE_TRANSFORMS.
+     *
+     * \since QGIS 3.16
+     */
+    bool prewarmCoordinateTransforms() const;
+
+    /**
+     * Returns TRUE if the layers of a project are read concurrently in background
+     * threads when the project is loaded, so that the connections of their data
+     * providers are established in parallel (see QgsProject::ReadFlag::FlagReadLayersInParallel).
+     *
+     * The default value is FALSE, this value can be changed by setting the environment
+     * variable QGIS_SERVER_READ_LAYERS_IN_PARALLEL.
+     *
+     * \since QGIS 3.16
+     */
+    bool readLayersInParallel() const;
+
     /**
      * Returns the string representation of a setting.
      * \since QGIS 3.16
@@ -0,0 +1,80 @@
+/***************************************************************************
+                              qgsmetrics.cpp
+                              --------------
+  begin                : October 2020
+  copyright            : (C) 2020 by the QGIS project
+  email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsmodule.h"
+#include "qgsserverapi.h"
+#include "qgsserverapicontext.h"
+#include "qgsservermetrics.h"
+
+/**
+ * Metrics API, exposes the timings collected by QgsServerMetrics in the
+ * Prometheus text format on /metrics
+ * \since QGIS 3.16
+ */
+class QgsMetricsApi: public QgsServerApi
+{
+  public:
+
+    QgsMetricsApi( QgsServerInterface *serverIface )
+      : QgsServerApi( serverIface )
+    {
+    }
+
+    const QString name() const override { return QStringLiteral( "Metrics" ); }
+    const QString description() const override { return QStringLiteral( "Request timings in the Prometheus text format" ); }
+    const QString version() const override { return QStringLiteral( "1.0.0" ); }
+    const QString rootPath() const override { return QStringLiteral( "/metrics" ); }
+
+    bool accept( const QUrl &url ) const override
+    {
+      // the metrics reveal the names of the layers, they may be disabled like the other APIs
+      return ! qgetenv( "QGIS_SERVER_DISABLED_APIS" ).contains( name().toUtf8() ) && url.path() == rootPath();
+    }
+
+    void executeRequest( const QgsServerApiContext &context ) const override
+    {
+      QgsServerResponse *response = context.response();
+      response->setHeader( QStringLiteral( "Content-Type" ), QStringLiteral( "text/plain; version=0.0.4; charset=utf-8" ) );
+      response->write( QgsServerMetrics::instance()->toPrometheus().toUtf8() );
+    }
+};
+
+/**
+ * \class QgsMetricsModule
+ * \brief Metrics module for QGIS Server
+ * \since QGIS 3.16
+ */
+class QgsMetricsModule: public QgsServiceModule
+{
+  public:
+    void registerSelf( QgsServiceRegistry &registry, QgsServerInterface *serverIface ) override
+    {
+      registry.registerApi( new QgsMetricsApi( serverIface ) );
+    }
+};
+
+
+// Entry points
+QGISEXTERN QgsServiceModule *QGS_ServiceModule_Init()
+{
+  static QgsMetricsModule module;
+  return &module;
+}
+QGISEXTERN void QGS_ServiceModule_Exit( QgsServiceModule * )
+{
+  // Nothing to do
+}
@@ -0,0 +1,322 @@
+/***************************************************************************
+                              qgsvectortiles.cpp
+                              ------------------
+  begin                : October 2020
+  copyright            : (C) 2020 by the QGIS project
+  email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsmodule.h"
+#include "qgsconfigcache.h"
+#include "qgsproject.h"
+#include "qgsruntimeprofiler.h"
+#include "qgsserverapi.h"
+#include "qgsserverapicontext.h"
+#include "qgsserverapiutils.h"
+#include "qgsserverexception.h"
+#include "qgsserverinterface.h"
+#include "qgsservermetrics.h"
+#include "qgsserverprojectutils.h"
+#include "qgsserverrequest.h"
+#include "qgsserverresponse.h"
+#include "qgsvectorlayer.h"
+#include "qgsvectortilemvtencoder.h"
+
+#ifdef HAVE_SERVER_PYTHON_PLUGINS
+#include "qgsaccesscontrol.h"
+#include "qgsfilterrestorer.h"
+#endif
+
+#include <QCache>
+#include <QDateTime>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRegularExpression>
+#include <QUrlQuery>
+
+#include <algorithm>
+#include <limits>
+
+/**
+ * In-memory cache of the encoded vector tiles, shared by the requests of all the projects.
+ * The tiles expire after a time to live and are dropped when their project is removed
+ * from QgsConfigCache.
+ * \since QGIS 3.16
+ */
+class QgsVectorTilesCache
+{
+  public:
+
+    //! Returns the process wide instance
+    static QgsVectorTilesCache *instance()
+    {
+      static QgsVectorTilesCache sInstance;
+      return &sInstance;
+    }
+
+    //! Sets the size in bytes of the cache and the number of \a seconds the tiles are valid
+    void setLimits( qint64 size, int seconds )
+    {
+      QMutexLocker locker( &mMutex );
+      mTiles.setMaxCost( static_cast<int>( std::min<qint64>( std::max<qint64>( 0, size ), std::numeric_limits<int>::max() ) ) );
+      mTimeToLive = seconds;
+    }
+
+    //! Sets \a data to the tile cached for \a key, returns FALSE if it is not cached
+    bool tile( const QString &key, QByteArray &data )
+    {
+      QMutexLocker locker( &mMutex );
+      const Tile *tile = mTiles.object( key );
+      if ( ! tile || tile->expiry < QDateTime::currentMSecsSinceEpoch() )
+        return false;
+      data = tile->data;
+      return true;
+    }
+
+    //! Caches the tile \a data for \a key
+    void insertTile( const QString &key, const QByteArray &data )
+    {
+      QMutexLocker locker( &mMutex );
+      if ( mTimeToLive <= 0 )
+        return;
+      Tile *tile = new Tile { data, QDateTime::currentMSecsSinceEpoch() + mTimeToLive * 1000LL };
+      mTiles.insert( key, tile, std::max( 1, data.size() ) );
+    }
+
+    //! Removes the tiles of the project with the given \a path
+    void removeProject( const QString &path )
+    {
+      QMutexLocker locker( &mMutex );
+      const QString prefix = path + '\n';
+      const QList<QString> keys = mTiles.keys();
+      for ( const QString &key : keys )
+      {
+        if ( key.startsWith( prefix ) )
+          mTiles.remove( key );
+      }
+    }
+
+  private:
+
+    QgsVectorTilesCache()
+    {
+      QObject::connect( QgsConfigCache::instance(), &QgsConfigCache::projectRemovedFromCache, [ this ]( const QString & path )
+      {
+        removeProject( path );
+      } );
+    }
+
+    struct Tile
+    {
+      QByteArray data;
+      qint64 expiry;
+    };
+
+    QMutex mMutex;
+    QCache<QString, Tile> mTiles;
+    int mTimeToLive = 0;
+};
+
+
+/**
+ * Vector tiles API, encodes on the fly the Mapbox vector tiles of the vector layers
+ * published in WFS on /tiles/{z}/{x}/{y}.pbf, in the WebMercatorQuad tile matrix set.
+ *
+ * The published layers may be restricted with the "layers" argument, a comma
+ * separated list of layer short names. The attributes excluded from WFS and the
+ * access control rules are honoured.
+ * \since QGIS 3.16
+ */
+class QgsVectorTilesApi: public QgsServerApi
+{
+  public:
+
+    QgsVectorTilesApi( QgsServerInterface *serverIface )
+      : QgsServerApi( serverIface )
+    {
+      QgsServerSettings *settings = serverIface->serverSettings();
+      QgsVectorTilesCache::instance()->setLimits( settings->vectorTilesCacheSize(), settings->vectorTilesCacheTimeToLive() );
+    }
+
+    const QString name() const override { return QStringLiteral( "Vector Tiles" ); }
+    const QString description() const override { return QStringLiteral( "Mapbox vector tiles of the vector layers published in WFS" ); }
+    const QString version() const override { return QStringLiteral( "1.0.0" ); }
+    const QString rootPath() const override { return QStringLiteral( "/tiles" ); }
+
+    bool accept( const QUrl &url ) const override
+    {
+      return ! qgetenv( "QGIS_SERVER_DISABLED_APIS" ).contains( name().toUtf8() ) && tilePath().match( url.path() ).hasMatch();
+    }
+
+    void executeRequest( const QgsServerApiContext &context ) const override
+    {
+      const QgsProject *project = context.project();
+      if ( ! project )
+      {
+        throw QgsServerApiImproperlyConfiguredException( QStringLiteral( "Project not found, please check your server configuration." ) );
+      }
+
+      // Tile coordinates
+      const QRegularExpressionMatch match = tilePath().match( context.request()->url().path() );
+      const int zoom = match.captured( QStringLiteral( "z" ) ).toInt();
+      const int column = match.captured( QStringLiteral( "x" ) ).toInt();
+      const int row = match.captured( QStringLiteral( "y" ) ).toInt();
+      if ( zoom > MAX_ZOOM_LEVEL || column >= ( 1 << zoom ) || row >= ( 1 << zoom ) )
+      {
+        throw QgsServerApiNotFoundError( QStringLiteral( "Tile %1/%2/%3 does not exist" ).arg( zoom ).arg( column ).arg( row ) );
+      }
+
+      // Layers
+      const QStringList layerNames = QUrlQuery( context.request()->url() ).queryItemValue( QStringLiteral( "layers" ), QUrl::FullyDecoded )
+                                     .split( ',', QString::SkipEmptyParts );
+      QList<QgsVectorLayer *> layers;
+      const QVector<QgsVectorLayer *> publishedLayers = QgsServerApiUtils::publishedWfsLayers<QgsVectorLayer *>( context );
+      for ( QgsVectorLayer *layer : publishedLayers )
+      {
+        const QString shortName = layer->shortName().isEmpty() ? layer->name() : layer->shortName();
+        if ( layerNames.isEmpty() || layerNames.contains( shortName ) )
+          layers << layer;
+      }
+      if ( layers.isEmpty() && ! layerNames.isEmpty() )
+      {
+        throw QgsServerApiNotFoundError( QStringLiteral( "Layers '%1' are not published" ).arg( layerNames.join( ',' ) ) );
+      }
+
+      QList<QgsMapLayer *> mapLayers;
+      for ( QgsVectorLayer *layer : qgis::as_const( layers ) )
+        mapLayers << layer;
+      QgsConfigCache::instance()->resolveLayers( mapLayers );
+
+#ifdef HAVE_SERVER_PYTHON_PLUGINS
+      QgsAccessControl *accessControl = context.serverInterface()->accessControls();
+      // restores the original layer filters when the request is done
+      std::unique_ptr< QgsOWSServerFilterRestorer > filterRestorer( new QgsOWSServerFilterRestorer() );
+      if ( accessControl )
+      {
+        for ( QgsVectorLayer *layer : qgis::as_const( layers ) )
+          QgsOWSServerFilterRestorer::applyAccessControlLayerFilters( accessControl, layer, filterRestorer->originalFilters() );
+      }
+#endif
+
+      // Published attributes, the subset strings hold the access control filters
+      QHash<QgsVectorLayer *, QgsAttributeList> layerAttributes;
+      QString key = QStringLiteral( "%1\n%2/%3/%4" ).arg( project->fileName() ).arg( zoom ).arg( column ).arg( row );
+      for ( QgsVectorLayer *layer : qgis::as_const( layers ) )
+      {
+        const QgsAttributeList attributes = publishedAttributes( layer, context );
+        layerAttributes.insert( layer, attributes );
+
+        QStringList attributeNames;
+        for ( int attribute : attributes )
+          attributeNames << QString::number( attribute );
+        key += QStringLiteral( "\n%1\n%2\n%3" ).arg( layer->id(), layer->subsetString(), attributeNames.join( ',' ) );
+      }
+
+      QByteArray data;
+      if ( ! QgsVectorTilesCache::instance()->tile( key, data ) )
+      {
+        QgsScopedRuntimeProfile profile( QStringLiteral( "encode" ), QgsServerMetrics::profilerGroup() );
+
+        QgsVectorTileMVTEncoder encoder( QgsTileXYZ( column, row, zoom ) );
+        encoder.setTransformContext( project->transformContext() );
+        // vertices closer than one tile unit are merged anyway by the encoding
+        encoder.setSimplifyGeometries( true );
+        for ( QgsVectorLayer *layer : qgis::as_const( layers ) )
+        {
+          if ( ! layer->isSpatial() )
+            continue;
+          const QString shortName = layer->shortName().isEmpty() ? layer->name() : layer->shortName();
+          encoder.addLayer( layer, layerAttributes.value( layer ), nullptr, QString(), shortName );
+        }
+        data = encoder.encode();
+        QgsVectorTilesCache::instance()->insertTile( key, data );
+      }
+
+      QgsServerResponse *response = context.response();
+      response->setHeader( QStringLiteral( "Content-Type" ), QStringLiteral( "application/vnd.mapbox-vector-tile" ) );
+      if ( data.isEmpty() )
+      {
+        // OGC API Tiles: no content for the tiles without features
+        response->setStatusCode( 204 );
+      }
+      else
+      {
+        response->write( data );
+      }
+    }
+
+  private:
+
+    //! Highest zoom level served
+    static const int MAX_ZOOM_LEVEL = 24;
+
+    static QRegularExpression tilePath()
+    {
+      static const QRegularExpression sTilePath( QStringLiteral( R"re(^/tiles/(?<z>\d{1,2})/(?<x>\d{1,8})/(?<y>\d{1,8})\.(pbf|mvt)$)re" ) );
+      return sTilePath;
+    }
+
+    //! Returns the indexes of the attributes of \a layer published in WFS
+    static QgsAttributeList publishedAttributes( const QgsVectorLayer *layer, const QgsServerApiContext &context )
+    {
+      const QSet<QString> &excludedAttributes = layer->excludeAttributesWfs();
+      const QgsFields fields = layer->fields();
+      QStringList attributeNames;
+      for ( const QgsField &field : fields )
+      {
+        if ( ! excludedAttributes.contains( field.name() ) )
+          attributeNames << field.name();
+      }
+
+#ifdef HAVE_SERVER_PYTHON_PLUGINS
+      // Python plugins can make further modifications to the allowed attributes
+      if ( QgsAccessControl *accessControl = context.serverInterface()->accessControls() )
+        attributeNames = accessControl->layerAttributes( layer, attributeNames );
+#else
+      Q_UNUSED( context )
+#endif
+
+      QgsAttributeList attributes;
+      for ( int i = 0; i < fields.count(); ++i )
+      {
+        if ( attributeNames.contains( fields.at( i ).name() ) )
+          attributes << i;
+      }
+      return attributes;
+    }
+};
+
+/**
+ * \class QgsVectorTilesModule
+ * \brief Vector tiles module for QGIS Server
+ * \since QGIS 3.16
+ */
+class QgsVectorTilesModule: public QgsServiceModule
+{
+  public:
+    void registerSelf( QgsServiceRegistry &registry, QgsServerInterface *serverIface ) override
+    {
+      registry.registerApi( new QgsVectorTilesApi( serverIface ) );
+    }
+};
+
+
+// Entry points
+QGISEXTERN QgsServiceModule *QGS_ServiceModule_Init()
+{
+  static QgsVectorTilesModule module;
+  return &module;
+}
+QGISEXTERN void QGS_ServiceModule_Exit( QgsServiceModule * )
+{
+  // Nothing to do
+}
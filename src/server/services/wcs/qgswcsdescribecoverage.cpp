@@ -18,6 +18,7 @@
  ***************************************************************************/
 #include "qgswcsutils.h"
 #include "qgsserverprojectutils.h"
+#include "qgsconfigcache.h"
 #include "qgswcsdescribecoverage.h"
 
 #include "qgsproject.h"
@@ -142,6 +143,7 @@ namespace QgsWcs
 
       if ( coveNameList.size() == 0 || coveNameList.contains( name ) )
       {
+        QgsConfigCache::instance()->resolveLayers( { layer } );
         QgsRasterLayer *rLayer = qobject_cast<QgsRasterLayer *>( layer );
         coveDescElement.appendChild( getCoverageOffering( doc, const_cast<QgsRasterLayer *>( rLayer ), project ) );
       }
@@ -21,6 +21,7 @@
 
 #include "qgswcsutils.h"
 #include "qgsserverprojectutils.h"
+#include "qgsconfigcache.h"
 #include "qgswcsgetcoverage.h"
 
 #include "qgsproject.h"
@@ -34,6 +35,14 @@
 namespace QgsWcs
 {
 
+  //! Size of the chunks of the coverage file written to the response
+  static const qint64 COVERAGE_CHUNK_SIZE = 1024 * 1024;
+
+  /**
+   * Writes the coverage of the request to the opened \a tempFile
+   */
+  static void writeCoverageFile( QgsServerInterface *serverIface, const QgsProject *project, const QgsServerRequest &request, QTemporaryFile &tempFile );
+
   /**
    * Output WCS DescribeCoverage response
    */
@@ -42,11 +51,21 @@ namespace QgsWcs
   {
     Q_UNUSED( version )
 
-    response.write( getCoverageData( serverIface, project, request ) );
+    QTemporaryFile tempFile;
+    tempFile.open();
+    writeCoverageFile( serverIface, project, request, tempFile );
+
+    // the file is sent by chunks, without reading it at once in memory
     response.setHeader( "Content-Type", "image/tiff" );
+    QByteArray chunk;
+    while ( !( chunk = tempFile.read( COVERAGE_CHUNK_SIZE ) ).isEmpty() )
+    {
+      response.write( chunk );
+      response.flush();
+    }
   }
 
-  QByteArray getCoverageData( QgsServerInterface *serverIface, const QgsProject *project, const QgsServerRequest &request )
+  static void writeCoverageFile( QgsServerInterface *serverIface, const QgsProject *project, const QgsServerRequest &request, QTemporaryFile &tempFile )
   {
     QgsServerRequest::Parameters parameters = request.parameters();
 
@@ -105,6 +124,7 @@ namespace QgsWcs
 
       if ( name == coveName )
       {
+        QgsConfigCache::instance()->resolveLayers( { layer } );
         rLayer = qobject_cast<QgsRasterLayer *>( layer );
         break;
       }
@@ -186,8 +206,6 @@ namespace QgsWcs
       }
     }
 
-    QTemporaryFile tempFile;
-    tempFile.open();
     QgsRasterFileWriter fileWriter( tempFile.fileName() );
 
     // clone pipe/provider
@@ -213,7 +231,6 @@ namespace QgsWcs
     {
       throw QgsRequestNotWellFormedException( QStringLiteral( "Cannot write raster error code: %1" ).arg( err ) );
     }
-    return tempFile.readAll();
   }
 
 } // namespace QgsWcs
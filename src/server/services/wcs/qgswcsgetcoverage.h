@@ -30,11 +30,6 @@ namespace QgsWcs
   void writeGetCoverage( QgsServerInterface *serverIface, const QgsProject *project, const QString &version,
                          const QgsServerRequest &request, QgsServerResponse &response );
 
-  /**
-   * Compute coverage data
-   */
-  QByteArray getCoverageData( QgsServerInterface *serverIface, const QgsProject *project, const QgsServerRequest &request );
-
 } // namespace QgsWcs
 
 #endif
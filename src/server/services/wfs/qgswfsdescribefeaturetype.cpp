@@ -21,6 +21,7 @@
  ***************************************************************************/
 #include "qgswfsutils.h"
 #include "qgsserverprojectutils.h"
+#include "qgsconfigcache.h"
 #include "qgswfsdescribefeaturetype.h"
 #include "qgswfsparameters.h"
 
@@ -165,6 +166,7 @@ namespace QgsWfs
         }
       }
 #endif
+      QgsConfigCache::instance()->resolveLayers( { layer } );
       QgsVectorLayer *vLayer = qobject_cast<QgsVectorLayer *>( layer );
       QgsVectorDataProvider *provider = vLayer->dataProvider();
       if ( !provider )
@@ -21,6 +21,7 @@
  ***************************************************************************/
 #include "qgswfsutils.h"
 #include "qgsserverprojectutils.h"
+#include "qgsserverfeaturecountcache.h"
 #include "qgswfsgetcapabilities.h"
 
 #include "qgsproject.h"
@@ -580,7 +581,7 @@ namespace QgsWfs
       layerElem.appendChild( operationsElement );
 
       //create WGS84BoundingBox
-      QgsRectangle layerExtent = layer->extent();
+      QgsRectangle layerExtent = QgsServerFeatureCountCache::instance()->extent( layer );
       //transform the layers native CRS into WGS84
       QgsCoordinateReferenceSystem wgs84 = QgsCoordinateReferenceSystem::fromOgcWmsCrs( geoEpsgCrsAuthId() );
       int wgs84precision = 6;
@@ -21,6 +21,7 @@
  ***************************************************************************/
 #include "qgswfsutils.h"
 #include "qgsserverprojectutils.h"
+#include "qgsserverfeaturecountcache.h"
 #include "qgswfsgetcapabilities_1_0_0.h"
 
 #include "qgsproject.h"
@@ -361,7 +362,7 @@ namespace QgsWfs
         }
 
         //create LatLongBoundingBox
-        QgsRectangle layerExtent = layer->extent();
+        QgsRectangle layerExtent = QgsServerFeatureCountCache::instance()->extent( layer );
         QDomElement bBoxElement = doc.createElement( QStringLiteral( "LatLongBoundingBox" ) );
         bBoxElement.setAttribute( QStringLiteral( "minx" ), qgsDoubleToString( QgsServerProjectUtils::floorWithPrecision( layerExtent.xMinimum(), precision ), precision ) );
         bBoxElement.setAttribute( QStringLiteral( "miny" ), qgsDoubleToString( QgsServerProjectUtils::floorWithPrecision( layerExtent.yMinimum(), precision ), precision ) );
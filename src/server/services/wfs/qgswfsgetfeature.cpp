@@ -22,6 +22,9 @@
 #include "qgswfsutils.h"
 #include "qgsserverprojectutils.h"
 #include "qgsserverfeatureid.h"
+#include "qgsconfigcache.h"
+#include "qgsruntimeprofiler.h"
+#include "qgsservermetrics.h"
 #include "qgsfields.h"
 #include "qgsdatetimefieldformatter.h"
 #include "qgsexpression.h"
@@ -83,6 +86,9 @@ namespace QgsWfs
 
     void endGetFeature( QgsServerResponse &response, QgsWfsParameters::Format format );
 
+    /* Size of the pending output above which the features written so far are flushed */
+    const int FLUSH_BUFFER_SIZE = 64 * 1024;
+
     QgsServerRequest::Parameters mRequestParameters;
     QgsWfsParameters mWfsParameters;
     /* GeoJSON Exporter */
@@ -150,6 +156,7 @@ namespace QgsWfs
 
       if ( typeNameList.contains( name ) )
       {
+        QgsConfigCache::instance()->resolveLayers( { layer } );
         // store layers
         mapLayerMap[name] = layer;
         // update request metadata
@@ -408,6 +415,7 @@ namespace QgsWfs
       }
 
       // Iterate through features
+      QgsScopedRuntimeProfile profile( QStringLiteral( "features:%1" ).arg( typeName ), QgsServerMetrics::profilerGroup() );
       QgsFeatureIterator fit = vlayer->getFeatures( featureRequest );
 
       if ( mWfsParameters.resultType() == QgsWfsParameters::ResultType::HITS )
@@ -1244,8 +1252,10 @@ namespace QgsWfs
         response.write( gmlDoc.toByteArray() );
       }
 
-      // Stream partial content
-      response.flush();
+      // Stream partial content once the pending output reaches the buffer size, so that
+      // memory stays bounded without flushing (and calling the filters) for every feature
+      if ( response.data().size() >= FLUSH_BUFFER_SIZE )
+        response.flush();
     }
 
     void endGetFeature( QgsServerResponse &response, QgsWfsParameters::Format format )
@@ -23,7 +23,9 @@
 
 #include "qgswfsutils.h"
 #include "qgsserverprojectutils.h"
+#include "qgsserverfeaturecountcache.h"
 #include "qgsserverfeatureid.h"
+#include "qgsconfigcache.h"
 #include "qgsfields.h"
 #include "qgsexpression.h"
 #include "qgsgeometry.h"
@@ -258,6 +260,8 @@ namespace QgsWfs
           continue;
         }
 
+        QgsConfigCache::instance()->resolveLayers( { layer } );
+
         // get vector layer
         QgsVectorLayer *vlayer = qobject_cast<QgsVectorLayer *>( layer );
         if ( !vlayer )
@@ -505,7 +509,10 @@ namespace QgsWfs
 #endif
 
         // Commit the changes of the update elements
-        if ( !vlayer->commitChanges() )
+        const bool committed = vlayer->commitChanges();
+        // even a failed commit may have changed some features
+        QgsServerFeatureCountCache::instance()->invalidate( vlayer );
+        if ( !committed )
         {
           action.error = true;
           action.errorMsg = QStringLiteral( "Error committing updates: %1" ).arg( vlayer->commitErrors().join( QStringLiteral( "; " ) ) );
@@ -623,7 +630,10 @@ namespace QgsWfs
         }
 
         // Commit the changes of the update elements
-        if ( !vlayer->commitChanges() )
+        const bool committed = vlayer->commitChanges();
+        // even a failed commit may have changed some features
+        QgsServerFeatureCountCache::instance()->invalidate( vlayer );
+        if ( !committed )
         {
           action.error = true;
           action.errorMsg = QStringLiteral( "Error committing deletes: %1" ).arg( vlayer->commitErrors().join( QStringLiteral( "; " ) ) );
@@ -738,7 +748,10 @@ namespace QgsWfs
         }
 
         // Commit the changes of the update elements
-        if ( !vlayer->commitChanges() )
+        const bool committed = vlayer->commitChanges();
+        // even a failed commit may have changed some features
+        QgsServerFeatureCountCache::instance()->invalidate( vlayer );
+        if ( !committed )
         {
           action.error = true;
           action.errorMsg = QStringLiteral( "Error committing inserts: %1" ).arg( vlayer->commitErrors().join( QStringLiteral( "; " ) ) );
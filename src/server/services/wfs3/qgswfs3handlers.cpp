@@ -28,6 +28,7 @@
 #include "qgsmessagelog.h"
 #include "qgsbufferserverrequest.h"
 #include "qgsserverprojectutils.h"
+#include "qgsserverfeaturecountcache.h"
 #include "qgsserverinterface.h"
 #include "qgsexpressioncontext.h"
 #include "qgsexpressioncontextutils.h"
@@ -798,9 +799,9 @@ QList<QgsServerQueryStringParameter> QgsWfs3CollectionsItemsHandler::parameters(
       offset.setCustomValidator( [ = ]( const QgsServerApiContext &, QVariant & value ) -> bool
       {
         const qlonglong longVal { value.toLongLong( ) };
-        return longVal >= 0 && longVal <= mapLayer->featureCount( );
+        return longVal >= 0 && longVal <= QgsServerFeatureCountCache::instance()->featureCount( mapLayer );
       } );
-      offset.setDescription( QStringLiteral( "Offset for features to retrieve [0-%1]" ).arg( mapLayer->featureCount( ) ) );
+      offset.setDescription( QStringLiteral( "Offset for features to retrieve [0-%1]" ).arg( QgsServerFeatureCountCache::instance()->featureCount( mapLayer ) ) );
       offsetValidatorSet = true;
       const QList<QgsServerQueryStringParameter> constFieldParameters { fieldParameters( mapLayer, context ) };
       for ( const auto &p : constFieldParameters )
@@ -894,6 +895,12 @@ QList<QgsServerQueryStringParameter> QgsWfs3CollectionsItemsHandler::parameters(
 
   params.push_back( offset );
 
+  // Keyset paging
+  QgsServerQueryStringParameter after { QStringLiteral( "after" ), false,
+                                        QgsServerQueryStringParameter::Type::Integer,
+                                        QStringLiteral( "Retrieve the features with a primary key greater than this value, as written in the next link (only for collections with an integer primary key, cannot be combined with sortby and offset)" ) };
+  params.push_back( after );
+
   // BBOX
   QgsServerQueryStringParameter bbox { QStringLiteral( "bbox" ), false,
                                        QgsServerQueryStringParameter::Type::String,
@@ -1099,6 +1106,29 @@ const QList<QgsServerQueryStringParameter> QgsWfs3CollectionsItemsHandler::field
   return params;
 }
 
+int QgsWfs3CollectionsItemsHandler::keysetAttributeIndex( const QgsVectorLayer *mapLayer )
+{
+  if ( ! mapLayer || ! mapLayer->dataProvider() )
+  {
+    return -1;
+  }
+  const QgsAttributeList pkAttributes { mapLayer->dataProvider()->pkAttributeIndexes() };
+  if ( pkAttributes.size() != 1 )
+  {
+    return -1;
+  }
+  switch ( mapLayer->fields().at( pkAttributes.first() ).type() )
+  {
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+      return pkAttributes.first();
+    default:
+      return -1;
+  }
+}
+
 void QgsWfs3CollectionsItemsHandler::handleRequest( const QgsServerApiContext &context ) const
 {
   if ( ! context.project() )
@@ -1178,6 +1208,19 @@ void QgsWfs3CollectionsItemsHandler::handleRequest( const QgsServerApiContext &c
       // so we do our own paging with "offset")
       const qlonglong offset { params.value( QStringLiteral( "offset" ) ).toLongLong( &ok ) };
 
+      // keyset paging: the pages are ordered by the primary key and the next links
+      // filter on the last key instead of skipping features with "offset"
+      const int keysetIndex { keysetAttributeIndex( mapLayer ) };
+      const QVariant after { params.value( QStringLiteral( "after" ) ) };
+      if ( after.isValid() && keysetIndex < 0 )
+      {
+        throw QgsServerApiBadRequestException( QStringLiteral( "Argument 'after' is not supported by collection '%1'" ).arg( mapLayer->name() ) );
+      }
+      if ( after.isValid() && offset != 0 )
+      {
+        throw QgsServerApiBadRequestException( QStringLiteral( "Arguments 'after' and 'offset' cannot be combined" ) );
+      }
+
       const qlonglong limit {  params.value( QStringLiteral( "limit" ) ).toLongLong( &ok ) };
 
       QString filterExpression;
@@ -1211,7 +1254,12 @@ void QgsWfs3CollectionsItemsHandler::handleRequest( const QgsServerApiContext &c
         {
           throw QgsServerApiBadRequestException( QStringLiteral( "Invalid sortBy field '%1'" ).arg( QgsServerApiUtils::sanitizedFieldValue( sortBy ) ) );
         }
+        if ( after.isValid() )
+        {
+          throw QgsServerApiBadRequestException( QStringLiteral( "Arguments 'after' and 'sortby' cannot be combined" ) );
+        }
       }
+      const bool keysetPaging { keysetIndex >= 0 && sortBy.isEmpty() };
 
 
       // ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1264,10 +1312,59 @@ void QgsWfs3CollectionsItemsHandler::handleRequest( const QgsServerApiContext &c
 
       // WFS3 core specs only serves 4326
       featureRequest.setDestinationCrs( crs, context.project()->transformContext() );
+
+      // The features matched by the request, whatever the page
+      const QgsFeatureRequest matchedRequest { featureRequest };
+
+      // Count features, -1 if the count is estimated
+      long matchedFeaturesCount = 0;
+      QgsServerFeatureCountCache *countCache = QgsServerFeatureCountCache::instance();
+      if ( attrFilters.isEmpty() && filterRect.isNull() )
+      {
+        matchedFeaturesCount = static_cast<long>( countCache->featureCount( mapLayer ) );
+      }
+      else
+      {
+        long long count = -1;
+        if ( countCache->cachedFeatureCount( mapLayer, matchedRequest, count ) )
+        {
+          matchedFeaturesCount = static_cast<long>( count );
+        }
+        else if ( context.serverInterface()->serverSettings()->estimatedFeatureCount() )
+        {
+          matchedFeaturesCount = -1;
+        }
+        else
+        {
+          matchedFeaturesCount = static_cast<long>( countCache->featureCount( mapLayer, matchedRequest ) );
+        }
+      }
+
+      // The features are ordered by their key only when the page follows a
+      // keyset next link or when it has one, i.e. when it is not the last page
+      const bool keysetOrder { keysetPaging && ( after.isValid() || matchedFeaturesCount < 0 || limit + offset < matchedFeaturesCount ) };
+      if ( keysetOrder )
+      {
+        const QString keysetField { mapLayer->fields().at( keysetIndex ).name() };
+        // Both the filter and the order are compiled by the providers of
+        // the layers with a primary key, so that a page costs the same
+        // whatever its position
+        featureRequest.setOrderBy( { { { QgsExpression::quotedColumnRef( keysetField ), true } } } );
+        if ( after.isValid() )
+        {
+          featureRequest.combineFilterExpression( QStringLiteral( "%1 > %2" ).arg( QgsExpression::quotedColumnRef( keysetField ) ).arg( after.toLongLong() ) );
+        }
+      }
+
       // Add offset to limit because paging is not supported by QgsFeatureRequest
       featureRequest.setLimit( limit + offset );
       QgsJsonExporter exporter { mapLayer };
       exporter.setAttributes( featureRequest.subsetOfAttributes() );
+      if ( keysetOrder && ( featureRequest.flags() & QgsFeatureRequest::SubsetOfAttributes ) && ! featureRequest.subsetOfAttributes().contains( keysetIndex ) )
+      {
+        // The key of the last feature is required for the next link
+        featureRequest.setSubsetOfAttributes( featureRequest.subsetOfAttributes() << keysetIndex );
+      }
       exporter.setAttributeDisplayName( true );
       exporter.setSourceCrs( mapLayer->crs() );
       exporter.setTransformGeometries( false );
@@ -1283,33 +1380,13 @@ void QgsWfs3CollectionsItemsHandler::handleRequest( const QgsServerApiContext &c
         i++;
       }
 
-      // Count features
-      long matchedFeaturesCount = 0;
-      if ( attrFilters.isEmpty() && filterRect.isNull() )
-      {
-        matchedFeaturesCount = mapLayer->featureCount();
-      }
-      else
-      {
-        if ( filterExpression.isEmpty() )
-        {
-          featureRequest.setNoAttributes();
-        }
-
-        featureRequest.setFlags( QgsFeatureRequest::Flag::NoGeometry );
-        featureRequest.setLimit( -1 );
-        features = mapLayer->getFeatures( featureRequest );
-
-        while ( features.nextFeature( feat ) )
-        {
-          matchedFeaturesCount++;
-        }
-      }
-
       json data = exporter.exportFeaturesToJsonObject( featureList );
 
       // Add some metadata
-      data["numberMatched"] = matchedFeaturesCount;
+      if ( matchedFeaturesCount >= 0 )
+      {
+        data["numberMatched"] = matchedFeaturesCount;
+      }
       data["numberReturned"] = featureList.count();
       data["links"] = links( context );
 
@@ -1321,6 +1398,7 @@ void QgsWfs3CollectionsItemsHandler::handleRequest( const QgsServerApiContext &c
       QUrlQuery query( cleanedUrl );
       query.removeQueryItem( QStringLiteral( "limit" ) );
       query.removeQueryItem( QStringLiteral( "offset" ) );
+      query.removeQueryItem( QStringLiteral( "after" ) );
       cleanedUrl.setQuery( query );
 
       QString cleanedUrlAsString { cleanedUrl.toString() };
@@ -1351,10 +1429,19 @@ void QgsWfs3CollectionsItemsHandler::handleRequest( const QgsServerApiContext &c
         data["links"].push_back( prevLink );
       }
 
-      if ( limit + offset < matchedFeaturesCount )
+      // without the count or the position of a keyset page, there may be a next page if the page is full
+      const bool hasNextPage { matchedFeaturesCount < 0 || after.isValid() ? i >= limit + offset : limit + offset < matchedFeaturesCount };
+      if ( hasNextPage )
       {
         json nextLink = selfLink;
-        nextLink["href"] = QStringLiteral( "%1&offset=%2&limit=%3" ).arg( cleanedUrlAsString ).arg( std::min<long>( matchedFeaturesCount, limit + offset ) ).arg( limit ).toStdString();
+        if ( keysetOrder && ! featureList.isEmpty() )
+        {
+          nextLink["href"] = QStringLiteral( "%1&after=%2&limit=%3" ).arg( cleanedUrlAsString ).arg( featureList.last().attribute( keysetIndex ).toLongLong() ).arg( limit ).toStdString();
+        }
+        else
+        {
+          nextLink["href"] = QStringLiteral( "%1&offset=%2&limit=%3" ).arg( cleanedUrlAsString ).arg( matchedFeaturesCount < 0 ? limit + offset : std::min<long>( matchedFeaturesCount, limit + offset ) ).arg( limit ).toStdString();
+        }
         nextLink["rel"] = "next";
         nextLink["name"] = "Next page";
         data["links"].push_back( nextLink );
@@ -1491,7 +1578,9 @@ void QgsWfs3CollectionsItemsHandler::handleRequest( const QgsServerApiContext &c
 
         QgsFeatureList featuresToAdd;
         featuresToAdd.append( feat );
-        if ( ! mapLayer->dataProvider()->addFeatures( featuresToAdd ) )
+        const bool added = mapLayer->dataProvider()->addFeatures( featuresToAdd );
+        QgsServerFeatureCountCache::instance()->invalidate( mapLayer );
+        if ( ! added )
         {
           throw QgsServerApiInternalServerError( QStringLiteral( "Error adding feature to collection" ) );
         }
@@ -1733,7 +1822,9 @@ void QgsWfs3CollectionsFeatureHandler::handleRequest( const QgsServerApiContext
 
         // TODO: raise if nothing to change?
 
-        if ( ! mapLayer->dataProvider()->changeFeatures( changedAttributes, changedGeometries ) )
+        const bool changed = mapLayer->dataProvider()->changeFeatures( changedAttributes, changedGeometries );
+        QgsServerFeatureCountCache::instance()->invalidate( mapLayer );
+        if ( ! changed )
         {
           throw QgsServerApiInternalServerError( QStringLiteral( "Error changing feature" ) );
         }
@@ -1861,7 +1952,9 @@ void QgsWfs3CollectionsFeatureHandler::handleRequest( const QgsServerApiContext
         QgsMessageLog::logMessage( QStringLiteral( "Changeset is empty: no features have been modified" ), QStringLiteral( "Server" ), Qgis::Info );
       }
 
-      if ( ! mapLayer->dataProvider()->changeFeatures( changedAttributes, changedGeometries ) )
+      const bool changed = mapLayer->dataProvider()->changeFeatures( changedAttributes, changedGeometries );
+      QgsServerFeatureCountCache::instance()->invalidate( mapLayer );
+      if ( ! changed )
       {
         throw QgsServerApiInternalServerError( QStringLiteral( "Error patching feature" ) );
       }
@@ -1902,7 +1995,9 @@ void QgsWfs3CollectionsFeatureHandler::handleRequest( const QgsServerApiContext
       }
 
 #endif
-      if ( ! mapLayer->dataProvider()->deleteFeatures( { feature.id() } ) )
+      const bool deleted = mapLayer->dataProvider()->deleteFeatures( { feature.id() } );
+      QgsServerFeatureCountCache::instance()->invalidate( mapLayer );
+      if ( ! deleted )
       {
         throw QgsServerApiInternalServerError( QStringLiteral( "Error deleting feature '%1' from layer '%2'" )
                                                .arg( featureId )
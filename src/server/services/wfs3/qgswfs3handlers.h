@@ -225,6 +225,9 @@ class QgsWfs3CollectionsItemsHandler: public QgsWfs3AbstractItemsHandler
 
     // Retrieve the fields filter parameters
     const QList<QgsServerQueryStringParameter> fieldParameters( const QgsVectorLayer *mapLayer,  const QgsServerApiContext &context ) const;
+
+    // Returns the index of the integer primary key used for keyset paging, -1 if the layer has none
+    static int keysetAttributeIndex( const QgsVectorLayer *mapLayer );
 };
 
 
@@ -17,10 +17,13 @@
 
 #include "qgsmaprendererjobproxy.h"
 
+#include "qgsmaplayer.h"
 #include "qgsmessagelog.h"
 #include "qgsmaprendererparalleljob.h"
 #include "qgsmaprenderercustompainterjob.h"
 #include "qgsapplication.h"
+#include "qgsruntimeprofiler.h"
+#include "qgsservermetrics.h"
 
 namespace QgsWms
 {
@@ -52,7 +55,11 @@ namespace QgsWms
   {
     if ( mParallelRendering )
     {
-      QgsMapRendererParallelJob renderJob( mapSettings );
+      // also spread the rendering of each layer on several threads
+      QgsMapSettings parallelSettings( mapSettings );
+      parallelSettings.setFlag( QgsMapSettings::ParallelFeatureRendering );
+      parallelSettings.setFlag( QgsMapSettings::ParallelRasterRendering );
+      QgsMapRendererParallelJob renderJob( parallelSettings );
 #ifdef HAVE_SERVER_PYTHON_PLUGINS
       renderJob.setFeatureFilterProvider( mFeatureFilterProvider );
 #endif
@@ -69,6 +76,7 @@ namespace QgsWms
       mPainter.reset( new QPainter( image ) );
 
       mErrors = renderJob.errors();
+      recordRenderingTimes( renderJob );
     }
     else
     {
@@ -79,9 +87,23 @@ namespace QgsWms
 #endif
       renderJob.renderSynchronously();
       mErrors = renderJob.errors();
+      recordRenderingTimes( renderJob );
     }
   }
 
+  void QgsMapRendererJobProxy::recordRenderingTimes( const QgsMapRendererJob &job ) const
+  {
+    QgsRuntimeProfiler *profiler = QgsApplication::profiler();
+    const QHash<QgsMapLayer *, int> layerTimes = job.perLayerRenderingTime();
+    for ( auto it = layerTimes.constBegin(); it != layerTimes.constEnd(); ++it )
+    {
+      const QString name = it.key()->shortName().isEmpty() ? it.key()->name() : it.key()->shortName();
+      profiler->record( QStringLiteral( "layer:%1" ).arg( name ), it.value() / 1000.0, QgsServerMetrics::profilerGroup() );
+    }
+    if ( job.labelingTime() >= 0 )
+      profiler->record( QStringLiteral( "labeling" ), job.labelingTime() / 1000.0, QgsServerMetrics::profilerGroup() );
+  }
+
   QPainter *QgsMapRendererJobProxy::takePainter()
   {
     return mPainter.release();
@@ -75,6 +75,9 @@ namespace QgsWms
 
       void getRenderErrors( const QgsMapRendererJob *job );
 
+      //! Records the rendering time of each layer and of the labels in the server profile of the request
+      void recordRenderingTimes( const QgsMapRendererJob &job ) const;
+
       //! Layer id / error message
       QgsMapRendererJob::Errors mErrors;
   };
@@ -24,6 +24,10 @@
 #include <QList>
 #include <QMultiMap>
 #include <QHash>
+#include <QThread>
+#include <QtConcurrent>
+
+#include <cstdlib>
 
 namespace QgsWms
 {
@@ -34,30 +38,95 @@ namespace QgsWms
   namespace
   {
 
+    //! Images with less pixels are processed by the calling thread only
+    const int PARALLEL_PIXEL_COUNT = 512 * 512;
+
+    //! Returns the [first, last) row ranges used to split \a image between threads
+    QVector< QPair<int, int> > rowStripes( const QImage &image )
+    {
+      const int height = image.height();
+      int count = 1;
+      if ( static_cast<qint64>( image.width() ) * height >= PARALLEL_PIXEL_COUNT )
+        count = std::max( 1, std::min( QThread::idealThreadCount(), height ) );
+
+      QVector< QPair<int, int> > stripes;
+      stripes.reserve( count );
+      for ( int i = 0; i < count; ++i )
+        stripes << qMakePair( height * i / count, height * ( i + 1 ) / count );
+      return stripes;
+    }
+
+    void stripeColors( QHash<QRgb, int> &colors, const QImage &image, int firstRow, int lastRow )
+    {
+      const int width = image.width();
+
+      // rendered maps have long runs of identical pixels, the lookup is only done once per run
+      for ( int i = firstRow; i < lastRow; ++i )
+      {
+        const QRgb *currentScanLine = reinterpret_cast< const QRgb * >( image.constScanLine( i ) );
+        int j = 0;
+        while ( j < width )
+        {
+          const QRgb color = currentScanLine[j];
+          int run = 1;
+          while ( j + run < width && currentScanLine[j + run] == color )
+            ++run;
+          colors[ color ] += run;
+          j += run;
+        }
+      }
+    }
+
     void imageColors( QHash<QRgb, int> &colors, const QImage &image )
     {
       colors.clear();
-      int width = image.width();
-      int height = image.height();
 
-      const QRgb *currentScanLine = nullptr;
-      QHash<QRgb, int>::iterator colorIt;
-      for ( int i = 0; i < height; ++i )
+      const QVector< QPair<int, int> > stripes = rowStripes( image );
+      if ( stripes.size() == 1 )
       {
-        currentScanLine = ( const QRgb * )( image.scanLine( i ) );
-        for ( int j = 0; j < width; ++j )
+        stripeColors( colors, image, 0, image.height() );
+        return;
+      }
+
+      const QList< QHash<QRgb, int> > stripeHistograms = QtConcurrent::blockingMapped< QList< QHash<QRgb, int> > >( stripes, [&image]( const QPair<int, int> &stripe )
+      {
+        QHash<QRgb, int> histogram;
+        stripeColors( histogram, image, stripe.first, stripe.second );
+        return histogram;
+      } );
+
+      colors = stripeHistograms.first();
+      for ( int i = 1; i < stripeHistograms.size(); ++i )
+      {
+        const QHash<QRgb, int> &histogram = stripeHistograms.at( i );
+        for ( auto it = histogram.constBegin(); it != histogram.constEnd(); ++it )
+          colors[ it.key() ] += it.value();
+      }
+    }
+
+    //! Same distance as the one used by QImage to convert to a color table
+    int pixelDistance( QRgb p1, QRgb p2 )
+    {
+      return std::abs( qRed( p1 ) - qRed( p2 ) ) + std::abs( qGreen( p1 ) - qGreen( p2 ) )
+             + std::abs( qBlue( p1 ) - qBlue( p2 ) ) + std::abs( qAlpha( p1 ) - qAlpha( p2 ) );
+    }
+
+    uchar closestColor( QRgb color, const QVector<QRgb> &colorTable )
+    {
+      int index = 0;
+      int distance = std::numeric_limits<int>::max();
+      for ( int i = 0; i < colorTable.size(); ++i )
+      {
+        const int currentDistance = pixelDistance( color, colorTable.at( i ) );
+        if ( currentDistance < distance )
         {
-          colorIt = colors.find( currentScanLine[j] );
-          if ( colorIt == colors.end() )
-          {
-            colors.insert( currentScanLine[j], 1 );
-          }
-          else
-          {
-            colorIt.value()++;
-          }
+          distance = currentDistance;
+          index = i;
+          if ( distance == 0 )
+            break;
         }
       }
+      return static_cast< uchar >( index );
     }
 
     bool minMaxRange( const QgsColorBox &colorBox, int &redRange, int &greenRange, int &blueRange, int &alphaRange )
@@ -251,73 +320,150 @@ namespace QgsWms
       colorBoxMap.insert( halfSum * 2.0 - currentSum, newColorBox2 );
     }
 
-  } // namespace
-
-  void medianCut( QVector<QRgb> &colorTable, int nColors, const QImage &inputImage )
-  {
-    QHash<QRgb, int> inputColors;
-    imageColors( inputColors, inputImage );
-
-    if ( inputColors.size() <= nColors ) //all the colors in the image can be mapped to one palette color
+    void medianCutColors( QVector<QRgb> &colorTable, int nColors, const QHash<QRgb, int> &inputColors )
     {
-      colorTable.resize( inputColors.size() );
-      int index = 0;
-      for ( auto inputColorIt = inputColors.constBegin(); inputColorIt != inputColors.constEnd(); ++inputColorIt )
+      if ( inputColors.size() <= nColors ) //all the colors in the image can be mapped to one palette color
       {
-        colorTable[index] = inputColorIt.key();
-        ++index;
+        colorTable.resize( inputColors.size() );
+        int index = 0;
+        for ( auto inputColorIt = inputColors.constBegin(); inputColorIt != inputColors.constEnd(); ++inputColorIt )
+        {
+          colorTable[index] = inputColorIt.key();
+          ++index;
+        }
+        return;
       }
-      return;
-    }
 
-    //create first box
-    QgsColorBox firstBox; //QList< QPair<QRgb, int> >
-    int firstBoxPixelSum = 0;
-    for ( auto  inputColorIt = inputColors.constBegin(); inputColorIt != inputColors.constEnd(); ++inputColorIt )
-    {
-      firstBox.push_back( qMakePair( inputColorIt.key(), inputColorIt.value() ) );
-      firstBoxPixelSum += inputColorIt.value();
-    }
+      //create first box
+      QgsColorBox firstBox; //QList< QPair<QRgb, int> >
+      int firstBoxPixelSum = 0;
+      for ( auto  inputColorIt = inputColors.constBegin(); inputColorIt != inputColors.constEnd(); ++inputColorIt )
+      {
+        firstBox.push_back( qMakePair( inputColorIt.key(), inputColorIt.value() ) );
+        firstBoxPixelSum += inputColorIt.value();
+      }
 
-    QgsColorBoxMap colorBoxMap; //QMultiMap< int, ColorBox >
-    colorBoxMap.insert( firstBoxPixelSum, firstBox );
-    QMap<int, QgsColorBox>::iterator colorBoxMapIt = colorBoxMap.end();
+      QgsColorBoxMap colorBoxMap; //QMultiMap< int, ColorBox >
+      colorBoxMap.insert( firstBoxPixelSum, firstBox );
+      QMap<int, QgsColorBox>::iterator colorBoxMapIt = colorBoxMap.end();
 
-    //split boxes until number of boxes == nColors or all the boxes have color count 1
-    bool allColorsMapped = false;
-    while ( colorBoxMap.size() < nColors )
-    {
-      //start at the end of colorBoxMap and pick the first entry with number of colors < 1
-      colorBoxMapIt = colorBoxMap.end();
-      while ( true )
+      //split boxes until number of boxes == nColors or all the boxes have color count 1
+      bool allColorsMapped = false;
+      while ( colorBoxMap.size() < nColors )
       {
-        --colorBoxMapIt;
-        if ( colorBoxMapIt.value().size() > 1 )
+        //start at the end of colorBoxMap and pick the first entry with number of colors < 1
+        colorBoxMapIt = colorBoxMap.end();
+        while ( true )
         {
-          splitColorBox( colorBoxMapIt.value(), colorBoxMap, colorBoxMapIt );
-          break;
+          --colorBoxMapIt;
+          if ( colorBoxMapIt.value().size() > 1 )
+          {
+            splitColorBox( colorBoxMapIt.value(), colorBoxMap, colorBoxMapIt );
+            break;
+          }
+          if ( colorBoxMapIt == colorBoxMap.begin() )
+          {
+            allColorsMapped = true;
+            break;
+          }
         }
-        if ( colorBoxMapIt == colorBoxMap.begin() )
+
+        if ( allColorsMapped )
         {
-          allColorsMapped = true;
           break;
         }
       }
 
-      if ( allColorsMapped )
+      //get representative colors for the boxes
+      int index = 0;
+      colorTable.resize( colorBoxMap.size() );
+      for ( auto colorBoxIt = colorBoxMap.constBegin(); colorBoxIt != colorBoxMap.constEnd(); ++colorBoxIt )
       {
-        break;
+        colorTable[index] = boxColor( colorBoxIt.value(), colorBoxIt.key() );
+        ++index;
       }
     }
 
-    //get representative colors for the boxes
-    int index = 0;
-    colorTable.resize( colorBoxMap.size() );
-    for ( auto colorBoxIt = colorBoxMap.constBegin(); colorBoxIt != colorBoxMap.constEnd(); ++colorBoxIt )
+  } // namespace
+
+  void medianCut( QVector<QRgb> &colorTable, int nColors, const QImage &inputImage )
+  {
+    QHash<QRgb, int> inputColors;
+    imageColors( inputColors, inputImage );
+    medianCutColors( colorTable, nColors, inputColors );
+  }
+
+  QImage medianCutImage( const QImage &inputImage, int nColors )
+  {
+    QHash<QRgb, int> inputColors;
+    imageColors( inputColors, inputImage );
+
+    QVector<QRgb> colorTable;
+    medianCutColors( colorTable, nColors, inputColors );
+    if ( colorTable.isEmpty() )
+      return QImage();
+
+    // closest color of the table for each distinct color of the image
+    QHash<QRgb, uchar> colorIndexes;
+    colorIndexes.reserve( inputColors.size() );
+    if ( inputColors.size() <= colorTable.size() )
     {
-      colorTable[index] = boxColor( colorBoxIt.value(), colorBoxIt.key() );
-      ++index;
+      for ( int i = 0; i < colorTable.size(); ++i )
+        colorIndexes.insert( colorTable.at( i ), static_cast< uchar >( i ) );
     }
+    else
+    {
+      const QVector<QRgb> colors = inputColors.keys().toVector();
+      QVector<uchar> indexes( colors.size() );
+      const int chunkSize = 4096;
+      QVector<int> chunks;
+      for ( int i = 0; i < colors.size(); i += chunkSize )
+        chunks << i;
+      QtConcurrent::blockingMap( chunks, [&]( int first )
+      {
+        const int last = std::min( first + chunkSize, colors.size() );
+        for ( int i = first; i < last; ++i )
+          indexes[i] = closestColor( colors.at( i ), colorTable );
+      } );
+      for ( int i = 0; i < colors.size(); ++i )
+        colorIndexes.insert( colors.at( i ), indexes.at( i ) );
+    }
+
+    QImage result( inputImage.size(), QImage::Format_Indexed8 );
+    result.setColorTable( colorTable );
+    // the non const accessors of QImage may detach, they are only called from this thread
+    uchar *outputBits = result.bits();
+    const int outputBytesPerLine = result.bytesPerLine();
+    auto convertStripe = [&]( const QPair<int, int> &stripe )
+    {
+      const int width = inputImage.width();
+      if ( width == 0 )
+        return;
+      for ( int i = stripe.first; i < stripe.second; ++i )
+      {
+        const QRgb *inputLine = reinterpret_cast< const QRgb * >( inputImage.constScanLine( i ) );
+        uchar *outputLine = outputBits + static_cast< qsizetype >( i ) * outputBytesPerLine;
+        QRgb previous = inputLine[0];
+        uchar index = colorIndexes.value( previous );
+        for ( int j = 0; j < width; ++j )
+        {
+          if ( inputLine[j] != previous )
+          {
+            previous = inputLine[j];
+            index = colorIndexes.value( previous );
+          }
+          outputLine[j] = index;
+        }
+      }
+    };
+
+    const QVector< QPair<int, int> > stripes = rowStripes( inputImage );
+    if ( stripes.size() == 1 )
+      convertStripe( stripes.first() );
+    else
+      QtConcurrent::blockingMap( stripes, convertStripe );
+
+    return result;
   }
 
 } // namespace QgsWms
@@ -39,6 +39,19 @@ namespace QgsWms
    */
   void medianCut( QVector<QRgb> &colorTable, int nColors, const QImage &inputImage );
 
+  /**
+   * Converts \a inputImage (in QImage::Format_ARGB32) to an 8 bit palettized image,
+   * with a color table of at most \a nColors colors computed by median cut.
+   *
+   * Each pixel gets the closest color of the table, like QImage::convertToFormat()
+   * with Qt::ThresholdDither, but the closest colors are only searched once per
+   * distinct color. The color histogram and the conversion of large images are
+   * spread over the threads of the global thread pool.
+   *
+   * \since QGIS 3.16
+   */
+  QImage medianCutImage( const QImage &inputImage, int nColors );
+
 } // namespace QgsWms
 
 #endif
@@ -21,6 +21,7 @@
 #include "qgswmsutils.h"
 #include "qgswmsgetcapabilities.h"
 #include "qgsserverprojectutils.h"
+#include "qgsserverfeaturecountcache.h"
 
 #include "qgslayoutmanager.h"
 #include "qgslayoutatlas.h"
@@ -100,6 +101,8 @@ namespace QgsWms
 
     QDomDocument doc;
     const QDomDocument *capabilitiesDocument = nullptr;
+    // keeps the document of the cache alive while it is written
+    std::shared_ptr<const QDomDocument> cachedDocument;
 
     // Data for WMS capabilities server memory cache
     QString configFilePath = serverIface->configFilePath();
@@ -124,7 +127,8 @@ namespace QgsWms
 #endif
     if ( !capabilitiesDocument && cache ) //capabilities xml not in cache plugins
     {
-      capabilitiesDocument = capabilitiesCache->searchCapabilitiesDocument( configFilePath, cacheKey );
+      cachedDocument = capabilitiesCache->searchCapabilitiesDocument( configFilePath, cacheKey );
+      capabilitiesDocument = cachedDocument.get();
     }
 
     if ( !capabilitiesDocument ) //capabilities xml not in cache. Create a new one
@@ -145,7 +149,8 @@ namespace QgsWms
       if ( !capabilitiesDocument )
       {
         capabilitiesCache->insertCapabilitiesDocument( configFilePath, cacheKey, &doc );
-        capabilitiesDocument = capabilitiesCache->searchCapabilitiesDocument( configFilePath, cacheKey );
+        cachedDocument = capabilitiesCache->searchCapabilitiesDocument( configFilePath, cacheKey );
+        capabilitiesDocument = cachedDocument.get();
       }
       if ( !capabilitiesDocument )
       {
@@ -1089,11 +1094,11 @@ namespace QgsWms
             appendCrsElementsToLayer( doc, layerElem, crsList, outputCrsList );
 
             //Ex_GeographicBoundingBox
-            QgsRectangle extent = l->extent();  // layer extent by default
+            QgsRectangle extent = QgsServerFeatureCountCache::instance()->extent( l );  // layer extent by default
             if ( l->type() == QgsMapLayerType::VectorLayer )
             {
               QgsVectorLayer *vl = qobject_cast<QgsVectorLayer *>( l );
-              if ( vl && vl->featureCount() == 0 )
+              if ( vl && QgsServerFeatureCountCache::instance()->featureCount( vl ) == 0 )
               {
                 // if there's no feature, use the wms extent defined in the
                 // project...
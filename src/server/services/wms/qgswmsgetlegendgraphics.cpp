@@ -24,6 +24,7 @@
 #include "qgsvectorlayerfeaturecounter.h"
 #include "qgssymbollayerutils.h"
 #include "qgsmaplayerlegend.h"
+#include "qgsserverprojectlocker.h"
 
 #include "qgswmsutils.h"
 #include "qgswmsserviceexception.h"
@@ -113,6 +114,10 @@ namespace QgsWms
 #endif
     QgsRenderer renderer( context );
 
+    // the legend model reads the layers and may count their features, it is locked
+    // in the same mode as the renderer restorer
+    const QgsServerProjectLocker locker( project, context.changesLayers() ? QgsServerProjectLocker::Exclusive : QgsServerProjectLocker::Shared );
+
     // retrieve legend settings and model
     std::unique_ptr<QgsLayerTree> tree( layerTree( context ) );
     std::unique_ptr<QgsLayerTreeModel> model( legendModel( context, *tree.get() ) );
@@ -150,7 +155,7 @@ namespace QgsWms
       tree->clear();
       if ( result )
       {
-        writeImage( response, *result, parameters.formatAsString(), context.imageQuality() );
+        writeImage( response, *result, parameters.formatAsString(), context.imageQuality(), context.settings().pngCompressionLevel() );
 #ifdef HAVE_SERVER_PYTHON_PLUGINS
         if ( cacheManager )
         {
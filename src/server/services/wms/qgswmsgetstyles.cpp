@@ -23,6 +23,7 @@
 #include "qgswmsutils.h"
 #include "qgswmsserviceexception.h"
 #include "qgswmsgetstyles.h"
+#include "qgsserverprojectlocker.h"
 #include "qgsserverprojectutils.h"
 
 #include "qgsproject.h"
@@ -181,6 +182,8 @@ namespace QgsWms
           QgsVectorLayer *vlayer = qobject_cast<QgsVectorLayer *>( layer );
           if ( vlayer->isSpatial() )
           {
+            // the styles are exported by making them current, which other requests must not see
+            const QgsServerProjectLocker locker( project, QgsServerProjectLocker::Exclusive );
             QString currentStyle = vlayer->styleManager()->currentStyle();
 
             QgsStringMap props;
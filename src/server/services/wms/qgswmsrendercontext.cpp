@@ -17,10 +17,12 @@
 
 #include "qgslayertree.h"
 
+#include "qgsmaplayerstylemanager.h"
 #include "qgsrasterlayer.h"
 #include "qgswmsrendercontext.h"
 #include "qgswmsserviceexception.h"
 #include "qgsserverprojectutils.h"
+#include "qgsconfigcache.h"
 
 using namespace QgsWms;
 
@@ -49,6 +51,9 @@ void QgsWmsRenderContext::setParameters( const QgsWmsParameters &parameters )
   removeUnwantedLayers();
   checkLayerReadPermissions();
 
+  // load the layers which have been read lazily
+  QgsConfigCache::instance()->resolveLayers( mLayersToRender );
+
   std::reverse( mLayersToRender.begin(), mLayersToRender.end() );
 }
 
@@ -258,6 +263,34 @@ bool QgsWmsRenderContext::updateExtent() const
   return update;
 }
 
+bool QgsWmsRenderContext::changesLayers() const
+{
+  if ( !mParameters.sldBody().isEmpty() || mParameters.showFeatureCountAsBool() )
+    return true;
+
+  for ( auto it = mStyles.constBegin(); it != mStyles.constEnd(); ++it )
+  {
+    for ( const QgsMapLayer *layer : mNicknameLayers.values( it.key() ) )
+    {
+      if ( layer->styleManager()->currentStyle() != it.value() )
+        return true;
+    }
+  }
+
+  for ( const QgsWmsParametersLayer &param : mParameters.layersParameters() )
+  {
+    if ( !param.mExternalUri.isEmpty() )
+      continue;
+
+    if ( ( testFlag( UseOpacity ) && param.mOpacity >= 0 ) ||
+         ( testFlag( UseFilter ) && !param.mFilter.isEmpty() ) ||
+         ( testFlag( UseSelection ) && !param.mSelection.isEmpty() ) )
+      return true;
+  }
+
+  return false;
+}
+
 QString QgsWmsRenderContext::layerNickname( const QgsMapLayer &layer ) const
 {
   QString name = layer.shortName();
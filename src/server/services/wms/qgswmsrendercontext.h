@@ -137,6 +137,14 @@ namespace QgsWms
        */
       bool updateExtent() const;
 
+      /**
+       * Returns TRUE if rendering the request temporarily changes the layers of the
+       * project (their style, opacity, filter, selection or feature counts), FALSE
+       * if it only reads them.
+       * \since QGIS 3.16
+       */
+      bool changesLayers() const;
+
       /**
        * Returns WMS parameters for a specific layer. An empty instance is
        * returned if not available.
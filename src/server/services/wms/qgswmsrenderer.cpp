@@ -46,6 +46,9 @@
 #include "qgsrenderer.h"
 #include "qgsfeature.h"
 #include "qgsaccesscontrol.h"
+#include "qgsconfigcache.h"
+#include "qgsruntimeprofiler.h"
+#include "qgsservermetrics.h"
 #include "qgsfeaturerequest.h"
 #include "qgsmaprendererjobproxy.h"
 #include "qgswmsserviceexception.h"
@@ -71,6 +74,7 @@
 #include <QTemporaryFile>
 #include <QDir>
 #include <QUrl>
+#include <QtConcurrent>
 #include <nlohmann/json.hpp>
 
 //for printing
@@ -284,9 +288,13 @@ namespace QgsWms
 
   QByteArray QgsRenderer::getPrint()
   {
-    // init layer restorer before doing anything
+    // layouts may reference any layer of the project
+    QgsConfigCache::instance()->resolveLayers( mProject->mapLayers().values() );
+
+    // init layer restorer before doing anything, the layouts and their
+    // atlas change the layers and are cloned from the shared project
     std::unique_ptr<QgsWmsRestorer> restorer;
-    restorer.reset( new QgsWmsRestorer( mContext ) );
+    restorer.reset( new QgsWmsRestorer( mContext, true ) );
 
     // GetPrint request needs a template parameter
     const QString templateName = mWmsParameters.composerTemplate();
@@ -482,6 +490,9 @@ namespace QgsWms
       exportSettings.dpi = dpi;
       // Draw selections
       exportSettings.flags |= QgsLayoutRenderContext::FlagDrawSelection;
+      // Render the map items at the same time
+      if ( mContext.settings().parallelRendering() )
+        exportSettings.flags |= QgsLayoutRenderContext::FlagRenderMapsInParallel;
       // Destination image size in px
       QgsLayoutSize layoutSize( layout->pageCollection()->page( 0 )->sizeWithUnits() );
       QgsLayoutMeasurement width( layout->convertFromLayoutUnits( layoutSize.width(), QgsUnitTypes::LayoutUnit::LayoutMillimeters ) );
@@ -519,6 +530,9 @@ namespace QgsWms
       }
       // Draw selections
       exportSettings.flags |= QgsLayoutRenderContext::FlagDrawSelection;
+      // Render the map items at the same time when the pages are rasterized
+      if ( mContext.settings().parallelRendering() )
+        exportSettings.flags |= QgsLayoutRenderContext::FlagRenderMapsInParallel;
       // Print as raster
       exportSettings.rasterizeWholeImage = layout->customProperty( QStringLiteral( "rasterize" ), false ).toBool();
 
@@ -1116,6 +1130,7 @@ namespace QgsWms
 
     // enable rendering optimization
     mapSettings.setFlag( QgsMapSettings::UseRenderingOptimization );
+    mapSettings.setFlag( QgsMapSettings::GpuRendering, mContext.settings().gpuRendering() );
 
     // set selection color
     mapSettings.setSelectionColor( mProject->selectionColor() );
@@ -1224,6 +1239,31 @@ namespace QgsWms
     //layers can have assigned a different name for GetCapabilities
     QHash<QString, QString> layerAliasMap = QgsServerProjectUtils::wmsFeatureInfoLayerAliasMap( *mProject );
 
+    // identify the raster layers concurrently, their results are merged in layer order below
+    QHash<const QgsRasterLayer *, QgsRasterIdentifyResult> rasterResults;
+    if ( infoPoint && mContext.settings().parallelRendering() )
+    {
+      QList<QgsRasterLayer *> rasterLayers;
+      for ( const QString &queryLayer : queryLayers )
+      {
+        for ( QgsMapLayer *layer : qgis::as_const( layers ) )
+        {
+          if ( queryLayer != mContext.layerNickname( *layer ) )
+            continue;
+
+          QgsRasterLayer *rasterLayer = qobject_cast<QgsRasterLayer *>( layer );
+          if ( rasterLayer && layer->flags().testFlag( QgsMapLayer::Identifiable ) && !rasterLayers.contains( rasterLayer )
+               && rasterLayer->extent().contains( mapSettings.mapToLayerCoordinates( layer, *infoPoint ) ) )
+          {
+            rasterLayers << rasterLayer;
+          }
+          break;
+        }
+      }
+      if ( rasterLayers.size() > 1 )
+        rasterResults = identifyRasterLayers( rasterLayers, mapSettings, *infoPoint );
+    }
+
     for ( const QString &queryLayer : queryLayers )
     {
       bool validLayer = false;
@@ -1295,7 +1335,9 @@ namespace QgsWms
               getFeatureInfoElement.appendChild( layerElement );
             }
 
-            ( void )featureInfoFromRasterLayer( rasterLayer, mapSettings, &layerInfoPoint, result, layerElement, version );
+            const auto rasterResult = rasterResults.constFind( rasterLayer );
+            ( void )featureInfoFromRasterLayer( rasterLayer, mapSettings, &layerInfoPoint, result, layerElement, version,
+                                                rasterResult != rasterResults.constEnd() ? &rasterResult.value() : nullptr );
           }
           break;
         }
@@ -1407,6 +1449,7 @@ namespace QgsWms
       return false;
     }
 
+    QgsScopedRuntimeProfile profile( QStringLiteral( "features:%1" ).arg( mContext.layerNickname( *layer ) ), QgsServerMetrics::profilerGroup() );
     QgsFeatureRequest fReq;
 
     // Transform filter geometry to layer CRS
@@ -1661,12 +1704,96 @@ namespace QgsWms
     return true;
   }
 
+  QgsRaster::IdentifyFormat QgsRenderer::rasterIdentifyFormat( const QgsRasterLayer *layer )
+  {
+    const int capabilities = layer->dataProvider()->capabilities();
+    if ( capabilities & QgsRasterDataProvider::IdentifyFeature )
+      return QgsRaster::IdentifyFormatFeature;
+    else if ( capabilities & QgsRasterDataProvider::IdentifyValue )
+      return QgsRaster::IdentifyFormatValue;
+    return QgsRaster::IdentifyFormatUndefined;
+  }
+
+  QgsRectangle QgsRenderer::rasterIdentifyExtent( const QgsRasterLayer *layer, const QgsMapSettings &mapSettings ) const
+  {
+    if ( layer->crs() == mapSettings.destinationCrs() )
+      return mapSettings.extent();
+
+    const QgsCoordinateTransform transform { mapSettings.destinationCrs(), layer->crs(), mapSettings.transformContext() };
+    if ( ! transform.isValid() )
+    {
+      throw QgsBadRequestException( QgsServiceException::OGC_InvalidCRS, QStringLiteral( "CRS transform error from %1 to %2 in layer %3" )
+                                    .arg( mapSettings.destinationCrs().authid() )
+                                    .arg( layer->crs().authid() )
+                                    .arg( layer->name() ) );
+    }
+    return transform.transform( mapSettings.extent() );
+  }
+
+  QHash<const QgsRasterLayer *, QgsRasterIdentifyResult> QgsRenderer::identifyRasterLayers( const QList<QgsRasterLayer *> &layers,
+      const QgsMapSettings &mapSettings,
+      const QgsPointXY &infoPoint ) const
+  {
+    struct IdentifyJob
+    {
+      const QgsRasterLayer *layer = nullptr;
+      const QgsRasterDataProvider *provider = nullptr;
+      QgsPointXY point;
+      QgsRaster::IdentifyFormat format = QgsRaster::IdentifyFormatUndefined;
+      QgsRectangle extent;
+      QgsRasterIdentifyResult result;
+      bool identified = false;
+    };
+
+    // transforms and formats are computed upfront, errors are raised from the request thread
+    QVector<IdentifyJob> jobs;
+    for ( const QgsRasterLayer *layer : layers )
+    {
+      if ( !layer || !layer->dataProvider() )
+        continue;
+
+      IdentifyJob job;
+      job.format = rasterIdentifyFormat( layer );
+      if ( job.format == QgsRaster::IdentifyFormatUndefined )
+        continue;
+
+      job.layer = layer;
+      job.provider = layer->dataProvider();
+      job.point = mapSettings.mapToLayerCoordinates( layer, infoPoint );
+      job.extent = rasterIdentifyExtent( layer, mapSettings );
+      jobs.append( job );
+    }
+
+    const int width = mapSettings.outputSize().width();
+    const int height = mapSettings.outputSize().height();
+    QtConcurrent::blockingMap( jobs, [width, height]( IdentifyJob & job )
+    {
+      // the clone is created in the pool thread, so that the network replies of the
+      // provider are handled by the event loop of this thread
+      std::unique_ptr<QgsRasterDataProvider> provider( dynamic_cast<QgsRasterDataProvider *>( job.provider->clone() ) );
+      if ( provider )
+      {
+        job.result = provider->identify( job.point, job.format, job.extent, width, height );
+        job.identified = true;
+      }
+    } );
+
+    QHash<const QgsRasterLayer *, QgsRasterIdentifyResult> results;
+    for ( const IdentifyJob &job : qgis::as_const( jobs ) )
+    {
+      if ( job.identified )
+        results.insert( job.layer, job.result );
+    }
+    return results;
+  }
+
   bool QgsRenderer::featureInfoFromRasterLayer( QgsRasterLayer *layer,
       const QgsMapSettings &mapSettings,
       const QgsPointXY *infoPoint,
       QDomDocument &infoDocument,
       QDomElement &layerElement,
-      const QString &version ) const
+      const QString &version,
+      const QgsRasterIdentifyResult *prefetchedResult ) const
   {
     Q_UNUSED( version )
 
@@ -1677,35 +1804,14 @@ namespace QgsWms
 
     QgsMessageLog::logMessage( QStringLiteral( "infoPoint: %1 %2" ).arg( infoPoint->x() ).arg( infoPoint->y() ) );
 
-    if ( !( layer->dataProvider()->capabilities() & QgsRasterDataProvider::IdentifyValue ) &&
-         !( layer->dataProvider()->capabilities() & QgsRasterDataProvider::IdentifyFeature ) )
+    const QgsRaster::IdentifyFormat identifyFormat = rasterIdentifyFormat( layer );
+    if ( identifyFormat == QgsRaster::IdentifyFormatUndefined )
     {
       return false;
     }
 
-    const QgsRaster::IdentifyFormat identifyFormat(
-      static_cast<bool>( layer->dataProvider()->capabilities() & QgsRasterDataProvider::IdentifyFeature )
-      ? QgsRaster::IdentifyFormat::IdentifyFormatFeature
-      : QgsRaster::IdentifyFormat::IdentifyFormatValue );
-
-    QgsRasterIdentifyResult identifyResult;
-    if ( layer->crs() != mapSettings.destinationCrs() )
-    {
-      const QgsRectangle extent { mapSettings.extent() };
-      const QgsCoordinateTransform transform { mapSettings.destinationCrs(), layer->crs(), mapSettings.transformContext() };
-      if ( ! transform.isValid() )
-      {
-        throw QgsBadRequestException( QgsServiceException::OGC_InvalidCRS, QStringLiteral( "CRS transform error from %1 to %2 in layer %3" )
-                                      .arg( mapSettings.destinationCrs().authid() )
-                                      .arg( layer->crs().authid() )
-                                      .arg( layer->name() ) );
-      }
-      identifyResult = layer->dataProvider()->identify( *infoPoint, identifyFormat, transform.transform( extent ), mapSettings.outputSize().width(), mapSettings.outputSize().height() );
-    }
-    else
-    {
-      identifyResult = layer->dataProvider()->identify( *infoPoint, identifyFormat, mapSettings.extent(), mapSettings.outputSize().width(), mapSettings.outputSize().height() );
-    }
+    const QgsRasterIdentifyResult identifyResult = prefetchedResult ? *prefetchedResult
+        : layer->dataProvider()->identify( *infoPoint, identifyFormat, rasterIdentifyExtent( layer, mapSettings ), mapSettings.outputSize().width(), mapSettings.outputSize().height() );
 
     if ( !identifyResult.isValid() )
       return false;
@@ -2554,7 +2660,7 @@ namespace QgsWms
       }
 
       // create vector layer
-      const QgsVectorLayer::LayerOptions options { QgsProject::instance()->transformContext() };
+      const QgsVectorLayer::LayerOptions options { mProject->transformContext() };
       std::unique_ptr<QgsVectorLayer> layer = qgis::make_unique<QgsVectorLayer>( url, param.mName, QLatin1String( "memory" ), options );
       if ( !layer->isValid() )
       {
@@ -2686,9 +2792,13 @@ namespace QgsWms
     QgsFeatureFilterProviderGroup filters;
     filters.addProvider( &mFeatureFilter );
 #ifdef HAVE_SERVER_PYTHON_PLUGINS
-    mContext.accessControl()->resolveFilterFeatures( mapSettings.layers() );
+    {
+      QgsScopedRuntimeProfile profile( QStringLiteral( "access_control" ), QgsServerMetrics::profilerGroup() );
+      mContext.accessControl()->resolveFilterFeatures( mapSettings.layers() );
+    }
     filters.addProvider( mContext.accessControl() );
 #endif
+    QgsScopedRuntimeProfile profile( QStringLiteral( "render" ), QgsServerMetrics::profilerGroup() );
     QgsMapRendererJobProxy renderJob( mContext.settings().parallelRendering(), mContext.settings().maxThreads(), &filters );
     renderJob.render( mapSettings, &image );
     painter = renderJob.takePainter();
@@ -3016,6 +3126,7 @@ namespace QgsWms
   void QgsRenderer::setLayerAccessControlFilter( QgsMapLayer *layer ) const
   {
 #ifdef HAVE_SERVER_PYTHON_PLUGINS
+    QgsScopedRuntimeProfile profile( QStringLiteral( "access_control" ), QgsServerMetrics::profilerGroup() );
     QgsOWSServerFilterRestorer::applyAccessControlLayerFilters( mContext.accessControl(), layer );
 #else
     Q_UNUSED( layer )
@@ -3087,6 +3198,7 @@ namespace QgsWms
 
   void QgsRenderer::configureLayers( QList<QgsMapLayer *> &layers, QgsMapSettings *settings )
   {
+    QgsScopedRuntimeProfile profile( QStringLiteral( "layers" ), QgsServerMetrics::profilerGroup() );
     const bool useSld = !mContext.parameters().sldBody().isEmpty();
 
     for ( auto layer : layers )
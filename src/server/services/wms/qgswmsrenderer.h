@@ -25,7 +25,10 @@
 #include "qgswmsrendercontext.h"
 #include "qgsfeaturefilter.h"
 #include "qgslayertreemodellegendnode.h"
+#include "qgsraster.h"
+#include "qgsrasteridentifyresult.h"
 #include <QDomDocument>
+#include <QHash>
 #include <QMap>
 #include <QString>
 
@@ -221,13 +224,36 @@ namespace QgsWms
                                        QgsRectangle *featureBBox = nullptr,
                                        QgsGeometry *filterGeom = nullptr ) const;
 
-      //! Appends feature info xml for the layer to the layer element of the dom document
+      /**
+       * Appends feature info xml for the layer to the layer element of the dom document.
+       * If \a prefetchedResult is not NULLPTR, it is used instead of querying the provider
+       * of the layer.
+       */
       bool featureInfoFromRasterLayer( QgsRasterLayer *layer,
                                        const QgsMapSettings &mapSettings,
                                        const QgsPointXY *infoPoint,
                                        QDomDocument &infoDocument,
                                        QDomElement &layerElement,
-                                       const QString &version ) const;
+                                       const QString &version,
+                                       const QgsRasterIdentifyResult *prefetchedResult = nullptr ) const;
+
+      //! Returns the identify format supported by the provider of \a layer, or QgsRaster::IdentifyFormatUndefined
+      static QgsRaster::IdentifyFormat rasterIdentifyFormat( const QgsRasterLayer *layer );
+
+      //! Returns the map extent in the CRS of the raster \a layer, for identify requests
+      QgsRectangle rasterIdentifyExtent( const QgsRasterLayer *layer, const QgsMapSettings &mapSettings ) const;
+
+      /**
+       * Identifies the raster \a layers concurrently, at the point \a infoPoint in map coordinates.
+       *
+       * Each layer is identified on a clone of its data provider in a thread of the global
+       * thread pool, so that the latencies of network bound providers (e.g. remote WMS
+       * layers) do not add up. Layers whose provider cannot be cloned are not part of
+       * the returned results.
+       */
+      QHash<const QgsRasterLayer *, QgsRasterIdentifyResult> identifyRasterLayers( const QList<QgsRasterLayer *> &layers,
+          const QgsMapSettings &mapSettings,
+          const QgsPointXY &infoPoint ) const;
 
       //! Record which symbols would be used if the map was in the current configuration of renderer. This is useful for content-based legend
       void runHitTest( const QgsMapSettings &mapSettings, HitTest &hitTest ) const;
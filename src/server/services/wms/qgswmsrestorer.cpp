@@ -121,8 +121,11 @@ QgsLayerRestorer::~QgsLayerRestorer()
 
 namespace QgsWms
 {
-  QgsWmsRestorer::QgsWmsRestorer( const QgsWmsRenderContext &context )
-    : mLayerRestorer( context.layers() )
+  QgsWmsRestorer::QgsWmsRestorer( const QgsWmsRenderContext &context, bool exclusive )
+    : mLocker( context.project(), exclusive || context.changesLayers() ? QgsServerProjectLocker::Exclusive : QgsServerProjectLocker::Shared )
   {
+    // layers which are only read are left untouched, as other requests may read them concurrently
+    if ( mLocker.mode() == QgsServerProjectLocker::Exclusive )
+      mLayerRestorer = qgis::make_unique<QgsLayerRestorer>( context.layers() );
   }
 }
@@ -18,11 +18,13 @@
 #ifndef QGSWMSRESTORER_H
 #define QGSWMSRESTORER_H
 
+#include <memory>
 #include <QList>
 #include <QDomDocument>
 #include <QMap>
 
 #include "qgsfeatureid.h"
+#include "qgsserverprojectlocker.h"
 #include "qgswmsrendercontext.h"
 
 class QgsMapLayer;
@@ -70,6 +72,9 @@ namespace QgsWms
   /**
    * \ingroup server
    * RAII class to restore the rendering context configuration on destruction
+   *
+   * The project of the context is locked until the layers are restored, exclusively
+   * if the request changes its layers (see QgsWmsRenderContext::changesLayers()).
    * \since QGIS 3.14
    */
   class QgsWmsRestorer
@@ -79,8 +84,9 @@ namespace QgsWms
       /**
        * Constructor for QgsWmsRestorer.
        * \param context The rendering context to restore in its initial state
+       * \param exclusive TRUE to lock the project exclusively whatever the parameters of the request (since QGIS 3.16)
        */
-      QgsWmsRestorer( const QgsWmsRenderContext &context );
+      QgsWmsRestorer( const QgsWmsRenderContext &context, bool exclusive = false );
 
       /**
        * Default destructor.
@@ -89,7 +95,9 @@ namespace QgsWms
 
     private:
 
-      QgsLayerRestorer mLayerRestorer;
+      // the lock is released once the layers are restored
+      QgsServerProjectLocker mLocker;
+      std::unique_ptr<QgsLayerRestorer> mLayerRestorer;
   };
 };
 
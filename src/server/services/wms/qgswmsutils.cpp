@@ -21,11 +21,15 @@
 
 #include <QRegularExpression>
 
+#include <algorithm>
+
 #include "qgsmodule.h"
 #include "qgswmsutils.h"
 #include "qgsmediancut.h"
 #include "qgsserverprojectutils.h"
 #include "qgswmsserviceexception.h"
+#include "qgsruntimeprofiler.h"
+#include "qgsservermetrics.h"
 
 namespace QgsWms
 {
@@ -105,8 +109,9 @@ namespace QgsWms
 
   // Write image response
   void writeImage( QgsServerResponse &response, QImage &img, const QString &formatStr,
-                   int imageQuality )
+                   int imageQuality, int pngCompressionLevel )
   {
+    QgsScopedRuntimeProfile profile( QStringLiteral( "encode" ), QgsServerMetrics::profilerGroup() );
     ImageOutputFormat outputFormat = parseImageFormat( formatStr );
     QImage  result;
     QString saveFormat;
@@ -120,16 +125,11 @@ namespace QgsWms
         break;
       case PNG8:
       {
-        QVector<QRgb> colorTable;
-
         // Rendering is made with the format QImage::Format_ARGB32_Premultiplied
         // So we need to convert it in QImage::Format_ARGB32 in order to properly build
         // the color table.
-        QImage img256 = img.convertToFormat( QImage::Format_ARGB32 );
-        medianCut( colorTable, 256, img256 );
-        result = img256.convertToFormat( QImage::Format_Indexed8, colorTable,
-                                         Qt::ColorOnly | Qt::ThresholdDither |
-                                         Qt::ThresholdAlphaDither | Qt::NoOpaqueDetection );
+        const QImage img256 = img.convertToFormat( QImage::Format_ARGB32 );
+        result = medianCutImage( img256, 256 );
       }
       contentType = "image/png";
       saveFormat = "PNG";
@@ -152,6 +152,7 @@ namespace QgsWms
         saveFormat = "JPEG";
         break;
       case WEBP:
+        result = img;
         contentType = QStringLiteral( "image/webp" );
         saveFormat = QStringLiteral( "WEBP" );
         break;
@@ -172,6 +173,11 @@ namespace QgsWms
       {
         result.save( response.io(), qPrintable( saveFormat ), imageQuality );
       }
+      else if ( pngCompressionLevel >= 0 )
+      {
+        // the PNG writer maps the quality [0, 100] to the zlib compression level [9, 0]
+        result.save( response.io(), qPrintable( saveFormat ), ( 9 - std::min( pngCompressionLevel, 9 ) ) * 91 / 9 );
+      }
       else
       {
         result.save( response.io(), qPrintable( saveFormat ) );
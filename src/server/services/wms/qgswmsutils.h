@@ -60,9 +60,14 @@ namespace QgsWms
 
   /**
    * Write image response
+   * \param response the response
+   * \param img the image to write
+   * \param formatStr the requested format
+   * \param imageQuality the quality of the JPEG and WEBP images, -1 for the default quality
+   * \param pngCompressionLevel the zlib compression level (0-9) of the PNG images, -1 for the default level
    */
   void writeImage( QgsServerResponse &response, QImage &img, const QString &formatStr,
-                   int imageQuality = -1 );
+                   int imageQuality = -1, int pngCompressionLevel = -1 );
 } // namespace QgsWms
 
 #endif
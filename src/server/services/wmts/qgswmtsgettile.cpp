@@ -17,11 +17,126 @@
 #include "qgswmtsutils.h"
 #include "qgswmtsparameters.h"
 #include "qgswmtsgettile.h"
+#include "qgswmtstilecache.h"
+#include "qgsbufferserverresponse.h"
+#include "qgsserversettings.h"
+#include "qgsserverprojectutils.h"
 
 #include <QImage>
+#include <QMutex>
+#include <QSet>
+#include <QWaitCondition>
 
 namespace QgsWmts
 {
+  namespace
+  {
+    //! Metatiles being rendered, other requests for the same metatile wait for them
+    QSet<QString> sRenderingMetatiles;
+    QMutex sMetatilesMutex;
+    QWaitCondition sMetatileRendered;
+
+    /**
+     * Removes a metatile from the metatiles being rendered and wakes up the
+     * requests waiting for it when destroyed, whatever the way the rendering ends.
+     */
+    class RenderingMetatileGuard
+    {
+      public:
+        explicit RenderingMetatileGuard( const QString &key )
+          : mKey( key )
+        {}
+
+        ~RenderingMetatileGuard()
+        {
+          QMutexLocker locker( &sMetatilesMutex );
+          sRenderingMetatiles.remove( mKey );
+          sMetatileRendered.wakeAll();
+        }
+
+        RenderingMetatileGuard( const RenderingMetatileGuard & ) = delete;
+        RenderingMetatileGuard &operator=( const RenderingMetatileGuard & ) = delete;
+
+      private:
+        QString mKey;
+    };
+
+    /**
+     * Renders the metatile containing the requested tile, stores all its tiles in
+     * the tile cache and returns the content of the requested tile. An empty array
+     * is returned if the metatile cannot be rendered, e.g. because it exceeds the
+     * maximum size of a WMS request.
+     */
+    QByteArray renderMetatile( QgsServerInterface *serverIface, const QgsProject *project,
+                               const QgsWmtsParameters &params, const QUrlQuery &tileQuery,
+                               const QgsWmtsTileCache &tileCache, const QStringList &tileCacheKeys,
+                               int metatileSize )
+    {
+      const QgsServerSettings *settings = serverIface->serverSettings();
+      const metatileDef metatile = translateWmtsParamToWmsMetatile( params, metatileSize, settings->wmtsMetatileBuffer(), project, serverIface );
+
+      const QString metatileKey = QStringList( { project->fileName(), metatile.query.toString( QUrl::FullyDecoded ) } + tileCacheKeys ).join( '\n' );
+      {
+        QMutexLocker locker( &sMetatilesMutex );
+        if ( sRenderingMetatiles.contains( metatileKey ) )
+        {
+          // Another request is rendering the same metatile, wait for its tiles
+          while ( sRenderingMetatiles.contains( metatileKey ) )
+            sMetatileRendered.wait( &sMetatilesMutex );
+
+          locker.unlock();
+          const QByteArray content = tileCache.tile( project, params, tileQuery, tileCacheKeys );
+          if ( !content.isEmpty() )
+            return content;
+          locker.relock();
+        }
+        sRenderingMetatiles.insert( metatileKey );
+      }
+      const RenderingMetatileGuard guard( metatileKey );
+
+      QgsBufferServerResponse metatileResponse;
+      QgsServerParameters wmsParams( metatile.query );
+      QgsServerRequest wmsRequest( "?" + metatile.query.query( QUrl::FullyDecoded ) );
+      QgsService *service = serverIface->serviceRegistry()->getService( wmsParams.service(), wmsParams.version() );
+
+      QImage metatileImage;
+      try
+      {
+        service->executeRequest( wmsRequest, metatileResponse, project );
+        if ( metatileResponse.statusCode() == 200 &&
+             metatileResponse.header( QStringLiteral( "Content-Type" ) ).startsWith( QLatin1String( "image/" ) ) )
+        {
+          metatileImage.loadFromData( metatileResponse.data() );
+        }
+      }
+      catch ( QgsException & )
+      {
+        // fall back to single tile rendering
+      }
+
+      const QList< QByteArray > tiles = splitMetatile( metatileImage, metatile, params.format(),
+                                        QgsServerProjectUtils::wmsImageQuality( *project ),
+                                        settings->pngCompressionLevel() );
+      if ( tiles.isEmpty() )
+        return QByteArray();
+
+      QByteArray content;
+      for ( int row = 0; row < metatile.rowCount; ++row )
+      {
+        for ( int col = 0; col < metatile.colCount; ++col )
+        {
+          const QByteArray &tileContent = tiles.at( row * metatile.colCount + col );
+          const int tileRow = metatile.minRow + row;
+          const int tileCol = metatile.minCol + col;
+          tileCache.setTile( project, params, tileRow, tileCol, tileQuery, tileContent, tileCacheKeys );
+          if ( tileRow == params.tileRowAsInt() && tileCol == params.tileColAsInt() )
+            content = tileContent;
+        }
+      }
+
+      return content;
+    }
+  }
 
   void writeGetTile( QgsServerInterface *serverIface, const QgsProject *project,
                      const QString &version, const QgsServerRequest &request,
@@ -66,10 +181,56 @@ namespace QgsWmts
     }
 #endif
 
-    QgsServerParameters wmsParams( query );
-    QgsServerRequest wmsRequest( "?" + query.query( QUrl::FullyDecoded ) );
-    QgsService *service = serverIface->serviceRegistry()->getService( wmsParams.service(), wmsParams.version() );
-    service->executeRequest( wmsRequest, response, project );
+    // Get tile from the persistent tile cache
+    const QgsWmtsTileCache tileCache( serverIface );
+    QStringList tileCacheKeys;
+    bool useTileCache = tileCache.isEnabled();
+#ifdef HAVE_SERVER_PYTHON_PLUGINS
+    if ( useTileCache && accessControl )
+    {
+      useTileCache = accessControl->fillCacheKey( tileCacheKeys );
+    }
+#endif
+    if ( useTileCache )
+    {
+      const QByteArray content = tileCache.tile( project, params, query, tileCacheKeys );
+      if ( !content.isEmpty() )
+      {
+        response.setHeader( QStringLiteral( "Content-Type" ),
+                            params.format() == QgsWmtsParameters::Format::JPG ? QStringLiteral( "image/jpeg" ) : QStringLiteral( "image/png" ) );
+        response.write( content );
+        return;
+      }
+    }
+
+    // Render the whole metatile, its tiles are stored in the tile cache
+    const int metatileSize = serverIface->serverSettings()->wmtsMetatileSize();
+    QByteArray metatileContent;
+    if ( useTileCache && metatileSize > 1 )
+    {
+      metatileContent = renderMetatile( serverIface, project, params, query, tileCache, tileCacheKeys, metatileSize );
+    }
+
+    if ( !metatileContent.isEmpty() )
+    {
+      response.setHeader( QStringLiteral( "Content-Type" ),
+                          params.format() == QgsWmtsParameters::Format::JPG ? QStringLiteral( "image/jpeg" ) : QStringLiteral( "image/png" ) );
+      response.write( metatileContent );
+    }
+    else
+    {
+      QgsServerParameters wmsParams( query );
+      QgsServerRequest wmsRequest( "?" + query.query( QUrl::FullyDecoded ) );
+      QgsService *service = serverIface->serviceRegistry()->getService( wmsParams.service(), wmsParams.version() );
+      service->executeRequest( wmsRequest, response, project );
+
+      // Only successfully rendered images are stored, not service exceptions
+      if ( useTileCache && response.statusCode() == 200 &&
+           response.header( QStringLiteral( "Content-Type" ) ).startsWith( QLatin1String( "image/" ) ) )
+      {
+        tileCache.setTile( project, params, query, response.data(), tileCacheKeys );
+      }
+    }
 #ifdef HAVE_SERVER_PYTHON_PLUGINS
     if ( cacheManager )
     {
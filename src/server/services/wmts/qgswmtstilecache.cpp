@@ -0,0 +1,289 @@
+/***************************************************************************
+                              qgswmtstilecache.cpp
+                              --------------------
+  begin                : October 2020
+  copyright            : (C) 2020 by the QGIS project
+  email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgswmtstilecache.h"
+#include "qgswmtsparameters.h"
+#include "qgsconfigcache.h"
+#include "qgsmessagelog.h"
+#include "qgsproject.h"
+#include "qgsserverinterface.h"
+#include "qgsserversettings.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <mutex>
+
+namespace QgsWmts
+{
+  namespace
+  {
+    //! Name of the file recording the modification time of the project the tiles were rendered from
+    const QString PROJECT_STAMP_FILE = QStringLiteral( "project.stamp" );
+
+    //! Project stamps already checked by this process, by project directory
+    QHash<QString, QDateTime> sCheckedStamps;
+    QMutex sStampsMutex;
+
+    //! Size of the tiles stored in each size limited cache directory, computed on the first write
+    QHash<QString, qint64> sCacheSizes;
+    QMutex sSizesMutex;
+
+    //! Ratio of the maximum size the cache is trimmed to, so that it is not scanned on each write once full
+    const double TRIM_RATIO = 0.9;
+
+    QString hashString( const QString &value )
+    {
+      return QString::fromLatin1( QCryptographicHash::hash( value.toUtf8(), QCryptographicHash::Sha1 ).toHex() );
+    }
+
+    struct TileFile
+    {
+      QString path;
+      qint64 size;
+      QDateTime lastModified;
+    };
+  }
+
+  QgsWmtsTileCache::QgsWmtsTileCache( const QString &directory, qint64 maxSize )
+    : mDirectory( directory )
+    , mMaxSize( std::max( static_cast< qint64 >( 0 ), maxSize ) )
+  {
+  }
+
+  QgsWmtsTileCache::QgsWmtsTileCache( QgsServerInterface *serverIface )
+    : QgsWmtsTileCache( serverIface->serverSettings()->wmtsTileCacheDirectory(), serverIface->serverSettings()->wmtsTileCacheSize() )
+  {
+    if ( mDirectory.isEmpty() )
+      return;
+
+    // Discard the tiles when the config cache detects a project change
+    static std::once_flag sConnected;
+    QgsServerSettings *settings = serverIface->serverSettings();
+    std::call_once( sConnected, [settings]
+    {
+      QObject::connect( QgsConfigCache::instance(), &QgsConfigCache::projectRemovedFromCache, QgsConfigCache::instance(), [settings]( const QString & path )
+      {
+        const QString directory = settings->wmtsTileCacheDirectory();
+        if ( !directory.isEmpty() )
+          QgsWmtsTileCache::invalidate( directory, path );
+      }, Qt::DirectConnection );
+    } );
+  }
+
+  QByteArray QgsWmtsTileCache::tile( const QgsProject *project, const QgsWmtsParameters &params,
+                                     const QUrlQuery &wmsQuery, const QStringList &extraKeys ) const
+  {
+    if ( !isEnabled() )
+      return QByteArray();
+
+    checkProjectStamp( project );
+
+    QFile file( tilePath( project, params, params.tileRowAsInt(), params.tileColAsInt(), wmsQuery, extraKeys ) );
+    if ( !file.open( QIODevice::ReadOnly ) )
+      return QByteArray();
+
+    return file.readAll();
+  }
+
+  bool QgsWmtsTileCache::setTile( const QgsProject *project, const QgsWmtsParameters &params,
+                                  const QUrlQuery &wmsQuery, const QByteArray &content,
+                                  const QStringList &extraKeys ) const
+  {
+    return setTile( project, params, params.tileRowAsInt(), params.tileColAsInt(), wmsQuery, content, extraKeys );
+  }
+
+  bool QgsWmtsTileCache::setTile( const QgsProject *project, const QgsWmtsParameters &params,
+                                  int tileRow, int tileCol,
+                                  const QUrlQuery &wmsQuery, const QByteArray &content,
+                                  const QStringList &extraKeys ) const
+  {
+    if ( !isEnabled() || content.isEmpty() )
+      return false;
+
+    checkProjectStamp( project );
+
+    const QString path = tilePath( project, params, tileRow, tileCol, wmsQuery, extraKeys );
+    if ( !QDir().mkpath( QFileInfo( path ).absolutePath() ) )
+    {
+      QgsMessageLog::logMessage( QStringLiteral( "Unable to create WMTS tile cache directory for %1" ).arg( path ), QStringLiteral( "Server" ), Qgis::Warning );
+      return false;
+    }
+
+    // a tile may be replaced, e.g. by concurrent requests for the same tile
+    const QFileInfo previousTile( path );
+    const qint64 previousSize = previousTile.exists() ? previousTile.size() : 0;
+
+    QSaveFile file( path );
+    if ( !file.open( QIODevice::WriteOnly ) )
+      return false;
+
+    file.write( content );
+    if ( !file.commit() )
+      return false;
+
+    if ( mMaxSize > 0 )
+      updateSize( content.size() - previousSize );
+
+    return true;
+  }
+
+  void QgsWmtsTileCache::invalidate( const QString &directory, const QString &projectPath )
+  {
+    const QString projectDir = projectDirectory( directory, projectPath );
+
+    QMutexLocker locker( &sStampsMutex );
+    sCheckedStamps.remove( projectDir );
+
+    QDir dir( projectDir );
+    if ( dir.exists() && !dir.removeRecursively() )
+    {
+      QgsMessageLog::logMessage( QStringLiteral( "Unable to remove WMTS tile cache directory %1" ).arg( projectDir ), QStringLiteral( "Server" ), Qgis::Warning );
+    }
+
+    // the size is computed again on the next write
+    QMutexLocker sizesLocker( &sSizesMutex );
+    sCacheSizes.remove( directory );
+  }
+
+  QString QgsWmtsTileCache::tilePath( const QgsProject *project, const QgsWmtsParameters &params,
+                                      int tileRow, int tileCol,
+                                      const QUrlQuery &wmsQuery, const QStringList &extraKeys ) const
+  {
+    // The layer set, styles, format and CRS are all part of the WMS query:
+    // the tile extent excepted, it identifies the tiles of a tile matrix set
+    QUrlQuery query( wmsQuery );
+    query.removeAllQueryItems( QStringLiteral( "BBOX" ) );
+
+    QStringList keys;
+    keys << params.tileMatrixSet()
+         << query.toString( QUrl::FullyDecoded )
+         << extraKeys;
+
+    const QString extension = params.format() == QgsWmtsParameters::Format::JPG ? QStringLiteral( "jpg" ) : QStringLiteral( "png" );
+
+    return QStringLiteral( "%1/%2/%3/%4/%5.%6" ).arg( projectDirectory( mDirectory, project->fileName() ),
+           hashString( keys.join( '\n' ) ),
+           QString::number( params.tileMatrixAsInt() ),
+           QString::number( tileRow ),
+           QString::number( tileCol ),
+           extension );
+  }
+
+  QString QgsWmtsTileCache::projectDirectory( const QString &directory, const QString &projectPath )
+  {
+    return QDir( directory ).absoluteFilePath( hashString( projectPath ) );
+  }
+
+  void QgsWmtsTileCache::checkProjectStamp( const QgsProject *project ) const
+  {
+    const QString projectDir = projectDirectory( mDirectory, project->fileName() );
+    const QDateTime lastModified = project->lastModified();
+
+    QMutexLocker locker( &sStampsMutex );
+    if ( sCheckedStamps.contains( projectDir ) && sCheckedStamps.value( projectDir ) == lastModified )
+      return;
+
+    // Tiles may have been rendered by another process or before a restart
+    const QString stampPath = QDir( projectDir ).absoluteFilePath( PROJECT_STAMP_FILE );
+    QFile stampFile( stampPath );
+    QDateTime stamp;
+    if ( stampFile.open( QIODevice::ReadOnly ) )
+    {
+      stamp = QDateTime::fromString( QString::fromUtf8( stampFile.readAll() ).trimmed(), Qt::ISODateWithMs );
+      stampFile.close();
+    }
+
+    if ( stamp != lastModified )
+    {
+      QDir( projectDir ).removeRecursively();
+      {
+        QMutexLocker sizesLocker( &sSizesMutex );
+        sCacheSizes.remove( mDirectory );
+      }
+      QDir().mkpath( projectDir );
+      QSaveFile newStampFile( stampPath );
+      if ( newStampFile.open( QIODevice::WriteOnly ) )
+      {
+        newStampFile.write( lastModified.toString( Qt::ISODateWithMs ).toUtf8() );
+        newStampFile.commit();
+      }
+    }
+
+    sCheckedStamps.insert( projectDir, lastModified );
+  }
+
+  void QgsWmtsTileCache::updateSize( qint64 delta ) const
+  {
+    QMutexLocker locker( &sSizesMutex );
+    auto it = sCacheSizes.find( mDirectory );
+    if ( it == sCacheSizes.end() )
+    {
+      // Tiles may have been stored by another process or before a restart,
+      // the new tile is already part of the scanned tiles
+      it = sCacheSizes.insert( mDirectory, trim( -1 ) );
+    }
+    else
+    {
+      *it += delta;
+    }
+
+    if ( *it > mMaxSize )
+      *it = trim( static_cast< qint64 >( mMaxSize * TRIM_RATIO ) );
+  }
+
+  qint64 QgsWmtsTileCache::trim( qint64 targetSize ) const
+  {
+    QList< TileFile > tiles;
+    qint64 size = 0;
+    QDirIterator it( mDirectory, QStringList() << QStringLiteral( "*.png" ) << QStringLiteral( "*.jpg" ),
+                     QDir::Files, QDirIterator::Subdirectories );
+    while ( it.hasNext() )
+    {
+      it.next();
+      const QFileInfo info = it.fileInfo();
+      tiles << TileFile { info.absoluteFilePath(), info.size(), info.lastModified() };
+      size += info.size();
+    }
+
+    if ( targetSize < 0 || size <= targetSize )
+      return size;
+
+    // the tiles rendered first are removed first
+    std::sort( tiles.begin(), tiles.end(), []( const TileFile & a, const TileFile & b )
+    {
+      return a.lastModified < b.lastModified;
+    } );
+
+    for ( const TileFile &tile : qgis::as_const( tiles ) )
+    {
+      if ( size <= targetSize )
+        break;
+
+      if ( QFile::remove( tile.path ) )
+        size -= tile.size;
+    }
+
+    return size;
+  }
+
+} // namespace QgsWmts
@@ -0,0 +1,139 @@
+/***************************************************************************
+                              qgswmtstilecache.h
+                              ------------------
+  begin                : October 2020
+  copyright            : (C) 2020 by the QGIS project
+  email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef QGSWMTSTILECACHE_H
+#define QGSWMTSTILECACHE_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QUrlQuery>
+
+class QgsProject;
+class QgsServerInterface;
+
+namespace QgsWmts
+{
+  class QgsWmtsParameters;
+
+  /**
+   * \ingroup server
+   * \brief On-disk store for the tiles rendered by GetTile requests.
+   *
+   * Tiles are stored in a directory tree below the directory defined by
+   * QgsServerSettings::wmtsTileCacheDirectory():
+   * <project>/<layers, styles and format>/<tile matrix>/<row>/<col>.<ext>
+   *
+   * The tiles of a project are discarded when the project is removed from
+   * QgsConfigCache (i.e. when the project file changes) and when the project
+   * last modification time differs from the one recorded with the tiles.
+   *
+   * When the size of the stored tiles exceeds QgsServerSettings::wmtsTileCacheSize(),
+   * the oldest tiles are removed.
+   *
+   * The store may be used concurrently by several worker threads or processes,
+   * tiles are written with QSaveFile so that a partial tile is never read.
+   *
+   * \since QGIS 3.16
+   */
+  class QgsWmtsTileCache
+  {
+    public:
+
+      /**
+       * Constructor for QgsWmtsTileCache, the cache directory is read from
+       * the settings of \a serverIface.
+       */
+      explicit QgsWmtsTileCache( QgsServerInterface *serverIface );
+
+      /**
+       * Constructor for QgsWmtsTileCache storing the tiles in \a directory,
+       * at most \a maxSize bytes of them if \a maxSize is greater than 0.
+       */
+      explicit QgsWmtsTileCache( const QString &directory, qint64 maxSize = 0 );
+
+      //! Returns TRUE if a cache directory is configured
+      bool isEnabled() const { return !mDirectory.isEmpty(); }
+
+      //! Returns the maximum size in bytes of the stored tiles, 0 if the size is not limited
+      qint64 maxSize() const { return mMaxSize; }
+
+      /**
+       * Returns the content of the cached tile or an empty array if the tile
+       * is not in the cache.
+       * \param project the project
+       * \param params the WMTS parameters of the GetTile request
+       * \param wmsQuery the WMS GetMap query translated from \a params
+       * \param extraKeys additional keys (e.g. from access control filters)
+       */
+      QByteArray tile( const QgsProject *project, const QgsWmtsParameters &params,
+                       const QUrlQuery &wmsQuery, const QStringList &extraKeys = QStringList() ) const;
+
+      /**
+       * Stores the \a content of a tile in the cache.
+       * \returns TRUE if the tile has been stored
+       * \see tile()
+       */
+      bool setTile( const QgsProject *project, const QgsWmtsParameters &params,
+                    const QUrlQuery &wmsQuery, const QByteArray &content,
+                    const QStringList &extraKeys = QStringList() ) const;
+
+      /**
+       * Stores the \a content of the tile at \a tileRow and \a tileCol in the
+       * tile matrix of \a params, e.g. a sibling tile cut from a metatile.
+       * \param wmsQuery the WMS GetMap query translated from \a params, identifying the layers
+       * \returns TRUE if the tile has been stored
+       */
+      bool setTile( const QgsProject *project, const QgsWmtsParameters &params,
+                    int tileRow, int tileCol,
+                    const QUrlQuery &wmsQuery, const QByteArray &content,
+                    const QStringList &extraKeys = QStringList() ) const;
+
+      /**
+       * Removes all the tiles of the project with the given \a projectPath
+       * stored in \a directory.
+       */
+      static void invalidate( const QString &directory, const QString &projectPath );
+
+    private:
+
+      //! Returns the tile file path
+      QString tilePath( const QgsProject *project, const QgsWmtsParameters &params,
+                        int tileRow, int tileCol,
+                        const QUrlQuery &wmsQuery, const QStringList &extraKeys ) const;
+
+      //! Returns the directory storing the tiles of the project
+      static QString projectDirectory( const QString &directory, const QString &projectPath );
+
+      //! Discards the project tiles if they have been rendered from an older version of the project
+      void checkProjectStamp( const QgsProject *project ) const;
+
+      //! Adds \a delta bytes to the size of the stored tiles and removes the oldest tiles if it exceeds the maximum size
+      void updateSize( qint64 delta ) const;
+
+      /**
+       * Removes the oldest tiles until their size is at most \a targetSize
+       * bytes and returns the size of the remaining tiles.
+       */
+      qint64 trim( qint64 targetSize ) const;
+
+      QString mDirectory;
+      qint64 mMaxSize = 0;
+  };
+
+} // namespace QgsWmts
+
+#endif // QGSWMTSTILECACHE_H
@@ -26,6 +26,11 @@
 #include "qgssettings.h"
 #include "qgsprojectviewsettings.h"
 
+#include <QBuffer>
+#include <QImage>
+
+#include <algorithm>
+
 namespace QgsWmts
 {
   namespace
@@ -807,6 +812,105 @@ namespace QgsWmts
     return query;
   }
 
+  metatileDef translateWmtsParamToWmsMetatile( const QgsWmtsParameters &params, int metatileSize, int buffer,
+      const QgsProject *project, QgsServerInterface *serverIface )
+  {
+    // validates the parameters
+    const QUrlQuery tileQuery = translateWmtsParamToWmsQueryItem( QStringLiteral( "GetMap" ), params, project, serverIface );
+
+    const tileMatrixSetDef tms = getTileMatrixSetList( project, params.tileMatrixSet() ).at( 0 );
+    const tileMatrixDef tm = tms.tileMatrixList.at( params.tileMatrixAsInt() );
+
+    const int tr = params.tileRowAsInt();
+    const int tc = params.tileColAsInt();
+
+    metatileDef metatile;
+    metatile.minRow = tr - tr % metatileSize;
+    metatile.minCol = tc - tc % metatileSize;
+    metatile.rowCount = std::min( metatileSize, tm.row - metatile.minRow );
+    metatile.colCount = std::min( metatileSize, tm.col - metatile.minCol );
+    metatile.buffer = std::max( 0, buffer );
+
+    const double res = tm.resolution;
+    const double margin = metatile.buffer * res;
+    const double minx = tm.left + metatile.minCol * ( tileSize * res ) - margin;
+    const double miny = tm.top - ( metatile.minRow + metatile.rowCount ) * ( tileSize * res ) - margin;
+    const double maxx = tm.left + ( metatile.minCol + metatile.colCount ) * ( tileSize * res ) + margin;
+    const double maxy = tm.top - metatile.minRow * ( tileSize * res ) + margin;
+    QString bbox;
+    if ( tms.hasAxisInverted )
+    {
+      bbox = qgsDoubleToString( miny, 6 ) + ',' +
+             qgsDoubleToString( minx, 6 ) + ',' +
+             qgsDoubleToString( maxy, 6 ) + ',' +
+             qgsDoubleToString( maxx, 6 );
+    }
+    else
+    {
+      bbox = qgsDoubleToString( minx, 6 ) + ',' +
+             qgsDoubleToString( miny, 6 ) + ',' +
+             qgsDoubleToString( maxx, 6 ) + ',' +
+             qgsDoubleToString( maxy, 6 );
+    }
+
+    metatile.query = tileQuery;
+    const QString bboxName = QgsWmsParameterForWmts::name( QgsWmsParameterForWmts::BBOX );
+    const QString widthName = QgsWmsParameterForWmts::name( QgsWmsParameterForWmts::WIDTH );
+    const QString heightName = QgsWmsParameterForWmts::name( QgsWmsParameterForWmts::HEIGHT );
+    const QString formatName = QgsWmsParameterForWmts::name( QgsWmsParameterForWmts::FORMAT );
+    metatile.query.removeAllQueryItems( bboxName );
+    metatile.query.removeAllQueryItems( widthName );
+    metatile.query.removeAllQueryItems( heightName );
+    metatile.query.removeAllQueryItems( formatName );
+    metatile.query.addQueryItem( bboxName, bbox );
+    metatile.query.addQueryItem( widthName, QString::number( metatile.colCount * tileSize + 2 * metatile.buffer ) );
+    metatile.query.addQueryItem( heightName, QString::number( metatile.rowCount * tileSize + 2 * metatile.buffer ) );
+    // JPEG tiles are cut from a lossless image, without TRANSPARENT its background is opaque
+    metatile.query.addQueryItem( formatName, QStringLiteral( "image/png" ) );
+
+    return metatile;
+  }
+
+  QList< QByteArray > splitMetatile( const QImage &image, const metatileDef &metatile, QgsWmtsParameters::Format format,
+                                     int jpegQuality, int pngCompressionLevel )
+  {
+    QList< QByteArray > tiles;
+    if ( image.width() != metatile.colCount * tileSize + 2 * metatile.buffer ||
+         image.height() != metatile.rowCount * tileSize + 2 * metatile.buffer )
+    {
+      return tiles;
+    }
+
+    const bool jpeg = format == QgsWmtsParameters::Format::JPG;
+    int quality = -1;
+    if ( jpeg )
+    {
+      quality = jpegQuality;
+    }
+    else if ( pngCompressionLevel >= 0 )
+    {
+      // the PNG writer maps the quality [0, 100] to the zlib compression level [9, 0]
+      quality = ( 9 - std::min( pngCompressionLevel, 9 ) ) * 91 / 9;
+    }
+
+    for ( int row = 0; row < metatile.rowCount; ++row )
+    {
+      for ( int col = 0; col < metatile.colCount; ++col )
+      {
+        QImage tileImage = image.copy( metatile.buffer + col * tileSize, metatile.buffer + row * tileSize, tileSize, tileSize );
+        if ( jpeg )
+          tileImage = tileImage.convertToFormat( QImage::Format_RGB32 );
+
+        QByteArray tileContent;
+        QBuffer buffer( &tileContent );
+        buffer.open( QIODevice::WriteOnly );
+        tileImage.save( &buffer, jpeg ? "JPEG" : "PNG", quality );
+        tiles << tileContent;
+      }
+    }
+    return tiles;
+  }
+
   namespace
   {
 
@@ -24,6 +24,7 @@
 #include "qgswmtsserviceexception.h"
 
 #include <QDomDocument>
+#include <QImage>
 
 /**
  * \ingroup server
@@ -98,6 +99,27 @@ namespace QgsWmts
     QMap< int, tileMatrixLimitDef > tileMatrixLimits;
   };
 
+  struct metatileDef
+  {
+    //! Row of the top left tile of the metatile
+    int minRow = 0;
+
+    //! Column of the top left tile of the metatile
+    int minCol = 0;
+
+    //! Number of tile rows in the metatile
+    int rowCount = 1;
+
+    //! Number of tile columns in the metatile
+    int colCount = 1;
+
+    //! Size in pixels of the margin rendered around the metatile
+    int buffer = 0;
+
+    //! WMS GetMap query rendering the whole metatile and its margin
+    QUrlQuery query;
+  };
+
   struct layerDef
   {
     QString id;
@@ -146,6 +168,30 @@ namespace QgsWmts
   QUrlQuery translateWmtsParamToWmsQueryItem( const QString &request, const QgsWmtsParameters &params,
       const QgsProject *project, QgsServerInterface *serverIface );
 
+  /**
+   * Returns the metatile containing the tile requested by a GetTile request:
+   * the block of \a metatileSize x \a metatileSize tiles aligned on the tile
+   * matrix, clamped to the tile matrix limits, with the WMS GetMap query
+   * rendering it in a single image surrounded by a margin of \a buffer pixels.
+   * The metatile is always rendered as a lossless PNG image so that its tiles
+   * are encoded only once by splitMetatile().
+   * \since QGIS 3.16
+   */
+  metatileDef translateWmtsParamToWmsMetatile( const QgsWmtsParameters &params, int metatileSize, int buffer,
+      const QgsProject *project, QgsServerInterface *serverIface );
+
+  /**
+   * Splits the rendered \a image of a \a metatile into its tiles, row by row,
+   * discarding the margin around the metatile. The tiles are encoded in
+   * \a format, with the quality \a jpegQuality for JPEG tiles and the zlib
+   * compression level \a pngCompressionLevel for PNG tiles (-1 for the default
+   * quality or level). An empty list is returned if the size of the image does
+   * not match the metatile.
+   * \since QGIS 3.16
+   */
+  QList< QByteArray > splitMetatile( const QImage &image, const metatileDef &metatile, QgsWmtsParameters::Format format,
+                                     int jpegQuality = -1, int pngCompressionLevel = -1 );
+
 } // namespace QgsWmts
 
 #endif
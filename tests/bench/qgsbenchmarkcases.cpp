@@ -0,0 +1,553 @@
+/***************************************************************************
+                 qgsbenchmarkcases.cpp  - Micro benchmark cases
+                             -------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgsbenchmarksuite.h"
+
+#include <QDir>
+#include <QImage>
+
+#include <cmath>
+#include <memory>
+#include <random>
+#include <stdexcept>
+
+#include "qgsbilinearrasterresampler.h"
+#include "qgscubicrasterresampler.h"
+#include "qgsexpression.h"
+#include "qgsexpressioncontextutils.h"
+#include "qgsfeatureiterator.h"
+#include "qgsgeometry.h"
+#include "qgsgeos.h"
+#include "qgsjsonutils.h"
+#include "qgsmaprenderersequentialjob.h"
+#include "qgsmapsettings.h"
+#include "qgspallabeling.h"
+#include "qgsproject.h"
+#include "qgsrasterdataprovider.h"
+#include "qgsrasterfilewriter.h"
+#include "qgsrasterlayer.h"
+#include "qgsrasterresamplefilter.h"
+#include "qgsvectordataprovider.h"
+#include "qgsvectorfilewriter.h"
+#include "qgsvectorlayer.h"
+#include "qgsvectorlayerlabeling.h"
+
+#ifdef HAVE_SERVER
+#include "qgsbufferserverrequest.h"
+#include "qgsbufferserverresponse.h"
+#include "qgsserver.h"
+#endif
+
+namespace
+{
+  const int POINT_COUNT = 100000;
+  const int POLYGON_COUNT = 20000;
+  const QgsRectangle DATA_EXTENT( -20, -10, 20, 10 );
+
+  // prevents the compiler from optimizing the benchmarked work away
+  volatile double sSink = 0;
+
+  /**
+   * Lazily created data sets shared by the cases.
+   */
+  class BenchmarkData
+  {
+    public:
+      explicit BenchmarkData( const QString &path ) : mPath( path ) {}
+
+      //! Memory layer of random points with id, value and name attributes
+      QgsVectorLayer *points()
+      {
+        if ( !mPoints )
+          mPoints = createLayer( QStringLiteral( "Point" ), POINT_COUNT, false );
+        return mPoints.get();
+      }
+
+      //! Memory layer of random small polygons with id, value and name attributes
+      QgsVectorLayer *polygons()
+      {
+        if ( !mPolygons )
+          mPolygons = createLayer( QStringLiteral( "Polygon" ), POLYGON_COUNT, true );
+        return mPolygons.get();
+      }
+
+      //! GeoPackage copy of the points layer
+      QString pointsGeoPackage()
+      {
+        if ( mPointsGeoPackage.isEmpty() )
+          mPointsGeoPackage = writeGeoPackage( points(), QStringLiteral( "points" ) );
+        return mPointsGeoPackage;
+      }
+
+      //! GeoPackage copy of the polygons layer
+      QString polygonsGeoPackage()
+      {
+        if ( mPolygonsGeoPackage.isEmpty() )
+          mPolygonsGeoPackage = writeGeoPackage( polygons(), QStringLiteral( "polygons" ) );
+        return mPolygonsGeoPackage;
+      }
+
+      //! Single band Float32 GeoTIFF in EPSG:4326
+      QString raster()
+      {
+        if ( !mRaster.isEmpty() )
+          return mRaster;
+
+        const QString fileName = QDir( mPath ).filePath( QStringLiteral( "raster.tif" ) );
+        const int width = 2000;
+        const int height = 1000;
+        QgsRasterFileWriter writer( fileName );
+        writer.setOutputProviderKey( QStringLiteral( "gdal" ) );
+        writer.setOutputFormat( QStringLiteral( "GTiff" ) );
+        std::unique_ptr< QgsRasterDataProvider > provider( writer.createOneBandRaster( Qgis::Float32, width, height, DATA_EXTENT, QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:4326" ) ) ) );
+        if ( !provider || !provider->isValid() )
+          throw std::runtime_error( "could not create raster data set" );
+
+        provider->setEditable( true );
+        QgsRasterBlock block( Qgis::Float32, width, height );
+        for ( int row = 0; row < height; ++row )
+          for ( int col = 0; col < width; ++col )
+            block.setValue( row, col, std::sin( col / 50.0 ) * std::cos( row / 30.0 ) * 100 );
+        provider->writeBlock( &block, 1 );
+        provider->setEditable( false );
+
+        mRaster = fileName;
+        return mRaster;
+      }
+
+      QString path() const { return mPath; }
+
+    private:
+
+      std::unique_ptr< QgsVectorLayer > createLayer( const QString &type, int count, bool polygons )
+      {
+        std::unique_ptr< QgsVectorLayer > layer = qgis::make_unique< QgsVectorLayer >(
+              QStringLiteral( "%1?crs=EPSG:4326&field=id:integer&field=value:double&field=name:string(20)" ).arg( type ),
+              type.toLower(), QStringLiteral( "memory" ) );
+
+        std::mt19937 generator( 42 );
+        std::uniform_real_distribution< double > xDistribution( DATA_EXTENT.xMinimum(), DATA_EXTENT.xMaximum() );
+        std::uniform_real_distribution< double > yDistribution( DATA_EXTENT.yMinimum(), DATA_EXTENT.yMaximum() );
+        std::uniform_real_distribution< double > valueDistribution( 0, 1000 );
+
+        QgsFeatureList features;
+        features.reserve( count );
+        for ( int i = 0; i < count; ++i )
+        {
+          QgsFeature feature( layer->fields() );
+          const double x = xDistribution( generator );
+          const double y = yDistribution( generator );
+          if ( polygons )
+          {
+            // irregular 32 vertex ring, about 0.1 degree wide
+            QgsPolylineXY ring;
+            for ( int v = 0; v < 32; ++v )
+            {
+              const double angle = 2 * M_PI * v / 32;
+              const double radius = 0.05 * ( 0.75 + 0.25 * std::sin( 5 * angle + i ) );
+              ring << QgsPointXY( x + radius * std::cos( angle ), y + radius * std::sin( angle ) );
+            }
+            ring << ring.first();
+            feature.setGeometry( QgsGeometry::fromPolygonXY( QgsPolygonXY() << ring ) );
+          }
+          else
+          {
+            feature.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( x, y ) ) );
+          }
+          feature.setAttributes( QgsAttributes() << i << valueDistribution( generator ) << QStringLiteral( "feature %1" ).arg( i ) );
+          features << feature;
+        }
+        layer->dataProvider()->addFeatures( features );
+        return layer;
+      }
+
+      QString writeGeoPackage( QgsVectorLayer *layer, const QString &name )
+      {
+        const QString fileName = QDir( mPath ).filePath( name + QStringLiteral( ".gpkg" ) );
+        QgsVectorFileWriter::SaveVectorOptions options;
+        options.driverName = QStringLiteral( "GPKG" );
+        options.layerName = name;
+        QString error;
+        if ( QgsVectorFileWriter::writeAsVectorFormatV2( layer, fileName, QgsCoordinateTransformContext(), options, nullptr, nullptr, &error ) != QgsVectorFileWriter::NoError )
+          throw std::runtime_error( error.toStdString() );
+        return fileName;
+      }
+
+      QString mPath;
+      std::unique_ptr< QgsVectorLayer > mPoints;
+      std::unique_ptr< QgsVectorLayer > mPolygons;
+      QString mPointsGeoPackage;
+      QString mPolygonsGeoPackage;
+      QString mRaster;
+  };
+
+  void iterate( QgsVectorLayer *layer, const QgsFeatureRequest &request = QgsFeatureRequest() )
+  {
+    QgsFeatureIterator it = layer->getFeatures( request );
+    QgsFeature feature;
+    double sum = 0;
+    while ( it.nextFeature( feature ) )
+      sum += feature.attribute( 1 ).toDouble();
+    sSink = sum;
+  }
+
+  std::shared_ptr< QgsVectorLayer > openLayer( const QString &uri, const QString &provider )
+  {
+    std::shared_ptr< QgsVectorLayer > layer = std::make_shared< QgsVectorLayer >( uri, QStringLiteral( "layer" ), provider );
+    if ( !layer->isValid() )
+      throw std::runtime_error( QStringLiteral( "could not open %1 layer %2" ).arg( provider, uri ).toStdString() );
+    return layer;
+  }
+
+  QgsBenchmarkSuite::Function expressionCase( BenchmarkData *data, const QString &expressionString, bool polygons )
+  {
+    QgsVectorLayer *layer = polygons ? data->polygons() : data->points();
+    std::shared_ptr< QgsFeatureList > features = std::make_shared< QgsFeatureList >();
+    QgsFeatureIterator it = layer->getFeatures();
+    QgsFeature feature;
+    while ( it.nextFeature( feature ) )
+      features->append( feature );
+
+    std::shared_ptr< QgsExpressionContext > context = std::make_shared< QgsExpressionContext >( QgsExpressionContextUtils::globalProjectLayerScopes( layer ) );
+    std::shared_ptr< QgsExpression > expression = std::make_shared< QgsExpression >( expressionString );
+    expression->prepare( context.get() );
+    if ( expression->hasParserError() || expression->hasEvalError() )
+      throw std::runtime_error( expression->parserErrorString().toStdString() );
+
+    return [features, context, expression]
+    {
+      int count = 0;
+      for ( const QgsFeature &feature : qgis::as_const( *features ) )
+      {
+        context->setFeature( feature );
+        if ( expression->evaluate( context.get() ).toBool() )
+          ++count;
+      }
+      sSink = count;
+    };
+  }
+
+  QgsMapSettings mapSettings( const QList< QgsMapLayer * > &layers, const QgsRectangle &extent, const QgsCoordinateReferenceSystem &crs )
+  {
+    QgsMapSettings settings;
+    settings.setOutputSize( QSize( 1024, 768 ) );
+    settings.setDestinationCrs( crs );
+    settings.setLayers( layers );
+    settings.setExtent( extent );
+    return settings;
+  }
+
+  void render( const QgsMapSettings &settings )
+  {
+    QgsMapRendererSequentialJob job( settings );
+    job.start();
+    job.waitForFinished();
+    const QImage image = job.renderedImage();
+    sSink = image.pixel( 0, 0 );
+  }
+
+  QgsBenchmarkSuite::Function rasterCase( BenchmarkData *data, QgsRasterResampler *resampler, const QgsRectangle &extent, const QgsCoordinateReferenceSystem &crs )
+  {
+    std::shared_ptr< QgsRasterLayer > layer = std::make_shared< QgsRasterLayer >( data->raster(), QStringLiteral( "raster" ), QStringLiteral( "gdal" ) );
+    if ( !layer->isValid() )
+      throw std::runtime_error( "could not open raster data set" );
+    if ( resampler )
+    {
+      layer->resampleFilter()->setZoomedInResampler( resampler );
+      layer->resampleFilter()->setZoomedOutResampler( resampler->clone() );
+    }
+    const QgsMapSettings settings = mapSettings( QList< QgsMapLayer * >() << layer.get(), extent, crs );
+    return [layer, settings] { render( settings ); };
+  }
+
+#ifdef HAVE_SERVER
+  QgsBenchmarkSuite::Function serverCase( BenchmarkData *data, const QString &query )
+  {
+    static QgsServer *server = new QgsServer();
+
+    std::shared_ptr< QgsProject > project = std::make_shared< QgsProject >();
+    QgsVectorLayer *layer = new QgsVectorLayer( data->polygonsGeoPackage() + QStringLiteral( "|layername=polygons" ), QStringLiteral( "polygons" ), QStringLiteral( "ogr" ) );
+    if ( !layer->isValid() )
+      throw std::runtime_error( "could not open polygons data set" );
+    project->addMapLayer( layer );
+    project->writeEntry( QStringLiteral( "WFSLayers" ), QStringLiteral( "/" ), QStringList() << layer->id() );
+    project->writeEntry( QStringLiteral( "WMSCrsList" ), QStringLiteral( "/" ), QStringList() << QStringLiteral( "EPSG:4326" ) );
+    project->setFileName( QDir( data->path() ).filePath( QStringLiteral( "server.qgs" ) ) );
+    if ( !project->write() )
+      throw std::runtime_error( "could not write server project" );
+
+    const QString url = QStringLiteral( "http://localhost/?MAP=%1&%2" ).arg( project->fileName(), query );
+    return [project, url]
+    {
+      QgsBufferServerRequest request( url );
+      QgsBufferServerResponse response;
+      server->handleRequest( request, response, project.get() );
+      if ( response.statusCode() != 200 )
+        throw std::runtime_error( QStringLiteral( "server returned status %1: %2" ).arg( response.statusCode() ).arg( QString::fromUtf8( response.body().left( 200 ) ) ).toStdString() );
+      sSink = response.body().size();
+    };
+  }
+#endif
+}
+
+void registerBenchmarkCases( QgsBenchmarkSuite &suite, const QString &dataPath )
+{
+  // owned for the lifetime of the application, cases share the generated data sets
+  static BenchmarkData *data = nullptr;
+  delete data;
+  data = new BenchmarkData( dataPath );
+
+  // Provider iteration
+
+  suite.addCase( QStringLiteral( "provider/memory_iterate" ), []
+  {
+    QgsVectorLayer *layer = data->points();
+    return [layer] { iterate( layer ); };
+  } );
+
+  suite.addCase( QStringLiteral( "provider/memory_iterate_rect" ), []
+  {
+    QgsVectorLayer *layer = data->points();
+    return [layer] { iterate( layer, QgsFeatureRequest().setFilterRect( QgsRectangle( -5, -5, 5, 5 ) ) ); };
+  } );
+
+  suite.addCase( QStringLiteral( "provider/ogr_iterate" ), []
+  {
+    std::shared_ptr< QgsVectorLayer > layer = openLayer( data->pointsGeoPackage() + QStringLiteral( "|layername=points" ), QStringLiteral( "ogr" ) );
+    return [layer] { iterate( layer.get() ); };
+  } );
+
+  suite.addCase( QStringLiteral( "provider/ogr_iterate_rect" ), []
+  {
+    std::shared_ptr< QgsVectorLayer > layer = openLayer( data->pointsGeoPackage() + QStringLiteral( "|layername=points" ), QStringLiteral( "ogr" ) );
+    return [layer] { iterate( layer.get(), QgsFeatureRequest().setFilterRect( QgsRectangle( -5, -5, 5, 5 ) ) ); };
+  } );
+
+  suite.addCase( QStringLiteral( "provider/ogr_iterate_no_geometry" ), []
+  {
+    std::shared_ptr< QgsVectorLayer > layer = openLayer( data->pointsGeoPackage() + QStringLiteral( "|layername=points" ), QStringLiteral( "ogr" ) );
+    return [layer] { iterate( layer.get(), QgsFeatureRequest().setFlags( QgsFeatureRequest::NoGeometry ) ); };
+  } );
+
+  suite.addCase( QStringLiteral( "provider/postgres_iterate" ), []
+  {
+    // e.g. "dbname='qgis_test' table=\"qgis_test\".\"someData\" (geom)"
+    const QString uri = qgetenv( "QGIS_BENCH_PG_URI" );
+    if ( uri.isEmpty() )
+      throw QgsBenchmarkSkip( QStringLiteral( "QGIS_BENCH_PG_URI is not set" ) );
+    std::shared_ptr< QgsVectorLayer > layer = openLayer( uri, QStringLiteral( "postgres" ) );
+    return [layer]
+    {
+      QgsFeatureIterator it = layer->getFeatures();
+      QgsFeature feature;
+      int count = 0;
+      while ( it.nextFeature( feature ) )
+        ++count;
+      sSink = count;
+    };
+  } );
+
+  // Expression evaluation
+
+  suite.addCase( QStringLiteral( "expression/arithmetic" ), []
+  {
+    return expressionCase( data, QStringLiteral( "\"value\" * 2 + \"id\" / 3 - 10 > 500 AND \"id\" % 7 <> 0" ), false );
+  } );
+
+  suite.addCase( QStringLiteral( "expression/string_functions" ), []
+  {
+    return expressionCase( data, QStringLiteral( "upper(\"name\") || to_string(round(\"value\", 2)) LIKE 'FEATURE 1%'" ), false );
+  } );
+
+  suite.addCase( QStringLiteral( "expression/in_and_case" ), []
+  {
+    return expressionCase( data, QStringLiteral( "CASE WHEN \"id\" IN (1, 5, 10, 50, 100, 500) THEN 1 WHEN \"value\" BETWEEN 100 AND 200 THEN 1 ELSE 0 END = 1" ), false );
+  } );
+
+  suite.addCase( QStringLiteral( "expression/geometry" ), []
+  {
+    return expressionCase( data, QStringLiteral( "area(buffer($geometry, 0.01)) > perimeter($geometry) * 0.01" ), true );
+  } );
+
+  // Geometry parsing
+
+  suite.addCase( QStringLiteral( "geometry/parse_wkb" ), []
+  {
+    std::shared_ptr< QVector< QByteArray > > wkbs = std::make_shared< QVector< QByteArray > >();
+    QgsFeatureIterator it = data->polygons()->getFeatures();
+    QgsFeature feature;
+    while ( it.nextFeature( feature ) )
+      wkbs->append( feature.geometry().asWkb() );
+    return [wkbs]
+    {
+      double area = 0;
+      for ( const QByteArray &wkb : qgis::as_const( *wkbs ) )
+      {
+        QgsGeometry geometry;
+        geometry.fromWkb( wkb );
+        area += geometry.constGet()->nCoordinates();
+      }
+      sSink = area;
+    };
+  } );
+
+  suite.addCase( QStringLiteral( "geometry/parse_wkt" ), []
+  {
+    std::shared_ptr< QStringList > wkts = std::make_shared< QStringList >();
+    QgsFeatureIterator it = data->polygons()->getFeatures();
+    QgsFeature feature;
+    while ( it.nextFeature( feature ) )
+      wkts->append( feature.geometry().asWkt() );
+    return [wkts]
+    {
+      double count = 0;
+      for ( const QString &wkt : qgis::as_const( *wkts ) )
+        count += QgsGeometry::fromWkt( wkt ).constGet()->nCoordinates();
+      sSink = count;
+    };
+  } );
+
+  suite.addCase( QStringLiteral( "geometry/parse_geojson" ), []
+  {
+    QgsJsonExporter exporter( data->polygons() );
+    QgsFeatureList features;
+    QgsFeatureIterator it = data->polygons()->getFeatures();
+    QgsFeature feature;
+    while ( it.nextFeature( feature ) )
+      features << feature;
+    const QString geojson = exporter.exportFeatures( features );
+    const QgsFields fields = data->polygons()->fields();
+    return [geojson, fields]
+    {
+      sSink = QgsJsonUtils::stringToFeatureList( geojson, fields ).size();
+    };
+  } );
+
+  // GEOS predicates
+
+  auto geosCase = []( const std::function< bool( const QgsGeos &, const QgsAbstractGeometry * ) > &predicate, bool prepared )
+  {
+    return [predicate, prepared]() -> QgsBenchmarkSuite::Function
+    {
+      std::shared_ptr< QVector< QgsGeometry > > geometries = std::make_shared< QVector< QgsGeometry > >();
+      QgsFeatureIterator it = data->polygons()->getFeatures();
+      QgsFeature feature;
+      while ( it.nextFeature( feature ) )
+        geometries->append( feature.geometry() );
+
+      // a large, detailed polygon covering part of the data set
+      std::shared_ptr< QgsGeometry > reference = std::make_shared< QgsGeometry >( QgsGeometry::fromPointXY( QgsPointXY( 0, 0 ) ).buffer( 8, 256 ) );
+      return [geometries, reference, predicate, prepared]
+      {
+        QgsGeos engine( reference->constGet() );
+        if ( prepared )
+          engine.prepareGeometry();
+        int count = 0;
+        for ( const QgsGeometry &geometry : qgis::as_const( *geometries ) )
+        {
+          if ( predicate( engine, geometry.constGet() ) )
+            ++count;
+        }
+        sSink = count;
+      };
+    };
+  };
+
+  suite.addCase( QStringLiteral( "geos/intersects" ), geosCase( []( const QgsGeos & engine, const QgsAbstractGeometry * geometry ) { return engine.intersects( geometry ); }, false ) );
+  suite.addCase( QStringLiteral( "geos/intersects_prepared" ), geosCase( []( const QgsGeos & engine, const QgsAbstractGeometry * geometry ) { return engine.intersects( geometry ); }, true ) );
+  suite.addCase( QStringLiteral( "geos/contains_prepared" ), geosCase( []( const QgsGeos & engine, const QgsAbstractGeometry * geometry ) { return engine.contains( geometry ); }, true ) );
+  suite.addCase( QStringLiteral( "geos/touches" ), geosCase( []( const QgsGeos & engine, const QgsAbstractGeometry * geometry ) { return engine.touches( geometry ); }, false ) );
+
+  // PAL labeling
+
+  suite.addCase( QStringLiteral( "labeling/points" ), []
+  {
+    std::shared_ptr< QgsVectorLayer > layer = openLayer( data->pointsGeoPackage() + QStringLiteral( "|layername=points" ), QStringLiteral( "ogr" ) );
+    QgsPalLayerSettings settings;
+    settings.fieldName = QStringLiteral( "name" );
+    settings.placement = QgsPalLayerSettings::AroundPoint;
+    layer->setLabeling( new QgsVectorLayerSimpleLabeling( settings ) );
+    layer->setLabelsEnabled( true );
+
+    QgsMapSettings ms = mapSettings( QList< QgsMapLayer * >() << layer.get(), QgsRectangle( -5, -2.5, 5, 2.5 ), layer->crs() );
+    ms.setFlag( QgsMapSettings::DrawLabeling, true );
+    return [layer, ms] { render( ms ); };
+  } );
+
+  suite.addCase( QStringLiteral( "labeling/polygons" ), []
+  {
+    std::shared_ptr< QgsVectorLayer > layer = openLayer( data->polygonsGeoPackage() + QStringLiteral( "|layername=polygons" ), QStringLiteral( "ogr" ) );
+    QgsPalLayerSettings settings;
+    settings.fieldName = QStringLiteral( "id" );
+    settings.placement = QgsPalLayerSettings::OverPoint;
+    layer->setLabeling( new QgsVectorLayerSimpleLabeling( settings ) );
+    layer->setLabelsEnabled( true );
+
+    QgsMapSettings ms = mapSettings( QList< QgsMapLayer * >() << layer.get(), DATA_EXTENT, layer->crs() );
+    ms.setFlag( QgsMapSettings::DrawLabeling, true );
+    return [layer, ms] { render( ms ); };
+  } );
+
+  // Raster resampling and reprojection
+
+  const QgsCoordinateReferenceSystem wgs84( QStringLiteral( "EPSG:4326" ) );
+  const QgsRectangle zoomedIn( -2, -1, 2, 1 );
+
+  suite.addCase( QStringLiteral( "raster/nearest" ), [wgs84, zoomedIn]
+  {
+    return rasterCase( data, nullptr, zoomedIn, wgs84 );
+  } );
+
+  suite.addCase( QStringLiteral( "raster/resample_bilinear" ), [wgs84, zoomedIn]
+  {
+    return rasterCase( data, new QgsBilinearRasterResampler(), zoomedIn, wgs84 );
+  } );
+
+  suite.addCase( QStringLiteral( "raster/resample_cubic" ), [wgs84, zoomedIn]
+  {
+    return rasterCase( data, new QgsCubicRasterResampler(), zoomedIn, wgs84 );
+  } );
+
+  suite.addCase( QStringLiteral( "raster/reproject" ), []
+  {
+    return rasterCase( data, nullptr, QgsRectangle( -2000000, -1000000, 2000000, 1000000 ), QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:3857" ) ) );
+  } );
+
+  // Server requests
+
+  const QStringList serverCases
+  {
+    QStringLiteral( "server/wms_getmap" ),
+    QStringLiteral( "SERVICE=WMS&VERSION=1.3.0&REQUEST=GetMap&LAYERS=polygons&STYLES=&CRS=EPSG:4326&BBOX=-10,-20,10,20&WIDTH=1024&HEIGHT=512&FORMAT=image/png" ),
+    QStringLiteral( "server/wms_getfeatureinfo" ),
+    QStringLiteral( "SERVICE=WMS&VERSION=1.3.0&REQUEST=GetFeatureInfo&LAYERS=polygons&QUERY_LAYERS=polygons&STYLES=&CRS=EPSG:4326&BBOX=-10,-20,10,20&WIDTH=1024&HEIGHT=512&I=512&J=256&FEATURE_COUNT=10&INFO_FORMAT=text/xml" ),
+    QStringLiteral( "server/wfs_getfeature" ),
+    QStringLiteral( "SERVICE=WFS&VERSION=1.1.0&REQUEST=GetFeature&TYPENAME=polygons&MAXFEATURES=1000&OUTPUTFORMAT=GeoJSON" ),
+  };
+  for ( int i = 0; i < serverCases.size(); i += 2 )
+  {
+    const QString query = serverCases.at( i + 1 );
+    suite.addCase( serverCases.at( i ), [query]() -> QgsBenchmarkSuite::Function
+    {
+#ifdef HAVE_SERVER
+      return serverCase( data, query );
+#else
+      Q_UNUSED( query )
+      throw QgsBenchmarkSkip( QStringLiteral( "QGIS was built without server support" ) );
+#endif
+    } );
+  }
+}
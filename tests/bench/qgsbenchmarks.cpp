@@ -0,0 +1,155 @@
+/***************************************************************************
+                 qgsbenchmarks.cpp  - Micro benchmark suite
+                             -------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <QDir>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QStringList>
+#include <QTemporaryDir>
+
+#include <iostream>
+
+#include "qgsapplication.h"
+#include "qgsbenchmarksuite.h"
+#include "qgsproviderregistry.h"
+#include <qgsconfig.h>
+#include <qgsversion.h>
+
+/**
+ * Print usage text
+ */
+void usage( std::string const &appName )
+{
+  std::cerr << "QGIS Benchmarks - " << VERSION << " '" << RELEASE_NAME << "' ("
+            << QGSVERSION << ")\n"
+            << "Times the core hot paths (providers, expressions, geometry, GEOS, labeling, raster, server) separately\n"
+            << "Usage: " << appName <<  " [options]\n"
+            << "  options:\n"
+            << "\t[--iterations iterations]\tnumber of timed runs of each case, default 10\n"
+            << "\t[--warmup iterations]\tnumber of untimed runs before timing, default 1\n"
+            << "\t[--filter regexp]\tonly run the cases with a matching name, e.g. \"^geos/\"\n"
+            << "\t[--log filename]\twrite results (JSON) to given file, default is stdout\n"
+            << "\t[--list]\t\tlist the cases and exit\n"
+            << "\t[--prefix path]\tpath to a different build of qgis, may be used to test old versions\n"
+            << "\t[--help]\t\tthis text\n\n"
+            << "  Data sets are generated in a temporary directory. Set QGIS_BENCH_PG_URI\n"
+            << "  to a PostgreSQL layer URI to enable the PostgreSQL case.\n";
+}
+
+int main( int argc, char *argv[] )
+{
+  int iterations = 10;
+  int warmup = 1;
+  QString filter;
+  QString logFileName;
+  QString prefixPath;
+  bool list = false;
+
+  for ( int i = 1; i < argc; i++ )
+  {
+    const QString arg = argv[i];
+
+    if ( arg == QLatin1String( "--help" ) || arg == QLatin1String( "-?" ) )
+    {
+      usage( argv[0] );
+      return 2;
+    }
+    else if ( i + 1 < argc && ( arg == QLatin1String( "--iterations" ) || arg == QLatin1String( "-i" ) ) )
+    {
+      iterations = QString( argv[++i] ).toInt();
+    }
+    else if ( i + 1 < argc && arg == QLatin1String( "--warmup" ) )
+    {
+      warmup = QString( argv[++i] ).toInt();
+    }
+    else if ( i + 1 < argc && ( arg == QLatin1String( "--filter" ) || arg == QLatin1String( "-f" ) ) )
+    {
+      filter = QString::fromLocal8Bit( argv[++i] );
+    }
+    else if ( i + 1 < argc && ( arg == QLatin1String( "--log" ) || arg == QLatin1String( "-l" ) ) )
+    {
+      logFileName = QDir::toNativeSeparators( QFileInfo( QFile::decodeName( argv[++i] ) ).absoluteFilePath() );
+    }
+    else if ( i + 1 < argc && arg == QLatin1String( "--prefix" ) )
+    {
+      prefixPath = argv[++i];
+    }
+    else if ( arg == QLatin1String( "--list" ) )
+    {
+      list = true;
+    }
+    else
+    {
+      usage( argv[0] );
+      return 1;
+    }
+  }
+
+  const QRegularExpression filterRegExp( filter );
+  if ( !filterRegExp.isValid() )
+  {
+    std::cerr << "Invalid filter: " << filterRegExp.errorString().toLocal8Bit().constData() << std::endl;
+    return 1;
+  }
+
+  QgsApplication app( argc, argv, false );
+
+  if ( prefixPath.isEmpty() )
+  {
+    QDir dir( QCoreApplication::applicationDirPath() );
+    dir.cdUp();
+    prefixPath = dir.absolutePath();
+  }
+  QgsApplication::setPrefixPath( prefixPath, true );
+
+  QgsApplication::setOrganizationName( QStringLiteral( "QGIS" ) );
+  QgsApplication::setOrganizationDomain( QStringLiteral( "qgis.org" ) );
+  QgsApplication::setApplicationName( QStringLiteral( "QGIS3" ) );
+
+  QgsApplication::init();
+  QgsApplication::initQgis();
+  QgsProviderRegistry::instance( QgsApplication::pluginPath() );
+
+  QTemporaryDir dataDir;
+  QgsBenchmarkSuite suite;
+  registerBenchmarkCases( suite, dataDir.path() );
+
+  int result = 0;
+  if ( list )
+  {
+    for ( const QString &name : suite.caseNames() )
+      std::cout << name.toLocal8Bit().constData() << '\n';
+  }
+  else
+  {
+    suite.run( iterations, warmup, filterRegExp, std::cerr );
+    if ( logFileName.isEmpty() )
+    {
+      std::cout << suite.toJson().toUtf8().constData() << std::endl;
+    }
+    else if ( !suite.saveResults( logFileName ) )
+    {
+      std::cerr << "Cannot write " << logFileName.toLocal8Bit().constData() << std::endl;
+      result = 1;
+    }
+
+    if ( suite.failureCount() > 0 )
+      result = 1;
+  }
+
+  QgsApplication::exitQgis();
+  return result;
+}
@@ -0,0 +1,184 @@
+/***************************************************************************
+                 qgsbenchmarksuite.cpp  - Micro benchmark runner
+                             -------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgsbenchmarksuite.h"
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSysInfo>
+#include <QThread>
+
+#include <algorithm>
+#include <ctime>
+#include <exception>
+#include <numeric>
+
+#include <nlohmann/json.hpp>
+
+#include "qgis.h"
+#include "qgsexception.h"
+
+using namespace nlohmann;
+
+namespace
+{
+  json statistics( QVector< double > values )
+  {
+    if ( values.isEmpty() )
+      return json();
+
+    std::sort( values.begin(), values.end() );
+    const int count = values.size();
+    const double median = count % 2 ? values.at( count / 2 ) : ( values.at( count / 2 - 1 ) + values.at( count / 2 ) ) / 2;
+    const double mean = std::accumulate( values.constBegin(), values.constEnd(), 0.0 ) / count;
+    return
+    {
+      { "min", values.first() },
+      { "median", median },
+      { "mean", mean },
+      { "max", values.last() },
+    };
+  }
+}
+
+void QgsBenchmarkSuite::addCase( const QString &name, const PrepareFunction &prepare )
+{
+  mCases.append( { name, prepare } );
+}
+
+QStringList QgsBenchmarkSuite::caseNames() const
+{
+  QStringList names;
+  for ( const Case &benchmark : mCases )
+    names << benchmark.name;
+  return names;
+}
+
+void QgsBenchmarkSuite::run( int iterations, int warmup, const QRegularExpression &filter, std::ostream &log )
+{
+  mResults.clear();
+  mIterations = iterations;
+  mWarmup = warmup;
+
+  for ( const Case &benchmark : qgis::as_const( mCases ) )
+  {
+    if ( !filter.match( benchmark.name ).hasMatch() )
+      continue;
+
+    Result result;
+    result.name = benchmark.name;
+    log << benchmark.name.toLocal8Bit().constData() << ": " << std::flush;
+
+    try
+    {
+      const Function function = benchmark.prepare();
+      for ( int i = 0; i < warmup; ++i )
+        function();
+
+      QElapsedTimer timer;
+      for ( int i = 0; i < iterations; ++i )
+      {
+        const std::clock_t cpuStart = std::clock();
+        timer.start();
+        function();
+        const double wall = timer.nsecsElapsed() / 1000000.0;
+        const double cpu = 1000.0 * ( std::clock() - cpuStart ) / CLOCKS_PER_SEC;
+        result.wall << wall;
+        result.cpu << cpu;
+      }
+      result.status = QStringLiteral( "ok" );
+
+      QVector< double > sorted = result.wall;
+      std::sort( sorted.begin(), sorted.end() );
+      log << QStringLiteral( "%1 ms (median wall)" ).arg( sorted.isEmpty() ? 0 : sorted.at( sorted.size() / 2 ), 0, 'f', 3 ).toLocal8Bit().constData() << std::endl;
+    }
+    catch ( QgsBenchmarkSkip &skip )
+    {
+      result.status = QStringLiteral( "skipped" );
+      result.message = skip.reason;
+      log << "skipped (" << skip.reason.toLocal8Bit().constData() << ")" << std::endl;
+    }
+    catch ( QgsException &e )
+    {
+      result.status = QStringLiteral( "failed" );
+      result.message = e.what();
+      log << "failed (" << result.message.toLocal8Bit().constData() << ")" << std::endl;
+    }
+    catch ( std::exception &e )
+    {
+      result.status = QStringLiteral( "failed" );
+      result.message = QString::fromLocal8Bit( e.what() );
+      log << "failed (" << e.what() << ")" << std::endl;
+    }
+    mResults.append( result );
+  }
+}
+
+QString QgsBenchmarkSuite::toJson() const
+{
+  json cases = json::array();
+  for ( const Result &result : mResults )
+  {
+    json item
+    {
+      { "name", result.name.toStdString() },
+      { "status", result.status.toStdString() },
+    };
+    if ( !result.message.isEmpty() )
+      item[ "message" ] = result.message.toStdString();
+    if ( !result.wall.isEmpty() )
+    {
+      item[ "wall_ms" ] = statistics( result.wall );
+      item[ "cpu_ms" ] = statistics( result.cpu );
+    }
+    cases.push_back( item );
+  }
+
+  const json results
+  {
+    { "qgis_version", Qgis::version().toStdString() },
+    { "qgis_release", Qgis::versionInt() },
+    { "qt_version", qVersion() },
+    { "platform", QSysInfo::prettyProductName().toStdString() },
+    { "cpu_architecture", QSysInfo::currentCpuArchitecture().toStdString() },
+    { "threads", QThread::idealThreadCount() },
+    { "date", QDateTime::currentDateTimeUtc().toString( Qt::ISODate ).toStdString() },
+    { "iterations", mIterations },
+    { "warmup", mWarmup },
+    { "cases", cases },
+  };
+  return QString::fromStdString( results.dump( 2 ) );
+}
+
+bool QgsBenchmarkSuite::saveResults( const QString &fileName ) const
+{
+  QFile file( fileName );
+  if ( !file.open( QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate ) )
+    return false;
+
+  file.write( toJson().toUtf8() );
+  file.write( "\n" );
+  return true;
+}
+
+int QgsBenchmarkSuite::failureCount() const
+{
+  return std::count_if( mResults.constBegin(), mResults.constEnd(), []( const Result & result )
+  {
+    return result.status == QLatin1String( "failed" );
+  } );
+}
@@ -0,0 +1,110 @@
+/***************************************************************************
+                 qgsbenchmarksuite.h  - Micro benchmark runner
+                             -------------------
+    begin                : October 2020
+    copyright            : (C) 2020 by the QGIS project
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef QGSBENCHMARKSUITE_H
+#define QGSBENCHMARKSUITE_H
+
+#include <QList>
+#include <QRegularExpression>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <functional>
+#include <ostream>
+
+/**
+ * Runs named benchmark cases and collects their timings.
+ *
+ * Each case is registered with a prepare function, which is only called if the case
+ * is selected and which returns the function to time. Data set up by the prepare
+ * function is therefore not part of the measurements. A prepare function may throw a
+ * QgsBenchmarkSkip to report that the case cannot run in this environment (e.g. a
+ * PostgreSQL case without a configured database).
+ *
+ * Results are written as JSON, with the wall and CPU time statistics (in milliseconds)
+ * of every case, so that runs of different builds can be compared automatically.
+ */
+class QgsBenchmarkSuite
+{
+  public:
+
+    //! Function timed for each iteration of a case
+    typedef std::function< void() > Function;
+
+    //! Prepares a case and returns the function to time
+    typedef std::function< Function() > PrepareFunction;
+
+    //! Registers a case called \a name, named as "group/case"
+    void addCase( const QString &name, const PrepareFunction &prepare );
+
+    //! Returns the names of all registered cases
+    QStringList caseNames() const;
+
+    /**
+     * Runs the cases with a name matching \a filter, timing \a iterations runs after
+     * \a warmup untimed ones. Progress is written to \a log.
+     */
+    void run( int iterations, int warmup, const QRegularExpression &filter, std::ostream &log );
+
+    //! Returns the results of the last run() as JSON
+    QString toJson() const;
+
+    //! Writes the results of the last run() as JSON to \a fileName
+    bool saveResults( const QString &fileName ) const;
+
+    //! Returns the number of cases which failed during the last run()
+    int failureCount() const;
+
+  private:
+
+    struct Case
+    {
+      QString name;
+      PrepareFunction prepare;
+    };
+
+    struct Result
+    {
+      QString name;
+      QString status;
+      QString message;
+      QVector< double > wall;
+      QVector< double > cpu;
+    };
+
+    QList< Case > mCases;
+    QList< Result > mResults;
+    int mIterations = 0;
+    int mWarmup = 0;
+};
+
+/**
+ * Exception thrown by a benchmark prepare function to skip the case.
+ */
+struct QgsBenchmarkSkip
+{
+  explicit QgsBenchmarkSkip( const QString &reason ) : reason( reason ) {}
+  QString reason;
+};
+
+/**
+ * Registers all the benchmark cases of the suite. Temporary data sets are created
+ * below \a dataPath.
+ */
+void registerBenchmarkCases( QgsBenchmarkSuite &suite, const QString &dataPath );
+
+#endif // QGSBENCHMARKSUITE_H
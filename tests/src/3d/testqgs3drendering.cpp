@@ -52,10 +52,12 @@
 #include "qgssinglesymbolrenderer.h"
 #include "qgsfillsymbollayer.h"
 #include "qgssimplelinematerialsettings.h"
+#include "qgs3dsceneexporter.h"
 
 #include <QFileInfo>
 #include <QDir>
 #include <QDesktopWidget>
+#include <QTemporaryDir>
 
 class TestQgs3DRendering : public QObject
 {
@@ -78,6 +80,7 @@ class TestQgs3DRendering : public QObject
     void testRuleBasedRenderer();
     void testAnimationExport();
     void testBillboardRendering();
+    void testExportTerrainLevelOfDetail();
 
   private:
     bool renderCheck( const QString &testName, QImage &image, int mismatchCount = 0 );
@@ -828,5 +831,55 @@ void TestQgs3DRendering::testBillboardRendering()
   QVERIFY( renderCheck( "billboard_rendering_2", img2, 40 ) );
 }
 
+void TestQgs3DRendering::testExportTerrainLevelOfDetail()
+{
+  QgsRectangle fullExtent = mLayerDtm->extent();
+
+  Qgs3DMapSettings *map = new Qgs3DMapSettings;
+  map->setCrs( mProject->crs() );
+  map->setOrigin( QgsVector3D( fullExtent.center().x(), fullExtent.center().y(), 0 ) );
+  map->setTerrainLayers( QList<QgsMapLayer *>() << mLayerRgb );
+
+  QgsFlatTerrainGenerator *flatTerrain = new QgsFlatTerrainGenerator;
+  flatTerrain->setCrs( map->crs() );
+  flatTerrain->setExtent( fullExtent );
+  map->setTerrainGenerator( flatTerrain );
+
+  QgsOffscreen3DEngine engine;
+  Qgs3DMapScene *scene = new Qgs3DMapScene( *map, &engine );
+  engine.setRootEntity( scene );
+  scene->cameraController()->setLookingAtPoint( QgsVector3D( 0, 0, 0 ), 2500, 0, 0 );
+  Qgs3DUtils::captureSceneImage( engine, scene );
+
+  QgsChunkNode *rootNode = scene->terrainEntity()->rootNode();
+  QgsChunkNode *sceneChildren[4];
+  for ( int i = 0; i < 4; ++i )
+    sceneChildren[i] = rootNode->children()[i];
+
+  QTemporaryDir dir;
+  {
+    Qgs3DSceneExporter exporter;
+    exporter.setTerrainLevelOfDetail( 2 );
+    exporter.parseTerrain( scene->terrainEntity(), QStringLiteral( "terrain" ) );
+
+    // the tiles of the export are not added to the nodes of the scene
+    for ( int i = 0; i < 4; ++i )
+      QCOMPARE( rootNode->children()[i], sceneChildren[i] );
+
+    exporter.save( QStringLiteral( "terrain" ), dir.path() );
+  }
+
+  // 4 x 4 tiles at the level 2
+  QFile objFile( QDir( dir.path() ).filePath( QStringLiteral( "terrain.obj" ) ) );
+  QVERIFY( objFile.open( QIODevice::ReadOnly | QIODevice::Text ) );
+  int objects = 0;
+  while ( !objFile.atEnd() )
+  {
+    if ( objFile.readLine().startsWith( "o " ) )
+      ++objects;
+  }
+  QCOMPARE( objects, 16 );
+}
+
 QGSTEST_MAIN( TestQgs3DRendering )
 #include "testqgs3drendering.moc"
@@ -0,0 +1,235 @@
+/***************************************************************************
+     testqgsterrainheightmapcache.cpp
+     --------------------------------
+    Date                 : October 2020
+    Copyright            : (C) 2020 by the QGIS project
+    Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+
+#include "qgssettings.h"
+#include "qgsterrainheightmapcache.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+/**
+ * \ingroup UnitTests
+ * This is a unit test for the on-disk cache of the terrain heightmaps
+ */
+class TestQgsTerrainHeightMapCache : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+
+    void roundTrip();
+    void newVersion();
+    void remoteMaxAge();
+    void invalidate();
+    void trim();
+
+  private:
+    //! Returns a heightmap of \a resolution x \a resolution floats starting at \a value
+    QByteArray heightMap( int resolution, float value ) const;
+
+    //! Stores \a count heightmaps of \a resolution in the directory of \a source
+    QString storeHeightMaps( const QString &source, int count, int resolution );
+
+    QTemporaryDir mDir;
+};
+
+void TestQgsTerrainHeightMapCache::initTestCase()
+{
+  QCoreApplication::setOrganizationName( QStringLiteral( "QGIS" ) );
+  QCoreApplication::setOrganizationDomain( QStringLiteral( "qgis.org" ) );
+  QCoreApplication::setApplicationName( QStringLiteral( "QGIS-TEST" ) );
+
+  QVERIFY( mDir.isValid() );
+  QgsSettings().setValue( QStringLiteral( "3D/heightMapCacheDirectory" ), mDir.filePath( QStringLiteral( "3d_heightmaps" ) ) );
+  QCOMPARE( QgsTerrainHeightMapCache::cacheDirectory(), mDir.filePath( QStringLiteral( "3d_heightmaps" ) ) );
+}
+
+void TestQgsTerrainHeightMapCache::cleanupTestCase()
+{
+  QgsSettings().remove( QStringLiteral( "3D/heightMapCacheDirectory" ) );
+}
+
+void TestQgsTerrainHeightMapCache::init()
+{
+  QDir( QgsTerrainHeightMapCache::cacheDirectory() ).removeRecursively();
+}
+
+QByteArray TestQgsTerrainHeightMapCache::heightMap( int resolution, float value ) const
+{
+  QByteArray data( resolution * resolution * static_cast<int>( sizeof( float ) ), Qt::Uninitialized );
+  float *values = reinterpret_cast<float *>( data.data() );
+  for ( int i = 0; i < resolution * resolution; ++i )
+    values[i] = value + i;
+  return data;
+}
+
+QString TestQgsTerrainHeightMapCache::storeHeightMaps( const QString &source, int count, int resolution )
+{
+  const QString directory = QgsTerrainHeightMapCache::sourceDirectory( source, QStringLiteral( "1" ) );
+  for ( int i = 0; i < count; ++i )
+    QgsTerrainHeightMapCache::writeHeightMap( QgsTerrainHeightMapCache::heightMapPath( directory, QString::number( i ) ), resolution, heightMap( resolution, i ) );
+  return directory;
+}
+
+void TestQgsTerrainHeightMapCache::roundTrip()
+{
+  const QString directory = QgsTerrainHeightMapCache::sourceDirectory( QStringLiteral( "gdal:/data/dem.tif" ), QStringLiteral( "1" ) );
+  QVERIFY( !directory.isEmpty() );
+  QVERIFY( QDir( directory ).exists() );
+  // the directory of a source does not depend on its version
+  QCOMPARE( QgsTerrainHeightMapCache::sourceDirectory( QStringLiteral( "gdal:/data/dem.tif" ), QStringLiteral( "1" ) ), directory );
+  QVERIFY( QgsTerrainHeightMapCache::sourceDirectory( QStringLiteral( "gdal:/data/other.tif" ), QStringLiteral( "1" ) ) != directory );
+
+  const QString path = QgsTerrainHeightMapCache::heightMapPath( directory, QStringLiteral( "tile 0/0/0" ) );
+  QVERIFY( path.startsWith( directory ) );
+  QVERIFY( path != QgsTerrainHeightMapCache::heightMapPath( directory, QStringLiteral( "tile 1/0/0" ) ) );
+  QVERIFY( QgsTerrainHeightMapCache::readHeightMap( path, 16 ).isNull() );
+
+  const QByteArray data = heightMap( 16, 100 );
+  QVERIFY( QgsTerrainHeightMapCache::writeHeightMap( path, 16, data ) );
+  QCOMPARE( QgsTerrainHeightMapCache::readHeightMap( path, 16 ), data );
+
+  // a heightmap of another resolution is not returned
+  QVERIFY( QgsTerrainHeightMapCache::readHeightMap( path, 8 ).isNull() );
+  // nor stored
+  QVERIFY( !QgsTerrainHeightMapCache::writeHeightMap( path, 8, data ) );
+  QCOMPARE( QgsTerrainHeightMapCache::readHeightMap( path, 16 ), data );
+
+  // a truncated file is ignored
+  QFile file( path );
+  QVERIFY( file.resize( file.size() - 4 ) );
+  QVERIFY( QgsTerrainHeightMapCache::readHeightMap( path, 16 ).isNull() );
+
+  // no cache directory
+  QVERIFY( QgsTerrainHeightMapCache::heightMapPath( QString(), QStringLiteral( "tile 0/0/0" ) ).isEmpty() );
+  QVERIFY( !QgsTerrainHeightMapCache::writeHeightMap( QString(), 16, data ) );
+}
+
+void TestQgsTerrainHeightMapCache::newVersion()
+{
+  const QString source = QStringLiteral( "gdal:/data/dem.tif" );
+  QString directory = QgsTerrainHeightMapCache::sourceDirectory( source, QStringLiteral( "1" ) );
+  const QString path = QgsTerrainHeightMapCache::heightMapPath( directory, QStringLiteral( "tile" ) );
+  QVERIFY( QgsTerrainHeightMapCache::writeHeightMap( path, 4, heightMap( 4, 0 ) ) );
+
+  // the same version keeps its heightmaps
+  directory = QgsTerrainHeightMapCache::sourceDirectory( source, QStringLiteral( "1" ) );
+  QVERIFY( !QgsTerrainHeightMapCache::readHeightMap( path, 4 ).isNull() );
+
+  // the heightmaps of the modified file are removed, no directory is left behind
+  const QString newDirectory = QgsTerrainHeightMapCache::sourceDirectory( source, QStringLiteral( "2" ) );
+  QCOMPARE( newDirectory, directory );
+  QVERIFY( QgsTerrainHeightMapCache::readHeightMap( path, 4 ).isNull() );
+  QCOMPARE( QDir( QgsTerrainHeightMapCache::cacheDirectory() ).entryList( QDir::Dirs | QDir::NoDotAndDotDot ).size(), 1 );
+}
+
+void TestQgsTerrainHeightMapCache::remoteMaxAge()
+{
+  const QString source = QStringLiteral( "https://example.com/terrain/{z}/{x}/{y}.png" );
+  const QString directory = QgsTerrainHeightMapCache::sourceDirectory( source, QString(), 7 );
+  const QString path = QgsTerrainHeightMapCache::heightMapPath( directory, QStringLiteral( "tile" ) );
+  QVERIFY( QgsTerrainHeightMapCache::writeHeightMap( path, 4, heightMap( 4, 0 ) ) );
+
+  // recent heightmaps are kept
+  QgsTerrainHeightMapCache::sourceDirectory( source, QString(), 7 );
+  QVERIFY( !QgsTerrainHeightMapCache::readHeightMap( path, 4 ).isNull() );
+
+  // the heightmaps were stored 8 days ago
+  QFile versionFile( QDir( directory ).filePath( QStringLiteral( "version.txt" ) ) );
+  QVERIFY( versionFile.open( QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate ) );
+  QTextStream stream( &versionFile );
+  stream << '\n' << QDateTime::currentDateTime().addDays( -8 ).toMSecsSinceEpoch() << '\n';
+  stream.flush();
+  versionFile.close();
+
+  // without a maximum age, they are still valid
+  QgsTerrainHeightMapCache::sourceDirectory( source, QString() );
+  QVERIFY( !QgsTerrainHeightMapCache::readHeightMap( path, 4 ).isNull() );
+
+  // and the age is the one of the first use of the directory, not of the last one
+  QgsTerrainHeightMapCache::sourceDirectory( source, QString(), 7 );
+  QVERIFY( QgsTerrainHeightMapCache::readHeightMap( path, 4 ).isNull() );
+}
+
+void TestQgsTerrainHeightMapCache::invalidate()
+{
+  const QString source = QStringLiteral( "wcs:url=https://example.com/wcs" );
+  const QString directory = QgsTerrainHeightMapCache::sourceDirectory( source, QString(), 7 );
+  const QString path = QgsTerrainHeightMapCache::heightMapPath( directory, QStringLiteral( "tile" ) );
+  QVERIFY( QgsTerrainHeightMapCache::writeHeightMap( path, 4, heightMap( 4, 0 ) ) );
+  const QString otherDirectory = storeHeightMaps( QStringLiteral( "gdal:/data/dem.tif" ), 1, 4 );
+
+  QgsTerrainHeightMapCache::invalidate( source );
+  QVERIFY( QgsTerrainHeightMapCache::readHeightMap( path, 4 ).isNull() );
+  QVERIFY( !QDir( directory ).exists() );
+  // the other sources are kept
+  QVERIFY( !QgsTerrainHeightMapCache::readHeightMap( QgsTerrainHeightMapCache::heightMapPath( otherDirectory, QStringLiteral( "0" ) ), 4 ).isNull() );
+
+  // heightmaps can be stored again
+  QVERIFY( QgsTerrainHeightMapCache::writeHeightMap( path, 4, heightMap( 4, 1 ) ) );
+  QCOMPARE( QgsTerrainHeightMapCache::readHeightMap( path, 4 ), heightMap( 4, 1 ) );
+}
+
+void TestQgsTerrainHeightMapCache::trim()
+{
+  // 3 sources of 4 heightmaps of 64 kB, used one after the other
+  const QString oldest = storeHeightMaps( QStringLiteral( "a" ), 4, 128 );
+  QTest::qWait( 1100 );
+  const QString middle = storeHeightMaps( QStringLiteral( "b" ), 4, 128 );
+  QTest::qWait( 1100 );
+  const QString newest = storeHeightMaps( QStringLiteral( "c" ), 4, 128 );
+
+  const qint64 heightMapSize = 3 * 4 + 128 * 128 * 4;
+  const qint64 size = QgsTerrainHeightMapCache::size();
+  QVERIFY( size >= 12 * heightMapSize );
+  QVERIFY( size < 13 * heightMapSize );
+
+  // nothing to remove
+  QgsTerrainHeightMapCache::trim( size );
+  QCOMPARE( QgsTerrainHeightMapCache::size(), size );
+
+  // the least recently used source is removed first
+  QgsTerrainHeightMapCache::trim( size - 1 );
+  QVERIFY( !QDir( oldest ).exists() );
+  QVERIFY( QDir( middle ).exists() );
+  QVERIFY( QDir( newest ).exists() );
+
+  // using a source again makes it the most recently used
+  QTest::qWait( 1100 );
+  QgsTerrainHeightMapCache::sourceDirectory( QStringLiteral( "b" ), QStringLiteral( "1" ) );
+  QgsTerrainHeightMapCache::trim( 5 * heightMapSize );
+  QVERIFY( QDir( middle ).exists() );
+  QVERIFY( !QDir( newest ).exists() );
+
+  // the directory in use is kept, only its oldest heightmaps are removed
+  QgsTerrainHeightMapCache::trim( 2 * heightMapSize, middle );
+  QVERIFY( QDir( middle ).exists() );
+  QVERIFY( QgsTerrainHeightMapCache::size() <= 2 * heightMapSize );
+  QCOMPARE( QDir( middle ).entryList( QStringList() << QStringLiteral( "*.heightmap" ), QDir::Files ).size(), 1 );
+
+  QgsTerrainHeightMapCache::trim( 0 );
+  QCOMPARE( QgsTerrainHeightMapCache::size(), qint64( 0 ) );
+}
+
+QGSTEST_MAIN( TestQgsTerrainHeightMapCache )
+#include "testqgsterrainheightmapcache.moc"
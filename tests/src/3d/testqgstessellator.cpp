@@ -143,6 +143,7 @@ class TestQgsTessellator : public QObject
     void testTriangulationDoesNotCrash();
     void testCrash2DTriangle();
     void narrowPolygon();
+    void testAddPolygons();
 
   private:
 };
@@ -424,5 +425,38 @@ void TestQgsTessellator::narrowPolygon()
   QCOMPARE( res.asWkt( 0 ), QStringLiteral( "MultiPolygonZ (((383357 4902094 0, 383356 4902092 0, 383356 4902091 0, 383357 4902094 0)),((383357 4902088 0, 383357 4902094 0, 383356 4902091 0, 383357 4902088 0)),((383357 4902088 0, 383361 4902086 0, 383357 4902094 0, 383357 4902088 0)),((383357 4902094 0, 383361 4902086 0, 383360 4902094 0, 383357 4902094 0)),((383363 4902094 0, 383360 4902094 0, 383361 4902086 0, 383363 4902094 0)),((383368 4902093 0, 383363 4902094 0, 383361 4902086 0, 383368 4902093 0)),((383368 4902093 0, 383361 4902086 0, 383369 4902085 0, 383368 4902093 0)),((383368 4902093 0, 383369 4902085 0, 383375 4902093 0, 383368 4902093 0)),((383375 4902093 0, 383369 4902085 0, 383380 4902084 0, 383375 4902093 0)),((383375 4902093 0, 383380 4902084 0, 383384 4902093 0, 383375 4902093 0)),((383384 4902093 0, 383380 4902084 0, 383396 4902084 0, 383384 4902093 0)),((383394 4902094 0, 383384 4902093 0, 383396 4902084 0, 383394 4902094 0)),((383403 4902094 0, 383394 4902094 0, 383396 4902084 0, 383403 4902094 0)),((383396 4902084 0, 383407 4902084 0, 383403 4902094 0, 383396 4902084 0)),((383411 4902094 0, 383403 4902094 0, 383407 4902084 0, 383411 4902094 0)),((383411 4902094 0, 383407 4902084 0, 383413 4902085 0, 383411 4902094 0)),((383411 4902094 0, 383413 4902085 0, 383416 4902093 0, 383411 4902094 0)),((383416 4902093 0, 383413 4902085 0, 383417 4902086 0, 383416 4902093 0)),((383419 4902088 0, 383416 4902093 0, 383417 4902086 0, 383419 4902088 0)),((383418 4902092 0, 383416 4902093 0, 383419 4902088 0, 383418 4902092 0)),((383418 4902092 0, 383419 4902088 0, 383419 4902091 0, 383418 4902092 0)),((383419 4902091 0, 383419 4902088 0, 383420 4902090 0, 383419 4902091 0)))" ) );
 }
 
+void TestQgsTessellator::testAddPolygons()
+{
+  // the batch gives the same vertices as the polygons added one by one
+  QgsPolygon polygon1;
+  polygon1.fromWkt( "POLYGONZ((1 1 5, 2 1 5, 3 2 5, 1 2 5, 1 1 5))" );
+  QgsPolygon polygon2;
+  polygon2.fromWkt( "POLYGONZ((10 10 0, 20 10 0, 20 20 0, 10 20 0, 10 10 0),(12 12 0, 14 12 0, 14 14 0, 12 14 0, 12 12 0))" );
+  QgsPolygon polygon3;
+  polygon3.fromWkt( "POLYGONZ((0 0 2, 42 0 2, 42 42 2, 0 0 2))" );
+
+  QgsTessellator expected( 0, 0, true );
+  expected.addPolygon( polygon1, 0 );
+  const int vertices2 = expected.dataVerticesCount();
+  expected.addPolygon( polygon2, 3 );
+  const int vertices3 = expected.dataVerticesCount();
+  expected.addPolygon( polygon3, 1 );
+
+  QgsTessellator t( 0, 0, true );
+  const QVector<int> firstVertices = t.addPolygons( QVector<const QgsPolygon *>() << &polygon1 << &polygon2 << &polygon3, QVector<float>() << 0 << 3 << 1 );
+  QCOMPARE( firstVertices, QVector<int>() << 0 << vertices2 << vertices3 );
+  QCOMPARE( t.data(), expected.data() );
+  QCOMPARE( t.zMinimum(), expected.zMinimum() );
+  QCOMPARE( t.zMaximum(), expected.zMaximum() );
+
+  // data from another tessellator with the same settings
+  QgsTessellator tData( 0, 0, true );
+  tData.addData( expected.data().mid( 0, vertices2 * tData.stride() / sizeof( float ) ) );
+  tData.addData( expected.data().mid( vertices2 * tData.stride() / sizeof( float ) ) );
+  QCOMPARE( tData.data(), expected.data() );
+  QCOMPARE( tData.zMinimum(), 0.0f );
+  QCOMPARE( tData.zMaximum(), 5.0f );
+}
+
 QGSTEST_MAIN( TestQgsTessellator )
 #include "testqgstessellator.moc"
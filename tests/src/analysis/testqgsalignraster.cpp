@@ -21,6 +21,7 @@
 #include "qgsrectangle.h"
 
 #include <QDir>
+#include <QThread>
 
 #include <gdal.h>
 
@@ -78,6 +79,58 @@ class TestAlignRaster : public QObject
       QCOMPARE( out.identify( 106.3, -6.5 ), 6. );
     }
 
+    void testMultipleRasters()
+    {
+      struct Progress : public QgsAlignRaster::ProgressHandler
+      {
+        bool progress( double complete ) override
+        {
+          threads << QThread::currentThread();
+          values << complete;
+          return true;
+        }
+        QList<QThread *> threads;
+        QList<double> values;
+      };
+
+      // several rasters are aligned concurrently, reporting their overall progress in the calling thread
+      QgsAlignRaster align;
+      QgsAlignRaster::List rasters;
+      for ( int i = 0; i < 4; ++i )
+        rasters << QgsAlignRaster::Item( SRC_FILE, _tempFile( QStringLiteral( "multiple-%1" ).arg( i ) ) );
+      rasters[1].resampleMethod = QgsAlignRaster::RA_Bilinear;
+      align.setRasters( rasters );
+      align.setParametersFromRaster( SRC_FILE );
+      align.setCellSize( 0.1, 0.1 );
+      Progress progress;
+      align.setProgressHandler( &progress );
+      bool res = align.run();
+      QVERIFY( res );
+      align.setProgressHandler( nullptr );
+
+      QVERIFY( !progress.values.isEmpty() );
+      QCOMPARE( progress.values.last(), 1.0 );
+      for ( QThread *thread : qgis::as_const( progress.threads ) )
+        QCOMPARE( thread, QThread::currentThread() );
+
+      QgsAlignRaster::RasterInfo first( rasters.at( 0 ).outputFilename );
+      QVERIFY( first.isValid() );
+      for ( int i = 1; i < 4; ++i )
+      {
+        QgsAlignRaster::RasterInfo out( rasters.at( i ).outputFilename );
+        QVERIFY( out.isValid() );
+        QCOMPARE( out.rasterSize(), QSize( 8, 8 ) );
+        QCOMPARE( out.cellSize(), QSizeF( 0.1, 0.1 ) );
+        if ( i == 1 )
+          QCOMPARE( out.identify( 106.15, -6.35 ), 2.25 );
+        else
+        {
+          QCOMPARE( out.identify( 106.15, -6.35 ), first.identify( 106.15, -6.35 ) );
+          QCOMPARE( out.identify( 106.65, -6.85 ), first.identify( 106.65, -6.85 ) );
+        }
+      }
+    }
+
     void testClipOutside()
     {
       QString tmpFile( _tempFile( QStringLiteral( "clip-outside" ) ) );
@@ -21,6 +21,8 @@ Email                : nyall dot dawson at gmail dot com
 #include "qgsvectordataprovider.h"
 #include "qgsvectorlayer.h"
 
+#include <QThreadPool>
+
 
 class TestQgsGeometrySnapper : public QObject
 {
@@ -51,6 +53,7 @@ class TestQgsGeometrySnapper : public QObject
     void insertExtra();
     void duplicateNodes();
     void snapMultiPolygonToPolygon();
+    void snapFeaturesInParallel();
 };
 
 void  TestQgsGeometrySnapper::initTestCase()
@@ -631,6 +634,39 @@ void TestQgsGeometrySnapper::snapMultiPolygonToPolygon()
 
 }
 
+void TestQgsGeometrySnapper::snapFeaturesInParallel()
+{
+  // a grid of squares, snapped by a shifted grid
+  std::unique_ptr< QgsVectorLayer > rl = qgis::make_unique< QgsVectorLayer >( QStringLiteral( "Polygon" ), QStringLiteral( "x" ), QStringLiteral( "memory" ) );
+  QgsFeatureList refFeatures;
+  QgsFeatureList features;
+  for ( int i = 0; i < 40; ++i )
+  {
+    for ( int j = 0; j < 40; ++j )
+    {
+      QgsFeature ff;
+      ff.setGeometry( QgsGeometry::fromRect( QgsRectangle( i, j, i + 1, j + 1 ) ) );
+      refFeatures << ff;
+      ff.setGeometry( QgsGeometry::fromRect( QgsRectangle( i + 0.05, j - 0.05, i + 1.02, j + 0.97 ) ) );
+      features << ff;
+    }
+  }
+  rl->dataProvider()->addFeatures( refFeatures );
+
+  const int maxThreads = QThreadPool::globalInstance()->maxThreadCount();
+  QThreadPool::globalInstance()->setMaxThreadCount( 4 );
+
+  QgsGeometrySnapper snapper( rl.get() );
+  // the reference geometries are read once, the source is not needed anymore to snap
+  rl.reset();
+  const QgsFeatureList result = snapper.snapFeatures( features, 0.1 );
+  QThreadPool::globalInstance()->setMaxThreadCount( maxThreads );
+
+  QCOMPARE( result.size(), features.size() );
+  for ( int i = 0; i < result.size(); ++i )
+    QCOMPARE( result.at( i ).geometry().asWkt(), snapper.snapGeometry( features.at( i ).geometry(), 0.1 ).asWkt() );
+  QCOMPARE( result.at( 0 ).geometry().asWkt(), QStringLiteral( "Polygon ((0 0, 1 0, 1 1, 0 1, 0 0))" ) );
+}
 
 QGSTEST_MAIN( TestQgsGeometrySnapper )
 #include "testqgsgeometrysnapper.moc"
@@ -16,6 +16,13 @@ Email                : nyall dot dawson at gmail dot com
 
 #include "qgsapplication.h"
 #include "qgsdualedgetriangulation.h"
+#include "qgsgdalutils.h"
+#include "qgsgridfilewriter.h"
+#include "qgsidwinterpolator.h"
+#include "qgsvectordataprovider.h"
+#include "qgsvectorlayer.h"
+
+#include <QTemporaryDir>
 
 class TestQgsInterpolator : public QObject
 {
@@ -29,6 +36,7 @@ class TestQgsInterpolator : public QObject
     void init() ;// will be called before each testfunction is executed.
     void cleanup() ;// will be called after every testfunction.
     void dualEdge();
+    void idwNearestPoints();
 
   private:
 };
@@ -281,5 +289,93 @@ void TestQgsInterpolator::dualEdge()
 }
 
 
+void TestQgsInterpolator::idwNearestPoints()
+{
+  QgsVectorLayer layer( QStringLiteral( "Point?crs=epsg:3857&field=value:double" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  QgsFeatureList features;
+  for ( int i = 0; i < 500; ++i )
+  {
+    QgsFeature f;
+    f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( ( i * 37 ) % 101 + 0.25, ( i * 61 ) % 97 + 0.5 ) ) );
+    f.setAttributes( QgsAttributes() << ( i * 13 ) % 29 );
+    features << f;
+  }
+  layer.dataProvider()->addFeatures( features );
+
+  QgsInterpolator::LayerData data;
+  data.source = &layer;
+  data.interpolationAttribute = 0;
+  data.valueSource = QgsInterpolator::ValueAttribute;
+
+  QgsIDWInterpolator all( QList< QgsInterpolator::LayerData >() << data );
+  QgsIDWInterpolator nearest( QList< QgsInterpolator::LayerData >() << data );
+  nearest.setMaxPoints( 8 );
+  QgsIDWInterpolator radius( QList< QgsInterpolator::LayerData >() << data );
+  radius.setSearchRadius( 15 );
+  QgsIDWInterpolator everything( QList< QgsInterpolator::LayerData >() << data );
+  everything.setMaxPoints( 500 );
+
+  for ( int i = 0; i < 50; ++i )
+  {
+    const double x = ( i * 17 ) % 120 - 10.5;
+    const double y = ( i * 23 ) % 110 - 5.25;
+
+    // brute force weights of the 8 nearest points, and of the points within the radius
+    QVector< QPair< double, double > > distances;
+    for ( const QgsFeature &f : qgis::as_const( features ) )
+    {
+      const QgsPointXY point = f.geometry().asPoint();
+      distances << qMakePair( point.distance( x, y ), f.attribute( 0 ).toDouble() );
+    }
+    std::sort( distances.begin(), distances.end() );
+    double sum = 0;
+    double weights = 0;
+    for ( int j = 0; j < 8; ++j )
+    {
+      sum += distances.at( j ).second / ( distances.at( j ).first * distances.at( j ).first );
+      weights += 1 / ( distances.at( j ).first * distances.at( j ).first );
+    }
+    double radiusSum = 0;
+    double radiusWeights = 0;
+    for ( const QPair< double, double > &distance : qgis::as_const( distances ) )
+    {
+      if ( distance.first <= 15 )
+      {
+        radiusSum += distance.second / ( distance.first * distance.first );
+        radiusWeights += 1 / ( distance.first * distance.first );
+      }
+    }
+
+    double result = 0;
+    double expected = 0;
+    QCOMPARE( nearest.interpolatePoint( x, y, result ), 0 );
+    QGSCOMPARENEAR( result, sum / weights, 1e-9 );
+
+    QCOMPARE( radius.interpolatePoint( x, y, result ), radiusWeights > 0 ? 0 : 1 );
+    if ( radiusWeights > 0 )
+      QGSCOMPARENEAR( result, radiusSum / radiusWeights, 1e-9 );
+
+    QCOMPARE( all.interpolatePoint( x, y, expected ), 0 );
+    QCOMPARE( everything.interpolatePoint( x, y, result ), 0 );
+    QGSCOMPARENEAR( result, expected, 1e-9 );
+  }
+
+  // the grid is streamed to a GeoTIFF
+  QTemporaryDir dir;
+  const QString tiffPath = dir.filePath( QStringLiteral( "idw.tif" ) );
+  QgsGridFileWriter writer( &nearest, tiffPath, QgsRectangle( 0, 0, 100, 50 ), 40, 20 );
+  QCOMPARE( writer.writeFile(), 0 );
+  gdal::dataset_unique_ptr dataset( GDALOpen( tiffPath.toUtf8().constData(), GA_ReadOnly ) );
+  QVERIFY( dataset );
+  QCOMPARE( GDALGetRasterXSize( dataset.get() ), 40 );
+  QCOMPARE( GDALGetRasterYSize( dataset.get() ), 20 );
+  float value = 0;
+  QCOMPARE( GDALRasterIO( GDALGetRasterBand( dataset.get(), 1 ), GF_Read, 3, 2, 1, 1, &value, 1, 1, GDT_Float32, 0, 0 ), CE_None );
+  double expected = 0;
+  QCOMPARE( nearest.interpolatePoint( 3 * 2.5 + 1.25, 50 - 2 * 2.5 - 1.25, expected ), 0 );
+  QGSCOMPARENEAR( value, expected, 1e-4 );
+}
+
+
 QGSTEST_MAIN( TestQgsInterpolator )
 #include "testqgsinterpolator.moc"
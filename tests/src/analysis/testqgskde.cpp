@@ -0,0 +1,114 @@
+/***************************************************************************
+     testqgskde.cpp
+     --------------
+    Date                 : October 2020
+    Copyright            : (C) 2020 by the QGIS project
+    Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+
+#include "qgsapplication.h"
+#include "qgsfeature.h"
+#include "qgsgeometry.h"
+#include "qgskde.h"
+#include "qgsogrutils.h"
+#include "qgsvectorlayer.h"
+
+#include <QTemporaryDir>
+
+#include <gdal.h>
+
+/**
+ * \ingroup UnitTests
+ * This is a unit test for the kernel density estimation class
+ */
+class TestQgsKde : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testTiles();
+};
+
+void TestQgsKde::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsKde::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+void TestQgsKde::testTiles()
+{
+  // points whose kernels overlap each other and the boundary between the first two columns of tiles
+  const QList< QgsPointXY > points { QgsPointXY( 100, 50 ), QgsPointXY( 560, 50 ), QgsPointXY( 620, 50 ), QgsPointXY( 590, 50 ) };
+  QgsVectorLayer layer( QStringLiteral( "Point?crs=EPSG:3857" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer.isValid() );
+  QgsFeatureList features;
+  for ( const QgsPointXY &point : points )
+  {
+    QgsFeature feature;
+    feature.setGeometry( QgsGeometry::fromPointXY( point ) );
+    features << feature;
+  }
+  QVERIFY( layer.dataProvider()->addFeatures( features ) );
+
+  QgsKernelDensityEstimation::Parameters parameters;
+  parameters.source = &layer;
+  parameters.radius = 50;
+  parameters.pixelSize = 1;
+  parameters.shape = QgsKernelDensityEstimation::KernelUniform;
+  parameters.decayRatio = 0;
+  parameters.outputValues = QgsKernelDensityEstimation::OutputRaw;
+
+  QTemporaryDir dir;
+  const QString path = dir.filePath( QStringLiteral( "kde.tif" ) );
+  QgsKernelDensityEstimation kde( parameters, path, QStringLiteral( "GTiff" ) );
+  QCOMPARE( kde.run(), QgsKernelDensityEstimation::Success );
+
+  gdal::dataset_unique_ptr dataset( GDALOpen( path.toUtf8().constData(), GA_ReadOnly ) );
+  QVERIFY( dataset );
+  const int columns = GDALGetRasterXSize( dataset.get() );
+  const int rows = GDALGetRasterYSize( dataset.get() );
+  QCOMPARE( columns, 621 );
+  QCOMPARE( rows, 101 );
+  QVector< float > values( columns * rows );
+  QCOMPARE( GDALRasterIO( GDALGetRasterBand( dataset.get(), 1 ), GF_Read, 0, 0, columns, rows, values.data(), columns, rows, GDT_Float32, 0, 0 ), CE_None );
+
+  // with a uniform kernel, each cell counts the points within the radius of its centroid
+  for ( int row = 0; row < rows; ++row )
+  {
+    for ( int column = 0; column < columns; ++column )
+    {
+      const QgsPointXY centroid( 50 + column + 0.5, 100 - row - 0.5 );
+      int count = 0;
+      for ( const QgsPointXY &point : points )
+      {
+        if ( centroid.distance( point ) <= 50 )
+          count++;
+      }
+      const float value = values.at( row * columns + column );
+      if ( count == 0 )
+        QCOMPARE( value, -9999.0f );
+      else
+        QCOMPARE( value, static_cast< float >( count ) );
+    }
+  }
+}
+
+QGSTEST_MAIN( TestQgsKde )
+#include "testqgskde.moc"
@@ -46,6 +46,8 @@ class TestQgsMeshCalculator : public QObject
     void singleOp_data();
     void singleOp(); //test operators which operate on a single value
 
+    void elementWise(); //test expressions calculated in a single pass
+
     void calcWithVertexLayers();
     void calcWithFaceLayers();
     void calcWithMixedLayers();
@@ -174,6 +176,47 @@ void TestQgsMeshCalculator::dualOp()
   }
 }
 
+void TestQgsMeshCalculator::elementWise()
+{
+  QString error;
+  std::unique_ptr<QgsMeshCalcNode> node( QgsMeshCalcNode::parseMeshCalcString( QStringLiteral( "abs( \"VertexScalarDataset\" - 2 ) * \"VertexScalarDataset2\" + 1" ), error ) );
+  QVERIFY( node );
+
+  QgsMeshCalcUtils utils( mpMeshLayer,
+                          node->usedDatasetGroupNames(),
+                          0,
+                          3600 );
+  QVERIFY( utils.isValid() );
+
+  QgsMeshMemoryDatasetGroup result( "result" );
+  QVERIFY( node->calculate( utils, result ) );
+
+  // same as the operations on the intermediate dataset groups
+  QgsMeshMemoryDatasetGroup expected( "expected", utils.outputType() );
+  QgsMeshMemoryDatasetGroup right( "right", utils.outputType() );
+  utils.copy( expected, QStringLiteral( "VertexScalarDataset" ) );
+  utils.number( right, 2 );
+  utils.subtract( expected, right );
+  utils.abs( expected );
+  utils.copy( right, QStringLiteral( "VertexScalarDataset2" ) );
+  utils.multiply( expected, right );
+  utils.number( right, 1 );
+  utils.add( expected, right );
+
+  QVERIFY( expected.datasetCount() > 1 );
+  QCOMPARE( result.datasetCount(), expected.datasetCount() );
+  for ( int datasetIndex = 0; datasetIndex < expected.datasetCount(); ++datasetIndex )
+  {
+    std::shared_ptr<QgsMeshMemoryDataset> ds = result.memoryDatasets.at( datasetIndex );
+    std::shared_ptr<QgsMeshMemoryDataset> expectedDs = expected.memoryDatasets.at( datasetIndex );
+    QCOMPARE( ds->time, expectedDs->time );
+    QCOMPARE( ds->active, expectedDs->active );
+    QCOMPARE( ds->values.size(), expectedDs->values.size() );
+    for ( int i = 0; i < ds->values.size(); ++i )
+      QCOMPARE( ds->values.at( i ).scalar(), expectedDs->values.at( i ).scalar() );
+  }
+}
+
 void TestQgsMeshCalculator::singleOp_data()
 {
   QTest::addColumn< QgsMeshCalcNode::Operator >( "op" );
@@ -50,6 +50,8 @@ class TestQgsMeshContours : public QObject
     void testQuadAndTriangleFaceScalarLine_data();
     void testQuadAndTriangleFaceScalarLine();
 
+    void testQuadAndTriangleVertexScalarLines();
+
     void testQuadAndTriangleVertexScalarPoly_data();
     void testQuadAndTriangleVertexScalarPoly();
 
@@ -162,6 +164,24 @@ void TestQgsMeshContours::testQuadAndTriangleFaceScalarLine()
   equals( res, expected );
 }
 
+void TestQgsMeshContours::testQuadAndTriangleVertexScalarLines()
+{
+  QgsMeshDatasetIndex datasetIndex( 1, 0 );
+
+  QgsMeshContours contours( mpMeshLayer );
+
+  // all the levels in a single pass, in the order of the values
+  const QVector<double> values { 2.0, 1.0, 4.0, 1.5, 3.0, 1.0 };
+  const QVector<QgsGeometry> res = contours.exportLines( datasetIndex, values, QgsMeshRendererScalarSettings::None );
+  QCOMPARE( res.size(), values.size() );
+  equals( res.at( 0 ), QgsGeometry( QgsGeometryFactory::geomFromWkt( "LineStringZ (2000 2000 30, 2000 3000 50)" ) ) );
+  equals( res.at( 1 ), QgsGeometry( QgsGeometryFactory::geomFromWkt( "LineStringZ (1000 3000 10, 1000 2000 20)" ) ) );
+  equals( res.at( 2 ), QgsGeometry() );
+  equals( res.at( 3 ), QgsGeometry( QgsGeometryFactory::geomFromWkt( "LineStringZ (1500 3000 30, 1500 2500 35, 1500 2000 25)" ) ) );
+  equals( res.at( 4 ), QgsGeometry() );
+  equals( res.at( 5 ), res.at( 1 ) );
+}
+
 void TestQgsMeshContours::testQuadAndTriangleVertexScalarPoly_data()
 {
   QTest::addColumn< double >( "min_value" );
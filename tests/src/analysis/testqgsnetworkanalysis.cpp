@@ -43,6 +43,9 @@ class TestQgsNetworkAnalysis : public QObject
     void dijkkjkjkskkjsktra();
     void testRouteFail();
     void testRouteFail2();
+    void testShortestPath();
+    void testCostMatrix();
+    void testManyTiePoints();
 
   private:
     std::unique_ptr< QgsVectorLayer > buildNetwork();
@@ -577,5 +580,181 @@ void TestQgsNetworkAnalysis::testRouteFail2()
 
 
 
+static void buildGridGraph( QgsGraph &graph, int size )
+{
+  // a directed grid with uneven costs, where some edges only go one way
+  for ( int y = 0; y < size; ++y )
+    for ( int x = 0; x < size; ++x )
+      graph.addVertex( QgsPointXY( x, y ) );
+  for ( int y = 0; y < size; ++y )
+  {
+    for ( int x = 0; x < size; ++x )
+    {
+      const int v = y * size + x;
+      if ( x + 1 < size )
+      {
+        graph.addEdge( v, v + 1, QVector< QVariant >() << 1 + ( x * 7 + y * 3 ) % 5 );
+        if ( y % 3 != 0 )
+          graph.addEdge( v + 1, v, QVector< QVariant >() << 1 + ( x * 2 + y * 5 ) % 4 );
+      }
+      if ( y + 1 < size )
+      {
+        graph.addEdge( v, v + size, QVector< QVariant >() << 1 + ( x * 3 + y ) % 6 );
+        if ( x % 4 != 1 )
+          graph.addEdge( v + size, v, QVector< QVariant >() << 1 + ( x + y * 7 ) % 3 );
+      }
+    }
+  }
+}
+
+void TestQgsNetworkAnalysis::testShortestPath()
+{
+  const int size = 12;
+  QgsGraph graph;
+  buildGridGraph( graph, size );
+
+  for ( int start : { 0, 17, 65, 143 } )
+  {
+    QVector<int> resultTree;
+    QVector<double> resultCost;
+    QgsGraphAnalyzer::dijkstra( &graph, start, 0, &resultTree, &resultCost );
+
+    for ( int end = 0; end < graph.vertexCount(); ++end )
+    {
+      QVector<int> path;
+      double cost = -1;
+      const bool found = QgsGraphAnalyzer::shortestPath( &graph, start, end, 0, &path, &cost );
+      QCOMPARE( found, end == start || resultTree.at( end ) != -1 );
+      if ( !found )
+        continue;
+
+      QCOMPARE( cost, resultCost.at( end ) );
+      // the path is connected, goes from start to end and has the returned cost
+      int vertex = start;
+      double pathCost = 0;
+      for ( int edgeId : qgis::as_const( path ) )
+      {
+        QCOMPARE( graph.edge( edgeId ).fromVertex(), vertex );
+        vertex = graph.edge( edgeId ).toVertex();
+        pathCost += graph.edge( edgeId ).cost( 0 ).toDouble();
+      }
+      QCOMPARE( vertex, end );
+      QCOMPARE( pathCost, cost );
+    }
+  }
+
+  QVERIFY( !QgsGraphAnalyzer::shortestPath( &graph, 0, graph.vertexCount(), 0 ) );
+
+  // the tree to an end vertex matches the searches from each start vertex
+  const int end = 40;
+  QVector<int> treeToEnd;
+  QVector<double> costToEnd;
+  QgsGraphAnalyzer::dijkstraToVertex( &graph, end, 0, &treeToEnd, &costToEnd );
+  QCOMPARE( treeToEnd.at( end ), -1 );
+  QCOMPARE( costToEnd.at( end ), 0.0 );
+  for ( int start = 0; start < graph.vertexCount(); ++start )
+  {
+    QVector<double> resultCost;
+    QgsGraphAnalyzer::dijkstra( &graph, start, 0, nullptr, &resultCost );
+    QCOMPARE( costToEnd.at( start ), resultCost.at( end ) );
+    if ( start != end && treeToEnd.at( start ) != -1 )
+    {
+      QCOMPARE( graph.edge( treeToEnd.at( start ) ).fromVertex(), start );
+      const int next = graph.edge( treeToEnd.at( start ) ).toVertex();
+      QCOMPARE( costToEnd.at( start ), graph.edge( treeToEnd.at( start ) ).cost( 0 ).toDouble() + costToEnd.at( next ) );
+    }
+  }
+}
+
+
+
+void TestQgsNetworkAnalysis::testCostMatrix()
+{
+  QgsGraph graph;
+  buildGridGraph( graph, 12 );
+
+  const QVector< int > starts = QVector< int >() << 0 << 17 << 65 << 143 << 100 << 3 << 77;
+  const QVector< int > ends = QVector< int >() << 143 << 0 << 50 << 17 << 99;
+  const QVector< QVector< double > > matrix = QgsGraphAnalyzer::costMatrix( &graph, starts, ends, 0 );
+  QCOMPARE( matrix.size(), starts.size() );
+  for ( int i = 0; i < starts.size(); ++i )
+  {
+    QVector<double> resultCost;
+    QgsGraphAnalyzer::dijkstra( &graph, starts.at( i ), 0, nullptr, &resultCost );
+    QCOMPARE( matrix.at( i ).size(), ends.size() );
+    for ( int j = 0; j < ends.size(); ++j )
+      QCOMPARE( matrix.at( i ).at( j ), resultCost.at( ends.at( j ) ) );
+  }
+
+  // the batch searches give the same trees as the single searches
+  QVector< QVector< int > > trees( starts.size() );
+  QgsGraphAnalyzer::dijkstra( &graph, starts, 0, [&trees]( int i, const QVector<int> &tree, const QVector<double> & )
+  {
+    trees[ i ] = tree;
+  } );
+  for ( int i = 0; i < starts.size(); ++i )
+  {
+    QVector<int> resultTree;
+    QgsGraphAnalyzer::dijkstra( &graph, starts.at( i ), 0, &resultTree );
+    QCOMPARE( trees.at( i ), resultTree );
+  }
+
+  QVERIFY( QgsGraphAnalyzer::costMatrix( &graph, QVector< int >(), ends, 0 ).isEmpty() );
+}
+
+
+void TestQgsNetworkAnalysis::testManyTiePoints()
+{
+  std::unique_ptr<QgsVectorLayer> network = buildNetwork();
+  // has already a linestring LineString(0 0, 10 0, 10 10)
+
+  QgsFeatureList flist;
+  QgsFeature ff( 0 );
+  for ( int i = 0; i < 20; ++i )
+  {
+    ff.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "LineString(%1 %2, %3 %4, %5 %6)" ).arg( i ).arg( 20 + ( i * 7 ) % 13 ).arg( i + 5 ).arg( 12 + ( i * 3 ) % 11 ).arg( 30 - i ).arg( ( i * 5 ) % 17 ) ) );
+    ff.setAttributes( QgsAttributes() << 1 );
+    flist << ff;
+  }
+  network->dataProvider()->addFeatures( flist );
+
+  QVector< QgsPointXY > points;
+  for ( int i = 0; i < 300; ++i )
+    points << QgsPointXY( ( i * 37 ) % 41 - 5.5, ( i * 53 ) % 47 - 7.25 );
+
+  std::unique_ptr< QgsVectorLayerDirector > director = qgis::make_unique< QgsVectorLayerDirector > ( network.get(),
+      -1, QString(), QString(), QString(), QgsVectorLayerDirector::DirectionBoth );
+  std::unique_ptr< QgsNetworkDistanceStrategy > strategy = qgis::make_unique< QgsNetworkDistanceStrategy >();
+  director->addStrategy( strategy.release() );
+  std::unique_ptr< QgsGraphBuilder > builder = qgis::make_unique< QgsGraphBuilder > ( network->sourceCrs(), false, 0 );
+
+  QVector<QgsPointXY > snapped;
+  director->makeGraph( builder.get(), points, snapped );
+  std::unique_ptr< QgsGraph > graph( builder->graph() );
+  QCOMPARE( snapped.size(), points.size() );
+
+  // each point is snapped to its closest location on the network, which is a vertex of the graph
+  QgsFeatureIterator it = network->getFeatures();
+  QgsFeature f;
+  QVector< QgsPolylineXY > lines;
+  while ( it.nextFeature( f ) )
+    lines << f.geometry().asPolyline();
+  for ( int i = 0; i < points.size(); ++i )
+  {
+    double closest = std::numeric_limits< double >::max();
+    for ( const QgsPolylineXY &line : qgis::as_const( lines ) )
+    {
+      for ( int j = 1; j < line.size(); ++j )
+      {
+        QgsPointXY closestPoint;
+        closest = std::min( closest, points.at( i ).sqrDistToSegment( line.at( j - 1 ).x(), line.at( j - 1 ).y(), line.at( j ).x(), line.at( j ).y(), closestPoint, 0 ) );
+      }
+    }
+    QGSCOMPARENEAR( points.at( i ).sqrDist( snapped.at( i ) ), closest, 1e-9 );
+    QVERIFY( graph->findVertex( snapped.at( i ) ) != -1 );
+  }
+}
+
+
 QGSTEST_MAIN( TestQgsNetworkAnalysis )
 #include "testqgsnetworkanalysis.moc"
@@ -28,6 +28,9 @@
 #endif
 
 #include <QDir>
+#include <QTemporaryDir>
+
+#include <gdal.h>
 
 // If true regenerate raster reference images
 const bool REGENERATE_REFERENCES = false;
@@ -47,6 +50,7 @@ class TestNineCellFilters : public QObject
     void testAspect();
     void testRuggedness();
     void testTotalCurvature();
+    void testTiles();
 #ifdef HAVE_OPENCL
     void testHillshadeCl();
     void testSlopeCl();
@@ -215,6 +219,61 @@ void TestNineCellFilters::testTotalCurvature()
   _testAlg<QgsTotalCurvatureFilter>( QStringLiteral( "totalcurvature" ) );
 }
 
+void TestNineCellFilters::testTiles()
+{
+#ifdef HAVE_OPENCL
+  QgsOpenClUtils::setEnabled( false );
+#endif
+
+  // a DEM large enough to be processed by several tiles of rows
+  QTemporaryDir dir;
+  const QString inputFile = dir.filePath( QStringLiteral( "dem.tif" ) );
+  const QString outputFile = dir.filePath( QStringLiteral( "slope.tif" ) );
+  const int xSize = 1100;
+  const int ySize = 2000;
+  {
+    gdal::dataset_unique_ptr dataset( GDALCreate( GDALGetDriverByName( "GTiff" ), inputFile.toUtf8().constData(), xSize, ySize, 1, GDT_Float32, nullptr ) );
+    QVERIFY( dataset );
+    double geotransform[] = { 0, 10, 0, ySize * 10.0, 0, -10 };
+    GDALSetGeoTransform( dataset.get(), geotransform );
+    GDALRasterBandH band = GDALGetRasterBand( dataset.get(), 1 );
+    GDALSetRasterNoDataValue( band, -9999 );
+    std::vector<float> values( static_cast< size_t >( xSize ) * ySize );
+    for ( size_t i = 0; i < values.size(); ++i )
+      values[ i ] = ( i % 97 == 0 ) ? -9999 : static_cast< float >( ( i % xSize ) * ( i % 13 ) + ( i / xSize ) * 0.5 );
+    QCOMPARE( GDALRasterIO( band, GF_Write, 0, 0, xSize, ySize, values.data(), xSize, ySize, GDT_Float32, 0, 0 ), CE_None );
+  }
+
+  QgsSlopeFilter filter( inputFile, outputFile, QStringLiteral( "GTiff" ) );
+  QCOMPARE( filter.processRaster(), 0 );
+
+  gdal::dataset_unique_ptr input( GDALOpen( inputFile.toUtf8().constData(), GA_ReadOnly ) );
+  gdal::dataset_unique_ptr output( GDALOpen( outputFile.toUtf8().constData(), GA_ReadOnly ) );
+  QVERIFY( input );
+  QVERIFY( output );
+  std::vector<float> in( static_cast< size_t >( xSize ) * ySize );
+  std::vector<float> out( in.size() );
+  QCOMPARE( GDALRasterIO( GDALGetRasterBand( input.get(), 1 ), GF_Read, 0, 0, xSize, ySize, in.data(), xSize, ySize, GDT_Float32, 0, 0 ), CE_None );
+  QCOMPARE( GDALRasterIO( GDALGetRasterBand( output.get(), 1 ), GF_Read, 0, 0, xSize, ySize, out.data(), xSize, ySize, GDT_Float32, 0, 0 ), CE_None );
+
+  // the first and last rows, and the rows around the tile boundaries, match a scan of the whole raster
+  float nodata = filter.inputNodataValue();
+  auto value = [&]( int x, int y ) -> float *
+  {
+    return x < 0 || x >= xSize || y < 0 || y >= ySize ? &nodata : &in[ static_cast< size_t >( y ) * xSize + x ];
+  };
+  const int tileRows = ( 1 << 20 ) / xSize;
+  for ( int y : { 0, 1, tileRows - 1, tileRows, tileRows + 1, 2 * tileRows - 1, 2 * tileRows, ySize - 2, ySize - 1 } )
+  {
+    for ( int x = 0; x < xSize; ++x )
+    {
+      const float expected = filter.processNineCellWindow( value( x - 1, y - 1 ), value( x, y - 1 ), value( x + 1, y - 1 ),
+                             value( x - 1, y ), value( x, y ), value( x + 1, y ),
+                             value( x - 1, y + 1 ), value( x, y + 1 ), value( x + 1, y + 1 ) );
+      QCOMPARE( out[ static_cast< size_t >( y ) * xSize + x ], expected );
+    }
+  }
+}
 
 QGSTEST_MAIN( TestNineCellFilters )
 
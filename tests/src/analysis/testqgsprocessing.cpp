@@ -23,11 +23,15 @@
 #include "qgsprocessingparametertype.h"
 #include "qgsprocessingmodelalgorithm.h"
 #include "qgsprocessingmodelgroupbox.h"
+#include "qgsprocessingfeaturepipe.h"
+#include "qgsprocessingmemoryoutputsink.h"
 #include "qgsnativealgorithms.h"
 #include <QObject>
 #include <QtTest/QSignalSpy>
 #include <QList>
 #include <QFileInfo>
+#include <QThreadPool>
+#include <QtConcurrentRun>
 #include "qgis.h"
 #include "qgstest.h"
 #include "qgsrasterlayer.h"
@@ -612,6 +616,10 @@ class TestQgsProcessing: public QObject
     void modelerAlgorithm();
     void modelExecution();
     void modelBranchPruning();
+    void modelParallelBranches();
+    void featurePipe();
+    void memoryOutputBudget();
+    void modelStreamedOutputs();
     void modelBranchPruningConditional();
     void modelWithProviderWithLimitedTypes();
     void modelVectorOutputIsCompatibleType();
@@ -9859,6 +9867,273 @@ void TestQgsProcessing::modelBranchPruning()
   QVERIFY( !results.contains( QStringLiteral( "buffer3:BUFFER3_OUTPUT" ) ) );
 }
 
+void TestQgsProcessing::modelParallelBranches()
+{
+  QgsVectorLayer *layer = new QgsVectorLayer( "Polygon?crs=epsg:3111", "polygons", "memory" );
+  QgsFeatureList features;
+  for ( int i = 0; i < 100; ++i )
+  {
+    QgsFeature f;
+    f.setGeometry( QgsGeometry::fromRect( QgsRectangle( i * 10, 0, i * 10 + 5, 5 ) ) );
+    features << f;
+  }
+  QVERIFY( layer->dataProvider()->addFeatures( features ) );
+  QgsProject p;
+  p.addMapLayer( layer );
+
+  QgsProcessingContext context;
+  context.setProject( &p );
+
+  // two independent branches, whose second children read the memory outputs of the first ones
+  QgsProcessingModelAlgorithm model;
+  QgsProcessingModelParameter param;
+  param.setParameterName( QStringLiteral( "LAYER" ) );
+  model.addModelParameter( new QgsProcessingParameterFeatureSource( QStringLiteral( "LAYER" ) ), param );
+
+  auto addChild = [&model]( const QString & id, const QString & algorithm, const QgsProcessingModelChildParameterSource & input )
+  {
+    QgsProcessingModelChildAlgorithm child;
+    child.setChildId( id );
+    child.setAlgorithmId( algorithm );
+    child.addParameterSources( QStringLiteral( "INPUT" ), QList< QgsProcessingModelChildParameterSource >() << input );
+    if ( algorithm == QLatin1String( "native:buffer" ) )
+      child.addParameterSources( QStringLiteral( "DISTANCE" ), QList< QgsProcessingModelChildParameterSource >() << QgsProcessingModelChildParameterSource::fromStaticValue( 1 ) );
+    QMap<QString, QgsProcessingModelOutput> outputs;
+    QgsProcessingModelOutput output( id + QStringLiteral( "_OUTPUT" ) );
+    output.setChildOutputName( "OUTPUT" );
+    outputs.insert( id + QStringLiteral( "_OUTPUT" ), output );
+    child.setModelOutputs( outputs );
+    model.addChildAlgorithm( child );
+  };
+  addChild( QStringLiteral( "centroids" ), QStringLiteral( "native:centroids" ), QgsProcessingModelChildParameterSource::fromModelParameter( QStringLiteral( "LAYER" ) ) );
+  addChild( QStringLiteral( "buffer" ), QStringLiteral( "native:buffer" ), QgsProcessingModelChildParameterSource::fromModelParameter( QStringLiteral( "LAYER" ) ) );
+  addChild( QStringLiteral( "centroids_buffer" ), QStringLiteral( "native:buffer" ), QgsProcessingModelChildParameterSource::fromChildOutput( QStringLiteral( "centroids" ), QStringLiteral( "OUTPUT" ) ) );
+  addChild( QStringLiteral( "buffer_centroids" ), QStringLiteral( "native:centroids" ), QgsProcessingModelChildParameterSource::fromChildOutput( QStringLiteral( "buffer" ), QStringLiteral( "OUTPUT" ) ) );
+
+  QVariantMap params;
+  params.insert( QStringLiteral( "LAYER" ), QStringLiteral( "polygons" ) );
+  params.insert( QStringLiteral( "centroids:centroids_OUTPUT" ), QStringLiteral( "memory:" ) );
+  params.insert( QStringLiteral( "buffer:buffer_OUTPUT" ), QStringLiteral( "memory:" ) );
+  params.insert( QStringLiteral( "centroids_buffer:centroids_buffer_OUTPUT" ), QStringLiteral( "memory:" ) );
+  params.insert( QStringLiteral( "buffer_centroids:buffer_centroids_OUTPUT" ), QStringLiteral( "memory:" ) );
+
+  const int maxThreadCount = QThreadPool::globalInstance()->maxThreadCount();
+  QThreadPool::globalInstance()->setMaxThreadCount( 4 );
+  QgsProcessingFeedback feedback;
+  bool ok = false;
+  QVariantMap results = model.run( params, context, &feedback, &ok );
+  QThreadPool::globalInstance()->setMaxThreadCount( maxThreadCount );
+  QVERIFY( ok );
+  QCOMPARE( results.value( QStringLiteral( "CHILD_RESULTS" ) ).toMap().count(), 4 );
+
+  // the memory outputs of all the children end up in the context
+  for ( const QString &output : { QStringLiteral( "centroids:centroids_OUTPUT" ), QStringLiteral( "buffer:buffer_OUTPUT" ), QStringLiteral( "centroids_buffer:centroids_buffer_OUTPUT" ), QStringLiteral( "buffer_centroids:buffer_centroids_OUTPUT" ) } )
+  {
+    QgsVectorLayer *outputLayer = qobject_cast< QgsVectorLayer * >( context.getMapLayer( results.value( output ).toString() ) );
+    QVERIFY( outputLayer );
+    QCOMPARE( outputLayer->featureCount(), 100L );
+  }
+  QgsVectorLayer *centroidsBuffer = qobject_cast< QgsVectorLayer * >( context.getMapLayer( results.value( QStringLiteral( "centroids_buffer:centroids_buffer_OUTPUT" ) ).toString() ) );
+  QCOMPARE( centroidsBuffer->geometryType(), QgsWkbTypes::PolygonGeometry );
+  QgsVectorLayer *bufferCentroids = qobject_cast< QgsVectorLayer * >( context.getMapLayer( results.value( QStringLiteral( "buffer_centroids:buffer_centroids_OUTPUT" ) ).toString() ) );
+  QCOMPARE( bufferCentroids->geometryType(), QgsWkbTypes::PointGeometry );
+}
+
+void TestQgsProcessing::memoryOutputBudget()
+{
+  QgsProcessingContext context;
+  QCOMPARE( context.memoryOutputBudget(), 0LL );
+
+  QgsFields fields;
+  fields.append( QgsField( QStringLiteral( "id" ), QVariant::Int ) );
+  fields.append( QgsField( QStringLiteral( "name" ), QVariant::String ) );
+  QgsFeature feature( fields );
+  feature.setAttributes( QgsAttributes() << 1 << QStringLiteral( "abc" ) );
+  feature.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( 1, 2 ) ) );
+  const qint64 featureSize = QgsProcessingMemoryOutputSink::featureSize( feature );
+  QVERIFY( featureSize > 0 );
+
+  for ( const qint64 budget : { 0LL, 100 * featureSize } )
+  {
+    context.setMemoryOutputBudget( budget );
+    QString destination = QStringLiteral( "memory:points" );
+    std::unique_ptr< QgsFeatureSink > sink( QgsProcessingUtils::createFeatureSink( destination, context, fields, QgsWkbTypes::Point, QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:3857" ) ) ) );
+    QVERIFY( sink );
+    for ( int i = 0; i < 1000; ++i )
+    {
+      QgsFeature f( fields );
+      f.setAttributes( QgsAttributes() << i << QStringLiteral( "abc" ) );
+      f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( i, i * 2 ) ) );
+      QVERIFY( sink->addFeature( f ) );
+    }
+    sink.reset();
+
+    // beyond the budget the layer keeps its id, reading a temporary GeoPackage
+    QgsVectorLayer *layer = qobject_cast< QgsVectorLayer * >( QgsProcessingUtils::mapLayerFromString( destination, context ) );
+    QVERIFY( layer );
+    QVERIFY( layer->isValid() );
+    QCOMPARE( layer->id(), destination );
+    QCOMPARE( layer->providerType(), budget > 0 ? QStringLiteral( "ogr" ) : QStringLiteral( "memory" ) );
+    QCOMPARE( layer->name(), QStringLiteral( "points" ) );
+    QCOMPARE( layer->featureCount(), 1000L );
+    if ( budget > 0 )
+      QCOMPARE( layer->hasSpatialIndex(), QgsFeatureSource::SpatialIndexPresent );
+
+    QgsFeatureIterator it = layer->getFeatures();
+    QgsFeature f;
+    int i = 0;
+    while ( it.nextFeature( f ) )
+    {
+      QCOMPARE( f.attribute( QStringLiteral( "id" ) ).toInt(), i );
+      QCOMPARE( f.geometry().asPoint(), QgsPointXY( i, i * 2 ) );
+      i++;
+    }
+    QCOMPARE( i, 1000 );
+  }
+}
+
+void TestQgsProcessing::featurePipe()
+{
+  std::shared_ptr< QgsProcessingFeaturePipe > pipe = QgsProcessingFeaturePipe::create( 10 );
+  QVERIFY( QgsProcessingFeaturePipe::pipe( pipe->id() ) == pipe );
+  QCOMPARE( pipe->featureCount(), static_cast< long >( QgsVectorDataProvider::UnknownCount ) );
+
+  // the producer blocks while 10 features are waiting, until the consumer reads them
+  QgsFields fields;
+  fields.append( QgsField( QStringLiteral( "id" ), QVariant::Int ) );
+  QFuture< void > producer = QtConcurrent::run( [pipe, fields]
+  {
+    QString destination = pipe->destination();
+    QgsProcessingContext context;
+    std::unique_ptr< QgsFeatureSink > sink( QgsProcessingUtils::createFeatureSink( destination, context, fields, QgsWkbTypes::Point, QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:3111" ) ) ) );
+    for ( int i = 0; i < 1000; ++i )
+    {
+      QgsFeature f( fields );
+      f.setAttributes( QgsAttributes() << i );
+      f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( i, 2 * i + 1 ) ) );
+      sink->addFeature( f );
+    }
+  } );
+
+  QgsVectorLayer layer( pipe->id(), QStringLiteral( "pipe" ), QgsProcessingFeaturePipeProvider::providerKey() );
+  QVERIFY( layer.isValid() );
+  QCOMPARE( layer.wkbType(), QgsWkbTypes::Point );
+  QCOMPARE( layer.fields().count(), 1 );
+  QCOMPARE( layer.crs().authid(), QStringLiteral( "EPSG:3111" ) );
+
+  QgsFeatureIterator it = layer.getFeatures();
+  QgsFeature f;
+  int count = 0;
+  while ( it.nextFeature( f ) )
+  {
+    QCOMPARE( f.attribute( QStringLiteral( "id" ) ).toInt(), count );
+    QCOMPARE( f.geometry().asPoint(), QgsPointXY( count, 2 * count + 1 ) );
+    count++;
+  }
+  producer.waitForFinished();
+  QCOMPARE( count, 1000 );
+  QCOMPARE( layer.featureCount(), 1000L );
+  QCOMPARE( layer.extent(), QgsRectangle( 0, 1, 999, 1999 ) );
+
+  // the features are gone once read
+  QVERIFY( !pipe->wasReadAgain() );
+  QgsFeatureIterator again = layer.getFeatures();
+  QVERIFY( !again.nextFeature( f ) );
+  QVERIFY( pipe->wasReadAgain() );
+
+  // a released pipe discards the features, without blocking its producer
+  std::shared_ptr< QgsProcessingFeaturePipe > released = QgsProcessingFeaturePipe::create( 10 );
+  released->open( fields, QgsWkbTypes::Point, QgsCoordinateReferenceSystem() );
+  released->release();
+  for ( int i = 0; i < 100; ++i )
+  {
+    QgsFeature feature( fields );
+    QVERIFY( released->addFeature( feature ) );
+  }
+  released->close();
+  QVERIFY( !released->nextFeature( f ) );
+  QCOMPARE( released->featureCount(), 100L );
+}
+
+void TestQgsProcessing::modelStreamedOutputs()
+{
+  // more polygons than the capacity of the pipe
+  QgsVectorLayer *layer = new QgsVectorLayer( "Polygon?crs=epsg:3111", "polygons", "memory" );
+  QgsFeatureList features;
+  for ( int i = 0; i < 10000; ++i )
+  {
+    QgsFeature f;
+    f.setGeometry( QgsGeometry::fromRect( QgsRectangle( i * 10, 0, i * 10 + 5, 5 ) ) );
+    features << f;
+  }
+  QVERIFY( layer->dataProvider()->addFeatures( features ) );
+  QgsProject p;
+  p.addMapLayer( layer );
+
+  QgsProcessingContext context;
+  context.setProject( &p );
+
+  // the temporary output of the buffer is only read by the centroids
+  QgsProcessingModelAlgorithm model;
+  QgsProcessingModelParameter param;
+  param.setParameterName( QStringLiteral( "LAYER" ) );
+  model.addModelParameter( new QgsProcessingParameterFeatureSource( QStringLiteral( "LAYER" ) ), param );
+
+  QgsProcessingModelChildAlgorithm buffer;
+  buffer.setChildId( QStringLiteral( "buffer" ) );
+  buffer.setAlgorithmId( QStringLiteral( "native:buffer" ) );
+  buffer.addParameterSources( QStringLiteral( "INPUT" ), QList< QgsProcessingModelChildParameterSource >() << QgsProcessingModelChildParameterSource::fromModelParameter( QStringLiteral( "LAYER" ) ) );
+  buffer.addParameterSources( QStringLiteral( "DISTANCE" ), QList< QgsProcessingModelChildParameterSource >() << QgsProcessingModelChildParameterSource::fromStaticValue( 1 ) );
+  model.addChildAlgorithm( buffer );
+
+  QgsProcessingModelChildAlgorithm centroids;
+  centroids.setChildId( QStringLiteral( "centroids" ) );
+  centroids.setAlgorithmId( QStringLiteral( "native:centroids" ) );
+  centroids.addParameterSources( QStringLiteral( "INPUT" ), QList< QgsProcessingModelChildParameterSource >() << QgsProcessingModelChildParameterSource::fromChildOutput( QStringLiteral( "buffer" ), QStringLiteral( "OUTPUT" ) ) );
+  QMap<QString, QgsProcessingModelOutput> outputs;
+  QgsProcessingModelOutput output( QStringLiteral( "centroids_OUTPUT" ) );
+  output.setChildOutputName( "OUTPUT" );
+  outputs.insert( QStringLiteral( "centroids_OUTPUT" ), output );
+  centroids.setModelOutputs( outputs );
+  model.addChildAlgorithm( centroids );
+
+  QVariantMap params;
+  params.insert( QStringLiteral( "LAYER" ), QStringLiteral( "polygons" ) );
+  params.insert( QStringLiteral( "centroids:centroids_OUTPUT" ), QStringLiteral( "memory:" ) );
+
+  const int maxThreadCount = QThreadPool::globalInstance()->maxThreadCount();
+  QThreadPool::globalInstance()->setMaxThreadCount( 4 );
+  QgsProcessingFeedback feedback;
+  bool ok = false;
+  QVariantMap results = model.run( params, context, &feedback, &ok );
+  QThreadPool::globalInstance()->setMaxThreadCount( maxThreadCount );
+  QVERIFY( ok );
+
+  // the buffer was streamed to the centroids through a pipe
+  const QString bufferOutput = results.value( QStringLiteral( "CHILD_RESULTS" ) ).toMap().value( QStringLiteral( "buffer" ) ).toMap().value( QStringLiteral( "OUTPUT" ) ).toString();
+  QgsVectorLayer *pipeLayer = qobject_cast< QgsVectorLayer * >( context.getMapLayer( bufferOutput ) );
+  QVERIFY( pipeLayer );
+  QCOMPARE( pipeLayer->providerType(), QgsProcessingFeaturePipeProvider::providerKey() );
+  QCOMPARE( pipeLayer->featureCount(), 10000L );
+
+  QgsVectorLayer *centroidsLayer = qobject_cast< QgsVectorLayer * >( context.getMapLayer( results.value( QStringLiteral( "centroids:centroids_OUTPUT" ) ).toString() ) );
+  QVERIFY( centroidsLayer );
+  QCOMPARE( centroidsLayer->featureCount(), 10000L );
+  QCOMPARE( centroidsLayer->geometryType(), QgsWkbTypes::PointGeometry );
+  QgsFeature f;
+  QVERIFY( centroidsLayer->getFeatures( QgsFeatureRequest().setFilterFid( 1 ) ).nextFeature( f ) );
+  QGSCOMPARENEAR( f.geometry().asPoint().y(), 2.5, 0.001 );
+
+  // without threads, the output is written to a memory layer as before
+  QThreadPool::globalInstance()->setMaxThreadCount( 1 );
+  results = model.run( params, context, &feedback, &ok );
+  QThreadPool::globalInstance()->setMaxThreadCount( maxThreadCount );
+  QVERIFY( ok );
+  QgsVectorLayer *memoryLayer = qobject_cast< QgsVectorLayer * >( context.getMapLayer( results.value( QStringLiteral( "CHILD_RESULTS" ) ).toMap().value( QStringLiteral( "buffer" ) ).toMap().value( QStringLiteral( "OUTPUT" ) ).toString() ) );
+  QVERIFY( memoryLayer );
+  QCOMPARE( memoryLayer->providerType(), QStringLiteral( "memory" ) );
+}
+
 void TestQgsProcessing::modelBranchPruningConditional()
 {
   QgsProcessingContext context;
@@ -56,6 +56,8 @@
 #include "qgsrenderchecker.h"
 #include "qgsrelationmanager.h"
 
+#include <QThreadPool>
+
 class TestQgsProcessingAlgs: public QObject
 {
     Q_OBJECT
@@ -81,6 +83,11 @@ class TestQgsProcessingAlgs: public QObject
     void parseGeoTags();
     void featureFilterAlg();
     void transformAlg();
+    void parallelFeatureProcessing();
+    void cascadedDissolve();
+    void parallelOverlay();
+    void bulkJoinByLocation();
+    void countPointsInPolygon();
     void kmeansCluster();
     void categorizeByStyle();
     void extractBinary();
@@ -648,6 +655,385 @@ void TestQgsProcessingAlgs::transformAlg()
   QVERIFY( ok );
 }
 
+void TestQgsProcessingAlgs::parallelFeatureProcessing()
+{
+  std::unique_ptr< QgsProcessingAlgorithm > alg( QgsApplication::processingRegistry()->createAlgorithmById( QStringLiteral( "native:boundary" ) ) );
+  QVERIFY( alg != nullptr );
+  QVERIFY( alg->flags() & QgsProcessingAlgorithm::FlagSupportsParallelFeatureProcessing );
+
+  std::unique_ptr< QgsProcessingContext > context = qgis::make_unique< QgsProcessingContext >();
+  QgsProject p;
+  context->setProject( &p );
+  QgsProcessingFeedback feedback;
+
+  // more features than a batch, with a closed line whose error is reported from the calling thread
+  QgsVectorLayer *layer = new QgsVectorLayer( QStringLiteral( "LineString?crs=EPSG:3857&field=id:integer" ), QStringLiteral( "lines" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer->isValid() );
+  QgsFeatureList features;
+  for ( int i = 0; i < 5000; ++i )
+  {
+    QgsFeature f( layer->fields() );
+    f.setAttributes( QgsAttributes() << i );
+    if ( i == 1234 )
+      f.setGeometry( QgsGeometry::fromPolylineXY( QgsPolylineXY() << QgsPointXY( i, 0 ) << QgsPointXY( i + 2, 0 ) << QgsPointXY( i, 1 ) << QgsPointXY( i, 0 ) ) );
+    else
+      f.setGeometry( QgsGeometry::fromPolylineXY( QgsPolylineXY() << QgsPointXY( i, 0 ) << QgsPointXY( i + 2, 0 ) << QgsPointXY( i, i % 10 + 1 ) ) );
+    features << f;
+  }
+  QVERIFY( layer->dataProvider()->addFeatures( features ) );
+  p.addMapLayer( layer );
+
+  const int maxThreadCount = QThreadPool::globalInstance()->maxThreadCount();
+  QThreadPool::globalInstance()->setMaxThreadCount( 4 );
+  QVariantMap parameters;
+  parameters.insert( QStringLiteral( "INPUT" ), QStringLiteral( "lines" ) );
+  parameters.insert( QStringLiteral( "OUTPUT" ), QStringLiteral( "memory:" ) );
+  bool ok = false;
+  QVariantMap results = alg->run( parameters, *context, &feedback, &ok );
+  QThreadPool::globalInstance()->setMaxThreadCount( maxThreadCount );
+  QVERIFY( ok );
+  QVERIFY( feedback.textLog().contains( QStringLiteral( "No boundary for feature" ) ) );
+
+  // the output features are in the order of the input features
+  QgsVectorLayer *output = qobject_cast< QgsVectorLayer * >( context->getMapLayer( results.value( QStringLiteral( "OUTPUT" ) ).toString() ) );
+  QVERIFY( output );
+  QCOMPARE( output->featureCount(), 5000L );
+  QgsFeatureIterator it = output->getFeatures();
+  QgsFeature f;
+  int i = 0;
+  while ( it.nextFeature( f ) )
+  {
+    QCOMPARE( f.attribute( 0 ).toInt(), i );
+    if ( i == 1234 )
+      QVERIFY( !f.hasGeometry() );
+    else
+      QCOMPARE( f.geometry().asWkt(), QStringLiteral( "MultiPoint ((%1 0),(%1 %2))" ).arg( i ).arg( i % 10 + 1 ) );
+    i++;
+  }
+  QCOMPARE( i, 5000 );
+}
+
+void TestQgsProcessingAlgs::cascadedDissolve()
+{
+  std::unique_ptr< QgsProcessingAlgorithm > alg( QgsApplication::processingRegistry()->createAlgorithmById( QStringLiteral( "native:dissolve" ) ) );
+  QVERIFY( alg != nullptr );
+
+  std::unique_ptr< QgsProcessingContext > context = qgis::make_unique< QgsProcessingContext >();
+  QgsProject p;
+  context->setProject( &p );
+  QgsProcessingFeedback feedback;
+
+  // a grid of adjacent squares in two groups longer than the dissolve queue, in a scattered order
+  QgsVectorLayer *layer = new QgsVectorLayer( QStringLiteral( "Polygon?crs=EPSG:3857&field=half:integer" ), QStringLiteral( "squares" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer->isValid() );
+  QgsFeatureList features;
+  for ( int i = 0; i < 24000; ++i )
+  {
+    const int cell = static_cast< int >( ( static_cast< qint64 >( i ) * 7919 ) % 24000 );
+    const int column = cell % 200;
+    const int row = cell / 200;
+    QgsFeature f( layer->fields() );
+    f.setAttributes( QgsAttributes() << ( column < 100 ? 0 : 1 ) );
+    f.setGeometry( QgsGeometry::fromRect( QgsRectangle( column, row, column + 1, row + 1 ) ) );
+    features << f;
+  }
+  QVERIFY( layer->dataProvider()->addFeatures( features ) );
+  p.addMapLayer( layer );
+
+  const int maxThreadCount = QThreadPool::globalInstance()->maxThreadCount();
+  QVariantMap parameters;
+  parameters.insert( QStringLiteral( "INPUT" ), QStringLiteral( "squares" ) );
+  parameters.insert( QStringLiteral( "OUTPUT" ), QStringLiteral( "memory:" ) );
+  bool ok = false;
+
+  // all the features, merging the batches of a single thread, then of several threads
+  for ( int threadCount : { 1, 4 } )
+  {
+    QThreadPool::globalInstance()->setMaxThreadCount( threadCount );
+    QVariantMap results = alg->run( parameters, *context, &feedback, &ok );
+    QThreadPool::globalInstance()->setMaxThreadCount( maxThreadCount );
+    QVERIFY( ok );
+
+    QgsVectorLayer *output = qobject_cast< QgsVectorLayer * >( context->getMapLayer( results.value( QStringLiteral( "OUTPUT" ) ).toString() ) );
+    QVERIFY( output );
+    QCOMPARE( output->featureCount(), 1L );
+    QgsFeature f;
+    QVERIFY( output->getFeatures().nextFeature( f ) );
+    QCOMPARE( f.geometry().constGet()->partCount(), 1 );
+    QGSCOMPARENEAR( f.geometry().area(), 24000, 0.0001 );
+    QCOMPARE( f.geometry().boundingBox(), QgsRectangle( 0, 0, 200, 120 ) );
+  }
+
+  // by groups, collected in parallel
+  parameters.insert( QStringLiteral( "FIELD" ), QStringList() << QStringLiteral( "half" ) );
+  QThreadPool::globalInstance()->setMaxThreadCount( 4 );
+  QVariantMap results = alg->run( parameters, *context, &feedback, &ok );
+  QThreadPool::globalInstance()->setMaxThreadCount( maxThreadCount );
+  QVERIFY( ok );
+
+  QgsVectorLayer *output = qobject_cast< QgsVectorLayer * >( context->getMapLayer( results.value( QStringLiteral( "OUTPUT" ) ).toString() ) );
+  QVERIFY( output );
+  QCOMPARE( output->featureCount(), 2L );
+  QgsFeatureIterator it = output->getFeatures();
+  QgsFeature f;
+  while ( it.nextFeature( f ) )
+  {
+    const int half = f.attribute( 0 ).toInt();
+    QCOMPARE( f.geometry().wkbType(), QgsWkbTypes::MultiPolygon );
+    QCOMPARE( f.geometry().constGet()->partCount(), 1 );
+    QGSCOMPARENEAR( f.geometry().area(), 12000, 0.0001 );
+    QCOMPARE( f.geometry().boundingBox(), QgsRectangle( half * 100, 0, half * 100 + 100, 120 ) );
+  }
+}
+
+void TestQgsProcessingAlgs::parallelOverlay()
+{
+  std::unique_ptr< QgsProcessingContext > context = qgis::make_unique< QgsProcessingContext >();
+  QgsProject p;
+  context->setProject( &p );
+  QgsProcessingFeedback feedback;
+
+  // more squares than a batch, overlaid with a rectangle across cells
+  QgsVectorLayer *squares = new QgsVectorLayer( QStringLiteral( "Polygon?crs=EPSG:3857&field=id:integer" ), QStringLiteral( "squares" ), QStringLiteral( "memory" ) );
+  QVERIFY( squares->isValid() );
+  QgsFeatureList features;
+  for ( int i = 0; i < 1600; ++i )
+  {
+    QgsFeature f( squares->fields() );
+    f.setAttributes( QgsAttributes() << i );
+    f.setGeometry( QgsGeometry::fromRect( QgsRectangle( i % 40, i / 40, i % 40 + 1, i / 40 + 1 ) ) );
+    features << f;
+  }
+  QVERIFY( squares->dataProvider()->addFeatures( features ) );
+  p.addMapLayer( squares );
+
+  QgsVectorLayer *overlay = new QgsVectorLayer( QStringLiteral( "Polygon?crs=EPSG:3857&field=name:string" ), QStringLiteral( "overlay" ), QStringLiteral( "memory" ) );
+  QVERIFY( overlay->isValid() );
+  QgsFeature rectangle( overlay->fields() );
+  rectangle.setAttributes( QgsAttributes() << QStringLiteral( "r" ) );
+  rectangle.setGeometry( QgsGeometry::fromRect( QgsRectangle( 10.5, 10.5, 30.5, 30.5 ) ) );
+  QVERIFY( overlay->dataProvider()->addFeature( rectangle ) );
+  p.addMapLayer( overlay );
+
+  const int maxThreadCount = QThreadPool::globalInstance()->maxThreadCount();
+  QThreadPool::globalInstance()->setMaxThreadCount( 4 );
+  QVariantMap parameters;
+  parameters.insert( QStringLiteral( "INPUT" ), QStringLiteral( "squares" ) );
+  parameters.insert( QStringLiteral( "OVERLAY" ), QStringLiteral( "overlay" ) );
+  parameters.insert( QStringLiteral( "OUTPUT" ), QStringLiteral( "memory:" ) );
+
+  std::unique_ptr< QgsProcessingAlgorithm > intersection( QgsApplication::processingRegistry()->createAlgorithmById( QStringLiteral( "native:intersection" ) ) );
+  QVERIFY( intersection != nullptr );
+  bool ok = false;
+  QVariantMap results = intersection->run( parameters, *context, &feedback, &ok );
+  std::unique_ptr< QgsProcessingAlgorithm > difference( QgsApplication::processingRegistry()->createAlgorithmById( QStringLiteral( "native:difference" ) ) );
+  QVERIFY( difference != nullptr );
+  bool differenceOk = false;
+  QVariantMap differenceResults = difference->run( parameters, *context, &feedback, &differenceOk );
+  QThreadPool::globalInstance()->setMaxThreadCount( maxThreadCount );
+  QVERIFY( ok );
+  QVERIFY( differenceOk );
+
+  // the output features are in the order of the input features
+  QgsVectorLayer *output = qobject_cast< QgsVectorLayer * >( context->getMapLayer( results.value( QStringLiteral( "OUTPUT" ) ).toString() ) );
+  QVERIFY( output );
+  QCOMPARE( output->featureCount(), 441L );
+  QgsFeatureIterator it = output->getFeatures();
+  QgsFeature f;
+  int previousId = -1;
+  double area = 0;
+  while ( it.nextFeature( f ) )
+  {
+    QVERIFY( f.attribute( 0 ).toInt() > previousId );
+    previousId = f.attribute( 0 ).toInt();
+    QCOMPARE( f.attribute( 1 ).toString(), QStringLiteral( "r" ) );
+    area += f.geometry().area();
+  }
+  QGSCOMPARENEAR( area, 400, 0.0001 );
+
+  output = qobject_cast< QgsVectorLayer * >( context->getMapLayer( differenceResults.value( QStringLiteral( "OUTPUT" ) ).toString() ) );
+  QVERIFY( output );
+  QCOMPARE( output->featureCount(), 1239L );
+  it = output->getFeatures();
+  previousId = -1;
+  area = 0;
+  while ( it.nextFeature( f ) )
+  {
+    QVERIFY( f.attribute( 0 ).toInt() > previousId );
+    previousId = f.attribute( 0 ).toInt();
+    area += f.geometry().area();
+  }
+  QGSCOMPARENEAR( area, 1200, 0.0001 );
+}
+
+void TestQgsProcessingAlgs::bulkJoinByLocation()
+{
+  std::unique_ptr< QgsProcessingAlgorithm > alg( QgsApplication::processingRegistry()->createAlgorithmById( QStringLiteral( "native:joinattributesbylocation" ) ) );
+  QVERIFY( alg != nullptr );
+
+  std::unique_ptr< QgsProcessingContext > context = qgis::make_unique< QgsProcessingContext >();
+  QgsProject p;
+  context->setProject( &p );
+  QgsProcessingFeedback feedback;
+
+  // more points than a batch, joined to two overlapping squares
+  QgsVectorLayer *points = new QgsVectorLayer( QStringLiteral( "Point?crs=EPSG:3857&field=id:integer" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  QVERIFY( points->isValid() );
+  QgsFeatureList features;
+  for ( int i = 0; i < 5000; ++i )
+  {
+    QgsFeature f( points->fields() );
+    f.setAttributes( QgsAttributes() << i );
+    f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( i % 20 + 0.5, 5 ) ) );
+    features << f;
+  }
+  QVERIFY( points->dataProvider()->addFeatures( features ) );
+  p.addMapLayer( points );
+
+  QgsVectorLayer *squares = new QgsVectorLayer( QStringLiteral( "Polygon?crs=EPSG:3857&field=name:string" ), QStringLiteral( "squares" ), QStringLiteral( "memory" ) );
+  QVERIFY( squares->isValid() );
+  features.clear();
+  QgsFeature square( squares->fields() );
+  square.setAttributes( QgsAttributes() << QStringLiteral( "a" ) );
+  square.setGeometry( QgsGeometry::fromRect( QgsRectangle( 0, 0, 10, 10 ) ) );
+  features << square;
+  square.setAttributes( QgsAttributes() << QStringLiteral( "b" ) );
+  square.setGeometry( QgsGeometry::fromRect( QgsRectangle( 5, 0, 15, 10 ) ) );
+  features << square;
+  QVERIFY( squares->dataProvider()->addFeatures( features ) );
+  p.addMapLayer( squares );
+
+  const int maxThreadCount = QThreadPool::globalInstance()->maxThreadCount();
+  QVariantMap parameters;
+  parameters.insert( QStringLiteral( "INPUT" ), QStringLiteral( "points" ) );
+  parameters.insert( QStringLiteral( "JOIN" ), QStringLiteral( "squares" ) );
+  parameters.insert( QStringLiteral( "PREDICATE" ), QVariantList() << 0 );
+  parameters.insert( QStringLiteral( "OUTPUT" ), QStringLiteral( "memory:" ) );
+  parameters.insert( QStringLiteral( "NON_MATCHING" ), QStringLiteral( "memory:" ) );
+
+  // one-to-many, then first matching feature only
+  for ( int method : { 0, 1 } )
+  {
+    parameters.insert( QStringLiteral( "METHOD" ), method );
+    QThreadPool::globalInstance()->setMaxThreadCount( 4 );
+    bool ok = false;
+    QVariantMap results = alg->run( parameters, *context, &feedback, &ok );
+    QThreadPool::globalInstance()->setMaxThreadCount( maxThreadCount );
+    QVERIFY( ok );
+    QCOMPARE( results.value( QStringLiteral( "JOINED_COUNT" ) ).toLongLong(), method == 0 ? 5000LL : 3750LL );
+
+    QgsVectorLayer *nonMatching = qobject_cast< QgsVectorLayer * >( context->getMapLayer( results.value( QStringLiteral( "NON_MATCHING" ) ).toString() ) );
+    QVERIFY( nonMatching );
+    QCOMPARE( nonMatching->featureCount(), 1250L );
+
+    // the output features are in the order of the input features
+    QgsVectorLayer *output = qobject_cast< QgsVectorLayer * >( context->getMapLayer( results.value( QStringLiteral( "OUTPUT" ) ).toString() ) );
+    QVERIFY( output );
+    QCOMPARE( output->featureCount(), method == 0 ? 6250L : 5000L );
+    QgsFeatureIterator it = output->getFeatures();
+    QgsFeature f;
+    int previousId = -1;
+    while ( it.nextFeature( f ) )
+    {
+      const int id = f.attribute( 0 ).toInt();
+      QVERIFY( id >= previousId );
+      previousId = id;
+      const double x = id % 20 + 0.5;
+      if ( x > 15 )
+        QVERIFY( f.attribute( 1 ).isNull() );
+      else if ( x < 5 || method == 1 )
+        QCOMPARE( f.attribute( 1 ).toString(), x < 10 ? QStringLiteral( "a" ) : QStringLiteral( "b" ) );
+    }
+  }
+}
+
+void TestQgsProcessingAlgs::countPointsInPolygon()
+{
+  std::unique_ptr< QgsProcessingAlgorithm > alg( QgsApplication::processingRegistry()->createAlgorithmById( QStringLiteral( "native:countpointsinpolygon" ) ) );
+  QVERIFY( alg != nullptr );
+  QVERIFY( alg->flags() & QgsProcessingAlgorithm::FlagSupportsParallelFeatureProcessing );
+
+  std::unique_ptr< QgsProcessingContext > context = qgis::make_unique< QgsProcessingContext >();
+  QgsProject p;
+  context->setProject( &p );
+  QgsProcessingFeedback feedback;
+
+  // a row of squares, with 3 points of 2 classes in each one, and a multipoint across the first two
+  QgsVectorLayer *squares = new QgsVectorLayer( QStringLiteral( "Polygon?crs=EPSG:3857&field=id:integer" ), QStringLiteral( "squares" ), QStringLiteral( "memory" ) );
+  QVERIFY( squares->isValid() );
+  QgsVectorLayer *points = new QgsVectorLayer( QStringLiteral( "MultiPoint?crs=EPSG:3857&field=weight:double&field=class:string" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  QVERIFY( points->isValid() );
+  QgsFeatureList squareFeatures;
+  QgsFeatureList pointFeatures;
+  for ( int i = 0; i < 1000; ++i )
+  {
+    QgsFeature square( squares->fields() );
+    square.setAttributes( QgsAttributes() << i );
+    square.setGeometry( QgsGeometry::fromRect( QgsRectangle( i, 0, i + 1, 1 ) ) );
+    squareFeatures << square;
+
+    for ( int j = 0; j < 3; ++j )
+    {
+      QgsFeature point( points->fields() );
+      point.setAttributes( QgsAttributes() << i * 0.5 << ( j == 0 ? QStringLiteral( "a" ) : QStringLiteral( "b" ) ) );
+      point.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( i + 0.25 * ( j + 1 ), 0.5 ) ) );
+      pointFeatures << point;
+    }
+  }
+  QgsFeature multiPoint( points->fields() );
+  multiPoint.setAttributes( QgsAttributes() << 100 << QStringLiteral( "c" ) );
+  multiPoint.setGeometry( QgsGeometry::fromMultiPointXY( QgsMultiPointXY() << QgsPointXY( 0.1, 0.1 ) << QgsPointXY( 1.1, 0.1 ) ) );
+  pointFeatures << multiPoint;
+  QVERIFY( squares->dataProvider()->addFeatures( squareFeatures ) );
+  QVERIFY( points->dataProvider()->addFeatures( pointFeatures ) );
+  p.addMapLayer( squares );
+  p.addMapLayer( points );
+
+  const int maxThreadCount = QThreadPool::globalInstance()->maxThreadCount();
+  QVariantMap parameters;
+  parameters.insert( QStringLiteral( "POLYGONS" ), QStringLiteral( "squares" ) );
+  parameters.insert( QStringLiteral( "POINTS" ), QStringLiteral( "points" ) );
+  parameters.insert( QStringLiteral( "OUTPUT" ), QStringLiteral( "memory:" ) );
+
+  // counts, weights, then classes
+  for ( int mode = 0; mode < 3; ++mode )
+  {
+    parameters.insert( QStringLiteral( "WEIGHT" ), mode == 1 ? QStringLiteral( "weight" ) : QString() );
+    parameters.insert( QStringLiteral( "CLASSFIELD" ), mode == 2 ? QStringLiteral( "class" ) : QString() );
+    QThreadPool::globalInstance()->setMaxThreadCount( 4 );
+    bool ok = false;
+    QVariantMap results = alg->run( parameters, *context, &feedback, &ok );
+    QThreadPool::globalInstance()->setMaxThreadCount( maxThreadCount );
+    QVERIFY( ok );
+
+    QgsVectorLayer *output = qobject_cast< QgsVectorLayer * >( context->getMapLayer( results.value( QStringLiteral( "OUTPUT" ) ).toString() ) );
+    QVERIFY( output );
+    QCOMPARE( output->featureCount(), 1000L );
+    QgsFeatureIterator it = output->getFeatures();
+    QgsFeature f;
+    int i = 0;
+    while ( it.nextFeature( f ) )
+    {
+      QCOMPARE( f.attribute( 0 ).toInt(), i );
+      const double score = f.attribute( 1 ).toDouble();
+      switch ( mode )
+      {
+        case 0:
+          QCOMPARE( score, 3.0 );
+          break;
+        case 1:
+          QCOMPARE( score, i * 1.5 );
+          break;
+        case 2:
+          QCOMPARE( score, 2.0 );
+          break;
+      }
+      i++;
+    }
+    QCOMPARE( i, 1000 );
+  }
+}
+
 void TestQgsProcessingAlgs::kmeansCluster()
 {
   // make some features
@@ -54,6 +54,7 @@ class TestQgsRasterCalculator : public QObject
 
     void rasterRefOp();
     void dualOpRasterRaster(); //test dual op on raster ref and raster ref
+    void calculateRow(); //test row calculation with reused buffers
 
     void calcWithLayers();
     void calcWithReprojectedLayers();
@@ -432,6 +433,53 @@ void TestQgsRasterCalculator::dualOpRasterRaster()
   QCOMPARE( result.data()[5], -9999.0 );
 }
 
+void TestQgsRasterCalculator::calculateRow()
+{
+  QgsRasterBlock m1( Qgis::Float32, 2, 3 );
+  m1.setNoDataValue( -1.0 );
+  m1.setValue( 0, 0, 1.0 );
+  m1.setValue( 0, 1, 2.0 );
+  m1.setValue( 1, 0, -2.0 );
+  m1.setValue( 1, 1, -1.0 ); //nodata
+  m1.setValue( 2, 0, 5.0 );
+  m1.setValue( 2, 1, 9.0 );
+  QgsRasterBlock m2( Qgis::Int16, 2, 3 );
+  m2.setNoDataValue( -2.0 );
+  m2.setValue( 0, 0, 4 );
+  m2.setValue( 0, 1, -2 ); //nodata
+  m2.setValue( 1, 0, 13 );
+  m2.setValue( 1, 1, 0 );
+  m2.setValue( 2, 0, 16 );
+  m2.setValue( 2, 1, 3 );
+  QMap<QString, QgsRasterBlock *> rasterData;
+  rasterData.insert( QStringLiteral( "raster1" ), &m1 );
+  rasterData.insert( QStringLiteral( "raster2" ), &m2 );
+
+  QString error;
+  std::unique_ptr< QgsRasterCalcNode > node( QgsRasterCalcNode::parseRasterCalcString( QStringLiteral( "( \"raster1\" * 2 + sqrt( \"raster2\" ) ) / ( \"raster2\" - 3 ) - ( \"raster1\" > 4 )" ), error ) );
+  QVERIFY( node );
+
+  // same results as the calculation of the rows with matrices
+  QgsRasterMatrix result( 2, 1, new double[2], -9999 );
+  std::vector< std::unique_ptr< QgsRasterMatrix > > buffers;
+  for ( int row = 0; row < 3; ++row )
+  {
+    QVERIFY( node->calculateRow( rasterData, row, result, buffers ) );
+    QgsRasterMatrix expected( 2, 1, nullptr, -9999 );
+    QVERIFY( node->calculate( rasterData, expected, row ) );
+    QCOMPARE( result.data()[0], expected.data()[0] );
+    QCOMPARE( result.data()[1], expected.data()[1] );
+  }
+  QCOMPARE( result.data()[0], ( 10.0 + 4.0 ) / 13.0 - 1.0 );
+  // division by zero
+  QCOMPARE( result.data()[1], -9999.0 );
+  QVERIFY( !buffers.empty() );
+
+  // unknown raster
+  std::unique_ptr< QgsRasterCalcNode > unknown( QgsRasterCalcNode::parseRasterCalcString( QStringLiteral( "\"raster3\" + 1" ), error ) );
+  QVERIFY( !unknown->calculateRow( rasterData, 0, result, buffers ) );
+}
+
 void TestQgsRasterCalculator::calcWithLayers()
 {
   QgsRasterCalculatorEntry entry1;
@@ -23,6 +23,12 @@
 #include "qgszonalstatistics.h"
 #include "qgsproject.h"
 #include "qgsvectorlayerutils.h"
+#include "qgsgeometryengine.h"
+#include "qgsogrutils.h"
+
+#include <QTemporaryDir>
+
+#include <gdal.h>
 
 /**
  * \ingroup UnitTests
@@ -43,6 +49,7 @@ class TestQgsZonalStatistics : public QObject
     void testNoData();
     void testSmallPolygons();
     void testShortName();
+    void testTiles();
 
   private:
     QgsVectorLayer *mVectorLayer = nullptr;
@@ -360,5 +367,90 @@ void TestQgsZonalStatistics::testShortName()
   QCOMPARE( QgsZonalStatistics::shortName( QgsZonalStatistics::Variance ), QStringLiteral( "variance" ) );
 }
 
+void TestQgsZonalStatistics::testTiles()
+{
+  // a raster of several tiles, and zones across the tiles, with holes and parts, on cell centers or not
+  QTemporaryDir dir;
+  const QString rasterFile = dir.filePath( QStringLiteral( "tiles.tif" ) );
+  const int size = 1100;
+  const QgsCoordinateReferenceSystem crs( QStringLiteral( "EPSG:3857" ) );
+  QVector<float> values( size * size );
+  {
+    gdal::dataset_unique_ptr dataset( GDALCreate( GDALGetDriverByName( "GTiff" ), rasterFile.toUtf8().constData(), size, size, 1, GDT_Float32, nullptr ) );
+    QVERIFY( dataset );
+    double geotransform[] = { 0, 1, 0, static_cast< double >( size ), 0, -1 };
+    GDALSetGeoTransform( dataset.get(), geotransform );
+    GDALSetProjection( dataset.get(), crs.toWkt( QgsCoordinateReferenceSystem::WKT_PREFERRED_GDAL ).toUtf8().constData() );
+    GDALRasterBandH band = GDALGetRasterBand( dataset.get(), 1 );
+    GDALSetRasterNoDataValue( band, -9999 );
+    for ( int i = 0; i < values.size(); ++i )
+      values[ i ] = i % 89 == 0 ? -9999 : ( ( i % size ) * 7 + ( i / size ) * 3 ) % 101;
+    QCOMPARE( GDALRasterIO( band, GF_Write, 0, 0, size, size, values.data(), size, size, GDT_Float32, 0, 0 ), CE_None );
+  }
+  std::unique_ptr< QgsRasterLayer > rasterLayer = qgis::make_unique< QgsRasterLayer >( rasterFile, QStringLiteral( "raster" ), QStringLiteral( "gdal" ) );
+  QVERIFY( rasterLayer->isValid() );
+
+  std::unique_ptr< QgsVectorLayer > vectorLayer = qgis::make_unique< QgsVectorLayer >( QStringLiteral( "Polygon?crs=EPSG:3857" ), QStringLiteral( "zones" ), QStringLiteral( "memory" ) );
+  QVERIFY( vectorLayer->isValid() );
+  const QStringList wkts
+  {
+    QStringLiteral( "Polygon ((500 580, 530 580, 530 600, 500 600, 500 580))" ),
+    QStringLiteral( "Polygon ((505.5 570.5, 540.5 605.5, 505.5 605.5, 505.5 570.5))" ),
+    QStringLiteral( "Polygon ((1000 50, 1090 50, 1090 120, 1000 120, 1000 50),(1020 70, 1040 70, 1040 90, 1020 90, 1020 70))" ),
+    QStringLiteral( "MultiPolygon (((100.3 200.7, 180.9 230.1, 150.2 300.4, 100.3 200.7)),((600.1 800.2, 700.7 790.3, 650.4 900.9, 600.1 800.2)))" ),
+  };
+  QgsFeatureList features;
+  for ( const QString &wkt : wkts )
+  {
+    QgsFeature feature;
+    feature.setGeometry( QgsGeometry::fromWkt( wkt ) );
+    features << feature;
+  }
+  QVERIFY( vectorLayer->dataProvider()->addFeatures( features ) );
+
+  QgsZonalStatistics zs( vectorLayer.get(), rasterLayer.get(), QString(), 1, QgsZonalStatistics::Count | QgsZonalStatistics::Sum | QgsZonalStatistics::Min | QgsZonalStatistics::Max );
+  QCOMPARE( zs.calculateStatistics( nullptr ), 0 );
+
+  // the statistics are those of the cells whose center is in the zone
+  QgsFeatureIterator it = vectorLayer->getFeatures();
+  QgsFeature f;
+  int featureCount = 0;
+  while ( it.nextFeature( f ) )
+  {
+    std::unique_ptr< QgsGeometryEngine > engine( QgsGeometry::createGeometryEngine( f.geometry().constGet() ) );
+    engine->prepareGeometry();
+    const QgsRectangle bbox = f.geometry().boundingBox();
+    double count = 0;
+    double sum = 0;
+    double min = std::numeric_limits<double>::max();
+    double max = std::numeric_limits<double>::lowest();
+    for ( int row = 0; row < size; ++row )
+    {
+      const double y = size - row - 0.5;
+      if ( y < bbox.yMinimum() || y > bbox.yMaximum() )
+        continue;
+      for ( int column = static_cast< int >( bbox.xMinimum() ); column < std::min( size, static_cast< int >( bbox.xMaximum() ) + 1 ); ++column )
+      {
+        const QgsPoint center( column + 0.5, y );
+        const double value = values.at( row * size + column );
+        if ( value != -9999 && engine->contains( &center ) )
+        {
+          count++;
+          sum += value;
+          min = std::min( min, value );
+          max = std::max( max, value );
+        }
+      }
+    }
+    QVERIFY( count > 1 );
+    QCOMPARE( f.attribute( "count" ).toDouble(), count );
+    QCOMPARE( f.attribute( "sum" ).toDouble(), sum );
+    QCOMPARE( f.attribute( "min" ).toDouble(), min );
+    QCOMPARE( f.attribute( "max" ).toDouble(), max );
+    featureCount++;
+  }
+  QCOMPARE( featureCount, 4 );
+}
+
 QGSTEST_MAIN( TestQgsZonalStatistics )
 #include "testqgszonalstatistics.moc"
@@ -19,6 +19,8 @@
 #include "qgsprintlayout.h"
 #include "qgslayoutmanager.h"
 #include "locator/qgsinbuiltlocatorfilters.h"
+#include "locator/qgslocatorfeaturesindex.h"
+#include "qgssettings.h"
 #include <QSignalSpy>
 #include <QClipboard>
 
@@ -39,6 +41,7 @@ class TestQgsAppLocatorFilters : public QObject
     void testSearchActiveLayer();
     void testSearchAllLayers();
     void testSearchAllLayersPrioritizeExactMatch();
+    void testSearchAllLayersIndexed();
     void testGoto();
 
   private:
@@ -256,6 +259,55 @@ void TestQgsAppLocatorFilters::testSearchAllLayersPrioritizeExactMatch()
   QgsProject::instance()->removeAllMapLayers();
 }
 
+void TestQgsAppLocatorFilters::testSearchAllLayersIndexed()
+{
+  QString layerDef = QStringLiteral( "Point?crs=epsg:4326&field=pk:integer&field=my_text:string&field=my_number:integer&key=pk" );
+  QgsVectorLayer *l1 = new QgsVectorLayer( layerDef, QStringLiteral( "Layer 1" ), QStringLiteral( "memory" ) );
+  QgsProject::instance()->addMapLayers( QList< QgsMapLayer *>() << l1 );
+
+  QgsFeatureList features;
+  for ( int i = 0; i < 1000; ++i )
+  {
+    QgsFeature f;
+    f.setAttributes( QVector<QVariant>() << i << QStringLiteral( "Street %1" ).arg( i ) << i % 10 );
+    features << f;
+  }
+  l1->dataProvider()->addFeatures( features );
+  l1->setDisplayExpression( QStringLiteral( "\"my_text\" || ' is ' || \"my_number\"" ) );
+
+  QgsSettings().setValue( QStringLiteral( "locator_filters/all_layers_features/use_index" ), true, QgsSettings::App );
+
+  QgsAllLayersFeaturesLocatorFilter filter;
+  QgsLocatorContext context;
+
+  // the index is built in the background, the provider is queried in the meantime
+  QList< QgsLocatorResult > results = gatherResults( &filter, QStringLiteral( "street 12 is 2" ), context );
+  QCOMPARE( results.count(), 8 );
+  while ( !QgsLocatorFeaturesIndexRegistry::instance()->index( l1 ) )
+    QCoreApplication::processEvents();
+  QCOMPARE( QgsLocatorFeaturesIndexRegistry::instance()->index( l1 )->count(), 1000 );
+
+  results = gatherResults( &filter, QStringLiteral( "street 12 is 2" ), context );
+  QCOMPARE( results.count(), 8 );
+  QCOMPARE( results.first().displayString, QStringLiteral( "Street 12 is 2" ) );
+  for ( const QgsLocatorResult &result : qgis::as_const( results ) )
+    QVERIFY( result.displayString.endsWith( QStringLiteral( "is 2" ) ) );
+
+  results = gatherResults( &filter, QStringLiteral( "STREET 999" ), context );
+  QCOMPARE( results.count(), 1 );
+  QCOMPARE( results.first().displayString, QStringLiteral( "Street 999 is 9" ) );
+
+  // a change of the display expression discards the index
+  l1->setDisplayExpression( QStringLiteral( "\"my_text\"" ) );
+  QVERIFY( !QgsLocatorFeaturesIndexRegistry::instance()->index( l1 ) );
+  results = gatherResults( &filter, QStringLiteral( "street 999" ), context );
+  QCOMPARE( results.count(), 1 );
+  QCOMPARE( results.first().displayString, QStringLiteral( "Street 999" ) );
+
+  QgsSettings().remove( QStringLiteral( "locator_filters/all_layers_features/use_index" ), QgsSettings::App );
+  QgsProject::instance()->removeAllMapLayers();
+}
+
 QList<QgsLocatorResult> TestQgsAppLocatorFilters::gatherResults( QgsLocatorFilter *filter, const QString &string, const QgsLocatorContext &context )
 {
   QSignalSpy spy( filter, &QgsLocatorFilter::resultFetched );
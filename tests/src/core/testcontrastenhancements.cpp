@@ -24,6 +24,7 @@
 #include <qgscontrastenhancement.h>
 #include <qgslinearminmaxenhancement.h>
 #include <qgslinearminmaxenhancementwithclip.h>
+#include <qgsrasterblock.h>
 
 /**
  * \ingroup UnitTests
@@ -41,6 +42,7 @@ class TestContrastEnhancements: public QObject
     void clipMinMaxEnhancementTest();
     void linearMinMaxEnhancementWithClipTest();
     void linearMinMaxEnhancementTest();
+    void enhanceBlockTest();
   private:
     QString mReport;
 };
@@ -103,5 +105,41 @@ void TestContrastEnhancements::linearMinMaxEnhancementTest()
   //Original pixel value of 240 should be scaled to 255
   QVERIFY( 255.0 == myEnhancement.enhance( 240.0 ) );
 }
+void TestContrastEnhancements::enhanceBlockTest()
+{
+  const QList< QgsContrastEnhancement::ContrastEnhancementAlgorithm > algorithms
+  {
+    QgsContrastEnhancement::NoEnhancement,
+    QgsContrastEnhancement::StretchToMinimumMaximum,
+    QgsContrastEnhancement::StretchAndClipToMinimumMaximum,
+    QgsContrastEnhancement::ClipToMinimumMaximum
+  };
+  for ( Qgis::DataType dataType : { Qgis::Byte, Qgis::UInt16, Qgis::Int32, Qgis::Float32 } )
+  {
+    QgsRasterBlock block( dataType, 50, 20 );
+    for ( int i = 0; i < 1000; ++i )
+      block.setValue( i, ( i * 37 ) % 256 );
+    block.setNoDataValue( 37 );
+
+    for ( QgsContrastEnhancement::ContrastEnhancementAlgorithm algorithm : algorithms )
+    {
+      QgsContrastEnhancement enhancement( dataType );
+      enhancement.setContrastEnhancementAlgorithm( algorithm, false );
+      enhancement.setMinimumValue( 10 );
+      enhancement.setMaximumValue( 240 );
+
+      // same results as the enhancement of each pixel
+      std::vector< int > values( 1000 );
+      enhancement.enhanceBlock( block, values.data() );
+      for ( int i = 0; i < 1000; ++i )
+      {
+        const double value = block.value( i );
+        const int expected = block.isNoData( i ) || !enhancement.isValueInDisplayableRange( value ) ? -1 : enhancement.enhanceContrast( value );
+        QCOMPARE( values[i], expected );
+      }
+    }
+  }
+}
+
 QGSTEST_MAIN( TestContrastEnhancements )
 #include "testcontrastenhancements.moc"
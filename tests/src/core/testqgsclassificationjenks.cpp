@@ -0,0 +1,130 @@
+/***************************************************************************
+     testqgsclassificationjenks.cpp
+     ------------------------------
+    Date                 : October 2020
+    Copyright            : (C) 2020 by the QGIS project
+    Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include <QObject>
+
+#include <qgsapplication.h>
+#include "qgsclassificationjenks.h"
+
+#include <limits>
+#include <random>
+
+// sum of the squared deviations of the values within each class
+static double classesDeviation( QVector<double> values, const QList<QgsClassificationRange> &classes )
+{
+  std::sort( values.begin(), values.end() );
+  double deviation = 0;
+  int begin = 0;
+  for ( int c = 0; c < classes.size(); ++c )
+  {
+    int end = begin;
+    while ( end < values.size() && ( c == classes.size() - 1 || values.at( end ) <= classes.at( c ).upperBound() ) )
+      end++;
+    double mean = 0;
+    for ( int i = begin; i < end; ++i )
+      mean += values.at( i );
+    mean /= std::max( 1, end - begin );
+    for ( int i = begin; i < end; ++i )
+      deviation += ( values.at( i ) - mean ) * ( values.at( i ) - mean );
+    begin = end;
+  }
+  return deviation;
+}
+
+// quadratic dynamic program, returning the optimal sum of squared deviations
+static double optimalDeviation( QVector<double> values, int nclasses )
+{
+  std::sort( values.begin(), values.end() );
+  const int n = values.size();
+  QVector< QVector<double> > cost( nclasses + 1, QVector<double>( n + 1, std::numeric_limits<double>::max() ) );
+  cost[0][0] = 0;
+  for ( int j = 1; j <= nclasses; ++j )
+  {
+    for ( int l = j; l <= n; ++l )
+    {
+      double sum = 0;
+      double squareSum = 0;
+      for ( int m = l - 1; m >= j - 1; --m )
+      {
+        sum += values.at( m );
+        squareSum += values.at( m ) * values.at( m );
+        if ( cost[j - 1][m] == std::numeric_limits<double>::max() )
+          continue;
+        cost[j][l] = std::min( cost[j][l], cost[j - 1][m] + squareSum - sum * sum / ( l - m ) );
+      }
+    }
+  }
+  return cost[nclasses][n];
+}
+
+class TestQgsClassificationJenks : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+
+    void initTestCase()
+    {
+      QgsApplication::init();
+      QgsApplication::initQgis();
+    }
+    void cleanupTestCase()
+    {
+      QgsApplication::exitQgis();
+    }
+
+    void testOptimal()
+    {
+      std::mt19937 generator( 42 );
+      std::normal_distribution< double > distribution( 50, 20 );
+      for ( int nclasses = 2; nclasses <= 7; ++nclasses )
+      {
+        QList<double> values;
+        for ( int i = 0; i < 400; ++i )
+          values << distribution( generator );
+
+        QgsClassificationJenks jenks;
+        const QList<QgsClassificationRange> classes = jenks.classes( values, nclasses );
+        QCOMPARE( classes.size(), nclasses );
+        QGSCOMPARENEAR( classesDeviation( values.toVector(), classes ), optimalDeviation( values.toVector(), nclasses ), 1e-6 );
+      }
+    }
+
+    void testLargeDataset()
+    {
+      // every value is used and the breaks do not change between runs
+      std::mt19937 generator( 42 );
+      std::lognormal_distribution< double > distribution( 3, 1 );
+      QList<double> values;
+      for ( int i = 0; i < 1000000; ++i )
+        values << distribution( generator );
+
+      QgsClassificationJenks jenks;
+      const QList<QgsClassificationRange> classes = jenks.classes( values, 6 );
+      QCOMPARE( classes.size(), 6 );
+      for ( int i = 1; i < classes.size(); ++i )
+        QVERIFY( classes.at( i ).upperBound() > classes.at( i - 1 ).upperBound() );
+      QCOMPARE( classes.last().upperBound(), *std::max_element( values.begin(), values.end() ) );
+
+      const QList<QgsClassificationRange> other = jenks.classes( values, 6 );
+      for ( int i = 0; i < classes.size(); ++i )
+        QCOMPARE( other.at( i ).upperBound(), classes.at( i ).upperBound() );
+    }
+};
+
+QGSTEST_MAIN( TestQgsClassificationJenks )
+
+#include "testqgsclassificationjenks.moc"
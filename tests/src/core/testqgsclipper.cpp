@@ -22,6 +22,7 @@
 //header for class being tested
 #include <qgsclipper.h>
 #include <qgspoint.h>
+#include "qgslinestring.h"
 #include "qgslogger.h"
 
 class TestQgsClipper: public QObject
@@ -34,6 +35,8 @@ class TestQgsClipper: public QObject
     void init() {} // will be called before each testfunction is executed.
     void cleanup() {} // will be called after every testfunction.
     void basic();
+    void trimPolygonInside();
+    void clippedLine();
   private:
     bool checkBoundingBox( const QPolygonF &polygon, const QgsRectangle &clipRect );
 };
@@ -78,6 +81,46 @@ void TestQgsClipper::basic()
   QVERIFY( ! checkBoundingBox( polygon, clipRectInner ) );
 }
 
+void TestQgsClipper::trimPolygonInside()
+{
+  // polygons inside the rectangle are returned unchanged
+  QPolygonF polygon;
+  polygon << QPointF( 1, 1 ) << QPointF( 9, 1 ) << QPointF( 9, 9 ) << QPointF( 1, 1 );
+  const QPolygonF original = polygon;
+  QgsClipper::trimPolygon( polygon, QgsRectangle( 0, 0, 10, 10 ) );
+  QCOMPARE( polygon, original );
+
+  // crossing a single boundary
+  QgsClipper::trimPolygon( polygon, QgsRectangle( 0, 0, 5, 10 ) );
+  QVERIFY( checkBoundingBox( polygon, QgsRectangle( 0, 0, 5, 10 ) ) );
+  QCOMPARE( polygon.boundingRect(), QRectF( 1, 1, 4, 4 ) );
+}
+
+void TestQgsClipper::clippedLine()
+{
+  const QgsRectangle clipRect( 0, 0, 10, 10 );
+
+  // inside the rectangle, including the boundary
+  QgsLineString inside( QVector< double >() << 0 << 5 << 10, QVector< double >() << 1 << 5 << 10 );
+  QCOMPARE( QgsClipper::clippedLine( inside, clipRect ), inside.asQPolygonF() );
+
+  // entirely on one side of the rectangle
+  QgsLineString outside( QVector< double >() << -5 << -1 << -3, QVector< double >() << -5 << 20 << 5 );
+  QVERIFY( QgsClipper::clippedLine( outside, clipRect ).isEmpty() );
+
+  // crossing the rectangle
+  QgsLineString crossing( QVector< double >() << -5 << 5 << 15, QVector< double >() << 5 << 5 << 5 );
+  QCOMPARE( QgsClipper::clippedLine( crossing, clipRect ), QPolygonF() << QPointF( 0, 5 ) << QPointF( 5, 5 ) << QPointF( 10, 5 ) );
+
+  // outside the rectangle, but not on a single side of it
+  QgsLineString around( QVector< double >() << -5 << 15 << 15, QVector< double >() << 5 << 5 << 20 );
+  QCOMPARE( QgsClipper::clippedLine( around, clipRect ), QPolygonF() << QPointF( 0, 5 ) << QPointF( 10, 5 ) );
+
+  // single point
+  QgsLineString point( QVector< double >() << 5, QVector< double >() << 5 );
+  QVERIFY( QgsClipper::clippedLine( point, clipRect ).isEmpty() );
+}
+
 bool TestQgsClipper::checkBoundingBox( const QPolygonF &polygon, const QgsRectangle &clipRect )
 {
   QgsRectangle bBox( polygon.boundingRect() );
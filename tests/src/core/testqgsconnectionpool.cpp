@@ -15,6 +15,7 @@
  *                                                                         *
  ***************************************************************************/
 #include "qgsapplication.h"
+#include "qgsconnectionpool.h"
 #include "qgsfeatureiterator.h"
 #include "qgsgeometry.h"
 #include "qgspoint.h"
@@ -22,7 +23,9 @@
 #include "qgsvectorlayer.h"
 #include <QEventLoop>
 #include <QObject>
+#include <QTemporaryDir>
 #include <QTemporaryFile>
+#include <QThreadPool>
 #include <QtConcurrentMap>
 #include "qgstest.h"
 
@@ -34,6 +37,8 @@ class TestQgsConnectionPool: public QObject
     void initTestCase();
     void cleanupTestCase();
     void layersFromSameDatasetGPX();
+    void minimumConnections();
+    void concurrentReadIterators();
 
   private:
     struct ReadJob
@@ -140,5 +145,84 @@ void TestQgsConnectionPool::layersFromSameDatasetGPX()
   QFile( testFile.fileName() ).remove();
 }
 
+void TestQgsConnectionPool::minimumConnections()
+{
+  QgsConnectionPoolMonitor::setMinimumConnections( 2 );
+  QCOMPARE( QgsConnectionPoolMonitor::minimumConnections(), 2 );
+
+  const QString path = QStringLiteral( TEST_DATA_DIR ) + QStringLiteral( "/points.shp" );
+  QgsVectorLayer layer( path, QStringLiteral( "points" ), QStringLiteral( "ogr" ) );
+  QVERIFY( layer.isValid() );
+
+  {
+    QgsFeatureIterator it = layer.getFeatures( QgsFeatureRequest().setLimit( 1 ) );
+    QgsFeature f;
+    QVERIFY( it.nextFeature( f ) );
+
+    // the group of connections is created with the minimum number of connections
+    bool found = false;
+    const QMap<QString, QgsConnectionPoolMonitor::GroupStatistics> statistics = QgsConnectionPoolMonitor::instance()->statistics();
+    for ( auto stats = statistics.constBegin(); stats != statistics.constEnd(); ++stats )
+    {
+      if ( !stats.key().contains( QLatin1String( "points.shp" ) ) )
+        continue;
+      found = true;
+      QVERIFY( stats->connectionsCreated >= 2 );
+      QCOMPARE( stats->acquired, 1 );
+      QVERIFY( stats->acquisitions >= 1 );
+    }
+    QVERIFY( found );
+  }
+
+  // the connection is back in the pool
+  const QMap<QString, QgsConnectionPoolMonitor::GroupStatistics> statistics = QgsConnectionPoolMonitor::instance()->statistics();
+  for ( auto stats = statistics.constBegin(); stats != statistics.constEnd(); ++stats )
+  {
+    if ( stats.key().contains( QLatin1String( "points.shp" ) ) )
+    {
+      QCOMPARE( stats->acquired, 0 );
+      QVERIFY( stats->idle >= 2 );
+    }
+  }
+
+  QgsConnectionPoolMonitor::setMinimumConnections( 0 );
+}
+
+void TestQgsConnectionPool::concurrentReadIterators()
+{
+  // the pool of a data source holds a dataset per thread of the global pool
+  const int maxThreads = QThreadPool::globalInstance()->maxThreadCount();
+  QThreadPool::globalInstance()->setMaxThreadCount( QgsApplication::instance()->maxConcurrentConnectionsPerPool() + 4 );
+
+  QTemporaryDir dir;
+  for ( const QString &suffix : { QStringLiteral( "shp" ), QStringLiteral( "shx" ), QStringLiteral( "dbf" ), QStringLiteral( "prj" ) } )
+    QVERIFY( QFile::copy( QStringLiteral( TEST_DATA_DIR ) + QStringLiteral( "/points." ) + suffix, dir.filePath( QStringLiteral( "points." ) + suffix ) ) );
+  QgsVectorLayer layer( dir.filePath( QStringLiteral( "points.shp" ) ), QStringLiteral( "points" ), QStringLiteral( "ogr" ) );
+  QVERIFY( layer.isValid() );
+
+  // each iterator holds its own dataset, none waits for another one
+  QList<QgsFeatureIterator> iterators;
+  for ( int i = 0; i < QThreadPool::globalInstance()->maxThreadCount(); ++i )
+  {
+    iterators << layer.getFeatures( QgsFeatureRequest().setTimeout( 0 ).setRequestMayBeNested( true ) );
+    QgsFeature f;
+    QVERIFY( iterators.last().nextFeature( f ) );
+  }
+
+  // and they read all the features
+  const long count = layer.featureCount();
+  for ( QgsFeatureIterator &it : iterators )
+  {
+    long read = 1;
+    QgsFeature f;
+    while ( it.nextFeature( f ) )
+      ++read;
+    QCOMPARE( read, count );
+  }
+  iterators.clear();
+
+  QThreadPool::globalInstance()->setMaxThreadCount( maxThreads );
+}
+
 QGSTEST_MAIN( TestQgsConnectionPool )
 #include "testqgsconnectionpool.moc"
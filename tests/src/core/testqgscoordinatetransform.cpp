@@ -15,11 +15,13 @@
  *                                                                         *
  ***************************************************************************/
 #include "qgscoordinatetransform.h"
+#include "qgsapproximatecoordinatetransform.h"
 #include "qgsapplication.h"
 #include "qgsrectangle.h"
 #include "qgscoordinatetransformcontext.h"
 #include "qgsproject.h"
 #include <QObject>
+#include <QtConcurrentMap>
 #include "qgstest.h"
 #include "qgsexception.h"
 #include "qgslogger.h"
@@ -47,6 +49,8 @@ class TestQgsCoordinateTransform: public QObject
     void transformErrorOnePoint();
     void testDeprecated4240to4326();
     void testCustomProjTransform();
+    void approximateTransform();
+    void transformInThreads();
 };
 
 
@@ -615,6 +619,95 @@ void TestQgsCoordinateTransform::testCustomProjTransform()
 #endif
 }
 
+void TestQgsCoordinateTransform::approximateTransform()
+{
+  const QgsCoordinateTransform ct( QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:4326" ) ), QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:3857" ) ), QgsProject::instance() );
+  const QgsRectangle extent( 4, 44, 8, 48 );
+  // a tenth of the size of a pixel of a 1000 pixels wide map
+  const double tolerance = 445000.0 / 1000 / 10;
+  const QgsApproximateCoordinateTransform approximate( ct, extent, tolerance );
+  QVERIFY( approximate.isValid() );
+  QCOMPARE( approximate.approximatedCellCount(), 32 * 32 );
+
+  QPolygonF polygon;
+  for ( int i = 0; i < 100; ++i )
+    polygon << QPointF( 4 + 0.0397 * i, 44 + 0.0291 * i );
+  // outside of the grid, transformed exactly
+  polygon << QPointF( 10, 50 );
+  QPolygonF exact = polygon;
+  ct.transformPolygon( exact );
+
+  approximate.transformPolygon( polygon );
+  for ( int i = 0; i < polygon.size(); ++i )
+  {
+    QVERIFY( std::fabs( polygon.at( i ).x() - exact.at( i ).x() ) <= tolerance );
+    QVERIFY( std::fabs( polygon.at( i ).y() - exact.at( i ).y() ) <= tolerance );
+  }
+  QCOMPARE( polygon.last(), exact.last() );
+
+  double x = 20;
+  double y = 50;
+  QVERIFY( !approximate.transformInPlace( x, y ) );
+  QCOMPARE( x, 20.0 );
+  const QPointF point = approximate.transform( 6.5, 45.5 );
+  const QgsPointXY exactPoint = ct.transform( QgsPointXY( 6.5, 45.5 ) );
+  QGSCOMPARENEAR( point.x(), exactPoint.x(), tolerance );
+  QGSCOMPARENEAR( point.y(), exactPoint.y(), tolerance );
+
+  // too strict tolerances cannot be approximated
+  QVERIFY( !QgsApproximateCoordinateTransform( ct, extent, 1e-9 ).isValid() );
+  // neither can invalid transforms
+  QVERIFY( !QgsApproximateCoordinateTransform( QgsCoordinateTransform(), extent, tolerance ).isValid() );
+
+  // the cells where mercator bends too much are refined
+  const QgsRectangle bentExtent( 0, 0, 40, 84 );
+  const QgsApproximateCoordinateTransform refined( ct, bentExtent, 50 );
+  QVERIFY( refined.approximatedCellCount() < 32 * 32 );
+  QVERIFY( refined.refinedCellCount() > 0 );
+  polygon.clear();
+  for ( int i = 0; i < 100; ++i )
+    polygon << QPointF( 0.397 * i, 0.839 * i );
+  exact = polygon;
+  ct.transformPolygon( exact );
+  refined.transformPolygon( polygon );
+  for ( int i = 0; i < polygon.size(); ++i )
+  {
+    QVERIFY( std::fabs( polygon.at( i ).x() - exact.at( i ).x() ) <= 50 );
+    QVERIFY( std::fabs( polygon.at( i ).y() - exact.at( i ).y() ) <= 50 );
+  }
+
+  // cached approximations are shared when they cover the extent accurately enough
+  const std::shared_ptr< const QgsApproximateCoordinateTransform > cached = QgsApproximateCoordinateTransform::cachedTransform( ct, extent, tolerance );
+  QVERIFY( cached );
+  QCOMPARE( QgsApproximateCoordinateTransform::cachedTransform( ct, extent, tolerance ).get(), cached.get() );
+  QCOMPARE( QgsApproximateCoordinateTransform::cachedTransform( ct, QgsRectangle( 5, 45, 7, 47 ), tolerance * 2 ).get(), cached.get() );
+  QVERIFY( QgsApproximateCoordinateTransform::cachedTransform( ct, extent, tolerance / 2 ).get() != cached.get() );
+  QVERIFY( QgsApproximateCoordinateTransform::cachedTransform( ct, QgsRectangle( 3, 44, 8, 48 ), tolerance ).get() != cached.get() );
+  const QgsCoordinateTransform otherCt( QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:4326" ) ), QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:3035" ) ), QgsProject::instance() );
+  QVERIFY( QgsApproximateCoordinateTransform::cachedTransform( otherCt, extent, tolerance ).get() != cached.get() );
+  QVERIFY( !QgsApproximateCoordinateTransform::cachedTransform( ct, extent, 1e-9 ) );
+}
+
+void TestQgsCoordinateTransform::transformInThreads()
+{
+  // the proj objects of the other threads are cloned from the ones of the main thread
+  const QgsCoordinateTransform ct( QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:4326" ) ), QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:2154" ) ), QgsProject::instance() );
+  QVERIFY( ct.isValid() );
+  const QgsPointXY expected = ct.transform( QgsPointXY( 2.5, 46.5 ) );
+
+  QVector< QgsPointXY > points( 64, QgsPointXY( 2.5, 46.5 ) );
+  QtConcurrent::blockingMap( points, []( QgsPointXY & point )
+  {
+    // a transform created in the thread is found in the cache
+    const QgsCoordinateTransform threadCt( QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:4326" ) ), QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:2154" ) ), QgsProject::instance() );
+    point = threadCt.transform( point );
+  } );
+  for ( const QgsPointXY &point : qgis::as_const( points ) )
+  {
+    QGSCOMPARENEAR( point.x(), expected.x(), 0.001 );
+    QGSCOMPARENEAR( point.y(), expected.y(), 0.001 );
+  }
+}
 
 QGSTEST_MAIN( TestQgsCoordinateTransform )
 #include "testqgscoordinatetransform.moc"
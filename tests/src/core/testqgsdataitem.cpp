@@ -29,6 +29,11 @@
 #include "qgsdataitemproviderregistry.h"
 #include "qgssettings.h"
 
+#include <QFile>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QtConcurrentRun>
+
 /**
  * \ingroup UnitTests
  * This is a unit test for the QgsDataItem class.
@@ -49,6 +54,7 @@ class TestQgsDataItem : public QObject
     void testValid();
     void testDirItem();
     void testDirItemChildren();
+    void testDirItemChildrenInThread();
     void testLayerItemType();
     void testProjectItemCreation();
 
@@ -200,6 +206,42 @@ void TestQgsDataItem::testDirItemChildren()
   }
 }
 
+void TestQgsDataItem::testDirItemChildrenInThread()
+{
+  // the files of a large directory are probed in parallel when populated in the background
+  QTemporaryDir dir;
+  QStringList expected;
+  for ( int i = 0; i < 100; ++i )
+  {
+    const QString name = QStringLiteral( "project_%1" ).arg( i, 3, 10, QChar( '0' ) );
+    QFile file( dir.filePath( name + QStringLiteral( ".qgs" ) ) );
+    QVERIFY( file.open( QIODevice::WriteOnly ) );
+    file.close();
+    expected << name;
+  }
+
+  QgsDirectoryItem *dirItem = new QgsDirectoryItem( nullptr, QStringLiteral( "Test" ), dir.path() );
+  QThread *mainThread = QThread::currentThread();
+  const QVector<QgsDataItem *> children = QtConcurrent::run( [dirItem, mainThread]
+  {
+    const QVector<QgsDataItem *> children = dirItem->createChildren();
+    for ( QgsDataItem *child : children )
+      child->moveToThread( mainThread );
+    return children;
+  } ).result();
+
+  QStringList names;
+  for ( QgsDataItem *child : children )
+  {
+    QCOMPARE( child->type(), QgsDataItem::Project );
+    QCOMPARE( child->thread(), mainThread );
+    names << child->name();
+  }
+  QCOMPARE( names, expected );
+  qDeleteAll( children );
+  delete dirItem;
+}
+
 void TestQgsDataItem::testLayerItemType()
 {
   std::unique_ptr< QgsMapLayer > layer = qgis::make_unique< QgsVectorLayer >( mTestDataDir + "polys.shp",
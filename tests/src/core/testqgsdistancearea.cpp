@@ -47,6 +47,8 @@ class TestQgsDistanceArea: public QObject
     void emptyPolygon();
     void regression14675();
     void regression16820();
+    void lineLengthBySegments();
+    void polygonAreaByPoints();
 
 };
 
@@ -403,6 +405,64 @@ void TestQgsDistanceArea::regression16820()
   QGSCOMPARENEAR( calc.measureArea( geom ), 43.3280029296875, 0.2 );
 }
 
+void TestQgsDistanceArea::lineLengthBySegments()
+{
+  // the length of a line string is measured in one pass, it must match the sum of its segments
+  QgsDistanceArea calc;
+  calc.setEllipsoid( QStringLiteral( "WGS84" ) );
+  calc.setSourceCrs( QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:3857" ) ), QgsProject::instance()->transformContext() );
+  const QVector< QgsPointXY > points = QVector< QgsPointXY >() << QgsPointXY( 1000000, 5000000 ) << QgsPointXY( 1200000, 5100000 )
+                                       << QgsPointXY( 1200000, 5100000 ) << QgsPointXY( 900000, 6000000 ) << QgsPointXY( -300000, 6100000 );
+  double expected = 0;
+  for ( int i = 1; i < points.size(); ++i )
+    expected += calc.measureLine( points.at( i - 1 ), points.at( i ) );
+
+  QGSCOMPARENEAR( calc.measureLength( QgsGeometry::fromPolylineXY( points ) ), expected, 0.0001 );
+  QGSCOMPARENEAR( calc.measureLine( points ), expected, 0.0001 );
+  QGSCOMPARENEAR( calc.measureLength( QgsGeometry::fromMultiPolylineXY( QgsMultiPolylineXY() << points << points ) ), 2 * expected, 0.0001 );
+  QCOMPARE( calc.measureLength( QgsGeometry::fromPolylineXY( QVector< QgsPointXY >() << points.at( 0 ) ) ), 0.0 );
+
+  // planar length when there is no ellipsoid
+  calc.setEllipsoid( QStringLiteral( "NONE" ) );
+  QGSCOMPARENEAR( calc.measureLength( QgsGeometry::fromPolylineXY( points ) ), QgsGeometry::fromPolylineXY( points ).constGet()->length(), 0.0001 );
+  QGSCOMPARENEAR( calc.measureLine( points ), QgsGeometry::fromPolylineXY( points ).constGet()->length(), 0.0001 );
+}
+
+void TestQgsDistanceArea::polygonAreaByPoints()
+{
+  // the vertices of a ring are transformed in a single call, the area must match
+  // the one of the vertices transformed one by one
+  QgsDistanceArea calc;
+  calc.setEllipsoid( QStringLiteral( "WGS84" ) );
+  calc.setSourceCrs( QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:3857" ) ), QgsProject::instance()->transformContext() );
+  const QVector< QgsPointXY > ring = QVector< QgsPointXY >() << QgsPointXY( 1000000, 5000000 ) << QgsPointXY( 1200000, 5100000 )
+                                     << QgsPointXY( 900000, 6000000 ) << QgsPointXY( -300000, 6100000 ) << QgsPointXY( 1000000, 5000000 );
+
+  const QgsCoordinateTransform transform( QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:3857" ) ), QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:4326" ) ), QgsProject::instance()->transformContext() );
+  QVector< QgsPointXY > transformedRing;
+  for ( const QgsPointXY &point : ring )
+    transformedRing << transform.transform( point );
+
+  QgsDistanceArea geographicCalc;
+  geographicCalc.setEllipsoid( QStringLiteral( "WGS84" ) );
+  geographicCalc.setSourceCrs( QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:4326" ) ), QgsProject::instance()->transformContext() );
+  const double expected = geographicCalc.measurePolygon( transformedRing );
+  QVERIFY( expected > 0 );
+
+  QGSCOMPARENEAR( calc.measurePolygon( ring ), expected, expected * 1e-9 );
+  QGSCOMPARENEAR( calc.measureArea( QgsGeometry::fromPolygonXY( QgsPolygonXY() << ring ) ), expected, expected * 1e-9 );
+
+  // the perimeter goes through the same batched transform
+  double expectedPerimeter = 0;
+  for ( int i = 1; i < transformedRing.size(); ++i )
+    expectedPerimeter += geographicCalc.measureLine( transformedRing.at( i - 1 ), transformedRing.at( i ) );
+  QGSCOMPARENEAR( calc.measurePerimeter( QgsGeometry::fromPolygonXY( QgsPolygonXY() << ring ) ), expectedPerimeter, 0.0001 );
+
+  // planar area when there is no ellipsoid
+  calc.setEllipsoid( QStringLiteral( "NONE" ) );
+  QGSCOMPARENEAR( calc.measurePolygon( ring ), QgsGeometry::fromPolygonXY( QgsPolygonXY() << ring ).area(), 0.0001 );
+}
+
 QGSTEST_MAIN( TestQgsDistanceArea )
 #include "testqgsdistancearea.moc"
 
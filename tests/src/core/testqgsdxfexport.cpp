@@ -29,6 +29,7 @@
 #include "qgssinglesymbolrenderer.h"
 #include "qgsvectorlayerlabeling.h"
 #include "qgslinesymbollayer.h"
+#include "qgsmarkersymbollayer.h"
 #include <QTemporaryFile>
 
 Q_DECLARE_METATYPE( QgsDxfExport::HAlign )
@@ -46,6 +47,7 @@ class TestQgsDxfExport : public QObject
     void init();// will be called before each testfunction is executed.
     void cleanup();// will be called after every testfunction.
     void testPoints();
+    void testSharedMarkerBlocks();
     void testLines();
     void testPolygons();
     void testMultiSurface();
@@ -175,6 +177,46 @@ void TestQgsDxfExport::testPoints()
   QCOMPARE( result->wkbType(), QgsWkbTypes::Point );
 }
 
+void TestQgsDxfExport::testSharedMarkerBlocks()
+{
+  // two layers with identical marker symbols share the same block
+  std::unique_ptr< QgsVectorLayer > otherPointLayer = qgis::make_unique< QgsVectorLayer >( QStringLiteral( TEST_DATA_DIR ) + "/points.shp", QStringLiteral( "points2" ), QStringLiteral( "ogr" ) );
+  QVERIFY( otherPointLayer->isValid() );
+  QgsStringMap props;
+  props.insert( QStringLiteral( "color" ), QStringLiteral( "255,0,0" ) );
+  props.insert( QStringLiteral( "size" ), QStringLiteral( "4" ) );
+  mPointLayer->setRenderer( new QgsSingleSymbolRenderer( QgsMarkerSymbol::createSimple( props ) ) );
+  otherPointLayer->setRenderer( new QgsSingleSymbolRenderer( QgsMarkerSymbol::createSimple( props ) ) );
+
+  QgsDxfExport d;
+  d.addLayers( QList< QgsDxfExport::DxfLayer >() << QgsDxfExport::DxfLayer( mPointLayer ) << QgsDxfExport::DxfLayer( otherPointLayer.get() ) );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setOutputSize( QSize( 640, 480 ) );
+  mapSettings.setExtent( mPointLayer->extent() );
+  mapSettings.setLayers( QList<QgsMapLayer *>() << mPointLayer << otherPointLayer.get() );
+  mapSettings.setOutputDpi( 96 );
+  mapSettings.setDestinationCrs( mPointLayer->crs() );
+
+  d.setMapSettings( mapSettings );
+  d.setSymbologyScale( 1000 );
+  d.setSymbologyExport( QgsDxfExport::SymbolLayerSymbology );
+
+  QString file = getTempFileName( "shared_marker_blocks_dxf" );
+  QFile dxfFile( file );
+  QCOMPARE( d.writeToFile( &dxfFile, QStringLiteral( "CP1252" ) ), QgsDxfExport::ExportResult::Success );
+  dxfFile.close();
+
+  QFile readFile( file );
+  QVERIFY( readFile.open( QIODevice::ReadOnly ) );
+  const QString content = QString::fromLatin1( readFile.readAll() );
+  QVERIFY( content.contains( QStringLiteral( "symbolLayer0" ) ) );
+  QVERIFY( !content.contains( QStringLiteral( "symbolLayer1" ) ) );
+
+  // all the features of both layers are inserted, they are read in background threads
+  QCOMPARE( static_cast< long >( content.count( QStringLiteral( "\nINSERT\n" ) ) ), mPointLayer->featureCount() + otherPointLayer->featureCount() );
+}
+
 void TestQgsDxfExport::testLines()
 {
   QgsDxfExport d;
@@ -47,6 +47,23 @@ static void _parseAndEvalExpr( int arg )
   }
 }
 
+class CacheTestFunction : public QgsScopedExpressionFunction
+{
+  public:
+    CacheTestFunction()
+      : QgsScopedExpressionFunction( QStringLiteral( "cache_test_function" ), 0, QStringLiteral( "test" ) ) {}
+
+    QVariant func( const QVariantList &, const QgsExpressionContext *, QgsExpression *, const QgsExpressionNodeFunction * ) override
+    {
+      return 42;
+    }
+
+    QgsScopedExpressionFunction *clone() const override
+    {
+      return new CacheTestFunction();
+    }
+};
+
 class TestQgsExpression: public QObject
 {
     Q_OBJECT
@@ -1848,6 +1865,125 @@ class TestQgsExpression: public QObject
       QCOMPARE( res.toInt(), 0 );
     }
 
+    void eval_prepared_operators_data()
+    {
+      QTest::addColumn<QString>( "string" );
+      QTest::addColumn<bool>( "evalError" );
+      QTest::addColumn<QVariant>( "result" );
+
+      QTest::newRow( "int plus" ) << "int_f + 1" << false << QVariant( 6LL );
+      QTest::newRow( "int div" ) << "int_f / 2" << false << QVariant( 2.5 );
+      QTest::newRow( "int mod zero" ) << "int_f % 0" << false << QVariant();
+      QTest::newRow( "int intdiv" ) << "int_f // 2" << false << QVariant( 2LL );
+      QTest::newRow( "double mul" ) << "dbl * 2" << false << QVariant( 5.0 );
+      QTest::newRow( "double mod" ) << "dbl % 2" << false << QVariant( 0.5 );
+      QTest::newRow( "null plus" ) << "nul + 1" << false << QVariant();
+      QTest::newRow( "pow" ) << "int_f ^ 2" << false << QVariant( 25.0 );
+      QTest::newRow( "unary minus" ) << "-int_f" << false << QVariant( -5LL );
+      QTest::newRow( "folded" ) << "2 * 3 + int_f" << false << QVariant( 11LL );
+      QTest::newRow( "and" ) << "int_f > 3 AND dbl < 3" << false << QVariant( 1 );
+      QTest::newRow( "or null" ) << "nul > 3 OR int_f = 5" << false << QVariant( 1 );
+      QTest::newRow( "and null" ) << "nul > 3 AND int_f = 5" << false << QVariant();
+      QTest::newRow( "not null" ) << "NOT nul" << false << QVariant();
+      QTest::newRow( "not" ) << "NOT ( int_f <> 5 )" << false << QVariant( 1 );
+      QTest::newRow( "is null" ) << "nul IS NULL" << false << QVariant( 1 );
+      QTest::newRow( "is not" ) << "int_f IS NOT 5.0" << false << QVariant( 0 );
+      QTest::newRow( "string concat" ) << "str + 'd'" << false << QVariant( "abcd" );
+      QTest::newRow( "null string concat" ) << "nstr + 'd'" << false << QVariant( "d" );
+      QTest::newRow( "string compare" ) << "str = 'abc'" << false << QVariant( 1 );
+      QTest::newRow( "string to int" ) << "'3' + int_f" << false << QVariant( 8LL );
+      QTest::newRow( "function operand" ) << "length(str) * 2" << false << QVariant( 6LL );
+      QTest::newRow( "condition operand" ) << "CASE WHEN int_f > 3 THEN dbl ELSE 0 END + 1" << false << QVariant( 3.5 );
+      QTest::newRow( "and shortcut" ) << "int_f > 10 AND to_int(str) = 1" << false << QVariant( 0 );
+      QTest::newRow( "or shortcut" ) << "int_f < 10 OR to_int(str) = 1" << false << QVariant( 1 );
+      QTest::newRow( "error" ) << "int_f < 10 AND to_int(str) = 1" << true << QVariant();
+      QTest::newRow( "date operand" ) << "to_datetime('2020-10-01 00:00:00') + to_interval(int_f || ' days') > to_datetime('2020-10-02 00:00:00')" << false << QVariant( 1 );
+    }
+
+    void eval_prepared_operators()
+    {
+      QFETCH( QString, string );
+      QFETCH( bool, evalError );
+      QFETCH( QVariant, result );
+
+      QgsFields fields;
+      fields.append( QgsField( QStringLiteral( "int_f" ), QVariant::Int ) );
+      fields.append( QgsField( QStringLiteral( "dbl" ), QVariant::Double ) );
+      fields.append( QgsField( QStringLiteral( "str" ), QVariant::String ) );
+      fields.append( QgsField( QStringLiteral( "nul" ), QVariant::Int ) );
+      fields.append( QgsField( QStringLiteral( "nstr" ), QVariant::String ) );
+
+      QgsFeature f( fields );
+      f.setAttributes( QgsAttributes() << 5 << 2.5 << QStringLiteral( "abc" ) << QVariant( QVariant::Int ) << QVariant( QVariant::String ) );
+      f.setValid( true );
+
+      QgsExpressionContext context = QgsExpressionContextUtils::createFeatureBasedContext( f, fields );
+
+      // evaluate twice, the second call reuses the prepared state
+      QgsExpression exp( string );
+      QVERIFY( exp.prepare( &context ) );
+      for ( int i = 0; i < 2; ++i )
+      {
+        const QVariant res = exp.evaluate( &context );
+        QCOMPARE( exp.hasEvalError(), evalError );
+        QCOMPARE( res.type(), result.type() );
+        QCOMPARE( res, result );
+      }
+
+      // without a feature the field references report an error, like the unprepared tree does
+      QgsExpressionContext noFeatureContext;
+      noFeatureContext.setFields( fields );
+      QgsExpression exp2( QStringLiteral( "int_f + 1" ) );
+      QVERIFY( exp2.prepare( &noFeatureContext ) );
+      QVERIFY( !exp2.evaluate( &noFeatureContext ).isValid() );
+      QVERIFY( exp2.hasEvalError() );
+    }
+
+    void parsed_expression_cache()
+    {
+      QgsFields fields;
+      fields.append( QgsField( QStringLiteral( "a" ), QVariant::Int ) );
+      fields.append( QgsField( QStringLiteral( "b" ), QVariant::Int ) );
+      QgsFeature f( fields );
+      f.setAttributes( QgsAttributes() << 1 << 2 );
+      f.setValid( true );
+      QgsExpressionContext context = QgsExpressionContextUtils::createFeatureBasedContext( f, fields );
+
+      // expressions created from the same string are independent from each other
+      QgsExpression exp1( QStringLiteral( "b * 10 + abs(-a)" ) );
+      QVERIFY( exp1.prepare( &context ) );
+      QCOMPARE( exp1.evaluate( &context ).toInt(), 21 );
+
+      QgsFields swapped;
+      swapped.append( fields.at( 1 ) );
+      swapped.append( fields.at( 0 ) );
+      QgsFeature f2( swapped );
+      f2.setAttributes( QgsAttributes() << 2 << 1 );
+      f2.setValid( true );
+      QgsExpressionContext context2 = QgsExpressionContextUtils::createFeatureBasedContext( f2, swapped );
+      QgsExpression exp2( QStringLiteral( "b * 10 + abs(-a)" ) );
+      QCOMPARE( exp2.dump(), exp1.dump() );
+      QVERIFY( exp2.prepare( &context2 ) );
+      QCOMPARE( exp2.evaluate( &context2 ).toInt(), 21 );
+      QCOMPARE( exp1.evaluate( &context ).toInt(), 21 );
+
+      // parser errors are not cached
+      QgsExpression bad( QStringLiteral( "cache_test_function()" ) );
+      QVERIFY( bad.hasParserError() );
+
+      // registering and unregistering functions invalidates cached trees
+      QVERIFY( QgsExpression::registerFunction( new CacheTestFunction(), true ) );
+      QgsExpression good( QStringLiteral( "cache_test_function() + 1" ) );
+      QVERIFY( !good.hasParserError() );
+      QCOMPARE( good.evaluate().toInt(), 43 );
+      QgsExpression good2( QStringLiteral( "cache_test_function() + 1" ) );
+      QCOMPARE( good2.evaluate().toInt(), 43 );
+
+      QVERIFY( QgsExpression::unregisterFunction( QStringLiteral( "cache_test_function" ) ) );
+      QgsExpression bad2( QStringLiteral( "cache_test_function() + 1" ) );
+      QVERIFY( bad2.hasParserError() );
+    }
+
     void eval_feature_id()
     {
       QgsFeature f( 100 );
@@ -1986,6 +2122,31 @@ class TestQgsExpression: public QObject
       }
     }
 
+    void eval_get_feature_indexed()
+    {
+      // after a few lookups within the same context, the features are looked up in an index
+      QgsExpressionContext context;
+      QList< QPair< int, QgsFeatureId > > lookups
+      {
+        { 10, 1 }, { 11, 2 }, { 3, 3 }, { 41, 4 }
+      };
+      for ( int value = 100; value < 110; ++value )
+        lookups << qMakePair( value, static_cast< QgsFeatureId >( -1 ) );
+      // the second pass uses the index
+      const QList< QPair< int, QgsFeatureId > > firstLookups = lookups;
+      lookups << firstLookups;
+      for ( const QPair< int, QgsFeatureId > &lookup : qgis::as_const( lookups ) )
+      {
+        QgsExpression exp( QStringLiteral( "get_feature('test','col1',%1)" ).arg( lookup.first ) );
+        const QVariant res = exp.evaluate( &context );
+        QVERIFY( !exp.hasEvalError() );
+        QCOMPARE( res.canConvert<QgsFeature>(), lookup.second >= 0 );
+        if ( lookup.second >= 0 )
+          QCOMPARE( res.value<QgsFeature>().id(), lookup.second );
+      }
+      QVERIFY( context.cachedValue( QStringLiteral( "getfeature_index:test:col1" ) ).type() == QVariant::Map );
+    }
+
     void test_sqliteFetchAndIncrement()
     {
       QTemporaryDir dir;
@@ -0,0 +1,170 @@
+/***************************************************************************
+     testqgsfeaturebatch.cpp
+     -----------------------
+    Date                 : October 2020
+    Copyright            : (C) 2020 by the QGIS project
+    Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgstest.h"
+#include <QObject>
+
+#include "qgsapplication.h"
+#include "qgsaggregatecalculator.h"
+#include "qgsfeaturebatch.h"
+#include "qgsfeatureiterator.h"
+#include "qgsgeometry.h"
+#include "qgsvectorlayer.h"
+
+class TestQgsFeatureBatch: public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void appendFeature();
+    void memoryLayer();
+    void limit();
+    void editBuffer();
+    void aggregate();
+
+  private:
+    QgsVectorLayer *createLayer( int count );
+};
+
+void TestQgsFeatureBatch::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsFeatureBatch::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+QgsVectorLayer *TestQgsFeatureBatch::createLayer( int count )
+{
+  QgsVectorLayer *layer = new QgsVectorLayer( QStringLiteral( "Point?field=id:integer&field=value:double&field=name:string" ), QStringLiteral( "layer" ), QStringLiteral( "memory" ) );
+  QgsFeatureList features;
+  for ( int i = 0; i < count; ++i )
+  {
+    QgsFeature f( layer->fields() );
+    f.setAttributes( QgsAttributes() << i << ( i % 3 == 0 ? QVariant() : QVariant( i * 0.5 ) ) << QStringLiteral( "name %1" ).arg( i ) );
+    f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( i, i ) ) );
+    features << f;
+  }
+  layer->dataProvider()->addFeatures( features );
+  return layer;
+}
+
+void TestQgsFeatureBatch::appendFeature()
+{
+  QgsFields fields;
+  fields.append( QgsField( QStringLiteral( "id" ), QVariant::Int ) );
+  fields.append( QgsField( QStringLiteral( "value" ), QVariant::Double ) );
+  fields.append( QgsField( QStringLiteral( "name" ), QVariant::String ) );
+
+  QgsFeatureBatch batch( fields, QgsAttributeList() << 2 << 1, true );
+  QCOMPARE( batch.columnCount(), 2 );
+  QCOMPARE( batch.columnForAttribute( 0 ), -1 );
+  QCOMPARE( batch.columnForAttribute( 2 ), 0 );
+  QCOMPARE( batch.columnType( 0 ), QgsFeatureBatch::String );
+  QCOMPARE( batch.columnType( 1 ), QgsFeatureBatch::Double );
+
+  QgsFeature f( fields, 5 );
+  f.setAttributes( QgsAttributes() << 1 << 2.5 << QStringLiteral( "été" ) );
+  f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( 1, 2 ) ) );
+  batch.appendFeature( f );
+  f.setId( 6 );
+  f.setAttributes( QgsAttributes() << 2 << QVariant() << QVariant() );
+  f.clearGeometry();
+  batch.appendFeature( f );
+
+  QCOMPARE( batch.size(), 2 );
+  QCOMPARE( batch.featureIds(), QVector<QgsFeatureId>() << 5 << 6 );
+  QCOMPARE( batch.stringValue( 0, 0 ), QStringLiteral( "été" ) );
+  QVERIFY( batch.isNull( 0, 1 ) );
+  QCOMPARE( batch.doubleValue( 1, 0 ), 2.5 );
+  QVERIFY( batch.isNull( 1, 1 ) );
+  QCOMPARE( batch.value( 1, 0 ), QVariant( 2.5 ) );
+  QVERIFY( batch.value( 1, 1 ).isNull() );
+  QCOMPARE( QgsGeometry::fromWkb( batch.wkb( 0 ) ).asWkt(), QStringLiteral( "Point (1 2)" ) );
+  QVERIFY( batch.wkb( 1 ).isEmpty() );
+
+  batch.clear();
+  QVERIFY( batch.isEmpty() );
+  QCOMPARE( batch.columnCount(), 2 );
+}
+
+void TestQgsFeatureBatch::memoryLayer()
+{
+  std::unique_ptr< QgsVectorLayer > layer( createLayer( 10 ) );
+
+  QgsFeatureBatch batch( layer->fields(), QgsAttributeList() << 0 << 1 );
+  QgsFeatureIterator it = layer->getFeatures();
+  QCOMPARE( it.nextBatch( batch, 4 ), 4 );
+  QCOMPARE( batch.int64Values( 0 ), QVector<qint64>() << 0 << 1 << 2 << 3 );
+  QVERIFY( batch.isNull( 1, 0 ) );
+  QCOMPARE( batch.doubleValue( 1, 1 ), 0.5 );
+  QCOMPARE( it.nextBatch( batch, 4 ), 4 );
+  QCOMPARE( batch.int64Values( 0 ).at( 0 ), 4LL );
+  QCOMPARE( it.nextBatch( batch, 4 ), 2 );
+  QCOMPARE( it.nextBatch( batch, 4 ), 0 );
+  QVERIFY( batch.isEmpty() );
+
+  // filtered requests are honored by the generic path
+  it = layer->getFeatures( QgsFeatureRequest().setFilterExpression( QStringLiteral( "id > 6" ) ) );
+  QCOMPARE( it.nextBatch( batch, 100 ), 3 );
+  QCOMPARE( batch.int64Values( 0 ), QVector<qint64>() << 7 << 8 << 9 );
+}
+
+void TestQgsFeatureBatch::limit()
+{
+  std::unique_ptr< QgsVectorLayer > layer( createLayer( 10 ) );
+
+  QgsFeatureBatch batch( layer->fields() );
+  QgsFeatureIterator it = layer->getFeatures( QgsFeatureRequest().setLimit( 5 ) );
+  QCOMPARE( it.nextBatch( batch, 3 ), 3 );
+  QCOMPARE( it.nextBatch( batch, 3 ), 2 );
+  QCOMPARE( it.nextBatch( batch, 3 ), 0 );
+}
+
+void TestQgsFeatureBatch::editBuffer()
+{
+  std::unique_ptr< QgsVectorLayer > layer( createLayer( 3 ) );
+  layer->startEditing();
+  QgsFeature f( layer->fields() );
+  f.setAttributes( QgsAttributes() << 100 << 1.0 << QStringLiteral( "new" ) );
+  layer->addFeature( f );
+
+  QgsFeatureBatch batch( layer->fields(), QgsAttributeList() << 0 );
+  QgsFeatureIterator it = layer->getFeatures();
+  QCOMPARE( it.nextBatch( batch, 10 ), 4 );
+  QVERIFY( batch.int64Values( 0 ).contains( 100 ) );
+  layer->rollBack();
+}
+
+void TestQgsFeatureBatch::aggregate()
+{
+  std::unique_ptr< QgsVectorLayer > layer( createLayer( 10 ) );
+
+  bool ok = false;
+  QgsAggregateCalculator agg( layer.get() );
+  QCOMPARE( agg.calculate( QgsAggregateCalculator::Sum, QStringLiteral( "id" ), nullptr, &ok ).toDouble(), 45.0 );
+  QVERIFY( ok );
+  // 1, 2, 4, 5, 7, 8 halved
+  QCOMPARE( agg.calculate( QgsAggregateCalculator::Sum, QStringLiteral( "value" ), nullptr, &ok ).toDouble(), 13.5 );
+  QCOMPARE( agg.calculate( QgsAggregateCalculator::CountMissing, QStringLiteral( "value" ), nullptr, &ok ).toInt(), 4 );
+  QCOMPARE( agg.calculate( QgsAggregateCalculator::Max, QStringLiteral( "value * 2" ), nullptr, &ok ).toDouble(), 8.0 );
+}
+
+QGSTEST_MAIN( TestQgsFeatureBatch )
+#include "testqgsfeaturebatch.moc"
@@ -0,0 +1,119 @@
+/***************************************************************************
+     testqgsfeaturemergesorter.cpp
+     -----------------------------
+    Date                 : October 2020
+    Copyright            : (C) 2020 by the QGIS project
+    Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include <QObject>
+#include <QString>
+
+#include <qgsapplication.h>
+#include "qgsexpressioncontextutils.h"
+#include "qgsexpressionsorter.h"
+#include "qgsfeatureiterator.h"
+#include "qgsfeaturemergesorter_p.h"
+#include "qgsgeometry.h"
+#include "qgsvectordataprovider.h"
+#include "qgsvectorlayer.h"
+
+#include <random>
+
+class TestQgsFeatureMergeSorter : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+
+    void initTestCase()
+    {
+      QgsApplication::init();
+      QgsApplication::initQgis();
+    }
+    void cleanupTestCase()
+    {
+      QgsApplication::exitQgis();
+    }
+
+    void testSpilledRuns()
+    {
+      // a small budget spills many runs, the merged order matches an in memory sort
+      QgsVectorLayer layer( QStringLiteral( "Point?field=number:integer&field=name:string&field=value:double" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+      std::mt19937 generator( 42 );
+      std::uniform_int_distribution< int > number( 0, 50 );
+      std::uniform_real_distribution< double > value( -100, 100 );
+      QgsFeatureList features;
+      for ( int i = 0; i < 20000; ++i )
+      {
+        QgsFeature f( layer.fields() );
+        f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( i, -i ) ) );
+        f.setAttribute( 0, i % 7 == 0 ? QVariant( QVariant::Int ) : QVariant( number( generator ) ) );
+        f.setAttribute( 1, QStringLiteral( "name %1" ).arg( number( generator ) ) );
+        f.setAttribute( 2, value( generator ) );
+        features << f;
+      }
+      layer.dataProvider()->addFeatures( features );
+
+      QList<QgsFeatureRequest::OrderByClause> orderBys;
+      orderBys << QgsFeatureRequest::OrderByClause( QStringLiteral( "number" ), false, true )
+               << QgsFeatureRequest::OrderByClause( QStringLiteral( "name" ), true )
+               << QgsFeatureRequest::OrderByClause( QStringLiteral( "value" ), true );
+      QgsExpressionContext context;
+      context << QgsExpressionContextUtils::layerScope( &layer );
+      for ( QgsFeatureRequest::OrderByClause &orderBy : orderBys )
+        orderBy.prepare( &context );
+
+      QgsFeatureMergeSorter sorter( orderBys, 512 * 1024 );
+      QVector< QgsIndexedFeature > expected;
+      QgsFeatureIterator it = layer.getFeatures();
+      QgsFeature f;
+      while ( it.nextFeature( f ) )
+      {
+        QgsIndexedFeature indexed;
+        indexed.mFeature = f;
+        indexed.mIndexes << f.attribute( 0 ) << f.attribute( 1 ) << f.attribute( 2 );
+        sorter.addFeature( f, indexed.mIndexes );
+        expected << indexed;
+      }
+      sorter.finish();
+      QVERIFY( sorter.spilledRunCount() > 1 );
+      std::stable_sort( expected.begin(), expected.end(), QgsExpressionSorter( orderBys ) );
+
+      int count = 0;
+      while ( sorter.nextFeature( f ) )
+      {
+        const QgsFeature &expectedFeature = expected.at( count++ ).mFeature;
+        QCOMPARE( f.attribute( 0 ), expectedFeature.attribute( 0 ) );
+        QCOMPARE( f.attribute( 1 ), expectedFeature.attribute( 1 ) );
+        QCOMPARE( f.attribute( 2 ), expectedFeature.attribute( 2 ) );
+        QCOMPARE( f.fields(), layer.fields() );
+      }
+      QCOMPARE( count, expected.size() );
+
+      // the order by of a request is handled by the iterator when the provider cannot
+      QgsFeatureRequest request;
+      request.setOrderBy( QgsFeatureRequest::OrderBy( orderBys ) );
+      request.setLimit( 100 );
+      it = layer.getFeatures( request );
+      count = 0;
+      while ( it.nextFeature( f ) )
+      {
+        QCOMPARE( f.attributes(), expected.at( count++ ).mFeature.attributes() );
+        QCOMPARE( f.geometry().asWkt(), expected.at( count - 1 ).mFeature.geometry().asWkt() );
+      }
+      QCOMPARE( count, 100 );
+    }
+};
+
+QGSTEST_MAIN( TestQgsFeatureMergeSorter )
+
+#include "testqgsfeaturemergesorter.moc"
@@ -0,0 +1,138 @@
+/***************************************************************************
+     testqgsgdaltilecache.cpp
+     ------------------------
+    Date                 : October 2020
+    Copyright            : (C) 2020 by the QGIS project
+    Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgstest.h"
+#include <QObject>
+#include <QTemporaryDir>
+#include <QThreadPool>
+
+#include <gdal.h>
+
+#include "qgsapplication.h"
+#include "qgsgdaltilecache.h"
+#include "qgsogrutils.h"
+
+class TestQgsGdalTileCache: public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void remoteDatasets();
+    void overviews();
+    void readWindow();
+
+  private:
+    QTemporaryDir mDir;
+    QString mPath;
+};
+
+void TestQgsGdalTileCache::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+
+  // a tiled dataset, whose values depend on the pixel position, with 2 overviews
+  mPath = mDir.filePath( QStringLiteral( "tiles.tif" ) );
+  const char *options[] = { "TILED=YES", "BLOCKXSIZE=256", "BLOCKYSIZE=256", nullptr };
+  gdal::dataset_unique_ptr dataset( GDALCreate( GDALGetDriverByName( "GTiff" ), mPath.toUtf8().constData(), 1000, 700, 1, GDT_Int16, const_cast< char ** >( options ) ) );
+  QVERIFY( dataset );
+  QVector<qint16> values( 1000 * 700 );
+  for ( int i = 0; i < values.size(); ++i )
+    values[ i ] = static_cast< qint16 >( ( i % 1000 ) + ( i / 1000 ) * 3 );
+  QCOMPARE( GDALRasterIO( GDALGetRasterBand( dataset.get(), 1 ), GF_Write, 0, 0, 1000, 700, values.data(), 1000, 700, GDT_Int16, 0, 0 ), CE_None );
+  int levels[] = { 2, 4 };
+  QCOMPARE( GDALBuildOverviews( dataset.get(), "NEAREST", 2, levels, 0, nullptr, nullptr, nullptr ), CE_None );
+}
+
+void TestQgsGdalTileCache::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+void TestQgsGdalTileCache::remoteDatasets()
+{
+  QVERIFY( QgsGdalTileCache::isRemoteDataset( QStringLiteral( "/vsicurl/https://example.com/cog.tif" ) ) );
+  QVERIFY( QgsGdalTileCache::isRemoteDataset( QStringLiteral( "/vsis3/bucket/cog.tif" ) ) );
+  QVERIFY( !QgsGdalTileCache::isRemoteDataset( QStringLiteral( "/data/cog.tif" ) ) );
+  QVERIFY( !QgsGdalTileCache::isRemoteDataset( QStringLiteral( "/vsizip//data/cog.zip/cog.tif" ) ) );
+}
+
+void TestQgsGdalTileCache::overviews()
+{
+  gdal::dataset_unique_ptr dataset( GDALOpen( mPath.toUtf8().constData(), GA_ReadOnly ) );
+  QVERIFY( dataset );
+  GDALRasterBandH band = GDALGetRasterBand( dataset.get(), 1 );
+
+  QCOMPARE( QgsGdalTileCache::overviewForDownsampling( band, 1 ), 0 );
+  QCOMPARE( QgsGdalTileCache::overviewForDownsampling( band, 1.9 ), 0 );
+  QCOMPARE( QgsGdalTileCache::overviewForDownsampling( band, 3 ), 1 );
+  QCOMPARE( QgsGdalTileCache::overviewForDownsampling( band, 10 ), 2 );
+  QCOMPARE( GDALGetRasterBandXSize( QgsGdalTileCache::overviewBand( band, 1 ) ), 500 );
+  QCOMPARE( QgsGdalTileCache::tileSize( band ), QSize( 256, 256 ) );
+}
+
+void TestQgsGdalTileCache::readWindow()
+{
+  gdal::dataset_unique_ptr dataset( GDALOpen( mPath.toUtf8().constData(), GA_ReadOnly ) );
+  QVERIFY( dataset );
+  GDALRasterBandH band = GDALGetRasterBand( dataset.get(), 1 );
+
+  QgsGdalTileCache *cache = QgsGdalTileCache::instance();
+  cache->clear();
+
+  // a window across 2 x 2 tiles, including clipped ones at the right
+  QVector<qint16> window( 300 * 100 );
+  QVERIFY( cache->readWindow( mPath, 1, 0, band, 700, 200, 300, 100, GDT_Int16, window.data() ) );
+  for ( int row = 0; row < 100; ++row )
+  {
+    for ( int column = 0; column < 300; ++column )
+      QCOMPARE( window.at( row * 300 + column ), static_cast< qint16 >( 700 + column + ( 200 + row ) * 3 ) );
+  }
+  QVERIFY( cache->contains( { mPath, 1, 0, 3, 1 } ) );
+  QVERIFY( !cache->contains( { mPath, 1, 1, 3, 1 } ) );
+
+  // the surrounding tiles are prefetched
+  QThreadPool::globalInstance()->waitForDone();
+  QVERIFY( cache->contains( { mPath, 1, 0, 2, 0 } ) );
+  QVERIFY( cache->contains( { mPath, 1, 0, 3, 2 } ) );
+  QCOMPARE( cache->tileCount(), 9 );
+
+  // the tiles are then taken from the cache
+  window.fill( 0 );
+  QVERIFY( cache->readWindow( mPath, 1, 0, band, 720, 250, 200, 50, GDT_Int16, window.data() ) );
+  QCOMPARE( window.at( 0 ), static_cast< qint16 >( 720 + 250 * 3 ) );
+  QCOMPARE( window.at( 49 * 200 + 199 ), static_cast< qint16 >( 919 + 299 * 3 ) );
+
+  // overviews
+  GDALRasterBandH overview = QgsGdalTileCache::overviewBand( band, 1 );
+  QVector<qint16> expected( 100 * 100 );
+  QCOMPARE( GDALRasterIO( overview, GF_Read, 200, 100, 100, 100, expected.data(), 100, 100, GDT_Int16, 0, 0 ), CE_None );
+  QVector<qint16> overviewWindow( 100 * 100 );
+  QVERIFY( cache->readWindow( mPath, 1, 1, overview, 200, 100, 100, 100, GDT_Int16, overviewWindow.data() ) );
+  QCOMPARE( overviewWindow, expected );
+  QThreadPool::globalInstance()->waitForDone();
+
+  // tiles are evicted beyond the budget
+  const int maximumCost = cache->maximumCost();
+  cache->setMaximumCost( 256 * 256 * 2 * 2 );
+  QVERIFY( cache->tileCount() <= 2 );
+  cache->setMaximumCost( maximumCost );
+  cache->clear();
+  QCOMPARE( cache->tileCount(), 0 );
+}
+
+QGSTEST_MAIN( TestQgsGdalTileCache )
+#include "testqgsgdaltilecache.moc"
@@ -24,9 +24,11 @@
 #include <QDir>
 #include <QDesktopServices>
 #include <QVector>
+#include <QThreadPool>
 #include <QPointF>
 #include <QImage>
 #include <QPainter>
+#include <QtConcurrent>
 
 //qgis includes...
 #include <qgsapplication.h>
@@ -53,6 +55,10 @@
 #include "qgsproject.h"
 #include "qgslinesegment.h"
 #include "qgsgeos.h"
+#include "qgsgeometryvalidator.h"
+#include "qgsfeedback.h"
+#include "qgsvectordataprovider.h"
+#include "qgsvectorlayer.h"
 
 //qgs unit test utility class
 #include "qgsrenderchecker.h"
@@ -147,6 +153,7 @@ class TestQgsGeometry : public QObject
     void poleOfInaccessibility();
 
     void makeValid();
+    void geosContextPerThread();
 
     void isSimple();
 
@@ -166,6 +173,9 @@ class TestQgsGeometry : public QObject
 
     void wktParser();
 
+    void cachedGeos();
+    void validateGeometries();
+
   private:
     //! Must be called before each render test
     void initPainterTest();
@@ -17332,6 +17342,35 @@ void TestQgsGeometry::wkbInOut()
   badHeader.fromWkb( wkb, size );
   QVERIFY( badHeader.isNull() );
   QCOMPARE( badHeader.wkbType(), QgsWkbTypes::Unknown );
+
+  // point count exceeding the WKB size, rejected before allocating the points
+  const char *hugeCountHexwkb = "0102000000FFFFFF7F000000000000F03F000000000000F03F";
+  wkb = hex2bytes( hugeCountHexwkb, &size );
+  QgsGeometry hugeCount;
+  hugeCount.fromWkb( wkb, size );
+  QVERIFY( hugeCount.isNull() );
+
+  // big endian line string with z and m values
+  const char *bigEndianHexwkb = "0000000BBA000000023FF0000000000000400000000000000040080000000000004010000000000000"
+                                "4014000000000000401800000000000040"
+                                "1C0000000000004020000000000000";
+  wkb = hex2bytes( bigEndianHexwkb, &size );
+  QgsGeometry bigEndian;
+  bigEndian.fromWkb( wkb, size );
+  QCOMPARE( bigEndian.asWkt(), QStringLiteral( "LineStringZM (1 2 3 4, 5 6 7 8)" ) );
+
+  // round trips through the bulk point reads
+  const QStringList wkts = QStringList() << QStringLiteral( "LineString (1 2, 3 4, 5 6)" )
+                           << QStringLiteral( "LineStringZ (1 2 3, 4 5 6)" )
+                           << QStringLiteral( "LineStringM (1 2 3, 4 5 6)" )
+                           << QStringLiteral( "PolygonZM ((0 0 1 2, 1 0 3 4, 1 1 5 6, 0 0 1 2))" )
+                           << QStringLiteral( "CircularStringZ (0 0 1, 1 1 2, 2 0 3)" );
+  for ( const QString &inputWkt : wkts )
+  {
+    QgsGeometry roundTrip;
+    roundTrip.fromWkb( QgsGeometry::fromWkt( inputWkt ).asWkb() );
+    QCOMPARE( roundTrip.asWkt(), inputWkt );
+  }
 }
 
 void TestQgsGeometry::directionNeutralSegmentation()
@@ -17524,6 +17563,50 @@ void TestQgsGeometry::makeValid()
   }
 }
 
+void TestQgsGeometry::geosContextPerThread()
+{
+  const GEOSContextHandle_t mainContext = QgsGeos::getGEOSHandler();
+  QVERIFY( mainContext );
+  // same context for all the calls from a thread
+  QCOMPARE( QgsGeos::getGEOSHandler(), mainContext );
+
+  const QgsGeometry polygon = QgsGeometry::fromWkt( QStringLiteral( "Polygon ((0 0, 10 0, 10 10, 0 10, 0 0))" ) );
+  const QgsGeometry clip = QgsGeometry::fromRect( QgsRectangle( 5, 5, 20, 20 ) );
+  const QgsGeometry expectedBuffer = polygon.buffer( 1, 8 );
+  const QgsGeometry expectedIntersection = expectedBuffer.intersection( clip );
+
+  // smash GEOS over many threads, each operation must give the result of the main thread
+  QVector< int > list;
+  list.resize( 1000 );
+  QAtomicInt failures = 0;
+  QMutex mutex;
+  QHash< QThread *, GEOSContextHandle_t > contexts;
+  QtConcurrent::blockingMap( list, [&]( int & )
+  {
+    const GEOSContextHandle_t context = QgsGeos::getGEOSHandler();
+    if ( !context || QgsGeos::getGEOSHandler() != context )
+      failures.ref();
+    {
+      QMutexLocker locker( &mutex );
+      contexts.insert( QThread::currentThread(), context );
+    }
+
+    const QgsGeometry buffer = polygon.buffer( 1, 8 );
+    const QgsGeometry intersection = buffer.intersection( clip );
+    if ( !buffer.isGeosEqual( expectedBuffer ) || !intersection.isGeosEqual( expectedIntersection ) )
+      failures.ref();
+  } );
+  QCOMPARE( static_cast< int >( failures ), 0 );
+
+  // one context per thread
+  const QList< GEOSContextHandle_t > threadContexts = contexts.values();
+  QCOMPARE( qgis::listToSet( threadContexts ).size(), threadContexts.size() );
+  if ( contexts.contains( QThread::currentThread() ) )
+    QCOMPARE( contexts.value( QThread::currentThread() ), mainContext );
+  else
+    QVERIFY( !threadContexts.contains( mainContext ) );
+}
+
 void TestQgsGeometry::isSimple()
 {
   typedef QPair<QString, bool> InputWktAndExpectedResult;
@@ -18360,5 +18443,111 @@ void TestQgsGeometry::wktParser()
   QVERIFY( mline.fromWkt( "MultiLineString EMPTY" ) );
   QCOMPARE( mline.asWkt(), QStringLiteral( "MultiLineString EMPTY" ) );
 }
+
+void TestQgsGeometry::cachedGeos()
+{
+  // the GEOS engine of a geometry is cached from its second use, it must follow its modifications
+  QgsGeometry polygon = QgsGeometry::fromWkt( QStringLiteral( "Polygon ((0 0, 10 0, 10 10, 0 10, 0 0))" ) );
+  const QgsGeometry inside = QgsGeometry::fromWkt( QStringLiteral( "Point (5 5)" ) );
+  const QgsGeometry outside = QgsGeometry::fromWkt( QStringLiteral( "Point (15 5)" ) );
+  for ( int i = 0; i < 3; ++i )
+  {
+    QVERIFY( polygon.intersects( inside ) );
+    QVERIFY( !polygon.intersects( outside ) );
+    QVERIFY( polygon.contains( inside ) );
+  }
+  QCOMPARE( polygon.centroid().asWkt(), QStringLiteral( "Point (5 5)" ) );
+
+  // a shared copy uses the same cache, until one of them is modified
+  QgsGeometry copy = polygon;
+  QVERIFY( copy.contains( inside ) );
+  QCOMPARE( copy.translate( 10, 0 ), QgsGeometry::Success );
+  QVERIFY( !copy.contains( inside ) );
+  QVERIFY( copy.contains( outside ) );
+  QVERIFY( polygon.contains( inside ) );
+  QVERIFY( !polygon.contains( outside ) );
+
+  // modified in place, as the only reference to the geometry
+  QCOMPARE( polygon.translate( 10, 0 ), QgsGeometry::Success );
+  QVERIFY( !polygon.intersects( inside ) );
+  QVERIFY( polygon.intersects( outside ) );
+  QCOMPARE( polygon.centroid().asWkt(), QStringLiteral( "Point (15 5)" ) );
+
+  // modified through a pointer, at any time
+  QgsAbstractGeometry *geometry = polygon.get();
+  QVERIFY( polygon.intersects( outside ) );
+  QVERIFY( polygon.intersects( outside ) );
+  geometry->transform( QTransform::fromTranslate( -10, 0 ) );
+  QVERIFY( polygon.intersects( inside ) );
+  QVERIFY( !polygon.intersects( outside ) );
+
+  // replaced
+  polygon.set( new QgsPoint( 15, 5 ) );
+  QVERIFY( polygon.intersects( outside ) );
+  QVERIFY( polygon.intersects( outside ) );
+  QVERIFY( !polygon.intersects( inside ) );
+}
+
+void TestQgsGeometry::validateGeometries()
+{
+  // enough features for several batches on several threads
+  const int maxThreads = QThreadPool::globalInstance()->maxThreadCount();
+  QThreadPool::globalInstance()->setMaxThreadCount( 4 );
+
+  QgsVectorLayer layer( QStringLiteral( "Polygon" ), QStringLiteral( "polygons" ), QStringLiteral( "memory" ) );
+  QgsFeatureList features;
+  QList< QgsFeatureId > invalidIds;
+  for ( int i = 0; i < 10000; ++i )
+  {
+    QgsFeature feature;
+    if ( i % 7 == 3 )
+    {
+      // self intersecting bow tie
+      feature.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "Polygon ((%1 0, %2 1, %2 0, %1 1, %1 0))" ).arg( i ).arg( i + 1 ) ) );
+      invalidIds << i + 1;
+    }
+    else if ( i % 7 != 5 )
+    {
+      feature.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "Polygon ((%1 0, %2 0, %2 1, %1 1, %1 0))" ).arg( i ).arg( i + 1 ) ) );
+    }
+    features << feature;
+  }
+  QVERIFY( layer.dataProvider()->addFeatures( features ) );
+
+  for ( QgsGeometry::ValidationMethod method : { QgsGeometry::ValidatorGeos, QgsGeometry::ValidatorQgisInternal } )
+  {
+    QList< QgsFeatureId > ids;
+    QgsFeatureIterator it = layer.getFeatures();
+    const long count = QgsGeometryValidator::validateGeometries( it, [&ids]( const QgsFeature & feature, const QVector<QgsGeometry::Error> &errors )
+    {
+      QVERIFY( !errors.isEmpty() );
+      ids << feature.id();
+    }, method );
+    QCOMPARE( count, static_cast< long >( invalidIds.size() ) );
+    QCOMPARE( ids, invalidIds );
+  }
+
+  QList< QgsFeatureId > ids;
+  QgsFeatureIterator it = layer.getFeatures();
+  const long count = QgsGeometryValidator::makeValidGeometries( it, [&ids]( const QgsFeature & feature )
+  {
+    ids << feature.id();
+    if ( feature.hasGeometry() )
+      QVERIFY( feature.geometry().isGeosValid() );
+  } );
+  QCOMPARE( count, static_cast< long >( invalidIds.size() ) );
+  QCOMPARE( ids.size(), 10000 );
+  QCOMPARE( ids.first(), static_cast< QgsFeatureId >( 1 ) );
+  QCOMPARE( ids.last(), static_cast< QgsFeatureId >( 10000 ) );
+
+  // canceled
+  QgsFeedback feedback;
+  feedback.cancel();
+  it = layer.getFeatures();
+  QCOMPARE( QgsGeometryValidator::makeValidGeometries( it, []( const QgsFeature & ) {}, &feedback ), 0L );
+
+  QThreadPool::globalInstance()->setMaxThreadCount( maxThreads );
+}
+
 QGSTEST_MAIN( TestQgsGeometry )
 #include "testqgsgeometry.moc"
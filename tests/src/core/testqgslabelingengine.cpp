@@ -19,6 +19,8 @@
 #include <qgslabelingengine.h>
 #include <qgsproject.h>
 #include <qgsmaprenderersequentialjob.h>
+#include <qgsmaprenderercache.h>
+#include "qgslabelplacements.h"
 #include <qgsreadwritecontext.h>
 #include <qgsrulebasedlabeling.h>
 #include <qgsvectorlayer.h>
@@ -71,6 +73,7 @@ class TestQgsLabelingEngine : public QObject
     void testLabelRotationWithReprojection();
     void drawUnplaced();
     void labelingResults();
+    void keepPlacementsWhilePanning();
     void pointsetExtend();
     void curvedOverrun();
     void parallelOverrun();
@@ -1944,6 +1947,83 @@ void TestQgsLabelingEngine::labelingResults()
   QCOMPARE( labels.count(), 0 );
 }
 
+void TestQgsLabelingEngine::keepPlacementsWhilePanning()
+{
+  QgsPalLayerSettings settings;
+  setDefaultLabelParams( settings );
+  settings.fieldName = QStringLiteral( "\"id\"" );
+  settings.isExpression = true;
+  settings.placement = QgsPalLayerSettings::AroundPoint;
+
+  std::unique_ptr< QgsVectorLayer> vl2( new QgsVectorLayer( QStringLiteral( "Point?crs=epsg:3857&field=id:integer" ), QStringLiteral( "vl" ), QStringLiteral( "memory" ) ) );
+  vl2->setRenderer( new QgsNullSymbolRenderer() );
+
+  QgsFeature f;
+  f.setAttributes( QgsAttributes() << 1 );
+  f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( 0, 0 ) ) );
+  QVERIFY( vl2->dataProvider()->addFeature( f ) );
+  f.setAttributes( QgsAttributes() << 2 );
+  f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( 10, 0 ) ) );
+  QVERIFY( vl2->dataProvider()->addFeature( f ) );
+  vl2->updateExtents();
+
+  vl2->setLabeling( new QgsVectorLayerSimpleLabeling( settings ) );  // TODO: this should not be necessary!
+  vl2->setLabelsEnabled( true );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setLabelingEngineSettings( createLabelEngineSettings() );
+  mapSettings.setDestinationCrs( vl2->crs() );
+  mapSettings.setOutputSize( QSize( 640, 480 ) );
+  mapSettings.setExtent( QgsRectangle( -320, -240, 320, 240 ) );
+  mapSettings.setLayers( QList<QgsMapLayer *>() << vl2.get() );
+  mapSettings.setOutputDpi( 96 );
+
+  QgsMapRendererCache cache;
+
+  QgsMapRendererSequentialJob job( mapSettings );
+  job.setCache( &cache );
+  job.start();
+  job.waitForFinished();
+  std::unique_ptr< QgsLabelingResults > results( job.takeLabelingResults() );
+  QList<QgsLabelPosition> labels = results->labelsWithinRect( QgsRectangle( -1000, -1000, 1000, 1000 ) );
+  QCOMPARE( labels.count(), 2 );
+
+  // the placements are kept by the cache, for maps with the same scale
+  QVERIFY( cache.labelPlacements() );
+  QVERIFY( !cache.labelPlacements()->isEmpty() );
+  QVERIFY( cache.labelPlacements()->isCompatibleWith( mapSettings ) );
+  QgsMapSettings zoomedSettings = mapSettings;
+  zoomedSettings.setExtent( QgsRectangle( -160, -120, 160, 120 ) );
+  QVERIFY( !cache.labelPlacements()->isCompatibleWith( zoomedSettings ) );
+
+  // pan, the labels of the features which remain visible do not move
+  QgsMapSettings pannedSettings = mapSettings;
+  pannedSettings.setExtent( QgsRectangle( -300, -250, 340, 230 ) );
+  QVERIFY( cache.labelPlacements()->isCompatibleWith( pannedSettings ) );
+
+  QgsMapRendererSequentialJob pannedJob( pannedSettings );
+  pannedJob.setCache( &cache );
+  pannedJob.start();
+  pannedJob.waitForFinished();
+  results.reset( pannedJob.takeLabelingResults() );
+  QList<QgsLabelPosition> pannedLabels = results->labelsWithinRect( QgsRectangle( -1000, -1000, 1000, 1000 ) );
+  QCOMPARE( pannedLabels.count(), 2 );
+
+  for ( const QgsLabelPosition &label : qgis::as_const( labels ) )
+  {
+    bool found = false;
+    for ( const QgsLabelPosition &pannedLabel : qgis::as_const( pannedLabels ) )
+    {
+      if ( pannedLabel.featureId != label.featureId )
+        continue;
+      found = true;
+      QGSCOMPARENEAR( pannedLabel.labelRect.xMinimum(), label.labelRect.xMinimum(), 0.01 );
+      QGSCOMPARENEAR( pannedLabel.labelRect.yMinimum(), label.labelRect.yMinimum(), 0.01 );
+    }
+    QVERIFY( found );
+  }
+}
+
 void TestQgsLabelingEngine::pointsetExtend()
 {
   // test extending pointsets by distance
@@ -25,6 +25,9 @@
 #include "qgslayoutitemmap.h"
 #include "qgsvectorlayer.h"
 #include "qgslayoutitemlegend.h"
+#include "qgslayoutatlas.h"
+#include "qgsprintlayout.h"
+#include <QTemporaryDir>
 
 class TestQgsLayoutExporter: public QObject
 {
@@ -36,6 +39,9 @@ class TestQgsLayoutExporter: public QObject
     void init();// will be called before each testfunction is executed.
     void cleanup();// will be called after every testfunction.
     void testHandleLayeredExport();
+    void testAtlasImageExport();
+    void testTiffBandExport();
+    void testParallelMapsImageExport();
 
 };
 
@@ -258,5 +264,135 @@ void TestQgsLayoutExporter::testHandleLayeredExport()
   qDeleteAll( items );
 }
 
+void TestQgsLayoutExporter::testAtlasImageExport()
+{
+  QgsProject p;
+  QgsVectorLayer *linesLayer = new QgsVectorLayer( TEST_DATA_DIR + QStringLiteral( "/lines.shp" ),
+      QStringLiteral( "lines" ), QStringLiteral( "ogr" ) );
+  QVERIFY( linesLayer->isValid() );
+  p.addMapLayer( linesLayer );
+
+  QgsPrintLayout l( &p );
+  l.initializeDefaults();
+  QgsLayoutItemMap *map = new QgsLayoutItemMap( &l );
+  map->attemptSetSceneRect( QRectF( 20, 20, 200, 100 ) );
+  map->setCrs( linesLayer->crs() );
+  map->setLayers( QList<QgsMapLayer *>() << linesLayer );
+  map->setAtlasDriven( true );
+  l.addLayoutItem( map );
+
+  QgsLayoutAtlas *atlas = l.atlas();
+  atlas->setCoverageLayer( linesLayer );
+  atlas->setEnabled( true );
+  QString error;
+  QVERIFY( atlas->setFilenameExpression( QStringLiteral( "'page_' || @atlas_featurenumber" ), error ) );
+
+  QgsLayoutExporter::ImageExportSettings settings;
+  settings.dpi = 10;
+
+  // the pages are written in background threads, all of them must exist once the export returns
+  QTemporaryDir dir;
+  QCOMPARE( QgsLayoutExporter::exportToImage( atlas, dir.path() + QStringLiteral( "/atlas.png" ), QStringLiteral( "png" ), settings, error ), QgsLayoutExporter::Success );
+  const long featureCount = linesLayer->featureCount();
+  QVERIFY( featureCount > 1 );
+  for ( long i = 1; i <= featureCount; ++i )
+  {
+    const QImage page( dir.filePath( QStringLiteral( "page_%1.png" ).arg( i ) ) );
+    QVERIFY( !page.isNull() );
+  }
+
+  // a failed write is reported
+  QCOMPARE( QgsLayoutExporter::exportToImage( atlas, dir.path() + QStringLiteral( "/missing/atlas.png" ), QStringLiteral( "png" ), settings, error ), QgsLayoutExporter::FileError );
+  QVERIFY( !error.isEmpty() );
+}
+
+void TestQgsLayoutExporter::testTiffBandExport()
+{
+  QgsProject p;
+  QgsLayout l( &p );
+  l.initializeDefaults();
+  QgsLayoutItemShape *shape = new QgsLayoutItemShape( &l );
+  shape->attemptSetSceneRect( QRectF( 30, 40, 150, 100 ) );
+  l.addLayoutItem( shape );
+
+  QgsLayoutExporter exporter( &l );
+  QgsLayoutExporter::ImageExportSettings settings;
+  settings.dpi = 20;
+  settings.exportMetadata = false;
+
+  QTemporaryDir dir;
+  QCOMPARE( exporter.exportToImage( dir.filePath( QStringLiteral( "full.tif" ) ), settings ), QgsLayoutExporter::Success );
+  // bands which do not divide the image height
+  settings.tiffBandHeight = 7;
+  QCOMPARE( exporter.exportToImage( dir.filePath( QStringLiteral( "bands.tif" ) ), settings ), QgsLayoutExporter::Success );
+
+  const QImage full = QImage( dir.filePath( QStringLiteral( "full.tif" ) ) ).convertToFormat( QImage::Format_ARGB32 );
+  const QImage bands = QImage( dir.filePath( QStringLiteral( "bands.tif" ) ) ).convertToFormat( QImage::Format_ARGB32 );
+  QVERIFY( !full.isNull() );
+  QCOMPARE( bands.size(), full.size() );
+
+  // only the antialiased pixels along the band edges may differ
+  int differences = 0;
+  for ( int y = 0; y < full.height(); ++y )
+  {
+    for ( int x = 0; x < full.width(); ++x )
+    {
+      if ( full.pixel( x, y ) != bands.pixel( x, y ) )
+        differences++;
+    }
+  }
+  QVERIFY( differences < full.width() * full.height() / 100 );
+}
+
+void TestQgsLayoutExporter::testParallelMapsImageExport()
+{
+  QgsProject p;
+  QgsVectorLayer *linesLayer = new QgsVectorLayer( TEST_DATA_DIR + QStringLiteral( "/lines.shp" ),
+      QStringLiteral( "lines" ), QStringLiteral( "ogr" ) );
+  QVERIFY( linesLayer->isValid() );
+  p.addMapLayer( linesLayer );
+
+  QgsLayout l( &p );
+  l.initializeDefaults();
+  for ( int i = 0; i < 3; ++i )
+  {
+    QgsLayoutItemMap *map = new QgsLayoutItemMap( &l );
+    map->attemptSetSceneRect( QRectF( 20, 20 + 60 * i, 150, 50 ) );
+    map->setFrameEnabled( true );
+    map->setCrs( linesLayer->crs() );
+    map->setLayers( QList<QgsMapLayer *>() << linesLayer );
+    map->zoomToExtent( linesLayer->extent() );
+    l.addLayoutItem( map );
+  }
+
+  QgsLayoutExporter exporter( &l );
+  QgsLayoutExporter::ImageExportSettings settings;
+  settings.dpi = 40;
+  settings.exportMetadata = false;
+
+  QTemporaryDir dir;
+  QCOMPARE( exporter.exportToImage( dir.filePath( QStringLiteral( "sequential.png" ) ), settings ), QgsLayoutExporter::Success );
+  // the maps are rendered ahead of the export, and drawn from the rendered images
+  settings.flags |= QgsLayoutRenderContext::FlagRenderMapsInParallel;
+  QCOMPARE( exporter.exportToImage( dir.filePath( QStringLiteral( "parallel.png" ) ), settings ), QgsLayoutExporter::Success );
+
+  const QImage sequential = QImage( dir.filePath( QStringLiteral( "sequential.png" ) ) ).convertToFormat( QImage::Format_ARGB32 );
+  const QImage parallel = QImage( dir.filePath( QStringLiteral( "parallel.png" ) ) ).convertToFormat( QImage::Format_ARGB32 );
+  QVERIFY( !sequential.isNull() );
+  QCOMPARE( parallel.size(), sequential.size() );
+
+  // the layer images are composed onto the page instead of drawn on it, only antialiased pixels may differ
+  int differences = 0;
+  for ( int y = 0; y < sequential.height(); ++y )
+  {
+    for ( int x = 0; x < sequential.width(); ++x )
+    {
+      if ( sequential.pixel( x, y ) != parallel.pixel( x, y ) )
+        differences++;
+    }
+  }
+  QVERIFY( differences < sequential.width() * sequential.height() / 100 );
+}
+
 QGSTEST_MAIN( TestQgsLayoutExporter )
 #include "testqgslayoutexporter.moc"
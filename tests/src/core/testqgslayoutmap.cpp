@@ -37,6 +37,10 @@
 #include "qgsfontutils.h"
 #include "qgsannotationlayer.h"
 #include "qgsannotationmarkeritem.h"
+#include "qgsmaprenderercache.h"
+#include "qgssinglesymbolrenderer.h"
+#include "qgsmarkersymbollayer.h"
+#include "qgslayoutreportcontext.h"
 
 #include <QObject>
 #include "qgstest.h"
@@ -75,6 +79,7 @@ class TestQgsLayoutMap : public QObject
     void testLayeredExport();
     void testLayeredExportLabelsByLayer();
     void testTemporal();
+    void atlasRenderCache();
 
   private:
     QgsRasterLayer *mRasterLayer = nullptr;
@@ -1948,5 +1953,86 @@ void TestQgsLayoutMap::testTemporal()
   QCOMPARE( renderContext.temporalRange(), QgsDateTimeRange( begin, end ) );
 }
 
+void TestQgsLayoutMap::atlasRenderCache()
+{
+  QgsProject p;
+  QgsVectorLayer *coverage = new QgsVectorLayer( QStringLiteral( "Point?crs=epsg:4326" ), QStringLiteral( "coverage" ), QStringLiteral( "memory" ) );
+  QgsFeature coverageFeature;
+  coverageFeature.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( 1, 1 ) ) );
+  coverage->dataProvider()->addFeatures( QgsFeatureList() << coverageFeature );
+
+  auto pointsLayer = [ = ]( const QString & name, const QString & colorExpression ) -> QgsVectorLayer *
+  {
+    QgsVectorLayer *layer = new QgsVectorLayer( QStringLiteral( "Point?crs=epsg:4326&field=atlas_color:string" ), name, QStringLiteral( "memory" ) );
+    QgsMarkerSymbol *symbol = QgsMarkerSymbol::createSimple( QgsStringMap() );
+    symbol->symbolLayer( 0 )->setDataDefinedProperty( QgsSymbolLayer::PropertyFillColor, QgsProperty::fromExpression( colorExpression ) );
+    layer->setRenderer( new QgsSingleSymbolRenderer( symbol ) );
+    return layer;
+  };
+  // the field is named after the atlas, but the style does not refer to the atlas variables
+  QgsVectorLayer *staticLayer = pointsLayer( QStringLiteral( "atlas_static" ), QStringLiteral( "coalesce(\"atlas_color\", 'red')" ) );
+  QgsVectorLayer *atlasLayer = pointsLayer( QStringLiteral( "atlas" ), QStringLiteral( "if(@atlas_featureid = 1, 'red', 'blue')" ) );
+  // the name of the variable is only known when the expression is evaluated
+  QgsVectorLayer *unknownVariableLayer = pointsLayer( QStringLiteral( "unknown" ), QStringLiteral( "var('atlas_' || 'featureid')" ) );
+  p.addMapLayers( QList<QgsMapLayer *>() << coverage << staticLayer << atlasLayer << unknownVariableLayer );
+
+  QgsLayout l( &p );
+  QgsLayoutItemMap *map = new QgsLayoutItemMap( &l );
+  map->attemptSetSceneRect( QRectF( 20, 20, 200, 100 ) );
+  map->setExtent( QgsRectangle( 0, 0, 10, 10 ) );
+  l.addLayoutItem( map );
+
+  const QList<QgsMapLayer *> layers = QList<QgsMapLayer *>() << coverage << staticLayer << atlasLayer << unknownVariableLayer;
+  QgsMapSettings settings = map->mapSettings( map->extent(), QSize( 200, 100 ), 96, false );
+  settings.setLayers( layers );
+  QImage image( 200, 100, QImage::Format_ARGB32_Premultiplied );
+  QPainter painter( &image );
+
+  // not an atlas render
+  QVERIFY( !map->atlasRenderCache( settings, &painter ) );
+
+  l.reportContext().setLayer( coverage );
+  l.reportContext().setFeature( coverage->getFeature( 1 ) );
+  QgsMapRendererCache *cache = map->atlasRenderCache( settings, &painter );
+  QVERIFY( cache );
+
+  auto fillCache = [ = ]
+  {
+    for ( QgsMapLayer *layer : layers )
+      cache->setCacheImage( layer->id(), image );
+  };
+  fillCache();
+
+  // the images of the layers depending on the atlas feature are dropped for the next page
+  QCOMPARE( map->atlasRenderCache( settings, &painter ), cache );
+  QVERIFY( cache->hasCacheImage( staticLayer->id() ) );
+  QVERIFY( !cache->hasCacheImage( coverage->id() ) );
+  QVERIFY( !cache->hasCacheImage( atlasLayer->id() ) );
+  QVERIFY( !cache->hasCacheImage( unknownVariableLayer->id() ) );
+
+  // the layers are only checked again after a change of their style
+  fillCache();
+  QgsMarkerSymbol *symbol = QgsMarkerSymbol::createSimple( QgsStringMap() );
+  symbol->symbolLayer( 0 )->setDataDefinedProperty( QgsSymbolLayer::PropertySize, QgsProperty::fromExpression( QStringLiteral( "@atlas_pagename" ) ) );
+  staticLayer->setRenderer( new QgsSingleSymbolRenderer( symbol ) );
+  atlasLayer->setRenderer( new QgsSingleSymbolRenderer( QgsMarkerSymbol::createSimple( QgsStringMap() ) ) );
+  map->atlasRenderCache( settings, &painter );
+  QVERIFY( !cache->hasCacheImage( staticLayer->id() ) );
+  fillCache();
+  map->atlasRenderCache( settings, &painter );
+  QVERIFY( !cache->hasCacheImage( staticLayer->id() ) );
+  QVERIFY( cache->hasCacheImage( atlasLayer->id() ) );
+
+  // the layers with a style override are rendered again
+  QMap<QString, QString> overrides;
+  overrides.insert( atlasLayer->id(), QString() );
+  settings.setLayerStyleOverrides( overrides );
+  cache = map->atlasRenderCache( settings, &painter );
+  fillCache();
+  map->atlasRenderCache( settings, &painter );
+  QVERIFY( !cache->hasCacheImage( atlasLayer->id() ) );
+  painter.end();
+}
+
 QGSTEST_MAIN( TestQgsLayoutMap )
 #include "testqgslayoutmap.moc"
@@ -29,6 +29,7 @@
 #include "qgslayertreemodel.h"
 #include "qgslayertreemodellegendnode.h"
 #include "qgslinesymbollayer.h"
+#include "qgsmaphittest.h"
 #include "qgsmaplayerlegend.h"
 #include "qgspainteffect.h"
 #include "qgsproject.h"
@@ -159,6 +160,8 @@ class TestQgsLegendRenderer : public QObject
     void testThreeColumns();
     void testFilterByMap();
     void testFilterByMapSameSymbol();
+    void testFilterByMapKeepsUnchangedLegends();
+    void testMapHitTestLayers();
     void testColumns_data();
     void testColumns();
     void testColumnBreaks();
@@ -819,6 +822,65 @@ void TestQgsLegendRenderer::testFilterByMap()
   QVERIFY( _verifyImage( testName, mReport ) );
 }
 
+void TestQgsLegendRenderer::testFilterByMapKeepsUnchangedLegends()
+{
+  QgsLayerTreeModel legendModel( mRoot );
+  QgsLayerTreeLayer *nodeLayer = mRoot->findLayer( mVL3 );
+
+  QgsMapSettings mapSettings;
+  // extent and size to include only the red and green points
+  mapSettings.setExtent( QgsRectangle( 0, 0, 10.0, 4.0 ) );
+  mapSettings.setOutputSize( QSize( 400, 100 ) );
+  mapSettings.setOutputDpi( 96 );
+  mapSettings.setLayers( QgsProject::instance()->mapLayers().values() );
+
+  legendModel.setLegendFilterByMap( &mapSettings );
+  const QList<QgsLayerTreeModelLegendNode *> nodes = legendModel.layerLegendNodes( nodeLayer );
+  QCOMPARE( nodes.count(), 2 );
+
+  // the same symbols are visible, the legend nodes of the layer are not rebuilt
+  mapSettings.setExtent( QgsRectangle( 0, 0, 10.0, 3.0 ) );
+  legendModel.setLegendFilterByMap( &mapSettings );
+  QCOMPARE( legendModel.layerLegendNodes( nodeLayer ), nodes );
+
+  // the blue point is now visible
+  mapSettings.setExtent( QgsRectangle( 0, 0, 10.0, 6.0 ) );
+  legendModel.setLegendFilterByMap( &mapSettings );
+  QCOMPARE( legendModel.layerLegendNodes( nodeLayer ).count(), 3 );
+
+  legendModel.setLegendFilterByMap( nullptr );
+  QCOMPARE( legendModel.layerLegendNodes( nodeLayer ).count(), 3 );
+}
+
+void TestQgsLegendRenderer::testMapHitTestLayers()
+{
+  QgsMapSettings mapSettings;
+  // extent and size to include only the red and green points
+  mapSettings.setExtent( QgsRectangle( 0, 0, 10.0, 4.0 ) );
+  mapSettings.setOutputSize( QSize( 400, 100 ) );
+  mapSettings.setOutputDpi( 96 );
+  mapSettings.setLayers( QgsProject::instance()->mapLayers().values() );
+
+  // the layers are tested in parallel
+  QgsMapHitTest hitTest( mapSettings );
+  hitTest.run();
+  QVERIFY( hitTest.legendKeyVisible( QStringLiteral( "0" ), mVL3 ) );
+  QVERIFY( hitTest.legendKeyVisible( QStringLiteral( "1" ), mVL3 ) );
+  QVERIFY( !hitTest.legendKeyVisible( QStringLiteral( "2" ), mVL3 ) );
+  QgsCategorizedSymbolRenderer *catRenderer = dynamic_cast<QgsCategorizedSymbolRenderer *>( mVL3->renderer() );
+  QVERIFY( hitTest.symbolVisible( catRenderer->categories().at( 0 ).symbol(), mVL3 ) );
+  QVERIFY( !hitTest.symbolVisible( catRenderer->categories().at( 2 ).symbol(), mVL3 ) );
+
+  // with an expression, only the green point remains
+  QgsMapHitTest::LayerFilterExpression expressions;
+  expressions.insert( mVL3->id(), QStringLiteral( "test_attr >= 2" ) );
+  QgsMapHitTest expressionHitTest( mapSettings, QgsGeometry(), expressions );
+  expressionHitTest.run();
+  QVERIFY( !expressionHitTest.legendKeyVisible( QStringLiteral( "0" ), mVL3 ) );
+  QVERIFY( expressionHitTest.legendKeyVisible( QStringLiteral( "1" ), mVL3 ) );
+  QVERIFY( !expressionHitTest.legendKeyVisible( QStringLiteral( "2" ), mVL3 ) );
+}
+
 void TestQgsLegendRenderer::testFilterByMapSameSymbol()
 {
   QgsVectorLayer *vl4 = new QgsVectorLayer( QStringLiteral( "Point" ), QStringLiteral( "Point Layer" ), QStringLiteral( "memory" ) );
@@ -20,6 +20,9 @@
 #include <QTime>
 #include <QApplication>
 #include <QDesktopServices>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
 
 #include "qgsvectorlayer.h"
 #include "qgsvectorfilewriter.h"
@@ -31,6 +34,7 @@
 #include "qgsfield.h"
 #include "qgis.h"
 #include "qgsmaprenderersequentialjob.h"
+#include "qgsmaprenderercache.h"
 #include "qgsmaplayer.h"
 #include "qgsreadwritecontext.h"
 #include "qgsproviderregistry.h"
@@ -90,9 +94,21 @@ class TestQgsMapRendererJob : public QObject
 
     void temporalRender();
 
+    void parallelFeatureRendering();
+    void gpuRendering();
+    void panReusesCachedImage();
+    void progressiveRendering();
+    void renderingStatistics();
+
   private:
     bool imageCheck( const QString &type, const QImage &image, int mismatchCount = 0 );
 
+    /**
+     * Returns the number of pixels of \a actual which differ noticeably from \a expected,
+     * and sets \a painted to the number of pixels of \a expected not of the background color
+     */
+    static int differentPixels( const QImage &expected, const QImage &actual, int &painted );
+
     QString mEncoding;
     QgsVectorFileWriter::WriterError mError =  QgsVectorFileWriter::NoError ;
     QgsCoordinateReferenceSystem mCRS;
@@ -946,6 +962,221 @@ void TestQgsMapRendererJob::temporalRender()
 
 }
 
+void TestQgsMapRendererJob::parallelFeatureRendering()
+{
+  std::unique_ptr< QgsVectorLayer > gridLayer = qgis::make_unique< QgsVectorLayer >( TEST_DATA_DIR + QStringLiteral( "/grid_4326.geojson" ),
+      QStringLiteral( "grid" ), QStringLiteral( "ogr" ) );
+  QVERIFY( gridLayer->isValid() );
+
+  std::unique_ptr< QgsLineSymbol > symbol = qgis::make_unique< QgsLineSymbol >();
+  symbol->setColor( QColor( 255, 0, 255 ) );
+  symbol->setWidth( 2 );
+  std::unique_ptr< QgsSingleSymbolRenderer > renderer = qgis::make_unique< QgsSingleSymbolRenderer >( symbol.release() );
+  gridLayer->setRenderer( renderer.release() );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setDestinationCrs( QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:3857" ) ) );
+  mapSettings.setExtent( QgsRectangle( -37000835.1, -20182273.7, 37000835.1, 20182273.7 ) );
+  mapSettings.setOutputSize( QSize( 512, 512 ) );
+  mapSettings.setFlag( QgsMapSettings::DrawLabeling, false );
+  mapSettings.setOutputDpi( 96 );
+  mapSettings.setLayers( QList< QgsMapLayer * >() << gridLayer.get() );
+
+  auto render = [&mapSettings]( bool parallel )
+  {
+    QgsMapSettings settings( mapSettings );
+    settings.setFlag( QgsMapSettings::ParallelFeatureRendering, parallel );
+    QgsMapRendererSequentialJob renderJob( settings );
+    renderJob.start();
+    renderJob.waitForFinished();
+    return renderJob.renderedImage();
+  };
+
+  // the bands are disjoint, the result must be the same as the sequential rendering
+  QCOMPARE( render( true ), render( false ) );
+
+  gridLayer->renderer()->setUsingSymbolLevels( true );
+  QCOMPARE( render( true ), render( false ) );
+}
+
+void TestQgsMapRendererJob::gpuRendering()
+{
+  std::unique_ptr< QgsVectorLayer > gridLayer = qgis::make_unique< QgsVectorLayer >( TEST_DATA_DIR + QStringLiteral( "/grid_4326.geojson" ),
+      QStringLiteral( "grid" ), QStringLiteral( "ogr" ) );
+  QVERIFY( gridLayer->isValid() );
+
+  std::unique_ptr< QgsLineSymbol > symbol = qgis::make_unique< QgsLineSymbol >();
+  symbol->setColor( QColor( 255, 0, 255 ) );
+  symbol->setWidth( 2 );
+  std::unique_ptr< QgsSingleSymbolRenderer > renderer = qgis::make_unique< QgsSingleSymbolRenderer >( symbol.release() );
+  gridLayer->setRenderer( renderer.release() );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setDestinationCrs( QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:3857" ) ) );
+  mapSettings.setExtent( QgsRectangle( -37000835.1, -20182273.7, 37000835.1, 20182273.7 ) );
+  mapSettings.setOutputSize( QSize( 512, 512 ) );
+  mapSettings.setFlag( QgsMapSettings::DrawLabeling, false );
+  mapSettings.setFlag( QgsMapSettings::Antialiasing );
+  mapSettings.setOutputDpi( 96 );
+  mapSettings.setLayers( QList< QgsMapLayer * >() << gridLayer.get() );
+
+  auto render = [&mapSettings]( bool gpu )
+  {
+    QgsMapSettings settings( mapSettings );
+    settings.setFlag( QgsMapSettings::GpuRendering, gpu );
+    QgsMapRendererSequentialJob renderJob( settings );
+    renderJob.start();
+    renderJob.waitForFinished();
+    return renderJob.renderedImage().convertToFormat( QImage::Format_ARGB32 );
+  };
+
+  // without an OpenGL context the layer is drawn on the CPU, otherwise the
+  // antialiasing of the edges may differ slightly
+  const QImage cpu = render( false );
+  const QImage gpu = render( true );
+  QCOMPARE( gpu.size(), cpu.size() );
+
+  int painted = 0;
+  const int mismatches = differentPixels( cpu, gpu, painted );
+  QVERIFY( painted > 0 );
+  QVERIFY2( mismatches < painted / 20, QStringLiteral( "%1 of %2 pixels differ" ).arg( mismatches ).arg( painted ).toLocal8Bit().constData() );
+}
+
+void TestQgsMapRendererJob::panReusesCachedImage()
+{
+  std::unique_ptr< QgsVectorLayer > gridLayer = qgis::make_unique< QgsVectorLayer >( TEST_DATA_DIR + QStringLiteral( "/grid_4326.geojson" ),
+      QStringLiteral( "grid" ), QStringLiteral( "ogr" ) );
+  QVERIFY( gridLayer->isValid() );
+
+  std::unique_ptr< QgsLineSymbol > symbol = qgis::make_unique< QgsLineSymbol >();
+  symbol->setColor( QColor( 255, 0, 255 ) );
+  symbol->setWidth( 2 );
+  std::unique_ptr< QgsSingleSymbolRenderer > renderer = qgis::make_unique< QgsSingleSymbolRenderer >( symbol.release() );
+  gridLayer->setRenderer( renderer.release() );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setDestinationCrs( QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:3857" ) ) );
+  mapSettings.setExtent( QgsRectangle( -20000000, -20000000, 20000000, 20000000 ) );
+  mapSettings.setOutputSize( QSize( 512, 512 ) );
+  mapSettings.setFlag( QgsMapSettings::DrawLabeling, false );
+  mapSettings.setOutputDpi( 96 );
+  mapSettings.setLayers( QList< QgsMapLayer * >() << gridLayer.get() );
+
+  auto render = []( const QgsMapSettings & settings, QgsMapRendererCache * cache )
+  {
+    QgsMapRendererSequentialJob renderJob( settings );
+    renderJob.setCache( cache );
+    renderJob.start();
+    renderJob.waitForFinished();
+    return renderJob.renderedImage();
+  };
+
+  QgsMapRendererCache cache;
+  render( mapSettings, &cache );
+  QVERIFY( cache.hasCacheImage( gridLayer->id() ) );
+  const QgsRectangle firstExtent = mapSettings.visibleExtent();
+
+  // pan by 100 pixels to the right and 40 pixels up
+  const double mapUnitsPerPixel = mapSettings.mapUnitsPerPixel();
+  QgsRectangle panned = firstExtent;
+  panned.setXMinimum( firstExtent.xMinimum() + 100 * mapUnitsPerPixel );
+  panned.setXMaximum( firstExtent.xMaximum() + 100 * mapUnitsPerPixel );
+  panned.setYMinimum( firstExtent.yMinimum() + 40 * mapUnitsPerPixel );
+  panned.setYMaximum( firstExtent.yMaximum() + 40 * mapUnitsPerPixel );
+  QgsMapSettings pannedSettings( mapSettings );
+  pannedSettings.setExtent( panned );
+
+  // the image of the previous extent is kept for the next render
+  cache.init( pannedSettings.visibleExtent(), pannedSettings.scale() );
+  QgsRectangle previousExtent;
+  QVERIFY( !cache.previousCacheImage( gridLayer->id(), previousExtent ).isNull() );
+  QCOMPARE( previousExtent, firstExtent );
+
+  const QImage reused = render( pannedSettings, &cache );
+  QVERIFY( cache.hasCacheImage( gridLayer->id() ) );
+  const QImage expected = render( pannedSettings, nullptr );
+  int painted = 0;
+  const int mismatches = differentPixels( expected.convertToFormat( QImage::Format_ARGB32 ), reused.convertToFormat( QImage::Format_ARGB32 ), painted );
+  QVERIFY( painted > 0 );
+  QVERIFY2( mismatches < painted / 50, QStringLiteral( "%1 of %2 pixels differ" ).arg( mismatches ).arg( painted ).toLocal8Bit().constData() );
+
+  // a repaint of the layer drops the previous image
+  cache.init( firstExtent, pannedSettings.scale() );
+  QVERIFY( !cache.previousCacheImage( gridLayer->id(), previousExtent ).isNull() );
+  gridLayer->triggerRepaint();
+  QVERIFY( cache.previousCacheImage( gridLayer->id(), previousExtent ).isNull() );
+}
+
+void TestQgsMapRendererJob::progressiveRendering()
+{
+  std::unique_ptr< QgsVectorLayer > gridLayer = qgis::make_unique< QgsVectorLayer >( TEST_DATA_DIR + QStringLiteral( "/grid_4326.geojson" ),
+      QStringLiteral( "grid" ), QStringLiteral( "ogr" ) );
+  QVERIFY( gridLayer->isValid() );
+
+  std::unique_ptr< QgsLineSymbol > symbol = qgis::make_unique< QgsLineSymbol >();
+  symbol->setColor( QColor( 255, 0, 255 ) );
+  symbol->setWidth( 2 );
+  std::unique_ptr< QgsSingleSymbolRenderer > renderer = qgis::make_unique< QgsSingleSymbolRenderer >( symbol.release() );
+  gridLayer->setRenderer( renderer.release() );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setDestinationCrs( QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:3857" ) ) );
+  mapSettings.setExtent( QgsRectangle( -20000000, -20000000, 20000000, 20000000 ) );
+  mapSettings.setOutputSize( QSize( 512, 512 ) );
+  mapSettings.setFlag( QgsMapSettings::DrawLabeling, false );
+  mapSettings.setOutputDpi( 96 );
+  mapSettings.setLayers( QList< QgsMapLayer * >() << gridLayer.get() );
+
+  auto render = []( const QgsMapSettings & settings, QgsMapRendererCache * cache )
+  {
+    QgsMapRendererSequentialJob renderJob( settings );
+    renderJob.setCache( cache );
+    renderJob.start();
+    renderJob.waitForFinished();
+    return renderJob.renderedImage();
+  };
+
+  const QImage expected = render( mapSettings, nullptr );
+
+  // the rendering time is recorded by the cache, and kept when the cache is cleared
+  QgsMapRendererCache cache;
+  QCOMPARE( cache.layerRenderingTime( gridLayer->id() ), -1 );
+  render( mapSettings, &cache );
+  QVERIFY( cache.layerRenderingTime( gridLayer->id() ) >= 0 );
+  cache.setLayerRenderingTime( gridLayer->id(), QgsMapRendererJob::PROGRESSIVE_RENDERING_THRESHOLD * 10 );
+  cache.clear();
+  QCOMPARE( cache.layerRenderingTime( gridLayer->id() ), QgsMapRendererJob::PROGRESSIVE_RENDERING_THRESHOLD * 10 );
+
+  // the preview of a slow layer is entirely replaced by the full rendering
+  mapSettings.setFlag( QgsMapSettings::ProgressiveRendering );
+  const QImage progressive = render( mapSettings, &cache );
+  int painted = 0;
+  const int mismatches = differentPixels( expected.convertToFormat( QImage::Format_ARGB32 ), progressive.convertToFormat( QImage::Format_ARGB32 ), painted );
+  QVERIFY( painted > 0 );
+  QCOMPARE( mismatches, 0 );
+  QVERIFY( cache.layerRenderingTime( gridLayer->id() ) < QgsMapRendererJob::PROGRESSIVE_RENDERING_THRESHOLD * 10 );
+}
+
+int TestQgsMapRendererJob::differentPixels( const QImage &expected, const QImage &actual, int &painted )
+{
+  painted = 0;
+  int mismatches = 0;
+  for ( int y = 0; y < expected.height(); ++y )
+  {
+    for ( int x = 0; x < expected.width(); ++x )
+    {
+      const QRgb expectedPixel = expected.pixel( x, y );
+      const QRgb actualPixel = actual.pixel( x, y );
+      if ( expectedPixel != expected.pixel( 0, 0 ) )
+        painted++;
+      if ( std::abs( qRed( expectedPixel ) - qRed( actualPixel ) ) > 128 || std::abs( qGreen( expectedPixel ) - qGreen( actualPixel ) ) > 128
+           || std::abs( qBlue( expectedPixel ) - qBlue( actualPixel ) ) > 128 || std::abs( qAlpha( expectedPixel ) - qAlpha( actualPixel ) ) > 128 )
+        mismatches++;
+    }
+  }
+  return mismatches;
+}
+
 bool TestQgsMapRendererJob::imageCheck( const QString &testName, const QImage &image, int mismatchCount )
 {
   mReport += "<h2>" + testName + "</h2>\n";
@@ -964,6 +1195,53 @@ bool TestQgsMapRendererJob::imageCheck( const QString &testName, const QImage &i
 
 
 QGSTEST_MAIN( TestQgsMapRendererJob )
+void TestQgsMapRendererJob::renderingStatistics()
+{
+  std::unique_ptr< QgsVectorLayer > gridLayer = qgis::make_unique< QgsVectorLayer >( TEST_DATA_DIR + QStringLiteral( "/grid_4326.geojson" ),
+      QStringLiteral( "grid" ), QStringLiteral( "ogr" ) );
+  QVERIFY( gridLayer->isValid() );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setExtent( gridLayer->extent() );
+  mapSettings.setOutputSize( QSize( 256, 256 ) );
+  mapSettings.setFlag( QgsMapSettings::DrawLabeling, false );
+  mapSettings.setLayers( QList< QgsMapLayer * >() << gridLayer.get() );
+
+  // not recorded by default
+  QgsMapRendererSequentialJob job( mapSettings );
+  job.start();
+  job.waitForFinished();
+  QVERIFY( job.perLayerRenderingStatistics().isEmpty() );
+
+  mapSettings.setFlag( QgsMapSettings::RecordRenderingStatistics );
+  QgsMapRendererCache cache;
+  QgsMapRendererSequentialJob recordedJob( mapSettings );
+  recordedJob.setCache( &cache );
+  recordedJob.start();
+  recordedJob.waitForFinished();
+  QgsMapLayerRenderingStatistics statistics = recordedJob.perLayerRenderingStatistics().value( gridLayer->id() );
+  QVERIFY( !statistics.cached );
+  QCOMPARE( statistics.featuresFetched, static_cast< long long >( gridLayer->featureCount() ) );
+  QCOMPARE( statistics.featuresDrawn, statistics.featuresFetched );
+  QVERIFY( statistics.fetchTime > 0 );
+  QVERIFY( statistics.symbolDrawingTime > 0 );
+
+  const QJsonDocument trace = QJsonDocument::fromJson( recordedJob.renderingStatisticsChromeTrace() );
+  const QJsonArray events = trace.object().value( QStringLiteral( "traceEvents" ) ).toArray();
+  QVERIFY( events.size() >= 3 );
+  QCOMPARE( events.at( 0 ).toObject().value( QStringLiteral( "name" ) ).toString(), QStringLiteral( "grid" ) );
+  QCOMPARE( events.at( 0 ).toObject().value( QStringLiteral( "ph" ) ).toString(), QStringLiteral( "X" ) );
+
+  // the second rendering uses the cached image
+  QgsMapRendererSequentialJob cachedJob( mapSettings );
+  cachedJob.setCache( &cache );
+  cachedJob.start();
+  cachedJob.waitForFinished();
+  statistics = cachedJob.perLayerRenderingStatistics().value( gridLayer->id() );
+  QVERIFY( statistics.cached );
+  QCOMPARE( statistics.featuresFetched, 0LL );
+}
+
 #include "testqgsmaprendererjob.moc"
 
 
@@ -29,6 +29,7 @@
 #include <qgsapplication.h>
 #include <qgsgeometry.h>
 #include <qgsmaptopixelgeometrysimplifier.h>
+#include <qgswkbgeometryview.h>
 #if 0
 #include <qgspoint.h>
 #include "qgsgeometryutils.h"
@@ -77,6 +78,9 @@ class TestQgsMapToPixelGeometrySimplifier : public QObject
     void testCircularString();
     void testVisvalingam();
     void testRingValidity();
+    void testWkbGeometryView();
+    void testSimplifyWkbView_data();
+    void testSimplifyWkbView();
 
 };
 
@@ -217,5 +221,90 @@ void TestQgsMapToPixelGeometrySimplifier::testRingValidity()
 
 }
 
+void TestQgsMapToPixelGeometrySimplifier::testWkbGeometryView()
+{
+  QgsGeometry g = QgsGeometry::fromWkt( QStringLiteral( "MultiPolygonZ (((0 0 1, 10 0 2, 10 10 3, 0 0 1),(1 1 0, 2 1 0, 2 2 0, 1 1 0)),((20 20 5, 30 20 5, 30 25 5, 20 20 5)))" ) );
+  QgsWkbGeometryView view( g.asWkb() );
+  QVERIFY( view.isValid() );
+  QVERIFY( view.isNativeIsoWkb() );
+  QCOMPARE( view.wkbType(), QgsWkbTypes::MultiPolygonZ );
+  QCOMPARE( view.partCount(), 2 );
+  QCOMPARE( view.ringCount( 0 ), 2 );
+  QCOMPARE( view.ringCount( 1 ), 1 );
+  QCOMPARE( view.pointCount( 0, 1 ), 4 );
+  QCOMPARE( view.nCoordinates(), 12 );
+  QCOMPARE( view.x( 0, 0, 1 ), 10.0 );
+  QCOMPARE( view.y( 1, 0, 2 ), 25.0 );
+  QCOMPARE( view.boundingBox(), g.boundingBox() );
+  QCOMPARE( view.boundingBox( 1, 0 ), QgsRectangle( 20, 20, 30, 25 ) );
+  QCOMPARE( view.asQPolygonF( 0, 1 ), QPolygonF() << QPointF( 1, 1 ) << QPointF( 2, 1 ) << QPointF( 2, 2 ) << QPointF( 1, 1 ) );
+  QCOMPARE( view.lineString( 0, 0 )->asWkt(), QStringLiteral( "LineStringZ (0 0 1, 10 0 2, 10 10 3, 0 0 1)" ) );
+  QCOMPARE( view.toGeometry().asWkt(), g.asWkt() );
+
+  // big endian line string
+  QgsWkbGeometryView xdr( QByteArray::fromHex( "0000000002000000020000000000000000400800000000000040100000000000004014000000000000" ) );
+  QVERIFY( xdr.isValid() );
+  QCOMPARE( xdr.wkbType(), QgsWkbTypes::LineString );
+  QCOMPARE( xdr.boundingBox(), QgsRectangle( 0, 3, 4, 5 ) );
+  QCOMPARE( xdr.x( 0, 0, 1 ), 4.0 );
+  QVERIFY( !xdr.isNativeIsoWkb() );
+
+  // old style 25D type codes and trailing data differ from what asWkb() exports
+  QVERIFY( !QgsWkbGeometryView( QByteArray::fromHex( "010100008000000000000000000000000000000000000000000000F03F" ) ).isNativeIsoWkb() );
+  QgsWkbGeometryView trailing( g.asWkb() + QByteArray( 1, '\0' ) );
+  QVERIFY( trailing.isValid() );
+  QVERIFY( !trailing.isNativeIsoWkb() );
+
+  // curves and truncated wkb are not supported
+  QVERIFY( !QgsWkbGeometryView( QgsGeometry::fromWkt( QStringLiteral( "CircularString (0 0, 1 1, 2 0)" ) ).asWkb() ).isValid() );
+  QByteArray truncated = g.asWkb();
+  truncated.chop( 8 );
+  QgsWkbGeometryView truncatedView( truncated );
+  QVERIFY( !truncatedView.isValid() );
+  QCOMPARE( truncatedView.partCount(), 0 );
+}
+
+void TestQgsMapToPixelGeometrySimplifier::testSimplifyWkbView_data()
+{
+  QTest::addColumn<QString>( "wkt" );
+  QTest::addColumn<int>( "algorithm" );
+
+  const QStringList wkts
+  {
+    QStringLiteral( "LineString (0 0, 30 0, 31 30, 32 0, 40 0, 41 100, 42 0, 50 0)" ),
+    QStringLiteral( "LineStringZ (0 0 1, 0.1 0 1, 0.2 0.1 1, 0.3 0 1, 0.4 0.1 1, 0.5 0 1)" ),
+    QStringLiteral( "Polygon ((0 0, 30 0, 30 30, 0 30, 0 0),(10.0001 10.00002, 10.0005 10.00002, 10.0005 10.00004, 10.00001 10.00004, 10.0001 10.00002 ))" ),
+    QStringLiteral( "MultiLineString ((0 0, 1 1, 2 0, 3 1, 10 0),(0 0, 0.5 0, 1 0, 1.5 0, 2 0, 2.5 0))" ),
+    QStringLiteral( "MultiPolygon (((0 0, 30 0, 30 30, 0 30, 0 0)),((100 100, 101 100, 101 101, 100.5 101.5, 100 101, 100 100)))" ),
+  };
+  for ( const QString &wkt : wkts )
+  {
+    QTest::newRow( QStringLiteral( "distance %1" ).arg( wkt ).toLocal8Bit().constData() ) << wkt << static_cast< int >( QgsMapToPixelSimplifier::Distance );
+    QTest::newRow( QStringLiteral( "grid %1" ).arg( wkt ).toLocal8Bit().constData() ) << wkt << static_cast< int >( QgsMapToPixelSimplifier::SnapToGrid );
+    QTest::newRow( QStringLiteral( "visvalingam %1" ).arg( wkt ).toLocal8Bit().constData() ) << wkt << static_cast< int >( QgsMapToPixelSimplifier::Visvalingam );
+  }
+}
+
+void TestQgsMapToPixelGeometrySimplifier::testSimplifyWkbView()
+{
+  QFETCH( QString, wkt );
+  QFETCH( int, algorithm );
+
+  const QgsGeometry g = QgsGeometry::fromWkt( wkt );
+  const QgsWkbGeometryView view( g.asWkb() );
+
+  // simplifying the view gives the same result as simplifying the full geometry
+  const QList< int > flags { QgsMapToPixelSimplifier::SimplifyGeometry, QgsMapToPixelSimplifier::SimplifyEnvelope, QgsMapToPixelSimplifier::SimplifyGeometry | QgsMapToPixelSimplifier::SimplifyEnvelope };
+  const QList< double > tolerances { 0.05, 2, 7, 50 };
+  for ( int fl : flags )
+  {
+    for ( double tolerance : tolerances )
+    {
+      const QgsMapToPixelSimplifier simplifier( fl, tolerance, static_cast< QgsMapToPixelSimplifier::SimplifyAlgorithm >( algorithm ) );
+      QCOMPARE( simplifier.simplify( view ).asWkt(), simplifier.simplify( g ).asWkt() );
+    }
+  }
+}
+
 QGSTEST_MAIN( TestQgsMapToPixelGeometrySimplifier )
 #include "testqgsmaptopixelgeometrysimplifier.moc"
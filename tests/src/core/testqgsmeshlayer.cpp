@@ -74,6 +74,7 @@ class TestQgsMeshLayer : public QObject
     void test_read_face_scalar_dataset();
     void test_read_face_vector_dataset();
     void test_read_vertex_scalar_dataset_with_inactive_face();
+    void test_dataset_cache();
     void test_extent();
 
     void test_temporal();
@@ -912,6 +913,45 @@ void TestQgsMeshLayer::test_read_vertex_scalar_dataset_with_inactive_face()
   }
 }
 
+void TestQgsMeshLayer::test_dataset_cache()
+{
+  QString uri( mDataDir + "/quad_and_triangle.2dm" );
+  QgsMeshLayer layer( uri, "Triangle and Quad MDAL", "mdal" );
+  layer.dataProvider()->addDataset( mDataDir + "/quad_and_triangle_vertex_scalar_with_inactive_face.dat" );
+  QCOMPARE( 2, layer.datasetGroupCount() );
+
+  for ( int i = 0; i < 2 ; ++i )
+  {
+    // read the whole blocks, in sequence, then parts of them from the cache
+    QgsMeshDatasetIndex ds( 1, i );
+    QgsMeshDataBlock values = layer.datasetValues( ds, 0, 5 );
+    QVERIFY( values.isValid() );
+    QCOMPARE( values.count(), 5 );
+    QCOMPARE( QgsMeshDatasetValue( 3.0 + i ), values.value( 2 ) );
+    QgsMeshDataBlock active = layer.areFacesActive( ds, 0, 2 );
+    QVERIFY( active.isValid() );
+    QVERIFY( !active.active( 0 ) );
+    QVERIFY( active.active( 1 ) );
+
+    values = layer.datasetValues( ds, 2, 3 );
+    QVERIFY( values.isValid() );
+    QCOMPARE( values.count(), 3 );
+    QCOMPARE( QgsMeshDatasetValue( 3.0 + i ), values.value( 0 ) );
+    QCOMPARE( QgsMeshDatasetValue( 2.0 + i ), values.value( 1 ) );
+    QCOMPARE( QgsMeshDatasetValue( 1.0 + i ), values.value( 2 ) );
+    QCOMPARE( QgsMeshDatasetValue( 2.0 + i ), layer.datasetValue( ds, 1 ) );
+
+    active = layer.areFacesActive( ds, 1, 1 );
+    QVERIFY( active.isValid() );
+    QCOMPARE( active.count(), 1 );
+    QVERIFY( active.active( 0 ) );
+    QVERIFY( !layer.isFaceActive( ds, 0 ) );
+    QVERIFY( layer.isFaceActive( ds, 1 ) );
+
+    QCoreApplication::processEvents();
+  }
+}
+
 void TestQgsMeshLayer::test_extent()
 {
   QgsRectangle expectedExtent( 1000.0, 2000.0, 3000.0, 3000.0 );
@@ -979,6 +1019,7 @@ void TestQgsMeshLayer::test_reload()
 
   //Test if the layer matches with quad and triangle
   QCOMPARE( layer.datasetGroupCount(), 1 );
+  QCOMPARE( layer.datasetValues( QgsMeshDatasetIndex( 0, 0 ), 0, 5 ).count(), 5 );
   QCOMPARE( layer.datasetGroupTreeRootItem()->childCount(), 1 );
   QCOMPARE( 5, layer.nativeMesh()->vertexCount() );
   QCOMPARE( 2, layer.nativeMesh()->faceCount() );
@@ -1003,7 +1044,8 @@ void TestQgsMeshLayer::test_reload()
   QCOMPARE( 8, layer.nativeMesh()->vertexCount() );
   QCOMPARE( 5, layer.nativeMesh()->faceCount() );
 
-  //Test dataSet in quad flower
+  //Test dataSet in quad flower, the cached values of the previous file are dropped
+  QCOMPARE( QgsMeshDatasetValue( 200 ), layer.datasetValue( ds, 0 ) );
   QCOMPARE( QgsMeshDatasetValue( 200 ), layer.dataProvider()->datasetValue( ds, 0 ) );
   QCOMPARE( QgsMeshDatasetValue( 200 ), layer.dataProvider()->datasetValue( ds, 1 ) );
   QCOMPARE( QgsMeshDatasetValue( 800 ), layer.dataProvider()->datasetValue( ds, 2 ) );
@@ -1161,6 +1203,19 @@ void TestQgsMeshLayer::test_mesh_simplification()
   QCOMPARE( simplifiedMeshes.at( 3 )->triangles().count(), 32 );
   QCOMPARE( simplifiedMeshes.at( 4 )->triangles().count(), 5 );
 
+  // Size of the triangles by region
+  QGSCOMPARENEAR( baseMesh->averageTriangleSize( baseMesh->extent() ), baseMesh->averageTriangleSize(), 1e-6 );
+  QCOMPARE( baseMesh->averageTriangleSize( QgsRectangle( -10, -10, -9, -9 ) ), baseMesh->averageTriangleSize() );
+  QVERIFY( simplifiedMeshes.at( 0 )->averageTriangleSize( baseMesh->extent() ) > baseMesh->averageTriangleSize( baseMesh->extent() ) );
+
+  // Restore a simplified mesh from its triangles
+  std::unique_ptr<QgsTriangularMesh> restoredMesh( baseMesh->simplifiedMesh( simplifiedMeshes.at( 1 )->triangles(),
+      simplifiedMeshes.at( 1 )->trianglesToNativeFaces(), 2 ) );
+  QCOMPARE( restoredMesh->levelOfDetail(), simplifiedMeshes.at( 1 )->levelOfDetail() );
+  QCOMPARE( restoredMesh->triangles(), simplifiedMeshes.at( 1 )->triangles() );
+  QCOMPARE( restoredMesh->trianglesToNativeFaces(), simplifiedMeshes.at( 1 )->trianglesToNativeFaces() );
+  QCOMPARE( restoredMesh->averageTriangleSize(), simplifiedMeshes.at( 1 )->averageTriangleSize() );
+
   // Delete simplified meshes
   for ( QgsTriangularMesh *m : simplifiedMeshes )
     delete m;
@@ -86,6 +86,7 @@ class TestQgsMeshRenderer : public QObject
     void test_face_scalar_dataset_interpolated_neighbour_average_rendering();
     void test_face_vector_dataset_rendering();
     void test_vertex_scalar_dataset_with_inactive_face_rendering();
+    void test_vertex_scalar_dataset_cached_pixel_triangles_rendering();
     void test_face_vector_on_user_grid();
     void test_face_vector_on_user_grid_streamlines();
     void test_vertex_vector_on_user_grid();
@@ -478,6 +479,25 @@ void TestQgsMeshRenderer::test_vertex_scalar_dataset_with_inactive_face_renderin
   QVERIFY( imageCheck( "quad_and_triangle_vertex_scalar_dataset_with_inactive_face", mMdalLayer ) );
 }
 
+void TestQgsMeshRenderer::test_vertex_scalar_dataset_cached_pixel_triangles_rendering()
+{
+  // render a dataset with all the faces active first, so that the second dataset
+  // is interpolated with the triangles of the pixels located for the first one
+  QgsMeshRendererSettings rendererSettings = mMdalLayer->rendererSettings();
+  mMdalLayer->setRendererSettings( rendererSettings );
+  mMdalLayer->setStaticScalarDatasetIndex( QgsMeshDatasetIndex( 0, 0 ) );
+  mMapSettings->setExtent( mMdalLayer->extent() );
+  mMapSettings->setDestinationCrs( mMdalLayer->crs() );
+  mMapSettings->setOutputDpi( 96 );
+  QgsMapRendererSequentialJob job( *mMapSettings );
+  job.start();
+  job.waitForFinished();
+
+  QgsMeshDatasetIndex ds( 1, 1 );
+  mMdalLayer->setStaticScalarDatasetIndex( ds );
+  QVERIFY( imageCheck( "quad_and_triangle_vertex_scalar_dataset_with_inactive_face", mMdalLayer ) );
+}
+
 void TestQgsMeshRenderer::test_face_vector_on_user_grid()
 {
   QgsMeshDatasetIndex ds( 3, 0 );
@@ -702,6 +722,17 @@ void TestQgsMeshRenderer::test_simplified_triangular_mesh_rendering()
   mMdal3DLayer->setRendererSettings( rendererSettings );
 
   mMdal3DLayer->setMeshSimplificationSettings( simplificatationSettings );
+
+  // the simplified meshes are built in a background task, started by the first rendering
+  QSignalSpy spy( mMdal3DLayer, &QgsMapLayer::repaintRequested );
+  mMapSettings->setExtent( mMdal3DLayer->extent() );
+  mMapSettings->setDestinationCrs( mMdal3DLayer->crs() );
+  mMapSettings->setOutputDpi( 96 );
+  QgsMapRendererSequentialJob job( *mMapSettings );
+  job.start();
+  job.waitForFinished();
+  QVERIFY( !spy.isEmpty() || spy.wait() );
+
   QVERIFY( imageCheck( "simplified_triangular_mesh", mMdal3DLayer ) );
 }
 
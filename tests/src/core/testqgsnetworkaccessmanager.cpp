@@ -24,6 +24,7 @@
 #include "qgssettings.h"
 #include <QNetworkReply>
 #include <QAuthenticator>
+#include <QtConcurrentMap>
 
 class BackgroundRequest : public QThread
 {
@@ -152,6 +153,8 @@ class TestQgsNetworkAccessManager : public QObject
     void fetchEmptyUrl(); //test fetching blank url
     void fetchBadUrl(); //test fetching bad url
     void fetchEncodedContent(); //test fetching url content encoded as utf-8
+    void fetchConcurrentBlocking(); //test identical blocking requests from worker threads
+    void fetchAsync(); //test chained asynchronous requests
     void fetchPost();
     void fetchBadSsl();
     void testSslErrorHandler();
@@ -401,6 +404,7 @@ void TestQgsNetworkAccessManager::fetchEncodedContent()
     QCOMPARE( reply.requestId(), requestId );
     QVERIFY( reply.rawHeaderList().contains( "Content-Length" ) );
     QCOMPARE( reply.request().url(), u );
+    QVERIFY( reply.elapsedTime() >= 0 );
     loaded = true;
   } );
   QNetworkRequest r( u );
@@ -459,6 +463,59 @@ void TestQgsNetworkAccessManager::fetchEncodedContent()
   blockingThread->deleteLater();
 }
 
+void TestQgsNetworkAccessManager::fetchConcurrentBlocking()
+{
+  const QUrl u = QUrl::fromLocalFile( QStringLiteral( TEST_DATA_DIR ) + '/' + "encoded_html.html" );
+  QVector< QgsNetworkReplyContent > replies( 8 );
+  QtConcurrent::blockingMap( replies, [u]( QgsNetworkReplyContent & reply )
+  {
+    QNetworkRequest request( u );
+    reply = QgsNetworkAccessManager::blockingGet( request );
+  } );
+  for ( const QgsNetworkReplyContent &reply : qgis::as_const( replies ) )
+  {
+    QCOMPARE( reply.error(), QNetworkReply::NoError );
+    QVERIFY( reply.content().contains( "<title>test</title>" ) );
+    QVERIFY( reply.elapsedTime() >= 0 );
+  }
+}
+
+void TestQgsNetworkAccessManager::fetchAsync()
+{
+  const QUrl u = QUrl::fromLocalFile( QStringLiteral( TEST_DATA_DIR ) + '/' + "encoded_html.html" );
+  QObject context;
+  int replies = 0;
+  const int requestId = QgsNetworkAccessManager::asyncGet( QNetworkRequest( u ), QString(), &context, [&]( const QgsNetworkReplyContent & reply )
+  {
+    QCOMPARE( reply.error(), QNetworkReply::NoError );
+    QVERIFY( reply.content().contains( "<title>test</title>" ) );
+    replies++;
+
+    // chained request
+    QgsNetworkAccessManager::asyncGet( QNetworkRequest( u ), QString(), &context, [&]( const QgsNetworkReplyContent & chainedReply )
+    {
+      QVERIFY( chainedReply.content().contains( "<title>test</title>" ) );
+      replies++;
+    } );
+  } );
+  QVERIFY( requestId > 0 );
+  while ( replies < 2 )
+  {
+    qApp->processEvents();
+  }
+
+  // no callback once the context is deleted
+  std::unique_ptr< QObject > deletedContext = qgis::make_unique< QObject >();
+  bool called = false;
+  QgsNetworkAccessManager::asyncGet( QNetworkRequest( u ), QString(), deletedContext.get(), [&]( const QgsNetworkReplyContent & )
+  {
+    called = true;
+  } );
+  deletedContext.reset();
+  QCoreApplication::processEvents();
+  QVERIFY( !called );
+}
+
 void TestQgsNetworkAccessManager::fetchPost()
 {
   if ( QgsTest::isTravis() )
@@ -55,6 +55,7 @@ class TestQgsOfflineEditing : public QObject
     void createSpatialiteAndSynchronizeBack();
     void createGeopackageAndSynchronizeBack();
     void removeConstraintsOnDefaultValues();
+    void synchronizeChanges();
 };
 
 void TestQgsOfflineEditing::initTestCase()
@@ -269,5 +270,64 @@ void TestQgsOfflineEditing::removeConstraintsOnDefaultValues()
 }
 
 
+void TestQgsOfflineEditing::synchronizeChanges()
+{
+  offlineDbFile = "TestQgsOfflineEditingChanges.sqlite";
+  QString myFileName( TEST_DATA_DIR ); //defined in CmakeLists.txt
+  QString myTempDirName = tempDir.path();
+  QFile::copy( myFileName + "/points.shp", myTempDirName + "/points_changes.shp" );
+  QFile::copy( myFileName + "/points.shx", myTempDirName + "/points_changes.shx" );
+  QFile::copy( myFileName + "/points.dbf", myTempDirName + "/points_changes.dbf" );
+  QgsVectorLayer *layer = new QgsVectorLayer( myTempDirName + "/points_changes.shp", QStringLiteral( "points_changes" ), QStringLiteral( "ogr" ) );
+  QgsProject::instance()->addMapLayer( layer );
+  const long featureCount = layer->featureCount();
+
+  //convert
+  mOfflineEditing->convertToOfflineProject( offlineDataPath, offlineDbFile, QStringList() << layer->id(), false, QgsOfflineEditing::SpatiaLite );
+
+  layer = qobject_cast<QgsVectorLayer *>( QgsProject::instance()->mapLayersByName( QStringLiteral( "points_changes (offline)" ) ).first() );
+  QCOMPARE( layer->featureCount(), featureCount );
+
+  //edit offline
+  QgsFeature changedFeature;
+  QgsFeature movedFeature;
+  QgsFeature removedFeature;
+  QgsFeatureIterator it = layer->getFeatures();
+  it.nextFeature( changedFeature );
+  it.nextFeature( movedFeature );
+  it.nextFeature( removedFeature );
+  const int classIndex = layer->fields().indexOf( QStringLiteral( "Class" ) );
+
+  layer->startEditing();
+  layer->changeAttributeValue( changedFeature.id(), classIndex, QStringLiteral( "Glider" ) );
+  layer->changeGeometry( movedFeature.id(), QgsGeometry::fromPointXY( QgsPointXY( -1000, 2000 ) ) );
+  layer->deleteFeature( removedFeature.id() );
+  QgsFeature newFeature( layer->fields() );
+  newFeature.setAttribute( classIndex, QStringLiteral( "Superjet" ) );
+  newFeature.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( 3000, 4000 ) ) );
+  layer->addFeature( newFeature );
+  QVERIFY( layer->commitChanges() );
+
+  //synchronize back
+  mOfflineEditing->synchronize();
+
+  layer = qobject_cast<QgsVectorLayer *>( QgsProject::instance()->mapLayersByName( QStringLiteral( "points_changes" ) ).first() );
+  QCOMPARE( layer->featureCount(), featureCount );
+
+  QStringList classes;
+  QList<QgsPointXY> points;
+  QgsFeature f;
+  it = layer->getFeatures();
+  while ( it.nextFeature( f ) )
+  {
+    classes << f.attribute( QStringLiteral( "Class" ) ).toString();
+    points << f.geometry().asPoint();
+  }
+  QCOMPARE( classes.count( QStringLiteral( "Glider" ) ), 1 );
+  QCOMPARE( classes.count( QStringLiteral( "Superjet" ) ), 1 );
+  QVERIFY( points.contains( QgsPointXY( -1000, 2000 ) ) );
+  QVERIFY( points.contains( QgsPointXY( 3000, 4000 ) ) );
+}
+
 QGSTEST_MAIN( TestQgsOfflineEditing )
 #include "testqgsofflineediting.moc"
@@ -24,6 +24,8 @@
 #include <qgsproviderregistry.h>
 #include <qgsvectorlayer.h>
 #include <qgsnetworkaccessmanager.h>
+#include <qgsfeaturebatch.h>
+#include <qgsvectordataprovider.h>
 
 #include <QObject>
 
@@ -48,6 +50,7 @@ class TestQgsOgrProvider : public QObject
     void decodeUri();
     void encodeUri();
     void testThread();
+    void fetchBatch();
 
   private:
     QString mTestDataDir;
@@ -331,6 +334,45 @@ void TestQgsOgrProvider::testThread()
 
 }
 
+void TestQgsOgrProvider::fetchBatch()
+{
+  QgsVectorLayer vl( mTestDataDir + '/' + QStringLiteral( "lines.shp" ), QStringLiteral( "lines" ), QStringLiteral( "ogr" ) );
+  QVERIFY( vl.isValid() );
+  QgsVectorDataProvider *provider = vl.dataProvider();
+
+  QgsFeatureList features;
+  QgsFeatureIterator it = provider->getFeatures();
+  QgsFeature f;
+  while ( it.nextFeature( f ) )
+    features << f;
+  QVERIFY( features.size() > 3 );
+
+  // the batches hold the same features as the iterator, in the same order
+  for ( const QgsAttributeList &attributes : { QgsAttributeList(), QgsAttributeList() << 1 } )
+  {
+    QgsFeatureRequest request;
+    if ( !attributes.isEmpty() )
+      request.setSubsetOfAttributes( attributes );
+    QgsFeatureBatch batch( provider->fields(), attributes, true );
+    it = provider->getFeatures( request );
+    int row = 0;
+    while ( it.nextBatch( batch, 3 ) > 0 )
+    {
+      QVERIFY( batch.size() <= 3 );
+      for ( int i = 0; i < batch.size(); ++i, ++row )
+      {
+        const QgsFeature &expected = features.at( row );
+        QCOMPARE( batch.featureIds().at( i ), expected.id() );
+        for ( int column = 0; column < batch.columnCount(); ++column )
+          QCOMPARE( batch.value( column, i ), expected.attribute( batch.attributeIndex( column ) ) );
+        QgsGeometry geometry;
+        geometry.fromWkb( batch.wkb( i ) );
+        QVERIFY( geometry.equals( expected.geometry() ) );
+      }
+    }
+    QCOMPARE( row, features.size() );
+  }
+}
 
 QGSTEST_MAIN( TestQgsOgrProvider )
 #include "testqgsogrprovider.moc"
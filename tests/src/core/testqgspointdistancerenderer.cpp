@@ -0,0 +1,153 @@
+/***************************************************************************
+     testqgspointdistancerenderer.cpp
+     --------------------------------
+    Date                 : October 2020
+    Copyright            : (C) 2020 by the QGIS project
+    Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgstest.h"
+#include <QObject>
+
+#include "qgsapplication.h"
+#include "qgspointdistancerenderer.h"
+#include "qgsrendercontext.h"
+#include "qgsmaptopixel.h"
+#include "qgsgeometry.h"
+#include "qgsspatialindex.h"
+
+/**
+ * A distance renderer which records the groups instead of drawing them
+ */
+class TestGroupRecorder : public QgsPointDistanceRenderer
+{
+  public:
+    TestGroupRecorder()
+      : QgsPointDistanceRenderer( QStringLiteral( "groupRecorder" ) )
+    {}
+
+    QgsFeatureRenderer *clone() const override
+    {
+      return new TestGroupRecorder();
+    }
+
+    //! Feature ids of the drawn groups
+    QList< QList< QgsFeatureId > > groups;
+
+    //! Whether the group index, the group locations and the spatial index matched the drawn groups
+    bool indexesMatch = true;
+
+  private:
+    void drawGroup( QPointF, QgsRenderContext &, const ClusteredGroup &group ) override
+    {
+      QList< QgsFeatureId > ids;
+      for ( const GroupedFeature &feature : group )
+      {
+        ids << feature.feature.id();
+        indexesMatch &= mGroupIndex.value( feature.feature.id(), -1 ) == groups.size();
+      }
+      indexesMatch &= mSpatialIndex && mGroupLocations.contains( group.at( 0 ).feature.id() );
+      groups << ids;
+    }
+};
+
+class TestQgsPointDistanceRenderer: public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void searchDistance();
+    void closestGroup();
+
+  private:
+    //! Returns the groups of \a points rendered with a search distance of \a distance map units
+    QList< QList< QgsFeatureId > > groups( const QList< QgsPointXY > &points, double distance ) const;
+};
+
+void TestQgsPointDistanceRenderer::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsPointDistanceRenderer::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+QList< QList< QgsFeatureId > > TestQgsPointDistanceRenderer::groups( const QList< QgsPointXY > &points, double distance ) const
+{
+  TestGroupRecorder renderer;
+  renderer.setTolerance( distance );
+  renderer.setToleranceUnit( QgsUnitTypes::RenderMapUnits );
+
+  QgsRenderContext context;
+  context.setMapToPixel( QgsMapToPixel( 1, 0, 0, 100, 100, 0 ) );
+  renderer.startRender( context, QgsFields() );
+  QgsFeatureId id = 1;
+  for ( const QgsPointXY &point : points )
+  {
+    QgsFeature feature( id++ );
+    feature.setGeometry( QgsGeometry::fromPointXY( point ) );
+    renderer.renderFeature( feature, context );
+  }
+  renderer.stopRender( context );
+
+  if ( !renderer.indexesMatch )
+    return QList< QList< QgsFeatureId > >();
+  return renderer.groups;
+}
+
+void TestQgsPointDistanceRenderer::searchDistance()
+{
+  typedef QList< QgsFeatureId > Ids;
+
+  // a point exactly at the search distance of the first point of a group joins it, in both directions
+  QCOMPARE( groups( QList< QgsPointXY >() << QgsPointXY( 0, 0 ) << QgsPointXY( 10, 0 ), 10 ), QList< Ids >() << ( Ids() << 1 << 2 ) );
+  QCOMPARE( groups( QList< QgsPointXY >() << QgsPointXY( 0, 0 ) << QgsPointXY( 0, -10 ), 10 ), QList< Ids >() << ( Ids() << 1 << 2 ) );
+  // the search area is a square
+  QCOMPARE( groups( QList< QgsPointXY >() << QgsPointXY( 0, 0 ) << QgsPointXY( -10, 10 ), 10 ), QList< Ids >() << ( Ids() << 1 << 2 ) );
+
+  // just beyond the search distance, including across the cells of the grid
+  QCOMPARE( groups( QList< QgsPointXY >() << QgsPointXY( 0, 0 ) << QgsPointXY( 10.001, 0 ), 10 ), QList< Ids >() << ( Ids() << 1 ) << ( Ids() << 2 ) );
+  QCOMPARE( groups( QList< QgsPointXY >() << QgsPointXY( 9.999, 0 ) << QgsPointXY( 20, 0 ), 10 ), QList< Ids >() << ( Ids() << 1 ) << ( Ids() << 2 ) );
+  QCOMPARE( groups( QList< QgsPointXY >() << QgsPointXY( -0.001, 5 ) << QgsPointXY( 10, 5 ), 10 ), QList< Ids >() << ( Ids() << 1 ) << ( Ids() << 2 ) );
+  // within the search distance, in the next cell of the grid
+  QCOMPARE( groups( QList< QgsPointXY >() << QgsPointXY( 9.999, 0 ) << QgsPointXY( 19.998, 0 ), 10 ), QList< Ids >() << ( Ids() << 1 << 2 ) );
+
+  // the distance is measured from the first point of the group, not from its location
+  QCOMPARE( groups( QList< QgsPointXY >() << QgsPointXY( 0, 0 ) << QgsPointXY( 10, 0 ) << QgsPointXY( 13, 0 ), 10 ),
+            QList< Ids >() << ( Ids() << 1 << 2 ) << ( Ids() << 3 ) );
+
+  // negative coordinates
+  QCOMPARE( groups( QList< QgsPointXY >() << QgsPointXY( -100, -100 ) << QgsPointXY( -110, -90 ) << QgsPointXY( -110.5, -100 ), 10 ),
+            QList< Ids >() << ( Ids() << 1 << 2 ) << ( Ids() << 3 ) );
+}
+
+void TestQgsPointDistanceRenderer::closestGroup()
+{
+  typedef QList< QgsFeatureId > Ids;
+
+  // the point within the search distance of two groups joins the one with the closest location
+  QCOMPARE( groups( QList< QgsPointXY >() << QgsPointXY( 0, 0 ) << QgsPointXY( 15, 0 ) << QgsPointXY( 9, 0 ), 10 ),
+            QList< Ids >() << ( Ids() << 1 ) << ( Ids() << 2 << 3 ) );
+
+  // the location of a group moves to the center of its points
+  QCOMPARE( groups( QList< QgsPointXY >() << QgsPointXY( 0, 0 ) << QgsPointXY( 15, 0 ) << QgsPointXY( -6, 0 ) << QgsPointXY( 7, 0 ), 10 ),
+            QList< Ids >() << ( Ids() << 1 << 3 ) << ( Ids() << 2 << 4 ) );
+
+  // ties go to the first group
+  QCOMPARE( groups( QList< QgsPointXY >() << QgsPointXY( 0, 0 ) << QgsPointXY( 12, 0 ) << QgsPointXY( 6, 0 ), 10 ),
+            QList< Ids >() << ( Ids() << 1 << 3 ) << ( Ids() << 2 ) );
+}
+
+QGSTEST_MAIN( TestQgsPointDistanceRenderer )
+#include "testqgspointdistancerenderer.moc"
@@ -517,6 +517,62 @@ class TestQgsPointLocator : public QObject
       QCOMPARE( m.vertexIndex(), 2 );
     }
 
+    void testExtentUpdate()
+    {
+      // points at the centers of the cells of a 100 x 100 grid
+      QgsVectorLayer layer( QStringLiteral( "Point" ), QStringLiteral( "x" ), QStringLiteral( "memory" ) );
+      QgsFeatureList features;
+      for ( int i = 0; i < 100; ++i )
+      {
+        for ( int j = 0; j < 100; ++j )
+        {
+          QgsFeature f;
+          f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( i + 0.5, j + 0.5 ) ) );
+          features << f;
+        }
+      }
+      layer.dataProvider()->addFeatures( features );
+
+      // the extent is aligned to tiles of about an eighth of its size
+      QgsRectangle extent( 10.2, 10.2, 25.8, 25.8 );
+      QgsPointLocator loc( &layer, QgsCoordinateReferenceSystem(), QgsCoordinateTransformContext(), &extent );
+      QCOMPARE( *loc.extent(), QgsRectangle( 10, 10, 26, 26 ) );
+      QVERIFY( loc.nearestVertex( QgsPointXY( 11, 11 ), 1 ).isValid() );
+      QCOMPARE( loc.cachedGeometryCount(), 256 );
+
+      // a small move keeps the index
+      extent = QgsRectangle( 10.4, 10.4, 26, 26 );
+      loc.setExtent( &extent );
+      QVERIFY( loc.hasIndex() );
+
+      // a larger one keeps the features still in the extent, and only reads the new tiles
+      SpatialIndex::ISpatialIndex *tree = loc.mRTree.get();
+      extent = QgsRectangle( 14.2, 8.2, 29.8, 23.8 );
+      loc.setExtent( &extent );
+      QCOMPARE( *loc.extent(), QgsRectangle( 14, 8, 30, 24 ) );
+      QVERIFY( !loc.hasIndex() );
+      QVERIFY( loc.nearestVertex( QgsPointXY( 29, 9 ), 1 ).isValid() );
+      QVERIFY( loc.hasIndex() );
+      QCOMPARE( loc.mRTree.get(), tree );
+      QCOMPARE( loc.cachedGeometryCount(), 256 );
+      QVERIFY( !loc.nearestVertex( QgsPointXY( 11.5, 24.5 ), 0.5 ).isValid() );
+
+      // edits are still applied to the updated index
+      layer.startEditing();
+      QgsFeature f;
+      f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( 20.2, 20.2 ) ) );
+      layer.addFeature( f );
+      QCOMPARE( loc.nearestVertex( QgsPointXY( 20.3, 20.3 ), 0.2 ).point(), QgsPointXY( 20.2, 20.2 ) );
+      layer.rollBack();
+
+      // a much larger extent is indexed again
+      extent = QgsRectangle( 0, 0, 100, 100 );
+      loc.setExtent( &extent );
+      QVERIFY( !loc.mRTree );
+      QVERIFY( loc.nearestVertex( QgsPointXY( 90, 90 ), 1 ).isValid() );
+      QCOMPARE( loc.cachedGeometryCount(), 10000 );
+    }
+
 };
 
 QGSTEST_MAIN( TestQgsPointLocator )
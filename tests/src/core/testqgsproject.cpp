@@ -25,6 +25,7 @@
 #include "qgssettings.h"
 #include "qgsunittypes.h"
 #include "qgsvectorlayer.h"
+#include "qgsvectordataprovider.h"
 #include "qgssymbollayerutils.h"
 #include "qgslayoutmanager.h"
 
@@ -46,6 +47,7 @@ class TestQgsProject : public QObject
     void testLocalFiles();
     void testLocalUrlFiles();
     void testReadFlags();
+    void testReadLayersInParallel();
     void testSetGetCrs();
     void testEmbeddedLayerGroupFromQgz();
     void projectSaveUser();
@@ -435,6 +437,46 @@ void TestQgsProject::testLocalUrlFiles()
 
 }
 
+void TestQgsProject::testReadLayersInParallel()
+{
+  const QString layerPath = QStringLiteral( TEST_DATA_DIR ) + QStringLiteral( "/points.shp" );
+  const QString linesPath = QStringLiteral( TEST_DATA_DIR ) + QStringLiteral( "/lines.shp" );
+  QgsProject prj;
+  QStringList layerIds;
+  for ( int i = 0; i < 6; ++i )
+  {
+    QgsVectorLayer *layer = new QgsVectorLayer( i % 2 ? layerPath : linesPath, QStringLiteral( "layer %1" ).arg( i ), QStringLiteral( "ogr" ) );
+    QVERIFY( layer->isValid() );
+    prj.addMapLayer( layer );
+    layerIds << layer->id();
+  }
+  QgsVectorLayer *memoryLayer = new QgsVectorLayer( QStringLiteral( "Point?field=name:string" ), QStringLiteral( "memory" ), QStringLiteral( "memory" ) );
+  prj.addMapLayer( memoryLayer );
+  layerIds << memoryLayer->id();
+
+  QTemporaryFile f;
+  QVERIFY( f.open() );
+  f.close();
+  prj.setFileName( f.fileName() );
+  QVERIFY( prj.write() );
+
+  // the layers read in background threads are added in the same order, and owned by the thread of the project
+  QgsProject prj2;
+  QSignalSpy spyLayersAdded( &prj2, &QgsProject::layerWasAdded );
+  QVERIFY( prj2.read( f.fileName(), QgsProject::ReadFlag::FlagReadLayersInParallel ) );
+  QCOMPARE( prj2.layerTreeRoot()->findLayerIds(), layerIds );
+  QCOMPARE( spyLayersAdded.count(), layerIds.count() );
+  for ( const QString &id : qgis::as_const( layerIds ) )
+  {
+    QgsVectorLayer *layer = qobject_cast< QgsVectorLayer * >( prj2.mapLayer( id ) );
+    QVERIFY( layer );
+    QVERIFY( layer->isValid() );
+    QCOMPARE( layer->thread(), prj2.thread() );
+    QCOMPARE( layer->dataProvider()->thread(), prj2.thread() );
+    QCOMPARE( layer->featureCount(), qobject_cast< QgsVectorLayer * >( prj.mapLayer( id ) )->featureCount() );
+  }
+}
+
 void TestQgsProject::testReadFlags()
 {
   QString project1Path = QString( TEST_DATA_DIR ) + QStringLiteral( "/embedded_groups/project1.qgs" );
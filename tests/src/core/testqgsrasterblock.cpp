@@ -39,6 +39,7 @@ class TestQgsRasterBlock : public QObject
 
     void testBasic();
     void testWrite();
+    void testTypedAccess();
 
   private:
 
@@ -242,6 +243,60 @@ void TestQgsRasterBlock::testWrite()
   delete block;
 }
 
+///@cond PRIVATE
+struct TestSum
+{
+  template <typename T>
+  void operator()( const T *values, qgssize count )
+  {
+    for ( qgssize i = 0; i < count; ++i )
+      sum += values[i];
+  }
+  double sum = 0;
+};
+///@endcond
+
+void TestQgsRasterBlock::testTypedAccess()
+{
+  QgsRasterBlock block( Qgis::UInt16, 4, 3 );
+  for ( int i = 0; i < 12; ++i )
+    block.setValue( i, i * 1000 );
+
+  QVERIFY( block.typedData< quint16 >() );
+  QVERIFY( !block.typedData< qint16 >() );
+  QVERIFY( !block.typedData< float >() );
+  QCOMPARE( block.typedRow< quint16 >( 1 )[2], static_cast< quint16 >( 6000 ) );
+  QVERIFY( !block.typedRow< quint16 >( 3 ) );
+  block.typedRow< quint16 >( 2 )[0] = 42;
+  QCOMPARE( block.value( 2, 0 ), 42.0 );
+
+  TestSum sum;
+  QVERIFY( block.apply( sum ) );
+  QCOMPARE( sum.sum, 66000.0 - 8000 + 42 );
+  TestSum rowSum;
+  QVERIFY( block.apply( rowSum, 1, 1 ) );
+  QCOMPARE( rowSum.sum, 22000.0 );
+  QVERIFY( !block.apply( rowSum, 2, 2 ) );
+
+  // no data value
+  QCOMPARE( block.noDataMask(), QByteArray( 12, 0 ) );
+  block.setNoDataValue( 5000 );
+  QByteArray mask = block.noDataMask();
+  QCOMPARE( mask.size(), 12 );
+  for ( int i = 0; i < 12; ++i )
+    QCOMPARE( static_cast< bool >( mask.at( i ) ), block.isNoData( i ) );
+  QCOMPARE( block.noDataMask( 1, 1 ), QByteArray( "\x00\x01\x00\x00", 4 ) );
+
+  // no data bitmap
+  QgsRasterBlock bitmapBlock( Qgis::Float32, 10, 2 );
+  bitmapBlock.setIsNoData( 1, 9 );
+  bitmapBlock.setIsNoData( 0, 3 );
+  mask = bitmapBlock.noDataMask();
+  for ( int i = 0; i < 20; ++i )
+    QCOMPARE( static_cast< bool >( mask.at( i ) ), bitmapBlock.isNoData( i ) );
+  QCOMPARE( mask.count( '\x01' ), 2 );
+}
+
 QGSTEST_MAIN( TestQgsRasterBlock )
 
 #include "testqgsrasterblock.moc"
@@ -51,6 +51,7 @@ class TestQgsRasterFileWriter: public QObject
     void testCreateOneBandRaster();
     void testCreateMultiBandRaster();
     void testVrtCreation();
+    void testTiledCompressedGeoTiff();
   private:
     bool writeTest( const QString &rasterName );
     void log( const QString &msg );
@@ -324,6 +325,40 @@ void TestQgsRasterFileWriter::testVrtCreation()
   QGSCOMPARENEAR( yminVrt, yminOriginal, srcRasterLayer->rasterUnitsPerPixelY() / 4 );
 }
 
+void TestQgsRasterFileWriter::testTiledCompressedGeoTiff()
+{
+  QString srcFileName = mTestDataDir + QStringLiteral( "ALLINGES_RGF93_CC46_1_1.tif" );
+  std::unique_ptr< QgsRasterLayer > srcRasterLayer = qgis::make_unique< QgsRasterLayer >( srcFileName, QStringLiteral( "src" ) );
+  QVERIFY( srcRasterLayer->isValid() );
+
+  QTemporaryDir dir;
+  const QString fileName = dir.path() + QStringLiteral( "/tiled.tif" );
+  QgsRasterFileWriter writer( fileName );
+  writer.setOutputFormat( QStringLiteral( "GTiff" ) );
+  writer.setCreateOptions( QStringList() << QStringLiteral( "TILED=YES" ) << QStringLiteral( "COMPRESS=DEFLATE" ) << QStringLiteral( "BLOCKXSIZE=128" ) << QStringLiteral( "BLOCKYSIZE=128" ) );
+  // parts are aligned on the blocks, 384 pixels rather than 500
+  writer.setMaxTileWidth( 500 );
+  writer.setMaxTileHeight( 500 );
+
+  QgsRasterPipe pipe;
+  pipe.set( srcRasterLayer->dataProvider()->clone() );
+  QgsRasterFileWriter::WriterError res = writer.writeRaster( &pipe, srcRasterLayer->width(), srcRasterLayer->height(), srcRasterLayer->extent(), srcRasterLayer->crs(), srcRasterLayer->transformContext() );
+  QCOMPARE( res, QgsRasterFileWriter::NoError );
+
+  std::unique_ptr< QgsRasterLayer > outputLayer = qgis::make_unique< QgsRasterLayer >( fileName, QStringLiteral( "output" ) );
+  QVERIFY( outputLayer->isValid() );
+  QCOMPARE( outputLayer->width(), srcRasterLayer->width() );
+  QCOMPARE( outputLayer->height(), srcRasterLayer->height() );
+
+  std::unique_ptr< QgsRasterBlock > srcBlock( srcRasterLayer->dataProvider()->block( 1, srcRasterLayer->extent(), srcRasterLayer->width(), srcRasterLayer->height() ) );
+  std::unique_ptr< QgsRasterBlock > outputBlock( outputLayer->dataProvider()->block( 1, outputLayer->extent(), outputLayer->width(), outputLayer->height() ) );
+  for ( int row = 0; row < srcRasterLayer->height(); row += 7 )
+  {
+    for ( int col = 0; col < srcRasterLayer->width(); col += 7 )
+      QCOMPARE( outputBlock->value( row, col ), srcBlock->value( row, col ) );
+  }
+}
+
 void TestQgsRasterFileWriter::log( const QString &msg )
 {
   mReport += msg + "<br>";
@@ -45,6 +45,7 @@
 #include "qgsrastertransparency.h"
 #include "qgspalettedrasterrenderer.h"
 #include "qgsrasterlayertemporalproperties.h"
+#include "qgsmaprenderersequentialjob.h"
 
 //qgis unit test includes
 #include <qgsrenderchecker.h>
@@ -78,8 +79,10 @@ class TestQgsRasterLayer : public QObject
     void colorRamp4();
     void landsatBasic();
     void landsatBasic875Qml();
+    void parallelRendering();
     void checkDimensions();
     void checkStats();
+    void checkGenericStats();
     void checkScaleOffset();
     void buildExternalOverviews();
     void registry();
@@ -373,6 +376,41 @@ void TestQgsRasterLayer::landsatBasic()
   QVERIFY( render( "landsat_basic" ) );
 }
 
+void TestQgsRasterLayer::parallelRendering()
+{
+  QVERIFY2( mpLandsatRasterLayer->isValid(), "landsat.tif layer is not valid!" );
+  mpLandsatRasterLayer->setContrastEnhancement( QgsContrastEnhancement::StretchToMinimumMaximum, QgsRasterMinMaxOrigin::MinMax );
+  QgsMapSettings settings;
+  settings.setLayers( QList<QgsMapLayer *>() << mpLandsatRasterLayer );
+  settings.setDestinationCrs( mpLandsatRasterLayer->crs() );
+  settings.setExtent( mpLandsatRasterLayer->extent() );
+  settings.setOutputSize( QSize( 600, 1024 ) );
+  auto render = [ &settings ]
+  {
+    QgsMapRendererSequentialJob job( settings );
+    job.start();
+    job.waitForFinished();
+    return job.renderedImage();
+  };
+
+  const QImage sequential = render();
+  settings.setFlag( QgsMapSettings::ParallelRasterRendering );
+  const QImage parallel = render();
+  QCOMPARE( parallel.size(), sequential.size() );
+
+  // the extents of the bands are rounded, pixels may only differ along their limits
+  int mismatches = 0;
+  for ( int y = 0; y < parallel.height(); ++y )
+  {
+    for ( int x = 0; x < parallel.width(); ++x )
+    {
+      if ( parallel.pixel( x, y ) != sequential.pixel( x, y ) )
+        mismatches++;
+    }
+  }
+  QVERIFY( mismatches <= parallel.width() * 1024 / 256 );
+}
+
 void TestQgsRasterLayer::landsatBasic875Qml()
 {
   QVERIFY2( mpLandsatRasterLayer->isValid(), "landsat.tif layer is not valid!" );
@@ -454,6 +492,50 @@ void TestQgsRasterLayer::checkStats()
   QGSCOMPARENEAR( myStatistics.stdDev, 0.707107, 0.00001 );
 }
 
+void TestQgsRasterLayer::checkGenericStats()
+{
+  // a user no data value makes the statistics computed by the generic, block parallel, method
+  std::unique_ptr< QgsRasterDataProvider > provider( mpLandsatRasterLayer->dataProvider()->clone() );
+  provider->setUserNoDataValue( 1, QgsRasterRangeList() << QgsRasterRange( 1000, 1000 ) );
+  const QgsRasterBandStats stats = provider->bandStatistics( 1, QgsRasterBandStats::All );
+
+  // compared with a serial scan of the whole band
+  std::unique_ptr< QgsRasterBlock > block( provider->block( 1, provider->extent(), provider->xSize(), provider->ySize() ) );
+  double minimum = std::numeric_limits<double>::max();
+  double maximum = std::numeric_limits<double>::lowest();
+  double sum = 0;
+  double sumOfSquares = 0;
+  qgssize count = 0;
+  for ( qgssize i = 0; i < static_cast< qgssize >( block->width() ) * block->height(); ++i )
+  {
+    bool isNoData = false;
+    const double value = block->valueAndNoData( i, isNoData );
+    if ( isNoData )
+      continue;
+    minimum = std::min( minimum, value );
+    maximum = std::max( maximum, value );
+    sum += value;
+    sumOfSquares += value * value;
+    count++;
+  }
+  const double mean = sum / count;
+  QCOMPARE( stats.elementCount, count );
+  QCOMPARE( stats.minimumValue, minimum );
+  QCOMPARE( stats.maximumValue, maximum );
+  QGSCOMPARENEAR( stats.sum, sum, 0.001 );
+  QGSCOMPARENEAR( stats.mean, mean, 0.000001 );
+  QGSCOMPARENEAR( stats.stdDev, std::sqrt( ( sumOfSquares - count * mean * mean ) / ( count - 1 ) ), 0.0001 );
+
+  // the histogram counts the same values
+  const QgsRasterHistogram histogram = provider->histogram( 1, 100, minimum, maximum );
+  QVERIFY( histogram.valid );
+  QCOMPARE( histogram.nonNullCount, static_cast< int >( count ) );
+  int histogramCount = 0;
+  for ( int binCount : histogram.histogramVector )
+    histogramCount += binCount;
+  QCOMPARE( histogramCount, static_cast< int >( count ) );
+}
+
 // test scale_factor and offset - uses netcdf file which may not be supported
 // see https://github.com/qgis/QGIS/issues/17186
 void TestQgsRasterLayer::checkScaleOffset()
@@ -22,6 +22,8 @@
 #include <qgsreadwritecontext.h>
 #include <qgssymbol.h>
 #include <qgsvectorlayer.h>
+#include "qgsexpressioncontextutils.h"
+#include "qgsrulebasedrendererfilterindex_p.h"
 
 typedef QgsRuleBasedRenderer::Rule RRule;
 
@@ -179,7 +181,79 @@ class TestQgsRuleBasedRenderer: public QObject
 
     }
 
-  private:
+    void test_filter_index()
+    {
+      QgsFields fields;
+      fields.append( QgsField( QStringLiteral( "cat" ), QVariant::Int ) );
+      fields.append( QgsField( QStringLiteral( "value" ), QVariant::Double ) );
+      fields.append( QgsField( QStringLiteral( "name" ), QVariant::String ) );
+
+      auto checkCandidates = [&fields]( const QStringList & expressions, const QString & field, const QVariantList & values )
+      {
+        std::vector< std::unique_ptr< QgsExpression > > filters;
+        QList< const QgsExpression * > filterPointers;
+        for ( const QString &expression : expressions )
+        {
+          filters.emplace_back( qgis::make_unique< QgsExpression >( expression ) );
+          filterPointers << filters.back().get();
+        }
+        std::unique_ptr< QgsRuleBasedRendererFilterIndex > index = QgsRuleBasedRendererFilterIndex::create( filterPointers, fields );
+        QVERIFY( index );
+
+        QgsExpressionContext context;
+        context.appendScope( QgsExpressionContextUtils::globalScope() );
+        for ( const QVariant &value : values )
+        {
+          QgsFeature feature( fields );
+          feature.setAttribute( field, value );
+          context.setFeature( feature );
+          QVector< int > candidates;
+          QVERIFY( index->candidates( feature, candidates ) );
+          for ( int rule = 0; rule < expressions.size(); ++rule )
+          {
+            // every matching rule is a candidate
+            if ( filters[ rule ]->evaluate( &context ).toBool() )
+              QVERIFY( candidates.contains( rule ) );
+          }
+          QVERIFY( candidates.size() <= 2 );
+        }
+      };
+
+      QStringList equalities;
+      for ( int i = 0; i < 20; ++i )
+        equalities << QStringLiteral( "\"cat\" = %1" ).arg( i );
+      equalities << QStringLiteral( "\"cat\" IN (100, -3, '25')" ) << QStringLiteral( "'40' = \"cat\"" );
+      checkCandidates( equalities, QStringLiteral( "cat" ), QVariantList() << 0 << 5 << 19 << 20 << 100 << -3 << 25 << 40 << QVariant( QVariant::Int ) );
+
+      QStringList names;
+      for ( int i = 0; i < 20; ++i )
+        names << QStringLiteral( "\"name\" = 'name %1'" ).arg( i );
+      names << QStringLiteral( "\"name\" = 5" );
+      checkCandidates( names, QStringLiteral( "name" ), QVariantList() << QStringLiteral( "name 3" ) << QStringLiteral( "5" ) << QStringLiteral( "5.0" ) << QStringLiteral( "other" ) );
+
+      QStringList ranges;
+      for ( int i = 0; i < 20; ++i )
+        ranges << QStringLiteral( "\"value\" >= %1 AND \"value\" <= %2" ).arg( i * 1.5 ).arg( ( i + 1 ) * 1.5 );
+      ranges << QStringLiteral( "\"value\" > 30" ) << QStringLiteral( "-1.5 > \"value\"" );
+      checkCandidates( ranges, QStringLiteral( "value" ), QVariantList() << 0.0 << 1.5 << 2.25 << 29.9 << 30.0 << 45.0 << -1.0 << -2.0 );
+
+      // filters which do not compare a single field with constants are not indexed
+      QStringList unsupported = equalities;
+      unsupported << QStringLiteral( "\"cat\" * 2 = 4" );
+      std::vector< std::unique_ptr< QgsExpression > > filters;
+      QList< const QgsExpression * > filterPointers;
+      for ( const QString &expression : qgis::as_const( unsupported ) )
+      {
+        filters.emplace_back( qgis::make_unique< QgsExpression >( expression ) );
+        filterPointers << filters.back().get();
+      }
+      QVERIFY( !QgsRuleBasedRendererFilterIndex::create( filterPointers, fields ) );
+      filterPointers.replace( filterPointers.size() - 1, filterPointers.at( 0 ) );
+      QgsExpression otherField( QStringLiteral( "\"value\" = 4" ) );
+      filterPointers.replace( 1, &otherField );
+      QVERIFY( !QgsRuleBasedRendererFilterIndex::create( filterPointers, fields ) );
+    }
+
     void xml2domElement( const QString &testFile, QDomDocument &doc )
     {
       QString fileName = QStringLiteral( TEST_DATA_DIR ) + '/' + testFile;
@@ -26,6 +26,7 @@ class TestQgsRuntimeProfiler: public QObject
     void initTestCase();
     void cleanupTestCase();
     void testGroups();
+    void record();
     void threading();
 
 };
@@ -90,6 +91,24 @@ void TestQgsRuntimeProfiler::testGroups()
 }
 
 
+void TestQgsRuntimeProfiler::record()
+{
+  QgsRuntimeProfiler profiler;
+
+  profiler.record( QStringLiteral( "task 1" ), 0.5, QStringLiteral( "group 1" ) );
+  QVERIFY( !profiler.groupIsActive( QStringLiteral( "group 1" ) ) );
+  QVERIFY( profiler.groups().contains( QStringLiteral( "group 1" ) ) );
+  QCOMPARE( profiler.profileTime( QStringLiteral( "task 1" ), QStringLiteral( "group 1" ) ), 0.5 );
+
+  // recorded as a child of the current task
+  profiler.start( QStringLiteral( "task 2" ), QStringLiteral( "group 1" ) );
+  profiler.record( QStringLiteral( "task 2a" ), 0.25, QStringLiteral( "group 1" ) );
+  profiler.end( QStringLiteral( "group 1" ) );
+
+  QCOMPARE( profiler.childGroups( QString(), QStringLiteral( "group 1" ) ), QStringList() << QStringLiteral( "task 1" ) << QStringLiteral( "task 2" ) );
+  QCOMPARE( profiler.childGroups( QStringLiteral( "task 2" ), QStringLiteral( "group 1" ) ), QStringList() << QStringLiteral( "task 2a" ) );
+  QCOMPARE( profiler.profileTime( QStringLiteral( "task 2/task 2a" ), QStringLiteral( "group 1" ) ), 0.25 );
+}
 
 class ProfileInThread : public QThread
 {
@@ -20,6 +20,7 @@
 #include <QFileInfo>
 #include <QDir>
 #include <QDesktopServices>
+#include <QPainter>
 
 //qgis includes...
 #include <qgsmaplayer.h>
@@ -31,6 +32,7 @@
 #include <qgssinglesymbolrenderer.h>
 #include "qgsmarkersymbollayer.h"
 #include "qgsproperty.h"
+#include "qgsrendercontext.h"
 
 //qgis test includes
 #include "qgsrenderchecker.h"
@@ -81,6 +83,7 @@ class TestQgsSimpleMarkerSymbol : public QObject
     void boundsWithRotation();
     void boundsWithRotationAndOffset();
     void colors();
+    void dataDefinedSprites();
 
   private:
     bool mTestHasError =  false ;
@@ -333,6 +336,73 @@ void TestQgsSimpleMarkerSymbol::colors()
   QCOMPARE( marker.strokeColor(), QColor( 250, 250, 250 ) );
 }
 
+void TestQgsSimpleMarkerSymbol::dataDefinedSprites()
+{
+  // markers with data defined properties drawn to screen with the sprite cache must
+  // look like the markers drawn as vectors
+  QgsFields fields;
+  fields.append( QgsField( QStringLiteral( "angle" ), QVariant::Double ) );
+  fields.append( QgsField( QStringLiteral( "size" ), QVariant::Double ) );
+  fields.append( QgsField( QStringLiteral( "color" ), QVariant::String ) );
+
+  auto render = [ = ]( bool forceVectorOutput )
+  {
+    QgsMarkerSymbol symbol;
+    QgsSimpleMarkerSymbolLayer *layer = new QgsSimpleMarkerSymbolLayer( QgsSimpleMarkerSymbolLayerBase::Triangle );
+    layer->setSizeUnit( QgsUnitTypes::RenderPixels );
+    layer->setStrokeWidthUnit( QgsUnitTypes::RenderPixels );
+    layer->setStrokeWidth( 1 );
+    layer->setStrokeColor( Qt::black );
+    layer->setDataDefinedProperty( QgsSymbolLayer::PropertyAngle, QgsProperty::fromField( QStringLiteral( "angle" ) ) );
+    layer->setDataDefinedProperty( QgsSymbolLayer::PropertySize, QgsProperty::fromField( QStringLiteral( "size" ) ) );
+    layer->setDataDefinedProperty( QgsSymbolLayer::PropertyFillColor, QgsProperty::fromField( QStringLiteral( "color" ) ) );
+    symbol.changeSymbolLayer( 0, layer );
+
+    QImage image( 400, 400, QImage::Format_ARGB32_Premultiplied );
+    image.fill( Qt::white );
+    QPainter painter( &image );
+    QgsRenderContext context = QgsRenderContext::fromQPainter( &painter );
+    context.setForceVectorOutput( forceVectorOutput );
+    context.setFlag( QgsRenderContext::Antialiasing, true );
+    context.expressionContext().setFields( fields );
+
+    symbol.startRender( context, fields );
+    for ( int i = 0; i < 100; ++i )
+    {
+      QgsFeature feature( fields, i );
+      // the same sizes, angles and colors are repeated to share sprites
+      feature.setAttributes( QgsAttributes() << ( i % 7 ) * 13.0 << 10.0 + ( i % 5 ) * 4 << ( i % 2 ? QStringLiteral( "255,0,0" ) : QStringLiteral( "0,0,255" ) ) );
+      context.expressionContext().setFeature( feature );
+      // pixel centers, the sprites are not positioned below the pixel
+      symbol.renderPoint( QPointF( 20.5 + ( i % 10 ) * 40, 20.5 + ( i / 10 ) * 40 ), &feature, context );
+    }
+    symbol.stopRender( context );
+    painter.end();
+    return image;
+  };
+
+  const QImage vector = render( true );
+  const QImage sprites = render( false );
+
+  int painted = 0;
+  int mismatches = 0;
+  for ( int y = 0; y < vector.height(); ++y )
+  {
+    for ( int x = 0; x < vector.width(); ++x )
+    {
+      const QRgb expected = vector.pixel( x, y );
+      const QRgb actual = sprites.pixel( x, y );
+      if ( expected != qRgb( 255, 255, 255 ) )
+        painted++;
+      if ( std::abs( qRed( expected ) - qRed( actual ) ) > 128 || std::abs( qGreen( expected ) - qGreen( actual ) ) > 128
+           || std::abs( qBlue( expected ) - qBlue( actual ) ) > 128 )
+        mismatches++;
+    }
+  }
+  QVERIFY( painted > 0 );
+  QVERIFY2( mismatches < painted / 20, QStringLiteral( "%1 of %2 pixels differ" ).arg( mismatches ).arg( painted ).toLocal8Bit().constData() );
+}
+
 //
 // Private helper functions not called directly by CTest
 //
@@ -0,0 +1,196 @@
+/***************************************************************************
+     testqgssimplifiedgeometrycache.cpp
+     ----------------------------------
+    Date                 : October 2020
+    Copyright            : (C) 2020 by the QGIS project
+    Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgstest.h"
+#include <QElapsedTimer>
+#include <QObject>
+
+#include "qgsapplication.h"
+#include "qgsfeatureiterator.h"
+#include "qgsgeometry.h"
+#include "qgslinestring.h"
+#include "qgsmaprenderersequentialjob.h"
+#include "qgsmapsettings.h"
+#include "qgssimplifiedgeometrycache.h"
+#include "qgssimplifymethod.h"
+#include "qgstaskmanager.h"
+#include "qgsvectorlayer.h"
+
+class TestQgsSimplifiedGeometryCache: public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void levels();
+    void requests();
+    void eviction();
+    void layer();
+};
+
+void TestQgsSimplifiedGeometryCache::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsSimplifiedGeometryCache::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+void TestQgsSimplifiedGeometryCache::levels()
+{
+  QCOMPARE( QgsSimplifiedGeometryCache::levelForTolerance( 1 ), 0 );
+  QCOMPARE( QgsSimplifiedGeometryCache::levelForTolerance( 3 ), 1 );
+  QCOMPARE( QgsSimplifiedGeometryCache::levelForTolerance( 4 ), 2 );
+  QCOMPARE( QgsSimplifiedGeometryCache::levelForTolerance( 0.001 ), -10 );
+  QCOMPARE( QgsSimplifiedGeometryCache::levelTolerance( 1 ), 2.0 );
+  QCOMPARE( QgsSimplifiedGeometryCache::levelTolerance( -2 ), 0.25 );
+}
+
+void TestQgsSimplifiedGeometryCache::requests()
+{
+  QgsSimplifiedGeometryCache cache;
+  cache.setLayerExtent( QgsRectangle( 0, 0, 100, 100 ) );
+
+  // a small part of the layer is not worth a level
+  cache.requestLevel( 1, QgsRectangle( 0, 0, 10, 10 ) );
+  QVERIFY( cache.takeRequestedLevels().isEmpty() );
+
+  cache.requestLevel( 1, QgsRectangle( -50, -50, 80, 80 ) );
+  cache.requestLevel( 2, QgsRectangle() );
+  QList<int> levels = cache.takeRequestedLevels();
+  std::sort( levels.begin(), levels.end() );
+  QCOMPARE( levels, QList<int>() << 1 << 2 );
+
+  // levels being built are not requested again
+  cache.requestLevel( 1, QgsRectangle() );
+  QVERIFY( cache.takeRequestedLevels().isEmpty() );
+
+  QHash<QgsFeatureId, QgsGeometry> geometries;
+  geometries.insert( 1, QgsGeometry::fromWkt( QStringLiteral( "Point (1 2)" ) ) );
+  const int generation = cache.generation();
+  QVERIFY( cache.insertLevel( 1, generation, geometries, 100 ) );
+  cache.abortLevel( 2, generation );
+
+  QHash<QgsFeatureId, QgsGeometry> cached;
+  QVERIFY( cache.geometries( 1, cached ) );
+  QCOMPARE( cached.value( 1 ).asWkt(), QStringLiteral( "Point (1 2)" ) );
+  QVERIFY( !cache.geometries( 2, cached ) );
+  cache.requestLevel( 1, QgsRectangle() );
+  cache.requestLevel( 2, QgsRectangle() );
+  QCOMPARE( cache.takeRequestedLevels(), QList<int>() << 2 );
+
+  // levels built before the cache was cleared are discarded
+  cache.clear();
+  QVERIFY( !cache.geometries( 1, cached ) );
+  QVERIFY( !cache.insertLevel( 1, generation, geometries, 100 ) );
+  QVERIFY( !cache.geometries( 1, cached ) );
+}
+
+void TestQgsSimplifiedGeometryCache::eviction()
+{
+  QgsSimplifiedGeometryCache cache;
+  cache.setMaximumCost( 250 );
+  QHash<QgsFeatureId, QgsGeometry> cached;
+
+  QVERIFY( cache.insertLevel( 1, 0, QHash<QgsFeatureId, QgsGeometry>(), 100 ) );
+  QVERIFY( cache.insertLevel( 2, 0, QHash<QgsFeatureId, QgsGeometry>(), 100 ) );
+  QVERIFY( cache.geometries( 1, cached ) );
+
+  // level 2 is the least recently used one
+  QVERIFY( cache.insertLevel( 3, 0, QHash<QgsFeatureId, QgsGeometry>(), 100 ) );
+  QVERIFY( cache.geometries( 1, cached ) );
+  QVERIFY( !cache.geometries( 2, cached ) );
+  QVERIFY( cache.geometries( 3, cached ) );
+
+  // too large levels are not stored, nor requested again
+  QVERIFY( !cache.insertLevel( 4, 0, QHash<QgsFeatureId, QgsGeometry>(), 300 ) );
+  QVERIFY( !cache.geometries( 4, cached ) );
+  cache.requestLevel( 4, QgsRectangle() );
+  QVERIFY( cache.takeRequestedLevels().isEmpty() );
+}
+
+void TestQgsSimplifiedGeometryCache::layer()
+{
+  QgsVectorLayer layer( QStringLiteral( "LineString?crs=EPSG:3857&field=id:integer" ), QStringLiteral( "lines" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer.isValid() );
+
+  // a detailed line, with vertices every 0.1 units
+  QgsPointSequence points;
+  for ( int i = 0; i <= 1000; ++i )
+    points << QgsPoint( i * 0.1, ( i % 2 ) * 0.05 );
+  QgsFeature feature( layer.fields() );
+  feature.setAttributes( QgsAttributes() << 1 );
+  feature.setGeometry( QgsGeometry( new QgsLineString( points ) ) );
+  QVERIFY( layer.dataProvider()->addFeature( feature ) );
+  layer.updateExtents();
+
+  QgsSimplifyMethod simplifyMethod;
+  simplifyMethod.setMethodType( QgsSimplifyMethod::OptimizeForRendering );
+  simplifyMethod.setTolerance( 5 );
+  QgsFeatureRequest request;
+  request.setFilterRect( QgsRectangle( -10, -10, 110, 10 ) );
+  request.setSimplifyMethod( simplifyMethod );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setDestinationCrs( layer.crs() );
+  mapSettings.setExtent( QgsRectangle( -10, -10, 110, 10 ) );
+  mapSettings.setOutputSize( QSize( 64, 64 ) );
+  mapSettings.setLayers( QList< QgsMapLayer * >() << &layer );
+  auto render = [ &mapSettings ]
+  {
+    QgsMapRendererSequentialJob job( mapSettings );
+    job.start();
+    job.waitForFinished();
+  };
+  render();
+
+  // the first fetch requests the level, which is built when the layer is rendered again
+  QgsFeature fetched;
+  QVERIFY( layer.getFeatures( request ).nextFeature( fetched ) );
+  QCOMPARE( fetched.geometry().constGet()->nCoordinates(), 1001 );
+  render();
+
+  QElapsedTimer timer;
+  timer.start();
+  while ( QgsApplication::taskManager()->countActiveTasks() > 0 && timer.elapsed() < 10000 )
+    QCoreApplication::processEvents();
+  QCoreApplication::processEvents();
+
+  // the geometry simplified with a tolerance of 4 is taken from the cache
+  QVERIFY( layer.getFeatures( request ).nextFeature( fetched ) );
+  QCOMPARE( fetched.attribute( 0 ).toInt(), 1 );
+  QVERIFY( fetched.geometry().constGet()->nCoordinates() < 1001 );
+  QVERIFY( fetched.geometry().constGet()->nCoordinates() >= 2 );
+
+  // not for the requests needing the exact geometries
+  request.setFlags( QgsFeatureRequest::ExactIntersect );
+  QVERIFY( layer.getFeatures( request ).nextFeature( fetched ) );
+  QCOMPARE( fetched.geometry().constGet()->nCoordinates(), 1001 );
+
+  // committed changes clear the cache
+  QVERIFY( layer.startEditing() );
+  QVERIFY( layer.changeAttributeValue( fetched.id(), 0, 2 ) );
+  QVERIFY( layer.commitChanges() );
+  request.setFlags( QgsFeatureRequest::Flags() );
+  QVERIFY( layer.getFeatures( request ).nextFeature( fetched ) );
+  QCOMPARE( fetched.attribute( 0 ).toInt(), 2 );
+  QCOMPARE( fetched.geometry().constGet()->nCoordinates(), 1001 );
+}
+
+QGSTEST_MAIN( TestQgsSimplifiedGeometryCache )
+#include "testqgssimplifiedgeometrycache.moc"
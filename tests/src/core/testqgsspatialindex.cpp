@@ -427,6 +427,51 @@ class TestQgsSpatialIndex : public QObject
       QCOMPARE( i2.nearestNeighbor( g, 2, 0.2 ), QList< QgsFeatureId >() );
     }
 
+    void testMemoryProviderIndex()
+    {
+      QgsVectorLayer layer( QStringLiteral( "Point?index=yes" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+      QVERIFY( layer.isValid() );
+      QCOMPARE( layer.dataProvider()->hasSpatialIndex(), QgsFeatureSource::SpatialIndexPresent );
+      QgsFeatureList features = _pointFeatures();
+      QVERIFY( layer.dataProvider()->addFeatures( features ) );
+
+      auto intersects = [&layer]( const QgsRectangle & rect ) -> QList< QgsFeatureId >
+      {
+        QList< QgsFeatureId > ids;
+        QgsFeatureIterator it = layer.dataProvider()->getFeatures( QgsFeatureRequest().setFilterRect( rect ) );
+        QgsFeature f;
+        while ( it.nextFeature( f ) )
+          ids << f.id();
+        return ids;
+      };
+
+      // the index is loaded again after each edit, and the features are returned in the order of their ids
+      QCOMPARE( intersects( QgsRectangle( 0, 0, 10, 10 ) ), QList< QgsFeatureId >() << 1 );
+      QCOMPARE( intersects( QgsRectangle( -10, -10, 10, 10 ) ), QList< QgsFeatureId >() << 1 << 2 << 3 << 4 );
+
+      QgsGeometryMap geometries;
+      geometries.insert( 1, QgsGeometry::fromPointXY( QgsPointXY( -1, -2 ) ) );
+      QVERIFY( layer.dataProvider()->changeGeometryValues( geometries ) );
+      QCOMPARE( intersects( QgsRectangle( 0, 0, 10, 10 ) ), QList< QgsFeatureId >() );
+      QCOMPARE( intersects( QgsRectangle( -10, -10, 0, 0 ) ), QList< QgsFeatureId >() << 1 << 3 );
+
+      QVERIFY( layer.dataProvider()->deleteFeatures( QgsFeatureIds() << 3 ) );
+      QCOMPARE( intersects( QgsRectangle( -10, -10, 0, 0 ) ), QList< QgsFeatureId >() << 1 );
+
+      // a source created before an edit keeps reading the features as they were
+      std::unique_ptr< QgsAbstractFeatureSource > source( layer.dataProvider()->featureSource() );
+      features = QgsFeatureList() << _pointFeature( 0, 5, 5 );
+      QVERIFY( layer.dataProvider()->addFeatures( features ) );
+      QCOMPARE( intersects( QgsRectangle( 0, 0, 10, 10 ) ), QList< QgsFeatureId >() << 5 );
+      QgsFeatureIterator it = source->getFeatures( QgsFeatureRequest().setFilterRect( QgsRectangle( 0, 0, 10, 10 ) ) );
+      QgsFeature f;
+      QVERIFY( !it.nextFeature( f ) );
+
+      QVERIFY( layer.dataProvider()->truncate() );
+      QCOMPARE( intersects( QgsRectangle( -10, -10, 10, 10 ) ), QList< QgsFeatureId >() );
+      QCOMPARE( layer.dataProvider()->hasSpatialIndex(), QgsFeatureSource::SpatialIndexPresent );
+    }
+
 };
 
 QGSTEST_MAIN( TestQgsSpatialIndex )
@@ -0,0 +1,280 @@
+/***************************************************************************
+     testqgsspatialindexpackedrtree.cpp
+     ----------------------------------
+    Date                 : October 2020
+    Copyright            : (C) 2020 by the QGIS project
+    Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include <QBuffer>
+#include <QObject>
+#include <QString>
+#include <QTemporaryDir>
+#include <QThreadPool>
+
+#include <qgsapplication.h>
+#include "qgsfeatureiterator.h"
+#include "qgsgeometry.h"
+#include "qgssettings.h"
+#include "qgsspatialindexcache.h"
+#include "qgsspatialindexpackedrtree.h"
+#include "qgsvectordataprovider.h"
+#include "qgsvectorlayer.h"
+
+#include <algorithm>
+#include <random>
+
+static QgsFeature _pointFeature( QgsFeatureId id, qreal x, qreal y )
+{
+  QgsFeature f( id );
+  QgsGeometry g = QgsGeometry::fromPointXY( QgsPointXY( x, y ) );
+  f.setGeometry( g );
+  return f;
+}
+
+static QList<QgsFeature> _pointFeatures()
+{
+  /*
+   *  2   |   1
+   *      |
+   * -----+-----
+   *      |
+   *  3   |   4
+   */
+
+  QList<QgsFeature> feats;
+  feats << _pointFeature( 1,  1,  1 )
+        << _pointFeature( 2, -1,  1 )
+        << _pointFeature( 3, -1, -1 )
+        << _pointFeature( 4,  1, -1 );
+  return feats;
+}
+
+class TestQgsSpatialIndexPackedRTree : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+
+    void initTestCase()
+    {
+      QgsApplication::init();
+      QgsApplication::initQgis();
+    }
+    void cleanupTestCase()
+    {
+      QgsApplication::exitQgis();
+    }
+
+    void testQuery()
+    {
+      QgsVectorLayer *vl = new QgsVectorLayer( "Point", "x", "memory" );
+      for ( QgsFeature f : _pointFeatures() )
+        vl->dataProvider()->addFeature( f );
+      QgsSpatialIndexPackedRTree index( *vl->dataProvider() );
+      QVERIFY( index.size() == 4 );
+      QCOMPARE( index.extent(), QgsRectangle( -1, -1, 1, 1 ) );
+
+      QList<QgsFeatureId> fids = index.intersects( QgsRectangle( 0, 0, 10, 10 ) );
+      QCOMPARE( fids, QList< QgsFeatureId >() << 1 );
+
+      fids = index.intersects( QgsRectangle( -10, -10, 0, 10 ) );
+      std::sort( fids.begin(), fids.end() );
+      QCOMPARE( fids, QList< QgsFeatureId >() << 2 << 3 );
+
+      QVERIFY( index.intersects( QgsRectangle( 2, 2, 10, 10 ) ).isEmpty() );
+
+      QCOMPARE( index.nearestNeighbor( QgsPointXY( 0.8, -0.9 ) ), QList< QgsFeatureId >() << 4 );
+      QCOMPARE( index.nearestNeighbor( QgsPointXY( 0.8, -0.9 ), 2 ), QList< QgsFeatureId >() << 4 << 3 );
+      QVERIFY( index.nearestNeighbor( QgsPointXY( 5, 5 ), 1, 1 ).isEmpty() );
+
+      QCOMPARE( index.boundingBox( 2 ), QgsRectangle( -1, 1, -1, 1 ) );
+      QVERIFY( index.boundingBox( 5 ).isNull() );
+
+      // implicit sharing
+      QgsSpatialIndexPackedRTree copy( index );
+      delete vl;
+      QVERIFY( copy.size() == 4 );
+      QCOMPARE( copy.intersects( QgsRectangle( 0, 0, 10, 10 ) ), QList< QgsFeatureId >() << 1 );
+    }
+
+    void testEmpty()
+    {
+      QgsSpatialIndexPackedRTree index( QVector< QgsFeatureId >(), QVector< QgsRectangle >() );
+      QVERIFY( index.size() == 0 );
+      QVERIFY( index.intersects( QgsRectangle( 0, 0, 10, 10 ) ).isEmpty() );
+      QVERIFY( index.nearestNeighbor( QgsPointXY( 0, 0 ) ).isEmpty() );
+      QVERIFY( index.extent().isNull() );
+    }
+
+    void testSerialization()
+    {
+      QVector< QgsFeatureId > ids;
+      QVector< QgsRectangle > boxes;
+      for ( int i = 0; i < 1000; ++i )
+      {
+        ids << i;
+        boxes << QgsRectangle( i % 37, i / 37, i % 37 + 1.5, i / 37 + 0.5 );
+      }
+      const QgsSpatialIndexPackedRTree index( ids, boxes );
+
+      QBuffer buffer;
+      buffer.open( QIODevice::ReadWrite );
+      QVERIFY( index.write( &buffer ) );
+
+      QgsSpatialIndexPackedRTree read( QVector< QgsFeatureId >(), QVector< QgsRectangle >() );
+      buffer.seek( 0 );
+      QVERIFY( read.read( &buffer ) );
+      QVERIFY( read.size() == index.size() );
+      QCOMPARE( read.extent(), index.extent() );
+      QList< QgsFeatureId > expected = index.intersects( QgsRectangle( 10, 10, 12.2, 14 ) );
+      QList< QgsFeatureId > fids = read.intersects( QgsRectangle( 10, 10, 12.2, 14 ) );
+      std::sort( expected.begin(), expected.end() );
+      std::sort( fids.begin(), fids.end() );
+      QVERIFY( !fids.isEmpty() );
+      QCOMPARE( fids, expected );
+      QCOMPARE( read.nearestNeighbor( QgsPointXY( 100, 100 ), 3 ), index.nearestNeighbor( QgsPointXY( 100, 100 ), 3 ) );
+
+      // truncated data is rejected and leaves the index unchanged
+      QByteArray data = buffer.data();
+      data.chop( 8 );
+      QBuffer truncated( &data );
+      truncated.open( QIODevice::ReadOnly );
+      QgsSpatialIndexPackedRTree empty( QVector< QgsFeatureId >(), QVector< QgsRectangle >() );
+      QVERIFY( !empty.read( &truncated ) );
+      QVERIFY( empty.size() == 0 );
+
+      // empty index
+      QBuffer emptyBuffer;
+      emptyBuffer.open( QIODevice::ReadWrite );
+      QVERIFY( empty.write( &emptyBuffer ) );
+      emptyBuffer.seek( 0 );
+      QVERIFY( read.read( &emptyBuffer ) );
+      QVERIFY( read.size() == 0 );
+      QVERIFY( read.intersects( QgsRectangle( 0, 0, 10, 10 ) ).isEmpty() );
+    }
+
+    void testCache()
+    {
+      QTemporaryDir dir;
+      QgsSettings settings;
+      const QVariant previousCacheDirectory = settings.value( QStringLiteral( "cache/directory" ) );
+      settings.setValue( QStringLiteral( "cache/directory" ), dir.filePath( QStringLiteral( "cache" ) ) );
+
+      const QString path = dir.filePath( QStringLiteral( "points.geojson" ) );
+      auto writeFile = [&path]( const QByteArray & content )
+      {
+        QFile file( path );
+        QVERIFY( file.open( QIODevice::WriteOnly ) );
+        file.write( content );
+      };
+      writeFile( QByteArrayLiteral( "{ \"type\": \"FeatureCollection\", \"features\": ["
+                                    "{ \"type\": \"Feature\", \"properties\": { \"id\": 1 }, \"geometry\": { \"type\": \"Point\", \"coordinates\": [ 1, 1 ] } },"
+                                    "{ \"type\": \"Feature\", \"properties\": { \"id\": 2 }, \"geometry\": { \"type\": \"Point\", \"coordinates\": [ -1, 1 ] } } ] }" ) );
+
+      std::unique_ptr< QgsVectorLayer > layer = qgis::make_unique< QgsVectorLayer >( path, QStringLiteral( "points" ), QStringLiteral( "ogr" ) );
+      QVERIFY( layer->isValid() );
+      QVERIFY( QgsSpatialIndexCache::isCacheable( layer.get() ) );
+
+      QgsSpatialIndexPackedRTree loaded( QVector< QgsFeatureId >(), QVector< QgsRectangle >() );
+      QVERIFY( !QgsSpatialIndexCache::loadIndex( layer.get(), loaded ) );
+
+      const QgsSpatialIndexPackedRTree index( *layer->dataProvider() );
+      QVERIFY( QgsSpatialIndexCache::storeIndex( layer.get(), index ) );
+      QVERIFY( QgsSpatialIndexCache::loadIndex( layer.get(), loaded ) );
+      QVERIFY( loaded.size() == 2 );
+      QCOMPARE( loaded.intersects( QgsRectangle( 0, 0, 10, 10 ) ), index.intersects( QgsRectangle( 0, 0, 10, 10 ) ) );
+
+      // the index of another subset is not the same
+      std::unique_ptr< QgsVectorLayer > subsetLayer = qgis::make_unique< QgsVectorLayer >( path, QStringLiteral( "points" ), QStringLiteral( "ogr" ) );
+      QVERIFY( subsetLayer->setSubsetString( QStringLiteral( "\"id\" = 1" ) ) );
+      QVERIFY( !QgsSpatialIndexCache::loadIndex( subsetLayer.get(), loaded ) );
+
+      // a modified file invalidates the index
+      layer.reset();
+      writeFile( QByteArrayLiteral( "{ \"type\": \"FeatureCollection\", \"features\": [] }" ) );
+      layer = qgis::make_unique< QgsVectorLayer >( path, QStringLiteral( "points" ), QStringLiteral( "ogr" ) );
+      QVERIFY( !QgsSpatialIndexCache::loadIndex( layer.get(), loaded ) );
+
+      // memory layers are not cached
+      QgsVectorLayer memoryLayer( QStringLiteral( "Point" ), QStringLiteral( "x" ), QStringLiteral( "memory" ) );
+      QVERIFY( !QgsSpatialIndexCache::isCacheable( &memoryLayer ) );
+
+      settings.setValue( QStringLiteral( "cache/directory" ), previousCacheDirectory );
+    }
+
+    void testBruteForce()
+    {
+      // enough boxes to build and query in parallel, compared with a linear scan
+      const int maxThreads = QThreadPool::globalInstance()->maxThreadCount();
+      QThreadPool::globalInstance()->setMaxThreadCount( 4 );
+
+      std::mt19937 generator( 42 );
+      std::uniform_real_distribution< double > position( -1000, 1000 );
+      std::uniform_real_distribution< double > extent( 0, 20 );
+      QVector< QgsFeatureId > ids;
+      QVector< QgsRectangle > boxes;
+      for ( int i = 0; i < 100000; ++i )
+      {
+        const double x = position( generator );
+        const double y = position( generator );
+        ids << i * 2;
+        boxes << QgsRectangle( x, y, x + extent( generator ), y + extent( generator ) );
+      }
+      QgsSpatialIndexPackedRTree index( ids, boxes );
+      QVERIFY( index.size() == 100000 );
+
+      QVector< QgsRectangle > queries;
+      for ( int i = 0; i < 200; ++i )
+      {
+        const double x = position( generator );
+        const double y = position( generator );
+        queries << QgsRectangle( x, y, x + 5 * extent( generator ), y + 5 * extent( generator ) );
+      }
+      const QVector< QList< QgsFeatureId > > results = index.intersects( queries );
+      QCOMPARE( results.size(), queries.size() );
+      for ( int i = 0; i < queries.size(); ++i )
+      {
+        QList< QgsFeatureId > expected;
+        for ( int j = 0; j < boxes.size(); ++j )
+        {
+          if ( boxes.at( j ).intersects( queries.at( i ) ) )
+            expected << ids.at( j );
+        }
+        QList< QgsFeatureId > result = results.at( i );
+        std::sort( result.begin(), result.end() );
+        QCOMPARE( result, expected );
+        QCOMPARE( index.intersects( queries.at( i ) ).size(), expected.size() );
+      }
+
+      // the nearest neighbors are the closest boxes
+      const QgsPointXY point( 12.5, -40 );
+      const QList< QgsFeatureId > neighbors = index.nearestNeighbor( point, 10 );
+      QCOMPARE( neighbors.size(), 10 );
+      QVector< double > distances;
+      for ( const QgsRectangle &box : qgis::as_const( boxes ) )
+      {
+        const double dx = std::max( { box.xMinimum() - point.x(), 0.0, point.x() - box.xMaximum() } );
+        const double dy = std::max( { box.yMinimum() - point.y(), 0.0, point.y() - box.yMaximum() } );
+        distances << dx * dx + dy * dy;
+      }
+      QVector< double > sortedDistances = distances;
+      std::sort( sortedDistances.begin(), sortedDistances.end() );
+      for ( int i = 0; i < neighbors.size(); ++i )
+        QCOMPARE( distances.at( static_cast< int >( neighbors.at( i ) / 2 ) ), sortedDistances.at( i ) );
+
+      QThreadPool::globalInstance()->setMaxThreadCount( maxThreads );
+    }
+};
+
+QGSTEST_MAIN( TestQgsSpatialIndexPackedRTree )
+
+#include "testqgsspatialindexpackedrtree.moc"
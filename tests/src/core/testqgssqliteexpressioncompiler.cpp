@@ -41,6 +41,8 @@ class TestQgsSQLiteExpressionCompiler: public QObject
     void cleanupTestCase();
     void testMakeExpression();
     void testCompiler();
+    void testCompilerFunctions();
+    void testGeoPackageTable();
 
   private:
 
@@ -112,6 +114,86 @@ void TestQgsSQLiteExpressionCompiler::testCompiler()
   QCOMPARE( compiler.result(), QStringLiteral( "lower('a') NOT LIKE lower('A') ESCAPE '\\'" ) );
 }
 
+void TestQgsSQLiteExpressionCompiler::testCompilerFunctions()
+{
+  QgsSQLiteExpressionCompiler compiler = QgsSQLiteExpressionCompiler( mPointsLayer->fields() );
+
+  QgsExpression caseExp( QStringLiteral( "CASE WHEN \"Z\" > 1 THEN 'high' ELSE 'low' END = 'high'" ) );
+  QCOMPARE( compiler.compile( &caseExp ), QgsSqlExpressionCompiler::Result::Complete );
+  QCOMPARE( compiler.result(), QStringLiteral( "(CASE WHEN (\"Z\" > 1) THEN 'high' ELSE 'low' END = 'high')" ) );
+
+  QgsExpression left( QStringLiteral( "left(\"Z\", 2) = '12'" ) );
+  QCOMPARE( compiler.compile( &left ), QgsSqlExpressionCompiler::Result::Complete );
+  QCOMPARE( compiler.result(), QStringLiteral( "(substr(\"Z\",1,2) = '12')" ) );
+  QgsExpression right( QStringLiteral( "right(\"Z\", 2) = '12'" ) );
+  QCOMPARE( compiler.compile( &right ), QgsSqlExpressionCompiler::Result::Complete );
+  QCOMPARE( compiler.result(), QStringLiteral( "(substr(\"Z\",-2) = '12')" ) );
+  QgsExpression substr( QStringLiteral( "substr(\"Z\", 2, 3) = '12'" ) );
+  QCOMPARE( compiler.compile( &substr ), QgsSqlExpressionCompiler::Result::Complete );
+  QCOMPARE( compiler.result(), QStringLiteral( "(substr(\"Z\",2,3) = '12')" ) );
+  QgsExpression strpos( QStringLiteral( "strpos(\"Z\", '1') > 0" ) );
+  QCOMPARE( compiler.compile( &strpos ), QgsSqlExpressionCompiler::Result::Complete );
+  QCOMPARE( compiler.result(), QStringLiteral( "(instr(\"Z\",'1') > 0)" ) );
+  QgsExpression replace( QStringLiteral( "replace(\"Z\", '1', '2') = '22'" ) );
+  QCOMPARE( compiler.compile( &replace ), QgsSqlExpressionCompiler::Result::Complete );
+  QCOMPARE( compiler.result(), QStringLiteral( "(replace(\"Z\",'1','2') = '22')" ) );
+
+  // arguments for which SQLite differs
+  QgsExpression substrZero( QStringLiteral( "substr(\"Z\", 0, 3) = '12'" ) );
+  QCOMPARE( compiler.compile( &substrZero ), QgsSqlExpressionCompiler::Result::Fail );
+  QgsExpression leftColumn( QStringLiteral( "left(\"Z\", \"Bottom\") = '12'" ) );
+  QCOMPARE( compiler.compile( &leftColumn ), QgsSqlExpressionCompiler::Result::Fail );
+  QgsExpression replaceEmpty( QStringLiteral( "replace(\"Z\", '', '2') = '22'" ) );
+  QCOMPARE( compiler.compile( &replaceEmpty ), QgsSqlExpressionCompiler::Result::Fail );
+
+  // an AND filter condition can drop an operand which cannot be compiled
+  QgsExpression partialAnd( QStringLiteral( "\"Z\" > 1 AND \"Bottom\" ~ '1'" ) );
+  QCOMPARE( compiler.compile( &partialAnd ), QgsSqlExpressionCompiler::Result::Partial );
+  QCOMPARE( compiler.result(), QStringLiteral( "(\"Z\" > 1)" ) );
+  QgsExpression partialOr( QStringLiteral( "\"Z\" > 1 OR \"Bottom\" ~ '1'" ) );
+  QCOMPARE( compiler.compile( &partialOr ), QgsSqlExpressionCompiler::Result::Fail );
+  QgsExpression negatedAnd( QStringLiteral( "NOT ( \"Z\" > 1 AND \"Bottom\" ~ '1' )" ) );
+  QCOMPARE( compiler.compile( &negatedAnd ), QgsSqlExpressionCompiler::Result::Fail );
+}
+
+void TestQgsSQLiteExpressionCompiler::testGeoPackageTable()
+{
+  QgsVectorLayer layer( QStringLiteral( "Point?crs=epsg:4326&field=d:date&field=dt:datetime" ), QStringLiteral( "dates" ), QStringLiteral( "memory" ) );
+  QgsSQLiteExpressionCompiler compiler = QgsSQLiteExpressionCompiler( layer.fields() );
+
+  QgsExpression year( QStringLiteral( "year(\"d\") = 2020" ) );
+  QCOMPARE( compiler.compile( &year ), QgsSqlExpressionCompiler::Result::Fail );
+  QgsExpression intersects( QStringLiteral( "intersects($geometry, geom_from_wkt('LINESTRING(1 2, 3 4)'))" ) );
+  QCOMPARE( compiler.compile( &intersects ), QgsSqlExpressionCompiler::Result::Fail );
+
+  compiler.setGeoPackageTable( QStringLiteral( "dates" ), QStringLiteral( "geom" ), QStringLiteral( "fid" ), true );
+  QCOMPARE( compiler.compile( &year ), QgsSqlExpressionCompiler::Result::Complete );
+  QCOMPARE( compiler.result(), QStringLiteral( "(CAST((strftime('%Y', \"d\")) AS INTEGER) = 2020)" ) );
+  QgsExpression hour( QStringLiteral( "hour(\"dt\") = 12" ) );
+  QCOMPARE( compiler.compile( &hour ), QgsSqlExpressionCompiler::Result::Complete );
+  QCOMPARE( compiler.result(), QStringLiteral( "(CAST((strftime('%H', \"dt\")) AS INTEGER) = 12)" ) );
+  QgsExpression dateHour( QStringLiteral( "hour(\"d\") = 12" ) );
+  QCOMPARE( compiler.compile( &dateHour ), QgsSqlExpressionCompiler::Result::Fail );
+
+  const QString rtree = QStringLiteral( "\"fid\" IN (SELECT id FROM \"rtree_dates_geom\" WHERE minx <= 3 AND maxx >= 1 AND miny <= 4 AND maxy >= 2)" );
+  QCOMPARE( compiler.compile( &intersects ), QgsSqlExpressionCompiler::Result::Partial );
+  QCOMPARE( compiler.result(), rtree );
+  QgsExpression within( QStringLiteral( "within(geom_from_wkt('LINESTRING(1 2, 3 4)'), $geometry) AND year(\"d\") = 2020" ) );
+  QCOMPARE( compiler.compile( &within ), QgsSqlExpressionCompiler::Result::Partial );
+  QCOMPARE( compiler.result(), QStringLiteral( "(%1 AND (CAST((strftime('%Y', \"d\")) AS INTEGER) = 2020))" ).arg( rtree ) );
+
+  // the lookup only stands in for a condition, and the other geometry must be constant
+  QgsExpression negated( QStringLiteral( "NOT intersects($geometry, geom_from_wkt('LINESTRING(1 2, 3 4)'))" ) );
+  QCOMPARE( compiler.compile( &negated ), QgsSqlExpressionCompiler::Result::Fail );
+  QgsExpression compared( QStringLiteral( "intersects($geometry, geom_from_wkt('LINESTRING(1 2, 3 4)')) = false" ) );
+  QCOMPARE( compiler.compile( &compared ), QgsSqlExpressionCompiler::Result::Fail );
+  QgsExpression buffer( QStringLiteral( "intersects($geometry, buffer($geometry, 1))" ) );
+  QCOMPARE( compiler.compile( &buffer ), QgsSqlExpressionCompiler::Result::Fail );
+
+  compiler.setGeoPackageTable( QStringLiteral( "dates" ), QStringLiteral( "geom" ), QStringLiteral( "fid" ), false );
+  QCOMPARE( compiler.compile( &intersects ), QgsSqlExpressionCompiler::Result::Fail );
+}
+
 
 
 QGSTEST_MAIN( TestQgsSQLiteExpressionCompiler )
@@ -27,6 +27,12 @@
 #include "qgssvgcache.h"
 #include "qgsmultirenderchecker.h"
 #include "qgsapplication.h"
+#include "qgsmarkersymbollayer.h"
+#include "qgsproject.h"
+#include "qgssinglesymbolrenderer.h"
+#include "qgssymbol.h"
+#include "qgssymbollayerutils.h"
+#include "qgsvectorlayer.h"
 
 /**
  * \ingroup UnitTests
@@ -56,6 +62,8 @@ class TestQgsSvgCache : public QObject
     void replaceParams();
     void aspectRatio();
     void noViewBox();
+    void maxCacheSize();
+    void prewarm();
 
 };
 
@@ -362,6 +370,61 @@ void TestQgsSvgCache::noViewBox()
   QGSCOMPARENEAR( viewBoxSize.height(), 6.358467, 0.0001 );
 }
 
+void TestQgsSvgCache::maxCacheSize()
+{
+  QgsSvgCache cache;
+  QCOMPARE( cache.maxCacheSize(), 20000000L );
+
+  const QString svgPath = TEST_DATA_DIR + QStringLiteral( "/sample_svg.svg" );
+  bool fitsInCache = false;
+  for ( int size = 100; size < 110; ++size )
+  {
+    cache.svgAsImage( svgPath, size, QColor( 255, 0, 0 ), QColor( 0, 255, 0 ), 1, 1, fitsInCache );
+    QVERIFY( fitsInCache );
+  }
+  QCOMPARE( cache.mEntryLookup.count(), 10 );
+
+  // the least used entries are removed when the cache is shrunk
+  cache.setMaxCacheSize( 1000000 );
+  QCOMPARE( cache.maxCacheSize(), 1000000L );
+  QVERIFY( cache.mTotalSize <= 1000000 );
+  QVERIFY( cache.mEntryLookup.count() < 10 );
+  QVERIFY( !cache.mEntryLookup.isEmpty() );
+  QVERIFY( qgsDoubleNear( cache.mMostRecentEntry->size, 109 ) );
+}
+
+void TestQgsSvgCache::prewarm()
+{
+  const QString svgPath = TEST_DATA_DIR + QStringLiteral( "/test_symbol_svg.svg" );
+
+  QgsProject project;
+  QgsVectorLayer *layer = new QgsVectorLayer( QStringLiteral( "Point" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  QgsSvgMarkerSymbolLayer *svgLayer = new QgsSvgMarkerSymbolLayer( svgPath, 7 );
+  svgLayer->setColor( QColor( 10, 20, 30 ) );
+  QgsMarkerSymbol *symbol = new QgsMarkerSymbol( QgsSymbolLayerList() << svgLayer );
+  layer->setRenderer( new QgsSingleSymbolRenderer( symbol ) );
+
+  // symbols in map units are not rendered in advance
+  QgsVectorLayer *mapUnitsLayer = new QgsVectorLayer( QStringLiteral( "Point" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  QgsSvgMarkerSymbolLayer *mapUnitsSvgLayer = new QgsSvgMarkerSymbolLayer( svgPath, 700 );
+  mapUnitsSvgLayer->setOutputUnit( QgsUnitTypes::RenderMapUnits );
+  QgsMarkerSymbol *mapUnitsSymbol = new QgsMarkerSymbol( QgsSymbolLayerList() << mapUnitsSvgLayer );
+  mapUnitsLayer->setRenderer( new QgsSingleSymbolRenderer( mapUnitsSymbol ) );
+
+  project.addMapLayers( QList< QgsMapLayer * >() << layer << mapUnitsLayer );
+
+  QCOMPARE( QgsSymbolLayerUtils::prewarmImageCaches( &project, 96 ), 1 );
+
+  // the entry matches the one of a render at 96 dpi
+  QgsSvgCache *cache = QgsApplication::svgCache();
+  const QList< QgsSvgCacheEntry * > entries = cache->mEntryLookup.values( svgPath );
+  QCOMPARE( entries.count(), 1 );
+  QGSCOMPARENEAR( entries.at( 0 )->size, 7 * 96 / 25.4, 0.0001 );
+  QGSCOMPARENEAR( entries.at( 0 )->widthScaleFactor, 96 / 25.4, 0.0001 );
+  QCOMPARE( entries.at( 0 )->fill, QColor( 10, 20, 30 ) );
+  QVERIFY( entries.at( 0 )->image );
+}
+
 bool TestQgsSvgCache::imageCheck( const QString &testName, QImage &image, int mismatchCount )
 {
   //draw background
@@ -334,6 +334,7 @@ class TestQgsTaskManager : public QObject
     void managerWithSubTasks2();
     void managerWithSubTasks3();
     void cancelBeforeStart();
+    void resourceClassLimits();
     void proxyTask();
     void proxyTask2();
     void scopedProxyTask();
@@ -1544,6 +1545,70 @@ void TestQgsTaskManager::managerWithSubTasks3()
   QCOMPARE( manager3.dependencies( subTask2Id ), QSet< long >() );
 }
 
+void TestQgsTaskManager::resourceClassLimits()
+{
+  QgsTaskManager manager;
+  QCOMPARE( manager.maximumConcurrentTasks( QgsTask::ResourceIo ), -1 );
+  manager.setMaximumConcurrentTasks( QgsTask::ResourceIo, 1 );
+  QCOMPARE( manager.maximumConcurrentTasks( QgsTask::ResourceIo ), 1 );
+
+  // a single IO task runs at once, the tasks of the other classes are not held
+  QPointer<CancelableTask> ioTask1 = new CancelableTask();
+  ioTask1->setResourceClass( QgsTask::ResourceIo );
+  QPointer<CancelableTask> ioTask2 = new CancelableTask();
+  ioTask2->setResourceClass( QgsTask::ResourceIo );
+  QPointer<CancelableTask> cpuTask = new CancelableTask();
+  manager.addTask( ioTask1 );
+  manager.addTask( ioTask2 );
+  manager.addTask( cpuTask );
+
+  while ( !ioTask1->isActive() || !cpuTask->isActive() )
+  {
+    QCoreApplication::processEvents();
+  }
+  flushEvents();
+  QCOMPARE( ioTask2->status(), QgsTask::Queued );
+
+  // the held task starts once the running one finishes
+  ioTask1->cancel();
+  while ( !ioTask2->isActive() )
+  {
+    QCoreApplication::processEvents();
+  }
+  QCOMPARE( ioTask2->status(), QgsTask::Running );
+  ioTask2->cancel();
+  cpuTask->cancel();
+  while ( manager.countActiveTasks() > 0 )
+  {
+    QCoreApplication::processEvents();
+  }
+
+  // removing the limit starts the held tasks
+  QPointer<CancelableTask> ioTask3 = new CancelableTask();
+  ioTask3->setResourceClass( QgsTask::ResourceIo );
+  QPointer<CancelableTask> ioTask4 = new CancelableTask();
+  ioTask4->setResourceClass( QgsTask::ResourceIo );
+  manager.addTask( ioTask3 );
+  manager.addTask( ioTask4 );
+  while ( !ioTask3->isActive() )
+  {
+    QCoreApplication::processEvents();
+  }
+  QCOMPARE( ioTask4->status(), QgsTask::Queued );
+  manager.setMaximumConcurrentTasks( QgsTask::ResourceIo, -1 );
+  QCOMPARE( manager.maximumConcurrentTasks( QgsTask::ResourceIo ), -1 );
+  while ( !ioTask4->isActive() )
+  {
+    QCoreApplication::processEvents();
+  }
+  ioTask3->cancel();
+  ioTask4->cancel();
+  while ( manager.countActiveTasks() > 0 )
+  {
+    QCoreApplication::processEvents();
+  }
+}
+
 void TestQgsTaskManager::cancelBeforeStart()
 {
   QThreadPool::globalInstance()->setMaxThreadCount( 3 );
@@ -0,0 +1,104 @@
+/***************************************************************************
+     testqgstilecache.cpp
+     --------------------
+    Date                 : October 2020
+    Copyright            : (C) 2020 by the QGIS project
+    Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgstest.h"
+#include <QObject>
+#include <QImage>
+#include <QUrl>
+
+#include "qgsapplication.h"
+#include "qgstilecache.h"
+
+class TestQgsTileCache: public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void hasTile();
+    void maxCost();
+
+  private:
+    QUrl tileUrl( int i ) const;
+};
+
+void TestQgsTileCache::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsTileCache::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+QUrl TestQgsTileCache::tileUrl( int i ) const
+{
+  return QUrl( QStringLiteral( "http://localhost/tiles/%1.png" ).arg( i ) );
+}
+
+void TestQgsTileCache::hasTile()
+{
+  QVERIFY( !QgsTileCache::hasTile( tileUrl( -1 ) ) );
+
+  QImage image( 256, 256, QImage::Format_ARGB32 );
+  image.fill( Qt::red );
+  QgsTileCache::insertTile( tileUrl( -1 ), image );
+  QVERIFY( QgsTileCache::hasTile( tileUrl( -1 ) ) );
+
+  QImage cached;
+  QVERIFY( QgsTileCache::tile( tileUrl( -1 ), cached ) );
+  QCOMPARE( cached.size(), QSize( 256, 256 ) );
+  QCOMPARE( cached.pixel( 0, 0 ), image.pixel( 0, 0 ) );
+
+  // only the in-memory cache is looked up
+  QVERIFY( !QgsTileCache::hasTile( tileUrl( -2 ) ) );
+}
+
+void TestQgsTileCache::maxCost()
+{
+  const int defaultMaxCost = QgsTileCache::maxCost();
+  // the size of the cache is not changed by loading the application
+  QCOMPARE( defaultMaxCost, 256 );
+
+  QgsTileCache::setMaxCost( 10 );
+  QCOMPARE( QgsTileCache::maxCost(), 10 );
+
+  QImage image( 16, 16, QImage::Format_ARGB32 );
+  image.fill( Qt::blue );
+  for ( int i = 0; i < 20; ++i )
+    QgsTileCache::insertTile( tileUrl( i ), image );
+
+  // the oldest tiles are evicted
+  QCOMPARE( QgsTileCache::totalCost(), 10 );
+  QVERIFY( !QgsTileCache::hasTile( tileUrl( 0 ) ) );
+  QVERIFY( !QgsTileCache::hasTile( tileUrl( 9 ) ) );
+  QVERIFY( QgsTileCache::hasTile( tileUrl( 10 ) ) );
+  QVERIFY( QgsTileCache::hasTile( tileUrl( 19 ) ) );
+
+  // shrinking the cache evicts tiles too
+  QgsTileCache::setMaxCost( 5 );
+  QCOMPARE( QgsTileCache::totalCost(), 5 );
+  QVERIFY( !QgsTileCache::hasTile( tileUrl( 14 ) ) );
+  QVERIFY( QgsTileCache::hasTile( tileUrl( 19 ) ) );
+
+  QgsTileCache::setMaxCost( defaultMaxCost );
+  QCOMPARE( QgsTileCache::maxCost(), defaultMaxCost );
+  QCOMPARE( QgsTileCache::totalCost(), 5 );
+}
+
+QGSTEST_MAIN( TestQgsTileCache )
+#include "testqgstilecache.moc"
@@ -27,6 +27,8 @@
 #include "qgsmapsettings.h"
 #include "qgssnappingutils.h"
 
+#include <QThreadPool>
+
 class TestQgsTracer : public QObject
 {
     Q_OBJECT
@@ -43,6 +45,8 @@ class TestQgsTracer : public QObject
     void testCurved();
     void testOffset();
     void testInvisible();
+    void testParallelNoding();
+    void testBackgroundBuild();
 
   private:
 
@@ -491,6 +495,87 @@ void TestQgsTracer::testOffset()
   delete vl;
 }
 
+void TestQgsTracer::testParallelNoding()
+{
+  // a grid with a diagonal, with enough segments to be noded in strips
+  QStringList wkts;
+  for ( int i = 0; i <= 100; ++i )
+  {
+    QStringList points;
+    for ( int j = 0; j <= 100; ++j )
+      points << QStringLiteral( "%1 %2" ).arg( j ).arg( i );
+    wkts << QStringLiteral( "LINESTRING(%1)" ).arg( points.join( QStringLiteral( ", " ) ) )
+         << QStringLiteral( "LINESTRING(%1 0, %1 100)" ).arg( i );
+  }
+  wkts << QStringLiteral( "LINESTRING(0 0, 100 100)" );
+  QgsVectorLayer *vl = make_layer( wkts );
+
+  const int maxThreads = QThreadPool::globalInstance()->maxThreadCount();
+  QVector< QgsPolylineXY > paths[2];
+  for ( int threads : { 1, 4 } )
+  {
+    QThreadPool::globalInstance()->setMaxThreadCount( threads );
+    QgsTracer tracer;
+    tracer.setLayers( QList<QgsVectorLayer *>() << vl );
+    QVector< QgsPolylineXY > &threadPaths = paths[ threads == 1 ? 0 : 1 ];
+    threadPaths << tracer.findShortestPath( QgsPointXY( 0.25, 50 ), QgsPointXY( 99.75, 50 ) )
+                << tracer.findShortestPath( QgsPointXY( 30, 0.25 ), QgsPointXY( 30, 99.75 ) )
+                << tracer.findShortestPath( QgsPointXY( 0.5, 0.5 ), QgsPointXY( 99.5, 99.5 ) );
+    QVERIFY( !tracer.hasTopologyProblem() );
+  }
+  QThreadPool::globalInstance()->setMaxThreadCount( maxThreads );
+
+  // the lines cut at the borders of the strips are joined back, without the cut points
+  for ( const QVector< QgsPolylineXY > &threadPaths : paths )
+  {
+    for ( const QgsPolylineXY &path : threadPaths )
+      QCOMPARE( path.count(), 101 );
+  }
+  QCOMPARE( paths[1], paths[0] );
+
+  delete vl;
+}
+
+void TestQgsTracer::testBackgroundBuild()
+{
+  // same shape as in testSimple()
+  QStringList wkts;
+  wkts  << QStringLiteral( "LINESTRING(0 0, 0 10)" )
+        << QStringLiteral( "LINESTRING(0 0, 10 0)" )
+        << QStringLiteral( "LINESTRING(0 10, 20 10)" )
+        << QStringLiteral( "LINESTRING(10 0, 20 10)" );
+
+  QgsVectorLayer *vl = make_layer( wkts );
+
+  QgsTracer tracer;
+  tracer.setBuildInBackground( true );
+  QVERIFY( tracer.buildInBackground() );
+  tracer.setLayers( QList<QgsVectorLayer *>() << vl );
+  QVERIFY( !tracer.isInitialized() );
+
+  // the build starts from the event loop, the path search waits for it
+  QCoreApplication::processEvents();
+  QgsPolylineXY points1 = tracer.findShortestPath( QgsPointXY( 0, 0 ), QgsPointXY( 20, 10 ) );
+  QCOMPARE( points1.count(), 3 );
+  QVERIFY( tracer.isInitialized() );
+
+  // an edit starts a new build including it
+  vl->startEditing();
+  QgsFeature f( make_feature( QStringLiteral( "LINESTRING(0 0, 20 10)" ) ) );
+  vl->addFeature( f );
+  QVERIFY( !tracer.isInitialized() );
+  QCoreApplication::processEvents();
+  QgsPolylineXY points2 = tracer.findShortestPath( QgsPointXY( 0, 0 ), QgsPointXY( 20, 10 ) );
+  QCOMPARE( points2.count(), 2 );
+
+  // without the event loop, the graph is built when needed
+  vl->rollBack();
+  QgsPolylineXY points3 = tracer.findShortestPath( QgsPointXY( 0, 0 ), QgsPointXY( 20, 10 ) );
+  QCOMPARE( points3.count(), 3 );
+
+  delete vl;
+}
+
 
 QGSTEST_MAIN( TestQgsTracer )
 #include "testqgstracer.moc"
@@ -38,6 +38,7 @@ class TestQgsValueRelationFieldFormatter: public QObject
     void cleanup(); // will be called after every testfunction.
     void testDependencies();
     void testSortValueNull();
+    void testSharedCache();
 
   private:
     std::unique_ptr<QgsVectorLayer> mLayer1;
@@ -164,5 +165,45 @@ void TestQgsValueRelationFieldFormatter::testSortValueNull()
   QCOMPARE( value, QVariant( QString( "iron" ) ) );
 }
 
+void TestQgsValueRelationFieldFormatter::testSharedCache()
+{
+  QgsValueRelationFieldFormatter formatter;
+  QVariantMap config;
+  config.insert( QStringLiteral( "Layer" ), mLayer2->id() );
+  config.insert( QStringLiteral( "Key" ), QStringLiteral( "pk" ) );
+  config.insert( QStringLiteral( "Value" ), QStringLiteral( "raccord" ) );
+
+  QgsValueRelationFieldFormatter::ValueRelationCache cache = QgsValueRelationFieldFormatter::createCache( config );
+  QCOMPARE( cache.size(), 3 );
+  QCOMPARE( cache.at( 1 ).value, QStringLiteral( "sleeve" ) );
+
+  // the field cache looks the values up by key
+  const QVariant fieldCache = formatter.createCache( mLayer1.get(), 1, config );
+  QCOMPARE( formatter.representValue( mLayer1.get(), 1, config, fieldCache, QVariant( 12 ) ), QStringLiteral( "collar" ) );
+  QCOMPARE( formatter.representValue( mLayer1.get(), 1, config, fieldCache, QVariant( 13 ) ), QStringLiteral( "(13)" ) );
+
+  // the shared cache is discarded when the referenced layer changes
+  QgsFeature ft( mLayer2->fields() );
+  ft.setAttribute( QStringLiteral( "pk" ), 13 );
+  ft.setAttribute( QStringLiteral( "raccord" ), "flange" );
+  mLayer2->startEditing();
+  mLayer2->addFeature( ft );
+  cache = QgsValueRelationFieldFormatter::createCache( config );
+  QCOMPARE( cache.size(), 4 );
+  QCOMPARE( formatter.representValue( mLayer1.get(), 1, config, formatter.createCache( mLayer1.get(), 1, config ), QVariant( 13 ) ), QStringLiteral( "flange" ) );
+  mLayer2->rollBack();
+  QCOMPARE( QgsValueRelationFieldFormatter::createCache( config ).size(), 3 );
+
+  // caches filtered with the form feature are built for each feature
+  config.insert( QStringLiteral( "FilterExpression" ), QStringLiteral( "\"pk\" = current_value( 'fk' ) + 10" ) );
+  QgsFeature formFeature( mLayer1->fields() );
+  formFeature.setAttribute( QStringLiteral( "fk" ), 1 );
+  formFeature.setValid( true );
+  cache = QgsValueRelationFieldFormatter::createCache( config, formFeature );
+  QCOMPARE( cache.size(), 1 );
+  QCOMPARE( cache.at( 0 ).value, QStringLiteral( "sleeve" ) );
+  QCOMPARE( QgsValueRelationFieldFormatter::createCache( config ).size(), 3 );
+}
+
 QGSTEST_MAIN( TestQgsValueRelationFieldFormatter )
 #include "testqgsvaluerelationfieldformatter.moc"
@@ -17,6 +17,8 @@
 #include <QString>
 #include <QStringList>
 #include <QApplication>
+#include <QTemporaryDir>
+#include <QThreadPool>
 
 #include "qgsvectorlayer.h" //defines QgsFieldMap
 #include "qgsvectorfilewriter.h" //logic for writing shpfiles
@@ -105,6 +107,10 @@ class TestQgsVectorFileWriter: public QObject
     void testExportToGpxMultiLineString();
     //! Test https://github.com/qgis/QGIS/issues/29819
     void testExportToGpxMultiLineStringForceRoute();
+    //! Test adding a batch of features whose geometries are converted in parallel
+    void testAddFeaturesInParallel();
+    //! Test the spatial index of new SpatiaLite databases, which is built once all features are written
+    void testSpatiaLiteSpatialIndex();
 
   private:
     // a little util fn used by all tests
@@ -640,5 +646,100 @@ void TestQgsVectorFileWriter::testExportToGpxMultiLineStringForceRoute()
                     QStringList() << QStringLiteral( "FORCE_GPX_ROUTE=YES" ) );
 }
 
+void TestQgsVectorFileWriter::testAddFeaturesInParallel()
+{
+  const int maxThreads = QThreadPool::globalInstance()->maxThreadCount();
+  QThreadPool::globalInstance()->setMaxThreadCount( 4 );
+
+  QTemporaryFile tmpFile( QDir::tempPath() +  "/test_qgsvectorfilewriter3_XXXXXX.gpkg" );
+  tmpFile.open();
+  const QString fileName( tmpFile.fileName( ) );
+  QgsFields fields;
+  fields.append( QgsField( QStringLiteral( "id" ), QVariant::Int ) );
+  QgsVectorFileWriter::SaveVectorOptions options;
+  options.driverName = QStringLiteral( "GPKG" );
+  options.layerName = QStringLiteral( "test" );
+  std::unique_ptr< QgsVectorFileWriter > writer( QgsVectorFileWriter::create( fileName, fields, QgsWkbTypes::MultiPointZ, QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:4326" ) ), QgsCoordinateTransformContext(), options ) );
+  QCOMPARE( writer->hasError(), QgsVectorFileWriter::NoError );
+
+  // single points, without z, are converted to the layer type
+  QgsFeatureList features;
+  for ( int i = 0; i < 3000; ++i )
+  {
+    QgsFeature f( fields );
+    f.setAttribute( 0, i );
+    f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( i, -i ) ) );
+    features << f;
+  }
+  QVERIFY( writer->addFeatures( features ) );
+  writer.reset();
+
+  QgsVectorLayer vl( QStringLiteral( "%1|layername=test" ).arg( fileName ), "test", "ogr" );
+  QVERIFY( vl.isValid() );
+  QCOMPARE( vl.featureCount(), 3000L );
+  QCOMPARE( vl.wkbType(), QgsWkbTypes::MultiPointZ );
+  QgsFeatureRequest request;
+  request.addOrderBy( QStringLiteral( "id" ) );
+  QgsFeatureIterator it = vl.getFeatures( request );
+  QgsFeature f;
+  int i = 0;
+  while ( it.nextFeature( f ) )
+  {
+    QCOMPARE( f.attribute( QStringLiteral( "id" ) ).toInt(), i );
+    QCOMPARE( f.geometry().asWkt(), QgsGeometry::fromWkt( QStringLiteral( "MultiPointZ ((%1 %2 0))" ).arg( i ).arg( -i ) ).asWkt() );
+    i++;
+  }
+  QCOMPARE( i, 3000 );
+
+  QThreadPool::globalInstance()->setMaxThreadCount( maxThreads );
+}
+
+void TestQgsVectorFileWriter::testSpatiaLiteSpatialIndex()
+{
+  QgsVectorLayer ml( QStringLiteral( "Point?crs=epsg:4326&field=id:int" ), "test", "memory" );
+  QgsFeatureList features;
+  for ( int i = 0; i < 5000; ++i )
+  {
+    QgsFeature f( ml.fields() );
+    f.setAttribute( 0, i );
+    f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( i % 100, i / 100 ) ) );
+    features << f;
+  }
+  ml.dataProvider()->addFeatures( features );
+
+  QTemporaryDir dir;
+  const QString fileName = dir.filePath( QStringLiteral( "test.sqlite" ) );
+  QgsVectorFileWriter::SaveVectorOptions options;
+  options.driverName = QStringLiteral( "SpatiaLite" );
+  options.layerName = QStringLiteral( "test" );
+  QgsVectorFileWriter::WriterError error( QgsVectorFileWriter::writeAsVectorFormatV2( &ml, fileName, ml.transformContext(), options ) );
+  QCOMPARE( error, QgsVectorFileWriter::NoError );
+
+  QgsVectorLayer vl( QStringLiteral( "%1|layername=test" ).arg( fileName ), "test", "ogr" );
+  QVERIFY( vl.isValid() );
+  QCOMPARE( vl.featureCount(), 5000L );
+  QCOMPARE( vl.hasSpatialIndex(), QgsFeatureSource::SpatialIndexPresent );
+  QgsFeatureRequest request( QgsRectangle( 9.5, 9.5, 10.5, 10.5 ) );
+  request.setNoAttributes();
+  QgsFeatureIterator it = vl.getFeatures( request );
+  QgsFeature f;
+  int count = 0;
+  while ( it.nextFeature( f ) )
+  {
+    QCOMPARE( f.geometry().asPoint(), QgsPointXY( 10, 10 ) );
+    count++;
+  }
+  QCOMPARE( count, 1 );
+
+  // an explicitly disabled index is not created
+  const QString noIndexFileName = dir.filePath( QStringLiteral( "test_no_index.sqlite" ) );
+  options.layerOptions = QStringList() << QStringLiteral( "SPATIAL_INDEX=NO" );
+  error = QgsVectorFileWriter::writeAsVectorFormatV2( &ml, noIndexFileName, ml.transformContext(), options );
+  QCOMPARE( error, QgsVectorFileWriter::NoError );
+  QgsVectorLayer vl2( QStringLiteral( "%1|layername=test" ).arg( noIndexFileName ), "test", "ogr" );
+  QVERIFY( vl2.isValid() );
+  QCOMPARE( vl2.hasSpatialIndex(), QgsFeatureSource::SpatialIndexNotPresent );
+}
+
 QGSTEST_MAIN( TestQgsVectorFileWriter )
 #include "testqgsvectorfilewriter.moc"
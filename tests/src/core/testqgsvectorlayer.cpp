@@ -21,6 +21,8 @@
 #include <QFileInfo>
 #include <QDir>
 #include <QDesktopServices>
+#include <QSignalSpy>
+#include <QThreadPool>
 
 //qgis includes...
 #include <qgsgeometry.h>
@@ -101,6 +103,10 @@ class TestQgsVectorLayer : public QObject
     void maximumValue();
     void isSpatial();
     void testAddTopologicalPoints();
+    void testExpressionFieldValueCache();
+    void testExpressionFieldValueCacheOtherLayers();
+    void testChangeFieldValues();
+    void testAggregate();
 };
 
 void TestQgsVectorLayer::initTestCase()
@@ -380,5 +386,249 @@ void TestQgsVectorLayer::testAddTopologicalPoints()
   delete layerLine;
 }
 
+void TestQgsVectorLayer::testExpressionFieldValueCache()
+{
+  QgsVectorLayer layer( QStringLiteral( "Point?field=a:integer&field=b:integer" ), QStringLiteral( "layer" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer.isValid() );
+  QgsFeatureList features;
+  for ( int i = 1; i <= 3; ++i )
+  {
+    QgsFeature feature( layer.fields() );
+    feature.setAttributes( QgsAttributes() << i << 10 * i );
+    feature.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( i, 0 ) ) );
+    features << feature;
+  }
+  QVERIFY( layer.dataProvider()->addFeatures( features ) );
+
+  const int doubleIdx = layer.addExpressionField( QStringLiteral( "\"a\" * 2" ), QgsField( QStringLiteral( "double_a" ), QVariant::Int ) );
+  const int xIdx = layer.addExpressionField( QStringLiteral( "$x" ), QgsField( QStringLiteral( "x" ), QVariant::Double ) );
+  QVERIFY( !layer.expressionFieldValueCachingEnabled() );
+  layer.setExpressionFieldValueCachingEnabled( true );
+  QVERIFY( layer.expressionFieldValueCachingEnabled() );
+
+  const QgsFeatureId fid = features.at( 0 ).id();
+  QCOMPARE( layer.getFeature( fid ).attribute( doubleIdx ).toInt(), 2 );
+  QCOMPARE( layer.getFeature( fid ).attribute( xIdx ).toDouble(), 1.0 );
+
+  // the provider changes are not signaled, the cached values are returned until they are invalidated
+  QgsChangedAttributesMap changes;
+  changes[ fid ].insert( 0, 5 );
+  QVERIFY( layer.dataProvider()->changeAttributeValues( changes ) );
+  QCOMPARE( layer.getFeature( fid ).attribute( doubleIdx ).toInt(), 2 );
+  layer.invalidateExpressionFieldValues();
+  QCOMPARE( layer.getFeature( fid ).attribute( doubleIdx ).toInt(), 10 );
+
+  // edits of the inputs invalidate the values of the feature
+  QVERIFY( layer.startEditing() );
+  QVERIFY( layer.changeAttributeValue( fid, 0, 7 ) );
+  QCOMPARE( layer.getFeature( fid ).attribute( doubleIdx ).toInt(), 14 );
+  QVERIFY( layer.changeAttributeValue( fid, 1, 70 ) );
+  QCOMPARE( layer.getFeature( fid ).attribute( doubleIdx ).toInt(), 14 );
+  QVERIFY( layer.changeGeometry( fid, QgsGeometry::fromPointXY( QgsPointXY( 4, 0 ) ) ) );
+  QCOMPARE( layer.getFeature( fid ).attribute( xIdx ).toDouble(), 4.0 );
+  layer.rollBack();
+  QCOMPARE( layer.getFeature( fid ).attribute( doubleIdx ).toInt(), 10 );
+  QCOMPARE( layer.getFeature( fid ).attribute( xIdx ).toDouble(), 1.0 );
+
+  // aggregates depend on all the features, any edit invalidates all the values
+  const int sumIdx = layer.addExpressionField( QStringLiteral( "sum( \"a\" )" ), QgsField( QStringLiteral( "sum_a" ), QVariant::Int ) );
+  QCOMPARE( layer.getFeature( features.at( 1 ).id() ).attribute( sumIdx ).toInt(), 10 );
+  QVERIFY( layer.startEditing() );
+  QVERIFY( layer.changeAttributeValue( fid, 0, 1 ) );
+  QCOMPARE( layer.getFeature( features.at( 1 ).id() ).attribute( sumIdx ).toInt(), 6 );
+  QCOMPARE( layer.getFeature( features.at( 2 ).id() ).attribute( doubleIdx ).toInt(), 6 );
+  QVERIFY( layer.deleteFeature( features.at( 2 ).id() ) );
+  QCOMPARE( layer.getFeature( features.at( 1 ).id() ).attribute( sumIdx ).toInt(), 3 );
+  QVERIFY( layer.commitChanges() );
+  QCOMPARE( layer.getFeature( features.at( 1 ).id() ).attribute( sumIdx ).toInt(), 3 );
+
+  // volatile expressions are not cached
+  const int randIdx = layer.addExpressionField( QStringLiteral( "rand( 0, 1000000000 )" ), QgsField( QStringLiteral( "random" ), QVariant::Int ) );
+  QVERIFY( layer.getFeature( fid ).attribute( randIdx ) != layer.getFeature( fid ).attribute( randIdx ) );
+
+  // the setting is saved with the expression fields
+  QDomDocument doc;
+  QDomElement element = doc.createElement( QStringLiteral( "maplayer" ) );
+  QString errorMessage;
+  QgsReadWriteContext context;
+  QVERIFY( layer.writeSymbology( element, doc, errorMessage, context ) );
+  QgsVectorLayer copy( QStringLiteral( "Point?field=a:integer&field=b:integer" ), QStringLiteral( "layer" ), QStringLiteral( "memory" ) );
+  QVERIFY( copy.readSymbology( element, errorMessage, context ) );
+  QVERIFY( copy.expressionFieldValueCachingEnabled() );
+}
+
+void TestQgsVectorLayer::testExpressionFieldValueCacheOtherLayers()
+{
+  QgsVectorLayer layer( QStringLiteral( "None?field=code:integer&field=b:integer" ), QStringLiteral( "layer" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer.isValid() );
+  QgsFeature feature( layer.fields() );
+  feature.setAttributes( QgsAttributes() << 1 << 5 );
+  QVERIFY( layer.dataProvider()->addFeature( feature ) );
+  const QgsFeatureId fid = feature.id();
+  layer.setExpressionFieldValueCachingEnabled( true );
+
+  QgsVectorLayer *other = new QgsVectorLayer( QStringLiteral( "None?field=code:integer&field=name:string" ), QStringLiteral( "codes" ), QStringLiteral( "memory" ) );
+  QVERIFY( other->isValid() );
+  QgsFeature code( other->fields() );
+  code.setAttributes( QgsAttributes() << 1 << QStringLiteral( "one" ) );
+  QVERIFY( other->dataProvider()->addFeature( code ) );
+
+  // the layer is resolved again when it is added to the project
+  const int nameIdx = layer.addExpressionField( QStringLiteral( "attribute( get_feature( 'codes', 'code', \"code\" ), 'name' )" ), QgsField( QStringLiteral( "name" ), QVariant::String ) );
+  QVERIFY( layer.getFeature( fid ).attribute( nameIdx ).isNull() );
+  QgsProject::instance()->addMapLayer( other );
+  QCOMPARE( layer.getFeature( fid ).attribute( nameIdx ).toString(), QStringLiteral( "one" ) );
+
+  // edits of the other layer invalidate the values
+  QVERIFY( other->startEditing() );
+  QVERIFY( other->changeAttributeValue( code.id(), 1, QStringLiteral( "uno" ) ) );
+  QCOMPARE( layer.getFeature( fid ).attribute( nameIdx ).toString(), QStringLiteral( "uno" ) );
+  QVERIFY( other->commitChanges() );
+  QCOMPARE( layer.getFeature( fid ).attribute( nameIdx ).toString(), QStringLiteral( "uno" ) );
+
+  // layers given by an expression are not known before the evaluation, they are not cached
+  const int dynamicIdx = layer.addExpressionField( QStringLiteral( "attribute( get_feature( 'co' || 'des', 'code', \"code\" ), 'name' )" ), QgsField( QStringLiteral( "dynamic_name" ), QVariant::String ) );
+  QCOMPARE( layer.getFeature( fid ).attribute( dynamicIdx ).toString(), QStringLiteral( "uno" ) );
+  QgsChangedAttributesMap changes;
+  changes[ code.id() ].insert( 1, QStringLiteral( "ein" ) );
+  QVERIFY( other->dataProvider()->changeAttributeValues( changes ) );
+  QCOMPARE( layer.getFeature( fid ).attribute( dynamicIdx ).toString(), QStringLiteral( "ein" ) );
+
+  // aggregates of the other layer
+  const int countIdx = layer.addExpressionField( QStringLiteral( "aggregate( 'codes', 'count', \"code\" )" ), QgsField( QStringLiteral( "count" ), QVariant::Int ) );
+  QCOMPARE( layer.getFeature( fid ).attribute( countIdx ).toInt(), 1 );
+  QVERIFY( other->startEditing() );
+  QgsFeature code2( other->fields() );
+  code2.setAttributes( QgsAttributes() << 2 << QStringLiteral( "two" ) );
+  QVERIFY( other->addFeature( code2 ) );
+  QVERIFY( other->commitChanges() );
+  QCOMPARE( layer.getFeature( fid ).attribute( countIdx ).toInt(), 2 );
+
+  // expressions reading all the attributes are invalidated by the edit of any of them
+  const int allIdx = layer.addExpressionField( QStringLiteral( "attributes()['b'] * 2" ), QgsField( QStringLiteral( "double_b" ), QVariant::Int ) );
+  QCOMPARE( layer.getFeature( fid ).attribute( allIdx ).toInt(), 10 );
+  QVERIFY( layer.startEditing() );
+  QVERIFY( layer.changeAttributeValue( fid, 1, 6 ) );
+  QCOMPARE( layer.getFeature( fid ).attribute( allIdx ).toInt(), 12 );
+  layer.rollBack();
+
+  // the removal of the layer invalidates the values
+  QgsProject::instance()->removeMapLayer( other );
+  QVERIFY( layer.getFeature( fid ).attribute( nameIdx ).isNull() );
+}
+
+void TestQgsVectorLayer::testChangeFieldValues()
+{
+  QgsVectorLayer layer( QStringLiteral( "Point?field=a:integer&field=b:integer" ), QStringLiteral( "layer" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer.isValid() );
+  QgsFeatureList features;
+  for ( int i = 0; i < 1000; ++i )
+  {
+    QgsFeature feature( layer.fields() );
+    feature.setAttributes( QgsAttributes() << i << 0 );
+    features << feature;
+  }
+  QVERIFY( layer.dataProvider()->addFeatures( features ) );
+
+  QVERIFY( layer.startEditing() );
+  QgsFeature added( layer.fields() );
+  added.setAttributes( QgsAttributes() << -1 << 0 );
+  QVERIFY( layer.addFeature( added ) );
+  QVERIFY( layer.changeAttributeValue( features.at( 0 ).id(), 1, 5 ) );
+  const int undoIndex = layer.undoStack()->index();
+
+  QHash<QgsFeatureId, QVariant> newValues;
+  QHash<QgsFeatureId, QVariant> oldValues;
+  for ( const QgsFeature &feature : qgis::as_const( features ) )
+  {
+    newValues.insert( feature.id(), feature.attribute( 0 ).toInt() * 2 );
+    if ( feature.attribute( 0 ).toInt() % 2 )
+      oldValues.insert( feature.id(), 0 );
+  }
+  newValues.insert( added.id(), 7 );
+  QVERIFY( layer.changeFieldValues( 1, newValues, oldValues ) );
+
+  // a single undo command for all the features
+  QCOMPARE( layer.undoStack()->index(), undoIndex + 1 );
+  QgsFeatureIterator it = layer.getFeatures();
+  QgsFeature feature;
+  while ( it.nextFeature( feature ) )
+    QCOMPARE( feature.attribute( 1 ), newValues.value( feature.id() ) );
+
+  QSignalSpy spy( &layer, &QgsVectorLayer::attributeValueChanged );
+  layer.undoStack()->undo();
+  QCOMPARE( spy.count(), 1001 );
+  QCOMPARE( layer.getFeature( features.at( 0 ).id() ).attribute( 1 ).toInt(), 5 );
+  QCOMPARE( layer.getFeature( features.at( 2 ).id() ).attribute( 1 ).toInt(), 0 );
+  QCOMPARE( layer.getFeature( added.id() ).attribute( 1 ).toInt(), 0 );
+  QCOMPARE( layer.editBuffer()->changedAttributeValues().size(), 1 );
+  for ( const QList<QVariant> &arguments : qgis::as_const( spy ) )
+  {
+    if ( arguments.at( 0 ).value<QgsFeatureId>() == features.at( 0 ).id() )
+      QCOMPARE( arguments.at( 2 ).toInt(), 5 );
+    else
+      QCOMPARE( arguments.at( 2 ).toInt(), 0 );
+  }
+
+  layer.undoStack()->redo();
+  QVERIFY( layer.commitChanges() );
+  it = layer.dataProvider()->getFeatures();
+  while ( it.nextFeature( feature ) )
+  {
+    if ( feature.attribute( 0 ).toInt() >= 0 )
+      QCOMPARE( feature.attribute( 1 ).toInt(), feature.attribute( 0 ).toInt() * 2 );
+    else
+      QCOMPARE( feature.attribute( 1 ).toInt(), 7 );
+  }
+
+  // not editable
+  QVERIFY( !layer.changeFieldValues( 1, newValues ) );
+}
+
+void TestQgsVectorLayer::testAggregate()
+{
+  QgsVectorLayer layer( QStringLiteral( "Point?field=a:integer&field=b:string" ), QStringLiteral( "layer" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer.isValid() );
+  QgsFeatureList features;
+  for ( int i = 0; i < 20000; ++i )
+  {
+    QgsFeature feature( layer.fields() );
+    feature.setAttributes( QgsAttributes() << i << QString::number( i % 7 ) );
+    features << feature;
+  }
+  QVERIFY( layer.dataProvider()->addFeatures( features ) );
+
+  // the expression values are evaluated in parallel, and reduced in the order of the features
+  const int maxThreads = QThreadPool::globalInstance()->maxThreadCount();
+  QThreadPool::globalInstance()->setMaxThreadCount( 1 );
+  bool ok = false;
+  const QVariant sequentialSum = layer.aggregate( QgsAggregateCalculator::Sum, QStringLiteral( "a * 2 + 1" ), QgsAggregateCalculator::AggregateParameters(), nullptr, &ok );
+  QVERIFY( ok );
+  QgsAggregateCalculator::AggregateParameters parameters;
+  parameters.delimiter = QStringLiteral( "," );
+  const QVariant sequentialConcatenation = layer.aggregate( QgsAggregateCalculator::StringConcatenate, QStringLiteral( "b || 'x'" ), parameters, nullptr, &ok );
+  QVERIFY( ok );
+
+  QThreadPool::globalInstance()->setMaxThreadCount( 4 );
+  QgsAggregateCalculator calculator( &layer );
+  QCOMPARE( calculator.calculate( QgsAggregateCalculator::Sum, QStringLiteral( "a * 2 + 1" ), nullptr, &ok ), sequentialSum );
+  QVERIFY( ok );
+  QCOMPARE( sequentialSum.toDouble(), 20000.0 * 20000.0 );
+  calculator.setDelimiter( QStringLiteral( "," ) );
+  QCOMPARE( calculator.calculate( QgsAggregateCalculator::StringConcatenate, QStringLiteral( "b || 'x'" ), nullptr, &ok ), sequentialConcatenation );
+  QVERIFY( sequentialConcatenation.toString().startsWith( QStringLiteral( "0x,1x,2x,3x,4x,5x,6x,0x," ) ) );
+  QCOMPARE( calculator.calculate( QgsAggregateCalculator::ArrayAggregate, QStringLiteral( "a" ), nullptr, &ok ).toList().size(), 20000 );
+  QThreadPool::globalInstance()->setMaxThreadCount( maxThreads );
+
+  // the cached result of the layer follows the edits
+  QCOMPARE( layer.aggregate( QgsAggregateCalculator::Sum, QStringLiteral( "a * 2 + 1" ) ), sequentialSum );
+  QVERIFY( layer.startEditing() );
+  QVERIFY( layer.changeAttributeValue( features.at( 0 ).id(), 0, 10 ) );
+  QCOMPARE( layer.aggregate( QgsAggregateCalculator::Sum, QStringLiteral( "a * 2 + 1" ) ).toDouble(), sequentialSum.toDouble() + 20 );
+  QCOMPARE( layer.aggregate( QgsAggregateCalculator::Max, QStringLiteral( "a" ) ).toInt(), 19999 );
+  QVERIFY( layer.rollBack() );
+  QCOMPARE( layer.aggregate( QgsAggregateCalculator::Sum, QStringLiteral( "a * 2 + 1" ) ), sequentialSum );
+}
+
 QGSTEST_MAIN( TestQgsVectorLayer )
 #include "testqgsvectorlayer.moc"
@@ -17,6 +17,7 @@
 #include "qgstest.h"
 #include <QObject>
 #include <QTemporaryFile>
+#include <QSignalSpy>
 
 //qgis includes...
 #include "qgsfeatureiterator.h"
@@ -56,6 +57,8 @@ class TestVectorLayerCache : public QObject
     void testCanUseCacheForRequest();
     void testCacheGeom();
     void testFullCacheWithRect(); // Test that if rect is set then no full cache can exist, see #19468
+    void testBackgroundFill();
+    void testSharedBudget();
 
     void onCommittedFeaturesAdded( const QString &, const QgsFeatureList & );
 
@@ -420,6 +423,99 @@ void TestVectorLayerCache::testFullCacheWithRect()
 
 }
 
+void TestVectorLayerCache::testBackgroundFill()
+{
+  QgsVectorLayer layer( QStringLiteral( "Point?field=a:integer" ), QStringLiteral( "layer" ), QStringLiteral( "memory" ) );
+  QgsFeatureList features;
+  for ( int i = 0; i < 25000; ++i )
+  {
+    QgsFeature feature( layer.fields() );
+    feature.setAttributes( QgsAttributes() << i );
+    features << feature;
+  }
+  QVERIFY( layer.dataProvider()->addFeatures( features ) );
+
+  QgsVectorLayerCache cache( &layer, 10 );
+  QSignalSpy cachedSpy( &cache, &QgsVectorLayerCache::featuresCached );
+  QSignalSpy finishedSpy( &cache, &QgsVectorLayerCache::finished );
+  cache.fillFullCacheInBackground();
+  QVERIFY( cache.isFillingInBackground() );
+  QVERIFY( !cache.hasFullCache() );
+
+  // edits made while the features are read
+  QVERIFY( layer.startEditing() );
+  QVERIFY( layer.changeAttributeValue( features.at( 5 ).id(), 0, -5 ) );
+  QVERIFY( layer.deleteFeature( features.at( 6 ).id() ) );
+  QgsFeature added( layer.fields() );
+  added.setAttributes( QgsAttributes() << -1 );
+  QVERIFY( layer.addFeature( added ) );
+
+  QVERIFY( finishedSpy.wait( 30000 ) );
+  QVERIFY( !cache.isFillingInBackground() );
+  QVERIFY( cache.hasFullCache() );
+  QVERIFY( cachedSpy.count() >= 3 );
+  QgsFeatureIds cachedIds;
+  for ( const QList<QVariant> &arguments : qgis::as_const( cachedSpy ) )
+    cachedIds.unite( arguments.at( 0 ).value<QgsFeatureIds>() );
+  QCOMPARE( cachedIds.size(), 25000 );
+  QVERIFY( cachedIds.contains( added.id() ) );
+  QVERIFY( !cachedIds.contains( features.at( 6 ).id() ) );
+
+  QCOMPARE( cache.cachedFeatureIds(), cachedIds );
+  QgsFeature feature;
+  QVERIFY( cache.featureAtId( features.at( 5 ).id(), feature ) );
+  QCOMPARE( feature.attribute( 0 ).toInt(), -5 );
+  layer.rollBack();
+
+  // canceled
+  cache.fillFullCacheInBackground();
+  QVERIFY( cache.isFillingInBackground() );
+  cache.cancelBackgroundFill();
+  QVERIFY( !cache.isFillingInBackground() );
+  QVERIFY( !finishedSpy.wait( 1000 ) );
+  QVERIFY( !cache.hasFullCache() );
+}
+
+void TestVectorLayerCache::testSharedBudget()
+{
+  QgsVectorLayer layer( QStringLiteral( "Point?field=a:string" ), QStringLiteral( "layer" ), QStringLiteral( "memory" ) );
+  QgsFeatureList features;
+  for ( int i = 0; i < 100; ++i )
+  {
+    QgsFeature feature( layer.fields() );
+    feature.setAttributes( QgsAttributes() << QString( 100, 'x' ) );
+    feature.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( i, i ) ) );
+    features << feature;
+  }
+  QVERIFY( layer.dataProvider()->addFeatures( features ) );
+
+  const qint64 otherBytes = QgsVectorLayerCache::sharedCacheBytes();
+  {
+    QgsVectorLayerCache cache( &layer, 1000 );
+    QgsFeature feature;
+    QVERIFY( cache.featureAtId( features.at( 0 ).id(), feature ) );
+    const qint64 featureBytes = cache.cacheBytes();
+    QVERIFY( featureBytes > 200 );
+    QCOMPARE( QgsVectorLayerCache::sharedCacheBytes(), otherBytes + featureBytes );
+
+    // the least recently used features are dropped once all the caches exceed the budget
+    QgsVectorLayerCache::setMaximumSharedCacheBytes( otherBytes + 10 * featureBytes );
+    for ( const QgsFeature &f : qgis::as_const( features ) )
+      QVERIFY( cache.featureAtId( f.id(), feature ) );
+    QVERIFY( QgsVectorLayerCache::sharedCacheBytes() <= QgsVectorLayerCache::maximumSharedCacheBytes() );
+    QVERIFY( cache.cachedFeatureIds().size() <= 10 );
+    QVERIFY( cache.isFidCached( features.at( 99 ).id() ) );
+    QVERIFY( !cache.isFidCached( features.at( 0 ).id() ) );
+
+    // but a full cache keeps all the features
+    cache.setFullCache( true );
+    QCOMPARE( cache.cachedFeatureIds().size(), 100 );
+    QVERIFY( QgsVectorLayerCache::sharedCacheBytes() > QgsVectorLayerCache::maximumSharedCacheBytes() );
+    QgsVectorLayerCache::setMaximumSharedCacheBytes( 0 );
+  }
+  QCOMPARE( QgsVectorLayerCache::sharedCacheBytes(), otherBytes );
+}
+
 void TestVectorLayerCache::onCommittedFeaturesAdded( const QString &layerId, const QgsFeatureList &features )
 {
   Q_UNUSED( layerId )
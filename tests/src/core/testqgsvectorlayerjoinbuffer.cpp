@@ -63,9 +63,11 @@ class TestVectorLayerJoinBuffer : public QObject
     void testJoinLayerDefinitionFile();
     void testCacheUpdate_data();
     void testCacheUpdate();
+    void testCacheIncrementalUpdate();
     void testRemoveJoinOnLayerDelete();
     void testResolveReferences();
     void testSignals();
+    void testJoinBatched();
 
   private:
     QgsProject mProject;
@@ -608,6 +610,85 @@ void TestVectorLayerJoinBuffer::testCacheUpdate()
   QCOMPARE( fA2.attribute( "B_value_b" ).toInt(), 12 );
 }
 
+void TestVectorLayerJoinBuffer::testCacheIncrementalUpdate()
+{
+  QgsVectorLayer *vlA = new QgsVectorLayer( QStringLiteral( "Point?field=id_a:integer" ), QStringLiteral( "cacheA" ), QStringLiteral( "memory" ) );
+  QVERIFY( vlA->isValid() );
+  QgsVectorLayer *vlB = new QgsVectorLayer( QStringLiteral( "Point?field=id_b:integer&field=value_b:integer" ), QStringLiteral( "cacheB" ), QStringLiteral( "memory" ) );
+  QVERIFY( vlB->isValid() );
+  mProject.addMapLayers( QList<QgsMapLayer *>() << vlA << vlB );
+
+  QgsFeatureList featuresA;
+  for ( int i = 1; i <= 3; ++i )
+  {
+    QgsFeature f( vlA->dataProvider()->fields() );
+    f.setAttribute( QStringLiteral( "id_a" ), i );
+    featuresA << f;
+  }
+  vlA->dataProvider()->addFeatures( featuresA );
+
+  QgsFeature fB1( vlB->dataProvider()->fields() );
+  fB1.setAttribute( QStringLiteral( "id_b" ), 1 );
+  fB1.setAttribute( QStringLiteral( "value_b" ), 11 );
+  QgsFeature fB2( vlB->dataProvider()->fields() );
+  fB2.setAttribute( QStringLiteral( "id_b" ), 2 );
+  fB2.setAttribute( QStringLiteral( "value_b" ), 12 );
+  vlB->dataProvider()->addFeatures( QgsFeatureList() << fB1 << fB2 );
+
+  QgsVectorLayerJoinInfo joinInfo;
+  joinInfo.setTargetFieldName( QStringLiteral( "id_a" ) );
+  joinInfo.setJoinLayer( vlB );
+  joinInfo.setJoinFieldName( QStringLiteral( "id_b" ) );
+  joinInfo.setUsingMemoryCache( true );
+  joinInfo.setPrefix( QStringLiteral( "B_" ) );
+  vlA->addJoin( joinInfo );
+
+  auto joinedValues = [vlA]
+  {
+    QMap< int, QVariant > values;
+    QgsFeatureIterator fi = vlA->getFeatures();
+    QgsFeature f;
+    while ( fi.nextFeature( f ) )
+      values.insert( f.attribute( QStringLiteral( "id_a" ) ).toInt(), f.attribute( QStringLiteral( "B_value_b" ) ) );
+    return values;
+  };
+
+  QMap< int, QVariant > values = joinedValues();
+  QCOMPARE( values.value( 1 ).toInt(), 11 );
+  QCOMPARE( values.value( 2 ).toInt(), 12 );
+  QVERIFY( values.value( 3 ).isNull() );
+
+  // edits of the joined layer are applied to the cache
+  vlB->startEditing();
+  QVERIFY( vlB->changeAttributeValue( 1, 1, 111 ) );
+  QgsFeature fB3( vlB->fields() );
+  fB3.setAttribute( QStringLiteral( "id_b" ), 3 );
+  fB3.setAttribute( QStringLiteral( "value_b" ), 13 );
+  QVERIFY( vlB->addFeature( fB3 ) );
+
+  values = joinedValues();
+  QCOMPARE( values.value( 1 ).toInt(), 111 );
+  QCOMPARE( values.value( 2 ).toInt(), 12 );
+  QCOMPARE( values.value( 3 ).toInt(), 13 );
+
+  // deleted joined features and changed join values are not joined anymore
+  QVERIFY( vlB->deleteFeature( 2 ) );
+  QVERIFY( vlB->changeAttributeValue( fB3.id(), 0, 4 ) );
+
+  values = joinedValues();
+  QCOMPARE( values.value( 1 ).toInt(), 111 );
+  QVERIFY( values.value( 2 ).isNull() );
+  QVERIFY( values.value( 3 ).isNull() );
+
+  vlB->rollBack();
+  values = joinedValues();
+  QCOMPARE( values.value( 1 ).toInt(), 11 );
+  QCOMPARE( values.value( 2 ).toInt(), 12 );
+  QVERIFY( values.value( 3 ).isNull() );
+
+  mProject.removeMapLayers( QStringList() << vlA->id() << vlB->id() );
+}
+
 void TestVectorLayerJoinBuffer::testRemoveJoinOnLayerDelete()
 {
   QgsVectorLayer *vlA = new QgsVectorLayer( QStringLiteral( "Point?field=id_a:integer" ), QStringLiteral( "cacheA" ), QStringLiteral( "memory" ) );
@@ -736,6 +817,97 @@ void TestVectorLayerJoinBuffer::testSignals()
   QCOMPARE( spy.count(), 3 );
 }
 
+void TestVectorLayerJoinBuffer::testJoinBatched()
+{
+  // without memory cache, the joined features are looked up by batches of features
+  QgsVectorLayer *vlTarget = new QgsVectorLayer( QStringLiteral( "Point?field=id:integer&field=ref:integer" ), QStringLiteral( "target" ), QStringLiteral( "memory" ) );
+  QgsVectorLayer *vlJoin = new QgsVectorLayer( QStringLiteral( "Point?field=ref_id:integer&field=name:string&field=extra:integer" ), QStringLiteral( "join" ), QStringLiteral( "memory" ) );
+  QVERIFY( vlTarget->isValid() );
+  QVERIFY( vlJoin->isValid() );
+  mProject.addMapLayers( QList<QgsMapLayer *>() << vlTarget << vlJoin );
+
+  QgsFeatureList targetFeatures;
+  for ( int i = 0; i < 2500; ++i )
+  {
+    QgsFeature f( vlTarget->fields() );
+    // every 7th feature has no joined feature, every 11th has a null reference
+    f.setAttributes( QgsAttributes() << i << ( i % 11 == 0 ? QVariant( QVariant::Int ) : QVariant( i % 7 == 0 ? -i : i % 100 ) ) );
+    targetFeatures << f;
+  }
+  QVERIFY( vlTarget->dataProvider()->addFeatures( targetFeatures ) );
+
+  QgsFeatureList joinFeatures;
+  for ( int i = 0; i < 100; ++i )
+  {
+    QgsFeature f( vlJoin->fields() );
+    f.setAttributes( QgsAttributes() << i << QStringLiteral( "name %1" ).arg( i ) << i * 10 );
+    joinFeatures << f;
+  }
+  QVERIFY( vlJoin->dataProvider()->addFeatures( joinFeatures ) );
+
+  QgsVectorLayerJoinInfo joinInfo;
+  joinInfo.setTargetFieldName( QStringLiteral( "ref" ) );
+  joinInfo.setJoinLayer( vlJoin );
+  joinInfo.setJoinFieldName( QStringLiteral( "ref_id" ) );
+  joinInfo.setUsingMemoryCache( false );
+  joinInfo.setPrefix( QStringLiteral( "j_" ) );
+  joinInfo.setJoinFieldNamesSubset( new QStringList( QStringList() << QStringLiteral( "name" ) ) );
+  QVERIFY( vlTarget->addJoin( joinInfo ) );
+  QCOMPARE( vlTarget->fields().count(), 3 );
+
+  auto checkFeature = []( const QgsFeature & f )
+  {
+    const int id = f.attribute( QStringLiteral( "id" ) ).toInt();
+    if ( id % 11 == 0 || id % 7 == 0 )
+      QVERIFY( f.attribute( QStringLiteral( "j_name" ) ).isNull() );
+    else
+      QCOMPARE( f.attribute( QStringLiteral( "j_name" ) ).toString(), QStringLiteral( "name %1" ).arg( id % 100 ) );
+  };
+
+  int count = 0;
+  QgsFeatureIterator fi = vlTarget->getFeatures();
+  QgsFeature f;
+  while ( fi.nextFeature( f ) )
+  {
+    checkFeature( f );
+    ++count;
+  }
+  QCOMPARE( count, 2500 );
+
+  // rewinding and limits
+  fi.rewind();
+  QVERIFY( fi.nextFeature( f ) );
+  checkFeature( f );
+
+  QgsFeatureRequest request;
+  request.setLimit( 3 );
+  fi = vlTarget->getFeatures( request );
+  count = 0;
+  while ( fi.nextFeature( f ) )
+  {
+    checkFeature( f );
+    ++count;
+  }
+  QCOMPARE( count, 3 );
+
+  // edited references are looked up too
+  vlTarget->startEditing();
+  QgsFeatureId editedFid = 0;
+  fi = vlTarget->getFeatures( QgsFeatureRequest().setFilterExpression( QStringLiteral( "id = 5" ) ) );
+  QVERIFY( fi.nextFeature( f ) );
+  editedFid = f.id();
+  QVERIFY( vlTarget->changeAttributeValue( editedFid, 1, 42 ) );
+  QVERIFY( vlTarget->getFeature( editedFid ).attribute( QStringLiteral( "j_name" ) ) == QStringLiteral( "name 42" ) );
+  fi = vlTarget->getFeatures();
+  while ( fi.nextFeature( f ) )
+  {
+    if ( f.id() == editedFid )
+      QCOMPARE( f.attribute( QStringLiteral( "j_name" ) ).toString(), QStringLiteral( "name 42" ) );
+  }
+  vlTarget->rollBack();
+
+  mProject.removeMapLayers( QStringList() << vlTarget->id() << vlJoin->id() );
+}
 
 QGSTEST_MAIN( TestVectorLayerJoinBuffer )
 #include "testqgsvectorlayerjoinbuffer.moc"
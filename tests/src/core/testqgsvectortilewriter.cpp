@@ -24,10 +24,12 @@
 #include "qgstiles.h"
 #include "qgsvectorlayer.h"
 #include "qgsvectortilemvtdecoder.h"
+#include "qgsvectortilemvtencoder.h"
 #include "qgsvectortilelayer.h"
 #include "qgsvectortilewriter.h"
 
 #include <QTemporaryDir>
+#include <QThreadPool>
 
 /**
  * \ingroup UnitTests
@@ -54,6 +56,9 @@ class TestQgsVectorTileWriter : public QObject
     void test_mbtiles();
     void test_mbtiles_metadata();
     void test_filtering();
+    void test_encoderAttributes();
+    void test_encoderLayerFeatures();
+    void test_parallel();
 };
 
 
@@ -315,6 +320,136 @@ void TestQgsVectorTileWriter::test_filtering()
   QCOMPARE( features0["polys"].count(), 0 );
 }
 
+void TestQgsVectorTileWriter::test_encoderAttributes()
+{
+  // only the requested fields are encoded, the geometries may be simplified
+  QgsVectorLayer *vlLines = new QgsVectorLayer( mDataDir + "/lines.shp", "lines", "ogr" );
+
+  QgsVectorTileMVTEncoder encoder( QgsTileXYZ( 0, 0, 0 ) );
+  encoder.setSimplifyGeometries( true );
+  QVERIFY( encoder.simplifyGeometries() );
+  encoder.addLayer( vlLines, QgsAttributeList() << vlLines->fields().indexOf( "Value" ) );
+  const QByteArray tile0 = encoder.encode();
+
+  delete vlLines;
+
+  QgsVectorTileMVTDecoder decoder;
+  QVERIFY( decoder.decode( QgsTileXYZ( 0, 0, 0 ), tile0 ) );
+  QCOMPARE( decoder.layers(), QStringList() << "lines" );
+  QCOMPARE( decoder.layerFieldNames( "lines" ), QStringList() << "Value" );
+
+  QMap<QString, QgsFields> perLayerFields;
+  perLayerFields["lines"] = QgsFields();
+  QgsVectorTileFeatures features0 = decoder.layerFeatures( perLayerFields, QgsCoordinateTransform() );
+  QCOMPARE( features0["lines"].count(), 6 );
+}
+
+void TestQgsVectorTileWriter::test_encoderLayerFeatures()
+{
+  // features read beforehand and reprojected are clipped and encoded like with addLayer()
+  QgsVectorLayer *vlLines = new QgsVectorLayer( mDataDir + "/lines.shp", "lines", "ogr" );
+  QgsCoordinateTransform ct( vlLines->crs(), QgsCoordinateReferenceSystem( "EPSG:3857" ), QgsProject::instance()->transformContext() );
+  QVector<QgsFeature> features;
+  QgsFeatureIterator fit = vlLines->getFeatures();
+  QgsFeature f;
+  while ( fit.nextFeature( f ) )
+  {
+    QgsGeometry g = f.geometry();
+    g.transform( ct );
+    f.setGeometry( g );
+    features << f;
+  }
+
+  QgsVectorTileMVTEncoder encoder( QgsTileXYZ( 0, 0, 0 ) );
+  encoder.addLayerFeatures( "lines2", vlLines->fields(), QgsAttributeList() << vlLines->fields().indexOf( "Value" ), features );
+  encoder.addLayerFeatures( "empty", vlLines->fields(), QgsAttributeList(), QVector<QgsFeature>() );
+  const QByteArray tile0 = encoder.encode();
+
+  delete vlLines;
+
+  QgsVectorTileMVTDecoder decoder;
+  QVERIFY( decoder.decode( QgsTileXYZ( 0, 0, 0 ), tile0 ) );
+  QCOMPARE( decoder.layers(), QStringList() << "lines2" );
+  QCOMPARE( decoder.layerFieldNames( "lines2" ), QStringList() << "Value" );
+
+  QMap<QString, QgsFields> perLayerFields;
+  perLayerFields["lines2"] = QgsFields();
+  QgsVectorTileFeatures features0 = decoder.layerFeatures( perLayerFields, QgsCoordinateTransform() );
+  QCOMPARE( features0["lines2"].count(), 6 );
+  QCOMPARE( features0["lines2"][0].geometry().wkbType(), QgsWkbTypes::LineString );
+}
+
+void TestQgsVectorTileWriter::test_parallel()
+{
+  // tiles encoded on several threads are written like the ones encoded on a single thread
+  const int maxThreads = QThreadPool::globalInstance()->maxThreadCount();
+
+  QMap<int, QByteArray> z0Tiles;
+  QMap<int, int> z3TileCounts;
+  for ( int threads : QList<int>() << 1 << 4 )
+  {
+    QThreadPool::globalInstance()->setMaxThreadCount( threads );
+
+    QString fileName = QDir::tempPath() + QStringLiteral( "/test_qgsvectortilewriter_parallel_%1.mbtiles" ).arg( threads );
+    if ( QFile::exists( fileName ) )
+      QFile::remove( fileName );
+
+    QgsDataSourceUri ds;
+    ds.setParam( "type", "mbtiles" );
+    ds.setParam( "url", fileName );
+
+    QgsVectorLayer *vlPoints = new QgsVectorLayer( mDataDir + "/points.shp", "points", "ogr" );
+    QgsVectorLayer *vlPolys = new QgsVectorLayer( mDataDir + "/polys.shp", "polys", "ogr" );
+
+    QList<QgsVectorTileWriter::Layer> layers;
+    layers << QgsVectorTileWriter::Layer( vlPoints );
+    layers << QgsVectorTileWriter::Layer( vlPolys );
+    layers[1].setMaxZoom( 2 );
+
+    QgsVectorTileWriter writer;
+    writer.setDestinationUri( ds.encodedUri() );
+    writer.setMaxZoom( 5 );
+    writer.setLayers( layers );
+
+    QVERIFY( writer.writeTiles() );
+    QVERIFY( writer.errorMessage().isEmpty() );
+
+    delete vlPoints;
+    delete vlPolys;
+
+    QgsMbTiles reader( fileName );
+    QVERIFY( reader.open() );
+    z0Tiles[threads] = reader.tileData( 0, 0, 0 );
+
+    QgsTileRange range = QgsTileMatrix::fromWebMercator( 3 ).tileRangeFromExtent( writer.fullExtent() );
+    int count = 0;
+    for ( int row = range.startRow(); row <= range.endRow(); ++row )
+      for ( int col = range.startColumn(); col <= range.endColumn(); ++col )
+        if ( !reader.tileData( 3, col, pow( 2, 3 ) - row - 1 ).isEmpty() )
+          ++count;
+    z3TileCounts[threads] = count;
+  }
+
+  QThreadPool::globalInstance()->setMaxThreadCount( maxThreads );
+
+  QVERIFY( !z0Tiles[1].isEmpty() );
+  QCOMPARE( z0Tiles[4], z0Tiles[1] );
+  QVERIFY( z3TileCounts[1] > 0 );
+  QCOMPARE( z3TileCounts[4], z3TileCounts[1] );
+
+  QByteArray tile0;
+  QVERIFY( QgsMbTiles::decodeGzip( z0Tiles[4], tile0 ) );
+  QgsVectorTileMVTDecoder decoder;
+  QVERIFY( decoder.decode( QgsTileXYZ( 0, 0, 0 ), tile0 ) );
+  QCOMPARE( decoder.layers(), QStringList() << "points" << "polys" );
+  QMap<QString, QgsFields> perLayerFields;
+  perLayerFields["points"] = QgsFields();
+  perLayerFields["polys"] = QgsFields();
+  QgsVectorTileFeatures features0 = decoder.layerFeatures( perLayerFields, QgsCoordinateTransform() );
+  QCOMPARE( features0["points"].count(), 17 );
+  QCOMPARE( features0["polys"].count(), 10 );
+}
+
 
 QGSTEST_MAIN( TestQgsVectorTileWriter )
 #include "testqgsvectortilewriter.moc"
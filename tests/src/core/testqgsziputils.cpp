@@ -17,6 +17,7 @@
 #include <QString>
 #include <QStringList>
 #include <QDirIterator>
+#include <QTemporaryDir>
 
 #include "qgsziputils.h"
 #include "qgsapplication.h"
@@ -35,6 +36,7 @@ class TestQgsZipUtils: public QObject
     void unzipWithSubdirs2();
     void specialChars();
     void testZip();
+    void testZipWithPrevious();
 
   private:
     void genericTest( QString zipName, int expectedEntries, bool includeFolders, const QStringList &testFileNames );
@@ -117,6 +119,36 @@ void TestQgsZipUtils::testZip()
   QVERIFY( QFile::exists( zipDirPath + "/aæýì.txt" ) );
 }
 
+void TestQgsZipUtils::testZipWithPrevious()
+{
+  QTemporaryDir dir;
+  auto writeFile = [&dir]( const QString & name, const QByteArray & content )
+  {
+    QFile file( dir.filePath( name ) );
+    file.open( QIODevice::WriteOnly | QIODevice::Truncate );
+    file.write( content );
+    return file.fileName();
+  };
+  const QString unchangedFile = writeFile( QStringLiteral( "unchanged.txt" ), QByteArray( 10000, 'a' ) );
+  const QString changedFile = writeFile( QStringLiteral( "changed.txt" ), QByteArray( 10000, 'b' ) );
+  QVERIFY( QgsZipUtils::zip( dir.filePath( QStringLiteral( "previous.zip" ) ), QStringList() << unchangedFile << changedFile ) );
+
+  // same size, different content
+  writeFile( QStringLiteral( "changed.txt" ), QByteArray( 10000, 'c' ) );
+  QVERIFY( QgsZipUtils::zip( dir.filePath( QStringLiteral( "new.zip" ) ), QStringList() << unchangedFile << changedFile, dir.filePath( QStringLiteral( "previous.zip" ) ) ) );
+
+  QDir().mkpath( dir.filePath( QStringLiteral( "unzipped" ) ) );
+  QStringList files;
+  QVERIFY( QgsZipUtils::unzip( dir.filePath( QStringLiteral( "new.zip" ) ), dir.filePath( QStringLiteral( "unzipped" ) ), files ) );
+  QCOMPARE( files.count(), 2 );
+  QFile unzippedUnchanged( dir.filePath( QStringLiteral( "unzipped/unchanged.txt" ) ) );
+  QVERIFY( unzippedUnchanged.open( QIODevice::ReadOnly ) );
+  QCOMPARE( unzippedUnchanged.readAll(), QByteArray( 10000, 'a' ) );
+  QFile unzippedChanged( dir.filePath( QStringLiteral( "unzipped/changed.txt" ) ) );
+  QVERIFY( unzippedChanged.open( QIODevice::ReadOnly ) );
+  QCOMPARE( unzippedChanged.readAll(), QByteArray( 10000, 'c' ) );
+}
+
 /**
  * \brief TestQgsZipUtils::genericTest
  * \param zipName File to unzip
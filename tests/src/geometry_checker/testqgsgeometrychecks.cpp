@@ -44,6 +44,7 @@
 #include "qgslinestring.h"
 #include "qgsproject.h"
 #include "qgsfeedback.h"
+#include <QThreadPool>
 
 #include "qgsgeometrytypecheck.h"
 
@@ -92,6 +93,7 @@ class TestQgsGeometryChecks: public QObject
     void testMultipartCheck();
     void testOverlapCheck();
     void testOverlapCheckNoMaxArea();
+    void testOverlapCheckParallel();
     void testPointCoveredByLineCheck();
     void testPointInPolygonCheck();
     void testSegmentLengthCheck();
@@ -893,6 +895,57 @@ void TestQgsGeometryChecks::testOverlapCheckNoMaxArea()
   QCOMPARE( errs1.size(), 2 );
 }
 
+void TestQgsGeometryChecks::testOverlapCheckParallel()
+{
+  // enough features for several batches, each checked on several threads
+  QgsVectorLayer *layer = new QgsVectorLayer( QStringLiteral( "Polygon?crs=epsg:4326" ), QStringLiteral( "grid" ), QStringLiteral( "memory" ) );
+  QgsFeatureList features;
+  for ( int row = 0; row < 50; ++row )
+  {
+    for ( int column = 0; column < 40; ++column )
+    {
+      // each square overlaps its right neighbor
+      QgsFeature feature;
+      feature.setGeometry( QgsGeometry::fromRect( QgsRectangle( column * 0.9, row * 2, column * 0.9 + 1, row * 2 + 1 ) ) );
+      features << feature;
+    }
+  }
+  layer->dataProvider()->addFeatures( features );
+
+  QMap<QString, QgsFeaturePool *> featurePools;
+  featurePools.insert( layer->id(), createFeaturePool( layer ) );
+  QgsGeometryCheckContext context( 8, layer->crs(), QgsProject::instance()->transformContext(), QgsProject::instance() );
+  QgsGeometryOverlapCheck check( &context, QVariantMap() );
+
+  const int maxThreads = QThreadPool::globalInstance()->maxThreadCount();
+  QList<QgsGeometryCheckError *> parallelErrors;
+  QList<QgsGeometryCheckError *> serialErrors;
+  QStringList messages;
+  QgsFeedback feedback;
+  QThreadPool::globalInstance()->setMaxThreadCount( 4 );
+  check.collectErrors( featurePools, parallelErrors, messages, &feedback );
+  QThreadPool::globalInstance()->setMaxThreadCount( 1 );
+  check.collectErrors( featurePools, serialErrors, messages, &feedback );
+  QThreadPool::globalInstance()->setMaxThreadCount( maxThreads );
+
+  QVERIFY( messages.isEmpty() );
+  QCOMPARE( parallelErrors.size(), 39 * 50 );
+  QCOMPARE( serialErrors.size(), parallelErrors.size() );
+  for ( int i = 0; i < parallelErrors.size(); ++i )
+  {
+    const QgsGeometryOverlapCheckError *parallelError = static_cast<QgsGeometryOverlapCheckError *>( parallelErrors.at( i ) );
+    const QgsGeometryOverlapCheckError *serialError = static_cast<QgsGeometryOverlapCheckError *>( serialErrors.at( i ) );
+    QCOMPARE( parallelError->featureId(), serialError->featureId() );
+    QCOMPARE( parallelError->overlappedFeature().featureId(), serialError->overlappedFeature().featureId() );
+    QGSCOMPARENEAR( parallelError->value().toDouble(), 0.1, 1e-8 );
+  }
+
+  qDeleteAll( parallelErrors );
+  qDeleteAll( serialErrors );
+  qDeleteAll( featurePools );
+  delete layer;
+}
+
 void TestQgsGeometryChecks::testPointCoveredByLineCheck()
 {
   QTemporaryDir dir;
@@ -19,6 +19,7 @@
 #include <editorwidgets/core/qgseditorwidgetregistry.h>
 #include <attributetable/qgsattributetableview.h>
 #include <attributetable/qgsdualview.h>
+#include <attributetable/qgsattributetablemodel.h>
 #include "qgsattributeform.h"
 #include <qgsapplication.h>
 #include "qgsfeatureiterator.h"
@@ -27,6 +28,9 @@
 #include <qgsmapcanvas.h>
 #include <qgsfeature.h>
 #include "qgsgui.h"
+#include "qgsvectorlayercache.h"
+
+#include <QSignalSpy>
 
 #include "qgstest.h"
 
@@ -55,6 +59,7 @@ class TestQgsDualView : public QObject
 
     void testAttributeFormSharedValueScanning();
     void testNoGeom();
+    void testLoadLayerSignals();
 
   private:
     QgsMapCanvas *mCanvas = nullptr;
@@ -334,5 +339,64 @@ void TestQgsDualView::testNoGeom()
   QVERIFY( ( model->request().flags() & QgsFeatureRequest::NoGeometry ) );
 }
 
+void TestQgsDualView::testLoadLayerSignals()
+{
+  QgsVectorLayer layer( QStringLiteral( "Point?crs=epsg:4326&field=id:integer" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer.isValid() );
+  QgsFeatureList features;
+  for ( int i = 0; i < 100; ++i )
+  {
+    QgsFeature feature( layer.fields() );
+    feature.setAttributes( QgsAttributes() << i );
+    feature.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( i, i ) ) );
+    features << feature;
+  }
+  QVERIFY( layer.dataProvider()->addFeatures( features ) );
+
+  QgsVectorLayerCache cache( &layer, 1000 );
+  QgsAttributeTableModel model( &cache );
+  QSignalSpy resetSpy( &model, &QAbstractItemModel::modelReset );
+  QSignalSpy insertedSpy( &model, &QAbstractItemModel::rowsInserted );
+  QSignalSpy dataChangedSpy( &model, &QAbstractItemModel::dataChanged );
+
+  // the rows are only announced by the reset of the model, not one by one
+  model.loadLayer();
+  QCOMPARE( model.rowCount(), 100 );
+  QCOMPARE( resetSpy.count(), 1 );
+  QCOMPARE( insertedSpy.count(), 0 );
+  QCOMPARE( dataChangedSpy.count(), 0 );
+  for ( int row = 0; row < model.rowCount(); ++row )
+  {
+    QgsFeature feature = layer.getFeature( model.rowToId( row ) );
+    QCOMPARE( model.data( model.index( row, 0 ), Qt::EditRole ), feature.attribute( 0 ) );
+    QCOMPARE( model.idToRow( feature.id() ), row );
+  }
+
+  // a filtered load
+  model.setRequest( QgsFeatureRequest().setFilterFids( QgsFeatureIds() << features.at( 2 ).id() << features.at( 5 ).id() ) );
+  model.loadLayer();
+  QCOMPARE( model.rowCount(), 2 );
+  QCOMPARE( resetSpy.count(), 2 );
+  QCOMPARE( insertedSpy.count(), 0 );
+  QCOMPARE( dataChangedSpy.count(), 0 );
+  QCOMPARE( model.data( model.index( model.idToRow( features.at( 5 ).id() ), 0 ), Qt::EditRole ).toInt(), 5 );
+
+  // a feature added after the load is still announced as an inserted row
+  model.setRequest( QgsFeatureRequest() );
+  model.loadLayer();
+  QCOMPARE( model.rowCount(), 100 );
+  QVERIFY( layer.startEditing() );
+  QgsFeature feature( layer.fields() );
+  feature.setAttributes( QgsAttributes() << 100 );
+  feature.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( 100, 100 ) ) );
+  QVERIFY( layer.addFeature( feature ) );
+  QCOMPARE( model.rowCount(), 101 );
+  QCOMPARE( insertedSpy.count(), 1 );
+  QCOMPARE( insertedSpy.at( 0 ).at( 1 ).toInt(), 100 );
+  QCOMPARE( dataChangedSpy.count(), 1 );
+  QCOMPARE( model.data( model.index( 100, 0 ), Qt::EditRole ).toInt(), 100 );
+  layer.rollBack();
+}
+
 QGSTEST_MAIN( TestQgsDualView )
 #include "testqgsdualview.moc"
@@ -0,0 +1,82 @@
+/***************************************************************************
+    testqgspostgreslistener.cpp
+    ---------------------
+    Date                 : October 2020
+    Copyright            : (C) 2020 by the QGIS project
+    Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgstest.h"
+#include <QObject>
+#include <QElapsedTimer>
+
+#include <qgspostgresconn.h>
+#include <qgspostgreslistener.h>
+
+//! Number of identical notifications sent in a burst
+const int BURST_SIZE = 50;
+
+/**
+ * \ingroup UnitTests
+ * This is a unit test for the listener of the PostgreSQL notifications.
+ * It needs the test database of QGIS_PGTEST_DB.
+ */
+class TestQgsPostgresListener: public QObject
+{
+    Q_OBJECT
+  private slots:
+
+    void initTestCase()
+    {
+      mConnInfo = QString::fromLocal8Bit( qgetenv( "QGIS_PGTEST_DB" ) );
+      if ( mConnInfo.isEmpty() )
+        mConnInfo = QStringLiteral( "service=qgis_test" );
+    }
+
+    void coalesceBurst()
+    {
+      QgsPostgresConn *conn = QgsPostgresConn::connectDb( mConnInfo, false, false );
+      if ( !conn )
+        QSKIP( "The PostgreSQL test database is not available" );
+
+      std::unique_ptr< QgsPostgresListener > listener = QgsPostgresListener::create( mConnInfo );
+      QStringList received;
+      const QMetaObject::Connection connection = connect( listener.get(), &QgsPostgresListener::notify, this, [&received]( const QString & message ) { received << message; } );
+
+      // one transaction per notification, PostgreSQL only folds the identical notifications of a same transaction
+      QString burst;
+      for ( int i = 0; i < BURST_SIZE; ++i )
+        burst += QStringLiteral( "BEGIN; NOTIFY qgis, 'burst'; COMMIT; " );
+      burst += QStringLiteral( "BEGIN; NOTIFY qgis, 'last'; COMMIT;" );
+      QVERIFY( conn->PQexecNR( burst ) );
+
+      QElapsedTimer timer;
+      timer.start();
+      while ( !received.contains( QStringLiteral( "last" ) ) && timer.elapsed() < 10000 )
+        QTest::qWait( 50 );
+      // the notifications read together are emitted once
+      QTest::qWait( 200 );
+
+      QCOMPARE( received.count( QStringLiteral( "last" ) ), 1 );
+      QVERIFY( received.count( QStringLiteral( "burst" ) ) >= 1 );
+      QVERIFY( received.count( QStringLiteral( "burst" ) ) < BURST_SIZE );
+      // the order of the notifications is kept
+      QCOMPARE( received.last(), QStringLiteral( "last" ) );
+
+      disconnect( connection );
+      listener.reset();
+      conn->unref();
+    }
+
+  private:
+    QString mConnInfo;
+};
+
+QGSTEST_MAIN( TestQgsPostgresListener )
+#include "testqgspostgreslistener.moc"
@@ -0,0 +1,127 @@
+/***************************************************************************
+     testqgsvirtuallayerprovider.cpp
+     -------------------------------
+    Date                 : October 2020
+    Copyright            : (C) 2020 by the QGIS project
+    Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include <QObject>
+
+#include "qgsapplication.h"
+#include "qgsfeatureiterator.h"
+#include "qgsgeometry.h"
+#include "qgsproject.h"
+#include "qgsvectordataprovider.h"
+#include "qgsvectorlayer.h"
+#include "qgsvirtuallayerdefinition.h"
+
+class TestQgsVirtualLayerProvider : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void testFilters_data();
+    void testFilters();
+    void testGeometry();
+
+  private:
+    QList<QVariant> queryValues( const QString &query, int attribute = 0 ) const;
+
+    QgsVectorLayer *mLayer = nullptr;
+};
+
+void TestQgsVirtualLayerProvider::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+
+  mLayer = new QgsVectorLayer( QStringLiteral( "Point?field=a:integer&field=b:string&field=c:double" ), QStringLiteral( "t" ), QStringLiteral( "memory" ) );
+  QgsFeatureList features;
+  for ( int i = 0; i < 1000; ++i )
+  {
+    QgsFeature feature( mLayer->fields() );
+    feature.setAttributes( QgsAttributes() << i << QStringLiteral( "X%1" ).arg( i % 2 ) << ( i % 10 ? QVariant( i / 4.0 ) : QVariant() ) );
+    feature.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( i, -i ) ) );
+    features << feature;
+  }
+  QVERIFY( mLayer->dataProvider()->addFeatures( features ) );
+  QgsProject::instance()->addMapLayer( mLayer );
+}
+
+void TestQgsVirtualLayerProvider::cleanupTestCase()
+{
+  QgsProject::instance()->removeAllMapLayers();
+  QgsApplication::exitQgis();
+}
+
+QList<QVariant> TestQgsVirtualLayerProvider::queryValues( const QString &query, int attribute ) const
+{
+  QgsVirtualLayerDefinition definition;
+  definition.addSource( QStringLiteral( "t" ), mLayer->id() );
+  definition.setQuery( query );
+  QgsVectorLayer layer( definition.toString(), QStringLiteral( "virtual" ), QStringLiteral( "virtual" ) );
+  if ( !layer.isValid() )
+    return QList<QVariant>() << QStringLiteral( "invalid" );
+
+  QList<QVariant> values;
+  QgsFeatureIterator it = layer.getFeatures();
+  QgsFeature feature;
+  while ( it.nextFeature( feature ) )
+    values << feature.attribute( attribute );
+  return values;
+}
+
+void TestQgsVirtualLayerProvider::testFilters_data()
+{
+  QTest::addColumn<QString>( "query" );
+  QTest::addColumn<QList<QVariant>>( "expected" );
+
+  QTest::newRow( "comparisons" ) << QStringLiteral( "SELECT a FROM t WHERE a > 5 AND a <= 8" ) << ( QList<QVariant>() << 6 << 7 << 8 );
+  QTest::newRow( "double" ) << QStringLiteral( "SELECT a FROM t WHERE c = 0.25" ) << ( QList<QVariant>() << 1 );
+  QTest::newRow( "in" ) << QStringLiteral( "SELECT a FROM t WHERE a IN (11, 3, 7) ORDER BY a" ) << ( QList<QVariant>() << 3 << 7 << 11 );
+  QTest::newRow( "in text" ) << QStringLiteral( "SELECT count(*) FROM t WHERE b IN ('X1', 'Y')" ) << ( QList<QVariant>() << 500 );
+  QTest::newRow( "like" ) << QStringLiteral( "SELECT count(*) FROM t WHERE b LIKE 'x0'" ) << ( QList<QVariant>() << 500 );
+  QTest::newRow( "null" ) << QStringLiteral( "SELECT count(*) FROM t WHERE c = NULL" ) << ( QList<QVariant>() << 0 );
+  QTest::newRow( "order by limit" ) << QStringLiteral( "SELECT a FROM t WHERE a >= 990 AND b = 'X1' ORDER BY a DESC LIMIT 3" ) << ( QList<QVariant>() << 999 << 997 << 995 );
+  QTest::newRow( "limit offset" ) << QStringLiteral( "SELECT a FROM t WHERE a < 100 ORDER BY a LIMIT 2 OFFSET 10" ) << ( QList<QVariant>() << 10 << 11 );
+  QTest::newRow( "order by nulls" ) << QStringLiteral( "SELECT a FROM t WHERE a < 25 AND a != 10 AND a != 20 ORDER BY c LIMIT 2" ) << ( QList<QVariant>() << 0 << 1 );
+  QTest::newRow( "order by text" ) << QStringLiteral( "SELECT a FROM t WHERE a < 4 ORDER BY b DESC, a LIMIT 3" ) << ( QList<QVariant>() << 1 << 3 << 0 );
+}
+
+void TestQgsVirtualLayerProvider::testFilters()
+{
+  QFETCH( QString, query );
+  QFETCH( QList<QVariant>, expected );
+
+  const QList<QVariant> values = queryValues( query );
+  QCOMPARE( values.size(), expected.size() );
+  for ( int i = 0; i < values.size(); ++i )
+    QCOMPARE( values.at( i ).toLongLong(), expected.at( i ).toLongLong() );
+}
+
+void TestQgsVirtualLayerProvider::testGeometry()
+{
+  // the geometry is read twice for the same row
+  QList<QVariant> values = queryValues( QStringLiteral( "SELECT st_x(geometry) + st_y(geometry) AS s, st_x(geometry) AS x FROM t WHERE a = 5" ), 1 );
+  QCOMPARE( values, QList<QVariant>() << 5.0 );
+
+  // rtree filter
+  values = queryValues( QStringLiteral( "SELECT a FROM t WHERE _search_frame_ = BuildMbr(9.5, -12.5, 12.5, -9.5) ORDER BY a" ) );
+  QCOMPARE( values.size(), 3 );
+  QCOMPARE( values.at( 0 ).toInt(), 10 );
+  QCOMPARE( values.at( 2 ).toInt(), 12 );
+}
+
+QGSTEST_MAIN( TestQgsVirtualLayerProvider )
+#include "testqgsvirtuallayerprovider.moc"
@@ -167,6 +167,59 @@ class TestQgsWmsProvider: public QObject
 
     }
 
+    void tileMatrixWithOneLimitedDimension()
+    {
+      const QString uri = QStringLiteral( "crs=EPSG:4326&format=image/png&layers=agri_zones&styles&url=http://localhost:8380/mapserv" );
+      QgsWmsProvider provider( uri, QgsDataProvider::ProviderOptions(), mCapabilities );
+      provider.mLayerExtent = QgsRectangle( 0, 0, 3000, 4000 );
+
+      // the server only limits the width, the height of the tiles is the default step size
+      std::unique_ptr<QgsWmtsTileMatrix> tm = provider.createTileMatrixWMS( 1, 1000, std::numeric_limits<int>::max() );
+      QCOMPARE( tm->tileWidth, 1000 );
+      QCOMPARE( tm->tileHeight, 2000 );
+      // the extent is exactly 3 x 2 tiles
+      QCOMPARE( tm->matrixWidth, 3 );
+      QCOMPARE( tm->matrixHeight, 2 );
+      QCOMPARE( tm->topLeft, QgsPointXY( 0, 4000 ) );
+      QCOMPARE( tm->tres, 1.0 );
+
+      // the resolution is not exactly representable, the rounding errors do not add a column
+      provider.mLayerExtent = QgsRectangle( 0, 0, 4200, 4000 );
+      tm = provider.createTileMatrixWMS( 0.7, 1000, std::numeric_limits<int>::max() );
+      QCOMPARE( tm->matrixWidth, 6 );
+      QCOMPARE( tm->matrixHeight, 3 );
+
+      // one more pixel needs another column or row
+      provider.mLayerExtent = QgsRectangle( 0, 0, 3001, 4001 );
+      tm = provider.createTileMatrixWMS( 1, 1000, std::numeric_limits<int>::max() );
+      QCOMPARE( tm->matrixWidth, 4 );
+      QCOMPARE( tm->matrixHeight, 3 );
+
+      // the server only limits the height
+      tm = provider.createTileMatrixWMS( 1, std::numeric_limits<int>::max(), 1000 );
+      QCOMPARE( tm->tileWidth, 2000 );
+      QCOMPARE( tm->tileHeight, 1000 );
+      QCOMPARE( tm->matrixWidth, 2 );
+      QCOMPARE( tm->matrixHeight, 5 );
+
+      // the unlimited dimension follows the step size of the URI
+      QgsWmsProvider stepProvider( uri + QStringLiteral( "&stepWidth=1500&stepHeight=1500" ), QgsDataProvider::ProviderOptions(), mCapabilities );
+      stepProvider.mLayerExtent = QgsRectangle( 0, 0, 3000, 4000 );
+      tm = stepProvider.createTileMatrixWMS( 1, 1000, std::numeric_limits<int>::max() );
+      QCOMPARE( tm->tileWidth, 1000 );
+      QCOMPARE( tm->tileHeight, 1500 );
+      QCOMPARE( tm->matrixHeight, 3 );
+
+      // the limits of the URI apply when they are smaller than the ones of the server
+      QgsWmsProvider limitedProvider( uri + QStringLiteral( "&maxWidth=500&maxHeight=800" ), QgsDataProvider::ProviderOptions(), mCapabilities );
+      limitedProvider.mLayerExtent = QgsRectangle( 0, 0, 3000, 4000 );
+      tm = limitedProvider.createTileMatrixWMS( 1, 1000, std::numeric_limits<int>::max() );
+      QCOMPARE( tm->tileWidth, 500 );
+      QCOMPARE( tm->tileHeight, 800 );
+      QCOMPARE( tm->matrixWidth, 6 );
+      QCOMPARE( tm->matrixHeight, 5 );
+    }
+
 
     bool imageCheck( const QString &testType, QgsMapLayer *layer, const QgsRectangle &extent )
     {
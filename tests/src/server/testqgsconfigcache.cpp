@@ -0,0 +1,339 @@
+/***************************************************************************
+     testqgsconfigcache.cpp
+     ----------------------
+    Date                 : October 2020
+    Copyright            : (C) 2020 by the QGIS project
+    Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgstest.h"
+
+#include "qgscapabilitiescache.h"
+#include "qgsconfigcache.h"
+#include "qgsproject.h"
+#include "qgsserverexception.h"
+#include "qgsserverprojectlocker.h"
+#include "qgsserversettings.h"
+#include "qgsvectorlayer.h"
+
+#include <QSignalSpy>
+#include <QTemporaryDir>
+
+#include <atomic>
+#include <thread>
+
+/**
+ * \ingroup UnitTests
+ * Unit tests for the lazy loading of the layers of the server config cache,
+ * the project file change notifications and the persisted capabilities documents
+ */
+class TestQgsConfigCache : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void resolveLayer();
+    void unresolvableLayer();
+    void concurrentResolve();
+    void unchangedProjectFile();
+    void persistedCapabilities();
+
+  private:
+    //! Writes a GeoJSON file with 3 points
+    void writeDataFile( const QString &path ) const;
+
+    //! Writes a project with a layer reading \a dataPath and returns its path
+    QString writeProject( const QString &name, const QString &dataPath ) const;
+
+    //! Appends a line break to the project file at \a projectPath, the project stays valid but its checksum changes
+    void modifyProjectFile( const QString &projectPath ) const;
+
+    //! Sends a file system change notification for \a projectPath to the config cache, as the file system watcher does
+    void notifyProjectFileChanged( const QString &projectPath ) const;
+
+    //! Returns the single layer of the project, read with the lazy layer loading
+    QgsMapLayer *projectLayer( const QString &projectPath, std::shared_ptr<const QgsProject> &project );
+
+    std::unique_ptr<QTemporaryDir> mTempDir;
+    std::unique_ptr<QgsServerSettings> mSettings;
+};
+
+void TestQgsConfigCache::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+
+  mTempDir = qgis::make_unique<QTemporaryDir>();
+  QVERIFY( mTempDir->isValid() );
+
+  qputenv( "QGIS_SERVER_LAZY_LAYER_LOADING", "true" );
+  mSettings = qgis::make_unique<QgsServerSettings>();
+  mSettings->load();
+  QVERIFY( mSettings->lazyLayerLoading() );
+}
+
+void TestQgsConfigCache::cleanupTestCase()
+{
+  mSettings.reset();
+  mTempDir.reset();
+  QgsApplication::exitQgis();
+}
+
+void TestQgsConfigCache::writeDataFile( const QString &path ) const
+{
+  QFile file( path );
+  QVERIFY( file.open( QIODevice::WriteOnly | QIODevice::Truncate ) );
+  file.write( "{ \"type\": \"FeatureCollection\", \"features\": ["
+              "{ \"type\": \"Feature\", \"properties\": { \"id\": 1 }, \"geometry\": { \"type\": \"Point\", \"coordinates\": [ 1, 1 ] } },"
+              "{ \"type\": \"Feature\", \"properties\": { \"id\": 2 }, \"geometry\": { \"type\": \"Point\", \"coordinates\": [ 2, 2 ] } },"
+              "{ \"type\": \"Feature\", \"properties\": { \"id\": 3 }, \"geometry\": { \"type\": \"Point\", \"coordinates\": [ 3, 3 ] } } ] }" );
+}
+
+QString TestQgsConfigCache::writeProject( const QString &name, const QString &dataPath ) const
+{
+  writeDataFile( dataPath );
+
+  QgsProject project;
+  QgsVectorLayer *layer = new QgsVectorLayer( dataPath, QStringLiteral( "points" ), QStringLiteral( "ogr" ) );
+  project.addMapLayer( layer );
+
+  const QString projectPath = mTempDir->filePath( name );
+  project.write( projectPath );
+  return projectPath;
+}
+
+void TestQgsConfigCache::modifyProjectFile( const QString &projectPath ) const
+{
+  QFile file( projectPath );
+  QVERIFY( file.open( QIODevice::WriteOnly | QIODevice::Append ) );
+  file.write( "\n" );
+}
+
+void TestQgsConfigCache::notifyProjectFileChanged( const QString &projectPath ) const
+{
+  QVERIFY( QMetaObject::invokeMethod( QgsConfigCache::instance(), "removeChangedEntry", Qt::DirectConnection, Q_ARG( QString, projectPath ) ) );
+}
+
+QgsMapLayer *TestQgsConfigCache::projectLayer( const QString &projectPath, std::shared_ptr<const QgsProject> &project )
+{
+  project = QgsConfigCache::instance()->project( projectPath, mSettings.get() );
+  if ( !project || project->mapLayers().size() != 1 )
+    return nullptr;
+  return project->mapLayers().first();
+}
+
+void TestQgsConfigCache::resolveLayer()
+{
+  const QString projectPath = writeProject( QStringLiteral( "resolve.qgs" ), mTempDir->filePath( QStringLiteral( "resolve.geojson" ) ) );
+
+  std::shared_ptr<const QgsProject> project;
+  QgsMapLayer *layer = projectLayer( projectPath, project );
+  QVERIFY( layer );
+  // the layer is read without its data source
+  QVERIFY( !layer->isValid() );
+
+  QgsConfigCache::instance()->resolveLayers( { layer } );
+  QVERIFY( layer->isValid() );
+  QCOMPARE( qobject_cast<QgsVectorLayer *>( layer )->featureCount(), 3L );
+
+  // resolving a loaded layer again is a no-op
+  QgsConfigCache::instance()->resolveLayers( { layer } );
+  QVERIFY( layer->isValid() );
+
+  QgsConfigCache::instance()->removeEntry( projectPath );
+}
+
+void TestQgsConfigCache::unresolvableLayer()
+{
+  const QString dataPath = mTempDir->filePath( QStringLiteral( "unresolvable.geojson" ) );
+  const QString projectPath = writeProject( QStringLiteral( "unresolvable.qgs" ), dataPath );
+  QVERIFY( QFile::remove( dataPath ) );
+
+  std::shared_ptr<const QgsProject> project;
+  QgsMapLayer *layer = projectLayer( projectPath, project );
+  QVERIFY( layer );
+
+  // every request using the layer fails, not only the first one
+  QVERIFY_EXCEPTION_THROWN( QgsConfigCache::instance()->resolveLayers( { layer } ), QgsServerException );
+  QVERIFY( !layer->isValid() );
+  QVERIFY_EXCEPTION_THROWN( QgsConfigCache::instance()->resolveLayers( { layer } ), QgsServerException );
+  QVERIFY( !layer->isValid() );
+
+  // the layer stays unresolved, it is loaded once its data is available
+  writeDataFile( dataPath );
+  QgsConfigCache::instance()->resolveLayers( { layer } );
+  QVERIFY( layer->isValid() );
+  QCOMPARE( qobject_cast<QgsVectorLayer *>( layer )->featureCount(), 3L );
+
+  QgsConfigCache::instance()->removeEntry( projectPath );
+}
+
+void TestQgsConfigCache::concurrentResolve()
+{
+  const QString projectPath = writeProject( QStringLiteral( "concurrent.qgs" ), mTempDir->filePath( QStringLiteral( "concurrent.geojson" ) ) );
+
+  std::shared_ptr<const QgsProject> project;
+  QgsMapLayer *layer = projectLayer( projectPath, project );
+  QVERIFY( layer );
+  QVERIFY( !layer->isValid() );
+
+  // as the requests of the worker threads, each thread resolves the layer
+  // and then reads it while holding a shared lock on the project
+  std::atomic<int> failures( 0 );
+  std::vector<std::thread> threads;
+  for ( int i = 0; i < 8; ++i )
+  {
+    threads.emplace_back( [&failures, layer, project]
+    {
+      for ( int j = 0; j < 20; ++j )
+      {
+        try
+        {
+          QgsConfigCache::instance()->resolveLayers( { layer } );
+          const QgsServerProjectLocker locker( project.get(), QgsServerProjectLocker::Shared );
+          QgsVectorLayer *vectorLayer = qobject_cast<QgsVectorLayer *>( layer );
+          if ( !vectorLayer->isValid() || vectorLayer->featureCount() != 3 )
+            ++failures;
+        }
+        catch ( QgsServerException & )
+        {
+          ++failures;
+        }
+      }
+    } );
+  }
+  for ( std::thread &thread : threads )
+    thread.join();
+
+  QCOMPARE( failures.load(), 0 );
+  QVERIFY( layer->isValid() );
+
+  QgsConfigCache::instance()->removeEntry( projectPath );
+}
+
+void TestQgsConfigCache::unchangedProjectFile()
+{
+  const QString projectPath = writeProject( QStringLiteral( "unchanged.qgs" ), mTempDir->filePath( QStringLiteral( "unchanged.geojson" ) ) );
+
+  QgsConfigCache *cache = QgsConfigCache::instance();
+  const std::shared_ptr<const QgsProject> project = cache->project( projectPath, mSettings.get() );
+  QVERIFY( project );
+  const QByteArray checksum = cache->projectChecksum( projectPath );
+  QVERIFY( !checksum.isEmpty() );
+  QCOMPARE( checksum, QgsConfigCache::fileChecksum( projectPath ) );
+  QVERIFY( QgsConfigCache::fileChecksum( mTempDir->filePath( QStringLiteral( "missing.qgs" ) ) ).isEmpty() );
+
+  QSignalSpy removedSpy( cache, &QgsConfigCache::projectRemovedFromCache );
+
+  // the file is written again with the same content, the project is not read again
+  QFile file( projectPath );
+  QVERIFY( file.open( QIODevice::ReadOnly ) );
+  const QByteArray content = file.readAll();
+  file.close();
+  QVERIFY( file.open( QIODevice::WriteOnly | QIODevice::Truncate ) );
+  QCOMPARE( file.write( content ), static_cast<qint64>( content.size() ) );
+  file.close();
+  notifyProjectFileChanged( projectPath );
+  QCOMPARE( removedSpy.count(), 0 );
+  QCOMPARE( cache->project( projectPath, mSettings.get() ).get(), project.get() );
+  QCOMPARE( cache->projectChecksum( projectPath ), checksum );
+
+  // the content changes, the project is removed and read again
+  modifyProjectFile( projectPath );
+  notifyProjectFileChanged( projectPath );
+  QCOMPARE( removedSpy.count(), 1 );
+  QCOMPARE( removedSpy.at( 0 ).at( 0 ).toString(), projectPath );
+  QVERIFY( cache->projectChecksum( projectPath ).isEmpty() );
+
+  const std::shared_ptr<const QgsProject> modifiedProject = cache->project( projectPath, mSettings.get() );
+  QVERIFY( modifiedProject );
+  QVERIFY( modifiedProject.get() != project.get() );
+  QVERIFY( !cache->projectChecksum( projectPath ).isEmpty() );
+  QVERIFY( cache->projectChecksum( projectPath ) != checksum );
+
+  cache->removeEntry( projectPath );
+  QCOMPARE( removedSpy.count(), 2 );
+}
+
+void TestQgsConfigCache::persistedCapabilities()
+{
+  const QString projectPath = writeProject( QStringLiteral( "capabilities.qgs" ), mTempDir->filePath( QStringLiteral( "capabilities.geojson" ) ) );
+  const QString directory = mTempDir->filePath( QStringLiteral( "capabilities" ) );
+  QVERIFY( QgsConfigCache::instance()->project( projectPath, mSettings.get() ) );
+
+  QDomDocument doc;
+  QVERIFY( doc.setContent( QStringLiteral( "<WMS_Capabilities version=\"1.3.0\"><Service><Title>first</Title></Service></WMS_Capabilities>" ) ) );
+  {
+    QgsCapabilitiesCache capabilitiesCache( directory );
+    QVERIFY( !capabilitiesCache.searchCapabilitiesDocument( projectPath, QStringLiteral( "1.3.0" ) ) );
+    capabilitiesCache.insertCapabilitiesDocument( projectPath, QStringLiteral( "1.3.0" ), &doc );
+    QVERIFY( capabilitiesCache.searchCapabilitiesDocument( projectPath, QStringLiteral( "1.3.0" ) ) );
+  }
+
+  // after a restart, the document is read from the disk
+  {
+    QgsCapabilitiesCache capabilitiesCache( directory );
+    const std::shared_ptr<const QDomDocument> persisted = capabilitiesCache.searchCapabilitiesDocument( projectPath, QStringLiteral( "1.3.0" ) );
+    QVERIFY( persisted );
+    QCOMPARE( persisted->toString(), doc.toString() );
+    QVERIFY( !capabilitiesCache.searchCapabilitiesDocument( projectPath, QStringLiteral( "1.1.1" ) ) );
+  }
+
+  // without directory, the documents are only cached in memory
+  {
+    QgsCapabilitiesCache capabilitiesCache;
+    QVERIFY( !capabilitiesCache.searchCapabilitiesDocument( projectPath, QStringLiteral( "1.3.0" ) ) );
+  }
+
+  // an unchanged project file keeps its persisted documents
+  notifyProjectFileChanged( projectPath );
+  {
+    QgsCapabilitiesCache capabilitiesCache( directory );
+    QVERIFY( capabilitiesCache.searchCapabilitiesDocument( projectPath, QStringLiteral( "1.3.0" ) ) );
+  }
+
+  // the documents of a previous version of the project are not used and are replaced
+  modifyProjectFile( projectPath );
+  notifyProjectFileChanged( projectPath );
+  QVERIFY( QgsConfigCache::instance()->project( projectPath, mSettings.get() ) );
+  QDomDocument modifiedDoc;
+  QVERIFY( modifiedDoc.setContent( QStringLiteral( "<WMS_Capabilities version=\"1.3.0\"><Service><Title>second</Title></Service></WMS_Capabilities>" ) ) );
+  {
+    QgsCapabilitiesCache capabilitiesCache( directory );
+    QVERIFY( !capabilitiesCache.searchCapabilitiesDocument( projectPath, QStringLiteral( "1.3.0" ) ) );
+    capabilitiesCache.insertCapabilitiesDocument( projectPath, QStringLiteral( "1.3.0" ), &modifiedDoc );
+  }
+  {
+    QgsCapabilitiesCache capabilitiesCache( directory );
+    const std::shared_ptr<const QDomDocument> persisted = capabilitiesCache.searchCapabilitiesDocument( projectPath, QStringLiteral( "1.3.0" ) );
+    QVERIFY( persisted );
+    QCOMPARE( persisted->toString(), modifiedDoc.toString() );
+
+    // removed documents are also removed from the disk
+    capabilitiesCache.removeCapabilitiesDocument( projectPath );
+    QVERIFY( !capabilitiesCache.searchCapabilitiesDocument( projectPath, QStringLiteral( "1.3.0" ) ) );
+  }
+
+  // nothing is read for a project which is not cached
+  {
+    QgsCapabilitiesCache capabilitiesCache( directory );
+    capabilitiesCache.insertCapabilitiesDocument( projectPath, QStringLiteral( "1.3.0" ), &modifiedDoc );
+  }
+  QgsConfigCache::instance()->removeEntry( projectPath );
+  {
+    QgsCapabilitiesCache capabilitiesCache( directory );
+    QVERIFY( !capabilitiesCache.searchCapabilitiesDocument( projectPath, QStringLiteral( "1.3.0" ) ) );
+  }
+}
+
+QGSTEST_MAIN( TestQgsConfigCache )
+#include "testqgsconfigcache.moc"
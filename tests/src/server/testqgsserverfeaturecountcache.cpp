@@ -0,0 +1,250 @@
+/***************************************************************************
+     testqgsserverfeaturecountcache.cpp
+     ----------------------------------
+    Date                 : October 2020
+    Copyright            : (C) 2020 by the QGIS project
+    Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgstest.h"
+
+#include "qgsserverfeaturecountcache.h"
+#include "qgsvectorlayer.h"
+#include "qgsvectordataprovider.h"
+#include "qgsvectorfilewriter.h"
+#include "qgsgeometry.h"
+
+#include <QTemporaryDir>
+#include <QThread>
+
+/**
+ * \ingroup UnitTests
+ * Unit tests for the cache of the feature counts and extents of the served layers
+ */
+class TestQgsServerFeatureCountCache : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+
+    void hitAndMiss();
+    void filters();
+    void invalidation();
+    void eviction();
+
+  private:
+    //! Writes a GeoPackage with \a count points named "point <i>" and returns a layer reading it
+    std::unique_ptr<QgsVectorLayer> writeLayer( const QString &name, int count ) const;
+
+    //! Adds a point to \a layer, behind the back of the cache
+    void addPoint( QgsVectorLayer *layer, double x, double y ) const;
+
+    std::unique_ptr<QTemporaryDir> mTempDir;
+};
+
+void TestQgsServerFeatureCountCache::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+
+  mTempDir = qgis::make_unique<QTemporaryDir>();
+  QVERIFY( mTempDir->isValid() );
+}
+
+void TestQgsServerFeatureCountCache::cleanupTestCase()
+{
+  QgsServerFeatureCountCache::instance()->setTimeToLive( 0 );
+  mTempDir.reset();
+  QgsApplication::exitQgis();
+}
+
+void TestQgsServerFeatureCountCache::init()
+{
+  QgsServerFeatureCountCache::instance()->clear();
+  QgsServerFeatureCountCache::instance()->setTimeToLive( 60 );
+}
+
+std::unique_ptr<QgsVectorLayer> TestQgsServerFeatureCountCache::writeLayer( const QString &name, int count ) const
+{
+  QgsVectorLayer memoryLayer( QStringLiteral( "Point?crs=epsg:4326&field=name:string" ), name, QStringLiteral( "memory" ) );
+  QgsFeatureList features;
+  for ( int i = 0; i < count; ++i )
+  {
+    QgsFeature feature( memoryLayer.fields() );
+    feature.setAttributes( QgsAttributes() << QStringLiteral( "point %1" ).arg( i ) );
+    feature.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( i, i ) ) );
+    features << feature;
+  }
+  memoryLayer.dataProvider()->addFeatures( features );
+
+  const QString path = mTempDir->filePath( name + QStringLiteral( ".gpkg" ) );
+  QgsVectorFileWriter::SaveVectorOptions options;
+  options.driverName = QStringLiteral( "GPKG" );
+  options.layerName = name;
+  QgsVectorFileWriter::writeAsVectorFormatV2( &memoryLayer, path, QgsCoordinateTransformContext(), options );
+
+  return qgis::make_unique<QgsVectorLayer>( path + QStringLiteral( "|layername=" ) + name, name, QStringLiteral( "ogr" ) );
+}
+
+void TestQgsServerFeatureCountCache::addPoint( QgsVectorLayer *layer, double x, double y ) const
+{
+  QgsFeature feature( layer->fields() );
+  feature.setAttribute( QStringLiteral( "name" ), QStringLiteral( "added" ) );
+  feature.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( x, y ) ) );
+  QVERIFY( layer->dataProvider()->addFeature( feature ) );
+}
+
+void TestQgsServerFeatureCountCache::hitAndMiss()
+{
+  QgsServerFeatureCountCache *cache = QgsServerFeatureCountCache::instance();
+  std::unique_ptr<QgsVectorLayer> layer = writeLayer( QStringLiteral( "hit" ), 5 );
+  QVERIFY( layer->isValid() );
+
+  // nothing is cached before the first count
+  long long count = -1;
+  QVERIFY( !cache->cachedFeatureCount( layer.get(), QgsFeatureRequest(), count ) );
+  QCOMPARE( cache->featureCount( layer.get() ), 5LL );
+  QVERIFY( cache->cachedFeatureCount( layer.get(), QgsFeatureRequest(), count ) );
+  QCOMPARE( count, 5LL );
+
+  // the cached count is returned, even if the data changed meanwhile
+  addPoint( layer.get(), 10, 10 );
+  QCOMPARE( cache->featureCount( layer.get() ), 5LL );
+
+  // another layer reading the same data shares the cached count
+  std::unique_ptr<QgsVectorLayer> sameSource = qgis::make_unique<QgsVectorLayer>( layer->source(), QStringLiteral( "same" ), QStringLiteral( "ogr" ) );
+  QVERIFY( cache->cachedFeatureCount( sameSource.get(), QgsFeatureRequest(), count ) );
+  QCOMPARE( count, 5LL );
+
+  // the extent is cached as well
+  QCOMPARE( cache->extent( layer.get() ), QgsRectangle( 0, 0, 4, 4 ) );
+  QCOMPARE( cache->extent( sameSource.get() ), QgsRectangle( 0, 0, 4, 4 ) );
+
+  // a null layer has no features
+  QCOMPARE( cache->featureCount( nullptr ), 0LL );
+  QVERIFY( !cache->cachedFeatureCount( nullptr, QgsFeatureRequest(), count ) );
+
+  // a disabled cache counts each time
+  cache->setTimeToLive( 0 );
+  QCOMPARE( cache->featureCount( layer.get() ), 6LL );
+  QVERIFY( !cache->cachedFeatureCount( layer.get(), QgsFeatureRequest(), count ) );
+}
+
+void TestQgsServerFeatureCountCache::filters()
+{
+  QgsServerFeatureCountCache *cache = QgsServerFeatureCountCache::instance();
+  std::unique_ptr<QgsVectorLayer> layer = writeLayer( QStringLiteral( "filters" ), 5 );
+  QVERIFY( layer->isValid() );
+
+  // the counts of the filters are kept apart
+  const QgsFeatureRequest expressionRequest( QgsExpression( QStringLiteral( "\"name\" IN ('point 1', 'point 2')" ) ) );
+  const QgsFeatureRequest rectRequest( QgsRectangle( 2.5, 2.5, 10, 10 ) );
+  QCOMPARE( cache->featureCount( layer.get(), expressionRequest ), 2LL );
+  QCOMPARE( cache->featureCount( layer.get(), rectRequest ), 2LL );
+  QCOMPARE( cache->featureCount( layer.get() ), 5LL );
+
+  long long count = -1;
+  QVERIFY( !cache->cachedFeatureCount( layer.get(), QgsFeatureRequest( QgsExpression( QStringLiteral( "\"name\" = 'point 1'" ) ) ), count ) );
+
+  // the limit is ignored
+  QgsFeatureRequest limitedRequest( expressionRequest );
+  limitedRequest.setLimit( 1 );
+  QVERIFY( cache->cachedFeatureCount( layer.get(), limitedRequest, count ) );
+  QCOMPARE( count, 2LL );
+
+  // the subset string, e.g. an access control filter, is part of the key
+  QVERIFY( layer->setSubsetString( QStringLiteral( "\"name\" = 'point 1'" ) ) );
+  QVERIFY( !cache->cachedFeatureCount( layer.get(), QgsFeatureRequest(), count ) );
+  QCOMPARE( cache->featureCount( layer.get() ), 1LL );
+  QCOMPARE( cache->featureCount( layer.get(), expressionRequest ), 1LL );
+
+  QVERIFY( layer->setSubsetString( QString() ) );
+  QVERIFY( cache->cachedFeatureCount( layer.get(), QgsFeatureRequest(), count ) );
+  QCOMPARE( count, 5LL );
+}
+
+void TestQgsServerFeatureCountCache::invalidation()
+{
+  QgsServerFeatureCountCache *cache = QgsServerFeatureCountCache::instance();
+  std::unique_ptr<QgsVectorLayer> layer = writeLayer( QStringLiteral( "invalidation" ), 5 );
+  std::unique_ptr<QgsVectorLayer> other = writeLayer( QStringLiteral( "other" ), 3 );
+  QVERIFY( layer->isValid() );
+  QVERIFY( other->isValid() );
+
+  const QgsFeatureRequest rectRequest( QgsRectangle( 2.5, 2.5, 20, 20 ) );
+  const QString subset = QStringLiteral( "\"name\" <> 'point 1'" );
+  QVERIFY( layer->setSubsetString( subset ) );
+  QCOMPARE( cache->featureCount( layer.get() ), 4LL );
+  QVERIFY( layer->setSubsetString( QString() ) );
+  QCOMPARE( cache->featureCount( layer.get() ), 5LL );
+  QCOMPARE( cache->featureCount( layer.get(), rectRequest ), 2LL );
+  QCOMPARE( cache->extent( layer.get() ), QgsRectangle( 0, 0, 4, 4 ) );
+  QCOMPARE( cache->featureCount( other.get() ), 3LL );
+
+  // the layer is changed, e.g. by a WFS-T transaction, which invalidates all the entries of its data source
+  addPoint( layer.get(), 10, 10 );
+  QCOMPARE( cache->featureCount( layer.get() ), 5LL );
+  cache->invalidate( layer.get() );
+
+  long long count = -1;
+  QVERIFY( !cache->cachedFeatureCount( layer.get(), QgsFeatureRequest(), count ) );
+  QVERIFY( !cache->cachedFeatureCount( layer.get(), rectRequest, count ) );
+  QVERIFY( layer->setSubsetString( subset ) );
+  QVERIFY( !cache->cachedFeatureCount( layer.get(), QgsFeatureRequest(), count ) );
+  QCOMPARE( cache->featureCount( layer.get() ), 5LL );
+  QVERIFY( layer->setSubsetString( QString() ) );
+  QCOMPARE( cache->featureCount( layer.get() ), 6LL );
+  QCOMPARE( cache->featureCount( layer.get(), rectRequest ), 3LL );
+  layer->updateExtents();
+  QCOMPARE( cache->extent( layer.get() ), QgsRectangle( 0, 0, 10, 10 ) );
+
+  // the entries of the other data sources are kept
+  QVERIFY( cache->cachedFeatureCount( other.get(), QgsFeatureRequest(), count ) );
+  QCOMPARE( count, 3LL );
+
+  cache->clear();
+  QVERIFY( !cache->cachedFeatureCount( other.get(), QgsFeatureRequest(), count ) );
+}
+
+void TestQgsServerFeatureCountCache::eviction()
+{
+  QgsServerFeatureCountCache *cache = QgsServerFeatureCountCache::instance();
+  std::unique_ptr<QgsVectorLayer> layer = writeLayer( QStringLiteral( "eviction" ), 5 );
+  QVERIFY( layer->isValid() );
+
+  cache->setTimeToLive( 1 );
+  QCOMPARE( cache->timeToLive(), 1 );
+  QCOMPARE( cache->featureCount( layer.get() ), 5LL );
+  addPoint( layer.get(), 10, 10 );
+  long long count = -1;
+  QVERIFY( cache->cachedFeatureCount( layer.get(), QgsFeatureRequest(), count ) );
+
+  // the entries expire after the time to live
+  QThread::msleep( 1100 );
+  QVERIFY( !cache->cachedFeatureCount( layer.get(), QgsFeatureRequest(), count ) );
+  QCOMPARE( cache->featureCount( layer.get() ), 6LL );
+  QVERIFY( cache->cachedFeatureCount( layer.get(), QgsFeatureRequest(), count ) );
+  QCOMPARE( count, 6LL );
+
+  // disabling the cache drops its entries
+  cache->setTimeToLive( 0 );
+  QCOMPARE( cache->timeToLive(), 0 );
+  cache->setTimeToLive( 60 );
+  QVERIFY( !cache->cachedFeatureCount( layer.get(), QgsFeatureRequest(), count ) );
+
+  // a negative time to live disables the cache
+  cache->setTimeToLive( -5 );
+  QCOMPARE( cache->timeToLive(), 0 );
+}
+
+QGSTEST_MAIN( TestQgsServerFeatureCountCache )
+#include "testqgsserverfeaturecountcache.moc"
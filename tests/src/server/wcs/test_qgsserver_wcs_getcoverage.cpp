@@ -0,0 +1,144 @@
+/***************************************************************************
+     test_qgsserver_wcs_getcoverage.cpp
+     ----------------------------------
+    Date                 : October 2020
+    Copyright            : (C) 2020 by the QGIS project
+    Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include "qgsserver.h"
+#include "qgsbufferserverrequest.h"
+#include "qgsbufferserverresponse.h"
+#include "qgsproject.h"
+#include "qgsrasterlayer.h"
+#include "qgsrasterdataprovider.h"
+#include "qgsrasterfilewriter.h"
+#include "qgsrasterpipe.h"
+#include "qgsrasterblock.h"
+
+#include <QTemporaryDir>
+
+//! Size of the requested coverage, larger than the chunks of the response
+const int COVERAGE_SIZE = 1024;
+
+/**
+ * \ingroup UnitTests
+ * This is a unit test for the WCS GetCoverage response
+ */
+class TestQgsServerWcsGetCoverage : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void chunkedResponse();
+    void missingCoverage();
+
+  private:
+    //! Returns the body of the response to a GetCoverage request with \a query, and sets its \a statusCode
+    QByteArray getCoverage( const QString &query, int &statusCode );
+
+    std::unique_ptr<QgsServer> mServer;
+    std::unique_ptr<QgsProject> mProject;
+    QgsRasterLayer *mLayer = nullptr;
+    QTemporaryDir mDir;
+};
+
+void TestQgsServerWcsGetCoverage::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+
+  mServer = qgis::make_unique<QgsServer>();
+
+  // a small float raster, the coverage is requested larger than the raster
+  const QString path = mDir.filePath( QStringLiteral( "dem.tif" ) );
+  const int size = 100;
+  QgsRasterFileWriter writer( path );
+  std::unique_ptr<QgsRasterDataProvider> provider( writer.createOneBandRaster( Qgis::Float32, size, size, QgsRectangle( 0, 0, 1000, 1000 ),
+      QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:32633" ) ) ) );
+  QVERIFY( provider );
+  QgsRasterBlock block( Qgis::Float32, size, size );
+  for ( int row = 0; row < size; ++row )
+    for ( int column = 0; column < size; ++column )
+      block.setValue( row, column, row * size + column );
+  QVERIFY( provider->writeBlock( &block, 1 ) );
+  provider.reset();
+
+  mLayer = new QgsRasterLayer( path, QStringLiteral( "dem" ) );
+  QVERIFY( mLayer->isValid() );
+
+  mProject = qgis::make_unique<QgsProject>();
+  mProject->addMapLayer( mLayer );
+  mProject->writeEntry( QStringLiteral( "WCSLayers" ), QStringLiteral( "/" ), QStringList() << mLayer->id() );
+}
+
+void TestQgsServerWcsGetCoverage::cleanupTestCase()
+{
+  mProject.reset();
+  mServer.reset();
+  QgsApplication::exitQgis();
+}
+
+QByteArray TestQgsServerWcsGetCoverage::getCoverage( const QString &query, int &statusCode )
+{
+  QgsBufferServerRequest request( QStringLiteral( "http://localhost/?SERVICE=WCS&VERSION=1.0.0&REQUEST=GetCoverage&%1" ).arg( query ) );
+  QgsBufferServerResponse response;
+  mServer->handleRequest( request, response, mProject.get() );
+  statusCode = response.statusCode();
+  return response.body();
+}
+
+void TestQgsServerWcsGetCoverage::chunkedResponse()
+{
+  int statusCode = 0;
+  const QByteArray body = getCoverage( QStringLiteral( "COVERAGE=dem&CRS=EPSG:32633&BBOX=0,0,1000,1000&WIDTH=%1&HEIGHT=%1" ).arg( COVERAGE_SIZE ), statusCode );
+  QCOMPARE( statusCode, 200 );
+  // the response is written by several chunks of 1 MB
+  QVERIFY( body.size() > 2 * 1024 * 1024 );
+
+  // the full coverage file, as it was sent at once before
+  const QString path = mDir.filePath( QStringLiteral( "coverage.tif" ) );
+  QgsRasterFileWriter writer( path );
+  QgsRasterPipe pipe;
+  QVERIFY( pipe.set( mLayer->dataProvider()->clone() ) );
+  QCOMPARE( writer.writeRaster( &pipe, COVERAGE_SIZE, COVERAGE_SIZE, QgsRectangle( 0, 0, 1000, 1000 ), mLayer->crs(), mLayer->transformContext() ), QgsRasterFileWriter::NoError );
+  QFile file( path );
+  QVERIFY( file.open( QIODevice::ReadOnly ) );
+  const QByteArray expected = file.readAll();
+
+  QCOMPARE( body.size(), expected.size() );
+  QVERIFY( body == expected );
+
+  // the response is a valid raster
+  const QString responsePath = mDir.filePath( QStringLiteral( "response.tif" ) );
+  QFile responseFile( responsePath );
+  QVERIFY( responseFile.open( QIODevice::WriteOnly ) );
+  responseFile.write( body );
+  responseFile.close();
+  QgsRasterLayer responseLayer( responsePath, QStringLiteral( "response" ) );
+  QVERIFY( responseLayer.isValid() );
+  QCOMPARE( responseLayer.width(), COVERAGE_SIZE );
+  QCOMPARE( responseLayer.height(), COVERAGE_SIZE );
+}
+
+void TestQgsServerWcsGetCoverage::missingCoverage()
+{
+  int statusCode = 0;
+  const QByteArray body = getCoverage( QStringLiteral( "COVERAGE=unknown&CRS=EPSG:32633&BBOX=0,0,1000,1000&WIDTH=10&HEIGHT=10" ), statusCode );
+  QCOMPARE( statusCode, 400 );
+  QVERIFY( body.contains( "unknown" ) );
+}
+
+QGSTEST_MAIN( TestQgsServerWcsGetCoverage )
+#include "test_qgsserver_wcs_getcoverage.moc"
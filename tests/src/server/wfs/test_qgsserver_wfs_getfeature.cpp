@@ -0,0 +1,144 @@
+/***************************************************************************
+     test_qgsserver_wfs_getfeature.cpp
+     ---------------------------------
+    Date                 : October 2020
+    Copyright            : (C) 2020 by the QGIS project
+    Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include "qgsserver.h"
+#include "qgsbufferserverrequest.h"
+#include "qgsbufferserverresponse.h"
+#include "qgsproject.h"
+#include "qgsvectorlayer.h"
+#include "qgsvectordataprovider.h"
+#include "qgsgeometry.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+//! Number of features of the test layer, their GeoJSON is much larger than the flush buffer
+const int FEATURE_COUNT = 3000;
+
+/**
+ * \ingroup UnitTests
+ * This is a unit test for the streaming of WFS GetFeature responses
+ */
+class TestQgsServerWfsGetFeature : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void streamed_before_finish();
+    void buffered_without_callback();
+
+  private:
+    std::unique_ptr<QgsServer> mServer;
+    std::unique_ptr<QgsProject> mProject;
+};
+
+void TestQgsServerWfsGetFeature::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+
+  mServer = qgis::make_unique<QgsServer>();
+
+  QgsVectorLayer *layer = new QgsVectorLayer( QStringLiteral( "Point?crs=epsg:4326&field=id:integer&field=name:string" ),
+      QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer->isValid() );
+
+  QgsFeatureList features;
+  for ( int i = 0; i < FEATURE_COUNT; ++i )
+  {
+    QgsFeature feature( layer->fields() );
+    feature.setAttributes( QgsAttributes() << i << QStringLiteral( "feature %1" ).arg( i ) );
+    feature.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( i % 360 - 180, i % 180 - 90 ) ) );
+    features << feature;
+  }
+  QVERIFY( layer->dataProvider()->addFeatures( features ) );
+
+  mProject = qgis::make_unique<QgsProject>();
+  mProject->addMapLayer( layer );
+  mProject->writeEntry( QStringLiteral( "WFSLayers" ), QStringLiteral( "/" ), QStringList() << layer->id() );
+}
+
+void TestQgsServerWfsGetFeature::cleanupTestCase()
+{
+  mProject.reset();
+  mServer.reset();
+  QgsApplication::exitQgis();
+}
+
+void TestQgsServerWfsGetFeature::streamed_before_finish()
+{
+  QgsBufferServerRequest request( QStringLiteral( "http://localhost/?SERVICE=WFS&VERSION=1.1.0&REQUEST=GetFeature&TYPENAME=points&OUTPUTFORMAT=GeoJSON" ) );
+  QgsBufferServerResponse response;
+
+  QList<QByteArray> chunks;
+  QMap<QString, QString> firstChunkHeaders;
+  response.setFlushCallback( [ &chunks, &firstChunkHeaders, &response ]( const QByteArray & data )
+  {
+    if ( chunks.isEmpty() )
+      firstChunkHeaders = response.headers();
+    chunks << data;
+  } );
+
+  mServer->handleRequest( request, response, mProject.get() );
+
+  QCOMPARE( response.statusCode(), 200 );
+
+  // the output is passed to the callback in several bounded chunks, the
+  // first one before the response is finished, i.e. without Content-Length
+  QVERIFY( chunks.size() > 2 );
+  QVERIFY( !firstChunkHeaders.isEmpty() );
+  QVERIFY( firstChunkHeaders.value( QStringLiteral( "Content-Type" ) ).contains( QLatin1String( "json" ) ) );
+  QVERIFY( !firstChunkHeaders.contains( QStringLiteral( "Content-Length" ) ) );
+  for ( const QByteArray &chunk : qgis::as_const( chunks ) )
+  {
+    QVERIFY( chunk.size() < 2 * 64 * 1024 );
+  }
+
+  // nothing is accumulated in the response
+  QVERIFY( response.body().isEmpty() );
+
+  // the chunks make up the whole document
+  QByteArray content;
+  for ( const QByteArray &chunk : qgis::as_const( chunks ) )
+    content.append( chunk );
+
+  QJsonParseError error;
+  const QJsonDocument document = QJsonDocument::fromJson( content, &error );
+  QCOMPARE( error.error, QJsonParseError::NoError );
+  QCOMPARE( document.object().value( QStringLiteral( "features" ) ).toArray().size(), FEATURE_COUNT );
+}
+
+void TestQgsServerWfsGetFeature::buffered_without_callback()
+{
+  QgsBufferServerRequest request( QStringLiteral( "http://localhost/?SERVICE=WFS&VERSION=1.1.0&REQUEST=GetFeature&TYPENAME=points&OUTPUTFORMAT=GeoJSON" ) );
+  QgsBufferServerResponse response;
+
+  mServer->handleRequest( request, response, mProject.get() );
+
+  QCOMPARE( response.statusCode(), 200 );
+
+  QJsonParseError error;
+  const QJsonDocument document = QJsonDocument::fromJson( response.body(), &error );
+  QCOMPARE( error.error, QJsonParseError::NoError );
+  QCOMPARE( document.object().value( QStringLiteral( "features" ) ).toArray().size(), FEATURE_COUNT );
+}
+
+QGSTEST_MAIN( TestQgsServerWfsGetFeature )
+#include "test_qgsserver_wfs_getfeature.moc"
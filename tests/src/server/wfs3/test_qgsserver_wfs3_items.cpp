@@ -0,0 +1,218 @@
+/***************************************************************************
+     test_qgsserver_wfs3_items.cpp
+     -----------------------------
+    Date                 : October 2020
+    Copyright            : (C) 2020 by the QGIS project
+    Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include "qgsserver.h"
+#include "qgsbufferserverrequest.h"
+#include "qgsbufferserverresponse.h"
+#include "qgsproject.h"
+#include "qgsvectorlayer.h"
+#include "qgsvectordataprovider.h"
+#include "qgsvectorfilewriter.h"
+#include "qgsgeometry.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QUrlQuery>
+
+//! Number of features of the test layer
+const int FEATURE_COUNT = 10;
+
+/**
+ * \ingroup UnitTests
+ * This is a unit test for the keyset paging of the WFS3 items
+ */
+class TestQgsServerWfs3Items : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void single_page();
+    void after_next_link();
+    void after_invalid_combinations();
+
+  private:
+    //! Returns the body of the response to an items request with \a query, and sets its \a statusCode
+    QByteArray itemsResponse( const QString &query, int &statusCode );
+
+    //! Returns the JSON response to a valid items request with \a query
+    QJsonObject items( const QString &query );
+
+    //! Returns the href of the link with \a rel, or an empty string
+    QString link( const QJsonObject &response, const QString &rel ) const;
+
+    //! Returns the ids of the features of the response
+    QList<qlonglong> featureIds( const QJsonObject &response ) const;
+
+    std::unique_ptr<QgsServer> mServer;
+    std::unique_ptr<QgsProject> mProject;
+    QTemporaryDir mDir;
+};
+
+void TestQgsServerWfs3Items::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+
+  mServer = qgis::make_unique<QgsServer>();
+
+  QgsVectorLayer memoryLayer( QStringLiteral( "Point?crs=epsg:4326&field=name:string" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  QVERIFY( memoryLayer.isValid() );
+  QgsFeatureList features;
+  for ( int i = 0; i < FEATURE_COUNT; ++i )
+  {
+    QgsFeature feature( memoryLayer.fields() );
+    feature.setAttributes( QgsAttributes() << QStringLiteral( "feature %1" ).arg( i ) );
+    feature.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( i, i ) ) );
+    features << feature;
+  }
+  QVERIFY( memoryLayer.dataProvider()->addFeatures( features ) );
+
+  // a GeoPackage layer, whose integer primary key allows the keyset paging
+  const QString path = mDir.filePath( QStringLiteral( "points.gpkg" ) );
+  QgsVectorFileWriter::SaveVectorOptions options;
+  options.driverName = QStringLiteral( "GPKG" );
+  options.layerName = QStringLiteral( "points" );
+  QString error;
+  QCOMPARE( QgsVectorFileWriter::writeAsVectorFormatV2( &memoryLayer, path, QgsCoordinateTransformContext(), options, nullptr, nullptr, &error ), QgsVectorFileWriter::NoError );
+
+  QgsVectorLayer *layer = new QgsVectorLayer( path + QStringLiteral( "|layername=points" ), QStringLiteral( "points" ), QStringLiteral( "ogr" ) );
+  QVERIFY( layer->isValid() );
+  QCOMPARE( layer->dataProvider()->pkAttributeIndexes().size(), 1 );
+  QCOMPARE( layer->featureCount(), static_cast<long>( FEATURE_COUNT ) );
+
+  mProject = qgis::make_unique<QgsProject>();
+  mProject->addMapLayer( layer );
+  mProject->writeEntry( QStringLiteral( "WFSLayers" ), QStringLiteral( "/" ), QStringList() << layer->id() );
+}
+
+void TestQgsServerWfs3Items::cleanupTestCase()
+{
+  mProject.reset();
+  mServer.reset();
+  QgsApplication::exitQgis();
+}
+
+QByteArray TestQgsServerWfs3Items::itemsResponse( const QString &query, int &statusCode )
+{
+  QgsBufferServerRequest request( QStringLiteral( "http://localhost/wfs3/collections/points/items.json?%1" ).arg( query ) );
+  QgsBufferServerResponse response;
+  mServer->handleRequest( request, response, mProject.get() );
+  statusCode = response.statusCode();
+  return response.body();
+}
+
+QJsonObject TestQgsServerWfs3Items::items( const QString &query )
+{
+  int statusCode = 0;
+  const QByteArray body = itemsResponse( query, statusCode );
+  if ( statusCode != 200 )
+    return QJsonObject();
+  return QJsonDocument::fromJson( body ).object();
+}
+
+QString TestQgsServerWfs3Items::link( const QJsonObject &response, const QString &rel ) const
+{
+  const QJsonArray links = response.value( QStringLiteral( "links" ) ).toArray();
+  for ( const QJsonValue &l : links )
+  {
+    if ( l.toObject().value( QStringLiteral( "rel" ) ).toString() == rel )
+      return l.toObject().value( QStringLiteral( "href" ) ).toString();
+  }
+  return QString();
+}
+
+QList<qlonglong> TestQgsServerWfs3Items::featureIds( const QJsonObject &response ) const
+{
+  QList<qlonglong> ids;
+  const QJsonArray features = response.value( QStringLiteral( "features" ) ).toArray();
+  for ( const QJsonValue &f : features )
+    ids << f.toObject().value( QStringLiteral( "id" ) ).toVariant().toLongLong();
+  return ids;
+}
+
+void TestQgsServerWfs3Items::single_page()
+{
+  // all the features fit in the page, there is no next link
+  const QJsonObject response = items( QStringLiteral( "limit=20" ) );
+  QCOMPARE( response.value( QStringLiteral( "numberReturned" ) ).toInt(), FEATURE_COUNT );
+  QCOMPARE( response.value( QStringLiteral( "numberMatched" ) ).toInt(), FEATURE_COUNT );
+  QVERIFY( link( response, QStringLiteral( "next" ) ).isEmpty() );
+
+  // the offset pages still work for layers with a primary key
+  const QJsonObject lastPage = items( QStringLiteral( "offset=8&limit=4" ) );
+  QCOMPARE( lastPage.value( QStringLiteral( "numberReturned" ) ).toInt(), 2 );
+  QVERIFY( link( lastPage, QStringLiteral( "next" ) ).isEmpty() );
+  QVERIFY( !link( lastPage, QStringLiteral( "prev" ) ).isEmpty() );
+}
+
+void TestQgsServerWfs3Items::after_next_link()
+{
+  // the first page has a keyset next link
+  QJsonObject response = items( QStringLiteral( "limit=4" ) );
+  QCOMPARE( featureIds( response ), QList<qlonglong>() << 1 << 2 << 3 << 4 );
+  QCOMPARE( response.value( QStringLiteral( "numberMatched" ) ).toInt(), FEATURE_COUNT );
+  QString next = link( response, QStringLiteral( "next" ) );
+  QVERIFY( !next.isEmpty() );
+  QUrlQuery nextQuery( QUrl( next ).query() );
+  QCOMPARE( nextQuery.queryItemValue( QStringLiteral( "after" ) ), QStringLiteral( "4" ) );
+  QCOMPARE( nextQuery.queryItemValue( QStringLiteral( "limit" ) ), QStringLiteral( "4" ) );
+  QVERIFY( !nextQuery.hasQueryItem( QStringLiteral( "offset" ) ) );
+
+  // the pages which follow the next links
+  response = items( nextQuery.toString() );
+  QCOMPARE( featureIds( response ), QList<qlonglong>() << 5 << 6 << 7 << 8 );
+  // the number of matched features is the one of the whole collection, whatever the page
+  QCOMPARE( response.value( QStringLiteral( "numberMatched" ) ).toInt(), FEATURE_COUNT );
+  QCOMPARE( response.value( QStringLiteral( "numberReturned" ) ).toInt(), 4 );
+  next = link( response, QStringLiteral( "next" ) );
+  nextQuery = QUrlQuery( QUrl( next ).query() );
+  QCOMPARE( nextQuery.queryItemValue( QStringLiteral( "after" ) ), QStringLiteral( "8" ) );
+
+  response = items( nextQuery.toString() );
+  QCOMPARE( featureIds( response ), QList<qlonglong>() << 9 << 10 );
+  QCOMPARE( response.value( QStringLiteral( "numberMatched" ) ).toInt(), FEATURE_COUNT );
+  QCOMPARE( response.value( QStringLiteral( "numberReturned" ) ).toInt(), 2 );
+  QVERIFY( link( response, QStringLiteral( "next" ) ).isEmpty() );
+
+  // after the last feature
+  response = items( QStringLiteral( "after=10&limit=4" ) );
+  QVERIFY( featureIds( response ).isEmpty() );
+  QVERIFY( link( response, QStringLiteral( "next" ) ).isEmpty() );
+}
+
+void TestQgsServerWfs3Items::after_invalid_combinations()
+{
+  int statusCode = 0;
+  QByteArray body = itemsResponse( QStringLiteral( "after=4&offset=2&limit=4" ), statusCode );
+  QCOMPARE( statusCode, 400 );
+  QVERIFY( body.contains( "'after' and 'offset'" ) );
+
+  body = itemsResponse( QStringLiteral( "after=4&sortby=name&limit=4" ), statusCode );
+  QCOMPARE( statusCode, 400 );
+  QVERIFY( body.contains( "'after' and 'sortby'" ) );
+
+  // a valid request
+  itemsResponse( QStringLiteral( "after=4&limit=4" ), statusCode );
+  QCOMPARE( statusCode, 200 );
+}
+
+QGSTEST_MAIN( TestQgsServerWfs3Items )
+#include "test_qgsserver_wfs3_items.moc"
@@ -14,11 +14,18 @@
  ***************************************************************************/
 
 #include "qgstest.h"
+#include "qgsfillsymbollayer.h"
+#include "qgsmaplayerstylemanager.h"
+#include "qgssinglesymbolrenderer.h"
+#include "qgssymbol.h"
 #include "qgsvectorlayer.h"
 
+#include "qgswmsrenderer.h"
 #include "qgswmsrestorer.h"
 #include "qgsserverinterfaceimpl.h"
 
+#include <thread>
+
 /**
  * \ingroup UnitTests
  * This is a unit test for the WMS restorer class
@@ -32,6 +39,8 @@ class TestQgsServerWmsRestorer : public QObject
     void cleanupTestCase();
 
     void restorer_layer();
+    void restorer_shared();
+    void concurrent_getmap();
 };
 
 void TestQgsServerWmsRestorer::initTestCase()
@@ -82,7 +91,7 @@ void TestQgsServerWmsRestorer::restorer_layer()
   {
     // destructor is called once out of scope
     std::unique_ptr<QgsWms::QgsWmsRestorer> restorer;
-    restorer.reset( new QgsWms::QgsWmsRestorer( context ) );
+    restorer.reset( new QgsWms::QgsWmsRestorer( context, true ) );
 
     const QString new_name = "new_name";
     vl->setName( new_name );
@@ -97,5 +106,143 @@ void TestQgsServerWmsRestorer::restorer_layer()
   QCOMPARE( vl->opacity(), opacity );
 }
 
+void TestQgsServerWmsRestorer::restorer_shared()
+{
+  QgsProject project;
+  QgsVectorLayer *vl = new QgsVectorLayer( QStringLiteral( "Polygon?crs=epsg:3857&field=name:string" ), QStringLiteral( "polygons" ), QStringLiteral( "memory" ) );
+  project.addMapLayer( vl );
+
+  QgsCapabilitiesCache cache;
+  QgsServiceRegistry registry;
+  QgsServerSettings settings;
+  QgsServerInterfaceImpl interface( &cache, &registry, &settings );
+
+  QUrlQuery query;
+  query.addQueryItem( QStringLiteral( "LAYERS" ), QStringLiteral( "polygons" ) );
+
+  QgsWms::QgsWmsRenderContext context( &project, &interface );
+  context.setFlag( QgsWms::QgsWmsRenderContext::UseOpacity );
+  context.setParameters( QgsWms::QgsWmsParameters( query ) );
+
+  // the request only reads the layers, which are left untouched
+  QVERIFY( !context.changesLayers() );
+  {
+    QgsWms::QgsWmsRestorer restorer( context );
+    vl->setOpacity( 0.5 );
+  }
+  QCOMPARE( vl->opacity(), 0.5 );
+  vl->setOpacity( 1 );
+
+  // the current style does not change the layer
+  query.addQueryItem( QStringLiteral( "STYLES" ), vl->styleManager()->currentStyle() );
+  context.setParameters( QgsWms::QgsWmsParameters( query ) );
+  QVERIFY( !context.changesLayers() );
+
+  // opacities are only applied by the requests using them
+  query.addQueryItem( QStringLiteral( "OPACITIES" ), QStringLiteral( "100" ) );
+  context.setParameters( QgsWms::QgsWmsParameters( query ) );
+  QVERIFY( context.changesLayers() );
+
+  QgsWms::QgsWmsRenderContext noOpacityContext( &project, &interface );
+  noOpacityContext.setParameters( QgsWms::QgsWmsParameters( query ) );
+  QVERIFY( !noOpacityContext.changesLayers() );
+}
+
+void TestQgsServerWmsRestorer::concurrent_getmap()
+{
+  QgsProject project;
+  QgsVectorLayer *vl = new QgsVectorLayer( QStringLiteral( "Polygon?crs=epsg:3857&field=name:string" ), QStringLiteral( "polygons" ), QStringLiteral( "memory" ) );
+  QgsFeature a( vl->fields() );
+  a.setAttributes( QgsAttributes() << QStringLiteral( "a" ) );
+  a.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "Polygon ((0 0, 10 0, 10 10, 0 10, 0 0))" ) ) );
+  QgsFeature b( vl->fields() );
+  b.setAttributes( QgsAttributes() << QStringLiteral( "b" ) );
+  b.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "Polygon ((10 0, 20 0, 20 10, 10 10, 10 0))" ) ) );
+  QgsFeatureList features { a, b };
+  QVERIFY( vl->dataProvider()->addFeatures( features ) );
+
+  // the current style is blue, the red one is only used by the requests asking for it
+  vl->setRenderer( new QgsSingleSymbolRenderer( QgsFillSymbol::createSimple( { { QStringLiteral( "color" ), QStringLiteral( "255,0,0" ) }, { QStringLiteral( "outline_style" ), QStringLiteral( "no" ) } } ) ) );
+  QVERIFY( vl->styleManager()->addStyleFromLayer( QStringLiteral( "red" ) ) );
+  vl->setRenderer( new QgsSingleSymbolRenderer( QgsFillSymbol::createSimple( { { QStringLiteral( "color" ), QStringLiteral( "0,0,255" ) }, { QStringLiteral( "outline_style" ), QStringLiteral( "no" ) } } ) ) );
+  project.addMapLayer( vl );
+  const QString defaultStyle = vl->styleManager()->currentStyle();
+
+  QgsCapabilitiesCache cache;
+  QgsServiceRegistry registry;
+  QgsServerSettings settings;
+  QgsServerInterfaceImpl interface( &cache, &registry, &settings );
+
+  const QList< QPair< QString, QString > > variants
+  {
+    { QString(), QString() },
+    { QStringLiteral( "STYLES" ), QStringLiteral( "red" ) },
+    { QStringLiteral( "OPACITIES" ), QStringLiteral( "100" ) },
+    { QStringLiteral( "FILTER" ), QStringLiteral( "polygons:\"name\" = 'a'" ) },
+    { QStringLiteral( "SELECTION" ), QStringLiteral( "polygons:%1" ).arg( features.at( 1 ).id() ) },
+  };
+
+  auto getMap = [&]( int variant ) -> QImage
+  {
+    QUrlQuery query;
+    query.addQueryItem( QStringLiteral( "SERVICE" ), QStringLiteral( "WMS" ) );
+    query.addQueryItem( QStringLiteral( "REQUEST" ), QStringLiteral( "GetMap" ) );
+    query.addQueryItem( QStringLiteral( "VERSION" ), QStringLiteral( "1.3.0" ) );
+    query.addQueryItem( QStringLiteral( "LAYERS" ), QStringLiteral( "polygons" ) );
+    query.addQueryItem( QStringLiteral( "CRS" ), QStringLiteral( "EPSG:3857" ) );
+    query.addQueryItem( QStringLiteral( "BBOX" ), QStringLiteral( "0,0,20,10" ) );
+    query.addQueryItem( QStringLiteral( "WIDTH" ), QStringLiteral( "40" ) );
+    query.addQueryItem( QStringLiteral( "HEIGHT" ), QStringLiteral( "20" ) );
+    query.addQueryItem( QStringLiteral( "FORMAT" ), QStringLiteral( "image/png" ) );
+    if ( !variants.at( variant ).first.isEmpty() )
+      query.addQueryItem( variants.at( variant ).first, variants.at( variant ).second );
+
+    QgsWms::QgsWmsRenderContext context( &project, &interface );
+    context.setFlag( QgsWms::QgsWmsRenderContext::UpdateExtent );
+    context.setFlag( QgsWms::QgsWmsRenderContext::UseOpacity );
+    context.setFlag( QgsWms::QgsWmsRenderContext::UseFilter );
+    context.setFlag( QgsWms::QgsWmsRenderContext::UseSelection );
+    context.setParameters( QgsWms::QgsWmsParameters( query ) );
+
+    QgsWms::QgsRenderer renderer( context );
+    std::unique_ptr<QImage> image( renderer.getMap() );
+    return image ? *image : QImage();
+  };
+
+  // reference images, rendered one after the other
+  QList< QImage > expected;
+  for ( int i = 0; i < variants.size(); ++i )
+  {
+    expected << getMap( i );
+    QVERIFY( !expected.last().isNull() );
+    if ( i > 0 )
+      QVERIFY( expected.last() != expected.first() );
+  }
+
+  // each request renders the same image when the requests are handled concurrently
+  const int requestCount = 10 * variants.size();
+  std::vector< QImage > images( requestCount );
+  std::vector< std::thread > workers;
+  for ( int worker = 0; worker < 4; ++worker )
+  {
+    workers.emplace_back( [&, worker]
+    {
+      for ( int i = worker; i < requestCount; i += 4 )
+        images[ static_cast< size_t >( i ) ] = getMap( i % variants.size() );
+    } );
+  }
+  for ( std::thread &worker : workers )
+    worker.join();
+
+  for ( int i = 0; i < requestCount; ++i )
+    QCOMPARE( images.at( static_cast< size_t >( i ) ), expected.at( i % variants.size() ) );
+
+  // the shared layer is restored
+  QCOMPARE( vl->styleManager()->currentStyle(), defaultStyle );
+  QCOMPARE( vl->opacity(), 1.0 );
+  QVERIFY( vl->subsetString().isEmpty() );
+  QVERIFY( vl->selectedFeatureIds().isEmpty() );
+}
+
 QGSTEST_MAIN( TestQgsServerWmsRestorer )
 #include "test_qgsserver_wms_restorer.moc"
@@ -0,0 +1,241 @@
+/***************************************************************************
+     test_qgsserver_wmts_metatile.cpp
+     --------------------------------
+    Date                 : October 2020
+    Copyright            : (C) 2020 by the QGIS project
+    Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include "qgsproject.h"
+#include "qgswmtsutils.h"
+
+#include <QImage>
+#include <QPainter>
+
+/**
+ * \ingroup UnitTests
+ * This is a unit test for the WMTS metatiles
+ */
+class TestQgsServerWmtsMetatile : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void metatile_query();
+    void metatile_clamped();
+    void split_png();
+    void split_jpeg();
+    void split_invalid_size();
+
+  private:
+    QgsWmts::QgsWmtsParameters tileParameters( const QString &format, int tileRow, int tileCol ) const;
+    QImage metatileImage( int rowCount, int colCount, int buffer, QImage::Format format ) const;
+    QColor tileColor( int row, int col ) const;
+};
+
+void TestQgsServerWmtsMetatile::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+
+  // a project publishing its root layer in WMTS with 4 levels of the EPSG:3857 grid
+  QgsProject *project = QgsProject::instance();
+  project->setTitle( QStringLiteral( "root" ) );
+  project->writeEntry( QStringLiteral( "WMTSLayers" ), QStringLiteral( "Project" ), true );
+  project->writeEntry( QStringLiteral( "WMTSGrids" ), QStringLiteral( "CRS" ), QStringList() << QStringLiteral( "EPSG:3857" ) );
+  project->writeEntry( QStringLiteral( "WMTSGrids" ), QStringLiteral( "Config" ), QStringList() << QStringLiteral( "EPSG:3857,0,0,0,3" ) );
+}
+
+void TestQgsServerWmtsMetatile::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+QgsWmts::QgsWmtsParameters TestQgsServerWmtsMetatile::tileParameters( const QString &format, int tileRow, int tileCol ) const
+{
+  QUrlQuery query;
+  query.addQueryItem( QStringLiteral( "SERVICE" ), QStringLiteral( "WMTS" ) );
+  query.addQueryItem( QStringLiteral( "REQUEST" ), QStringLiteral( "GetTile" ) );
+  query.addQueryItem( QStringLiteral( "LAYER" ), QStringLiteral( "root" ) );
+  query.addQueryItem( QStringLiteral( "FORMAT" ), format );
+  query.addQueryItem( QStringLiteral( "TILEMATRIXSET" ), QStringLiteral( "EPSG:3857" ) );
+  query.addQueryItem( QStringLiteral( "TILEMATRIX" ), QStringLiteral( "3" ) );
+  query.addQueryItem( QStringLiteral( "TILEROW" ), QString::number( tileRow ) );
+  query.addQueryItem( QStringLiteral( "TILECOL" ), QString::number( tileCol ) );
+
+  const QgsServerParameters parameters( query );
+  return QgsWmts::QgsWmtsParameters( parameters );
+}
+
+QColor TestQgsServerWmtsMetatile::tileColor( int row, int col ) const
+{
+  return QColor( 40 + 60 * row, 40 + 60 * col, 200 );
+}
+
+QImage TestQgsServerWmtsMetatile::metatileImage( int rowCount, int colCount, int buffer, QImage::Format format ) const
+{
+  // each tile has its own color, the margin around the metatile is red
+  QImage image( colCount * 256 + 2 * buffer, rowCount * 256 + 2 * buffer, format );
+  image.fill( Qt::red );
+  QPainter painter( &image );
+  for ( int row = 0; row < rowCount; ++row )
+  {
+    for ( int col = 0; col < colCount; ++col )
+    {
+      painter.fillRect( buffer + col * 256, buffer + row * 256, 256, 256, tileColor( row, col ) );
+    }
+  }
+  painter.end();
+  return image;
+}
+
+void TestQgsServerWmtsMetatile::metatile_query()
+{
+  const QgsWmts::QgsWmtsParameters params = tileParameters( QStringLiteral( "image/jpeg" ), 5, 6 );
+  const QgsWmts::metatileDef metatile = QgsWmts::translateWmtsParamToWmsMetatile( params, 4, 16, QgsProject::instance(), nullptr );
+
+  // the metatile is aligned on the tile matrix
+  QCOMPARE( metatile.minRow, 4 );
+  QCOMPARE( metatile.minCol, 4 );
+  QCOMPARE( metatile.rowCount, 4 );
+  QCOMPARE( metatile.colCount, 4 );
+  QCOMPARE( metatile.buffer, 16 );
+
+  // the image includes the margin
+  QCOMPARE( metatile.query.queryItemValue( QStringLiteral( "WIDTH" ) ), QStringLiteral( "1056" ) );
+  QCOMPARE( metatile.query.queryItemValue( QStringLiteral( "HEIGHT" ) ), QStringLiteral( "1056" ) );
+
+  // the metatile of JPEG tiles is rendered as an opaque lossless image
+  QCOMPARE( metatile.query.queryItemValue( QStringLiteral( "FORMAT" ) ), QStringLiteral( "image/png" ) );
+  QVERIFY( !metatile.query.hasQueryItem( QStringLiteral( "TRANSPARENT" ) ) );
+
+  // the extent covers the south east quarter of the grid and the margin
+  const double extent = 20037508.3427892480;
+  const double res = 2 * extent / ( 8 * 256 );
+  const QStringList bbox = metatile.query.queryItemValue( QStringLiteral( "BBOX" ) ).split( ',' );
+  QCOMPARE( bbox.size(), 4 );
+  QGSCOMPARENEAR( bbox.at( 0 ).toDouble(), -16 * res, 1 );
+  QGSCOMPARENEAR( bbox.at( 1 ).toDouble(), -extent - 16 * res, 1 );
+  QGSCOMPARENEAR( bbox.at( 2 ).toDouble(), extent + 16 * res, 1 );
+  QGSCOMPARENEAR( bbox.at( 3 ).toDouble(), 16 * res, 1 );
+
+  // PNG tiles keep their transparency
+  const QgsWmts::metatileDef pngMetatile = QgsWmts::translateWmtsParamToWmsMetatile( tileParameters( QStringLiteral( "image/png" ), 5, 6 ), 4, 16, QgsProject::instance(), nullptr );
+  QCOMPARE( pngMetatile.query.queryItemValue( QStringLiteral( "FORMAT" ) ), QStringLiteral( "image/png" ) );
+  QCOMPARE( pngMetatile.query.queryItemValue( QStringLiteral( "TRANSPARENT" ) ), QStringLiteral( "true" ) );
+}
+
+void TestQgsServerWmtsMetatile::metatile_clamped()
+{
+  // the last rows and columns of the tile matrix do not fill a whole metatile
+  const QgsWmts::QgsWmtsParameters params = tileParameters( QStringLiteral( "image/png" ), 7, 6 );
+  const QgsWmts::metatileDef metatile = QgsWmts::translateWmtsParamToWmsMetatile( params, 3, 0, QgsProject::instance(), nullptr );
+
+  QCOMPARE( metatile.minRow, 6 );
+  QCOMPARE( metatile.minCol, 6 );
+  QCOMPARE( metatile.rowCount, 2 );
+  QCOMPARE( metatile.colCount, 2 );
+  QCOMPARE( metatile.query.queryItemValue( QStringLiteral( "WIDTH" ) ), QStringLiteral( "512" ) );
+  QCOMPARE( metatile.query.queryItemValue( QStringLiteral( "HEIGHT" ) ), QStringLiteral( "512" ) );
+
+  // a negative buffer is ignored
+  const QgsWmts::metatileDef noBuffer = QgsWmts::translateWmtsParamToWmsMetatile( params, 3, -10, QgsProject::instance(), nullptr );
+  QCOMPARE( noBuffer.buffer, 0 );
+  QCOMPARE( noBuffer.query.queryItemValue( QStringLiteral( "WIDTH" ) ), QStringLiteral( "512" ) );
+}
+
+void TestQgsServerWmtsMetatile::split_png()
+{
+  QgsWmts::metatileDef metatile;
+  metatile.rowCount = 2;
+  metatile.colCount = 3;
+  metatile.buffer = 32;
+
+  const QImage image = metatileImage( 2, 3, 32, QImage::Format_ARGB32_Premultiplied );
+  const QList< QByteArray > tiles = QgsWmts::splitMetatile( image, metatile, QgsWmts::QgsWmtsParameters::Format::PNG, -1, 9 );
+  QCOMPARE( tiles.size(), 6 );
+
+  for ( int row = 0; row < 2; ++row )
+  {
+    for ( int col = 0; col < 3; ++col )
+    {
+      const QByteArray &content = tiles.at( row * 3 + col );
+      QVERIFY( content.startsWith( "\x89PNG" ) );
+
+      QImage tile;
+      QVERIFY( tile.loadFromData( content ) );
+      QCOMPARE( tile.size(), QSize( 256, 256 ) );
+
+      // the tile is not shifted by the margin and has no pixel of the margin
+      const QRgb expected = tileColor( row, col ).rgb();
+      QCOMPARE( tile.pixel( 0, 0 ), expected );
+      QCOMPARE( tile.pixel( 255, 0 ), expected );
+      QCOMPARE( tile.pixel( 0, 255 ), expected );
+      QCOMPARE( tile.pixel( 255, 255 ), expected );
+    }
+  }
+}
+
+void TestQgsServerWmtsMetatile::split_jpeg()
+{
+  QgsWmts::metatileDef metatile;
+  metatile.rowCount = 2;
+  metatile.colCount = 2;
+  metatile.buffer = 8;
+
+  const QImage image = metatileImage( 2, 2, 8, QImage::Format_RGB32 );
+  const QList< QByteArray > tiles = QgsWmts::splitMetatile( image, metatile, QgsWmts::QgsWmtsParameters::Format::JPG, 90 );
+  QCOMPARE( tiles.size(), 4 );
+
+  for ( int row = 0; row < 2; ++row )
+  {
+    for ( int col = 0; col < 2; ++col )
+    {
+      const QByteArray &content = tiles.at( row * 2 + col );
+      QVERIFY( content.startsWith( "\xFF\xD8" ) );
+
+      QImage tile;
+      QVERIFY( tile.loadFromData( content ) );
+      QCOMPARE( tile.size(), QSize( 256, 256 ) );
+      QVERIFY( !tile.hasAlphaChannel() );
+
+      // encoded once, the colors are close to the rendered ones
+      const QColor expected = tileColor( row, col );
+      const QColor corner = tile.pixelColor( 0, 0 );
+      QVERIFY( std::abs( corner.red() - expected.red() ) <= 8 );
+      QVERIFY( std::abs( corner.green() - expected.green() ) <= 8 );
+      QVERIFY( std::abs( corner.blue() - expected.blue() ) <= 8 );
+    }
+  }
+
+  // higher quality gives larger tiles
+  const QList< QByteArray > lowQualityTiles = QgsWmts::splitMetatile( image, metatile, QgsWmts::QgsWmtsParameters::Format::JPG, 10 );
+  QCOMPARE( lowQualityTiles.size(), 4 );
+  QVERIFY( lowQualityTiles.at( 0 ).size() < tiles.at( 0 ).size() );
+}
+
+void TestQgsServerWmtsMetatile::split_invalid_size()
+{
+  QgsWmts::metatileDef metatile;
+  metatile.rowCount = 2;
+  metatile.colCount = 2;
+  metatile.buffer = 8;
+
+  // e.g. the WMS request failed or the image does not include the margin
+  QVERIFY( QgsWmts::splitMetatile( QImage(), metatile, QgsWmts::QgsWmtsParameters::Format::PNG ).isEmpty() );
+  QVERIFY( QgsWmts::splitMetatile( metatileImage( 2, 2, 0, QImage::Format_RGB32 ), metatile, QgsWmts::QgsWmtsParameters::Format::PNG ).isEmpty() );
+}
+
+QGSTEST_MAIN( TestQgsServerWmtsMetatile )
+#include "test_qgsserver_wmts_metatile.moc"
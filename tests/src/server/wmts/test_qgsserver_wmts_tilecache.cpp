@@ -0,0 +1,250 @@
+/***************************************************************************
+     test_qgsserver_wmts_tilecache.cpp
+     ---------------------------------
+    Date                 : October 2020
+    Copyright            : (C) 2020 by the QGIS project
+    Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include "qgsproject.h"
+#include "qgsconfigcache.h"
+#include "qgsserverinterfaceimpl.h"
+#include "qgsserversettings.h"
+#include "qgsserviceregistry.h"
+#include "qgswmtsparameters.h"
+#include "qgswmtstilecache.h"
+
+#include <QDirIterator>
+#include <QTemporaryDir>
+
+/**
+ * \ingroup UnitTests
+ * This is a unit test for the WMTS tile cache
+ */
+class TestQgsServerWmtsTileCache : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void disabled();
+    void hit_miss();
+    void eviction_by_size();
+    void invalidation_project_removed();
+    void invalidation_project_modified();
+
+  private:
+    QgsWmts::QgsWmtsParameters tileParameters( int tileRow, int tileCol ) const;
+    QUrlQuery wmsQuery( const QString &styles = QString() ) const;
+    qint64 tilesSize( const QString &directory ) const;
+
+    std::unique_ptr<QTemporaryDir> mTempDir;
+    std::unique_ptr<QgsProject> mProject;
+
+    std::unique_ptr<QgsCapabilitiesCache> mCapabilitiesCache;
+    std::unique_ptr<QgsServiceRegistry> mRegistry;
+    std::unique_ptr<QgsServerSettings> mSettings;
+    std::unique_ptr<QgsServerInterfaceImpl> mInterface;
+};
+
+void TestQgsServerWmtsTileCache::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+
+  mTempDir = qgis::make_unique<QTemporaryDir>();
+  QVERIFY( mTempDir->isValid() );
+
+  // the tiles are stored by project file
+  mProject = qgis::make_unique<QgsProject>();
+  QVERIFY( mProject->write( mTempDir->filePath( QStringLiteral( "project.qgs" ) ) ) );
+
+  // the tile cache of the server settings is connected to the config cache
+  qputenv( "QGIS_SERVER_WMTS_TILE_CACHE_DIRECTORY", mTempDir->filePath( QStringLiteral( "server_tiles" ) ).toUtf8() );
+  mCapabilitiesCache = qgis::make_unique<QgsCapabilitiesCache>();
+  mRegistry = qgis::make_unique<QgsServiceRegistry>();
+  mSettings = qgis::make_unique<QgsServerSettings>();
+  mSettings->load();
+  mInterface = qgis::make_unique<QgsServerInterfaceImpl>( mCapabilitiesCache.get(), mRegistry.get(), mSettings.get() );
+}
+
+void TestQgsServerWmtsTileCache::cleanupTestCase()
+{
+  mInterface.reset();
+  mSettings.reset();
+  mRegistry.reset();
+  mCapabilitiesCache.reset();
+  mProject.reset();
+  mTempDir.reset();
+  QgsApplication::exitQgis();
+}
+
+QgsWmts::QgsWmtsParameters TestQgsServerWmtsTileCache::tileParameters( int tileRow, int tileCol ) const
+{
+  QUrlQuery query;
+  query.addQueryItem( QStringLiteral( "SERVICE" ), QStringLiteral( "WMTS" ) );
+  query.addQueryItem( QStringLiteral( "REQUEST" ), QStringLiteral( "GetTile" ) );
+  query.addQueryItem( QStringLiteral( "LAYER" ), QStringLiteral( "root" ) );
+  query.addQueryItem( QStringLiteral( "FORMAT" ), QStringLiteral( "image/png" ) );
+  query.addQueryItem( QStringLiteral( "TILEMATRIXSET" ), QStringLiteral( "EPSG:3857" ) );
+  query.addQueryItem( QStringLiteral( "TILEMATRIX" ), QStringLiteral( "3" ) );
+  query.addQueryItem( QStringLiteral( "TILEROW" ), QString::number( tileRow ) );
+  query.addQueryItem( QStringLiteral( "TILECOL" ), QString::number( tileCol ) );
+
+  const QgsServerParameters parameters( query );
+  return QgsWmts::QgsWmtsParameters( parameters );
+}
+
+QUrlQuery TestQgsServerWmtsTileCache::wmsQuery( const QString &styles ) const
+{
+  QUrlQuery query;
+  query.addQueryItem( QStringLiteral( "SERVICE" ), QStringLiteral( "WMS" ) );
+  query.addQueryItem( QStringLiteral( "REQUEST" ), QStringLiteral( "GetMap" ) );
+  query.addQueryItem( QStringLiteral( "LAYERS" ), QStringLiteral( "root" ) );
+  query.addQueryItem( QStringLiteral( "STYLES" ), styles );
+  query.addQueryItem( QStringLiteral( "BBOX" ), QStringLiteral( "0,0,1,1" ) );
+  return query;
+}
+
+qint64 TestQgsServerWmtsTileCache::tilesSize( const QString &directory ) const
+{
+  qint64 size = 0;
+  QDirIterator it( directory, QStringList() << QStringLiteral( "*.png" ), QDir::Files, QDirIterator::Subdirectories );
+  while ( it.hasNext() )
+  {
+    it.next();
+    size += it.fileInfo().size();
+  }
+  return size;
+}
+
+void TestQgsServerWmtsTileCache::disabled()
+{
+  const QgsWmts::QgsWmtsTileCache cache( QString(), 0 );
+  QVERIFY( !cache.isEnabled() );
+
+  const QgsWmts::QgsWmtsParameters params = tileParameters( 1, 2 );
+  QVERIFY( !cache.setTile( mProject.get(), params, wmsQuery(), QByteArray( "tile" ) ) );
+  QVERIFY( cache.tile( mProject.get(), params, wmsQuery() ).isEmpty() );
+}
+
+void TestQgsServerWmtsTileCache::hit_miss()
+{
+  const QgsWmts::QgsWmtsTileCache cache( mTempDir->filePath( QStringLiteral( "hit_miss" ) ) );
+  QVERIFY( cache.isEnabled() );
+  QCOMPARE( cache.maxSize(), qint64( 0 ) );
+
+  const QgsWmts::QgsWmtsParameters params = tileParameters( 1, 2 );
+
+  // miss
+  QVERIFY( cache.tile( mProject.get(), params, wmsQuery() ).isEmpty() );
+
+  // hit
+  QVERIFY( cache.setTile( mProject.get(), params, wmsQuery(), QByteArray( "tile 1 2" ) ) );
+  QCOMPARE( cache.tile( mProject.get(), params, wmsQuery() ), QByteArray( "tile 1 2" ) );
+
+  // the tile extent does not identify the tile
+  QUrlQuery otherBbox = wmsQuery();
+  otherBbox.removeAllQueryItems( QStringLiteral( "BBOX" ) );
+  otherBbox.addQueryItem( QStringLiteral( "BBOX" ), QStringLiteral( "2,2,3,3" ) );
+  QCOMPARE( cache.tile( mProject.get(), params, otherBbox ), QByteArray( "tile 1 2" ) );
+
+  // other tiles, styles and extra keys miss
+  QVERIFY( cache.tile( mProject.get(), tileParameters( 2, 1 ), wmsQuery() ).isEmpty() );
+  QVERIFY( cache.tile( mProject.get(), params, wmsQuery( QStringLiteral( "red" ) ) ).isEmpty() );
+  QVERIFY( cache.tile( mProject.get(), params, wmsQuery(), QStringList() << QStringLiteral( "user" ) ).isEmpty() );
+
+  // a sibling tile, e.g. cut from a metatile
+  QVERIFY( cache.setTile( mProject.get(), params, 2, 1, wmsQuery(), QByteArray( "tile 2 1" ) ) );
+  QCOMPARE( cache.tile( mProject.get(), tileParameters( 2, 1 ), wmsQuery() ), QByteArray( "tile 2 1" ) );
+
+  // a tile is replaced
+  QVERIFY( cache.setTile( mProject.get(), params, wmsQuery(), QByteArray( "new tile 1 2" ) ) );
+  QCOMPARE( cache.tile( mProject.get(), params, wmsQuery() ), QByteArray( "new tile 1 2" ) );
+
+  // empty tiles are not stored
+  QVERIFY( !cache.setTile( mProject.get(), tileParameters( 3, 3 ), wmsQuery(), QByteArray() ) );
+}
+
+void TestQgsServerWmtsTileCache::eviction_by_size()
+{
+  const QString directory = mTempDir->filePath( QStringLiteral( "eviction" ) );
+  const QgsWmts::QgsWmtsTileCache cache( directory, 5000 );
+  QCOMPARE( cache.maxSize(), qint64( 5000 ) );
+
+  const QByteArray content( 1000, 'x' );
+  for ( int col = 0; col < 10; ++col )
+  {
+    QVERIFY( cache.setTile( mProject.get(), tileParameters( 0, col ), wmsQuery(), content ) );
+    QVERIFY( tilesSize( directory ) <= 5000 );
+    // the tiles are evicted by modification time
+    QTest::qSleep( 20 );
+  }
+
+  // once full, the cache is trimmed to 90% of its size, the oldest tiles first:
+  // the 6th tile leaves 4 tiles (2-5), the 8th 4 tiles (4-7) and the 10th 4 tiles (6-9)
+  QCOMPARE( tilesSize( directory ), 4000 );
+  for ( int col = 0; col < 6; ++col )
+  {
+    QVERIFY( cache.tile( mProject.get(), tileParameters( 0, col ), wmsQuery() ).isEmpty() );
+  }
+  for ( int col = 6; col < 10; ++col )
+  {
+    QCOMPARE( cache.tile( mProject.get(), tileParameters( 0, col ), wmsQuery() ), content );
+  }
+
+  // the size of the tiles stored before, e.g. by another process, is accounted
+  const QgsWmts::QgsWmtsTileCache otherCache( directory, 4500 );
+  QVERIFY( otherCache.setTile( mProject.get(), tileParameters( 1, 0 ), wmsQuery(), content ) );
+  QVERIFY( tilesSize( directory ) <= 4500 );
+  QCOMPARE( otherCache.tile( mProject.get(), tileParameters( 1, 0 ), wmsQuery() ), content );
+  QVERIFY( otherCache.tile( mProject.get(), tileParameters( 0, 6 ), wmsQuery() ).isEmpty() );
+}
+
+void TestQgsServerWmtsTileCache::invalidation_project_removed()
+{
+  const QgsWmts::QgsWmtsTileCache cache( mInterface.get() );
+  QVERIFY( cache.isEnabled() );
+
+  const QgsWmts::QgsWmtsParameters params = tileParameters( 1, 2 );
+  QVERIFY( cache.setTile( mProject.get(), params, wmsQuery(), QByteArray( "tile" ) ) );
+  QCOMPARE( cache.tile( mProject.get(), params, wmsQuery() ), QByteArray( "tile" ) );
+
+  // other projects are not affected
+  QgsConfigCache::instance()->removeEntry( mTempDir->filePath( QStringLiteral( "other.qgs" ) ) );
+  QCOMPARE( cache.tile( mProject.get(), params, wmsQuery() ), QByteArray( "tile" ) );
+
+  // the config cache detected a change of the project file
+  QgsConfigCache::instance()->removeEntry( mProject->fileName() );
+  QVERIFY( cache.tile( mProject.get(), params, wmsQuery() ).isEmpty() );
+
+  QVERIFY( cache.setTile( mProject.get(), params, wmsQuery(), QByteArray( "new tile" ) ) );
+  QCOMPARE( cache.tile( mProject.get(), params, wmsQuery() ), QByteArray( "new tile" ) );
+}
+
+void TestQgsServerWmtsTileCache::invalidation_project_modified()
+{
+  const QgsWmts::QgsWmtsTileCache cache( mTempDir->filePath( QStringLiteral( "modified" ) ) );
+
+  const QgsWmts::QgsWmtsParameters params = tileParameters( 1, 2 );
+  QVERIFY( cache.setTile( mProject.get(), params, wmsQuery(), QByteArray( "tile" ) ) );
+  QCOMPARE( cache.tile( mProject.get(), params, wmsQuery() ), QByteArray( "tile" ) );
+
+  // the tiles rendered from an older version of the project are discarded
+  QTest::qSleep( 20 );
+  QVERIFY( mProject->write() );
+  QVERIFY( cache.tile( mProject.get(), params, wmsQuery() ).isEmpty() );
+}
+
+QGSTEST_MAIN( TestQgsServerWmtsTileCache )
+#include "test_qgsserver_wmts_tilecache.moc"